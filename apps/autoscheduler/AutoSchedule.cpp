@@ -30,7 +30,7 @@
   Write out a training sample for the selected schedule into this file. Needs to be augmented with the runtime using augment_sample before it can be used to train.
 
   HL_MACHINE_PARAMS
-  An architecture description string. Used by Halide master to configure the cost model. We only use the first term. Set it to the number of cores to target.
+  An architecture description string. Used by Halide master to configure the cost model. We only use the first term, and the optional fourth term. The first is the number of cores to target. The fourth is a limit on the bytes of intermediate storage that may be allocated at once, and states that might exceed it are pruned from the search.
 
   HL_PERMIT_FAILED_UNROLL
   Set to 1 to tell Halide not to freak out if we try to unroll a loop that doesn't have a constant extent. Should generally not be necessary, but sometimes the autoscheduler's model for what will and will not turn into a constant during lowering is inaccurate, because Halide isn't perfect at constant-folding.
@@ -53,13 +53,28 @@
   HL_NO_SUBTILING
   If set to 1, limits the search space to that of Mullapudi et al.
 
+  HL_AUTOSCHEDULE_NUM_THREADS
+  Number of threads used to build the FunctionDAG and to expand states in the beam search. Defaults to the number of cores. Set to 1 to do both serially.
+
+  HL_COST_MODEL_BATCH_SIZE
+  The most schedules the default cost model will batch up into a single evaluation. Defaults to 1024. Larger values let each round of the beam search be evaluated in one call, which helps most when the cost model is compiled for a GPU (see AUTOSCHED_COST_MODEL_TARGET in apps/support/autoscheduler.inc).
+
+  HL_AUTOSCHEDULE_PINNED
+  A comma-separated list of Funcs whose existing schedules should be kept. The search places each pinned Func inline if its schedule says it is inlined, and otherwise treats it as computed at root, and nothing else is computed inside its loops. Only the pinned Funcs' own schedules are preserved, so a pinned Func computed at another Func's loops needs that Func pinned too.
+
+  HL_SCHEDULE_CACHE_DIR
+  If set, the result of the beam search is cached in this directory, keyed on a hash of the pipeline, its estimates, the target, the machine params, the search settings, and the cost model weights. A later search with the same key replays the cached decisions instead of searching.
+
   TODO: expose these settings by adding some means to pass args to
   generator plugins instead of environment vars.
 */
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <queue>
 #include <random>
 #include <set>
@@ -120,6 +135,21 @@ bool random_dropout(std::mt19937 &rng, size_t num_decisions) {
     return drop_it;
 }
 
+// Get the HL_AUTOSCHEDULE_PINNED environment variable. Purpose described above.
+set<string> get_pinned_funcs() {
+    set<string> result;
+    for (const string &name : split_string(get_env_variable("HL_AUTOSCHEDULE_PINNED"), ",")) {
+        if (!name.empty()) {
+            result.insert(name);
+        }
+    }
+    return result;
+}
+bool is_pinned(const Function &f) {
+    static set<string> pinned = get_pinned_funcs();
+    return pinned.count(f.name()) > 0;
+}
+
 // Get the HL_NO_SUBTILING environment variable. Purpose described above.
 bool get_may_subtile() {
     string no_subtiling_str = get_env_variable("HL_NO_SUBTILING");
@@ -252,6 +282,10 @@ struct LoopNest {
     // little boxes to the left of the loop nest tree figures.
     mutable NodeMap<Bound> bounds;
 
+    // Loop nests are shared between states, which may be expanded on
+    // different threads, so the bounds cache has a lock.
+    mutable std::mutex bounds_mutex;
+
     // The Func this loop nest belongs to
     const FunctionDAG::Node *node = nullptr;
 
@@ -278,7 +312,10 @@ struct LoopNest {
         children = n.children;
         inlined = n.inlined;
         store_at = n.store_at;
-        bounds = n.bounds;
+        {
+            std::lock_guard<std::mutex> lock(n.bounds_mutex);
+            bounds = n.bounds;
+        }
         node = n.node;
         stage = n.stage;
         innermost = n.innermost;
@@ -1130,19 +1167,23 @@ struct LoopNest {
     }
 
     // Set the region required of a Func at this site.
-    const Bound &set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+    Bound set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
         return bounds.emplace(f, b);
     }
 
     // Get the region required of a Func at this site, from which we
     // know what region would be computed if it were scheduled here,
     // and what its loop nest would be.
-    const Bound &get_bounds(const FunctionDAG::Node *f) const {
-        if (bounds.contains(f)) {
-            const Bound &b = bounds.get(f);
-            // Expensive validation for debugging
-            // b->validate();
-            return b;
+    Bound get_bounds(const FunctionDAG::Node *f) const {
+        {
+            std::lock_guard<std::mutex> lock(bounds_mutex);
+            if (bounds.contains(f)) {
+                const Bound &b = bounds.get(f);
+                // Expensive validation for debugging
+                // b->validate();
+                return b;
+            }
         }
         auto bound = f->make_bound();
 
@@ -1194,9 +1235,12 @@ struct LoopNest {
             f->loop_nest_for_region(i, &(bound->region_computed(0)), &(bound->loops(i, 0)));
         }
 
-        const Bound &b = set_bounds(f, bound);
-        // b->validate();
-        return b;
+        // If another thread got here first, keep its result.
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        if (bounds.contains(f)) {
+            return bounds.get(f);
+        }
+        return bounds.emplace(f, bound);
     }
 
     // Recursively print a loop nest representation to stderr
@@ -1468,7 +1512,10 @@ struct LoopNest {
         inner->innermost = innermost;
         inner->children = children;
         inner->inlined = inlined;
-        inner->bounds = bounds;
+        {
+            std::lock_guard<std::mutex> lock(bounds_mutex);
+            inner->bounds = bounds;
+        }
         inner->store_at = store_at;
 
         auto b = inner->get_bounds(node)->make_copy();
@@ -1522,6 +1569,12 @@ struct LoopNest {
 
         vector<IntrusivePtr<const LoopNest>> result;
 
+        // The loops of a pinned Func belong to its own schedule, so
+        // we can't put anything inside them.
+        if (node && is_pinned(node->func)) {
+            return result;
+        }
+
         // Some pruning to not waste time on terrible states
         if (parent) {
             const auto &bounds_here = get_bounds(f);
@@ -1630,7 +1683,10 @@ struct LoopNest {
                 inner->innermost = innermost;
                 inner->children = children;
                 inner->inlined = inlined;
-                inner->bounds = bounds;
+                {
+                    std::lock_guard<std::mutex> lock(bounds_mutex);
+                    inner->bounds = bounds;
+                }
                 inner->store_at = store_at;
 
 
@@ -1813,6 +1869,10 @@ struct LoopNest {
                const LoopNest *compute_site) const {
         if (is_root()) {
             for (auto &c : children) {
+                if (is_pinned(c->node->func)) {
+                    // Leave the user's schedule alone
+                    continue;
+                }
                 Func(c->node->func).compute_root();
                 c->apply(LoopLevel::root(), state_map, num_cores, 1, this, c.get());
                 if (c->stage->index == 0) {
@@ -2095,6 +2155,10 @@ struct State {
     double cost = 0;
     int num_decisions_made = 0;
     bool penalized = false;
+    // Which of its parent's children this is, in the order
+    // generate_children produced them. Used to record and replay
+    // paths through the search tree.
+    int child_index = 0;
 
     State() = default;
     State(const State &) = delete;
@@ -2102,7 +2166,7 @@ struct State {
     void operator=(const State &) = delete;
     void operator=(State &&) = delete;
 
-    static int cost_calculations;
+    static std::atomic<int> cost_calculations;
 
     uint64_t structural_hash(int depth) const {
         uint64_t h = num_decisions_made;
@@ -2278,6 +2342,25 @@ struct State {
             }
         }
 
+        // Reject states that might need more memory for
+        // intermediates than the machine allows. We conservatively
+        // assume every allocation is live at once, and that one
+        // copy is live per core for allocations inside parallel
+        // loops.
+        if (params.max_resident_bytes) {
+            double resident_bytes = 0;
+            for (auto it = features.begin(); it != features.end(); it++) {
+                const auto *stage = it.key();
+                if (stage->index != 0 || stage->node->is_input || stage->node->is_output) continue;
+                const auto &feat = it.value();
+                resident_bytes += feat.bytes_at_production * std::min(feat.outer_parallelism, (double)params.parallelism);
+            }
+            if (resident_bytes > params.max_resident_bytes) {
+                cost = 1e50;
+                return false;
+            }
+        }
+
         // Avoid code size explosion from recursive inlining.
         if (root->max_inlined_calls() >= 256) {
             cost = 1e50;
@@ -2346,9 +2429,16 @@ struct State {
     void generate_children(const FunctionDAG &dag,
                            const MachineParams &params,
                            CostModel *cost_model,
-                           std::function<void(IntrusivePtr<State> &&)> &accept_child) const {
+                           std::function<void(IntrusivePtr<State> &&)> &emit_child) const {
         internal_assert(root.defined() && root->is_root());
 
+        int next_child_index = 0;
+        std::function<void(IntrusivePtr<State> &&)> accept_child =
+            [&](IntrusivePtr<State> &&child) {
+            child->child_index = next_child_index++;
+            emit_child(std::move(child));
+        };
+
         if (num_decisions_made == 2*(int)dag.nodes.size()) {
             return;
         }
@@ -2399,6 +2489,32 @@ struct State {
 
         int num_children = 0;
 
+        if (is_pinned(node->func)) {
+            // The schedule of this Func is fixed. Model it as either
+            // inlined or computed at root, with no tiling and no
+            // parallelism for us to choose.
+            auto child = make_child();
+            child->num_decisions_made++;
+            if (phase == 0) {
+                LoopNest *new_root = new LoopNest;
+                new_root->copy_from(*root);
+                if (node->func.schedule().compute_level().is_inlined()) {
+                    user_assert(node->stages.size() == 1 && !node->is_output)
+                        << "Pinned Func " << node->func.name() << " is inlined, but can't be\n";
+                    new_root->inline_func(node);
+                } else {
+                    new_root->compute_here(node, false, 0);
+                    new_root->store_at.insert(node);
+                }
+                child->root = new_root;
+                if (!child->calculate_cost(dag, params, cost_model)) {
+                    return;
+                }
+            }
+            accept_child(std::move(child));
+            return;
+        }
+
         if (phase == 0) {
             // Injecting realizations
             {
@@ -2647,7 +2763,16 @@ struct State {
     // Apply the schedule represented by this state to a Halide
     // Pipeline. Also generate source code for the schedule for the
     // user to copy-paste to freeze this schedule as permanent artifact.
-    void apply_schedule(const FunctionDAG &dag, const MachineParams &params) {
+    // If the target has a GPU, the parallel loop of each compute_root
+    // stage is mapped onto GPU blocks and threads. The search itself
+    // still models a CPU, so this is a starting point for a GPU
+    // schedule rather than a tuned one.
+    void apply_schedule(const FunctionDAG &dag, const MachineParams &params,
+                        const Target &target = Target()) {
+        const bool use_gpu = target.has_gpu_feature();
+        // The block vars declared so far in the emitted source.
+        set<string> gpu_block_vars;
+
         StageMap<std::unique_ptr<LoopNest::StageScheduleState>> state_map;
         root->apply(LoopLevel::root(), state_map, params.parallelism, 0, nullptr, nullptr);
 
@@ -2744,8 +2869,30 @@ struct State {
                     stage.fuse(parallel_vars[i], parallel_vars[i-1], parallel_vars[i]);
                 }
                 if (!parallel_vars.empty()) {
-                    p.second->schedule_source << "\n    .parallel(" << parallel_vars.back().name() << ")";
-                    stage.parallel(parallel_vars.back());
+                    const VarOrRVar &v = parallel_vars.back();
+                    if (use_gpu && !v.is_rvar &&
+                        p.first->node->func.schedule().compute_level().is_root()) {
+                        // Keep the inner name for the thread loop, so
+                        // that anything computed at this loop lands
+                        // inside a single thread.
+                        const int threads = (int)std::min<int64_t>(parallel_tasks, 64);
+                        string block_name = v.name() + "_block";
+                        Var block(block_name);
+                        if (gpu_block_vars.insert(block_name).second) {
+                            src << "Var " << block_name << "(\"" << block_name << "\");\n";
+                        }
+                        p.second->schedule_source
+                            << "\n    .split(" << v.name() << ", " << block_name << ", " << v.name()
+                            << ", " << threads << ", TailStrategy::GuardWithIf)"
+                            << "\n    .gpu_blocks(" << block_name << ")"
+                            << "\n    .gpu_threads(" << v.name() << ")";
+                        stage.split(v, block, v, threads, TailStrategy::GuardWithIf)
+                            .gpu_blocks(block)
+                            .gpu_threads(v);
+                    } else {
+                        p.second->schedule_source << "\n    .parallel(" << v.name() << ")";
+                        stage.parallel(v);
+                    }
                 }
             } else {
                 for (const auto &v : parallel_vars) {
@@ -2789,7 +2936,7 @@ struct State {
 };
 
 // Keep track of how many times we evaluated a state.
-int State::cost_calculations = 0;
+std::atomic<int> State::cost_calculations(0);
 
 // A priority queue of states, sorted according to increasing
 // cost. Never shrinks, to avoid reallocations.
@@ -2890,6 +3037,62 @@ void configure_pipeline_features(const FunctionDAG &dag,
     cost_model->set_pipeline_features(pipeline_features, params.parallelism);
 }
 
+// A cost model that records the states enqueued on it without
+// evaluating them. This lets us generate the children of several
+// states in parallel, and then hand them all to the real cost model
+// from a single thread in a deterministic order.
+class DeferredCostModel : public CostModel {
+    struct Enqueued {
+        int num_stages;
+        Runtime::Buffer<float> schedule_features;
+        double *cost_ptr;
+    };
+    vector<Enqueued> enqueued;
+
+public:
+    void set_pipeline_features(const Runtime::Buffer<float> &, int) override {
+        internal_error << "DeferredCostModel::set_pipeline_features should not be called\n";
+    }
+
+    void enqueue(int ns, Runtime::Buffer<float> *schedule_feats, double *cost_ptr) override {
+        enqueued.push_back({ns, Runtime::Buffer<float>(ScheduleFeatures::num_features(), ns), cost_ptr});
+        *schedule_feats = enqueued.back().schedule_features;
+    }
+
+    void evaluate_costs() override {
+        internal_error << "DeferredCostModel::evaluate_costs should not be called\n";
+    }
+
+    void reset() override {
+        enqueued.clear();
+    }
+
+    float backprop(const Runtime::Buffer<const float> &, float) override {
+        internal_error << "DeferredCostModel::backprop should not be called\n";
+        return 0;
+    }
+
+    void save_weights() override {
+        internal_error << "DeferredCostModel::save_weights should not be called\n";
+    }
+
+    uint64_t weights_hash() override {
+        internal_error << "DeferredCostModel::weights_hash should not be called\n";
+        return 0;
+    }
+
+    // Enqueue everything recorded so far on the real cost model, in
+    // the order it was recorded.
+    void forward_to(CostModel *cost_model) {
+        for (auto &e : enqueued) {
+            Runtime::Buffer<float> dst;
+            cost_model->enqueue(e.num_stages, &dst, e.cost_ptr);
+            dst.copy_from(e.schedule_features);
+        }
+        enqueued.clear();
+    }
+};
+
 // A single pass of coarse-to-fine beam search.
 IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                                           vector<Function> outputs,
@@ -2964,6 +3167,19 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
 
     string cyos_str = get_env_variable("HL_CYOS");
 
+    // Generating children is the bulk of the work of the search, and
+    // the states in the beam can be expanded independently, so we do
+    // it on a thread pool. The children of each state are then
+    // enqueued serially, in the order the states came off the queue,
+    // so that the search is deterministic regardless of the number
+    // of threads.
+    const int num_threads = get_num_threads();
+    std::unique_ptr<ThreadPool<void>> thread_pool;
+    if (num_threads > 1) {
+        thread_pool.reset(new ThreadPool<void>(num_threads));
+    }
+    vector<IntrusivePtr<State>> to_expand;
+
     // This loop is beam search over the sequence of decisions to make.
     for (int i = 0; ; i++) {
         std::unordered_map<uint64_t, int> hashes;
@@ -2993,7 +3209,8 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
         }
 
         expanded = 0;
-        while (expanded < beam_size && !pending.empty()) {
+        to_expand.clear();
+        while ((int)to_expand.size() < beam_size && !pending.empty()) {
 
             IntrusivePtr<State> state {pending.pop()};
 
@@ -3068,9 +3285,46 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                 return best;
             }
 
-            state->generate_children(dag, params, cost_model, enqueue_new_children);
-            expanded++;
+            to_expand.emplace_back(std::move(state));
+        }
+
+        if (thread_pool && to_expand.size() > 1) {
+            const size_t n = to_expand.size();
+            vector<vector<IntrusivePtr<State>>> children(n);
+            vector<DeferredCostModel> deferred(n);
+            vector<std::future<void>> futures;
+            futures.reserve(n);
+            for (size_t j = 0; j < n; j++) {
+                futures.emplace_back(thread_pool->async([&, j]() {
+                    std::function<void(IntrusivePtr<State> &&)> collect_child =
+                        [&](IntrusivePtr<State> &&s) {
+                        children[j].emplace_back(std::move(s));
+                    };
+                    to_expand[j]->generate_children(dag, params,
+                                                    cost_model ? &deferred[j] : nullptr,
+                                                    collect_child);
+                }));
+            }
+            for (auto &f : futures) {
+                f.get();
+            }
+            for (size_t j = 0; j < n; j++) {
+                expanded = (int)j;
+                if (cost_model) {
+                    deferred[j].forward_to(cost_model);
+                }
+                for (auto &c : children[j]) {
+                    enqueue_new_children(std::move(c));
+                }
+            }
+            expanded = (int)n;
+        } else {
+            for (auto &state : to_expand) {
+                state->generate_children(dag, params, cost_model, enqueue_new_children);
+                expanded++;
+            }
         }
+        to_expand.clear();
 
         // Drop the other states unconsidered.
         pending.clear();
@@ -3156,6 +3410,155 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
     return best;
 }
 
+// Compute the key for the schedule cache. It must capture everything
+// that can change the result of the search.
+uint64_t schedule_cache_key(const FunctionDAG &dag,
+                            const Target &target,
+                            const MachineParams &params,
+                            CostModel *cost_model,
+                            int beam_size,
+                            int seed) {
+    std::ostringstream key;
+    key << "target " << target.to_string() << "\n"
+        << "params " << params.parallelism << " "
+        << params.last_level_cache_size << " "
+        << params.balance << "\n"
+        << "beam_size " << beam_size << "\n"
+        << "num_passes " << get_env_variable("HL_NUM_PASSES") << "\n"
+        << "may_subtile " << may_subtile() << "\n"
+        << "pinned " << get_env_variable("HL_AUTOSCHEDULE_PINNED") << "\n"
+        << "weights " << cost_model->weights_hash() << "\n";
+    uint32_t dropout = get_dropout_threshold();
+    if (dropout < 100) {
+        // The seed only matters if we're doing random dropout.
+        key << "dropout " << dropout << " " << seed << "\n";
+    }
+
+    for (const auto &n : dag.nodes) {
+        const Function &f = n.func;
+        key << "func " << f.name() << " " << n.is_input << n.is_output << "\n";
+        auto dump_definition = [&](const Definition &d) {
+            for (const Expr &a : d.args()) {
+                key << "  arg " << a << "\n";
+            }
+            for (const Expr &v : d.values()) {
+                key << "  value " << v << "\n";
+            }
+        };
+        if (f.has_pure_definition()) {
+            dump_definition(f.definition());
+        }
+        for (const Definition &d : f.updates()) {
+            dump_definition(d);
+        }
+        for (const auto &b : f.schedule().estimates()) {
+            key << "  estimate " << b.var << " " << b.min << " " << b.extent << "\n";
+        }
+        for (const auto &r : n.region_computed) {
+            key << "  computed " << r.in.min << " " << r.in.max << "\n";
+        }
+        for (const auto &st : n.stages) {
+            key << "  stage " << st.name << "\n";
+            for (const auto &l : st.loop) {
+                key << "    loop " << l.var << " " << l.min << " " << l.max << "\n";
+            }
+        }
+    }
+    for (const auto &e : dag.edges) {
+        key << "edge " << e.producer->func.name() << " " << e.consumer->name << "\n";
+        for (const auto &b : e.bounds) {
+            key << "  " << b.first.expr << " " << b.second.expr << "\n";
+        }
+    }
+
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : key.str()) {
+        h = (h ^ (uint8_t)c) * 1099511628211ULL;
+    }
+    return h;
+}
+
+string schedule_cache_file(const string &dir, uint64_t key) {
+    std::ostringstream name;
+    name << dir << "/" << std::hex << key << ".schedule";
+    return name.str();
+}
+
+// Each cache entry records the sequence of children chosen at each
+// decision of the search, starting from the initial state.
+const char *schedule_cache_magic = "halide_autoschedule_cache_v1";
+
+void save_cached_schedule(const string &filename, const State *state) {
+    vector<int> path;
+    for (const State *s = state; s->parent.defined(); s = s->parent.get()) {
+        path.push_back(s->child_index);
+    }
+    std::reverse(path.begin(), path.end());
+
+    // Write to a temporary file and rename it into place, so that
+    // concurrent builds never see a partially-written entry.
+    string tmp = filename + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream f(tmp);
+        f << schedule_cache_magic << "\n" << path.size();
+        for (int i : path) {
+            f << " " << i;
+        }
+        f << "\n";
+        if (f.fail()) {
+            debug(0) << "Failed to write schedule cache entry " << tmp << "\n";
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        debug(0) << "Failed to write schedule cache entry " << filename << "\n";
+        std::remove(tmp.c_str());
+    }
+}
+
+// Rebuild a state from a cache entry. Returns nullptr if there is no
+// entry, or if it doesn't describe a complete schedule for this
+// pipeline.
+IntrusivePtr<State> load_cached_schedule(const string &filename,
+                                         const FunctionDAG &dag,
+                                         const MachineParams &params) {
+    std::ifstream f(filename);
+    if (!f.is_open()) {
+        return nullptr;
+    }
+    string magic;
+    size_t num_decisions = 0;
+    f >> magic >> num_decisions;
+    if (f.fail() || magic != schedule_cache_magic || num_decisions != 2 * dag.nodes.size()) {
+        debug(0) << "Ignoring malformed schedule cache entry " << filename << "\n";
+        return nullptr;
+    }
+
+    IntrusivePtr<State> state{new State};
+    state->root = new LoopNest;
+    // The children's costs are never needed, so their features can go
+    // to a cost model that never evaluates anything.
+    DeferredCostModel cost_model;
+    for (size_t i = 0; i < num_decisions; i++) {
+        int idx = -1;
+        f >> idx;
+        vector<IntrusivePtr<State>> children;
+        std::function<void(IntrusivePtr<State> &&)> collect_child =
+            [&](IntrusivePtr<State> &&s) {
+            children.emplace_back(std::move(s));
+        };
+        state->generate_children(dag, params, &cost_model, collect_child);
+        cost_model.reset();
+        if (f.fail() || idx < 0 || idx >= (int)children.size()) {
+            debug(0) << "Ignoring stale schedule cache entry " << filename << "\n";
+            return nullptr;
+        }
+        state = children[idx];
+    }
+    return state;
+}
+
 // The main entrypoint to generate a schedule for a pipeline.
 std::string generate_schedule(const std::vector<Function> &outputs,
                               const Target &target,
@@ -3204,8 +3607,30 @@ std::string generate_schedule(const std::vector<Function> &outputs,
 
     IntrusivePtr<State> optimal;
 
-    // Run beam search
-    optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size);
+    // Check the schedule cache. Randomized weights or a hand-driven
+    // search won't give reproducible results, so those skip it.
+    string cache_dir = get_env_variable("HL_SCHEDULE_CACHE_DIR");
+    string cache_file;
+    if (!cache_dir.empty() && !randomize_weights && get_env_variable("HL_CYOS") != "1") {
+        uint64_t key = schedule_cache_key(dag, target, params, cost_model.get(), beam_size, seed);
+        cache_file = schedule_cache_file(cache_dir, key);
+        optimal = load_cached_schedule(cache_file, dag, params);
+        if (optimal.defined()) {
+            debug(0) << "Using cached schedule " << cache_file << "\n";
+        }
+    }
+
+    if (!optimal.defined()) {
+        // Run beam search
+        optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size);
+        if (!cache_file.empty()) {
+            save_cached_schedule(cache_file, optimal.get());
+        }
+    } else {
+        // The search normally configures the cost model. We still
+        // need it for the debugging output below.
+        configure_pipeline_features(dag, params, cost_model.get());
+    }
 
     HALIDE_TOC;
 
@@ -3218,7 +3643,7 @@ std::string generate_schedule(const std::vector<Function> &outputs,
     optimal->calculate_cost(dag, params, cost_model.get(), true);
 
     // Apply the schedules to the pipeline
-    optimal->apply_schedule(dag, params);
+    optimal->apply_schedule(dag, params, target);
 
     // Print out the schedule
     optimal->dump();
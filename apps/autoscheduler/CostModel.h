@@ -28,6 +28,10 @@ public:
     // Save the model weights to disk.
     virtual void save_weights() = 0;
 
+    // A hash of the model weights, so that results computed with this
+    // model can be cached.
+    virtual uint64_t weights_hash() = 0;
+
     static std::unique_ptr<CostModel> make_default(const std::string &weights_in_dir = "",
                                                    const std::string &weights_out_dir = "",
                                                    bool randomize_weights = false);
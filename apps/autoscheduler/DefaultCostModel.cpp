@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -85,9 +86,30 @@ class DefaultCostModel : public CostModel {
     Runtime::Buffer<double *> cost_ptrs;
     int cursor, num_stages, num_cores;
 
+    // The most schedules we will queue up before evaluating them. The
+    // queue starts small and grows up to this size, so large values
+    // only cost memory when the search actually generates that many
+    // schedules between calls to evaluate_costs.
+    int max_batch_size = 1024;
+
     const std::string weights_in_dir, weights_out_dir;
     const bool randomize_weights;
 
+    // Reallocate the queue to hold n schedules of up to max_num_stages
+    // stages each, keeping anything already enqueued.
+    void resize_queue(int n, int max_num_stages) {
+        Runtime::Buffer<float> new_schedule_feat_queue(n, head2_w, max_num_stages);
+        Runtime::Buffer<float> new_costs(n);
+        Runtime::Buffer<double *> new_cost_ptrs(n);
+        if (cursor > 0) {
+            new_schedule_feat_queue.copy_from(schedule_feat_queue.cropped(0, 0, cursor));
+            new_cost_ptrs.copy_from(cost_ptrs.cropped(0, 0, cursor));
+        }
+        schedule_feat_queue = new_schedule_feat_queue;
+        costs = new_costs;
+        cost_ptrs = new_cost_ptrs;
+    }
+
  public:
 
     DefaultCostModel(const std::string &weights_in_dir,
@@ -97,6 +119,11 @@ class DefaultCostModel : public CostModel {
         weights_out_dir(weights_out_dir),
         randomize_weights(randomize_weights) {
 
+        const char *batch_size_str = std::getenv("HL_COST_MODEL_BATCH_SIZE");
+        if (batch_size_str && batch_size_str[0]) {
+            max_batch_size = std::max(1, std::atoi(batch_size_str));
+        }
+
         load_weights();
     }
 
@@ -119,20 +146,22 @@ class DefaultCostModel : public CostModel {
             abort();
         }
 
-        const int batch_size = 1024;
         if (!schedule_feat_queue.data() ||
             schedule_feat_queue.dim(2).extent() < max_num_stages) {
             assert(cursor == 0);
-            schedule_feat_queue = Runtime::Buffer<float>(batch_size, head2_w, max_num_stages);
-            if (!costs.data()) {
-                assert(!cost_ptrs.data());
-                costs = Runtime::Buffer<float>(batch_size);
-                cost_ptrs = Runtime::Buffer<double *>(batch_size);
-            }
+            resize_queue(std::min(1024, max_batch_size), max_num_stages);
         }
 
-        if (cursor == batch_size) {
-            evaluate_costs();
+        const int capacity = schedule_feat_queue.dim(0).extent();
+        if (cursor == capacity) {
+            if (capacity < max_batch_size) {
+                // Grow the batch rather than evaluating it early, so
+                // that each call to the network sees as many
+                // schedules as possible.
+                resize_queue(std::min(2 * capacity, max_batch_size), max_num_stages);
+            } else {
+                evaluate_costs();
+            }
         }
 
         *schedule_feats = schedule_feat_queue.sliced(0, cursor);
@@ -256,6 +285,12 @@ class DefaultCostModel : public CostModel {
 
         auto loss = Runtime::Buffer<float>::make_scalar();
 
+        // The features were written on the host since the last
+        // evaluation. This matters if the cost model was compiled
+        // for a GPU target.
+        pipeline_feat_queue.set_host_dirty();
+        schedule_feat_queue.set_host_dirty();
+
         cost_model(num_stages,
                    cursor,
                    num_cores,
@@ -267,6 +302,8 @@ class DefaultCostModel : public CostModel {
                    0.0f, 0, 0, nullptr,
                    dst, loss);
 
+        dst.copy_to_host();
+
         for (int i = 0; i < cursor; i++) {
             assert(cost_ptrs(i));
             *(cost_ptrs(i)) = dst(i);
@@ -319,6 +356,18 @@ class DefaultCostModel : public CostModel {
         }
     }
 
+    uint64_t weights_hash() {
+        // FNV-1a over the bytes of all the weights
+        uint64_t h = 14695981039346656037ULL;
+        for_each_weight([&](const Runtime::Buffer<float> &w) {
+                const uint8_t *bytes = (const uint8_t *)w.data();
+                for (size_t i = 0; i < w.size_in_bytes(); i++) {
+                    h = (h ^ bytes[i]) * 1099511628211ULL;
+                }
+            });
+        return h;
+    }
+
     void save_weights() {
         if (weights_out_dir.empty()) return;
 
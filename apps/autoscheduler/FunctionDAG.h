@@ -7,8 +7,10 @@
 
 #include <stdint.h>
 #include <algorithm>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <string>
 
 #include "Halide.h"
@@ -24,6 +26,16 @@ using std::map;
 using std::string;
 using std::unique_ptr;
 
+// Get the HL_AUTOSCHEDULE_NUM_THREADS environment variable. Purpose
+// described in AutoSchedule.cpp.
+inline int get_num_threads() {
+    string num_threads_str = get_env_variable("HL_AUTOSCHEDULE_NUM_THREADS");
+    if (num_threads_str.empty()) {
+        return (int)ThreadPool<void>::num_processors_online();
+    }
+    return std::max(1, atoi(num_threads_str.c_str()));
+}
+
 // First we have various utility classes.
 
 // An optional rational type used when analyzing memory dependencies.
@@ -310,8 +322,9 @@ struct BoundContents {
     // We're frequently going to need to make these concrete bounds
     // arrays.  It makes things more efficient if we figure out the
     // memory layout of those data structures once ahead of time, and
-    // make each individual instance just use that. Note that this is
-    // not thread-safe.
+    // make each individual instance just use that. The pool is guarded
+    // by a mutex, so bounds can be made and released from the threads
+    // expanding states in parallel.
     struct Layout {
         // number of Span to allocate
         int total_size;
@@ -332,6 +345,8 @@ struct BoundContents {
 
         mutable size_t num_live = 0;
 
+        mutable std::mutex mutex;
+
         Layout() {}
 
         ~Layout() {
@@ -370,6 +385,7 @@ struct BoundContents {
 
         // Make a BoundContents object with this layout
         BoundContents *make() const {
+            std::lock_guard<std::mutex> lock(mutex);
             if (pool.empty()) {
                 allocate_some_more();
             }
@@ -383,6 +399,7 @@ struct BoundContents {
         void release(const BoundContents *b) const {
             internal_assert(b->layout == this) << "Releasing BoundContents onto the wrong pool!";
             b->~BoundContents();
+            std::lock_guard<std::mutex> lock(mutex);
             pool.push_back(const_cast<BoundContents *>(b));
             num_live--;
         }
@@ -740,6 +757,8 @@ struct FunctionDAG {
     // Create the function DAG, and do all the dependency and cost
     // analysis. This is done once up-front before the tree search.
     FunctionDAG(const vector<Function> &outputs, const MachineParams &params, const Target &target) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+
         map<string, Function> env;
         for (Function o : outputs) {
             populate_environment(o, env);
@@ -770,7 +789,7 @@ struct FunctionDAG {
                     return op;
                 }
             }
-        } apply_param_estimates;
+        };
 
         // Compute a realization order
         vector<string> order = topological_order(outputs, env);
@@ -787,11 +806,34 @@ struct FunctionDAG {
         }
 
         int stage_count = 0;
+        for (const auto &n : nodes) {
+            stage_count += (int)n.func.updates().size() + 1;
+        }
 
-        for (size_t i = order.size(); i > 0; i--) {
-            Function consumer = env[order[i-1]];
+        // The bounds queries below need the value bounds of every
+        // Func. These don't depend on the stage being analyzed, so
+        // compute them once.
+        FuncValueBounds func_value_bounds = compute_function_value_bounds(order, env);
+        {
+            ApplyParamEstimates apply_param_estimates;
+            for (auto &p : func_value_bounds) {
+                p.second.min = apply_param_estimates.mutate(p.second.min);
+                p.second.max = apply_param_estimates.mutate(p.second.max);
+            }
+        }
 
-            Node &node = nodes[order.size() - i];
+        // Analyzing the Nodes is most of the cost of building the
+        // DAG, and they're independent of each other, so we do it in
+        // parallel. Each Node collects its incoming edges separately,
+        // and they're concatenated in Node order afterwards so that
+        // the DAG doesn't depend on the number of threads.
+        vector<vector<Edge>> node_edges(nodes.size());
+        auto analyze_node = [&](size_t k) {
+            ApplyParamEstimates apply_param_estimates;
+            Function consumer = env.at(order[order.size() - k - 1]);
+
+            Node &node = nodes[k];
+            vector<Edge> &new_edges = node_edges[k];
             Scope<Interval> scope;
             node.func = consumer;
 
@@ -808,7 +850,6 @@ struct FunctionDAG {
             auto pure_args = node.func.args();
 
             for (int s = 0; s <= (int)consumer.updates().size(); s++) {
-                stage_count++;
                 Halide::Stage halide_stage = Func(consumer);
                 if (s > 0) {
                     halide_stage = Func(consumer).update(s-1);
@@ -1075,12 +1116,6 @@ struct FunctionDAG {
 
                 exprs = apply_param_estimates.mutate(exprs);
 
-                FuncValueBounds func_value_bounds = compute_function_value_bounds(order, env);
-                for (auto &p : func_value_bounds) {
-                    p.second.min = apply_param_estimates.mutate(p.second.min);
-                    p.second.max = apply_param_estimates.mutate(p.second.max);
-                }
-
                 // For this stage scope we want symbolic bounds for the rvars
 
                 // Now create the edges that lead to this func
@@ -1097,7 +1132,7 @@ struct FunctionDAG {
                         // Discard loads from input images and self-loads
                         Edge edge;
                         edge.consumer = &stage;
-                        edge.producer = node_map.at(env[p.first]);
+                        edge.producer = node_map.at(it->second);
                         edge.all_bounds_affine = true;
 
                         for (Interval &in : p.second.bounds) {
@@ -1114,7 +1149,7 @@ struct FunctionDAG {
                         edge.calls = checker.calls[edge.producer->func.name()];
                         any_incoming_edges = true;
                         node.is_pointwise &= checker.is_pointwise;
-                        edges.emplace_back(std::move(edge));
+                        new_edges.emplace_back(std::move(edge));
                     }
                 }
 
@@ -1122,8 +1157,31 @@ struct FunctionDAG {
                 node.is_input = !node.func.has_update_definition() && node.is_wrapper && !any_incoming_edges;
                 node.dimensions = node.func.dimensions();
             }
+        };
+
+        const int num_threads = std::min(get_num_threads(), (int)nodes.size());
+        if (num_threads > 1) {
+            ThreadPool<void> thread_pool(num_threads);
+            vector<std::future<void>> futures;
+            for (size_t k = 0; k < nodes.size(); k++) {
+                futures.emplace_back(thread_pool.async(analyze_node, k));
+            }
+            for (auto &f : futures) {
+                f.get();
+            }
+        } else {
+            for (size_t k = 0; k < nodes.size(); k++) {
+                analyze_node(k);
+            }
+        }
+        for (auto &v : node_edges) {
+            for (auto &e : v) {
+                edges.emplace_back(std::move(e));
+            }
         }
 
+        auto t_analyzed = std::chrono::high_resolution_clock::now();
+
         // Initialize the memory layouts for the bounds structs
         for (auto &n : nodes) {
             n.bounds_memory_layout.reset(new BoundContents::Layout);
@@ -1171,6 +1229,13 @@ struct FunctionDAG {
 
         // Compute the algorithm-specific features for the neural net
         featurize();
+
+        auto t_done = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> analysis_ms = t_analyzed - t_start;
+        std::chrono::duration<double, std::milli> rest_ms = t_done - t_analyzed;
+        debug(0) << "Built FunctionDAG of " << nodes.size() << " Funcs and " << stage_count << " stages: "
+                 << analysis_ms.count() << " ms analyzing stages using " << std::max(num_threads, 1)
+                 << " threads, " << rest_ms.count() << " ms computing dependencies and features\n";
     }
 
     class Featurizer : public IRVisitor {
@@ -34,6 +34,19 @@ fi
 COMPILATION_TIMEOUT=600s
 BENCHMARKING_TIMEOUT=60s
 
+# Optionally benchmark on other machines. Set this to a
+# space-separated list of ssh destinations (e.g. "user@host1 host2").
+# Each host benchmarks one sample at a time, and the hosts run in
+# parallel. The hosts need passwordless ssh, and the shared libraries
+# the benchmark binaries link against (libjpeg, libpng, libz).
+# Compilation and retraining still happen locally.
+BENCHMARK_HOSTS=${HL_AUTOTUNE_BENCHMARK_HOSTS:-}
+REMOTE_DIR=/tmp/halide_autotune_${USER:-$(id -un)}
+
+# The number of batches to run. Each batch is compiled, benchmarked,
+# and then used to retrain the weights before the next one starts.
+NUM_BATCHES=${HL_AUTOTUNE_NUM_BATCHES:-1}
+
 if [ -z ${HL_TARGET} ]; then
 HL_TARGET=x86-64-avx2
 fi
@@ -130,18 +143,30 @@ make_sample() {
         -ljpeg -ldl -lpthread -lz -lpng
 }
 
-# Benchmark one of the random samples
+# Benchmark one of the random samples, optionally on a remote host
 benchmark_sample() {
     sleep 1 # Give CPU clocks a chance to spin back up if we're thermally throttling
     D=${1}
-    HL_NUM_THREADS=32 \
-        ${TIMEOUT_CMD} -k ${BENCHMARKING_TIMEOUT} ${BENCHMARKING_TIMEOUT} \
-        ${D}/bench \
-        --output_extents=estimate \
+    HOST=${4:-}
+    BENCH_ARGS="--output_extents=estimate \
         --default_input_buffers=random:0:estimate_then_auto \
         --default_input_scalars=estimate \
-        --benchmarks=all \
-            | tee ${D}/bench.txt || echo "Benchmarking failed or timed out for ${D}"
+        --benchmarks=all"
+    if [ -z "${HOST}" ]; then
+        HL_NUM_THREADS=32 \
+            ${TIMEOUT_CMD} -k ${BENCHMARKING_TIMEOUT} ${BENCHMARKING_TIMEOUT} \
+            ${D}/bench ${BENCH_ARGS} \
+                | tee ${D}/bench.txt || echo "Benchmarking failed or timed out for ${D}"
+    else
+        REMOTE_BENCH=${REMOTE_DIR}/bench_${2}
+        # The remote host may not have gtimeout, so we use the timeout
+        # command there and a local timeout around the whole ssh.
+        ( scp -q ${D}/bench ${HOST}:${REMOTE_BENCH} && \
+          ${TIMEOUT_CMD} -k ${BENCHMARKING_TIMEOUT} ${BENCHMARKING_TIMEOUT} \
+            ssh ${HOST} "HL_NUM_THREADS=32 ${REMOTE_BENCH} ${BENCH_ARGS}; rm -f ${REMOTE_BENCH}" ) \
+                > ${D}/bench.txt || echo "Benchmarking failed or timed out for ${D} on ${HOST}"
+        cat ${D}/bench.txt
+    fi
 
     # Add the runtime, pipeline id, and schedule id to the feature file
     R=$(cut -d' ' -f8 < ${D}/bench.txt)
@@ -160,7 +185,13 @@ else
 fi
 echo Local number of cores detected as ${LOCAL_CORES}
 
-NUM_BATCHES=1
+if [ ! -z "${BENCHMARK_HOSTS}" ]; then
+    read -r -a BENCHMARK_HOSTS_ARRAY <<< "${BENCHMARK_HOSTS}"
+    echo Benchmarking on ${#BENCHMARK_HOSTS_ARRAY[@]} hosts: ${BENCHMARK_HOSTS}
+    for HOST in "${BENCHMARK_HOSTS_ARRAY[@]}"; do
+        ssh ${HOST} "mkdir -p ${REMOTE_DIR}"
+    done
+fi
 
 for ((BATCH_ID=$((FIRST+1));BATCH_ID<$((FIRST+1+NUM_BATCHES));BATCH_ID++)); do
 
@@ -201,11 +232,27 @@ for ((BATCH_ID=$((FIRST+1));BATCH_ID<$((FIRST+1+NUM_BATCHES));BATCH_ID++)); do
         done
         wait
 
-        # benchmark them serially using rungen
-        for ((SAMPLE_ID=0;SAMPLE_ID<${BATCH_SIZE};SAMPLE_ID++)); do
-            S=$(printf "%d%02d" $BATCH_ID $SAMPLE_ID)
-            benchmark_sample "${DIR}/${SAMPLE_ID}" $S $EXTRA_ARGS_IDX
-        done
+        if [ -z "${BENCHMARK_HOSTS}" ]; then
+            # benchmark them serially using rungen
+            for ((SAMPLE_ID=0;SAMPLE_ID<${BATCH_SIZE};SAMPLE_ID++)); do
+                S=$(printf "%d%02d" $BATCH_ID $SAMPLE_ID)
+                benchmark_sample "${DIR}/${SAMPLE_ID}" $S $EXTRA_ARGS_IDX
+            done
+        else
+            # Deal the samples out to the hosts. Each host
+            # benchmarks its share serially, so that samples never
+            # compete with each other for a machine.
+            NUM_HOSTS=${#BENCHMARK_HOSTS_ARRAY[@]}
+            for ((HOST_ID=0;HOST_ID<${NUM_HOSTS};HOST_ID++)); do
+                (
+                    for ((SAMPLE_ID=${HOST_ID};SAMPLE_ID<${BATCH_SIZE};SAMPLE_ID+=${NUM_HOSTS})); do
+                        S=$(printf "%d%02d" $BATCH_ID $SAMPLE_ID)
+                        benchmark_sample "${DIR}/${SAMPLE_ID}" $S $EXTRA_ARGS_IDX ${BENCHMARK_HOSTS_ARRAY[HOST_ID]}
+                    done
+                ) &
+            done
+            wait
+        fi
 
         # retrain model weights on all samples seen so far
         echo Retraining model...
@@ -108,6 +108,7 @@ public:
     template<typename T> using Output = GeneratorOutput<T>;
     using Generator<CostModel<training>>::auto_schedule;
     using Generator<CostModel<training>>::get_pipeline;
+    using Generator<CostModel<training>>::get_target;
 
     // Number of pipeline stages
     Input<int> num_stages{ "num_stages", 1 };
@@ -477,6 +478,27 @@ public:
             do_cost_model_schedule(get_pipeline());
         } else if (auto_schedule) {
             // Do nothing.
+        } else if (!training && get_target().has_gpu_feature()) {
+            // An inference schedule for large batches on a GPU. The
+            // batch-independent work on the pipeline features is tiny,
+            // so it stays on the host.
+            conv1_stage1.compute_root().vectorize(c, 8);
+            squashed_head1_filter.compute_root().vectorize(c, 8);
+
+            // Each conv layer gets a thread per output channel and
+            // schedule, with the reduction done serially in that
+            // thread.
+            Var ci, wi, ni;
+            head2_relu.compute_root()
+                .gpu_tile(c, w, n, ci, wi, ni, head2_channels, 1, 8);
+            head2_conv.compute_at(head2_relu, ci);
+            relu1.compute_root()
+                .gpu_tile(c, w, n, ci, wi, ni, conv1_channels, 1, 8);
+            conv1_stage2.compute_at(relu1, ci);
+
+            // Then a thread per schedule sums the costs of its stages.
+            prediction_output.compute_root().gpu_tile(n, ni, 64);
+            prediction.compute_at(prediction_output, ni);
         } else {
             // We just write down a good schedule for
             // inference. Scheduling a couple of convs is easy.
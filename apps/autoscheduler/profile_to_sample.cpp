@@ -0,0 +1,82 @@
+// Turns profiler output from a deployed pipeline into a training
+// sample for the cost model. The pipeline must have been
+// autoscheduled with HL_FEATURE_FILE set to produce the .sample file
+// of its schedule features, and run with the profiler enabled (the
+// -profile target feature). This tool finds the pipeline's reports in
+// the captured profiler output, and appends the average runtime per
+// run, plus the pipeline and schedule ids, to the sample, in the same
+// way augment_sample does for benchmark results. The resulting
+// samples can be fed to train_cost_model alongside (or instead of)
+// the ones from the autotuning loop, to fine-tune existing weights on
+// production hardware and input sizes.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+    if (argc != 6) {
+        printf("Usage: profile_to_sample profiler_output.txt pipeline_name sample.bin pipeline_id schedule_id\n");
+        return -1;
+    }
+
+    std::ifstream report(argv[1]);
+    if (!report.is_open()) {
+        fprintf(stderr, "Unable to open file: %s\n", argv[1]);
+        return -1;
+    }
+    const std::string pipeline_name = argv[2];
+
+    // The report for each pipeline starts with a line containing just
+    // its name, followed by a line like:
+    //  total time: 12.5 ms  samples: 11  runs: 10  time/run: 1.25 ms
+    // The output may contain many reports (e.g. one per process), so
+    // we accumulate over all of them.
+    double total_ms = 0;
+    long long total_runs = 0;
+    std::string line;
+    while (std::getline(report, line)) {
+        if (line != pipeline_name) {
+            continue;
+        }
+        if (!std::getline(report, line)) {
+            break;
+        }
+        float ms = 0;
+        long long samples = 0, runs = 0;
+        if (sscanf(line.c_str(), " total time: %f ms samples: %lld runs: %lld", &ms, &samples, &runs) == 3 &&
+            runs > 0) {
+            total_ms += ms;
+            total_runs += runs;
+        }
+    }
+
+    if (total_runs == 0) {
+        fprintf(stderr, "No profiler reports for pipeline %s found in %s\n", argv[2], argv[1]);
+        return -1;
+    }
+
+    FILE *f = fopen(argv[3], "ab");
+    if (!f) {
+        fprintf(stderr, "Unable to open file: %s\n", argv[3]);
+        return -1;
+    }
+
+    // The sample file stores times in milliseconds.
+    float r = (float)(total_ms / total_runs);
+    int pid = atoi(argv[4]);
+    int sid = atoi(argv[5]);
+
+    fwrite(&r, 4, 1, f);
+    fwrite(&pid, 4, 1, f);
+    fwrite(&sid, 4, 1, f);
+
+    fclose(f);
+
+    printf("%s: %f ms per run over %lld runs\n", argv[2], r, total_runs);
+
+    return 0;
+}
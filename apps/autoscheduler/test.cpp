@@ -467,5 +467,25 @@ int main(int argc, char **argv) {
         Pipeline(casted).auto_schedule(target, params);
     }
 
+    // For a GPU target, the parallel loops of the root stages should be
+    // mapped onto GPU blocks and threads.
+    for (const char *gpu_target : {"x86-64-linux-sse41-avx-avx2-cuda",
+                                   "x86-64-linux-sse41-avx-avx2-opencl"}) {
+        Func f("f"), g("g"), h("h");
+        f(x, y) = (x + y) * (x + 2*y) * (x + 3*y);
+        h(x, y) = (f(x-1, y-1) + f(x, y-1) + f(x+1, y-1) +
+                   f(x-1, y  ) + f(x, y  ) + f(x+1, y  ) +
+                   f(x-1, y+1) + f(x, y+1) + f(x+1, y-1));
+
+        h.estimate(x, 0, 2048).estimate(y, 0, 2048);
+
+        std::string schedule = Pipeline(h).auto_schedule(Target(gpu_target), params);
+        if (schedule.find(".gpu_blocks(") == std::string::npos ||
+            schedule.find(".gpu_threads(") == std::string::npos) {
+            std::cerr << "Schedule for " << gpu_target << " has no GPU loops:\n" << schedule;
+            return 1;
+        }
+    }
+
     return 0;
 }
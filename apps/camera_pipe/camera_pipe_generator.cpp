@@ -218,6 +218,12 @@ public:
     // currently allow 8-bit computations
     GeneratorParam<Type> result_type{"result_type", UInt(8)};
 
+    // If true, the cpu schedule can compute any strip of output rows
+    // whose min and extent are multiples of 32, rather than only whole
+    // frames. This lets the pipeline run a strip at a time as rows of
+    // the input arrive (see line_buffered_pipeline.h).
+    GeneratorParam<bool> streaming{"streaming", false};
+
     Input<Buffer<uint16_t>> input{"input", 2};
     Input<Buffer<float>> matrix_3200{"matrix_3200", 2};
     Input<Buffer<float>> matrix_7000{"matrix_7000", 2};
@@ -567,8 +573,10 @@ void CameraPipe::generate() {
         // We can generate slightly better code if we know the splits divide the extent.
         processed
             .bound(c, 0, 3)
-            .bound(x, 0, ((out_width)/(2*vec))*(2*vec))
-            .bound(y, 0, (out_height/strip_size)*strip_size);
+            .bound(x, 0, ((out_width)/(2*vec))*(2*vec));
+        if (!streaming) {
+            processed.bound(y, 0, (out_height/strip_size)*strip_size);
+        }
 
         /* Optional tags to specify layout for HalideTraceViz */
         {
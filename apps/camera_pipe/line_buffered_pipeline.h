@@ -0,0 +1,147 @@
+#ifndef LINE_BUFFERED_PIPELINE_H
+#define LINE_BUFFERED_PIPELINE_H
+
+#include "HalideBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+/** Runs a pipeline with a two-dimensional input on an image that
+ * arrives a few rows at a time, as it would from a sensor. Each strip
+ * of output rows is computed as soon as all of the input rows it
+ * depends on have arrived, and only those input rows are kept.
+ *
+ * The pipeline must be able to compute any strip of output rows whose
+ * min and extent are multiples of strip_height (e.g. camera_pipe built
+ * with streaming=true). The input rows each strip needs are found with
+ * a bounds query, so the pipeline must not have a boundary condition
+ * that makes it read outside of the input it is given. Rows of the
+ * input the pipeline needs for neighboring strips are recomputed for
+ * each strip, so smaller strips give lower latency at the cost of more
+ * redundant work. */
+template<typename InT, typename OutT>
+class LineBufferedPipeline {
+public:
+    /** Runs the pipeline on the given input, producing the given output.
+     * Returns a Halide error code. */
+    using Pipeline = std::function<int(halide_buffer_t *input, halide_buffer_t *output)>;
+
+    /** Called with the min and extent of each strip of output rows once
+     * it has been computed. */
+    using RowsReady = std::function<void(int y_min, int y_extent)>;
+
+    LineBufferedPipeline(Pipeline pipeline, int input_width, int input_height,
+                         Halide::Runtime::Buffer<OutT> output, int strip_height,
+                         RowsReady rows_ready)
+        : pipeline(pipeline), input_width(input_width), input_height(input_height),
+          output(output), strip_height(strip_height), rows_ready(rows_ready) {
+        assert(output.dim(1).min() % strip_height == 0 &&
+               output.dim(1).extent() % strip_height == 0);
+        reset();
+    }
+
+    /** Start a new frame. */
+    void reset() {
+        rows_received = 0;
+        window_min = 0;
+        window_rows = 0;
+        next_output_row = output.dim(1).min();
+        error = 0;
+    }
+
+    /** Append the next num_rows rows of the input, which are densely
+     * packed rows of input_width values each, and compute every strip
+     * of output rows that is now computable. Returns a Halide error
+     * code. */
+    int push_rows(const InT *rows, int num_rows) {
+        if (error) {
+            return error;
+        }
+        assert(rows_received + num_rows <= input_height);
+
+        // Drop the rows before the ones the next strip needs, and make
+        // room for the new ones.
+        if (!done()) {
+            int needed_min, needed_extent;
+            if ((error = input_rows_needed(next_output_row, &needed_min, &needed_extent))) {
+                return error;
+            }
+            const int drop = std::min(std::max(0, needed_min - window_min), window_rows);
+            if (drop > 0) {
+                std::memmove(window.data(), window.data() + (size_t)drop * input_width,
+                             (size_t)(window_rows - drop) * input_width * sizeof(InT));
+                window_min += drop;
+                window_rows -= drop;
+            }
+        }
+        const size_t elems = (size_t)(window_rows + num_rows) * input_width;
+        if (window.size() < elems) {
+            window.resize(elems);
+        }
+        std::memcpy(window.data() + (size_t)window_rows * input_width, rows,
+                    (size_t)num_rows * input_width * sizeof(InT));
+        window_rows += num_rows;
+        rows_received += num_rows;
+
+        while (!done()) {
+            int needed_min, needed_extent;
+            if ((error = input_rows_needed(next_output_row, &needed_min, &needed_extent))) {
+                return error;
+            }
+            assert(needed_min >= window_min);
+            if (needed_min + needed_extent > input_height) {
+                // The input is too small to compute this strip.
+                return error = halide_error_code_access_out_of_bounds;
+            }
+            if (needed_min + needed_extent > rows_received) {
+                break;
+            }
+            Halide::Runtime::Buffer<InT> in(window.data(), input_width, window_rows);
+            in.set_min(0, window_min);
+            Halide::Runtime::Buffer<OutT> out = output.cropped(1, next_output_row, strip_height);
+            if ((error = pipeline(in, out))) {
+                return error;
+            }
+            rows_ready(next_output_row, strip_height);
+            next_output_row += strip_height;
+        }
+        return 0;
+    }
+
+    /** Whether every row of the output has been computed. */
+    bool done() const {
+        return next_output_row >= output.dim(1).max() + 1;
+    }
+
+private:
+    Pipeline pipeline;
+    const int input_width, input_height;
+    Halide::Runtime::Buffer<OutT> output;
+    const int strip_height;
+    RowsReady rows_ready;
+
+    // The input rows still needed: rows [window_min, window_min +
+    // window_rows) of the input, densely packed.
+    std::vector<InT> window;
+    int window_min, window_rows;
+
+    int rows_received;
+    int next_output_row;
+    int error;
+
+    // Ask the pipeline which input rows the strip of output rows
+    // starting at y_min reads.
+    int input_rows_needed(int y_min, int *min, int *extent) {
+        Halide::Runtime::Buffer<InT> query(nullptr, input_width, 1);
+        Halide::Runtime::Buffer<OutT> out = output.cropped(1, y_min, strip_height);
+        int result = pipeline(query, out);
+        *min = query.dim(1).min();
+        *extent = query.dim(1).extent();
+        return result;
+    }
+};
+
+#endif
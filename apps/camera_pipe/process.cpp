@@ -4,11 +4,17 @@
 #ifndef NO_AUTO_SCHEDULE
 #include "camera_pipe_auto_schedule.h"
 #endif
+#ifndef NO_STREAMING
+#include "camera_pipe_streaming.h"
+#include "line_buffered_pipeline.h"
+#endif
 
 #include "HalideBuffer.h"
 #include "halide_image_io.h"
 #include "halide_malloc_trace.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -84,6 +90,63 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Halide (auto):\t%gus\n", best * 1e6);
     #endif
 
+    #ifndef NO_STREAMING
+    {
+        // Feed the input to the streaming variant a few rows at a
+        // time, as a sensor would deliver it, and measure how long each
+        // strip of output rows takes to compute once the last input row
+        // it needs has arrived.
+        const int rows_per_push = 8;
+        const int strip = 32;
+        Buffer<uint8_t> streamed(output.width(), output.height(), 3);
+        auto run = [&](halide_buffer_t *in, halide_buffer_t *out) {
+            return camera_pipe_streaming(in, matrix_3200, matrix_7000,
+                                         color_temp, gamma, contrast, sharpen, blackLevel, whiteLevel,
+                                         out);
+        };
+        LineBufferedPipeline<uint16_t, uint8_t> pipe(run, input.width(), input.height(),
+                                                     streamed, strip, [](int, int) {});
+        double best_frame = 0, worst_latency = 0;
+        for (int i = 0; i < std::max(timing_iterations, 1); i++) {
+            pipe.reset();
+            auto frame_start = std::chrono::high_resolution_clock::now();
+            for (int y = 0; y < input.height(); y += rows_per_push) {
+                auto start = std::chrono::high_resolution_clock::now();
+                int rows = std::min(rows_per_push, input.height() - y);
+                if (pipe.push_rows(&input(0, y), rows)) {
+                    fprintf(stderr, "Streaming camera_pipe failed\n");
+                    return -1;
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                worst_latency = std::max(worst_latency, std::chrono::duration<double>(end - start).count());
+            }
+            auto frame_end = std::chrono::high_resolution_clock::now();
+            double t = std::chrono::duration<double>(frame_end - frame_start).count();
+            best_frame = i == 0 ? t : std::min(best_frame, t);
+        }
+        fprintf(stderr, "Halide (streaming):\t%gus per frame, worst latency %gus\n",
+                best_frame * 1e6, worst_latency * 1e6);
+
+        // The strips of the streaming variant should exactly match the
+        // whole frame.
+        camera_pipe(input, matrix_3200, matrix_7000,
+                    color_temp, gamma, contrast, sharpen, blackLevel, whiteLevel,
+                    output);
+        output.device_sync();
+        for (int c = 0; c < output.channels(); c++) {
+            for (int y = 0; y < output.height(); y++) {
+                for (int x = 0; x < output.width(); x++) {
+                    if (streamed(x, y, c) != output(x, y, c)) {
+                        fprintf(stderr, "Streaming camera_pipe mismatch at %d %d %d: %d vs %d\n",
+                                x, y, c, streamed(x, y, c), output(x, y, c));
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+    #endif
+
     fprintf(stderr, "output: %s\n", argv[7]);
     convert_and_save_image(output, argv[7]);
     fprintf(stderr, "        %d %d\n", output.width(), output.height());
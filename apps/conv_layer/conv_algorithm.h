@@ -0,0 +1,48 @@
+#ifndef CONV_ALGORITHM_H
+#define CONV_ALGORITHM_H
+
+// The convolution layers in this app all compute the same (valid, unit
+// stride) convolution, at different costs.
+enum class ConvAlgorithm {
+    // conv_layer: any filter size.
+    Direct,
+    // winograd_conv_layer: 3x3 filters only.
+    Winograd,
+    // fft_conv_layer: any square filter the FFT generators were built for.
+    FFT,
+};
+
+// Choose the convolution algorithm for a layer. Winograd and FFT
+// convolutions transform the input once per input channel and the
+// output once per output channel, so they only pay off when those
+// transforms are amortized over many channel pairs. The filter
+// transforms are assumed to be cached with the weights.
+inline ConvAlgorithm choose_conv_algorithm(int filter_width, int filter_height,
+                                           int input_channels, int output_channels) {
+    const int min_channels = 16;
+    if (input_channels < min_channels || output_channels < min_channels) {
+        return ConvAlgorithm::Direct;
+    }
+    if (filter_width == 3 && filter_height == 3) {
+        // F(4x4, 3x3) does 4x fewer multiplies, and its tiles are
+        // small enough to keep the transforms in registers.
+        return ConvAlgorithm::Winograd;
+    }
+    if (filter_width >= 5 && filter_width == filter_height) {
+        // The cost of the FFT convolution doesn't grow with the filter
+        // size, while the direct convolution's grows quadratically.
+        return ConvAlgorithm::FFT;
+    }
+    return ConvAlgorithm::Direct;
+}
+
+inline const char *conv_algorithm_name(ConvAlgorithm a) {
+    switch (a) {
+    case ConvAlgorithm::Direct: return "direct";
+    case ConvAlgorithm::Winograd: return "winograd";
+    case ConvAlgorithm::FFT: return "fft";
+    }
+    return "unknown";
+}
+
+#endif
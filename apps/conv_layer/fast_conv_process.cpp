@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "conv_layer.h"
+#include "winograd_weights.h"
+#include "winograd_conv_layer.h"
+#include "fft_weights_3x3.h"
+#include "fft_conv_layer_3x3.h"
+#include "fft_weights_5x5.h"
+#include "fft_conv_layer_5x5.h"
+
+#include "conv_algorithm.h"
+
+#include "halide_benchmark.h"
+#include "HalideBuffer.h"
+
+using namespace Halide::Tools;
+using namespace Halide::Runtime;
+
+namespace {
+
+// Must match the tile_size the FFT generators were built with.
+const int fft_tile_size = 16;
+
+Buffer<float> random_buffer(int w, int h, int c, int n) {
+    Buffer<float> buf(w, h, c, n);
+    buf.for_each_value([](float &v) { v = (float)rand() / RAND_MAX - 0.5f; });
+    return buf;
+}
+
+// Returns true if the output is within a tolerance of the direct
+// convolution, relative to the largest output.
+bool check(const char *name, const Buffer<float> &output, const Buffer<float> &reference) {
+    float max_ref = 0.0f, max_err = 0.0f;
+    reference.for_each_element([&](int x, int y, int z, int n) {
+        max_ref = std::max(max_ref, std::abs(reference(x, y, z, n)));
+        max_err = std::max(max_err, std::abs(output(x, y, z, n) - reference(x, y, z, n)));
+    });
+    if (max_err > 1e-3f * max_ref) {
+        printf("%s convolution is incorrect: max error %g (max output %g)\n",
+               name, max_err, max_ref);
+        return false;
+    }
+    return true;
+}
+
+// Runs each of the algorithms that apply to a filter_size x
+// filter_size convolution layer. The filter transforms are computed
+// once, outside of the timing loop, like they would be when loading
+// the weights of a network.
+bool run_layer(int filter_size, int width, int height, int channels, int batch) {
+    Buffer<float> input = random_buffer(width + filter_size - 1,
+                                        height + filter_size - 1,
+                                        channels, batch);
+    Buffer<float> filter = random_buffer(filter_size, filter_size, channels, channels);
+    Buffer<float> bias(channels);
+    bias.for_each_value([](float &v) { v = (float)rand() / RAND_MAX - 0.5f; });
+
+    ConvAlgorithm chosen = choose_conv_algorithm(filter_size, filter_size, channels, channels);
+    printf("%dx%d filters, %d channels: choosing %s\n",
+           filter_size, filter_size, channels, conv_algorithm_name(chosen));
+
+    Buffer<float> reference(width, height, channels, batch);
+    conv_layer(input, filter, bias, reference);
+    double t_direct = benchmark(10, 10, [&]() {
+        conv_layer(input, filter, bias, reference);
+    });
+    printf("  direct:   %gms\n", t_direct * 1e3);
+
+    bool success = true;
+    Buffer<float> output(width, height, channels, batch);
+
+    if (filter_size == 3) {
+        Buffer<float> winograd_filter(6, 6, channels, channels);
+        winograd_weights(filter, winograd_filter);
+        winograd_conv_layer(input, winograd_filter, bias, output);
+        success &= check("Winograd", output, reference);
+        double t = benchmark(10, 10, [&]() {
+            winograd_conv_layer(input, winograd_filter, bias, output);
+        });
+        printf("  winograd: %gms (%.2fx)\n", t * 1e3, t_direct / t);
+    }
+
+    Buffer<float> fft_filter(fft_tile_size, fft_tile_size / 2 + 1, channels, channels, 2);
+    auto fft_weights = filter_size == 3 ? fft_weights_3x3 : fft_weights_5x5;
+    auto fft_conv_layer = filter_size == 3 ? fft_conv_layer_3x3 : fft_conv_layer_5x5;
+    fft_weights(filter, fft_filter);
+    fft_conv_layer(input, fft_filter, bias, output);
+    success &= check("FFT", output, reference);
+    double t = benchmark(10, 10, [&]() {
+        fft_conv_layer(input, fft_filter, bias, output);
+    });
+    printf("  fft:      %gms (%.2fx)\n", t * 1e3, t_direct / t);
+
+    return success;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool success = true;
+    success &= run_layer(3, 64, 64, 32, 4);
+    success &= run_layer(5, 64, 64, 32, 4);
+    if (!success) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
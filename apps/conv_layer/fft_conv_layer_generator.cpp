@@ -0,0 +1,137 @@
+#include "Halide.h"
+
+#include "fft.h"
+
+namespace {
+
+using namespace Halide;
+
+// FFT convolution by overlap-save. The input is cut into overlapping
+// tile_size x tile_size tiles, which are transformed, multiplied with
+// the transformed filters and summed over the input channels, and
+// transformed back. The first (tile_size - filter_size + 1) samples
+// of each dimension of the result are the output of the convolution;
+// the rest are wrapped around and discarded. The cost per output
+// sample is independent of the filter size, so this is faster than
+// the direct convolution for large filters.
+
+// Transforms the filters to the frequency domain of the tiles. As the
+// transform only depends on the weights, this is computed once when
+// the weights are loaded and the result is passed to every call of
+// fft_conv_layer. The result is conjugated, because the layer
+// computes a correlation, and scaled by the gain of the inverse FFT.
+class FFTWeights : public Halide::Generator<FFTWeights> {
+public:
+    GeneratorParam<int> tile_size{"tile_size", 16};
+    GeneratorParam<int> filter_size{"filter_size", 5};
+
+    // (x, y, input channel, output channel)
+    Input<Buffer<float>>  filter{"filter", 4};
+    // (frequency x, frequency y, input channel, output channel,
+    // real/imaginary)
+    Output<Buffer<float>> transformed_filter{"transformed_filter", 5};
+
+    void generate() {
+        const int N = tile_size;
+        const int K = filter_size;
+        _halide_user_assert(K <= N) << "The filter must fit in a tile\n";
+
+        Var x("x"), y("y"), ci("ci"), co("co"), c("c");
+
+        Func padded("padded");
+        padded(x, y, ci, co) =
+            BoundaryConditions::constant_exterior(filter, 0.0f)(x, y, ci, co);
+
+        Fft2dDesc desc;
+        desc.gain = 1.0f / (N * N);
+        ComplexFunc F = fft2d_r2c(padded, N, N, get_target(), desc);
+
+        transformed_filter(x, y, ci, co, c) =
+            select(c == 0, re(F(x, y, ci, co)), -im(F(x, y, ci, co)));
+
+        filter.dim(0).set_bounds(0, K).dim(1).set_bounds(0, K);
+        transformed_filter.bound(c, 0, 2);
+
+        F.compute_at(transformed_filter, ci);
+        transformed_filter.reorder(c, x, y, ci, co).unroll(c).parallel(co);
+    }
+};
+
+class FFTConvolutionLayer : public Halide::Generator<FFTConvolutionLayer> {
+public:
+    GeneratorParam<int> tile_size{"tile_size", 16};
+    GeneratorParam<int> filter_size{"filter_size", 5};
+
+    Input<Buffer<float>>  input{"input", 4};
+    // The output of fft_weights, generated with the same tile_size
+    // and filter_size.
+    Input<Buffer<float>>  transformed_filter{"transformed_filter", 5};
+    Input<Buffer<float>>  bias{"bias", 1};
+
+    Output<Buffer<float>> f_ReLU{"ReLU", 4};
+
+    void generate() {
+        const int N = tile_size;
+        const int K = filter_size;
+        _halide_user_assert(K <= N) << "The filter must fit in a tile\n";
+
+        /* THE ALGORITHM */
+
+        Var x("x"), y("y"), z("z"), n("n");
+        Var tx("tx"), ty("ty");
+
+        // The number of valid outputs along each dimension of a tile.
+        const int step = N - K + 1;
+
+        Func in = BoundaryConditions::constant_exterior(input, 0.0f);
+
+        Func tiles("tiles");
+        tiles(x, y, tx, ty, z, n) = in(tx * step + x, ty * step + y, z, n);
+
+        Fft2dDesc desc;
+        desc.name = "input";
+        ComplexFunc X = fft2d_r2c(tiles, N, N, get_target(), desc);
+
+        // The pointwise products, summed over the input channels.
+        RDom r(transformed_filter.dim(2).min(), transformed_filter.dim(2).extent());
+        ComplexFunc P("P");
+        P(x, y, tx, ty, z, n) = ComplexExpr(0.0f, 0.0f);
+        P(x, y, tx, ty, z, n) +=
+            X(x, y, tx, ty, r, n) * ComplexExpr(transformed_filter(x, y, r, z, 0),
+                                                transformed_filter(x, y, r, z, 1));
+
+        desc.name = "output";
+        Func conv = fft2d_c2r(P, N, N, get_target(), desc);
+
+        f_ReLU(x, y, z, n) =
+            max(0, bias(z) + conv(x % step, y % step, x / step, y / step, z, n));
+
+        /* THE SCHEDULE */
+
+        transformed_filter.dim(4).set_bounds(0, 2);
+
+        const int vec = natural_vector_size<float>();
+
+        // Compute a row of tiles at a time. The transforms of the
+        // input tiles are shared by all of the output channels.
+        Var yo("yo"), yi("yi"), yn("yn");
+        f_ReLU.split(y, yo, yi, step)
+            .reorder(x, yi, z, yo, n)
+            .vectorize(x, vec)
+            .fuse(yo, n, yn)
+            .parallel(yn);
+
+        X.compute_at(f_ReLU, yn);
+        P.compute_at(f_ReLU, yn)
+            .vectorize(x, vec);
+        P.update()
+            .reorder(x, r, y, tx, z)
+            .vectorize(x, vec);
+        conv.compute_at(f_ReLU, z);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(FFTWeights, fft_weights)
+HALIDE_REGISTER_GENERATOR(FFTConvolutionLayer, fft_conv_layer)
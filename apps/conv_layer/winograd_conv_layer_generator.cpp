@@ -0,0 +1,218 @@
+#include "Halide.h"
+
+namespace {
+
+using namespace Halide;
+
+// Winograd F(4x4, 3x3) convolution. Each 4x4 tile of the output is
+// computed from a 6x6 tile of the input as
+//
+//   Y = A^T [ sum_c (G g G^T) .* (B^T d B) ] A
+//
+// which costs 36 multiplies per tile and channel pair, instead of the
+// 144 the direct convolution needs. The transform matrices are the
+// ones from Lavin & Gray, "Fast Algorithms for Convolutional Neural
+// Networks".
+const int tile_size = 4;
+const int transform_size = tile_size + 2;
+
+const float BT[6][6] = {
+    {4.0f,  0.0f, -5.0f,  0.0f, 1.0f, 0.0f},
+    {0.0f, -4.0f, -4.0f,  1.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f, -4.0f, -1.0f, 1.0f, 0.0f},
+    {0.0f, -2.0f, -1.0f,  2.0f, 1.0f, 0.0f},
+    {0.0f,  2.0f, -1.0f, -2.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f,  0.0f, -5.0f, 0.0f, 1.0f},
+};
+
+const float G[6][3] = {
+    { 1.0f / 4,        0.0f,       0.0f},
+    {-1.0f / 6,  -1.0f / 6,  -1.0f / 6},
+    {-1.0f / 6,   1.0f / 6,  -1.0f / 6},
+    { 1.0f / 24,  1.0f / 12,  1.0f / 6},
+    { 1.0f / 24, -1.0f / 12,  1.0f / 6},
+    {      0.0f,       0.0f,      1.0f},
+};
+
+const float AT[4][6] = {
+    {1.0f, 1.0f,  1.0f, 1.0f,  1.0f, 0.0f},
+    {0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.0f},
+    {0.0f, 1.0f,  1.0f, 4.0f,  4.0f, 0.0f},
+    {0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 1.0f},
+};
+
+// Select column j of a constant matrix with the row given by an
+// Expr. Once the loop over the row is unrolled, this simplifies to a
+// constant, and the multiplies by the zeros in the matrix vanish.
+template <int R, int C>
+Expr coefficient(const float (&m)[R][C], Expr row, int j) {
+    Expr result = m[R - 1][j];
+    for (int i = R - 2; i >= 0; i--) {
+        result = select(row == i, m[i][j], result);
+    }
+    return result;
+}
+
+// Transforms 3x3 filters into the 6x6 Winograd domain. The transform
+// only depends on the weights, so it is computed once when the
+// weights are loaded and the result is passed to every call of
+// winograd_conv_layer.
+class WinogradWeights : public Halide::Generator<WinogradWeights> {
+public:
+    // (x, y, input channel, output channel)
+    Input<Buffer<float>>  filter{"filter", 4};
+    // (transform x, transform y, input channel, output channel)
+    Output<Buffer<float>> transformed_filter{"transformed_filter", 4};
+
+    void generate() {
+        Var e("e"), u("u"), i("i"), ci("ci"), co("co");
+
+        // G g, along x.
+        Func Gg("Gg");
+        Expr Gg_e = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            Gg_e += coefficient(G, e, j) * filter(j, i, ci, co);
+        }
+        Gg(e, i, ci, co) = Gg_e;
+
+        // (G g) G^T, along y.
+        Expr GgGT = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            GgGT += coefficient(G, u, j) * Gg(e, j, ci, co);
+        }
+        transformed_filter(e, u, ci, co) = GgGT;
+
+        filter.dim(0).set_bounds(0, 3).dim(1).set_bounds(0, 3);
+        transformed_filter.bound(e, 0, transform_size)
+                          .bound(u, 0, transform_size);
+
+        // This runs once per set of weights, so the schedule is kept
+        // simple.
+        Gg.compute_at(transformed_filter, ci).unroll(e).unroll(i);
+        transformed_filter.reorder(e, u, ci, co)
+            .unroll(e).unroll(u)
+            .parallel(co);
+    }
+};
+
+class WinogradConvolutionLayer : public Halide::Generator<WinogradConvolutionLayer> {
+public:
+    Input<Buffer<float>>  input{"input", 4};
+    // The output of winograd_weights.
+    Input<Buffer<float>>  transformed_filter{"transformed_filter", 4};
+    Input<Buffer<float>>  bias{"bias", 1};
+
+    Output<Buffer<float>> f_ReLU{"ReLU", 4};
+
+    void generate() {
+        /* THE ALGORITHM */
+
+        Var x("x"), y("y"), z("z"), n("n");
+        Var e("e"), u("u"), i("i"), tx("tx"), ty("ty"), c("c");
+
+        // Partial tiles at the edges of the output read past the end
+        // of the input.
+        Func in = BoundaryConditions::constant_exterior(input, 0.0f);
+
+        // The input transform B^T d B, one 6x6 tile at a time.
+        Func BTd("BTd");
+        Expr BTd_e = 0.0f;
+        for (int j = 0; j < transform_size; j++) {
+            BTd_e += coefficient(BT, e, j) *
+                in(tx * tile_size + j, ty * tile_size + i, c, n);
+        }
+        BTd(e, i, tx, ty, c, n) = BTd_e;
+
+        Func V("V");
+        Expr V_e = 0.0f;
+        for (int j = 0; j < transform_size; j++) {
+            V_e += coefficient(BT, u, j) * BTd(e, j, tx, ty, c, n);
+        }
+        V(e, u, tx, ty, c, n) = V_e;
+
+        // The elementwise products, summed over the input
+        // channels. This is a batch of 36 matrix multiplies.
+        Func M("M");
+        RDom r(transformed_filter.dim(2).min(), transformed_filter.dim(2).extent());
+        M(e, u, tx, ty, z, n) = 0.0f;
+        M(e, u, tx, ty, z, n) += transformed_filter(e, u, r, z) * V(e, u, tx, ty, r, n);
+
+        // The output transform A^T M A.
+        Func ATM("ATM");
+        Expr ATM_e = 0.0f;
+        for (int j = 0; j < transform_size; j++) {
+            ATM_e += coefficient(AT, e, j) * M(j, u, tx, ty, z, n);
+        }
+        ATM(e, u, tx, ty, z, n) = ATM_e;
+
+        Func Y("Y");
+        Expr Y_e = 0.0f;
+        for (int j = 0; j < transform_size; j++) {
+            Y_e += coefficient(AT, u, j) * ATM(e, j, tx, ty, z, n);
+        }
+        Y(e, u, tx, ty, z, n) = Y_e;
+
+        f_ReLU(x, y, z, n) =
+            max(0, bias(z) + Y(x % tile_size, y % tile_size,
+                               x / tile_size, y / tile_size, z, n));
+
+        /* THE SCHEDULE */
+
+        transformed_filter.dim(0).set_bounds(0, transform_size)
+                          .dim(1).set_bounds(0, transform_size);
+
+        const int vec = natural_vector_size<float>();
+
+        // Transform the input one row of tiles at a time, vectorized
+        // across the tiles.
+        Var tn("tn");
+        V.compute_root()
+            .reorder(e, u, tx, c, ty, n)
+            .unroll(e).unroll(u)
+            .vectorize(tx, vec)
+            .fuse(ty, n, tn)
+            .parallel(tn);
+        V.bound(e, 0, transform_size).bound(u, 0, transform_size);
+        V.reorder_storage(tx, e, u, c, ty, n);
+        BTd.compute_at(V, c)
+            .reorder(e, i, tx)
+            .unroll(e).unroll(i)
+            .vectorize(tx, vec);
+
+        // Block the batched matrix multiply over the output channels,
+        // keeping the accumulators in registers.
+        Var zi("zi"), yo("yo"), yi("yi"), yn("yn");
+        M.compute_at(f_ReLU, yn)
+            .reorder_storage(tx, z, e, u, ty, n)
+            .vectorize(tx, vec);
+        M.update()
+            .split(z, z, zi, 4, TailStrategy::GuardWithIf)
+            .reorder(tx, zi, r, e, u, z)
+            .vectorize(tx, vec)
+            .unroll(zi);
+
+        // Apply the output transform one row of tiles at a time,
+        // stored so the tiles along x are dense.
+        Y.compute_at(f_ReLU, z)
+            .reorder(e, u, tx)
+            .unroll(e).unroll(u)
+            .vectorize(tx, vec);
+        Y.reorder_storage(e, tx, u, ty, z, n);
+        Y.bound(e, 0, tile_size).bound(u, 0, tile_size);
+        ATM.compute_at(f_ReLU, z)
+            .reorder(e, u, tx)
+            .unroll(e).unroll(u)
+            .vectorize(tx, vec);
+
+        f_ReLU.split(y, yo, yi, tile_size)
+            .reorder(x, yi, z, yo, n)
+            .vectorize(x, vec)
+            .fuse(yo, n, yn)
+            .parallel(yn);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(WinogradWeights, winograd_weights)
+HALIDE_REGISTER_GENERATOR(WinogradConvolutionLayer, winograd_conv_layer)
@@ -6,6 +6,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <complex>
 #include <cstddef>
 #include <limits>
 #include <map>
@@ -286,6 +287,21 @@ ComplexFunc twiddle_factors(int N, Expr gain, int sign,
     return W;
 }
 
+// Radices larger than this are too expensive to compute directly,
+// so FFTs of sizes with such a factor use Bluestein's algorithm instead.
+const int kMaxDirectRadix = 64;
+
+vector<int> radix_factor(int N);
+
+ComplexFunc fft_dim1_bluestein(ComplexFunc x,
+                               int N,
+                               int sign,
+                               int extent_0,
+                               Expr gain,
+                               bool parallel,
+                               const string& prefix,
+                               const Target& target);
+
 // Compute the N point DFT of dimension 1 (columns) of x using
 // radix R.
 ComplexFunc fft_dim1(ComplexFunc x,
@@ -299,6 +315,12 @@ ComplexFunc fft_dim1(ComplexFunc x,
                      TwiddleFactorSet* twiddle_cache) {
     int N = product(NR);
 
+    for (int R : NR) {
+        if (R > kMaxDirectRadix) {
+            return fft_dim1_bluestein(x, N, sign, extent_0, gain, parallel, prefix, target);
+        }
+    }
+
     vector<Var> args = x.args();
     Var n0(args[0]), n1(args[1]);
     args.erase(args.begin());
@@ -413,6 +435,124 @@ ComplexFunc fft_dim1(ComplexFunc x,
     return x;
 }
 
+// Compute the DFT of z in place, in double precision. The size of z must
+// be a power of 2. This is only used to compute constant tables when
+// defining an FFT.
+void fft_radix2(vector<std::complex<double>> &z, int sign) {
+    const size_t N = z.size();
+    for (size_t i = 1, j = 0; i < N; i++) {
+        size_t bit = N >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(z[i], z[j]);
+        }
+    }
+    for (size_t len = 2; len <= N; len *= 2) {
+        for (size_t k = 0; k < len / 2; k++) {
+            std::complex<double> w = std::polar(1.0, sign * 2 * M_PI * k / len);
+            for (size_t i = k; i < N; i += len) {
+                std::complex<double> u = z[i];
+                std::complex<double> v = z[i + len / 2] * w;
+                z[i] = u + v;
+                z[i + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+// Compute the N point DFT of dimension 1 of x using Bluestein's
+// algorithm. Using the chirp c_n = expj(sign * pi * n^2 / N), the DFT
+// can be written as a convolution:
+//
+//   X_k = c_k * sum_n (x_n * c_n) * conj(c_(k - n))
+//
+// We compute the convolution with a pair of FFTs of a power of 2 size
+// M >= 2*N - 1. The chirp and the DFT of its conjugate are constants,
+// which we compute in double precision and embed in the pipeline.
+ComplexFunc fft_dim1_bluestein(ComplexFunc x,
+                               int N,
+                               int sign,
+                               int extent_0,
+                               Expr gain,
+                               bool parallel,
+                               const string& prefix,
+                               const Target& target) {
+    int M = 1;
+    while (M < 2 * N - 1) {
+        M *= 2;
+    }
+
+    // The conjugate chirp is needed for k - n in (-N, N), which wraps
+    // around to the end of the convolution of size M.
+    Buffer<float> chirp_table(N, 2, prefix + "chirp_table");
+    vector<std::complex<double>> b(M, 0.0);
+    for (int n = 0; n < N; n++) {
+        // Reduce n^2 modulo 2N so the angle stays accurate for large n.
+        int64_t n2 = ((int64_t)n * n) % (2 * N);
+        double theta = sign * M_PI * n2 / N;
+        chirp_table(n, 0) = (float)cos(theta);
+        chirp_table(n, 1) = (float)sin(theta);
+        b[n] = std::polar(1.0, -theta);
+        if (n > 0) {
+            b[M - n] = b[n];
+        }
+    }
+    fft_radix2(b, -1);
+
+    // Fold the normalization of the inverse FFT into the table.
+    Buffer<float> b_dft_table(M, 2, prefix + "b_dft_table");
+    for (int k = 0; k < M; k++) {
+        b_dft_table(k, 0) = (float)(b[k].real() / M);
+        b_dft_table(k, 1) = (float)(b[k].imag() / M);
+    }
+
+    vector<Var> args = x.args();
+    Var n0(args[0]), n1(args[1]);
+    args.erase(args.begin());
+    args.erase(args.begin());
+
+    ComplexFunc chirp(prefix + "chirp");
+    chirp(n1) = ComplexExpr(chirp_table(n1, 0), chirp_table(n1, 1));
+    ComplexFunc b_dft(prefix + "b_dft");
+    b_dft(n1) = ComplexExpr(b_dft_table(n1, 0), b_dft_table(n1, 1));
+
+    // Apply the chirp, and zero pad to M points.
+    Expr n1_clamped = clamp(n1, 0, N - 1);
+    ComplexFunc a(prefix + "bluestein_a");
+    a(A({n0, n1}, args)) = select(n1 < N,
+                                  cast<float>(x(A({n0, n1_clamped}, args))) * chirp(n1_clamped),
+                                  ComplexExpr(0.0f, 0.0f));
+
+    // Convolve with the conjugate chirp. The two FFTs have opposite
+    // signs, so they can't share twiddle factors.
+    vector<int> RM = radix_factor(M);
+    TwiddleFactorSet forward_twiddles, inverse_twiddles;
+    ComplexFunc a_dft = fft_dim1(a, RM, -1, extent_0, 1.0f, false,
+                                 prefix + "bluestein_fwd_", target, &forward_twiddles);
+    ComplexFunc ab_dft(prefix + "bluestein_ab_dft");
+    ab_dft(A({n0, n1}, args)) = a_dft(A({n0, n1}, args)) * b_dft(n1);
+    ComplexFunc ab = fft_dim1(ab_dft, RM, 1, extent_0, 1.0f, false,
+                              prefix + "bluestein_inv_", target, &inverse_twiddles);
+
+    ComplexFunc X(prefix + "bluestein");
+    X(A({n0, n1}, args)) = ab(A({n0, n1}, args)) * chirp(n1) * gain;
+    X.bound(n1, 0, N);
+
+    int vector_width = std::min(target.natural_vector_size<float>(), extent_0);
+    X.split(n0, group, n0, vector_width)
+        .vectorize(n0);
+    if (parallel) {
+        X.parallel(group);
+    }
+    a_dft.compute_at(X, group);
+    ab.compute_at(X, group);
+
+    return X;
+}
+
 // transpose the first two dimensions of x.
 template <typename FuncType>
 FuncType transpose(FuncType f) {
@@ -1017,7 +1157,7 @@ vector<int> radix_factor(int N) {
     }
 
     // Factor N into factors found in the 'radices' set.
-    static const int radices[] = { 8, 6, 4, 2 };
+    static const int radices[] = { 8, 6, 4, 2, 3, 5, 7 };
     vector<int> R;
     for (int r : radices) {
         while (N % r == 0) {
@@ -1026,7 +1166,15 @@ vector<int> radix_factor(int N) {
         }
     }
 
-    // If there are still factors left over, just include them as a radix.
+    // Any remaining factors are primes that we compute with a direct
+    // DFT. If one of these is larger than kMaxDirectRadix, fft_dim1
+    // uses Bluestein's algorithm for the whole dimension instead.
+    for (int p = 11; p * p <= N; p += 2) {
+        while (N % p == 0) {
+            R.push_back(p);
+            N /= p;
+        }
+    }
     if (N != 1 || R.empty()) {
         R.push_back(N);
     }
@@ -10,6 +10,7 @@
 #include "fft_inverse_c2r.h"
 #include "fft_forward_c2c.h"
 #include "fft_inverse_c2c.h"
+#include "fft_forward_r2c_batch.h"
 
 namespace {
 const float kPi = 3.14159265358979310000f;
@@ -292,5 +293,50 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Batched forward real to complex test, of a size that needs the
+    // complex fallback in x and Bluestein's algorithm in y.
+    {
+        std::cout << "Batched forward real to complex test." << std::endl;
+
+        const int size0 = 15, size1 = 67, batch = 3;
+
+        Buffer<float, 4> in({size0, size1, 1, batch}, {2, 0, 1, 3});
+        in.for_each_element([&](int x, int y, int c, int b) {
+            in(x, y, c, b) = sin(x * 0.7f + b) + cos(y * 1.3f - b);
+        });
+
+        Buffer<float, 4> out({size0, size1 / 2 + 1, 2, batch}, {2, 0, 1, 3});
+
+        int halide_result;
+        halide_result = fft_forward_r2c_batch(in, out);
+        if (halide_result != 0) {
+            std::cerr << "fft_forward_r2c_batch failed returning " << halide_result << std::endl;
+            exit(1);
+        }
+
+        // Compare against a direct DFT.
+        for (int b = 0; b < batch; b++) {
+            for (int j = 0; j < size1 / 2 + 1; j++) {
+                for (int i = 0; i < size0; i++) {
+                    double real = 0, imaginary = 0;
+                    for (int y = 0; y < size1; y++) {
+                        for (int x = 0; x < size0; x++) {
+                            double theta = -2 * kPi * ((double)(i * x) / size0 + (double)(j * y) / size1);
+                            real += in(x, y, 0, b) * cos(theta);
+                            imaginary += in(x, y, 0, b) * sin(theta);
+                        }
+                    }
+                    if (fabs(out(i, j, 0, b) - real) > .01 ||
+                        fabs(out(i, j, 1, b) - imaginary) > .01) {
+                        std::cerr << "fft_forward_r2c_batch mismatch at (" << i << ", " << j << ", " << b << ") "
+                                  << out(i, j, 0, b) << " + " << out(i, j, 1, b) << "j vs. "
+                                  << real << " + " << imaginary << "j" << std::endl;
+                        exit(1);
+                    }
+                }
+            }
+        }
+    }
+
     exit(0);
 }
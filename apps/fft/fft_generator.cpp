@@ -5,6 +5,7 @@
 namespace {
 
 using namespace Halide;
+using std::vector;
 
 enum class FFTNumberType { Real, Complex };
 std::map<std::string, FFTNumberType> fft_number_type_enum_map() {
@@ -80,11 +81,24 @@ public:
     // Dim0: extent = size0, stride = 2
     // Dim1: extent = size1, stride = size0 * 2
     // Dim2: extent = 2, stride = 1 (real followed by imaginary components)
-    Input<Buffer<float>>  input{"input", 3};
-    Output<Buffer<float>> output{"output", 3};
+    //
+    // The number of dimensions is set with the input.dim GeneratorParam,
+    // and must be 3 or 4. If it is 4, dimension 3 of the input and output
+    // is a batch of independent FFTs, which are computed in parallel.
+    //
+    // Sizes may have any factors. Sizes with a prime factor too large to
+    // compute directly use Bluestein's algorithm. The real to complex and
+    // complex to real FFTs require size0 to be even; for odd size0 they
+    // fall back to a complex FFT.
+    Input<Buffer<float>>  input{"input"};
+    Output<Buffer<float>> output{"output"};
 
     void generate() {
         _halide_user_assert(size0 > 0) << "FFT must be at least 1D\n";
+        _halide_user_assert(input.dimensions() == 3 || input.dimensions() == 4)
+            << "input.dim must be 3, or 4 for a batch of FFTs\n";
+        batched = input.dimensions() == 4;
+        const bool even_size0 = size0 % 2 == 0;
 
         Fft2dDesc desc;
 
@@ -105,36 +119,62 @@ public:
                 // -> Func conversion should happen, It may not work
                 // with implicit dimension (use of _) logic in FFT.
                 Func in;
-                in(x, y) = input(x, y, 0);
-
-                complex_result = fft2d_r2c(in, size0, size1, target, desc);
+                in(xy()) = input(xyc(0));
+
+                if (even_size0) {
+                    complex_result = fft2d_r2c(in, size0, size1, target, desc);
+                } else {
+                    // Compute the complex FFT, and only produce the
+                    // part of it the r2c FFT would.
+                    ComplexFunc in_c;
+                    in_c(xy()) = ComplexExpr(in(xy()), 0);
+                    complex_result = fft2d_c2c(in_c, size0, size1, sign, target, desc);
+                }
             } else {
                 ComplexFunc in;
-                in(x, y) = ComplexExpr(input(x, y, 0), 0);
+                in(xy()) = ComplexExpr(input(xyc(0)), 0);
 
                 complex_result = fft2d_c2c(in, size0, size1, sign, target, desc);
             }
         } else {
             ComplexFunc in;
-            in(x, y) = ComplexExpr(input(x, y, 0), input(x, y, 1));
+            in(xy()) = ComplexExpr(input(xyc(0)), input(xyc(1)));
             if (output_number_type == FFTNumberType::Real &&
                 direction == FFTDirection::FrequencyToSamples) {
-                real_result = fft2d_c2r(in, size0, size1, target, desc);
+                if (even_size0) {
+                    real_result = fft2d_c2r(in, size0, size1, target, desc);
+                } else {
+                    // Reconstruct the redundant half of the input from
+                    // its conjugate symmetry, and compute the complex FFT.
+                    const int half1 = size1 / 2;
+                    vector<Expr> mirror = xy();
+                    mirror[0] = (size0 - x) % size0;
+                    mirror[1] = clamp(size1 - y, 0, half1);
+                    vector<Expr> direct = xy();
+                    direct[1] = min(y, half1);
+                    ComplexFunc in_full;
+                    in_full(xy()) = select(y <= half1, in(direct), conj(in(mirror)));
+                    complex_result = fft2d_c2c(in_full, size0, size1, sign, target, desc);
+                }
             } else {
                 complex_result = fft2d_c2c(in, size0, size1, sign, target, desc);
             }
         }
 
+        vector<Var> args = {x, y, c};
+        if (batched) {
+            args.push_back(b);
+        }
         if (output_number_type == FFTNumberType::Real) {
             if (real_result.defined()) {
-                 output(x, y, c) = real_result(x, y);
+                 output(args) = real_result(xy());
             } else {
-                 output(x, y, c) = re(complex_result(x, y));
+                 output(args) = re(complex_result(xy()));
             }
         } else {
-            output(x, y, c) = select(c == 0,
-                                     re(complex_result(x, y)),
-                                     im(complex_result(x, y)));
+            output(args) = select(c == 0,
+                                  re(complex_result(xy())),
+                                  im(complex_result(xy())));
         }
     }
 
@@ -152,17 +192,43 @@ public:
             output.reorder(c, x, y).unroll(c);
         }
 
+        // Compute each FFT of a batch separately, in parallel.
+        LoopLevel fft_level = LoopLevel(output, Var::outermost());
+        if (batched) {
+            output.parallel(b);
+            fft_level = LoopLevel(output, b);
+        }
+
         if (real_result.defined()) {
-            real_result.compute_at(output, Var::outermost());
+            real_result.compute_at(fft_level);
         } else {
             assert(complex_result.defined());
-            complex_result.compute_at(output, Var::outermost());
+            complex_result.compute_at(fft_level);
         }
     }
 private:
-    Var x{"x"}, y{"y"}, c{"c"};
+    Var x{"x"}, y{"y"}, c{"c"}, b{"b"};
     Func real_result;
     ComplexFunc complex_result;
+    bool batched = false;
+
+    // The arguments of the FFT, with the batch dimension if there is one.
+    vector<Expr> xy() const {
+        vector<Expr> args = {x, y};
+        if (batched) {
+            args.push_back(b);
+        }
+        return args;
+    }
+
+    // The arguments of the input buffer for component c.
+    vector<Expr> xyc(int c) const {
+        vector<Expr> args = {x, y, c};
+        if (batched) {
+            args.push_back(b);
+        }
+        return args;
+    }
 };
 
 }  // namespace
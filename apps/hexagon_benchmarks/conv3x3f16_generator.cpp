@@ -0,0 +1,77 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+// A 3x3 convolution with float16 multiplies accumulated in float32,
+// to measure the HVX v68 floating point instructions.
+class Conv3x3f16 : public Generator<Conv3x3f16> {
+public:
+    // Takes an 8 bit image; one channel.
+    Input<Buffer<uint8_t>> input{"input", 2};
+    // The mask coefficients are rounded to float16.
+    Input<Buffer<float>> mask{"mask", 2};
+    // Outputs a float image; one channel.
+    Output<Buffer<float>> output{"output", 2};
+
+    GeneratorParam<bool> use_parallel_sched{"use_parallel_sched", true};
+    GeneratorParam<bool> use_prefetch_sched{"use_prefetch_sched", true};
+
+    void generate() {
+        bounded_input(x, y) = BoundaryConditions::repeat_edge(input)(x, y);
+
+        Expr sum = 0.0f;
+        for (int i = -1; i <= 1; i++) {
+            for (int j = -1; j <= 1; j++) {
+                Expr in_f16 = cast(Float(16), bounded_input(x+j, y+i));
+                Expr mask_f16 = cast(Float(16), mask(j+1, i+1));
+                sum += cast<float>(in_f16) * cast<float>(mask_f16);
+            }
+        }
+        output(x, y) = sum * 0.0625f;
+    }
+
+    void schedule() {
+        Var xi{"xi"}, yi{"yi"};
+
+        input.dim(0).set_min(0);
+        input.dim(1).set_min(0);
+
+        output.dim(0).set_min(0);
+        output.dim(1).set_min(0);
+
+        if (get_target().features_any_of({Target::HVX_64, Target::HVX_128})) {
+            const int vector_size = get_target().has_feature(Target::HVX_128) ? 128 : 64;
+            Expr input_stride = input.dim(1).stride();
+            input.dim(1).set_stride((input_stride/vector_size) * vector_size);
+
+            Expr output_stride = output.dim(1).stride();
+            output.dim(1).set_stride((output_stride/vector_size) * vector_size);
+            bounded_input
+                .compute_at(Func(output), y)
+                .align_storage(x, 128)
+                .vectorize(x, vector_size, TailStrategy::RoundUp);
+            output
+                .hexagon()
+                .tile(x, y, xi, yi, vector_size, 4, TailStrategy::RoundUp)
+                .vectorize(xi)
+                .unroll(yi);
+            if (use_prefetch_sched) {
+                output.prefetch(input, y, 2);
+            }
+            if (use_parallel_sched) {
+                Var yo;
+                output.split(y, yo, y, 128).parallel(yo);
+            }
+        } else {
+            const int vector_size = natural_vector_size<float>();
+            output
+                .vectorize(x, vector_size)
+                .parallel(y, 16);
+        }
+    }
+private:
+    Var x{"x"}, y{"y"};
+    Func bounded_input{"input_bounded"};
+};
+
+HALIDE_REGISTER_GENERATOR(Conv3x3f16, conv3x3f16)
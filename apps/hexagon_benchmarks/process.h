@@ -27,6 +27,10 @@
 #include "conv3x3a32.h"
 #endif
 
+#ifdef CONV3X3F16
+#include "conv3x3f16.h"
+#endif
+
 template <typename T>
 T clamp(T val, T min, T max) {
     if (val < min)
@@ -485,4 +489,87 @@ public:
     }
 };
 
+class Conv3x3f16Descriptor : public PipelineDescriptorBase {
+    Halide::Runtime::Buffer<uint8_t> u8_in;
+    Halide::Runtime::Buffer<float> f32_mask, f32_out;
+
+public:
+    Conv3x3f16Descriptor(int W, int H) : u8_in(nullptr, W, H),
+                                         f32_mask(nullptr, 3, 3),
+                                         f32_out(nullptr, W, H) {}
+
+    void init() {
+#ifdef HALIDE_RUNTIME_HEXAGON
+        u8_in.device_malloc(halide_hexagon_device_interface());
+        f32_mask.device_malloc(halide_hexagon_device_interface());
+        f32_out.device_malloc(halide_hexagon_device_interface());
+#else
+        u8_in.allocate();
+        f32_mask.allocate();
+        f32_out.allocate();
+#endif
+
+        u8_in.for_each_value([&](uint8_t &x) {
+            x = static_cast<uint8_t>(rand());
+        });
+        f32_out.fill(0.0f);
+
+        // These are exactly representable in float16, so the result
+        // is exact.
+        f32_mask(0, 0) = 1.0f;
+        f32_mask(1, 0) = -4.0f;
+        f32_mask(2, 0) = 7.0f;
+
+        f32_mask(0, 1) = 2.0f;
+        f32_mask(1, 1) = -5.0f;
+        f32_mask(2, 1) = 8.0f;
+
+        f32_mask(0, 2) = 3.0f;
+        f32_mask(1, 2) = -6.0f;
+        f32_mask(2, 2) = 9.0f;
+    }
+
+    const char *name() { return "conv3x3f16"; }
+
+    bool defined() {
+#ifdef CONV3X3F16
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool verify(const int W, const int H) {
+        f32_out.copy_to_host();
+        f32_out.for_each_element([&](int x, int y) {
+            float sum = 0.0f;
+            for (int ry = -1; ry <= 1; ry++) {
+                for (int rx = -1; rx <= 1; rx++) {
+                    sum += static_cast<float>(u8_in(clamp(x+rx, 0, W-1), clamp(y+ry, 0, H-1)))
+                                                * f32_mask(rx+1, ry+1);
+                }
+            }
+            sum = sum * 0.0625f;
+            float out_xy = f32_out(x, y);
+            if (sum != out_xy) {
+                printf("Conv3x3f16: Mismatch at %d %d : %f != %f\n", x, y, out_xy, sum);
+                abort();
+            }
+        });
+        return true;
+    }
+
+    int run() {
+#ifdef CONV3X3F16
+        return conv3x3f16(u8_in, f32_mask, f32_out);
+#endif
+        return 1;
+    }
+    void finalize() {
+        u8_in.device_free();
+        f32_mask.device_free();
+        f32_out.device_free();
+    }
+};
+
 #endif
@@ -8,6 +8,12 @@ using namespace Halide;
 
 class LensBlur : public Halide::Generator<LensBlur> {
 public:
+    // If true, take the max filter of the bokeh radius with running
+    // maxima over blocks the size of the filter (the van Herk/Gil-Werman
+    // algorithm), which costs O(1) per pixel regardless of the blur
+    // radius.
+    GeneratorParam<bool>    running_max{"running_max", false};
+
     Input<Buffer<uint8_t>>  left_im{"left_im", 3};
     Input<Buffer<uint8_t>>  right_im{"right_im", 3};
     // The number of displacements to consider
@@ -93,10 +99,43 @@ public:
         // sampling more efficient below.
         Func worst_case_bokeh_radius_y;
         Func worst_case_bokeh_radius;
-        {
+        Func prefix_max_y, suffix_max_y, prefix_max_x, suffix_max_x;
+        RDom ry_prefix, ry_suffix, rx_prefix, rx_suffix;
+        if (!running_max) {
             RDom r(-maximum_blur_radius, 2*maximum_blur_radius+1);
             worst_case_bokeh_radius_y(x, y) = maximum(bokeh_radius(x, y + r));
             worst_case_bokeh_radius(x, y) = maximum(worst_case_bokeh_radius_y(x + r, y));
+        } else {
+            // Split the region into blocks the size of the filter, and
+            // take running maxima forwards and backwards within each
+            // block. Every window of the filter is then the union of
+            // the end of one block and the start of the next.
+            Expr r = maximum_blur_radius;
+            Expr n = 2*r + 1;
+            Expr x_min = final.dim(0).min() - r, x_max = final.dim(0).max() + r;
+            Expr y_min = final.dim(1).min() - r, y_max = final.dim(1).max() + r;
+
+            ry_prefix = RDom(y_min + 1, y_max - y_min);
+            ry_suffix = RDom(0, y_max - y_min);
+            Expr ys = y_max - 1 - ry_suffix;
+            prefix_max_y(x, y) = bokeh_radius(x, y);
+            prefix_max_y(x, ry_prefix) = select((ry_prefix - y_min) % n == 0, prefix_max_y(x, ry_prefix),
+                                                max(prefix_max_y(x, ry_prefix - 1), prefix_max_y(x, ry_prefix)));
+            suffix_max_y(x, y) = bokeh_radius(x, y);
+            suffix_max_y(x, ys) = select((ys - y_min) % n == n - 1, suffix_max_y(x, ys),
+                                         max(suffix_max_y(x, ys + 1), suffix_max_y(x, ys)));
+            worst_case_bokeh_radius_y(x, y) = max(suffix_max_y(x, y - r), prefix_max_y(x, y + r));
+
+            rx_prefix = RDom(x_min + 1, x_max - x_min);
+            rx_suffix = RDom(0, x_max - x_min);
+            Expr xs = x_max - 1 - rx_suffix;
+            prefix_max_x(x, y) = worst_case_bokeh_radius_y(x, y);
+            prefix_max_x(rx_prefix, y) = select((rx_prefix - x_min) % n == 0, prefix_max_x(rx_prefix, y),
+                                                max(prefix_max_x(rx_prefix - 1, y), prefix_max_x(rx_prefix, y)));
+            suffix_max_x(x, y) = worst_case_bokeh_radius_y(x, y);
+            suffix_max_x(xs, y) = select((xs - x_min) % n == n - 1, suffix_max_x(xs, y),
+                                         max(suffix_max_x(xs + 1, y), suffix_max_x(xs, y)));
+            worst_case_bokeh_radius(x, y) = max(suffix_max_x(x - r, y), prefix_max_x(x + r, y));
         }
 
         Func input_with_alpha;
@@ -196,6 +235,17 @@ public:
                 .gpu_tile(x, y, xi, yi, 16, 16);
             input_with_alpha.compute_root()
                 .reorder(c, x, y).unroll(c).gpu_tile(x, y, xi, yi, 16, 16);
+            if (running_max) {
+                // Each thread does the scan for one column (or row).
+                for (Func f : {prefix_max_y, suffix_max_y, prefix_max_x, suffix_max_x}) {
+                    f.compute_root()
+                        .gpu_tile(x, y, xi, yi, 16, 16);
+                }
+                prefix_max_y.update().gpu_tile(x, xi, 64);
+                suffix_max_y.update().gpu_tile(x, xi, 64);
+                prefix_max_x.update().gpu_tile(y, yi, 64);
+                suffix_max_x.update().gpu_tile(y, yi, 64);
+            }
             worst_case_bokeh_radius_y
                 .compute_root()
                 .gpu_tile(x, y, xi, yi, 16, 16);
@@ -248,9 +298,39 @@ public:
                 .unroll(c)
                 .vectorize(x, 8)
                 .parallel(y, 8);
-            worst_case_bokeh_radius_y
-                .compute_at(final, y)
-                .vectorize(x, 8);
+            if (running_max) {
+                Var xo;
+                for (Func f : {prefix_max_y, suffix_max_y}) {
+                    f.compute_root()
+                        .vectorize(x, 8)
+                        .parallel(y, 8);
+                }
+                prefix_max_y.update()
+                    .split(x, xo, x, 64)
+                    .reorder(x, ry_prefix, xo)
+                    .vectorize(x, 8)
+                    .parallel(xo);
+                suffix_max_y.update()
+                    .split(x, xo, x, 64)
+                    .reorder(x, ry_suffix, xo)
+                    .vectorize(x, 8)
+                    .parallel(xo);
+                worst_case_bokeh_radius_y
+                    .compute_root()
+                    .vectorize(x, 8)
+                    .parallel(y, 8);
+                for (Func f : {prefix_max_x, suffix_max_x}) {
+                    f.compute_root()
+                        .vectorize(x, 8)
+                        .parallel(y, 8);
+                    f.update()
+                        .parallel(y, 8);
+                }
+            } else {
+                worst_case_bokeh_radius_y
+                    .compute_at(final, y)
+                    .vectorize(x, 8);
+            }
             final.compute_root()
                 .reorder(c, x, y)
                 .bound(c, 0, 3)
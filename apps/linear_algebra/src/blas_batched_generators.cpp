@@ -0,0 +1,254 @@
+#include <vector>
+#include "Halide.h"
+
+using namespace Halide;
+
+namespace {
+
+// Generators for batches of small matrix operations. Matrices are
+// column-major, with the batch as the last dimension. The matrices are
+// too small to vectorize within one of them, so these vectorize across
+// the batch instead. This is fastest with the interleaved
+// batch-of-matrices layout, where the batch dimension has stride 1 and
+// each element of a vector comes from a different matrix.
+template<class T>
+class BatchedGeneratorBase : public Generator<T> {
+  public:
+    typedef Generator<T> Base;
+    using Base::natural_vector_size;
+
+    // If true, the batch dimension of every buffer has stride 1.
+    GeneratorParam<bool> interleaved_ = {"interleaved", true};
+
+  protected:
+    // Vectorize f across the batch, parallelizing over groups of
+    // vectors. The intermediates for one vector of matrices should be
+    // computed at the loop bo. Small batches are not vectorized.
+    template<typename FuncOrOutput>
+    void schedule_batch(FuncOrOutput &f, Var batch, Expr batch_size, Type t,
+                        Var bo, const std::vector<Var> &inner) {
+        const int vec = natural_vector_size(t);
+        const int vecs_per_task = 16;
+
+        Var bt("bt"), bi("bi");
+        std::vector<VarOrRVar> order = {bi};
+        order.insert(order.end(), inner.begin(), inner.end());
+        order.push_back(bo);
+        order.push_back(bt);
+
+        // The intermediates are computed for a whole vector of
+        // matrices, so shift the last vector inwards rather than
+        // computing past the end of the batch.
+        f.specialize(batch_size >= vec)
+            .split(batch, bo, bi, vec, TailStrategy::ShiftInwards)
+            .split(bo, bt, bo, vecs_per_task, TailStrategy::GuardWithIf)
+            .reorder(order)
+            .vectorize(bi)
+            .parallel(bt);
+        f.split(batch, bo, bi, 1)
+            .split(bo, bt, bo, 1)
+            .reorder(order);
+    }
+};
+
+// Generator class for batched gemm: result = a * A * B + b * C for
+// each matrix in the batch.
+template<class T>
+class BatchedGEMMGenerator :
+        public BatchedGeneratorBase<BatchedGEMMGenerator<T>> {
+  public:
+    typedef BatchedGeneratorBase<BatchedGEMMGenerator<T>> Base;
+    using Base::interleaved_;
+    template<typename T2> using Input = typename Base::template Input<T2>;
+    template<typename T2> using Output = typename Base::template Output<T2>;
+
+    // Standard ordering of parameters in GEMM functions.
+    Input<T>         a_ = {"a_", 1};
+    Input<Buffer<T>> A_ = {"A_", 3};
+    Input<Buffer<T>> B_ = {"B_", 3};
+    Input<T>         b_ = {"b_", 1};
+    Input<Buffer<T>> C_ = {"C_", 3};
+
+    Output<Buffer<T>> result_ = {"result", 3};
+
+    void generate() {
+        const Expr num_rows = A_.dim(0).extent();
+        const Expr num_cols = B_.dim(1).extent();
+        const Expr sum_size = A_.dim(1).extent();
+        const Expr batch_size = A_.dim(2).extent();
+
+        Var i("i"), j("j"), b("b"), bo("bo");
+
+        RDom k(0, sum_size, "k");
+        Func AB("AB");
+        AB(i, j, b) = cast<T>(0);
+        AB(i, j, b) += A_(i, k, b) * B_(k, j, b);
+
+        result_(i, j, b) = a_ * AB(i, j, b) + b_ * C_(i, j, b);
+
+        this->schedule_batch(result_, b, batch_size, type_of<T>(), bo, {i, j});
+
+        // Accumulate a vector of matrices at a time, with the vectors
+        // of each element of the product adjacent.
+        AB.compute_at(result_, bo)
+            .reorder_storage(b, i, j)
+            .vectorize(b)
+            .update()
+            .reorder(b, i, k, j)
+            .vectorize(b);
+
+        for (auto *buf : {&A_, &B_, &C_}) {
+            buf->dim(0).set_min(0).dim(1).set_min(0).dim(2).set_min(0);
+        }
+        B_.dim(0).set_extent(sum_size).dim(2).set_extent(batch_size);
+        C_.dim(0).set_extent(num_rows).dim(1).set_extent(num_cols).dim(2).set_extent(batch_size);
+        result_.dim(0).set_bounds(0, num_rows)
+            .dim(1).set_bounds(0, num_cols)
+            .dim(2).set_bounds(0, batch_size);
+
+        // Buffers are dense in dimension 0 by default, so remove that
+        // constraint before making the batch dense instead.
+        if (interleaved_) {
+            A_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            B_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            C_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            result_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+        }
+    }
+};
+
+// Generator class for batched gemv: result = a * A * x + b * y for
+// each matrix and pair of vectors in the batch.
+template<class T>
+class BatchedGEMVGenerator :
+        public BatchedGeneratorBase<BatchedGEMVGenerator<T>> {
+  public:
+    typedef BatchedGeneratorBase<BatchedGEMVGenerator<T>> Base;
+    using Base::interleaved_;
+    template<typename T2> using Input = typename Base::template Input<T2>;
+    template<typename T2> using Output = typename Base::template Output<T2>;
+
+    // Standard ordering of parameters in GEMV functions.
+    Input<T>         a_ = {"a", 1};
+    Input<Buffer<T>> A_ = {"A", 3};
+    Input<Buffer<T>> x_ = {"x", 2};
+    Input<T>         b_ = {"b", 1};
+    Input<Buffer<T>> y_ = {"y", 2};
+
+    Output<Buffer<T>> output_ = {"output", 2};
+
+    void generate() {
+        const Expr num_rows = A_.dim(0).extent();
+        const Expr sum_size = A_.dim(1).extent();
+        const Expr batch_size = A_.dim(2).extent();
+
+        Var i("i"), b("b"), bo("bo");
+
+        RDom j(0, sum_size, "j");
+        Func Ax("Ax");
+        Ax(i, b) = cast<T>(0);
+        Ax(i, b) += A_(i, j, b) * x_(j, b);
+
+        output_(i, b) = a_ * Ax(i, b) + b_ * y_(i, b);
+
+        this->schedule_batch(output_, b, batch_size, type_of<T>(), bo, {i});
+
+        Ax.compute_at(output_, bo)
+            .reorder_storage(b, i)
+            .vectorize(b)
+            .update()
+            .reorder(b, i, j)
+            .vectorize(b);
+
+        A_.dim(0).set_min(0).dim(1).set_min(0).dim(2).set_min(0);
+        x_.dim(0).set_bounds(0, sum_size).dim(1).set_bounds(0, batch_size);
+        y_.dim(0).set_bounds(0, num_rows).dim(1).set_bounds(0, batch_size);
+        output_.dim(0).set_bounds(0, num_rows).dim(1).set_bounds(0, batch_size);
+
+        if (interleaved_) {
+            A_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            x_.dim(0).set_stride(Expr()).dim(1).set_stride(1);
+            y_.dim(0).set_stride(Expr()).dim(1).set_stride(1);
+            output_.dim(0).set_stride(Expr()).dim(1).set_stride(1);
+        }
+    }
+};
+
+// Generator class for batched trsm: solves A * X = a * B for X, where
+// A is triangular, for each pair of matrices in the batch. B may have
+// any number of columns.
+template<class T>
+class BatchedTRSMGenerator :
+        public BatchedGeneratorBase<BatchedTRSMGenerator<T>> {
+  public:
+    typedef BatchedGeneratorBase<BatchedTRSMGenerator<T>> Base;
+    using Base::interleaved_;
+    template<typename T2> using Input = typename Base::template Input<T2>;
+    template<typename T2> using Output = typename Base::template Output<T2>;
+
+    // Whether A is lower or upper triangular. The other triangle of A
+    // is not read.
+    GeneratorParam<bool> lower_ = {"lower", true};
+
+    Input<T>         a_ = {"a_", 1};
+    Input<Buffer<T>> A_ = {"A_", 3};
+    Input<Buffer<T>> B_ = {"B_", 3};
+
+    Output<Buffer<T>> result_ = {"result", 3};
+
+    void generate() {
+        const Expr size = A_.dim(0).extent();
+        const Expr num_cols = B_.dim(1).extent();
+        const Expr batch_size = A_.dim(2).extent();
+
+        Var i("i"), j("j"), b("b"), bo("bo");
+
+        // Substitute the rows in order. r.y is the row being solved,
+        // and r.x walks the solved rows it depends on, followed by
+        // the diagonal.
+        RDom r(0, size, 0, size, "r");
+        r.where(r.x <= r.y);
+        const Expr row = lower_ ? Expr(r.y) : size - 1 - r.y;
+        const Expr col = lower_ ? Expr(r.x) : size - 1 - r.x;
+
+        Func X("X");
+        X(i, j, b) = a_ * B_(i, j, b);
+        X(row, j, b) = select(col == row,
+                              X(row, j, b) / A_(row, row, b),
+                              X(row, j, b) - A_(row, col, b) * X(col, j, b));
+
+        result_(i, j, b) = X(i, j, b);
+
+        this->schedule_batch(result_, b, batch_size, type_of<T>(), bo, {i, j});
+
+        // Solve a vector of systems at a time in interleaved scratch,
+        // regardless of the layout of the output.
+        X.compute_at(result_, bo)
+            .reorder_storage(b, i, j)
+            .vectorize(b)
+            .update()
+            .reorder(b, j, r.x, r.y)
+            .vectorize(b);
+
+        A_.dim(0).set_min(0).dim(1).set_bounds(0, size).dim(2).set_min(0);
+        B_.dim(0).set_bounds(0, size).dim(1).set_min(0).dim(2).set_bounds(0, batch_size);
+        result_.dim(0).set_bounds(0, size)
+            .dim(1).set_bounds(0, num_cols)
+            .dim(2).set_bounds(0, batch_size);
+
+        if (interleaved_) {
+            A_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            B_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+            result_.dim(0).set_stride(Expr()).dim(2).set_stride(1);
+        }
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(BatchedGEMMGenerator<float>, sgemm_batched)
+HALIDE_REGISTER_GENERATOR(BatchedGEMMGenerator<double>, dgemm_batched)
+HALIDE_REGISTER_GENERATOR(BatchedGEMVGenerator<float>, sgemv_batched)
+HALIDE_REGISTER_GENERATOR(BatchedGEMVGenerator<double>, dgemv_batched)
+HALIDE_REGISTER_GENERATOR(BatchedTRSMGenerator<float>, strsm_batched)
+HALIDE_REGISTER_GENERATOR(BatchedTRSMGenerator<double>, dtrsm_batched)
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 #include "Halide.h"
 
@@ -158,7 +159,158 @@ class GEMMGenerator :
     }
 };
 
+// Generator class for BLAS gemm operations on large matrices. This
+// follows the structure of the Goto/BLIS algorithm: the columns of
+// the result are split into panels of nc columns, the reduction into
+// blocks of kc, and the rows into blocks of mc. For each block of the
+// reduction, the corresponding kc x nc panel of B is packed into a
+// contiguous buffer that stays in the last level cache, and for each
+// block of rows, the mc x kc block of A is packed into a contiguous
+// buffer that stays in L2. The innermost loop is a register-blocked
+// micro-kernel, which computes an mr x nr tile of the result from
+// an mr x kc micro-panel of A and a kc x nr micro-panel of B, the
+// latter staying in L1.
+template<class T>
+class PackedGEMMGenerator :
+        public Generator<PackedGEMMGenerator<T>> {
+  public:
+    typedef Generator<PackedGEMMGenerator<T>> Base;
+    using Base::get_target;
+    using Base::get_machine_params;
+    using Base::natural_vector_size;
+    template<typename T2> using Input = typename Base::template Input<T2>;
+    template<typename T2> using Output = typename Base::template Output<T2>;
+
+    GeneratorParam<bool> transpose_A_ = {"transpose_A", false};
+    GeneratorParam<bool> transpose_B_ = {"transpose_B", false};
+
+    // MachineParams only describes the last level cache, which is used
+    // to size the panels of B. The sizes of the two inner levels of
+    // cache are given here.
+    GeneratorParam<int> l1_cache_size_ = {"l1_cache_size", 32 * 1024};
+    GeneratorParam<int> l2_cache_size_ = {"l2_cache_size", 256 * 1024};
+
+    // Standard ordering of parameters in GEMM functions.
+    Input<T>         a_ = {"a_", 1};
+    Input<Buffer<T>> A_ = {"A_", 2};
+    Input<Buffer<T>> B_ = {"B_", 2};
+    Input<T>         b_ = {"b_", 1};
+    Input<Buffer<T>> C_ = {"C_", 2};
+
+    Output<Buffer<T>> result_ = {"result", 2};
+
+    void generate() {
+        // Matrices are interpreted as column-major by default. The
+        // transpose GeneratorParams are used to handle cases where
+        // one or both is actually row major. The transposes are
+        // absorbed by the packing stages.
+        const bool transpose_A = transpose_A_;
+        const bool transpose_B = transpose_B_;
+        const Expr num_rows = transpose_A ? A_.height() : A_.width();
+        const Expr num_cols = transpose_B ? B_.width() : B_.height();
+        const Expr sum_size = transpose_A ? A_.width() : A_.height();
+
+        // The shape of the micro-kernel. Its accumulators, a column of
+        // the A micro-panel and a broadcast element of B together fit
+        // in 16 vector registers.
+        const int vec = natural_vector_size(a_.type());
+        const int mr = vec * 2;
+        const int nr = 6;
+
+        // Size the blocks so that the micro-panel of B fills half of
+        // L1, the block of A fills half of L2, and the panel of B
+        // fills half of the last level cache. The other halves are
+        // left for the data streaming through each level.
+        const int elem_size = sizeof(T);
+        const MachineParams machine = get_machine_params();
+        const int kc = std::max(16, ((int)l1_cache_size_ / 2) / ((mr + nr) * elem_size) / 8 * 8);
+        const int mc = std::max(mr, ((int)l2_cache_size_ / 2) / (kc * elem_size) / mr * mr);
+        const int nc = std::max(nr, (int)std::min<uint64_t>(4096, (machine.last_level_cache_size / 2) /
+                                                                  (kc * elem_size)) / nr * nr);
+
+        Var i("i"), j("j"), k("k"), ii("ii"), ji("ji"), io("io"), jo("jo"), ko("ko");
+
+        // Pad A and B with zeros, so the packed panels are a multiple
+        // of the micro-kernel and block sizes.
+        Func A("A"), B("B");
+        Func A_padded = BoundaryConditions::constant_exterior(A_, cast<T>(0));
+        Func B_padded = BoundaryConditions::constant_exterior(B_, cast<T>(0));
+        if (transpose_A) {
+            A(i, k) = A_padded(k, i);
+        } else {
+            A(i, k) = A_padded(i, k);
+        }
+        if (transpose_B) {
+            B(k, j) = B_padded(j, k);
+        } else {
+            B(k, j) = B_padded(k, j);
+        }
+
+        // The packing stages. Each micro-panel is contiguous, with
+        // the elements used by one step of the micro-kernel adjacent.
+        Func A_packed("A_packed"), B_packed("B_packed");
+        A_packed(ii, k, io) = A(io * mr + ii, k);
+        B_packed(ji, k, jo) = B(k, jo * nr + ji);
+
+        // The micro-kernel, computing an mr x nr tile of the product
+        // for one block of the reduction.
+        RDom rk(0, kc, "rk");
+        Func micro("micro");
+        micro(ii, ji, io, jo, ko) = cast<T>(0);
+        micro(ii, ji, io, jo, ko) +=
+            A_packed(ii, ko * kc + rk, io) * B_packed(ji, ko * kc + rk, jo);
+
+        // Accumulate the tiles into the result, one block of the
+        // reduction at a time.
+        RDom rko(0, (sum_size + kc - 1) / kc, "rko");
+        result_(i, j) = b_ * C_(i, j);
+        result_(i, j) += a_ * micro(i % mr, j % nr, i / mr, j / nr, rko);
+
+        // Schedule.
+        Var ic("ic"), jc("jc"), ir("ir"), jr("jr"), in("in"), jn("jn");
+        result_.vectorize(i, vec, TailStrategy::GuardWithIf);
+        result_.update()
+            .split(j, jc, jn, nc, TailStrategy::GuardWithIf)
+            .split(jn, jr, ji, nr, TailStrategy::GuardWithIf)
+            .split(i, ic, in, mc, TailStrategy::GuardWithIf)
+            .split(in, ir, ii, mr, TailStrategy::GuardWithIf)
+            .reorder(ii, ji, ir, jr, ic, rko, jc)
+            .vectorize(ii, vec)
+            .unroll(ji)
+            .parallel(ic);
+
+        // Keep the accumulators in registers.
+        micro.compute_at(result_, ir)
+            .bound_extent(ii, mr).vectorize(ii)
+            .bound_extent(ji, nr).unroll(ji)
+            .update()
+            .reorder(ii, ji, rk)
+            .vectorize(ii)
+            .unroll(ji)
+            .unroll(rk, 2);
+
+        // Pack the block of A for each block of rows, and the panel of
+        // B once per block of the reduction, shared by the parallel
+        // blocks of rows.
+        A_packed.compute_at(result_, ic)
+            .bound_extent(ii, mr)
+            .vectorize(ii);
+        B_packed.compute_at(result_, rko)
+            .bound_extent(ji, nr)
+            .reorder(ji, k, jo)
+            .unroll(ji);
+
+        A_.dim(0).set_min(0).dim(1).set_min(0);
+        B_.dim(0).set_min(0).dim(1).set_min(0);
+        C_.dim(0).set_bounds(0, num_rows);
+        C_.dim(1).set_bounds(0, num_cols);
+        result_.dim(0).set_bounds(0, num_rows).dim(1).set_bounds(0, num_cols);
+    }
+};
+
 }  // namespace
 
 HALIDE_REGISTER_GENERATOR(GEMMGenerator<float>, sgemm)
 HALIDE_REGISTER_GENERATOR(GEMMGenerator<double>, dgemm)
+HALIDE_REGISTER_GENERATOR(PackedGEMMGenerator<float>, sgemm_packed)
+HALIDE_REGISTER_GENERATOR(PackedGEMMGenerator<double>, dgemm_packed)
@@ -28,6 +28,27 @@
 #include "halide_dgemm_transB.h"
 #include "halide_sgemm_transAB.h"
 #include "halide_dgemm_transAB.h"
+#include "halide_sgemm_packed_notrans.h"
+#include "halide_dgemm_packed_notrans.h"
+#include "halide_sgemm_packed_transA.h"
+#include "halide_dgemm_packed_transA.h"
+#include "halide_sgemm_packed_transB.h"
+#include "halide_dgemm_packed_transB.h"
+#include "halide_sgemm_packed_transAB.h"
+#include "halide_dgemm_packed_transAB.h"
+
+// Kernels for batches of small matrices, which are vectorized across the
+// batch. These take buffers in the interleaved layout (the batch is the
+// last dimension, with stride 1), and can be called directly or from other
+// pipelines with define_extern.
+#include "halide_sgemm_batched.h"
+#include "halide_sgemv_batched.h"
+#include "halide_dgemm_batched.h"
+#include "halide_dgemv_batched.h"
+#include "halide_strsm_batched_lower.h"
+#include "halide_strsm_batched_upper.h"
+#include "halide_dtrsm_batched_lower.h"
+#include "halide_dtrsm_batched_upper.h"
 
 inline int halide_scopy(halide_buffer_t *x, halide_buffer_t *y) {
     return halide_scopy_impl(0, x, nullptr, y);
@@ -77,7 +98,26 @@ inline int halide_dger(float a, halide_buffer_t *x, halide_buffer_t *y, halide_b
     return halide_dger_impl(a, x, y, A);
 }
 
+// The packed gemm kernels pay for packing A and B into panels, which
+// is only worth it once the matrices no longer fit in cache.
+inline bool use_packed_gemm(bool transA, const halide_buffer_t *A, const halide_buffer_t *C) {
+    const int min_size = 256;
+    const int sum_size = transA ? A->dim[0].extent : A->dim[1].extent;
+    return C->dim[0].extent >= min_size && C->dim[1].extent >= min_size && sum_size >= min_size;
+}
+
 inline int halide_sgemm(bool transA, bool transB, float a, halide_buffer_t *A, halide_buffer_t *B, float b, halide_buffer_t *C) {
+    if (use_packed_gemm(transA, A, C)) {
+        if (transA && transB) {
+            return halide_sgemm_packed_transAB(a, A, B, b, C, C);
+        } else if (transA) {
+            return halide_sgemm_packed_transA(a, A, B, b, C, C);
+        } else if (transB) {
+            return halide_sgemm_packed_transB(a, A, B, b, C, C);
+        } else {
+            return halide_sgemm_packed_notrans(a, A, B, b, C, C);
+        }
+    }
     if (transA && transB) {
         return halide_sgemm_transAB(a, A, B, b, C, C);
     } else if (transA) {
@@ -91,6 +131,17 @@ inline int halide_sgemm(bool transA, bool transB, float a, halide_buffer_t *A, h
 }
 
 inline int halide_dgemm(bool transA, bool transB, double a, halide_buffer_t *A, halide_buffer_t *B, double b, halide_buffer_t *C) {
+    if (use_packed_gemm(transA, A, C)) {
+        if (transA && transB) {
+            return halide_dgemm_packed_transAB(a, A, B, b, C, C);
+        } else if (transA) {
+            return halide_dgemm_packed_transA(a, A, B, b, C, C);
+        } else if (transB) {
+            return halide_dgemm_packed_transB(a, A, B, b, C, C);
+        } else {
+            return halide_dgemm_packed_notrans(a, A, B, b, C, C);
+        }
+    }
     if (transA && transB) {
         return halide_dgemm_transAB(a, A, B, b, C, C);
     } else if (transA) {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
@@ -6,6 +7,7 @@
 #include <string>
 #include <cblas.h>
 #include <halide_blas.h>
+#include "HalideBuffer.h"
 
 #define RUN_TEST(method)                                                \
     std::cout << std::setw(30) << ("Testing " #method ": ") << std::flush; \
@@ -117,6 +119,12 @@ struct BLASTestBase {
     typedef T Scalar;
     typedef std::vector<T> Vector;
     typedef std::vector<T> Matrix;
+    typedef Halide::Runtime::Buffer<T> Batch;
+
+    // The batched kernels are meant for small matrices, so are tested
+    // on a batch of them rather than on N x N matrices.
+    const int batch_size = 37;
+    static int batch_matrix_size(int N) { return std::min(N, 16); }
 
     std::random_device rand_dev;
     std::default_random_engine rand_eng;
@@ -144,6 +152,102 @@ struct BLASTestBase {
         return buff;
     }
 
+    // A batch of rows x cols matrices in the interleaved layout.
+    Batch random_batch(int rows, int cols) {
+        Batch buff({rows, cols, batch_size}, {2, 0, 1});
+        buff.for_each_value([&](Scalar &x) { x = random_scalar(); });
+        return buff;
+    }
+
+    // A batch of vectors in the interleaved layout.
+    Batch random_vector_batch(int N) {
+        Batch buff({N, batch_size}, {1, 0});
+        buff.for_each_value([&](Scalar &x) { x = random_scalar(); });
+        return buff;
+    }
+
+    // Copy one matrix (or vector) of a batch into a dense column-major
+    // matrix (or vector).
+    Matrix batch_element(const Batch &buff, int b) {
+        const int rows = buff.dim(0).extent();
+        const int cols = buff.dimensions() == 3 ? buff.dim(1).extent() : 1;
+        Matrix result(rows * cols);
+        for (int j = 0; j < cols; ++j) {
+            for (int i = 0; i < rows; ++i) {
+                result[i + j * rows] = buff.dimensions() == 3 ? buff(i, j, b) : buff(i, b);
+            }
+        }
+        return result;
+    }
+
+    template<typename CblasGEMM, typename HalideGEMM>
+    bool test_gemm_batched(int N, CblasGEMM cblas_gemm, HalideGEMM halide_gemm) {
+        const int M = batch_matrix_size(N);
+        Scalar alpha = random_scalar();
+        Scalar beta = random_scalar();
+        Batch A(random_batch(M, M)), B(random_batch(M, M)), C(random_batch(M, M));
+        Batch result({M, M, batch_size}, {2, 0, 1});
+        halide_gemm(alpha, A, B, beta, C, result);
+
+        for (int b = 0; b < batch_size; ++b) {
+            Matrix eA(batch_element(A, b)), eB(batch_element(B, b)), eC(batch_element(C, b));
+            cblas_gemm(CblasColMajor, CblasNoTrans, CblasNoTrans, M, M, M,
+                       alpha, &eA[0], M, &eB[0], M, beta, &eC[0], M);
+            if (!compareMatrices(M, eC, batch_element(result, b))) {
+                std::cerr << "Batch element: " << b << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename CblasGEMV, typename HalideGEMV>
+    bool test_gemv_batched(int N, CblasGEMV cblas_gemv, HalideGEMV halide_gemv) {
+        const int M = batch_matrix_size(N);
+        Scalar alpha = random_scalar();
+        Scalar beta = random_scalar();
+        Batch A(random_batch(M, M)), x(random_vector_batch(M)), y(random_vector_batch(M));
+        Batch result({M, batch_size}, {1, 0});
+        halide_gemv(alpha, A, x, beta, y, result);
+
+        for (int b = 0; b < batch_size; ++b) {
+            Matrix eA(batch_element(A, b));
+            Vector ex(batch_element(x, b)), ey(batch_element(y, b));
+            cblas_gemv(CblasColMajor, CblasNoTrans, M, M, alpha, &eA[0], M, &ex[0], 1, beta, &ey[0], 1);
+            if (!compareVectors(M, ey, batch_element(result, b))) {
+                std::cerr << "Batch element: " << b << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename CblasTRSM, typename HalideTRSM>
+    bool test_trsm_batched(int N, bool lower, CblasTRSM cblas_trsm, HalideTRSM halide_trsm) {
+        const int M = batch_matrix_size(N);
+        Scalar alpha = random_scalar();
+        Batch A(random_batch(M, M)), B(random_batch(M, M));
+        // Keep the systems well conditioned.
+        for (int b = 0; b < batch_size; ++b) {
+            for (int i = 0; i < M; ++i) {
+                A(i, i, b) += M;
+            }
+        }
+        Batch result({M, M, batch_size}, {2, 0, 1});
+        halide_trsm(alpha, A, B, result);
+
+        for (int b = 0; b < batch_size; ++b) {
+            Matrix eA(batch_element(A, b)), eB(batch_element(B, b));
+            cblas_trsm(CblasColMajor, CblasLeft, lower ? CblasLower : CblasUpper,
+                       CblasNoTrans, CblasNonUnit, M, M, alpha, &eA[0], M, &eB[0], M);
+            if (!compareMatrices(M, eB, batch_element(result, b))) {
+                std::cerr << "Batch element: " << b << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool compareScalars(Scalar x, Scalar y, Scalar epsilon = 4 * std::numeric_limits<Scalar>::epsilon()) {
         if (x == y) {
             return true;
@@ -210,6 +314,10 @@ struct BLASFloatTests : public BLASTestBase<float> {
         RUN_TEST(sgemm_transA);
         RUN_TEST(sgemm_transB);
         RUN_TEST(sgemm_transAB);
+        RUN_TEST(sgemm_batched);
+        RUN_TEST(sgemv_batched);
+        RUN_TEST(strsm_batched_lower);
+        RUN_TEST(strsm_batched_upper);
     }
 
     L1_VECTOR_TEST(scopy, scopy(N, x, 1, y, 1))
@@ -241,6 +349,19 @@ struct BLASFloatTests : public BLASTestBase<float> {
     L3_TEST(sgemm_transAB,
             cblas_sgemm(CblasColMajor, CblasTrans, CblasTrans, N, N, N, alpha, A, N, B, N, beta, C, N),
             hblas_sgemm(HblasColMajor, HblasTrans, HblasTrans, N, N, N, alpha, A, N, B, N, beta, C, N));
+
+    bool test_sgemm_batched(int N) {
+        return test_gemm_batched(N, cblas_sgemm, halide_sgemm_batched);
+    }
+    bool test_sgemv_batched(int N) {
+        return test_gemv_batched(N, cblas_sgemv, halide_sgemv_batched);
+    }
+    bool test_strsm_batched_lower(int N) {
+        return test_trsm_batched(N, true, cblas_strsm, halide_strsm_batched_lower);
+    }
+    bool test_strsm_batched_upper(int N) {
+        return test_trsm_batched(N, false, cblas_strsm, halide_strsm_batched_upper);
+    }
 };
 
 struct BLASDoubleTests : public BLASTestBase<double> {
@@ -257,6 +378,10 @@ struct BLASDoubleTests : public BLASTestBase<double> {
         RUN_TEST(dgemm_transA);
         RUN_TEST(dgemm_transB);
         RUN_TEST(dgemm_transAB);
+        RUN_TEST(dgemm_batched);
+        RUN_TEST(dgemv_batched);
+        RUN_TEST(dtrsm_batched_lower);
+        RUN_TEST(dtrsm_batched_upper);
     }
 
     L1_VECTOR_TEST(dcopy, dcopy(N, x, 1, y, 1))
@@ -288,6 +413,19 @@ struct BLASDoubleTests : public BLASTestBase<double> {
     L3_TEST(dgemm_transAB,
             cblas_dgemm(CblasColMajor, CblasTrans, CblasTrans, N, N, N, alpha, A, N, B, N, beta, C, N),
             hblas_dgemm(HblasColMajor, HblasTrans, HblasTrans, N, N, N, alpha, A, N, B, N, beta, C, N));
+
+    bool test_dgemm_batched(int N) {
+        return test_gemm_batched(N, cblas_dgemm, halide_dgemm_batched);
+    }
+    bool test_dgemv_batched(int N) {
+        return test_gemv_batched(N, cblas_dgemv, halide_dgemv_batched);
+    }
+    bool test_dtrsm_batched_lower(int N) {
+        return test_trsm_batched(N, true, cblas_dtrsm, halide_dtrsm_batched_lower);
+    }
+    bool test_dtrsm_batched_upper(int N) {
+        return test_trsm_batched(N, false, cblas_dtrsm, halide_dtrsm_batched_upper);
+    }
 };
 
 int main(int argc, char *argv[]) {
@@ -8,6 +8,10 @@ constexpr int maxJ = 20;
 class LocalLaplacian : public Halide::Generator<LocalLaplacian> {
 public:
     GeneratorParam<int>     pyramid_levels{"pyramid_levels", 8, 1, maxJ};
+    // If true, the cpu schedule computes every pyramid level in strips
+    // of output rows, so that peak memory use is proportional to the
+    // width of the image rather than its size.
+    GeneratorParam<bool>    streaming{"streaming", false};
 
     Input<Buffer<uint16_t>> input{"input", 3};
     Input<int>              levels{"levels"};
@@ -122,6 +126,27 @@ public:
                 }
                 outGPyramid[j].compute_root().gpu_tile(x, y, xi, yi, blockw, blockh);
             }
+        } else if (streaming) {
+            // streaming cpu schedule. Each strip of output rows slides
+            // every level of every pyramid down the strip, computing
+            // each new row of a level when the output first needs it.
+            // The coarse levels are recomputed with some overlap
+            // between strips, but they are small.
+            remap.compute_root();
+            Var yo;
+            output.reorder(c, x, y).split(y, yo, y, 64).parallel(yo).vectorize(x, 8);
+            gray.store_at(output, yo).compute_at(output, y).vectorize(x, 8);
+            for (int j = 1; j < J; j++) {
+                inGPyramid[j].store_at(output, yo).compute_at(output, y);
+                gPyramid[j].store_at(output, yo).compute_at(output, y).reorder_storage(x, k, y);
+                outGPyramid[j].store_at(output, yo).compute_at(output, y);
+                if (j < 5) {
+                    inGPyramid[j].vectorize(x, 8);
+                    gPyramid[j].vectorize(x, 8);
+                    outGPyramid[j].vectorize(x, 8);
+                }
+            }
+            outGPyramid[0].compute_at(output, y).vectorize(x, 8);
         } else {
             // cpu schedule
             remap.compute_root();
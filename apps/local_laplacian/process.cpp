@@ -1,10 +1,15 @@
+#include <atomic>
 #include <cstdio>
+#include <cstdlib>
 #include <chrono>
 
 #include "local_laplacian.h"
 #ifndef NO_AUTO_SCHEDULE
 #include "local_laplacian_auto_schedule.h"
 #endif
+#ifndef NO_STREAMING
+#include "local_laplacian_streaming.h"
+#endif
 
 #include "halide_benchmark.h"
 #include "HalideBuffer.h"
@@ -13,6 +18,51 @@
 using namespace Halide::Runtime;
 using namespace Halide::Tools;
 
+namespace {
+
+// Track the memory allocated by the pipeline, to compare the peak
+// memory use of the schedules.
+std::atomic<size_t> live_bytes(0), peak_bytes(0);
+
+void *tracking_malloc(void *user_context, size_t size) {
+    void *orig = malloc(size + 128 + 16);
+    if (!orig) {
+        return nullptr;
+    }
+    // Align to 128 bytes, leaving room for the original pointer and
+    // the size just before the allocation.
+    void *ptr = (void *)((((size_t)orig + 16 + 127) >> 7) << 7);
+    ((void **)ptr)[-1] = orig;
+    ((size_t *)ptr)[-2] = size;
+    size_t live = (live_bytes += size);
+    size_t peak = peak_bytes;
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {
+    }
+    return ptr;
+}
+
+void tracking_free(void *user_context, void *ptr) {
+    if (!ptr) return;
+    live_bytes -= ((size_t *)ptr)[-2];
+    free(((void **)ptr)[-1]);
+}
+
+// Returns the peak number of bytes allocated on the heap during a
+// single call to f.
+template<typename F>
+size_t peak_memory(F f) {
+    halide_malloc_t old_malloc = halide_set_custom_malloc(tracking_malloc);
+    halide_free_t old_free = halide_set_custom_free(tracking_free);
+    live_bytes = 0;
+    peak_bytes = 0;
+    f();
+    halide_set_custom_malloc(old_malloc);
+    halide_set_custom_free(old_free);
+    return peak_bytes;
+}
+
+}  // namespace
+
 int main(int argc, char **argv) {
     if (argc < 7) {
         printf("Usage: ./process input.png levels alpha beta timing_iterations output.png\n"
@@ -37,6 +87,22 @@ int main(int argc, char **argv) {
         local_laplacian(input, levels, alpha/(levels-1), beta, output);
     });
     printf("Manually-tuned time: %gms\n", best_manual * 1e3);
+    size_t manual_bytes = peak_memory([&]() {
+        local_laplacian(input, levels, alpha/(levels-1), beta, output);
+    });
+    printf("Manually-tuned peak memory: %gMB\n", manual_bytes / (1024.0 * 1024.0));
+
+    #ifndef NO_STREAMING
+    // Manually-tuned version that streams the pyramids in strips
+    double best_streaming = benchmark(timing, 1, [&]() {
+        local_laplacian_streaming(input, levels, alpha/(levels-1), beta, output);
+    });
+    printf("Streaming time: %gms\n", best_streaming * 1e3);
+    size_t streaming_bytes = peak_memory([&]() {
+        local_laplacian_streaming(input, levels, alpha/(levels-1), beta, output);
+    });
+    printf("Streaming peak memory: %gMB\n", streaming_bytes / (1024.0 * 1024.0));
+    #endif
 
     #ifndef NO_AUTO_SCHEDULE
     // Auto-scheduled version
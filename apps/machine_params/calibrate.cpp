@@ -0,0 +1,198 @@
+#include "Halide.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "halide_benchmark.h"
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Measures the host machine with a handful of JIT-compiled Halide
+// pipelines, and prints a hardware profile followed by a line that sets
+// HL_MACHINE_PARAMS, which MachineParams::generic() reads. The output
+// can be evaluated directly by a shell:
+//
+//   eval "$(./calibrate)"
+
+namespace {
+
+Target target = get_jit_target_from_environment();
+
+// Arithmetic throughput, in floating point operations per second. Each
+// point runs several independent multiply-add chains so that the
+// latency of each operation is hidden.
+double measure_ops(bool vectorize, bool parallel) {
+    const int chains = 8, steps = 64;
+    const int points = parallel ? (1 << 22) : (1 << 18);
+    Var x("x"), xo("xo"), xi("xi");
+
+    std::vector<Expr> acc;
+    for (int c = 0; c < chains; c++) {
+        acc.push_back(cast<float>(x + c));
+    }
+    for (int i = 0; i < steps; i++) {
+        for (int c = 0; c < chains; c++) {
+            acc[c] = acc[c] * 0.999f + 0.001f;
+        }
+    }
+    Expr e = acc[0];
+    for (int c = 1; c < chains; c++) {
+        e += acc[c];
+    }
+    Func ops("ops");
+    ops(x) = e;
+
+    const int vec = target.natural_vector_size<float>();
+    ops.split(x, xo, xi, 64 * vec);
+    if (vectorize) {
+        ops.vectorize(xi, vec);
+    }
+    if (parallel) {
+        ops.parallel(xo);
+    }
+    ops.compile_jit(target);
+
+    Buffer<float> out(points);
+    double t = benchmark(5, 1, [&]() { ops.realize(out); });
+    const double ops_per_point = chains * steps * 2 + (chains - 1);
+    return points * ops_per_point / t;
+}
+
+// Read bandwidth, in bytes per second, for a working set of the given
+// size. The buffer is swept repeatedly, by one thread or by all of
+// them, so after the first sweep it is served from whichever level of
+// the memory hierarchy it fits in.
+class Bandwidth {
+    static const int lanes = 64;
+    ImageParam data{Float(32), 2, "data"};
+    Param<int> rows{"rows"}, passes{"passes"};
+    Func sum{"sum"};
+
+public:
+    Bandwidth(bool parallel) {
+        // Thread t sums its own slice of the rows of the buffer.
+        Var x("x"), t("t");
+        RDom r(0, rows, 0, passes);
+        sum(x, t) = 0.0f;
+        sum(x, t) += data(x, r.x + t * rows);
+        sum.bound(x, 0, lanes).vectorize(x);
+        sum.update().vectorize(x);
+        if (parallel) {
+            sum.update().parallel(t);
+        }
+        sum.compile_jit(target);
+    }
+
+    double measure(size_t bytes, int threads) {
+        const int rows_per_thread = std::max<int>(1, bytes / (lanes * sizeof(float)) / threads);
+        Buffer<float> buf(lanes, rows_per_thread * threads);
+        buf.fill(1.0f);
+        data.set(buf);
+        rows.set(rows_per_thread);
+        // Read about 1GB in total, and at least one sweep.
+        const size_t sweep = buf.number_of_elements() * sizeof(float);
+        passes.set(std::max<int>(1, (1 << 30) / sweep));
+        Buffer<float> out(lanes, threads);
+        double t = benchmark(5, 1, [&]() { sum.realize(out); });
+        return (double)sweep * passes.get() / t;
+    }
+};
+
+// The latency of a dependent load from a working set of the given size,
+// in seconds. The buffer holds a single random cycle, so each load
+// depends on the last and can't be prefetched.
+double measure_latency(size_t bytes) {
+    const int n = bytes / sizeof(int), steps = 1 << 22;
+    Buffer<int> next(n);
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    std::mt19937 rng(0);
+    for (int i = n - 1; i > 0; i--) {
+        std::swap(perm[i], perm[std::uniform_int_distribution<int>(0, i - 1)(rng)]);
+    }
+    for (int i = 0; i < n; i++) {
+        next(perm[i]) = perm[(i + 1) % n];
+    }
+
+    Func chase("chase");
+    RDom r(0, steps);
+    chase() = 0;
+    // The condition is always true, but makes this an update over r.
+    chase() = select(r < steps, next(unsafe_promise_clamped(chase(), 0, n - 1)), 0);
+    chase.compile_jit(target);
+
+    Buffer<int> out = Buffer<int>::make_scalar();
+    double t = benchmark(3, 1, [&]() { chase.realize(out); });
+    return t / steps;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cerr << "Measuring arithmetic throughput...\n";
+    const double scalar_ops = measure_ops(false, false);
+    const double vector_ops = measure_ops(true, false);
+    const double parallel_ops = measure_ops(true, true);
+
+    // Find the cache levels from the drops in single-threaded bandwidth
+    // as the working set grows. A level ends where the bandwidth falls
+    // well below the best seen since the previous drop.
+    std::cerr << "Measuring cache sizes and bandwidth...\n";
+    const size_t min_size = 4 * 1024, max_size = size_t(512) * 1024 * 1024;
+    Bandwidth single(false), all(true);
+    struct Level {
+        size_t size;
+        double bandwidth;
+    };
+    std::vector<Level> levels;
+    double plateau = 0, last = 0;
+    for (size_t size = min_size; size <= max_size; size *= 2) {
+        double bw = single.measure(size, 1);
+        if (plateau > 0 && bw < 0.6 * plateau) {
+            levels.push_back({size / 2, plateau});
+            plateau = bw;
+        }
+        plateau = std::max(plateau, bw);
+        last = bw;
+    }
+    const double memory_bandwidth = all.measure(max_size, threads);
+
+    const size_t llc = levels.empty() ? 16 * 1024 * 1024 : levels.back().size;
+
+    std::cerr << "Measuring memory latency...\n";
+    const double latency = measure_latency(std::min(max_size, std::max<size_t>(4 * llc, 64 * 1024 * 1024)));
+
+    // The balance is how many arithmetic operations the machine can do
+    // in the time it takes to load a float from memory, and the
+    // latency of a load is expressed in operations of a single thread.
+    const float balance = parallel_ops / (memory_bandwidth / sizeof(float));
+    const int memory_latency = std::max(1, (int)(latency * scalar_ops + 0.5));
+
+    std::cout << "# Hardware profile for " << target.to_string() << "\n"
+              << "#   threads:                " << threads << "\n"
+              << "#   parallel speedup:       " << parallel_ops / vector_ops << "x\n"
+              << "#   scalar ops/s/thread:    " << scalar_ops << "\n"
+              << "#   vector ops/s/thread:    " << vector_ops << "\n"
+              << "#   vector ops/s:           " << parallel_ops << "\n";
+    for (size_t i = 0; i < levels.size(); i++) {
+        std::cout << "#   cache L" << i + 1 << ":               "
+                  << levels[i].size / 1024 << " KB, "
+                  << levels[i].bandwidth / 1e9 << " GB/s/thread\n";
+    }
+    std::cout << "#   memory:                 " << last / 1e9 << " GB/s/thread, "
+              << memory_bandwidth / 1e9 << " GB/s total\n"
+              << "#   memory latency:         " << latency * 1e9 << " ns\n";
+
+    MachineParams params(threads, llc, balance, 0, memory_latency);
+    std::cout << "export HL_MACHINE_PARAMS=" << params.to_string() << "\n";
+
+    return 0;
+}
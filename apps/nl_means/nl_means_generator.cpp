@@ -6,6 +6,11 @@ using namespace Halide;
 
 class NonLocalMeans : public Halide::Generator<NonLocalMeans> {
 public:
+    // If true, compute the patch differences with running sums, which
+    // cost O(1) per pixel regardless of the patch size, one search
+    // offset at a time.
+    GeneratorParam<bool>  running_sums{"running_sums", false};
+
     Input<Buffer<float>>  input{"input", 3};
     Input<int>            patch_size{"patch_size"};
     Input<int>            search_area{"search_area"};
@@ -39,10 +44,34 @@ public:
         // Find the patch differences by blurring the difference images
         RDom patch_dom(-(patch_size/2), patch_size);
         Func blur_d_y("blur_d_y");
-        blur_d_y(x, y, dx, dy) = sum(d(x, y + patch_dom, dx, dy));
-
         Func blur_d("blur_d");
-        blur_d(x, y, dx, dy) = sum(blur_d_y(x + patch_dom, y, dx, dy));
+        RDom ry, rx;
+        if (!running_sums) {
+            blur_d_y(x, y, dx, dy) = sum(d(x, y + patch_dom, dx, dy));
+            blur_d(x, y, dx, dy) = sum(blur_d_y(x + patch_dom, y, dx, dy));
+        } else {
+            // Sum the first patch of each column (or row) of the
+            // output directly, and then slide the patch along it,
+            // adding the value entering the patch and subtracting
+            // the one leaving it. This is an integral image
+            // formulation, but the sums don't grow with the image
+            // size, so float rounding error stays small.
+            Expr lo = patch_size/2, hi = patch_size - 1 - patch_size/2;
+            Expr x_min = non_local_means.dim(0).min(), x_max = non_local_means.dim(0).max();
+            Expr y_min = non_local_means.dim(1).min(), y_max = non_local_means.dim(1).max();
+            ry = RDom(y_min + 1, y_max - y_min, "ry");
+            rx = RDom(x_min + 1, x_max - x_min, "rx");
+
+            blur_d_y(x, y, dx, dy) = 0.0f;
+            blur_d_y(x, y_min, dx, dy) += d(x, y_min + patch_dom, dx, dy);
+            blur_d_y(x, ry, dx, dy) = (blur_d_y(x, ry - 1, dx, dy) +
+                                       d(x, ry + hi, dx, dy) - d(x, ry - lo - 1, dx, dy));
+
+            blur_d(x, y, dx, dy) = 0.0f;
+            blur_d(x_min, y, dx, dy) += blur_d_y(x_min + patch_dom, y, dx, dy);
+            blur_d(rx, y, dx, dy) = (blur_d(rx - 1, y, dx, dy) +
+                                     blur_d_y(rx + hi, y, dx, dy) - blur_d_y(rx - lo - 1, y, dx, dy));
+        }
 
         // Compute the weights from the patch differences
         Func w("w");
@@ -112,7 +141,46 @@ public:
                 .update()
                 .reorder(x, y, c, s_dom.x, s_dom.y)
                 .gpu_threads(x, y);
-        }*/ else {
+        }*/ else if (running_sums) {
+            // The running sums are only valid over the whole output, so
+            // compute them for the whole output one search offset at a
+            // time, and accumulate each offset into the sums of all
+            // the output pixels.
+            Var xo("xo");
+            non_local_means.compute_root()
+                .reorder(c, x, y)
+                .parallel(y, 8)
+                .vectorize(x, 8);
+            non_local_means_sum.compute_root()
+                .reorder(c, x, y)
+                .bound(c, 0, 4).unroll(c)
+                .parallel(y, 8)
+                .vectorize(x, 8);
+            non_local_means_sum.update(0)
+                .reorder(c, x, y, s_dom.x, s_dom.y)
+                .unroll(c)
+                .parallel(y, 8)
+                .vectorize(x, 8);
+            blur_d_y.compute_at(non_local_means_sum, s_dom.x)
+                .parallel(y, 8)
+                .vectorize(x, 8);
+            blur_d_y.update(0)
+                .reorder(x, patch_dom.x)
+                .vectorize(x, 8);
+            blur_d_y.update(1)
+                .split(x, xo, x, 64)
+                .reorder(x, ry, xo)
+                .parallel(xo)
+                .vectorize(x, 8);
+            blur_d.compute_at(non_local_means_sum, s_dom.x)
+                .parallel(y, 8)
+                .vectorize(x, 8);
+            blur_d.update(0)
+                .reorder(y, patch_dom.x)
+                .vectorize(y, 8);
+            blur_d.update(1)
+                .parallel(y, 8);
+        } else {
             non_local_means.compute_root()
                 .reorder(c, x, y)
                 .tile(x, y, tx, ty, x, y, 16, 8)
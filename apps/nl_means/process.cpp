@@ -1,8 +1,11 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <chrono>
 
 #include "nl_means.h"
 #include "nl_means_auto_schedule.h"
+#include "nl_means_running_sums.h"
 
 #include "halide_benchmark.h"
 #include "HalideBuffer.h"
@@ -44,6 +47,25 @@ int main(int argc, char **argv) {
     });
     printf("Auto-scheduled time: %gms\n", min_t_auto * 1e3);
 
+    // Manually-tuned version using running sums for the patch differences
+    Buffer<float> output_running_sums(input.width(), input.height(), 3);
+    double min_t_running_sums = benchmark(timing_iterations, 1, [&]() {
+        nl_means_running_sums(input, patch_size, search_area, sigma, output_running_sums);
+    });
+    printf("Running sums time: %gms\n", min_t_running_sums * 1e3);
+
+    // The running sums round differently, so only expect them to be close.
+    nl_means(input, patch_size, search_area, sigma, output);
+    double max_error = 0;
+    output.for_each_element([&](int x, int y, int c) {
+        max_error = std::max(max_error, (double)std::abs(output(x, y, c) - output_running_sums(x, y, c)));
+    });
+    printf("Running sums max error: %g\n", max_error);
+    if (max_error > 1e-3) {
+        printf("Running sums result differs from the manually-tuned result\n");
+        return -1;
+    }
+
     convert_and_save_image(output, argv[6]);
 
     return 0;
@@ -27,3 +27,9 @@ Expr rounding_shift_right(Expr x, Expr shift) {
 Expr multiply_quantized_multiplier(Expr x, Expr q, Expr shift) {
     return rounding_shift_right(saturating_rounding_doubling_high_multiply(x, q), shift);
 }
+
+Expr multiply_quantized_multiplier_signed_shift(Expr x, Expr q, Expr shift) {
+    Expr left_shift = max(0, -shift);
+    Expr right_shift = max(0, shift);
+    return rounding_shift_right(saturating_rounding_doubling_high_multiply(x << left_shift, q), right_shift);
+}
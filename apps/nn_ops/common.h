@@ -16,4 +16,12 @@ Halide::Expr rounding_shift_right(Halide::Expr x, Halide::Expr shift);
 // Performs right shift and multiply by a multiplier.
 Halide::Expr multiply_quantized_multiplier(
     Halide::Expr x, Halide::Expr quantized_multiplier, Halide::Expr shift);
+
+// Like multiply_quantized_multiplier, but a negative shift is a left shift
+// applied before the multiply, so that the real multiplier represented by
+// quantized_multiplier * 2^(-31 - shift) may be greater than one. This is
+// the form used for per-channel requantization, where each channel can
+// have a different multiplier and shift.
+Halide::Expr multiply_quantized_multiplier_signed_shift(
+    Halide::Expr x, Halide::Expr quantized_multiplier, Halide::Expr shift);
 #endif
@@ -67,9 +67,10 @@ class HalideBackend(BackendBase):
         with WatchdogTimer(timeout=300):
             prepared.BuildFromOnnxModel(model)
             # Optimize the schedule of nontrivial models to make sure they
-            # complete in a reasonable amount of time
+            # complete in a reasonable amount of time. This is done once the
+            # shapes of the inputs are known.
             if len(model.graph.node) > 10:
-                prepared.OptimizeSchedule()
+                prepared.schedule_on_first_run = True
             return prepared
 
     @classmethod
@@ -64,6 +64,49 @@ std::string auto_schedule(const HalideModel &pipeline) {
     return schedule;
 }
 
+std::string auto_schedule_for_shapes(
+    const HalideModel &pipeline,
+    const std::vector<std::vector<int>> &input_shapes) {
+    if (input_shapes.size() != pipeline.input_names.size()) {
+        throw std::invalid_argument(
+            "Expected " + std::to_string(pipeline.input_names.size()) +
+            " input shapes but got " + std::to_string(input_shapes.size()));
+    }
+
+    // Replace the estimates made when converting the model with the
+    // actual shapes of the inputs, and the shapes of the outputs they
+    // imply.
+    std::map<std::string, std::vector<int>> shapes;
+    for (int i = 0; i < input_shapes.size(); ++i) {
+        const std::string &input_name = pipeline.input_names[i];
+        Halide::ImageParam &input = pipeline.model->inputs.at(input_name);
+        const std::vector<int> &shape = input_shapes[i];
+        if (shape.size() != input.dimensions()) {
+            throw std::invalid_argument(
+                "Expected a shape of rank " + std::to_string(input.dimensions()) +
+                " for input " + input_name + " but got " + std::to_string(shape.size()));
+        }
+        for (int j = 0; j < shape.size(); ++j) {
+            input.dim(j).set_bounds_estimate(0, shape[j]);
+        }
+        shapes[input_name] = shape;
+    }
+
+    std::map<std::string, std::vector<int>> output_shapes;
+    compute_output_shapes(*pipeline.model, shapes, &output_shapes);
+    for (const std::string &output_name : pipeline.output_names) {
+        Halide::Func f = pipeline.model->outputs.at(output_name).rep;
+        const std::vector<Halide::Var> args = f.args();
+        const std::vector<int> &shape = output_shapes.at(output_name);
+        f.function().schedule().estimates().clear();
+        for (int i = 0; i < args.size(); ++i) {
+            f.estimate(args[i], 0, shape[i]);
+        }
+    }
+
+    return auto_schedule(pipeline);
+}
+
 template<typename T>
 struct Distribution {
     typedef typename std::conditional<
@@ -533,6 +576,10 @@ PYBIND11_MODULE(model_cpp, m) {
         "AutoSchedule",
         &auto_schedule,
         "A function to automatic schedule HalideModel.");
+    m.def(
+        "AutoScheduleForShapes",
+        &auto_schedule_for_shapes,
+        "A function to automatic schedule HalideModel for the given input shapes.");
     m.def("Run", &run, "A function to JIT compile and run HalideModel.");
     m.def("Benchmark", &benchmark, "A function to benchmark the model");
     m.def("PrintLoopNest", &print_loop_nest, "Print a high level representation of the loop nest");
@@ -9,6 +9,9 @@ import model_cpp
 class Model():
     def __init__(self):
         self.pipeline = None
+        # Schedule the model for the shapes of the inputs of the first call
+        # to run, unless it has been scheduled already.
+        self.schedule_on_first_run = False
 
     def BuildFromOnnxModel(self, onnx_model):
         assert onnx_model
@@ -22,14 +25,19 @@ class Model():
             model_str = onnx_model.SerializeToString()
             self.pipeline = model_cpp.ConvertOnnxModel(model_str)
 
-    def OptimizeSchedule(self):
+    def OptimizeSchedule(self, input_shapes=None):
         if not self.pipeline:
             raise Exception("model not initialized, call BuildFromOnnxModel first")
-        return model_cpp.AutoSchedule(self.pipeline)
+        self.schedule_on_first_run = False
+        if input_shapes is None:
+            return model_cpp.AutoSchedule(self.pipeline)
+        return model_cpp.AutoScheduleForShapes(self.pipeline, input_shapes)
 
     def run(self, inputs, device=''):
         if not self.pipeline:
             raise Exception("model not initialized, call BuildFromOnnxModel first")
+        if self.schedule_on_first_run:
+            self.OptimizeSchedule([list(i.shape) for i in inputs])
         return model_cpp.Run(self.pipeline, inputs, device)
 
     def Benchmark(self, num_iters=5, device=''):
@@ -1,6 +1,9 @@
 #include "onnx_converter.h"
+#include "onnx_weights.h"
 #include <climits>
 #include <exception>
+#include <fstream>
+#include <map>
 #include <math.h>
 #include <unordered_set>
 
@@ -210,11 +213,15 @@ Halide::Func encode_buffer_as_func(
             val(halide_coords) = *reinterpret_cast<const DataType *>(raw); \
         }                                                                  \
     });                                                                    \
-    result.rep = encode_buffer_as_func(val, dims, NodeName);
+    result.rep = encode_buffer_as_func(val, dims, NodeName);               \
+    if (values) {                                                          \
+        *values = val;                                                     \
+    }
 
 Tensor build_from_constant(
     const onnx::TensorProto &value,
-    const std::string &name) {
+    const std::string &name,
+    Halide::Buffer<> *values = nullptr) {
     Tensor result;
 
     std::vector<int> dims;
@@ -3530,14 +3537,30 @@ std::vector<Halide::Expr> finalize_type_info(
     return result;
 }
 
-Model convert_model(const onnx::ModelProto &model) {
+Model convert_model(const onnx::ModelProto &model, bool external_weights) {
     Model result;
     std::unordered_map<std::string, Tensor> &reps = result.tensors;
     std::unordered_map<std::string, Halide::Internal::Dimension> symbolic_dims;
 
     // Encode the constants inputs.
     for (const auto &constant : model.graph().initializer()) {
-        Tensor t = build_from_constant(constant, sanitize_name(constant.name()));
+        const std::string name = sanitize_name(constant.name());
+        Halide::Buffer<> values;
+        Tensor t = build_from_constant(constant, name, &values);
+        // Small constants are folded into the code, and integer constants
+        // are often shapes or indices that the conversion of other nodes
+        // inspects, so only large floating point tensors are external.
+        if (external_weights && values.defined() && values.type().is_float() &&
+            values.number_of_elements() > 16) {
+            Halide::ImageParam p(values.type(), values.dimensions(), name);
+            for (int i = 0; i < values.dimensions(); ++i) {
+                p.dim(i).set_bounds(0, values.dim(i).extent());
+                p.dim(i).set_stride(values.dim(i).stride());
+            }
+            t.rep = p;
+            result.weights[name] = p;
+            result.weight_values[name] = values;
+        }
         reps[constant.name()] = t;
     }
 
@@ -3619,6 +3642,77 @@ Model convert_model(const onnx::ModelProto &model) {
     return result;
 }
 
+void write_weights(const Model &model, const std::string &path) {
+    // Sort the weights by name, so that the file doesn't depend on the
+    // order of the hash map.
+    std::map<std::string, Halide::Buffer<>> weights(
+        model.weight_values.begin(), model.weight_values.end());
+
+    std::string header;
+    auto append = [&](const void *data, size_t size) {
+        header.append(static_cast<const char *>(data), size);
+    };
+    header.append(OnnxWeights::magic(), OnnxWeights::kMagicSize);
+    const uint32_t version = OnnxWeights::kVersion;
+    const uint32_t num_weights = weights.size();
+    append(&version, sizeof(version));
+    append(&num_weights, sizeof(num_weights));
+
+    // The offsets of the data are only known once the size of the header
+    // is, so leave room for them and fill them in afterwards.
+    std::vector<size_t> offset_positions;
+    for (const auto &weight : weights) {
+        const Halide::Buffer<> &values = weight.second;
+        const uint32_t name_size = weight.first.size();
+        append(&name_size, sizeof(name_size));
+        header.append(weight.first);
+        const uint8_t code = values.type().code();
+        const uint8_t bits = values.type().bits();
+        const uint16_t reserved = 0;
+        const uint32_t rank = values.dimensions();
+        append(&code, sizeof(code));
+        append(&bits, sizeof(bits));
+        append(&reserved, sizeof(reserved));
+        append(&rank, sizeof(rank));
+        for (int i = 0; i < values.dimensions(); ++i) {
+            const int32_t extent = values.dim(i).extent();
+            append(&extent, sizeof(extent));
+        }
+        offset_positions.push_back(header.size());
+        const uint64_t offset = 0;
+        append(&offset, sizeof(offset));
+    }
+
+    std::vector<uint64_t> offsets;
+    uint64_t offset = header.size();
+    for (const auto &weight : weights) {
+        offset = OnnxWeights::align(offset);
+        offsets.push_back(offset);
+        offset += weight.second.size_in_bytes();
+    }
+    for (int i = 0; i < offsets.size(); ++i) {
+        header.replace(offset_positions[i], sizeof(uint64_t),
+                       reinterpret_cast<const char *>(&offsets[i]), sizeof(uint64_t));
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::invalid_argument("Can't open weights file " + path);
+    }
+    out.write(header.data(), header.size());
+    int i = 0;
+    for (const auto &weight : weights) {
+        const uint64_t position = out.tellp();
+        const std::string padding(offsets[i++] - position, '\0');
+        out.write(padding.data(), padding.size());
+        out.write(reinterpret_cast<const char *>(weight.second.data()),
+                  weight.second.size_in_bytes());
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write weights file " + path);
+    }
+}
+
 Halide::Type get_halide_type(const Tensor &tensor) {
     switch (tensor.type) {
     case onnx::TensorProto_DataType_FLOAT:
@@ -31,9 +31,22 @@ struct Model {
     std::unordered_map<std::string, Tensor> tensors;
 
     std::vector<Halide::Expr> requirements;
+
+    // The weights passed to the model as inputs, when they aren't embedded in
+    // it, and their values.
+    std::unordered_map<std::string, Halide::ImageParam> weights;
+    std::unordered_map<std::string, Halide::Buffer<>> weight_values;
 };
 
-Model convert_model(const onnx::ModelProto &model);
+// Convert an ONNX model to Halide. If external_weights is true, the large
+// floating point initializers of the model are passed in as inputs instead of
+// being embedded in the pipeline. Their values can be saved with
+// write_weights, and loaded at runtime with OnnxWeights.
+Model convert_model(const onnx::ModelProto &model, bool external_weights = false);
+
+// Write the values of the external weights of a model to a file that can be
+// memory mapped by OnnxWeights (see onnx_weights.h).
+void write_weights(const Model &model, const std::string &path);
 
 Halide::Type get_halide_type(const Tensor &tensor);
 
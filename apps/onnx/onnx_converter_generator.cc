@@ -9,6 +9,11 @@ class OnnxModelConverterGenerator
     : public Halide::Generator<OnnxModelConverterGenerator> {
 public:
     GeneratorParam<std::string> model_file_path{ "model_file_path", "" };
+    // If set, the weights of the model are written to this file instead of
+    // being embedded in the generated code, and the pipeline takes them as
+    // inputs, following the inputs of the model. Load them at runtime with
+    // OnnxWeights (see onnx_weights.h).
+    GeneratorParam<std::string> weights_file_path{ "weights_file_path", "" };
 
     void configure() {
         onnx::ModelProto onnx_model;
@@ -24,13 +29,26 @@ public:
             abort();
         }
 
-        converted_model_ = convert_model(onnx_model);
+        const bool external_weights = !weights_file_path.value().empty();
+        converted_model_ = convert_model(onnx_model, external_weights);
         for (const auto &input : converted_model_.inputs) {
             model_inputs_[input.first] = add_input<Buffer<>>(
                 input.first,
                 input.second.type(),
                 input.second.parameter().dimensions());
         }
+        if (external_weights) {
+            write_weights(converted_model_, weights_file_path.value());
+            // Add the weights in the same (sorted) order as in the file.
+            std::map<std::string, Halide::ImageParam> weights(
+                converted_model_.weights.begin(), converted_model_.weights.end());
+            for (const auto &weight : weights) {
+                add_input<Buffer<>>(
+                    weight.first,
+                    weight.second.type(),
+                    weight.second.dimensions());
+            }
+        }
         for (const auto &output : converted_model_.outputs) {
             model_outputs_[output.first] = add_output<Buffer<>>(
                 output.first,
@@ -0,0 +1,33 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "onnx_weights.h"
+#include "test_model_weights.h"
+#include <iostream>
+#include <random>
+
+int main(int argc, char **argv) {
+    std::cout << "Running onnx_converter_generator_weights_test...\n";
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <weights file>\n";
+        return -1;
+    }
+    OnnxWeights weights(argv[1]);
+    Halide::Runtime::Buffer<float> A(5, 4);
+    Halide::Runtime::Buffer<float> C(5, 4);
+
+    std::mt19937 rnd(123);
+    A.for_each_value([&](float &v) {
+        v = rnd();
+    });
+    test_model_weights(A, weights["W"], C);
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            if (C(i, j) != A(i, j) + (i * 4 + j)) {
+                std::cerr << "Unexpected value for inputs at (" << i << "," << j << ") \n";
+                return -1;
+            }
+        }
+    }
+    std::cout << "Success!\n";
+    return 0;
+}
@@ -0,0 +1,162 @@
+#ifndef ONNX_WEIGHTS_H_
+#define ONNX_WEIGHTS_H_
+
+// A loader for the weights of ONNX models compiled ahead of time with
+// external weights (see write_weights in onnx_converter.h). It only depends on
+// the Halide runtime, so it can be used by applications that link with the
+// compiled model.
+//
+// The file is memory mapped, and the buffers returned point into the mapping,
+// so loading a model doesn't read or copy its weights. The buffers are read
+// only, and remain valid as long as the OnnxWeights object is alive.
+//
+// The file consists of a header followed by the data of each weight, densely
+// packed with the first dimension innermost, and aligned to kAlignment bytes:
+//   char magic[8];
+//   uint32_t version, num_weights;
+//   For each weight:
+//     uint32_t name_size; char name[name_size];
+//     uint8_t type_code, type_bits; uint16_t reserved;
+//     uint32_t rank; int32_t extents[rank];
+//     uint64_t offset;  // From the start of the file.
+
+#include "HalideBuffer.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+class OnnxWeights {
+public:
+    // The first kMagicSize bytes of the file.
+    static const char *magic() {
+        return "HLONNXWT";
+    }
+    static constexpr size_t kMagicSize = 8;
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kAlignment = 64;
+
+    static uint64_t align(uint64_t offset) {
+        return (offset + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    explicit OnnxWeights(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::invalid_argument("Can't open weights file " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::invalid_argument("Can't stat weights file " + path);
+        }
+        size_ = st.st_size;
+        data_ = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            throw std::invalid_argument("Can't map weights file " + path);
+        }
+        try {
+            parse(path);
+        } catch (...) {
+            munmap(data_, size_);
+            throw;
+        }
+    }
+
+    ~OnnxWeights() {
+        if (data_) {
+            munmap(data_, size_);
+        }
+    }
+
+    OnnxWeights(const OnnxWeights &) = delete;
+    OnnxWeights &operator=(const OnnxWeights &) = delete;
+
+    // The names of the weights, which are the names of the corresponding
+    // arguments of the compiled model.
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (const auto &it : weights_) {
+            result.push_back(it.first);
+        }
+        return result;
+    }
+
+    // Get the weight with the given name.
+    Halide::Runtime::Buffer<> get(const std::string &name) const {
+        auto it = weights_.find(name);
+        if (it == weights_.end()) {
+            throw std::invalid_argument("No weight named " + name);
+        }
+        return it->second;
+    }
+
+    Halide::Runtime::Buffer<> operator[](const std::string &name) const {
+        return get(name);
+    }
+
+private:
+    void *data_ = nullptr;
+    size_t size_ = 0;
+    std::map<std::string, Halide::Runtime::Buffer<>> weights_;
+
+    void parse(const std::string &path) {
+        const char *base = static_cast<const char *>(data_);
+        size_t pos = 0;
+        auto read = [&](void *dst, size_t n) {
+            if (pos + n > size_) {
+                throw std::invalid_argument("Truncated weights file " + path);
+            }
+            memcpy(dst, base + pos, n);
+            pos += n;
+        };
+
+        char file_magic[kMagicSize];
+        uint32_t version, num_weights;
+        read(file_magic, kMagicSize);
+        read(&version, sizeof(version));
+        read(&num_weights, sizeof(num_weights));
+        if (memcmp(file_magic, magic(), kMagicSize) != 0 || version != kVersion) {
+            throw std::invalid_argument("Invalid weights file " + path);
+        }
+
+        for (uint32_t i = 0; i < num_weights; i++) {
+            uint32_t name_size;
+            read(&name_size, sizeof(name_size));
+            std::string name(name_size, '\0');
+            read(&name[0], name_size);
+            uint8_t code, bits;
+            uint16_t reserved;
+            uint32_t rank;
+            read(&code, sizeof(code));
+            read(&bits, sizeof(bits));
+            read(&reserved, sizeof(reserved));
+            read(&rank, sizeof(rank));
+            std::vector<int> extents(rank);
+            uint64_t num_bytes = bits / 8;
+            for (uint32_t d = 0; d < rank; d++) {
+                int32_t extent;
+                read(&extent, sizeof(extent));
+                extents[d] = extent;
+                num_bytes *= extent;
+            }
+            uint64_t offset;
+            read(&offset, sizeof(offset));
+            if (offset % kAlignment != 0 || offset + num_bytes > size_) {
+                throw std::invalid_argument("Invalid data for weight " + name + " in " + path);
+            }
+            halide_type_t type(static_cast<halide_type_code_t>(code), bits);
+            weights_.emplace(name, Halide::Runtime::Buffer<>(type, const_cast<char *>(base) + offset, extents));
+        }
+    }
+};
+
+#endif
@@ -160,7 +160,7 @@ public:
             .compute_at(kernel_y, y)
             .vectorize(y);
         kernel_y
-            .compute_at(output, y)
+            .compute_root()
             .reorder(k, y).vectorize(y, 8);
 
         if (upsample) {
@@ -175,15 +175,29 @@ public:
                 .compute_at(output, y)
                 .vectorize(x, 8);
         } else {
+            // The resize in x reads a different input column for each
+            // output column, so vectorizing it along x makes a gather
+            // for each tap. Instead, store the resize in y transposed so
+            // that the resize in x can vectorize across rows with dense
+            // loads, and transpose back in 8x8 blocks. Both transposes
+            // are unrolled stores with a constant stride of 8, which
+            // Halide turns into dense stores of interleaved vectors.
+            Var xii, yii;
             output
-                .tile(x, y, xi, yi, 32, 8)
+                .tile(x, y, xi, yi, 8, 8)
                 .parallel(y)
                 .vectorize(xi);
             resized_y
                 .compute_at(output, y)
-                .vectorize(x, 8);
+                .reorder_storage(y, x, c)
+                .tile(x, y, xii, yii, 8, 8)
+                .vectorize(xii)
+                .unroll(yii);
             resized_x
-                .compute_at(output, xi);
+                .compute_at(output, x)
+                .reorder(y, x)
+                .vectorize(y)
+                .unroll(x);
         }
 
         // Allow the input and output to have arbitrary memory layout,
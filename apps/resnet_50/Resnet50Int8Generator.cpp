@@ -0,0 +1,399 @@
+// An 8-bit quantized version of the ResNet-50 pipeline in
+// Resnet50Generator.cpp.
+//
+// Activations are uint8 with a per-tensor scale and a zero point of zero,
+// which is exact for the outputs of the ReLUs that feed every convolution.
+// Weights are int8 with a per-output-channel scale, with the batch norm
+// folded in, and each convolution has an int32 bias in units of the
+// accumulator. The scales and requantization multipliers are computed
+// offline by quantize_weights.py.
+//
+// Each convolution accumulates in int32, and its batch norm, scale, ReLU
+// and (for the last convolution of each block) residual sum are computed
+// by a per-channel requantization epilogue fused into the consumer. The
+// reductions sum groups of four u8 x i8 products, which is the pattern
+// that x86 targets with avx512_vnni compile to vpdpbusd.
+//
+// The pooling at the end of the network is dequantized to float, and the
+// final fully connected layer and softmax are computed in float.
+
+#include "Halide.h"
+#include "common.h"
+
+namespace {
+
+using Halide::ConciseCasts::i32;
+using Halide::ConciseCasts::u8_sat;
+
+struct Tensor {
+    Halide::Func f;
+    std::vector<int> shape;
+    std::string name;
+    // The reduction domain of a convolution, if this tensor is one.
+    Halide::RDom r;
+};
+
+struct WeightShape {
+    int c;  // output channels
+    int w;
+    int h;
+    int pad;
+    int stride;
+};
+
+class Resnet50Int8Generator : public Halide::Generator<Resnet50Int8Generator> {
+public:
+    Input<Buffer<float>> input{ "input", 3 };
+    /** The scale used to quantize the input, and to dequantize the input to
+     * the final average pooling. **/
+    Input<float> input_scale{ "input_scale" };
+    Input<float> features_scale{ "features_scale" };
+
+    /** int8 weights, int32 biases, and per-channel requantization
+     * multipliers and shifts for convolutions. A shift is a right shift
+     * if positive, and a left shift if negative. **/
+    Input<Buffer<int8_t>> conv1_weights{ "conv1_weights", 4 };
+    Input<Buffer<int32_t>> conv1_bias{ "conv1_bias", 1 };
+    Input<Buffer<int32_t>> conv1_multiplier{ "conv1_multiplier", 1 };
+    Input<Buffer<int32_t>> conv1_shift{ "conv1_shift", 1 };
+
+    Input<Buffer<int8_t>[4]> br1_conv_weights { "br1_conv_weights", 4 };
+    Input<Buffer<int32_t>[4]> br1_bias { "br1_bias", 1 };
+    Input<Buffer<int32_t>[4]> br1_multiplier { "br1_multiplier", 1 };
+    Input<Buffer<int32_t>[4]> br1_shift { "br1_shift", 1 };
+
+    Input<Buffer<int8_t>[16]> br2a_conv_weights { "br2a_conv_weights", 4 };
+    Input<Buffer<int32_t>[16]> br2a_bias { "br2a_bias", 1 };
+    Input<Buffer<int32_t>[16]> br2a_multiplier { "br2a_multiplier", 1 };
+    Input<Buffer<int32_t>[16]> br2a_shift { "br2a_shift", 1 };
+
+    Input<Buffer<int8_t>[16]> br2b_conv_weights { "br2b_conv_weights", 4 };
+    Input<Buffer<int32_t>[16]> br2b_bias { "br2b_bias", 1 };
+    Input<Buffer<int32_t>[16]> br2b_multiplier { "br2b_multiplier", 1 };
+    Input<Buffer<int32_t>[16]> br2b_shift { "br2b_shift", 1 };
+
+    Input<Buffer<int8_t>[16]> br2c_conv_weights { "br2c_conv_weights", 4 };
+    Input<Buffer<int32_t>[16]> br2c_bias { "br2c_bias", 1 };
+    Input<Buffer<int32_t>[16]> br2c_multiplier { "br2c_multiplier", 1 };
+    Input<Buffer<int32_t>[16]> br2c_shift { "br2c_shift", 1 };
+
+    /** Multiplier and shift that rescale the input of each residual unit to
+     * the scale of its output, for units without a branch1 convolution. The
+     * entries for units with a branch1 convolution are ignored. **/
+    Input<Buffer<int32_t>> shortcut_multiplier{ "shortcut_multiplier", 1 };
+    Input<Buffer<int32_t>> shortcut_shift{ "shortcut_shift", 1 };
+
+    Input<Buffer<float>> fc1000_weights{ "fc1000_weights", 2 };
+    Input<Buffer<float>> fc1000_bias{ "fc1000_bias", 1 };
+    Output<Buffer<float>> final_output{ "final_output", 1 };
+
+    /** list out shapes of each layers weights **/
+    // weight shapes: out channels, kernel_w, kernel_h, pad, stride. In channels infered by input tensor shape
+    const WeightShape conv1_ws = { 64, 7, 7, 3, 2 };
+    const WeightShape pool1_ws = { 64, 3, 3, 1, 2 };
+    const WeightShape pool5_ws = { 2048, 7, 7, 0, 1 };
+    const WeightShape fc1000_ws = { 1000, 1, 1, 0, 1 };
+
+    const WeightShape res2x_br2a_ws = { 64, 1, 1, 0, 1 };
+    const WeightShape res2a_br2b_ws = { 64, 3, 3, 1, 1 };
+    const WeightShape res2x_br2b_ws = { 64, 3, 3, 1, 1 };
+    const WeightShape res2x_br2c_ws = { 256, 1, 1, 0, 1 };
+    const WeightShape res2a_br1_ws = { 256, 1, 1, 0, 1 };
+
+    const WeightShape res3x_br2a_ws = { 128, 1, 1, 0, 1 };
+    const WeightShape res3a_br2b_ws = { 128, 3, 3, 1, 2 };
+    const WeightShape res3x_br2b_ws = { 128, 3, 3, 1, 1 };
+    const WeightShape res3x_br2c_ws = { 512, 1, 1, 0, 1 };
+    const WeightShape res3a_br1_ws = { 512, 1, 1, 0, 2 };
+
+    const WeightShape res4x_br2a_ws = { 256, 1, 1, 0, 1 };
+    const WeightShape res4a_br2b_ws = { 256, 3, 3, 1, 2 };
+    const WeightShape res4x_br2b_ws = { 256, 3, 3, 1, 1 };
+    const WeightShape res4x_br2c_ws = { 1024, 1, 1, 0, 1 };
+    const WeightShape res4a_br1_ws = { 1024, 1, 1, 0, 2 };
+
+    const WeightShape res5x_br2a_ws = { 512, 1, 1, 0, 1 };
+    const WeightShape res5a_br2b_ws = { 512, 3, 3, 1, 2 };
+    const WeightShape res5x_br2b_ws = { 512, 3, 3, 1, 1 };
+    const WeightShape res5x_br2c_ws = { 2048, 1, 1, 0, 1 };
+    const WeightShape res5a_br1_ws = { 2048, 1, 1, 0, 2 };
+
+    const WeightShape br1_ws[4] = { res2a_br1_ws, res3a_br1_ws, res4a_br1_ws, res5a_br1_ws };
+    const WeightShape br2a_ws[16] = { res2x_br2a_ws, res2x_br2a_ws, res2x_br2a_ws,
+                                      res3x_br2a_ws, res3x_br2a_ws, res3x_br2a_ws, res3x_br2a_ws,
+                                      res4x_br2a_ws, res4x_br2a_ws, res4x_br2a_ws, res4x_br2a_ws, res4x_br2a_ws, res4x_br2a_ws,
+                                      res5x_br2a_ws, res5x_br2a_ws, res5x_br2a_ws };
+    const WeightShape br2b_ws[16] = { res2a_br2b_ws, res2x_br2b_ws, res2x_br2b_ws,
+                                      res3a_br2b_ws, res3x_br2b_ws, res3x_br2b_ws, res3x_br2b_ws,
+                                      res4a_br2b_ws, res4x_br2b_ws, res4x_br2b_ws, res4x_br2b_ws, res4x_br2b_ws, res4x_br2b_ws,
+                                      res5a_br2b_ws, res5x_br2b_ws, res5x_br2b_ws };
+    const WeightShape br2c_ws[16] = { res2x_br2c_ws, res2x_br2c_ws, res2x_br2c_ws,
+                                      res3x_br2c_ws, res3x_br2c_ws, res3x_br2c_ws, res3x_br2c_ws,
+                                      res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws, res4x_br2c_ws,
+                                      res5x_br2c_ws, res5x_br2c_ws, res5x_br2c_ws };
+
+    Var c, i, j;
+
+    void generate() {
+        const int vec = natural_vector_size<int32_t>();
+
+        // Algorithm
+
+        Tensor br1_conv[4];
+        Tensor br2a_conv[16], br2a_relu[16];
+        Tensor br2b_conv[16], br2b_relu[16];
+        Tensor br2c_conv[16];
+        Tensor resunit_relu[16];
+
+        Tensor quantized_input;
+        quantized_input.f(c, i, j) = u8_sat(round(input(c, i, j) / input_scale));
+        quantized_input.shape = { 3, 224, 224 };
+        quantized_input.name = "quantized_input";
+
+        Tensor conv1 = conv2D(quantized_input, conv1_ws, conv1_weights, conv1_bias, "conv1");
+        Tensor relu1 = requantize_relu_layer(conv1, conv1_multiplier, conv1_shift, "relu1");
+        Tensor pool1 = max_pool_layer(relu1, pool1_ws, "pool1");
+
+        const int branch1_indices[4] = { 0, 3, 7, 13 };
+        int br1_i = 0;
+        for (int block_id = 0; block_id < 16; ++block_id) {
+            const std::string prefix = "block" + std::to_string(block_id);
+            const Tensor &block_input = block_id == 0 ? pool1 : resunit_relu[block_id - 1];
+
+            // branch2a
+            br2a_conv[block_id] = conv2D(block_input, br2a_ws[block_id], br2a_conv_weights[block_id],
+                                         br2a_bias[block_id], prefix + "_2a_conv");
+            br2a_relu[block_id] = requantize_relu_layer(br2a_conv[block_id], br2a_multiplier[block_id],
+                                                        br2a_shift[block_id], prefix + "_2a_relu");
+
+            // branch 2b
+            br2b_conv[block_id] = conv2D(br2a_relu[block_id], br2b_ws[block_id], br2b_conv_weights[block_id],
+                                         br2b_bias[block_id], prefix + "_2b_conv");
+            br2b_relu[block_id] = requantize_relu_layer(br2b_conv[block_id], br2b_multiplier[block_id],
+                                                        br2b_shift[block_id], prefix + "_2b_relu");
+
+            // branch 2c
+            br2c_conv[block_id] = conv2D(br2b_relu[block_id], br2c_ws[block_id], br2c_conv_weights[block_id],
+                                         br2c_bias[block_id], prefix + "_2c_conv");
+            Expr branch2 = multiply_quantized_multiplier_signed_shift(
+                br2c_conv[block_id].f(c, i, j), br2c_multiplier[block_id](c), br2c_shift[block_id](c));
+
+            // branch1 is either a convolution, or the input of the residual
+            // unit rescaled to the scale of its output.
+            Expr branch1;
+            if (br1_i < 4 && branch1_indices[br1_i] == block_id) {
+                br1_conv[br1_i] = conv2D(block_input, br1_ws[br1_i], br1_conv_weights[br1_i],
+                                         br1_bias[br1_i], prefix + "_br1_conv");
+                branch1 = multiply_quantized_multiplier_signed_shift(
+                    br1_conv[br1_i].f(c, i, j), br1_multiplier[br1_i](c), br1_shift[br1_i](c));
+                br1_i++;
+            } else {
+                branch1 = multiply_quantized_multiplier_signed_shift(
+                    i32(block_input.f(c, i, j)), shortcut_multiplier(block_id), shortcut_shift(block_id));
+            }
+
+            // create residual unit
+            Func res_relu(prefix + "_res_relu");
+            res_relu(c, i, j) = u8_sat(max(0, branch1 + branch2));
+            resunit_relu[block_id].f = res_relu;
+            resunit_relu[block_id].shape = br2c_conv[block_id].shape;
+            resunit_relu[block_id].name = res_relu.name();
+        }
+
+        // create final 3 layers
+        Tensor pool5 = avg_pool_layer(resunit_relu[15], pool5_ws, "pool5");
+        Tensor fc1000 = fc_layer(pool5, fc1000_ws, fc1000_weights, fc1000_bias, "fc");
+        final_output = softmax_layer(fc1000, 1000, "softmax");
+
+        // Schedule
+
+        // The input is quantized once, so that the first convolution
+        // doesn't quantize each input value 49 times.
+        quantized_input.f.compute_root();
+        schedule_conv(conv1, relu1.f, vec);
+        pool1.f.compute_root().vectorize(c, vec * 4).parallel(j);
+        for (int b = 0; b < 16; b++) {
+            schedule_conv(br2a_conv[b], br2a_relu[b].f, vec);
+            schedule_conv(br2b_conv[b], br2b_relu[b].f, vec);
+            // The requantization of both branches and the residual sum and
+            // ReLU are fused into the output of the residual unit.
+            schedule_conv(br2c_conv[b], resunit_relu[b].f, vec);
+        }
+        for (int b = 0; b < 4; b++) {
+            schedule_accumulator(br1_conv[b], resunit_relu[branch1_indices[b]].f, vec);
+        }
+        pool5.f.compute_root().vectorize(c, vec);
+        fc1000.f.compute_root().vectorize(c, vec, TailStrategy::GuardWithIf);
+        fc1000.f.update().vectorize(c, vec, TailStrategy::GuardWithIf);
+        final_output.compute_root();
+    }
+
+private:
+    // Compute f in vectors of output channels, with the rows of the output
+    // in parallel. A vector of channels is computed for a whole row, so
+    // the weights for those channels stay in cache.
+    void schedule_conv(const Tensor &conv, Func f, int vec) {
+        Var co("co");
+        f.compute_root()
+            .split(c, co, c, vec)
+            .reorder(c, i, co, j)
+            .vectorize(c)
+            .parallel(j);
+        schedule_accumulator(conv, f, vec);
+    }
+
+    // Compute the int32 accumulator of the convolution conv, which f
+    // consumes, for one vector of output channels of f at a time. The
+    // whole reduction is done for each vector, which keeps the
+    // accumulator in a register.
+    void schedule_accumulator(const Tensor &conv, Func f, int vec) {
+        Func acc = conv.f;
+        acc.compute_at(f, i).vectorize(c, vec);
+        acc.update()
+            .reorder(c, conv.r.x, conv.r.y, conv.r.z)
+            .vectorize(c, vec);
+    }
+
+    Func pad(Func f, Expr width, Expr height) {
+        std::vector<std::pair<Expr, Expr>> bounds(f.dimensions());
+        bounds[1].first = 0;
+        bounds[1].second = width;
+        bounds[2].first = 0;
+        bounds[2].second = height;
+        return Halide::BoundaryConditions::constant_exterior(f, cast(f.value().type(), 0), bounds);
+    }
+
+    std::vector<int> compute_shape(const Tensor &in, const WeightShape &params) {
+        int w = (1.0 / params.stride) * (params.pad * 2 + in.shape[1] - params.w + 1 + params.stride - 1);
+        int h = (1.0 / params.stride) * (params.pad * 2 + in.shape[2] - params.h + 1 + params.stride - 1);
+        int c = params.c;
+
+        return { c, w, h };
+    }
+
+    // The int32 accumulator of a convolution of uint8 activations with int8
+    // weights. The reduction over input channels is written as a sum of
+    // groups of four products, which is the form the x86 backend maps to
+    // the VNNI dot product instructions. Inputs with a number of channels that
+    // isn't a multiple of four are padded with zeros.
+    Tensor conv2D(const Tensor &input, const WeightShape &weight_shape, Func weights,
+                  const Func &bias, const std::string &name) {
+        const int in_channels = input.shape[0];
+        const int groups = (in_channels + 3) / 4;
+        int p = weight_shape.pad;
+        Func padded = input.f;
+        if (in_channels % 4 != 0) {
+            padded = Halide::BoundaryConditions::constant_exterior(
+                padded, cast<uint8_t>(0), { { 0, in_channels }, { Expr(), Expr() }, { Expr(), Expr() } });
+            weights = Halide::BoundaryConditions::constant_exterior(
+                weights, cast<int8_t>(0),
+                { { Expr(), Expr() }, { Expr(), Expr() }, { Expr(), Expr() }, { 0, in_channels } });
+        }
+        // pad input
+        if (p) {
+            padded = pad(padded, input.shape[1], input.shape[2]);
+        }
+        RDom r(0, groups, 0, weight_shape.w, 0, weight_shape.h);
+        Expr x = weight_shape.stride * i + r.y - p;
+        Expr y = weight_shape.stride * j + r.z - p;
+        Expr dot = 0;
+        for (int k = 0; k < 4; k++) {
+            dot += i32(weights(c, r.y, r.z, 4 * r.x + k)) * i32(padded(4 * r.x + k, x, y));
+        }
+        Func conv(name);
+        conv(c, i, j) = bias(c);
+        conv(c, i, j) += dot;
+
+        Tensor output;
+        output.f = conv;
+        output.name = name;
+        output.shape = compute_shape(input, weight_shape);
+        output.r = r;
+        return output;
+    }
+
+    // The batch norm and scale layers are folded into the weights and bias
+    // of the convolution, so all that's left is to requantize the
+    // accumulator to the scale of the output and apply the ReLU.
+    Tensor requantize_relu_layer(const Tensor &input, const Func &multiplier,
+                                 const Func &shift, const std::string &name) {
+        Func relu(name);
+        relu(c, i, j) = u8_sat(max(0, multiply_quantized_multiplier_signed_shift(
+                                          input.f(c, i, j), multiplier(c), shift(c))));
+        Tensor output;
+        output.f = relu;
+        output.shape = input.shape;
+        output.name = name;
+        return output;
+    }
+
+    // assumes input is 3D (c, w, h) where w and h = 1
+    Tensor fc_layer(const Tensor &input, const WeightShape &weight_shape, const Func &weights, const Func &bias, const std::string &name) {
+        RDom r(0, input.shape[0]);
+        Func fc;
+        fc(c) = bias(c);
+        fc(c) += weights(c, r.x) * input.f(r.x, 0, 0);
+
+        Tensor output;
+        output.f = fc;
+        output.name = name;
+        output.shape = compute_shape(input, weight_shape);
+
+        return output;
+    }
+
+    Tensor max_pool_layer(const Tensor &input, const WeightShape &weight_shape, const std::string &name) {
+        int p = weight_shape.pad;
+        Func padded;
+        if (p) {
+            padded = pad(input.f, input.shape[1], input.shape[2]);
+        } else {
+            padded = input.f;
+        }
+        RDom r(0, weight_shape.w, 0, weight_shape.h);
+        Func pool;
+        pool(c, i, j) = maximum(padded(c, weight_shape.stride * i + r.x - p, weight_shape.stride * j + r.y - p));
+        Tensor output;
+        output.f = pool;
+        output.name = name;
+        output.shape = compute_shape(input, weight_shape);
+
+        return output;
+    }
+
+    // Dequantizes the uint8 input to float.
+    Tensor avg_pool_layer(const Tensor &input, const WeightShape &weight_shape, const std::string &name) {
+        int p = weight_shape.pad;
+        Func padded;
+        if (p) {
+            padded = pad(input.f, input.shape[1], input.shape[2]);
+        } else {
+            padded = input.f;
+        }
+        RDom r(0, weight_shape.w, 0, weight_shape.h);
+        Expr n = features_scale / (weight_shape.w * weight_shape.h);
+        Func pool;
+        pool(c, i, j) = n * cast<float>(sum(i32(padded(c, weight_shape.stride * i + r.x - p, weight_shape.stride * j + r.y - p))));
+
+        Tensor output;
+        output.f = pool;
+        output.name = name;
+        output.shape = compute_shape(input, weight_shape);
+
+        return output;
+    }
+
+    Func softmax_layer(const Tensor &input, const int classes, const std::string &name) {
+        assert(input.shape[0] == classes);
+        RDom r(0, classes);
+        Func exp_vals;
+        exp_vals(c) = exp(input.f(c));
+        Func output("output");
+        output(c) = exp_vals(c) / sum(exp_vals(r.x));
+        return output;
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(Resnet50Int8Generator, resnet50_int8)
@@ -0,0 +1,224 @@
+#include "halide_benchmark.h"
+
+#include "resnet50_int8.h"
+
+#include "HalideBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+using namespace Halide::Runtime;
+using namespace Halide::Tools;
+
+#define unroll_array_of_16_buffers(buff_name) \
+    buff_name[0],                             \
+        buff_name[1],                         \
+        buff_name[2],                         \
+        buff_name[3],                         \
+        buff_name[4],                         \
+        buff_name[5],                         \
+        buff_name[6],                         \
+        buff_name[7],                         \
+        buff_name[8],                         \
+        buff_name[9],                         \
+        buff_name[10],                        \
+        buff_name[11],                        \
+        buff_name[12],                        \
+        buff_name[13],                        \
+        buff_name[14],                        \
+        buff_name[15]
+
+#define unroll_array_of_4_buffers(buff_name) buff_name[0], \
+                                             buff_name[1], \
+                                             buff_name[2], \
+                                             buff_name[3]
+
+std::vector<int> load_shape(const std::string &shapefile) {
+    std::ifstream infile(shapefile, std::ios::binary);
+    int num_dims = 0;
+    infile.read(reinterpret_cast<char *>(&num_dims), sizeof(int));
+    std::vector<int> dims(num_dims);
+    infile.read((char *) dims.data(), num_dims * sizeof(int));
+    infile.close();
+    assert(!infile.fail());
+    return dims;
+}
+
+void write_buffer_to_file(const Buffer<float> &buf, const std::string &filename) {
+    std::ofstream o(filename, std::ios_base::trunc | std::ios_base::binary);
+    o.write((const char *) (buf.data()), buf.size_in_bytes());
+    o.close();
+    assert(!o.fail());
+}
+
+// Load a tensor written by load_weights.py or quantize_weights.py, given the
+// path of its data without the .data suffix.
+template<typename T>
+Buffer<T> load_tensor(const std::string &path, int dimensions) {
+    std::vector<int> shape = load_shape(path + "_shape.data");
+    assert((int) shape.size() == dimensions);
+    Buffer<T> buffer(shape);
+    std::ifstream infile(path + ".data", std::ios::binary);
+    infile.read((char *) buffer.data(), buffer.size_in_bytes());
+    infile.close();
+    assert(!infile.fail());
+    return buffer;
+}
+
+// The quantized weights and requantization parameters of one convolution.
+struct QuantizedConv {
+    Buffer<int8_t> weights;
+    Buffer<int32_t> bias, multiplier, shift;
+
+    void load(const std::string &path) {
+        weights = load_tensor<int8_t>(path + "_int8_weight", 4);
+        bias = load_tensor<int32_t>(path + "_int8_bias", 1);
+        multiplier = load_tensor<int32_t>(path + "_int8_multiplier", 1);
+        shift = load_tensor<int32_t>(path + "_int8_shift", 1);
+    }
+};
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        printf("Usage: iterations weight_dir seed output_file [float_output_file]");
+        return -1;
+    }
+    int iterations = atoi(argv[1]);
+    std::string weight_dir = argv[2];
+    int seed = atoi(argv[3]);
+    std::string output_file = argv[4];
+
+    Buffer<float> input(3, 224, 224);
+    Buffer<float> output(1000);
+
+    std::string layer_names[16] = { "layer1_0", "layer1_1", "layer1_2",
+                                    "layer2_0", "layer2_1", "layer2_2", "layer2_3",
+                                    "layer3_0", "layer3_1", "layer3_2", "layer3_3", "layer3_4", "layer3_5",
+                                    "layer4_0", "layer4_1", "layer4_2" };
+
+    std::string br1_names[4] = { "layer1_0_downsample", "layer2_0_downsample", "layer3_0_downsample", "layer4_0_downsample" };
+
+    QuantizedConv conv1, br1[4], br2a[16], br2b[16], br2c[16];
+    conv1.load(weight_dir + "conv1");
+    for (int i = 0; i < 4; i++) {
+        br1[i].load(weight_dir + br1_names[i] + "_0");
+    }
+    for (int i = 0; i < 16; i++) {
+        br2a[i].load(weight_dir + layer_names[i] + "_conv1");
+        br2b[i].load(weight_dir + layer_names[i] + "_conv2");
+        br2c[i].load(weight_dir + layer_names[i] + "_conv3");
+    }
+
+    Buffer<int8_t> br1_weights[4], br2a_weights[16], br2b_weights[16], br2c_weights[16];
+    Buffer<int32_t> br1_bias[4], br2a_bias[16], br2b_bias[16], br2c_bias[16];
+    Buffer<int32_t> br1_multiplier[4], br2a_multiplier[16], br2b_multiplier[16], br2c_multiplier[16];
+    Buffer<int32_t> br1_shift[4], br2a_shift[16], br2b_shift[16], br2c_shift[16];
+    for (int i = 0; i < 4; i++) {
+        br1_weights[i] = br1[i].weights;
+        br1_bias[i] = br1[i].bias;
+        br1_multiplier[i] = br1[i].multiplier;
+        br1_shift[i] = br1[i].shift;
+    }
+    for (int i = 0; i < 16; i++) {
+        br2a_weights[i] = br2a[i].weights;
+        br2a_bias[i] = br2a[i].bias;
+        br2a_multiplier[i] = br2a[i].multiplier;
+        br2a_shift[i] = br2a[i].shift;
+        br2b_weights[i] = br2b[i].weights;
+        br2b_bias[i] = br2b[i].bias;
+        br2b_multiplier[i] = br2b[i].multiplier;
+        br2b_shift[i] = br2b[i].shift;
+        br2c_weights[i] = br2c[i].weights;
+        br2c_bias[i] = br2c[i].bias;
+        br2c_multiplier[i] = br2c[i].multiplier;
+        br2c_shift[i] = br2c[i].shift;
+    }
+
+    Buffer<int32_t> shortcut_multiplier = load_tensor<int32_t>(weight_dir + "shortcut_int8_multiplier", 1);
+    Buffer<int32_t> shortcut_shift = load_tensor<int32_t>(weight_dir + "shortcut_int8_shift", 1);
+    Buffer<float> scales = load_tensor<float>(weight_dir + "int8_scales", 1);
+
+    Buffer<float> fc1000_weights = load_tensor<float>(weight_dir + "fc_weight", 2);
+    Buffer<float> fc1000_bias = load_tensor<float>(weight_dir + "fc_bias", 1);
+
+    // The same input that process.cpp uses for this seed.
+    std::mt19937 e2(seed);
+    input.for_each_value([&e2](float &v) {
+        v = e2() / (float) e2.max();
+    });
+    printf("Running int8 Resnet50 for %d iterations....\n", iterations);
+    double best = benchmark(iterations, 1, [&]() {
+        resnet50_int8(input,
+                      scales(0),
+                      scales(1),
+                      conv1.weights,
+                      conv1.bias,
+                      conv1.multiplier,
+                      conv1.shift,
+                      unroll_array_of_4_buffers(br1_weights),
+                      unroll_array_of_4_buffers(br1_bias),
+                      unroll_array_of_4_buffers(br1_multiplier),
+                      unroll_array_of_4_buffers(br1_shift),
+                      unroll_array_of_16_buffers(br2a_weights),
+                      unroll_array_of_16_buffers(br2a_bias),
+                      unroll_array_of_16_buffers(br2a_multiplier),
+                      unroll_array_of_16_buffers(br2a_shift),
+                      unroll_array_of_16_buffers(br2b_weights),
+                      unroll_array_of_16_buffers(br2b_bias),
+                      unroll_array_of_16_buffers(br2b_multiplier),
+                      unroll_array_of_16_buffers(br2b_shift),
+                      unroll_array_of_16_buffers(br2c_weights),
+                      unroll_array_of_16_buffers(br2c_bias),
+                      unroll_array_of_16_buffers(br2c_multiplier),
+                      unroll_array_of_16_buffers(br2c_shift),
+                      shortcut_multiplier,
+                      shortcut_shift,
+                      fc1000_weights,
+                      fc1000_bias,
+                      output);
+    });
+    printf("Execution time : %gms \n", best * 1e3);
+
+    int max_class = 0;
+    for (int i = 1; i < 1000; ++i) {
+        if (output(i) > output(max_class)) {
+            max_class = i;
+        }
+    }
+    printf("Class for random data of seed %d is %d\n", seed, max_class);
+
+    printf("Writing output layer to %s\n", output_file.c_str());
+    write_buffer_to_file(output, output_file);
+
+    // Compare against the output of the float pipeline, if we have it.
+    if (argc > 5) {
+        Buffer<float> ref(1000);
+        std::ifstream infile(argv[5], std::ios::binary);
+        infile.read((char *) ref.data(), ref.size_in_bytes());
+        if (infile.fail()) {
+            printf("Could not read float output from %s\n", argv[5]);
+            return -1;
+        }
+        int ref_class = 0;
+        float max_diff = 0.0f;
+        for (int i = 0; i < 1000; ++i) {
+            if (ref(i) > ref(ref_class)) {
+                ref_class = i;
+            }
+            max_diff = std::max(max_diff, std::abs(output(i) - ref(i)));
+        }
+        printf("Class from float pipeline is %d, max difference in output is %g\n", ref_class, max_diff);
+        if (ref_class != max_class) {
+            printf("int8 and float pipelines disagree on the class\n");
+            return -1;
+        }
+    }
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+import numpy as np
+import torch
+import torchvision.models.resnet as resnet
+import struct
+import os
+import sys
+
+# Quantizes the pretrained resnet50 weights for the resnet50_int8 generator.
+#
+# Each batch norm is folded into the weights and bias of the convolution
+# before it, and the weights are quantized to int8 with a scale per output
+# channel. Activations are quantized to uint8 with a scale per tensor,
+# calibrated from the largest value each one takes over a batch of random
+# inputs like the ones process.cpp uses.
+
+num_calibration_images = 16
+
+
+def write_tensor(dir, name, tensor):
+    # Same format as load_weights.py: the data, and the shape with the
+    # innermost dimension first.
+    path = os.path.join(dir, name)
+    with open(path + ".data", "wb") as f:
+        f.write(tensor.tobytes())
+    with open(path + "_shape.data", "wb") as f:
+        f.write(struct.pack('i', len(tensor.shape)))
+        for i in list(reversed(range(len(tensor.shape)))):
+            f.write(struct.pack('i', tensor.shape[i]))
+
+
+def quantize_multiplier(m):
+    # Represent a positive real multiplier as an int32 multiplier in
+    # [2^30, 2^31) and a shift, such that m = multiplier * 2^(-31 - shift).
+    m = np.asarray(m, dtype=np.float64)
+    mantissa, exponent = np.frexp(m)
+    multiplier = np.round(mantissa * (1 << 31)).astype(np.int64)
+    # Rounding can push the mantissa up to 1.0.
+    overflow = multiplier == (1 << 31)
+    multiplier[overflow] //= 2
+    exponent[overflow] += 1
+    return multiplier.astype(np.int32), (-exponent).astype(np.int32)
+
+
+def activation_scale(max_value):
+    return max(float(max_value), 1e-6) / 255.0
+
+
+def quantize_conv(dir, name, conv, bn, input_scale, output_scale):
+    weight = conv.weight.detach().numpy().astype(np.float64)
+    gamma = bn.weight.detach().numpy().astype(np.float64)
+    beta = bn.bias.detach().numpy().astype(np.float64)
+    mu = bn.running_mean.detach().numpy().astype(np.float64)
+    var = bn.running_var.detach().numpy().astype(np.float64)
+
+    # Fold the batch norm into the convolution.
+    a = gamma / np.sqrt(var + bn.eps)
+    weight = weight * a.reshape(-1, 1, 1, 1)
+    bias = beta - mu * a
+
+    weight_scale = np.abs(weight).reshape(weight.shape[0], -1).max(axis=1) / 127.0
+    weight_scale[weight_scale == 0] = 1.0
+    q_weight = np.clip(np.round(weight / weight_scale.reshape(-1, 1, 1, 1)), -127, 127).astype(np.int8)
+    # Transpose to output channel, h, w, input channel order, as in
+    # load_weights.py.
+    q_weight = np.transpose(q_weight, (1, 2, 3, 0)).copy()
+
+    accumulator_scale = input_scale * weight_scale
+    q_bias = np.clip(np.round(bias / accumulator_scale), -2**31, 2**31 - 1).astype(np.int32)
+    multiplier, shift = quantize_multiplier(accumulator_scale / output_scale)
+
+    write_tensor(dir, name + "_int8_weight", q_weight)
+    write_tensor(dir, name + "_int8_bias", q_bias)
+    write_tensor(dir, name + "_int8_multiplier", multiplier)
+    write_tensor(dir, name + "_int8_shift", shift)
+
+
+def quantize_weights(dir):
+    if not os.path.isdir(dir):
+        print("Path %s is not a dir" % dir)
+        sys.exit(1)
+
+    print("-----------quantizing weights------------")
+    net = resnet.resnet50(pretrained=True)
+    net.eval()
+
+    # Record the largest value of each activation that gets quantized.
+    max_values = {}
+
+    def record(name):
+        def hook(module, inputs, output):
+            max_values[name] = max(max_values.get(name, 0.0), float(output.max()))
+        return hook
+
+    blocks = [b for layer in [net.layer1, net.layer2, net.layer3, net.layer4] for b in layer]
+    hooks = [net.maxpool.register_forward_hook(record("pool1"))]
+    for i, b in enumerate(blocks):
+        # The ReLUs are shared within a block, so record the batch norms
+        # before them, and clamp at zero below.
+        hooks.append(b.bn1.register_forward_hook(record("block%d_2a" % i)))
+        hooks.append(b.bn2.register_forward_hook(record("block%d_2b" % i)))
+        hooks.append(b.register_forward_hook(record("block%d_out" % i)))
+
+    np.random.seed(0)
+    images = np.random.rand(num_calibration_images, 224, 224, 3).astype(np.float32)
+    images = images.transpose(0, 3, 1, 2)
+    with torch.no_grad():
+        net(torch.from_numpy(images))
+    for h in hooks:
+        h.remove()
+
+    input_scale = activation_scale(images.max())
+    pool1_scale = activation_scale(max_values["pool1"])
+    quantize_conv(dir, "conv1", net.conv1, net.bn1, input_scale, pool1_scale)
+
+    layer_names = ["layer1_0", "layer1_1", "layer1_2",
+                   "layer2_0", "layer2_1", "layer2_2", "layer2_3",
+                   "layer3_0", "layer3_1", "layer3_2", "layer3_3", "layer3_4", "layer3_5",
+                   "layer4_0", "layer4_1", "layer4_2"]
+
+    shortcut_multiplier = np.zeros(16, dtype=np.int32)
+    shortcut_shift = np.zeros(16, dtype=np.int32)
+    block_input_scale = pool1_scale
+    for i, b in enumerate(blocks):
+        scale_2a = activation_scale(max_values["block%d_2a" % i])
+        scale_2b = activation_scale(max_values["block%d_2b" % i])
+        out_scale = activation_scale(max_values["block%d_out" % i])
+        name = layer_names[i]
+        quantize_conv(dir, name + "_conv1", b.conv1, b.bn1, block_input_scale, scale_2a)
+        quantize_conv(dir, name + "_conv2", b.conv2, b.bn2, scale_2a, scale_2b)
+        quantize_conv(dir, name + "_conv3", b.conv3, b.bn3, scale_2b, out_scale)
+        if b.downsample is not None:
+            quantize_conv(dir, name + "_downsample_0", b.downsample[0], b.downsample[1],
+                          block_input_scale, out_scale)
+        else:
+            m, s = quantize_multiplier([block_input_scale / out_scale])
+            shortcut_multiplier[i] = m[0]
+            shortcut_shift[i] = s[0]
+        block_input_scale = out_scale
+
+    write_tensor(dir, "shortcut_int8_multiplier", shortcut_multiplier)
+    write_tensor(dir, "shortcut_int8_shift", shortcut_shift)
+    # The scale of the input, and of the input to the final average pooling.
+    write_tensor(dir, "int8_scales", np.array([input_scale, block_input_scale], dtype=np.float32))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("Usage: quantize_weights destdir")
+        sys.exit(1)
+    quantize_weights(sys.argv[1])
@@ -0,0 +1,70 @@
+"""Compare two files of RunGen --json_output benchmark results.
+
+Usage: compare_benchmarks.py baseline.jsonl results.jsonl [tolerance]
+
+Each line of the files is a JSON object as produced by RunGen's
+--json_output. Results are matched by pipeline name, target, thread
+count and cache mode, and compared by median time per iteration. A
+result whose median is more than (1 + tolerance) times the baseline's
+(tolerance defaults to 0.1) is reported as a regression, and the
+script exits with status 1 if there are any.
+"""
+
+import json
+import sys
+
+
+def load_results(filename):
+    results = {}
+    with open(filename) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            r = json.loads(line)
+            if "median_msec" not in r:
+                continue
+            key = (r["name"], r["target"], r.get("num_threads", 0), r.get("cache", "warm"))
+            results[key] = r
+    return results
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        print(__doc__)
+        sys.exit(2)
+
+    baseline = load_results(sys.argv[1])
+    results = load_results(sys.argv[2])
+    tolerance = float(sys.argv[3]) if len(sys.argv) == 4 else 0.1
+
+    regressions = 0
+    print("%-40s %12s %12s %8s" % ("pipeline", "baseline ms", "current ms", "change"))
+    for key in sorted(results):
+        name = key[0]
+        if key[2]:
+            name += " (%d threads)" % key[2]
+        if key[3] != "warm":
+            name += " (%s cache)" % key[3]
+        current = results[key]["median_msec"]
+        if key not in baseline:
+            print("%-40s %12s %12.4f %8s" % (name, "-", current, "new"))
+            continue
+        base = baseline[key]["median_msec"]
+        change = current / base - 1.0 if base > 0 else 0.0
+        flag = ""
+        if change > tolerance:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-40s %12.4f %12.4f %+7.1f%%%s" % (name, base, current, change * 100, flag))
+
+    for key in sorted(set(baseline) - set(results)):
+        print("%-40s %12.4f %12s %8s" % (key[0], baseline[key]["median_msec"], "-", "missing"))
+
+    if regressions:
+        print("%d regression(s) of more than %.0f%%" % (regressions, tolerance * 100))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+"""Sweep a scalar input of a pipeline with RunGen, and report the fastest.
+
+Usage: sweep_rungen.py PARAM VALUES -- RUNGEN_COMMAND...
+
+PARAM is the name of a scalar input of the pipeline, and VALUES is a
+comma-separated list of values to try, or a range MIN:MAX[:STEP]. The
+RunGen command (including the pipeline's other inputs) is run once per
+value, with PARAM=VALUE, --benchmarks=all and --json_output appended.
+
+This is useful for tuning schedule parameters that are exposed as
+inputs, such as the offset passed to Func::prefetch. For example:
+
+    sweep_rungen.py prefetch_offset 1:16 -- ./bin/host/blur.rungen \\
+        input=input.png --output_extents=[1536,2560]
+
+Each result is printed, then the value with the smallest median time
+per iteration.
+"""
+
+import json
+import subprocess
+import sys
+
+
+def parse_values(s):
+    if ":" in s:
+        r = [int(v) for v in s.split(":")]
+        step = r[2] if len(r) > 2 else 1
+        return [str(v) for v in range(r[0], r[1] + 1, step)]
+    return s.split(",")
+
+
+def run(command, param, value):
+    args = command + ["%s=%s" % (param, value), "--benchmarks=all", "--json_output"]
+    output = subprocess.check_output(args, universal_newlines=True)
+    for line in output.splitlines():
+        line = line.strip()
+        if not line.startswith("{"):
+            continue
+        r = json.loads(line)
+        if "median_msec" in r:
+            return r["median_msec"]
+    raise RuntimeError("No benchmark results from: %s" % " ".join(args))
+
+
+def main():
+    if len(sys.argv) < 5 or sys.argv[3] != "--":
+        print(__doc__)
+        sys.exit(2)
+
+    param = sys.argv[1]
+    values = parse_values(sys.argv[2])
+    command = sys.argv[4:]
+
+    best = None
+    print("%-20s %12s" % (param, "median ms"))
+    for value in values:
+        t = run(command, param, value)
+        print("%-20s %12.4f" % (value, t))
+        if best is None or t < best[1]:
+            best = (value, t)
+
+    print("Best: %s=%s (%.4f ms)" % (param, best[0], best[1]))
+
+
+if __name__ == "__main__":
+    main()
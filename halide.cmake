@@ -415,7 +415,7 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
   _halide_split_target("${HALIDE_TARGET}" BASE FEATURES)
   # Discard target features which do not affect the contents of the runtime.
   list(REMOVE_DUPLICATES FEATURES)
-  list(REMOVE_ITEM FEATURES "user_context" "no_asserts" "no_bounds_query" "no_runtime" "profile")
+  list(REMOVE_ITEM FEATURES "user_context" "no_asserts" "no_bounds_query" "trusted_entry" "auto_async" "no_runtime" "profile" "profile_by_stage" "profile_branches")
   list(SORT FEATURES)
   # Now build up the name
   set(RESULT "halide_rt")
@@ -440,6 +440,7 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         debug
         no_asserts
         no_bounds_query
+        trusted_entry
         sse41
         avx
         avx2
@@ -456,6 +457,8 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         cuda_capability_35
         cuda_capability_50
         cuda_capability_61
+        cuda_capability_70
+        cuda_capability_80
         opencl
         cl_doubles
         cl_half
@@ -474,6 +477,9 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         hvx_v62
         hvx_v65
         hvx_v66
+        hvx_v68
+        hvx_v69
+        hvx_auto_vtcm
         hvx_shared_object
         fuzz_float_stores
         soft_float_abi
@@ -497,6 +503,29 @@ function(_halide_runtime_target_name HALIDE_TARGET OUTVAR)
         disable_llvm_loop_unroll
         wasm_simd128
         wasm_signext
+        arena_alloc
+        cuda_cubin
+        avx512_vnni
+        avx512_bf16
+        arm_dot_prod
+        arm_fp16
+        sve
+        sve2
+        rvv
+        wasm_threads
+        metal_lib
+        auto_async
+        profile_by_stage
+        profile_branches
+        vulkan
+        webgpu
+        power_arch_3_00
+        power_arch_3_1
+        avx512_sapphirerapids
+        check_aliasing
+        cache_bounds_checks
+        share_allocations
+        reuse_producer_storage
       )
     # Synthesize a one-or-two-char abbreviation based on the feature's position
     # in the KNOWN_FEATURES list.
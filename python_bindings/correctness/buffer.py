@@ -240,6 +240,48 @@ def test_overflow():
     except ValueError as e:
         assert 'Out of range arguments to make_dim_vec.' in str(e)
 
+def test_strided_ndarray():
+    a = np.arange(20 * 30, dtype=np.int32).reshape((20, 30))
+
+    # Strided and reversed views are wrapped without copying.
+    view = a[2:18:3, ::-2]
+    b = hl.Buffer(view)
+    assert b.dim(0).extent() == view.shape[0]
+    assert b.dim(0).stride() == 3 * 30
+    assert b.dim(1).extent() == view.shape[1]
+    assert b.dim(1).stride() == -2
+    for i in range(view.shape[0]):
+        for j in range(view.shape[1]):
+            assert b[i, j] == view[i, j]
+
+    b[1, 1] = -1
+    assert a[5, 27] == -1
+
+def test_realize_from_threads():
+    import threading
+
+    x = hl.Var("x")
+    f = hl.Func("f")
+    f[x] = x * 2
+    f.compile_jit()
+
+    errors = []
+    def run():
+        try:
+            for _ in range(10):
+                out = hl.Buffer(hl.Int(32), [1000])
+                f.realize(out)
+                assert out[999] == 1998
+        except Exception as e:
+            errors.append(e)
+
+    threads = [threading.Thread(target=run) for _ in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert not errors, errors
+
 if __name__ == "__main__":
     test_make_interleaved()
     test_interleaved_ndarray()
@@ -252,3 +294,5 @@ if __name__ == "__main__":
     test_int64()
     test_reorder()
     test_overflow()
+    test_strided_ndarray()
+    test_realize_from_threads()
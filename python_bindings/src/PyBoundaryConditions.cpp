@@ -135,6 +135,8 @@ void define_boundary_conditions(py::module &m) {
         return Func();
     }, py::arg("f"), py::arg("bounds"));
 
+    // ----- padded
+    bc.def("padded", &padded, py::arg("f"), py::arg("at") = LoopLevel::root());
 }
 
 }  // namespace PythonBindings
@@ -162,6 +162,87 @@ Type format_descriptor_to_type(const std::string &fd) {
     return Type();
 }
 
+// Convert the typestr of an __array_interface__ or
+// __cuda_array_interface__ (e.g. "<f4") to a Type.
+Type typestr_to_type(const std::string &typestr) {
+    if (typestr.size() < 3 || (typestr[0] != '<' && typestr[0] != '|')) {
+        throw py::value_error("Unsupported array type string: " + typestr);
+    }
+    const int bits = std::atoi(typestr.c_str() + 2) * 8;
+    switch (typestr[1]) {
+    case 'b':
+        if (bits == 8) return Bool();
+        break;
+    case 'i':
+        if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return Int(bits);
+        break;
+    case 'u':
+        if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return UInt(bits);
+        break;
+    case 'f':
+        if (bits == 16 || bits == 32 || bits == 64) return Float(bits);
+        break;
+    }
+    throw py::value_error("Unsupported array type string: " + typestr);
+    return Type();
+}
+
+// Make the dimensions of a Buffer from a shape and strides in bytes,
+// in the same order.
+std::vector<halide_dimension_t> make_dims(const Type &t,
+                                          const std::vector<ssize_t> &shape,
+                                          const std::vector<ssize_t> &strides) {
+    std::vector<halide_dimension_t> dims;
+    dims.reserve(shape.size());
+    for (size_t i = 0; i < shape.size(); i++) {
+        if (strides[i] % t.bytes() != 0) {
+            throw py::value_error("Strides must be a multiple of the element size.");
+        }
+        const ssize_t stride = strides[i] / t.bytes();
+        if (INT_MAX < shape[i] || INT_MAX < stride || stride < INT_MIN) {
+            throw py::value_error("Out of range arguments to make_dim_vec.");
+        }
+        dims.push_back({0, (int32_t) shape[i], (int32_t) stride});
+    }
+    return dims;
+}
+
+// Make a Buffer that refers to the device memory of an object that
+// exposes __cuda_array_interface__ (e.g. a CuPy array, or a Numba or
+// PyTorch CUDA array), without copying it.
+Buffer<> buffer_from_cuda_array_interface(const py::object &obj, const std::string &name, const Target &target) {
+    if (!py::hasattr(obj, "__cuda_array_interface__")) {
+        throw py::value_error("Object does not have a __cuda_array_interface__.");
+    }
+    py::dict iface = obj.attr("__cuda_array_interface__");
+    if (iface.contains("mask") && !iface["mask"].is_none()) {
+        throw py::value_error("Masked CUDA arrays are not supported.");
+    }
+
+    const Type t = typestr_to_type(iface["typestr"].cast<std::string>());
+    const std::vector<ssize_t> shape = iface["shape"].cast<std::vector<ssize_t>>();
+    std::vector<ssize_t> strides;
+    if (iface.contains("strides") && !iface["strides"].is_none()) {
+        strides = iface["strides"].cast<std::vector<ssize_t>>();
+    } else {
+        // The array is C-contiguous.
+        strides.resize(shape.size());
+        ssize_t stride = t.bytes();
+        for (size_t i = shape.size(); i > 0; i--) {
+            strides[i - 1] = stride;
+            stride *= shape[i - 1];
+        }
+    }
+    const uintptr_t ptr = iface["data"].cast<py::tuple>()[0].cast<uintptr_t>();
+
+    const std::vector<halide_dimension_t> dims = make_dims(t, shape, strides);
+    Buffer<> b(t, nullptr, (int) dims.size(), dims.data(), name);
+    if (b.device_wrap_native(DeviceAPI::CUDA, (uint64_t) ptr, target) != 0) {
+        throw py::value_error("Could not wrap the CUDA device pointer.");
+    }
+    b.set_device_dirty();
+    return b;
+}
 
 py::object buffer_getitem_operator(Buffer<> &buf, const std::vector<int> &pos) {
     if ((size_t) pos.size() != (size_t) buf.dimensions()) {
@@ -227,16 +308,9 @@ class PyBuffer : public Buffer<> {
     py::buffer_info info;
 
     static std::vector<halide_dimension_t> make_dim_vec(const py::buffer_info &info) {
-        const Type t = format_descriptor_to_type(info.format);
-        std::vector<halide_dimension_t> dims;
-        dims.reserve(info.ndim);
-        for (int i = 0; i < info.ndim; i++) {
-            if (INT_MAX < info.shape[i] || INT_MAX < (info.strides[i] / t.bytes())) {
-                throw py::value_error("Out of range arguments to make_dim_vec.");
-            }
-            dims.push_back({0, (int32_t) info.shape[i], (int32_t) (info.strides[i] / t.bytes())});
-        }
-        return dims;
+        // Any strides are fine (including negative ones), so strided
+        // views are wrapped without copying.
+        return make_dims(format_descriptor_to_type(info.format), info.shape, info.strides);
     }
 
     PyBuffer(py::buffer_info &&info, const std::string &name)
@@ -330,6 +404,12 @@ void define_buffer(py::module &m) {
             return Buffer<>::make_with_shape_of(buffer, nullptr, nullptr, name);
         }, py::arg("src"), py::arg("name") = "")
 
+        // Wrap GPU memory of another library without copying it. The
+        // result has no host allocation, and keeps the object alive.
+        .def_static("from_cuda_array_interface", &buffer_from_cuda_array_interface,
+            py::arg("array"), py::arg("name") = "", py::arg("target") = get_jit_target_from_environment(),
+            py::keep_alive<0, 1>())
+
         .def("set_name", &Buffer<>::set_name)
         .def("name", &Buffer<>::name)
 
@@ -31,6 +31,13 @@ void define_derivative(py::module &m) {
         (Derivative (*)(const Func &, const Buffer<float> &))&propagate_adjoints);
     m.def("propagate_adjoints",
         (Derivative (*)(const Func &))&propagate_adjoints);
+    m.def("schedule_checkpoints",
+        (void (*)(const Func &, const std::vector<Func> &))&schedule_checkpoints,
+        py::arg("output"), py::arg("stored"));
+    m.def("schedule_checkpoints",
+        (std::vector<Func> (*)(const Func &))&schedule_checkpoints,
+        py::arg("output"));
+    m.def("parallelize_scatters", &parallelize_scatters, py::arg("derivative"));
 }
 
 }  // namespace PythonBindings
@@ -89,6 +89,7 @@ void define_enums(py::module &m) {
         .value("Debug", Target::Feature::Debug)
         .value("NoAsserts", Target::Feature::NoAsserts)
         .value("NoBoundsQuery", Target::Feature::NoBoundsQuery)
+        .value("TrustedEntry", Target::Feature::TrustedEntry)
         .value("SSE41", Target::Feature::SSE41)
         .value("AVX", Target::Feature::AVX)
         .value("AVX2", Target::Feature::AVX2)
@@ -105,6 +106,8 @@ void define_enums(py::module &m) {
         .value("CUDACapability35", Target::Feature::CUDACapability35)
         .value("CUDACapability50", Target::Feature::CUDACapability50)
         .value("CUDACapability61", Target::Feature::CUDACapability61)
+        .value("CUDACapability70", Target::Feature::CUDACapability70)
+        .value("CUDACapability80", Target::Feature::CUDACapability80)
         .value("OpenCL", Target::Feature::OpenCL)
         .value("CLDoubles", Target::Feature::CLDoubles)
         .value("CLHalf", Target::Feature::CLHalf)
@@ -123,6 +126,9 @@ void define_enums(py::module &m) {
         .value("HVX_v62", Target::Feature::HVX_v62)
         .value("HVX_v65", Target::Feature::HVX_v65)
         .value("HVX_v66", Target::Feature::HVX_v66)
+        .value("HVX_v68", Target::Feature::HVX_v68)
+        .value("HVX_v69", Target::Feature::HVX_v69)
+        .value("HVX_AutoVTCM", Target::Feature::HVX_AutoVTCM)
         .value("HVX_shared_object", Target::Feature::HVX_shared_object)
         .value("FuzzFloatStores", Target::Feature::FuzzFloatStores)
         .value("SoftFloatABI", Target::Feature::SoftFloatABI)
@@ -146,6 +152,29 @@ void define_enums(py::module &m) {
         .value("DisableLLVMLoopUnroll", Target::Feature::DisableLLVMLoopUnroll)
         .value("WasmSimd128", Target::Feature::WasmSimd128)
         .value("WasmSignExt", Target::Feature::WasmSignExt)
+        .value("ArenaAlloc", Target::Feature::ArenaAlloc)
+        .value("CUDACubin", Target::Feature::CUDACubin)
+        .value("AVX512_VNNI", Target::Feature::AVX512_VNNI)
+        .value("AVX512_BF16", Target::Feature::AVX512_BF16)
+        .value("ARMDotProd", Target::Feature::ARMDotProd)
+        .value("ARMFp16", Target::Feature::ARMFp16)
+        .value("SVE", Target::Feature::SVE)
+        .value("SVE2", Target::Feature::SVE2)
+        .value("RVV", Target::Feature::RVV)
+        .value("WasmThreads", Target::Feature::WasmThreads)
+        .value("MetalLib", Target::Feature::MetalLib)
+        .value("AutoAsync", Target::Feature::AutoAsync)
+        .value("ProfileByStage", Target::Feature::ProfileByStage)
+        .value("ProfileBranches", Target::Feature::ProfileBranches)
+        .value("Vulkan", Target::Feature::Vulkan)
+        .value("WebGPU", Target::Feature::WebGPU)
+        .value("POWER_ARCH_3_00", Target::Feature::POWER_ARCH_3_00)
+        .value("POWER_ARCH_3_1", Target::Feature::POWER_ARCH_3_1)
+        .value("AVX512_SapphireRapids", Target::Feature::AVX512_SapphireRapids)
+        .value("CheckAliasing", Target::Feature::CheckAliasing)
+        .value("CacheBoundsChecks", Target::Feature::CacheBoundsChecks)
+        .value("ShareAllocations", Target::Feature::ShareAllocations)
+        .value("ReuseProducerStorage", Target::Feature::ReuseProducerStorage)
         .value("FeatureEnd", Target::Feature::FeatureEnd);
 
     py::enum_<halide_type_code_t>(m, "TypeCode")
@@ -5,6 +5,7 @@
 #include "PyExpr.h"
 #include "PyFuncRef.h"
 #include "PyLoopLevel.h"
+#include "PyPipeline.h"
 #include "PyScheduleMethods.h"
 #include "PyStage.h"
 #include "PyTuple.h"
@@ -83,36 +84,36 @@ void define_func(py::module &m) {
         .def(py::init([](const ImageParam &im) -> Func { return im; }))
 
         .def("realize", [](Func &f, Buffer<> buffer, const Target &target, const ParamMap &param_map) -> void {
-            f.realize(buffer, target);
+            realize_without_gil(f.pipeline(), Realization(buffer), target, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // This will actually allow a list-of-buffers as well as a tuple-of-buffers, but that's OK.
         .def("realize", [](Func &f, std::vector<Buffer<>> buffers, const Target &t, const ParamMap &param_map) -> void {
-            f.realize(Realization(buffers), t);
+            realize_without_gil(f.pipeline(), Realization(buffers), t, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("realize", [](Func &f, std::vector<int32_t> sizes, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(sizes, target, param_map));
+            return realization_to_object(realize_without_gil(f.pipeline(), sizes, target, param_map));
         }, py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, target, param_map));
+            return realization_to_object(realize_without_gil(f.pipeline(), {x_size}, target, param_map));
         }, py::arg("x_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, target, param_map));
+            return realization_to_object(realize_without_gil(f.pipeline(), {x_size, y_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, int z_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, z_size, target, param_map));
+            return realization_to_object(realize_without_gil(f.pipeline(), {x_size, y_size, z_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Func &f, int x_size, int y_size, int z_size, int w_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(f.realize(x_size, y_size, z_size, w_size, target, param_map));
+            return realization_to_object(realize_without_gil(f.pipeline(), {x_size, y_size, z_size, w_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("defined", &Func::defined)
@@ -149,10 +150,20 @@ void define_func(py::module &m) {
         .def("store_at", (Func &(Func::*)(LoopLevel)) &Func::store_at,
             py::arg("loop_level"))
 
+        .def("hoist_storage", (Func &(Func::*)(Func, Var)) &Func::hoist_storage,
+            py::arg("f"), py::arg("var"))
+        .def("hoist_storage", (Func &(Func::*)(Func, RVar)) &Func::hoist_storage,
+            py::arg("f"), py::arg("var"))
+        .def("hoist_storage", (Func &(Func::*)(LoopLevel)) &Func::hoist_storage,
+            py::arg("loop_level"))
+
         .def("memoize", &Func::memoize)
+        .def("carry_loads", &Func::carry_loads)
+        .def("store_tuple_interleaved", &Func::store_tuple_interleaved)
         .def("compute_inline", &Func::compute_inline)
         .def("compute_root", &Func::compute_root)
         .def("store_root", &Func::store_root)
+        .def("hoist_storage_root", &Func::hoist_storage_root)
 
         .def("store_in", &Func::store_in,
             py::arg("memory_type"))
@@ -284,9 +295,13 @@ void define_func(py::module &m) {
         .def("clone_in", (Func (Func::*)(const Func &)) &Func::clone_in, py::arg("f"))
         .def("clone_in", (Func (Func::*)(const std::vector<Func> &fs)) &Func::clone_in, py::arg("fs"))
 
+        .def("stage_in_gpu_shared", &Func::stage_in_gpu_shared, py::arg("consumer"), py::arg("block_var"))
+
         .def("copy_to_device", &Func::copy_to_device,
             py::arg("device_api") = DeviceAPI::Default_GPU)
         .def("copy_to_host", &Func::copy_to_host)
+        .def("hexagon_dma_prefetch", &Func::hexagon_dma_prefetch,
+            py::arg("consumer"), py::arg("tile_var"), py::arg("store_var"), py::arg("fold_var"), py::arg("tile_extent"))
 
         .def("estimate", &Func::estimate,
             py::arg("var"), py::arg("min"), py::arg("extent"))
@@ -297,6 +312,9 @@ void define_func(py::module &m) {
         .def("bound_extent", &Func::bound_extent,
             py::arg("var"), py::arg("extent"))
 
+        .def("value_bounds", &Func::value_bounds,
+            py::arg("min"), py::arg("max"))
+
         .def("gpu_lanes", &Func::gpu_lanes,
             py::arg("thread_x"), py::arg("device_api") = DeviceAPI::Default_GPU)
 
@@ -307,11 +325,14 @@ void define_func(py::module &m) {
             py::arg("x"), py::arg("y"), py::arg("c"))
 
         .def("align_storage", &Func::align_storage,
-            py::arg("dim"), py::arg("alignment"))
+            py::arg("dim"), py::arg("alignment"), py::arg("padding") = Expr())
 
         .def("fold_storage", &Func::fold_storage,
             py::arg("dim"), py::arg("extent"), py::arg("fold_forward") = true)
 
+        .def("ring_buffer", &Func::ring_buffer,
+            py::arg("dim"), py::arg("extent"), py::arg("fold_forward") = true)
+
         .def("compute_with", (Func &(Func::*)(LoopLevel, const std::vector<std::pair<VarOrRVar, LoopAlignStrategy>> &)) &Func::compute_with,
             py::arg("loop_level"), py::arg("align"))
         .def("compute_with", (Func &(Func::*)(LoopLevel, LoopAlignStrategy)) &Func::compute_with,
@@ -132,6 +132,14 @@ void define_operators(py::module &m) {
     m.def("fast_log", &fast_log);
     m.def("fast_exp", &fast_exp);
     m.def("fast_pow", &fast_pow);
+    m.def("fast_sin", &fast_sin, py::arg("x"), py::arg("max_ulp_error") = 0);
+    m.def("fast_cos", &fast_cos, py::arg("x"), py::arg("max_ulp_error") = 0);
+    m.def("fast_atan", &fast_atan, py::arg("x"), py::arg("max_ulp_error") = 0);
+    m.def("fast_atan2", &fast_atan2, py::arg("y"), py::arg("x"), py::arg("max_ulp_error") = 0);
+    m.def("fast_tanh", &fast_tanh, py::arg("x"), py::arg("max_ulp_error") = 0);
+    m.def("sorted", &sorted, py::arg("values"));
+    m.def("kth_smallest", &kth_smallest, py::arg("values"), py::arg("k"));
+    m.def("median", &median, py::arg("values"));
     m.def("fast_inverse", &fast_inverse);
     m.def("fast_inverse_sqrt", &fast_inverse_sqrt);
     m.def("floor", &floor);
@@ -5,12 +5,16 @@ namespace PythonBindings {
 
 void define_machine_params(py::module &m) {
     auto machine_params_class = py::class_<MachineParams>(m, "MachineParams")
-        .def(py::init<int32_t, int32_t, int32_t>(),
-            py::arg("parallelism"), py::arg("last_level_cache_size"), py::arg("balance"))
+        .def(py::init<int32_t, int32_t, int32_t, uint64_t, int32_t>(),
+            py::arg("parallelism"), py::arg("last_level_cache_size"), py::arg("balance"),
+            py::arg("max_resident_bytes") = 0,
+            py::arg("memory_latency") = (int32_t)MachineParams::default_memory_latency)
         .def(py::init<std::string>())
         .def_readwrite("parallelism", &MachineParams::parallelism)
         .def_readwrite("last_level_cache_size", &MachineParams::last_level_cache_size)
         .def_readwrite("balance", &MachineParams::balance)
+        .def_readwrite("max_resident_bytes", &MachineParams::max_resident_bytes)
+        .def_readwrite("memory_latency", &MachineParams::memory_latency)
         .def_static("generic", &MachineParams::generic)
         .def("__str__", &MachineParams::to_string)
         .def("__repr__", [](const MachineParams &mp) -> std::string {
@@ -48,8 +48,10 @@ void define_outputs(py::module &m) {
         .def_readwrite("c_source_name", &Outputs::c_source_name)
         .def_readwrite("stmt_name", &Outputs::stmt_name)
         .def_readwrite("stmt_html_name", &Outputs::stmt_html_name)
+        .def_readwrite("stmt_html_profile_name", &Outputs::stmt_html_profile_name)
         .def_readwrite("static_library_name", &Outputs::static_library_name)
         .def_readwrite("schedule_name", &Outputs::schedule_name)
+        .def_readwrite("roofline_name", &Outputs::roofline_name)
         .def("__repr__", [](const Outputs &o) -> std::string {
             return "<halide.Outputs>";
         })
@@ -17,8 +17,31 @@ py::object realization_to_object(const Realization &r) {
     return to_python_tuple(r);
 }
 
+Target compile_for_realize(Pipeline &p, const Target &target) {
+    Target t = target;
+    if (t.os == Target::OSUnknown) {
+        t = get_jit_target_from_environment();
+    }
+    p.compile_jit(t);
+    return t;
+}
+
 }  // namespace
 
+void realize_without_gil(Pipeline p, Pipeline::RealizationArg outputs,
+                         const Target &target, const ParamMap &param_map) {
+    Target t = compile_for_realize(p, target);
+    py::gil_scoped_release release;
+    p.realize(std::move(outputs), t, param_map);
+}
+
+Realization realize_without_gil(Pipeline p, const std::vector<int32_t> &sizes,
+                                const Target &target, const ParamMap &param_map) {
+    Target t = compile_for_realize(p, target);
+    py::gil_scoped_release release;
+    return p.realize(sizes, t, param_map);
+}
+
 void define_pipeline(py::module &m) {
 
     // Deliberately not supported, because they don't seem to make sense for Python:
@@ -46,6 +69,8 @@ void define_pipeline(py::module &m) {
         .def("outputs", &Pipeline::outputs)
         .def("auto_schedule", &Pipeline::auto_schedule,
             py::arg("target"), py::arg("machine_params") = MachineParams::generic())
+        .def("roofline_report", &Pipeline::roofline_report,
+            py::arg("machine_params") = MachineParams::generic())
         .def("get_func", &Pipeline::get_func,
             py::arg("index"))
         .def("print_loop_nest", &Pipeline::print_loop_nest)
@@ -82,39 +107,42 @@ void define_pipeline(py::module &m) {
         .def("compile_jit", [](Pipeline &p, const Target &target) -> void {
             (void) p.compile_jit();
         }, py::arg("target") = get_jit_target_from_environment())
+        .def("compile_jit_in_background", &Pipeline::compile_jit_in_background, py::arg("target") = get_jit_target_from_environment())
+        .def("jit_replacement_pending", &Pipeline::jit_replacement_pending)
+        .def("set_lazy_specializations", &Pipeline::set_lazy_specializations, py::arg("lazy"))
 
 
         .def("realize", [](Pipeline &p, Buffer<> buffer, const Target &target, const ParamMap &param_map) -> void {
-            p.realize(Realization(buffer), target);
+            realize_without_gil(p, Realization(buffer), target, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // This will actually allow a list-of-buffers as well as a tuple-of-buffers, but that's OK.
         .def("realize", [](Pipeline &p, std::vector<Buffer<>> buffers, const Target &t, const ParamMap &param_map) -> void {
-            p.realize(Realization(buffers), t);
+            realize_without_gil(p, Realization(buffers), t, param_map);
         }, py::arg("dst"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("realize", [](Pipeline &p, std::vector<int32_t> sizes, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(p.realize(sizes, target, param_map));
+            return realization_to_object(realize_without_gil(p, sizes, target, param_map));
         }, py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Pipeline &p, int x_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(p.realize(x_size, target, param_map));
+            return realization_to_object(realize_without_gil(p, {x_size}, target, param_map));
         }, py::arg("x_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Pipeline &p, int x_size, int y_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(p.realize(x_size, y_size, target, param_map));
+            return realization_to_object(realize_without_gil(p, {x_size, y_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Pipeline &p, int x_size, int y_size, int z_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(p.realize(x_size, y_size, z_size, target, param_map));
+            return realization_to_object(realize_without_gil(p, {x_size, y_size, z_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         // TODO: deprecate in favor of std::vector<int32_t> size version?
         .def("realize", [](Pipeline &p, int x_size, int y_size, int z_size, int w_size, const Target &target, const ParamMap &param_map) -> py::object {
-            return realization_to_object(p.realize(x_size, y_size, z_size, w_size, target, param_map));
+            return realization_to_object(realize_without_gil(p, {x_size, y_size, z_size, w_size}, target, param_map));
         }, py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target(), py::arg("param_map") = ParamMap())
 
         .def("infer_input_bounds", [](Pipeline &p, int x_size, int y_size, int z_size, int w_size, const ParamMap &param_map) -> void {
@@ -134,6 +162,7 @@ void define_pipeline(py::module &m) {
 
         .def("defined", &Pipeline::defined)
         .def("invalidate_cache", &Pipeline::invalidate_cache)
+        .def("set_output_buffer_pool_size", &Pipeline::set_output_buffer_pool_size, py::arg("max_buffers"))
 
         .def("__repr__", [](const Pipeline &p) -> std::string {
             std::ostringstream o;
@@ -8,6 +8,17 @@ namespace PythonBindings {
 
 void define_pipeline(py::module &m);
 
+/** Realize a Pipeline with the GIL released, so that other Python
+ * threads can run while it does. Any JIT compilation needed is done
+ * first, with the GIL held, as it isn't safe for more than one thread
+ * to compile the same Pipeline at once. */
+// @{
+void realize_without_gil(Pipeline p, Pipeline::RealizationArg outputs,
+                         const Target &target, const ParamMap &param_map);
+Realization realize_without_gil(Pipeline p, const std::vector<int32_t> &sizes,
+                                const Target &target, const ParamMap &param_map);
+// @}
+
 }  // namespace PythonBindings
 }  // namespace Halide
 
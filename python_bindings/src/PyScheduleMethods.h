@@ -22,6 +22,8 @@ HALIDE_NEVER_INLINE void add_schedule_methods(PythonClass &class_instance) {
         py::arg("var"))
     .def("unroll", (T &(T::*)(VarOrRVar, Expr, TailStrategy)) &T::unroll,
         py::arg("var"), py::arg("factor"), py::arg("tail") = TailStrategy::Auto)
+    .def("unroll_and_jam", &T::unroll_and_jam,
+        py::arg("var"), py::arg("factor"), py::arg("tail") = TailStrategy::Auto)
 
     .def("split", (T &(T::*)(VarOrRVar, VarOrRVar, VarOrRVar, Expr, TailStrategy)) &T::split,
         py::arg("old"), py::arg("outer"), py::arg("inner"), py::arg("factor"), py::arg("tail") = TailStrategy::Auto)
@@ -115,6 +117,11 @@ HALIDE_NEVER_INLINE void add_schedule_methods(PythonClass &class_instance) {
         // Templated function; specializing only on ImageParam for now
         return t.prefetch(image, var, offset, strategy);
     }, py::arg("image"), py::arg("var"), py::arg("offset") = 1, py::arg("strategy") = PrefetchBoundStrategy::GuardWithIf)
+    .def("prefetch", (T &(T::*)(const Func &, VarOrRVar, const MachineParams &, PrefetchBoundStrategy)) &T::prefetch,
+        py::arg("func"), py::arg("var"), py::arg("params"), py::arg("strategy") = PrefetchBoundStrategy::GuardWithIf)
+    .def("prefetch", [](T &t, const ImageParam &image, VarOrRVar var, const MachineParams &params, PrefetchBoundStrategy strategy) -> T & {
+        return t.prefetch(image, var, params, strategy);
+    }, py::arg("image"), py::arg("var"), py::arg("params"), py::arg("strategy") = PrefetchBoundStrategy::GuardWithIf)
 
     .def("source_location", &T::source_location)
     ;
@@ -14,12 +14,19 @@ void define_stage(py::module &m) {
             py::arg("preserved"))
         .def("rfactor", (Func (Stage::*)(RVar, Var)) &Stage::rfactor,
             py::arg("r"), py::arg("v"))
+        .def("parallel_scan", &Stage::parallel_scan,
+            py::arg("r"), py::arg("block_size"), py::arg("ri"), py::arg("rb"))
+        .def("privatize", &Stage::privatize,
+            py::arg("r"), py::arg("u"), py::arg("num_copies"), py::arg("vector_width") = 1)
 
         // These two variants of compute_with are specific to Stage
         .def("compute_with", (Stage &(Stage::*)(LoopLevel, const std::vector<std::pair<VarOrRVar, LoopAlignStrategy>> &)) &Stage::compute_with,
             py::arg("loop_level"), py::arg("align"))
         .def("compute_with", (Stage &(Stage::*)(LoopLevel, LoopAlignStrategy)) &Stage::compute_with,
             py::arg("loop_level"), py::arg("align") = LoopAlignStrategy::Auto)
+
+        .def("atomic", &Stage::atomic,
+            py::arg("override_associativity_test") = false)
     ;
     add_schedule_methods(stage_class);
 }
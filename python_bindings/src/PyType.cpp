@@ -32,6 +32,9 @@ std::string halide_type_to_string(const Type &type) {
         case halide_type_float:
             stream << "float";
             break;
+        case halide_type_bfloat:
+            stream << "bfloat";
+            break;
         case halide_type_handle:
             stream << "handle";
             break;
@@ -0,0 +1,94 @@
+#include "AddAliasChecks.h"
+#include "IROperator.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+const char *const buffers_may_alias_marker = "__buffers_may_alias";
+
+namespace {
+
+// The half-open range of addresses that a buffer argument covers,
+// computed from its halide_buffer_t.
+void buffer_address_range(const Argument &arg, Expr *begin, Expr *end) {
+    Expr buf = Variable::make(type_of<struct halide_buffer_t *>(), arg.name + ".buffer");
+    Expr host = Call::make(type_of<void *>(), Call::buffer_get_host, {buf}, Call::Extern);
+    Expr base = reinterpret(UInt(64), host);
+
+    // The offsets in elements of the lowest and highest addressed
+    // elements, relative to the host pointer.
+    Expr lo = make_zero(Int(64)), hi = make_zero(Int(64));
+    for (int i = 0; i < arg.dimensions; i++) {
+        Expr extent = Call::make(Int(32), Call::buffer_get_extent, {buf, i}, Call::Extern);
+        Expr stride = Call::make(Int(32), Call::buffer_get_stride, {buf, i}, Call::Extern);
+        Expr span = cast<int64_t>(stride) * (cast<int64_t>(extent) - 1);
+        lo += min(span, make_zero(Int(64)));
+        hi += max(span, make_zero(Int(64)));
+    }
+    int bytes = arg.type.bytes();
+    *begin = base + cast<uint64_t>(lo * bytes);
+    *end = base + cast<uint64_t>((hi + 1) * bytes);
+}
+
+}  // namespace
+
+Stmt add_alias_checks(const Stmt &s, const vector<Argument> &args) {
+    vector<const Argument *> buffers, outputs;
+    for (const Argument &arg : args) {
+        if (arg.is_buffer()) {
+            buffers.push_back(&arg);
+            if (arg.is_output()) {
+                outputs.push_back(&arg);
+            }
+        }
+    }
+
+    // Only writes through one buffer can be reordered wrongly with
+    // accesses through another, so each output needs checking against
+    // every other buffer argument.
+    Expr distinct;
+    for (const Argument *out : outputs) {
+        Expr out_begin, out_end;
+        buffer_address_range(*out, &out_begin, &out_end);
+        for (const Argument *other : buffers) {
+            if (other == out || (other->is_output() && other < out)) {
+                // Pairs of outputs are only checked once.
+                continue;
+            }
+            Expr other_begin, other_end;
+            buffer_address_range(*other, &other_begin, &other_end);
+            Expr disjoint = (out_end <= other_begin) || (other_end <= out_begin);
+            distinct = distinct.defined() ? (distinct && disjoint) : disjoint;
+        }
+    }
+
+    if (!distinct.defined()) {
+        return s;
+    }
+
+    // The check reads the buffer arguments, so it has to go after the
+    // leading assertions that they aren't null.
+    vector<Stmt> asserts;
+    Stmt body = s;
+    while (const Block *b = body.as<Block>()) {
+        if (!b->first.as<AssertStmt>()) {
+            break;
+        }
+        asserts.push_back(b->first);
+        body = b->rest;
+    }
+
+    Stmt may_alias = LetStmt::make(buffers_may_alias_marker, const_true(), body);
+    Stmt result = IfThenElse::make(distinct, body, may_alias);
+    while (!asserts.empty()) {
+        result = Block::make(asserts.back(), result);
+        asserts.pop_back();
+    }
+    return result;
+}
+
+}  // namespace Internal
+}  // namespace Halide
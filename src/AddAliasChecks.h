@@ -0,0 +1,32 @@
+#ifndef HALIDE_INTERNAL_ADD_ALIAS_CHECKS_H
+#define HALIDE_INTERNAL_ADD_ALIAS_CHECKS_H
+
+/** \file
+ *
+ * Defines the lowering pass that specializes a pipeline on whether
+ * its input and output buffers overlap in memory.
+ */
+
+#include "Argument.h"
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** The name of the LetStmt that marks the copy of the pipeline body
+ * that must not assume its buffer arguments are distinct. CodeGen_LLVM
+ * gives loads and stores of the buffer arguments in its body
+ * conservative alias metadata. */
+extern const char *const buffers_may_alias_marker;
+
+/** Wrap the body of a pipeline in a runtime check that none of its
+ * output buffers overlap any of its other buffer arguments. If they
+ * don't, the original body runs, and codegen may mark the buffer
+ * arguments as noalias. Otherwise a copy of the body marked with
+ * buffers_may_alias_marker runs instead. */
+Stmt add_alias_checks(const Stmt &s, const std::vector<Argument> &args);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -94,6 +94,35 @@ public:
     }
 };
 
+/* Find the scalar parameters that the argument checks depend on, and
+ * whether they also depend on the contents of any buffer. */
+class FindCheckInputs : public IRGraphVisitor {
+public:
+    map<string, Parameter> params;
+    bool depends_on_data = false;
+
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) override {
+        if (op->param.defined() && !op->param.is_buffer()) {
+            params[op->name] = op->param;
+        }
+    }
+
+    void visit(const Load *op) override {
+        depends_on_data = true;
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        if (op->call_type == Call::Image ||
+            op->call_type == Call::Halide) {
+            depends_on_data = true;
+        }
+        IRGraphVisitor::visit(op);
+    }
+};
+
 Stmt add_image_checks(Stmt s,
                       const vector<Function> &outputs,
                       const Target &t,
@@ -103,6 +132,7 @@ Stmt add_image_checks(Stmt s,
 
     bool no_asserts = t.has_feature(Target::NoAsserts);
     bool no_bounds_query = t.has_feature(Target::NoBoundsQuery);
+    bool cache_checks = t.has_feature(Target::CacheBoundsChecks);
 
     // First hunt for all the referenced buffers
     FindBuffers finder;
@@ -145,6 +175,11 @@ Stmt add_image_checks(Stmt s,
     vector<Stmt> asserts_host_non_null;
     vector<Stmt> buffer_rewrites;
 
+    // The buffer fields that the checks depend on. With
+    // CacheBoundsChecks, a call with the same values as the last one
+    // that passed the checks skips them.
+    vector<Expr> cache_key;
+
     // Inject the code that conditionally returns if we're in inference mode
     Expr maybe_return_condition = const_false();
 
@@ -263,6 +298,9 @@ Stmt add_image_checks(Stmt s,
         {
             string type_name = name + ".type";
             Expr type_var = Variable::make(UInt(32), type_name, image, param, rdom);
+            if (param.defined()) {
+                cache_key.push_back(type_var);
+            }
             uint32_t correct_type_bits = ((halide_type_t)type).as_u32();
             Expr correct_type_expr = make_const(UInt(32), correct_type_bits);
             Expr error = Call::make(Int(32), "halide_error_bad_type",
@@ -276,6 +314,9 @@ Stmt add_image_checks(Stmt s,
         {
             string dimensions_name = name + ".dimensions";
             Expr dimensions_given = Variable::make(Int(32), dimensions_name, image, param, rdom);
+            if (param.defined()) {
+                cache_key.push_back(dimensions_given);
+            }
             Expr error = Call::make(Int(32), "halide_error_bad_dimensions",
                                     {error_name,
                                      dimensions_given, make_const(Int(32), dimensions)},
@@ -299,6 +340,11 @@ Stmt add_image_checks(Stmt s,
             Expr actual_min = Variable::make(Int(32), actual_min_name, image, param, rdom);
             Expr actual_extent = Variable::make(Int(32), actual_extent_name, image, param, rdom);
             Expr actual_stride = Variable::make(Int(32), actual_stride_name, image, param, rdom);
+            if (param.defined()) {
+                cache_key.push_back(actual_min);
+                cache_key.push_back(actual_extent);
+                cache_key.push_back(actual_stride);
+            }
 
             if (!touched.empty() && !touched[j].is_bounded()) {
                 user_error << "Buffer " << name
@@ -579,8 +625,51 @@ Stmt add_image_checks(Stmt s,
             s = Block::make(asserts_host_alignment[i-1], s);
         }
     }
+
+    // Gather the checks that only depend on the buffer fields in the
+    // key and on scalar parameters, in the order they run.
+    vector<Stmt> cached_checks;
+    if (cache_checks) {
+        if (!no_asserts) {
+            cached_checks.insert(cached_checks.end(), asserts_type_checks.begin(), asserts_type_checks.end());
+            cached_checks.insert(cached_checks.end(), asserts_required.begin(), asserts_required.end());
+        }
+        cached_checks.insert(cached_checks.end(), asserts_constrained.begin(), asserts_constrained.end());
+        if (!no_asserts && !dims_no_overflow_asserts.empty()) {
+            Stmt overflow_checks = Block::make(dims_no_overflow_asserts);
+            for (size_t i = lets_overflow.size(); i > 0; i--) {
+                overflow_checks = LetStmt::make(lets_overflow[i-1].first, lets_overflow[i-1].second, overflow_checks);
+            }
+            cached_checks.push_back(substitute(replace_with_constrained, overflow_checks));
+        }
+
+        FindCheckInputs inputs;
+        for (const Stmt &check : cached_checks) {
+            check.accept(&inputs);
+        }
+        for (const pair<string, Expr> &let : lets_required) {
+            let.second.accept(&inputs);
+        }
+        for (const pair<string, Expr> &let : lets_constrained) {
+            let.second.accept(&inputs);
+        }
+        for (const pair<const string, Parameter> &p : inputs.params) {
+            Expr value = Variable::make(p.second.type(), p.first, p.second);
+            if (value.type().is_handle()) {
+                value = reinterpret(UInt(64), value);
+            } else if (value.type().is_float()) {
+                value = reinterpret(UInt(value.type().bits()), value);
+            }
+            cache_key.push_back(value);
+        }
+
+        if (inputs.depends_on_data || cached_checks.empty()) {
+            cache_checks = false;
+        }
+    }
+
     // Inject the code that checks that no dimension math overflows
-    if (!no_asserts) {
+    if (!no_asserts && !cache_checks) {
         for (size_t i = dims_no_overflow_asserts.size(); i > 0; i--) {
             s = Block::make(dims_no_overflow_asserts[i-1], s);
         }
@@ -601,14 +690,37 @@ Stmt add_image_checks(Stmt s,
     // all in reverse order compared to execution, as we incrementally
     // prepending code.
 
-    // Inject the code that checks the constraints are correct. We
-    // need these regardless of how NoAsserts is set, because they are
-    // what gets Halide to actually exploit the constraint.
-    for (size_t i = asserts_constrained.size(); i > 0; i--) {
-        s = Block::make(asserts_constrained[i-1], s);
+    if (cache_checks) {
+        // Run the checks only if the key differs from the last call
+        // that passed them, and then remember it.
+        Expr cache = Variable::make(Handle(), "bounds_check_cache");
+        Expr key = Variable::make(Handle(), "bounds_check_cache.key");
+        Expr key_size = (int)cache_key.size();
+        Expr hit = Call::make(Int(32), "halide_bounds_check_cache_lookup",
+                              {cache, key, key_size}, Call::Extern);
+        Expr store = Call::make(Int(32), "halide_bounds_check_cache_store",
+                                {cache, key, key_size}, Call::Extern);
+        cached_checks.push_back(Evaluate::make(store));
+        s = Block::make(IfThenElse::make(hit == 0, Block::make(cached_checks)), s);
+
+        vector<Expr> key_values;
+        for (const Expr &e : cache_key) {
+            key_values.push_back(cast<int64_t>(e));
+        }
+        Expr key_struct = Call::make(Handle(), Call::make_struct, key_values, Call::Intrinsic);
+        s = LetStmt::make("bounds_check_cache.key", key_struct, s);
+        s = LetStmt::make("bounds_check_cache",
+                          Call::make(Handle(), Call::bounds_check_cache, {key_size}, Call::Intrinsic), s);
+    } else {
+        // Inject the code that checks the constraints are correct. We
+        // need these regardless of how NoAsserts is set, because they are
+        // what gets Halide to actually exploit the constraint.
+        for (size_t i = asserts_constrained.size(); i > 0; i--) {
+            s = Block::make(asserts_constrained[i-1], s);
+        }
     }
 
-    if (!no_asserts) {
+    if (!no_asserts && !cache_checks) {
         // Inject the code that checks for out-of-bounds access to the buffers.
         for (size_t i = asserts_required.size(); i > 0; i--) {
             s = Block::make(asserts_required[i-1], s);
@@ -1,4 +1,5 @@
 #include "AsyncProducers.h"
+#include "Debug.h"
 #include "ExprUsesVar.h"
 #include "IREquality.h"
 #include "IRMutator.h"
@@ -286,18 +287,93 @@ public:
     int count = 0;
 };
 
+class ContainsProduceNode : public IRVisitor {
+    const string &func;
+
+    using IRVisitor::visit;
+
+    void visit(const ProducerConsumer *op) override {
+        if (op->name == func && op->is_producer) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+public:
+    ContainsProduceNode(const string &f) : func(f) {}
+    bool result = false;
+};
+
+// Finds the first statement run after the production of func in the
+// body of its realization, skipping the lets, realizations and
+// conditions wrapped around it.
+Stmt first_stmt_after_produce(const string &func, Stmt s, bool after) {
+    while (s.defined()) {
+        if (const LetStmt *let = s.as<LetStmt>()) {
+            s = let->body;
+        } else if (const Realize *r = s.as<Realize>()) {
+            s = r->body;
+        } else if (const Block *b = s.as<Block>()) {
+            if (after) {
+                s = b->first;
+            } else {
+                ContainsProduceNode contains(func);
+                b->first.accept(&contains);
+                after = contains.result;
+                s = b->rest;
+            }
+        } else if (const IfThenElse *i = s.as<IfThenElse>()) {
+            // A stage that may be skipped (see skip_stages).
+            if (!after || i->else_case.defined()) {
+                return Stmt();
+            }
+            s = i->then_case;
+        } else {
+            return after ? s : Stmt();
+        }
+    }
+    return Stmt();
+}
+
+// Whether a realization of func at the root level would let another
+// Func be computed while func is being produced, if func were
+// async. That is the case when the realization order puts a Func
+// that doesn't consume func right after it. Consume nodes have been
+// tightened by this point, so this is a produce node of another
+// Func, rather than a consume node of this one.
+bool overlaps_with_next_stage(const string &func, Stmt body) {
+    Stmt next = first_stmt_after_produce(func, body, false);
+    const ProducerConsumer *pc = next.as<ProducerConsumer>();
+    return pc && pc->is_producer && pc->name != func;
+}
+
 class ForkAsyncProducers : public IRMutator {
     using IRMutator::visit;
 
     const map<string, Function> &env;
+    const bool auto_async;
 
     map<string, string> cloned_acquires;
 
+    int loop_depth = 0;
+
+    Stmt visit(const For *op) override {
+        ScopedValue<int> old_loop_depth(loop_depth, loop_depth + 1);
+        return IRMutator::visit(op);
+    }
+
     Stmt visit(const Realize *op) override {
         auto it = env.find(op->name);
         internal_assert(it != env.end());
         Function f = it->second;
-        if (f.schedule().async()) {
+        bool async = f.schedule().async();
+        if (!async && auto_async && loop_depth == 0 &&
+            !f.schedule().memoized() &&
+            overlaps_with_next_stage(op->name, op->body)) {
+            debug(2) << "Running " << op->name << " asynchronously\n";
+            async = true;
+        }
+        if (async) {
             Stmt body = op->body;
 
             // Make two copies of the body, one which only does the
@@ -351,7 +427,7 @@ class ForkAsyncProducers : public IRMutator {
     }
 
 public:
-    ForkAsyncProducers(const map<string, Function> &e) : env(e) {}
+    ForkAsyncProducers(const map<string, Function> &e, bool a) : env(e), auto_async(a) {}
 };
 
 // Lowers semaphore initialization from a call to
@@ -628,9 +704,9 @@ class TightenForkNodes : public IRMutator {
 
 // TODO: merge semaphores?
 
-Stmt fork_async_producers(Stmt s, const map<string, Function> &env) {
+Stmt fork_async_producers(Stmt s, const map<string, Function> &env, const Target &t) {
     s = TightenProducerConsumerNodes(env).mutate(s);
-    s = ForkAsyncProducers(env).mutate(s);
+    s = ForkAsyncProducers(env, t.has_feature(Target::AutoAsync)).mutate(s);
     s = ExpandAcquireNodes().mutate(s);
     s = TightenForkNodes().mutate(s);
     s = InitializeSemaphores().mutate(s);
@@ -6,11 +6,16 @@
  */
 
 #include "IR.h"
+#include "Target.h"
 
 namespace Halide {
 namespace Internal {
 
-Stmt fork_async_producers(Stmt s, const std::map<std::string, Function> &env);
+/** Run the producers of Funcs scheduled as async concurrently with
+ * their consumers. With Target::AutoAsync, compute_root Funcs that are
+ * followed in the realization order by a Func that doesn't consume
+ * them are run that way too. */
+Stmt fork_async_producers(Stmt s, const std::map<std::string, Function> &env, const Target &t);
 
 }
 }
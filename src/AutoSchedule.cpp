@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <iomanip>
 #include <regex>
 
 #include "AutoSchedule.h"
@@ -1176,6 +1177,16 @@ struct Partitioner {
     // auto scheduling.
     void generate_cpu_schedule(const Target &t, AutoSchedule &sched);
 
+    // Pick a storage order for each function that isn't inlined or an
+    // output of the pipeline. Each dimension is tried as the innermost
+    // one, and the layout for which the stages that produce and consume
+    // the function can be given the smallest innermost access stride
+    // (weighted by the number of points they compute) is applied with
+    // reorder_storage. Functions that the user has already given a
+    // storage order, or that are passed to extern stages, are left alone.
+    void choose_storage_layouts(const map<FStage, map<string, Box>> &storage_bounds,
+                                const set<string> &inlines, AutoSchedule &sched);
+
     // Same as \ref Partitioner::generate_cpu_schedule, but this generates and
     // applies schedules for a group of function stages.
 
@@ -2826,6 +2837,24 @@ void Partitioner::generate_group_cpu_schedule(
         tile_inner_var = VarOrRVar(var_name, is_rvar);
     }
 
+    // If the tiles of the group output can't keep the machine busy,
+    // produce the members computed per tile as asynchronous tasks, so
+    // that independent producers of a tile are computed concurrently
+    // with each other.
+    bool async_members = false;
+    if (!outer_dims.empty() && arch_params.parallelism > 1 &&
+        can_prove(def_par < arch_params.parallelism)) {
+        int num_tile_producers = 0;
+        for (const FStage &mem : g.members) {
+            if (mem.stage_num == 0 &&
+                g.inlined.find(mem.func.name()) == g.inlined.end() &&
+                mem.func.name() != g_out.name()) {
+                num_tile_producers++;
+            }
+        }
+        async_members = num_tile_producers > 1;
+    }
+
     for (const FStage &mem : g.members) {
         // Skip member stages that have been inlined or stage that is the
         // output stage of the group
@@ -2865,6 +2894,10 @@ void Partitioner::generate_group_cpu_schedule(
                 sched.push_schedule(mem_handle.name(), mem.stage_num,
                                     "compute_at(" + sanitized_g_out + ", " + tile_inner_var.name() + ")",
                                     {sanitized_g_out, tile_inner_var.name()});
+                if (async_members && !mem.func.has_update_definition()) {
+                    Func(mem.func).async();
+                    sched.push_schedule(mem_handle.name(), mem.stage_num, "async()", {});
+                }
             } else {
                 user_warning << "Degenerate tiling. No dimensions are tiled" << '\n';
                 user_warning << "Computing \"" <<  mem.func.name() << "\" at root" << '\n';
@@ -2888,6 +2921,161 @@ void Partitioner::generate_group_cpu_schedule(
     }
 }
 
+void Partitioner::choose_storage_layouts(const map<FStage, map<string, Box>> &storage_bounds,
+                                         const set<string> &inlines, AutoSchedule &sched) {
+    // The stages that are given a loop nest of their own, along with the
+    // allocation bounds of the group they are computed in.
+    vector<pair<FStage, map<string, Box>>> stages;
+    for (const pair<const FStage, Group> &g : groups) {
+        for (const FStage &mem : g.second.members) {
+            if ((inlines.find(mem.func.name()) == inlines.end()) &&
+                !mem.func.has_extern_definition()) {
+                stages.push_back(make_pair(mem, get_element(storage_bounds, g.first)));
+            }
+        }
+    }
+
+    // Extern stages expect their inputs in the order they were defined.
+    set<string> extern_inputs;
+    for (const auto &iter : dep_analysis.env) {
+        if (iter.second.has_extern_definition()) {
+            for (const ExternFuncArgument &arg : iter.second.extern_arguments()) {
+                if (arg.is_func()) {
+                    extern_inputs.insert(Function(arg.func).name());
+                }
+            }
+        }
+    }
+
+    for (const auto &iter : dep_analysis.env) {
+        Function f = iter.second;
+        if ((f.args().size() < 2) ||
+            f.has_extern_definition() ||
+            (inlines.find(f.name()) != inlines.end()) ||
+            (extern_inputs.find(f.name()) != extern_inputs.end()) ||
+            std::any_of(outputs.begin(), outputs.end(),
+                        [&f](const Function &o) { return o.name() == f.name(); })) {
+            continue;
+        }
+
+        vector<StorageDim> &storage_dims = f.schedule().storage_dims();
+        const vector<StorageDim> original = storage_dims;
+        bool reordered = false;
+        for (size_t i = 0; i < original.size(); i++) {
+            reordered = reordered || (original[i].var != f.args()[i]);
+        }
+        if (reordered) {
+            continue;
+        }
+
+        // Find the stages that access f, after inlining.
+        vector<size_t> users;
+        for (size_t i = 0; i < stages.size(); i++) {
+            const FStage &stg = stages[i].first;
+            bool uses_f = (stg.func.name() == f.name());
+            if (!uses_f) {
+                Definition def = get_stage_definition(stg.func, stg.stage_num);
+                FindAllCalls find;
+                for (const Expr &val : def.values()) {
+                    perform_inline(val, dep_analysis.env, inlines, dep_analysis.order).accept(&find);
+                }
+                for (const Expr &arg : def.args()) {
+                    perform_inline(arg, dep_analysis.env, inlines, dep_analysis.order).accept(&find);
+                }
+                uses_f = (find.funcs_called.find(f.name()) != find.funcs_called.end());
+            }
+            if (uses_f) {
+                users.push_back(i);
+            }
+        }
+
+        // Try each dimension as the innermost one, keeping the order of the
+        // others. Ties go to the order of the args.
+        Expr best_cost;
+        size_t best_inner = 0;
+        for (size_t inner = 0; inner < original.size(); inner++) {
+            storage_dims.clear();
+            storage_dims.push_back(original[inner]);
+            for (size_t i = 0; i < original.size(); i++) {
+                if (i != inner) {
+                    storage_dims.push_back(original[i]);
+                }
+            }
+
+            // The cost of a stage is the smallest stride along any of its
+            // pure loop dimensions, which reorder_dims will make the
+            // innermost one, times the number of points it computes.
+            Expr cost = make_zero(Int(64));
+            for (size_t u : users) {
+                const FStage &stg = stages[u].first;
+                map<string, Expr> strides = analyze_spatial_locality(stg, stages[u].second, inlines);
+                if (strides.empty()) {
+                    cost = Expr();
+                    break;
+                }
+
+                Definition def = get_stage_definition(stg.func, stg.stage_num);
+                const vector<Dim> &dims = def.schedule().dims();
+                Expr min_stride;
+                for (int d = 0; d < (int)dims.size() - 1; d++) {
+                    if (dims[d].is_pure()) {
+                        const Expr &stride = get_element(strides, dims[d].var);
+                        min_stride = min_stride.defined() ? min(min_stride, stride) : stride;
+                    }
+                }
+                if (!min_stride.defined()) {
+                    continue;
+                }
+
+                Expr points = make_one(Int(64));
+                for (const auto &b : get_bounds(stg)) {
+                    Expr extent = get_extent(b.second);
+                    if (!extent.defined()) {
+                        points = Expr();
+                        break;
+                    }
+                    points *= extent;
+                }
+                if (!points.defined()) {
+                    cost = Expr();
+                    break;
+                }
+                cost += min_stride * points;
+            }
+            if (!cost.defined()) {
+                best_cost = Expr();
+                break;
+            }
+            cost = simplify(cost);
+
+            debug(3) << "Cost of storing " << f.name() << " with " << original[inner].var
+                     << " innermost: " << cost << "\n";
+            if (!best_cost.defined() || can_prove(cost < best_cost)) {
+                best_cost = cost;
+                best_inner = inner;
+            }
+        }
+
+        storage_dims = original;
+        if (!best_cost.defined() || best_inner == 0) {
+            continue;
+        }
+
+        vector<Var> order = {Var(original[best_inner].var)};
+        set<string> var_list = {original[best_inner].var};
+        string var_order = original[best_inner].var;
+        for (size_t i = 0; i < original.size(); i++) {
+            if (i != best_inner) {
+                order.push_back(Var(original[i].var));
+                var_list.insert(original[i].var);
+                var_order += ", " + original[i].var;
+            }
+        }
+        Func(f).reorder_storage(order);
+        sched.push_schedule(f.name(), 0, "reorder_storage(" + var_order + ")", var_list);
+    }
+}
+
 void Partitioner::generate_cpu_schedule(const Target &t, AutoSchedule &sched) {
     // Grab the group bounds early as they rely on the dimensions of the group
     // outputs which will be altered by modifying schedules.
@@ -2902,6 +3090,10 @@ void Partitioner::generate_cpu_schedule(const Target &t, AutoSchedule &sched) {
         }
     }
 
+    // Pick the storage layouts before scheduling the loops, because the
+    // loop orders are chosen based on the strides of the accesses.
+    choose_storage_layouts(storage_bounds, inlines, sched);
+
     // TODO: Inlining functions with update definitions has different
     // behavior than pure functions. They may need to be computed above
     // the innermost vector loop to avoid complications with varying
@@ -2938,6 +3130,22 @@ Expr Partitioner::find_max_access_stride(const Scope<> &vars,
         num_storage_dims = buffer_bounds.size();
     }
 
+    // The index of the argument that each storage dimension corresponds
+    // to, from innermost to outermost. Inputs are stored in argument order.
+    vector<size_t> arg_index(num_storage_dims);
+    for (size_t sdim = 0; sdim < num_storage_dims; sdim++) {
+        arg_index[sdim] = sdim;
+    }
+    if (iter != dep_analysis.env.end()) {
+        const Function &f = iter->second;
+        const vector<StorageDim> &storage_dims = f.schedule().storage_dims();
+        for (size_t sdim = 0; sdim < num_storage_dims; sdim++) {
+            const auto &arg = std::find(f.args().begin(), f.args().end(), storage_dims[sdim].var);
+            internal_assert(arg != f.args().end());
+            arg_index[sdim] = arg - f.args().begin();
+        }
+    }
+
     Expr curr_stride = bytes_per_ele;
     Expr stride = make_zero(Int(64));
 
@@ -2945,11 +3153,11 @@ Expr Partitioner::find_max_access_stride(const Scope<> &vars,
     for (size_t sdim = 0; sdim < num_storage_dims; sdim++) {
         // Check if the access expression depends on any of the loop variables
         // in 'vars'. Expressions that do not involve the variable have stride 0.
-        if (expr_uses_vars(acc_exprs[sdim], vars)) {
+        if (expr_uses_vars(acc_exprs[arg_index[sdim]], vars)) {
            stride = max(stride, curr_stride);
         }
 
-        const Interval &dim_range = buffer_bounds[sdim];
+        const Interval &dim_range = buffer_bounds[arg_index[sdim]];
         Expr dim_extent = get_extent(dim_range);
         if (!dim_extent.defined()) {
             return Expr();
@@ -3530,8 +3738,161 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
     return sched_string;
 }
 
+// Estimate the work and memory traffic of every stage of the pipeline
+// with the same cost model the auto-scheduler uses, and classify each
+// stage as compute- or memory-bound.
+string generate_roofline_report(const vector<Function> &outputs,
+                                const MachineParams &arch_params) {
+    map<string, Function> env;
+    for (Function f : outputs) {
+        map<string, Function> more_funcs = find_transitive_calls(f);
+        env.insert(more_funcs.begin(), more_funcs.end());
+    }
+
+    for (auto &iter : env) {
+        iter.second.lock_loop_levels();
+    }
+
+    check_estimates_on_outputs(outputs);
+
+    vector<string> order = realization_order(outputs, env).first;
+    FuncValueBounds func_val_bounds = compute_function_value_bounds(order, env);
+    RegionCosts costs(env, order);
+    DependenceAnalysis dep_analysis(env, order, func_val_bounds);
+    map<string, Box> pipeline_bounds =
+        get_pipeline_bounds(dep_analysis, outputs, &costs.input_estimates);
+
+    // Funcs the schedule inlines are costed as part of their consumers.
+    set<string> output_names;
+    for (const Function &f : outputs) {
+        output_names.insert(f.name());
+    }
+    set<string> inlines;
+    for (const auto &iter : env) {
+        const Function &f = iter.second;
+        if (!output_names.count(f.name()) && f.can_be_inlined() &&
+            f.schedule().compute_level().is_inlined()) {
+            inlines.insert(f.name());
+        }
+    }
+
+    // The cost of a load relative to an arithmetic operation grows
+    // linearly with the footprint of the Func it loads from, up to
+    // 'balance' once the footprint exceeds the last level cache, as in
+    // Partitioner::analyze_group.
+    float load_slope = arch_params.balance / arch_params.last_level_cache_size;
+    auto load_cost_factor = [&](const string &name) {
+        Expr footprint;
+        auto b = pipeline_bounds.find(name);
+        if (b != pipeline_bounds.end()) {
+            footprint = env.count(name) ? costs.region_size(name, b->second) : costs.input_region_size(name, b->second);
+        }
+        const int64_t *bytes = footprint.defined() ? as_const_int(simplify(footprint)) : nullptr;
+        return bytes ? std::min(1 + *bytes * load_slope, arch_params.balance) : arch_params.balance;
+    };
+
+    auto as_int = [](const Expr &e) -> const int64_t * {
+        return e.defined() ? as_const_int(simplify(e)) : nullptr;
+    };
+
+    std::ostringstream stream;
+    stream << "// Roofline estimate for MachineParams(" << arch_params.to_string() << ")\n"
+           << "// ops is the arithmetic cost and bytes the amount of memory loaded and\n"
+           << "// stored by each stage, as estimated by the auto-scheduler's cost model.\n"
+           << "// A stage is memory-bound when its loads, weighted by the relative\n"
+           << "// cost of a load from a footprint of that size, outweigh its ops.\n";
+    stream << std::left << std::setw(24) << "stage" << std::right
+           << std::setw(16) << "points"
+           << std::setw(16) << "ops"
+           << std::setw(16) << "bytes"
+           << std::setw(10) << "ops/byte"
+           << "  bound\n";
+
+    int64_t total_arith = 0, total_bytes = 0;
+    for (const string &name : order) {
+        const Function &f = env.at(name);
+        if (inlines.count(name)) {
+            stream << std::left << std::setw(24) << name << "inlined\n";
+            continue;
+        }
+        if (f.has_extern_definition()) {
+            stream << std::left << std::setw(24) << name << "extern (not costed)\n";
+            continue;
+        }
+        auto b = pipeline_bounds.find(name);
+        if (b == pipeline_bounds.end() || is_box_unbounded(b->second)) {
+            stream << std::left << std::setw(24) << name << "unbounded (not costed)\n";
+            continue;
+        }
+        const Box &region = b->second;
+        int64_t value_size = 0;
+        for (const Type &t : f.output_types()) {
+            value_size += t.bytes();
+        }
+
+        for (size_t s = 0; s < f.updates().size() + 1; s++) {
+            string stage_name = s == 0 ? name : name + ".update(" + std::to_string(s - 1) + ")";
+
+            // The points this stage iterates over: the pure dimensions
+            // of the Func it writes, and its reduction domain.
+            Definition def = get_stage_definition(f, s);
+            Box domain;
+            for (size_t d = 0; d < f.args().size(); d++) {
+                const Variable *v = def.args()[d].as<Variable>();
+                if (s == 0 || (v && v->name == f.args()[d])) {
+                    domain.push_back(region[d]);
+                }
+            }
+            for (const ReductionVariable &rv : def.schedule().rvars()) {
+                domain.push_back(Interval(subsitute_var_estimates(rv.min),
+                                          subsitute_var_estimates(rv.min + rv.extent - 1)));
+            }
+
+            const int64_t *points = as_int(box_size(domain));
+            Cost cost = costs.get_func_stage_cost(f, s, inlines);
+            const int64_t *arith = cost.defined() ? as_int(cost.arith) : nullptr;
+            if (!points || !arith) {
+                stream << std::left << std::setw(24) << stage_name << "unknown (not costed)\n";
+                continue;
+            }
+
+            // Weigh the loads from each Func or input by the size of
+            // its footprint, and count a store of each point.
+            int64_t bytes = *points * value_size;
+            float weighted = bytes * load_cost_factor(name);
+            for (const auto &load : costs.stage_detailed_load_costs(name, s, inlines)) {
+                const int64_t *per_point = as_int(load.second);
+                if (per_point) {
+                    bytes += *points * *per_point;
+                    weighted += *points * *per_point * load_cost_factor(load.first);
+                }
+            }
+
+            int64_t total_ops = *points * *arith;
+            total_arith += total_ops;
+            total_bytes += bytes;
+            stream << std::left << std::setw(24) << stage_name << std::right
+                   << std::setw(16) << *points
+                   << std::setw(16) << total_ops
+                   << std::setw(16) << bytes
+                   << std::setw(10) << std::fixed << std::setprecision(2)
+                   << (bytes ? (float)total_ops / bytes : 0.0f)
+                   << "  " << (weighted > total_ops ? "memory" : "compute") << "\n";
+        }
+    }
+    stream << std::left << std::setw(24) << "total" << std::right
+           << std::setw(16) << ""
+           << std::setw(16) << total_arith
+           << std::setw(16) << total_bytes
+           << std::setw(10) << std::fixed << std::setprecision(2)
+           << (total_bytes ? (float)total_arith / total_bytes : 0.0f) << "\n";
+    return stream.str();
+}
+
 }  // namespace Internal
 
+const int MachineParams::default_memory_latency;
+
 MachineParams MachineParams::generic() {
     std::string params = Internal::get_env_variable("HL_MACHINE_PARAMS");
     if (params.empty()) {
@@ -3544,15 +3905,23 @@ MachineParams MachineParams::generic() {
 std::string MachineParams::to_string() const {
     std::ostringstream o;
     o << parallelism << "," << last_level_cache_size << "," << balance;
+    if (max_resident_bytes || memory_latency != default_memory_latency) {
+        o << "," << max_resident_bytes;
+    }
+    if (memory_latency != default_memory_latency) {
+        o << "," << memory_latency;
+    }
     return o.str();
 }
 
 MachineParams::MachineParams(const std::string &s) {
     std::vector<std::string> v = Internal::split_string(s, ",");
-    user_assert(v.size() == 3) << "Unable to parse MachineParams: " << s;
+    user_assert(v.size() >= 3 && v.size() <= 5) << "Unable to parse MachineParams: " << s;
     parallelism = std::atoi(v[0].c_str());
     last_level_cache_size = std::atoll(v[1].c_str());
     balance = std::atof(v[2].c_str());
+    max_resident_bytes = v.size() >= 4 ? std::atoll(v[3].c_str()) : 0;
+    memory_latency = v.size() >= 5 ? std::atoi(v[4].c_str()) : default_memory_latency;
 }
 
 }  // namespace Halide
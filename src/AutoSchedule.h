@@ -21,14 +21,30 @@ struct MachineParams {
     /** Indicates how much more expensive is the cost of a load compared to
      * the cost of an arithmetic operation at last level cache. */
     float balance;
+    /** An upper bound on the memory (in bytes) that the intermediate
+     * Funcs of a pipeline may have allocated at once. Autoschedulers
+     * that support it reject schedules that may exceed it. Zero means
+     * no limit. */
+    uint64_t max_resident_bytes;
+    /** The latency of a load that misses in the last level cache, in
+     * units of the cost of an arithmetic operation. Used to choose how
+     * far ahead to prefetch (see \ref Func::prefetch). */
+    int memory_latency;
 
-    explicit MachineParams(int parallelism, uint64_t llc, float balance)
-        : parallelism(parallelism), last_level_cache_size(llc), balance(balance) {}
+    explicit MachineParams(int parallelism, uint64_t llc, float balance, uint64_t max_resident_bytes = 0,
+                           int memory_latency = default_memory_latency)
+        : parallelism(parallelism), last_level_cache_size(llc), balance(balance),
+          max_resident_bytes(max_resident_bytes), memory_latency(memory_latency) {}
+
+    /** The memory latency used when none is specified. */
+    static const int default_memory_latency = 200;
 
     /** Default machine parameters for generic CPU architecture. */
     static MachineParams generic();
 
-    /** Convert the MachineParams into canonical string form. */
+    /** Convert the MachineParams into canonical string form. The
+     * memory limit and memory latency are only included if they are
+     * not the defaults. */
     std::string to_string() const;
 
     /** Reconstruct a MachineParams from canonical string form. */
@@ -46,6 +62,15 @@ std::string generate_schedules(const std::vector<Function> &outputs,
                                const Target &target,
                                const MachineParams &arch_params);
 
+/** Return a report of the estimated arithmetic cost, bytes moved,
+ * arithmetic intensity, and whether each stage of a pipeline is likely
+ * to be compute- or memory-bound on a machine described by
+ * 'arch_params'. This uses the cost model of the auto-scheduler, and
+ * requires estimates on the outputs. Funcs that the current schedule
+ * inlines are costed as part of their consumers. */
+std::string generate_roofline_report(const std::vector<Function> &outputs,
+                                     const MachineParams &arch_params);
+
 }  // namespace Internal
 }  // namespace Halide
 
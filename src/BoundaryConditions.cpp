@@ -210,6 +210,18 @@ Func mirror_interior(const Func &source,
     return bounded;
 }
 
+Func padded(const Func &bounded, LoopLevel at) {
+    user_assert(bounded.defined())
+        << "padded called with undefined Func " << bounded.name() << "\n";
+
+    std::vector<Var> args = bounded.args();
+    Func result("padded");
+    result(args) = bounded(args);
+    result.compute_at(at);
+
+    return result;
+}
+
 }  // namespace BoundaryConditions
 
 }  // namespace Halide
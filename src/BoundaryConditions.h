@@ -262,6 +262,25 @@ inline HALIDE_NO_USER_CODE_INLINE Func mirror_interior(const T &func_like, Bound
 }
 // @}
 
+/** Materialize a Func with a boundary condition imposed (e.g. one
+ *  returned by the functions above) into a padded buffer, computed at
+ *  the given loop level. For example:
+ *
+ \code
+ Func input_padded = padded(repeat_edge(input), LoopLevel(output, xo));
+ input_padded.vectorize(_0, 8);
+ \endcode
+ *
+ *  The copy is the only stage that evaluates the boundary condition,
+ *  and its loops can always be partitioned into a clamp-free
+ *  interior. Consumers read the padded buffer directly, so their inner
+ *  loops contain no clamps or selects even when loop partitioning
+ *  can't remove them (e.g. under TailStrategy::GuardWithIf, or with
+ *  bounds that aren't known at compile time). The returned Func can
+ *  be scheduled further like any other.
+ */
+Func padded(const Func &bounded, LoopLevel at = LoopLevel::root());
+
 }  // namespace BoundaryConditions
 
 }  // namespace Halide
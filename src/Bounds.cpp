@@ -781,13 +781,96 @@ private:
         }
     }
 
+    // If cond is a comparison of an integer variable in scope with some
+    // other value, find the narrower range of the variable given that
+    // cond evaluates to the value 'when'.
+    bool bounds_of_var_given_condition(const Expr &cond, bool when, string *var, Interval *result) {
+        if (const Not *n = cond.as<Not>()) {
+            return bounds_of_var_given_condition(n->a, !when, var, result);
+        }
+
+        // Put the condition in the form a < b or a <= b.
+        Expr a, b;
+        bool strict;
+        if (const LT *lt = cond.as<LT>()) {
+            a = lt->a;
+            b = lt->b;
+            strict = true;
+        } else if (const LE *le = cond.as<LE>()) {
+            a = le->a;
+            b = le->b;
+            strict = false;
+        } else if (const GT *gt = cond.as<GT>()) {
+            a = gt->b;
+            b = gt->a;
+            strict = true;
+        } else if (const GE *ge = cond.as<GE>()) {
+            a = ge->b;
+            b = ge->a;
+            strict = false;
+        } else {
+            return false;
+        }
+        if (a.type() != Int(32)) {
+            return false;
+        }
+        if (!when) {
+            std::swap(a, b);
+            strict = !strict;
+        }
+
+        const Variable *v = a.as<Variable>();
+        if (v && scope.contains(v->name)) {
+            b.accept(this);
+            if (!interval.has_upper_bound()) {
+                return false;
+            }
+            *var = v->name;
+            *result = scope.get(v->name);
+            result->max = Interval::make_min(result->max, strict ? interval.max - 1 : interval.max);
+            return true;
+        }
+
+        v = b.as<Variable>();
+        if (v && scope.contains(v->name)) {
+            a.accept(this);
+            if (!interval.has_lower_bound()) {
+                return false;
+            }
+            *var = v->name;
+            *result = scope.get(v->name);
+            result->min = Interval::make_max(result->min, strict ? interval.min + 1 : interval.min);
+            return true;
+        }
+
+        return false;
+    }
+
     void visit(const Select *op) override {
         TRACK_BOUNDS_INTERVAL;
-        op->true_value.accept(this);
-        Interval a = interval;
 
-        op->false_value.accept(this);
-        Interval b = interval;
+        // Bound each value using what the condition implies about the
+        // variable it compares, e.g. in select(x < 10, x, 9) the true
+        // value is at most 9.
+        Interval a, b;
+        {
+            string var;
+            Interval var_bounds;
+            bool refined = (op->condition.type().is_scalar() &&
+                            bounds_of_var_given_condition(op->condition, true, &var, &var_bounds));
+            ScopedBinding<Interval> p(refined, scope, var, var_bounds);
+            op->true_value.accept(this);
+            a = interval;
+        }
+        {
+            string var;
+            Interval var_bounds;
+            bool refined = (op->condition.type().is_scalar() &&
+                            bounds_of_var_given_condition(op->condition, false, &var, &var_bounds));
+            ScopedBinding<Interval> p(refined, scope, var, var_bounds);
+            op->false_value.accept(this);
+            b = interval;
+        }
 
         op->condition.accept(this);
         Interval cond = interval;
@@ -1269,6 +1352,42 @@ private:
         interval = result;
     }
 
+    void visit(const VectorReduce *op) override {
+        TRACK_BOUNDS_INTERVAL;
+        op->value.accept(this);
+        int factor = op->value.type().lanes() / op->type.lanes();
+        switch (op->op) {
+        case VectorReduce::Add:
+            if (interval.has_upper_bound()) {
+                interval.max *= factor;
+            }
+            if (interval.has_lower_bound()) {
+                interval.min *= factor;
+            }
+            break;
+        case VectorReduce::Mul:
+            // Technically there are some things we could say
+            // here. E.g. if all the lanes are positive then we're
+            // bounded by the upper bound raised to the factor
+            // power. However it's extremely unlikely that Mul
+            // will be used in practice.
+            bounds_of_type(op->type);
+            break;
+        case VectorReduce::Min:
+        case VectorReduce::Max:
+            // The min and max are all lanes, or a subset of them.
+            break;
+        case VectorReduce::And:
+        case VectorReduce::Or:
+            // For bools this is min or max respectively. For other
+            // types, the bitwise ops make the bounds hard to track.
+            if (!op->type.is_bool()) {
+                bounds_of_type(op->type);
+            }
+            break;
+        }
+    }
+
     void visit(const LetStmt *) override {
         internal_error << "Bounds of statement\n";
     }
@@ -2486,6 +2605,18 @@ FuncValueBounds compute_function_value_bounds(const vector<string> &order,
                 // are all constant, it may be profitable to calculate the bounds here too
             }
 
+            // Use the range promised by Func::value_bounds, if any.
+            if (!f.value_bounds().empty()) {
+                result = Interval::make_intersection(result, f.value_bounds()[j]);
+                if (result.has_lower_bound()) {
+                    result.min = simplify(result.min);
+                }
+                if (result.has_upper_bound()) {
+                    result.max = simplify(result.max);
+                }
+                fb[key] = result;
+            }
+
             debug(2) << "Bounds on value " << j
                      << " for func " << order[i]
                      << " are: " << result.min << ", " << result.max << "\n";
@@ -2728,6 +2859,12 @@ void bounds_test() {
     check(scope, select(y == 5, 0, 3), select(y == 5, 0, 3), select(y == 5, 0, 3));
     check(scope, select(y == 5, x, -3*x + 8), select(y == 5, 0, -22), select(y == 5, 10, 8));
     check(scope, select(y == x, x, -3*x + 8), -22, select(y <= 10 && 0 <= y, 10, 8));
+    // The condition narrows the range of x in each branch.
+    check(scope, select(x < 4, x, 3), 0, 3);
+    check(scope, select(x < 4, 0, x), 0, 10);
+    check(scope, select(4 < x, x - 5, 0), 0, 5);
+    check(scope, select(!(x <= 6), 0, x), 0, 6);
+    check(scope, select(x <= 7 - 1, x * 2, 12), 0, 12);
 
     check(scope, cast<int32_t>(abs(cast<int16_t>(x/y))), 0, 32768);
     check(scope, cast<float>(x), 0.0f, 10.0f);
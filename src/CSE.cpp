@@ -6,6 +6,8 @@
 #include "IROperator.h"
 #include "Scope.h"
 #include "Simplify.h"
+#include "ThreadPool.h"
+#include "Util.h"
 
 namespace Halide {
 namespace Internal {
@@ -290,8 +292,75 @@ Expr common_subexpression_elimination(const Expr &e_in, bool lift_all) {
     return e;
 }
 
+namespace {
+
+// Find the producers that aren't inside other producers.
+class FindOutermostProducers : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const ProducerConsumer *op) override {
+        if (op->is_producer) {
+            result.push_back(op);
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    vector<const ProducerConsumer *> result;
+};
+
+// CSE everything except the bodies of some producers, which have
+// already been done.
+class CSEAroundProducers : public CSEEveryExprInStmt {
+    using IRMutator::visit;
+
+    const map<const ProducerConsumer *, Stmt> &done;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        auto it = done.find(op);
+        if (it != done.end()) {
+            return ProducerConsumer::make(op->name, op->is_producer, it->second);
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    CSEAroundProducers(bool l, const map<const ProducerConsumer *, Stmt> &d) :
+        CSEEveryExprInStmt(l), done(d) {}
+};
+
+}  // namespace
+
 Stmt common_subexpression_elimination(const Stmt &s, bool lift_all) {
-    return CSEEveryExprInStmt(lift_all).mutate(s);
+    // Each Expr is done independently, so when compiling with
+    // multiple threads we can do the bodies of different producers
+    // concurrently.
+    size_t threads = get_num_compile_threads();
+    FindOutermostProducers producers;
+    if (threads > 1) {
+        s.accept(&producers);
+    }
+    if (producers.result.size() < 2) {
+        return CSEEveryExprInStmt(lift_all).mutate(s);
+    }
+
+    debug(2) << "Doing CSE of " << producers.result.size()
+             << " producers on " << threads << " threads\n";
+    map<const ProducerConsumer *, Stmt> done;
+    {
+        ThreadPool<Stmt> pool(std::min(threads, producers.result.size()));
+        vector<std::future<Stmt>> bodies;
+        for (const ProducerConsumer *p : producers.result) {
+            bodies.push_back(pool.async([=]() {
+                return CSEEveryExprInStmt(lift_all).mutate(p->body);
+            }));
+        }
+        for (size_t i = 0; i < bodies.size(); i++) {
+            done[producers.result[i]] = bodies[i].get();
+        }
+    }
+    return CSEAroundProducers(lift_all, done).mutate(s);
 }
 
 
@@ -35,6 +35,10 @@ CodeGen_ARM::CodeGen_ARM(Target target) : CodeGen_Posix(target) {
         #endif
         user_assert(llvm_AArch64_enabled) << "llvm build not configured with AArch64 target enabled.\n";
     }
+    user_assert(target.bits == 64 ||
+                !(target.has_feature(Target::ARMDotProd) || target.has_feature(Target::ARMFp16) ||
+                  target.has_feature(Target::SVE) || target.has_feature(Target::SVE2)))
+        << "The arm_dot_prod, arm_fp16, sve and sve2 target features are only supported on 64-bit ARM.\n";
 
     // Generate the cast patterns that can take vector types.  We need
     // to iterate over all 64 and 128 bit integer types relevant for
@@ -463,7 +467,100 @@ void CodeGen_ARM::visit(const Div *op) {
     CodeGen_Posix::visit(op);
 }
 
+namespace {
+
+void flatten_sum(const Expr &e, vector<Expr> &terms) {
+    if (const Add *add = e.as<Add>()) {
+        flatten_sum(add->a, terms);
+        flatten_sum(add->b, terms);
+    } else {
+        terms.push_back(e);
+    }
+}
+
+}  // namespace
+
 void CodeGen_ARM::visit(const Add *op) {
+    // A 32-bit sum of widening products of 8-bit values can use the
+    // ARMv8.2 dot product instructions, which add four u8 x u8 (udot)
+    // or i8 x i8 (sdot) products to each lane of an accumulator. The
+    // operands of each group of four products are interleaved so that
+    // the ones summed together are adjacent. Like the sum they
+    // replace, the instructions wrap on overflow.
+    Type t = op->type;
+    if (target.has_feature(Target::ARMDotProd) && !neon_intrinsics_disabled() &&
+        t.is_vector() && (t.is_int() || t.is_uint()) && t.bits() == 32 && t.lanes() % 2 == 0) {
+        vector<Expr> terms;
+        flatten_sum(op, terms);
+
+        Type u8_t = UInt(8, t.lanes()), i8_t = Int(8, t.lanes());
+        // Index 0 holds the udot products, index 1 the sdot ones.
+        vector<Expr> dot_a[2], dot_b[2], dot_terms[2], rest;
+        for (const Expr &term : terms) {
+            const Mul *mul = term.as<Mul>();
+            int kind = -1;
+            Expr a, b;
+            if (mul) {
+                a = lossless_cast(u8_t, mul->a);
+                b = lossless_cast(u8_t, mul->b);
+                if (a.defined() && b.defined()) {
+                    kind = 0;
+                } else {
+                    a = lossless_cast(i8_t, mul->a);
+                    b = lossless_cast(i8_t, mul->b);
+                    if (a.defined() && b.defined()) {
+                        kind = 1;
+                    }
+                }
+            }
+            if (kind < 0) {
+                rest.push_back(term);
+            } else {
+                dot_a[kind].push_back(a);
+                dot_b[kind].push_back(b);
+                dot_terms[kind].push_back(term);
+            }
+        }
+
+        // Pad out a trailing partial group with zeros, unless it
+        // would only contain one real product.
+        for (int kind = 0; kind < 2; kind++) {
+            if (dot_a[kind].size() % 4 == 1) {
+                rest.push_back(dot_terms[kind].back());
+                dot_a[kind].pop_back();
+                dot_b[kind].pop_back();
+            }
+            Type narrow = kind == 0 ? u8_t : i8_t;
+            while (dot_a[kind].size() % 4 != 0) {
+                dot_a[kind].push_back(make_zero(narrow));
+                dot_b[kind].push_back(make_zero(narrow));
+            }
+        }
+
+        if (!dot_a[0].empty() || !dot_a[1].empty()) {
+            Expr acc;
+            for (const Expr &term : rest) {
+                acc = acc.defined() ? acc + term : term;
+            }
+            Value *acc_value = codegen(acc.defined() ? acc : make_zero(t));
+
+            int intrin_lanes = t.lanes() % 4 == 0 ? 4 : 2;
+            string suffix = intrin_lanes == 4 ? ".v4i32.v16i8" : ".v2i32.v8i8";
+            for (int kind = 0; kind < 2; kind++) {
+                string intrin = (kind == 0 ? "llvm.aarch64.neon.udot" : "llvm.aarch64.neon.sdot") + suffix;
+                for (size_t i = 0; i < dot_a[kind].size(); i += 4) {
+                    vector<Expr> a(dot_a[kind].begin() + i, dot_a[kind].begin() + i + 4);
+                    vector<Expr> b(dot_b[kind].begin() + i, dot_b[kind].begin() + i + 4);
+                    Value *a_value = codegen(Shuffle::make_interleave(a));
+                    Value *b_value = codegen(Shuffle::make_interleave(b));
+                    acc_value = call_intrin(llvm_type_of(t), intrin_lanes, intrin, {acc_value, a_value, b_value});
+                }
+            }
+            value = acc_value;
+            return;
+        }
+    }
+
     CodeGen_Posix::visit(op);
 }
 
@@ -657,8 +754,8 @@ void CodeGen_ARM::visit(const Max *op) {
 }
 
 void CodeGen_ARM::visit(const Store *op) {
-    // Predicated store
-    if (!is_one(op->predicate)) {
+    // Predicated or atomic store
+    if (!is_one(op->predicate) || atomic_producers.contains(op->name)) {
         CodeGen_Posix::visit(op);
         return;
     }
@@ -1005,6 +1102,66 @@ void CodeGen_ARM::visit(const Call *op) {
     CodeGen_Posix::visit(op);
 }
 
+void CodeGen_ARM::visit(const VectorReduce *op) {
+    const Type t = op->type;
+    const int factor = op->value.type().lanes() / t.lanes();
+    const bool is_integer = (t.is_int() || t.is_uint()) && t.bits() >= 8;
+
+    // Widening sums of adjacent pairs of lanes are vpaddl (arm32) or
+    // saddlp/uaddlp (arm64).
+    const Cast *cast = op->value.as<Cast>();
+    if (op->op == VectorReduce::Add &&
+        factor == 2 &&
+        t.is_vector() &&
+        is_integer &&
+        t.bits() >= 16 &&
+        cast &&
+        (cast->value.type().is_int() || cast->value.type().is_uint()) &&
+        cast->value.type().bits() * 2 == t.bits()) {
+        Type narrow = cast->value.type();
+        int intrin_lanes = 128 / t.bits();
+        string suffix = ".v" + std::to_string(intrin_lanes) + "i" + std::to_string(t.bits()) +
+            ".v" + std::to_string(intrin_lanes * 2) + "i" + std::to_string(narrow.bits());
+        string intrin;
+        if (target.bits == 32) {
+            intrin = (narrow.is_int() ? "llvm.arm.neon.vpaddls" : "llvm.arm.neon.vpaddlu") + suffix;
+        } else {
+            intrin = (narrow.is_int() ? "llvm.aarch64.neon.saddlp" : "llvm.aarch64.neon.uaddlp") + suffix;
+        }
+        value = call_intrin(t, intrin_lanes, intrin, {cast->value});
+        return;
+    }
+
+    // Integer reductions all the way to a scalar have single
+    // instructions on arm64 (addv, sminv, etc.), which the LLVM
+    // reduction intrinsics select.
+    if (target.bits == 64 && t.is_scalar() && is_integer && op->op != VectorReduce::Mul) {
+        Value *v = codegen(op->value);
+        switch (op->op) {
+        case VectorReduce::Add:
+            value = builder->CreateAddReduce(v);
+            break;
+        case VectorReduce::Min:
+            value = builder->CreateIntMinReduce(v, t.is_int());
+            break;
+        case VectorReduce::Max:
+            value = builder->CreateIntMaxReduce(v, t.is_int());
+            break;
+        case VectorReduce::And:
+            value = builder->CreateAndReduce(v);
+            break;
+        case VectorReduce::Or:
+            value = builder->CreateOrReduce(v);
+            break;
+        case VectorReduce::Mul:
+            internal_error << "Unreachable";
+        }
+        return;
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
 string CodeGen_ARM::mcpu() const {
     if (target.bits == 32) {
         if (target.has_feature(Target::ARMv7s)) {
@@ -1031,11 +1188,30 @@ string CodeGen_ARM::mattrs() const {
             return "-neon";
         }
     } else {
+        std::string features;
+        std::string separator;
         if (target.os == Target::IOS || target.os == Target::OSX) {
-            return "+reserve-x18";
-        } else {
-            return "";
+            features += "+reserve-x18";
+            separator = ",";
+        }
+        if (target.has_feature(Target::ARMDotProd)) {
+            features += separator + "+dotprod";
+            separator = ",";
+        }
+        if (target.has_feature(Target::ARMFp16)) {
+            features += separator + "+fullfp16";
+            separator = ",";
+        }
+        // Vectors are still NEON-width (the minimum SVE vector
+        // length), but LLVM may select SVE instructions for them.
+        if (target.has_feature(Target::SVE2)) {
+            features += separator + "+sve2";
+            separator = ",";
+        } else if (target.has_feature(Target::SVE)) {
+            features += separator + "+sve";
+            separator = ",";
         }
+        return features;
     }
 }
 
@@ -31,6 +31,8 @@ extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeOpenGLCompu
 extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeOpenGL_h[];
 extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeQurt_h[];
 extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeD3D12Compute_h[];
+extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeVulkan_h[];
+extern "C" unsigned char halide_internal_runtime_header_HalideRuntimeWebGPU_h[];
 
 namespace {
 
@@ -398,6 +400,12 @@ CodeGen_C::~CodeGen_C() {
             if (target.has_feature(Target::D3D12Compute)) {
                 stream << halide_internal_runtime_header_HalideRuntimeD3D12Compute_h << '\n';
             }
+            if (target.has_feature(Target::Vulkan)) {
+                stream << halide_internal_runtime_header_HalideRuntimeVulkan_h << '\n';
+            }
+            if (target.has_feature(Target::WebGPU)) {
+                stream << halide_internal_runtime_header_HalideRuntimeWebGPU_h << '\n';
+            }
         }
         stream << "#endif\n";
     }
@@ -408,7 +416,16 @@ string type_to_c_type(Type type, bool include_space, bool c_plus_plus = true) {
     bool needs_space = true;
     ostringstream oss;
 
-    if (type.is_float()) {
+    if (type.is_bfloat()) {
+        // Arithmetic on bfloats has already been emulated in float,
+        // so only the bits remain.
+        user_assert(type.bits() == 16) << "Can't represent a bfloat with this many bits in C: " << type << "\n";
+        oss << "uint16";
+        if (type.is_vector()) {
+            oss << "x" << type.lanes();
+        }
+        oss << "_t";
+    } else if (type.is_float()) {
         if (type.bits() == 32) {
             oss << "float";
         } else if (type.bits() == 64) {
@@ -593,6 +610,26 @@ public:
         }
     }
 
+    // predicated gather; inactive lanes read as zero
+    static Vec load_predicated(const void *base, const CppVector<int32_t, Lanes> &offset, const Mask &predicate) {
+        Vec r;
+        for (size_t i = 0; i < Lanes; i++) {
+            if (predicate[i]) {
+                r.elements[i] = ((const ElementType*)base)[offset[i]];
+            }
+        }
+        return r;
+    }
+
+    // predicated scatter
+    void store_predicated(void *base, const CppVector<int32_t, Lanes> &offset, const Mask &predicate) const {
+        for (size_t i = 0; i < Lanes; i++) {
+            if (predicate[i]) {
+                ((ElementType*)base)[offset[i]] = elements[i];
+            }
+        }
+    }
+
     static Vec shuffle(const Vec &a, const int32_t indices[Lanes]) {
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
@@ -1051,6 +1088,35 @@ public:
         }
     }
 
+    // predicated gather; inactive lanes read as zero
+    static Vec load_predicated(const void *base, const NativeVector<int32_t, Lanes> &offset, const Mask &predicate) {
+        Vec r;
+        for (size_t i = 0; i < Lanes; i++) {
+            if (predicate[i]) {
+                r.native_vector[i] = ((const ElementType*)base)[offset[i]];
+            }
+        }
+        return r;
+    }
+
+    // predicated scatter
+    void store_predicated(void *base, const NativeVector<int32_t, Lanes> &offset, const Mask &predicate) const {
+        for (size_t i = 0; i < Lanes; i++) {
+            if (predicate[i]) {
+                ((ElementType*)base)[offset[i]] = native_vector[i];
+            }
+        }
+    }
+
+    // Access to the underlying vector, for the compiler builtins
+    // (e.g. __builtin_shufflevector) emitted inline by CodeGen_C.
+    const NativeVectorType &native() const {
+        return native_vector;
+    }
+    static Vec from_native(const NativeVectorType &src) {
+        return Vec(from_native_vector, src);
+    }
+
     // TODO: this should be improved by taking advantage of native operator support.
     static Vec shuffle(const Vec &a, const int32_t indices[Lanes]) {
         Vec r(empty);
@@ -1221,58 +1287,28 @@ public:
         return r;
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] < b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector < b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator<=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] <= b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector <= b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] > b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector > b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator>=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] >= b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector >= b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator==(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] == b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector == b.native_vector);
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     friend Mask operator!=(const Vec &a, const Vec &b) {
-        Mask r;
-        for (size_t i = 0; i < Lanes; i++) {
-            r.native_vector[i] = a[i] != b[i] ? 0xff : 0x00;
-        }
-        return r;
+        return to_mask(a.native_vector != b.native_vector);
     }
 
     // TODO: this should be improved by taking advantage of native operator support.
@@ -1289,23 +1325,32 @@ public:
         #if __cplusplus >= 201103L
         static_assert(Vec::Lanes == OtherVec::Lanes, "Lanes mismatch");
         #endif
-#if 0 // __has_builtin(__builtin_convertvector)
-        // Disabled (for now) because __builtin_convertvector appears to have
-        // different float->int rounding behavior in at least some situations;
-        // for now we'll use the much-slower-but-correct explicit C++ code.
-        // (https://github.com/halide/Halide/issues/2080)
-        return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
-#else
+#if __has_builtin(__builtin_convertvector)
+        // __builtin_convertvector appears to have different float->int
+        // rounding behavior in at least some situations
+        // (https://github.com/halide/Halide/issues/2080), so only use it
+        // for the other conversions (e.g. integer widening and narrowing).
+        const bool src_is_float = (typename OtherVec::ElementType)0.5f != 0;
+        const bool dst_is_float = (ElementType)0.5f != 0;
+        if (!src_is_float || dst_is_float) {
+            return Vec(from_native_vector, __builtin_convertvector(src.native_vector, NativeVectorType));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = static_cast<typename Vec::ElementType>(src.native_vector[i]);
         }
         return r;
-#endif
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec max(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_elementwise_max)
+        // Only for integers; the float versions have different NaN
+        // semantics than halide_cpp_max.
+        if ((ElementType)0.5f == 0) {
+            return Vec(from_native_vector, __builtin_elementwise_max(a.native_vector, b.native_vector));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = ::halide_cpp_max(a[i], b[i]);
@@ -1313,8 +1358,12 @@ public:
         return r;
     }
 
-    // TODO: this should be improved by taking advantage of native operator support.
     static Vec min(const Vec &a, const Vec &b) {
+#if __has_builtin(__builtin_elementwise_min)
+        if ((ElementType)0.5f == 0) {
+            return Vec(from_native_vector, __builtin_elementwise_min(a.native_vector, b.native_vector));
+        }
+#endif
         Vec r(empty);
         for (size_t i = 0; i < Lanes; i++) {
             r.native_vector[i] = ::halide_cpp_min(a[i], b[i]);
@@ -1327,6 +1376,21 @@ private:
 
     NativeVectorType native_vector;
 
+    // Native vector comparisons produce lanes of all ones or all
+    // zeros, as wide as the lanes compared; narrow them to a Mask.
+    template <typename CompareResult>
+    static Mask to_mask(const CompareResult &c) {
+#if __has_builtin(__builtin_convertvector)
+        return Mask::from_native(__builtin_convertvector(c, typename Mask::NativeVectorType));
+#else
+        Mask r;
+        for (size_t i = 0; i < Lanes; i++) {
+            r.native_vector[i] = c[i] ? 0xff : 0x00;
+        }
+        return r;
+#endif
+    }
+
     // Leave vector uninitialized for cases where we overwrite every entry
     enum Empty { empty };
     inline NativeVector(Empty) {}
@@ -1787,6 +1851,16 @@ void CodeGen_C::compile(const LoweredFunc &f) {
 
         // And also the metadata.
         stream << "const struct halide_filter_metadata_t *" << simple_name << "_metadata() HALIDE_FUNCTION_ATTRS;\n";
+
+        // And the function that does any lazy initialization ahead of
+        // the first call.
+        stream << "int " << simple_name << "_prewarm(void *user_context) HALIDE_FUNCTION_ATTRS;\n";
+
+        // And the argv and batch versions of the trusted entry point.
+        if (target.has_feature(Target::TrustedEntry)) {
+            stream << "int " << simple_name << "_trusted_argv(void **args) HALIDE_FUNCTION_ATTRS;\n";
+            stream << "int " << simple_name << "_trusted_batch(int count, void ***args) HALIDE_FUNCTION_ATTRS;\n";
+        }
     }
 
     if (!namespaces.empty()) {
@@ -2234,6 +2308,15 @@ void CodeGen_C::visit(const Call *op) {
             stream << "uint64_t " << array_name << "[" << size << "];";
             rhs << "(" << print_type(op->type) << ")(&" << array_name << ")";
         }
+    } else if (op->is_intrinsic(Call::bounds_check_cache)) {
+        internal_assert(op->args.size() == 1);
+        const int64_t *size = as_const_int(op->args[0]);
+        internal_assert(size);
+        // A mutex, a valid flag, and the key.
+        do_indent();
+        string array_name = unique_name('c');
+        stream << "static int64_t " << array_name << "[" << (*size + 2) << "] = {0};\n";
+        rhs << "(" << print_type(op->type) << ")(&" << array_name << ")";
     } else if (op->is_intrinsic(Call::make_struct)) {
         if (op->args.empty()) {
             internal_assert(op->type.handle_type);
@@ -2428,8 +2511,6 @@ string CodeGen_C::print_extern_call(const Call *op) {
 }
 
 void CodeGen_C::visit(const Load *op) {
-    user_assert(is_one(op->predicate)) << "Predicated load is not supported by C backend.\n";
-
     // TODO: We could replicate the logic in the llvm codegen which decides whether
     // the vector access can be aligned. Doing so would also require introducing
     // aligned type equivalents for all the vector types.
@@ -2440,7 +2521,16 @@ void CodeGen_C::visit(const Load *op) {
 
     // If we're loading a contiguous ramp into a vector, just load the vector
     Expr dense_ramp_base = strided_ramp_base(op->index, 1);
-    if (dense_ramp_base.defined()) {
+    if (!is_one(op->predicate)) {
+        string id_index = print_expr(op->index);
+        string id_predicate = print_expr(op->predicate);
+        if (t.is_vector()) {
+            rhs << print_type(t) + "::load_predicated(" << name << ", " << id_index << ", " << id_predicate << ")";
+        } else {
+            rhs << "(" << id_predicate << " ? ((const " << print_type(t) << " *)" << name << ")[" << id_index << "] : "
+                << print_type(t) << "())";
+        }
+    } else if (dense_ramp_base.defined()) {
         internal_assert(t.is_vector());
         string id_ramp_base = print_expr(dense_ramp_base);
         rhs << print_type(t) + "::load(" << name << ", " << id_ramp_base << ")";
@@ -2464,8 +2554,6 @@ void CodeGen_C::visit(const Load *op) {
 }
 
 void CodeGen_C::visit(const Store *op) {
-    user_assert(is_one(op->predicate)) << "Predicated store is not supported by C backend.\n";
-
     Type t = op->value.type();
     string id_value = print_expr(op->value);
     string name = print_name(op->name);
@@ -2476,7 +2564,17 @@ void CodeGen_C::visit(const Store *op) {
 
     // If we're writing a contiguous ramp, just store the vector.
     Expr dense_ramp_base = strided_ramp_base(op->index, 1);
-    if (dense_ramp_base.defined()) {
+    if (!is_one(op->predicate)) {
+        string id_index = print_expr(op->index);
+        string id_predicate = print_expr(op->predicate);
+        do_indent();
+        if (t.is_vector()) {
+            stream << id_value + ".store_predicated(" << name << ", " << id_index << ", " << id_predicate << ");\n";
+        } else {
+            stream << "if (" << id_predicate << ") ((" << print_type(t) << " *)" << name << ")["
+                   << id_index << "] = " << id_value << ";\n";
+        }
+    } else if (dense_ramp_base.defined()) {
         internal_assert(op->value.type().is_vector());
         string id_ramp_base = print_expr(dense_ramp_base);
         do_indent();
@@ -2834,6 +2932,11 @@ void CodeGen_C::visit(const Prefetch *op) {
     internal_error << "Cannot emit prefetch statements to C\n";
 }
 
+void CodeGen_C::visit(const Atomic *op) {
+    user_error << "Can't generate code for an atomic() update of " << op->producer_name
+               << " to C source. Only the LLVM-based backends and OpenCL support atomic().\n";
+}
+
 void CodeGen_C::visit(const IfThenElse *op) {
     string cond_id = print_expr(op->condition);
 
@@ -2859,6 +2962,10 @@ void CodeGen_C::visit(const Evaluate *op) {
     stream << "(void)" << id << ";\n";
 }
 
+void CodeGen_C::visit(const VectorReduce *op) {
+    id = print_expr(lower_vector_reduce(op));
+}
+
 void CodeGen_C::visit(const Shuffle *op) {
     internal_assert(op->vectors.size() >= 1);
     internal_assert(op->vectors[0].type().is_vector());
@@ -2875,6 +2982,29 @@ void CodeGen_C::visit(const Shuffle *op) {
     for (Expr v : op->vectors) {
         vecs.push_back(print_expr(v));
     }
+
+    // Shuffles of one or two native vectors (which covers interleaves,
+    // slices, and deinterleaves) can use __builtin_shufflevector where
+    // the compiler provides it, rather than a per-lane loop. Whether a
+    // type is native is only known when the C++ is compiled, so emit both
+    // versions.
+    const bool try_shufflevector = op->type.is_vector() && op->vectors.size() <= 2;
+    string result_id;
+    if (try_shufflevector) {
+        Type in_t = op->vectors[0].type();
+        string scalar_name = type_to_c_type(in_t.element_of(), false, false);
+        result_id = unique_name('_');
+        stream << "#if __has_builtin(__builtin_shufflevector)"
+               << " && halide_cpp_use_native_vector(" << scalar_name << ", " << in_t.lanes() << ")"
+               << " && halide_cpp_use_native_vector(" << scalar_name << ", " << op->type.lanes() << ")\n";
+        do_indent();
+        stream << print_type(op->type, AppendSpace) << result_id << " = "
+               << print_type(op->type) << "::from_native(__builtin_shufflevector("
+               << vecs[0] << ".native(), " << vecs.back() << ".native(), "
+               << with_commas(op->indices) << "));\n";
+        stream << "#else\n";
+    }
+
     string src = vecs[0];
     if (op->vectors.size() > 1) {
         ostringstream rhs;
@@ -2883,7 +3013,14 @@ void CodeGen_C::visit(const Shuffle *op) {
         stream << "const " << print_type(op->vectors[0].type()) << " " << storage_name << "[] = { " << with_commas(vecs) << " };\n";
 
         rhs << print_type(op->type) << "::concat(" << op->vectors.size() << ", " << storage_name << ")";
-        src = print_assignment(op->type, rhs.str());
+        if (try_shufflevector) {
+            // Don't cache anything declared inside the #if
+            src = unique_name('_');
+            do_indent();
+            stream << print_type(op->type, AppendSpace) << src << " = " << rhs.str() << ";\n";
+        } else {
+            src = print_assignment(op->type, rhs.str());
+        }
     }
     ostringstream rhs;
     if (op->type.is_scalar()) {
@@ -2894,7 +3031,14 @@ void CodeGen_C::visit(const Shuffle *op) {
         stream << "const int32_t " << indices_name << "[" << op->indices.size() << "] = { " << with_commas(op->indices) << " };\n";
         rhs << print_type(op->type) << "::shuffle(" << src << ", " << indices_name << ")";
     }
-    print_assignment(op->type, rhs.str());
+    if (try_shufflevector) {
+        do_indent();
+        stream << print_type(op->type, AppendSpace) << result_id << " = " << rhs.str() << ";\n";
+        stream << "#endif\n";
+        id = result_id;
+    } else {
+        print_assignment(op->type, rhs.str());
+    }
 }
 
 void CodeGen_C::test() {
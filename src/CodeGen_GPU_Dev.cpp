@@ -95,5 +95,30 @@ bool CodeGen_GPU_Dev::is_buffer_constant(Stmt kernel,
     return v.result;
 }
 
+namespace {
+class FindGPUShuffles : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) override {
+        if (op->name == "halide_gpu_shuffle") {
+            internal_assert(op->args.size() == 3);
+            const int64_t *width = as_const_int(op->args[2]);
+            internal_assert(width) << "halide_gpu_shuffle with non-constant width\n";
+            result = std::max(result, (int)*width);
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    int result = 0;
+};
+}  // namespace
+
+int CodeGen_GPU_Dev::gpu_shuffle_width(Stmt kernel) {
+    FindGPUShuffles v;
+    kernel.accept(&v);
+    return v.result;
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -63,6 +63,11 @@ struct CodeGen_GPU_Dev {
      * candidate for constant storage if it is never written to, and loads are
      * uniform within the workgroup. */
     static bool is_buffer_constant(Stmt kernel, const std::string &buffer);
+
+    /** Returns the widest group of lanes exchanged by the
+     * halide_gpu_shuffle calls that lower_warp_shuffles inserts into
+     * the kernel, or zero if it has none. */
+    static int gpu_shuffle_width(Stmt kernel);
 };
 
 }  // namespace Internal
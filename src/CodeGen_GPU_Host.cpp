@@ -8,6 +8,8 @@
 #include "CodeGen_OpenGL_Dev.h"
 #include "CodeGen_PTX_Dev.h"
 #include "CodeGen_D3D12Compute_Dev.h"
+#include "CodeGen_Vulkan_Dev.h"
+#include "CodeGen_WebGPU_Dev.h"
 #include "Debug.h"
 #include "ExprUsesVar.h"
 #include "IROperator.h"
@@ -125,6 +127,14 @@ CodeGen_GPU_Host<CodeGen_CPU>::CodeGen_GPU_Host(Target target) : CodeGen_CPU(tar
         debug(1) << "Constructing Direct3D 12 Compute device codegen\n";
         cgdev[DeviceAPI::D3D12Compute] = new CodeGen_D3D12Compute_Dev(target);
     }
+    if (target.has_feature(Target::Vulkan)) {
+        debug(1) << "Constructing Vulkan device codegen\n";
+        cgdev[DeviceAPI::Vulkan] = new CodeGen_Vulkan_Dev(target);
+    }
+    if (target.has_feature(Target::WebGPU)) {
+        debug(1) << "Constructing WebGPU device codegen\n";
+        cgdev[DeviceAPI::WebGPU] = new CodeGen_WebGPU_Dev(target);
+    }
 
     if (cgdev.empty()) {
         internal_error << "Requested unknown GPU target: " << target.to_string() << "\n";
@@ -143,6 +153,7 @@ void CodeGen_GPU_Host<CodeGen_CPU>::compile_func(const LoweredFunc &f,
                                                  const std::string &simple_name,
                                                  const std::string &extern_name) {
     function_name = simple_name;
+    kernel_inits.clear();
 
     // Create a new module for all of the kernels we find in this function.
     for (pair<const DeviceAPI, CodeGen_GPU_Dev *> &i : cgdev) {
@@ -205,12 +216,13 @@ void CodeGen_GPU_Host<CodeGen_CPU>::compile_func(const LoweredFunc &f,
         Value *user_context = get_user_context();
         Value *kernel_size = ConstantInt::get(i32_t, kernel_src.size());
         std::string init_kernels_name = "halide_" + api_unique_name + "_initialize_kernels";
-        Value *init = module->getFunction(init_kernels_name);
+        llvm::Function *init = module->getFunction(init_kernels_name);
         internal_assert(init) << "Could not find function " + init_kernels_name + " in initial module\n";
         vector<Value *> init_kernels_args = {user_context, module_state, kernel_src_ptr, kernel_size};
         Value *result = builder->CreateCall(init, init_kernels_args);
         Value *did_succeed = builder->CreateICmpEQ(result, ConstantInt::get(i32_t, 0));
         CodeGen_CPU::create_assertion(did_succeed, Expr(), result);
+        kernel_inits.push_back({init, module_state, kernel_src_ptr, kernel_size});
     }
 
     // the init kernels block should branch to the post-entry block
@@ -220,6 +232,47 @@ void CodeGen_GPU_Host<CodeGen_CPU>::compile_func(const LoweredFunc &f,
 
 }
 
+// Make a function of the form
+//
+//    int name(void *user_context) {
+//        int result = halide_<api>_initialize_kernels(user_context, ...);
+//        if (result != 0) return result;
+//        ...
+//        return 0;
+//    }
+//
+// with the same calls the function just compiled makes on entry, so
+// that the kernels can be loaded ahead of the first call, e.g. on a
+// background thread at startup.
+template<typename CodeGen_CPU>
+llvm::Function *CodeGen_GPU_Host<CodeGen_CPU>::add_prewarm_function(const std::string &name) {
+    if (kernel_inits.empty()) {
+        return CodeGen_CPU::add_prewarm_function(name);
+    }
+
+    llvm::Type *args_t[] = {i8_t->getPointerTo()};
+    llvm::FunctionType *func_t = llvm::FunctionType::get(i32_t, args_t, false);
+    llvm::Function *func = llvm::Function::Create(func_t, llvm::GlobalValue::ExternalLinkage, name, module.get());
+    BasicBlock *entry_bb = BasicBlock::Create(*context, "entry", func);
+    builder->SetInsertPoint(entry_bb);
+
+    Value *user_context = iterator_to_pointer(func->arg_begin());
+    for (const KernelInit &k : kernel_inits) {
+        Value *uc = builder->CreatePointerCast(user_context, k.init->getFunctionType()->getParamType(0));
+        Value *result = builder->CreateCall(k.init, {uc, k.module_state, k.kernel_src, k.kernel_size});
+        BasicBlock *fail_bb = BasicBlock::Create(*context, "init_kernels_failed", func);
+        BasicBlock *next_bb = BasicBlock::Create(*context, "init_kernels_succeeded", func);
+        builder->CreateCondBr(builder->CreateIsNotNull(result), fail_bb, next_bb);
+        builder->SetInsertPoint(fail_bb);
+        builder->CreateRet(result);
+        builder->SetInsertPoint(next_bb);
+    }
+    builder->CreateRet(ConstantInt::get(i32_t, 0));
+
+    internal_assert(!verifyFunction(*func, &llvm::errs()));
+    return func;
+}
+
 template<typename CodeGen_CPU>
 void CodeGen_GPU_Host<CodeGen_CPU>::visit(const For *loop) {
     if (CodeGen_GPU_Dev::is_gpu_var(loop->name)) {
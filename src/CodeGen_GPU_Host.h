@@ -36,6 +36,9 @@ public:
 protected:
     void compile_func(const LoweredFunc &func, const std::string &simple_name, const std::string &extern_name) override;
 
+    /** Initialize the kernels of the function just compiled. */
+    llvm::Function *add_prewarm_function(const std::string &name) override;
+
     /** Declare members of the base class that must exist to help the
      * compiler do name lookup. Annoying but necessary, because the
      * compiler doesn't know that CodeGen_CPU will in fact inherit
@@ -77,6 +80,15 @@ protected:
 private:
     /** Child code generator for device kernels. */
     std::map<DeviceAPI, CodeGen_GPU_Dev *> cgdev;
+
+    /** The arguments to the calls to the initialize_kernels runtime
+     * functions made by the function just compiled, which
+     * add_prewarm_function calls too. */
+    struct KernelInit {
+        llvm::Function *init;
+        llvm::Value *module_state, *kernel_src, *kernel_size;
+    };
+    std::vector<KernelInit> kernel_inits;
 };
 
 }  // namespace Internal
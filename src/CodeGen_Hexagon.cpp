@@ -48,7 +48,11 @@ CodeGen_Hexagon::CodeGen_Hexagon(Target t) : CodeGen_Posix(t) {
     user_error << "hexagon not enabled for this build of Halide.\n";
 #endif
     user_assert(llvm_Hexagon_enabled) << "llvm build not configured with Hexagon target enabled.\n";
-    if (target.has_feature(Halide::Target::HVX_v66)) {
+    if (target.has_feature(Halide::Target::HVX_v69)) {
+        isa_version = 69;
+    } else if (target.has_feature(Halide::Target::HVX_v68)) {
+        isa_version = 68;
+    } else if (target.has_feature(Halide::Target::HVX_v66)) {
         isa_version = 66;
     } else if (target.has_feature(Halide::Target::HVX_v65)) {
         isa_version = 65;
@@ -59,6 +63,8 @@ CodeGen_Hexagon::CodeGen_Hexagon(Target t) : CodeGen_Posix(t) {
     }
     user_assert(!target.features_all_of({Halide::Target::HVX_128, Halide::Target::HVX_64}))
         << "Cannot set both HVX_64 and HVX_128 at the same time.\n";
+    user_assert(isa_version < 68 || !target.has_feature(Halide::Target::HVX_64))
+        << "HVX v68 and later only support 128 byte vectors (HVX_128).\n";
 }
 
 namespace {
@@ -272,6 +278,14 @@ void CodeGen_Hexagon::compile_func(const LoweredFunc &f,
     body = unpredicate_loads_stores(body);
     debug(2) << "Lowering after unpredicating loads/stores:\n" << body << "\n\n";
 
+    if (target.has_feature(Target::HVX_v65) && target.has_feature(Target::HVX_AutoVTCM)) {
+        // Leave half of the VTCM pool in the runtime for allocations
+        // explicitly stored in VTCM.
+        debug(1) << "Placing allocations in VTCM...\n";
+        body = place_allocations_in_vtcm(body, 128 * 1024);
+        debug(2) << "Lowering after placing allocations in VTCM:\n" << body << "\n\n";
+    }
+
     if (target.has_feature(Target::HVX_v65)) {
         // Generate vscatter-vgathers before optimize_hexagon_shuffles.
         debug(1) << "Looking for vscatter-vgather...\n";
@@ -1484,7 +1498,12 @@ namespace {
 
 string type_suffix(Type type, bool signed_variants = true) {
     string prefix = type.is_vector() ? ".v" : ".";
-    if (type.is_int() || !signed_variants) {
+    if (type.is_float()) {
+        switch (type.bits()) {
+        case 16: return prefix + "hf";
+        case 32: return prefix + "sf";
+        }
+    } else if (type.is_int() || !signed_variants) {
         switch (type.bits()) {
         case 8: return prefix + "b";
         case 16: return prefix + "h";
@@ -1561,7 +1580,11 @@ Value *CodeGen_Hexagon::call_intrin(llvm::Type *result_type, const string &name,
 }
 
 string CodeGen_Hexagon::mcpu() const {
-    if (target.has_feature(Halide::Target::HVX_v66)) {
+    if (target.has_feature(Halide::Target::HVX_v69)) {
+        return "hexagonv69";
+    } else if (target.has_feature(Halide::Target::HVX_v68)) {
+        return "hexagonv68";
+    } else if (target.has_feature(Halide::Target::HVX_v66)) {
         return "hexagonv66";
     } else if (target.has_feature(Halide::Target::HVX_v65)) {
         return "hexagonv65";
@@ -1579,6 +1602,10 @@ string CodeGen_Hexagon::mattrs() const {
     } else {
         attrs << "+hvx-length64b";
     }
+    if (isa_version >= 68) {
+        // v68 adds IEEE and qfloat floating point vector instructions.
+        attrs << ",+hvx-qfloat,+hvx-ieee-fp";
+    }
     attrs << ",+long-calls";
     return attrs.str();
 }
@@ -1596,7 +1623,9 @@ int CodeGen_Hexagon::native_vector_bits() const {
 }
 
 void CodeGen_Hexagon::visit(const Add *op) {
-    if (op->type.is_vector()) {
+    if (op->type.is_float() && !is_hvx_float_supported(op->type)) {
+        CodeGen_Posix::visit(op);
+    } else if (op->type.is_vector()) {
         value = call_intrin(op->type,
                             "halide.hexagon.add" + type_suffix(op->a, op->b, false),
                             {op->a, op->b});
@@ -1606,7 +1635,9 @@ void CodeGen_Hexagon::visit(const Add *op) {
 }
 
 void CodeGen_Hexagon::visit(const Sub *op) {
-    if (op->type.is_vector()) {
+    if (op->type.is_float() && !is_hvx_float_supported(op->type)) {
+        CodeGen_Posix::visit(op);
+    } else if (op->type.is_vector()) {
         value = call_intrin(op->type,
                             "halide.hexagon.sub" + type_suffix(op->a, op->b, false),
                             {op->a, op->b});
@@ -1629,7 +1660,9 @@ Expr maybe_scalar(Expr x) {
 }  // namespace
 
 void CodeGen_Hexagon::visit(const Mul *op) {
-    if (op->type.is_vector()) {
+    if (op->type.is_float() && !is_hvx_float_supported(op->type)) {
+        CodeGen_Posix::visit(op);
+    } else if (op->type.is_vector()) {
         value = call_intrin(op->type,
                             "halide.hexagon.mul" + type_suffix(op->a, op->b),
                             {op->a, op->b},
@@ -1915,8 +1948,9 @@ void CodeGen_Hexagon::visit(const Call *op) {
 }
 
 void CodeGen_Hexagon::visit(const Broadcast *op) {
-    if (op->lanes * op->type.bits() <= 32) {
-        // If the result is not more than 32 bits, just use scalar code.
+    if (op->lanes * op->type.bits() <= 32 || op->type.is_float()) {
+        // If the result is not more than 32 bits, just use scalar
+        // code. There are no float splats, LLVM handles those.
         CodeGen_Posix::visit(op);
     } else {
         // TODO: Use vd0?
@@ -1931,7 +1965,9 @@ void CodeGen_Hexagon::visit(const Broadcast *op) {
 }
 
 void CodeGen_Hexagon::visit(const Max *op) {
-    if (op->type.is_vector()) {
+    if (op->type.is_float() && !is_hvx_float_supported(op->type)) {
+        CodeGen_Posix::visit(op);
+    } else if (op->type.is_vector()) {
         value = call_intrin(op->type,
                             "halide.hexagon.max" + type_suffix(op->a, op->b),
                             {op->a, op->b},
@@ -1948,7 +1984,9 @@ void CodeGen_Hexagon::visit(const Max *op) {
 }
 
 void CodeGen_Hexagon::visit(const Min *op) {
-    if (op->type.is_vector()) {
+    if (op->type.is_float() && !is_hvx_float_supported(op->type)) {
+        CodeGen_Posix::visit(op);
+    } else if (op->type.is_vector()) {
         value = call_intrin(op->type,
                             "halide.hexagon.min" + type_suffix(op->a, op->b),
                             {op->a, op->b},
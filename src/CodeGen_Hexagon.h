@@ -39,6 +39,9 @@ protected:
 
     int is_hvx_v62_or_later() {return (isa_version >= 62);}
     int is_hvx_v65_or_later() {return (isa_version >= 65);}
+    int is_hvx_v68_or_later() {return (isa_version >= 68);}
+    /** HVX float arithmetic (on float16 and float32 only) requires v68. */
+    bool is_hvx_float_supported(Type t) {return is_hvx_v68_or_later() && t.bits() <= 32;}
 
     using CodeGen_Posix::visit;
 
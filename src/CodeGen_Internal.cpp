@@ -1,10 +1,13 @@
 #include "CodeGen_Internal.h"
 #include "CSE.h"
 #include "Debug.h"
+#include "Deinterleave.h"
+#include "IREquality.h"
 #include "IntegerDivisionTable.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "LLVM_Headers.h"
+#include "Substitute.h"
 
 namespace Halide {
 namespace Internal {
@@ -113,7 +116,12 @@ void unpack_closure(const Closure& closure,
 
 llvm::Type *llvm_type_of(LLVMContext *c, Halide::Type t) {
     if (t.lanes() == 1) {
-        if (t.is_float()) {
+        if (t.is_bfloat()) {
+            // LLVM has no bfloat type. Arithmetic on bfloats has
+            // already been emulated in float, so only the bits are
+            // moved around.
+            return llvm::Type::getIntNTy(*c, t.bits());
+        } else if (t.is_float()) {
             switch (t.bits()) {
             case 16:
                 return llvm::Type::getHalfTy(*c);
@@ -174,12 +182,24 @@ bool function_takes_user_context(const std::string &name) {
         "halide_memoization_cache_lookup",
         "halide_memoization_cache_store",
         "halide_memoization_cache_release",
+        "halide_bounds_check_cache_lookup",
+        "halide_bounds_check_cache_store",
+        "halide_memory_pool_create",
+        "halide_memory_pool_acquire",
+        "halide_memory_pool_release",
+        "halide_memory_pool_destroy",
+        "halide_arena_create",
+        "halide_arena_alloc",
+        "halide_arena_free",
+        "halide_arena_destroy",
         "halide_cuda_run",
         "halide_opencl_run",
         "halide_opengl_run",
         "halide_openglcompute_run",
         "halide_metal_run",
         "halide_d3d12compute_run",
+        "halide_vulkan_run",
+        "halide_webgpu_run",
         "halide_msan_annotate_buffer_is_initialized_as_destructor",
         "halide_msan_annotate_buffer_is_initialized",
         "halide_msan_annotate_memory_is_initialized",
@@ -202,6 +222,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_openglcompute_initialize_kernels",
         "halide_metal_initialize_kernels",
         "halide_d3d12compute_initialize_kernels",
+        "halide_vulkan_initialize_kernels",
+        "halide_webgpu_initialize_kernels",
         "halide_get_gpu_device",
         "halide_upgrade_buffer_t",
         "halide_downgrade_buffer_t",
@@ -386,6 +408,72 @@ Expr lower_euclidean_div(Expr a, Expr b) {
     }
 }
 
+Expr lower_vector_reduce(const VectorReduce *op) {
+    const int lanes = op->type.lanes();
+    int factor = op->value.type().lanes() / lanes;
+
+    auto binop = [&](Expr a, Expr b) -> Expr {
+        switch (op->op) {
+        case VectorReduce::Add:
+            return Add::make(a, b);
+        case VectorReduce::Mul:
+            return Mul::make(a, b);
+        case VectorReduce::Min:
+            return Min::make(a, b);
+        case VectorReduce::Max:
+            return Max::make(a, b);
+        case VectorReduce::And:
+            if (a.type().is_bool()) {
+                return And::make(a, b);
+            }
+            return Call::make(a.type(), Call::bitwise_and, {a, b}, Call::PureIntrinsic);
+        case VectorReduce::Or:
+            if (a.type().is_bool()) {
+                return Or::make(a, b);
+            }
+            return Call::make(a.type(), Call::bitwise_or, {a, b}, Call::PureIntrinsic);
+        }
+        return Expr();
+    };
+
+    // Each step uses its input more than once, so bind it to a name
+    // rather than duplicating it.
+    std::vector<std::pair<std::string, Expr>> lets;
+    auto bind = [&](Expr e) -> Expr {
+        if (e.as<Variable>()) {
+            return e;
+        }
+        std::string name = unique_name('t');
+        lets.emplace_back(name, e);
+        return Variable::make(e.type(), name);
+    };
+
+    // The groups of lanes being reduced are adjacent, so combining
+    // the even lanes with the odd lanes halves every group.
+    Expr v = op->value;
+    while (factor % 2 == 0) {
+        v = bind(v);
+        const int n = v.type().lanes() / 2;
+        v = binop(Shuffle::make_slice(v, 0, 2, n), Shuffle::make_slice(v, 1, 2, n));
+        factor /= 2;
+    }
+
+    // Then combine what's left of each group one lane at a time.
+    if (factor > 1) {
+        v = bind(v);
+        Expr result = Shuffle::make_slice(v, 0, factor, lanes);
+        for (int i = 1; i < factor; i++) {
+            result = binop(result, Shuffle::make_slice(v, i, factor, lanes));
+        }
+        v = result;
+    }
+
+    for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+        v = Let::make(it->first, it->second, v);
+    }
+    return v;
+}
+
 Expr lower_euclidean_mod(Expr a, Expr b) {
     internal_assert(a.type() == b.type());
     // IROperator's mod_round_to_zero will replace this with a % b for
@@ -493,6 +581,68 @@ Stmt unpredicate_loads_stores(Stmt s) {
     return UnpredicateLoadsStores().mutate(s);
 }
 
+Stmt scalarize_atomic_store(const Store *op) {
+    Type t = op->value.type();
+    vector<Stmt> lanes;
+    for (int i = 0; i < t.lanes(); i++) {
+        Expr value_i = t.is_vector() ? extract_lane(op->value, i) : op->value;
+        Expr index_i = t.is_vector() ? extract_lane(op->index, i) : op->index;
+        Stmt lane = Store::make(op->name, value_i, index_i, op->param, const_true(), ModulusRemainder());
+        if (!is_one(op->predicate)) {
+            Expr pred_i = t.is_vector() ? extract_lane(op->predicate, i) : op->predicate;
+            lane = IfThenElse::make(pred_i, lane);
+        }
+        lanes.push_back(lane);
+    }
+    return Block::make(lanes);
+}
+
+namespace {
+
+// Replace loads of a particular location with a variable. Operates
+// on graphs, as the exprs it is given have had their lets
+// substituted in.
+class ReplaceLoadsOfLocation : public IRGraphMutator2 {
+    using IRGraphMutator2::visit;
+
+    const string &buffer;
+    const Expr &index;
+    const Expr &replacement;
+
+    Expr visit(const Load *op) override {
+        if (op->name == buffer) {
+            internal_assert(graph_equal(op->index, index))
+                << "Atomic store to " << buffer
+                << " reads from a different location in the same buffer\n";
+            found = true;
+            return replacement;
+        }
+        return IRGraphMutator2::visit(op);
+    }
+
+public:
+    bool found = false;
+
+    ReplaceLoadsOfLocation(const string &b, const Expr &i, const Expr &r) :
+        buffer(b), index(i), replacement(r) {}
+};
+
+}  // namespace
+
+Expr atomic_update_in_terms_of(const Store *op, const string &old_value_name) {
+    internal_assert(op->value.type().is_scalar() && is_one(op->predicate))
+        << "Atomic stores should have been scalarized\n";
+    Expr value = substitute_in_all_lets(op->value);
+    Expr index = substitute_in_all_lets(op->index);
+    Expr old_value = Variable::make(op->value.type(), old_value_name);
+    ReplaceLoadsOfLocation replacer(op->name, index, old_value);
+    value = replacer.mutate(value);
+    if (!replacer.found) {
+        return Expr();
+    }
+    return common_subexpression_elimination(value);
+}
+
 bool get_md_bool(llvm::Metadata *value, bool &result) {
     if (!value) {
         return false;
@@ -84,10 +84,29 @@ Expr lower_euclidean_div(Expr a, Expr b);
 Expr lower_euclidean_mod(Expr a, Expr b);
 ///@}
 
+/** Express a horizontal vector reduction in terms of slices of the
+ * value and ordinary binary operators. Adjacent pairs of lanes are
+ * combined while the reduction factor is even, so reductions by a
+ * power of two take a logarithmic number of steps. Used by backends
+ * with no better instructions for the reduction. */
+Expr lower_vector_reduce(const VectorReduce *op);
+
 /** Replace predicated loads/stores with unpredicated equivalents
  * inside branches. */
 Stmt unpredicate_loads_stores(Stmt s);
 
+/** Break a vector or predicated Store inside an Atomic node into one
+ * unpredicated scalar Store per lane, each guarded by its lane of the
+ * predicate, so that every lane gets its own atomic update. */
+Stmt scalarize_atomic_store(const Store *op);
+
+/** Express the value of a scalar Store inside an Atomic node in terms
+ * of the value currently in memory, by replacing Loads of the location
+ * being stored to with a Variable of the given name. Returns an
+ * undefined Expr if the value doesn't read that location, in which
+ * case an ordinary store is already atomic. */
+Expr atomic_update_in_terms_of(const Store *op, const std::string &old_value_name);
+
 /** Given an llvm::Module, set llvm:TargetOptions, cpu and attr information */
 void get_target_options(const llvm::Module &module, llvm::TargetOptions &options, std::string &mcpu, std::string &mattrs);
 
@@ -1,8 +1,10 @@
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <mutex>
 #include <sstream>
 
+#include "AddAliasChecks.h"
 #include "CPlusPlusMangle.h"
 #include "CSE.h"
 #include "CodeGen_ARM.h"
@@ -15,9 +17,11 @@
 #include "CodeGen_RISCV.h"
 #include "CodeGen_WebAssembly.h"
 #include "CodeGen_X86.h"
+#include "CompileTimeProfiler.h"
 #include "Debug.h"
 #include "Deinterleave.h"
 #include "ExprUsesVar.h"
+#include "IREquality.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
 #include "IntegerDivisionTable.h"
@@ -275,7 +279,8 @@ CodeGen_LLVM::CodeGen_LLVM(Target t) :
     min_f64(Float(64).min()),
     max_f64(Float(64).max()),
     destructor_block(nullptr),
-    strict_float(t.has_feature(Target::StrictFloat)) {
+    strict_float(t.has_feature(Target::StrictFloat)),
+    buffers_may_alias(false) {
     initialize_llvm();
 }
 
@@ -303,7 +308,9 @@ CodeGen_LLVM *CodeGen_LLVM::new_for_target(const Target &target,
                                 Target::OpenGL,
                                 Target::OpenGLCompute,
                                 Target::Metal,
-                                Target::D3D12Compute})) {
+                                Target::D3D12Compute,
+                                Target::Vulkan,
+                                Target::WebGPU})) {
 #ifdef WITH_X86
         if (target.arch == Target::X86) {
             return make_codegen<CodeGen_GPU_Host<CodeGen_X86>>(target, context);
@@ -617,6 +624,7 @@ void CodeGen_LLVM::init_codegen(const std::string &name, bool any_strict_float)
 }
 
 std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
+    CompileTimeProfiler profiler(input.name());
     init_codegen(input.name(), input.any_strict_float());
 
     internal_assert(module && context && builder)
@@ -638,6 +646,7 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
         // (useful for calling from JIT and other machine interfaces).
         if (f.linkage == LinkageType::ExternalPlusMetadata) {
             llvm::Function *wrapper = add_argv_wrapper(function, names.argv_name);
+            add_prewarm_function(names.simple_name + "_prewarm");
             llvm::Function *metadata_getter = embed_metadata_getter(names.metadata_name,
                 names.simple_name, f.args, input.get_metadata_name_map());
 
@@ -647,7 +656,26 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
         }
     }
 
+    // The trusted entry points (see TrustedEntryPoints.h) also get an
+    // argv wrapper, and a wrapper that calls that over a batch.
+    if (target.has_feature(Target::TrustedEntry)) {
+        for (const auto &f : input.functions()) {
+            if (f.linkage != LinkageType::ExternalPlusMetadata) {
+                continue;
+            }
+            const auto names = get_mangled_names(f, get_target());
+            LoweredFunc trusted_f(f.name + "_trusted", f.args, {}, LinkageType::External, f.name_mangling);
+            llvm::Function *trusted = module->getFunction(get_mangled_names(trusted_f, get_target()).extern_name);
+            if (!trusted) {
+                continue;
+            }
+            llvm::Function *trusted_argv = add_argv_wrapper(trusted, names.simple_name + "_trusted_argv");
+            add_batch_wrapper(trusted_argv, names.simple_name + "_trusted_batch");
+        }
+    }
+
     debug(2) << module.get() << "\n";
+    profiler.pass_done("generating LLVM IR");
 
     return finish_codegen();
 }
@@ -759,6 +787,17 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f, const std::string &simple_
     // Generate the function declaration and argument unpacking code.
     begin_func(f.linkage, simple_name, extern_name, f.args);
 
+    argument_alias_scopes.clear();
+    if (target.has_feature(Target::CheckAliasing)) {
+        llvm::MDBuilder builder(*context);
+        MDNode *domain = builder.createAnonymousAliasScopeDomain(f.name);
+        for (const auto &arg : f.args) {
+            if (arg.is_buffer()) {
+                argument_alias_scopes[arg.name] = builder.createAnonymousAliasScope(domain, arg.name);
+            }
+        }
+    }
+
     // If building with MSAN, ensure that calls to halide_msan_annotate_buffer_is_initialized()
     // happen for every output buffer if the function succeeds.
     if (f.linkage != LinkageType::Internal &&
@@ -775,14 +814,121 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f, const std::string &simple_
         }
     }
 
+    begin_branch_profile(f.name);
+
      // Generate the function body.
     debug(1) << "Generating llvm bitcode for function " << f.name << "...\n";
     f.body.accept(this);
 
+    end_branch_profile();
+
     // Clean up and return.
     end_func(f.args);
 }
 
+void CodeGen_LLVM::begin_branch_profile(const std::string &name) {
+    branch_profile = BranchProfile();
+    branch_profile.function = name;
+    branch_profile.instrument = target.has_feature(Target::ProfileBranches);
+
+    if (branch_profile.instrument) {
+        user_assert(target.arch != Target::Hexagon &&
+                    target.os != Target::NoOS &&
+                    target.os != Target::QuRT)
+            << "The profile_branches target feature is not supported on " << target.to_string() << "\n";
+
+        // Register the function on entry, and keep the counters the
+        // runtime gives it in a global, so that the closures of
+        // parallel tasks can find them too. The number of sites isn't
+        // known until the whole function has been generated.
+        llvm::Function *register_fn = module->getFunction("halide_branch_profile_register");
+        internal_assert(register_fn) << "Could not find halide_branch_profile_register in module\n";
+        GlobalVariable *num_sites = new GlobalVariable(*module, i32_t, false, GlobalValue::PrivateLinkage,
+                                                       nullptr, name + ".branch_profile_sites");
+        branch_profile.counters = new GlobalVariable(*module, i64_t->getPointerTo(), false,
+                                                     GlobalValue::PrivateLinkage,
+                                                     ConstantPointerNull::get(i64_t->getPointerTo()),
+                                                     name + ".branch_profile_counters");
+        Value *args[] = {get_user_context(), create_string_constant(name), builder->CreateLoad(num_sites)};
+        Value *counters = builder->CreateCall(register_fn, args);
+        builder->CreateStore(builder->CreatePointerCast(counters, i64_t->getPointerTo()), branch_profile.counters);
+        return;
+    }
+
+    string path = get_env_variable("HL_BRANCH_PROFILE");
+    if (path.empty()) {
+        return;
+    }
+    std::ifstream file(path);
+    if (!file) {
+        debug(1) << "Could not read branch profile " << path << "\n";
+        return;
+    }
+    string func;
+    int site;
+    uint64_t a, b;
+    while (file >> func >> site >> a >> b) {
+        if (func == name) {
+            auto &c = branch_profile.counts[site];
+            c.first += a;
+            c.second += b;
+        }
+    }
+    debug(1) << "Read counts for " << branch_profile.counts.size()
+             << " branches and loops of " << name << " from " << path << "\n";
+}
+
+void CodeGen_LLVM::end_branch_profile() {
+    if (branch_profile.instrument) {
+        GlobalVariable *num_sites = module->getNamedGlobal(branch_profile.function + ".branch_profile_sites");
+        internal_assert(num_sites);
+        num_sites->setInitializer(ConstantInt::get(i32_t, branch_profile.num_sites));
+        num_sites->setConstant(true);
+    }
+    branch_profile = BranchProfile();
+}
+
+int CodeGen_LLVM::next_branch_profile_site() {
+    if (branch_profile.function.empty()) {
+        return -1;
+    }
+    return branch_profile.num_sites++;
+}
+
+void CodeGen_LLVM::count_branch_profile_site(int site, int counter, llvm::Value *amount) {
+    if (site < 0 || !branch_profile.instrument) {
+        return;
+    }
+    Value *counters = builder->CreateLoad(branch_profile.counters);
+    Value *ptr = builder->CreateInBoundsGEP(counters, ConstantInt::get(i32_t, 2 * site + counter));
+    builder->CreateAtomicRMW(AtomicRMWInst::Add, ptr,
+                             builder->CreateIntCast(amount, i64_t, true),
+                             AtomicOrdering::Monotonic);
+}
+
+llvm::MDNode *CodeGen_LLVM::branch_profile_weights(int site, bool is_loop) {
+    auto it = branch_profile.counts.find(site);
+    if (it == branch_profile.counts.end()) {
+        return nullptr;
+    }
+    // For a branch, the counts are how often it was and wasn't
+    // taken. For a loop, they're how often it ran at least once and
+    // the total iterations, so the back edge was taken once less than
+    // every iteration.
+    uint64_t taken = it->second.first, not_taken = it->second.second;
+    if (is_loop) {
+        taken = not_taken - std::min(taken, not_taken);
+        not_taken = it->second.first;
+    }
+    if (taken == 0 && not_taken == 0) {
+        return nullptr;
+    }
+    // Branch weights are 32-bit, so scale down large counts.
+    uint64_t scale = std::max(taken, not_taken) / std::numeric_limits<uint32_t>::max() + 1;
+    llvm::MDBuilder md_builder(*context);
+    return md_builder.createBranchWeights((uint32_t)(taken / scale), (uint32_t)(not_taken / scale));
+}
+
 // Given a range of iterators of constant ints, get a corresponding vector of llvm::Constant.
 template<typename It>
 std::vector<llvm::Constant*> get_constants(llvm::Type *t, It begin, It end) {
@@ -1072,6 +1218,68 @@ llvm::Function *CodeGen_LLVM::add_argv_wrapper(llvm::Function *fn,
     return wrapper_func;
 }
 
+// Make a function of the form
+//
+//    int name(int count, void ***args) {
+//        for (int i = 0; i < count; i++) {
+//            int result = argv_fn(args[i]);
+//            if (result != 0) return result;
+//        }
+//        return 0;
+//    }
+//
+// so that small pipelines can be run many times for the cost of one
+// call.
+llvm::Function *CodeGen_LLVM::add_batch_wrapper(llvm::Function *argv_fn, const std::string &name) {
+    llvm::Type *argv_t = i8_t->getPointerTo()->getPointerTo();
+    llvm::Type *wrapper_args_t[] = {i32_t, argv_t->getPointerTo()};
+    llvm::FunctionType *wrapper_func_t = llvm::FunctionType::get(i32_t, wrapper_args_t, false);
+    llvm::Function *wrapper_func = llvm::Function::Create(wrapper_func_t, llvm::GlobalValue::ExternalLinkage, name, module.get());
+    llvm::BasicBlock *entry_bb = llvm::BasicBlock::Create(module->getContext(), "entry", wrapper_func);
+    llvm::BasicBlock *loop_bb = llvm::BasicBlock::Create(module->getContext(), "loop", wrapper_func);
+    llvm::BasicBlock *next_bb = llvm::BasicBlock::Create(module->getContext(), "next", wrapper_func);
+    llvm::BasicBlock *fail_bb = llvm::BasicBlock::Create(module->getContext(), "fail", wrapper_func);
+    llvm::BasicBlock *done_bb = llvm::BasicBlock::Create(module->getContext(), "done", wrapper_func);
+
+    llvm::Value *count = iterator_to_pointer(wrapper_func->arg_begin());
+    llvm::Value *arg_sets = iterator_to_pointer(wrapper_func->arg_begin() + 1);
+
+    builder->SetInsertPoint(entry_bb);
+    builder->CreateCondBr(builder->CreateICmpSGT(count, ConstantInt::get(i32_t, 0)), loop_bb, done_bb);
+
+    builder->SetInsertPoint(loop_bb);
+    PHINode *i = builder->CreatePHI(i32_t, 2);
+    i->addIncoming(ConstantInt::get(i32_t, 0), entry_bb);
+    llvm::Value *args = builder->CreateLoad(builder->CreateInBoundsGEP(arg_sets, i));
+    llvm::Value *result = builder->CreateCall(argv_fn, {args});
+    builder->CreateCondBr(builder->CreateIsNotNull(result), fail_bb, next_bb);
+
+    builder->SetInsertPoint(next_bb);
+    llvm::Value *next_i = builder->CreateNSWAdd(i, ConstantInt::get(i32_t, 1));
+    i->addIncoming(next_i, next_bb);
+    builder->CreateCondBr(builder->CreateICmpSLT(next_i, count), loop_bb, done_bb);
+
+    builder->SetInsertPoint(fail_bb);
+    builder->CreateRet(result);
+
+    builder->SetInsertPoint(done_bb);
+    builder->CreateRet(ConstantInt::get(i32_t, 0));
+
+    internal_assert(!verifyFunction(*wrapper_func, &llvm::errs()));
+    return wrapper_func;
+}
+
+llvm::Function *CodeGen_LLVM::add_prewarm_function(const std::string &name) {
+    llvm::Type *args_t[] = {i8_t->getPointerTo()};
+    llvm::FunctionType *func_t = llvm::FunctionType::get(i32_t, args_t, false);
+    llvm::Function *func = llvm::Function::Create(func_t, llvm::GlobalValue::ExternalLinkage, name, module.get());
+    llvm::BasicBlock *entry_bb = llvm::BasicBlock::Create(module->getContext(), "entry", func);
+    builder->SetInsertPoint(entry_bb);
+    builder->CreateRet(ConstantInt::get(i32_t, 0));
+    internal_assert(!verifyFunction(*func, &llvm::errs()));
+    return func;
+}
+
 llvm::Function *CodeGen_LLVM::embed_metadata_getter(const std::string &metadata_name,
         const std::string &function_name, const std::vector<LoweredArgument> &args,
         const std::map<std::string, std::string> &metadata_name_map) {
@@ -1187,6 +1395,7 @@ llvm::Type *CodeGen_LLVM::llvm_type_of(Type t) {
 
 void CodeGen_LLVM::optimize_module() {
     debug(3) << "Optimizing module\n";
+    ScopedCompileTimer timer(module->getModuleIdentifier(), "LLVM optimization");
 
     if (debug::debug_level() >= 3) {
         module->print(dbgs(), nullptr, false, true);
@@ -1446,7 +1655,13 @@ void CodeGen_LLVM::visit(const UIntImm *op) {
 }
 
 void CodeGen_LLVM::visit(const FloatImm *op) {
-    value = ConstantFP::get(llvm_type_of(op->type), op->value);
+    if (op->type.is_bfloat()) {
+        // Only reachable for constants embedded in metadata; bfloat
+        // constants in the body have already been lowered to bits.
+        value = ConstantInt::get(llvm_type_of(op->type), bfloat16_t(op->value).to_bits());
+    } else {
+        value = ConstantFP::get(llvm_type_of(op->type), op->value);
+    }
 }
 
 void CodeGen_LLVM::visit(const StringImm *op) {
@@ -1773,6 +1988,30 @@ void CodeGen_LLVM::add_tbaa_metadata(llvm::Instruction *inst, string buffer, Exp
     // is using.
     buffer = get_allocation_name(buffer);
 
+    auto scope = argument_alias_scopes.find(buffer);
+    if (scope != argument_alias_scopes.end()) {
+        if (buffers_may_alias) {
+            // The buffer arguments may overlap, so treat them all as
+            // one block of memory, and don't use the index to
+            // distinguish accesses.
+            buffer = "Halide buffer arguments";
+            index = Expr();
+        } else {
+            // They have been checked not to overlap. Tell LLVM so
+            // with scoped noalias metadata as well as TBAA.
+            vector<Metadata *> others;
+            for (const auto &s : argument_alias_scopes) {
+                if (s.first != buffer) {
+                    others.push_back(s.second);
+                }
+            }
+            inst->setMetadata(LLVMContext::MD_alias_scope, MDNode::get(*context, {scope->second}));
+            if (!others.empty()) {
+                inst->setMetadata(LLVMContext::MD_noalias, MDNode::get(*context, others));
+            }
+        }
+    }
+
     // If the index is constant, we generate some TBAA info that helps
     // LLVM understand our loads/stores aren't aliased.
     bool constant_index = false;
@@ -2740,6 +2979,18 @@ void CodeGen_LLVM::visit(const Call *op) {
         internal_assert(op->args[1].type().is_handle());
         Value *arg = codegen(op->args[1]);
         value = register_destructor(f, arg, Always);
+    } else if (op->is_intrinsic(Call::bounds_check_cache)) {
+        internal_assert(op->args.size() == 1);
+        const int64_t *size = as_const_int(op->args[0]);
+        internal_assert(size);
+        // A mutex, a valid flag, and the key.
+        llvm::Type *type = ArrayType::get(i64_t, *size + 2);
+        GlobalVariable *global = new GlobalVariable(*module, type,
+                                                    /*isConstant*/ false, GlobalValue::PrivateLinkage,
+                                                    ConstantAggregateZero::get(type),
+                                                    unique_name("bounds_check_cache"));
+        global->setAlignment(8);
+        value = builder->CreatePointerCast(global, i8_t->getPointerTo());
     } else if (op->is_intrinsic(Call::call_cached_indirect_function)) {
         // Arguments to call_cached_indirect_function are of the form
         //
@@ -2762,12 +3013,16 @@ void CodeGen_LLVM::visit(const Call *op) {
         // evaluating to true will have its corresponding function cached,
         // which will be used to complete this (and all subsequent) calls.
         //
+        // The selection is also made by a static constructor when the
+        // object is loaded, so that calls don't have to make it. The
+        // cached pointer is registered with the runtime, which clears it
+        // if halide_set_custom_can_use_target_features changes how the
+        // conditions evaluate.
+        //
         // The final condition (cond_N) must evaluate to a constant TRUE
         // value (so that the final function will be selected if all others
         // fail); failure to do so will cause unpredictable results.
         //
-        // There is currently no way to clear the cached function pointer.
-        //
         // It is assumed/required that all of the conditions are "pure"; each
         // must evaluate to the same value (within a given runtime environment)
         // across multiple evaluations.
@@ -2846,23 +3101,29 @@ void CodeGen_LLVM::visit(const Call *op) {
         // be able to re-write the same value, which is harmless for our purposes, and
         // avoiding such code simplifies and speeds the resulting code.
         //
-        // (Note that if we ever need to add a way to clear the cached function pointer,
-        // we may need to reconsider this, to avoid amusingly horrible race conditions.)
+        // (The runtime clears the cached function pointer only when the
+        // custom can-use-target function is replaced; a call racing with
+        // that may use either the old or the new selection.)
         builder->CreateCondBr(builder->CreateIsNotNull(loaded_value),
             global_inited_bb, global_not_inited_bb, very_likely_branch);
 
+        auto select_sub_fn = [&]() {
+            llvm::Value *selected = nullptr;
+            for (int i = sub_fns.size() - 1; i >= 0; i--) {
+                const auto sub_fn = sub_fns[i];
+                if (!selected) {
+                    selected = sub_fn.fn_ptr;
+                } else {
+                    Value *c = codegen(sub_fn.cond);
+                    selected = builder->CreateSelect(c, sub_fn.fn_ptr, selected);
+                }
+            }
+            return selected;
+        };
+
         // Build the not-already-inited case
         builder->SetInsertPoint(global_not_inited_bb);
-        llvm::Value *selected_value = nullptr;
-        for (int i = sub_fns.size() - 1; i >= 0; i--) {
-            const auto sub_fn = sub_fns[i];
-            if (!selected_value) {
-                selected_value = sub_fn.fn_ptr;
-            } else {
-                Value *c = codegen(sub_fn.cond);
-                selected_value = builder->CreateSelect(c, sub_fn.fn_ptr, selected_value);
-            }
-        }
+        llvm::Value *selected_value = select_sub_fn();
         builder->CreateStore(selected_value, global);
         builder->CreateBr(call_fn_bb);
 
@@ -2882,6 +3143,40 @@ void CodeGen_LLVM::visit(const Call *op) {
 
         llvm::CallInst *call = builder->CreateCall(base_fn->getFunctionType(), phi, call_args);
         value = call;
+
+        // Build the static constructor that makes the selection at load
+        // time. If the runtime can't track the cached pointer, leave it
+        // to be selected on the first call instead.
+        {
+            IRBuilderBase::InsertPoint here = builder->saveIP();
+            llvm::Type *cache_t = i8_t->getPointerTo()->getPointerTo();
+            llvm::Function *register_fn = module->getFunction("halide_register_dispatch_cache");
+            if (!register_fn) {
+                register_fn = llvm::Function::Create(FunctionType::get(i32_t, {cache_t}, false),
+                                                     llvm::Function::ExternalLinkage,
+                                                     "halide_register_dispatch_cache", module.get());
+            }
+            llvm::Function *init_fn = llvm::Function::Create(FunctionType::get(void_t, false),
+                                                             llvm::Function::InternalLinkage,
+                                                             global_name + "_init", module.get());
+            BasicBlock *entry_bb = BasicBlock::Create(*context, "entry", init_fn);
+            BasicBlock *select_bb = BasicBlock::Create(*context, "select_bb", init_fn);
+            BasicBlock *done_bb = BasicBlock::Create(*context, "done_bb", init_fn);
+
+            builder->SetInsertPoint(entry_bb);
+            Value *registered = builder->CreateCall(register_fn, {builder->CreatePointerCast(global, cache_t)});
+            builder->CreateCondBr(builder->CreateIsNotNull(registered), select_bb, done_bb, very_likely_branch);
+
+            builder->SetInsertPoint(select_bb);
+            builder->CreateStore(select_sub_fn(), global);
+            builder->CreateBr(done_bb);
+
+            builder->SetInsertPoint(done_bb);
+            builder->CreateRetVoid();
+
+            llvm::appendToGlobalCtors(*module, init_fn, 65535);
+            builder->restoreIP(here);
+        }
     } else if (op->is_intrinsic(Call::prefetch)) {
         user_assert((op->args.size() == 4) && is_one(op->args[2]))
             << "Only prefetch of 1 cache line is supported.\n";
@@ -3137,6 +3432,13 @@ void CodeGen_LLVM::visit(const Let *op) {
 }
 
 void CodeGen_LLVM::visit(const LetStmt *op) {
+    if (op->name == buffers_may_alias_marker) {
+        bool old = buffers_may_alias;
+        buffers_may_alias = true;
+        codegen(op->body);
+        buffers_may_alias = old;
+        return;
+    }
     sym_push(op->name, codegen(op->value));
     codegen(op->body);
     sym_pop(op->name);
@@ -3256,6 +3558,15 @@ void CodeGen_LLVM::visit(const For *op) {
         do_as_parallel_task(op);
     } else if (op->for_type == ForType::Serial) {
 
+        // Count the runs of the loop with at least one iteration, and
+        // the total iterations.
+        int site = next_branch_profile_site();
+        if (site >= 0 && branch_profile.instrument) {
+            Value *ran = builder->CreateICmpSGT(extent, ConstantInt::get(i32_t, 0));
+            count_branch_profile_site(site, 0, builder->CreateZExt(ran, i32_t));
+            count_branch_profile_site(site, 1, builder->CreateSelect(ran, extent, ConstantInt::get(i32_t, 0)));
+        }
+
         Value *max = builder->CreateNSWAdd(min, extent);
 
         BasicBlock *preheader_bb = builder->GetInsertBlock();
@@ -3288,7 +3599,7 @@ void CodeGen_LLVM::visit(const For *op) {
 
         // Maybe exit the loop
         Value *end_condition = builder->CreateICmpNE(next_var, max);
-        builder->CreateCondBr(end_condition, loop_bb, after_bb);
+        builder->CreateCondBr(end_condition, loop_bb, after_bb, branch_profile_weights(site, true));
 
         builder->SetInsertPoint(after_bb);
 
@@ -3704,6 +4015,105 @@ void CodeGen_LLVM::visit(const Fork *op) {
     do_as_parallel_task(op);
 }
 
+void CodeGen_LLVM::visit(const Atomic *op) {
+    ScopedBinding<> bind(atomic_producers, op->producer_name);
+    codegen(op->body);
+}
+
+void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
+    Halide::Type t = op->value.type();
+    string old_value_name = unique_name("atomic_old_value");
+    Expr update = atomic_update_in_terms_of(op, old_value_name);
+    Value *ptr = codegen_buffer_pointer(op->name, t, op->index);
+
+    if (!update.defined()) {
+        // The value doesn't depend on what's in memory, so an
+        // ordinary aligned store is already atomic.
+        Value *val = codegen(op->value);
+        StoreInst *store = builder->CreateAlignedStore(val, ptr, t.bytes());
+        add_tbaa_metadata(store, op->name, op->index);
+        return;
+    }
+
+    // Try to use a native atomic read-modify-write. These require
+    // the update to be a binary op of the old value and something
+    // that doesn't depend on it.
+    Expr old_value = Variable::make(t, old_value_name);
+    Expr operand;
+    AtomicRMWInst::BinOp rmw_op = AtomicRMWInst::BAD_BINOP;
+    auto other_operand = [&](const Expr &a, const Expr &b, bool commutative) {
+        if (equal(a, old_value) && !expr_uses_var(b, old_value_name)) {
+            return b;
+        } else if (commutative && equal(b, old_value) && !expr_uses_var(a, old_value_name)) {
+            return a;
+        }
+        return Expr();
+    };
+    if (const Add *add = update.as<Add>()) {
+        operand = other_operand(add->a, add->b, true);
+        if (t.is_float()) {
+#if LLVM_VERSION >= 90
+            rmw_op = AtomicRMWInst::FAdd;
+#endif
+        } else {
+            rmw_op = AtomicRMWInst::Add;
+        }
+    } else if (const Sub *sub = update.as<Sub>()) {
+        operand = other_operand(sub->a, sub->b, false);
+        if (t.is_float()) {
+#if LLVM_VERSION >= 90
+            rmw_op = AtomicRMWInst::FSub;
+#endif
+        } else {
+            rmw_op = AtomicRMWInst::Sub;
+        }
+    } else if (const Min *min = update.as<Min>()) {
+        operand = other_operand(min->a, min->b, true);
+        if (!t.is_float()) {
+            rmw_op = t.is_uint() ? AtomicRMWInst::UMin : AtomicRMWInst::Min;
+        }
+    } else if (const Max *max = update.as<Max>()) {
+        operand = other_operand(max->a, max->b, true);
+        if (!t.is_float()) {
+            rmw_op = t.is_uint() ? AtomicRMWInst::UMax : AtomicRMWInst::Max;
+        }
+    }
+
+    if (operand.defined() && rmw_op != AtomicRMWInst::BAD_BINOP) {
+        Value *val = codegen(operand);
+        builder->CreateAtomicRMW(rmw_op, ptr, val, AtomicOrdering::Monotonic);
+        return;
+    }
+
+    // Otherwise fall back to a compare-and-swap loop on the bits of
+    // the value.
+    llvm::Type *bits_t = llvm::Type::getIntNTy(*context, t.bits());
+    Value *bits_ptr = builder->CreatePointerCast(ptr, bits_t->getPointerTo());
+    LoadInst *initial = builder->CreateAlignedLoad(bits_ptr, t.bytes());
+    add_tbaa_metadata(initial, op->name, op->index);
+
+    BasicBlock *pre_bb = builder->GetInsertBlock();
+    BasicBlock *loop_bb = BasicBlock::Create(*context, "atomic_cas_loop", function);
+    BasicBlock *after_bb = BasicBlock::Create(*context, "atomic_cas_done", function);
+    builder->CreateBr(loop_bb);
+    builder->SetInsertPoint(loop_bb);
+
+    PHINode *expected = builder->CreatePHI(bits_t, 2);
+    expected->addIncoming(initial, pre_bb);
+    sym_push(old_value_name, builder->CreateBitCast(expected, llvm_type_of(t)));
+    Value *desired = builder->CreateBitCast(codegen(update), bits_t);
+    sym_pop(old_value_name);
+
+    Value *result = builder->CreateAtomicCmpXchg(bits_ptr, expected, desired,
+                                                 AtomicOrdering::Monotonic,
+                                                 AtomicOrdering::Monotonic);
+    Value *actual = builder->CreateExtractValue(result, {0});
+    Value *success = builder->CreateExtractValue(result, {1});
+    expected->addIncoming(actual, builder->GetInsertBlock());
+    builder->CreateCondBr(success, after_bb, loop_bb);
+    builder->SetInsertPoint(after_bb);
+}
+
 void CodeGen_LLVM::visit(const Store *op) {
     // Even on 32-bit systems, Handles are treated as 64-bit in
     // memory, so convert stores of handles to stores of uint64_ts.
@@ -3713,6 +4123,16 @@ void CodeGen_LLVM::visit(const Store *op) {
         return;
     }
 
+    if (atomic_producers.contains(op->name)) {
+        if (op->value.type().is_vector() || !is_one(op->predicate)) {
+            // Each lane needs its own atomic update.
+            codegen(scalarize_atomic_store(op));
+        } else {
+            codegen_atomic_store(op);
+        }
+        return;
+    }
+
     // Predicated store
     if (!is_one(op->predicate)) {
         codegen_predicated_vector_store(op);
@@ -3874,16 +4294,20 @@ void CodeGen_LLVM::visit(const Provide *op) {
 }
 
 void CodeGen_LLVM::visit(const IfThenElse *op) {
+    int site = next_branch_profile_site();
     BasicBlock *true_bb = BasicBlock::Create(*context, "true_bb", function);
     BasicBlock *false_bb = BasicBlock::Create(*context, "false_bb", function);
     BasicBlock *after_bb = BasicBlock::Create(*context, "after_bb", function);
-    builder->CreateCondBr(codegen(op->condition), true_bb, false_bb);
+    builder->CreateCondBr(codegen(op->condition), true_bb, false_bb,
+                          branch_profile_weights(site, false));
 
     builder->SetInsertPoint(true_bb);
+    count_branch_profile_site(site, 0, ConstantInt::get(i32_t, 1));
     codegen(op->then_case);
     builder->CreateBr(after_bb);
 
     builder->SetInsertPoint(false_bb);
+    count_branch_profile_site(site, 1, ConstantInt::get(i32_t, 1));
     if (op->else_case.defined()) {
         codegen(op->else_case);
     }
@@ -3926,6 +4350,10 @@ void CodeGen_LLVM::visit(const Shuffle *op) {
     }
 }
 
+void CodeGen_LLVM::visit(const VectorReduce *op) {
+    value = codegen(lower_vector_reduce(op));
+}
+
 Value *CodeGen_LLVM::create_alloca_at_entry(llvm::Type *t, int n, bool zero_initialize, const string &name) {
     IRBuilderBase::InsertPoint here = builder->saveIP();
     BasicBlock *entry = &builder->GetInsertBlock()->getParent()->getEntryBlock();
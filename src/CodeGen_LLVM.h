@@ -90,6 +90,13 @@ protected:
     virtual void compile_buffer(const Buffer<> &buffer);
     // @}
 
+    /** Make a function of the form int name(void *user_context) that
+     * does the one-time initialization the function just compiled
+     * would otherwise do lazily on its first call, e.g. loading its
+     * GPU kernels, and returns the first error code. The default
+     * does nothing and returns zero. */
+    virtual llvm::Function *add_prewarm_function(const std::string &name);
+
     /** Helper functions for compiling Halide functions to llvm
      * functions. begin_func performs all the work necessary to begin
      * generating code for a function with a given argument list with
@@ -145,6 +152,38 @@ protected:
     std::vector<LoweredArgument> current_function_args;
     //@}
 
+    /** State for Target::ProfileBranches, which counts how often each
+     * branch is taken and how many iterations each serial loop runs,
+     * and for using such counts read back from HL_BRANCH_PROFILE as
+     * branch weights. Sites are numbered in the order they are
+     * generated within each function passed to compile_func. */
+    // @{
+    struct BranchProfile {
+        std::string function;
+        int num_sites = 0;
+        bool instrument = false;
+        llvm::GlobalVariable *counters = nullptr;
+        std::map<int, std::pair<uint64_t, uint64_t>> counts;
+    } branch_profile;
+
+    /** Start numbering the sites of a function, and either set up
+     * its counters or load its counts. */
+    void begin_branch_profile(const std::string &name);
+    void end_branch_profile();
+
+    /** Take the next site number, or return -1 outside of
+     * compile_func. */
+    int next_branch_profile_site();
+
+    /** Add 'amount' to one of the two counters of a site, if
+     * instrumenting. */
+    void count_branch_profile_site(int site, int counter, llvm::Value *amount);
+
+    /** Make branch weights from the loaded counts for a site, or
+     * return nullptr if there are none. */
+    llvm::MDNode *branch_profile_weights(int site, bool is_loop);
+    // @}
+
     /** The target we're generating code for */
     Halide::Target target;
 
@@ -378,7 +417,9 @@ protected:
     void visit(const IfThenElse *) override;
     void visit(const Evaluate *) override;
     void visit(const Shuffle *) override;
+    void visit(const VectorReduce *) override;
     void visit(const Prefetch *) override;
+    void visit(const Atomic *) override;
     // @}
 
     /** Generate code for an allocate node. It has no default
@@ -471,6 +512,22 @@ protected:
      */
     std::pair<llvm::Function *, int> find_vector_runtime_function(const std::string &name, int lanes);
 
+    /** The producers whose stores must currently be done atomically,
+     * because we're inside an Atomic node for them. Subclasses that
+     * override visit(const Store *) should defer to CodeGen_LLVM for
+     * these. */
+    Scope<> atomic_producers;
+
+    /** Generate code for a scalar store inside an Atomic node. */
+    void codegen_atomic_store(const Store *op);
+
+    /** Generate code for loads and stores with a vector predicate
+     * other than all-true. */
+    // @{
+    virtual void codegen_predicated_vector_load(const Load *op);
+    virtual void codegen_predicated_vector_store(const Store *op);
+    // @}
+
 private:
 
     /** All the values in scope at the current code location during
@@ -489,6 +546,15 @@ private:
     /** Turn off all unsafe math flags in scopes while this is set. */
     bool strict_float;
 
+    /** When Target::CheckAliasing is set, the alias scope of each
+     * buffer argument of the function being compiled. Loads and
+     * stores of each are marked as not aliasing the others. */
+    std::map<std::string, llvm::MDNode *> argument_alias_scopes;
+
+    /** Set while compiling the copy of the body that add_alias_checks
+     * makes for when the buffer arguments overlap. */
+    bool buffers_may_alias;
+
     /** Embed an instance of halide_filter_metadata_t in the code, using
      * the given name (by convention, this should be ${FUNCTIONNAME}_metadata)
      * as extern "C" linkage. Note that the return value is a function-returning-
@@ -504,10 +570,11 @@ private:
 
     llvm::Function *add_argv_wrapper(llvm::Function *fn, const std::string &name, bool result_in_argv = false);
 
-    llvm::Value *codegen_dense_vector_load(const Load *load, llvm::Value *vpred = nullptr);
+    /** Make a function that calls an argv wrapper once for each of an
+     * array of argument lists, stopping at the first failure. */
+    llvm::Function *add_batch_wrapper(llvm::Function *argv_fn, const std::string &name);
 
-    virtual void codegen_predicated_vector_load(const Load *op);
-    virtual void codegen_predicated_vector_store(const Store *op);
+    llvm::Value *codegen_dense_vector_load(const Load *load, llvm::Value *vpred = nullptr);
 
     void init_codegen(const std::string &name, bool any_strict_float = false);
     std::unique_ptr<llvm::Module> finish_codegen();
@@ -1,10 +1,13 @@
 #include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 #include "CodeGen_Internal.h"
 #include "CodeGen_Metal_Dev.h"
 #include "Debug.h"
 #include "IROperator.h"
+#include "Util.h"
 
 namespace Halide {
 namespace Internal {
@@ -17,7 +20,7 @@ using std::vector;
 static ostringstream nil;
 
 CodeGen_Metal_Dev::CodeGen_Metal_Dev(Target t) :
-    metal_c(src_stream, t) {
+    metal_c(src_stream, t), target(t) {
 }
 
 string CodeGen_Metal_Dev::CodeGen_Metal_C::print_type_maybe_storage(Type type, bool storage, AppendSpaceIfNeeded space) {
@@ -540,6 +543,11 @@ void CodeGen_Metal_Dev::CodeGen_Metal_C::add_kernel(Stmt s,
     stream << "kernel void " << name << "(\n";
     stream << "uint3 tgroup_index [[ threadgroup_position_in_grid ]],\n"
            << "uint3 tid_in_tgroup [[ thread_position_in_threadgroup ]]";
+    if (CodeGen_GPU_Dev::gpu_shuffle_width(s) > 0) {
+        // Needed by halide_gpu_shuffle. SIMD-groups are at least as
+        // wide as the loop over lanes, so shuffle relative to this lane.
+        stream << ",\nuint _simd_lane [[ thread_index_in_simdgroup ]]";
+    }
     size_t buffer_index = 0;
     if (any_scalar_args) {
         stream << ",\nconst device " << name << "_args *_scalar_args [[ buffer(0) ]]";
@@ -632,6 +640,7 @@ void CodeGen_Metal_Dev::init_module() {
                << "#define tanh_f32 tanh\n"
                << "#define atanh_f32 atanh\n"
                << "#define fast_inverse_sqrt_f32 rsqrt\n"
+               << "#define halide_gpu_shuffle(x, delta, width) simd_shuffle(x, (ushort)(_simd_lane + (delta)))\n"
                << "}\n"; // close namespace
 
     // __shared always has address space threadgroup.
@@ -646,6 +655,34 @@ vector<char> CodeGen_Metal_Dev::compile_to_src() {
     string str = src_stream.str();
     debug(1) << "Metal kernel:\n" << str << "\n";
     vector<char> buffer(str.begin(), str.end());
+
+    if (target.has_feature(Target::MetalLib)) {
+        // Compile the source to a metallib now, so that the runtime
+        // can load it with newLibraryWithData instead of compiling
+        // the source on first use. The runtime tells the two apart
+        // by the metallib's magic number.
+        TemporaryFile metal(get_current_kernel_name(), ".metal");
+        TemporaryFile air(get_current_kernel_name(), ".air");
+        TemporaryFile lib(get_current_kernel_name(), ".metallib");
+
+        std::ofstream f(metal.pathname());
+        f.write(buffer.data(), buffer.size());
+        f.close();
+
+        const string sdk = target.os == Target::IOS ? "iphoneos" : "macosx";
+        // The runtime compiles the source with fast math disabled.
+        string cmd = "xcrun -sdk " + sdk + " metal -fno-fast-math -c " + metal.pathname() + " -o " + air.pathname() +
+                     " && xcrun -sdk " + sdk + " metallib " + air.pathname() + " -o " + lib.pathname();
+        debug(1) << "Compiling Metal source to a metallib: " << cmd << "\n";
+        user_assert(system(cmd.c_str()) == 0)
+            << "The metal_lib target feature requires the Metal compiler from Xcode to be in the path.\n";
+
+        std::ifstream in(lib.pathname(), std::ios::binary);
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        user_assert(!buffer.empty()) << "metallib produced an empty library.\n";
+        return buffer;
+    }
+
     buffer.push_back(0);
     return buffer;
 }
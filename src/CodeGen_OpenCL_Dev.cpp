@@ -5,8 +5,11 @@
 #include "CodeGen_OpenCL_Dev.h"
 #include "Debug.h"
 #include "EliminateBoolVectors.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "Simplify.h"
 
 namespace Halide {
 namespace Internal {
@@ -233,9 +236,42 @@ string CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::print_extern_call(const Call *op) {
     return rhs.str();
 }
 
+Expr CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::aligned_vector_index(const string &name, const Expr &index,
+                                                                 const ModulusRemainder &align) {
+    Expr ramp_base = strided_ramp_base(index);
+    if (!ramp_base.defined() || !kernel_buffers.count(name)) {
+        return Expr();
+    }
+    int lanes = index.type().lanes();
+    // OpenCL's 3-vectors are padded to the size of 4-vectors.
+    if (lanes != 2 && lanes != 4 && lanes != 8 && lanes != 16) {
+        return Expr();
+    }
+    if (align.modulus % lanes != 0 || align.remainder % lanes != 0) {
+        return Expr();
+    }
+    return simplify(ramp_base / lanes);
+}
+
 void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Load *op) {
     user_assert(is_one(op->predicate)) << "Predicated load is not supported inside OpenCL kernel.\n";
 
+    // If the load is a contiguous ramp that's aligned to the vector
+    // size, load it through a vector pointer. Many drivers can't
+    // prove the alignment of vloadn, and split it into scalar loads.
+    Expr vector_index = op->type.is_bool() ? Expr() : aligned_vector_index(op->name, op->index, op->alignment);
+    if (vector_index.defined()) {
+        string id_vector_index = print_expr(vector_index);
+
+        ostringstream rhs;
+        rhs << "((" << get_memory_space(op->name) << " "
+            << print_type(op->type) << " *)"
+            << print_name(op->name) << ")[" << id_vector_index << "]";
+
+        print_assignment(op->type, rhs.str());
+        return;
+    }
+
     // If we're loading a contiguous ramp into a vector, use vload instead.
     Expr ramp_base = strided_ramp_base(op->index);
     if (ramp_base.defined()) {
@@ -299,15 +335,128 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Load *op) {
     }
 }
 
+void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Atomic *op) {
+    ScopedBinding<> bind(atomic_producers, op->producer_name);
+    op->body.accept(this);
+}
+
+bool CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::emit_atomic_store(const Store *op) {
+    Type t = op->value.type();
+    string old_value_name = unique_name("atomic_old_value");
+    Expr update = atomic_update_in_terms_of(op, old_value_name);
+    if (!update.defined()) {
+        return false;
+    }
+
+    user_assert(t.bits() == 32)
+        << "OpenCL only supports atomic() updates of 32-bit types, but "
+        << op->name << " is of type " << t << "\n";
+
+    string space = get_memory_space(op->name);
+    string id_index = print_expr(op->index);
+    string address = "&((" + space + " " + print_type(t) + " *)" +
+        print_name(op->name) + ")[" + id_index + "]";
+
+    // The built-in atomic functions cover integer add, sub, min, and
+    // max of the old value and something that doesn't depend on it.
+    Expr old_value = Variable::make(t, old_value_name);
+    Expr operand;
+    string fn;
+    if (!t.is_float()) {
+        if (const Add *add = update.as<Add>()) {
+            fn = "atomic_add";
+            if (equal(add->a, old_value)) {
+                operand = add->b;
+            } else if (equal(add->b, old_value)) {
+                operand = add->a;
+            }
+        } else if (const Sub *sub = update.as<Sub>()) {
+            fn = "atomic_sub";
+            if (equal(sub->a, old_value)) {
+                operand = sub->b;
+            }
+        } else if (const Min *min = update.as<Min>()) {
+            fn = "atomic_min";
+            if (equal(min->a, old_value)) {
+                operand = min->b;
+            } else if (equal(min->b, old_value)) {
+                operand = min->a;
+            }
+        } else if (const Max *max = update.as<Max>()) {
+            fn = "atomic_max";
+            if (equal(max->a, old_value)) {
+                operand = max->b;
+            } else if (equal(max->b, old_value)) {
+                operand = max->a;
+            }
+        }
+    }
+
+    if (operand.defined() && !expr_uses_var(operand, old_value_name)) {
+        string id_operand = print_expr(operand);
+        do_indent();
+        stream << fn << "((volatile " << space << " " << print_type(t) << " *)"
+               << address << ", " << id_operand << ");\n";
+        return true;
+    }
+
+    // Otherwise use a compare-and-swap loop on the bits of the value.
+    string id_ptr = "_" + unique_name('V');
+    string id_expected = "_" + unique_name('V');
+    string id_actual = "_" + unique_name('V');
+    do_indent();
+    stream << "volatile " << space << " uint *" << id_ptr
+           << " = (volatile " << space << " uint *)" << address << ";\n";
+    do_indent();
+    stream << "uint " << id_expected << ", " << id_actual << " = *" << id_ptr << ";\n";
+    do_indent();
+    stream << "do\n";
+    open_scope();
+    do_indent();
+    stream << id_expected << " = " << id_actual << ";\n";
+    do_indent();
+    stream << print_type(t) << " " << print_name(old_value_name)
+           << " = as_" << print_type(t) << "(" << id_expected << ");\n";
+    string id_update = print_expr(update);
+    do_indent();
+    stream << id_actual << " = atomic_cmpxchg(" << id_ptr << ", " << id_expected
+           << ", as_uint(" << id_update << "));\n";
+    indent--;
+    do_indent();
+    stream << "} while (" << id_actual << " != " << id_expected << ");\n";
+    cache.clear();
+    return true;
+}
+
 void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Store *op) {
+    if (atomic_producers.contains(op->name)) {
+        if (op->value.type().is_vector() || !is_one(op->predicate)) {
+            // Each lane needs its own atomic update.
+            scalarize_atomic_store(op).accept(this);
+            return;
+        } else if (emit_atomic_store(op)) {
+            return;
+        }
+    }
+
     user_assert(is_one(op->predicate)) << "Predicated store is not supported inside OpenCL kernel.\n";
 
     string id_value = print_expr(op->value);
     Type t = op->value.type();
 
-    // If we're writing a contiguous ramp, use vstore instead.
+    // If we're writing a contiguous ramp that's aligned to the vector
+    // size, store through a vector pointer. Otherwise use vstore.
+    Expr vector_index = t.is_bool() ? Expr() : aligned_vector_index(op->name, op->index, op->alignment);
     Expr ramp_base = strided_ramp_base(op->index);
-    if (ramp_base.defined()) {
+    if (vector_index.defined()) {
+        string id_vector_index = print_expr(vector_index);
+
+        do_indent();
+        stream << "((" << get_memory_space(op->name) << " "
+               << print_type(t) << " *)"
+               << print_name(op->name) << ")[" << id_vector_index << "] = "
+               << id_value << ";\n";
+    } else if (ramp_base.defined()) {
         internal_assert(op->value.type().is_vector());
         string id_ramp_base = print_expr(ramp_base);
 
@@ -605,8 +754,14 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::add_kernel(Stmt s,
         }
     }
 
-    // Emit the function prototype
-    stream << "__kernel void " << name << "(\n";
+    // Emit the function prototype. Kernels that shuffle across
+    // lanes ask for subgroups at least as wide as the loop over lanes.
+    stream << "__kernel ";
+    int shuffle_width = CodeGen_GPU_Dev::gpu_shuffle_width(s);
+    if (shuffle_width > 0) {
+        stream << "halide_reqd_sub_group_size(" << std::max(8, shuffle_width) << ") ";
+    }
+    stream << "void " << name << "(\n";
     for (size_t i = 0; i < args.size(); i++) {
         if (args[i].is_buffer) {
             stream << " " << get_memory_space(args[i].name) << " ";
@@ -617,6 +772,7 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::add_kernel(Stmt s,
             Allocation alloc;
             alloc.type = args[i].type;
             allocations.push(args[i].name, alloc);
+            kernel_buffers.insert(args[i].name);
         } else {
             Type t = args[i].type;
             // Bools are passed as a uint8.
@@ -643,6 +799,7 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::add_kernel(Stmt s,
             allocations.pop(args[i].name);
         }
     }
+    kernel_buffers.clear();
 
     // Undef all the buffer address spaces, in case they're different in another kernel.
     for (size_t i = 0; i < args.size(); i++) {
@@ -699,6 +856,23 @@ void CodeGen_OpenCL_Dev::init_module() {
     // __shared always has address space __local.
     src_stream << "#define __address_space___shared __local\n";
 
+    // Shuffles across the lanes of a gpu_lanes loop. The source lane
+    // is given relative to this one, because the subgroup may be wider
+    // than the loop over lanes.
+    src_stream << "#if defined(cl_khr_subgroup_shuffle)\n"
+               << "#pragma OPENCL EXTENSION cl_khr_subgroups : enable\n"
+               << "#pragma OPENCL EXTENSION cl_khr_subgroup_shuffle : enable\n"
+               << "#define halide_gpu_shuffle(x, delta, width) sub_group_shuffle(x, get_sub_group_local_id() + (delta))\n"
+               << "#elif defined(cl_intel_subgroups)\n"
+               << "#pragma OPENCL EXTENSION cl_intel_subgroups : enable\n"
+               << "#define halide_gpu_shuffle(x, delta, width) intel_sub_group_shuffle(x, get_sub_group_local_id() + (delta))\n"
+               << "#endif\n"
+               << "#if defined(cl_intel_required_subgroup_size)\n"
+               << "#define halide_reqd_sub_group_size(n) __attribute__((intel_reqd_sub_group_size(n)))\n"
+               << "#else\n"
+               << "#define halide_reqd_sub_group_size(n)\n"
+               << "#endif\n";
+
     if (target.has_feature(Target::CLDoubles)) {
         src_stream << "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n"
                    << "bool is_nan_f64(double x) {return x != x; }\n"
@@ -5,6 +5,7 @@
  * Defines the code-generator for producing OpenCL C kernel code
  */
 
+#include <set>
 #include <sstream>
 
 #include "CodeGen_C.h"
@@ -58,12 +59,32 @@ protected:
 
         std::string get_memory_space(const std::string &);
 
+        // The producers whose stores must currently be done atomically.
+        Scope<> atomic_producers;
+
+        // The buffers passed to the current kernel. Their base
+        // addresses are aligned to at least the largest vector type,
+        // because even crops of them are sub-buffers, so dense vector
+        // accesses to them with a suitably aligned index can be done
+        // through a vector pointer instead of vloadn/vstoren.
+        std::set<std::string> kernel_buffers;
+
+        // If a dense vector access with the given index and alignment
+        // into the named buffer can use a vector pointer, returns the
+        // index of the vector. Otherwise returns an undefined Expr.
+        Expr aligned_vector_index(const std::string &name, const Expr &index, const ModulusRemainder &align);
+
+        // Emit a scalar store inside an Atomic node. Returns false if
+        // an ordinary store will do.
+        bool emit_atomic_store(const Store *op);
+
         void visit(const For *) override;
         void visit(const Ramp *op) override;
         void visit(const Broadcast *op) override;
         void visit(const Call *op) override;
         void visit(const Load *op) override;
         void visit(const Store *op) override;
+        void visit(const Atomic *op) override;
         void visit(const Cast *op) override;
         void visit(const Select *op) override;
         void visit(const EQ *) override;
@@ -7,6 +7,7 @@
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "IRVisitor.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
 #include "Simplify.h"
@@ -14,6 +15,7 @@
 #include "Target.h"
 
 #include <fstream>
+#include <iterator>
 
 // This is declared in NVPTX.h, which is not exported. Ugly, but seems better than
 // hardcoding a path to the .h file.
@@ -48,6 +50,56 @@ CodeGen_PTX_Dev::~CodeGen_PTX_Dev() {
     delete context;
 }
 
+namespace {
+// Find the extents of the thread loops of a kernel, if they are
+// constant. These become the kernel's launch bounds.
+class FindConstantThreadExtents : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        const char *suffixes[] = {".__thread_id_x", ".__thread_id_y", ".__thread_id_z"};
+        for (int i = 0; i < 3; i++) {
+            if (ends_with(op->name, suffixes[i])) {
+                const int64_t *extent = as_const_int(op->extent);
+                if (extent) {
+                    extents[i] = *extent;
+                } else {
+                    all_constant = false;
+                }
+            }
+        }
+        if (ends_with(op->name, ".__thread_id_w")) {
+            all_constant = false;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    int64_t extents[3] = {1, 1, 1};
+    bool all_constant = true;
+};
+
+class ReadsSharedMemory : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *op) override {
+        if (op->name == "__shared") {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result = false;
+};
+
+bool reads_shared_memory(const Stmt &s) {
+    ReadsSharedMemory v;
+    s.accept(&v);
+    return v.result;
+}
+}  // namespace
+
 void CodeGen_PTX_Dev::add_kernel(Stmt stmt,
                                  const std::string &name,
                                  const std::vector<DeviceArgument> &args) {
@@ -77,6 +129,8 @@ void CodeGen_PTX_Dev::add_kernel(Stmt stmt,
         }
     }
 
+    in_thread_loop = use_cp_async = cp_async_pending = false;
+
     // Make the initial basic block
     entry_block = BasicBlock::Create(*context, "entry", function);
     builder->SetInsertPoint(entry_block);
@@ -125,6 +179,26 @@ void CodeGen_PTX_Dev::add_kernel(Stmt stmt,
 
     module->getOrInsertNamedMetadata("nvvm.annotations")->addOperand(md_node);
 
+    // If the block size is known at compile time, tell ptxas about
+    // it. This lets it allocate registers for the actual number of
+    // threads rather than for the largest block the device supports.
+    FindConstantThreadExtents thread_extents;
+    stmt.accept(&thread_extents);
+    if (thread_extents.all_constant) {
+        const char *names[] = {"maxntidx", "maxntidy", "maxntidz"};
+        for (int i = 0; i < 3; i++) {
+            llvm::Metadata *md_bound[] = {
+                llvm::ValueAsMetadata::get(function),
+                MDString::get(*context, names[i]),
+                llvm::ValueAsMetadata::get(ConstantInt::get(i32_t, thread_extents.extents[i]))
+            };
+            module->getOrInsertNamedMetadata("nvvm.annotations")->addOperand(MDNode::get(*context, md_bound));
+        }
+        debug(2) << "Launch bounds for " << name << ": "
+                 << thread_extents.extents[0] << " x "
+                 << thread_extents.extents[1] << " x "
+                 << thread_extents.extents[2] << "\n";
+    }
 
     // Now verify the function is ok
     verifyFunction(*function);
@@ -150,6 +224,9 @@ void CodeGen_PTX_Dev::init_module() {
 
 void CodeGen_PTX_Dev::visit(const Call *op) {
     if (op->is_intrinsic(Call::gpu_thread_barrier)) {
+        // Our own cp.async copies must land before the other threads
+        // can see them.
+        wait_for_cp_async();
         llvm::Function *barrier0 = module->getFunction("llvm.nvvm.barrier0");
         internal_assert(barrier0) << "Could not find PTX barrier intrinsic (llvm.nvvm.barrier0)\n";
         builder->CreateCall(barrier0);
@@ -159,6 +236,16 @@ void CodeGen_PTX_Dev::visit(const Call *op) {
     }
 }
 
+void CodeGen_PTX_Dev::wait_for_cp_async() {
+    if (cp_async_pending) {
+        llvm::FunctionType *wait_all_t = llvm::FunctionType::get(void_t, false);
+        llvm::InlineAsm *wait_all =
+            llvm::InlineAsm::get(wait_all_t, "cp.async.wait_all;", "~{memory}", true);
+        builder->CreateCall(wait_all_t, wait_all);
+        cp_async_pending = false;
+    }
+}
+
 string CodeGen_PTX_Dev::simt_intrinsic(const string &name) {
     if (ends_with(name, ".__thread_id_x")) {
         return "llvm.nvvm.read.ptx.sreg.tid.x";
@@ -186,9 +273,21 @@ void CodeGen_PTX_Dev::visit(const For *loop) {
         Expr simt_idx = Call::make(Int(32), simt_intrinsic(loop->name), std::vector<Expr>(), Call::Extern);
         internal_assert(is_zero(loop->min));
         sym_push(loop->name, codegen(simt_idx));
-        codegen(loop->body);
+        if (is_gpu_thread_var(loop->name) && !in_thread_loop) {
+            ScopedValue<bool> old_in_thread_loop(in_thread_loop, true);
+            ScopedValue<bool> old_use_cp_async(use_cp_async,
+                                               target.has_feature(Target::CUDACapability80));
+            codegen(loop->body);
+        } else {
+            codegen(loop->body);
+        }
         sym_pop(loop->name);
     } else {
+        // Reads of shared memory wait for the copies made before them,
+        // but a copy made in one iteration of a serial loop could be
+        // read in the next one, before the wait.
+        ScopedValue<bool> old_use_cp_async(use_cp_async,
+                                           use_cp_async && !reads_shared_memory(loop->body));
         CodeGen_LLVM::visit(loop);
     }
 }
@@ -236,40 +335,136 @@ void CodeGen_PTX_Dev::visit(const AssertStmt *op) {
     codegen(IfThenElse::make(!op->condition, Evaluate::make(trap)));
 }
 
+namespace {
+
+// If a dense vector access of the given type and alignment can be
+// done as a sequence of aligned 128-bit accesses, returns the number
+// of lanes in each one. Otherwise returns zero.
+int lanes_per_128_bit_access(const Ramp *r, Type t, const ModulusRemainder &align) {
+    if (!r || !is_one(r->stride) || t.bits() > 64 || 128 % t.bits() != 0) {
+        return 0;
+    }
+    int k = 128 / t.bits();
+    if (r->lanes < k || r->lanes % k != 0 ||
+        align.modulus % k != 0 || align.remainder % k != 0) {
+        return 0;
+    }
+    return k;
+}
+
+#if LLVM_VERSION < 110
+// Replace the operand of the first line of some PTX that starts with
+// the given directive.
+string set_ptx_directive(const string &ptx, const string &directive, const string &value) {
+    size_t start = ptx.find("\n" + directive + " ");
+    internal_assert(start != string::npos) << "No " << directive << " directive in PTX\n";
+    start += directive.size() + 2;
+    size_t end = ptx.find('\n', start);
+    return ptx.substr(0, start) + value + ptx.substr(end);
+}
+#endif
+
+}  // namespace
+
 void CodeGen_PTX_Dev::visit(const Load *op) {
+    if (op->name == "__shared") {
+        // This thread may be reading back its own cp.async copy.
+        wait_for_cp_async();
+    }
 
-    // Do aligned 4-wide 32-bit loads as a single i128 load.
+    // Do aligned dense loads as a sequence of i128 loads, which become
+    // ld.global.v4 (or v2 for 64-bit types).
     const Ramp *r = op->index.as<Ramp>();
-    // TODO: lanes >= 4, not lanes == 4
-    if (is_one(op->predicate) && r && is_one(r->stride) && r->lanes == 4 && op->type.bits() == 32) {
-        ModulusRemainder align = op->alignment;
-        if (align.modulus % 4 == 0 && align.remainder % 4 == 0) {
-            Expr index = simplify(r->base / 4);
-            Expr equiv = Load::make(UInt(128), op->name, index,
-                                    op->image, op->param, const_true(), align / 4);
-            equiv = reinterpret(op->type, equiv);
-            codegen(equiv);
-            return;
+    int k = lanes_per_128_bit_access(r, op->type, op->alignment);
+    if (is_one(op->predicate) && !atomic_producers.contains(op->name) && k) {
+        Expr base = simplify(r->base / k);
+        ModulusRemainder align = op->alignment / k;
+        vector<Expr> slices;
+        for (int i = 0; i < r->lanes / k; i++) {
+            Expr slice = Load::make(UInt(128), op->name, simplify(base + i),
+                                    op->image, op->param, const_true(), align + i);
+            slices.push_back(reinterpret(op->type.with_lanes(k), slice));
         }
+        codegen(Shuffle::make_concat(slices));
+        return;
     }
 
     CodeGen_LLVM::visit(op);
 }
 
+bool CodeGen_PTX_Dev::try_cp_async(const Store *op) {
+    const Load *load = op->value.as<Load>();
+    if (!use_cp_async || op->name != "__shared" || !is_one(op->predicate) ||
+        !load || !is_one(load->predicate) || load->name == "__shared" ||
+        !llvm::isa<llvm::Argument>(sym_get(load->name))) {
+        return false;
+    }
+
+    // cp.async copies 4, 8, or 16 bytes, aligned to the size.
+    Type t = op->value.type();
+    vector<Expr> dst_idx, src_idx;
+    Type chunk_type = t;
+    if (t.is_scalar() && (t.bytes() == 4 || t.bytes() == 8)) {
+        dst_idx.push_back(op->index);
+        src_idx.push_back(load->index);
+    } else {
+        const Ramp *dst_ramp = op->index.as<Ramp>();
+        const Ramp *src_ramp = load->index.as<Ramp>();
+        int k = lanes_per_128_bit_access(dst_ramp, t, op->alignment);
+        if (!k || lanes_per_128_bit_access(src_ramp, t, load->alignment) != k) {
+            return false;
+        }
+        chunk_type = UInt(128);
+        for (int i = 0; i < t.lanes() / k; i++) {
+            dst_idx.push_back(simplify(dst_ramp->base / k + i));
+            src_idx.push_back(simplify(src_ramp->base / k + i));
+        }
+    }
+
+    // LLVM has no cp.async intrinsics before LLVM 13, so the copies
+    // are inline PTX on the shared and global addresses.
+    llvm::FunctionType *cp_async_t = llvm::FunctionType::get(void_t, {i64_t, i64_t}, false);
+    string asm_str = "cp.async.ca.shared.global [$0], [$1], " + std::to_string(chunk_type.bytes()) + ";";
+    llvm::InlineAsm *cp_async = llvm::InlineAsm::get(cp_async_t, asm_str, "l,l,~{memory}", true);
+    llvm::Type *global_ptr_t = i8_t->getPointerTo(1);
+    for (size_t i = 0; i < dst_idx.size(); i++) {
+        Value *dst = codegen_buffer_pointer("__shared", chunk_type, dst_idx[i]);
+        Value *src = codegen_buffer_pointer(load->name, chunk_type, src_idx[i]);
+        src = builder->CreateAddrSpaceCast(builder->CreatePointerCast(src, i8_t->getPointerTo()), global_ptr_t);
+        builder->CreateCall(cp_async_t, cp_async, {builder->CreatePtrToInt(dst, i64_t),
+                                                   builder->CreatePtrToInt(src, i64_t)});
+    }
+    cp_async_pending = true;
+    return true;
+}
+
 void CodeGen_PTX_Dev::visit(const Store *op) {
 
-    // Do aligned 4-wide 32-bit stores as a single i128 store.
+    if (try_cp_async(op)) {
+        return;
+    }
+
+    // Do aligned dense stores as a sequence of i128 stores.
     const Ramp *r = op->index.as<Ramp>();
-    // TODO: lanes >= 4, not lanes == 4
-    if (is_one(op->predicate) && r && is_one(r->stride) && r->lanes == 4 && op->value.type().bits() == 32) {
-        ModulusRemainder align = op->alignment;
-        if (align.modulus % 4 == 0 && align.remainder % 4 == 0) {
-            Expr index = simplify(r->base / 4);
+    int k = lanes_per_128_bit_access(r, op->value.type(), op->alignment);
+    if (is_one(op->predicate) && k) {
+        Expr base = simplify(r->base / k);
+        ModulusRemainder align = op->alignment / k;
+        if (r->lanes == k) {
             Expr value = reinterpret(UInt(128), op->value);
-            Stmt equiv = Store::make(op->name, value, index, op->param, const_true(), align / 4);
-            codegen(equiv);
+            codegen(Store::make(op->name, value, base, op->param, const_true(), align));
             return;
         }
+        // Compute the value once, and then store each slice of it.
+        string value_name = unique_name('t');
+        Expr value = Variable::make(op->value.type(), value_name);
+        vector<Stmt> stores;
+        for (int i = 0; i < r->lanes / k; i++) {
+            Expr slice = reinterpret(UInt(128), Shuffle::make_slice(value, i * k, 1, k));
+            stores.push_back(Store::make(op->name, slice, simplify(base + i), op->param, const_true(), align + i));
+        }
+        codegen(LetStmt::make(value_name, op->value, Block::make(stores)));
+        return;
     }
 
     CodeGen_LLVM::visit(op);
@@ -280,7 +475,17 @@ string CodeGen_PTX_Dev::march() const {
 }
 
 string CodeGen_PTX_Dev::mcpu() const {
-    if (target.has_feature(Target::CUDACapability61)) {
+    if (target.has_feature(Target::CUDACapability80)) {
+        #if LLVM_VERSION >= 110
+        return "sm_80";
+        #else
+        // This LLVM doesn't know sm_80, so the code is generated for
+        // sm_70 and retargeted in compile_to_src.
+        return "sm_70";
+        #endif
+    } else if (target.has_feature(Target::CUDACapability70)) {
+        return "sm_70";
+    } else if (target.has_feature(Target::CUDACapability61)) {
         return "sm_61";
     } else if (target.has_feature(Target::CUDACapability50)) {
         return "sm_50";
@@ -296,7 +501,16 @@ string CodeGen_PTX_Dev::mcpu() const {
 }
 
 string CodeGen_PTX_Dev::mattrs() const {
-    if (target.has_feature(Target::CUDACapability61)) {
+    if (target.has_feature(Target::CUDACapability80)) {
+        #if LLVM_VERSION >= 110
+        return "+ptx70";
+        #else
+        return "+ptx60";
+        #endif
+    } else if (target.has_feature(Target::CUDACapability70)) {
+        // Need ptx isa 6.0 for the wmma instructions.
+        return "+ptx60";
+    } else if (target.has_feature(Target::CUDACapability61)) {
         return "+ptx50";
     } else if (target.features_any_of({Target::CUDACapability32,
                                 Target::CUDACapability50})) {
@@ -429,9 +643,21 @@ vector<char> CodeGen_PTX_Dev::compile_to_src() {
     }
     debug(2) << "Done with CodeGen_PTX_Dev::compile_to_src";
 
-    debug(1) << "PTX kernel:\n" << outstr.c_str() << "\n";
+    string src(outstr.begin(), outstr.end());
+    string gpu_name = mcpu();
+    #if LLVM_VERSION < 110
+    if (this->target.has_feature(Target::CUDACapability80)) {
+        // PTX is forward compatible, so the sm_70 code only needs a
+        // new header to use the sm_80 instructions emitted inline.
+        src = set_ptx_directive(src, ".version", "7.0");
+        src = set_ptx_directive(src, ".target", "sm_80");
+        gpu_name = "sm_80";
+    }
+    #endif
 
-    vector<char> buffer(outstr.begin(), outstr.end());
+    debug(1) << "PTX kernel:\n" << src << "\n";
+
+    vector<char> buffer(src.begin(), src.end());
 
     // Dump the SASS too if the cuda SDK is in the path
     if (debug::debug_level() >= 2) {
@@ -444,27 +670,33 @@ vector<char> CodeGen_PTX_Dev::compile_to_src() {
         f.write(buffer.data(), buffer.size());
         f.close();
 
-        string cmd = "ptxas --gpu-name " + mcpu() + " " + ptx.pathname() + " -o " + sass.pathname();
+        string cmd = "ptxas --gpu-name " + gpu_name + " " + ptx.pathname() + " -o " + sass.pathname();
         if (system(cmd.c_str()) == 0) {
             cmd = "nvdisasm " + sass.pathname();
             int ret = system(cmd.c_str());
             (void)ret; // Don't care if it fails
         }
+    }
 
-        // Note: It works to embed the contents of the .sass file in
-        // the buffer instead of the ptx source, and this could help
-        // with app startup times. Expose via the target?
-        /*
-        {
-            std::ifstream f(sass.pathname());
-            buffer.clear();
-            f.seekg(0, std::ios_base::end);
-            std::streampos sz = f.tellg();
-            buffer.resize(sz);
-            f.seekg(0, std::ios_base::beg);
-            f.read(buffer.data(), sz);
-        }
-        */
+    if (this->target.has_feature(Target::CUDACubin)) {
+        // Compile the PTX to native code for the target compute
+        // capability now, so that the driver doesn't have to
+        // JIT-compile it every time the pipeline is loaded.
+        TemporaryFile ptx(get_current_kernel_name(), ".ptx");
+        TemporaryFile cubin(get_current_kernel_name(), ".cubin");
+
+        std::ofstream f(ptx.pathname());
+        f.write(buffer.data(), buffer.size());
+        f.close();
+
+        string cmd = "ptxas --gpu-name " + gpu_name + " " + ptx.pathname() + " -o " + cubin.pathname();
+        debug(1) << "Compiling PTX to a cubin: " << cmd << "\n";
+        user_assert(system(cmd.c_str()) == 0)
+            << "The cuda_cubin target feature requires ptxas from the CUDA SDK to be in the path.\n";
+
+        std::ifstream in(cubin.pathname(), std::ios::binary);
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        user_assert(!buffer.empty()) << "ptxas produced an empty cubin.\n";
     }
 
     // Null-terminate the ptx source
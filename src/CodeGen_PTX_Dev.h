@@ -74,6 +74,16 @@ protected:
     /** Map from simt variable names (e.g. foo.__block_id_x) to the llvm
      * ptx intrinsic functions to call to get them. */
     std::string simt_intrinsic(const std::string &name);
+
+    /** On sm_80 and later, copies from global to shared memory in
+     * thread loops are done with cp.async, which skips the
+     * registers. They are waited for at the next barrier or read of
+     * shared memory. */
+    // @{
+    bool in_thread_loop = false, use_cp_async = false, cp_async_pending = false;
+    bool try_cp_async(const Store *op);
+    void wait_for_cp_async();
+    // @}
 };
 
 }  // namespace Internal
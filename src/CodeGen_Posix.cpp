@@ -237,6 +237,8 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
         allocation.ptr = builder->CreatePointerCast(call, llvm_type_of(type)->getPointerTo());
         allocation.pseudostack_slot = slot;
     } else {
+        // The pointer to free, if it's not allocation.ptr.
+        Value *heap_allocation = nullptr;
         if (new_expr.defined()) {
             allocation.ptr = codegen(new_expr);
         } else {
@@ -257,12 +259,42 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
             debug(4) << "\n";
             Value *args[2] = { get_user_context(), llvm_size };
 
-            Value *call = builder->CreateCall(malloc_fn, args);
-
-            // Fix the type to avoid pointless bitcasts later
-            call = builder->CreatePointerCast(call, llvm_type_of(type)->getPointerTo());
-
-            allocation.ptr = call;
+            if (in_loop && memory_type == MemoryType::Auto && constant_bytes == 0 && free_function.empty()) {
+                // The size is only known at runtime. Use scratch
+                // space on the stack if it's small, and only call
+                // halide_malloc otherwise.
+                allocation.scratch = get_scratch(name);
+                Value *scratch = builder->CreatePointerCast(allocation.scratch, malloc_fn->getReturnType());
+
+                BasicBlock *before_bb = builder->GetInsertBlock();
+                BasicBlock *heap_bb = BasicBlock::Create(*context, name + "_heap", function);
+                BasicBlock *after_bb = BasicBlock::Create(*context, name + "_allocated", function);
+                Value *fits = builder->CreateICmpULE(llvm_size, ConstantInt::get(llvm_size->getType(), max_scratch_bytes));
+                builder->CreateCondBr(fits, after_bb, heap_bb, very_likely_branch);
+
+                builder->SetInsertPoint(heap_bb);
+                Value *call = builder->CreateCall(malloc_fn, args);
+                builder->CreateBr(after_bb);
+
+                builder->SetInsertPoint(after_bb);
+                PHINode *ptr = builder->CreatePHI(malloc_fn->getReturnType(), 2);
+                ptr->addIncoming(scratch, before_bb);
+                ptr->addIncoming(call, heap_bb);
+                // Only the heap allocation needs to be freed.
+                PHINode *heap_ptr = builder->CreatePHI(malloc_fn->getReturnType(), 2);
+                heap_ptr->addIncoming(ConstantPointerNull::get(cast<PointerType>(malloc_fn->getReturnType())), before_bb);
+                heap_ptr->addIncoming(call, heap_bb);
+
+                allocation.ptr = builder->CreatePointerCast(ptr, llvm_type_of(type)->getPointerTo());
+                heap_allocation = heap_ptr;
+            } else {
+                Value *call = builder->CreateCall(malloc_fn, args);
+
+                // Fix the type to avoid pointless bitcasts later
+                call = builder->CreatePointerCast(call, llvm_type_of(type)->getPointerTo());
+
+                allocation.ptr = call;
+            }
         }
 
         // Assert that the allocation worked.
@@ -286,7 +318,7 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
         }
         llvm::Function *free_fn = module->getFunction(free_function);
         internal_assert(free_fn) << "Could not find " << free_function << " in module.\n";
-        allocation.destructor = register_destructor(free_fn, allocation.ptr, OnError);
+        allocation.destructor = register_destructor(free_fn, heap_allocation ? heap_allocation : allocation.ptr, OnError);
         allocation.destructor_function = free_fn;
     }
 
@@ -314,10 +346,27 @@ void CodeGen_Posix::free_allocation(const std::string &name) {
         trigger_destructor(alloc.destructor_function, alloc.destructor);
     }
 
+    if (alloc.scratch) {
+        free_scratch.push_back(alloc.scratch);
+    }
+
     allocations.pop(name);
     sym_pop(name);
 }
 
+Value *CodeGen_Posix::get_scratch(const std::string &name) {
+    llvm::Function *current_func = builder->GetInsertBlock()->getParent();
+    for (auto it = free_scratch.begin(); it != free_scratch.end(); ++it) {
+        AllocaInst *alloca_inst = dyn_cast<AllocaInst>(*it);
+        if (alloca_inst && alloca_inst->getParent()->getParent() == current_func) {
+            Value *scratch = *it;
+            free_scratch.erase(it);
+            return scratch;
+        }
+    }
+    return create_alloca_at_entry(i8_t, max_scratch_bytes, false, name + ".scratch");
+}
+
 string CodeGen_Posix::get_allocation_name(const std::string &n) {
     if (allocations.contains(n)) {
         return allocations.get(n).name;
@@ -349,5 +398,10 @@ void CodeGen_Posix::visit(const Free *stmt) {
     free_allocation(stmt->name);
 }
 
+void CodeGen_Posix::visit(const For *op) {
+    ScopedValue<bool> old_in_loop(in_loop, true);
+    CodeGen_LLVM::visit(op);
+}
+
 }  // namespace Internal
 }  // namespace Halide
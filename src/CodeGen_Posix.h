@@ -24,12 +24,17 @@ protected:
 
     /** Posix implementation of Allocate. Small constant-sized allocations go
      * on the stack. The rest go on the heap by calling "halide_malloc"
-     * and "halide_free" in the standard library. */
+     * and "halide_free" in the standard library, unless their size
+     * turns out to be small at runtime. */
     // @{
     void visit(const Allocate *) override;
     void visit(const Free *) override;
     // @}
 
+    /** Track whether we're inside a loop, where heap allocations are
+     * worth avoiding. */
+    void visit(const For *) override;
+
     /** It can be convenient for backends to assume there is extra
      * padding beyond the end of a buffer to enable faster
      * loads/stores. This function gets the padding required by the
@@ -51,6 +56,11 @@ protected:
          * allocations of type Stack with dynamic size. */
         llvm::Value *pseudostack_slot = nullptr;
 
+        /** Stack space used instead of the heap when the size turns
+         * out to be small. Non-null for allocations of type Auto with
+         * dynamic size. */
+        llvm::Value *scratch = nullptr;
+
         /** The (Halide) type of the allocation. */
         Type type;
 
@@ -85,6 +95,22 @@ private:
      * for debug output purposes. */
     size_t cur_stack_alloc_total{0};
 
+    /** Scratch stack space of dynamically-sized allocations that were
+     * freed, and can be re-used by another. */
+    std::vector<llvm::Value *> free_scratch;
+
+    /** Dynamically-sized heap allocations inside loops of at most
+     * this many bytes use scratch space on the stack instead. As
+     * parallel loop bodies are separate functions, each thread has
+     * its own scratch space. */
+    static const int max_scratch_bytes = 1024;
+
+    /** Are we inside a loop? */
+    bool in_loop = false;
+
+    /** Get scratch stack space for a dynamically-sized allocation. */
+    llvm::Value *get_scratch(const std::string &name);
+
     /** Generates code for computing the size of an allocation from a
      * list of its extents and its size. Fires a runtime assert
      * (halide_error) if the size overflows 2^31 -1, the maximum
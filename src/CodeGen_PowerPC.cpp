@@ -51,6 +51,7 @@ void CodeGen_PowerPC::visit(const Cast *op) {
 
     struct Pattern {
         bool needs_vsx;
+        bool le_only;
         bool wide_op;
         Type type;
         string intrin;
@@ -58,42 +59,51 @@ void CodeGen_PowerPC::visit(const Cast *op) {
     };
 
     static Pattern patterns[] = {
-        {false, true, Int(8, 16), "llvm.ppc.altivec.vaddsbs",
+        {false, false, true, Int(8, 16), "llvm.ppc.altivec.vaddsbs",
          i8_sat(wild_i16x_ + wild_i16x_)},
-        {false, true, Int(8, 16), "llvm.ppc.altivec.vsubsbs",
+        {false, false, true, Int(8, 16), "llvm.ppc.altivec.vsubsbs",
          i8_sat(wild_i16x_ - wild_i16x_)},
-        {false, true, UInt(8, 16), "llvm.ppc.altivec.vaddubs",
+        {false, false, true, UInt(8, 16), "llvm.ppc.altivec.vaddubs",
          u8_sat(wild_u16x_ + wild_u16x_)},
-        {false, true, UInt(8, 16), "llvm.ppc.altivec.vsububs",
+        {false, false, true, UInt(8, 16), "llvm.ppc.altivec.vsububs",
          u8(max(wild_i16x_ - wild_i16x_, 0))},
-        {false, true, Int(16, 8), "llvm.ppc.altivec.vaddshs",
+        {false, false, true, Int(16, 8), "llvm.ppc.altivec.vaddshs",
          i16_sat(wild_i32x_ + wild_i32x_)},
-        {false, true, Int(16, 8), "llvm.ppc.altivec.vsubshs",
+        {false, false, true, Int(16, 8), "llvm.ppc.altivec.vsubshs",
          i16_sat(wild_i32x_ - wild_i32x_)},
-        {false, true, UInt(16, 8), "llvm.ppc.altivec.vadduhs",
+        {false, false, true, UInt(16, 8), "llvm.ppc.altivec.vadduhs",
          u16_sat(wild_u32x_ + wild_u32x_)},
-        {false, true, UInt(16, 8), "llvm.ppc.altivec.vsubuhs",
+        {false, false, true, UInt(16, 8), "llvm.ppc.altivec.vsubuhs",
          u16(max(wild_i32x_ - wild_i32x_, 0))},
-        {false, true, Int(32, 4), "llvm.ppc.altivec.vaddsws",
+        {false, false, true, Int(32, 4), "llvm.ppc.altivec.vaddsws",
          i32_sat(wild_i64x_ + wild_i64x_)},
-        {false, true, Int(32, 4), "llvm.ppc.altivec.vsubsws",
+        {false, false, true, Int(32, 4), "llvm.ppc.altivec.vsubsws",
          i32_sat(wild_i64x_ - wild_i64x_)},
-        {false, true, UInt(32, 4), "llvm.ppc.altivec.vadduws",
+        {false, false, true, UInt(32, 4), "llvm.ppc.altivec.vadduws",
          u32_sat(wild_u64x_ + wild_u64x_)},
-        {false, true, UInt(32, 4), "llvm.ppc.altivec.vsubuws",
+        {false, false, true, UInt(32, 4), "llvm.ppc.altivec.vsubuws",
          u32(max(wild_i64x_ - wild_i64x_, 0))},
-        {false, true, Int(8, 16), "llvm.ppc.altivec.vavgsb",
+        {false, false, true, Int(8, 16), "llvm.ppc.altivec.vavgsb",
          i8(((wild_i16x_ + wild_i16x_) + 1) / 2)},
-        {false, true, UInt(8, 16), "llvm.ppc.altivec.vavgub",
+        {false, false, true, UInt(8, 16), "llvm.ppc.altivec.vavgub",
          u8(((wild_u16x_ + wild_u16x_) + 1) / 2)},
-        {false, true, Int(16, 8), "llvm.ppc.altivec.vavgsh",
+        {false, false, true, Int(16, 8), "llvm.ppc.altivec.vavgsh",
          i16(((wild_i32x_ + wild_i32x_) + 1) / 2)},
-        {false, true, UInt(16, 8), "llvm.ppc.altivec.vavguh",
+        {false, false, true, UInt(16, 8), "llvm.ppc.altivec.vavguh",
          u16(((wild_u32x_ + wild_u32x_) + 1) / 2)},
-        {false, true, Int(32, 4), "llvm.ppc.altivec.vavgsw",
+        {false, false, true, Int(32, 4), "llvm.ppc.altivec.vavgsw",
          i32(((wild_i64x_ + wild_i64x_) + 1) / 2)},
-        {false, true, UInt(32, 4), "llvm.ppc.altivec.vavguw",
+        {false, false, true, UInt(32, 4), "llvm.ppc.altivec.vavguw",
          u32(((wild_u64x_ + wild_u64x_) + 1) / 2)},
+
+        // Saturating narrowing packs, via the wrappers in powerpc.ll,
+        // which assume little-endian lanes.
+        {false, true, false, Int(8, 16), "vpkshssx16", i8_sat(wild_i16x_)},
+        {false, true, false, UInt(8, 16), "vpkshusx16", u8_sat(wild_i16x_)},
+        {false, true, false, UInt(8, 16), "vpkuhusx16", u8_sat(wild_u16x_)},
+        {false, true, false, Int(16, 8), "vpkswssx8", i16_sat(wild_i32x_)},
+        {false, true, false, UInt(16, 8), "vpkswusx8", u16_sat(wild_i32x_)},
+        {false, true, false, UInt(16, 8), "vpkuwusx8", u16_sat(wild_u32x_)},
     };
 
     for (size_t i = 0; i < sizeof(patterns)/sizeof(patterns[0]); i++) {
@@ -103,6 +113,10 @@ void CodeGen_PowerPC::visit(const Cast *op) {
             continue;
         }
 
+        if (pattern.le_only && target.bits != 64) {
+            continue;
+        }
+
         if (expr_match(pattern.pattern, op, matches)) {
             bool match = true;
             if (pattern.wide_op) {
@@ -122,6 +136,321 @@ void CodeGen_PowerPC::visit(const Cast *op) {
     CodeGen_Posix::visit(op);
 }
 
+void CodeGen_PowerPC::visit(const Mul *op) {
+    // A widening multiply is done as separate multiplies of the even
+    // and odd lanes, which are then interleaved. The instructions
+    // number lanes big-endian, so on a little-endian target the "odd"
+    // instruction multiplies the even lanes.
+    Type t = op->type;
+    if (t.is_vector() && (t.is_int() || t.is_uint()) &&
+        (t.bits() == 16 || t.bits() == 32) && t.lanes() % 2 == 0) {
+        Type narrow = t.with_bits(t.bits() / 2);
+        Expr a = lossless_cast(narrow.with_code(Type::Int), op->a);
+        Expr b = lossless_cast(narrow.with_code(Type::Int), op->b);
+        string sign = "s";
+        if (!a.defined() || !b.defined()) {
+            a = lossless_cast(narrow.with_code(Type::UInt), op->a);
+            b = lossless_cast(narrow.with_code(Type::UInt), op->b);
+            sign = "u";
+        }
+        if (a.defined() && b.defined()) {
+            string suffix = sign + (t.bits() == 16 ? "b" : "h");
+            bool le = target.bits == 64;
+            Type half_t = t.with_lanes(t.lanes() / 2);
+            int intrin_lanes = 128 / t.bits();
+            Value *a_value = codegen(a), *b_value = codegen(b);
+            Value *even = call_intrin(llvm_type_of(half_t), intrin_lanes,
+                                      (le ? "llvm.ppc.altivec.vmulo" : "llvm.ppc.altivec.vmule") + suffix,
+                                      {a_value, b_value});
+            Value *odd = call_intrin(llvm_type_of(half_t), intrin_lanes,
+                                     (le ? "llvm.ppc.altivec.vmule" : "llvm.ppc.altivec.vmulo") + suffix,
+                                     {a_value, b_value});
+            value = interleave_vectors({even, odd});
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
+namespace {
+
+void flatten_sum(const Expr &e, vector<Expr> &terms) {
+    if (const Add *add = e.as<Add>()) {
+        flatten_sum(add->a, terms);
+        flatten_sum(add->b, terms);
+    } else {
+        terms.push_back(e);
+    }
+}
+
+// View a 16-lane vector as a 4x4 tile, with lane 4*i + j in row i and
+// column j. If every row of e is the same, returns that row (as a
+// 4-lane vector). If every column is the same, and columns is true,
+// returns that column instead. Otherwise returns an undefined Expr.
+Expr tile_row_or_column(const Expr &e, bool columns) {
+    if (e.type().lanes() != 16) {
+        return Expr();
+    }
+    if (const Broadcast *b = e.as<Broadcast>()) {
+        if (b->value.type().is_scalar()) {
+            return Broadcast::make(b->value, 4);
+        } else if (b->value.type().lanes() == 4 && !columns) {
+            return b->value;
+        }
+    } else if (const Cast *c = e.as<Cast>()) {
+        Expr v = tile_row_or_column(c->value, columns);
+        if (v.defined()) {
+            return Cast::make(c->type.with_lanes(4), v);
+        }
+    } else if (const Load *l = e.as<Load>()) {
+        if (!is_one(l->predicate)) {
+            return Expr();
+        }
+        const Broadcast *b = l->index.as<Broadcast>();
+        const Ramp *r = l->index.as<Ramp>();
+        Expr index;
+        if (b && b->value.type().lanes() == 4 && !columns) {
+            index = b->value;
+        } else if (r && r->lanes == 4 && columns) {
+            const Broadcast *base = r->base.as<Broadcast>();
+            const Broadcast *stride = r->stride.as<Broadcast>();
+            if (base && stride && base->value.type().is_scalar() && stride->value.type().is_scalar()) {
+                index = Ramp::make(base->value, stride->value, 4);
+            }
+        }
+        if (index.defined()) {
+            return Load::make(l->type.with_lanes(4), l->name, index, l->image,
+                              l->param, const_true(4), ModulusRemainder());
+        }
+    } else if (const Shuffle *s = e.as<Shuffle>()) {
+        if (s->vectors.size() == 1 && s->vectors[0].type().lanes() == 4) {
+            bool match = true;
+            for (int i = 0; i < 16; i++) {
+                match = match && s->indices[i] == (columns ? i / 4 : i % 4);
+            }
+            if (match) {
+                return s->vectors[0];
+            }
+        }
+    }
+    return Expr();
+}
+
+}  // namespace
+
+void CodeGen_PowerPC::visit(const Add *op) {
+    Type t = op->type;
+    if (t.is_vector() && t.bits() == 32 &&
+        target.bits == 64 && target.has_feature(Target::POWER_ARCH_3_1) &&
+        t.lanes() == 16 && codegen_mma_update(op)) {
+        return;
+    }
+
+    // A 32-bit sum of widening products of 8 or 16-bit values can use
+    // the multiply-sum instructions, which add four byte products
+    // (vmsumubm for u8 x u8, vmsummbm for i8 x u8) or two halfword
+    // products (vmsumshm, vmsumuhm) to each lane of an accumulator.
+    // The operands of each group of products are interleaved so that
+    // the ones summed together are adjacent. Like the sum they
+    // replace, the instructions wrap on overflow.
+    if (t.is_vector() && (t.is_int() || t.is_uint()) && t.bits() == 32 && t.lanes() % 4 == 0) {
+        vector<Expr> terms;
+        flatten_sum(op, terms);
+
+        Type u8_t = UInt(8, t.lanes()), i8_t = Int(8, t.lanes());
+        Type u16_t = UInt(16, t.lanes()), i16_t = Int(16, t.lanes());
+        struct Kind {
+            Type a_t, b_t;
+            int group;
+            const char *intrin;
+        };
+        const Kind kinds[] = {
+            {u8_t, u8_t, 4, "llvm.ppc.altivec.vmsumubm"},
+            {i8_t, u8_t, 4, "llvm.ppc.altivec.vmsummbm"},
+            {i16_t, i16_t, 2, "llvm.ppc.altivec.vmsumshm"},
+            {u16_t, u16_t, 2, "llvm.ppc.altivec.vmsumuhm"},
+        };
+        const int num_kinds = sizeof(kinds) / sizeof(kinds[0]);
+        vector<Expr> dot_a[num_kinds], dot_b[num_kinds], dot_terms[num_kinds], rest;
+        for (const Expr &term : terms) {
+            const Mul *mul = term.as<Mul>();
+            bool found = false;
+            for (int k = 0; mul && !found && k < num_kinds; k++) {
+                for (int swap = 0; !found && swap < 2; swap++) {
+                    Expr a = lossless_cast(kinds[k].a_t, swap ? mul->b : mul->a);
+                    Expr b = lossless_cast(kinds[k].b_t, swap ? mul->a : mul->b);
+                    if (a.defined() && b.defined()) {
+                        dot_a[k].push_back(a);
+                        dot_b[k].push_back(b);
+                        dot_terms[k].push_back(term);
+                        found = true;
+                    }
+                }
+            }
+            if (!found) {
+                rest.push_back(term);
+            }
+        }
+
+        // Pad out a trailing partial group with zeros, unless it
+        // would only contain one real product.
+        bool any = false;
+        for (int k = 0; k < num_kinds; k++) {
+            if (dot_a[k].size() % kinds[k].group == 1) {
+                rest.push_back(dot_terms[k].back());
+                dot_a[k].pop_back();
+                dot_b[k].pop_back();
+            }
+            while (dot_a[k].size() % kinds[k].group != 0) {
+                dot_a[k].push_back(make_zero(kinds[k].a_t));
+                dot_b[k].push_back(make_zero(kinds[k].b_t));
+            }
+            any = any || !dot_a[k].empty();
+        }
+
+        if (any) {
+            Expr acc;
+            for (const Expr &term : rest) {
+                acc = acc.defined() ? acc + term : term;
+            }
+            Value *acc_value = codegen(acc.defined() ? acc : make_zero(t));
+            for (int k = 0; k < num_kinds; k++) {
+                int group = kinds[k].group;
+                for (size_t i = 0; i < dot_a[k].size(); i += group) {
+                    vector<Expr> a(dot_a[k].begin() + i, dot_a[k].begin() + i + group);
+                    vector<Expr> b(dot_b[k].begin() + i, dot_b[k].begin() + i + group);
+                    Value *a_value = codegen(Shuffle::make_interleave(a));
+                    Value *b_value = codegen(Shuffle::make_interleave(b));
+                    acc_value = call_intrin(llvm_type_of(t), 4, kinds[k].intrin, {a_value, b_value, acc_value});
+                }
+            }
+            value = acc_value;
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
+bool CodeGen_PowerPC::codegen_mma_update(const Add *op) {
+#if LLVM_VERSION >= 120
+    // A 16-lane sum that includes outer products of a row and a column
+    // of a 4x4 tile is a rank-k update of that tile, which is what the
+    // POWER10 Matrix-Multiply Assist instructions do: xvf32gerpp adds
+    // the outer product of two f32x4 vectors to a 4x4 accumulator,
+    // xvi8ger4pp the sum of four outer products of i8 columns and u8
+    // rows, and xvi16ger2pp the sum of two outer products of i16
+    // vectors. The rest of the sum initializes the accumulator.
+    Type t = op->type;
+    vector<Expr> terms;
+    flatten_sum(op, terms);
+
+    // For each kind of product, the column and row operands. Index 0
+    // is f32, 1 is i8 x u8, 2 is i16 x i16.
+    vector<Expr> cols[3], rows[3], products[3], rest;
+    for (const Expr &term : terms) {
+        const Mul *mul = term.as<Mul>();
+        bool found = false;
+        for (int swap = 0; mul && !found && swap < 2; swap++) {
+            Expr col = tile_row_or_column(swap ? mul->b : mul->a, true);
+            Expr row = tile_row_or_column(swap ? mul->a : mul->b, false);
+            if (!col.defined() || !row.defined()) {
+                continue;
+            }
+            if (t.is_float()) {
+                cols[0].push_back(col);
+                rows[0].push_back(row);
+                products[0].push_back(term);
+                found = true;
+            } else if (lossless_cast(Int(8, 4), col).defined() &&
+                       lossless_cast(UInt(8, 4), row).defined()) {
+                cols[1].push_back(lossless_cast(Int(8, 4), col));
+                rows[1].push_back(lossless_cast(UInt(8, 4), row));
+                products[1].push_back(term);
+                found = true;
+            } else if (lossless_cast(Int(16, 4), col).defined() &&
+                       lossless_cast(Int(16, 4), row).defined()) {
+                cols[2].push_back(lossless_cast(Int(16, 4), col));
+                rows[2].push_back(lossless_cast(Int(16, 4), row));
+                products[2].push_back(term);
+                found = true;
+            }
+        }
+        if (!found) {
+            rest.push_back(term);
+        }
+    }
+
+    // Integer products come in groups. Pad out a trailing partial
+    // group with zeros, unless it would only contain one real product.
+    const int group[3] = {1, 4, 2};
+    const Type narrow[3][2] = {{Float(32, 4), Float(32, 4)},
+                               {Int(8, 4), UInt(8, 4)},
+                               {Int(16, 4), Int(16, 4)}};
+    for (int k = 1; k < 3; k++) {
+        if (cols[k].size() % group[k] == 1) {
+            rest.push_back(products[k].back());
+            cols[k].pop_back();
+            rows[k].pop_back();
+        }
+        while (cols[k].size() % group[k] != 0) {
+            cols[k].push_back(make_zero(narrow[k][0]));
+            rows[k].push_back(make_zero(narrow[k][1]));
+        }
+    }
+    if (cols[0].empty() && cols[1].empty() && cols[2].empty()) {
+        return false;
+    }
+
+    Expr init;
+    for (const Expr &term : rest) {
+        init = init.defined() ? init + term : term;
+    }
+    Value *init_value = codegen(init.defined() ? init : make_zero(t));
+
+    // The accumulator is assembled from, and disassembled into, its
+    // four rows. LLVM presents them in lane order on little-endian
+    // targets too.
+    llvm::Type *v16i8_t = VectorType::get(i8_t, 16);
+    llvm::Type *acc_t = VectorType::get(i1_t, 512);
+    vector<Value *> acc_rows;
+    for (int i = 0; i < 4; i++) {
+        acc_rows.push_back(builder->CreateBitCast(slice_vector(init_value, i * 4, 4), v16i8_t));
+    }
+    FunctionCallee assemble = module->getOrInsertFunction("llvm.ppc.mma.assemble.acc", acc_t,
+                                                          v16i8_t, v16i8_t, v16i8_t, v16i8_t);
+    Value *acc = builder->CreateCall(assemble, acc_rows);
+
+    const char *intrin[3] = {"llvm.ppc.mma.xvf32gerpp", "llvm.ppc.mma.xvi8ger4pp", "llvm.ppc.mma.xvi16ger2pp"};
+    for (int k = 0; k < 3; k++) {
+        FunctionCallee ger = module->getOrInsertFunction(intrin[k], acc_t, acc_t, v16i8_t, v16i8_t);
+        for (size_t i = 0; i < cols[k].size(); i += group[k]) {
+            vector<Expr> col(cols[k].begin() + i, cols[k].begin() + i + group[k]);
+            vector<Expr> row(rows[k].begin() + i, rows[k].begin() + i + group[k]);
+            Value *col_value = codegen(group[k] == 1 ? col[0] : Shuffle::make_interleave(col));
+            Value *row_value = codegen(group[k] == 1 ? row[0] : Shuffle::make_interleave(row));
+            acc = builder->CreateCall(ger, {acc,
+                                            builder->CreateBitCast(col_value, v16i8_t),
+                                            builder->CreateBitCast(row_value, v16i8_t)});
+        }
+    }
+
+    llvm::Type *rows_t = StructType::get(*context, {v16i8_t, v16i8_t, v16i8_t, v16i8_t});
+    FunctionCallee disassemble = module->getOrInsertFunction("llvm.ppc.mma.disassemble.acc", rows_t, acc_t);
+    Value *result_rows = builder->CreateCall(disassemble, {acc});
+    llvm::Type *row_t = llvm_type_of(t.with_lanes(4));
+    vector<Value *> result;
+    for (unsigned i = 0; i < 4; i++) {
+        result.push_back(builder->CreateBitCast(builder->CreateExtractValue(result_rows, {i}), row_t));
+    }
+    value = concat_vectors(result);
+    return true;
+#else
+    return false;
+#endif
+}
+
 void CodeGen_PowerPC::visit(const Min *op) {
     if (!op->type.is_vector()) {
         CodeGen_Posix::visit(op);
@@ -129,7 +458,7 @@ void CodeGen_PowerPC::visit(const Min *op) {
     }
 
     bool vsx = target.has_feature(Target::VSX);
-    bool arch_2_07 = target.has_feature(Target::POWER_ARCH_2_07);
+    bool arch_2_07 = target.features_any_of({Target::POWER_ARCH_2_07, Target::POWER_ARCH_3_00, Target::POWER_ARCH_3_1});
 
     const Type& element_type = op->type.element_of();
     const char* element_type_name = altivec_int_type_name(element_type);
@@ -155,7 +484,7 @@ void CodeGen_PowerPC::visit(const Max *op) {
     }
 
     bool vsx = target.has_feature(Target::VSX);
-    bool arch_2_07 = target.has_feature(Target::POWER_ARCH_2_07);
+    bool arch_2_07 = target.features_any_of({Target::POWER_ARCH_2_07, Target::POWER_ARCH_3_00, Target::POWER_ARCH_3_1});
 
     const Type& element_type = op->type.element_of();
     const char* element_type_name = altivec_int_type_name(element_type);
@@ -178,7 +507,13 @@ string CodeGen_PowerPC::mcpu() const {
     if (target.bits == 32) {
         return "ppc32";
     } else {
-        if (target.has_feature(Target::POWER_ARCH_2_07))
+#if LLVM_VERSION >= 120
+        if (target.has_feature(Target::POWER_ARCH_3_1))
+            return "pwr10";
+#endif
+        if (target.features_any_of({Target::POWER_ARCH_3_00, Target::POWER_ARCH_3_1}))
+            return "pwr9";
+        else if (target.has_feature(Target::POWER_ARCH_2_07))
             return "pwr8";
         else if (target.has_feature(Target::VSX))
             return "pwr7";
@@ -199,7 +534,8 @@ string CodeGen_PowerPC::mattrs() const {
     features += separator + enable + "vsx";
     separator = ",";
 
-    enable = target.has_feature(Target::POWER_ARCH_2_07) ? "+" : "-";
+    bool arch_2_07 = target.features_any_of({Target::POWER_ARCH_2_07, Target::POWER_ARCH_3_00, Target::POWER_ARCH_3_1});
+    enable = arch_2_07 ? "+" : "-";
     features += separator + enable + "power8-altivec";
     separator = ",";
 
@@ -209,6 +545,16 @@ string CodeGen_PowerPC::mattrs() const {
     features += separator + enable + "direct-move";
     separator = ",";
 
+    if (target.features_any_of({Target::POWER_ARCH_3_00, Target::POWER_ARCH_3_1})) {
+        features += separator + "+power9-vector";
+    }
+
+#if LLVM_VERSION >= 120
+    if (target.has_feature(Target::POWER_ARCH_3_1)) {
+        features += separator + "+power10-vector,+mma";
+    }
+#endif
+
     return features;
 }
 
@@ -31,10 +31,17 @@ protected:
     /** Nodes for which we want to emit specific sse/avx intrinsics */
     // @{
     void visit(const Cast *) override;
+    void visit(const Mul *) override;
+    void visit(const Add *) override;
     void visit(const Min *) override;
     void visit(const Max *) override;
     // @}
 
+    /** Generate a 16-lane sum that includes outer products of
+     * 4-element vectors as a POWER10 MMA rank-k update of a 4x4
+     * accumulator. Returns false if the sum isn't of that form. */
+    bool codegen_mma_update(const Add *op);
+
     // Call an intrinsic as defined by a pattern. Dispatches to the
 private:
     static const char *altivec_int_type_name(const Type &);
@@ -13,6 +13,10 @@ CodeGen_RISCV::CodeGen_RISCV(Target t) : CodeGen_Posix(t) {
     #if !defined(WITH_RISCV)
     user_error << "llvm build not configured with RISCV target enabled.\n";
     #endif
+    #if LLVM_VERSION < 110
+    user_assert(!t.has_feature(Target::RVV))
+        << "The rvv target feature requires LLVM 11 or later.\n";
+    #endif
 }
 
 string CodeGen_RISCV::mcpu() const {
@@ -20,7 +24,17 @@ string CodeGen_RISCV::mcpu() const {
 }
 
 string CodeGen_RISCV::mattrs() const {
-    return "";
+    // Hosted targets are assumed to be RV32GC/RV64GC, which is what
+    // the Linux distributions build for.
+    string features;
+    if (target.os != Target::NoOS) {
+        features = "+m,+a,+f,+d,+c";
+    }
+    if (target.has_feature(Target::RVV)) {
+        features += features.empty() ? "" : ",";
+        features += "+experimental-v";
+    }
+    return features;
 }
 
 bool CodeGen_RISCV::use_soft_float_abi() const {
@@ -28,6 +42,8 @@ bool CodeGen_RISCV::use_soft_float_abi() const {
 }
 
 int CodeGen_RISCV::native_vector_bits() const {
+    // 128 bits is the minimum vector register length for application
+    // processors with the vector extension.
     return 128;
 }
 
@@ -10,10 +10,10 @@
 namespace Halide {
 namespace Internal {
 
-/** A code generator that emits mips code from a given Halide stmt. */
+/** A code generator that emits RISC-V code from a given Halide stmt. */
 class CodeGen_RISCV : public CodeGen_Posix {
 public:
-    /** Create a mips code generator. Processor features can be
+    /** Create a RISC-V code generator. Processor features can be
      * enabled using the appropriate flags in the target struct. */
     CodeGen_RISCV(Target);
 
@@ -0,0 +1,1479 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+
+#include "CodeGen_Internal.h"
+#include "CodeGen_Vulkan_Dev.h"
+#include "Debug.h"
+#include "Float16.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "Lerp.h"
+#include "Scope.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The subset of the SPIR-V 1.3 specification used by the emitter
+// below. There is no dependency on the SPIR-V headers, so the enum
+// values are reproduced here.
+namespace Spv {
+
+const uint32_t MagicNumber = 0x07230203;
+const uint32_t Version_1_3 = 0x00010300;
+
+const uint32_t OpName = 5;
+const uint32_t OpExtension = 10;
+const uint32_t OpExtInstImport = 11;
+const uint32_t OpExtInst = 12;
+const uint32_t OpMemoryModel = 14;
+const uint32_t OpEntryPoint = 15;
+const uint32_t OpExecutionMode = 16;
+const uint32_t OpCapability = 17;
+const uint32_t OpTypeVoid = 19;
+const uint32_t OpTypeBool = 20;
+const uint32_t OpTypeInt = 21;
+const uint32_t OpTypeFloat = 22;
+const uint32_t OpTypeVector = 23;
+const uint32_t OpTypeArray = 28;
+const uint32_t OpTypeRuntimeArray = 29;
+const uint32_t OpTypeStruct = 30;
+const uint32_t OpTypePointer = 32;
+const uint32_t OpTypeFunction = 33;
+const uint32_t OpConstantTrue = 41;
+const uint32_t OpConstantFalse = 42;
+const uint32_t OpConstant = 43;
+const uint32_t OpFunction = 54;
+const uint32_t OpFunctionEnd = 56;
+const uint32_t OpVariable = 59;
+const uint32_t OpLoad = 61;
+const uint32_t OpStore = 62;
+const uint32_t OpAccessChain = 65;
+const uint32_t OpDecorate = 71;
+const uint32_t OpMemberDecorate = 72;
+const uint32_t OpCompositeConstruct = 80;
+const uint32_t OpCompositeExtract = 81;
+const uint32_t OpConvertFToU = 109;
+const uint32_t OpConvertFToS = 110;
+const uint32_t OpConvertSToF = 111;
+const uint32_t OpConvertUToF = 112;
+const uint32_t OpUConvert = 113;
+const uint32_t OpSConvert = 114;
+const uint32_t OpFConvert = 115;
+const uint32_t OpBitcast = 124;
+const uint32_t OpIAdd = 128;
+const uint32_t OpFAdd = 129;
+const uint32_t OpISub = 130;
+const uint32_t OpFSub = 131;
+const uint32_t OpIMul = 132;
+const uint32_t OpFMul = 133;
+const uint32_t OpUDiv = 134;
+const uint32_t OpSDiv = 135;
+const uint32_t OpFDiv = 136;
+const uint32_t OpUMod = 137;
+const uint32_t OpSRem = 138;
+const uint32_t OpFMod = 141;
+const uint32_t OpIsNan = 156;
+const uint32_t OpLogicalEqual = 164;
+const uint32_t OpLogicalNotEqual = 165;
+const uint32_t OpLogicalOr = 166;
+const uint32_t OpLogicalAnd = 167;
+const uint32_t OpLogicalNot = 168;
+const uint32_t OpSelect = 169;
+const uint32_t OpIEqual = 170;
+const uint32_t OpINotEqual = 171;
+const uint32_t OpUGreaterThan = 172;
+const uint32_t OpSGreaterThan = 173;
+const uint32_t OpUGreaterThanEqual = 174;
+const uint32_t OpSGreaterThanEqual = 175;
+const uint32_t OpULessThan = 176;
+const uint32_t OpSLessThan = 177;
+const uint32_t OpULessThanEqual = 178;
+const uint32_t OpSLessThanEqual = 179;
+const uint32_t OpFOrdEqual = 180;
+const uint32_t OpFUnordNotEqual = 183;
+const uint32_t OpFOrdLessThan = 184;
+const uint32_t OpFOrdGreaterThan = 186;
+const uint32_t OpFOrdLessThanEqual = 188;
+const uint32_t OpFOrdGreaterThanEqual = 190;
+const uint32_t OpShiftRightLogical = 194;
+const uint32_t OpShiftRightArithmetic = 195;
+const uint32_t OpShiftLeftLogical = 196;
+const uint32_t OpBitwiseOr = 197;
+const uint32_t OpBitwiseXor = 198;
+const uint32_t OpBitwiseAnd = 199;
+const uint32_t OpNot = 200;
+const uint32_t OpBitCount = 205;
+const uint32_t OpControlBarrier = 224;
+const uint32_t OpLoopMerge = 246;
+const uint32_t OpSelectionMerge = 247;
+const uint32_t OpLabel = 248;
+const uint32_t OpBranch = 249;
+const uint32_t OpBranchConditional = 250;
+const uint32_t OpReturn = 253;
+
+const uint32_t CapabilityShader = 1;
+const uint32_t CapabilityFloat16 = 9;
+const uint32_t CapabilityFloat64 = 10;
+const uint32_t CapabilityInt64 = 11;
+const uint32_t CapabilityInt16 = 22;
+const uint32_t CapabilityInt8 = 39;
+const uint32_t CapabilityStorageBuffer16BitAccess = 4433;
+const uint32_t CapabilityStorageBuffer8BitAccess = 4448;
+
+const uint32_t AddressingModelLogical = 0;
+const uint32_t MemoryModelGLSL450 = 1;
+const uint32_t ExecutionModelGLCompute = 5;
+const uint32_t ExecutionModeLocalSize = 17;
+
+const uint32_t StorageClassInput = 1;
+const uint32_t StorageClassWorkgroup = 4;
+const uint32_t StorageClassFunction = 7;
+const uint32_t StorageClassPushConstant = 9;
+const uint32_t StorageClassStorageBuffer = 12;
+
+const uint32_t DecorationBlock = 2;
+const uint32_t DecorationArrayStride = 6;
+const uint32_t DecorationBuiltIn = 11;
+const uint32_t DecorationBinding = 33;
+const uint32_t DecorationDescriptorSet = 34;
+const uint32_t DecorationOffset = 35;
+
+const uint32_t BuiltInWorkgroupId = 26;
+const uint32_t BuiltInLocalInvocationId = 27;
+
+const uint32_t ScopeWorkgroup = 2;
+const uint32_t MemorySemanticsAcquireRelease = 0x8;
+const uint32_t MemorySemanticsUniformMemory = 0x40;
+const uint32_t MemorySemanticsWorkgroupMemory = 0x100;
+
+// Instructions of the GLSL.std.450 extended instruction set.
+const uint32_t GLSLRoundEven = 2;
+const uint32_t GLSLTrunc = 3;
+const uint32_t GLSLFAbs = 4;
+const uint32_t GLSLSAbs = 5;
+const uint32_t GLSLFloor = 8;
+const uint32_t GLSLCeil = 9;
+const uint32_t GLSLSin = 13;
+const uint32_t GLSLCos = 14;
+const uint32_t GLSLTan = 15;
+const uint32_t GLSLAsin = 16;
+const uint32_t GLSLAcos = 17;
+const uint32_t GLSLAtan = 18;
+const uint32_t GLSLSinh = 19;
+const uint32_t GLSLCosh = 20;
+const uint32_t GLSLTanh = 21;
+const uint32_t GLSLAsinh = 22;
+const uint32_t GLSLAcosh = 23;
+const uint32_t GLSLAtanh = 24;
+const uint32_t GLSLAtan2 = 25;
+const uint32_t GLSLPow = 26;
+const uint32_t GLSLExp = 27;
+const uint32_t GLSLLog = 28;
+const uint32_t GLSLSqrt = 31;
+const uint32_t GLSLInverseSqrt = 32;
+const uint32_t GLSLFMin = 37;
+const uint32_t GLSLUMin = 38;
+const uint32_t GLSLSMin = 39;
+const uint32_t GLSLFMax = 40;
+const uint32_t GLSLUMax = 41;
+const uint32_t GLSLSMax = 42;
+const uint32_t GLSLFindILsb = 73;
+const uint32_t GLSLFindUMsb = 75;
+
+}  // namespace Spv
+
+// The size of the push constant block that every Vulkan
+// implementation must support.
+const int max_push_constant_bytes = 128;
+
+// Which component of the workgroup/invocation id a gpu loop variable
+// refers to, or -1.
+int gpu_var_dimension(const string &name) {
+    const char *suffixes[] = {"_x", "_y", "_z", "_w"};
+    for (int i = 0; i < 4; i++) {
+        if (ends_with(name, suffixes[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The type a value of type t is stored as in a buffer. Buffers of
+// bools hold one byte per element.
+Type storage_type_of(Type t) {
+    return t.is_bool() ? UInt(8, t.lanes()) : t;
+}
+
+}  // namespace
+
+// Emits a SPIR-V module with one GLCompute entry point per kernel. The
+// runtime (src/runtime/vulkan.cpp) binds the buffer arguments of a
+// kernel to consecutive bindings of descriptor set 0, in argument
+// order, and passes everything else in a push constant block: one
+// uint32 element offset per buffer argument (so that crops need no
+// aligned descriptor offsets), followed by the scalar arguments, each
+// in a 4-byte slot (8 bytes for 64-bit types) aligned to its size.
+// Scalars narrower than 32 bits are zero-extended into their slot.
+class CodeGen_Vulkan_Dev::SPIRV_Emitter : public IRVisitor {
+public:
+    SPIRV_Emitter(Target t) : target(t) {
+        reset();
+    }
+
+    void reset();
+    void add_kernel(Stmt s, const string &name, const vector<DeviceArgument> &args);
+    vector<uint32_t> assemble() const;
+
+    // Names of the kernels added since the last reset, for dump().
+    vector<string> kernel_names;
+
+protected:
+    using IRVisitor::visit;
+
+    void visit(const IntImm *) override;
+    void visit(const UIntImm *) override;
+    void visit(const FloatImm *) override;
+    void visit(const StringImm *) override;
+    void visit(const Cast *) override;
+    void visit(const Variable *) override;
+    void visit(const Add *) override;
+    void visit(const Sub *) override;
+    void visit(const Mul *) override;
+    void visit(const Div *) override;
+    void visit(const Mod *) override;
+    void visit(const Min *) override;
+    void visit(const Max *) override;
+    void visit(const EQ *) override;
+    void visit(const NE *) override;
+    void visit(const LT *) override;
+    void visit(const LE *) override;
+    void visit(const GT *) override;
+    void visit(const GE *) override;
+    void visit(const And *) override;
+    void visit(const Or *) override;
+    void visit(const Not *) override;
+    void visit(const Select *) override;
+    void visit(const Load *) override;
+    void visit(const Ramp *) override;
+    void visit(const Broadcast *) override;
+    void visit(const Call *) override;
+    void visit(const Let *) override;
+    void visit(const Shuffle *) override;
+    void visit(const VectorReduce *) override;
+    void visit(const LetStmt *) override;
+    void visit(const AssertStmt *) override;
+    void visit(const For *) override;
+    void visit(const Store *) override;
+    void visit(const Provide *) override;
+    void visit(const Allocate *) override;
+    void visit(const Free *) override;
+    void visit(const Realize *) override;
+    void visit(const IfThenElse *) override;
+    void visit(const Evaluate *) override;
+    void visit(const Prefetch *) override;
+    void visit(const Fork *) override;
+    void visit(const Acquire *) override;
+    void visit(const Atomic *) override;
+
+private:
+    typedef uint32_t SpvId;
+    typedef vector<uint32_t> Section;
+
+    Target target;
+    SpvId next_id;
+
+    std::set<uint32_t> capabilities;
+    std::set<string> extensions;
+    SpvId glsl_ext;
+
+    // The module-level sections, in the order they are laid out.
+    Section entry_points, execution_modes, debug_names, annotations, declarations, functions;
+
+    // Types and constants, keyed by a description, so that each is
+    // declared once per module.
+    map<string, SpvId> declared;
+
+    SpvId workgroup_id_var, local_invocation_id_var;
+
+    // The variables of the kernel being emitted, which must open its
+    // first block, and the rest of its body.
+    Section vars, body;
+
+    // The result of the last expression visited.
+    SpvId id;
+
+    Scope<SpvId> symbols;
+
+    struct BufferBinding {
+        SpvId var;
+        Type storage_type;
+        SpvId offset;
+    };
+    map<string, BufferBinding> buffers;
+
+    struct Allocation {
+        SpvId var;
+        Type storage_type;
+        uint32_t storage_class;
+    };
+    Scope<Allocation> allocations;
+
+    int workgroup_size[3];
+
+    SpvId make_id() {
+        return next_id++;
+    }
+
+    static void emit(Section &section, uint32_t opcode, const vector<uint32_t> &operands) {
+        section.push_back(((uint32_t)(operands.size() + 1) << 16) | opcode);
+        section.insert(section.end(), operands.begin(), operands.end());
+    }
+
+    static void append_string(vector<uint32_t> &words, const string &str) {
+        // Strings are nul-terminated and padded to a whole word.
+        size_t n = str.size() / 4 + 1;
+        size_t first = words.size();
+        words.resize(first + n, 0);
+        for (size_t i = 0; i < str.size(); i++) {
+            words[first + i / 4] |= (uint32_t)(uint8_t)str[i] << (8 * (i % 4));
+        }
+    }
+
+    void require_capability(uint32_t cap) {
+        capabilities.insert(cap);
+    }
+
+    SpvId codegen(const Expr &e) {
+        internal_assert(e.defined());
+        e.accept(this);
+        return id;
+    }
+
+    SpvId type_of(Type t);
+    SpvId void_type();
+    SpvId pointer_type(uint32_t storage_class, SpvId pointee);
+    SpvId array_type(SpvId element, uint32_t size);
+    SpvId buffer_struct_type(Type storage_type);
+    SpvId function_type();
+    SpvId constant(Type t, uint64_t bits);
+    SpvId int_constant(int32_t value) {
+        return constant(Int(32), (uint64_t)(int64_t)value);
+    }
+    SpvId uint_constant(uint32_t value) {
+        return constant(UInt(32), value);
+    }
+
+    SpvId emit_op(uint32_t opcode, Type t, const vector<SpvId> &operands);
+    SpvId emit_ext_inst(uint32_t inst, Type t, const vector<SpvId> &operands);
+    SpvId emit_cast(Type dst, Type src, SpvId value);
+    SpvId emit_load(Type t, SpvId pointer) {
+        return emit_op(Spv::OpLoad, t, {pointer});
+    }
+    SpvId function_variable(SpvId pointee);
+    void emit_label(SpvId label) {
+        emit(body, Spv::OpLabel, {label});
+    }
+    SpvId extract_lane(Type t, SpvId vec, int lane) {
+        if (t.is_scalar()) {
+            return vec;
+        }
+        return emit_op(Spv::OpCompositeExtract, t.element_of(), {vec, (uint32_t)lane});
+    }
+    SpvId construct(Type t, const vector<SpvId> &lanes) {
+        if (lanes.size() == 1) {
+            return lanes[0];
+        }
+        return emit_op(Spv::OpCompositeConstruct, t, lanes);
+    }
+    SpvId element_pointer(const string &name, SpvId index, Type *storage_type);
+
+    void visit_binop(Type t, const Expr &a, const Expr &b, uint32_t float_op, uint32_t int_op);
+    void visit_cmp(const Expr &a, const Expr &b, uint32_t float_op, uint32_t int_op, uint32_t uint_op, uint32_t bool_op);
+    void visit_min_max(Type t, const Expr &a, const Expr &b, bool is_min);
+    void visit_counting_op(const Call *op);
+};
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::reset() {
+    next_id = 1;
+    capabilities.clear();
+    extensions.clear();
+    glsl_ext = 0;
+    entry_points.clear();
+    execution_modes.clear();
+    debug_names.clear();
+    annotations.clear();
+    declarations.clear();
+    functions.clear();
+    declared.clear();
+    kernel_names.clear();
+
+    require_capability(Spv::CapabilityShader);
+
+    // The builtins every kernel reads its position in the grid from.
+    SpvId ptr_uvec3 = pointer_type(Spv::StorageClassInput, type_of(UInt(32, 3)));
+    workgroup_id_var = make_id();
+    emit(declarations, Spv::OpVariable, {ptr_uvec3, workgroup_id_var, Spv::StorageClassInput});
+    emit(annotations, Spv::OpDecorate, {workgroup_id_var, Spv::DecorationBuiltIn, Spv::BuiltInWorkgroupId});
+    local_invocation_id_var = make_id();
+    emit(declarations, Spv::OpVariable, {ptr_uvec3, local_invocation_id_var, Spv::StorageClassInput});
+    emit(annotations, Spv::OpDecorate, {local_invocation_id_var, Spv::DecorationBuiltIn, Spv::BuiltInLocalInvocationId});
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::type_of(Type t) {
+    std::ostringstream key;
+    key << "type " << t;
+    auto it = declared.find(key.str());
+    if (it != declared.end()) {
+        return it->second;
+    }
+
+    SpvId result;
+    if (t.lanes() > 1) {
+        user_assert(t.lanes() <= 4)
+            << "Vulkan: vector types wider than 4 lanes are not supported, but "
+            << t << " was used. Vectorize GPU loops by at most 4.\n";
+        SpvId element = type_of(t.element_of());
+        result = make_id();
+        emit(declarations, Spv::OpTypeVector, {result, element, (uint32_t)t.lanes()});
+    } else if (t.is_bool()) {
+        result = make_id();
+        emit(declarations, Spv::OpTypeBool, {result});
+    } else if (t.is_int() || t.is_uint()) {
+        switch (t.bits()) {
+        case 8:  require_capability(Spv::CapabilityInt8); break;
+        case 16: require_capability(Spv::CapabilityInt16); break;
+        case 32: break;
+        case 64: require_capability(Spv::CapabilityInt64); break;
+        default: user_error << "Vulkan: Can't represent type '" << t << "'.\n";
+        }
+        result = make_id();
+        emit(declarations, Spv::OpTypeInt, {result, (uint32_t)t.bits(), t.is_int() ? 1u : 0u});
+    } else if (t.is_float()) {
+        switch (t.bits()) {
+        case 16: require_capability(Spv::CapabilityFloat16); break;
+        case 32: break;
+        case 64: require_capability(Spv::CapabilityFloat64); break;
+        default: user_error << "Vulkan: Can't represent type '" << t << "'.\n";
+        }
+        result = make_id();
+        emit(declarations, Spv::OpTypeFloat, {result, (uint32_t)t.bits()});
+    } else {
+        user_error << "Vulkan: Can't represent type '" << t << "'.\n";
+        result = 0;
+    }
+    declared[key.str()] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::void_type() {
+    auto it = declared.find("void");
+    if (it != declared.end()) {
+        return it->second;
+    }
+    SpvId result = make_id();
+    emit(declarations, Spv::OpTypeVoid, {result});
+    declared["void"] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::function_type() {
+    auto it = declared.find("function");
+    if (it != declared.end()) {
+        return it->second;
+    }
+    SpvId v = void_type();
+    SpvId result = make_id();
+    emit(declarations, Spv::OpTypeFunction, {result, v});
+    declared["function"] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::pointer_type(uint32_t storage_class, SpvId pointee) {
+    string key = "pointer " + std::to_string(storage_class) + " " + std::to_string(pointee);
+    auto it = declared.find(key);
+    if (it != declared.end()) {
+        return it->second;
+    }
+    SpvId result = make_id();
+    emit(declarations, Spv::OpTypePointer, {result, storage_class, pointee});
+    declared[key] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::array_type(SpvId element, uint32_t size) {
+    string key = "array " + std::to_string(element) + " " + std::to_string(size);
+    auto it = declared.find(key);
+    if (it != declared.end()) {
+        return it->second;
+    }
+    SpvId length = uint_constant(size);
+    SpvId result = make_id();
+    emit(declarations, Spv::OpTypeArray, {result, element, length});
+    declared[key] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::buffer_struct_type(Type storage_type) {
+    std::ostringstream key;
+    key << "buffer " << storage_type;
+    auto it = declared.find(key.str());
+    if (it != declared.end()) {
+        return it->second;
+    }
+
+    if (storage_type.bits() == 8) {
+        require_capability(Spv::CapabilityStorageBuffer8BitAccess);
+        extensions.insert("SPV_KHR_8bit_storage");
+    } else if (storage_type.bits() == 16) {
+        require_capability(Spv::CapabilityStorageBuffer16BitAccess);
+        extensions.insert("SPV_KHR_16bit_storage");
+    }
+
+    SpvId element = type_of(storage_type);
+    SpvId runtime_array = make_id();
+    emit(declarations, Spv::OpTypeRuntimeArray, {runtime_array, element});
+    emit(annotations, Spv::OpDecorate, {runtime_array, Spv::DecorationArrayStride, (uint32_t)storage_type.bytes()});
+    SpvId result = make_id();
+    emit(declarations, Spv::OpTypeStruct, {result, runtime_array});
+    emit(annotations, Spv::OpDecorate, {result, Spv::DecorationBlock});
+    emit(annotations, Spv::OpMemberDecorate, {result, 0, Spv::DecorationOffset, 0});
+    declared[key.str()] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::constant(Type t, uint64_t bits) {
+    internal_assert(t.is_scalar());
+    std::ostringstream key;
+    key << "constant " << t << " " << bits;
+    auto it = declared.find(key.str());
+    if (it != declared.end()) {
+        return it->second;
+    }
+
+    SpvId type = type_of(t);
+    SpvId result = make_id();
+    if (t.is_bool()) {
+        emit(declarations, bits ? Spv::OpConstantTrue : Spv::OpConstantFalse, {type, result});
+    } else if (t.bits() == 64) {
+        emit(declarations, Spv::OpConstant, {type, result, (uint32_t)bits, (uint32_t)(bits >> 32)});
+    } else {
+        uint32_t word = (uint32_t)bits;
+        if (t.bits() < 32) {
+            // Narrow literals must be zero-extended, except for
+            // signed integers, which are sign-extended.
+            uint32_t mask = (1u << t.bits()) - 1;
+            word &= mask;
+            if (t.is_int() && (word >> (t.bits() - 1))) {
+                word |= ~mask;
+            }
+        }
+        emit(declarations, Spv::OpConstant, {type, result, word});
+    }
+    declared[key.str()] = result;
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::emit_op(uint32_t opcode, Type t, const vector<SpvId> &operands) {
+    SpvId type = type_of(t);
+    SpvId result = make_id();
+    vector<uint32_t> words = {type, result};
+    words.insert(words.end(), operands.begin(), operands.end());
+    emit(body, opcode, words);
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::emit_ext_inst(uint32_t inst, Type t, const vector<SpvId> &operands) {
+    if (!glsl_ext) {
+        glsl_ext = make_id();
+    }
+    vector<SpvId> words = {glsl_ext, inst};
+    words.insert(words.end(), operands.begin(), operands.end());
+    return emit_op(Spv::OpExtInst, t, words);
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::function_variable(SpvId pointee) {
+    SpvId result = make_id();
+    emit(vars, Spv::OpVariable, {pointer_type(Spv::StorageClassFunction, pointee), result, Spv::StorageClassFunction});
+    return result;
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::emit_cast(Type dst, Type src, SpvId value) {
+    if (dst == src) {
+        return value;
+    }
+    if (src.is_bool()) {
+        SpvId one = codegen(make_one(dst));
+        SpvId zero = codegen(make_zero(dst));
+        return emit_op(Spv::OpSelect, dst, {value, one, zero});
+    }
+    if (dst.is_bool()) {
+        SpvId zero = codegen(make_zero(src));
+        // Casting NaN to bool gives true, as in C.
+        return emit_op(src.is_float() ? Spv::OpFUnordNotEqual : Spv::OpINotEqual, dst, {value, zero});
+    }
+    if (src.is_float()) {
+        if (dst.is_float()) {
+            return emit_op(Spv::OpFConvert, dst, {value});
+        }
+        return emit_op(dst.is_int() ? Spv::OpConvertFToS : Spv::OpConvertFToU, dst, {value});
+    }
+    if (dst.is_float()) {
+        return emit_op(src.is_int() ? Spv::OpConvertSToF : Spv::OpConvertUToF, dst, {value});
+    }
+    if (src.bits() == dst.bits()) {
+        return emit_op(Spv::OpBitcast, dst, {value});
+    }
+    // Widening sign- or zero-extends according to the source type;
+    // narrowing truncates either way.
+    return emit_op(src.is_int() ? Spv::OpSConvert : Spv::OpUConvert, dst, {value});
+}
+
+CodeGen_Vulkan_Dev::SPIRV_Emitter::SpvId CodeGen_Vulkan_Dev::SPIRV_Emitter::element_pointer(const string &name, SpvId index, Type *storage_type) {
+    if (allocations.contains(name)) {
+        const Allocation &alloc = allocations.get(name);
+        *storage_type = alloc.storage_type;
+        SpvId ptr = pointer_type(alloc.storage_class, type_of(alloc.storage_type));
+        SpvId result = make_id();
+        emit(body, Spv::OpAccessChain, {ptr, result, alloc.var, index});
+        return result;
+    }
+    auto it = buffers.find(name);
+    internal_assert(it != buffers.end()) << "Vulkan: no buffer or allocation named " << name << "\n";
+    const BufferBinding &binding = it->second;
+    *storage_type = binding.storage_type;
+    SpvId offset_index = emit_op(Spv::OpIAdd, Int(32), {index, binding.offset});
+    SpvId ptr = pointer_type(Spv::StorageClassStorageBuffer, type_of(binding.storage_type));
+    SpvId result = make_id();
+    emit(body, Spv::OpAccessChain, {ptr, result, binding.var, int_constant(0), offset_index});
+    return result;
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const IntImm *op) {
+    id = constant(op->type, (uint64_t)op->value);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const UIntImm *op) {
+    id = constant(op->type, op->value);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const FloatImm *op) {
+    uint64_t bits;
+    if (op->type.bits() == 16) {
+        bits = float16_t(op->value).to_bits();
+    } else if (op->type.bits() == 32) {
+        float f = (float)op->value;
+        uint32_t b;
+        memcpy(&b, &f, sizeof(b));
+        bits = b;
+    } else {
+        internal_assert(op->type.bits() == 64);
+        memcpy(&bits, &op->value, sizeof(bits));
+    }
+    id = constant(op->type, bits);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const StringImm *op) {
+    user_error << "Vulkan: strings are not supported in kernels.\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Cast *op) {
+    SpvId value = codegen(op->value);
+    id = emit_cast(op->type, op->value.type(), value);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Variable *op) {
+    internal_assert(symbols.contains(op->name)) << "Vulkan: unknown variable " << op->name << "\n";
+    id = symbols.get(op->name);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit_binop(Type t, const Expr &a, const Expr &b, uint32_t float_op, uint32_t int_op) {
+    SpvId va = codegen(a);
+    SpvId vb = codegen(b);
+    id = emit_op(t.is_float() ? float_op : int_op, t, {va, vb});
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Add *op) {
+    visit_binop(op->type, op->a, op->b, Spv::OpFAdd, Spv::OpIAdd);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Sub *op) {
+    visit_binop(op->type, op->a, op->b, Spv::OpFSub, Spv::OpISub);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Mul *op) {
+    visit_binop(op->type, op->a, op->b, Spv::OpFMul, Spv::OpIMul);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Div *op) {
+    int bits;
+    if (op->type.is_float()) {
+        visit_binop(op->type, op->a, op->b, Spv::OpFDiv, Spv::OpFDiv);
+    } else if (is_const_power_of_two_integer(op->b, &bits)) {
+        // Euclidean division by a power of two is a shift, arithmetic
+        // for signed types.
+        SpvId a = codegen(op->a);
+        SpvId shift = codegen(make_const(op->type, bits));
+        id = emit_op(op->type.is_int() ? Spv::OpShiftRightArithmetic : Spv::OpShiftRightLogical,
+                     op->type, {a, shift});
+    } else if (op->type.is_int()) {
+        codegen(lower_euclidean_div(op->a, op->b));
+    } else {
+        visit_binop(op->type, op->a, op->b, Spv::OpUDiv, Spv::OpUDiv);
+    }
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Mod *op) {
+    int bits;
+    if (op->type.is_float()) {
+        // OpFMod takes the sign of the divisor, which matches Halide's
+        // definition of a - b * floor(a / b).
+        visit_binop(op->type, op->a, op->b, Spv::OpFMod, Spv::OpFMod);
+    } else if (is_const_power_of_two_integer(op->b, &bits)) {
+        SpvId a = codegen(op->a);
+        SpvId mask = codegen(make_const(op->type, ((uint64_t)1 << bits) - 1));
+        id = emit_op(Spv::OpBitwiseAnd, op->type, {a, mask});
+    } else if (op->type.is_int()) {
+        codegen(lower_euclidean_mod(op->a, op->b));
+    } else {
+        visit_binop(op->type, op->a, op->b, Spv::OpUMod, Spv::OpUMod);
+    }
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit_min_max(Type t, const Expr &a, const Expr &b, bool is_min) {
+    SpvId va = codegen(a);
+    SpvId vb = codegen(b);
+    if (t.is_bool()) {
+        id = emit_op(is_min ? Spv::OpLogicalAnd : Spv::OpLogicalOr, t, {va, vb});
+    } else if (t.is_float()) {
+        id = emit_ext_inst(is_min ? Spv::GLSLFMin : Spv::GLSLFMax, t, {va, vb});
+    } else if (t.is_int()) {
+        id = emit_ext_inst(is_min ? Spv::GLSLSMin : Spv::GLSLSMax, t, {va, vb});
+    } else {
+        id = emit_ext_inst(is_min ? Spv::GLSLUMin : Spv::GLSLUMax, t, {va, vb});
+    }
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Min *op) {
+    visit_min_max(op->type, op->a, op->b, true);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Max *op) {
+    visit_min_max(op->type, op->a, op->b, false);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit_cmp(const Expr &a, const Expr &b, uint32_t float_op, uint32_t int_op, uint32_t uint_op, uint32_t bool_op) {
+    Type t = a.type();
+    SpvId va = codegen(a);
+    SpvId vb = codegen(b);
+    uint32_t opcode;
+    if (t.is_float()) {
+        opcode = float_op;
+    } else if (t.is_bool()) {
+        internal_assert(bool_op) << "Vulkan: unsupported comparison of bools\n";
+        opcode = bool_op;
+    } else if (t.is_int()) {
+        opcode = int_op;
+    } else {
+        opcode = uint_op;
+    }
+    id = emit_op(opcode, Bool(t.lanes()), {va, vb});
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const EQ *op) {
+    visit_cmp(op->a, op->b, Spv::OpFOrdEqual, Spv::OpIEqual, Spv::OpIEqual, Spv::OpLogicalEqual);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const NE *op) {
+    // NaN != NaN.
+    visit_cmp(op->a, op->b, Spv::OpFUnordNotEqual, Spv::OpINotEqual, Spv::OpINotEqual, Spv::OpLogicalNotEqual);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const LT *op) {
+    visit_cmp(op->a, op->b, Spv::OpFOrdLessThan, Spv::OpSLessThan, Spv::OpULessThan, 0);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const LE *op) {
+    visit_cmp(op->a, op->b, Spv::OpFOrdLessThanEqual, Spv::OpSLessThanEqual, Spv::OpULessThanEqual, 0);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const GT *op) {
+    visit_cmp(op->a, op->b, Spv::OpFOrdGreaterThan, Spv::OpSGreaterThan, Spv::OpUGreaterThan, 0);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const GE *op) {
+    visit_cmp(op->a, op->b, Spv::OpFOrdGreaterThanEqual, Spv::OpSGreaterThanEqual, Spv::OpUGreaterThanEqual, 0);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const And *op) {
+    visit_binop(op->type, op->a, op->b, Spv::OpLogicalAnd, Spv::OpLogicalAnd);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Or *op) {
+    visit_binop(op->type, op->a, op->b, Spv::OpLogicalOr, Spv::OpLogicalOr);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Not *op) {
+    SpvId a = codegen(op->a);
+    id = emit_op(Spv::OpLogicalNot, op->type, {a});
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Select *op) {
+    SpvId cond = codegen(op->condition);
+    SpvId true_value = codegen(op->true_value);
+    SpvId false_value = codegen(op->false_value);
+    if (op->condition.type().is_scalar() && op->type.is_vector()) {
+        cond = construct(Bool(op->type.lanes()), vector<SpvId>(op->type.lanes(), cond));
+    }
+    id = emit_op(Spv::OpSelect, op->type, {cond, true_value, false_value});
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Load *op) {
+    user_assert(is_one(op->predicate)) << "Vulkan: predicated loads are not supported.\n";
+
+    // There are no pointers to vectors in logical addressing, so
+    // vector loads are assembled one lane at a time.
+    Type t = op->type;
+    SpvId index = codegen(op->index);
+    vector<SpvId> lanes;
+    for (int i = 0; i < t.lanes(); i++) {
+        SpvId lane_index = extract_lane(op->index.type(), index, i);
+        Type storage_type;
+        SpvId ptr = element_pointer(op->name, lane_index, &storage_type);
+        SpvId value = emit_load(storage_type, ptr);
+        if (storage_type != t.element_of()) {
+            user_assert(storage_type.bits() == t.bits() || t.is_bool())
+                << "Vulkan: can't load a " << t.element_of() << " from " << op->name
+                << ", which holds " << storage_type << "\n";
+            value = t.is_bool() ?
+                emit_cast(t.element_of(), storage_type, value) :
+                emit_op(Spv::OpBitcast, t.element_of(), {value});
+        }
+        lanes.push_back(value);
+    }
+    id = construct(t, lanes);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Store *op) {
+    user_assert(is_one(op->predicate)) << "Vulkan: predicated stores are not supported.\n";
+
+    Type t = op->value.type();
+    SpvId value = codegen(op->value);
+    SpvId index = codegen(op->index);
+    for (int i = 0; i < t.lanes(); i++) {
+        SpvId lane_value = extract_lane(t, value, i);
+        SpvId lane_index = extract_lane(op->index.type(), index, i);
+        Type storage_type;
+        SpvId ptr = element_pointer(op->name, lane_index, &storage_type);
+        if (storage_type != t.element_of()) {
+            user_assert(storage_type.bits() == t.bits() || t.is_bool())
+                << "Vulkan: can't store a " << t.element_of() << " to " << op->name
+                << ", which holds " << storage_type << "\n";
+            lane_value = t.is_bool() ?
+                emit_cast(storage_type, t.element_of(), lane_value) :
+                emit_op(Spv::OpBitcast, storage_type, {lane_value});
+        }
+        emit(body, Spv::OpStore, {ptr, lane_value});
+    }
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Ramp *op) {
+    Type t = op->base.type();
+    SpvId base = codegen(op->base);
+    SpvId stride = codegen(op->stride);
+    vector<SpvId> lanes = {base};
+    for (int i = 1; i < op->lanes; i++) {
+        SpvId scale = codegen(make_const(t, i));
+        SpvId offset = emit_op(t.is_float() ? Spv::OpFMul : Spv::OpIMul, t, {stride, scale});
+        lanes.push_back(emit_op(t.is_float() ? Spv::OpFAdd : Spv::OpIAdd, t, {base, offset}));
+    }
+    id = construct(op->type, lanes);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Broadcast *op) {
+    SpvId value = codegen(op->value);
+    id = construct(op->type, vector<SpvId>(op->lanes, value));
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Shuffle *op) {
+    vector<SpvId> vectors;
+    for (const Expr &v : op->vectors) {
+        vectors.push_back(codegen(v));
+    }
+    vector<SpvId> lanes;
+    for (int index : op->indices) {
+        // Find the vector the index falls in.
+        size_t i = 0;
+        while (index >= op->vectors[i].type().lanes()) {
+            index -= op->vectors[i].type().lanes();
+            i++;
+        }
+        lanes.push_back(extract_lane(op->vectors[i].type(), vectors[i], index));
+    }
+    id = construct(op->type, lanes);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const VectorReduce *op) {
+    codegen(lower_vector_reduce(op));
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit_counting_op(const Call *op) {
+    Expr arg = op->args[0];
+    Type t = arg.type();
+    user_assert(t.bits() <= 32) << "Vulkan: " << op->name << " of " << t << " is not supported.\n";
+    Type u32 = UInt(32, t.lanes());
+    Type i32 = Int(32, t.lanes());
+    SpvId x = codegen(arg);
+    if (t.is_int()) {
+        x = emit_cast(t.with_code(Type::UInt), t, x);
+    }
+    x = emit_cast(u32, t.with_code(Type::UInt), x);
+    SpvId result;
+    if (op->is_intrinsic(Call::popcount)) {
+        result = emit_op(Spv::OpBitCount, u32, {x});
+        id = emit_cast(op->type, u32, result);
+        return;
+    } else if (op->is_intrinsic(Call::count_leading_zeros)) {
+        // FindUMsb of zero is -1, which gives a count of t.bits().
+        SpvId msb = emit_ext_inst(Spv::GLSLFindUMsb, i32, {x});
+        result = emit_op(Spv::OpISub, i32, {codegen(make_const(i32, t.bits() - 1)), msb});
+    } else {
+        SpvId lsb = emit_ext_inst(Spv::GLSLFindILsb, i32, {x});
+        SpvId is_zero = emit_op(Spv::OpIEqual, Bool(t.lanes()), {x, codegen(make_zero(u32))});
+        result = emit_op(Spv::OpSelect, i32, {is_zero, codegen(make_const(i32, t.bits())), lsb});
+    }
+    id = emit_cast(op->type, i32, result);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Call *op) {
+    if (op->is_intrinsic(Call::gpu_thread_barrier)) {
+        SpvId scope = uint_constant(Spv::ScopeWorkgroup);
+        SpvId semantics = uint_constant(Spv::MemorySemanticsAcquireRelease |
+                                        Spv::MemorySemanticsWorkgroupMemory |
+                                        Spv::MemorySemanticsUniformMemory);
+        emit(body, Spv::OpControlBarrier, {scope, scope, semantics});
+        id = codegen(make_zero(op->type));
+    } else if (op->is_intrinsic(Call::bitwise_and) ||
+               op->is_intrinsic(Call::bitwise_or) ||
+               op->is_intrinsic(Call::bitwise_xor)) {
+        SpvId a = codegen(op->args[0]);
+        SpvId b = codegen(op->args[1]);
+        uint32_t opcode;
+        if (op->is_intrinsic(Call::bitwise_and)) {
+            opcode = op->type.is_bool() ? Spv::OpLogicalAnd : Spv::OpBitwiseAnd;
+        } else if (op->is_intrinsic(Call::bitwise_or)) {
+            opcode = op->type.is_bool() ? Spv::OpLogicalOr : Spv::OpBitwiseOr;
+        } else {
+            opcode = op->type.is_bool() ? Spv::OpLogicalNotEqual : Spv::OpBitwiseXor;
+        }
+        id = emit_op(opcode, op->type, {a, b});
+    } else if (op->is_intrinsic(Call::bitwise_not)) {
+        SpvId a = codegen(op->args[0]);
+        id = emit_op(op->type.is_bool() ? Spv::OpLogicalNot : Spv::OpNot, op->type, {a});
+    } else if (op->is_intrinsic(Call::shift_left) || op->is_intrinsic(Call::shift_right)) {
+        SpvId a = codegen(op->args[0]);
+        SpvId b = codegen(op->args[1]);
+        uint32_t opcode = op->is_intrinsic(Call::shift_left) ? Spv::OpShiftLeftLogical :
+            op->type.is_int() ? Spv::OpShiftRightArithmetic : Spv::OpShiftRightLogical;
+        id = emit_op(opcode, op->type, {a, b});
+    } else if (op->is_intrinsic(Call::reinterpret)) {
+        SpvId a = codegen(op->args[0]);
+        id = (op->type == op->args[0].type()) ? a : emit_op(Spv::OpBitcast, op->type, {a});
+    } else if (op->is_intrinsic(Call::abs)) {
+        Type t = op->args[0].type();
+        SpvId a = codegen(op->args[0]);
+        if (t.is_float()) {
+            id = emit_ext_inst(Spv::GLSLFAbs, t, {a});
+        } else if (t.is_int()) {
+            // The absolute value of a signed integer is unsigned.
+            id = emit_op(Spv::OpBitcast, op->type, {emit_ext_inst(Spv::GLSLSAbs, t, {a})});
+        } else {
+            id = a;
+        }
+    } else if (op->is_intrinsic(Call::absd)) {
+        Expr a = op->args[0], b = op->args[1];
+        if (a.type().is_float()) {
+            codegen(abs(a - b));
+        } else {
+            Type u = a.type().with_code(Type::UInt);
+            codegen(select(a < b, cast(u, b) - cast(u, a), cast(u, a) - cast(u, b)));
+        }
+    } else if (op->is_intrinsic(Call::lerp)) {
+        codegen(lower_lerp(op->args[0], op->args[1], op->args[2]));
+    } else if (op->is_intrinsic(Call::popcount) ||
+               op->is_intrinsic(Call::count_leading_zeros) ||
+               op->is_intrinsic(Call::count_trailing_zeros)) {
+        visit_counting_op(op);
+    } else if (op->is_intrinsic(Call::div_round_to_zero)) {
+        visit_binop(op->type, op->args[0], op->args[1], Spv::OpFDiv,
+                    op->type.is_int() ? Spv::OpSDiv : Spv::OpUDiv);
+    } else if (op->is_intrinsic(Call::mod_round_to_zero)) {
+        visit_binop(op->type, op->args[0], op->args[1], Spv::OpFMod,
+                    op->type.is_int() ? Spv::OpSRem : Spv::OpUMod);
+    } else if (op->is_intrinsic(Call::likely) ||
+               op->is_intrinsic(Call::likely_if_innermost) ||
+               op->is_intrinsic(Call::strict_float) ||
+               op->is_intrinsic(Call::unsafe_promise_clamped)) {
+        codegen(op->args[0]);
+    } else if (op->is_intrinsic(Call::return_second)) {
+        codegen(op->args[0]);
+        codegen(op->args[1]);
+    } else if (op->is_intrinsic(Call::if_then_else)) {
+        // Only one side may be evaluated, so this is a branch that
+        // leaves its result in a variable.
+        SpvId result = function_variable(type_of(op->type));
+        SpvId cond = codegen(op->args[0]);
+        SpvId then_label = make_id(), merge_label = make_id();
+        SpvId else_label = op->args.size() > 2 ? make_id() : merge_label;
+        emit(body, Spv::OpSelectionMerge, {merge_label, 0});
+        emit(body, Spv::OpBranchConditional, {cond, then_label, else_label});
+        emit_label(then_label);
+        emit(body, Spv::OpStore, {result, codegen(op->args[1])});
+        emit(body, Spv::OpBranch, {merge_label});
+        if (op->args.size() > 2) {
+            emit_label(else_label);
+            emit(body, Spv::OpStore, {result, codegen(op->args[2])});
+            emit(body, Spv::OpBranch, {merge_label});
+        }
+        emit_label(merge_label);
+        id = emit_load(op->type, result);
+    } else if (op->call_type == Call::Extern || op->call_type == Call::PureExtern) {
+        // Math functions are named <fn>_f<bits>.
+        string name = op->name;
+        size_t suffix = name.rfind("_f");
+        if (suffix != string::npos && (ends_with(name, "_f16") || ends_with(name, "_f32") || ends_with(name, "_f64"))) {
+            name = name.substr(0, suffix);
+        }
+        static const map<string, uint32_t> glsl_functions = {
+            {"sqrt", Spv::GLSLSqrt},
+            {"sin", Spv::GLSLSin},
+            {"cos", Spv::GLSLCos},
+            {"tan", Spv::GLSLTan},
+            {"asin", Spv::GLSLAsin},
+            {"acos", Spv::GLSLAcos},
+            {"atan", Spv::GLSLAtan},
+            {"atan2", Spv::GLSLAtan2},
+            {"sinh", Spv::GLSLSinh},
+            {"cosh", Spv::GLSLCosh},
+            {"tanh", Spv::GLSLTanh},
+            {"asinh", Spv::GLSLAsinh},
+            {"acosh", Spv::GLSLAcosh},
+            {"atanh", Spv::GLSLAtanh},
+            {"exp", Spv::GLSLExp},
+            {"log", Spv::GLSLLog},
+            {"pow", Spv::GLSLPow},
+            {"floor", Spv::GLSLFloor},
+            {"ceil", Spv::GLSLCeil},
+            {"trunc", Spv::GLSLTrunc},
+            // Halide rounds to even.
+            {"round", Spv::GLSLRoundEven},
+            {"abs", Spv::GLSLFAbs},
+            {"fast_inverse_sqrt", Spv::GLSLInverseSqrt},
+        };
+        auto it = glsl_functions.find(name);
+        if (it != glsl_functions.end()) {
+            vector<SpvId> args;
+            for (const Expr &a : op->args) {
+                args.push_back(codegen(a));
+            }
+            id = emit_ext_inst(it->second, op->type, args);
+        } else if (name == "fast_inverse") {
+            SpvId a = codegen(op->args[0]);
+            id = emit_op(Spv::OpFDiv, op->type, {codegen(make_one(op->type)), a});
+        } else if (name == "is_nan") {
+            SpvId a = codegen(op->args[0]);
+            SpvId is_nan = emit_op(Spv::OpIsNan, Bool(op->type.lanes()), {a});
+            id = emit_cast(op->type, Bool(op->type.lanes()), is_nan);
+        } else if (name == "nan" || name == "inf" || name == "neg_inf") {
+            double value = (name == "nan") ? std::numeric_limits<double>::quiet_NaN() :
+                (name == "inf") ? std::numeric_limits<double>::infinity() :
+                -std::numeric_limits<double>::infinity();
+            codegen(FloatImm::make(op->type, value));
+        } else {
+            user_error << "Vulkan: unsupported function " << op->name << " in kernel.\n";
+        }
+    } else {
+        user_error << "Vulkan: unsupported call " << op->name << " in kernel.\n";
+    }
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Let *op) {
+    SpvId value = codegen(op->value);
+    ScopedBinding<SpvId> bind(symbols, op->name, value);
+    codegen(op->body);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const LetStmt *op) {
+    SpvId value = codegen(op->value);
+    ScopedBinding<SpvId> bind(symbols, op->name, value);
+    op->body.accept(this);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const AssertStmt *op) {
+    // Kernels have no way to report failures.
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const For *op) {
+    if (is_gpu_var(op->name)) {
+        internal_assert((op->for_type == ForType::GPUBlock) ||
+                        (op->for_type == ForType::GPUThread))
+            << "kernel loop must be either gpu block or gpu thread\n";
+        internal_assert(is_zero(op->min));
+
+        int dim = gpu_var_dimension(op->name);
+        user_assert(dim >= 0 && dim < 3) << "Vulkan: 4-dimensional loops with " << op->name << " are not supported\n";
+        SpvId builtin;
+        if (is_gpu_thread_var(op->name)) {
+            // The workgroup size is part of the shader.
+            const IntImm *extent = op->extent.as<IntImm>();
+            user_assert(extent) << "Vulkan: the extent of GPU thread loops must be a constant integer.\n";
+            user_assert(workgroup_size[dim] == 0 || workgroup_size[dim] == extent->value)
+                << "Vulkan: all thread loops in a kernel must have the same extent in each dimension,"
+                << " but " << workgroup_size[dim] << " and " << extent->value
+                << " were encountered in dimension " << dim << ".\n";
+            workgroup_size[dim] = extent->value;
+            builtin = local_invocation_id_var;
+        } else {
+            builtin = workgroup_id_var;
+        }
+        SpvId ids = emit_load(UInt(32, 3), builtin);
+        SpvId component = emit_op(Spv::OpCompositeExtract, UInt(32), {ids, (uint32_t)dim});
+        SpvId value = emit_op(Spv::OpBitcast, Int(32), {component});
+        ScopedBinding<SpvId> bind(symbols, op->name, value);
+        op->body.accept(this);
+        return;
+    }
+
+    user_assert(op->for_type != ForType::Parallel) << "Cannot use parallel loops inside Vulkan kernel\n";
+    internal_assert(op->for_type == ForType::Serial) << "Vulkan: unexpected " << op->for_type << " loop in kernel\n";
+
+    // A structured loop over a counter variable:
+    //   header:   OpLoopMerge merge continue; OpBranch test
+    //   test:     if (i < end) goto loop_body else goto merge
+    //   loop_body: ...; OpBranch continue
+    //   continue: i += 1; OpBranch header
+    Type t = op->min.type();
+    SpvId counter = function_variable(type_of(t));
+    SpvId min = codegen(op->min);
+    SpvId extent = codegen(op->extent);
+    SpvId end = emit_op(Spv::OpIAdd, t, {min, extent});
+    emit(body, Spv::OpStore, {counter, min});
+
+    SpvId header = make_id(), test = make_id(), loop_body = make_id();
+    SpvId continue_label = make_id(), merge = make_id();
+    emit(body, Spv::OpBranch, {header});
+
+    emit_label(header);
+    emit(body, Spv::OpLoopMerge, {merge, continue_label, 0});
+    emit(body, Spv::OpBranch, {test});
+
+    emit_label(test);
+    SpvId i = emit_load(t, counter);
+    SpvId in_range = emit_op(Spv::OpSLessThan, Bool(), {i, end});
+    emit(body, Spv::OpBranchConditional, {in_range, loop_body, merge});
+
+    emit_label(loop_body);
+    {
+        SpvId value = emit_load(t, counter);
+        ScopedBinding<SpvId> bind(symbols, op->name, value);
+        op->body.accept(this);
+    }
+    emit(body, Spv::OpBranch, {continue_label});
+
+    emit_label(continue_label);
+    SpvId current = emit_load(t, counter);
+    SpvId next = emit_op(Spv::OpIAdd, t, {current, codegen(make_one(t))});
+    emit(body, Spv::OpStore, {counter, next});
+    emit(body, Spv::OpBranch, {header});
+
+    emit_label(merge);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Provide *op) {
+    internal_error << "Vulkan: Provide should have been lowered before codegen\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Realize *op) {
+    internal_error << "Vulkan: Realize should have been lowered before codegen\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Allocate *op) {
+    user_assert(op->type.is_scalar()) << "Vulkan: allocations of vector type are not supported\n";
+    int32_t size = op->constant_allocation_size();
+    user_assert(size > 0) << "Vulkan: allocation " << op->name << " inside a kernel must have a constant size\n";
+
+    debug(2) << "Vulkan: Allocate " << op->name << " of type " << op->type << " on device\n";
+
+    SpvId array = array_type(type_of(op->type), (uint32_t)size);
+    Allocation alloc;
+    alloc.storage_type = op->type;
+    if (op->memory_type == MemoryType::GPUShared || starts_with(op->name, "__shared")) {
+        alloc.storage_class = Spv::StorageClassWorkgroup;
+        alloc.var = make_id();
+        emit(declarations, Spv::OpVariable, {pointer_type(Spv::StorageClassWorkgroup, array), alloc.var, Spv::StorageClassWorkgroup});
+    } else {
+        alloc.storage_class = Spv::StorageClassFunction;
+        alloc.var = function_variable(array);
+    }
+    ScopedBinding<Allocation> bind(allocations, op->name, alloc);
+    op->body.accept(this);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Free *op) {
+    // The allocation goes out of scope with its Allocate node.
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const IfThenElse *op) {
+    SpvId cond = codegen(op->condition);
+    SpvId then_label = make_id(), merge_label = make_id();
+    SpvId else_label = op->else_case.defined() ? make_id() : merge_label;
+    emit(body, Spv::OpSelectionMerge, {merge_label, 0});
+    emit(body, Spv::OpBranchConditional, {cond, then_label, else_label});
+
+    emit_label(then_label);
+    op->then_case.accept(this);
+    emit(body, Spv::OpBranch, {merge_label});
+
+    if (op->else_case.defined()) {
+        emit_label(else_label);
+        op->else_case.accept(this);
+        emit(body, Spv::OpBranch, {merge_label});
+    }
+    emit_label(merge_label);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Evaluate *op) {
+    if (is_const(op->value)) return;
+    codegen(op->value);
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Prefetch *op) {
+    // Prefetches are only hints.
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Fork *op) {
+    user_error << "Vulkan: async is not supported inside kernels.\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Acquire *op) {
+    user_error << "Vulkan: async is not supported inside kernels.\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::visit(const Atomic *op) {
+    user_error << "Vulkan: atomics are not supported yet.\n";
+}
+
+void CodeGen_Vulkan_Dev::SPIRV_Emitter::add_kernel(Stmt s, const string &name, const vector<DeviceArgument> &args) {
+    debug(2) << "Adding Vulkan kernel " << name << "\n";
+
+    vars.clear();
+    body.clear();
+    buffers.clear();
+    workgroup_size[0] = 0;
+    workgroup_size[1] = 0;
+    workgroup_size[2] = 0;
+    kernel_names.push_back(name);
+
+    // Declare the buffers, and lay out the push constant block (see
+    // the comment on this class).
+    vector<SpvId> member_types;
+    vector<uint32_t> member_offsets;
+    vector<string> member_names;
+    uint32_t push_constant_bytes = 0;
+    uint32_t binding = 0;
+    for (const DeviceArgument &arg : args) {
+        if (!arg.is_buffer) {
+            continue;
+        }
+        Type storage_type = storage_type_of(arg.type);
+        SpvId var = make_id();
+        SpvId ptr = pointer_type(Spv::StorageClassStorageBuffer, buffer_struct_type(storage_type));
+        emit(declarations, Spv::OpVariable, {ptr, var, Spv::StorageClassStorageBuffer});
+        emit(annotations, Spv::OpDecorate, {var, Spv::DecorationDescriptorSet, 0});
+        emit(annotations, Spv::OpDecorate, {var, Spv::DecorationBinding, binding++});
+        vector<uint32_t> var_name = {var};
+        append_string(var_name, arg.name);
+        emit(debug_names, Spv::OpName, var_name);
+        buffers[arg.name] = {var, storage_type, 0};
+
+        member_types.push_back(type_of(UInt(32)));
+        member_offsets.push_back(push_constant_bytes);
+        member_names.push_back(arg.name);
+        push_constant_bytes += 4;
+    }
+    for (const DeviceArgument &arg : args) {
+        if (arg.is_buffer) {
+            continue;
+        }
+        Type slot_type = arg.type.bits() < 32 ? UInt(32) : arg.type;
+        uint32_t slot_bytes = slot_type.bytes();
+        push_constant_bytes = (push_constant_bytes + slot_bytes - 1) / slot_bytes * slot_bytes;
+        member_types.push_back(type_of(slot_type));
+        member_offsets.push_back(push_constant_bytes);
+        member_names.push_back(arg.name);
+        push_constant_bytes += slot_bytes;
+    }
+    user_assert(push_constant_bytes <= max_push_constant_bytes)
+        << "Vulkan: the arguments of kernel " << name << " need " << push_constant_bytes
+        << " bytes of push constants, but only " << max_push_constant_bytes
+        << " are guaranteed to be available.\n";
+
+    SpvId push_constants = 0;
+    if (!member_types.empty()) {
+        SpvId block = make_id();
+        vector<uint32_t> operands = {block};
+        operands.insert(operands.end(), member_types.begin(), member_types.end());
+        emit(declarations, Spv::OpTypeStruct, operands);
+        emit(annotations, Spv::OpDecorate, {block, Spv::DecorationBlock});
+        for (size_t i = 0; i < member_offsets.size(); i++) {
+            emit(annotations, Spv::OpMemberDecorate, {block, (uint32_t)i, Spv::DecorationOffset, member_offsets[i]});
+        }
+        push_constants = make_id();
+        emit(declarations, Spv::OpVariable, {pointer_type(Spv::StorageClassPushConstant, block), push_constants, Spv::StorageClassPushConstant});
+    }
+
+    // Read all the push constants up front, so that the values
+    // dominate every use.
+    uint32_t member = 0;
+    vector<std::pair<string, SpvId>> scalars;
+    for (const DeviceArgument &arg : args) {
+        if (!arg.is_buffer) {
+            continue;
+        }
+        SpvId ptr = make_id();
+        emit(body, Spv::OpAccessChain, {pointer_type(Spv::StorageClassPushConstant, type_of(UInt(32))), ptr, push_constants, int_constant(member++)});
+        SpvId offset = emit_load(UInt(32), ptr);
+        buffers[arg.name].offset = emit_op(Spv::OpBitcast, Int(32), {offset});
+    }
+    for (const DeviceArgument &arg : args) {
+        if (arg.is_buffer) {
+            continue;
+        }
+        Type slot_type = arg.type.bits() < 32 ? UInt(32) : arg.type;
+        SpvId ptr = make_id();
+        emit(body, Spv::OpAccessChain, {pointer_type(Spv::StorageClassPushConstant, type_of(slot_type)), ptr, push_constants, int_constant(member++)});
+        SpvId value = emit_load(slot_type, ptr);
+        if (arg.type.is_bool()) {
+            value = emit_cast(Bool(), UInt(32), value);
+        } else if (slot_type != arg.type) {
+            value = emit_op(Spv::OpUConvert, UInt(arg.type.bits()), {value});
+            if (!arg.type.is_uint()) {
+                value = emit_op(Spv::OpBitcast, arg.type, {value});
+            }
+        }
+        scalars.push_back({arg.name, value});
+    }
+    for (const auto &scalar : scalars) {
+        symbols.push(scalar.first, scalar.second);
+    }
+
+    s.accept(this);
+
+    for (const auto &scalar : scalars) {
+        symbols.pop(scalar.first);
+    }
+
+    // Assemble the function. Its variables must open its first block.
+    SpvId fn = make_id();
+    emit(functions, Spv::OpFunction, {void_type(), fn, 0, function_type()});
+    emit(functions, Spv::OpLabel, {make_id()});
+    functions.insert(functions.end(), vars.begin(), vars.end());
+    functions.insert(functions.end(), body.begin(), body.end());
+    emit(functions, Spv::OpReturn, {});
+    emit(functions, Spv::OpFunctionEnd, {});
+
+    vector<uint32_t> entry_point = {Spv::ExecutionModelGLCompute, fn};
+    append_string(entry_point, name);
+    entry_point.push_back(workgroup_id_var);
+    entry_point.push_back(local_invocation_id_var);
+    emit(entry_points, Spv::OpEntryPoint, entry_point);
+
+    emit(execution_modes, Spv::OpExecutionMode, {fn, Spv::ExecutionModeLocalSize,
+                                                 (uint32_t)std::max(workgroup_size[0], 1),
+                                                 (uint32_t)std::max(workgroup_size[1], 1),
+                                                 (uint32_t)std::max(workgroup_size[2], 1)});
+
+    vector<uint32_t> fn_name = {fn};
+    append_string(fn_name, name);
+    emit(debug_names, Spv::OpName, fn_name);
+}
+
+vector<uint32_t> CodeGen_Vulkan_Dev::SPIRV_Emitter::assemble() const {
+    vector<uint32_t> module = {Spv::MagicNumber, Spv::Version_1_3, 0, next_id, 0};
+    for (uint32_t cap : capabilities) {
+        emit(module, Spv::OpCapability, {cap});
+    }
+    for (const string &ext : extensions) {
+        vector<uint32_t> name;
+        append_string(name, ext);
+        emit(module, Spv::OpExtension, name);
+    }
+    if (glsl_ext) {
+        vector<uint32_t> operands = {glsl_ext};
+        append_string(operands, "GLSL.std.450");
+        emit(module, Spv::OpExtInstImport, operands);
+    }
+    emit(module, Spv::OpMemoryModel, {Spv::AddressingModelLogical, Spv::MemoryModelGLSL450});
+    for (const Section *section : {&entry_points, &execution_modes, &debug_names,
+                                   &annotations, &declarations, &functions}) {
+        module.insert(module.end(), section->begin(), section->end());
+    }
+    return module;
+}
+
+CodeGen_Vulkan_Dev::CodeGen_Vulkan_Dev(Target target)
+    : emitter(new SPIRV_Emitter(target)) {
+}
+
+CodeGen_Vulkan_Dev::~CodeGen_Vulkan_Dev() {
+}
+
+void CodeGen_Vulkan_Dev::add_kernel(Stmt s,
+                                    const string &name,
+                                    const vector<DeviceArgument> &args) {
+    debug(2) << "CodeGen_Vulkan_Dev::compile " << name << "\n";
+    cur_kernel_name = name;
+    emitter->add_kernel(s, name, args);
+}
+
+void CodeGen_Vulkan_Dev::init_module() {
+    emitter->reset();
+    cur_kernel_name = "";
+}
+
+vector<char> CodeGen_Vulkan_Dev::compile_to_src() {
+    vector<uint32_t> module = emitter->assemble();
+    debug(1) << "SPIR-V module of " << module.size() << " words\n";
+    vector<char> buffer(module.size() * sizeof(uint32_t));
+    memcpy(buffer.data(), module.data(), buffer.size());
+    return buffer;
+}
+
+string CodeGen_Vulkan_Dev::get_current_kernel_name() {
+    return cur_kernel_name;
+}
+
+void CodeGen_Vulkan_Dev::dump() {
+    vector<uint32_t> module = emitter->assemble();
+    std::cerr << "SPIR-V module of " << module.size() << " words with kernels:\n";
+    for (const string &name : emitter->kernel_names) {
+        std::cerr << "  " << name << "\n";
+    }
+}
+
+string CodeGen_Vulkan_Dev::print_gpu_name(const string &name) {
+    return name;
+}
+
+}  // namespace Internal
+}  // namespace Halide
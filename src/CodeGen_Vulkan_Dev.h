@@ -0,0 +1,55 @@
+#ifndef HALIDE_CODEGEN_VULKAN_DEV_H
+#define HALIDE_CODEGEN_VULKAN_DEV_H
+
+/** \file
+ * Defines the code-generator for producing SPIR-V compute shaders for Vulkan.
+ */
+
+#include <memory>
+
+#include "CodeGen_GPU_Dev.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+class CodeGen_Vulkan_Dev : public CodeGen_GPU_Dev {
+public:
+    CodeGen_Vulkan_Dev(Target target);
+    ~CodeGen_Vulkan_Dev() override;
+
+    /** Compile a GPU kernel into the module. Every kernel becomes an
+     * entry point of a single SPIR-V module shared by the pipeline. */
+    void add_kernel(Stmt stmt,
+                    const std::string &name,
+                    const std::vector<DeviceArgument> &args) override;
+
+    /** (Re)initialize the GPU kernel module. */
+    void init_module() override;
+
+    /** Returns the SPIR-V binary for all kernels added since the last
+     * call to init_module. */
+    std::vector<char> compile_to_src() override;
+
+    std::string get_current_kernel_name() override;
+
+    void dump() override;
+
+    std::string print_gpu_name(const std::string &name) override;
+
+    std::string api_unique_name() override { return "vulkan"; }
+
+    /** The runtime packs the scalar arguments into push constants,
+     * which needs their types, not just their sizes. */
+    bool kernel_run_takes_types() const override { return true; }
+
+protected:
+    class SPIRV_Emitter;
+    std::unique_ptr<SPIRV_Emitter> emitter;
+    std::string cur_kernel_name;
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
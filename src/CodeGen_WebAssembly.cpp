@@ -114,6 +114,13 @@ string CodeGen_WebAssembly::mattrs() const {
         sep = ",";
     }
 
+    // The module must also be linked with shared memory
+    // (e.g. -s USE_PTHREADS=1 with Emscripten).
+    if (target.has_feature(Target::WasmThreads)) {
+        s << sep << "+atomics,+bulk-memory";
+        sep = ",";
+    }
+
     // TODO: Emscripten doesn't seem to be able to validate wasm that contains this yet.
     // We could only generate for JIT mode (where we know we can enable it), but that
     // would mean the execution model for JIT vs AOT could be slightly different,
@@ -0,0 +1,686 @@
+#include "CodeGen_WebGPU_Dev.h"
+#include "CodeGen_Internal.h"
+#include "Debug.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Simplify.h"
+
+#include <set>
+
+namespace Halide {
+namespace Internal {
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+CodeGen_WebGPU_Dev::CodeGen_WebGPU_Dev(Target target)
+    : wgsl(src_stream, target) {
+}
+
+namespace {
+
+string simt_intrinsic(const string &name) {
+    if (ends_with(name, ".__thread_id_x")) {
+        return "local_id.x";
+    } else if (ends_with(name, ".__thread_id_y")) {
+        return "local_id.y";
+    } else if (ends_with(name, ".__thread_id_z")) {
+        return "local_id.z";
+    } else if (ends_with(name, ".__thread_id_w")) {
+        user_error << "WebGPU does not support more than three dimensions for compute shaders.\n";
+    } else if (ends_with(name, ".__block_id_x")) {
+        return "group_id.x";
+    } else if (ends_with(name, ".__block_id_y")) {
+        return "group_id.y";
+    } else if (ends_with(name, ".__block_id_z")) {
+        return "group_id.z";
+    } else if (ends_with(name, ".__block_id_w")) {
+        user_error << "WebGPU does not support more than three dimensions for compute shaders.\n";
+    }
+    internal_error << "simt_intrinsic called on bad variable name: " << name << "\n";
+    return "";
+}
+
+int thread_loop_dimension(const string &name) {
+    if (ends_with(name, ".__thread_id_x")) {
+        return 0;
+    } else if (ends_with(name, ".__thread_id_y")) {
+        return 1;
+    } else if (ends_with(name, ".__thread_id_z")) {
+        return 2;
+    }
+    user_error << "WebGPU does not support more than three dimensions for compute shaders.\n";
+    return 0;
+}
+
+// WGSL declares the workgroup size on the entry point, so it has to
+// be known before the body is printed.
+class FindWorkgroupSize : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (CodeGen_GPU_Dev::is_gpu_thread_var(op->name)) {
+            Expr e = simplify(op->extent);
+            const IntImm *extent = e.as<IntImm>();
+            user_assert(extent)
+                << "WebGPU requires constant extents for GPU thread loops, but the extent of "
+                << op->name << " is " << op->extent << "\n";
+            int d = thread_loop_dimension(op->name);
+            size[d] = std::max(size[d], (int)extent->value);
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    int size[3] = {1, 1, 1};
+};
+
+class FindSharedAllocations : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) override {
+        op->body.accept(this);
+        if (starts_with(op->name, "__shared")) {
+            allocs.push_back(op);
+        }
+    }
+
+public:
+    vector<const Allocate *> allocs;
+};
+
+class FindStoredBuffers : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Store *op) override {
+        stored.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::set<string> stored;
+};
+
+}  // namespace
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::print_type(Type type, AppendSpaceIfNeeded space) {
+    user_assert(type.is_scalar())
+        << "WebGPU does not support vector types in GPU kernels: " << type << "\n";
+    string s;
+    if (type.is_bool()) {
+        s = "bool";
+    } else if (type.is_float()) {
+        user_assert(type.bits() == 32)
+            << "WebGPU only supports 32-bit floating point types, not " << type << "\n";
+        s = "f32";
+    } else {
+        user_assert(type.bits() <= 32)
+            << "WebGPU does not support 64-bit integer types: " << type << "\n";
+        s = type.is_uint() ? "u32" : "i32";
+    }
+    if (space == AppendSpace) {
+        s += " ";
+    }
+    return s;
+}
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::print_reinterpret(Type type, Expr e) {
+    internal_assert(type.bits() == e.type().bits())
+        << "WebGPU can only reinterpret between types of the same width\n";
+    return wrap(type, "bitcast<" + print_type(type) + ">(" + print_expr(e) + ")");
+}
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::print_name(const string &name) {
+    // WGSL reserves identifiers that begin with two underscores.
+    string n = CodeGen_C::print_name(name);
+    if (starts_with(n, "__")) {
+        n = "v" + n;
+    }
+    return n;
+}
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::print_assignment(Type t, const string &rhs) {
+    auto cached = cache.find(rhs);
+    if (cached == cache.end()) {
+        id = unique_name('_');
+        do_indent();
+        stream << "let " << id << " : " << print_type(t) << " = " << rhs << ";\n";
+        cache[rhs] = id;
+    } else {
+        id = cached->second;
+    }
+    return id;
+}
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::wrap(Type t, const string &e) {
+    if (t.is_bool() || t.is_float() || t.bits() >= 32) {
+        return e;
+    } else if (t.is_uint()) {
+        uint32_t mask = (1u << t.bits()) - 1;
+        return "((" + e + ") & " + std::to_string(mask) + "u)";
+    } else {
+        int shift = 32 - t.bits();
+        return "(((" + e + ") << " + std::to_string(shift) + "u) >> " + std::to_string(shift) + "u)";
+    }
+}
+
+string CodeGen_WebGPU_Dev::CodeGen_WGSL::storage_name(const string &name) {
+    if (buffers.count(name) || starts_with(name, "__shared")) {
+        // Buffer arguments and shared allocations live at module
+        // scope, so they are prefixed with the kernel name.
+        return kernel_name + "_" + print_name(name);
+    }
+    return print_name(name);
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const IntImm *op) {
+    id = "i32(" + std::to_string(op->value) + ")";
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const UIntImm *op) {
+    if (op->type.is_bool()) {
+        id = op->value ? "true" : "false";
+    } else {
+        id = std::to_string(op->value) + "u";
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const FloatImm *op) {
+    user_assert(op->type.bits() == 32)
+        << "WebGPU only supports 32-bit floating point types, not " << op->type << "\n";
+    union {
+        uint32_t as_uint;
+        float as_float;
+    } u;
+    u.as_float = op->value;
+    ostringstream oss;
+    oss << "bitcast<f32>(" << u.as_uint << "u /* " << op->value << " */)";
+    id = oss.str();
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Cast *op) {
+    Type t = op->type;
+    Type from = op->value.type();
+    string value = print_expr(op->value);
+    string rhs = print_type(t) + "(" + value + ")";
+    // Widening from an integer type whose range fits in the
+    // destination needs no wrapping.
+    bool fits = (from.is_int() || from.is_uint()) &&
+                from.bits() < t.bits() &&
+                (from.is_uint() || t.is_int());
+    if (!fits) {
+        rhs = wrap(t, rhs);
+    }
+    print_assignment(t, rhs);
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Add *op) {
+    string a = print_expr(op->a);
+    string b = print_expr(op->b);
+    print_assignment(op->type, wrap(op->type, a + " + " + b));
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Sub *op) {
+    string a = print_expr(op->a);
+    string b = print_expr(op->b);
+    print_assignment(op->type, wrap(op->type, a + " - " + b));
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Mul *op) {
+    string a = print_expr(op->a);
+    string b = print_expr(op->b);
+    print_assignment(op->type, wrap(op->type, a + " * " + b));
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Div *op) {
+    int bits;
+    if (op->type.is_float() || op->type.is_uint()) {
+        string a = print_expr(op->a);
+        string b = print_expr(op->b);
+        print_assignment(op->type, a + " / " + b);
+    } else if (is_const_power_of_two_integer(op->b, &bits)) {
+        // Arithmetic shift rounds towards negative infinity, which is
+        // the Euclidean result for a positive divisor.
+        string a = print_expr(op->a);
+        print_assignment(op->type, a + " >> " + std::to_string(bits) + "u");
+    } else {
+        print_expr(lower_euclidean_div(op->a, op->b));
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Mod *op) {
+    int bits;
+    if ((op->type.is_int() || op->type.is_uint()) &&
+        is_const_power_of_two_integer(op->b, &bits)) {
+        string a = print_expr(op->a);
+        string mask = print_expr(make_const(op->type, (1 << bits) - 1));
+        print_assignment(op->type, a + " & " + mask);
+    } else if (op->type.is_int()) {
+        print_expr(lower_euclidean_mod(op->a, op->b));
+    } else if (op->type.is_float()) {
+        string a = print_expr(op->a);
+        string b = print_expr(op->b);
+        print_assignment(op->type, a + " - " + b + " * floor(" + a + " / " + b + ")");
+    } else {
+        string a = print_expr(op->a);
+        string b = print_expr(op->b);
+        print_assignment(op->type, a + " % " + b);
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Max *op) {
+    string a = print_expr(op->a);
+    string b = print_expr(op->b);
+    if (op->type.is_bool()) {
+        print_assignment(op->type, a + " || " + b);
+    } else {
+        print_assignment(op->type, "max(" + a + ", " + b + ")");
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Min *op) {
+    string a = print_expr(op->a);
+    string b = print_expr(op->b);
+    if (op->type.is_bool()) {
+        print_assignment(op->type, a + " && " + b);
+    } else {
+        print_assignment(op->type, "min(" + a + ", " + b + ")");
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Select *op) {
+    string cond = print_expr(op->condition);
+    string true_val = print_expr(op->true_value);
+    string false_val = print_expr(op->false_value);
+    print_assignment(op->type, "select(" + false_val + ", " + true_val + ", " + cond + ")");
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Call *op) {
+    Type t = op->type;
+    if (op->is_intrinsic(Call::gpu_thread_barrier)) {
+        do_indent();
+        stream << "workgroupBarrier();\n";
+        id = "i32(0)";
+    } else if (op->is_intrinsic(Call::shift_left)) {
+        internal_assert(op->args.size() == 2);
+        string a = print_expr(op->args[0]);
+        string b = print_expr(op->args[1]);
+        print_assignment(t, wrap(t, a + " << u32(" + b + ")"));
+    } else if (op->is_intrinsic(Call::shift_right)) {
+        internal_assert(op->args.size() == 2);
+        string a = print_expr(op->args[0]);
+        string b = print_expr(op->args[1]);
+        print_assignment(t, a + " >> u32(" + b + ")");
+    } else if (op->is_intrinsic(Call::bitwise_not)) {
+        internal_assert(op->args.size() == 1);
+        string a = print_expr(op->args[0]);
+        if (t.is_bool()) {
+            print_assignment(t, "!" + a);
+        } else {
+            print_assignment(t, wrap(t, "~" + a));
+        }
+    } else if (op->is_intrinsic(Call::count_leading_zeros) ||
+               op->is_intrinsic(Call::count_trailing_zeros) ||
+               op->is_intrinsic(Call::popcount)) {
+        internal_assert(op->args.size() == 1);
+        Type arg_t = op->args[0].type();
+        string mask = std::to_string(arg_t.bits() == 32 ? 0xffffffffu : (1u << arg_t.bits()) - 1) + "u";
+        string a = "(u32(" + print_expr(op->args[0]) + ") & " + mask + ")";
+        string rhs;
+        if (op->is_intrinsic(Call::count_leading_zeros)) {
+            rhs = "countLeadingZeros(" + a + ") - " + std::to_string(32 - arg_t.bits()) + "u";
+        } else if (op->is_intrinsic(Call::count_trailing_zeros)) {
+            rhs = "min(countTrailingZeros(" + a + "), " + std::to_string(arg_t.bits()) + "u)";
+        } else {
+            rhs = "countOneBits(" + a + ")";
+        }
+        print_assignment(t, print_type(t) + "(" + rhs + ")");
+    } else if (op->is_intrinsic(Call::if_then_else)) {
+        internal_assert(op->args.size() == 3);
+        // WGSL has no conditional expression that evaluates only one
+        // side, so lower to a mutable variable.
+        string result_id = unique_name('_');
+        do_indent();
+        stream << "var " << result_id << " : " << print_type(t) << ";\n";
+        string cond_id = print_expr(op->args[0]);
+        do_indent();
+        stream << "if (" << cond_id << ")\n";
+        open_scope();
+        {
+            string true_case = print_expr(op->args[1]);
+            do_indent();
+            stream << result_id << " = " << true_case << ";\n";
+        }
+        close_scope("if " + cond_id);
+        do_indent();
+        stream << "else\n";
+        open_scope();
+        {
+            string false_case = print_expr(op->args[2]);
+            do_indent();
+            stream << result_id << " = " << false_case << ";\n";
+        }
+        close_scope("if " + cond_id + " else");
+        id = result_id;
+    } else if (op->is_intrinsic(Call::return_second)) {
+        internal_assert(op->args.size() == 2);
+        print_expr(op->args[0]);
+        id = print_expr(op->args[1]);
+    } else if (op->is_intrinsic(Call::prefetch)) {
+        // There is no way to prefetch in WGSL.
+        id = "i32(0)";
+    } else {
+        CodeGen_C::visit(op);
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Load *op) {
+    user_assert(is_one(op->predicate))
+        << "WebGPU does not support predicated loads.\n";
+    Type t = op->type;
+    string idx = print_expr(op->index);
+
+    auto buf = buffers.find(op->name);
+    if (buf == buffers.end()) {
+        // A local or shared allocation.
+        print_assignment(t, storage_name(op->name) + "[" + idx + "]");
+        return;
+    }
+
+    const BufferArg &b = buf->second;
+    string elem = print_assignment(Int(32), kernel_name + "_args.offset_" + std::to_string(b.index) + " + " + idx);
+    if (!b.packed) {
+        string rhs = storage_name(op->name) + "[" + elem + "]";
+        if (t != b.type) {
+            rhs = "bitcast<" + print_type(t) + ">(" + rhs + ")";
+        }
+        print_assignment(t, rhs);
+        return;
+    }
+
+    // 8 and 16-bit elements are extracted from the u32 word that
+    // holds them.
+    int bits = b.type.bits();
+    string word_ref = storage_name(op->name) + "[" + elem + (bits == 8 ? " >> 2u" : " >> 1u") + "]";
+    string word = print_assignment(UInt(32), b.atomic ? "atomicLoad(&" + word_ref + ")" : word_ref);
+    string pos = print_assignment(UInt(32), "u32(" + elem + (bits == 8 ? " & 3" : " & 1") + ") * " + std::to_string(bits) + "u");
+    string mask = std::to_string((1u << bits) - 1) + "u";
+    if (t.is_bool()) {
+        print_assignment(t, "((" + word + " >> " + pos + ") & " + mask + ") != 0u");
+    } else if (t.is_int()) {
+        print_assignment(t, "bitcast<i32>(" + word + " << (" + std::to_string(32 - bits) + "u - " + pos + ")) >> " +
+                                std::to_string(32 - bits) + "u");
+    } else {
+        print_assignment(t, "(" + word + " >> " + pos + ") & " + mask);
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Store *op) {
+    user_assert(is_one(op->predicate))
+        << "WebGPU does not support predicated stores.\n";
+    Type t = op->value.type();
+    string value = print_expr(op->value);
+    string idx = print_expr(op->index);
+
+    auto buf = buffers.find(op->name);
+    if (buf == buffers.end()) {
+        do_indent();
+        stream << storage_name(op->name) << "[" << idx << "] = " << value << ";\n";
+    } else {
+        const BufferArg &b = buf->second;
+        string elem = print_assignment(Int(32), kernel_name + "_args.offset_" + std::to_string(b.index) + " + " + idx);
+        if (!b.packed) {
+            if (t != b.type) {
+                value = "bitcast<" + print_type(b.type) + ">(" + value + ")";
+            }
+            do_indent();
+            stream << storage_name(op->name) << "[" << elem << "] = " << value << ";\n";
+        } else {
+            // Other invocations may be writing neighbouring elements of
+            // the same word, so update only our bits, atomically.
+            int bits = b.type.bits();
+            string word_ref = storage_name(op->name) + "[" + elem + (bits == 8 ? " >> 2u" : " >> 1u") + "]";
+            string pos = print_assignment(UInt(32), "u32(" + elem + (bits == 8 ? " & 3" : " & 1") + ") * " + std::to_string(bits) + "u");
+            string mask = std::to_string((1u << bits) - 1) + "u";
+            string bits_val = t.is_bool() ? "select(0u, 1u, " + value + ")" : "(u32(" + value + ") & " + mask + ")";
+            do_indent();
+            stream << "atomicAnd(&" << word_ref << ", ~(" << mask << " << " << pos << "));\n";
+            do_indent();
+            stream << "atomicOr(&" << word_ref << ", " << bits_val << " << " << pos << ");\n";
+        }
+    }
+    cache.clear();
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const For *loop) {
+    if (is_gpu_var(loop->name)) {
+        internal_assert((loop->for_type == ForType::GPUBlock) ||
+                        (loop->for_type == ForType::GPUThread))
+            << "kernel loop must be either gpu block or gpu thread\n";
+        internal_assert(is_zero(loop->min));
+
+        do_indent();
+        stream << "let " << print_name(loop->name) << " : i32 = i32(" << simt_intrinsic(loop->name) << ");\n";
+        loop->body.accept(this);
+    } else {
+        user_assert(loop->for_type != ForType::Parallel)
+            << "Cannot use parallel loops inside WebGPU kernel\n";
+        internal_assert(loop->for_type == ForType::Serial)
+            << "Can only emit serial or parallel for loops to WGSL\n";
+
+        string id_min = print_expr(loop->min);
+        string id_extent = print_expr(loop->extent);
+        string n = print_name(loop->name);
+
+        do_indent();
+        stream << "for (var " << n << " : i32 = " << id_min << "; "
+               << n << " < " << id_min << " + " << id_extent << "; "
+               << n << "++)\n";
+        open_scope();
+        loop->body.accept(this);
+        close_scope("for " + n);
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Allocate *op) {
+    debug(2) << "WebGPU: Allocate " << op->name << " of type " << op->type << " on device\n";
+
+    Allocation alloc;
+    alloc.type = op->type;
+    bool shared = starts_with(op->name, "__shared");
+    if (!shared) {
+        // Shared allocations were already declared at module scope.
+        int32_t size = op->constant_allocation_size();
+        user_assert(size > 0)
+            << "WebGPU requires allocations inside kernels to have a constant size: "
+            << op->name << "\n";
+        open_scope();
+        do_indent();
+        stream << "var " << print_name(op->name) << " : array<"
+               << print_type(op->type) << ", " << size << ">;\n";
+    }
+    allocations.push(op->name, alloc);
+    op->body.accept(this);
+    if (allocations.contains(op->name)) {
+        allocations.pop(op->name);
+    }
+    if (!shared) {
+        close_scope("alloc " + print_name(op->name));
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Free *op) {
+    debug(2) << "WebGPU: Free on device for " << op->name << "\n";
+
+    if (allocations.contains(op->name)) {
+        allocations.pop(op->name);
+    }
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Evaluate *op) {
+    if (is_const(op->value)) return;
+    print_expr(op->value);
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const AssertStmt *op) {
+    // Kernels have no way to report errors.
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Ramp *op) {
+    user_error << "WebGPU does not support vector types in GPU kernels. "
+               << "Remove the vectorize directive from the GPU loop nest.\n";
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::visit(const Broadcast *op) {
+    user_error << "WebGPU does not support vector types in GPU kernels. "
+               << "Remove the vectorize directive from the GPU loop nest.\n";
+}
+
+void CodeGen_WebGPU_Dev::add_kernel(Stmt s,
+                                    const string &name,
+                                    const vector<DeviceArgument> &args) {
+    debug(2) << "CodeGen_WebGPU_Dev::compile " << name << "\n";
+
+    cur_kernel_name = name;
+    wgsl.add_kernel(s, name, args);
+}
+
+void CodeGen_WebGPU_Dev::CodeGen_WGSL::add_kernel(Stmt s,
+                                                  const string &name,
+                                                  const vector<DeviceArgument> &args) {
+    debug(2) << "Adding WebGPU kernel " << name << "\n";
+    cache.clear();
+    buffers.clear();
+    kernel_name = name;
+
+    FindStoredBuffers fsb;
+    s.accept(&fsb);
+
+    // Buffers are bound first, in argument order, followed by a
+    // uniform block holding the scalar arguments and the element
+    // offset of each buffer within its device allocation.
+    stream << "// kernel " << name << "\n";
+    int binding = 0;
+    for (const DeviceArgument &arg : args) {
+        if (!arg.is_buffer) {
+            continue;
+        }
+        Type t = arg.type.is_bool() ? UInt(8) : arg.type;
+        user_assert(t.bits() <= 32 && (t.bits() == 32 || !t.is_float()))
+            << "WebGPU does not support buffers of type " << arg.type << "\n";
+        BufferArg b;
+        b.type = t;
+        b.index = binding;
+        b.packed = t.bits() < 32;
+        b.atomic = b.packed && fsb.stored.count(arg.name);
+        buffers[arg.name] = b;
+        string elem = b.packed ? (b.atomic ? "atomic<u32>" : "u32") : print_type(t);
+        stream << "@group(0) @binding(" << binding << ") var<storage, read_write> "
+               << storage_name(arg.name) << " : array<" << elem << ">;\n";
+        binding++;
+    }
+
+    vector<string> fields;
+    for (int i = 0; i < binding; i++) {
+        fields.push_back("offset_" + std::to_string(i) + " : i32");
+    }
+    for (const DeviceArgument &arg : args) {
+        if (arg.is_buffer) {
+            continue;
+        }
+        user_assert(arg.type.bits() <= 32)
+            << "WebGPU does not support 64-bit scalar arguments: " << arg.name << "\n";
+        fields.push_back(print_name(arg.name) + " : " + (arg.type.is_bool() ? "u32" : print_type(arg.type)));
+    }
+    if (!fields.empty()) {
+        stream << "struct " << name << "_args_t {\n";
+        for (const string &f : fields) {
+            stream << "  " << f << ",\n";
+        }
+        stream << "}\n"
+               << "@group(0) @binding(" << binding << ") var<uniform> "
+               << name << "_args : " << name << "_args_t;\n";
+    }
+
+    // Find all the shared allocations and declare them at module scope.
+    FindSharedAllocations fsa;
+    s.accept(&fsa);
+    for (const Allocate *op : fsa.allocs) {
+        int32_t size = op->constant_allocation_size();
+        user_assert(size > 0)
+            << "WebGPU requires shared allocations to have a constant size: " << op->name << "\n";
+        stream << "var<workgroup> " << storage_name(op->name) << " : array<"
+               << print_type(op->type) << ", " << size << ">;\n";
+    }
+
+    FindWorkgroupSize fws;
+    s.accept(&fws);
+
+    stream << "@compute @workgroup_size(" << fws.size[0] << ", " << fws.size[1] << ", " << fws.size[2] << ")\n"
+           << "fn " << name << "(@builtin(workgroup_id) group_id : vec3<u32>,\n"
+           << "    @builtin(local_invocation_id) local_id : vec3<u32>)\n";
+    open_scope();
+    for (const DeviceArgument &arg : args) {
+        if (arg.is_buffer) {
+            continue;
+        }
+        do_indent();
+        stream << "let " << print_name(arg.name) << " : " << print_type(arg.type) << " = "
+               << name << "_args." << print_name(arg.name) << (arg.type.is_bool() ? " != 0u" : "") << ";\n";
+    }
+    print(s);
+    close_scope("kernel " + name);
+    stream << "\n";
+}
+
+void CodeGen_WebGPU_Dev::init_module() {
+    src_stream.str("");
+    src_stream.clear();
+    cur_kernel_name = "";
+
+    // Halide calls math functions by their C names; define them once
+    // for every kernel in the module.
+    src_stream << "// Halide WGSL prelude\n";
+    const char *unary[] = {"sqrt", "sin", "cos", "tan", "asin", "acos", "atan",
+                           "sinh", "cosh", "tanh", "asinh", "acosh", "atanh",
+                           "exp", "log", "abs", "floor", "ceil", "round", "trunc"};
+    for (const char *f : unary) {
+        src_stream << "fn " << f << "_f32(x : f32) -> f32 { return " << f << "(x); }\n";
+    }
+    src_stream << "fn pow_f32(x : f32, y : f32) -> f32 { return pow(x, y); }\n"
+               << "fn atan2_f32(y : f32, x : f32) -> f32 { return atan2(y, x); }\n"
+               << "fn fast_inverse_f32(x : f32) -> f32 { return 1.0 / x; }\n"
+               << "fn fast_inverse_sqrt_f32(x : f32) -> f32 { return inverseSqrt(x); }\n"
+               // WGSL implementations may assume NaN and infinity never
+               // occur, so test the bits rather than the value.
+               << "fn is_nan_f32(x : f32) -> bool { return (bitcast<u32>(x) & 0x7fffffffu) > 0x7f800000u; }\n"
+               << "fn is_inf_f32(x : f32) -> bool { return (bitcast<u32>(x) & 0x7fffffffu) == 0x7f800000u; }\n"
+               << "fn is_finite_f32(x : f32) -> bool { return (bitcast<u32>(x) & 0x7f800000u) != 0x7f800000u; }\n"
+               << "fn nan_f32() -> f32 { return bitcast<f32>(0x7fc00000u); }\n"
+               << "fn inf_f32() -> f32 { return bitcast<f32>(0x7f800000u); }\n"
+               << "fn neg_inf_f32() -> f32 { return bitcast<f32>(0xff800000u); }\n\n";
+}
+
+vector<char> CodeGen_WebGPU_Dev::compile_to_src() {
+    string str = src_stream.str();
+    debug(1) << "WGSL source:\n" << str << '\n';
+    vector<char> buffer(str.begin(), str.end());
+    buffer.push_back(0);
+    return buffer;
+}
+
+string CodeGen_WebGPU_Dev::get_current_kernel_name() {
+    return cur_kernel_name;
+}
+
+void CodeGen_WebGPU_Dev::dump() {
+    std::cerr << src_stream.str() << std::endl;
+}
+
+string CodeGen_WebGPU_Dev::print_gpu_name(const string &name) {
+    return name;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,109 @@
+#ifndef HALIDE_CODEGEN_WEBGPU_DEV_H
+#define HALIDE_CODEGEN_WEBGPU_DEV_H
+
+/** \file
+ * Defines the code-generator for producing WGSL kernel code for WebGPU.
+ */
+
+#include <map>
+#include <sstream>
+
+#include "CodeGen_C.h"
+#include "CodeGen_GPU_Dev.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+class CodeGen_WebGPU_Dev : public CodeGen_GPU_Dev {
+public:
+    CodeGen_WebGPU_Dev(Target target);
+
+    // CodeGen_GPU_Dev interface
+    void add_kernel(Stmt stmt,
+                    const std::string &name,
+                    const std::vector<DeviceArgument> &args) override;
+
+    void init_module() override;
+
+    std::vector<char> compile_to_src() override;
+
+    std::string get_current_kernel_name() override;
+
+    void dump() override;
+
+    std::string print_gpu_name(const std::string &name) override;
+
+    std::string api_unique_name() override { return "webgpu"; }
+    bool kernel_run_takes_types() const override { return true; }
+
+protected:
+
+    class CodeGen_WGSL : public CodeGen_C {
+    public:
+        CodeGen_WGSL(std::ostream &s, Target t) : CodeGen_C(s, t) {}
+        void add_kernel(Stmt stmt,
+                        const std::string &name,
+                        const std::vector<DeviceArgument> &args);
+
+    protected:
+        std::string print_type(Type type, AppendSpaceIfNeeded space_option = DoNotAppendSpace) override;
+        std::string print_reinterpret(Type type, Expr e) override;
+        std::string print_name(const std::string &name) override;
+        std::string print_assignment(Type t, const std::string &rhs) override;
+
+        using CodeGen_C::visit;
+        void visit(const IntImm *op) override;
+        void visit(const UIntImm *op) override;
+        void visit(const FloatImm *op) override;
+        void visit(const Cast *op) override;
+        void visit(const Add *op) override;
+        void visit(const Sub *op) override;
+        void visit(const Mul *op) override;
+        void visit(const Div *op) override;
+        void visit(const Mod *op) override;
+        void visit(const Max *op) override;
+        void visit(const Min *op) override;
+        void visit(const Select *op) override;
+        void visit(const Call *op) override;
+        void visit(const Load *op) override;
+        void visit(const Store *op) override;
+        void visit(const For *op) override;
+        void visit(const Allocate *op) override;
+        void visit(const Free *op) override;
+        void visit(const Evaluate *op) override;
+        void visit(const AssertStmt *op) override;
+        void visit(const Ramp *op) override;
+        void visit(const Broadcast *op) override;
+
+        /** WGSL only has 32-bit integers, so narrower integers are held
+         * in i32 or u32 values, and are wrapped back into their range
+         * after each operation that can leave it. */
+        std::string wrap(Type t, const std::string &e);
+
+        /** The variable a kernel accesses an allocation or buffer
+         * argument through. */
+        std::string storage_name(const std::string &name);
+
+        /** A buffer argument of the current kernel. 8 and 16-bit
+         * buffers are packed into u32 words, which are atomic if the
+         * kernel stores to them. */
+        struct BufferArg {
+            Type type;
+            int index;
+            bool packed;
+            bool atomic;
+        };
+        std::map<std::string, BufferArg> buffers;
+        std::string kernel_name;
+    };
+
+    std::ostringstream src_stream;
+    std::string cur_kernel_name;
+    CodeGen_WGSL wgsl;
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -9,9 +9,14 @@
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "Param.h"
+#include "Simplify.h"
 #include "Util.h"
 #include "Var.h"
 
+#if LLVM_VERSION >= 130
+#include <llvm/IR/IntrinsicsX86.h>
+#endif
+
 namespace Halide {
 namespace Internal {
 
@@ -26,6 +31,16 @@ namespace {
 // existing flags, so that instruction patterns can just check for the
 // oldest feature flag that supports an instruction.
 Target complete_x86_target(Target t) {
+    if (t.has_feature(Target::AVX512_SapphireRapids)) {
+        t.set_feature(Target::AVX512_BF16);
+        t.set_feature(Target::AVX512_Cannonlake);
+    }
+    if (t.has_feature(Target::AVX512_BF16)) {
+        t.set_feature(Target::AVX512_VNNI);
+    }
+    if (t.has_feature(Target::AVX512_VNNI)) {
+        t.set_feature(Target::AVX512_Skylake);
+    }
     if (t.has_feature(Target::AVX512_Cannonlake) ||
         t.has_feature(Target::AVX512_Skylake) ||
         t.has_feature(Target::AVX512_KNL)) {
@@ -48,6 +63,11 @@ CodeGen_X86::CodeGen_X86(Target t) : CodeGen_Posix(complete_x86_target(t)) {
     #endif
 
     user_assert(llvm_X86_enabled) << "llvm build not configured with X86 target enabled.\n";
+
+    #if LLVM_VERSION < 130
+    user_assert(!t.has_feature(Target::AVX512_SapphireRapids))
+        << "avx512_sapphirerapids (AMX tiles) requires Halide to be built with LLVM 13 or later.\n";
+    #endif
 }
 
 namespace {
@@ -80,12 +100,117 @@ bool should_use_pmaddwd(Expr a, Expr b, vector<Expr> &result) {
     return true;
 }
 
+void flatten_sum(const Expr &e, vector<Expr> &terms) {
+    if (const Add *add = e.as<Add>()) {
+        flatten_sum(add->a, terms);
+        flatten_sum(add->b, terms);
+    } else {
+        terms.push_back(e);
+    }
+}
+
+// A sum of i32 terms that includes several products of the form
+// i32(u8_a)*i32(i8_b), or i32(i16_a)*i32(i16_b), can be computed with
+// the AVX512-VNNI dot product instructions: vpdpbusd adds four u8 x i8
+// products to each lane of an accumulator, and vpdpwssd adds two i16 x
+// i16 products. The operands of each group of products are interleaved
+// so that the ones summed together share an i32 lane. Both
+// instructions wrap on overflow, like the i32 sum they replace.
+bool should_use_vnni(const Add *op, Expr &result) {
+    Type t = op->type;
+    if (!(t.is_int() && t.bits() == 32 && t.lanes() >= 4)) {
+        return false;
+    }
+
+    vector<Expr> terms;
+    flatten_sum(op, terms);
+
+    Type u8_t = t.with_bits(8).with_code(Type::UInt);
+    Type i8_t = t.with_bits(8);
+    Type i16_t = t.with_bits(16);
+    vector<Expr> byte_a, byte_b, byte_terms, word_a, word_b, word_terms, rest;
+    for (const Expr &term : terms) {
+        const Mul *mul = term.as<Mul>();
+        if (!mul) {
+            rest.push_back(term);
+            continue;
+        }
+        Expr a = lossless_cast(u8_t, mul->a);
+        Expr b = lossless_cast(i8_t, mul->b);
+        if (!a.defined() || !b.defined()) {
+            a = lossless_cast(u8_t, mul->b);
+            b = lossless_cast(i8_t, mul->a);
+        }
+        if (a.defined() && b.defined()) {
+            byte_a.push_back(a);
+            byte_b.push_back(b);
+            byte_terms.push_back(term);
+            continue;
+        }
+        a = lossless_cast(i16_t, mul->a);
+        b = lossless_cast(i16_t, mul->b);
+        if (a.defined() && b.defined()) {
+            word_a.push_back(a);
+            word_b.push_back(b);
+            word_terms.push_back(term);
+            continue;
+        }
+        rest.push_back(term);
+    }
+
+    // A trailing group of byte products is padded out with zeros,
+    // unless it would only contain one real product.
+    if (byte_a.size() % 4 == 1) {
+        rest.push_back(byte_terms.back());
+        byte_a.pop_back();
+        byte_b.pop_back();
+    }
+    while (byte_a.size() % 4 != 0) {
+        byte_a.push_back(make_zero(u8_t));
+        byte_b.push_back(make_zero(i8_t));
+    }
+    if (word_a.size() % 2 == 1) {
+        rest.push_back(word_terms.back());
+        word_a.pop_back();
+        word_b.pop_back();
+    }
+
+    // A lone pair of i16 products with nothing to accumulate into is
+    // better served by pmaddwd.
+    if (byte_a.empty() && (word_a.empty() || (word_a.size() == 2 && rest.empty()))) {
+        return false;
+    }
+
+    Expr acc;
+    for (const Expr &term : rest) {
+        acc = acc.defined() ? acc + term : term;
+    }
+    if (!acc.defined()) {
+        acc = make_zero(t);
+    }
+    for (size_t i = 0; i < byte_a.size(); i += 4) {
+        Expr a = Shuffle::make_interleave({byte_a[i], byte_a[i + 1], byte_a[i + 2], byte_a[i + 3]});
+        Expr b = Shuffle::make_interleave({byte_b[i], byte_b[i + 1], byte_b[i + 2], byte_b[i + 3]});
+        acc = Call::make(t, "dpbusd", {acc, reinterpret(t, a), reinterpret(t, b)}, Call::Extern);
+    }
+    for (size_t i = 0; i < word_a.size(); i += 2) {
+        Expr a = Shuffle::make_interleave({word_a[i], word_a[i + 1]});
+        Expr b = Shuffle::make_interleave({word_b[i], word_b[i + 1]});
+        acc = Call::make(t, "dpwssd", {acc, reinterpret(t, a), reinterpret(t, b)}, Call::Extern);
+    }
+    result = acc;
+    return true;
+}
+
 }
 
 
 void CodeGen_X86::visit(const Add *op) {
     vector<Expr> matches;
-    if (should_use_pmaddwd(op->a, op->b, matches)) {
+    Expr vnni;
+    if (target.has_feature(Target::AVX512_VNNI) && should_use_vnni(op, vnni)) {
+        codegen(vnni);
+    } else if (should_use_pmaddwd(op->a, op->b, matches)) {
         codegen(Call::make(op->type, "pmaddwd", matches, Call::Extern));
     } else {
         CodeGen_Posix::visit(op);
@@ -380,6 +505,26 @@ void CodeGen_X86::visit(const Cast *op) {
         }
     }
 
+    // Convert vectors of float16 eight lanes at a time, rather than
+    // letting LLVM scalarize the conversions.
+    if (target.has_feature(Target::F16C)) {
+        const int lanes = op->type.lanes();
+        if (op->type.element_of() == Float(32) &&
+            op->value.type().element_of() == Float(16)) {
+            Value *bits = builder->CreateBitCast(codegen(op->value), llvm_type_of(UInt(16, lanes)));
+            value = call_intrin(llvm_type_of(op->type), 8, "llvm.x86.vcvtph2ps.256", {bits});
+            return;
+        } else if (op->type.element_of() == Float(16) &&
+                   op->value.type().element_of() == Float(32)) {
+            // Round to nearest, ties to even.
+            Value *rounding = ConstantInt::get(i32_t, 0);
+            Value *bits = call_intrin(llvm_type_of(UInt(16, lanes)), 8, "llvm.x86.vcvtps2ph.256",
+                                      {codegen(op->value), rounding});
+            value = builder->CreateBitCast(bits, llvm_type_of(op->type));
+            return;
+        }
+    }
+
     // Workaround for https://llvm.org/bugs/show_bug.cgi?id=24512
     // LLVM uses a numerically unstable method for vector
     // uint32->float conversion before AVX.
@@ -424,10 +569,270 @@ void CodeGen_X86::visit(const Call *op) {
         return;
     }
 
+    if (op->is_intrinsic("tile_zero") ||
+        op->is_intrinsic("tile_load") ||
+        op->is_intrinsic("tile_matmul") ||
+        op->is_intrinsic("tile_store")) {
+        value = codegen_tile_op(op);
+        return;
+    }
+
     CodeGen_Posix::visit(op);
 }
 
+Value *CodeGen_X86::codegen_tile_op(const Call *op) {
+#if LLVM_VERSION >= 130
+    // The shape arguments of all the tile intrinsics are i16s.
+    auto shape = [&](int i) {
+        return builder->CreateTrunc(codegen(op->args[i]), i16_t);
+    };
+    auto to_tile = [&](Value *v) {
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), Intrinsic::x86_cast_vector_to_tile, {v->getType()});
+        return builder->CreateCall(fn, {v});
+    };
+    auto from_tile = [&](Value *v) {
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), Intrinsic::x86_cast_tile_to_vector, {llvm_type_of(op->type)});
+        return builder->CreateCall(fn, {v});
+    };
+    // Loads and stores take a buffer, the index of the first element,
+    // and the row stride in elements.
+    auto row_pointer = [&](int i, Type t) {
+        const Variable *buffer = op->args[i].as<Variable>();
+        internal_assert(buffer) << "Expected a buffer name in " << Expr(op) << "\n";
+        Value *ptr = codegen_buffer_pointer(buffer->name, t, op->args[i + 1]);
+        return builder->CreatePointerCast(ptr, i8_t->getPointerTo());
+    };
+    auto row_stride = [&](int i, Type t) {
+        return codegen(i64(op->args[i]) * t.bytes());
+    };
+
+    if (op->is_intrinsic("tile_zero")) {
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), Intrinsic::x86_tilezero_internal);
+        return from_tile(builder->CreateCall(fn, {shape(0), shape(1)}));
+    } else if (op->is_intrinsic("tile_load")) {
+        Type t = op->type.element_of();
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), Intrinsic::x86_tileloadd64_internal);
+        return from_tile(builder->CreateCall(fn, {shape(0), shape(1), row_pointer(2, t), row_stride(4, t)}));
+    } else if (op->is_intrinsic("tile_matmul")) {
+        Type a = op->args[4].type().element_of();
+        Type b = op->args[5].type().element_of();
+        Intrinsic::ID id;
+        if (a.is_bfloat()) {
+            id = Intrinsic::x86_tdpbf16ps_internal;
+        } else if (a.is_int()) {
+            id = b.is_int() ? Intrinsic::x86_tdpbssd_internal : Intrinsic::x86_tdpbsud_internal;
+        } else {
+            id = b.is_int() ? Intrinsic::x86_tdpbusd_internal : Intrinsic::x86_tdpbuud_internal;
+        }
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), id);
+        Value *acc = to_tile(codegen(op->args[3]));
+        Value *lhs = to_tile(codegen(op->args[4]));
+        Value *rhs = to_tile(codegen(op->args[5]));
+        return from_tile(builder->CreateCall(fn, {shape(0), shape(1), shape(2), acc, lhs, rhs}));
+    } else {
+        internal_assert(op->is_intrinsic("tile_store"));
+        Type t = op->args[5].type().element_of();
+        Value *tile = to_tile(codegen(op->args[5]));
+        llvm::Function *fn = Intrinsic::getDeclaration(module.get(), Intrinsic::x86_tilestored64_internal);
+        builder->CreateCall(fn, {shape(0), shape(1), row_pointer(2, t), row_stride(4, t), tile});
+        return ConstantInt::get(i32_t, 0);
+    }
+#else
+    // The constructor rejects avx512_sapphirerapids, so there are no
+    // tile operations to generate.
+    internal_error << "AMX tile operation without LLVM 13 or later\n";
+    return nullptr;
+#endif
+}
+
+void CodeGen_X86::visit(const VectorReduce *op) {
+    const int input_lanes = op->value.type().lanes();
+    const int factor = input_lanes / op->type.lanes();
+
+    // A widening sum of absolute differences of bytes, in groups of a
+    // multiple of eight, is psadbw followed by a narrower reduction.
+    if (op->op == VectorReduce::Add &&
+        factor % 8 == 0 &&
+        input_lanes >= 16 &&
+        (op->type.is_int() || op->type.is_uint()) &&
+        op->type.bits() >= 16) {
+        const Cast *cast = op->value.as<Cast>();
+        const Call *call = cast ? cast->value.as<Call>() : nullptr;
+        if (call &&
+            call->is_intrinsic(Call::absd) &&
+            call->args[0].type().element_of() == UInt(8) &&
+            call->args[1].type().element_of() == UInt(8)) {
+            Type sad_t = UInt(64, input_lanes / 8);
+            Value *sad;
+            if (target.has_feature(Target::AVX2) && input_lanes >= 32) {
+                sad = call_intrin(sad_t, 4, "llvm.x86.avx2.psad.bw", call->args);
+            } else {
+                sad = call_intrin(sad_t, 2, "llvm.x86.sse2.psad.bw", call->args);
+            }
+            // Each lane of the sum is at most 8 * 255, so narrowing it
+            // to the result type is exact.
+            Type partial_t = op->type.with_lanes(input_lanes / 8);
+            sad = builder->CreateIntCast(sad, llvm_type_of(partial_t), false);
+            if (factor == 8) {
+                value = sad;
+            } else {
+                string name = unique_name('t');
+                sym_push(name, sad);
+                value = codegen(VectorReduce::make(VectorReduce::Add, Variable::make(partial_t, name), op->type.lanes()));
+                sym_pop(name);
+            }
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
+bool CodeGen_X86::use_masked_gather_scatter(Type t) const {
+    // AVX-512F has gathers and scatters of 32 and 64-bit values
+    // under a mask register.
+    return (t.bits() == 32 || t.bits() == 64) &&
+        t.lanes() >= 4 &&
+        target.features_any_of({Target::AVX512, Target::AVX512_KNL,
+                                Target::AVX512_Skylake, Target::AVX512_Cannonlake});
+}
+
+Value *CodeGen_X86::codegen_buffer_pointers(const string &buffer, Type t, Expr index) {
+    // The base pointer, cast to the element type.
+    Value *base = codegen_buffer_pointer(buffer, t.element_of(), ConstantInt::get(i32_t, 0));
+    Value *vindex = codegen(index);
+    llvm::DataLayout d(module.get());
+    if (d.getPointerSize() == 8) {
+        vindex = builder->CreateIntCast(vindex, VectorType::get(i64_t, t.lanes()), true);
+    }
+    return builder->CreateInBoundsGEP(base, vindex);
+}
+
+void CodeGen_X86::codegen_predicated_vector_load(const Load *op) {
+    const Ramp *ramp = op->index.as<Ramp>();
+    const bool dense = ramp && (is_one(ramp->stride) || is_const(ramp->stride, -1));
+    if (dense || !use_masked_gather_scatter(op->type)) {
+        CodeGen_Posix::codegen_predicated_vector_load(op);
+        return;
+    }
+
+    debug(4) << "Predicated gather\n\t" << Expr(op) << "\n";
+    Value *vpred = codegen(op->predicate);
+    Value *ptrs = codegen_buffer_pointers(op->name, op->type, op->index);
+    Instruction *load = builder->CreateMaskedGather(ptrs, op->type.bytes(), vpred,
+                                                    Constant::getNullValue(llvm_type_of(op->type)));
+    add_tbaa_metadata(load, op->name, op->index);
+    value = load;
+}
+
+void CodeGen_X86::codegen_predicated_vector_store(const Store *op) {
+    const Ramp *ramp = op->index.as<Ramp>();
+    const bool dense = ramp && is_one(ramp->stride);
+    if (dense || !use_masked_gather_scatter(op->value.type())) {
+        CodeGen_Posix::codegen_predicated_vector_store(op);
+        return;
+    }
+
+    debug(4) << "Predicated scatter\n\t" << Stmt(op) << "\n";
+    Value *vpred = codegen(op->predicate);
+    Value *val = codegen(op->value);
+    Value *ptrs = codegen_buffer_pointers(op->name, op->value.type(), op->index);
+    Instruction *store = builder->CreateMaskedScatter(val, ptrs, op->value.type().bytes(), vpred);
+    add_tbaa_metadata(store, op->name, op->index);
+}
+
+bool CodeGen_X86::use_dense_strided_load(Type t, int stride) const {
+    // Whether loading the whole span of a stride-3 or stride-4 load
+    // and shuffling out the lanes beats a gather of scalar loads. Byte
+    // deinterleaves are always cheap enough with pshufb. Wider types
+    // need the cross-lane shuffles of AVX2 or AVX-512.
+    if (t.bits() == 8) {
+        return true;
+    }
+    if (target.features_any_of({Target::AVX512, Target::AVX512_KNL,
+                                Target::AVX512_Skylake, Target::AVX512_Cannonlake})) {
+        return true;
+    }
+    return stride == 3 && target.has_feature(Target::AVX2);
+}
+
+void CodeGen_X86::visit(const Load *op) {
+    const Ramp *ramp = op->index.as<Ramp>();
+    const IntImm *stride = ramp ? ramp->stride.as<IntImm>() : nullptr;
+    if (!stride || (stride->value != 3 && stride->value != 4) ||
+        !is_one(op->predicate) || op->type.is_handle() ||
+        !use_dense_strided_load(op->type, stride->value)) {
+        CodeGen_Posix::visit(op);
+        return;
+    }
+
+    // Load the span of the strided load as a series of dense native
+    // vectors and shuffle out the lanes we want. The last vector is
+    // backed up so that it ends on the last lane, so this never reads
+    // anything the strided load wouldn't have.
+    const int s = stride->value;
+    const int span = (ramp->lanes - 1) * s + 1;
+    const int slice_lanes = std::min(native_vector_bits() / op->type.bits(), span);
+    vector<Value *> slices;
+    vector<int> starts;
+    for (int i = 0; i < span; i += slice_lanes) {
+        int start = std::min(i, span - slice_lanes);
+        Expr slice_base = simplify(ramp->base + start);
+        Expr slice_index = Ramp::make(slice_base, make_one(slice_base.type()), slice_lanes);
+        Expr slice = Load::make(op->type.with_lanes(slice_lanes), op->name, slice_index,
+                                op->image, op->param, const_true(slice_lanes),
+                                op->alignment + start);
+        slices.push_back(codegen(slice));
+        starts.push_back(start);
+    }
+
+    vector<int> indices(ramp->lanes);
+    for (int i = 0; i < ramp->lanes; i++) {
+        int offset = i * s;
+        int j = std::min(offset / slice_lanes, (int)starts.size() - 1);
+        indices[i] = j * slice_lanes + offset - starts[j];
+    }
+    value = shuffle_vectors(concat_vectors(slices), indices);
+}
+
+Value *CodeGen_X86::interleave_vectors(const vector<Value *> &vecs) {
+    // LLVM recognizes a store of a single shuffle that interleaves
+    // three or four byte vectors, and lowers it to pshufb/palignr or
+    // unpack sequences that are much shorter than what it makes of
+    // the nested shuffles the generic version produces. This only
+    // pays off with AVX2. With AVX-512 VBMI the nested shuffles
+    // become vpermt2b, which is better still.
+    llvm::Type *t = vecs[0]->getType();
+    if ((vecs.size() != 3 && vecs.size() != 4) ||
+        !t->getScalarType()->isIntegerTy(8) ||
+        !target.has_feature(Target::AVX2) ||
+        target.has_feature(Target::AVX512_Cannonlake)) {
+        return CodeGen_Posix::interleave_vectors(vecs);
+    }
+
+    const int n = t->getVectorNumElements();
+    const int f = (int)vecs.size();
+    vector<Value *> padded = vecs;
+    if (f == 3) {
+        padded.push_back(UndefValue::get(t));
+    }
+    Value *ab = concat_vectors({padded[0], padded[1]});
+    Value *cd = concat_vectors({padded[2], padded[3]});
+    vector<int> indices(n * f);
+    for (int i = 0; i < n * f; i++) {
+        indices[i] = (i % f) * n + i / f;
+    }
+    return shuffle_vectors(ab, cd, indices);
+}
+
 string CodeGen_X86::mcpu() const {
+#if LLVM_VERSION >= 120
+    if (target.has_feature(Target::AVX512_SapphireRapids)) return "sapphirerapids";
+#endif
+#if LLVM_VERSION >= 80
+    if (target.has_feature(Target::AVX512_VNNI) &&
+        !target.has_feature(Target::AVX512_Cannonlake)) return "cascadelake";
+#endif
     if (target.has_feature(Target::AVX512_Cannonlake)) return "cannonlake";
     if (target.has_feature(Target::AVX512_Skylake)) return "skylake-avx512";
     if (target.has_feature(Target::AVX512_KNL)) return "knl";
@@ -470,6 +875,17 @@ string CodeGen_X86::mattrs() const {
         if (target.has_feature(Target::AVX512_Cannonlake)) {
             features += ",+avx512ifma,+avx512vbmi";
         }
+        if (target.has_feature(Target::AVX512_VNNI)) {
+            features += ",+avx512vnni";
+        }
+        if (target.has_feature(Target::AVX512_BF16)) {
+            features += ",+avx512bf16";
+        }
+#if LLVM_VERSION >= 120
+        if (target.has_feature(Target::AVX512_SapphireRapids)) {
+            features += ",+amx-int8,+amx-bf16,+amx-tile";
+        }
+#endif
     }
     return features;
 }
@@ -45,7 +45,42 @@ protected:
     void visit(const EQ *) override;
     void visit(const NE *) override;
     void visit(const Select *) override;
+    void visit(const VectorReduce *) override;
     // @}
+
+    /** With AVX-512, predicated loads and stores that aren't dense use
+     * masked gathers and scatters, instead of being scalarized. */
+    // @{
+    void codegen_predicated_vector_load(const Load *op) override;
+    void codegen_predicated_vector_store(const Store *op) override;
+    // @}
+
+    /** Can a predicated gather or scatter of this type use the
+     * AVX-512 mask registers. */
+    bool use_masked_gather_scatter(Type t) const;
+
+    /** Get a vector of pointers to the elements of a buffer at a
+     * vector of indices. */
+    llvm::Value *codegen_buffer_pointers(const std::string &buffer, Type t, Expr index);
+
+    /** Stride-3 and stride-4 loads are done as dense loads and a
+     * shuffle where that beats scalarizing them, which turns
+     * deinterleaving loads of packed RGB and RGBA data into byte
+     * shuffles. */
+    void visit(const Load *) override;
+    bool use_dense_strided_load(Type t, int stride) const;
+
+    /** Interleave three or four byte vectors with a single shuffle
+     * where LLVM can lower that well. */
+    llvm::Value *interleave_vectors(const std::vector<llvm::Value *> &) override;
+
+    /** Generate code for the tile_zero, tile_load, tile_matmul, and
+     * tile_store intrinsics injected by extract_tile_operations. Tiles
+     * are passed around as 1KB vectors, and cast to and from LLVM's
+     * x86_amx type around each AMX instruction. LLVM configures the
+     * tile registers (ldtilecfg) in the prologue of any function that
+     * uses them. */
+    llvm::Value *codegen_tile_op(const Call *op);
 };
 
 }  // namespace Internal
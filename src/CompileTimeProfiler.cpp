@@ -0,0 +1,202 @@
+#include "CompileTimeProfiler.h"
+#include "Debug.h"
+#include "IRVisitor.h"
+#include "Util.h"
+
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+struct PassRecord {
+    string name;
+    double ms;
+    uint64_t peak_memory;
+    size_t ir_nodes;
+};
+
+// All the passes recorded so far, grouped by pipeline. The report is
+// written when this is destroyed at process exit.
+class CompileProfile {
+    std::mutex mutex;
+    string filename;
+    // Pipelines in the order they were first seen.
+    vector<string> pipelines;
+    std::map<string, vector<PassRecord>> passes;
+
+    void write_table(std::ostream &out) {
+        for (const string &p : pipelines) {
+            out << "Pipeline " << p << ":\n"
+                << "  " << std::left << std::setw(48) << "pass"
+                << std::right << std::setw(12) << "time (ms)"
+                << std::setw(16) << "peak mem (MB)"
+                << std::setw(12) << "IR nodes" << "\n";
+            double total = 0;
+            for (const PassRecord &r : passes[p]) {
+                out << "  " << std::left << std::setw(48) << r.name
+                    << std::right << std::setw(12) << std::fixed << std::setprecision(3) << r.ms
+                    << std::setw(16) << std::setprecision(1) << r.peak_memory / (1024.0 * 1024.0)
+                    << std::setw(12);
+                if (r.ir_nodes) {
+                    out << r.ir_nodes;
+                } else {
+                    out << "-";
+                }
+                out << "\n";
+                total += r.ms;
+            }
+            out << "  " << std::left << std::setw(48) << "total"
+                << std::right << std::setw(12) << std::setprecision(3) << total << "\n\n";
+        }
+    }
+
+    void write_json(std::ostream &out) {
+        out << "{\n";
+        for (size_t i = 0; i < pipelines.size(); i++) {
+            const string &p = pipelines[i];
+            out << "  \"" << p << "\": [\n";
+            const vector<PassRecord> &records = passes[p];
+            for (size_t j = 0; j < records.size(); j++) {
+                const PassRecord &r = records[j];
+                out << "    {\"pass\": \"" << r.name << "\", "
+                    << "\"time_ms\": " << r.ms << ", "
+                    << "\"peak_memory_bytes\": " << r.peak_memory << ", "
+                    << "\"ir_nodes\": " << r.ir_nodes << "}"
+                    << (j + 1 < records.size() ? ",\n" : "\n");
+            }
+            out << "  ]" << (i + 1 < pipelines.size() ? ",\n" : "\n");
+        }
+        out << "}\n";
+    }
+
+public:
+    CompileProfile() : filename(get_env_variable("HL_COMPILE_PROFILE")) {}
+
+    ~CompileProfile() {
+        if (pipelines.empty()) {
+            return;
+        }
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            debug(0) << "Could not open " << filename << " to write the compile profile\n";
+            return;
+        }
+        if (ends_with(filename, ".json")) {
+            write_json(out);
+        } else {
+            write_table(out);
+        }
+    }
+
+    bool enabled() const {
+        return !filename.empty();
+    }
+
+    void record(const string &pipeline, const PassRecord &r) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = passes.find(pipeline);
+        if (it == passes.end()) {
+            pipelines.push_back(pipeline);
+            it = passes.emplace(pipeline, vector<PassRecord>()).first;
+        }
+        it->second.push_back(r);
+    }
+};
+
+CompileProfile &compile_profile() {
+    static CompileProfile profile;
+    return profile;
+}
+
+// The high-water mark of this process's resident memory, in bytes.
+uint64_t peak_memory_use() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    // Linux reports this in kilobytes.
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// Counts distinct IR nodes, treating the IR as a DAG.
+class CountIRNodes : public IRGraphVisitor {
+    std::set<const IRNode *> seen;
+
+    using IRGraphVisitor::visit;
+
+    void include(const Expr &e) override {
+        if (seen.insert(e.get()).second) {
+            e.accept(this);
+        }
+    }
+
+    void include(const Stmt &s) override {
+        if (seen.insert(s.get()).second) {
+            s.accept(this);
+        }
+    }
+
+public:
+    size_t count(const Stmt &s) {
+        include(s);
+        return seen.size();
+    }
+};
+
+}  // namespace
+
+bool CompileTimeProfiler::enabled() {
+    return compile_profile().enabled();
+}
+
+CompileTimeProfiler::CompileTimeProfiler(const string &pipeline_name) :
+    pipeline_name(pipeline_name), start(std::chrono::high_resolution_clock::now()) {}
+
+void CompileTimeProfiler::pass_done(const string &pass_name, const Stmt &s) {
+    if (!enabled()) {
+        return;
+    }
+    auto now = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = now - start;
+
+    size_t ir_nodes = 0;
+    if (s.defined()) {
+        ir_nodes = CountIRNodes().count(s);
+    }
+    compile_profile().record(pipeline_name, {pass_name, elapsed.count(), peak_memory_use(), ir_nodes});
+
+    // Don't charge the cost of counting the IR to the next pass.
+    start = std::chrono::high_resolution_clock::now();
+}
+
+ScopedCompileTimer::ScopedCompileTimer(const string &pipeline_name, const string &pass_name) :
+    profiler(pipeline_name), pass_name(pass_name) {}
+
+ScopedCompileTimer::~ScopedCompileTimer() {
+    profiler.pass_done(pass_name);
+}
+
+}  // namespace Internal
+}  // namespace Halide
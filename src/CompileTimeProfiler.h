@@ -0,0 +1,62 @@
+#ifndef HALIDE_COMPILE_TIME_PROFILER_H
+#define HALIDE_COMPILE_TIME_PROFILER_H
+
+/** \file
+ * Tools for measuring how long each pass of lowering and code
+ * generation takes.
+ */
+
+#include <chrono>
+#include <string>
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Records the wall time, the process's peak memory use, and the size
+ * of the IR after each pass of compilation. Profiling is enabled by
+ * setting the environment variable HL_COMPILE_PROFILE to the name of a
+ * file. When the process exits, a report of all the passes run for
+ * each pipeline is written to that file, as a table, or as JSON if the
+ * file name ends in ".json". When profiling is disabled all methods
+ * are no-ops. */
+class CompileTimeProfiler {
+    std::string pipeline_name;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start;
+
+public:
+    /** Is HL_COMPILE_PROFILE set? */
+    static bool enabled();
+
+    /** Start timing the first pass of the named pipeline. */
+    explicit CompileTimeProfiler(const std::string &pipeline_name);
+
+    /** Record that the named pass has just finished, and start timing
+     * the next one. If s is defined, the number of distinct IR nodes
+     * in it is recorded too. */
+    void pass_done(const std::string &pass_name, const Stmt &s = Stmt());
+};
+
+/** Times a single pass that lasts for the lifetime of this object,
+ * e.g. LLVM optimization of a module:
+ \code
+ {
+     ScopedCompileTimer timer(module_name, "LLVM optimization");
+     ...
+ }
+ \endcode
+ */
+class ScopedCompileTimer {
+    CompileTimeProfiler profiler;
+    std::string pass_name;
+
+public:
+    ScopedCompileTimer(const std::string &pipeline_name, const std::string &pass_name);
+    ~ScopedCompileTimer();
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -301,6 +301,20 @@ private:
         }
     }
 
+    Expr visit(const VectorReduce *op) override {
+        // Each lane of the result is the reduction of a group of
+        // adjacent lanes of the value, so pick out the groups for the
+        // lanes we want and reduce those.
+        const int factor = op->value.type().lanes() / op->type.lanes();
+        std::vector<int> indices;
+        for (int i = 0; i < new_lanes; i++) {
+            for (int j = 0; j < factor; j++) {
+                indices.push_back((starting_lane + lane_stride * i) * factor + j);
+            }
+        }
+        return VectorReduce::make(op->op, Shuffle::make({op->value}, indices), new_lanes);
+    }
+
     Expr visit(const Shuffle *op) override {
         if (op->is_interleave()) {
             internal_assert(starting_lane >= 0 && starting_lane < lane_stride);
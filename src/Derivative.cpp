@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <set>
@@ -122,6 +123,9 @@ protected:
     void visit(const Shuffle *op) override {
         internal_assert(false) << "Encounter unexpected statement \"Shuffle\" when differentiating.";
     }
+    void visit(const VectorReduce *op) override {
+        internal_assert(false) << "Encounter unexpected expression \"VectorReduce\" when differentiating.";
+    }
     void visit(const Prefetch *op) override {
         internal_assert(false) << "Encounter unexpected statement \"Prefetch\" when differentiating.";
     }
@@ -131,6 +135,9 @@ protected:
     void visit(const Acquire *op) override {
         internal_assert(false) << "Encounter unexpected statement \"Acquire\" when differentiating.";
     }
+    void visit(const Atomic *op) override {
+        internal_assert(false) << "Encounter unexpected statement \"Atomic\" when differentiating.";
+    }
 
 private:
     void accumulate(const Expr &stub, Expr adjoint);
@@ -1920,4 +1927,101 @@ Derivative propagate_adjoints(const Func &output) {
     return propagate_adjoints(output, adjoint, output_bounds);
 }
 
+namespace {
+
+bool can_recompute(const Func &f) {
+    return !f.has_update_definition() && !f.is_extern();
+}
+
+}  // namespace
+
+void schedule_checkpoints(const Func &output, const vector<Func> &stored) {
+    map<string, Internal::Function> env = find_transitive_calls(output.function());
+    set<string> stored_names;
+    for (const Func &f : stored) {
+        user_assert(env.count(f.name()))
+            << "Can't store " << f.name() << " for the adjoints of " << output.name()
+            << ", because " << output.name() << " doesn't depend on it\n";
+        stored_names.insert(f.name());
+    }
+    for (const auto &it : env) {
+        Func f(it.second);
+        if (stored_names.count(f.name()) || !can_recompute(f)) {
+            f.compute_root();
+        } else {
+            f.compute_inline();
+        }
+    }
+}
+
+vector<Func> schedule_checkpoints(const Func &output) {
+    map<string, Internal::Function> env = find_transitive_calls(output.function());
+    vector<string> order = Internal::realization_order({ output.function() }, env).first;
+
+    int num_recomputable = 0;
+    for (const auto &name : order) {
+        num_recomputable += can_recompute(Func(env[name])) ? 1 : 0;
+    }
+    const int stride = std::max(1, (int) std::lround(std::sqrt((double) num_recomputable)));
+
+    // Store every stride'th Func since the last one stored. Funcs
+    // that can't be recomputed are stored anyway, so they start a
+    // new run.
+    vector<Func> stored;
+    int run = 0;
+    for (const auto &name : order) {
+        Func f(env[name]);
+        if (!can_recompute(f)) {
+            run = 0;
+        } else if (++run == stride) {
+            stored.push_back(f);
+            run = 0;
+        }
+    }
+    schedule_checkpoints(output, stored);
+    return stored;
+}
+
+void parallelize_scatters(const Derivative &d) {
+    set<string> done;
+    for (const auto &it : d.adjoints) {
+        Func f = it.second;
+        if (!done.insert(f.name()).second || f.outputs() != 1) {
+            continue;
+        }
+        for (int update_id = 0; update_id < f.num_update_definitions(); update_id++) {
+            const Internal::StageSchedule &schedule = f.function().update(update_id).schedule();
+            // The last dim is the outermost placeholder.
+            const vector<Internal::Dim> &dims = schedule.dims();
+            if (schedule.rvars().empty() || dims.size() < 2) {
+                continue;
+            }
+            const Internal::Dim &outer = dims[dims.size() - 2];
+            if (outer.is_pure()) {
+                f.update(update_id).parallel(VarOrRVar(outer.var, outer.is_rvar()));
+                continue;
+            }
+            // Only accumulations into the Func can be made atomic.
+            const vector<Expr> &args = f.update_args(update_id);
+            auto is_self_reference = [&](const Expr &e) {
+                const Internal::Call *call = e.as<Internal::Call>();
+                if (!call || call->call_type != Internal::Call::Halide ||
+                    call->name != f.name() || call->args.size() != args.size()) {
+                    return false;
+                }
+                for (size_t i = 0; i < args.size(); i++) {
+                    if (!equal(call->args[i], args[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            const Internal::Add *add = f.update_value(update_id).as<Internal::Add>();
+            if (add && (is_self_reference(add->a) || is_self_reference(add->b))) {
+                f.update(update_id).atomic().parallel(RVar(outer.var));
+            }
+        }
+    }
+}
+
 }  // namespace Halide
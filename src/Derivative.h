@@ -96,6 +96,42 @@ Derivative propagate_adjoints(const Func &output,
  */
 Derivative propagate_adjoints(const Func &output);
 
+/**
+ *  Schedule the Funcs that output depends on for computing its
+ *  adjoints, trading memory for recomputation. The Funcs in 'stored'
+ *  are computed at root, so their values are kept in memory for the
+ *  adjoint Funcs that use them. All other Funcs are inlined, so they
+ *  are recomputed from the nearest stored Funcs wherever the adjoints
+ *  need them. Funcs that can't be inlined (those with update
+ *  definitions, and extern Funcs) are always computed at root.
+ *  The schedules set here can be refined afterwards, e.g. by computing
+ *  a recomputed Func at a tile of the adjoint that consumes it.
+ */
+void schedule_checkpoints(const Func &output, const std::vector<Func> &stored);
+
+/**
+ *  Schedule the Funcs that output depends on for computing its
+ *  adjoints as above, storing about sqrt(N) of the N Funcs that could
+ *  be inlined, evenly spaced in realization order. This bounds both
+ *  the number of Funcs kept in memory and the length of the chains of
+ *  Funcs that are recomputed by about sqrt(N). Returns the Funcs
+ *  chosen to be stored.
+ */
+std::vector<Func> schedule_checkpoints(const Func &output);
+
+/**
+ *  Parallelize the update definitions of the adjoint Funcs that loop
+ *  over RVars. Gathers in the forward pass (e.g. f(x) = g(h(x))) become
+ *  scatters in the adjoints (d_g(h(r.x)) += d_f(r.x)), which can't run
+ *  in parallel as-is. Each such update is parallelized over its
+ *  outermost loop: directly if that loop can't race, and otherwise
+ *  after making the update atomic (see \ref Stage::atomic), which
+ *  requires a backend that supports atomics. Updates that overwrite
+ *  values instead of accumulating them, and Tuple-valued Funcs, are
+ *  left serial.
+ */
+void parallelize_scatters(const Derivative &d);
+
 }  // namespace Halide
 
 #endif
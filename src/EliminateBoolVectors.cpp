@@ -271,6 +271,25 @@ private:
         return expr;
     }
 
+    Expr visit(const VectorReduce *op) override {
+        Expr value = mutate(op->value);
+        if (op->type.is_bool() && op->value.type().is_vector()) {
+            // The value is now an integer mask, which is all ones in
+            // the true lanes. The bitwise reduction of masks is the
+            // mask of the logical reduction.
+            internal_assert(op->op == VectorReduce::And || op->op == VectorReduce::Or);
+            Expr expr = VectorReduce::make(op->op, value, op->type.lanes());
+            if (op->type.is_scalar()) {
+                expr = expr != make_zero(expr.type());
+            }
+            return expr;
+        } else if (!value.same_as(op->value)) {
+            return VectorReduce::make(op->op, value, op->type.lanes());
+        } else {
+            return op;
+        }
+    }
+
     template <typename NodeType, typename LetType>
     NodeType visit_let(const LetType *op) {
         Expr value = mutate(op->value);
@@ -0,0 +1,160 @@
+#include "EmulateFloat16Math.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+
+namespace Halide {
+namespace Internal {
+
+Expr bfloat16_to_float32(Expr e) {
+    internal_assert(e.type().is_bfloat() && e.type().bits() == 16);
+    const int lanes = e.type().lanes();
+    // A bfloat16 is the top half of a float32.
+    Expr bits = cast(UInt(32, lanes), reinterpret(UInt(16, lanes), std::move(e)));
+    return reinterpret(Float(32, lanes), bits << 16);
+}
+
+Expr float32_to_bfloat16(Expr e) {
+    internal_assert(e.type().element_of() == Float(32));
+    const int lanes = e.type().lanes();
+    const Type u32 = UInt(32, lanes);
+    std::string name = unique_name('b');
+    Expr bits = Variable::make(u32, name);
+    // Round to nearest with ties going to even. Values past the
+    // largest finite bfloat16 carry into the exponent and become
+    // infinity.
+    Expr rounded = bits + (make_const(u32, 0x7fff) + ((bits >> 16) & make_const(u32, 1)));
+    // NaNs must keep a non-zero mantissa after truncation.
+    Expr nan = (bits & make_const(u32, 0x7fffffff)) > make_const(u32, 0x7f800000);
+    Expr result = select(nan, (bits >> 16) | make_const(u32, 0x0040), rounded >> 16);
+    result = reinterpret(BFloat(16, lanes), cast(UInt(16, lanes), result));
+    return Let::make(name, reinterpret(u32, std::move(e)), result);
+}
+
+bool target_has_native_float16_math(const Target &t) {
+    return ((t.arch == Target::ARM && t.bits == 64 && t.has_feature(Target::ARMFp16)) ||
+            t.arch == Target::Hexagon);
+}
+
+namespace {
+
+class EmulateFloat16Math : public IRMutator {
+    using IRMutator::visit;
+
+    // Whether to widen float16 math in the current context, as
+    // opposed to only bfloat16 math.
+    bool widen_float16;
+
+    bool needs_widening(const Type &t) const {
+        return t.is_bfloat() || (widen_float16 && t.element_of() == Float(16));
+    }
+
+    Expr widen(const Expr &e) {
+        Expr m = mutate(e);
+        if (e.type().is_bfloat()) {
+            return bfloat16_to_float32(m);
+        } else if (needs_widening(e.type())) {
+            return Cast::make(Float(32, e.type().lanes()), m);
+        } else {
+            return m;
+        }
+    }
+
+    Expr narrow(const Expr &e, const Type &t) {
+        if (t.is_bfloat()) {
+            return float32_to_bfloat16(e);
+        } else if (needs_widening(t)) {
+            return Cast::make(t, e);
+        } else {
+            return e;
+        }
+    }
+
+    template<typename T>
+    Expr visit_bin_op(const T *op) {
+        if (!needs_widening(op->a.type())) {
+            return IRMutator::visit(op);
+        }
+        return narrow(T::make(widen(op->a), widen(op->b)), op->type);
+    }
+
+    Expr visit(const Add *op) override { return visit_bin_op(op); }
+    Expr visit(const Sub *op) override { return visit_bin_op(op); }
+    Expr visit(const Mul *op) override { return visit_bin_op(op); }
+    Expr visit(const Div *op) override { return visit_bin_op(op); }
+    Expr visit(const Mod *op) override { return visit_bin_op(op); }
+    Expr visit(const Min *op) override { return visit_bin_op(op); }
+    Expr visit(const Max *op) override { return visit_bin_op(op); }
+    Expr visit(const EQ *op) override { return visit_bin_op(op); }
+    Expr visit(const NE *op) override { return visit_bin_op(op); }
+    Expr visit(const LT *op) override { return visit_bin_op(op); }
+    Expr visit(const LE *op) override { return visit_bin_op(op); }
+    Expr visit(const GT *op) override { return visit_bin_op(op); }
+    Expr visit(const GE *op) override { return visit_bin_op(op); }
+
+    Expr visit(const Cast *op) override {
+        // Conversions to and from float16 are native everywhere, so
+        // only conversions involving bfloat16 need rewriting.
+        const Type f32 = Float(32, op->type.lanes());
+        if (op->type.is_bfloat()) {
+            Expr value = widen(op->value);
+            if (value.type() != f32) {
+                value = Cast::make(f32, value);
+            }
+            return float32_to_bfloat16(value);
+        } else if (op->value.type().is_bfloat()) {
+            Expr value = widen(op->value);
+            if (op->type == f32) {
+                return value;
+            }
+            return Cast::make(op->type, value);
+        } else {
+            return IRMutator::visit(op);
+        }
+    }
+
+    Expr visit(const FloatImm *op) override {
+        if (op->type.is_bfloat()) {
+            uint16_t bits = bfloat16_t(op->value).to_bits();
+            return reinterpret(op->type, make_const(UInt(16), bits));
+        } else {
+            return op;
+        }
+    }
+
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::abs) && op->type.is_bfloat()) {
+            // Clear the sign bit.
+            const Type u16 = UInt(16, op->type.lanes());
+            Expr bits = reinterpret(u16, mutate(op->args[0]));
+            return reinterpret(op->type, bits & make_const(u16, 0x7fff));
+        } else if (op->is_intrinsic(Call::lerp) && needs_widening(op->type)) {
+            Expr result = Call::make(Float(32, op->type.lanes()), Call::lerp,
+                                     {widen(op->args[0]), widen(op->args[1]), widen(op->args[2])},
+                                     Call::PureIntrinsic);
+            return narrow(result, op->type);
+        } else {
+            return IRMutator::visit(op);
+        }
+    }
+
+    Stmt visit(const For *op) override {
+        // Device code is compiled for a different target, which
+        // decides for itself how to do float16 math.
+        bool is_device = (op->device_api != DeviceAPI::None &&
+                          op->device_api != DeviceAPI::Host);
+        ScopedValue<bool> old(widen_float16, widen_float16 && !is_device);
+        return IRMutator::visit(op);
+    }
+
+public:
+    EmulateFloat16Math(bool widen_float16) : widen_float16(widen_float16) {}
+};
+
+}  // namespace
+
+Stmt emulate_float16_math(const Stmt &s, const Target &t) {
+    return EmulateFloat16Math(!target_has_native_float16_math(t)).mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
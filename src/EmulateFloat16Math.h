@@ -0,0 +1,39 @@
+#ifndef HALIDE_EMULATE_FLOAT16_MATH_H
+#define HALIDE_EMULATE_FLOAT16_MATH_H
+
+/** \file
+ * Defines the lowering pass that emulates arithmetic on 16-bit
+ * floating point values using float32.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Convert a bfloat16 Expr to the float32 with the same value. */
+Expr bfloat16_to_float32(Expr e);
+
+/** Convert a float32 Expr to bfloat16, rounding to nearest with ties
+ * going to even. */
+Expr float32_to_bfloat16(Expr e);
+
+/** Whether the target does float16 arithmetic natively, as opposed to
+ * widening to float32 for each operation. */
+bool target_has_native_float16_math(const Target &t);
+
+/** Rewrite all arithmetic, comparisons, and conversions involving
+ * bfloat16 values into float32 math and integer bit manipulation, so
+ * that the backends only ever load, store, and shuffle the raw bits
+ * of a bfloat16. On targets without native float16 arithmetic, also
+ * widen float16 arithmetic on the host to float32 explicitly, so that
+ * it vectorizes with the target's conversion instructions. Each
+ * operation is rounded back to 16 bits, so the results are the same
+ * as native math. */
+Stmt emulate_float16_math(const Stmt &s, const Target &t);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -53,6 +53,7 @@ enum class IRNodeType {
     Call,
     Let,
     Shuffle,
+    VectorReduce,
     // Stmts
     LetStmt,
     AssertStmt,
@@ -69,6 +70,7 @@ enum class IRNodeType {
     IfThenElse,
     Evaluate,
     Prefetch,
+    Atomic,
 };
 
 /** The abstract base classes for a node in the Halide IR. */
@@ -82,6 +84,13 @@ struct IRNode {
     IRNode(IRNodeType t) : node_type(t) {}
     virtual ~IRNode() {}
 
+    /** IR nodes are allocated through IRArena, so that lowering can
+     * optionally allocate them in bulk. See IRArena.h. */
+    // @{
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+    // @}
+
     /** These classes are all managed with intrusive reference
      * counting, so we also track a reference count. It's mutable
      * so that we can do reference counting even through const
@@ -250,7 +259,11 @@ struct FloatImm : public ExprNode<FloatImm> {
         node->type = t;
         switch (t.bits()) {
         case 16:
-            node->value = (double)((float16_t)value);
+            if (t.is_bfloat()) {
+                node->value = (double)((bfloat16_t)value);
+            } else {
+                node->value = (double)((float16_t)value);
+            }
             break;
         case 32:
             node->value = (float)value;
@@ -307,6 +320,7 @@ struct Expr : public Internal::IRHandle {
     explicit Expr(uint32_t x)  : IRHandle(Internal::UIntImm::make(UInt(32), x)) {}
     explicit Expr(uint64_t x)  : IRHandle(Internal::UIntImm::make(UInt(64), x)) {}
              Expr(float16_t x) : IRHandle(Internal::FloatImm::make(Float(16), (double)x)) {}
+             Expr(bfloat16_t x) : IRHandle(Internal::FloatImm::make(BFloat(16), (double)x)) {}
              Expr(float x)     : IRHandle(Internal::FloatImm::make(Float(32), x)) {}
     explicit Expr(double x)    : IRHandle(Internal::FloatImm::make(Float(64), x)) {}
     // @}
@@ -349,6 +363,8 @@ enum class DeviceAPI {
     Hexagon,
     HexagonDma,
     D3D12Compute,
+    Vulkan,
+    WebGPU,
 };
 
 /** An array containing all the device apis. Useful for iterating
@@ -363,7 +379,9 @@ const DeviceAPI all_device_apis[] = {DeviceAPI::None,
                                      DeviceAPI::Metal,
                                      DeviceAPI::Hexagon,
                                      DeviceAPI::HexagonDma,
-                                     DeviceAPI::D3D12Compute};
+                                     DeviceAPI::D3D12Compute,
+                                     DeviceAPI::Vulkan,
+                                     DeviceAPI::WebGPU};
 
 /** An enum describing different address spaces to be used with Func::store_in. */
 enum class MemoryType {
@@ -398,6 +416,16 @@ enum class MemoryType {
      * intermediate buffers. Necessary for vgather-vscatter instructions
      * on Hexagon */
     VTCM,
+
+    /** An AMX tile register on x86 (Sapphire Rapids and later). The
+     * Func must be an int32 or float32 tile of at most 16 rows of 16
+     * elements, initialized to zero, updated with a multiply-add of
+     * 8-bit or bfloat16 inputs, and stored unchanged into its
+     * consumer. Falls back to the stack if the accesses don't have
+     * that shape. Requires the avx512_sapphirerapids target feature,
+     * which is only supported when Halide is built with LLVM 13 or
+     * later. See ExtractTileOperations.h */
+    AMXTile,
 };
 
 namespace Internal {
@@ -0,0 +1,474 @@
+#include "ExtractTileOperations.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "InjectHostDevBufferCopies.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+// The AMX instructions operate on tile registers of up to 16 rows of
+// 64 bytes. A Func stored in MemoryType::AMXTile is an accumulator
+// tile, and we look for the three loop nests that touch it:
+//
+//   mm(x, y) = 0                                 -> tile_zero
+//   mm(x, y) += i32(A(k, y)) * i32(B(k%4, x, k/4)) -> tile_load x2, tile_matmul
+//   out(x, y) = mm(x, y)                         -> tile_store
+//
+// After storage flattening these are perfect loop nests around a
+// single Store, and we recognize the role of each loop by the stride
+// of the flattened indices with respect to it. The reduction may be
+// a single loop over k, or already split into a loop over groups of
+// four bytes and a loop within each group. The accumulator itself
+// becomes a single 1KB vector, which LLVM keeps in a tile register
+// and spills to the allocation when it has to.
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const int max_tile_rows = 16;
+const int max_tile_row_bytes = 64;
+const int tile_bytes = max_tile_rows * max_tile_row_bytes;
+
+struct TileLoop {
+    string name;
+    Expr min, extent;
+    ForType for_type;
+    DeviceAPI device_api;
+    int const_extent;
+};
+
+// The stride of an index with respect to one loop of a nest, or an
+// undefined Expr if the index isn't linear in the loops of the nest.
+Expr stride_of(const Expr &index, const string &var, const vector<TileLoop> &loops) {
+    Expr v = Variable::make(Int(32), var);
+    Expr stride = simplify(substitute(var, v + 1, index) - index);
+    for (const TileLoop &l : loops) {
+        if (expr_uses_var(stride, l.name)) {
+            return Expr();
+        }
+    }
+    return stride;
+}
+
+// The index at the first iteration of a loop nest.
+Expr base_of(Expr index, const vector<TileLoop> &loops) {
+    for (const TileLoop &l : loops) {
+        index = substitute(l.name, l.min, index);
+    }
+    return simplify(index);
+}
+
+class UsesBuffer : public IRVisitor {
+    using IRVisitor::visit;
+
+    const string &name;
+
+    void visit(const Load *op) override {
+        result = result || op->name == name;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) override {
+        result = result || op->name == name;
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result = false;
+    UsesBuffer(const string &name) : name(name) {}
+};
+
+bool uses_buffer(const Stmt &s, const string &name) {
+    UsesBuffer u(name);
+    s.accept(&u);
+    return u.result;
+}
+
+class ExtractTileOperations : public IRMutator {
+    using IRMutator::visit;
+
+    // The enclosing lets, outermost first.
+    vector<std::pair<string, Expr>> lets;
+
+    // The AMXTile allocation we're currently rewriting, and the shape
+    // the nests that touch it agree on.
+    string tile;
+    Type tile_type;
+    int rows = 0, cols = 0;
+    Expr row_stride;
+    bool found_update = false, found_store = false, failed = false;
+
+    Expr resolve(Expr e) const {
+        for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+            e = substitute(it->first, it->second, e);
+        }
+        return simplify(e);
+    }
+
+    Expr whole_tile() const {
+        return Ramp::make(0, 1, tile_bytes / tile_type.bytes());
+    }
+
+    Expr load_tile() const {
+        const int lanes = tile_bytes / tile_type.bytes();
+        return Load::make(tile_type.with_lanes(lanes), tile, whole_tile(),
+                          Buffer<>(), Parameter(), const_true(lanes), ModulusRemainder());
+    }
+
+    Stmt store_tile(Expr value) const {
+        const int lanes = tile_bytes / tile_type.bytes();
+        return Store::make(tile, value, whole_tile(), Parameter(), const_true(lanes), ModulusRemainder());
+    }
+
+    // Work out which of the loops walk the columns and rows of the
+    // tile from its index, and check they agree with the other nests.
+    bool get_tile_shape(const Expr &index, const vector<TileLoop> &loops,
+                        const TileLoop *&x, const TileLoop *&y,
+                        vector<const TileLoop *> &reductions) {
+        x = y = nullptr;
+        Expr y_stride;
+        for (const TileLoop &l : loops) {
+            Expr stride = stride_of(index, l.name, loops);
+            if (!stride.defined()) {
+                return false;
+            } else if (is_zero(stride)) {
+                reductions.push_back(&l);
+            } else if (is_one(stride) && !x) {
+                x = &l;
+            } else if (as_const_int(stride) && !y) {
+                y = &l;
+                y_stride = stride;
+            } else {
+                return false;
+            }
+        }
+        if (!x || !y ||
+            x->const_extent > max_tile_row_bytes / 4 ||
+            y->const_extent > max_tile_rows ||
+            !can_prove(resolve(base_of(index, loops)) == 0)) {
+            return false;
+        }
+        if (!row_stride.defined()) {
+            rows = y->const_extent;
+            cols = x->const_extent;
+            row_stride = y_stride;
+        }
+        return (rows == y->const_extent &&
+                cols == x->const_extent &&
+                equal(row_stride, y_stride));
+    }
+
+    Stmt match_init(const Store *op, const vector<TileLoop> &loops) {
+        const TileLoop *x, *y;
+        vector<const TileLoop *> reductions;
+        if (!is_zero(op->value) ||
+            !get_tile_shape(op->index, loops, x, y, reductions) ||
+            !reductions.empty()) {
+            return Stmt();
+        }
+        Expr zero = Call::make(tile_type.with_lanes(tile_bytes / tile_type.bytes()), "tile_zero",
+                               {rows, cols * 4}, Call::PureIntrinsic);
+        return store_tile(zero);
+    }
+
+    Stmt match_store(const Store *op, const vector<TileLoop> &loops) {
+        const Load *load = op->value.as<Load>();
+        const TileLoop *x, *y;
+        vector<const TileLoop *> reductions;
+        if (!load || load->name != tile ||
+            !is_one(op->predicate) || !is_one(load->predicate) ||
+            !get_tile_shape(load->index, loops, x, y, reductions) ||
+            !reductions.empty()) {
+            return Stmt();
+        }
+        Expr out_stride = stride_of(op->index, y->name, loops);
+        if (!is_one(stride_of(op->index, x->name, loops)) || !out_stride.defined()) {
+            return Stmt();
+        }
+        Expr out_base = base_of(op->index, loops);
+        found_store = true;
+        return Evaluate::make(Call::make(Int(32), "tile_store",
+                                         {rows, cols * 4, Variable::make(Handle(), op->name),
+                                          out_base, out_stride, load_tile()},
+                                         Call::Intrinsic));
+    }
+
+    // Match one side of the multiply-add: a widening cast of a load
+    // of 8-bit integers into int32, or of bfloat16 into float32.
+    const Load *match_operand(const Expr &e) const {
+        const Cast *cast = e.as<Cast>();
+        const Load *load = cast ? cast->value.as<Load>() : nullptr;
+        if (!load || cast->type != tile_type || !is_one(load->predicate)) {
+            return nullptr;
+        }
+        Type t = load->type;
+        if ((tile_type == Int(32) && (t == Int(8) || t == UInt(8))) ||
+            (tile_type == Float(32) && t == BFloat(16))) {
+            return load;
+        }
+        return nullptr;
+    }
+
+    Stmt match_update(const Store *op, const vector<TileLoop> &loops) {
+        const Add *add = op->value.as<Add>();
+        if (!add) {
+            return Stmt();
+        }
+        const Load *acc = add->a.as<Load>();
+        Expr prod = add->b;
+        if (!acc || acc->name != tile) {
+            acc = add->b.as<Load>();
+            prod = add->a;
+        }
+        const Mul *mul = prod.as<Mul>();
+        const TileLoop *x, *y;
+        vector<const TileLoop *> reductions;
+        if (!acc || acc->name != tile || !mul ||
+            !equal(acc->index, op->index) ||
+            !get_tile_shape(op->index, loops, x, y, reductions) ||
+            reductions.empty() || reductions.size() > 2) {
+            return Stmt();
+        }
+
+        const Load *loads[] = {match_operand(mul->a), match_operand(mul->b)};
+        if (!loads[0] || !loads[1]) {
+            return Stmt();
+        }
+
+        // The number of consecutive k values packed into 4 bytes of a
+        // row of the right-hand side.
+        const int elem_bytes = loads[0]->type.bytes();
+        const int pack = 4 / elem_bytes;
+
+        // Split the reduction into a loop over groups of k (ko) and a
+        // loop within each group (ki). If it's a single loop, do that
+        // by substituting k = min + ko * pack + ki into the indices.
+        vector<TileLoop> nest;
+        for (const TileLoop &l : loops) {
+            if (&l == reductions[0] && reductions.size() == 1 && l.const_extent > pack) {
+                if (l.const_extent % pack) {
+                    return Stmt();
+                }
+                nest.push_back({l.name + ".ko", 0, l.const_extent / pack, l.for_type, l.device_api, l.const_extent / pack});
+                nest.push_back({l.name + ".ki", 0, pack, l.for_type, l.device_api, pack});
+            } else {
+                nest.push_back(l);
+            }
+        }
+        Expr indices[] = {loads[0]->index, loads[1]->index};
+        if (nest.size() > loops.size()) {
+            const TileLoop &k = *reductions[0];
+            Expr ko = Variable::make(Int(32), k.name + ".ko");
+            Expr ki = Variable::make(Int(32), k.name + ".ki");
+            Scope<Interval> bounds;
+            bounds.push(k.name + ".ko", Interval(0, k.const_extent / pack - 1));
+            bounds.push(k.name + ".ki", Interval(0, pack - 1));
+            for (Expr &index : indices) {
+                index = simplify(substitute(k.name, k.min + ko * pack + ki, index), true, bounds);
+            }
+        }
+
+        const TileLoop *tx = nullptr, *ty = nullptr, *ko = nullptr, *ki = nullptr;
+        for (const TileLoop &l : nest) {
+            if (l.name == x->name) {
+                tx = &l;
+            } else if (l.name == y->name) {
+                ty = &l;
+            } else if (l.const_extent == pack && !ki &&
+                       (is_one(stride_of(indices[0], l.name, nest)) ||
+                        is_one(stride_of(indices[1], l.name, nest)))) {
+                ki = &l;
+            } else {
+                ko = &l;
+            }
+        }
+        if (!ki) {
+            return Stmt();
+        }
+        const int k_groups = ko ? ko->const_extent : 1;
+        const int k_bytes = k_groups * pack * elem_bytes;
+        if (k_bytes > max_tile_row_bytes || k_groups > max_tile_rows) {
+            return Stmt();
+        }
+
+        // The left-hand side is a rows x k matrix with k dense, and
+        // the right-hand side is a (k / pack) x (cols * pack) matrix
+        // with k innermost within each group.
+        for (int i = 0; i < 2; i++) {
+            const Load *lhs = loads[i], *rhs = loads[1 - i];
+            const Expr &lhs_index = indices[i], &rhs_index = indices[1 - i];
+            Expr lhs_stride = stride_of(lhs_index, ty->name, nest);
+            Expr rhs_stride = ko ? stride_of(rhs_index, ko->name, nest) : make_zero(Int(32));
+            if (!lhs_stride.defined() || !rhs_stride.defined() ||
+                !is_zero(stride_of(lhs_index, tx->name, nest)) ||
+                !is_one(stride_of(lhs_index, ki->name, nest)) ||
+                (ko && !is_const(stride_of(lhs_index, ko->name, nest), pack)) ||
+                !is_zero(stride_of(rhs_index, ty->name, nest)) ||
+                !is_one(stride_of(rhs_index, ki->name, nest)) ||
+                !is_const(stride_of(rhs_index, tx->name, nest), pack)) {
+                continue;
+            }
+            auto tile_load = [&](const Load *load, int load_rows, int load_cols, const Expr &index, const Expr &stride) {
+                return Call::make(load->type.with_lanes(tile_bytes / elem_bytes), "tile_load",
+                                  {load_rows, load_cols, Variable::make(Handle(), load->name),
+                                   base_of(index, nest), stride},
+                                  Call::Intrinsic);
+            };
+            Expr a = tile_load(lhs, rows, k_bytes, lhs_index, lhs_stride);
+            Expr b = tile_load(rhs, k_groups, cols * 4, rhs_index, rhs_stride);
+            Expr matmul = Call::make(tile_type.with_lanes(tile_bytes / tile_type.bytes()), "tile_matmul",
+                                     {rows, cols * 4, k_bytes, load_tile(), a, b},
+                                     Call::PureIntrinsic);
+            found_update = true;
+            return store_tile(matmul);
+        }
+        return Stmt();
+    }
+
+    // Try to rewrite the innermost loops of a perfect nest around a
+    // store that touches the tile. Outer loops of the nest that
+    // aren't part of the tile (e.g. a loop over chunks of k too large
+    // for one tile_matmul) are kept.
+    Stmt match_nest(const Store *op, const vector<TileLoop> &loops) {
+        const bool is_update = op->name == tile && !is_zero(op->value);
+        for (size_t n = 2; n <= std::min(loops.size(), (size_t)4); n++) {
+            vector<TileLoop> inner(loops.end() - n, loops.end());
+            bool ok = true;
+            for (TileLoop &l : inner) {
+                const int64_t *extent = as_const_int(resolve(l.extent));
+                ok = ok && extent && *extent > 0 && l.for_type != ForType::Parallel;
+                for (const TileLoop &other : inner) {
+                    ok = ok && !expr_uses_var(l.min, other.name);
+                }
+                l.const_extent = extent ? (int)*extent : 0;
+            }
+            if (!ok) {
+                continue;
+            }
+
+            Stmt s;
+            if (op->name == tile) {
+                s = is_update ? match_update(op, inner) : match_init(op, inner);
+            } else {
+                s = match_store(op, inner);
+            }
+            if (s.defined()) {
+                for (size_t i = loops.size() - n; i > 0; i--) {
+                    const TileLoop &l = loops[i - 1];
+                    s = For::make(l.name, l.min, l.extent, l.for_type, l.device_api, s);
+                }
+                return s;
+            }
+        }
+        return Stmt();
+    }
+
+    Stmt visit(const For *op) override {
+        if (tile.empty() || !uses_buffer(op, tile)) {
+            return IRMutator::visit(op);
+        }
+
+        // Peel off a perfect nest of loops, substituting in any lets
+        // between them.
+        vector<TileLoop> loops;
+        Stmt s = op;
+        while (true) {
+            if (const For *f = s.as<For>()) {
+                loops.push_back({f->name, f->min, f->extent, f->for_type, f->device_api, 0});
+                s = f->body;
+            } else if (const LetStmt *l = s.as<LetStmt>()) {
+                s = substitute(l->name, l->value, l->body);
+            } else {
+                break;
+            }
+        }
+        const Store *store = s.as<Store>();
+        if (!store) {
+            // Not a perfect nest. Look for one further in.
+            return IRMutator::visit(op);
+        }
+
+        Stmt result = match_nest(store, loops);
+        if (!result.defined()) {
+            debug(3) << "Could not match AMX tile access:\n" << Stmt(op) << "\n";
+            failed = true;
+            return op;
+        }
+        return result;
+    }
+
+    Expr visit(const Load *op) override {
+        failed = failed || op->name == tile;
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const Store *op) override {
+        failed = failed || op->name == tile;
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        lets.emplace_back(op->name, op->value);
+        Stmt s = IRMutator::visit(op);
+        lets.pop_back();
+        return s;
+    }
+
+    Stmt visit(const Allocate *op) override {
+        if (op->memory_type != MemoryType::AMXTile || !tile.empty()) {
+            return IRMutator::visit(op);
+        }
+
+        Stmt body;
+        if (op->type == Int(32) || op->type == Float(32)) {
+            ScopedValue<string> old_tile(tile, op->name);
+            tile_type = op->type;
+            rows = cols = 0;
+            row_stride = Expr();
+            found_update = found_store = failed = false;
+            body = mutate(op->body);
+        }
+
+        if (!body.defined() || failed || !found_update || !found_store) {
+            user_warning << "Could not use an AMX tile for " << op->name
+                         << ". Tiles must be int32 or float32, initialized to zero, "
+                         << "updated with a multiply-add of 8-bit or bfloat16 values, "
+                         << "and stored unchanged. Storing it on the stack instead.\n";
+            return Allocate::make(op->name, op->type, MemoryType::Stack, op->extents, op->condition,
+                                  mutate(op->body), op->new_expr, op->free_function);
+        }
+
+        used_tiles = true;
+        return Allocate::make(op->name, op->type, MemoryType::AMXTile,
+                              {tile_bytes / op->type.bytes()}, op->condition,
+                              body, op->new_expr, op->free_function);
+    }
+
+public:
+    bool used_tiles = false;
+};
+
+}  // namespace
+
+Stmt extract_tile_operations(const Stmt &s, const Target &t) {
+    ExtractTileOperations extractor;
+    Stmt result = extractor.mutate(s);
+    if (extractor.used_tiles && t.os == Target::Linux) {
+        // Linux only hands out the AMX register state to processes
+        // that ask for it.
+        Expr user_context = Variable::make(type_of<void *>(), "__user_context");
+        result = Block::make(call_extern_and_assert("halide_x86_amx_request_permission", {user_context}),
+                             result);
+    }
+    return result;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,31 @@
+#ifndef HALIDE_EXTRACT_TILE_OPERATIONS_H
+#define HALIDE_EXTRACT_TILE_OPERATIONS_H
+
+/** \file
+ * Defines the lowering pass that injects calls to the x86 AMX tile
+ * instructions for Funcs stored in MemoryType::AMXTile.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite the loop nests that initialize, update, and consume an
+ * allocation in MemoryType::AMXTile into calls to the tile_zero,
+ * tile_load, tile_matmul, and tile_store intrinsics, which
+ * CodeGen_X86 lowers to tilezero, tileloadd, tdpb*d/tdpbf16ps, and
+ * tilestored. The update must be a multiply-accumulate of 8-bit
+ * integers into int32, or of bfloat16 into float32, where the
+ * right-hand side is laid out in the VNNI order the instructions
+ * expect (groups of 4 bytes of consecutive k, one per column). If any
+ * access to the allocation doesn't have that form, a warning is
+ * printed and it is left on the stack. Must run after storage
+ * flattening and before vectorization. */
+Stmt extract_tile_operations(const Stmt &s, const Target &t);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
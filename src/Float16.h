@@ -117,6 +117,106 @@ private:
 
 static_assert(sizeof(float16_t) == 2, "float16_t should occupy two bytes");
 
+/** Class that provides a type that implements the bfloat16 floating
+ *  point format in software. A bfloat16 is the top 16 bits of an
+ *  IEEE754 binary32, so it has the range of a float with only 8 bits
+ *  of precision.
+ *
+ *  As with float16_t, this type holds only the raw bits, so it can
+ *  be used as the element type of a Buffer.
+ * */
+struct bfloat16_t {
+
+    /// \name Constructors
+    /// @{
+
+    /** Construct from a float, double, or int using
+     * round-to-nearest-ties-to-even. Out-of-range values become +/-
+     * infinity.
+     */
+    // @{
+    explicit bfloat16_t(float value);
+    explicit bfloat16_t(double value);
+    explicit bfloat16_t(int value);
+    // @}
+
+    /** Construct a bfloat16_t with the bits initialised to 0. This
+     * represents positive zero.*/
+    bfloat16_t();
+
+    /// @}
+
+    /** Cast to float */
+    explicit operator float() const;
+    /** Cast to double */
+    explicit operator double() const;
+
+    bfloat16_t(const bfloat16_t&) = default;
+    bfloat16_t& operator=(const bfloat16_t&) = default;
+
+    /** \name Convenience "constructors"
+     */
+    /**@{*/
+
+    /** Get a new bfloat16_t that represents zero
+     * \param positive if true then returns positive zero otherwise returns
+     *        negative zero.
+     */
+    static bfloat16_t make_zero(bool positive);
+
+    /** Get a new bfloat16_t that represents infinity
+     * \param positive if true then returns positive infinity otherwise returns
+     *        negative infinity.
+     */
+    static bfloat16_t make_infinity(bool positive);
+
+    /** Get a new bfloat16_t that represents NaN (not a number) */
+    static bfloat16_t make_nan();
+
+    /** Get a new bfloat16_t with the given raw bits */
+    static bfloat16_t make_from_bits(uint16_t bits);
+
+    /**@}*/
+
+    /** Return a new bfloat16_t with a negated sign bit*/
+    bfloat16_t operator-() const;
+
+    /** Arithmetic operators. */
+    // @{
+    bfloat16_t operator+(bfloat16_t rhs) const;
+    bfloat16_t operator-(bfloat16_t rhs) const;
+    bfloat16_t operator*(bfloat16_t rhs) const;
+    bfloat16_t operator/(bfloat16_t rhs) const;
+    // @}
+
+    /** Comparison operators */
+    // @{
+    bool operator==(bfloat16_t rhs) const;
+    bool operator!=(bfloat16_t rhs) const { return !(*this == rhs); }
+    bool operator>(bfloat16_t rhs) const;
+    bool operator<(bfloat16_t rhs) const;
+    bool operator>=(bfloat16_t rhs) const { return (*this > rhs) || (*this == rhs); }
+    bool operator<=(bfloat16_t rhs) const { return (*this < rhs) || (*this == rhs); }
+    // @}
+
+    /** Properties */
+    // @{
+    bool is_nan() const;
+    bool is_infinity() const;
+    bool is_negative() const;
+    bool is_zero() const;
+    // @}
+
+    /** Returns the bits that represent this bfloat16_t. */
+    uint16_t to_bits() const;
+
+private:
+    // The raw bits.
+    uint16_t data;
+};
+
+static_assert(sizeof(bfloat16_t) == 2, "bfloat16_t should occupy two bytes");
+
 }  // namespace Halide
 
 template<>
@@ -124,4 +224,9 @@ HALIDE_ALWAYS_INLINE halide_type_t halide_type_of<Halide::float16_t>() {
     return halide_type_t(halide_type_float, 16);
 }
 
+template<>
+HALIDE_ALWAYS_INLINE halide_type_t halide_type_of<Halide::bfloat16_t>() {
+    return halide_type_t(halide_type_bfloat, 16);
+}
+
 #endif
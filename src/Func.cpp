@@ -289,13 +289,16 @@ void Stage::set_dim_type(VarOrRVar var, ForType t) {
             // If it's an rvar and the for type is parallel, we need to
             // validate that this doesn't introduce a race condition.
             if (!dims[i].is_pure() && var.is_rvar && is_parallel(t)) {
-                user_assert(definition.schedule().allow_race_conditions())
+                user_assert(definition.schedule().allow_race_conditions() ||
+                            definition.schedule().atomic())
                     << "In schedule for " << name()
                     << ", marking var " << var.name()
                     << " as parallel or vectorized may introduce a race"
                     << " condition resulting in incorrect output."
                     << " It is possible to override this error using"
-                    << " the allow_race_conditions() method. Use this"
+                    << " the allow_race_conditions() method, or, if the"
+                    << " update is associative and commutative, by calling"
+                    << " atomic() first. Use allow_race_conditions()"
                     << " with great caution, and only when you are willing"
                     << " to accept non-deterministic output, or you can prove"
                     << " that any race conditions in this code do not change"
@@ -393,6 +396,49 @@ Expr substitute_self_reference(Expr val, const string &func, const Function &sub
     return val;
 }
 
+// Replace calls to 'func' at the site one step back along dimension
+// 'dim' from 'site' with calls at 'site' itself, so that the scan
+// looks like a reduction to prove_associativity. Counts any other
+// calls to 'func'.
+class ReplaceScanReference : public IRMutator {
+    using IRMutator::visit;
+
+    const string &func;
+    const vector<Expr> &site;
+    const size_t dim;
+
+    Expr visit(const Call *c) override {
+        Expr expr = IRMutator::visit(c);
+        c = expr.as<Call>();
+        internal_assert(c);
+
+        if (c->call_type != Call::Halide || c->name != func) {
+            return expr;
+        }
+        bool is_prev = c->args.size() == site.size();
+        for (size_t i = 0; is_prev && i < site.size(); i++) {
+            if (i == dim) {
+                is_prev = is_const(simplify(c->args[i] - site[i]), -1);
+            } else {
+                is_prev = equal(c->args[i], site[i]);
+            }
+        }
+        if (!is_prev) {
+            other_calls++;
+            return expr;
+        }
+        scan_calls++;
+        return Call::make(c->type, c->name, site, c->call_type,
+                          c->func, c->value_index, c->image, c->param);
+    }
+
+public:
+    int scan_calls = 0, other_calls = 0;
+
+    ReplaceScanReference(const string &func, const vector<Expr> &site, size_t dim)
+        : func(func), site(site), dim(dim) {}
+};
+
 // Substitute the occurrence of 'name' in 'exprs' with 'value'.
 void substitute_var_in_exprs(const string &name, Expr value, vector<Expr> &exprs) {
     for (auto &expr : exprs) {
@@ -886,6 +932,153 @@ Func Stage::rfactor(vector<pair<RVar, Var>> preserved) {
     return intm;
 }
 
+pair<Func, Func> Stage::parallel_scan(RVar r, Expr block_size, Var ri, Var rb) {
+    user_assert(!definition.is_init()) << "parallel_scan() must be called on an update definition\n";
+
+    const string &func_name = function.name();
+    vector<Expr> &args = definition.args();
+    vector<Expr> &values = definition.values();
+    const vector<ReductionVariable> &rvars = definition.schedule().rvars();
+
+    user_assert(values.size() == 1)
+        << "In parallel_scan() on " << name() << ": scans of Tuples are not supported\n";
+    user_assert(rvars.size() == 1 && var_name_match(rvars[0].var, r.name()))
+        << "In parallel_scan() on " << name() << ": the reduction domain must be "
+        << "one-dimensional, and " << r.name() << " must be its only variable\n";
+    user_assert(is_one(definition.predicate()))
+        << "In parallel_scan() on " << name() << ": reduction domains with "
+        << "predicates are not supported\n";
+    user_assert(definition.schedule().splits().empty())
+        << "In parallel_scan() on " << name() << ": parallel_scan() must be "
+        << "called before " << r.name() << " is split\n";
+
+    // Find the dimension scanned along. The others must be pure.
+    const ReductionVariable &rv = rvars[0];
+    size_t dim = args.size();
+    vector<Var> pure_args;
+    for (size_t i = 0; i < args.size(); i++) {
+        const Variable *v = args[i].as<Variable>();
+        user_assert(v)
+            << "In parallel_scan() on " << name() << ": the left-hand side must "
+            << "only contain " << r.name() << " and pure Vars\n";
+        if (v->name == rv.var) {
+            dim = i;
+        } else {
+            user_assert(!v->reduction_domain.defined())
+                << "In parallel_scan() on " << name() << ": the left-hand side must "
+                << "only contain " << r.name() << " and pure Vars\n";
+            pure_args.push_back(Var(v->name));
+        }
+    }
+    user_assert(dim < args.size())
+        << "In parallel_scan() on " << name() << ": " << r.name()
+        << " must appear on the left-hand side\n";
+
+    // The update must combine the value one step back along r with
+    // something that doesn't depend on the Func.
+    ReplaceScanReference replacer(func_name, args, dim);
+    Expr value = replacer.mutate(values[0]);
+    user_assert(replacer.scan_calls == 1 && replacer.other_calls == 0)
+        << "In parallel_scan() on " << name() << ": the update must refer to "
+        << func_name << " exactly once, one step back along " << r.name() << "\n";
+
+    const auto &prover_result = prove_associativity(func_name, args, {value});
+    user_assert(prover_result.associative() &&
+                !prover_result.xs[0].var.empty() &&
+                !prover_result.ys[0].var.empty())
+        << "In parallel_scan() on " << name()
+        << ": can't prove associativity of the operator\n";
+
+    auto op = [&](Expr a, Expr b) {
+        map<string, Expr> replacements;
+        replacements.emplace(prover_result.xs[0].var, a);
+        replacements.emplace(prover_result.ys[0].var, b);
+        return substitute(replacements, prover_result.pattern.ops[0]);
+    };
+
+    Expr min = rv.min, extent = rv.extent;
+    Expr num_blocks = (extent + block_size - 1) / block_size;
+
+    auto site = [&](Expr s0, Expr s1) {
+        vector<Expr> a(pure_args.begin(), pure_args.end());
+        a.push_back(s0);
+        a.push_back(s1);
+        return a;
+    };
+    auto totals_site = [&](Expr s) {
+        vector<Expr> a(pure_args.begin(), pure_args.end());
+        a.push_back(s);
+        return a;
+    };
+
+    // Scan each block. The tail of the last block reads the last
+    // element again, and is never used.
+    Func blocks(func_name + "_scan_blocks");
+    Expr elem = ::Halide::min(min + rb * block_size + ri, min + extent - 1);
+    blocks(site(ri, rb)) = substitute(rv.var, elem, prover_result.ys[0].expr);
+    RDom rs(1, block_size - 1, func_name + "_scan_ri");
+    blocks(site(rs, rb)) = op(blocks(site(rs - 1, rb)), blocks(site(rs, rb)));
+
+    // Scan the totals of the blocks.
+    Func totals(func_name + "_scan_totals");
+    totals(totals_site(rb)) = blocks(site(block_size - 1, rb));
+    RDom rt(1, num_blocks - 1, func_name + "_scan_rb");
+    totals(totals_site(rt)) = op(totals(totals_site(rt - 1)), totals(totals_site(rt)));
+
+    // Replace the update with one that combines the value before the
+    // scan, the totals of the blocks before this one, and the scan
+    // within this block. It has no loop-carried dependence.
+    Expr r_var = args[dim];
+    Expr offset = r_var - min;
+    Expr block = offset / block_size, within = offset % block_size;
+    vector<Expr> before_args = args;
+    before_args[dim] = min - 1;
+    Expr before = Call::make(value.type(), func_name, before_args, Call::Halide,
+                             FunctionPtr(), 0);
+    Expr local = blocks(site(within, block));
+    Expr carried = totals(totals_site(::Halide::max(block - 1, 0)));
+    values[0] = op(before, select(block > 0, op(carried, local), local));
+
+    blocks.compute_root().parallel(rb);
+    blocks.update().parallel(rb);
+    totals.compute_root();
+
+    return {blocks, totals};
+}
+
+Func Stage::privatize(RVar r, Var u, Expr num_copies, int vector_width) {
+    user_assert(!definition.is_init()) << "privatize() must be called on an update definition\n";
+
+    const vector<ReductionVariable> &rvars = definition.schedule().rvars();
+    const auto &rv = std::find_if(rvars.begin(), rvars.end(),
+        [&r](const ReductionVariable &rv) { return var_name_match(rv.var, r.name()); });
+    user_assert(rv != rvars.end())
+        << "In privatize() on " << name() << ": " << r.name()
+        << " is not a variable of the reduction domain\n";
+    const vector<Dim> &dims = definition.schedule().dims();
+    user_assert(std::any_of(dims.begin(), dims.end(),
+        [&r](const Dim &d) { return var_name_match(d.var, r.name()); }))
+        << "In privatize() on " << name() << ": privatize() must be called "
+        << "before " << r.name() << " is split\n";
+
+    // Give each copy an equal share of r, and lift the copies out
+    // into a Func with an extra dimension u.
+    Expr extent = rv->extent;
+    RVar ro(unique_name(r.name() + "o")), ri(unique_name(r.name() + "i"));
+    split(r, ro, ri, (extent + num_copies - 1) / num_copies, TailStrategy::GuardWithIf);
+    Func intm = rfactor(ro, u);
+
+    // Each copy is only as large as the region of this Func that is
+    // used, and is reduced into by one thread.
+    intm.compute_root();
+    intm.update(0).parallel(u);
+    if (vector_width > 1) {
+        intm.vectorize(intm.args()[0], vector_width);
+        vectorize(Var(function.args()[0]), vector_width);
+    }
+    return intm;
+}
+
 void Stage::split(const string &old, const string &outer, const string &inner, Expr factor, bool exact, TailStrategy tail) {
     debug(4) << "In schedule for " << name() << ", split " << old << " into "
              << outer << " and " << inner << " with factor of " << factor << "\n";
@@ -1404,6 +1597,34 @@ Stage &Stage::allow_race_conditions() {
     return *this;
 }
 
+Stage &Stage::atomic(bool override_associativity_test) {
+    user_assert(!definition.is_init())
+        << "In schedule for " << name()
+        << ", atomic() may only be applied to update definitions.\n";
+    const vector<Expr> &values = definition.values();
+    user_assert(values.size() == 1)
+        << "In schedule for " << name()
+        << ", atomic() does not support Tuple-valued Funcs.\n";
+    user_assert(!values[0].type().is_bool() && !values[0].type().is_handle())
+        << "In schedule for " << name()
+        << ", atomic() does not support Funcs of type " << values[0].type() << ".\n";
+
+    if (!override_associativity_test) {
+        // Atomic updates may happen in any order, so the operator must
+        // be both associative and commutative.
+        const auto &prover_result = prove_associativity(function.name(), definition.args(), values);
+        user_assert(prover_result.associative() && prover_result.commutative())
+            << "In schedule for " << name()
+            << ", can't make the update atomic because Halide can't prove"
+            << " that the operator is associative and commutative. If you are"
+            << " sure that it is, call atomic(true) to skip this check.\n";
+    }
+
+    definition.schedule().atomic() = true;
+    definition.schedule().override_atomic_associativity_test() = override_associativity_test;
+    return *this;
+}
+
 Stage &Stage::serial(VarOrRVar var) {
     set_dim_type(var, ForType::Serial);
     return *this;
@@ -1463,6 +1684,39 @@ Stage &Stage::unroll(VarOrRVar var, Expr factor, TailStrategy tail) {
     return *this;
 }
 
+Stage &Stage::unroll_and_jam(VarOrRVar var, Expr factor, TailStrategy tail) {
+    VarOrRVar inner = var.is_rvar ? VarOrRVar(RVar()) : VarOrRVar(Var());
+    split(var, var, inner, factor, tail);
+
+    // Move the unrolled dimension inwards past every loop inside it,
+    // stopping at any vectorized loops, so that the iterations of
+    // those loops are jammed together.
+    const vector<Dim> &dims = definition.schedule().dims();
+    size_t pos = 0;
+    while (pos < dims.size() && !var_name_match(dims[pos].var, inner.name())) {
+        pos++;
+    }
+    internal_assert(pos < dims.size());
+    size_t num_vectorized = 0;
+    while (num_vectorized < pos && dims[num_vectorized].for_type == ForType::Vectorized) {
+        num_vectorized++;
+    }
+    vector<VarOrRVar> order;
+    for (size_t i = 0; i < num_vectorized; i++) {
+        order.emplace_back(dims[i].var, dims[i].is_rvar());
+    }
+    order.push_back(inner);
+    for (size_t i = num_vectorized; i < pos; i++) {
+        order.emplace_back(dims[i].var, dims[i].is_rvar());
+    }
+    if (pos > num_vectorized) {
+        reorder(order);
+    }
+
+    unroll(inner);
+    return *this;
+}
+
 Stage &Stage::tile(VarOrRVar x, VarOrRVar y,
                    VarOrRVar xo, VarOrRVar yo,
                    VarOrRVar xi, VarOrRVar yi,
@@ -1717,13 +1971,29 @@ Stage &Stage::hexagon(VarOrRVar x) {
 }
 
 Stage &Stage::prefetch(const Func &f, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
-    PrefetchDirective prefetch = {f.name(), var.name(), offset, strategy, Parameter()};
+    user_assert(offset.defined()) << "Prefetch offset of " << f.name() << " must be defined\n";
+    PrefetchDirective prefetch = {f.name(), var.name(), offset, strategy, Parameter(), 0};
     definition.schedule().prefetches().push_back(prefetch);
     return *this;
 }
 
 Stage &Stage::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
-    PrefetchDirective prefetch = {param.name(), var.name(), offset, strategy, param};
+    user_assert(offset.defined()) << "Prefetch offset of " << param.name() << " must be defined\n";
+    PrefetchDirective prefetch = {param.name(), var.name(), offset, strategy, param, 0};
+    definition.schedule().prefetches().push_back(prefetch);
+    return *this;
+}
+
+Stage &Stage::prefetch(const Func &f, VarOrRVar var, const MachineParams &params, PrefetchBoundStrategy strategy) {
+    user_assert(params.memory_latency > 0) << "Memory latency for prefetch of " << f.name() << " must be positive\n";
+    PrefetchDirective prefetch = {f.name(), var.name(), Expr(), strategy, Parameter(), params.memory_latency};
+    definition.schedule().prefetches().push_back(prefetch);
+    return *this;
+}
+
+Stage &Stage::prefetch(const Internal::Parameter &param, VarOrRVar var, const MachineParams &params, PrefetchBoundStrategy strategy) {
+    user_assert(params.memory_latency > 0) << "Memory latency for prefetch of " << param.name() << " must be positive\n";
+    PrefetchDirective prefetch = {param.name(), var.name(), Expr(), strategy, param, params.memory_latency};
     definition.schedule().prefetches().push_back(prefetch);
     return *this;
 }
@@ -1904,6 +2174,31 @@ Func Func::clone_in(const vector<Func> &fs) {
     return get_wrapper(func, name() + "_clone", fs, true);
 }
 
+Func Func::stage_in_gpu_shared(const Func &consumer, Var block_var) {
+    user_assert(defined())
+        << "Can't stage undefined Func " << name() << " in GPU shared memory\n";
+    Func staged = in(consumer);
+    staged.compute_at(consumer, block_var).store_in(MemoryType::GPUShared);
+
+    vector<Var> staged_args = staged.args();
+    if (staged_args.size() == 1) {
+        staged.gpu_threads(staged_args[0]);
+        return staged;
+    }
+    staged.gpu_threads(staged_args[0], staged_args[1]);
+
+    // Shared memory is divided into 32 banks, each 4 bytes wide. Pad
+    // the rows to a multiple of the width of all of them, plus one
+    // word (or one element, if elements are wider than a word), so
+    // that a column of the region touches every bank.
+    int bytes = 1;
+    for (const Type &t : output_types()) {
+        bytes = std::max(bytes, t.bytes());
+    }
+    staged.align_storage(staged_args[0], 128 / bytes, std::max(1, 4 / bytes));
+    return staged;
+}
+
 Func Func::copy_to_device(DeviceAPI d) {
     user_assert(defined())
         << "copy_to_device on Func " << name() << " with no definition\n";
@@ -1956,6 +2251,19 @@ Func Func::copy_to_host() {
     return copy_to_device(DeviceAPI::Host);
 }
 
+Func Func::hexagon_dma_prefetch(const Func &consumer, Var tile_var, Var store_var,
+                                Var fold_var, Expr tile_extent) {
+    user_assert(tile_extent.defined())
+        << "hexagon_dma_prefetch on Func " << name() << " requires a tile extent\n";
+    copy_to_host();
+    async();
+    compute_at(consumer, tile_var);
+    store_at(consumer, store_var);
+    store_in(MemoryType::LockedCache);
+    fold_storage(fold_var, tile_extent * 2);
+    return *this;
+}
+
 Func &Func::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor, TailStrategy tail) {
     invalidate_cache();
     Stage(func, func.definition(), 0, args()).split(old, outer, inner, factor, tail);
@@ -1997,6 +2305,18 @@ Func &Func::async() {
     return *this;
 }
 
+Func &Func::carry_loads() {
+    invalidate_cache();
+    func.schedule().carry_loads() = true;
+    return *this;
+}
+
+Func &Func::store_tuple_interleaved() {
+    invalidate_cache();
+    func.schedule().interleave_tuple() = true;
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func, func.definition(), 0, args()).specialize(c);
@@ -2049,6 +2369,12 @@ Func &Func::unroll(VarOrRVar var, Expr factor, TailStrategy tail) {
     return *this;
 }
 
+Func &Func::unroll_and_jam(VarOrRVar var, Expr factor, TailStrategy tail) {
+    invalidate_cache();
+    Stage(func, func.definition(), 0, args()).unroll_and_jam(var, factor, tail);
+    return *this;
+}
+
 Func &Func::bound(Var var, Expr min, Expr extent) {
     user_assert(!min.defined() || Int(32).can_represent(min.type())) << "Can't represent min bound in int32\n";
     user_assert(extent.defined()) << "Extent bound of a Func can't be undefined\n";
@@ -2078,6 +2404,22 @@ Func &Func::bound(Var var, Expr min, Expr extent) {
     return *this;
 }
 
+Func &Func::value_bounds(Expr min, Expr max) {
+    user_assert(defined())
+        << "Can't promise value bounds for Func " << name()
+        << " because it has not yet been defined.\n";
+    user_assert(min.defined() && max.defined())
+        << "Value bounds of Func " << name() << " can't be undefined\n";
+
+    invalidate_cache();
+    std::vector<Interval> &bounds = func.value_bounds();
+    bounds.clear();
+    for (Type t : func.output_types()) {
+        bounds.emplace_back(cast(t, min), cast(t, max));
+    }
+    return *this;
+}
+
 Func &Func::estimate(Var var, Expr min, Expr extent) {
     invalidate_cache();
     bool found = func.is_pure_arg(var.name());
@@ -2338,6 +2680,18 @@ Func &Func::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offse
     return *this;
 }
 
+Func &Func::prefetch(const Func &f, VarOrRVar var, const MachineParams &params, PrefetchBoundStrategy strategy) {
+    invalidate_cache();
+    Stage(func, func.definition(), 0, args()).prefetch(f, var, params, strategy);
+    return *this;
+}
+
+Func &Func::prefetch(const Internal::Parameter &param, VarOrRVar var, const MachineParams &params, PrefetchBoundStrategy strategy) {
+    invalidate_cache();
+    Stage(func, func.definition(), 0, args()).prefetch(param, var, params, strategy);
+    return *this;
+}
+
 Func &Func::reorder_storage(Var x, Var y) {
     invalidate_cache();
 
@@ -2377,13 +2731,14 @@ Func &Func::reorder_storage(const std::vector<Var> &dims) {
     return reorder_storage(dims, 0);
 }
 
-Func &Func::align_storage(Var dim, Expr alignment) {
+Func &Func::align_storage(Var dim, Expr alignment, Expr padding) {
     invalidate_cache();
 
     vector<StorageDim> &dims = func.schedule().storage_dims();
     for (size_t i = 0; i < dims.size(); i++) {
         if (var_name_match(dims[i].var, dim.name())) {
             dims[i].alignment = alignment;
+            dims[i].padding = padding;
             return *this;
         }
     }
@@ -2408,6 +2763,23 @@ Func &Func::fold_storage(Var dim, Expr factor, bool fold_forward) {
     return *this;
 }
 
+Func &Func::ring_buffer(Var dim, Expr extent, bool fold_forward) {
+    invalidate_cache();
+
+    vector<StorageDim> &dims = func.schedule().storage_dims();
+    for (size_t i = 0; i < dims.size(); i++) {
+        if (var_name_match(dims[i].var, dim.name())) {
+            dims[i].fold_factor = extent;
+            dims[i].fold_forward = fold_forward;
+            dims[i].ring_buffer = true;
+            return *this;
+        }
+    }
+    user_error << "Could not find variable " << dim.name()
+               << " to store in a ring buffer.\n";
+    return *this;
+}
+
 Func &Func::compute_at(LoopLevel loop_level) {
     invalidate_cache();
     func.schedule().compute_level() = loop_level;
@@ -2473,6 +2845,24 @@ Func &Func::store_root() {
     return store_at(LoopLevel::root());
 }
 
+Func &Func::hoist_storage(LoopLevel loop_level) {
+    invalidate_cache();
+    func.schedule().hoist_storage_level() = loop_level;
+    return *this;
+}
+
+Func &Func::hoist_storage(Func f, RVar var) {
+    return hoist_storage(LoopLevel(f, var));
+}
+
+Func &Func::hoist_storage(Func f, Var var) {
+    return hoist_storage(LoopLevel(f, var));
+}
+
+Func &Func::hoist_storage_root() {
+    return hoist_storage(LoopLevel::root());
+}
+
 Func &Func::compute_inline() {
     return compute_at(LoopLevel::inlined());
 }
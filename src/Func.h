@@ -184,6 +184,57 @@ public:
     Func rfactor(RVar r, Var v);
     // @}
 
+    /** Calling parallel_scan() on an update definition that is a scan
+     * along a one-dimensional RDom, like:
+     \code
+     f(x, y) = 0;
+     f(x, r) = f(x, r - 1) + g(x, r);
+     \endcode
+     * rewrites it as a blocked scan, using an associative operator
+     * inferred the same way as for rfactor(). The range of r is cut
+     * into blocks of block_size. The first Func returned scans within
+     * each block, with args (the other pure Vars of f, ri, rb), where
+     * ri is the position within block rb. The second scans the totals
+     * of the blocks, with args (the other pure Vars of f, rb). The
+     * update definition then becomes:
+     \code
+     f(x, r) = f(x, r.min - 1) + (b > 0 ? totals(x, b - 1) + blocks(x, i, b) : blocks(x, i, b));
+     \endcode
+     * where b and i are the block and the position within it of r.
+     * The update no longer has a loop-carried dependence, so r can be
+     * parallelized or vectorized. Both Funcs are compute_root by
+     * default, and the scan within blocks is parallel over rb. All
+     * of these can be rescheduled, e.g. to vectorize the scan within
+     * blocks over x, or to move the work to a GPU. Each element is
+     * computed in two passes, so this pays off when there is enough
+     * parallelism to win that back. */
+    std::pair<Func, Func> parallel_scan(RVar r, Expr block_size, Var ri, Var rb);
+
+    /** Parallelize an associative reduction that scatters
+     * into a small Func, such as a histogram, by giving each thread
+     * its own private copy of it:
+     \code
+     hist(x) = 0;
+     hist(in(r.x, r.y)) += 1;
+     hist.update().privatize(r.y, u, 16, 8);
+     \endcode
+     * This splits r into num_copies pieces and rfactor()s them out
+     * into a new Func with an extra dimension u, which is returned.
+     * It is computed at root, with each copy of the reduction running
+     * in parallel over u, and is sized by the bounds of this Func
+     * that are required. The update definition then sums the copies
+     * together. If vector_width is greater than one, the
+     * initialization of the copies and the merge are vectorized by
+     * that amount over the innermost pure dimension. This is
+     * equivalent to:
+     \code
+     hist.update().split(r.y, ryo, ryi, (r.y.extent() + 15) / 16, TailStrategy::GuardWithIf)
+         .rfactor(ryo, u).compute_root().vectorize(x, 8).update().parallel(u);
+     hist.update().vectorize(x, 8);
+     \endcode
+     * and the returned Func can be rescheduled in the same way. */
+    Func privatize(RVar r, Var u, Expr num_copies, int vector_width = 1);
+
     /** Schedule the iteration over this stage to be fused with another
      * stage 's' from outermost loop to a given LoopLevel. 'this' stage will
      * be computed AFTER 's' in the innermost fused dimension. There should not
@@ -194,6 +245,19 @@ public:
      * exact schedule from the outermost to the innermost fused dimension, and
      * the stage we are calling compute_with on should not have specializations,
      * e.g. f2.compute_with(f1, x) is allowed only if f2 has no specializations.
+     * A fused dimension may be a Var in one stage and an RVar in the
+     * other, so an update over a reduction domain can be fused with a
+     * pure stage once its RVar is renamed to match:
+     \code
+     f(x, y) = in(x, y);
+     f(x, y) += x;
+     g(x, y) = in(x, y);
+     g(x, r) = g(x, r - 1) + in(x, r);
+     g.compute_with(f, y);
+     g.update().rename(r, RVar("y")).compute_with(f.update(), y);
+     \endcode
+     * Any number of stages may be fused into the same loop nest by
+     * computing each of them with the same parent, or with each other.
      *
      * Also, if a producer is desired to be computed at the fused loop level,
      * the function passed to the compute_at() needs to be the "parent". Consider
@@ -344,6 +408,7 @@ public:
     Stage &parallel(VarOrRVar var, Expr task_size, TailStrategy tail = TailStrategy::Auto);
     Stage &vectorize(VarOrRVar var, Expr factor, TailStrategy tail = TailStrategy::Auto);
     Stage &unroll(VarOrRVar var, Expr factor, TailStrategy tail = TailStrategy::Auto);
+    Stage &unroll_and_jam(VarOrRVar var, Expr factor, TailStrategy tail = TailStrategy::Auto);
     Stage &tile(VarOrRVar x, VarOrRVar y,
                 VarOrRVar xo, VarOrRVar yo,
                 VarOrRVar xi, VarOrRVar yi, Expr
@@ -420,6 +485,20 @@ public:
 
     Stage &allow_race_conditions();
 
+    /** Perform the stores of this update atomically, so that it can be
+     * parallelized or vectorized over RVars that may write to the same
+     * location (e.g. a histogram) without an rfactor(). Stores that
+     * read back the location being written become atomic
+     * read-modify-writes: native atomic instructions for +, -, min,
+     * and max where the target has them, and a compare-and-swap loop
+     * otherwise. The update must be associative and commutative, which
+     * is checked using the same machinery as rfactor(), unless
+     * override_associativity_test is true. Call this before
+     * parallelizing the RVars. Only single-valued Funcs are supported,
+     * and only the LLVM-based backends (CPU, CUDA) and OpenCL can
+     * generate code for it. */
+    Stage &atomic(bool override_associativity_test = false);
+
     Stage &hexagon(VarOrRVar x = Var::outermost());
     Stage &prefetch(const Func &f, VarOrRVar var, Expr offset = 1,
                            PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
@@ -430,6 +509,15 @@ public:
                     PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf) {
         return prefetch(image.parameter(), var, offset, strategy);
     }
+    Stage &prefetch(const Func &f, VarOrRVar var, const MachineParams &params,
+                    PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+    Stage &prefetch(const Internal::Parameter &param, VarOrRVar var, const MachineParams &params,
+                    PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+    template<typename T>
+    Stage &prefetch(const T &image, VarOrRVar var, const MachineParams &params,
+                    PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf) {
+        return prefetch(image.parameter(), var, params, strategy);
+    }
     // @}
 
     /** Attempt to get the source file and line where this stage was
@@ -1158,7 +1246,20 @@ public:
     /** Add an extern definition for this Func. This lets you define a
      * Func that represents an external pipeline stage. You can, for
      * example, use it to wrap a call to an extern library such as
-     * fftw. */
+     * fftw.
+     *
+     * If device_api names a specific device (e.g. DeviceAPI::CUDA),
+     * Halide copies the inputs to that device before the call if they
+     * are stale there, allocates the outputs there, and marks them
+     * device-dirty afterwards. The stage must then read its inputs
+     * and write its outputs on that device, and leave their
+     * allocations alone. It need not wait for its device work to
+     * finish: passing user_context_value() as an argument lets it
+     * find the stream Halide is using (see
+     * halide_cuda_get_current_stream), and work queued there is
+     * ordered with the rest of the pipeline. Host stages, and stages
+     * using DeviceAPI::Default_GPU, manage the device state of their
+     * buffers themselves. */
     // @{
     void define_extern(const std::string &function_name,
                        const std::vector<ExternFuncArgument> &params, Type t,
@@ -1379,6 +1480,27 @@ public:
     Func clone_in(const std::vector<Func> &fs);
     //@}
 
+    /** Stage the region of this Func used by a GPU kernel in shared
+     * memory. Creates and returns the wrapper \ref Func::in(const Func &)
+     * would for 'consumer', computed at consumer's gpu_blocks loop over
+     * 'block_var' and stored in MemoryType::GPUShared. The innermost
+     * one or two dimensions of the wrapper are mapped to gpu_threads,
+     * so that the threads of each block load the region cooperatively,
+     * and its innermost storage dimension is padded so that successive
+     * rows of the region start in different shared memory banks. This
+     * avoids bank conflicts when the consumer reads down columns.
+     *
+     * For example, to transpose an image through shared memory:
+     \code
+     g(x, y) = f(y, x);
+     g.gpu_tile(x, y, xo, yo, xi, yi, 32, 32);
+     f.stage_in_gpu_shared(g, xo);
+     \endcode
+     *
+     * The returned wrapper can be scheduled further, e.g. to unroll its
+     * loads. */
+    Func stage_in_gpu_shared(const Func &consumer, Var block_var);
+
     /** Declare that this function should be implemented by a call to
      * halide_buffer_copy with the given target device API. Asserts
      * that the Func has a pure definition which is a simple call to a
@@ -1403,6 +1525,33 @@ public:
      */
     Func copy_to_host();
 
+    /** Schedule this Func, which must be a suitable candidate for
+     * copy_to_host(), to DMA tiles of a buffer wrapped with
+     * halide_hexagon_dma_device_wrap_native into locked L2 cache while
+     * the previous tile is being processed. The copy is computed at
+     * 'consumer's loop over 'tile_var' in a separate thread (see
+     * async()), into storage allocated at 'consumer's loop over
+     * 'store_var' in MemoryType::LockedCache. The storage is folded
+     * over 'fold_var' with a factor of twice 'tile_extent', so that
+     * it holds exactly two tiles used as ping-pong buffers.
+     *
+     * This support is partial: the DMA wrapper still waits for each
+     * transfer to finish before returning, so the transfer of the next
+     * tile only overlaps the processing of the current one because it
+     * runs in the async producer thread, not because the DMA engine
+     * runs in the background.
+     *
+     * For example, for a consumer tiled in x:
+     \code
+     input_copy(x, y) = input(x, y);
+     output(x, y) = input_copy(x, y) * 2;
+     output.tile(x, y, tx, ty, x, y, 128, 32);
+     input_copy.hexagon_dma_prefetch(output, tx, ty, x, 128);
+     \endcode
+     */
+    Func hexagon_dma_prefetch(const Func &consumer, Var tile_var, Var store_var,
+                              Var fold_var, Expr tile_extent);
+
     /** Split a dimension into inner and outer subdimensions with the
      * given names, where the inner dimension iterates from 0 to
      * factor-1. The inner and outer subdimensions can then be dealt
@@ -1458,6 +1607,25 @@ public:
      * dimension of the split. 'factor' must be an integer. */
     Func &unroll(VarOrRVar var, Expr factor, TailStrategy tail = TailStrategy::Auto);
 
+    /** Split a dimension by the given factor, move the inner
+     * dimension of the split inwards past all the loops inside it
+     * except vectorized ones, and unroll it. This is unroll-and-jam:
+     * the body of the inner loops is replicated for 'factor'
+     * iterations of var, so loads and other work that those
+     * iterations share is only done once. For example, for a matrix
+     * multiply:
+     \code
+     c(x, y) += a(r, y) * b(x, r);
+     c.update().split(x, xo, xi, 8).reorder(xi, r, xo, y).vectorize(xi)
+         .unroll_and_jam(y, 4);
+     \endcode
+     * updates a vector of each of four rows of c in each iteration
+     * of the loop over r, loading the vector of b they share
+     * once. It is equivalent to a split, a reorder, and an
+     * unroll. After this call, var refers to the outer dimension of
+     * the split. 'factor' must be an integer. */
+    Func &unroll_and_jam(VarOrRVar var, Expr factor, TailStrategy tail = TailStrategy::Auto);
+
     /** Statically declare that the range over which a function should
      * be evaluated is given by the second and third arguments. This
      * can let Halide perform some optimizations. E.g. if you know
@@ -1494,6 +1662,16 @@ public:
      * means it can go on the stack. */
     Func &bound_extent(Var var, Expr extent);
 
+    /** Promise that every value of this Func lies within [min, max],
+     * so that bounds inference can use the range for the regions of
+     * other Funcs and images indexed by it. This is useful for lookup
+     * tables with update definitions, or that are loaded from an
+     * input, whose values can't otherwise be bounded more tightly than
+     * their type. For a Func with a Tuple value, the range applies to
+     * every element. The promise is not checked: if a value lies
+     * outside the range, a consumer may read out of bounds. */
+    Func &value_bounds(Expr min, Expr max);
+
     /** Split two dimensions at once by the given factors, and then
      * reorder the resulting dimensions to be xi, yi, xo, yo from
      * innermost outwards. This gives a tiled traversal. */
@@ -1838,7 +2016,13 @@ public:
     Func &glsl(Var x, Var y, Var c);
 
     /** Schedule for execution on Hexagon. When a loop is marked with
-     * Hexagon, that loop is executed on a Hexagon DSP. */
+     * Hexagon, that loop is executed on a Hexagon DSP. The calling
+     * thread blocks until the DSP is done. To keep the CPU busy with
+     * other work meanwhile, also schedule the Func async(): the
+     * offloaded loop then runs from its own task, and consumers wait
+     * on a semaphore for it to complete. The synchronization must
+     * happen on the CPU, so the Func's compute and store levels must
+     * be outside of any loop marked hexagon(). */
     Func &hexagon(VarOrRVar x = Var::outermost());
 
     /** Prefetch data written to or read from a Func or an ImageParam by a
@@ -1870,6 +2054,10 @@ public:
      *   for x = ...
      *     prefetch(&f[x + 2, y], 1, 16);
      *     g(x, y) = 2 * f(x, y)
+     *
+     * The offset may be an Expr of Params (or Generator Inputs), in
+     * which case the best offset can be found at runtime by sweeping
+     * it, e.g. with apps/support/sweep_rungen.py.
      */
     // @{
     Func &prefetch(const Func &f, VarOrRVar var, Expr offset = 1,
@@ -1883,6 +2071,28 @@ public:
     }
     // @}
 
+    /** Prefetch as above, but choose the iteration offset
+     * automatically. During lowering, the cost of one iteration of the
+     * loop over 'var' is estimated by counting the operations in its
+     * body (scaled by the extents of any inner loops), and the offset
+     * is the number of iterations needed to cover
+     * params.memory_latency. For example:
+     \code
+     g.prefetch(f, y, get_machine_params());
+     \endcode
+     */
+    // @{
+    Func &prefetch(const Func &f, VarOrRVar var, const MachineParams &params,
+                   PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+    Func &prefetch(const Internal::Parameter &param, VarOrRVar var, const MachineParams &params,
+                   PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+    template<typename T>
+    Func &prefetch(const T &image, VarOrRVar var, const MachineParams &params,
+                   PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf) {
+        return prefetch(image.parameter(), var, params, strategy);
+    }
+    // @}
+
     /** Specify how the storage for the function is laid out. These
      * calls let you specify the nesting order of the dimensions. For
      * example, foo.reorder_storage(y, x) tells Halide to use
@@ -1918,8 +2128,13 @@ public:
      *
      * For example, to guarantee that a function foo(x, y, c)
      * representing an image has scanlines starting on offsets
-     * aligned to multiples of 16, use foo.align_storage(x, 16). */
-    Func &align_storage(Var dim, Expr alignment);
+     * aligned to multiples of 16, use foo.align_storage(x, 16).
+     *
+     * If padding is given, that many more elements are added to the
+     * extent after rounding it up. Padding by one element after
+     * aligning to the number of shared memory banks, for example,
+     * makes successive rows start in different banks. */
+    Func &align_storage(Var dim, Expr alignment, Expr padding = Expr());
 
     /** Store realizations of this function in a circular buffer of a
      * given extent. This is more efficient when the extent of the
@@ -1950,9 +2165,38 @@ public:
      * Then g will be computed at each row of f and stored in a buffer
      * with an extent in y of 2, alternately storing each computed row
      * of g in row y=0 or y=1.
+     *
+     * Storage is also folded automatically where possible. If each
+     * iteration of a loop computes all of a function that it uses
+     * (e.g. a loop over tiles that have been fused together), then
+     * every dimension whose footprint moves with the loop is folded
+     * over it, in whichever direction the footprint moves.
      */
     Func &fold_storage(Var dim, Expr extent, bool fold_forward = true);
 
+    /** Store realizations of this function in a circular buffer of a
+     * given extent, like fold_storage, but address it as a ring of
+     * buffers. Instead of taking every coordinate modulo the extent,
+     * the index of the first buffer in use is advanced once per
+     * iteration of the loop the storage is folded over, and accesses
+     * are offset from it, wrapping around with a single comparison.
+     * This makes addressing cheap even when the extent is not a power
+     * of two, e.g. for a line buffer that holds exactly the number of
+     * scanlines a stencil needs. It works with async producers, which
+     * are synchronized with their consumers in the same way as for
+     * fold_storage. If the footprint of each iteration can't be
+     * analyzed statically, this falls back to the same addressing as
+     * fold_storage.
+     \code
+     Func f, g;
+     Var x, y;
+     g(x, y) = x*y;
+     f(x, y) = g(x, y-1) + g(x, y) + g(x, y+1);
+     g.compute_at(f, y).store_root().ring_buffer(y, 3);
+     \endcode
+     */
+    Func &ring_buffer(Var dim, Expr extent, bool fold_forward = true);
+
     /** Compute this function as needed for each unique value of the
      * given var for the given calling function f.
      *
@@ -2104,6 +2348,32 @@ public:
      */
     Func &async();
 
+    /** Keep values loaded on one iteration of the serial loops in this
+     * Func's production in registers, for reuse on the next, instead of
+     * loading them again. This helps stencils along a serial loop, and
+     * (because unaligned vector loads are first rewritten as aligned
+     * loads plus shuffles) stencils along the vectorized dimension:
+     * e.g. a 1-D convolution vectorized along x then loads each aligned
+     * vector of the input once. The aligned loads may read outside of
+     * the values used, but never outside of the aligned vectors that
+     * contain them. The number of values carried is limited by the
+     * target's vector registers. This is what Hexagon code already
+     * does everywhere, so it has no effect on Hexagon targets. */
+    Func &carry_loads();
+
+    /** Store the elements of this Tuple-valued Func interleaved in a
+     * single allocation, as an array of structs, instead of in one
+     * allocation per element. This helps when consumers read all the
+     * elements at the same site, e.g. the real and imaginary parts of
+     * a complex number, because they then come from one stream of
+     * memory instead of several. Vectorized loads and stores of the
+     * elements are turned into dense vector loads and stores with
+     * shuffles to deinterleave or interleave them. Only applies if all
+     * the elements have the same type, and is ignored for pipeline
+     * outputs, extern Funcs, memoized Funcs, and Funcs consumed by
+     * extern stages, which need one buffer per element. */
+    Func &store_tuple_interleaved();
+
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
      * separate the loop level at which storage occurs from the loop
@@ -2213,6 +2483,43 @@ public:
      * outside the outermost loop. */
     Func &store_root();
 
+    /** Keep the memory for this function's allocations alive at the
+     * given loop level, and reuse it across the iterations of all
+     * the loops between there and the store_at level. This is most
+     * useful when a Func is computed inside a parallel loop: store_at
+     * can't be moved outside the parallel loop without introducing a
+     * race, but hoist_storage can. Each iteration still gets its own
+     * allocation, but instead of a call to halide_malloc and
+     * halide_free per iteration, the allocation is taken from a pool
+     * created at the hoist_storage level, which holds at most one
+     * block per concurrently-running iteration. For example:
+     *
+     \code
+     Func f, g;
+     Var x, y;
+     g(x, y) = x * y;
+     f(x, y) = g(x - 1, y) + g(x + 1, y);
+     g.compute_at(f, y).hoist_storage_root();
+     f.parallel(y);
+     \endcode
+     *
+     * The hoist_storage level must be outside of or equal to the
+     * store_at level. */
+    Func &hoist_storage(Func f, Var var);
+
+    /** Equivalent to the version of hoist_storage that takes a Var, but
+     * hoists storage to the loop over a dimension of a reduction
+     * domain */
+    Func &hoist_storage(Func f, RVar var);
+
+    /** Equivalent to the version of hoist_storage that takes a Var, but
+     * hoists storage to a given LoopLevel. */
+    Func &hoist_storage(LoopLevel loop_level);
+
+    /** Equivalent to \ref Func::hoist_storage, but hoists storage
+     * outside the outermost loop. */
+    Func &hoist_storage_root();
+
     /** Aggressively inline all uses of this function. This is the
      * default schedule, so you're unlikely to need to call this. For
      * a Func with an update definition, that means it gets computed
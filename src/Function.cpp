@@ -86,6 +86,8 @@ struct FunctionContents {
     DeviceAPI extern_function_device_api = DeviceAPI::Host;
     Expr extern_proxy_expr;
 
+    std::vector<Interval> value_bounds;
+
     bool trace_loads = false, trace_stores = false, trace_realizations = false;
     std::vector<string> trace_tags;
 
@@ -116,6 +118,11 @@ struct FunctionContents {
             }
         }
 
+        for (const Interval &i : value_bounds) {
+            i.min.accept(visitor);
+            i.max.accept(visitor);
+        }
+
         for (Parameter i : output_buffers) {
             for (size_t j = 0; j < args.size(); j++) {
                 if (i.min_constraint(j).defined()) {
@@ -150,6 +157,11 @@ struct FunctionContents {
             }
             extern_proxy_expr = mutator->mutate(extern_proxy_expr);
         }
+
+        for (Interval &i : value_bounds) {
+            i.min = mutator->mutate(i.min);
+            i.max = mutator->mutate(i.max);
+        }
     }
 };
 
@@ -336,6 +348,7 @@ void Function::deep_copy(FunctionPtr copy, DeepCopyMap &copied_map) const {
     copy->extern_mangling = contents->extern_mangling;
     copy->extern_function_device_api = contents->extern_function_device_api;
     copy->extern_proxy_expr = contents->extern_proxy_expr;
+    copy->value_bounds = contents->value_bounds;
     copy->trace_loads = contents->trace_loads;
     copy->trace_stores = contents->trace_stores;
     copy->trace_realizations = contents->trace_realizations;
@@ -856,6 +869,14 @@ Expr Function::make_call_to_extern_definition(const std::vector<Expr> &args,
     return Call::make(Int(32), contents->extern_function_name, args, call_type, contents);
 }
 
+const std::vector<Interval> &Function::value_bounds() const {
+    return contents->value_bounds;
+}
+
+std::vector<Interval> &Function::value_bounds() {
+    return contents->value_bounds;
+}
+
 Expr Function::extern_definition_proxy_expr() const {
     return contents->extern_proxy_expr;
 }
@@ -922,6 +943,7 @@ void Function::lock_loop_levels() {
     auto &schedule = contents->func_schedule;
     schedule.compute_level().lock();
     schedule.store_level().lock();
+    schedule.hoist_storage_level().lock();
     // If store_level is inlined, use the compute_level instead.
     // (Note that we deliberately do *not* do the same if store_level
     // is undefined.)
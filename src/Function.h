@@ -10,6 +10,7 @@
 #include "Expr.h"
 #include "FunctionPtr.h"
 #include "IntrusivePtr.h"
+#include "Interval.h"
 #include "Parameter.h"
 #include "Reduction.h"
 #include "Schedule.h"
@@ -266,6 +267,13 @@ public:
         return ExternFuncArgument(contents);
     }
 
+    /** Get a handle to the promised bounds on each value of this
+     * Function. Empty if none were given. See \ref Func::value_bounds */
+    // @{
+    const std::vector<Interval> &value_bounds() const;
+    std::vector<Interval> &value_bounds();
+    // @}
+
     /** Tracing calls and accessors, passed down from the Func
      * equivalents. */
     // @{
@@ -375,7 +375,8 @@ class ExtractSharedAllocations : public IRMutator {
             Expr predicate = mutate(op->predicate);
             Expr index = mutate(op->index);
             shared[op->name].max = barrier_stage;
-            if (device_api == DeviceAPI::OpenGLCompute) {
+            if (device_api == DeviceAPI::OpenGLCompute || device_api == DeviceAPI::Vulkan ||
+            device_api == DeviceAPI::WebGPU) {
                 return Load::make(op->type, shared_mem_name + "_" + op->name,
                                   index, op->image, op->param, predicate, op->alignment);
             } else {
@@ -395,7 +396,8 @@ class ExtractSharedAllocations : public IRMutator {
             Expr predicate = mutate(op->predicate);
             Expr index = mutate(op->index);
             Expr value = mutate(op->value);
-            if (device_api == DeviceAPI::OpenGLCompute) {
+            if (device_api == DeviceAPI::OpenGLCompute || device_api == DeviceAPI::Vulkan ||
+            device_api == DeviceAPI::WebGPU) {
                 return Store::make(shared_mem_name + "_" + op->name, value, index,
                                    op->param, predicate, op->alignment);
             } else {
@@ -537,7 +539,8 @@ class ExtractSharedAllocations : public IRMutator {
 public:
     Stmt rewrap(Stmt s) {
 
-        if (device_api == DeviceAPI::OpenGLCompute) {
+        if (device_api == DeviceAPI::OpenGLCompute || device_api == DeviceAPI::Vulkan ||
+            device_api == DeviceAPI::WebGPU) {
 
             // Individual shared allocations.
             for (SharedAllocation alloc : allocations) {
@@ -869,7 +872,9 @@ class ZeroGPULoopMins : public IRMutator {
         in_non_glsl_gpu = (in_non_glsl_gpu && op->device_api == DeviceAPI::None) ||
           (op->device_api == DeviceAPI::CUDA) || (op->device_api == DeviceAPI::OpenCL) ||
           (op->device_api == DeviceAPI::Metal) ||
-          (op->device_api == DeviceAPI::D3D12Compute);
+          (op->device_api == DeviceAPI::D3D12Compute) ||
+          (op->device_api == DeviceAPI::Vulkan) ||
+          (op->device_api == DeviceAPI::WebGPU);
 
         Stmt stmt = IRMutator::visit(op);
         if (CodeGen_GPU_Dev::is_gpu_var(op->name) && !is_zero(op->min)) {
@@ -132,6 +132,9 @@ Outputs compute_outputs(const Target &target,
     if (options.emit_schedule) {
         output_files.schedule_name = base_path + get_extension(".schedule", options);
     }
+    if (options.emit_roofline) {
+        output_files.roofline_name = base_path + get_extension(".roofline", options);
+    }
     return output_files;
 }
 
@@ -763,7 +766,8 @@ const std::map<std::string, Type> &get_halide_type_enum_map() {
         {"uint32", UInt(32)},
         {"float16", Float(16)},
         {"float32", Float(32)},
-        {"float64", Float(64)}
+        {"float64", Float(64)},
+        {"bfloat16", BFloat(16)}
     };
     return halide_type_enum_map;
 }
@@ -774,6 +778,7 @@ std::string halide_type_to_c_source(const Type &t) {
         { halide_type_uint, "UInt" },
         { halide_type_float, "Float" },
         { halide_type_handle, "Handle" },
+        { halide_type_bfloat, "BFloat" },
     };
     std::ostringstream oss;
     oss << "Halide::" << m.at(t.code()) << "(" << t.bits() << + ")";
@@ -809,7 +814,7 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
         "\n"
         " -e  A comma separated list of files to emit. Accepted values are:\n"
         "     [assembly, bitcode, cpp, h, html, o, static_library,\n"
-        "      stmt, cpp_stub, schedule, registration].\n"
+        "      stmt, cpp_stub, schedule, roofline, registration].\n"
         "     If omitted, default value is [static_library, h, registration].\n"
         "\n"
         " -x  A comma separated list of file extension pairs to substitute during\n"
@@ -973,11 +978,13 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
                 emit_options.emit_cpp_stub = true;
             } else if (opt == "schedule") {
                 emit_options.emit_schedule = true;
+            } else if (opt == "roofline") {
+                emit_options.emit_roofline = true;
             } else if (opt == "registration") {
                 emit_options.emit_registration = true;
             } else if (!opt.empty()) {
                 cerr << "Unrecognized emit option: " << opt
-                     << " not one of [assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub, registration], ignoring.\n";
+                     << " not one of [assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub, schedule, roofline, registration], ignoring.\n";
             }
         }
     }
@@ -1036,7 +1043,7 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
         // Don't bother with this if we're just emitting a cpp_stub.
         if (!stub_only) {
             Outputs output_files = compute_outputs(targets[0], base_path, emit_options);
-            auto module_producer = [&generator_name, &generator_args]
+            auto module_producer = [&generator_name, &generator_args, &emit_options]
                 (const std::string &name, const Target &target) -> Module {
                     // Reset the counters so the function/variable names look
                     // consistent for different targets.
@@ -1047,7 +1054,11 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
                     // Must re-create each time since each instance will have a different Target.
                     auto gen = GeneratorRegistry::create(generator_name, GeneratorContext(target));
                     gen->set_generator_param_values(sub_generator_args);
-                    return gen->build_module(name);
+                    Module m = gen->build_module(name);
+                    if (emit_options.emit_roofline) {
+                        m.set_roofline_report(gen->get_pipeline().roofline_report(gen->get_machine_params()));
+                    }
+                    return m;
                 };
             if (targets.size() > 1 || !emit_options.substitutions.empty()) {
                 compile_multitarget(function_name, output_files, targets, module_producer, emit_options.substitutions);
@@ -1465,6 +1476,22 @@ Pipeline GeneratorBase::get_pipeline() {
     return pipeline;
 }
 
+namespace {
+
+// Add a specialization of s for each combination of the conditions,
+// with at most one condition taken from each group.
+void specialize_on_conditions(Stage s, const std::vector<std::vector<Expr>> &conditions, size_t i) {
+    if (i == conditions.size()) {
+        return;
+    }
+    for (const Expr &c : conditions[i]) {
+        specialize_on_conditions(s.specialize(c), conditions, i + 1);
+    }
+    specialize_on_conditions(s, conditions, i + 1);
+}
+
+}  // namespace
+
 Module GeneratorBase::build_module(const std::string &function_name,
                                    const LinkageType linkage_type) {
     std::string auto_schedule_result;
@@ -1476,10 +1503,34 @@ Module GeneratorBase::build_module(const std::string &function_name,
 
     GeneratorParamInfo &pi = param_info();
     std::vector<Argument> filter_arguments;
+    std::vector<std::vector<Expr>> specialize_conditions;
     for (auto *input : pi.inputs()) {
         for (const auto &p : input->parameters_) {
             filter_arguments.push_back(to_argument(p, p.is_buffer() ? Expr() : input->get_def_expr()));
         }
+        if (!input->specialize_values_.empty()) {
+            Expr e = input->exprs().at(0);
+            std::vector<Expr> conditions;
+            for (const Expr &value : input->specialize_values_) {
+                conditions.push_back(e == value);
+            }
+            specialize_conditions.push_back(conditions);
+        }
+    }
+
+    // Specialize every stage of the outputs on the declared Input
+    // values. Producers computed inside the outputs are specialized
+    // along with them when the branches are simplified.
+    if (!specialize_conditions.empty()) {
+        for (Func f : pipeline.outputs()) {
+            if (f.is_extern()) {
+                continue;
+            }
+            specialize_on_conditions(f, specialize_conditions, 0);
+            for (int i = 0; i < f.num_update_definitions(); i++) {
+                specialize_on_conditions(f.update(i), specialize_conditions, 0);
+            }
+        }
     }
 
     Module result = pipeline.compile_to_module(filter_arguments, function_name, target, linkage_type);
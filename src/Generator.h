@@ -1406,6 +1406,9 @@ protected:
 
     std::vector<Parameter> parameters_;
 
+    // The values declared with specialize_on(), if any.
+    std::vector<Expr> specialize_values_;
+
     Parameter parameter() const;
 
     void init_internals();
@@ -1874,6 +1877,24 @@ public:
         }
         this->parameters_.at(index).set_estimate(e);
     }
+
+    /** Declare the values this Input is expected to take. The outputs
+     * of the Generator get a specialization for each of them (and for
+     * each combination of them with the values of any other Inputs
+     * declared this way), in which the Input is a constant. Calls with
+     * any other value run the generic code. */
+    template <typename T2 = T, typename std::enable_if<!std::is_array<T2>::value>::type * = nullptr>
+    void specialize_on(const std::vector<TBase> &values) {
+        this->check_gio_access();
+        this->specialize_values_.clear();
+        for (const TBase &value : values) {
+            Expr e = Expr(value);
+            if (std::is_same<T2, bool>::value) {
+              e = cast<bool>(e);
+            }
+            this->specialize_values_.push_back(e);
+        }
+    }
 };
 
 template<typename T>
@@ -2050,6 +2071,7 @@ public:
     HALIDE_FORWARD_METHOD_CONST(Func, args)
     HALIDE_FORWARD_METHOD(Func, bound)
     HALIDE_FORWARD_METHOD(Func, bound_extent)
+    HALIDE_FORWARD_METHOD(Func, carry_loads)
     HALIDE_FORWARD_METHOD(Func, compute_at)
     HALIDE_FORWARD_METHOD(Func, compute_inline)
     HALIDE_FORWARD_METHOD(Func, compute_root)
@@ -2069,6 +2091,8 @@ public:
     HALIDE_FORWARD_METHOD(Func, gpu_tile)
     HALIDE_FORWARD_METHOD_CONST(Func, has_update_definition)
     HALIDE_FORWARD_METHOD(Func, hexagon)
+    HALIDE_FORWARD_METHOD(Func, hoist_storage)
+    HALIDE_FORWARD_METHOD(Func, hoist_storage_root)
     HALIDE_FORWARD_METHOD(Func, in)
     HALIDE_FORWARD_METHOD(Func, memoize)
     HALIDE_FORWARD_METHOD_CONST(Func, num_update_definitions)
@@ -2080,6 +2104,7 @@ public:
     HALIDE_FORWARD_METHOD(Func, rename)
     HALIDE_FORWARD_METHOD(Func, reorder)
     HALIDE_FORWARD_METHOD(Func, reorder_storage)
+    HALIDE_FORWARD_METHOD(Func, ring_buffer)
     HALIDE_FORWARD_METHOD_CONST(Func, rvars)
     HALIDE_FORWARD_METHOD(Func, serial)
     HALIDE_FORWARD_METHOD(Func, shader)
@@ -2088,9 +2113,11 @@ public:
     HALIDE_FORWARD_METHOD(Func, split)
     HALIDE_FORWARD_METHOD(Func, store_at)
     HALIDE_FORWARD_METHOD(Func, store_root)
+    HALIDE_FORWARD_METHOD(Func, store_tuple_interleaved)
     HALIDE_FORWARD_METHOD(Func, tile)
     HALIDE_FORWARD_METHOD(Func, trace_stores)
     HALIDE_FORWARD_METHOD(Func, unroll)
+    HALIDE_FORWARD_METHOD(Func, unroll_and_jam)
     HALIDE_FORWARD_METHOD(Func, update)
     HALIDE_FORWARD_METHOD_CONST(Func, update_args)
     HALIDE_FORWARD_METHOD_CONST(Func, update_value)
@@ -2844,6 +2871,7 @@ public:
         bool emit_static_library{true};
         bool emit_cpp_stub{false};
         bool emit_schedule{false};
+        bool emit_roofline{false};
         bool emit_registration{false};
 
         // This is an optional map used to replace the default extensions generated for
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <memory>
+#include <set>
 
 #include "Closure.h"
 #include "Elf.h"
@@ -41,6 +42,8 @@ enum {
     EF_HEXAGON_MACH_V62 = 0x62,
     EF_HEXAGON_MACH_V65 = 0x65,
     EF_HEXAGON_MACH_V66 = 0x66,
+    EF_HEXAGON_MACH_V68 = 0x68,
+    EF_HEXAGON_MACH_V69 = 0x69,
 };
 
 enum {
@@ -533,7 +536,11 @@ public:
     uint32_t flags;
 
     HexagonLinker(const Target &target) {
-        if (target.has_feature(Target::HVX_v66)) {
+        if (target.has_feature(Target::HVX_v69)) {
+            flags = Elf::EF_HEXAGON_MACH_V69;
+        } else if (target.has_feature(Target::HVX_v68)) {
+            flags = Elf::EF_HEXAGON_MACH_V68;
+        } else if (target.has_feature(Target::HVX_v66)) {
             flags = Elf::EF_HEXAGON_MACH_V66;
         } else if (target.has_feature(Target::HVX_v65)) {
             flags = Elf::EF_HEXAGON_MACH_V65;
@@ -667,6 +674,30 @@ Stmt replace_params(Stmt s, const std::map<std::string, Parameter> &replacements
     return ReplaceParams(replacements).mutate(s);
 }
 
+// Find the semaphores acquired or released by a statement.
+class FindSemaphores : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Acquire *op) override {
+        if (const Variable *v = op->semaphore.as<Variable>()) {
+            semaphores.insert(v->name);
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        if (op->name == "halide_semaphore_release" && !op->args.empty()) {
+            if (const Variable *v = op->args[0].as<Variable>()) {
+                semaphores.insert(v->name);
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::set<std::string> semaphores;
+};
+
 class InjectHexagonRpc : public IRMutator {
     std::map<std::string, Expr> state_bufs;
 
@@ -735,6 +766,20 @@ class InjectHexagonRpc : public IRMutator {
         // or the loop itself? Currently, this moves the loop itself.
         Closure c(body);
 
+        // Semaphores used to synchronize async() producers and
+        // consumers live in host memory, and the task system that
+        // waits on them runs on the host. If the offloaded code
+        // would need to touch one, the async Func's schedule puts
+        // the synchronization inside the offloaded loop.
+        FindSemaphores semaphores;
+        body.accept(&semaphores);
+        for (const std::string &s : semaphores.semaphores) {
+            user_assert(!c.vars.count(s))
+                << "Loop " << loop->name << " is scheduled on Hexagon, but contains synchronization"
+                << " for an async() producer (" << s << "). The compute and store levels of async()"
+                << " Funcs must be outside of loops scheduled with hexagon().\n";
+        }
+
         // A buffer parameter potentially generates 3 scalar parameters (min,
         // extent, stride) per dimension. Pipelines with many buffers may
         // generate extreme numbers of scalar parameters, which can cause
@@ -948,6 +993,9 @@ Stmt inject_hexagon_rpc(Stmt s, const Target &host_target,
         Target::HVX_v62,
         Target::HVX_v65,
         Target::HVX_v66,
+        Target::HVX_v68,
+        Target::HVX_v69,
+        Target::HVX_AutoVTCM,
     };
     for (Target::Feature i : shared_features) {
         if (host_target.has_feature(i)) {
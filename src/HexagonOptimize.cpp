@@ -7,11 +7,13 @@
 #include "IRMatch.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "IRVisitor.h"
 #include "Lerp.h"
 #include "Scope.h"
 #include "Simplify.h"
 #include "Substitute.h"
 #include "HexagonAlignment.h"
+#include <algorithm>
 #include <unordered_map>
 
 namespace Halide {
@@ -143,6 +145,7 @@ struct Pattern {
         v62orLater = 1 << 20,  // Pattern should be matched only for v62 target or later
         v65orLater = 1 << 21,  // Pattern should be matched only for v65 target or later
         v66orLater = 1 << 22,  // Pattern should be matched only for v66 target or later
+        v68orLater = 1 << 23,  // Pattern should be matched only for v68 target or later
    };
 
     string intrin;        // Name of the intrinsic
@@ -171,19 +174,25 @@ Expr wild_i8x = Variable::make(Type(Type::Int, 8, 0), "*");
 Expr wild_i16x = Variable::make(Type(Type::Int, 16, 0), "*");
 Expr wild_i32x = Variable::make(Type(Type::Int, 32, 0), "*");
 Expr wild_i64x = Variable::make(Type(Type::Int, 64, 0), "*");
+Expr wild_f32x = Variable::make(Type(Type::Float, 32, 0), "*");
 
 // Check if a pattern with flags 'flags' is supported on the target.
 bool check_pattern_target(int flags, const Target &target) {
     if ((flags & (Pattern::v62orLater)) &&
-        !target.features_any_of({Target::HVX_v62, Target::HVX_v65, Target::HVX_v66})) {
+        !target.features_any_of({Target::HVX_v62, Target::HVX_v65, Target::HVX_v66,
+                                 Target::HVX_v68, Target::HVX_v69})) {
         return false;
     }
     if ((flags & (Pattern::v65orLater)) &&
-        !target.features_any_of({Target::HVX_v65, Target::HVX_v66})) {
+        !target.features_any_of({Target::HVX_v65, Target::HVX_v66, Target::HVX_v68, Target::HVX_v69})) {
         return false;
     }
     if ((flags & (Pattern::v66orLater)) &&
-        !target.features_any_of({Target::HVX_v66})) {
+        !target.features_any_of({Target::HVX_v66, Target::HVX_v68, Target::HVX_v69})) {
+        return false;
+    }
+    if ((flags & (Pattern::v68orLater)) &&
+        !target.features_any_of({Target::HVX_v68, Target::HVX_v69})) {
         return false;
     }
     return true;
@@ -461,6 +470,12 @@ private:
             { "halide.hexagon.mul.vw.vh", wild_i32x*wild_i32x, Pattern::ReinterleaveOp0 | Pattern::NarrowOp1 },
             { "halide.hexagon.mul.vw.vuh", wild_i32x*wild_i32x, Pattern::ReinterleaveOp0 | Pattern::NarrowUnsignedOp1 },
             { "halide.hexagon.mul.vuw.vuh", wild_u32x*wild_u32x, Pattern::ReinterleaveOp0 | Pattern::NarrowUnsignedOp1 },
+
+            // Widening float16 multiplication. The product of two
+            // float16 values is exact in float32. The runtime
+            // interleaves the result, because call_intrin can't pass
+            // float vectors to the integer interleave.
+            { "halide.hexagon.mpy.vhf.vhf", wild_f32x*wild_f32x, Pattern::NarrowOps | Pattern::v68orLater },
         };
 
         if (op->type.is_vector()) {
@@ -537,11 +552,54 @@ private:
             std::stable_sort(mpys.begin(), mpys.end(), LoadCompare());
         }
     }
+
+    Expr visit(const VectorReduce *op) override {
+        // A horizontal sum of groups of four products of 8-bit values
+        // is exactly what vrmpy computes, with no deinterleaving of
+        // the operands required.
+        const int input_lanes = op->value.type().lanes();
+        const int factor = input_lanes / op->type.lanes();
+        const Mul *mul = op->value.as<Mul>();
+        if (op->op == VectorReduce::Add &&
+            op->type.is_vector() &&
+            (op->type.is_int() || op->type.is_uint()) &&
+            op->type.bits() == 32 &&
+            factor % 4 == 0 &&
+            mul) {
+            Expr a_u8 = lossless_cast(UInt(8, input_lanes), mul->a);
+            Expr b_u8 = lossless_cast(UInt(8, input_lanes), mul->b);
+            Expr a_i8 = lossless_cast(Int(8, input_lanes), mul->a);
+            Expr b_i8 = lossless_cast(Int(8, input_lanes), mul->b);
+            const int result_lanes = input_lanes / 4;
+            Expr new_expr;
+            if (a_u8.defined() && b_u8.defined()) {
+                new_expr = halide_hexagon_add_4mpy(UInt(32, result_lanes), ".vub.vub", a_u8, b_u8);
+            } else if (a_i8.defined() && b_i8.defined()) {
+                new_expr = halide_hexagon_add_4mpy(Int(32, result_lanes), ".vb.vb", a_i8, b_i8);
+            } else if (a_u8.defined() && b_i8.defined()) {
+                new_expr = halide_hexagon_add_4mpy(Int(32, result_lanes), ".vub.vb", a_u8, b_i8);
+            } else if (a_i8.defined() && b_u8.defined()) {
+                new_expr = halide_hexagon_add_4mpy(Int(32, result_lanes), ".vub.vb", b_u8, a_i8);
+            }
+            if (new_expr.defined()) {
+                if (new_expr.type() != op->type.with_lanes(result_lanes)) {
+                    // The sums are the same bits regardless of signedness.
+                    new_expr = reinterpret(op->type.with_lanes(result_lanes), new_expr);
+                }
+                if (factor > 4) {
+                    new_expr = VectorReduce::make(VectorReduce::Add, new_expr, op->type.lanes());
+                }
+                return mutate(new_expr);
+            }
+        }
+        return IRMutator::visit(op);
+    }
+
     Expr visit(const Add *op) override {
         // vmpa, vdmpy, and vrmpy instructions are hard to match with
         // patterns, do it manually here.
         // Try to find vrmpy opportunities first, which consume 4 operands.
-        if (op->type.is_vector() && (op->type.bits() == 16 || op->type.bits() == 32)) {
+        if (op->type.is_vector() && !op->type.is_float() && (op->type.bits() == 16 || op->type.bits() == 32)) {
             int lanes = op->type.lanes();
             vector<MulExpr> mpys;
             Expr rest;
@@ -698,6 +756,10 @@ private:
             { "halide.hexagon.acc_add_4mpy.vw.vub.vb",      wild_i32x + halide_hexagon_add_4mpy(Int(32, 0),  ".vub.vb", wild_u8x, wild_i8x) },
             { "halide.hexagon.acc_add_4mpy.vw.vb.vb",       wild_i32x + halide_hexagon_add_4mpy(Int(32, 0),  ".vb.vb", wild_i8x, wild_i8x) },
 
+            // Widening float16 multiply-accumulates and adds.
+            { "halide.hexagon.add_mpy.vsf.vhf.vhf", wild_f32x + wild_f32x*wild_f32x, Pattern::NarrowOp1 | Pattern::NarrowOp2 | Pattern::v68orLater },
+            { "halide.hexagon.add_vsf.vhf.vhf", wild_f32x + wild_f32x, Pattern::NarrowOps | Pattern::v68orLater },
+
             // Widening adds. There are other instructions that add two vub and two vuh but do not widen.
             // To differentiate those from the widening ones, we encode the return type in the name here.
             { "halide.hexagon.add_vuh.vub.vub", wild_u16x + wild_u16x, Pattern::InterleaveResult | Pattern::NarrowOps },
@@ -786,6 +848,7 @@ private:
                     { "halide.hexagon.sub_vuw.vuh.vuh", wild_u32x - wild_u32x, Pattern::InterleaveResult | Pattern::NarrowOps },
                     { "halide.hexagon.sub_vw.vuh.vuh", wild_i32x - wild_i32x, Pattern::InterleaveResult | Pattern::NarrowUnsignedOps },
                     { "halide.hexagon.sub_vw.vh.vh", wild_i32x - wild_i32x, Pattern::InterleaveResult | Pattern::NarrowOps },
+                    { "halide.hexagon.sub_vsf.vhf.vhf", wild_f32x - wild_f32x, Pattern::NarrowOps | Pattern::v68orLater },
                 };
 
                 Expr new_expr = apply_patterns(op, subs, target, this);
@@ -2296,8 +2359,101 @@ public:
     }
 };
 
+// Find the allocations that are candidates for VTCM: those with a
+// constant size, in the default memory type, realized inside a loop.
+class FindVTCMCandidates : public IRVisitor {
+    int loop_depth = 0;
+    int copies = 1;
+
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        int old_copies = copies;
+        if (op->for_type == ForType::Parallel) {
+            // Each thread has its own copy of the allocations inside
+            // the loop, and there are up to 4 HVX contexts.
+            copies *= 4;
+        }
+        loop_depth++;
+        IRVisitor::visit(op);
+        loop_depth--;
+        copies = old_copies;
+    }
+
+    void visit(const Allocate *op) override {
+        if (loop_depth > 0 &&
+            op->memory_type == MemoryType::Auto &&
+            !op->new_expr.defined()) {
+            int64_t size = (int64_t)op->constant_allocation_size() * op->type.bytes() * copies;
+            if (size > 0) {
+                candidates.push_back({op->name, size, loop_depth});
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    struct Candidate {
+        string name;
+        int64_t size;
+        int loop_depth;
+    };
+    vector<Candidate> candidates;
+};
+
+class PlaceInVTCM : public IRMutator {
+    const set<string> &names;
+
+    using IRMutator::visit;
+
+    Stmt visit(const Allocate *op) override {
+        Stmt s = IRMutator::visit(op);
+        if (names.count(op->name)) {
+            op = s.as<Allocate>();
+            internal_assert(op);
+            return Allocate::make(op->name, op->type, MemoryType::VTCM, op->extents,
+                                  op->condition, op->body, op->new_expr, op->free_function);
+        }
+        return s;
+    }
+
+public:
+    PlaceInVTCM(const set<string> &names) : names(names) {}
+};
+
 }  // namespace
 
+Stmt place_allocations_in_vtcm(Stmt s, int64_t budget) {
+    FindVTCMCandidates finder;
+    s.accept(&finder);
+
+    // Use the loop depth as a proxy for how often an allocation is
+    // accessed, and take the most deeply nested ones first. Among
+    // allocations at the same depth, prefer smaller ones, so more of
+    // them fit. All the chosen allocations must fit at once, because
+    // we don't know which of them are live at the same time.
+    vector<FindVTCMCandidates::Candidate> &candidates = finder.candidates;
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const FindVTCMCandidates::Candidate &a, const FindVTCMCandidates::Candidate &b) {
+                         if (a.loop_depth != b.loop_depth) {
+                             return a.loop_depth > b.loop_depth;
+                         }
+                         return a.size < b.size;
+                     });
+    set<string> names;
+    for (const auto &c : candidates) {
+        if (c.size <= budget) {
+            debug(2) << "Placing allocation " << c.name << " of " << c.size << " bytes in VTCM\n";
+            names.insert(c.name);
+            budget -= c.size;
+        }
+    }
+    if (names.empty()) {
+        return s;
+    }
+    return PlaceInVTCM(names).mutate(s);
+}
+
 Stmt optimize_hexagon_shuffles(Stmt s, int lut_alignment) {
     // Replace indirect and other complicated loads with
     // dynamic_shuffle (vlut) calls.
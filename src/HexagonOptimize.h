@@ -25,6 +25,12 @@ Stmt vtmpy_generator(Stmt s);
  *     2. out(idx(x)) = foo(x) -> vscatter */
 Stmt scatter_gather_generator(Stmt s);
 
+/** Change the memory type of some allocations realized inside loops
+ * from MemoryType::Auto to MemoryType::VTCM, preferring the most
+ * deeply nested ones, while their total size fits in 'budget'
+ * bytes. */
+Stmt place_allocations_in_vtcm(Stmt s, int64_t budget);
+
 /** Hexagon deinterleaves when performing widening operations, and
  * interleaves when performing narrowing operations. This pass
  * rewrites widenings/narrowings to be explicit in the IR, and
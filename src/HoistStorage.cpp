@@ -0,0 +1,471 @@
+#include "HoistStorage.h"
+#include "CodeGen_Internal.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "SplitTuples.h"
+
+#include <set>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Allocations that codegen will place on the stack or in registers are
+// already free, so there's no point taking them from a pool or arena.
+bool can_pool_allocation(const Allocate *op) {
+    if (op->extents.empty() ||
+        (op->memory_type != MemoryType::Auto &&
+         op->memory_type != MemoryType::Heap)) {
+        return false;
+    }
+    int32_t constant_bytes = Allocate::constant_allocation_size(op->extents, op->name) * op->type.bytes();
+    return !(op->memory_type == MemoryType::Auto &&
+             constant_bytes > 0 &&
+             can_allocation_fit_on_stack(constant_bytes));
+}
+
+// The number of bytes to request for an allocation. This matches the
+// size codegen would pass to halide_malloc, including the padding for
+// reading one scalar past the end.
+Expr pooled_allocation_size(const Allocate *op) {
+    Expr size = make_const(UInt(64), op->type.bytes());
+    for (const Expr &e : op->extents) {
+        size *= cast(UInt(64), e);
+    }
+    size += op->type.bytes();
+    if (!is_one(op->condition)) {
+        size = select(op->condition, size, make_zero(UInt(64)));
+    }
+    return size;
+}
+
+bool is_device_loop(const For *op) {
+    return (op->device_api != DeviceAPI::Host &&
+            op->device_api != DeviceAPI::None);
+}
+
+class HoistStorage : public IRMutator {
+    using IRMutator::visit;
+
+    // The Funcs with a hoist_storage level, keyed by the names of
+    // their allocations.
+    map<string, Function> hoisted;
+
+    // The Funcs whose pools are in scope, by Func name.
+    Scope<> pools;
+
+    // The Funcs whose pools have had an allocation rewritten to use them.
+    std::set<string> used;
+
+    // How many device loops we're inside.
+    int in_device_loop = 0;
+
+    static string pool_name(const Function &f) {
+        return f.name() + ".memory_pool";
+    }
+
+    Stmt wrap_with_pool(const Function &f, const Stmt &body) {
+        if (!used.count(f.name())) {
+            return body;
+        }
+        used.erase(f.name());
+        Expr pool = Variable::make(Handle(), pool_name(f));
+        Stmt destroy =
+            Evaluate::make(Call::make(Int(32), Call::register_destructor,
+                                      {Expr("halide_memory_pool_destroy"), pool}, Call::Intrinsic));
+        Expr create = Call::make(Handle(), "halide_memory_pool_create", {}, Call::Extern);
+        return LetStmt::make(pool_name(f), create, Block::make(destroy, body));
+    }
+
+    Stmt visit(const For *op) override {
+        vector<Function> here;
+        for (const auto &p : hoisted) {
+            const Function &f = p.second;
+            if (f.name() != p.first && p.first != f.name() + ".0") {
+                // Only consider each Func once, via its first allocation.
+                continue;
+            }
+            if (f.schedule().hoist_storage_level().match(op->name)) {
+                user_assert(!pools.contains(f.name()))
+                    << "Func " << f.name() << " has more than one hoist_storage site.\n";
+                here.push_back(f);
+            }
+        }
+
+        for (const Function &f : here) {
+            pools.push(f.name());
+        }
+        bool device_loop = is_device_loop(op);
+        in_device_loop += device_loop;
+        Stmt body = mutate(op->body);
+        in_device_loop -= device_loop;
+        for (const Function &f : here) {
+            pools.pop(f.name());
+            body = wrap_with_pool(f, body);
+        }
+
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+    Stmt visit(const Allocate *op) override {
+        auto it = hoisted.find(op->name);
+        if (it == hoisted.end() || op->new_expr.defined()) {
+            return IRMutator::visit(op);
+        }
+        const Function &f = it->second;
+
+        user_assert(pools.contains(f.name()))
+            << "Func " << f.name() << " is scheduled to hoist_storage at "
+            << f.schedule().hoist_storage_level().to_string()
+            << ", which is not outside of its store_at level "
+            << f.schedule().store_level().to_string() << ".\n";
+
+        if (in_device_loop || !can_pool_allocation(op)) {
+            return IRMutator::visit(op);
+        }
+
+        Stmt body = mutate(op->body);
+
+        used.insert(f.name());
+        Expr pool = Variable::make(Handle(), pool_name(f));
+        Expr new_expr = Call::make(Handle(), "halide_memory_pool_acquire",
+                                   {pool, pooled_allocation_size(op)}, Call::Extern);
+        return Allocate::make(op->name, op->type, op->memory_type, op->extents, op->condition,
+                              body, new_expr, "halide_memory_pool_release");
+    }
+
+public:
+    HoistStorage(const map<string, Function> &env) {
+        for (const auto &p : env) {
+            const Function &f = p.second;
+            if (f.schedule().hoist_storage_level().is_inlined()) {
+                continue;
+            }
+            if (f.outputs() == 1 || interleaves_tuple(f, env)) {
+                hoisted.emplace(f.name(), f);
+            } else {
+                for (int i = 0; i < f.outputs(); i++) {
+                    hoisted.emplace(f.name() + "." + std::to_string(i), f);
+                }
+            }
+        }
+    }
+
+    Stmt run(const Stmt &s) {
+        if (hoisted.empty()) {
+            return s;
+        }
+        vector<Function> root;
+        for (const auto &p : hoisted) {
+            const Function &f = p.second;
+            if ((p.first == f.name() || p.first == f.name() + ".0") &&
+                f.schedule().hoist_storage_level().is_root()) {
+                root.push_back(f);
+            }
+        }
+        for (const Function &f : root) {
+            pools.push(f.name());
+        }
+        Stmt result = mutate(s);
+        for (const Function &f : root) {
+            pools.pop(f.name());
+            result = wrap_with_pool(f, result);
+        }
+        return result;
+    }
+};
+
+// Allocations that run once per invocation of the pipeline go in the
+// arena. Allocations inside loops would make the arena grow without
+// bound, so they share a memory pool instead, which holds roughly one
+// block per worker thread.
+class InjectArenaAllocations : public IRMutator {
+    using IRMutator::visit;
+
+    int loop_depth = 0;
+    int in_device_loop = 0;
+
+    Stmt visit(const For *op) override {
+        bool device_loop = is_device_loop(op);
+        loop_depth++;
+        in_device_loop += device_loop;
+        Stmt stmt = IRMutator::visit(op);
+        in_device_loop -= device_loop;
+        loop_depth--;
+        return stmt;
+    }
+
+    Stmt visit(const Allocate *op) override {
+        if (op->new_expr.defined() || in_device_loop || !can_pool_allocation(op)) {
+            return IRMutator::visit(op);
+        }
+        Stmt body = mutate(op->body);
+        Expr new_expr;
+        string free_function;
+        if (loop_depth == 0) {
+            used_arena = true;
+            new_expr = Call::make(Handle(), "halide_arena_alloc",
+                                  {Variable::make(Handle(), arena_name), pooled_allocation_size(op)},
+                                  Call::Extern);
+            free_function = "halide_arena_free";
+        } else {
+            used_pool = true;
+            new_expr = Call::make(Handle(), "halide_memory_pool_acquire",
+                                  {Variable::make(Handle(), pool_name), pooled_allocation_size(op)},
+                                  Call::Extern);
+            free_function = "halide_memory_pool_release";
+        }
+        return Allocate::make(op->name, op->type, op->memory_type, op->extents, op->condition,
+                              body, new_expr, free_function);
+    }
+
+public:
+    const string arena_name = "pipeline_arena";
+    const string pool_name = "pipeline_memory_pool";
+    bool used_arena = false, used_pool = false;
+};
+
+// Allocations at the same loop level whose lifetimes don't overlap
+// (because inject_early_frees has placed the Free of one before the
+// other is allocated) take their memory from a shared memory pool, so
+// that a later one reuses the block released by an earlier one instead
+// of making a fresh heap allocation. The pools are created once per
+// pipeline invocation, so allocations inside loops also reuse their
+// blocks from one iteration to the next.
+class ShareAllocations : public IRMutator {
+    using IRMutator::visit;
+
+    // Find the lifetimes of the allocations in the straight-line part
+    // of a loop level, i.e. not inside any inner loop or branch, as
+    // positions in program order.
+    class FindLifetimes : public IRVisitor {
+        using IRVisitor::visit;
+
+        int position = 0;
+        map<string, size_t> open;
+
+        void visit(const For *op) override {
+            position++;
+        }
+
+        void visit(const IfThenElse *op) override {
+            position++;
+        }
+
+        void visit(const Fork *op) override {
+            position++;
+        }
+
+        void visit(const Acquire *op) override {
+            position++;
+        }
+
+        void visit(const Allocate *op) override {
+            size_t idx = lifetimes.size();
+            lifetimes.push_back({op, position++, -1});
+            open[op->name] = idx;
+            op->body.accept(this);
+            auto it = open.find(op->name);
+            if (it != open.end() && it->second == idx) {
+                lifetimes[idx].end = position++;
+                open.erase(it);
+            }
+        }
+
+        void visit(const Free *op) override {
+            auto it = open.find(op->name);
+            if (it != open.end()) {
+                lifetimes[it->second].end = position++;
+                open.erase(it);
+            }
+        }
+
+    public:
+        struct Lifetime {
+            const Allocate *op;
+            int begin, end;
+        };
+        vector<Lifetime> lifetimes;
+    };
+
+    // The pool each shared allocation takes its memory from.
+    map<const Allocate *, string> pool_for;
+
+    int in_device_loop = 0;
+
+    // Assign the allocations of the loop level starting at s to pools,
+    // greedily in order of allocation. An allocation can join a pool
+    // once the last allocation in the pool has been freed.
+    void share_level(const Stmt &s) {
+        if (in_device_loop || !s.defined()) {
+            return;
+        }
+        FindLifetimes finder;
+        s.accept(&finder);
+
+        std::set<const Allocate *> seen, repeated;
+        for (const auto &l : finder.lifetimes) {
+            if (!seen.insert(l.op).second) {
+                repeated.insert(l.op);
+            }
+        }
+
+        struct Slot {
+            vector<const Allocate *> members;
+            int end;
+        };
+        vector<Slot> slots;
+        for (const auto &l : finder.lifetimes) {
+            const Allocate *op = l.op;
+            if (op->new_expr.defined() ||
+                !op->free_function.empty() ||
+                !can_pool_allocation(op) ||
+                repeated.count(op)) {
+                continue;
+            }
+            Slot *slot = nullptr;
+            for (Slot &candidate : slots) {
+                if (candidate.end < l.begin) {
+                    slot = &candidate;
+                    break;
+                }
+            }
+            if (!slot) {
+                slots.emplace_back();
+                slot = &slots.back();
+            }
+            slot->members.push_back(op);
+            slot->end = l.end;
+        }
+
+        for (const Slot &slot : slots) {
+            if (slot.members.size() < 2) {
+                continue;
+            }
+            string pool = "shared_memory_pool." + std::to_string(pools.size());
+            pools.push_back(pool);
+            for (const Allocate *op : slot.members) {
+                debug(3) << "Allocation " << op->name << " shares " << pool << "\n";
+                pool_for[op] = pool;
+            }
+        }
+    }
+
+    Stmt mutate_level(const Stmt &s) {
+        share_level(s);
+        return mutate(s);
+    }
+
+    Stmt visit(const For *op) override {
+        bool device_loop = is_device_loop(op);
+        in_device_loop += device_loop;
+        Stmt body = mutate_level(op->body);
+        in_device_loop -= device_loop;
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+    Stmt visit(const IfThenElse *op) override {
+        Stmt then_case = mutate_level(op->then_case);
+        Stmt else_case = mutate_level(op->else_case);
+        if (then_case.same_as(op->then_case) &&
+            else_case.same_as(op->else_case)) {
+            return op;
+        }
+        return IfThenElse::make(op->condition, then_case, else_case);
+    }
+
+    Stmt visit(const Fork *op) override {
+        Stmt first = mutate_level(op->first);
+        Stmt rest = mutate_level(op->rest);
+        if (first.same_as(op->first) &&
+            rest.same_as(op->rest)) {
+            return op;
+        }
+        return Fork::make(first, rest);
+    }
+
+    Stmt visit(const Acquire *op) override {
+        Stmt body = mutate_level(op->body);
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return Acquire::make(op->semaphore, op->count, body);
+    }
+
+    Stmt visit(const Allocate *op) override {
+        auto it = pool_for.find(op);
+        if (it == pool_for.end()) {
+            return IRMutator::visit(op);
+        }
+        Expr pool = Variable::make(Handle(), it->second);
+        Expr new_expr = Call::make(Handle(), "halide_memory_pool_acquire",
+                                   {pool, pooled_allocation_size(op)}, Call::Extern);
+        Stmt body = mutate(op->body);
+        return Allocate::make(op->name, op->type, op->memory_type, op->extents, op->condition,
+                              body, new_expr, "halide_memory_pool_release");
+    }
+
+public:
+    vector<string> pools;
+
+    Stmt run(const Stmt &s) {
+        Stmt result = mutate_level(s);
+        for (const string &name : pools) {
+            Expr pool = Variable::make(Handle(), name);
+            Stmt destroy =
+                Evaluate::make(Call::make(Int(32), Call::register_destructor,
+                                          {Expr("halide_memory_pool_destroy"), pool}, Call::Intrinsic));
+            Expr create = Call::make(Handle(), "halide_memory_pool_create", {}, Call::Extern);
+            result = LetStmt::make(name, create, Block::make(destroy, result));
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+Stmt share_allocations(const Stmt &s) {
+    return ShareAllocations().run(s);
+}
+
+Stmt inject_arena_allocations(const Stmt &s) {
+    InjectArenaAllocations injector;
+    Stmt result = injector.mutate(s);
+    if (injector.used_pool) {
+        Expr pool = Variable::make(Handle(), injector.pool_name);
+        Stmt destroy =
+            Evaluate::make(Call::make(Int(32), Call::register_destructor,
+                                      {Expr("halide_memory_pool_destroy"), pool}, Call::Intrinsic));
+        Expr create = Call::make(Handle(), "halide_memory_pool_create", {}, Call::Extern);
+        result = LetStmt::make(injector.pool_name, create, Block::make(destroy, result));
+    }
+    if (injector.used_arena) {
+        Expr arena = Variable::make(Handle(), injector.arena_name);
+        Stmt destroy =
+            Evaluate::make(Call::make(Int(32), Call::register_destructor,
+                                      {Expr("halide_arena_destroy"), arena}, Call::Intrinsic));
+        Expr create = Call::make(Handle(), "halide_arena_create", {}, Call::Extern);
+        result = LetStmt::make(injector.arena_name, create, Block::make(destroy, result));
+    }
+    return result;
+}
+
+Stmt hoist_storage(const Stmt &s, const map<string, Function> &env) {
+    return HoistStorage(env).run(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,46 @@
+#ifndef HALIDE_HOIST_STORAGE_H
+#define HALIDE_HOIST_STORAGE_H
+
+/** \file
+ * Defines the lowering passes that take heap allocations from
+ * longer-lived pools instead of calling halide_malloc for each one.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+class Function;
+
+/** For each Func scheduled with hoist_storage, create a memory pool at
+ * the hoist_storage level, and rewrite the heap allocations of that
+ * Func inside it to acquire their memory from the pool and release it
+ * back afterwards, instead of calling halide_malloc and halide_free on
+ * every iteration of the enclosing loops. */
+Stmt hoist_storage(const Stmt &s, const std::map<std::string, Function> &env);
+
+/** Find heap allocations at the same loop level whose lifetimes, as
+ * bounded by the markers from inject_early_frees, don't overlap, and
+ * make them acquire their memory from a shared memory pool created
+ * once per pipeline invocation. A later allocation then reuses the
+ * block released by an earlier one, so the memory held for a sequence
+ * of such allocations is that of the largest rather than their sum.
+ * Allocations already rewritten by hoist_storage are left alone. Used
+ * for Target::ShareAllocations. */
+Stmt share_allocations(const Stmt &s);
+
+/** Used for Target::ArenaAlloc. Heap allocations that happen once per
+ * invocation of the pipeline are carved out of an arena, and heap
+ * allocations inside loops are taken from a memory pool shared by the
+ * whole pipeline. Both are released in bulk when the pipeline
+ * finishes. Allocations already rewritten by hoist_storage are left
+ * alone. */
+Stmt inject_arena_allocations(const Stmt &s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
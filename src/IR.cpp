@@ -355,6 +355,15 @@ Stmt Acquire::make(Expr semaphore, Expr count, Stmt body) {
     return node;
 }
 
+Stmt Atomic::make(const std::string &producer_name, Stmt body) {
+    internal_assert(body.defined()) << "Atomic with undefined body\n";
+
+    Atomic *node = new Atomic;
+    node->producer_name = producer_name;
+    node->body = std::move(body);
+    return node;
+}
+
 Stmt Store::make(const std::string &name, Expr value, Expr index, Parameter param, Expr predicate, ModulusRemainder alignment) {
     internal_assert(predicate.defined()) << "Store with undefined predicate\n";
     internal_assert(value.defined()) << "Store of undefined\n";
@@ -776,6 +785,22 @@ bool Shuffle::is_extract_element() const {
     return indices.size() == 1;
 }
 
+Expr VectorReduce::make(VectorReduce::Operator op, Expr value, int lanes) {
+    internal_assert(value.defined()) << "VectorReduce of undefined Expr\n";
+    internal_assert(lanes > 0 && value.type().lanes() % lanes == 0)
+        << "VectorReduce to " << lanes << " lanes from a vector of "
+        << value.type().lanes() << " lanes\n";
+    if (op == VectorReduce::And || op == VectorReduce::Or) {
+        internal_assert(!value.type().is_float()) << "Logical VectorReduce of a float vector\n";
+    }
+
+    VectorReduce *node = new VectorReduce;
+    node->type = value.type().with_lanes(lanes);
+    node->value = std::move(value);
+    node->op = op;
+    return node;
+}
+
 template<> void ExprNode<IntImm>::accept(IRVisitor *v) const { v->visit((const IntImm *)this); }
 template<> void ExprNode<UIntImm>::accept(IRVisitor *v) const { v->visit((const UIntImm *)this); }
 template<> void ExprNode<FloatImm>::accept(IRVisitor *v) const { v->visit((const FloatImm *)this); }
@@ -804,6 +829,7 @@ template<> void ExprNode<Ramp>::accept(IRVisitor *v) const { v->visit((const Ram
 template<> void ExprNode<Broadcast>::accept(IRVisitor *v) const { v->visit((const Broadcast *)this); }
 template<> void ExprNode<Call>::accept(IRVisitor *v) const { v->visit((const Call *)this); }
 template<> void ExprNode<Shuffle>::accept(IRVisitor *v) const { v->visit((const Shuffle *)this); }
+template<> void ExprNode<VectorReduce>::accept(IRVisitor *v) const { v->visit((const VectorReduce *)this); }
 template<> void ExprNode<Let>::accept(IRVisitor *v) const { v->visit((const Let *)this); }
 template<> void StmtNode<LetStmt>::accept(IRVisitor *v) const { v->visit((const LetStmt *)this); }
 template<> void StmtNode<AssertStmt>::accept(IRVisitor *v) const { v->visit((const AssertStmt *)this); }
@@ -820,6 +846,7 @@ template<> void StmtNode<Evaluate>::accept(IRVisitor *v) const { v->visit((const
 template<> void StmtNode<Prefetch>::accept(IRVisitor *v) const { v->visit((const Prefetch *)this); }
 template<> void StmtNode<Acquire>::accept(IRVisitor *v) const { v->visit((const Acquire *)this); }
 template<> void StmtNode<Fork>::accept(IRVisitor *v) const { v->visit((const Fork *)this); }
+template<> void StmtNode<Atomic>::accept(IRVisitor *v) const { v->visit((const Atomic *)this); }
 
 template<> Expr ExprNode<IntImm>::mutate_expr(IRMutator *v) const { return v->visit((const IntImm *)this); }
 template<> Expr ExprNode<UIntImm>::mutate_expr(IRMutator *v) const { return v->visit((const UIntImm *)this); }
@@ -849,6 +876,7 @@ template<> Expr ExprNode<Ramp>::mutate_expr(IRMutator *v) const { return v->visi
 template<> Expr ExprNode<Broadcast>::mutate_expr(IRMutator *v) const { return v->visit((const Broadcast *)this); }
 template<> Expr ExprNode<Call>::mutate_expr(IRMutator *v) const { return v->visit((const Call *)this); }
 template<> Expr ExprNode<Shuffle>::mutate_expr(IRMutator *v) const { return v->visit((const Shuffle *)this); }
+template<> Expr ExprNode<VectorReduce>::mutate_expr(IRMutator *v) const { return v->visit((const VectorReduce *)this); }
 template<> Expr ExprNode<Let>::mutate_expr(IRMutator *v) const { return v->visit((const Let *)this); }
 
 template<> Stmt StmtNode<LetStmt>::mutate_stmt(IRMutator *v) const { return v->visit((const LetStmt *)this); }
@@ -866,6 +894,7 @@ template<> Stmt StmtNode<Evaluate>::mutate_stmt(IRMutator *v) const { return v->
 template<> Stmt StmtNode<Prefetch>::mutate_stmt(IRMutator *v) const { return v->visit((const Prefetch *)this); }
 template<> Stmt StmtNode<Acquire>::mutate_stmt(IRMutator *v) const { return v->visit((const Acquire *)this); }
 template<> Stmt StmtNode<Fork>::mutate_stmt(IRMutator *v) const { return v->visit((const Fork *)this); }
+template<> Stmt StmtNode<Atomic>::mutate_stmt(IRMutator *v) const { return v->visit((const Atomic *)this); }
 
 Call::ConstString Call::debug_to_file = "debug_to_file";
 Call::ConstString Call::reinterpret = "reinterpret";
@@ -918,6 +947,7 @@ Call::ConstString Call::unsafe_promise_clamped = "unsafe_promise_clamped";
 Call::ConstString Call::gpu_thread_barrier = "gpu_thread_barrier";
 Call::ConstString Call::mulhi_shr = "mulhi_shr";
 Call::ConstString Call::sorted_avg = "sorted_avg";
+Call::ConstString Call::bounds_check_cache = "bounds_check_cache";
 
 Call::ConstString Call::buffer_get_dimensions = "_halide_buffer_get_dimensions";
 Call::ConstString Call::buffer_get_min = "_halide_buffer_get_min";
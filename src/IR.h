@@ -547,7 +547,8 @@ struct Call : public ExprNode<Call> {
         unsafe_promise_clamped,
         gpu_thread_barrier,
         mulhi_shr, // Compute high_half(arg[0] * arg[1]) >> arg[3]. Note that this is a shift in addition to taking the upper half of multiply result. arg[3] must be an unsigned integer immediate.
-        sorted_avg; // Compute (arg[0] + arg[1]) / 2, assuming arg[0] < arg[1].
+        sorted_avg, // Compute (arg[0] + arg[1]) / 2, assuming arg[0] < arg[1].
+        bounds_check_cache; // A pointer to zero-initialized static storage for halide_bounds_check_cache_lookup with room for arg[0] key values.
 
     // We also declare some symbolic names for some of the runtime
     // functions that we want to construct Call nodes to here to avoid
@@ -769,6 +770,37 @@ struct Shuffle : public ExprNode<Shuffle> {
     static const IRNodeType _node_type = IRNodeType::Shuffle;
 };
 
+/** Horizontally reduce a vector to a vector with fewer lanes, using
+ * an associative and commutative binary operator. The input lanes are
+ * split into groups of adjacent lanes, one for each output lane, so
+ * lane i of the result is the reduction of lanes [i*f, (i+1)*f) of the
+ * value, where f is the input lanes divided by the output lanes. Each
+ * backend lowers this to its horizontal reduction instructions where it
+ * has them. Produced when vectorizing an associative update of a
+ * location that doesn't depend on the vectorized variable. */
+struct VectorReduce : public ExprNode<VectorReduce> {
+    // 99.9% of the time people will use this for horizontal addition,
+    // but these are all of the associative and commutative ops in
+    // the IR.
+    typedef enum {
+        Add,
+        Mul,
+        Min,
+        Max,
+        And,
+        Or,
+    } Operator;
+
+    Expr value;
+    Operator op;
+
+    /** Make a VectorReduce with the given number of output lanes,
+     * which must divide the lanes of the value. */
+    static Expr make(Operator op, Expr value, int lanes);
+
+    static const IRNodeType _node_type = IRNodeType::VectorReduce;
+};
+
 /** Represent a multi-dimensional region of a Func or an ImageParam that
  * needs to be prefetched. */
 struct Prefetch : public StmtNode<Prefetch> {
@@ -788,6 +820,19 @@ struct Prefetch : public StmtNode<Prefetch> {
     static const IRNodeType _node_type = IRNodeType::Prefetch;
 };
 
+/** Lock all the Store nodes to the named producer in the body so that
+ * they are performed atomically. Stores whose value reads back the
+ * location being stored to become atomic read-modify-writes. Produced
+ * by the atomic() scheduling directive. */
+struct Atomic : public StmtNode<Atomic> {
+    std::string producer_name;
+    Stmt body;
+
+    static Stmt make(const std::string &producer_name, Stmt body);
+
+    static const IRNodeType _node_type = IRNodeType::Atomic;
+};
+
 }  // namespace Internal
 }  // namespace Halide
 
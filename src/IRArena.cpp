@@ -0,0 +1,171 @@
+#include "IRArena.h"
+#include "Debug.h"
+#include "Expr.h"
+#include "Util.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// Allocations from a chunk are rounded up to this, to keep nodes
+// aligned like malloc would.
+const size_t alignment = 16;
+
+// The usable size of each chunk. Allocations larger than an eighth of
+// a chunk go to the heap, so that a chunk isn't retired while mostly
+// empty.
+const size_t chunk_size = 64 * 1024;
+
+IRArena *&current_arena() {
+    static thread_local IRArena *arena = nullptr;
+    return arena;
+}
+
+// The number of chunks that have not been freed yet. While it is zero,
+// no node can have come from a chunk, so freeing a node skips the
+// lookup below.
+std::atomic<int> live_chunks(0);
+
+// The chunks that have not been freed yet, by the address of their
+// data. Never destroyed, as nodes may be freed during static
+// destruction.
+std::mutex &chunks_mutex() {
+    static std::mutex *m = new std::mutex;
+    return *m;
+}
+
+std::map<const char *, void *> &chunks_by_address() {
+    static std::map<const char *, void *> *m = new std::map<const char *, void *>;
+    return *m;
+}
+
+}  // namespace
+
+struct IRArena::Chunk {
+    // One count for each live node allocated from this chunk, plus
+    // one held by the arena for as long as it is allocating from it.
+    std::atomic<int> live;
+    size_t used;
+
+    Chunk() : live(1), used(0) {}
+
+    char *data() {
+        return (char *)this + chunk_header_size();
+    }
+
+    static size_t chunk_header_size() {
+        return (sizeof(Chunk) + alignment - 1) / alignment * alignment;
+    }
+};
+
+bool IRArena::enabled() {
+    static bool on = get_env_variable("HL_IR_ARENA") == "1";
+    return on;
+}
+
+IRArena::IRArena() :
+    chunk(nullptr), enclosing(current_arena()), active(enabled()),
+    chunks_allocated(0), bytes_allocated(0) {
+    if (active) {
+        current_arena() = this;
+    }
+}
+
+IRArena::~IRArena() {
+    if (!active) {
+        return;
+    }
+    if (chunk) {
+        release(chunk);
+    }
+    current_arena() = enclosing;
+    debug(1) << "IR arena allocated " << bytes_allocated << " bytes of IR nodes in "
+             << chunks_allocated << " chunks\n";
+}
+
+void IRArena::release(Chunk *c) {
+    if (c->live.fetch_sub(1) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(chunks_mutex());
+            chunks_by_address().erase(c->data());
+        }
+        live_chunks--;
+        c->~Chunk();
+        ::operator delete((void *)c);
+    }
+}
+
+IRArena::Chunk *IRArena::find_chunk(const void *p) {
+    std::lock_guard<std::mutex> lock(chunks_mutex());
+    const std::map<const char *, void *> &chunks = chunks_by_address();
+    // The last chunk starting at or before p.
+    auto it = chunks.upper_bound((const char *)p);
+    if (it == chunks.begin()) {
+        return nullptr;
+    }
+    --it;
+    if ((const char *)p >= it->first + chunk_size) {
+        return nullptr;
+    }
+    return (Chunk *)it->second;
+}
+
+void IRArena::new_chunk() {
+    if (chunk) {
+        release(chunk);
+    }
+    void *mem = ::operator new(Chunk::chunk_header_size() + chunk_size);
+    chunk = new (mem) Chunk;
+    live_chunks++;
+    {
+        std::lock_guard<std::mutex> lock(chunks_mutex());
+        chunks_by_address()[chunk->data()] = chunk;
+    }
+    chunks_allocated++;
+}
+
+void *IRArena::allocate(size_t size) {
+    IRArena *arena = current_arena();
+    size_t total = (size + alignment - 1) / alignment * alignment;
+    if (!arena || total > chunk_size / 8) {
+        return ::operator new(size);
+    }
+    if (!arena->chunk || arena->chunk->used + total > chunk_size) {
+        arena->new_chunk();
+    }
+    Chunk *c = arena->chunk;
+    char *mem = c->data() + c->used;
+    c->used += total;
+    c->live++;
+    arena->bytes_allocated += total;
+    return mem;
+}
+
+void IRArena::deallocate(void *p) {
+    if (!p) {
+        return;
+    }
+    Chunk *c = live_chunks.load() ? find_chunk(p) : nullptr;
+    if (c) {
+        release(c);
+    } else {
+        ::operator delete(p);
+    }
+}
+
+void *IRNode::operator new(size_t size) {
+    return IRArena::allocate(size);
+}
+
+void IRNode::operator delete(void *p) {
+    IRArena::deallocate(p);
+}
+
+}  // namespace Internal
+}  // namespace Halide
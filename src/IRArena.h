@@ -0,0 +1,69 @@
+#ifndef HALIDE_IR_ARENA_H
+#define HALIDE_IR_ARENA_H
+
+/** \file
+ * An optional arena for the IR nodes created during lowering.
+ */
+
+#include <stddef.h>
+
+namespace Halide {
+namespace Internal {
+
+/** While one of these is alive, the IR nodes created on this thread
+ * are bump-allocated from large chunks instead of individually on the
+ * heap. The address range of each chunk is registered, so that freeing
+ * a node can find the chunk it came from, and each chunk counts its
+ * live nodes. A chunk is freed in bulk once it has been
+ * filled (or the arena has been destroyed) and its last node has been
+ * freed, so nodes may outlive the arena, or be freed on another
+ * thread. This makes it safe to wrap all of lowering in an arena,
+ * even though some nodes, such as those of the lowered Stmt, are
+ * retained afterwards. A long-lived node does keep the rest of its
+ * chunk from being reused, so the arena trades peak memory for fewer
+ * calls to malloc.
+ *
+ * The arena is only used if the environment variable HL_IR_ARENA is
+ * set to 1; otherwise constructing one does nothing. While no chunks
+ * exist, IR nodes are allocated and freed with plain operator new and
+ * delete, with no per-node overhead. Arenas may be nested, in which
+ * case the innermost one is used. */
+class IRArena {
+    struct Chunk;
+
+    /** The chunk currently being allocated from. */
+    Chunk *chunk;
+
+    /** The arena that was active on this thread before this one. */
+    IRArena *enclosing;
+
+    bool active;
+    size_t chunks_allocated, bytes_allocated;
+
+    static void release(Chunk *c);
+    static Chunk *find_chunk(const void *p);
+    void new_chunk();
+
+public:
+    /** Is HL_IR_ARENA set to 1? */
+    static bool enabled();
+
+    IRArena();
+    ~IRArena();
+
+    IRArena(const IRArena &) = delete;
+    IRArena &operator=(const IRArena &) = delete;
+
+    /** Allocate or free the memory for an IR node, from the arena
+     * active on this thread if there is one, and from the heap
+     * otherwise. These implement IRNode's operator new and delete. */
+    // @{
+    static void *allocate(size_t size);
+    static void deallocate(void *p);
+    // @}
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
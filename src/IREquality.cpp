@@ -91,7 +91,9 @@ private:
     void visit(const IfThenElse *) override;
     void visit(const Evaluate *) override;
     void visit(const Shuffle *) override;
+    void visit(const VectorReduce *) override;
     void visit(const Prefetch *) override;
+    void visit(const Atomic *) override;
 };
 
 template<typename T>
@@ -501,6 +503,13 @@ void IRComparer::visit(const Fork *op) {
     compare_stmt(s->rest, op->rest);
 }
 
+void IRComparer::visit(const Atomic *op) {
+    const Atomic *s = stmt.as<Atomic>();
+
+    compare_names(s->producer_name, op->producer_name);
+    compare_stmt(s->body, op->body);
+}
+
 void IRComparer::visit(const Free *op) {
     const Free *s = stmt.as<Free>();
 
@@ -532,6 +541,14 @@ void IRComparer::visit(const Shuffle *op) {
     }
 }
 
+void IRComparer::visit(const VectorReduce *op) {
+    const VectorReduce *e = expr.as<VectorReduce>();
+
+    compare_scalar(op->op, e->op);
+    // We've already compared types, so it's enough to compare the value
+    compare_expr(op->value, e->value);
+}
+
 void IRComparer::visit(const Prefetch *op) {
     const Prefetch *s = stmt.as<Prefetch>();
 
@@ -382,6 +382,9 @@ bool equal_helper(const BaseExprNode &a, const BaseExprNode &b) noexcept {
     case IRNodeType::Shuffle:
         return (equal_helper(((const Shuffle &)a).vectors, ((const Shuffle &)b).vectors) &&
                 equal_helper(((const Shuffle &)a).indices, ((const Shuffle &)b).indices));
+    case IRNodeType::VectorReduce:
+        return (((const VectorReduce &)a).op == ((const VectorReduce &)b).op &&
+                equal_helper(((const VectorReduce &)a).value, ((const VectorReduce &)b).value));
     // Explicitly list all the Stmts instead of using a default
     // clause so that if new Exprs are added without being handled
     // here we get a compile-time error.
@@ -400,6 +403,7 @@ bool equal_helper(const BaseExprNode &a, const BaseExprNode &b) noexcept {
     case IRNodeType::IfThenElse:
     case IRNodeType::Evaluate:
     case IRNodeType::Prefetch:
+    case IRNodeType::Atomic:
         ;
     }
     return false;
@@ -67,6 +67,7 @@ protected:
     virtual Expr visit(const Call *);
     virtual Expr visit(const Let *);
     virtual Expr visit(const Shuffle *);
+    virtual Expr visit(const VectorReduce *);
 
     virtual Stmt visit(const LetStmt *);
     virtual Stmt visit(const AssertStmt *);
@@ -83,6 +84,7 @@ protected:
     virtual Stmt visit(const Prefetch *);
     virtual Stmt visit(const Acquire *);
     virtual Stmt visit(const Fork *);
+    virtual Stmt visit(const Atomic *);
 };
 
 /** A mutator that caches and reapplies previously-done mutations, so
@@ -46,6 +46,34 @@ Expr evaluate_polynomial(const Expr &x, float *coeff, int n) {
         return odd_terms * std::move(x) + even_terms;
     }
 }
+
+// The same, but with coefficients in double precision that are
+// converted to the type of x.
+Expr evaluate_polynomial(const Expr &x, const std::vector<double> &coeff) {
+    const int n = (int)coeff.size();
+    internal_assert(n >= 2);
+    Type t = x.type();
+
+    Expr x2 = x * x;
+
+    Expr even_terms = Internal::make_const(t, coeff[0]);
+    Expr odd_terms = Internal::make_const(t, coeff[1]);
+
+    for (int i = 2; i < n; i++) {
+        Expr c = Internal::make_const(t, coeff[i]);
+        if ((i & 1) == 0) {
+            even_terms = even_terms * x2 + c;
+        } else {
+            odd_terms = odd_terms * x2 + c;
+        }
+    }
+
+    if ((n & 1) == 0) {
+        return even_terms * x + odd_terms;
+    } else {
+        return odd_terms * x + even_terms;
+    }
+}
 }  // namespace
 
 namespace Internal {
@@ -461,6 +489,12 @@ void match_types(Expr &a, Expr &b) {
         a = cast(tb, std::move(a));
     } else if (ta.is_float() && !tb.is_float()) {
         b = cast(ta, std::move(b));
+    } else if (ta.is_float() && tb.is_float() && ta.bits() == tb.bits()) {
+        // A float16 and a bfloat16 can't represent each other's
+        // values, so use a float32.
+        internal_assert(ta.bits() == 16) << "Could not match types: " << ta << ", " << tb << "\n";
+        a = cast(Float(32, ta.lanes()), std::move(a));
+        b = cast(Float(32, tb.lanes()), std::move(b));
     } else if (ta.is_float() && tb.is_float()) {
         // float(a) * float(b) -> float(max(a, b))
         if (ta.bits() > tb.bits()) b = cast(ta, std::move(b));
@@ -873,6 +907,356 @@ Expr fast_exp(Expr x_full) {
     return result;
 }
 
+namespace {
+
+// A polynomial approximation, and the worst error it was measured to
+// have in ulps (including range reduction). Tables of these are
+// ordered from cheapest to most accurate. sin and cos share range
+// reduction, so their entries hold both polynomials.
+struct Approximation {
+    double max_ulp_error;
+    std::vector<double> p, q;
+};
+
+// sin(r)/r and cos(r) as polynomials in r^2, for |r| <= pi/4.
+const std::vector<Approximation> &sin_cos_approximations(const Type &t) {
+    static const std::vector<Approximation> f32 = {
+        {25, {0.00815150607, -0.166624725, 0.999998569},
+         {-0.00135857798, 0.0416550152, -0.499998569, 1}},
+        {3, {-0.000195039043, 0.0083320355, -0.166666508, 1},
+         {2.43798313e-05, -0.0013886618, 0.0416666158, -0.5, 1}}};
+    static const std::vector<Approximation> f64 = {
+        {41, {-2.4756558962730345e-08, 2.7555271896482949e-06, -0.00019841263298408452,
+              0.0083333333238781934, -0.16666666666616686, 0.99999999999999567},
+         {2.0630453233714149e-09, -2.7555233871819586e-07, 2.4801578538551306e-05,
+          -0.0013888888869978966, 0.04166666666647232, -0.49999999999999251, 1}},
+        {3, {1.5894781324945172e-10, -2.5050717883455069e-08, 2.7557313383593623e-06,
+             -0.00019841269828677565, 0.0083333333333204113, -0.16666666666666616, 1},
+         {-1.1350430297965231e-11, 2.087551806634058e-09, -2.7557312555431163e-07,
+          2.4801587281665537e-05, -0.0013888888888856615, 0.041666666666666415, -0.5, 1}}};
+    return t.bits() == 64 ? f64 : f32;
+}
+
+// atan(z)/z as a polynomial in z^2, for 0 <= z <= 1.
+const std::vector<Approximation> &atan_approximations(const Type &t) {
+    static const std::vector<Approximation> f32 = {
+        {591, {0.0232860073, -0.0907520205, 0.184463561, -0.331544608, 0.999964774}},
+        {88, {-0.0131303817, 0.0565899834, -0.120448582, 0.195346594, -0.332957119, 0.999994814}},
+        {15, {0.00764835393, -0.0363604315, 0.0831264555, -0.134478644, 0.198720396,
+              -0.333256781, 0.999999225}},
+        {4, {-0.00455979211, 0.0237805191, -0.0588297546, 0.0986886546, -0.140032902,
+             0.199669614, -0.333318114, 0.999999881}}};
+    static const std::vector<Approximation> f64 = {
+        {70, {7.0631408245524322e-05, -0.0006774104064473347, 0.0030659952617582524,
+              -0.0087924346805980831, 0.018198569378988703, -0.029589011212199666,
+              0.040517789153590431, -0.049779966481504484, 0.057941923078881442,
+              -0.06646145788114842, 0.07688811662033862, -0.090904896477486022,
+              0.11111077584966235, -0.14285712646049975, 0.19999999957481809,
+              -0.33333333332893977, 0.99999999999999245}},
+        {14, {-4.5724647287636046e-05, 0.00046114696898783664, -0.0021983899962996541,
+              0.006642617408679846, -0.014458807558989187, 0.024589163383816125,
+              -0.034874503214012628, 0.043771900283004095, -0.051278290492289692,
+              0.058455877272321162, -0.066591199492233216, 0.076911700693344923,
+              -0.090907879682436479, 0.11111102499446697, -0.14285713910428319,
+              0.19999999991319245, -0.33333333333253284, 0.99999999999999878}},
+        {5, {2.9696764703810377e-05, -0.00031420447536793642, 0.0015739647120132756,
+             -0.0050004052901277893, 0.011430090129904071, -0.020330951569427099,
+             0.029924126914523379, -0.038526118794168743, 0.045668750744780703,
+             -0.052025839387999422, 0.058677762975424652, -0.066640076711691767,
+             0.07691950428565586, -0.090908751011329544, 0.11111108947286111,
+             -0.14285714201156252, 0.19999999998244453, -0.33333333333318799,
+             0.99999999999999978}}};
+    return t.bits() == 64 ? f64 : f32;
+}
+
+// tanh(x)/x as a polynomial in x^2, for |x| < 0.625.
+const std::vector<Approximation> &tanh_approximations(const Type &t) {
+    static const std::vector<Approximation> f32 = {
+        {51, {-0.0400093384, 0.130142704, -0.333090544, 0.999997079}},
+        {4, {0.0150433565, -0.0518159121, 0.133043796, -0.333319426, 0.999999881}}};
+    static const std::vector<Approximation> f64 = {
+        {67, {-0.00011314591191629327, 0.0005001644828271281, -0.0014175438621104968,
+              0.0035819502552967598, -0.0088615338972323002, 0.02186931369801557,
+              -0.053968243586573914, 0.13333333301889616, -0.33333333332962617,
+              0.99999999999999278}},
+        {5, {4.2550114208524647e-05, -0.00019640422323640141, 0.000569417522426096,
+             -0.0014494435145175507, 0.0035908324529024924, -0.0088630651374594759,
+             0.021869474474927656, -0.053968253288273912, 0.13333333331641167,
+             -0.33333333333316861, 0.99999999999999978}}};
+    return t.bits() == 64 ? f64 : f32;
+}
+
+// The cheapest approximation within the requested error, or the most
+// accurate one if none are. Zero means the cheapest.
+const Approximation &choose_approximation(const std::vector<Approximation> &table,
+                                          int max_ulp_error) {
+    if (max_ulp_error > 0) {
+        for (const Approximation &a : table) {
+            if (a.max_ulp_error <= max_ulp_error) {
+                return a;
+            }
+        }
+        return table.back();
+    }
+    return table.front();
+}
+
+// Float(16) is computed in Float(32) and cast back, where even the
+// cheapest approximation is well within half a ulp.
+Type fast_math_compute_type(const Expr &x, const char *name) {
+    user_assert(x.defined()) << name << " of undefined Expr\n";
+    Type t = x.type();
+    user_assert(t.is_float()) << name << " only works for floating-point types\n";
+    return t.bits() == 16 ? t.with_bits(32) : t;
+}
+
+int fast_math_ulp_error(const Type &t, int max_ulp_error) {
+    return t.bits() == 16 ? 0 : max_ulp_error;
+}
+
+Expr fast_sin_cos(Expr x_full, bool is_cos, int max_ulp_error) {
+    Type orig = x_full.type();
+    Type t = fast_math_compute_type(x_full, is_cos ? "fast_cos" : "fast_sin");
+    const Approximation &a = choose_approximation(sin_cos_approximations(t),
+                                                  fast_math_ulp_error(orig, max_ulp_error));
+    Expr x = cast(t, std::move(x_full));
+
+    // Reduce to [-pi/4, pi/4] with a three-part Cody-Waite
+    // representation of pi/2.
+    Expr k_real = round(x * Internal::make_const(t, 2 / M_PI));
+    Expr k = cast(Int(32, t.lanes()), k_real);
+    Expr r;
+    if (t.bits() == 64) {
+        r = x - k_real * Internal::make_const(t, 1.57079625129699707031e0);
+        r -= k_real * Internal::make_const(t, 7.54978941586159635336e-8);
+        r -= k_real * Internal::make_const(t, 5.39030285815811905290e-15);
+    } else {
+        r = x - k_real * 1.5703125f;
+        r -= k_real * 4.837512969970703125e-4f;
+        r -= k_real * 7.54978995489188216e-8f;
+    }
+
+    Expr r2 = r * r;
+    Expr s = r * evaluate_polynomial(r2, a.p);
+    Expr c = evaluate_polynomial(r2, a.q);
+
+    // cos(x) = sin(x + pi/2).
+    if (is_cos) {
+        k += 1;
+    }
+    Expr result = select((k & 1) == 1, c, s);
+    result = select((k & 2) == 2, -result, result);
+    result = Internal::common_subexpression_elimination(result);
+    return cast(orig, result);
+}
+
+// atan(z) for 0 <= z <= 1.
+Expr fast_atan_reduced(Expr z, const Approximation &a) {
+    return z * evaluate_polynomial(z * z, a.p);
+}
+
+// exp(x) for Float(64), with x in [0, 40].
+Expr fast_exp_f64(Expr x_full) {
+    Type t = x_full.type();
+    Expr k_real = floor(x_full * Internal::make_const(t, 1 / M_LN2) + Internal::make_const(t, 0.5));
+    Expr x = x_full - k_real * Internal::make_const(t, 0.693145751953125);
+    x -= k_real * Internal::make_const(t, 1.42860682030941723212e-6);
+
+    std::vector<double> coeff = {
+        2.5111436997105443e-08, 2.7632629336529454e-07, 2.7557236120797738e-06,
+        2.4801485504489075e-05, 0.00019841269895974539, 0.001388888895230353,
+        0.008333333333316496, 0.041666666666488071, 0.16666666666666688,
+        0.50000000000000189, 1, 1};
+    Expr result = evaluate_polynomial(x, coeff);
+
+    // Compute 2^k.
+    Expr biased = cast(Int(64, t.lanes()), k_real) + 1023;
+    return result * reinterpret(t, biased << 52);
+}
+
+}  // namespace
+
+Expr fast_sin(Expr x, int max_ulp_error) {
+    return fast_sin_cos(std::move(x), false, max_ulp_error);
+}
+
+Expr fast_cos(Expr x, int max_ulp_error) {
+    return fast_sin_cos(std::move(x), true, max_ulp_error);
+}
+
+Expr fast_atan(Expr x_full, int max_ulp_error) {
+    Type orig = x_full.type();
+    Type t = fast_math_compute_type(x_full, "fast_atan");
+    const Approximation &a = choose_approximation(atan_approximations(t),
+                                                  fast_math_ulp_error(orig, max_ulp_error));
+    Expr x = cast(t, std::move(x_full));
+
+    // Use atan(x) = pi/2 - atan(1/x) to reduce to [0, 1].
+    Expr ax = abs(x);
+    Expr invert = ax > Internal::make_one(t);
+    Expr z = select(invert, Internal::make_one(t) / ax, ax);
+    Expr result = fast_atan_reduced(z, a);
+    result = select(invert, Internal::make_const(t, M_PI / 2) - result, result);
+    result = select(x < Internal::make_zero(t), -result, result);
+    result = Internal::common_subexpression_elimination(result);
+    return cast(orig, result);
+}
+
+Expr fast_atan2(Expr y_full, Expr x_full, int max_ulp_error) {
+    user_assert(y_full.defined() && x_full.defined()) << "fast_atan2 of undefined Expr\n";
+    Internal::match_types(y_full, x_full);
+    Type orig = x_full.type();
+    Type t = fast_math_compute_type(x_full, "fast_atan2");
+    const Approximation &a = choose_approximation(atan_approximations(t),
+                                                  fast_math_ulp_error(orig, max_ulp_error));
+    Expr y = cast(t, std::move(y_full));
+    Expr x = cast(t, std::move(x_full));
+
+    // Reduce to the first octant, and then unfold the result.
+    Expr zero = Internal::make_zero(t);
+    Expr ax = abs(x), ay = abs(y);
+    Expr hi = max(ax, ay), lo = min(ax, ay);
+    Expr z = select(hi == zero, zero, lo / hi);
+    Expr result = fast_atan_reduced(z, a);
+    result = select(ay > ax, Internal::make_const(t, M_PI / 2) - result, result);
+    result = select(x < zero, Internal::make_const(t, M_PI) - result, result);
+    result = select(y < zero, -result, result);
+    result = Internal::common_subexpression_elimination(result);
+    return cast(orig, result);
+}
+
+Expr fast_tanh(Expr x_full, int max_ulp_error) {
+    Type orig = x_full.type();
+    Type t = fast_math_compute_type(x_full, "fast_tanh");
+    const Approximation &a = choose_approximation(tanh_approximations(t),
+                                                  fast_math_ulp_error(orig, max_ulp_error));
+    Expr x = cast(t, std::move(x_full));
+
+    // A polynomial near zero, where the other form cancels
+    // catastrophically, and 1 - 2/(exp(2|x|) + 1) elsewhere. Beyond
+    // |x| = 20 the result rounds to one anyway.
+    Expr ax = min(abs(x), Internal::make_const(t, 20));
+    Expr small = x * evaluate_polynomial(x * x, a.p);
+    Expr e = t.bits() == 64 ? fast_exp_f64(ax * 2) : Internal::halide_exp(ax * 2);
+    Expr large = Internal::make_one(t) - Internal::make_two(t) / (e + Internal::make_one(t));
+    large = select(x < Internal::make_zero(t), -large, large);
+    Expr result = select(ax < Internal::make_const(t, 0.625), small, large);
+    result = Internal::common_subexpression_elimination(result);
+    return cast(orig, result);
+}
+
+namespace {
+
+// Sorting networks with the fewest known comparators, as lists of
+// (i, j) pairs with i < j, indexed by the number of elements.
+const std::vector<std::pair<int, int>> best_sorting_networks[] = {
+    {},
+    {},
+    {{0, 1}},
+    {{0, 2}, {0, 1}, {1, 2}},
+    {{0, 2}, {1, 3}, {0, 1}, {2, 3}, {1, 2}},
+    {{0, 3}, {1, 4}, {0, 2}, {1, 3}, {0, 1}, {2, 4}, {1, 2}, {3, 4}, {2, 3}},
+    {{0, 5}, {1, 3}, {2, 4}, {1, 2}, {3, 4}, {0, 3}, {2, 5}, {0, 1}, {2, 3},
+     {4, 5}, {1, 2}, {3, 4}},
+    {{0, 6}, {2, 3}, {4, 5}, {0, 2}, {1, 4}, {3, 6}, {0, 1}, {2, 5}, {3, 4},
+     {1, 2}, {4, 6}, {2, 3}, {4, 5}, {1, 2}, {3, 4}, {5, 6}},
+    {{0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}, {0, 1},
+     {2, 3}, {4, 5}, {6, 7}, {2, 4}, {3, 5}, {1, 4}, {3, 6}, {1, 2}, {3, 4},
+     {5, 6}},
+    {{0, 3}, {1, 7}, {2, 5}, {4, 8}, {0, 7}, {2, 4}, {3, 8}, {5, 6}, {0, 2},
+     {1, 3}, {4, 5}, {7, 8}, {1, 4}, {3, 6}, {5, 7}, {0, 1}, {2, 4}, {3, 5},
+     {6, 8}, {2, 3}, {4, 5}, {6, 7}, {1, 2}, {3, 4}, {5, 6}},
+    {{0, 8}, {1, 9}, {2, 7}, {3, 5}, {4, 6}, {0, 2}, {1, 4}, {5, 8}, {7, 9},
+     {0, 3}, {2, 4}, {5, 7}, {6, 9}, {0, 1}, {3, 6}, {8, 9}, {1, 5}, {2, 3},
+     {4, 8}, {6, 7}, {1, 2}, {3, 5}, {4, 6}, {7, 8}, {2, 3}, {4, 5}, {6, 7},
+     {3, 4}, {5, 6}},
+};
+
+std::vector<std::pair<int, int>> sorting_network(int n) {
+    const int num_best = sizeof(best_sorting_networks) / sizeof(best_sorting_networks[0]);
+    if (n < num_best) {
+        return best_sorting_networks[n];
+    }
+
+    // Batcher's odd-even merge sort, which works for any n.
+    std::vector<std::pair<int, int>> network;
+    for (int p = 1; p < n; p *= 2) {
+        for (int k = p; k >= 1; k /= 2) {
+            for (int j = k % p; j + k < n; j += 2 * k) {
+                for (int i = 0; i < std::min(k, n - j - k); i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        network.emplace_back(i + j, i + j + k);
+                    }
+                }
+            }
+        }
+    }
+    return network;
+}
+
+// Run a sorting network over the values, where only the outputs
+// marked in wanted are computed. Comparators that don't contribute
+// to them are dropped, and a comparator that only contributes one of
+// its outputs only computes that one.
+std::vector<Expr> run_sorting_network(std::vector<Expr> values, std::vector<bool> wanted,
+                                      const char *name) {
+    const int n = (int)values.size();
+    for (const Expr &v : values) {
+        user_assert(v.defined()) << name << " of undefined Expr\n";
+        user_assert(v.type() == values[0].type())
+            << "In " << name << ", all values must have the same type, but "
+            << values[0] << " has type " << values[0].type() << " and "
+            << v << " has type " << v.type() << "\n";
+    }
+
+    const std::vector<std::pair<int, int>> network = sorting_network(n);
+    std::vector<std::pair<bool, bool>> used(network.size());
+    for (size_t c = network.size(); c > 0; c--) {
+        int i = network[c - 1].first, j = network[c - 1].second;
+        used[c - 1] = {wanted[i], wanted[j]};
+        if (wanted[i] || wanted[j]) {
+            wanted[i] = wanted[j] = true;
+        }
+    }
+
+    for (size_t c = 0; c < network.size(); c++) {
+        int i = network[c].first, j = network[c].second;
+        Expr a = values[i], b = values[j];
+        if (used[c].first) {
+            values[i] = min(a, b);
+        }
+        if (used[c].second) {
+            values[j] = max(a, b);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (wanted[i]) {
+            values[i] = Internal::common_subexpression_elimination(values[i]);
+        }
+    }
+    return values;
+}
+
+}  // namespace
+
+std::vector<Expr> sorted(const std::vector<Expr> &values) {
+    return run_sorting_network(values, std::vector<bool>(values.size(), true), "sorted");
+}
+
+Expr kth_smallest(const std::vector<Expr> &values, int k) {
+    user_assert(k >= 0 && k < (int)values.size())
+        << "kth_smallest of " << values.size() << " values can't select element " << k << "\n";
+    std::vector<bool> wanted(values.size(), false);
+    wanted[k] = true;
+    return run_sorting_network(values, wanted, "kth_smallest")[k];
+}
+
+Expr median(const std::vector<Expr> &values) {
+    user_assert(!values.empty()) << "median of no values\n";
+    return kth_smallest(values, (int)values.size() / 2);
+}
+
 Expr stringify(const std::vector<Expr> &args) {
     if (args.empty()) {
         return Expr("");
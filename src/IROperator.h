@@ -98,6 +98,7 @@ inline Expr make_const(Type t, uint8_t val)   {return make_const(t, (uint64_t)va
 inline Expr make_const(Type t, bool val)      {return make_const(t, (uint64_t)val);}
 inline Expr make_const(Type t, float val)     {return make_const(t, (double)val);}
 inline Expr make_const(Type t, float16_t val) {return make_const(t, (double)val);}
+inline Expr make_const(Type t, bfloat16_t val) {return make_const(t, (double)val);}
 // @}
 
 /** Construct a unique indeterminate_expression Expr */
@@ -900,6 +901,23 @@ inline Expr clamp(Expr a, Expr min_val, Expr max_val) {
     return Internal::Max::make(Internal::Min::make(std::move(a), std::move(n_max_val)), std::move(n_min_val));
 }
 
+/** Sort a list of Exprs of the same type into ascending order, using
+ * a network of min and max operations. For up to ten values it uses
+ * the network with the fewest known comparators, and Batcher's
+ * odd-even merge sort beyond that. There are no branches or
+ * shuffles, so this vectorizes as well as min and max do. */
+std::vector<Expr> sorted(const std::vector<Expr> &values);
+
+/** Select the k-th smallest of a list of Exprs of the same type,
+ * counting from zero. This is run through the same networks as
+ * sorted(), with the comparators that don't affect the k-th output
+ * removed. */
+Expr kth_smallest(const std::vector<Expr> &values, int k);
+
+/** The median of a list of Exprs of the same type. For an even
+ * number of values, this is the upper of the two middle values. */
+Expr median(const std::vector<Expr> &values);
+
 /** Returns the absolute value of a signed integer or floating-point
  * expression. Vectorizes cleanly. Unlike in C, abs of a signed
  * integer returns an unsigned integer of the same bit width. This
@@ -1282,6 +1300,36 @@ inline Expr fast_pow(Expr x, Expr y) {
     return select(x == 0.0f, 0.0f, fast_exp(fast_log(x) * std::move(y)));
 }
 
+/** Fast approximate cleanly vectorizable sine and cosine, built from
+ * polynomials and selects, so they also work on GPUs. max_ulp_error
+ * picks the cheapest polynomial within that many ulps of the correct
+ * result. Zero, the default, means the cheapest available, which is
+ * accurate to about 25 ulps for Float(32) and 41 for Float(64). The
+ * most accurate are within 3 ulps. Error bounds hold for |x| < 100;
+ * for Float(32), accuracy degrades gradually beyond that. Float(16)
+ * is computed in Float(32). */
+// @{
+Expr fast_sin(Expr x, int max_ulp_error = 0);
+Expr fast_cos(Expr x, int max_ulp_error = 0);
+// @}
+
+/** Fast approximate cleanly vectorizable arctangent, and
+ * arctangent of y/x that takes the signs of both into account to
+ * find the quadrant. max_ulp_error works as in fast_sin. The cheapest
+ * is accurate to about 600 ulps for Float(32) and 70 for
+ * Float(64). The most accurate are within 4 and 5 ulps
+ * respectively. Float(16) is computed in Float(32). */
+// @{
+Expr fast_atan(Expr x, int max_ulp_error = 0);
+Expr fast_atan2(Expr y, Expr x, int max_ulp_error = 0);
+// @}
+
+/** Fast approximate cleanly vectorizable hyperbolic tangent.
+ * max_ulp_error works as in fast_sin. The cheapest is accurate to
+ * about 50 ulps for Float(32) and 70 for Float(64), and the most
+ * accurate to about 5. Float(16) is computed in Float(32). */
+Expr fast_tanh(Expr x, int max_ulp_error = 0);
+
 /** Fast approximate inverse for Float(32). Corresponds to the rcpps
  * instruction on x86, and the vrecpe instruction on ARM. Vectorizes
  * cleanly. Note that this can produce slightly different results
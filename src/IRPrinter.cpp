@@ -27,6 +27,9 @@ ostream &operator<<(ostream &out, const Type &type) {
     case Type::Float:
         out << "float";
         break;
+    case Type::BFloat:
+        out << "bfloat";
+        break;
     case Type::Handle:
         if (type.handle_type) {
             out << "(" << type.handle_type->inner_name.name << " *)";
@@ -103,6 +106,12 @@ ostream &operator<<(ostream &out, const DeviceAPI &api) {
     case DeviceAPI::D3D12Compute:
         out << "<D3D12Compute>";
         break;
+    case DeviceAPI::Vulkan:
+        out << "<Vulkan>";
+        break;
+    case DeviceAPI::WebGPU:
+        out << "<WebGPU>";
+        break;
     }
     return out;
 }
@@ -130,6 +139,9 @@ std::ostream &operator<<(std::ostream &out, const MemoryType &t) {
     case MemoryType::VTCM:
         out << "VTCM";
         break;
+    case MemoryType::AMXTile:
+        out << "AMXTile";
+        break;
     }
     return out;
 }
@@ -325,6 +337,30 @@ std::ostream &operator<<(std::ostream &stream, const LinkageType &type) {
     return stream;
 }
 
+std::ostream &operator<<(std::ostream &stream, const VectorReduce::Operator &op) {
+    switch (op) {
+    case VectorReduce::Add:
+        stream << "add";
+        break;
+    case VectorReduce::Mul:
+        stream << "mul";
+        break;
+    case VectorReduce::Min:
+        stream << "min";
+        break;
+    case VectorReduce::Max:
+        stream << "max";
+        break;
+    case VectorReduce::And:
+        stream << "and";
+        break;
+    case VectorReduce::Or:
+        stream << "or";
+        break;
+    }
+    return stream;
+}
+
 IRPrinter::IRPrinter(ostream &s) : stream(s), indent(0) {
     s.setf(std::ios::fixed, std::ios::floatfield);
 }
@@ -675,6 +711,16 @@ void IRPrinter::visit(const Acquire *op) {
     stream << "}\n";
 }
 
+void IRPrinter::visit(const Atomic *op) {
+    do_indent();
+    stream << "atomic (" << op->producer_name << ") {\n";
+    indent += 2;
+    print(op->body);
+    indent -= 2;
+    do_indent();
+    stream << "}\n";
+}
+
 void IRPrinter::visit(const Store *op) {
     do_indent();
     const bool has_pred = !is_one(op->predicate);
@@ -904,5 +950,15 @@ void IRPrinter::visit(const Shuffle *op) {
     }
 }
 
+void IRPrinter::visit(const VectorReduce *op) {
+    stream << "("
+           << op->type
+           << ")vector_reduce("
+           << op->op
+           << ", ";
+    print(op->value);
+    stream << ")";
+}
+
 }  // namespace Internal
 }  // namespace Halide
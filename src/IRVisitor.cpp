@@ -238,6 +238,10 @@ void IRVisitor::visit(const Fork *op) {
     }
 }
 
+void IRVisitor::visit(const Atomic *op) {
+    op->body.accept(this);
+}
+
 void IRVisitor::visit(const IfThenElse *op) {
     op->condition.accept(this);
     op->then_case.accept(this);
@@ -256,6 +260,10 @@ void IRVisitor::visit(const Shuffle *op) {
     }
 }
 
+void IRVisitor::visit(const VectorReduce *op) {
+    op->value.accept(this);
+}
+
 void IRGraphVisitor::include(const Expr &e) {
     auto r = visited.insert(e.get());
     if (r.second) {
@@ -484,6 +492,10 @@ void IRGraphVisitor::visit(const Fork *op) {
     include(op->rest);
 }
 
+void IRGraphVisitor::visit(const Atomic *op) {
+    include(op->body);
+}
+
 void IRGraphVisitor::visit(const IfThenElse *op) {
     include(op->condition);
     include(op->then_case);
@@ -502,5 +514,9 @@ void IRGraphVisitor::visit(const Shuffle *op) {
     }
 }
 
+void IRGraphVisitor::visit(const VectorReduce *op) {
+    include(op->value);
+}
+
 }  // namespace Internal
 }  // namespace Halide
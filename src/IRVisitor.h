@@ -74,6 +74,8 @@ protected:
     virtual void visit(const Prefetch *);
     virtual void visit(const Fork *);
     virtual void visit(const Acquire *);
+    virtual void visit(const Atomic *);
+    virtual void visit(const VectorReduce *);
 };
 
 /** A base class for algorithms that walk recursively over the IR
@@ -142,6 +144,8 @@ protected:
     void visit(const Prefetch *) override;
     void visit(const Acquire *) override;
     void visit(const Fork *) override;
+    void visit(const Atomic *) override;
+    void visit(const VectorReduce *) override;
     // @}
 };
 
@@ -216,6 +220,8 @@ private:
             return ((T *)this)->visit((const Let *)node, std::forward<Args>(args)...);
         case IRNodeType::Shuffle:
             return ((T *)this)->visit((const Shuffle *)node, std::forward<Args>(args)...);
+        case IRNodeType::VectorReduce:
+            return ((T *)this)->visit((const VectorReduce *)node, std::forward<Args>(args)...);
             // Explicitly list the Stmt types rather than using a
             // default case so that when new IR nodes are added we
             // don't miss them here.
@@ -234,6 +240,7 @@ private:
         case IRNodeType::IfThenElse:
         case IRNodeType::Evaluate:
         case IRNodeType::Prefetch:
+        case IRNodeType::Atomic:
             internal_error << "Unreachable";
         }
         return ExprRet {};
@@ -272,6 +279,7 @@ private:
         case IRNodeType::Call:
         case IRNodeType::Let:
         case IRNodeType::Shuffle:
+        case IRNodeType::VectorReduce:
             internal_error << "Unreachable";
             break;
         case IRNodeType::LetStmt:
@@ -304,6 +312,8 @@ private:
             return ((T *)this)->visit((const Evaluate *)node, std::forward<Args>(args)...);
         case IRNodeType::Prefetch:
             return ((T *)this)->visit((const Prefetch *)node, std::forward<Args>(args)...);
+        case IRNodeType::Atomic:
+            return ((T *)this)->visit((const Atomic *)node, std::forward<Args>(args)...);
         }
         return StmtRet {};
     }
@@ -82,6 +82,11 @@ Func ImageParam::in() {
     return func.in();
 }
 
+Func ImageParam::stage_in_gpu_shared(const Func &consumer, Var block_var) {
+    internal_assert(func.defined());
+    return func.stage_in_gpu_shared(consumer, block_var);
+}
+
 void ImageParam::trace_loads() {
     internal_assert(func.defined());
     func.trace_loads();
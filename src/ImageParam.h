@@ -124,6 +124,10 @@ public:
     Func in();
     // @}
 
+    /** Stage the region of this ImageParam used by a GPU kernel in
+     * shared memory. See \ref Func::stage_in_gpu_shared. */
+    Func stage_in_gpu_shared(const Func &consumer, Var block_var);
+
     /** Trace all loads from this ImageParam by emitting calls to halide_trace. */
     void trace_loads();
 
@@ -0,0 +1,196 @@
+#include "IndexStrengthReduction.h"
+#include "CodeGen_GPU_Dev.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Util.h"
+
+#include <map>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+class ContainsLoop : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        result = true;
+    }
+
+public:
+    bool result = false;
+};
+
+// Check if an Expr can be evaluated outside a loop: it must not load
+// from memory, call anything, or use variables bound inside the loop.
+class IsInvariant : public IRVisitor {
+    using IRVisitor::visit;
+
+    const Scope<> &inner_vars;
+
+    void visit(const Variable *op) override {
+        if (inner_vars.contains(op->name)) {
+            result = false;
+        }
+    }
+
+    void visit(const Load *op) override {
+        result = false;
+    }
+
+    void visit(const Call *op) override {
+        result = false;
+    }
+
+public:
+    bool result = true;
+    IsInvariant(const Scope<> &s) : inner_vars(s) {}
+};
+
+// Replace the products of a loop variable and an invariant stride in
+// the body of that loop with loads of a carried offset.
+class ReplaceStridedTerms : public IRMutator {
+    using IRMutator::visit;
+
+    const string &loop_var;
+    Scope<> inner_vars;
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        Expr body;
+        {
+            ScopedBinding<> bind(inner_vars, op->name);
+            body = mutate(op->body);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return Let::make(op->name, value, body);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        Expr value = mutate(op->value);
+        Stmt body;
+        {
+            ScopedBinding<> bind(inner_vars, op->name);
+            body = mutate(op->body);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return LetStmt::make(op->name, value, body);
+    }
+
+    // Get the stride of a product of the loop variable that can be
+    // strength reduced, or an undefined Expr.
+    Expr invariant_stride(const Expr &a, const Expr &b) {
+        const Variable *v = a.as<Variable>();
+        if (!v || v->name != loop_var || is_const(b)) {
+            return Expr();
+        }
+        IsInvariant check(inner_vars);
+        b.accept(&check);
+        if (!check.result) {
+            return Expr();
+        }
+        return b;
+    }
+
+    Expr visit(const Mul *op) override {
+        if (op->type != Int(32)) {
+            return IRMutator::visit(op);
+        }
+        Expr stride = invariant_stride(op->a, op->b);
+        if (!stride.defined()) {
+            stride = invariant_stride(op->b, op->a);
+        }
+        if (!stride.defined()) {
+            return IRMutator::visit(op);
+        }
+
+        auto it = offsets.find(stride);
+        if (it == offsets.end()) {
+            it = offsets.emplace(stride, unique_name('o')).first;
+        }
+        return Load::make(Int(32), it->second, 0, Buffer<>(), Parameter(),
+                          const_true(), ModulusRemainder());
+    }
+
+public:
+    // The carried offset for each stride.
+    map<Expr, string, IRDeepCompare> offsets;
+
+    ReplaceStridedTerms(const string &loop_var) : loop_var(loop_var) {
+        inner_vars.push(loop_var);
+    }
+};
+
+class StrengthReduceIndices : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+            (op->device_api != DeviceAPI::None &&
+             op->device_api != DeviceAPI::Host)) {
+            return op;
+        }
+
+        Stmt body = mutate(op->body);
+
+        ContainsLoop inner;
+        body.accept(&inner);
+        if (op->for_type != ForType::Serial || inner.result) {
+            if (body.same_as(op->body)) {
+                return op;
+            }
+            return For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+
+        ReplaceStridedTerms replacer(op->name);
+        body = replacer.mutate(body);
+        if (replacer.offsets.empty()) {
+            if (body.same_as(op->body)) {
+                return op;
+            }
+            return For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+
+        // Step each offset at the end of the body, start it at the
+        // loop min before the loop, and allocate it around that.
+        vector<Stmt> steps, inits;
+        for (const auto &p : replacer.offsets) {
+            Expr offset = Load::make(Int(32), p.second, 0, Buffer<>(), Parameter(),
+                                     const_true(), ModulusRemainder());
+            steps.push_back(Store::make(p.second, offset + p.first, 0,
+                                        Parameter(), const_true(), ModulusRemainder()));
+            inits.push_back(Store::make(p.second, op->min * p.first, 0,
+                                        Parameter(), const_true(), ModulusRemainder()));
+        }
+        body = Block::make(body, Block::make(steps));
+        Stmt result = For::make(op->name, op->min, op->extent,
+                                op->for_type, op->device_api, body);
+        result = Block::make(Block::make(inits), result);
+        for (const auto &p : replacer.offsets) {
+            result = Allocate::make(p.second, Int(32), MemoryType::Stack, {1}, const_true(), result);
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+Stmt strength_reduce_indices(Stmt s) {
+    return StrengthReduceIndices().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,29 @@
+#ifndef HALIDE_INDEX_STRENGTH_REDUCTION_H
+#define HALIDE_INDEX_STRENGTH_REDUCTION_H
+
+/** \file
+ * Defines a lowering pass that replaces multiplications of a loop
+ * variable by a loop-invariant stride with offsets carried across
+ * iterations.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** In innermost serial loops, replace each product of the loop
+ * variable and a stride that is not a constant, but does not vary
+ * within the loop (e.g. the stride of an input buffer), with an
+ * offset that starts at the loop min times the stride and is
+ * incremented by the stride at the end of each iteration. The offsets
+ * live in single-element stack allocations, which LLVM promotes to
+ * registers. This removes the multiplies from the address
+ * computations of loops that walk buffers along a dimension other
+ * than the innermost one. Loops on GPUs are left alone. */
+Stmt strength_reduce_indices(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -1,10 +1,13 @@
 #include "InjectHostDevBufferCopies.h"
 
+#include "Bounds.h"
 #include "CodeGen_GPU_Dev.h"
 #include "Debug.h"
+#include "ExprUsesVar.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "Simplify.h"
 #include "Substitute.h"
 
 #include <map>
@@ -28,6 +31,17 @@ Stmt call_extern_and_assert(const string& name, const vector<Expr>& args) {
 
 namespace {
 
+// Is the Expr a crop of the given buffer, as made for the inputs and
+// outputs of extern stages?
+bool is_crop_of(const Expr &e, const string &buffer) {
+    const Call *c = e.as<Call>();
+    if (!c || c->name != Call::buffer_crop || c->args.size() < 3) {
+        return false;
+    }
+    const Variable *var = c->args[2].as<Variable>();
+    return var && var->name == buffer + ".buffer";
+}
+
 class FindBufferUsage : public IRVisitor {
     using IRVisitor::visit;
 
@@ -51,6 +65,23 @@ class FindBufferUsage : public IRVisitor {
         return var && (var->name == buffer + ".buffer");
     }
 
+    // Extern stages that only need part of a buffer are passed a
+    // crop of it, made in a LetStmt just outside the call.
+    set<string> crops;
+
+    bool is_crop_of_buffer(Expr e) {
+        const Variable *var = e.as<Variable>();
+        return var && crops.count(var->name);
+    }
+
+    void visit(const LetStmt *op) override {
+        op->value.accept(this);
+        if (is_crop_of(op->value, buffer)) {
+            crops.insert(op->name);
+        }
+        op->body.accept(this);
+    }
+
     void visit(const Call *op) override {
         if (op->is_intrinsic(Call::image_load)) {
             internal_assert(op->args.size() >= 1);
@@ -84,12 +115,30 @@ class FindBufferUsage : public IRVisitor {
             internal_assert((f.extern_arguments().size() + f.outputs()) == op->args.size()) <<
                 "Mismatch between args size and extern_arguments size in call to " << op->name << "\n";
 
+            DeviceAPI extern_device_api = f.extern_function_device_api();
+            // An extern stage that declared a specific device API
+            // promises to read its inputs on that device, and to write
+            // its outputs into the device allocations it is given
+            // without touching their dirty bits or allocations. We can
+            // then do the copies for it and track the buffer state
+            // across the call, rather than forgetting everything we
+            // know about the buffer.
+            bool device_aware = (extern_device_api != DeviceAPI::Host &&
+                                 extern_device_api != DeviceAPI::None &&
+                                 extern_device_api != DeviceAPI::Default_GPU);
+
             // Check each buffer arg
             for (size_t i = 0; i < op->args.size(); i++) {
-                if (is_buffer_var(op->args[i])){
-                    DeviceAPI extern_device_api = f.extern_function_device_api();
+                bool is_output = i >= f.extern_arguments().size();
+                if (device_aware &&
+                    (is_buffer_var(op->args[i]) || is_crop_of_buffer(op->args[i]))) {
+                    devices_touched.insert(extern_device_api);
+                    if (is_output) {
+                        devices_writing.insert(extern_device_api);
+                    }
+                } else if (is_buffer_var(op->args[i])){
                     devices_touched_by_extern.insert(extern_device_api);
-                    if (i >= f.extern_arguments().size()) {
+                    if (is_output) {
                         // An output. The extern stage is responsible
                         // for dealing with any device transitions for
                         // inputs.
@@ -127,6 +176,112 @@ public:
     FindBufferUsage(const std::string &buf, DeviceAPI d) : buffer(buf), current_device_api(d) {}
 };
 
+// Find the range of element offsets of a buffer that a stmt loads or
+// stores either on the host or on a device. The range is unbounded
+// if the buffer is used in any way other than by loads and stores,
+// or if the bounds of the indices can't be expressed in terms of
+// variables defined outside the stmt.
+class FindBufferRange : public IRVisitor {
+    using IRVisitor::visit;
+
+    const string &buffer;
+    const bool on_host;
+    DeviceAPI current_device_api = DeviceAPI::Host;
+
+    Scope<Interval> scope;
+    Scope<> defined_inside;
+
+    bool wanted() const {
+        return (current_device_api == DeviceAPI::Host) == on_host;
+    }
+
+    void include(const Expr &index) {
+        if (!wanted()) {
+            return;
+        }
+        Interval i = bounds_of_expr_in_scope(index, scope);
+        if (!i.is_bounded() ||
+            expr_uses_vars(i.min, defined_inside) ||
+            expr_uses_vars(i.max, defined_inside)) {
+            unbounded = true;
+        } else {
+            range.include(i);
+        }
+    }
+
+    void visit(const Load *op) override {
+        IRVisitor::visit(op);
+        if (op->name == buffer) {
+            include(op->index);
+        }
+    }
+
+    void visit(const Store *op) override {
+        IRVisitor::visit(op);
+        if (op->name == buffer) {
+            include(op->index);
+        }
+    }
+
+    void visit(const Variable *op) override {
+        // The buffer itself is passed to something we can't see into.
+        if (op->name == buffer + ".buffer") {
+            unbounded = true;
+        }
+    }
+
+    void visit(const For *op) override {
+        op->min.accept(this);
+        op->extent.accept(this);
+        Interval min_bounds = bounds_of_expr_in_scope(op->min, scope);
+        Interval max_bounds = bounds_of_expr_in_scope(op->min + op->extent - 1, scope);
+        DeviceAPI old = current_device_api;
+        if (op->device_api != DeviceAPI::None) {
+            current_device_api = op->device_api;
+        }
+        ScopedBinding<Interval> bind(scope, op->name, Interval(min_bounds.min, max_bounds.max));
+        ScopedBinding<> bind_inside(defined_inside, op->name);
+        op->body.accept(this);
+        current_device_api = old;
+    }
+
+    template<typename LetOrLetStmt>
+    void visit_let(const LetOrLetStmt *op) {
+        op->value.accept(this);
+        ScopedBinding<Interval> bind(scope, op->name, bounds_of_expr_in_scope(op->value, scope));
+        ScopedBinding<> bind_inside(defined_inside, op->name);
+        op->body.accept(this);
+    }
+
+    void visit(const Let *op) override {
+        visit_let(op);
+    }
+
+    void visit(const LetStmt *op) override {
+        visit_let(op);
+    }
+
+public:
+    Interval range = Interval::nothing();
+    bool unbounded = false;
+
+    FindBufferRange(const string &b, bool on_host) : buffer(b), on_host(on_host) {}
+};
+
+// Get the min and extent of the range of element offsets of a buffer
+// that a stmt touches on the host or on a device. Returns false if we
+// don't know it.
+bool find_range(Stmt s, const string &buffer, bool on_host, Expr *min, Expr *extent) {
+    FindBufferRange finder(buffer, on_host);
+    s.accept(&finder);
+    if (finder.unbounded || !finder.range.is_bounded()) {
+        return false;
+    }
+    *min = simplify(finder.range.min);
+    *extent = simplify(finder.range.max - finder.range.min + 1);
+    return true;
+}
+
 // Inject the device copies, mallocs, and dirty flag setting for a
 // single allocation. Sticks to the same loop level as the original
 // allocation and treats the stmt as a serial sequence of leaf
@@ -190,6 +345,16 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator {
         return call_extern_and_assert("halide_copy_to_device", {buffer_var(), device_interface});
     }
 
+    Stmt make_copy_to_host_region(Expr min, Expr extent) {
+        return call_extern_and_assert("halide_copy_to_host_region", {buffer_var(), min, extent});
+    }
+
+    Stmt make_copy_to_device_region(DeviceAPI target_device_api, Expr min, Expr extent) {
+        Expr device_interface = make_device_interface_call(target_device_api);
+        return call_extern_and_assert("halide_copy_to_device_region",
+                                      {buffer_var(), device_interface, min, extent});
+    }
+
     Stmt make_host_dirty() {
         return Evaluate::make(Call::make(Int(32), Call::buffer_set_host_dirty,
                                          {buffer_var(), const_true()}, Call::Extern));
@@ -259,12 +424,26 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator {
         bool needs_device_dirty = (written_on_device &&
                                    (state.device_dirty != True));
 
+        // If the stmt only reads the buffer on the destination, and we
+        // can tell which part of it, we only need to copy that
+        // part. The dirty bits stay set, because the rest of the
+        // buffer is still stale.
+        const bool can_copy_region = (!needs_device_flip &&
+                                      !(touched_on_host && touched_on_device) &&
+                                      finder.devices_touched_by_extern.empty());
+        Expr region_min, region_extent;
+
         vector<Stmt> stmts;
 
         // Then do it, updating what we know about the buffer
         if (needs_copy_to_host) {
-            stmts.push_back(make_copy_to_host());
-            state.device_dirty = False;
+            if (can_copy_region && !written_on_host &&
+                find_range(s, buffer, true, &region_min, &region_extent)) {
+                stmts.push_back(make_copy_to_host_region(region_min, region_extent));
+            } else {
+                stmts.push_back(make_copy_to_host());
+                state.device_dirty = False;
+            }
         }
 
         // When flipping a buffer between devices, we need to free the
@@ -277,8 +456,13 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator {
         }
 
         if (needs_copy_to_device) {
-            stmts.push_back(make_copy_to_device(touching_device));
-            state.host_dirty = False;
+            if (can_copy_region && !written_on_device &&
+                find_range(s, buffer, false, &region_min, &region_extent)) {
+                stmts.push_back(make_copy_to_device_region(touching_device, region_min, region_extent));
+            } else {
+                stmts.push_back(make_copy_to_device(touching_device));
+                state.host_dirty = False;
+            }
             state.device_allocation_exists = True;
             state.current_device = touching_device;
         }
@@ -345,7 +529,8 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator {
         FindBufferUsage finder(buffer, DeviceAPI::Host);
         op->value.accept(&finder);
         if (finder.devices_touched.empty() &&
-            finder.devices_touched_by_extern.empty()) {
+            finder.devices_touched_by_extern.empty() &&
+            !is_crop_of(op->value, buffer)) {
             return IRMutator::visit(op);
         } else {
             return do_copies(op);
@@ -455,7 +640,8 @@ private:
         FindBufferUsage finder(buffer, DeviceAPI::Host);
         op->value.accept(&finder);
         if (finder.devices_touched.empty() &&
-            finder.devices_touched_by_extern.empty()) {
+            finder.devices_touched_by_extern.empty() &&
+            !is_crop_of(op->value, buffer)) {
              IRVisitor::visit(op);
         } else {
              check_and_record_last_use(op);
@@ -10,6 +10,8 @@
 #include <iostream>
 #include <sstream>
 #include <stdio.h>
+#include <atomic>
+#include <mutex>
 
 // defines backtrace, which gets the call stack as instruction pointers
 #include <execinfo.h>
@@ -2218,59 +2220,161 @@ private:
 };
 
 namespace {
+
+struct CompilationUnitTest {
+    bool (*test)(bool (*)(const void *, const std::string &));
+    bool (*test_a)(const void *, const std::string &);
+    void (*calib)();
+};
+
 DebugSections *debug_sections = nullptr;
+
+// Parsing the debug info of a large binary takes seconds, so it is
+// deferred until the first query after a compilation unit asks to
+// use it, rather than done when that compilation unit is
+// initialized. Querying is not otherwise thread-safe, but the first
+// query may come from any thread (e.g. the first Func constructed),
+// so loading is guarded by a lock. It's recursive, because testing
+// the compilation units queries the debug info being loaded.
+struct LoadingState {
+    std::recursive_mutex mutex;
+    bool loading = false;
+    // The compilation units, and the heap objects registered, since
+    // the debug info was last queried.
+    vector<CompilationUnitTest> tests;
+    map<const void *, pair<size_t, const void *>> heap_objects;
+};
+
+// Compilation units are tested during static initialization, possibly
+// before this one is initialized, so this is constructed on first use.
+LoadingState &loading_state() {
+    static LoadingState state;
+    return state;
 }
 
-bool dump_stack_frame() {
+// Whether there are compilation units to test. This is
+// constant-initialized, so it is safe to read at any time.
+std::atomic<bool> pending(false);
+
+bool saves_frame_pointer(void *fn) {
+    // On x86-64, if we save the frame pointer, the first two instructions should be pushing the stack pointer and the frame pointer:
+    const uint8_t *ptr = (const uint8_t *)(fn);
+    return ptr[0] == 0x55; // push %rbp
+}
+
+void test_loaded_compilation_unit(const CompilationUnitTest &t) {
+    debug(5) << "Testing compilation unit with offset_marker at " << reinterpret_bits<void *>(t.calib) << "\n";
+
+    if (!saves_frame_pointer(reinterpret_bits<void *>(&test_compilation_unit)) ||
+        !saves_frame_pointer(reinterpret_bits<void *>(t.test))) {
+        // Make sure libHalide and the test compilation unit both save the frame pointer
+        debug_sections->working = false;
+        debug(5) << "Failed because frame pointer not saved\n";
+    } else if (debug_sections->working) {
+        debug_sections->calibrate_pc_offset(t.calib);
+        if (!debug_sections->working) {
+            debug(5) << "Failed because offset calibration failed\n";
+            return;
+        }
+
+        debug_sections->working = (*t.test)(t.test_a);
+        if (!debug_sections->working) {
+            debug(5) << "Failed because test routine failed\n";
+            return;
+        }
+
+        debug(5) << "Test passed\n";
+    }
+}
+
+// Load the debug info and test the pending compilation units, if
+// there are any, and return the debug info if it is usable.
+DebugSections *get_debug_sections() {
+    if (pending) {
+        LoadingState &state = loading_state();
+        std::lock_guard<std::recursive_mutex> lock(state.mutex);
+        if (pending && !state.loading) {
+            state.loading = true;
+            if (!debug_sections) {
+                char path[2048];
+                get_program_name(path, sizeof(path));
+                debug_sections = new DebugSections(path);
+            }
+            for (const CompilationUnitTest &t : state.tests) {
+                test_loaded_compilation_unit(t);
+            }
+            state.tests.clear();
+            if (debug_sections->working) {
+                for (const auto &h : state.heap_objects) {
+                    debug_sections->register_heap_object(h.first, h.second.first, h.second.second);
+                }
+            }
+            state.heap_objects.clear();
+            pending = false;
+            state.loading = false;
+        }
+    }
     if (!debug_sections || !debug_sections->working) {
+        return nullptr;
+    }
+    return debug_sections;
+}
+
+}  // namespace
+
+bool dump_stack_frame() {
+    DebugSections *sections = get_debug_sections();
+    if (!sections) {
         return false;
     }
     void *ptr = __builtin_return_address(0);
-    return debug_sections->dump_stack_frame(ptr);
+    return sections->dump_stack_frame(ptr);
 }
 
 std::string get_variable_name(const void *var, const std::string &expected_type) {
-    if (!debug_sections) return "";
-    if (!debug_sections->working) return "";
-    std::string name = debug_sections->get_stack_variable_name(var, expected_type);
+    DebugSections *sections = get_debug_sections();
+    if (!sections) return "";
+    std::string name = sections->get_stack_variable_name(var, expected_type);
     if (name.empty()) {
         // Maybe it's a member of a heap object.
-        name = debug_sections->get_heap_member_name(var, expected_type);
+        name = sections->get_heap_member_name(var, expected_type);
     }
     if (name.empty()) {
         // Maybe it's a global
-        name = debug_sections->get_global_variable_name(var, expected_type);
+        name = sections->get_global_variable_name(var, expected_type);
     }
 
     return name;
 }
 
 std::string get_source_location() {
-    if (!debug_sections) return "";
-    if (!debug_sections->working) return "";
-    return debug_sections->get_source_location();
+    DebugSections *sections = get_debug_sections();
+    if (!sections) return "";
+    return sections->get_source_location();
 }
 
 void register_heap_object(const void *obj, size_t size, const void *helper) {
-    if (!debug_sections) return;
-    if (!debug_sections->working) return;
     if (!helper) return;
+    LoadingState &state = loading_state();
+    std::lock_guard<std::recursive_mutex> lock(state.mutex);
+    if (pending) {
+        state.heap_objects[obj] = {size, helper};
+        return;
+    }
+    if (!debug_sections || !debug_sections->working) return;
     debug_sections->register_heap_object(obj, size, helper);
 }
 
 void deregister_heap_object(const void *obj, size_t size) {
-    if (!debug_sections) return;
-    if (!debug_sections->working) return;
+    LoadingState &state = loading_state();
+    std::lock_guard<std::recursive_mutex> lock(state.mutex);
+    if (pending) {
+        state.heap_objects.erase(obj);
+    }
+    if (!debug_sections || !debug_sections->working) return;
     debug_sections->deregister_heap_object(obj, size);
 }
 
-bool saves_frame_pointer(void *fn) {
-    // On x86-64, if we save the frame pointer, the first two instructions should be pushing the stack pointer and the frame pointer:
-    const uint8_t *ptr = (const uint8_t *)(fn);
-    return ptr[0] == 0x55; // push %rbp
-}
-
-
 void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string &)),
                            bool (*test_a)(const void *, const std::string &),
                            void (*calib)()) {
@@ -2283,34 +2387,17 @@ void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string
         return;
     }
 
-    debug(5) << "Testing compilation unit with offset_marker at " << reinterpret_bits<void *>(calib) << "\n";
-
-    if (!debug_sections) {
-        char path[2048];
-        get_program_name(path, sizeof(path));
-        debug_sections = new DebugSections(path);
+    // HL_INTROSPECTION=0 turns introspection off, so the debug info is
+    // never loaded.
+    static bool disabled = get_env_variable("HL_INTROSPECTION") == "0";
+    if (disabled) {
+        return;
     }
 
-    if (!saves_frame_pointer(reinterpret_bits<void *>(&test_compilation_unit)) ||
-        !saves_frame_pointer(reinterpret_bits<void *>(test))) {
-        // Make sure libHalide and the test compilation unit both save the frame pointer
-        debug_sections->working = false;
-        debug(5) << "Failed because frame pointer not saved\n";
-    } else if (debug_sections->working) {
-        debug_sections->calibrate_pc_offset(calib);
-        if (!debug_sections->working) {
-            debug(5) << "Failed because offset calibration failed\n";
-            return;
-        }
-
-        debug_sections->working = (*test)(test_a);
-        if (!debug_sections->working) {
-            debug(5) << "Failed because test routine failed\n";
-            return;
-        }
-
-        debug(5) << "Test passed\n";
-    }
+    LoadingState &state = loading_state();
+    std::lock_guard<std::recursive_mutex> lock(state.mutex);
+    state.tests.push_back({test, test_a, calib});
+    pending = true;
 
     #endif
 }
@@ -0,0 +1,275 @@
+#include "InvariantDivision.h"
+#include "CodeGen_GPU_Dev.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Util.h"
+
+#include <map>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Check if an Expr can be evaluated outside a loop: it must not load
+// from memory, call anything, or use variables bound inside the loop.
+class IsInvariant : public IRVisitor {
+    using IRVisitor::visit;
+
+    const Scope<> &inner_vars;
+
+    void visit(const Variable *op) override {
+        if (inner_vars.contains(op->name)) {
+            result = false;
+        }
+    }
+
+    void visit(const Load *op) override {
+        result = false;
+    }
+
+    void visit(const Call *op) override {
+        result = false;
+    }
+
+public:
+    bool result = true;
+    IsInvariant(const Scope<> &s) : inner_vars(s) {}
+};
+
+// The values computed once per divisor.
+struct DivisionMagic {
+    // The divisor, clamped to be at least one, as an unsigned value
+    // of the same width.
+    Expr divisor;
+    // All ones if the original (signed) divisor is negative, zero
+    // otherwise.
+    Expr sign;
+    Expr multiplier, shift1, shift2;
+};
+
+// Replace divisions in a loop body by divisors that don't vary
+// within the loop.
+class ReplaceInvariantDivisions : public IRMutator {
+    using IRMutator::visit;
+
+    Scope<> inner_vars;
+
+    map<Expr, DivisionMagic, IRDeepCompare> magic;
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        Expr body;
+        {
+            ScopedBinding<> bind(inner_vars, op->name);
+            body = mutate(op->body);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return Let::make(op->name, value, body);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        Expr value = mutate(op->value);
+        Stmt body;
+        {
+            ScopedBinding<> bind(inner_vars, op->name);
+            body = mutate(op->body);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return LetStmt::make(op->name, value, body);
+    }
+
+    Stmt visit(const For *op) override {
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name)) {
+            return op;
+        }
+        ScopedBinding<> bind(inner_vars, op->name);
+        return IRMutator::visit(op);
+    }
+
+    // Get the scalar divisor of a division that can be strength
+    // reduced, or an undefined Expr.
+    Expr invariant_divisor(const Expr &a, const Expr &b) {
+        Type t = a.type();
+        if (!(t.is_int() || t.is_uint()) ||
+            !(t.bits() == 8 || t.bits() == 16 || t.bits() == 32)) {
+            return Expr();
+        }
+        Expr d = b;
+        if (const Broadcast *bc = d.as<Broadcast>()) {
+            d = bc->value;
+        }
+        if (d.type().is_vector() || is_const(d)) {
+            return Expr();
+        }
+        IsInvariant check(inner_vars);
+        d.accept(&check);
+        if (!check.result) {
+            return Expr();
+        }
+        return d;
+    }
+
+    const DivisionMagic &get_magic(const Expr &d) {
+        auto it = magic.find(d);
+        if (it != magic.end()) {
+            return it->second;
+        }
+
+        Type t = d.type();
+        Type u = t.with_code(Type::UInt);
+        string name = unique_name('t');
+        DivisionMagic m;
+        m.divisor = Variable::make(u, name + ".divisor");
+        if (t.is_int()) {
+            m.sign = Variable::make(t, name + ".sign");
+        }
+        m.multiplier = Variable::make(u, name + ".multiplier");
+        m.shift1 = Variable::make(u, name + ".shift1");
+        m.shift2 = Variable::make(u, name + ".shift2");
+
+        Expr abs_d = t.is_int() ? abs(d) : d;
+        Expr sign = t.is_int() ? (d >> (t.bits() - 1)) : Expr();
+        Expr divisor = max(abs_d, make_one(u));
+
+        // Granlund and Montgomery, "Division by Invariant Integers
+        // using Multiplication", figure 4.1. With l = ceil(log2(d)),
+        // the multiplier is floor(2^n * (2^l - d) / d) + 1, which
+        // fits in n bits.
+        Type wide = u.with_bits(u.bits() * 2);
+        Expr l = make_const(u, u.bits()) - count_leading_zeros(m.divisor - 1);
+        Expr wide_d = cast(wide, m.divisor);
+        Expr multiplier = (((make_one(wide) << cast(wide, l)) - wide_d) << u.bits()) / wide_d + 1;
+        multiplier = cast(u, multiplier);
+        Expr shift1 = min(l, make_one(u));
+        Expr shift2 = l - shift1;
+
+        lets.push_back({m.divisor.as<Variable>()->name, divisor});
+        if (sign.defined()) {
+            lets.push_back({m.sign.as<Variable>()->name, sign});
+        }
+        lets.push_back({m.multiplier.as<Variable>()->name, multiplier});
+        lets.push_back({m.shift1.as<Variable>()->name, shift1});
+        lets.push_back({m.shift2.as<Variable>()->name, shift2});
+
+        return magic.emplace(d, m).first->second;
+    }
+
+    // Divide a non-negative value by the unsigned divisor.
+    Expr unsigned_divide(Expr a, const DivisionMagic &m) {
+        Type u = a.type();
+        Type wide = u.with_bits(u.bits() * 2);
+        int lanes = u.lanes();
+        auto bcast = [=](const Expr &e) {
+            return lanes > 1 ? Broadcast::make(e, lanes) : e;
+        };
+        // Multiply, keeping the high half. Backends recognize this
+        // pattern as a multiply-high where there is one.
+        Expr t1 = cast(u, (cast(wide, a) * cast(wide, bcast(m.multiplier))) >> u.bits());
+        return (t1 + ((a - t1) >> bcast(m.shift1))) >> bcast(m.shift2);
+    }
+
+    Expr divide(const Expr &a, const DivisionMagic &m) {
+        Type t = a.type();
+        if (t.is_uint()) {
+            return unsigned_divide(a, m);
+        }
+        // Round towards negative infinity by flipping the bits of
+        // negative numerators before and after dividing by the
+        // magnitude of the divisor. Then negate the result for
+        // negative divisors, as Halide's division is Euclidean.
+        int lanes = t.lanes();
+        Expr sign = lanes > 1 ? Broadcast::make(m.sign, lanes) : m.sign;
+        Expr a_sign = a >> (t.bits() - 1);
+        Type u = t.with_code(Type::UInt);
+        Expr q = cast(t, unsigned_divide(cast(u, a ^ a_sign), m)) ^ a_sign;
+        return (q ^ sign) - sign;
+    }
+
+    template<typename T>
+    Expr visit_div_or_mod(const T *op, bool is_div) {
+        Expr a = mutate(op->a);
+        Expr b = mutate(op->b);
+        Expr d = invariant_divisor(a, b);
+        if (!d.defined()) {
+            if (a.same_as(op->a) && b.same_as(op->b)) {
+                return op;
+            }
+            return T::make(a, b);
+        }
+        const DivisionMagic &m = get_magic(d);
+        string a_name = unique_name('t');
+        Expr a_var = Variable::make(a.type(), a_name);
+        Expr result = divide(a_var, m);
+        if (!is_div) {
+            result = a_var - result * b;
+        }
+        return Let::make(a_name, a, result);
+    }
+
+    Expr visit(const Div *op) override {
+        return visit_div_or_mod(op, true);
+    }
+
+    Expr visit(const Mod *op) override {
+        return visit_div_or_mod(op, false);
+    }
+
+public:
+    // The values to compute before the loop, in order.
+    vector<pair<string, Expr>> lets;
+
+    ReplaceInvariantDivisions(const string &loop_var) {
+        inner_vars.push(loop_var);
+    }
+};
+
+class LowerInvariantDivisions : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name)) {
+            return op;
+        }
+
+        // Replace the divisions that are invariant in this loop
+        // first, so that the magic numbers are computed outside the
+        // outermost loop possible. Then handle the divisions that
+        // only don't vary within the inner loops.
+        ReplaceInvariantDivisions replacer(op->name);
+        Stmt body = replacer.mutate(op->body);
+        body = mutate(body);
+
+        Stmt result;
+        if (body.same_as(op->body)) {
+            result = op;
+        } else {
+            result = For::make(op->name, op->min, op->extent,
+                               op->for_type, op->device_api, body);
+        }
+        for (auto it = replacer.lets.rbegin(); it != replacer.lets.rend(); ++it) {
+            result = LetStmt::make(it->first, it->second, result);
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+Stmt lower_invariant_divisions(Stmt s) {
+    return LowerInvariantDivisions().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,26 @@
+#ifndef HALIDE_INVARIANT_DIVISION_H
+#define HALIDE_INVARIANT_DIVISION_H
+
+/** \file
+ * Defines a lowering pass that strength-reduces integer division by
+ * loop-invariant values.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite integer division and modulus of 8, 16, and 32-bit values
+ * by a divisor that is not a constant, but does not vary within a
+ * loop (e.g. a Param), as a multiply-keep-high-half and shifts. The
+ * magic multiplier and shifts for the divisor are computed once, in
+ * LetStmts just outside the outermost loop over which the divisor is
+ * invariant. Division by zero is undefined, and is treated as
+ * division by one. Loops on GPUs are left alone. */
+Stmt lower_invariant_divisions(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
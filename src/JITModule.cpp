@@ -1,3 +1,4 @@
+#include <atomic>
 #include <mutex>
 #include <set>
 #include <stdint.h>
@@ -146,6 +147,8 @@ public:
     std::map<std::string, JITModule::Symbol> exports;
     llvm::LLVMContext context;
     ExecutionEngine *execution_engine;
+    // Set if HL_JIT_CACHE_DIR is in use. Must outlive execution_engine.
+    std::unique_ptr<llvm::ObjectCache> object_cache;
     std::vector<JITModule> dependencies;
     JITModule::Symbol entrypoint;
     JITModule::Symbol argv_entrypoint;
@@ -249,6 +252,83 @@ public:
 
 };
 
+// Bump this when a change to the JIT (e.g. to how symbols are resolved)
+// makes previously cached objects unusable.
+const int jit_cache_version = 1;
+
+// An llvm::ObjectCache that persists compiled object code in the
+// directory named by HL_JIT_CACHE_DIR. Entries are keyed on a hash of
+// the module's bitcode (which includes the runtime modules linked into
+// it), the Halide target, the version of LLVM, and jit_cache_version, so
+// a cache hit only skips LLVM's optimization and code generation:
+// relocation against the current process (and any dependencies) still
+// happens as usual.
+class HalideJITObjectCache : public llvm::ObjectCache {
+    string dir;
+    string target_string;
+    std::map<const llvm::Module *, string> paths;
+
+    string path_for(const llvm::Module *m) {
+        auto it = paths.find(m);
+        if (it != paths.end()) {
+            return it->second;
+        }
+
+        llvm::SmallVector<char, 65536> bitcode;
+        llvm::raw_svector_ostream bitcode_stream(bitcode);
+        llvm::WriteBitcodeToFile(*m, bitcode_stream);
+
+        llvm::MD5 hasher;
+        hasher.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+        hasher.update(target_string);
+        hasher.update(LLVM_VERSION_STRING);
+        hasher.update(std::to_string(jit_cache_version));
+        llvm::MD5::MD5Result result;
+        hasher.final(result);
+
+        string path = dir + "/" + result.digest().str().str() + ".o";
+        paths[m] = path;
+        return path;
+    }
+
+public:
+    HalideJITObjectCache(const string &dir, const Target &target) :
+        dir(dir), target_string(target.to_string()) {}
+
+    void notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef obj) override {
+        string path = path_for(m);
+        // Write to a temporary and rename it into place, so that
+        // concurrent processes never see a partially-written object.
+        string tmp_path = path + "." + std::to_string(llvm::sys::Process::getProcessId()) + ".tmp";
+        {
+            std::error_code err;
+            llvm::raw_fd_ostream out(tmp_path, err, llvm::sys::fs::F_None);
+            if (err) {
+                debug(1) << "Could not write JIT cache entry " << tmp_path << ": " << err.message() << "\n";
+                return;
+            }
+            out.write(obj.getBufferStart(), obj.getBufferSize());
+        }
+        if (llvm::sys::fs::rename(tmp_path, path)) {
+            llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+        debug(2) << "Wrote JIT cache entry " << path << "\n";
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *m) override {
+        string path = path_for(m);
+        // Large files are mmapped rather than read.
+        auto buf = llvm::MemoryBuffer::getFile(path);
+        if (!buf) {
+            debug(2) << "JIT cache miss for " << m->getModuleIdentifier() << "\n";
+            return nullptr;
+        }
+        debug(1) << "JIT cache hit for " << m->getModuleIdentifier() << ": " << path << "\n";
+        return std::move(*buf);
+    }
+};
+
 }
 
 JITModule::JITModule() {
@@ -317,6 +397,16 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     if (!ee) std::cerr << error_string << "\n";
     internal_assert(ee) << "Couldn't create execution engine\n";
 
+    string cache_dir = get_env_variable("HL_JIT_CACHE_DIR");
+    if (!cache_dir.empty()) {
+        if (llvm::sys::fs::create_directories(cache_dir)) {
+            user_warning << "Could not create HL_JIT_CACHE_DIR " << cache_dir << "\n";
+        } else {
+            jit_module->object_cache.reset(new HalideJITObjectCache(cache_dir, target));
+            ee->setObjectCache(jit_module->object_cache.get());
+        }
+    }
+
     // Do any target-specific initialization
     std::vector<llvm::JITEventListener *> listeners;
 
@@ -477,6 +567,41 @@ void JITModule::memoization_cache_set_size(int64_t size) const {
     }
 }
 
+void JITModule::memoization_cache_set_pipeline_budget(const std::string &pipeline_name, int64_t size) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_set_pipeline_budget");
+    if (f != exports().end()) {
+        (reinterpret_bits<int (*)(void *, const char *, int64_t)>(f->second.address))(nullptr, pipeline_name.c_str(), size);
+    }
+}
+
+int JITModule::memoization_cache_set_persistent_store(const std::string &path, int64_t size) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_set_persistent_store");
+    if (f != exports().end()) {
+        return (reinterpret_bits<int (*)(void *, const char *, int64_t)>(f->second.address))(nullptr, path.c_str(), size);
+    }
+    return -1;
+}
+
+void JITModule::memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_get_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *, halide_memoization_cache_stats_t *)>(f->second.address))(nullptr, stats);
+    } else {
+        *stats = halide_memoization_cache_stats_t();
+    }
+}
+
+void JITModule::memoization_cache_reset_stats() const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_reset_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *)>(f->second.address))(nullptr);
+    }
+}
+
 bool JITModule::compiled() const {
   return jit_module->execution_engine != nullptr;
 }
@@ -487,6 +612,9 @@ JITHandlers runtime_internal_handlers;
 JITHandlers default_handlers;
 JITHandlers active_handlers;
 int64_t default_cache_size;
+std::map<std::string, int64_t> default_pipeline_cache_budgets;
+std::string default_persistent_store_path;
+int64_t default_persistent_store_size;
 
 void merge_handlers(JITHandlers &base, const JITHandlers &addins) {
     if (addins.custom_print) {
@@ -640,6 +768,8 @@ enum RuntimeKind {
     OpenGLCompute,
     Hexagon,
     D3D12Compute,
+    Vulkan,
+    WebGPU,
     OpenCLDebug,
     MetalDebug,
     CUDADebug,
@@ -647,21 +777,60 @@ enum RuntimeKind {
     OpenGLComputeDebug,
     HexagonDebug,
     D3D12ComputeDebug,
+    VulkanDebug,
+    WebGPUDebug,
     MaxRuntimeKind
 };
 
 JITModule &shared_runtimes(RuntimeKind k) {
-    // We're already guarded by the shared_runtimes_mutex
-    static JITModule *m = nullptr;
-    if (!m) {
-        // Note that this is never freed. On windows this would invoke
-        // static destructors that use threading objects, and these
-        // don't work (crash or deadlock) after main exits.
-        m = new JITModule[MaxRuntimeKind];
-    }
+    // Note that this is never freed. On windows this would invoke
+    // static destructors that use threading objects, and these
+    // don't work (crash or deadlock) after main exits.
+    static JITModule *m = new JITModule[MaxRuntimeKind];
     return m[k];
 }
 
+// Set once a shared runtime is completely built, after which it is
+// not modified until release_all, so it can be read without holding
+// shared_runtimes_mutex. Building a runtime and changing its settings
+// still take the mutex.
+std::atomic<bool> shared_runtime_ready[MaxRuntimeKind];
+
+// The shared runtimes needed by code compiled for a target: the main
+// runtime, followed by one for each device API it uses.
+std::vector<RuntimeKind> runtime_kinds_for_target(const Target &target) {
+    const bool debug = target.has_feature(Target::Debug);
+    std::vector<RuntimeKind> kinds = {MainShared};
+    if (target.has_feature(Target::OpenCL)) {
+        kinds.push_back(debug ? OpenCLDebug : OpenCL);
+    }
+    if (target.has_feature(Target::Metal)) {
+        kinds.push_back(debug ? MetalDebug : Metal);
+    }
+    if (target.has_feature(Target::CUDA)) {
+        kinds.push_back(debug ? CUDADebug : CUDA);
+    }
+    if (target.has_feature(Target::OpenGL)) {
+        kinds.push_back(debug ? OpenGLDebug : OpenGL);
+    }
+    if (target.has_feature(Target::OpenGLCompute)) {
+        kinds.push_back(debug ? OpenGLComputeDebug : OpenGLCompute);
+    }
+    if (target.features_any_of({Target::HVX_64, Target::HVX_128})) {
+        kinds.push_back(debug ? HexagonDebug : Hexagon);
+    }
+    if (target.has_feature(Target::D3D12Compute)) {
+        kinds.push_back(debug ? D3D12ComputeDebug : D3D12Compute);
+    }
+    if (target.has_feature(Target::Vulkan)) {
+        kinds.push_back(debug ? VulkanDebug : Vulkan);
+    }
+    if (target.has_feature(Target::WebGPU)) {
+        kinds.push_back(debug ? WebGPUDebug : WebGPU);
+    }
+    return kinds;
+}
+
 JITModule &make_module(llvm::Module *for_module, Target target,
                        RuntimeKind runtime_kind, const std::vector<JITModule> &deps,
                        bool create) {
@@ -684,6 +853,8 @@ JITModule &make_module(llvm::Module *for_module, Target target,
         one_gpu.set_feature(Target::OpenGL, false);
         one_gpu.set_feature(Target::OpenGLCompute, false);
         one_gpu.set_feature(Target::D3D12Compute, false);
+        one_gpu.set_feature(Target::Vulkan, false);
+        one_gpu.set_feature(Target::WebGPU, false);
         string module_name;
         switch (runtime_kind) {
         case OpenCLDebug:
@@ -758,11 +929,31 @@ JITModule &make_module(llvm::Module *for_module, Target target,
                 internal_error << "JIT support for Direct3D 12 is only implemented on Windows 10 and above.\n";
             #endif
             break;
+        case VulkanDebug:
+            one_gpu.set_feature(Target::Debug);
+            one_gpu.set_feature(Target::Vulkan);
+            module_name = "debug_vulkan";
+            break;
+        case Vulkan:
+            one_gpu.set_feature(Target::Vulkan);
+            module_name += "vulkan";
+            break;
+        case WebGPUDebug:
+            one_gpu.set_feature(Target::Debug);
+            one_gpu.set_feature(Target::WebGPU);
+            module_name = "debug_webgpu";
+            break;
+        case WebGPU:
+            one_gpu.set_feature(Target::WebGPU);
+            module_name += "webgpu";
+            break;
         default:
             module_name = "shared runtime";
             break;
         }
 
+        debug(1) << "Building the " << module_name << " JIT runtime module\n";
+
         // This function is protected by a mutex so this is thread safe.
         std::unique_ptr<llvm::Module> module(get_initial_module_for_target(one_gpu,
             &runtime.jit_module->context, true, runtime_kind != MainShared));
@@ -822,6 +1013,13 @@ JITModule &make_module(llvm::Module *for_module, Target target,
             if (default_cache_size != 0) {
                 runtime.memoization_cache_set_size(default_cache_size);
             }
+            for (const auto &it : default_pipeline_cache_budgets) {
+                runtime.memoization_cache_set_pipeline_budget(it.first, it.second);
+            }
+            if (!default_persistent_store_path.empty()) {
+                runtime.memoization_cache_set_persistent_store(default_persistent_store_path,
+                                                               default_persistent_store_size);
+            }
 
             runtime.jit_module->name = "MainShared";
         } else {
@@ -837,6 +1035,8 @@ JITModule &make_module(llvm::Module *for_module, Target target,
         uint64_t fun_addr = runtime.jit_module->execution_engine->getGlobalValueAddress("halide_jit_module_adjust_ref_count");
         internal_assert(fun_addr != 0);
         *(void (**)(void *arg, int32_t count))fun_addr = &adjust_module_ref_count;
+
+        shared_runtime_ready[runtime_kind].store(true, std::memory_order_release);
     }
     return runtime;
 }
@@ -852,61 +1052,28 @@ JITModule &make_module(llvm::Module *for_module, Target target,
  * JITSharedRuntime::release_all is called, the global state is reset
  * and any newly compiled Funcs will get a new runtime. */
 std::vector<JITModule> JITSharedRuntime::get(llvm::Module *for_module, const Target &target, bool create) {
-    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    const std::vector<RuntimeKind> kinds = runtime_kinds_for_target(target);
 
+    // Once the runtimes have been built, which is the common case
+    // when compiling many pipelines, they are returned without taking
+    // the lock, so concurrent JIT compilations don't serialize here.
     std::vector<JITModule> result;
-
-    JITModule m = make_module(for_module, target, MainShared, result, create);
-    if (m.compiled()) {
-        result.push_back(m);
-    }
-
-    // Add all requested GPU modules, each only depending on the main shared runtime.
-    std::vector<JITModule> gpu_modules;
-    if (target.has_feature(Target::OpenCL)) {
-        auto kind = target.has_feature(Target::Debug) ? OpenCLDebug : OpenCL;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
-        }
-    }
-    if (target.has_feature(Target::Metal)) {
-        auto kind = target.has_feature(Target::Debug) ? MetalDebug : Metal;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
-        }
-    }
-    if (target.has_feature(Target::CUDA)) {
-        auto kind = target.has_feature(Target::Debug) ? CUDADebug : CUDA;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
-        }
-    }
-    if (target.has_feature(Target::OpenGL)) {
-        auto kind = target.has_feature(Target::Debug) ? OpenGLDebug : OpenGL;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
-        }
-    }
-    if (target.has_feature(Target::OpenGLCompute)) {
-        auto kind = target.has_feature(Target::Debug) ? OpenGLComputeDebug : OpenGLCompute;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
+    for (RuntimeKind kind : kinds) {
+        if (!shared_runtime_ready[kind].load(std::memory_order_acquire)) {
+            break;
         }
+        result.push_back(shared_runtimes(kind));
     }
-    if (target.features_any_of({Target::HVX_64, Target::HVX_128})) {
-        auto kind = target.has_feature(Target::Debug) ? HexagonDebug : Hexagon;
-        JITModule m = make_module(for_module, target, kind, result, create);
-        if (m.compiled()) {
-            result.push_back(m);
-        }
+    if (result.size() == kinds.size()) {
+        return result;
     }
-    if (target.has_feature(Target::D3D12Compute)) {
-        auto kind = target.has_feature(Target::Debug) ? D3D12ComputeDebug : D3D12Compute;
+    result.clear();
+
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    // Add the main shared runtime, and then all requested GPU
+    // modules, each only depending on the main shared runtime.
+    for (RuntimeKind kind : kinds) {
         JITModule m = make_module(for_module, target, kind, result, create);
         if (m.compiled()) {
             result.push_back(m);
@@ -932,6 +1099,7 @@ void JITSharedRuntime::release_all() {
     std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
 
     for (int i = MaxRuntimeKind; i > 0; i--) {
+        shared_runtime_ready[i - 1].store(false, std::memory_order_release);
         shared_runtimes((RuntimeKind)(i - 1)) = JITModule();
     }
 }
@@ -953,5 +1121,50 @@ void JITSharedRuntime::memoization_cache_set_size(int64_t size) {
     }
 }
 
+void JITSharedRuntime::memoization_cache_set_pipeline_budget(const std::string &pipeline_name, int64_t size) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    if (size == 0) {
+        default_pipeline_cache_budgets.erase(pipeline_name);
+    } else {
+        default_pipeline_cache_budgets[pipeline_name] = size;
+    }
+    shared_runtimes(MainShared).memoization_cache_set_pipeline_budget(pipeline_name, size);
+}
+
+bool JITSharedRuntime::memoization_cache_set_persistent_store(const std::string &path, int64_t size) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    // Remember the store for the shared runtimes created later,
+    // e.g. after release_all().
+    default_persistent_store_path = path;
+    default_persistent_store_size = size;
+    JITModule &runtime = shared_runtimes(MainShared);
+    if (runtime.compiled()) {
+        return runtime.memoization_cache_set_persistent_store(path, size) == 0;
+    }
+    return true;
+}
+
+halide_memoization_cache_stats_t JITSharedRuntime::memoization_cache_get_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    halide_memoization_cache_stats_t stats = halide_memoization_cache_stats_t();
+    JITModule &runtime = shared_runtimes(MainShared);
+    if (runtime.compiled()) {
+        runtime.memoization_cache_get_stats(&stats);
+    }
+    return stats;
+}
+
+void JITSharedRuntime::memoization_cache_reset_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    JITModule &runtime = shared_runtimes(MainShared);
+    if (runtime.compiled()) {
+        runtime.memoization_cache_reset_stats();
+    }
+}
+
 }  // namespace Internal
 }  // namespace Halide
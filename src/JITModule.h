@@ -126,6 +126,18 @@ struct JITModule {
     /** Encapsulate device (GPU) and buffer interactions. */
     void memoization_cache_set_size(int64_t size) const;
 
+    /** Set the soft limit on memoization cache memory used by the
+     * pipeline with the given name. A size of zero removes the limit. */
+    void memoization_cache_set_pipeline_budget(const std::string &pipeline_name, int64_t size) const;
+
+    /** Back the memoization cache with a file shared between
+     * processes. Returns zero on success. */
+    int memoization_cache_set_persistent_store(const std::string &path, int64_t size) const;
+
+    /** Get or reset the counters of the memoization cache. */
+    void memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const;
+    void memoization_cache_reset_stats() const;
+
     /** Return true if compile_module has been called on this module. */
     bool compiled() const;
 };
@@ -150,6 +162,14 @@ struct JITUserContext {
     JITHandlers handlers;
 };
 
+/** The runtime shared by all JIT-compiled code in the process. It is
+ * split into one device-independent module (the thread pool, allocator,
+ * memoization cache, profiler, etc.), built once, and one module per
+ * device API (and per debug setting), each built the first time a
+ * target needs it and depending only on the device-independent
+ * module. So JIT compiling for several device APIs, or for the CPU
+ * alone, shares one thread pool and one memoization cache. Set
+ * HL_DEBUG_CODEGEN=1 to see which modules are built. */
 class JITSharedRuntime {
 public:
     // Note only the first llvm::Module passed in here is used. The same shared runtime is used for all JIT.
@@ -163,6 +183,38 @@ public:
      */
     static void memoization_cache_set_size(int64_t size);
 
+    /** Set the maximum number of bytes of memoization cache used by
+     * the pipeline with the given name, so that one hot pipeline
+     * can't evict the cached results of all the others. A size of
+     * zero removes the limit. If you are compiling statically, you
+     * should include HalideRuntime.h and call
+     * halide_memoization_cache_set_pipeline_budget() instead.
+     */
+    static void memoization_cache_set_pipeline_budget(const std::string &pipeline_name, int64_t size);
+
+    /** Back the memoization cache with a file of the given size that
+     * is shared by every process on the host using the same path, so
+     * that memoized results survive restarts. The store is set up
+     * when the shared runtime is created, if it doesn't exist yet;
+     * otherwise, returns false if it could not use the file. If you
+     * are compiling statically, you
+     * should include HalideRuntime.h and call
+     * halide_memoization_cache_set_persistent_store() instead.
+     */
+    static bool memoization_cache_set_persistent_store(const std::string &path, int64_t size);
+
+    /** Get the hit, miss and eviction counters of the memoization
+     * cache, or reset them to zero. If you are compiling statically,
+     * you should include HalideRuntime.h and call
+     * halide_memoization_cache_get_stats() instead.
+     */
+    static halide_memoization_cache_stats_t memoization_cache_get_stats();
+    static void memoization_cache_reset_stats();
+
+    /** Release the shared runtimes, so that the next JIT compilation
+     * creates new ones. Must not be called while other threads are
+     * JIT compiling, as the existing runtimes are returned to them
+     * without a lock. */
     static void release_all();
 };
 
@@ -1,4 +1,5 @@
 #include "LoopCarry.h"
+#include "AlignLoads.h"
 #include "CSE.h"
 #include "ExprUsesVar.h"
 #include "IREquality.h"
@@ -192,6 +193,7 @@ class LoopCarryOverLoop : public IRMutator {
     const Scope<> &in_consume;
 
     int max_carried_values;
+    int vector_bits;
 
     using IRMutator::visit;
 
@@ -221,6 +223,12 @@ class LoopCarryOverLoop : public IRMutator {
         return lift_carried_values_out_of_stmt(op);
     }
 
+    Stmt visit(const Atomic *op) override {
+        // Other threads may be writing to the locations loaded in
+        // here, so their values can't be carried between iterations.
+        return op;
+    }
+
     Stmt visit(const Block *op) override {
         vector<Stmt> v = block_to_vector(op);
 
@@ -354,19 +362,30 @@ class LoopCarryOverLoop : public IRMutator {
 
         // Only keep the top N carried values. Otherwise we'll just
         // spray stack spills everywhere. This is ugly, because we're
-        // relying on a heuristic.
+        // relying on a heuristic. If we know the vector width, a
+        // value wider than a vector counts once per register it
+        // occupies.
+        auto registers_per_value = [&](const vector<int> &c) {
+            const Type &t = loads[c[0]][0]->type;
+            if (vector_bits <= 0) {
+                return 1;
+            }
+            return std::max(1, (t.bits() * t.lanes() + vector_bits - 1) / vector_bits);
+        };
         vector<vector<int>> trimmed;
-        size_t sz = 0;
+        int sz = 0;
         for (const vector<int> &c : chains) {
-            if (sz + c.size() > (size_t)max_carried_values) {
-                if (sz < (size_t)max_carried_values - 1) {
+            const int regs = registers_per_value(c);
+            if (sz + (int)c.size() * regs > max_carried_values) {
+                const int values = (max_carried_values - sz) / regs;
+                if (values > 1) {
                     // Take a partial chain
-                    trimmed.emplace_back(c.begin(), c.begin() + max_carried_values - sz);
+                    trimmed.emplace_back(c.begin(), c.begin() + values);
                 }
                 break;
             }
             trimmed.push_back(c);
-            sz += c.size();
+            sz += (int)c.size() * regs;
         }
         chains.swap(trimmed);
 
@@ -487,8 +506,8 @@ class LoopCarryOverLoop : public IRMutator {
     }
 
 public:
-    LoopCarryOverLoop(const string &var, const Scope<> &s, int max_carried_values)
-        : in_consume(s), max_carried_values(max_carried_values) {
+    LoopCarryOverLoop(const string &var, const Scope<> &s, int max_carried_values, int vector_bits)
+        : in_consume(s), max_carried_values(max_carried_values), vector_bits(vector_bits) {
         linear.push(var, 1);
     }
 
@@ -505,11 +524,33 @@ public:
 class LoopCarry : public IRMutator {
     using IRMutator::visit;
 
-    int max_carried_values;
+    int max_carried_values, vector_bits;
     Scope<> in_consume;
 
+    // If set, only carry values over loops inside the productions of
+    // these Funcs, after rewriting their loads as aligned loads of
+    // align_bytes (if nonzero). How many of those productions we're
+    // inside.
+    const set<string> *funcs = nullptr;
+    int align_bytes = 0;
+    int in_funcs = 0;
+
     Stmt visit(const ProducerConsumer *op) override {
         if (op->is_producer) {
+            if (funcs && funcs->count(op->name)) {
+                Stmt body = op->body;
+                if (align_bytes) {
+                    // As for Hexagon, don't simplify between aligning
+                    // the loads and carrying them, or the aligned loads
+                    // will be collapsed again.
+                    body = align_loads(body, align_bytes);
+                    body = common_subexpression_elimination(body);
+                }
+                in_funcs++;
+                body = mutate(body);
+                in_funcs--;
+                return ProducerConsumer::make(op->name, op->is_producer, simplify(body));
+            }
             return IRMutator::visit(op);
         } else {
             ScopedBinding<> bind(in_consume, op->name);
@@ -519,10 +560,15 @@ class LoopCarry : public IRMutator {
     }
 
     Stmt visit(const For *op) override {
-        if (op->for_type == ForType::Serial && !is_one(op->extent)) {
+        if (funcs && op->device_api != DeviceAPI::None && op->device_api != DeviceAPI::Host) {
+            // Leave device code to the device backends.
+            return op;
+        }
+        if (op->for_type == ForType::Serial && !is_one(op->extent) &&
+            (!funcs || in_funcs > 0)) {
             Stmt stmt;
             Stmt body = mutate(op->body);
-            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values);
+            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values, vector_bits);
             body = carry.mutate(body);
             if (body.same_as(op->body)) {
                 stmt = op;
@@ -545,13 +591,50 @@ class LoopCarry : public IRMutator {
     }
 
 public:
-    LoopCarry(int max_carried_values) : max_carried_values(max_carried_values) {}
+    LoopCarry(int max_carried_values, int vector_bits)
+        : max_carried_values(max_carried_values), vector_bits(vector_bits) {}
+
+    LoopCarry(int max_carried_values, int vector_bits, const set<string> &funcs, int align_bytes)
+        : max_carried_values(max_carried_values), vector_bits(vector_bits),
+          funcs(&funcs), align_bytes(align_bytes) {}
 };
 
+// The number of vector registers the target has.
+int vector_register_count(const Target &t) {
+    switch (t.arch) {
+    case Target::X86:
+        if (t.bits == 32) {
+            return 8;
+        }
+        return t.has_feature(Target::AVX512) ? 32 : 16;
+    case Target::ARM:
+        return t.bits == 64 ? 32 : 16;
+    case Target::POWERPC:
+    case Target::Hexagon:
+        return 32;
+    default:
+        return 16;
+    }
+}
+
 }  // namespace
 
-Stmt loop_carry(Stmt s, int max_carried_values) {
-    s = LoopCarry(max_carried_values).mutate(s);
+Stmt loop_carry(Stmt s, int max_carried_values, int vector_bits) {
+    s = LoopCarry(max_carried_values, vector_bits).mutate(s);
+    return s;
+}
+
+Stmt carry_loads(Stmt s, const set<string> &funcs, const Target &t) {
+    if (funcs.empty()) {
+        return s;
+    }
+    // Leave half of the vector registers for the computation.
+    const int max_carried_values = vector_register_count(t) / 2;
+    const int vector_bits = t.natural_vector_size(UInt(8)) * 8;
+    // Aligning loads may load the whole aligned vectors around the
+    // values used, which the sanitizers would report.
+    const bool align = !t.has_feature(Target::ASAN) && !t.has_feature(Target::MSAN);
+    s = LoopCarry(max_carried_values, vector_bits, funcs, align ? vector_bits / 8 : 0).mutate(s);
     return s;
 }
 
@@ -1,7 +1,11 @@
 #ifndef HALIDE_LOOP_CARRY_H
 #define HALIDE_LOOP_CARRY_H
 
+#include <set>
+#include <string>
+
 #include "Expr.h"
+#include "Target.h"
 
 namespace Halide {
 namespace Internal {
@@ -10,9 +14,18 @@ namespace Internal {
  * induction variables instead of redoing the load. If the loads are
  * predicated, the predicates need to match. Can be an optimization or
  * pessimization depending on how good the L1 cache is on the architecture
- * and how many memory issue slots there are. Currently only intended
- * for Hexagon. */
-Stmt loop_carry(Stmt, int max_carried_values = 8);
+ * and how many memory issue slots there are. If vector_bits is
+ * nonzero, each carried value counts once per vector register of that
+ * many bits that it occupies. */
+Stmt loop_carry(Stmt, int max_carried_values = 8, int vector_bits = 0);
+
+/** Carry loads over the serial loops in the productions of the given
+ * Funcs (those scheduled with Func::carry_loads) on a CPU target. Their
+ * unaligned loads are first rewritten as aligned loads, so that
+ * overlapping windows can be reused across iterations, and the number
+ * of carried values is bounded by half the target's vector
+ * registers. Device loops are left alone. */
+Stmt carry_loads(Stmt s, const std::set<std::string> &funcs, const Target &t);
 
 }  // namespace Internal
 }  // namespace Halide
@@ -5,6 +5,7 @@
 
 #include "Lower.h"
 
+#include "AddAliasChecks.h"
 #include "AddImageChecks.h"
 #include "AddParameterChecks.h"
 #include "AllocationBoundsInference.h"
@@ -14,24 +15,31 @@
 #include "BoundsInference.h"
 #include "CSE.h"
 #include "CanonicalizeGPUVars.h"
+#include "CompileTimeProfiler.h"
 #include "Debug.h"
 #include "DebugArguments.h"
 #include "DebugToFile.h"
 #include "Deinterleave.h"
 #include "EarlyFree.h"
+#include "EmulateFloat16Math.h"
+#include "ExtractTileOperations.h"
 #include "FindCalls.h"
 #include "Func.h"
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
 #include "FuzzFloatStores.h"
 #include "HexagonOffload.h"
+#include "HoistStorage.h"
+#include "IRArena.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "IndexStrengthReduction.h"
 #include "InferArguments.h"
 #include "InjectHostDevBufferCopies.h"
 #include "InjectOpenGLIntrinsics.h"
 #include "Inline.h"
+#include "InvariantDivision.h"
 #include "LICM.h"
 #include "LoopCarry.h"
 #include "LowerWarpShuffles.h"
@@ -42,9 +50,12 @@
 #include "Profiling.h"
 #include "Qualify.h"
 #include "RealizationOrder.h"
+#include "RebaseLargeBufferIndices.h"
+#include "RedundantLoads.h"
 #include "RemoveDeadAllocations.h"
 #include "RemoveExternLoops.h"
 #include "RemoveUndef.h"
+#include "ReuseStorage.h"
 #include "ScheduleFunctions.h"
 #include "SelectGPUAPI.h"
 #include "Simplify.h"
@@ -59,6 +70,7 @@
 #include "Substitute.h"
 #include "Tracing.h"
 #include "TrimNoOps.h"
+#include "TrustedEntryPoints.h"
 #include "UnifyDuplicateLets.h"
 #include "UniquifyVariableNames.h"
 #include "UnpackBuffers.h"
@@ -89,6 +101,10 @@ Module lower(const vector<Function> &output_funcs,
     std::string simple_pipeline_name = extract_namespaces(pipeline_name, namespaces);
 
     Module result_module(simple_pipeline_name, t);
+    CompileTimeProfiler profiler(simple_pipeline_name);
+
+    // Most of the nodes created by the passes below are short-lived.
+    IRArena arena;
 
     // Compute an environment
     map<string, Function> env;
@@ -130,11 +146,13 @@ Module lower(const vector<Function> &output_funcs,
     bool any_memoized = false;
     Stmt s = schedule_functions(outputs, fused_groups, env, t, any_memoized);
     debug(2) << "Lowering after creating initial loop nests:\n" << s << '\n';
+    profiler.pass_done("creating initial loop nests", s);
 
     if (any_memoized) {
         debug(1) << "Injecting memoization...\n";
         s = inject_memoization(s, env, pipeline_name, outputs);
         debug(2) << "Lowering after injecting memoization:\n" << s << '\n';
+        profiler.pass_done("injecting memoization", s);
     } else {
         debug(1) << "Skipping injecting memoization...\n";
     }
@@ -142,10 +160,12 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Injecting tracing...\n";
     s = inject_tracing(s, pipeline_name, env, outputs, t);
     debug(2) << "Lowering after injecting tracing:\n" << s << '\n';
+    profiler.pass_done("injecting tracing", s);
 
     debug(1) << "Adding checks for parameters\n";
     s = add_parameter_checks(requirements, s, t);
     debug(2) << "Lowering after injecting parameter checks:\n" << s << '\n';
+    profiler.pass_done("injecting parameter checks", s);
 
     // Compute the maximum and minimum possible value of each
     // function. Used in later bounds inference passes.
@@ -157,6 +177,7 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Adding checks for images\n";
     s = add_image_checks(s, outputs, t, order, env, func_bounds);
     debug(2) << "Lowering after injecting image checks:\n" << s << '\n';
+    profiler.pass_done("injecting image checks", s);
 
     // This pass injects nested definitions of variable names, so we
     // can't simplify statements from here until we fix them up. (We
@@ -164,26 +185,42 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Performing computation bounds inference...\n";
     s = bounds_inference(s, outputs, order, fused_groups, env, func_bounds, t);
     debug(2) << "Lowering after computation bounds inference:\n" << s << '\n';
+    profiler.pass_done("computation bounds inference", s);
 
     debug(1) << "Removing extern loops...\n";
     s = remove_extern_loops(s);
     debug(2) << "Lowering after removing extern loops:\n" << s << '\n';
+    profiler.pass_done("removing extern loops", s);
 
     debug(1) << "Performing sliding window optimization...\n";
     s = sliding_window(s, env);
     debug(2) << "Lowering after sliding window:\n" << s << '\n';
+    profiler.pass_done("sliding window", s);
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
     debug(2) << "Lowering after simplifying correlated differences:\n" << s << '\n';
+    profiler.pass_done("simplifying correlated differences", s);
+
+    if (t.has_feature(Target::ReuseProducerStorage) &&
+        !t.has_feature(Target::TraceLoads) &&
+        !t.has_feature(Target::TraceStores) &&
+        !t.has_feature(Target::TraceRealizations)) {
+        debug(1) << "Storing elementwise consumers in place of their producers...\n";
+        s = reuse_producer_storage(s, env, outputs);
+        debug(2) << "Lowering after storing consumers in place of producers:\n" << s << '\n';
+        profiler.pass_done("reusing producer storage", s);
+    }
 
     debug(1) << "Performing allocation bounds inference...\n";
     s = allocation_bounds_inference(s, env, func_bounds);
     debug(2) << "Lowering after allocation bounds inference:\n" << s << '\n';
+    profiler.pass_done("allocation bounds inference", s);
 
     debug(1) << "Removing code that depends on undef values...\n";
     s = remove_undef(s);
     debug(2) << "Lowering after removing code that depends on undef values:\n" << s << "\n\n";
+    profiler.pass_done("removing code that depends on undef values", s);
 
     // This uniquifies the variable names, so we're good to simplify
     // after this point. This lets later passes assume syntactic
@@ -191,34 +228,42 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Uniquifying variable names...\n";
     s = uniquify_variable_names(s);
     debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
+    profiler.pass_done("uniquifying variable names", s);
 
     debug(1) << "Simplifying...\n";
     s = simplify(s, false); // Storage folding needs .loop_max symbols
     debug(2) << "Lowering after first simplification:\n" << s << "\n\n";
+    profiler.pass_done("first simplification", s);
 
     debug(1) << "Performing storage folding optimization...\n";
     s = storage_folding(s, env);
     debug(2) << "Lowering after storage folding:\n" << s << '\n';
+    profiler.pass_done("storage folding", s);
 
     debug(1) << "Injecting debug_to_file calls...\n";
     s = debug_to_file(s, outputs, env);
     debug(2) << "Lowering after injecting debug_to_file calls:\n" << s << '\n';
+    profiler.pass_done("injecting debug_to_file calls", s);
 
     debug(1) << "Injecting prefetches...\n";
     s = inject_prefetch(s, env);
     debug(2) << "Lowering after injecting prefetches:\n" << s << "\n\n";
+    profiler.pass_done("injecting prefetches", s);
 
     debug(1) << "Dynamically skipping stages...\n";
     s = skip_stages(s, order);
     debug(2) << "Lowering after dynamically skipping stages:\n" << s << "\n\n";
+    profiler.pass_done("dynamically skipping stages", s);
 
     debug(1) << "Forking asynchronous producers...\n";
-    s = fork_async_producers(s, env);
+    s = fork_async_producers(s, env, t);
     debug(2) << "Lowering after forking asynchronous producers:\n" << s << '\n';
+    profiler.pass_done("forking asynchronous producers", s);
 
     debug(1) << "Destructuring tuple-valued realizations...\n";
     s = split_tuples(s, env);
     debug(2) << "Lowering after destructuring tuple-valued realizations:\n" << s << "\n\n";
+    profiler.pass_done("destructuring tuple-valued realizations", s);
 
     // OpenGL relies on GPU var canonicalization occurring before
     // storage flattening.
@@ -229,20 +274,24 @@ Module lower(const vector<Function> &output_funcs,
         s = canonicalize_gpu_vars(s);
         debug(2) << "Lowering after canonicalizing GPU var names:\n"
                  << s << '\n';
+        profiler.pass_done("canonicalizing GPU var names", s);
     }
 
     debug(1) << "Performing storage flattening...\n";
     s = storage_flattening(s, outputs, env, t);
     debug(2) << "Lowering after storage flattening:\n" << s << "\n\n";
+    profiler.pass_done("storage flattening", s);
 
     debug(1) << "Unpacking buffer arguments...\n";
     s = unpack_buffers(s);
     debug(2) << "Lowering after unpacking buffer arguments...\n" << s << "\n\n";
+    profiler.pass_done("unpacking buffer arguments", s);
 
     if (any_memoized) {
         debug(1) << "Rewriting memoized allocations...\n";
         s = rewrite_memoized_allocations(s, env);
         debug(2) << "Lowering after rewriting memoized allocations:\n" << s << "\n\n";
+        profiler.pass_done("rewriting memoized allocations", s);
     } else {
         debug(1) << "Skipping rewriting memoized allocations...\n";
     }
@@ -255,122 +304,218 @@ Module lower(const vector<Function> &output_funcs,
         debug(1) << "Selecting a GPU API for GPU loops...\n";
         s = select_gpu_api(s, t);
         debug(2) << "Lowering after selecting a GPU API:\n" << s << "\n\n";
+        profiler.pass_done("selecting a GPU API", s);
 
         debug(1) << "Injecting host <-> dev buffer copies...\n";
         s = inject_host_dev_buffer_copies(s, t);
         debug(2) << "Lowering after injecting host <-> dev buffer copies:\n" << s << "\n\n";
+        profiler.pass_done("injecting host <-> dev buffer copies", s);
 
         debug(1) << "Selecting a GPU API for extern stages...\n";
         s = select_gpu_api(s, t);
         debug(2) << "Lowering after selecting a GPU API for extern stages:\n" << s << "\n\n";
+        profiler.pass_done("selecting a GPU API for extern stages", s);
     }
 
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Injecting OpenGL texture intrinsics...\n";
         s = inject_opengl_intrinsics(s);
         debug(2) << "Lowering after OpenGL intrinsics:\n" << s << "\n\n";
+        profiler.pass_done("OpenGL intrinsics", s);
     }
 
     debug(1) << "Simplifying...\n";
     s = simplify(s);
     s = unify_duplicate_lets(s);
     debug(2) << "Lowering after second simplifcation:\n" << s << "\n\n";
+    profiler.pass_done("second simplification", s);
 
     debug(1) << "Reduce prefetch dimension...\n";
     s = reduce_prefetch_dimension(s, t);
     debug(2) << "Lowering after reduce prefetch dimension:\n" << s << "\n";
+    profiler.pass_done("reduce prefetch dimension", s);
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
     debug(2) << "Lowering after simplifying correlated differences:\n" << s << '\n';
+    profiler.pass_done("simplifying correlated differences", s);
+
+    if (t.arch == Target::X86 && t.has_feature(Target::AVX512_SapphireRapids)) {
+        debug(1) << "Extracting tile operations...\n";
+        s = extract_tile_operations(s, t);
+        debug(2) << "Lowering after extracting tile operations:\n" << s << "\n\n";
+        profiler.pass_done("extracting tile operations", s);
+    }
 
     debug(1) << "Unrolling...\n";
     s = unroll_loops(s);
     s = simplify(s);
     debug(2) << "Lowering after unrolling:\n" << s << "\n\n";
+    profiler.pass_done("unrolling", s);
 
     debug(1) << "Vectorizing...\n";
     s = vectorize_loops(s, t);
     s = simplify(s);
     debug(2) << "Lowering after vectorizing:\n" << s << "\n\n";
+    profiler.pass_done("vectorizing", s);
 
     if (t.has_gpu_feature() ||
         t.has_feature(Target::OpenGLCompute)) {
         debug(1) << "Injecting per-block gpu synchronization...\n";
         s = fuse_gpu_thread_loops(s);
         debug(2) << "Lowering after injecting per-block gpu synchronization:\n" << s << "\n\n";
+        profiler.pass_done("injecting per-block gpu synchronization", s);
     }
 
     debug(1) << "Detecting vector interleavings...\n";
     s = rewrite_interleavings(s);
     s = simplify(s);
     debug(2) << "Lowering after rewriting vector interleavings:\n" << s << "\n\n";
+    profiler.pass_done("rewriting vector interleavings", s);
 
     debug(1) << "Partitioning loops to simplify boundary conditions...\n";
     s = partition_loops(s);
     s = simplify(s);
     debug(2) << "Lowering after partitioning loops:\n" << s << "\n\n";
+    profiler.pass_done("partitioning loops", s);
 
     debug(1) << "Trimming loops to the region over which they do something...\n";
     s = trim_no_ops(s);
     debug(2) << "Lowering after loop trimming:\n" << s << "\n\n";
+    profiler.pass_done("loop trimming", s);
 
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
     debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
+    profiler.pass_done("injecting early frees", s);
 
     if (t.has_feature(Target::FuzzFloatStores)) {
         debug(1) << "Fuzzing floating point stores...\n";
         s = fuzz_float_stores(s);
         debug(2) << "Lowering after fuzzing floating point stores:\n" << s << "\n\n";
+        profiler.pass_done("fuzzing floating point stores", s);
     }
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
     debug(2) << "Lowering after simplifying correlated differences:\n" << s << '\n';
+    profiler.pass_done("simplifying correlated differences", s);
 
     debug(1) << "Bounding small allocations...\n";
     s = bound_small_allocations(s);
     debug(2) << "Lowering after bounding small allocations:\n" << s << "\n\n";
+    profiler.pass_done("bounding small allocations", s);
+
+    debug(1) << "Hoisting storage...\n";
+    s = hoist_storage(s, env);
+    debug(2) << "Lowering after hoisting storage:\n" << s << "\n\n";
+    profiler.pass_done("hoisting storage", s);
+
+    if (t.has_feature(Target::ShareAllocations)) {
+        debug(1) << "Sharing allocations with disjoint lifetimes...\n";
+        s = share_allocations(s);
+        debug(2) << "Lowering after sharing allocations:\n" << s << "\n\n";
+        profiler.pass_done("sharing allocations", s);
+    }
+
+    if (t.has_feature(Target::ArenaAlloc)) {
+        debug(1) << "Injecting arena allocations...\n";
+        s = inject_arena_allocations(s);
+        debug(2) << "Lowering after injecting arena allocations:\n" << s << "\n\n";
+        profiler.pass_done("injecting arena allocations", s);
+    }
 
     if (t.has_feature(Target::Profile)) {
         debug(1) << "Injecting profiling...\n";
-        s = inject_profiling(s, pipeline_name);
+        s = inject_profiling(s, pipeline_name, t.has_feature(Target::ProfileByStage));
         debug(2) << "Lowering after injecting profiling:\n" << s << "\n\n";
+        profiler.pass_done("injecting profiling", s);
     }
 
-    if (t.has_feature(Target::CUDA)) {
+    if (t.has_feature(Target::CUDA) ||
+        t.has_feature(Target::OpenCL) ||
+        t.has_feature(Target::Metal)) {
         debug(1) << "Injecting warp shuffles...\n";
         s = lower_warp_shuffles(s);
         debug(2) << "Lowering after injecting warp shuffles:\n" << s << "\n\n";
+        profiler.pass_done("injecting warp shuffles", s);
     }
 
+    debug(1) << "Eliminating redundant loads...\n";
+    s = eliminate_redundant_loads(s);
+    debug(2) << "Lowering after eliminating redundant loads:\n" << s << "\n\n";
+    profiler.pass_done("eliminating redundant loads", s);
+
+    debug(1) << "Emulating float16 math...\n";
+    s = emulate_float16_math(s, t);
+    debug(2) << "Lowering after emulating float16 math:\n" << s << "\n\n";
+    profiler.pass_done("emulating float16 math", s);
+
     debug(1) << "Simplifying...\n";
     s = common_subexpression_elimination(s);
+    profiler.pass_done("common subexpression elimination", s);
 
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Detecting varying attributes...\n";
         s = find_linear_expressions(s);
         debug(2) << "Lowering after detecting varying attributes:\n" << s << "\n\n";
+        profiler.pass_done("detecting varying attributes", s);
 
         debug(1) << "Moving varying attribute expressions out of the shader...\n";
         s = setup_gpu_vertex_buffer(s);
         debug(2) << "Lowering after removing varying attributes:\n" << s << "\n\n";
+        profiler.pass_done("removing varying attributes", s);
     }
 
     debug(1) << "Lowering unsafe promises...\n";
     s = lower_unsafe_promises(s, t);
     debug(2) << "Lowering after lowering unsafe promises:\n" << s << "\n\n";
+    profiler.pass_done("lowering unsafe promises", s);
 
     s = remove_dead_allocations(s);
     s = simplify(s);
     s = loop_invariant_code_motion(s);
     debug(1) << "Lowering after final simplification:\n" << s << "\n\n";
+    profiler.pass_done("final simplification", s);
+
+    debug(1) << "Lowering division by loop invariant values...\n";
+    s = lower_invariant_divisions(s);
+    debug(2) << "Lowering after lowering division by loop invariant values:\n" << s << "\n\n";
+    profiler.pass_done("lowering division by loop invariant values", s);
+
+    // Hexagon code generation carries loads everywhere already.
+    if (t.arch != Target::Hexagon) {
+        set<string> carried;
+        for (const auto &p : env) {
+            if (p.second.schedule().carry_loads()) {
+                carried.insert(p.first);
+            }
+        }
+        if (!carried.empty()) {
+            debug(1) << "Carrying loads across loop iterations...\n";
+            s = carry_loads(s, carried, t);
+            debug(2) << "Lowering after carrying loads:\n" << s << "\n\n";
+            profiler.pass_done("carrying loads", s);
+        }
+    }
+
+    if (t.has_large_buffers()) {
+        debug(1) << "Rebasing large buffer indices...\n";
+        s = rebase_large_buffer_indices(s);
+        debug(2) << "Lowering after rebasing large buffer indices:\n" << s << "\n\n";
+        profiler.pass_done("rebasing large buffer indices", s);
+    }
+
+    debug(1) << "Strength reducing strided indices...\n";
+    s = strength_reduce_indices(s);
+    debug(2) << "Lowering after strength reducing strided indices:\n" << s << "\n\n";
+    profiler.pass_done("strength reducing strided indices", s);
 
     if (t.arch != Target::Hexagon && (t.features_any_of({Target::HVX_64, Target::HVX_128}))) {
         debug(1) << "Splitting off Hexagon offload...\n";
         s = inject_hexagon_rpc(s, t, result_module);
         debug(2) << "Lowering after splitting off Hexagon offload:\n" << s << '\n';
+        profiler.pass_done("splitting off Hexagon offload", s);
     } else {
         debug(1) << "Skipping Hexagon offload...\n";
     }
@@ -380,6 +525,7 @@ Module lower(const vector<Function> &output_funcs,
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
             debug(1) << "Lowering after custom pass " << i << ":\n" << s << "\n\n";
+            profiler.pass_done("custom pass " + std::to_string(i), s);
         }
     }
 
@@ -392,6 +538,13 @@ Module lower(const vector<Function> &output_funcs,
         }
     }
 
+    if (t.has_feature(Target::CheckAliasing)) {
+        debug(1) << "Adding checks for aliased buffers...\n";
+        s = add_alias_checks(s, public_args);
+        debug(2) << "Lowering after adding checks for aliased buffers:\n" << s << "\n\n";
+        profiler.pass_done("adding checks for aliased buffers", s);
+    }
+
     vector<InferredArgument> inferred_args = infer_arguments(s, outputs);
     for (const InferredArgument &arg : inferred_args) {
         if (arg.param.defined() && arg.param.name() == "__user_context") {
@@ -465,12 +618,14 @@ Module lower(const vector<Function> &output_funcs,
     }
 
     result_module.append(main_func);
+    profiler.pass_done("building the module", s);
 
     // Append a wrapper for this pipeline that accepts old buffer_ts
     // and upgrades them. It will use the same name, so it will
     // require C++ linkage. We don't need it when jitting.
     if (!t.has_feature(Target::JIT)) {
         add_legacy_wrapper(result_module, main_func);
+        add_trusted_entry_points(result_module, main_func);
     }
 
     return result_module;
@@ -354,6 +354,7 @@ public:
 class LowerWarpShuffles : public IRMutator {
     using IRMutator::visit;
 
+    DeviceAPI device_api;
     Expr warp_size, this_lane;
     string this_lane_name;
     bool may_use_warp_shuffle;
@@ -376,7 +377,7 @@ class LowerWarpShuffles : public IRMutator {
             if (op->for_type == ForType::GPULane) {
                 const int64_t *loop_size = as_const_int(op->extent);
                 user_assert(loop_size && *loop_size <= 32)
-                    << "CUDA gpu lanes loop must have constant extent of at most 32: " << op->extent << "\n";
+                    << "gpu lanes loop must have constant extent of at most 32: " << op->extent << "\n";
 
                 // Select a warp size - the smallest power of two that contains the loop size
                 int64_t ws = 1;
@@ -555,6 +556,23 @@ class LowerWarpShuffles : public IRMutator {
 
         internal_assert(may_use_warp_shuffle) << name << ", " << idx << ", " << lane << "\n";
 
+        if (device_api != DeviceAPI::CUDA) {
+            // OpenCL subgroups and Metal SIMD-groups may be wider
+            // than the loop over lanes, so express the source lane
+            // relative to this one. The backends define
+            // halide_gpu_shuffle in terms of their own subgroup
+            // shuffle. The last arg is the width of the group of
+            // lanes, for backends that need to request a minimum
+            // subgroup size.
+            Expr delta = simplify(lane - this_lane, true, bounds);
+            Expr shuffled = Call::make(shuffle_type, "halide_gpu_shuffle",
+                                       {base_val, delta, warp_size}, Call::PureExtern);
+            if (shuffled.type() != type) {
+                shuffled = reinterpret(type, cast(type.with_code(Type::UInt), shuffled));
+            }
+            return shuffled;
+        }
+
         string intrin_suffix;
         if (shuffle_type.is_float()) {
             intrin_suffix = ".f32";
@@ -644,7 +662,9 @@ class LowerWarpShuffles : public IRMutator {
     }
 
 public:
-    LowerWarpShuffles() {}
+    LowerWarpShuffles(DeviceAPI device_api) :
+        device_api(device_api) {
+    }
 };
 
 class HoistWarpShufflesFromSingleIfStmt : public IRMutator {
@@ -656,7 +676,8 @@ class HoistWarpShufflesFromSingleIfStmt : public IRMutator {
     Expr visit(const Call *op) override {
         // If it was written outside this if clause but read inside of
         // it, we need to hoist it.
-        if (starts_with(op->name, "llvm.nvvm.shfl.") &&
+        if ((starts_with(op->name, "llvm.nvvm.shfl.") ||
+             op->name == "halide_gpu_shuffle") &&
             !expr_uses_vars(op, stored_to)) {
             string name = unique_name('t');
             lifted_lets.push_back({name, op});
@@ -796,9 +817,12 @@ class LowerWarpShufflesInEachKernel : public IRMutator {
     using IRMutator::visit;
 
     Stmt visit(const For *op) override {
-        if (op->device_api == DeviceAPI::CUDA && has_lane_loop(op)) {
+        if ((op->device_api == DeviceAPI::CUDA ||
+             op->device_api == DeviceAPI::OpenCL ||
+             op->device_api == DeviceAPI::Metal) &&
+            has_lane_loop(op)) {
             Stmt s = op;
-            s = LowerWarpShuffles().mutate(s);
+            s = LowerWarpShuffles(op->device_api).mutate(s);
             s = HoistWarpShuffles().mutate(s);
             return simplify(s);
         } else {
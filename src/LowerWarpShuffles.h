@@ -2,8 +2,9 @@
 #define HALIDE_LOWER_WARP_SHUFFLES_H
 
 /** \file
- * Defines the lowering pass that injects CUDA warp shuffle
- * instructions to access storage outside of a GPULane loop.
+ * Defines the lowering pass that injects CUDA warp shuffle (or
+ * OpenCL/Metal subgroup shuffle) instructions to access storage
+ * outside of a GPULane loop.
  */
 
 #include "IR.h"
@@ -12,7 +13,10 @@ namespace Halide {
 namespace Internal {
 
 /** Rewrite access to things stored outside the loop over GPU lanes to
- * use nvidia's warp shuffle instructions. */
+ * use nvidia's warp shuffle instructions. In OpenCL and Metal kernels,
+ * emits calls to halide_gpu_shuffle(value, lane delta, lane count)
+ * instead, which those backends define in terms of subgroup
+ * shuffles. */
 Stmt lower_warp_shuffles(Stmt s);
 
 }  // namespace Internal
@@ -2,7 +2,9 @@
 
 #include <array>
 #include <fstream>
+#include <functional>
 #include <future>
+#include <sstream>
 
 #include "CodeGen_C.h"
 #include "CodeGen_Internal.h"
@@ -15,6 +17,7 @@
 #include "Outputs.h"
 #include "PythonExtensionGen.h"
 #include "StmtToHtml.h"
+#include "ThreadPool.h"
 #include "WrapExternStages.h"
 
 using Halide::Internal::debug;
@@ -71,6 +74,31 @@ private:
     void operator=(const TemporaryObjectFileDir &) = delete;
 };
 
+// Run independent compilation tasks on up to get_num_compile_threads()
+// threads, and wait for all of them to finish. With one thread, the
+// tasks run in order on the calling thread.
+void run_compile_tasks(const std::vector<std::function<void()>> &tasks) {
+    size_t threads = std::min((size_t)get_num_compile_threads(), tasks.size());
+    if (threads > 1) {
+        ThreadPool<void> pool(threads);
+        std::vector<std::future<void>> done;
+        for (const auto &task : tasks) {
+            done.push_back(pool.async(task));
+        }
+        // Let every task finish before rethrowing any error.
+        for (auto &f : done) {
+            f.wait();
+        }
+        for (auto &f : done) {
+            f.get();
+        }
+    } else {
+        for (const auto &task : tasks) {
+            task();
+        }
+    }
+}
+
 
 // Given a pathname of the form /path/to/name.ext, append suffix before ext to produce /path/to/namesuffix.ext
 std::string add_suffix(const std::string &path, const std::string &suffix) {
@@ -109,7 +137,9 @@ Outputs add_suffixes(const Outputs &in, const std::string &suffix) {
     if (!in.c_source_name.empty()) out.c_source_name = add_suffix(in.c_source_name, suffix);
     if (!in.stmt_name.empty()) out.stmt_name = add_suffix(in.stmt_name, suffix);
     if (!in.stmt_html_name.empty()) out.stmt_html_name = add_suffix(in.stmt_html_name, suffix);
+    out.stmt_html_profile_name = in.stmt_html_profile_name;
     if (!in.schedule_name.empty()) out.schedule_name = add_suffix(in.schedule_name, suffix);
+    if (!in.roofline_name.empty()) out.roofline_name = add_suffix(in.roofline_name, suffix);
     if (!in.registration_name.empty()) out.registration_name = add_suffix(in.registration_name, suffix);
 
     return out;
@@ -202,7 +232,7 @@ static Registerer registerer;
 
 struct ModuleContents {
     mutable RefCount ref_count;
-    std::string name, auto_schedule;
+    std::string name, auto_schedule, roofline_report;
     Target target;
     std::vector<Buffer<>> buffers;
     std::vector<Internal::LoweredFunc> functions;
@@ -255,6 +285,11 @@ void Module::set_auto_schedule(const std::string &auto_schedule) {
     contents->auto_schedule = auto_schedule;
 }
 
+void Module::set_roofline_report(const std::string &roofline_report) {
+    internal_assert(contents->roofline_report.empty());
+    contents->roofline_report = roofline_report;
+}
+
 void Module::set_any_strict_float(bool any_strict_float) {
     contents->any_strict_float = any_strict_float;
 }
@@ -271,6 +306,10 @@ const std::string &Module::auto_schedule() const {
     return contents->auto_schedule;
 }
 
+const std::string &Module::roofline_report() const {
+    return contents->roofline_report;
+}
+
 bool Module::any_strict_float() const {
     return contents->any_strict_float;
 }
@@ -440,7 +479,16 @@ void Module::compile(const Outputs &output_files_arg) const {
     }
     if (!output_files.stmt_html_name.empty()) {
         debug(1) << "Module.compile(): stmt_html_name " << output_files.stmt_html_name << "\n";
-        Internal::print_to_html(output_files.stmt_html_name, *this);
+        if (output_files.stmt_html_profile_name.empty()) {
+            Internal::print_to_html(output_files.stmt_html_name, *this);
+        } else {
+            std::ifstream file(output_files.stmt_html_profile_name);
+            user_assert(file.is_open())
+                << "Could not open profiler report " << output_files.stmt_html_profile_name << "\n";
+            std::stringstream report;
+            report << file.rdbuf();
+            Internal::print_to_html(output_files.stmt_html_name, *this, report.str());
+        }
         output_files.stmt_html_name.clear();
     }
 
@@ -453,99 +501,128 @@ void Module::compile(const Outputs &output_files_arg) const {
         return;
     }
 
+    // The outputs are independent of each other, so they may be
+    // written concurrently. The LLVM outputs share one LLVM module, so
+    // they are all written by one task, which is started first as it
+    // usually takes the longest.
+    std::vector<std::function<void()>> tasks;
     if (!output_files.object_name.empty() || !output_files.assembly_name.empty() ||
         !output_files.bitcode_name.empty() || !output_files.llvm_assembly_name.empty() ||
         !output_files.static_library_name.empty()) {
-        llvm::LLVMContext context;
-        std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(*this, context));
+        tasks.push_back([&]() {
+            llvm::LLVMContext context;
+            std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(*this, context));
 
-        if (!output_files.object_name.empty()) {
-            debug(1) << "Module.compile(): object_name " << output_files.object_name << "\n";
-            auto out = make_raw_fd_ostream(output_files.object_name);
-            compile_llvm_module_to_object(*llvm_module, *out);
-        }
-        if (!output_files.static_library_name.empty()) {
-            // To simplify the code, we always create a temporary object output
-            // here, even if output_files.object_name was also set: in practice,
-            // no real-world code ever sets both object_name and static_library_name
-            // at the same time, so there is no meaningful performance advantage
-            // to be had.
-            TemporaryObjectFileDir temp_dir;
-            {
-                std::string object_name = temp_dir.add_temp_object_file(output_files.static_library_name, "", target());
-                debug(1) << "Module.compile(): temporary object_name " << object_name << "\n";
-                auto out = make_raw_fd_ostream(object_name);
+            if (!output_files.object_name.empty()) {
+                debug(1) << "Module.compile(): object_name " << output_files.object_name << "\n";
+                auto out = make_raw_fd_ostream(output_files.object_name);
                 compile_llvm_module_to_object(*llvm_module, *out);
-                out->flush();  // create_static_library() is happier if we do this
             }
-            debug(1) << "Module.compile(): static_library_name " << output_files.static_library_name << "\n";
-            Target base_target(target().os, target().arch, target().bits);
-            create_static_library(temp_dir.files(), base_target, output_files.static_library_name);
-        }
-        if (!output_files.assembly_name.empty()) {
-            debug(1) << "Module.compile(): assembly_name " << output_files.assembly_name << "\n";
-            auto out = make_raw_fd_ostream(output_files.assembly_name);
-            compile_llvm_module_to_assembly(*llvm_module, *out);
-        }
-        if (!output_files.bitcode_name.empty()) {
-            debug(1) << "Module.compile(): bitcode_name " << output_files.bitcode_name << "\n";
-            auto out = make_raw_fd_ostream(output_files.bitcode_name);
-            compile_llvm_module_to_llvm_bitcode(*llvm_module, *out);
-        }
-        if (!output_files.llvm_assembly_name.empty()) {
-            debug(1) << "Module.compile(): llvm_assembly_name " << output_files.llvm_assembly_name << "\n";
-            auto out = make_raw_fd_ostream(output_files.llvm_assembly_name);
-            compile_llvm_module_to_llvm_assembly(*llvm_module, *out);
-        }
+            if (!output_files.static_library_name.empty()) {
+                // To simplify the code, we always create a temporary object output
+                // here, even if output_files.object_name was also set: in practice,
+                // no real-world code ever sets both object_name and static_library_name
+                // at the same time, so there is no meaningful performance advantage
+                // to be had.
+                TemporaryObjectFileDir temp_dir;
+                {
+                    std::string object_name = temp_dir.add_temp_object_file(output_files.static_library_name, "", target());
+                    debug(1) << "Module.compile(): temporary object_name " << object_name << "\n";
+                    auto out = make_raw_fd_ostream(object_name);
+                    compile_llvm_module_to_object(*llvm_module, *out);
+                    out->flush();  // create_static_library() is happier if we do this
+                }
+                debug(1) << "Module.compile(): static_library_name " << output_files.static_library_name << "\n";
+                Target base_target(target().os, target().arch, target().bits);
+                create_static_library(temp_dir.files(), base_target, output_files.static_library_name);
+            }
+            if (!output_files.assembly_name.empty()) {
+                debug(1) << "Module.compile(): assembly_name " << output_files.assembly_name << "\n";
+                auto out = make_raw_fd_ostream(output_files.assembly_name);
+                compile_llvm_module_to_assembly(*llvm_module, *out);
+            }
+            if (!output_files.bitcode_name.empty()) {
+                debug(1) << "Module.compile(): bitcode_name " << output_files.bitcode_name << "\n";
+                auto out = make_raw_fd_ostream(output_files.bitcode_name);
+                compile_llvm_module_to_llvm_bitcode(*llvm_module, *out);
+            }
+            if (!output_files.llvm_assembly_name.empty()) {
+                debug(1) << "Module.compile(): llvm_assembly_name " << output_files.llvm_assembly_name << "\n";
+                auto out = make_raw_fd_ostream(output_files.llvm_assembly_name);
+                compile_llvm_module_to_llvm_assembly(*llvm_module, *out);
+            }
+        });
     }
     if (!output_files.c_header_name.empty()) {
-        debug(1) << "Module.compile(): c_header_name " << output_files.c_header_name << "\n";
-        std::ofstream file(output_files.c_header_name);
-        Internal::CodeGen_C cg(file,
-                               target(),
-                               target().has_feature(Target::CPlusPlusMangling) ?
-                               Internal::CodeGen_C::CPlusPlusHeader : Internal::CodeGen_C::CHeader,
-                               output_files.c_header_name);
-        cg.compile(*this);
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): c_header_name " << output_files.c_header_name << "\n";
+            std::ofstream file(output_files.c_header_name);
+            Internal::CodeGen_C cg(file,
+                                   target(),
+                                   target().has_feature(Target::CPlusPlusMangling) ?
+                                   Internal::CodeGen_C::CPlusPlusHeader : Internal::CodeGen_C::CHeader,
+                                   output_files.c_header_name);
+            cg.compile(*this);
+        });
     }
     if (!output_files.c_source_name.empty()) {
-        debug(1) << "Module.compile(): c_source_name " << output_files.c_source_name << "\n";
-        std::ofstream file(output_files.c_source_name);
-        Internal::CodeGen_C cg(file,
-                               target(),
-                               target().has_feature(Target::CPlusPlusMangling) ?
-                               Internal::CodeGen_C::CPlusPlusImplementation : Internal::CodeGen_C::CImplementation);
-        cg.compile(*this);
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): c_source_name " << output_files.c_source_name << "\n";
+            std::ofstream file(output_files.c_source_name);
+            Internal::CodeGen_C cg(file,
+                                   target(),
+                                   target().has_feature(Target::CPlusPlusMangling) ?
+                                   Internal::CodeGen_C::CPlusPlusImplementation : Internal::CodeGen_C::CImplementation);
+            cg.compile(*this);
+        });
     }
     if (!output_files.python_extension_name.empty()) {
-        debug(1) << "Module.compile(): python_extension_name " << output_files.python_extension_name << "\n";
-        std::string c_header_name = output_files.c_header_name;
-        if (c_header_name.empty()) {
-          // If we we're not generating a header right now, guess the filename.
-          c_header_name = replace_extension(output_files.python_extension_name, ".h");
-        }
-        std::ofstream file(output_files.python_extension_name);
-        Internal::PythonExtensionGen python_extension_gen(file,
-                                                          c_header_name,
-                                                          target());
-        python_extension_gen.compile(*this);
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): python_extension_name " << output_files.python_extension_name << "\n";
+            std::string c_header_name = output_files.c_header_name;
+            if (c_header_name.empty()) {
+              // If we we're not generating a header right now, guess the filename.
+              c_header_name = replace_extension(output_files.python_extension_name, ".h");
+            }
+            std::ofstream file(output_files.python_extension_name);
+            Internal::PythonExtensionGen python_extension_gen(file,
+                                                              c_header_name,
+                                                              target());
+            python_extension_gen.compile(*this);
+        });
     }
     if (!output_files.schedule_name.empty()) {
-        debug(1) << "Module.compile(): schedule_name " << output_files.schedule_name << "\n";
-        std::ofstream file(output_files.schedule_name);
-        if (contents->auto_schedule.empty()) {
-           file << "// auto_schedule_outputs() was not called for this Generator.\n";
-        } else {
-           file << contents->auto_schedule;
-        }
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): schedule_name " << output_files.schedule_name << "\n";
+            std::ofstream file(output_files.schedule_name);
+            if (contents->auto_schedule.empty()) {
+               file << "// auto_schedule_outputs() was not called for this Generator.\n";
+            } else {
+               file << contents->auto_schedule;
+            }
+        });
+    }
+    if (!output_files.roofline_name.empty()) {
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): roofline_name " << output_files.roofline_name << "\n";
+            std::ofstream file(output_files.roofline_name);
+            if (contents->roofline_report.empty()) {
+               file << "// No roofline report was generated for this Module.\n";
+            } else {
+               file << contents->roofline_report;
+            }
+        });
     }
     if (!output_files.registration_name.empty()) {
-        debug(1) << "Module.compile(): registration_name " << output_files.registration_name << "\n";
-        std::ofstream file(output_files.registration_name);
-        emit_registration(*this, file);
-        file.close();
-        internal_assert(!file.fail());
+        tasks.push_back([&]() {
+            debug(1) << "Module.compile(): registration_name " << output_files.registration_name << "\n";
+            std::ofstream file(output_files.registration_name);
+            emit_registration(*this, file);
+            file.close();
+            internal_assert(!file.fail());
+        });
     }
+    run_compile_tasks(tasks);
 }
 
 Outputs compile_standalone_runtime(const Outputs &output_files, Target t) {
@@ -610,6 +687,7 @@ void compile_multitarget(const std::string &fn_name,
     TemporaryObjectFileDir temp_dir;
     std::vector<Expr> wrapper_args;
     std::vector<LoweredArgument> base_target_args;
+    std::vector<std::pair<Module, Outputs>> sub_modules;
     for (const Target &target : targets) {
         // arch-bits-os must be identical across all targets.
         if (target.os != base_target.os ||
@@ -661,8 +739,7 @@ void compile_multitarget(const std::string &fn_name,
         internal_assert(sub_out.object_name.empty());
         sub_out.object_name = temp_dir.add_temp_object_file(output_files.static_library_name, suffix, target);
         sub_out.registration_name.clear();
-        debug(1) << "compile_multitarget: compile_sub_target " << sub_out.object_name << "\n";
-        sub_module.compile(sub_out);
+        sub_modules.emplace_back(std::move(sub_module), sub_out);
 
         uint64_t cur_target_features[kFeaturesWordCount] = {0};
         for (int i = 0; i < Target::FeatureEnd; ++i) {
@@ -692,6 +769,19 @@ void compile_multitarget(const std::string &fn_name,
         wrapper_args.push_back(sub_fn_name);
     }
 
+    // Producing the sub-modules runs the generator and so must be
+    // done serially, but each sub-module, and each of the other
+    // modules below, is compiled in its own LLVMContext, so those can
+    // be done concurrently. Anything that depends on global state
+    // (e.g. unique_name) is done here, before the compilation starts.
+    std::vector<std::function<void()>> tasks;
+    for (const auto &sub : sub_modules) {
+        tasks.push_back([&sub]() {
+            debug(1) << "compile_multitarget: compile_sub_target " << sub.second.object_name << "\n";
+            sub.first.compile(sub.second);
+        });
+    }
+
     // If we haven't specified "no runtime", build a runtime with the base target
     // and add that to the result.
     if (!base_target.has_feature(Target::NoRuntime)) {
@@ -710,8 +800,10 @@ void compile_multitarget(const std::string &fn_name,
         }
         Outputs runtime_out = Outputs().object(
             temp_dir.add_temp_object_file(output_files.static_library_name, "_runtime", runtime_target));
-        debug(1) << "compile_multitarget: compile_standalone_runtime " << runtime_out.static_library_name << "\n";
-        compile_standalone_runtime(runtime_out, runtime_target);
+        tasks.push_back([runtime_out, runtime_target]() {
+            debug(1) << "compile_multitarget: compile_standalone_runtime " << runtime_out.static_library_name << "\n";
+            compile_standalone_runtime(runtime_out, runtime_target);
+        });
     }
 
     if (needs_wrapper) {
@@ -749,8 +841,10 @@ void compile_multitarget(const std::string &fn_name,
 
         Outputs wrapper_out = Outputs().object(
             temp_dir.add_temp_object_file(output_files.static_library_name, "_wrapper", base_target, /* in_front*/ true));
-        debug(1) << "compile_multitarget: wrapper " << wrapper_out.object_name << "\n";
-        wrapper_module.compile(wrapper_out);
+        tasks.push_back([wrapper_module, wrapper_out]() {
+            debug(1) << "compile_multitarget: wrapper " << wrapper_out.object_name << "\n";
+            wrapper_module.compile(wrapper_out);
+        });
     }
 
     if (!output_files.c_header_name.empty()) {
@@ -759,18 +853,24 @@ void compile_multitarget(const std::string &fn_name,
         // Add a wrapper to accept old buffer_ts
         add_legacy_wrapper(header_module, header_module.functions().back());
         Outputs header_out = Outputs().c_header(output_files.c_header_name);
-        debug(1) << "compile_multitarget: c_header_name " << header_out.c_header_name << "\n";
-        header_module.compile(header_out);
+        tasks.push_back([header_module, header_out]() {
+            debug(1) << "compile_multitarget: c_header_name " << header_out.c_header_name << "\n";
+            header_module.compile(header_out);
+        });
     }
 
     if (!output_files.registration_name.empty()) {
-        debug(1) << "compile_multitarget: registration_name " << output_files.registration_name << "\n";
         Module registration_module(fn_name, base_target);
         registration_module.append(LoweredFunc(fn_name, base_target_args, {}, LinkageType::ExternalPlusMetadata));
         Outputs registration_out = Outputs().registration(output_files.registration_name);
-        registration_module.compile(registration_out);
+        tasks.push_back([registration_module, registration_out]() {
+            debug(1) << "compile_multitarget: registration_name " << registration_out.registration_name << "\n";
+            registration_module.compile(registration_out);
+        });
     }
 
+    run_compile_tasks(tasks);
+
     if (!output_files.static_library_name.empty()) {
         debug(1) << "compile_multitarget: static_library_name " << output_files.static_library_name << "\n";
         create_static_library(temp_dir.files(), base_target, output_files.static_library_name);
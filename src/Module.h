@@ -97,6 +97,10 @@ public:
      * for that schedule. */
     const std::string &auto_schedule() const;
 
+    /** If a roofline report was requested for this Module, this is
+     * the text of that report. */
+    const std::string &roofline_report() const;
+
     /** Return whether this module uses strict floating-point anywhere. */
     bool any_strict_float() const;
 
@@ -145,6 +149,10 @@ public:
      * multiple times for a given Module. */
     void set_auto_schedule(const std::string &auto_schedule);
 
+    /** Set the roofline report text for the Module. It is an error to
+     * call this multiple times for a given Module. */
+    void set_roofline_report(const std::string &roofline_report);
+
     /** Set whether this module uses strict floating-point directives anywhere. */
     void set_any_strict_float(bool any_strict_float);
 };
@@ -65,10 +65,12 @@ public:
     void visit(const Realize *) override;
     void visit(const Block *) override;
     void visit(const Fork *) override;
+    void visit(const Atomic *) override;
     void visit(const IfThenElse *) override;
     void visit(const Free *) override;
     void visit(const Evaluate *) override;
     void visit(const Shuffle *) override;
+    void visit(const VectorReduce *) override;
     void visit(const Prefetch *) override;
 };
 
@@ -477,6 +479,11 @@ void ComputeModulusRemainder::visit(const Shuffle *op) {
     result = ModulusRemainder{};
 }
 
+void ComputeModulusRemainder::visit(const VectorReduce *op) {
+    internal_assert(op->type.is_scalar()) << "modulus_remainder of vector\n";
+    result = ModulusRemainder{};
+}
+
 void ComputeModulusRemainder::visit(const LetStmt *) {
     internal_assert(false) << "modulus_remainder of statement\n";
 }
@@ -521,6 +528,10 @@ void ComputeModulusRemainder::visit(const Fork *) {
     internal_assert(false) << "modulus_remainder of statement\n";
 }
 
+void ComputeModulusRemainder::visit(const Atomic *) {
+    internal_assert(false) << "modulus_remainder of statement\n";
+}
+
 void ComputeModulusRemainder::visit(const Free *) {
     internal_assert(false) << "modulus_remainder of statement\n";
 }
@@ -338,6 +338,24 @@ class MonotonicVisitor : public IRVisitor {
         result = Monotonic::Constant;
     }
 
+    void visit(const VectorReduce *op) override {
+        op->value.accept(this);
+        switch (op->op) {
+        case VectorReduce::Add:
+        case VectorReduce::Min:
+        case VectorReduce::Max:
+            // These reductions are monotonic in the arg
+            break;
+        case VectorReduce::Mul:
+        case VectorReduce::And:
+        case VectorReduce::Or:
+            // These ones are not
+            if (result != Monotonic::Constant) {
+                result = Monotonic::Unknown;
+            }
+        }
+    }
+
     void visit(const LetStmt *op) override {
         internal_error << "Monotonic of statement\n";
     }
@@ -386,6 +404,10 @@ class MonotonicVisitor : public IRVisitor {
         internal_error << "Monotonic of statement\n";
     }
 
+    void visit(const Atomic *op) override {
+        internal_error << "Monotonic of statement\n";
+    }
+
     void visit(const IfThenElse *op) override {
         internal_error << "Monotonic of statement\n";
     }
@@ -46,6 +46,11 @@ struct Outputs {
      * output is desired. */
     std::string stmt_html_name;
 
+    /** The name of a file holding the output of halide_profiler_report
+     * for a previous run of the pipeline, used to annotate the
+     * stmt.html file. Empty if it should not be annotated. */
+    std::string stmt_html_profile_name;
+
     /** The name of the emitted static library file. Empty if no static library
      * output is desired. */
     std::string static_library_name;
@@ -58,6 +63,10 @@ struct Outputs {
      * output is desired. */
     std::string schedule_name;
 
+    /** The name of the emitted roofline report file. Empty if no
+     * roofline report is desired. */
+    std::string roofline_name;
+
     /** The name of the emitted registration file. Empty if no registration
      * output is desired. */
     std::string registration_name;
@@ -126,6 +135,15 @@ struct Outputs {
         return updated;
     }
 
+    /** Make a new Outputs struct that emits everything this one does,
+     * with the stmt.html file annotated with the profiler report in
+     * the file with the given name. */
+    Outputs stmt_html_profile(const std::string &stmt_html_profile_name) const {
+        Outputs updated = *this;
+        updated.stmt_html_profile_name = stmt_html_profile_name;
+        return updated;
+    }
+
     /** Make a new Outputs struct that emits everything this one does
      * and also a static library file with the given name. */
     Outputs static_library(const std::string &static_library_name) const {
@@ -150,6 +168,14 @@ struct Outputs {
         return updated;
     }
 
+    /** Make a new Outputs struct that emits everything this one does
+     * and also a roofline report file with the given name. */
+    Outputs roofline(const std::string &roofline_name) const {
+        Outputs updated = *this;
+        updated.roofline_name = roofline_name;
+        return updated;
+    }
+
     /** Make a new Outputs struct that emits everything this one does
      * and also a registration glue C++ source with the given name. */
     Outputs registration(const std::string &registration_name) const {
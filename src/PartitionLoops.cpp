@@ -485,6 +485,52 @@ bool contains_warp_synchronous_logic(Stmt s) {
     return c.result;
 }
 
+// Partitioning a loop that isn't innermost makes two more copies of
+// its body, including the inner loop nest. Past this many IR nodes in
+// the body, we share a single unsimplified copy between the prologue
+// and the epilogue instead.
+const int max_duplicated_loop_nest_size = 500;
+
+// Check if a stmt contains a loop and has more than
+// max_duplicated_loop_nest_size IR nodes. Stops counting once the
+// limit is reached.
+class IsLargeLoopNest : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    int nodes = 0;
+    bool contains_loop = false;
+
+    void include(const Expr &e) override {
+        if (nodes <= max_duplicated_loop_nest_size) {
+            nodes++;
+            IRGraphVisitor::include(e);
+        }
+    }
+
+    void include(const Stmt &s) override {
+        if (nodes <= max_duplicated_loop_nest_size) {
+            nodes++;
+            IRGraphVisitor::include(s);
+        }
+    }
+
+    void visit(const For *op) override {
+        contains_loop = true;
+        IRGraphVisitor::visit(op);
+    }
+
+public:
+    bool result() const {
+        return contains_loop && nodes > max_duplicated_loop_nest_size;
+    }
+};
+
+bool is_large_loop_nest(const Stmt &s) {
+    IsLargeLoopNest c;
+    s.accept(&c);
+    return c.result();
+}
+
 class PartitionLoops : public IRMutator {
     using IRMutator::visit;
 
@@ -640,6 +686,20 @@ class PartitionLoops : public IRMutator {
         bool make_prologue = !equal(prologue, simpler_body);
         bool make_epilogue = !equal(epilogue, simpler_body);
 
+        // For a large loop nest, two more copies of the body cost a
+        // lot of code size and compile time, and a multi-dimensional
+        // boundary condition does this at every level. The edge
+        // iterations of an outer loop are a small fraction of the
+        // work, so use the unsimplified body for both edges, and
+        // select between it and the steady state with a branch in a
+        // single loop.
+        bool share_edge_code = (make_prologue && make_epilogue && !in_gpu_loop &&
+                                is_large_loop_nest(body));
+        if (share_edge_code) {
+            debug(3) << "Sharing edge code for large loop nest over " << op->name << "\n";
+            prologue = epilogue = body;
+        }
+
         // Recurse on the middle section.
         simpler_body = mutate(simpler_body);
 
@@ -682,7 +742,7 @@ class PartitionLoops : public IRMutator {
 
         Stmt stmt;
         // Bust simple serial for loops up into three.
-        if (op->for_type == ForType::Serial && !op->body.as<Acquire>()) {
+        if (op->for_type == ForType::Serial && !op->body.as<Acquire>() && !share_edge_code) {
             stmt = For::make(op->name, min_steady, max_steady - min_steady,
                              op->for_type, op->device_api, simpler_body);
 
@@ -708,7 +768,8 @@ class PartitionLoops : public IRMutator {
             // Simple serial for loops that contain an Acquire node go
             // into the task system as a single entity, but Block
             // nodes do not, so we get a flatter task graph if we do
-            // the same trick.
+            // the same trick. We also do this when sharing the edge
+            // code, so that there is only one copy of it.
             Expr loop_var = Variable::make(Int(32), op->name);
             stmt = simpler_body;
             if (make_epilogue && make_prologue && equal(prologue, epilogue)) {
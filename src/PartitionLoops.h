@@ -21,7 +21,9 @@ bool has_likely_tag(Expr e);
 
 /** Partitions loop bodies into a prologue, a steady state, and an
  * epilogue. Finds the steady state by hunting for use of clamped
- * ramps, or the 'likely' intrinsic. */
+ * ramps, or the 'likely' intrinsic. Outer loops with large bodies
+ * instead get a single unsimplified copy of the body shared by the
+ * prologue and epilogue, to limit code size. */
 Stmt partition_loops(Stmt s);
 
 }  // namespace Internal
@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 #include "Argument.h"
 #include "FindCalls.h"
 #include "Func.h"
+#include "IRMutator.h"
 #include "IRVisitor.h"
 #include "InferArguments.h"
 #include "LLVM_Headers.h"
@@ -13,6 +16,9 @@
 #include "Pipeline.h"
 #include "PrintLoopNest.h"
 #include "RealizationOrder.h"
+#include "Simplify.h"
+#include "Substitute.h"
+#include "ThreadPool.h"
 #include "WasmExecutor.h"
 
 using namespace Halide::Internal;
@@ -43,6 +49,37 @@ Outputs static_library_outputs(const string &filename_prefix, const Target &targ
     return outputs;
 }
 
+// The default for Pipeline::set_auto_specialize.
+int default_auto_specialize_calls() {
+    static int calls = std::atoi(get_env_variable("HL_JIT_AUTO_SPECIALIZE").c_str());
+    return calls;
+}
+
+// A version of a JIT-compiled pipeline specialized on the argument
+// values it was called with repeatedly. See
+// Pipeline::set_auto_specialize.
+struct AutoSpecialization {
+    // The argument values, as collected by observed_argument_values.
+    vector<int64_t> values;
+    // Set by the background compilation once jit_module is set, or
+    // left undefined if the compilation failed.
+    std::atomic<bool> done{false};
+    JITModule jit_module;
+};
+
+// A replacement for the JIT-compiled code of a pipeline, compiled in
+// the background. See Pipeline::compile_jit_in_background.
+struct JITReplacement {
+    Target target;
+    vector<InferredArgument> inferred_args;
+    vector<JITModule> dependencies;
+    // Set by the background compilation once module and jit_module
+    // are set, or left undefined if the compilation failed.
+    std::atomic<bool> done{false};
+    Module module{"", Target()};
+    JITModule jit_module;
+};
+
 }  // namespace
 
 struct PipelineContents {
@@ -61,6 +98,106 @@ struct PipelineContents {
     // Cached compiled JavaScript and/or wasm if defined */
     WasmModule wasm_module;
 
+    // The JITModules for the externs that jit_module depends on.
+    vector<JITModule> jit_dependencies;
+
+    /** The number of calls in a row with the same argument values
+     * after which realize compiles a specialization for them, or zero
+     * to never specialize. */
+    int auto_specialize_calls;
+
+    /** The argument values of the last call to realize, and the
+     * number of calls in a row with these values. */
+    vector<int64_t> observed_values;
+    int observed_repeats = 0;
+
+    /** The most recent automatic specialization, which may still be
+     * compiling. Shared with the background compilation. */
+    std::shared_ptr<AutoSpecialization> auto_specialization;
+
+    /** Whether compile_jit leaves the specializations that depend
+     * on the arguments to be compiled when a call first takes them.
+     * See Pipeline::set_lazy_specializations. */
+    bool lazy_specializations = false;
+
+    /** When jit_module was compiled with lazy specializations, copies
+     * of the Funcs it was compiled from, and the conditions of their
+     * specializations that it assumes are false, in the order
+     * decide_specializations visits them. */
+    vector<Function> lazy_outputs;
+    vector<Expr> lazy_conditions;
+
+    /** The versions of jit_module compiled for calls that take some of
+     * those specializations, keyed by the value of each condition: 0
+     * or 1, or -1 where the arguments don't determine it. */
+    std::map<vector<int>, JITModule> lazy_jit_modules;
+
+    /** The replacement for jit_module being compiled in the
+     * background, if any. Shared with the background compilation. */
+    std::shared_ptr<JITReplacement> jit_replacement;
+
+    /** Switch to the replacement compiled in the background, if it is
+     * ready. Calls running the old code hold their own reference to
+     * it. */
+    void install_jit_replacement() {
+        std::shared_ptr<JITReplacement> replacement = jit_replacement;
+        if (!replacement || !replacement->done.load(std::memory_order_acquire)) {
+            return;
+        }
+        jit_replacement.reset();
+        if (!replacement->jit_module.compiled()) {
+            return;
+        }
+        invalidate_cache();
+        module = replacement->module;
+        jit_module = replacement->jit_module;
+        jit_target = replacement->target;
+        inferred_args = replacement->inferred_args;
+        jit_dependencies = replacement->dependencies;
+    }
+
+    /** The number of outputs realize keeps for reuse, and the kept
+     * outputs. Each one is free for reuse once it holds the only
+     * reference to its host memory. */
+    int output_pool_size = 0;
+    vector<Buffer<>> output_pool;
+
+    /** Allocate buf, which has the shape of an output, by sharing the
+     * host memory of a free pooled buffer of the same type and shape,
+     * or by allocating new memory and keeping it in the pool. */
+    void allocate_pooled_output(Buffer<> &buf) {
+        for (const Buffer<> &pooled : output_pool) {
+            if (pooled.get()->host_memory_ref_count() == 1 &&
+                pooled.type() == buf.type() &&
+                pooled.dimensions() == buf.dimensions()) {
+                bool same_shape = true;
+                for (int d = 0; d < buf.dimensions(); d++) {
+                    same_shape &= (pooled.dim(d).min() == buf.dim(d).min() &&
+                                   pooled.dim(d).extent() == buf.dim(d).extent() &&
+                                   pooled.dim(d).stride() == buf.dim(d).stride());
+                }
+                if (same_shape) {
+                    buf = Buffer<>(Runtime::Buffer<>(*pooled.get()), buf.name());
+                    return;
+                }
+            }
+        }
+
+        buf.allocate();
+        if ((int)output_pool.size() >= output_pool_size) {
+            // Make room by dropping the oldest free buffer, if any.
+            for (auto it = output_pool.begin(); it != output_pool.end(); it++) {
+                if (it->get()->host_memory_ref_count() == 1) {
+                    output_pool.erase(it);
+                    break;
+                }
+            }
+        }
+        if ((int)output_pool.size() < output_pool_size) {
+            output_pool.emplace_back(Runtime::Buffer<>(*buf.get()), buf.name());
+        }
+    }
+
     /** Clear all cached state */
     void invalidate_cache() {
         module = Module("", Target());
@@ -68,6 +205,14 @@ struct PipelineContents {
         jit_target = Target();
         inferred_args.clear();
         wasm_module = WasmModule();
+        jit_dependencies.clear();
+        observed_values.clear();
+        observed_repeats = 0;
+        auto_specialization.reset();
+        jit_replacement.reset();
+        lazy_outputs.clear();
+        lazy_conditions.clear();
+        lazy_jit_modules.clear();
     }
 
     // The outputs
@@ -98,7 +243,7 @@ struct PipelineContents {
     std::vector<Stmt> requirements;
 
     PipelineContents() :
-        module("", Target()) {
+        module("", Target()), auto_specialize_calls(default_auto_specialize_calls()) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, type_of<const void*>(), 0, ArgumentEstimates{});
         user_context_arg.param = Parameter(Handle(), false, 0, "__user_context");
     }
@@ -178,6 +323,10 @@ void Pipeline::set_custom_auto_scheduler(std::function<string(Pipeline, const Ta
     *get_custom_auto_scheduler_ptr() = auto_scheduler;
 }
 
+string Pipeline::roofline_report(const MachineParams &arch_params) {
+    return generate_roofline_report(contents->outputs, arch_params);
+}
+
 Func Pipeline::get_func(size_t index) {
     // Compute an environment
     std::map<string, Function> env;
@@ -313,29 +462,244 @@ void Pipeline::compile_to_file(const string &filename_prefix,
     m.compile(outputs);
 }
 
-vector<Argument> Pipeline::infer_arguments(Stmt body) {
+namespace {
+
+// The arguments of the jitted entry point of a pipeline, in order.
+vector<InferredArgument> infer_jit_arguments(const PipelineContents &contents, Stmt body) {
     Stmt s = body;
-    if (!contents->requirements.empty()) {
-        s = Block::make(contents->requirements);
+    if (!contents.requirements.empty()) {
+        s = Block::make(contents.requirements);
         if (body.defined()) {
             s = Block::make(s, body);
         }
     }
-    contents->inferred_args = ::infer_arguments(s, contents->outputs);
+    vector<InferredArgument> inferred_args = ::infer_arguments(s, contents.outputs);
 
     // Add the user context argument if it's not already there, or hook up our user context
     // Parameter to any existing one.
     bool has_user_context = false;
-    for (auto &arg : contents->inferred_args) {
-        if (arg.arg.name == contents->user_context_arg.arg.name) {
-            arg = contents->user_context_arg;
+    for (auto &arg : inferred_args) {
+        if (arg.arg.name == contents.user_context_arg.arg.name) {
+            arg = contents.user_context_arg;
             has_user_context = true;
         }
     }
     if (!has_user_context) {
-        contents->inferred_args.push_back(contents->user_context_arg);
+        inferred_args.push_back(contents.user_context_arg);
+    }
+    return inferred_args;
+}
+
+// A pipeline to splice into its callers in place of the extern stages
+// that call it, along with the arguments of its jitted entry point,
+// which the arguments of those extern stages are passed to.
+struct SplicedPipeline {
+    vector<Function> outputs;
+    vector<InferredArgument> args;
+};
+
+// Rewrites references to the arguments of a pipeline spliced into its
+// caller into the corresponding arguments of the caller's extern
+// stage. Funcs passed as extern arguments become buffer arguments,
+// one per tuple element, so each buffer argument is paired with the
+// value index it refers to.
+class SubstituteExternArguments : public IRMutator {
+    using IRMutator::visit;
+
+    const std::map<string, std::pair<ExternFuncArgument, int>> &buffers;
+    const std::map<string, Expr> &scalars;
+    const string &stage;
+
+    Expr visit(const Call *op) override {
+        Expr expr = IRMutator::visit(op);
+        op = expr.as<Call>();
+        internal_assert(op);
+        if (op->call_type != Call::Image) {
+            return expr;
+        }
+        auto it = buffers.find(op->name);
+        if (it == buffers.end()) {
+            return expr;
+        }
+        const ExternFuncArgument &arg = it->second.first;
+        Expr result;
+        if (arg.is_func()) {
+            result = Call::make(Function(arg.func), op->args, it->second.second);
+        } else if (arg.is_buffer()) {
+            result = Call::make(arg.buffer, op->args);
+        } else {
+            result = Call::make(arg.image_param, op->args);
+        }
+        user_assert(result.type() == op->type)
+            << "Can't inline the pipeline called by extern stage " << stage
+            << ", because its input " << op->name << " has type " << op->type
+            << ", but is passed a buffer of type " << result.type() << "\n";
+        return result;
     }
 
+    Expr visit(const Variable *op) override {
+        if (!op->param.defined()) {
+            return op;
+        }
+        if (!op->param.is_buffer()) {
+            auto it = scalars.find(op->name);
+            if (it == scalars.end()) {
+                return op;
+            }
+            user_assert(it->second.type() == op->type)
+                << "Can't inline the pipeline called by extern stage " << stage
+                << ", because its parameter " << op->name << " has type " << op->type
+                << ", but is passed a value of type " << it->second.type() << "\n";
+            return it->second;
+        }
+        // A field of an input buffer, such as its min or extent.
+        auto it = buffers.find(op->param.name());
+        if (it == buffers.end()) {
+            return op;
+        }
+        const ExternFuncArgument &arg = it->second.first;
+        user_assert(!arg.is_func())
+            << "Can't inline the pipeline called by extern stage " << stage
+            << ", because it uses " << op->name << ", and the Func passed for "
+            << op->param.name() << " has no buffer until it is scheduled.\n";
+        string field = op->name.substr(op->param.name().size());
+        if (arg.is_buffer()) {
+            return Variable::make(op->type, arg.buffer.name() + field, arg.buffer);
+        } else {
+            return Variable::make(op->type, arg.image_param.name() + field, arg.image_param);
+        }
+    }
+
+public:
+    SubstituteExternArguments(const std::map<string, std::pair<ExternFuncArgument, int>> &buffers,
+                              const std::map<string, Expr> &scalars,
+                              const string &stage)
+        : buffers(buffers), scalars(scalars), stage(stage) {}
+};
+
+// Make a copy of the graph of Funcs rooted at the given outputs, in
+// which each extern stage that calls one of the given pipelines is
+// replaced by a pure Func with the same name and schedule that calls
+// a copy of that pipeline's output directly. The pipeline's Funcs
+// then take part in scheduling along with the caller's: by default
+// its output is inlined into the stand-in, and so is computed
+// wherever the extern stage would have been.
+vector<Function> splice_pipelines(const vector<Function> &outputs,
+                                  const std::map<string, SplicedPipeline> &pipelines) {
+    std::map<string, Function> env;
+    for (const Function &f : outputs) {
+        populate_environment(f, env);
+    }
+    vector<Function> copied_outputs;
+    std::tie(copied_outputs, env) = deep_copy(outputs, env);
+
+    std::map<FunctionPtr, FunctionPtr> substitutions;
+    std::map<string, Function> spliced_env;
+    for (const auto &iter : env) {
+        Function f = iter.second;
+        if (!f.has_extern_definition()) {
+            continue;
+        }
+        auto p = pipelines.find(f.extern_function_name());
+        if (p == pipelines.end()) {
+            continue;
+        }
+        const SplicedPipeline &pipeline = p->second;
+        user_assert(pipeline.outputs.size() == 1)
+            << "Can't inline the pipeline called by extern stage " << f.name()
+            << ", because it has more than one output Func.\n";
+
+        std::map<string, Function> inner_env;
+        populate_environment(pipeline.outputs[0], inner_env);
+        vector<Function> inner_outputs;
+        std::tie(inner_outputs, inner_env) = deep_copy(pipeline.outputs, inner_env);
+        Function inner_output = inner_outputs[0];
+        user_assert(inner_output.dimensions() == f.dimensions() &&
+                    inner_output.output_types() == f.output_types())
+            << "Can't inline the pipeline called by extern stage " << f.name()
+            << ", because its output " << inner_output.name()
+            << " has a different type or dimensionality.\n";
+
+        // Match up the extern stage's arguments with the pipeline's.
+        std::map<string, std::pair<ExternFuncArgument, int>> buffers;
+        std::map<string, Expr> scalars;
+        size_t next = 0;
+        for (const ExternFuncArgument &arg : f.extern_arguments()) {
+            int count = arg.is_func() ? Function(arg.func).outputs() : 1;
+            for (int i = 0; i < count; i++, next++) {
+                user_assert(next < pipeline.args.size())
+                    << "Extern stage " << f.name() << " passes more arguments than "
+                    << "the pipeline it calls takes.\n";
+                const InferredArgument &param = pipeline.args[next];
+                user_assert(param.arg.is_buffer() == !arg.is_expr())
+                    << "Extern stage " << f.name() << " passes a "
+                    << (arg.is_expr() ? "scalar" : "buffer") << " for argument "
+                    << param.arg.name << " of the pipeline it calls.\n";
+                if (arg.is_expr()) {
+                    scalars[param.arg.name] = arg.expr;
+                } else {
+                    buffers[param.arg.name] = {arg, i};
+                }
+            }
+        }
+        user_assert(next == pipeline.args.size())
+            << "Extern stage " << f.name() << " passes fewer arguments than "
+            << "the pipeline it calls takes.\n";
+
+        SubstituteExternArguments substitute(buffers, scalars, f.name());
+        for (auto &inner_iter : inner_env) {
+            user_assert(!env.count(inner_iter.first) && !spliced_env.count(inner_iter.first))
+                << "Can't inline the pipeline called by extern stage " << f.name()
+                << ", because it has a Func named " << inner_iter.first
+                << ", and so does the pipeline it is inlined into.\n";
+            inner_iter.second.mutate(&substitute);
+            spliced_env.emplace(inner_iter.first, inner_iter.second);
+        }
+
+        Function stand_in(f.name());
+        vector<Expr> args, values;
+        for (const string &arg : f.args()) {
+            args.push_back(Variable::make(Int(32), arg));
+        }
+        for (int i = 0; i < inner_output.outputs(); i++) {
+            values.push_back(Call::make(inner_output, args, i));
+        }
+        stand_in.define(f.args(), values);
+        stand_in.schedule() = f.schedule();
+        substitutions.emplace(f.get_contents(), stand_in.get_contents());
+    }
+
+    if (substitutions.empty()) {
+        return outputs;
+    }
+
+    // Point everything that used the extern stages at their stand-ins.
+    spliced_env.insert(env.begin(), env.end());
+    for (auto &iter : spliced_env) {
+        Function f = iter.second;
+        f.substitute_calls(substitutions);
+        if (f.has_extern_definition()) {
+            for (ExternFuncArgument &arg : f.extern_arguments()) {
+                if (arg.is_func() && substitutions.count(arg.func)) {
+                    arg.func = substitutions[arg.func];
+                }
+            }
+        }
+    }
+    for (Function &f : copied_outputs) {
+        auto it = substitutions.find(f.get_contents());
+        if (it != substitutions.end()) {
+            f = Function(it->second);
+        }
+    }
+    return copied_outputs;
+}
+
+}  // namespace
+
+vector<Argument> Pipeline::infer_arguments(Stmt body) {
+    contents->inferred_args = infer_jit_arguments(*contents, body);
+
     // Return the inferred argument types, minus any constant images
     // (we'll embed those in the binary by default), and minus the user_context arg.
     vector<Argument> result;
@@ -455,13 +819,32 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
             custom_passes.push_back(p.pass);
         }
 
-        contents->module = lower(contents->outputs, new_fn_name, target, lowering_args,
+        contents->module = lower(lowering_outputs(), new_fn_name, target, lowering_args,
                                  linkage_type, contents->requirements, custom_passes);
     }
 
     return contents->module;
 }
 
+vector<Function> Pipeline::lowering_outputs() const {
+    // Splice in the pipelines of any JITExterns that asked to be
+    // inlined into their callers.
+    vector<Function> outputs = contents->outputs;
+    std::map<string, SplicedPipeline> spliced;
+    for (const auto &e : contents->jit_externs) {
+        const Pipeline &pipeline = e.second.pipeline();
+        if (e.second.inlined_into_caller()) {
+            user_assert(pipeline.defined())
+                << "JITExtern " << e.first << " is not a Pipeline or Func, so it can't be inlined into its caller.\n";
+            spliced[e.first] = {pipeline.contents->outputs, infer_jit_arguments(*pipeline.contents, Stmt())};
+        }
+    }
+    if (!spliced.empty()) {
+        outputs = splice_pipelines(outputs, spliced);
+    }
+    return outputs;
+}
+
 std::string Pipeline::generate_function_name() const {
     user_assert(defined()) << "Pipeline is undefined\n";
     // Come up with a name for a generated function
@@ -474,6 +857,54 @@ std::string Pipeline::generate_function_name() const {
     return name;
 }
 
+namespace {
+
+void decide_specializations(Definition &def, const vector<int> &decisions,
+                            vector<Expr> *conditions) {
+    for (Specialization &s : def.specializations()) {
+        Expr c = simplify(s.condition);
+        if (!is_const(c)) {
+            const size_t i = conditions->size();
+            conditions->push_back(c);
+            if (i < decisions.size() && decisions[i] == 0) {
+                s.condition = const_false();
+            } else if (i < decisions.size() && decisions[i] == 1) {
+                s.condition = const_true();
+            }
+        }
+        decide_specializations(s.definition, decisions, conditions);
+    }
+}
+
+// Replace outputs with copies, in which the conditions of the
+// specializations that depend on the arguments are replaced with the
+// value at the same position in decisions: 0 for false and 1 for
+// true, or -1 to leave the condition as it is. Conditions past the
+// end of decisions are left as they are. Returns the conditions, in
+// the order they are visited, which is the same for copies of the
+// same Funcs.
+vector<Expr> decide_specializations(vector<Function> &outputs, const vector<int> &decisions) {
+    std::map<string, Function> env;
+    for (const Function &f : outputs) {
+        populate_environment(f, env);
+    }
+    auto copied = deep_copy(outputs, env);
+    outputs = copied.first;
+    vector<Expr> conditions;
+    for (auto &p : copied.second) {
+        Function &f = p.second;
+        if (f.has_pure_definition()) {
+            decide_specializations(f.definition(), decisions, &conditions);
+        }
+        for (size_t i = 0; i < f.updates().size(); i++) {
+            decide_specializations(f.update(i), decisions, &conditions);
+        }
+    }
+    return conditions;
+}
+
+}  // namespace
+
 void Pipeline::compile_jit(const Target &target_arg) {
     user_assert(defined()) << "Pipeline is undefined\n";
 
@@ -518,8 +949,29 @@ void Pipeline::compile_jit(const Target &target_arg) {
     // Come up with a name for the generated function
     string name = generate_function_name();
 
-    // Compile to a module and also compile any submodules.
-    Module module = compile_to_module(args, name, target).resolve_submodules();
+    // Compile to a module and also compile any submodules. With lazy
+    // specializations, the specializations that depend on the
+    // arguments are left out until a call takes them.
+    Module module("", Target());
+    vector<Function> lazy_outputs;
+    vector<Expr> lazy_conditions;
+    if (contents->lazy_specializations && target.arch != Target::WebAssembly) {
+        lazy_outputs = lowering_outputs();
+        lazy_conditions = decide_specializations(lazy_outputs, {});
+    }
+    if (!lazy_conditions.empty()) {
+        vector<Function> outputs = lazy_outputs;
+        decide_specializations(outputs, vector<int>(lazy_conditions.size(), 0));
+        vector<IRMutator *> custom_passes;
+        for (CustomLoweringPass p : contents->custom_lowering_passes) {
+            custom_passes.push_back(p.pass);
+        }
+        contents->module = lower(outputs, name, target, args, LinkageType::ExternalPlusMetadata,
+                                 contents->requirements, custom_passes);
+        module = contents->module.resolve_submodules();
+    } else {
+        module = compile_to_module(args, name, target).resolve_submodules();
+    }
 
     std::map<std::string, JITExtern> lowered_externs = contents->jit_externs;
 
@@ -554,7 +1006,8 @@ void Pipeline::compile_jit(const Target &target_arg) {
     auto f = module.get_function_by_name(name);
 
     // Compile to jit module
-    JITModule jit_module(module, f, make_externs_jit_module(target_arg, lowered_externs));
+    contents->jit_dependencies = make_externs_jit_module(target_arg, lowered_externs);
+    JITModule jit_module(module, f, contents->jit_dependencies);
 
     // Dump bitcode to a file if the environment variable
     // HL_GENBITCODE is defined to a nonzero value.
@@ -569,6 +1022,87 @@ void Pipeline::compile_jit(const Target &target_arg) {
     }
 
     contents->jit_module = jit_module;
+    contents->lazy_outputs = lazy_outputs;
+    contents->lazy_conditions = lazy_conditions;
+}
+
+namespace {
+
+// Compilation of replacements happens on one background thread, so
+// that realize never waits for it.
+ThreadPool<void> &jit_replacement_thread() {
+    static ThreadPool<void> pool(1);
+    return pool;
+}
+
+void compile_jit_replacement(std::shared_ptr<JITReplacement> replacement,
+                             vector<Function> outputs, string name, vector<Argument> args,
+                             vector<Stmt> requirements, vector<IRMutator *> custom_passes) {
+#ifdef WITH_EXCEPTIONS
+    try {
+#endif
+        Module module = lower(outputs, name, replacement->target, args,
+                              LinkageType::ExternalPlusMetadata, requirements, custom_passes);
+        Module resolved = module.resolve_submodules();
+        replacement->jit_module = JITModule(resolved, resolved.get_function_by_name(name),
+                                            replacement->dependencies);
+        replacement->module = module;
+        debug(1) << "Compiled a replacement for " << name << "\n";
+#ifdef WITH_EXCEPTIONS
+    } catch (...) {
+        // Keep using the current code.
+        debug(1) << "Failed to compile a replacement for " << name << "\n";
+    }
+#endif
+    replacement->done.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+void Pipeline::compile_jit_in_background(const Target &target_arg) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(target_arg.arch != Target::WebAssembly)
+        << "Pipelines can't be compiled in the background for WebAssembly\n";
+    for (Function f : contents->outputs) {
+        user_assert(f.has_pure_definition() || f.has_extern_definition())
+            << "Can't compile Pipeline with undefined output Func: " << f.name() << ".\n";
+    }
+
+    // Everything that reads the Funcs or the externs happens here, so
+    // that the background thread only lowers and compiles copies.
+    auto replacement = std::make_shared<JITReplacement>();
+    replacement->target = target_arg;
+    replacement->target.set_feature(Target::JIT);
+    replacement->target.set_feature(Target::UserContext);
+    replacement->inferred_args = infer_jit_arguments(*contents, Stmt());
+    std::map<std::string, JITExtern> lowered_externs = contents->jit_externs;
+    replacement->dependencies = make_externs_jit_module(target_arg, lowered_externs);
+
+    vector<Argument> args;
+    for (const InferredArgument &arg : replacement->inferred_args) {
+        args.push_back(arg.arg);
+    }
+    vector<IRMutator *> custom_passes;
+    for (CustomLoweringPass p : contents->custom_lowering_passes) {
+        custom_passes.push_back(p.pass);
+    }
+    vector<Function> outputs = lowering_outputs();
+    std::map<string, Function> env;
+    for (const Function &f : outputs) {
+        populate_environment(f, env);
+    }
+    outputs = deep_copy(outputs, env).first;
+
+    debug(1) << "Compiling a replacement for " << generate_function_name() << " in the background\n";
+    contents->jit_replacement = replacement;
+    jit_replacement_thread().async(compile_jit_replacement, replacement, outputs,
+                                   generate_function_name(), args, contents->requirements,
+                                   custom_passes);
+}
+
+bool Pipeline::jit_replacement_pending() const {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    return contents->jit_replacement != nullptr;
 }
 
 
@@ -655,7 +1189,11 @@ Realization Pipeline::realize(vector<int32_t> sizes, const Target &target,
         realize(r, target, param_map);
     }
     for (size_t i = 0; i < r.size(); i++) {
-        r[i].allocate();
+        if (contents->output_pool_size > 0) {
+            contents->allocate_pooled_output(r[i]);
+        } else {
+            r[i].allocate();
+        }
     }
     // Do the actual computation
     realize(r, target, param_map);
@@ -947,7 +1485,10 @@ Pipeline::make_externs_jit_module(const Target &target,
          iter != externs_in_out.end();
          iter++) {
         Pipeline pipeline = iter->second.pipeline();
-        if (pipeline.defined()) {
+        if (iter->second.inlined_into_caller()) {
+            // Its Funcs were compiled into the caller.
+            continue;
+        } else if (pipeline.defined()) {
             PipelineContents &pipeline_contents(*pipeline.contents);
 
             // Ensure that the pipeline is compiled.
@@ -989,7 +1530,294 @@ int Pipeline::call_jit_code(const Target &target, const JITCallArgs &args) {
         internal_assert(contents->wasm_module.contents.defined());
         return contents->wasm_module.run(args.store);
     }
-    return contents->jit_module.argv_function()(args.store);
+    // Hold a reference to the code for the duration of the call, in
+    // case a replacement is switched to while it runs.
+    JITModule jit_module = jit_module_for_call(&args);
+    return jit_module.argv_function()(args.store);
+}
+
+namespace {
+
+// Read a scalar argument of type t as a constant.
+Expr scalar_argument_value(Type t, const void *ptr) {
+    if (t.is_float()) {
+        return make_const(t, t.bits() == 32 ? (double)*(const float *)ptr : *(const double *)ptr);
+    }
+    uint64_t bits = 0;
+    memcpy(&bits, ptr, t.bytes());
+    if (t.is_int()) {
+        // Sign-extend.
+        const int shift = 64 - t.bits();
+        return make_const(t, ((int64_t)(bits << shift)) >> shift);
+    }
+    return make_const(t, bits);
+}
+
+// Collect the argument values of a JIT call that an automatic
+// specialization bakes in: the min, extent and stride of each
+// dimension of the input and output buffers, and the values of the
+// integer and floating point scalar parameters. If replacements is
+// not null, also fill it in with the constants to use in place of the
+// variables that hold these values in the lowered code. Returns false
+// if the call can't be specialized, because an input is unbound.
+bool observed_argument_values(const PipelineContents &contents, const void *const *store,
+                              vector<int64_t> *values, std::map<string, Expr> *replacements) {
+    auto add_buffer = [&](const string &name, const halide_buffer_t *buf) {
+        for (int d = 0; d < buf->dimensions; d++) {
+            const halide_dimension_t &dim = buf->dim[d];
+            values->push_back(dim.min);
+            values->push_back(dim.extent);
+            values->push_back(dim.stride);
+            if (replacements) {
+                const string suffix = "." + std::to_string(d);
+                (*replacements)[name + ".min" + suffix] = dim.min;
+                (*replacements)[name + ".extent" + suffix] = dim.extent;
+                (*replacements)[name + ".stride" + suffix] = dim.stride;
+            }
+        }
+    };
+
+    size_t i = 0;
+    for (const InferredArgument &arg : contents.inferred_args) {
+        const void *ptr = store[i++];
+        if (!arg.param.defined() || arg.param.same_as(contents.user_context_arg.param)) {
+            // Embedded buffers are already constant.
+            continue;
+        }
+        if (arg.arg.is_buffer()) {
+            if (ptr == nullptr) {
+                return false;
+            }
+            add_buffer(arg.arg.name, (const halide_buffer_t *)ptr);
+        } else {
+            const Type t = arg.arg.type;
+            if (t.is_handle() || (t.is_float() && t.bits() < 32)) {
+                continue;
+            }
+            int64_t bits = 0;
+            memcpy(&bits, ptr, t.bytes());
+            values->push_back(bits);
+            if (replacements) {
+                (*replacements)[arg.arg.name] = scalar_argument_value(t, ptr);
+            }
+        }
+    }
+    for (const Function &out : contents.outputs) {
+        for (const Parameter &buf : out.output_buffers()) {
+            add_buffer(buf.name(), (const halide_buffer_t *)store[i++]);
+        }
+    }
+    return true;
+}
+
+// Replace the buffer fields and scalar parameters that an automatic
+// specialization is compiled for with constants. The buffer fields
+// are defined by LetStmts at the top of the pipeline.
+class ReplaceObservedValues : public IRMutator {
+    using IRMutator::visit;
+
+    const std::map<string, Expr> &replacements;
+
+    Stmt visit(const LetStmt *op) override {
+        auto it = replacements.find(op->name);
+        if (it != replacements.end()) {
+            return LetStmt::make(op->name, it->second, mutate(op->body));
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Variable *op) override {
+        if (op->param.defined() && !op->param.is_buffer()) {
+            auto it = replacements.find(op->name);
+            if (it != replacements.end()) {
+                return it->second;
+            }
+        }
+        return op;
+    }
+
+public:
+    ReplaceObservedValues(const std::map<string, Expr> &replacements)
+        : replacements(replacements) {}
+};
+
+// Compilation of automatic specializations happens on one background
+// thread, so that realize never waits for it.
+ThreadPool<void> &auto_specialization_thread() {
+    static ThreadPool<void> pool(1);
+    return pool;
+}
+
+void compile_auto_specialization(std::shared_ptr<AutoSpecialization> specialization,
+                                 vector<Function> outputs, string name, Target target,
+                                 vector<Argument> args, vector<Stmt> requirements,
+                                 std::map<string, Expr> replacements,
+                                 vector<JITModule> dependencies) {
+#ifdef WITH_EXCEPTIONS
+    try {
+#endif
+        Module module = lower(outputs, name, target, args, LinkageType::External, requirements);
+        for (LoweredFunc &f : module.functions()) {
+            if (f.name == name) {
+                f.body = simplify(ReplaceObservedValues(replacements).mutate(f.body));
+            }
+        }
+        module = module.resolve_submodules();
+        specialization->jit_module = JITModule(module, module.get_function_by_name(name), dependencies);
+        debug(1) << "Compiled an automatic specialization of " << name << "\n";
+#ifdef WITH_EXCEPTIONS
+    } catch (...) {
+        // Keep using the generic code.
+        debug(1) << "Failed to compile an automatic specialization of " << name << "\n";
+    }
+#endif
+    specialization->done.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+void Pipeline::set_output_buffer_pool_size(int max_buffers) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(max_buffers >= 0) << "The size of the output buffer pool must not be negative\n";
+    contents->output_pool_size = max_buffers;
+    // Drop the free buffers beyond the new size first, then the oldest
+    // of those still in use, which their users keep alive.
+    vector<Buffer<>> &pool = contents->output_pool;
+    for (auto it = pool.begin(); it != pool.end() && (int)pool.size() > max_buffers;) {
+        if (it->get()->host_memory_ref_count() == 1) {
+            it = pool.erase(it);
+        } else {
+            it++;
+        }
+    }
+    while ((int)pool.size() > max_buffers) {
+        pool.erase(pool.begin());
+    }
+}
+
+void Pipeline::set_auto_specialize(int min_calls) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(min_calls >= 0) << "The number of calls before specializing must not be negative\n";
+    contents->auto_specialize_calls = min_calls;
+    contents->observed_values.clear();
+    contents->observed_repeats = 0;
+    contents->auto_specialization.reset();
+}
+
+bool Pipeline::call_auto_specialized_jit_code(const Target &target, const JITCallArgs &args, int *exit_status) {
+    PipelineContents &c = *contents;
+    if (c.auto_specialize_calls <= 0 ||
+        target.arch == Target::WebAssembly ||
+        !c.custom_lowering_passes.empty()) {
+        return false;
+    }
+
+    vector<int64_t> values;
+    if (!observed_argument_values(c, args.store, &values, nullptr)) {
+        return false;
+    }
+
+    std::shared_ptr<AutoSpecialization> specialization = c.auto_specialization;
+    const bool done = specialization && specialization->done.load(std::memory_order_acquire);
+    if (done && specialization->values == values) {
+        if (!specialization->jit_module.compiled()) {
+            return false;
+        }
+        *exit_status = specialization->jit_module.argv_function()(args.store);
+        return true;
+    }
+
+    if (values == c.observed_values) {
+        c.observed_repeats++;
+    } else {
+        c.observed_values = values;
+        c.observed_repeats = 1;
+    }
+
+    // Start compiling a specialization for these values, replacing
+    // the previous one, unless one is already compiling.
+    if (c.observed_repeats >= c.auto_specialize_calls &&
+        (!specialization || (done && specialization->values != values))) {
+        vector<int64_t> same_values;
+        std::map<string, Expr> replacements;
+        observed_argument_values(c, args.store, &same_values, &replacements);
+
+        vector<Argument> lowering_args;
+        for (const InferredArgument &arg : c.inferred_args) {
+            lowering_args.push_back(arg.arg);
+        }
+
+        debug(1) << "Compiling an automatic specialization of " << generate_function_name()
+                 << " after " << c.observed_repeats << " calls\n";
+        c.auto_specialization = std::make_shared<AutoSpecialization>();
+        c.auto_specialization->values = values;
+        auto_specialization_thread().async(compile_auto_specialization, c.auto_specialization,
+                                           c.outputs, generate_function_name(), c.jit_target,
+                                           lowering_args, c.requirements, replacements,
+                                           c.jit_dependencies);
+    }
+    return false;
+}
+
+void Pipeline::set_lazy_specializations(bool lazy) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    if (contents->lazy_specializations != lazy) {
+        contents->lazy_specializations = lazy;
+        contents->invalidate_cache();
+    }
+}
+
+JITModule Pipeline::jit_module_for_call(const JITCallArgs *args) {
+    PipelineContents &c = *contents;
+    if (c.lazy_conditions.empty()) {
+        return c.jit_module;
+    }
+
+    // Evaluate the conditions of the specializations left out of
+    // jit_module on the arguments. If an input is unbound, the
+    // default code reports the error.
+    vector<int> decisions(c.lazy_conditions.size(), -1);
+    if (args) {
+        vector<int64_t> values;
+        std::map<string, Expr> replacements;
+        if (!observed_argument_values(c, args->store, &values, &replacements)) {
+            return c.jit_module;
+        }
+        bool all_false = true;
+        for (size_t i = 0; i < decisions.size(); i++) {
+            Expr value = simplify(substitute(replacements, c.lazy_conditions[i]));
+            decisions[i] = is_one(value) ? 1 : (is_zero(value) ? 0 : -1);
+            all_false = all_false && decisions[i] == 0;
+        }
+        if (all_false) {
+            return c.jit_module;
+        }
+    }
+
+    auto it = c.lazy_jit_modules.find(decisions);
+    if (it != c.lazy_jit_modules.end()) {
+        return it->second;
+    }
+
+    // This is the first call to take these specializations, so
+    // compile them now.
+    vector<Function> outputs = c.lazy_outputs;
+    decide_specializations(outputs, decisions);
+    vector<Argument> lowering_args;
+    for (const InferredArgument &arg : c.inferred_args) {
+        lowering_args.push_back(arg.arg);
+    }
+    vector<IRMutator *> custom_passes;
+    for (CustomLoweringPass p : c.custom_lowering_passes) {
+        custom_passes.push_back(p.pass);
+    }
+    const string name = generate_function_name();
+    debug(1) << "Compiling the specializations of " << name << " taken by this call\n";
+    Module module = lower(outputs, name, c.jit_target, lowering_args, LinkageType::ExternalPlusMetadata,
+                          c.requirements, custom_passes).resolve_submodules();
+    JITModule jit_module(module, module.get_function_by_name(name), c.jit_dependencies);
+    c.lazy_jit_modules[decisions] = jit_module;
+    return jit_module;
 }
 
 void Pipeline::realize(RealizationArg outputs, const Target &t,
@@ -999,6 +1827,8 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
 
     debug(2) << "Realizing Pipeline for " << target << "\n";
 
+    contents->install_jit_replacement();
+
     // If target is unspecified...
     if (target.os == Target::OSUnknown) {
         // If we've already jit-compiled for a specific target, use that.
@@ -1082,7 +1912,10 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
     // exception.
 
     debug(2) << "Calling jitted function\n";
-    int exit_status = call_jit_code(target, args);
+    int exit_status;
+    if (!call_auto_specialized_jit_code(target, args, &exit_status)) {
+        exit_status = call_jit_code(target, args);
+    }
     debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
 
     // If we're profiling, report runtimes and reset profiler stats.
@@ -1101,9 +1934,130 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
         }
     }
 
+    // If we're counting branches, write out the counts so far, so
+    // that a later compile can use them.
+    if (target.has_feature(Target::ProfileBranches)) {
+        JITModule::Symbol dump_sym =
+            contents->jit_module.find_symbol_by_name("halide_branch_profile_dump");
+        if (dump_sym.address) {
+            int (*dump_fn_ptr)(void *) = (int (*)(void *))(dump_sym.address);
+            dump_fn_ptr(&jit_context.jit_context);
+        }
+    }
+
     jit_context.finalize(exit_status);
 }
 
+struct JITBoundCall::Contents {
+    // Keep the compiled code alive, even if the Pipeline is recompiled.
+    JITModule jit_module;
+    WasmModule wasm_module;
+    JITModule::argv_wrapper argv_function{nullptr};
+
+    // The arguments to pass, as marshalled by prepare_jit_call_arguments.
+    std::vector<const void *> args;
+
+    // Keep the output buffers alive, if we were given Buffers and not
+    // a raw halide_buffer_t.
+    std::vector<Buffer<>> outputs;
+
+    JITFuncCallContext jit_context;
+    void *user_context_storage;
+
+    void (*profiler_report)(void *){nullptr};
+    void (*profiler_reset)(){nullptr};
+
+    Contents(const JITHandlers &handlers) :
+        jit_context(handlers), user_context_storage(&jit_context.jit_context) {}
+};
+
+void JITBoundCall::run() {
+    user_assert(defined()) << "Can't run an undefined JITBoundCall\n";
+    Contents &c = *contents;
+
+    int exit_status;
+    if (c.wasm_module.contents.defined()) {
+        exit_status = c.wasm_module.run(c.args.data());
+    } else {
+        exit_status = c.argv_function(c.args.data());
+    }
+
+    if (c.profiler_report) {
+        c.profiler_report(&c.jit_context.jit_context);
+        c.profiler_reset();
+    }
+
+    c.jit_context.finalize(exit_status);
+}
+
+JITBoundCall Pipeline::bind(RealizationArg outputs, const Target &t,
+                            const ParamMap &param_map) {
+    Target target = t;
+    user_assert(defined()) << "Can't bind an undefined Pipeline\n";
+
+    // Pick the target in the same way as realize.
+    if (target.os == Target::OSUnknown) {
+        if (contents->jit_module.compiled()) {
+            target = contents->jit_target;
+        } else {
+            target = get_jit_target_from_environment();
+        }
+    }
+
+    compile_jit(target);
+
+    JITBoundCall result;
+    result.contents = std::make_shared<JITBoundCall::Contents>(jit_handlers());
+    JITBoundCall::Contents &c = *result.contents;
+
+    if (target.arch == Target::WebAssembly) {
+        c.wasm_module = contents->wasm_module;
+    } else {
+        // The values of the arguments may change before the call, so
+        // with lazy specializations, bind to the code with all of
+        // them in.
+        c.jit_module = jit_module_for_call(nullptr);
+        c.argv_function = c.jit_module.argv_function();
+    }
+
+    JITCallArgs args(contents->inferred_args.size() + outputs.size());
+    prepare_jit_call_arguments(outputs, target, param_map,
+                               &c.user_context_storage, false, args);
+    c.args.assign(args.store, args.store + args.size);
+
+    if (outputs.r) {
+        for (size_t i = 0; i < outputs.r->size(); i++) {
+            c.outputs.push_back((*outputs.r)[i]);
+        }
+    } else if (outputs.buffer_list) {
+        c.outputs = *outputs.buffer_list;
+    }
+
+    if (target.has_feature(Target::Profile)) {
+        JITModule::Symbol report_sym =
+            contents->jit_module.find_symbol_by_name("halide_profiler_report");
+        JITModule::Symbol reset_sym =
+            contents->jit_module.find_symbol_by_name("halide_profiler_reset");
+        if (report_sym.address && reset_sym.address) {
+            c.profiler_report = (void (*)(void *))(report_sym.address);
+            c.profiler_reset = (void (*)())(reset_sym.address);
+        }
+    }
+
+    return result;
+}
+
+std::future<void> Pipeline::realize_async(RealizationArg outputs, const Target &t,
+                                          const ParamMap &param_map) {
+    // Compile and marshal the arguments on the calling thread, so
+    // that errors in the call itself are reported immediately, and
+    // the other thread only runs the pipeline.
+    JITBoundCall call = bind(std::move(outputs), t, param_map);
+    return std::async(std::launch::async, [call]() mutable {
+        call.run();
+    });
+}
+
 void Pipeline::infer_input_bounds(RealizationArg outputs, const ParamMap &param_map) {
     Target target = get_jit_target_from_environment();
 
@@ -1246,4 +2200,11 @@ JITExtern::JITExtern(const ExternCFunction &extern_c_function)
     : extern_c_function_(extern_c_function) {
 }
 
+JITExtern &JITExtern::inline_into_caller(bool enable) {
+    user_assert(pipeline_.defined() || !enable)
+        << "Only a JITExtern made from a Pipeline or Func can be inlined into its caller.\n";
+    inline_into_caller_ = enable;
+    return *this;
+}
+
 }  // namespace Halide
@@ -7,6 +7,8 @@
  * pipeline.
  */
 
+#include <future>
+#include <memory>
 #include <vector>
 
 #include "AutoSchedule.h"
@@ -27,6 +29,7 @@ struct Outputs;
 struct PipelineContents;
 
 namespace Internal {
+class Function;
 class IRMutator;
 }  // namespace Internal
 
@@ -55,6 +58,36 @@ struct CustomLoweringPass {
 
 struct JITExtern;
 
+/** A JIT-compiled Pipeline with its output buffers and input
+ * arguments bound ahead of time, made by Pipeline::bind. Running it
+ * skips the per-call compilation check and argument marshalling that
+ * Pipeline::realize does, which matters for small pipelines that are
+ * called very many times.
+ *
+ * Scalar Params are bound by address, so setting a Param between
+ * calls to run() takes effect. Buffers are bound by address too, so
+ * binding a different Buffer to an ImageParam, or replacing an output
+ * halide_buffer_t, requires calling Pipeline::bind again. A
+ * JITBoundCall keeps its compiled code alive even if the Pipeline is
+ * later recompiled. It must not be run from more than one thread at a
+ * time. */
+class JITBoundCall {
+    struct Contents;
+    std::shared_ptr<Contents> contents;
+    friend class Pipeline;
+
+public:
+    JITBoundCall() = default;
+
+    bool defined() const {
+        return contents != nullptr;
+    }
+
+    /** Run the pipeline. Errors are reported in the same way as for
+     * Pipeline::realize. */
+    void run();
+};
+
 /** A class representing a Halide pipeline. Constructed from the Func
  * or Funcs that it outputs. */
 class Pipeline {
@@ -106,6 +139,21 @@ public:
 
     int call_jit_code(const Target &target, const JITCallArgs &args);
 
+    // Run the automatic specialization for these arguments instead of
+    // call_jit_code if there is one, which returns true.
+    bool call_auto_specialized_jit_code(const Target &target, const JITCallArgs &args, int *exit_status);
+
+    // The jit-compiled code to call with these arguments: the compiled
+    // code of the pipeline, or with lazy specializations, the version
+    // of it for the specializations the arguments take, which is
+    // compiled the first time it is needed. With null args, the
+    // version with every specialization in.
+    Internal::JITModule jit_module_for_call(const JITCallArgs *args);
+
+    // The outputs to lower, with the pipelines of any JITExterns that
+    // are inlined into their callers spliced in.
+    std::vector<Internal::Function> lowering_outputs() const;
+
  public:
     /** Make an undefined Pipeline object. */
     Pipeline();
@@ -132,6 +180,13 @@ public:
      * passed nullptr. */
     static void set_custom_auto_scheduler(std::function<std::string(Pipeline, const Target &, const MachineParams &)> auto_scheduler);
 
+    /** Estimate the arithmetic cost and memory traffic of each stage of
+     * the pipeline under its current schedule, and whether each is
+     * likely to be compute- or memory-bound on the given machine. Uses
+     * the auto-scheduler's cost model, so the outputs need
+     * estimates. Returns a human-readable table. */
+    std::string roofline_report(const MachineParams &arch_params = MachineParams::generic());
+
     /** Return handle to the index-th Func within the pipeline based on the
      * topological order. */
     Func get_func(size_t index);
@@ -263,6 +318,21 @@ public:
      */
      void compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** Jit compile a replacement for the current jit-compiled code on
+     * a background thread, e.g. after rescheduling the Funcs, without
+     * invalidating the current code. Calls to realize keep running the
+     * current code until the replacement is ready, and the first call
+     * after that switches to it. Calls already running finish on the
+     * old code, which is released once the last of them returns. If a
+     * replacement is already compiling, this one replaces it. The
+     * Funcs must not be changed until the replacement is ready. Not
+     * supported for WebAssembly. */
+    void compile_jit_in_background(const Target &target = get_jit_target_from_environment());
+
+    /** Check if a replacement started by compile_jit_in_background
+     * has not yet been switched to by realize. */
+    bool jit_replacement_pending() const;
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -427,6 +497,65 @@ public:
     void realize(RealizationArg output, const Target &target = Target(),
                  const ParamMap &param_map = ParamMap::empty_map());
 
+    /** JIT-compile this Pipeline if necessary, and capture everything
+     * needed to realize it into the given buffer or buffers, so that
+     * it can be run repeatedly with minimal overhead. See
+     * JITBoundCall. */
+    JITBoundCall bind(RealizationArg output, const Target &target = Target(),
+                      const ParamMap &param_map = ParamMap::empty_map());
+
+    /** Start realizing this Pipeline into the given buffer or buffers,
+     * and return without waiting for it to finish. The pipeline is
+     * compiled if necessary and its arguments are captured as for
+     * bind() before this returns, and then it runs on another thread,
+     * where its parallel loops use the thread pool as usual. Wait on
+     * the returned future to find out when it is done; errors are
+     * reported when you call get() on it. Scalar Params and buffer
+     * contents are read while the pipeline runs, so don't change them
+     * until then. As with realize into existing buffers, GPU outputs
+     * are not copied back to the host, and kernels are launched
+     * asynchronously, so the future may be ready before the device
+     * has finished. */
+    std::future<void> realize_async(RealizationArg output, const Target &target = Target(),
+                                    const ParamMap &param_map = ParamMap::empty_map());
+
+    /** Let realize specialize the JIT-compiled code on the arguments
+     * it is called with: the mins, extents and strides of the input
+     * and output buffers, and the values of the scalar parameters.
+     * Once realize has been called with the same values min_calls
+     * times in a row, a version of the pipeline with those values
+     * baked in is compiled on a background thread, and used for
+     * later calls with the same values once it is ready. Other calls
+     * keep using the generic code. A min_calls of zero turns this
+     * off, which is the default unless the environment variable
+     * HL_JIT_AUTO_SPECIALIZE is set to a number of calls. Pipelines
+     * with custom lowering passes are not specialized, and neither
+     * are calls made through bind() or for WebAssembly. */
+    void set_auto_specialize(int min_calls);
+
+    /** Let compile_jit leave out the specializations of the Funcs
+     * whose conditions depend on the arguments, i.e. on scalar Params
+     * and the shapes of the input and output buffers. Calls whose
+     * arguments take none of them run the default code. The first
+     * call to take a set of them compiles a version of the pipeline
+     * with those specializations in, which later calls that take the
+     * same set reuse. This saves the time spent compiling branches
+     * that never run, at the cost of a pause on the first call to
+     * take each one. Calls through bind(), replacements compiled by
+     * compile_jit_in_background, and WebAssembly compile all the
+     * specializations up front. Off by default. Changing this
+     * invalidates the jit-compiled code. */
+    void set_lazy_specializations(bool lazy);
+
+    /** Let realize reuse the outputs it returned from earlier calls
+     * once the caller no longer refers to them, instead of allocating
+     * new ones. Up to max_buffers outputs are kept, and are reused for
+     * outputs of the same type, mins, extents and strides. Only host
+     * memory is reused. A max_buffers of zero, the default, turns this
+     * off and releases the kept outputs. Outputs passed in to realize
+     * are never pooled. */
+    void set_output_buffer_pool_size(int max_buffers);
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
@@ -539,6 +668,7 @@ private:
     // can be set in a given JITExtern instance.
     Pipeline pipeline_;
     ExternCFunction extern_c_function_;
+    bool inline_into_caller_ = false;
 
 public:
     JITExtern(Pipeline pipeline);
@@ -548,8 +678,23 @@ public:
     template <typename RT, typename... Args>
     JITExtern(RT (*f)(Args... args)) : JITExtern(ExternCFunction(f)) {}
 
+    /** Rather than calling this JITExtern's pipeline as an opaque
+     * function, splice its Funcs into the pipeline that calls it. The
+     * extern stage is replaced by a pure Func of the same name and
+     * schedule that calls the pipeline's output, so the output is
+     * inlined into it, and the pipeline's other Funcs can be
+     * scheduled relative to the caller's (e.g. with compute_at)
+     * instead of always being computed in full. The arguments of the
+     * extern stage are matched to the pipeline's in the order they
+     * would have been passed to it. The pipeline must have a single
+     * output, and must not contain a Func with the same name as one
+     * in the caller. Only valid for a JITExtern made from a Pipeline
+     * or Func. */
+    JITExtern &inline_into_caller(bool enable = true);
+
     const Pipeline &pipeline() const { return pipeline_; }
     const ExternCFunction &extern_c_function() const { return extern_c_function_; }
+    bool inlined_into_caller() const { return inline_into_caller_; }
 };
 
 }  // namespace Halide
@@ -5,6 +5,8 @@
 #include "Bounds.h"
 #include "ExprUsesVar.h"
 #include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
 #include "Prefetch.h"
 #include "Scope.h"
 #include "Simplify.h"
@@ -60,6 +62,52 @@ public:
     }
 };
 
+// Estimate the number of operations executed by one iteration of a
+// loop, given its body. Inner loops with unknown extents are assumed
+// to run a modest number of iterations, and vectorized loops count as
+// a single iteration of vector operations.
+class EstimateIterationCost : public IRGraphVisitor {
+    using IRGraphVisitor::include;
+    using IRGraphVisitor::visit;
+
+    const int64_t unknown_loop_extent = 16;
+
+    void include(const Expr &e) override {
+        if (!e.as<Variable>() && !is_const(e)) {
+            cost++;
+        }
+        IRGraphVisitor::include(e);
+    }
+
+    void visit(const For *op) override {
+        include(op->min);
+        include(op->extent);
+        int64_t outer_cost = cost;
+        cost = 0;
+        include(op->body);
+        int64_t iterations = unknown_loop_extent;
+        if (op->for_type == ForType::Vectorized) {
+            iterations = 1;
+        } else if (const int64_t *extent = as_const_int(op->extent)) {
+            iterations = std::max(*extent, (int64_t)1);
+        }
+        cost = outer_cost + cost * iterations;
+    }
+
+public:
+    int64_t cost = 0;
+};
+
+// Choose the prefetch offset (in iterations of the loop with the given
+// body) that covers the memory latency.
+int auto_prefetch_offset(const Stmt &body, int memory_latency) {
+    EstimateIterationCost estimate;
+    body.accept(&estimate);
+    int64_t cost = std::max(estimate.cost, (int64_t)1);
+    int64_t offset = (memory_latency + cost - 1) / cost;
+    return (int)std::max(offset, (int64_t)1);
+}
+
 class InjectPrefetch : public IRMutator {
 public:
     InjectPrefetch(const map<string, Function> &e, const map<string, Box> &buffers)
@@ -102,7 +150,12 @@ private:
     Stmt visit(const Prefetch *op) override {
         Stmt body = mutate(op->body);
 
-        const PrefetchDirective &p = op->prefetch;
+        PrefetchDirective p = op->prefetch;
+        if (!p.offset.defined()) {
+            p.offset = auto_prefetch_offset(body, p.memory_latency);
+            debug(3) << "Prefetching " << p.name << " at offset " << p.offset
+                     << " of " << p.var << "\n";
+        }
         Expr loop_var = Variable::make(Int(32), p.var);
 
         // Add loop variable + prefetch offset to interval scope for box computation
@@ -149,11 +202,11 @@ private:
                 condition = simplify(prefetch_box.used && condition);
             }
             internal_assert(!new_bounds.empty());
-            return Prefetch::make(op->name, op->types, new_bounds, op->prefetch, condition, std::move(body));
+            return Prefetch::make(op->name, op->types, new_bounds, p, condition, std::move(body));
         }
 
         if (!body.same_as(op->body)) {
-            return Prefetch::make(op->name, op->types, op->bounds, op->prefetch, op->condition, std::move(body));
+            return Prefetch::make(op->name, op->types, op->bounds, p, op->condition, std::move(body));
         } else if (op->bounds.empty()) {
             // Remove the Prefetch IR since it is prefetching an empty region
             user_warning << "Removing prefetch of " << p.name
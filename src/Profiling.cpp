@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstdlib>
 #include <limits>
 #include <map>
 #include <string>
@@ -27,9 +28,22 @@ public:
 
     string pipeline_name;
 
-    InjectProfiling(const string &pipeline_name) : pipeline_name(pipeline_name) {
+    // Whether update stages are attributed to ids of their own, and
+    // the names of the enclosing produce nodes and of the stages we
+    // are inside of, to tell when a loop starts a new stage.
+    bool by_stage;
+    vector<string> producers, stages;
+
+    // The names of the variables holding the slot in which the
+    // current thread records which func it's running. Every parallel
+    // task gets its own slot, so that the profiler can tell what each
+    // thread is doing.
+    vector<string> slots;
+
+    InjectProfiling(const string &pipeline_name, bool by_stage) : pipeline_name(pipeline_name), by_stage(by_stage) {
         indices["overhead"] = 0;
         stack.push_back(0);
+        slots.push_back("profiler_slot");
     }
 
     map<int, uint64_t> func_stack_current; // map from func id -> current stack allocation
@@ -47,6 +61,9 @@ private:
 
     bool profiling_memory = true;
 
+    // Remote targets (i.e. Hexagon) don't have per-thread slots.
+    bool per_thread_slots = true;
+
     // Strip down the tuple name, e.g. f.0 into f
     string normalize_name(const string &name) {
         vector<string> v = split_string(name, ".");
@@ -54,8 +71,8 @@ private:
         return v[0];
     }
 
-    int get_func_id(const string &name) {
-        string norm_name = normalize_name(name);
+    int get_func_id(const string &name, bool normalize = true) {
+        string norm_name = normalize ? normalize_name(name) : name;
         int idx = -1;
         map<string, int>::iterator iter = indices.find(norm_name);
         if (iter == indices.end()) {
@@ -191,7 +208,11 @@ private:
         if (op->is_producer) {
             idx = get_func_id(op->name);
             stack.push_back(idx);
+            producers.push_back(op->name);
+            stages.push_back(op->name + ".s0.");
             body = mutate(op->body);
+            stages.pop_back();
+            producers.pop_back();
             stack.pop_back();
         } else {
             body = mutate(op->body);
@@ -200,16 +221,57 @@ private:
             idx = stack.back();
         }
 
-        Expr profiler_token = Variable::make(Int(32), "profiler_token");
-        Expr profiler_state = Variable::make(Handle(), "profiler_state");
+        body = Block::make(set_current_func(idx), body);
 
+        return ProducerConsumer::make(op->name, op->is_producer, body);
+    }
+
+    Stmt set_current_func(int idx) {
+        Expr profiler_token = Variable::make(Int(32), "profiler_token");
+        Expr slot = Variable::make(Handle(), slots.back());
         // This call gets inlined and becomes a single store instruction.
-        Expr set_task = Call::make(Int(32), "halide_profiler_set_current_func",
-                                   {profiler_state, profiler_token, idx}, Call::Extern);
+        return Evaluate::make(Call::make(Int(32), "halide_profiler_set_current_func",
+                                         {slot, profiler_token, idx}, Call::Extern));
+    }
 
-        body = Block::make(Evaluate::make(set_task), body);
+    // Mark the current thread as idle, because it's waiting for
+    // some parallel tasks to complete.
+    Stmt set_waiting() {
+        Expr slot = Variable::make(Handle(), slots.back());
+        return Evaluate::make(Call::make(Int(32), "halide_profiler_set_current_func",
+                                         {slot, 0, halide_profiler_outside_of_halide}, Call::Extern));
+    }
 
-        return ProducerConsumer::make(op->name, op->is_producer, body);
+    // Wrap a parallel launch, during which the launching thread
+    // just waits for the tasks it launched.
+    Stmt wrap_parallel_launch(const Stmt &s) {
+        if (per_thread_slots) {
+            return Block::make({decr_active_threads(), set_waiting(), s,
+                                set_current_func(stack.back()), incr_active_threads()});
+        } else {
+            return Block::make({decr_active_threads(), s, incr_active_threads()});
+        }
+    }
+
+    // Mutate the body of a parallel task, giving it its own slot.
+    Stmt mutate_parallel_task_body(const Stmt &s) {
+        if (!per_thread_slots) {
+            return Block::make({incr_active_threads(), mutate(s), decr_active_threads()});
+        }
+        string slot_name = unique_name("profiler_slot");
+        slots.push_back(slot_name);
+        Stmt body = mutate(s);
+        slots.pop_back();
+
+        Expr profiler_token = Variable::make(Int(32), "profiler_token");
+        Expr profiler_state = Variable::make(Handle(), "profiler_state");
+        Expr slot = Variable::make(Handle(), slot_name);
+        Expr acquire = Call::make(Handle(), "halide_profiler_acquire_slot",
+                                  {profiler_state, profiler_token + stack.back()}, Call::Extern);
+        Stmt release = Evaluate::make(Call::make(Int(32), "halide_profiler_release_slot",
+                                                 {profiler_state, slot}, Call::Extern));
+        body = Block::make({incr_active_threads(), body, decr_active_threads(), release});
+        return LetStmt::make(slot_name, acquire, body);
     }
 
     Stmt incr_active_threads() {
@@ -230,21 +292,42 @@ private:
         } else if (const Acquire *a = s.as<Acquire>()) {
             return Acquire::make(a->semaphore, a->count, visit_parallel_task(a->body));
         } else {
-            return Block::make({incr_active_threads(), mutate(s), decr_active_threads()});
+            return mutate_parallel_task_body(s);
         }
     }
 
     Stmt visit(const Acquire *op) override {
-        Stmt s = visit_parallel_task(op);
-        return Block::make({decr_active_threads(), s, incr_active_threads()});
+        return wrap_parallel_launch(visit_parallel_task(op));
     }
 
     Stmt visit(const Fork *op) override {
-        Stmt s = visit_parallel_task(op);
-        return Block::make({decr_active_threads(), s, incr_active_threads()});
+        return wrap_parallel_launch(visit_parallel_task(op));
     }
 
     Stmt visit(const For *op) override {
+        // The loops of the stages of a Func are named
+        // <func>.s<stage>.<var>, so a loop of the Func being produced
+        // that isn't part of the current stage starts the next one.
+        if (by_stage && !producers.empty() &&
+            starts_with(op->name, producers.back() + ".s") &&
+            !starts_with(op->name, stages.back())) {
+            const string &func = producers.back();
+            size_t dot = op->name.find('.', func.size() + 2);
+            string stage_prefix = op->name.substr(0, dot + 1);
+            int stage = std::atoi(op->name.c_str() + func.size() + 2);
+            int idx = (stage == 0) ? get_func_id(func) :
+                get_func_id(func + ".update(" + std::to_string(stage - 1) + ")", false);
+            stack.push_back(idx);
+            stages.push_back(stage_prefix);
+            Stmt stmt = visit_loop(op);
+            stages.pop_back();
+            stack.pop_back();
+            return Block::make({set_current_func(idx), stmt, set_current_func(stack.back())});
+        }
+        return visit_loop(op);
+    }
+
+    Stmt visit_loop(const For *op) {
         Stmt body = op->body;
 
         // The for loop indicates a device transition or a
@@ -254,45 +337,58 @@ private:
         bool update_active_threads = (op->device_api == DeviceAPI::Hexagon ||
                                       op->is_unordered_parallel());
 
-        if (update_active_threads) {
-            body = Block::make({incr_active_threads(), body, decr_active_threads()});
-        }
-
         // We profile by storing a token to global memory, so don't enter GPU loops
         if (op->device_api == DeviceAPI::Hexagon) {
             // TODO: This is for all offload targets that support
             // limited internal profiling, which is currently just
             // hexagon. We don't support per-func stats remotely,
-            // which means we can't do memory accounting.
+            // which means we can't do memory accounting, and we
+            // don't track threads separately.
+            body = Block::make({incr_active_threads(), body, decr_active_threads()});
             bool old_profiling_memory = profiling_memory;
+            bool old_per_thread_slots = per_thread_slots;
             profiling_memory = false;
+            per_thread_slots = false;
+            string slot_name = unique_name("hvx_profiler_slot");
+            slots.push_back(slot_name);
             body = mutate(body);
+            slots.pop_back();
             profiling_memory = old_profiling_memory;
+            per_thread_slots = old_per_thread_slots;
 
             // Get the profiler state pointer from scratch inside the
             // kernel. There will be a separate copy of the state on
             // the DSP that the host side will periodically query.
             Expr get_state = Call::make(Handle(), "halide_profiler_get_state", {}, Call::Extern);
-            body = substitute("profiler_state", Variable::make(Handle(), "hvx_profiler_state"), body);
+            Expr hvx_state = Variable::make(Handle(), "hvx_profiler_state");
+            body = substitute("profiler_state", hvx_state, body);
+            body = LetStmt::make(slot_name, Call::make(Handle(), "halide_profiler_main_slot",
+                                                       {hvx_state}, Call::Extern), body);
             body = LetStmt::make("hvx_profiler_state", get_state, body);
         } else if (op->device_api == DeviceAPI::None ||
                    op->device_api == DeviceAPI::Host) {
-            body = mutate(body);
+            if (update_active_threads) {
+                body = mutate_parallel_task_body(body);
+            } else {
+                body = mutate(body);
+            }
         } else {
             body = op->body;
         }
 
         Stmt stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
 
-        if (update_active_threads) {
+        if (op->device_api == DeviceAPI::Hexagon) {
             stmt = Block::make({decr_active_threads(), stmt, incr_active_threads()});
+        } else if (update_active_threads) {
+            stmt = wrap_parallel_launch(stmt);
         }
         return stmt;
     }
 };
 
-Stmt inject_profiling(Stmt s, string pipeline_name) {
-    InjectProfiling profiling(pipeline_name);
+Stmt inject_profiling(Stmt s, string pipeline_name, bool by_stage) {
+    InjectProfiling profiling(pipeline_name, by_stage);
     s = profiling.mutate(s);
 
     int num_funcs = (int)(profiling.indices.size());
@@ -331,6 +427,8 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
     s = Block::make({incr_active_threads, s, decr_active_threads});
 
     s = LetStmt::make("profiler_pipeline_state", get_pipeline_state, s);
+    s = LetStmt::make("profiler_slot", Call::make(Handle(), "halide_profiler_main_slot",
+                                                  {profiler_state}, Call::Extern), s);
     s = LetStmt::make("profiler_state", get_state, s);
     // If there was a problem starting the profiler, it will call an
     // appropriate halide error function and then return the
@@ -33,10 +33,11 @@ namespace Internal {
  * high-resolution timing into the generated code (via spawning a
  * thread that acts as a sampling profiler); summaries of execution
  * times and counts will be logged at the end. Should be done before
- * storage flattening, but after all bounds inference.
- *
+ * storage flattening, but after all bounds inference. If by_stage is
+ * true, the time spent in each update stage of a Func is reported
+ * separately, as \<func_name\>.update(i).
  */
-Stmt inject_profiling(Stmt, std::string);
+Stmt inject_profiling(Stmt, std::string, bool by_stage = false);
 
 }  // namespace Internal
 }  // namespace Halide
@@ -105,20 +105,19 @@ std::pair<string, string> print_type(const LoweredArgument* arg) {
     }
 }
 
-void PythonExtensionGen::convert_buffer(string name, const LoweredArgument* arg) {
+void PythonExtensionGen::convert_buffer(string name, int index, const LoweredArgument* arg) {
     assert(arg->is_buffer());
     assert(arg->dimensions);
-    dest << "    halide_buffer_t buffer_" << name << ";\n";
-    dest << "    halide_dimension_t dimensions_" << name << "[" << (int)arg->dimensions << "];\n";
     dest << "    if (_convert_py_buffer_to_halide(";
-    dest << /*pyobj*/ "py_" << name << ", ";
+    dest << /*pyobj*/ "py_args[" << index << "], ";
     dest << /*dimensions*/ (int)arg->dimensions << ", ";
     dest << /*flags*/ (arg->is_output() ? "PyBUF_WRITABLE" : "0") << ", ";
     dest << /*dim*/ "dimensions_" << name << ", ";
     dest << /*out*/ "&buffer_" << name << ", ";
+    dest << /*buf*/ "&view_" << name << ", ";
     dest << /*name*/ "\"" << name << "\"";
     dest << ") < 0) {\n";
-    dest << "        return NULL;\n";
+    dest << "        goto done;\n";
     dest << "    }\n";
 }
 
@@ -141,71 +140,80 @@ void PythonExtensionGen::compile(const Module &module) {
 #    define HALIDE_PYTHON_EXPORT __attribute__((visibility("default")))
 #endif
 
+/* Python 3.7 and later support the vectorcall convention for
+ * functions, which passes the arguments in an array, without packing
+ * them into a tuple and a dict. */
+#if PY_VERSION_HEX >= 0x03070000
+#    define HALIDE_PYTHON_FASTCALL 1
+#    define HALIDE_PYTHON_METH_FLAGS (METH_FASTCALL | METH_KEYWORDS)
+#else
+#    define HALIDE_PYTHON_FASTCALL 0
+#    define HALIDE_PYTHON_METH_FLAGS (METH_VARARGS | METH_KEYWORDS)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-static __attribute__((unused)) int _convert_py_buffer_to_halide(
-        PyObject* pyobj, int dimensions, int flags,
+static __attribute__((unused)) int _fill_halide_buffer(
+        Py_buffer* buf, int dimensions,
         halide_dimension_t* dim,  // array of size `dimensions`
         halide_buffer_t* out, const char* name) {
-    Py_buffer buf;
-    int ret = PyObject_GetBuffer(
-      pyobj, &buf, PyBUF_FORMAT | PyBUF_STRIDED_RO | PyBUF_ANY_CONTIGUOUS | flags);
-    if (ret < 0) {
-      return ret;
-    }
-    if (dimensions && buf.ndim != dimensions) {
+    if (dimensions && buf->ndim != dimensions) {
       PyErr_Format(PyExc_ValueError, "Invalid argument %s: Expected %d dimensions, got %d",
-                   name, dimensions, buf.ndim);
+                   name, dimensions, buf->ndim);
       return -1;
     }
     /* We'll get a buffer that's either:
-     * C_CONTIGUOUS (last dimension varies the fastest, i.e., has stride=1) or
-     * F_CONTIGUOUS (first dimension varies the fastest, i.e., has stride=1).
-     * The latter is preferred, since it's already in the format that Halide
+     * F_CONTIGUOUS (first dimension varies the fastest, i.e., has stride=1),
+     * C_CONTIGUOUS (last dimension varies the fastest, i.e., has stride=1), or
+     * strided, e.g. a slice of a C_CONTIGUOUS array.
+     * The first is preferred, since it's already in the format that Halide
      * needs. It can can be achieved in numpy by passing order='F' during array
-     * creation. However, if we do get a C_CONTIGUOUS buffer, flip the dimensions
+     * creation. However, if we do get any other buffer, flip the dimensions
      * (transpose) so we can process it without having to reallocate.
      */
     int i, j, j_step;
-    if (PyBuffer_IsContiguous(&buf, 'F')) {
+    int contiguous = 1;
+    if (PyBuffer_IsContiguous(buf, 'F')) {
       j = 0;
       j_step = 1;
-    } else if (PyBuffer_IsContiguous(&buf, 'C')) {
-      j = buf.ndim - 1;
-      j_step = -1;
     } else {
-      /* Python checks all dimensions and strides, so this typically indicates
-       * a bug in the array's buffer protocol. */
-      PyErr_Format(PyExc_ValueError, "Invalid buffer: neither C nor Fortran contiguous");
-      return -1;
+      contiguous = PyBuffer_IsContiguous(buf, 'C');
+      j = buf->ndim - 1;
+      j_step = -1;
     }
-    for (i = 0; i < buf.ndim; ++i, j += j_step) {
+    for (i = 0; i < buf->ndim; ++i, j += j_step) {
+        if (buf->strides[j] % buf->itemsize != 0) {
+            PyErr_Format(PyExc_ValueError, "Invalid buffer %s: strides must be a multiple of the element size",
+                         name);
+            return -1;
+        }
         dim[i].min = 0;
-        dim[i].stride = (int)(buf.strides[j] / buf.itemsize); // strides is in bytes
-        dim[i].extent = (int)buf.shape[j];
+        dim[i].stride = (int)(buf->strides[j] / buf->itemsize); // strides is in bytes
+        dim[i].extent = (int)buf->shape[j];
         dim[i].flags = 0;
-        if (buf.suboffsets && buf.suboffsets[i] >= 0) {
+        if (buf->suboffsets && buf->suboffsets[i] >= 0) {
             // Halide doesn't support arrays of pointers. But we should never see this
             // anyway, since we specified PyBUF_STRIDED.
             PyErr_Format(PyExc_ValueError, "Invalid buffer: suboffsets not supported");
             return -1;
         }
     }
-    if (dim[buf.ndim - 1].extent * dim[buf.ndim - 1].stride * buf.itemsize != buf.len) {
+    if (contiguous &&
+        dim[buf->ndim - 1].extent * dim[buf->ndim - 1].stride * buf->itemsize != buf->len) {
         PyErr_Format(PyExc_ValueError, "Invalid buffer: length %ld, but computed length %ld",
-                     buf.len, buf.shape[0] * buf.strides[0]);
+                     buf->len, buf->shape[0] * buf->strides[0]);
         return -1;
     }
     memset(out, 0, sizeof(*out));
-    if (!buf.format) {
+    if (!buf->format) {
         out->type.code = halide_type_uint;
         out->type.bits = 8;
     } else {
         /* Convert struct type code. See
          * https://docs.python.org/2/library/struct.html#module-struct */
-        char* p = buf.format;
+        char* p = buf->format;
         while (strchr("@<>!=", *p)) {
             p++;  // ignore little/bit endian (and alignment)
         }
@@ -221,19 +229,85 @@ static __attribute__((unused)) int _convert_py_buffer_to_halide(
         }
         const char* type_codes = "bB?hHiIlLqQfd";  // integers and floats
         if (strchr(type_codes, *p)) {
-            out->type.bits = buf.itemsize * 8;
+            out->type.bits = buf->itemsize * 8;
         } else {
             // We don't handle 's' and 'p' (char[]) and 'P' (void*)
-            PyErr_Format(PyExc_ValueError, "Invalid data type for %s: %s", name, buf.format);
+            PyErr_Format(PyExc_ValueError, "Invalid data type for %s: %s", name, buf->format);
             return -1;
         }
     }
     out->type.lanes = 1;
-    out->dimensions = buf.ndim;
+    out->dimensions = buf->ndim;
     out->dim = dim;
-    out->host = (uint8_t*)buf.buf;
+    out->host = (uint8_t*)buf->buf;
+    return 0;
+}
+
+/* Convert a Python object that supports the buffer protocol to a
+ * halide_buffer_t. The view of the object is returned in `buf`, and
+ * must be released with PyBuffer_Release once the halide_buffer_t is
+ * no longer used. On failure, the view is released already. */
+static __attribute__((unused)) int _convert_py_buffer_to_halide(
+        PyObject* pyobj, int dimensions, int flags,
+        halide_dimension_t* dim,  // array of size `dimensions`
+        halide_buffer_t* out, Py_buffer* buf, const char* name) {
+    int ret = PyObject_GetBuffer(pyobj, buf, PyBUF_FORMAT | PyBUF_STRIDED_RO | flags);
+    if (ret < 0) {
+      buf->obj = NULL;
+      return ret;
+    }
+    if (_fill_halide_buffer(buf, dimensions, dim, out, name) < 0) {
+      PyBuffer_Release(buf);
+      return -1;
+    }
+    return 0;
+}
+
+#if HALIDE_PYTHON_FASTCALL
+/* Match the positional and keyword arguments of a vectorcall to the
+ * `n` named parameters in `kwlist`. All parameters are required. */
+static __attribute__((unused)) int _parse_fastcall_args(
+        PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames,
+        const char* const* kwlist, int n, PyObject** out, const char* fname) {
+    Py_ssize_t k, nkw = kwnames ? PyTuple_GET_SIZE(kwnames) : 0;
+    int i;
+    if (nargs > n) {
+        PyErr_Format(PyExc_TypeError, "%s() takes %d arguments (%d given)",
+                     fname, n, (int)(nargs + nkw));
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        out[i] = i < nargs ? args[i] : NULL;
+    }
+    for (k = 0; k < nkw; k++) {
+        const char* key = PyUnicode_AsUTF8(PyTuple_GET_ITEM(kwnames, k));
+        if (!key) {
+            return -1;
+        }
+        for (i = 0; i < n; i++) {
+            if (strcmp(key, kwlist[i]) == 0) {
+                break;
+            }
+        }
+        if (i == n) {
+            PyErr_Format(PyExc_TypeError, "'%s' is an invalid keyword argument for %s()", key, fname);
+            return -1;
+        }
+        if (out[i]) {
+            PyErr_Format(PyExc_TypeError, "Argument given by name ('%s') and position (%d)", key, i + 1);
+            return -1;
+        }
+        out[i] = args[nargs + k];
+    }
+    for (i = 0; i < n; i++) {
+        if (!out[i]) {
+            PyErr_Format(PyExc_TypeError, "Required argument '%s' (pos %d) not found", kwlist[i], i + 1);
+            return -1;
+        }
+    }
     return 0;
 }
+#endif
 
 )INLINE_CODE";
 
@@ -250,8 +324,10 @@ static __attribute__((unused)) int _convert_py_buffer_to_halide(
          * twice, once with new and once with old buffers. Ignore the latter. */
         if (!has_legacy_buffers(f)) {
             const string basename = remove_namespaces(f.name);
-            dest << "    {\"" << basename << "\", (PyCFunction)_f_" << basename
-                 << ", METH_VARARGS|METH_KEYWORDS, NULL},\n";
+            dest << "    {\"" << basename << "\", (PyCFunction)(void(*)(void))_f_" << basename
+                 << ", HALIDE_PYTHON_METH_FLAGS, NULL},\n";
+            dest << "    {\"" << basename << "_batch\", (PyCFunction)_f_" << basename
+                 << "_batch, METH_O, NULL},\n";
         }
     }
     dest << "    {0, 0, 0, NULL},  // sentinel\n";
@@ -288,74 +364,176 @@ HALIDE_PYTHON_EXPORT void init)INLINE_CODE";
 void PythonExtensionGen::compile(const LoweredFunc &f) {
     const std::vector<LoweredArgument> &args = f.args;
     const string basename = remove_namespaces(f.name);
+    const int num_args = (int)args.size();
     std::vector<string> arg_names(args.size());
-    dest << "// " << f.name << "\n";
-    dest << "static PyObject* _f_" << basename << "(PyObject* module, PyObject* args, PyObject* kwargs) {\n";
+    const LoweredArgument *unconvertible = nullptr;
+    bool has_user_context = false;
     for (size_t i = 0; i < args.size(); i++) {
         arg_names[i] = sanitize_name(args[i].name);
-        if (!can_convert(&args[i])) {
-            /* Some arguments can't be converted to Python yet. In those
-             * cases, just add a dummy function that always throws an
-             * Exception. */
-            // TODO: Add support for handles and vectors.
-            dest << "    PyErr_Format(PyExc_NotImplementedError, "
-                 << "\"Can't convert argument " << args[i].name << " from Python\");\n";
-            dest << "    return NULL;\n";
-            dest << "}";
-            return;
+        if (!can_convert(&args[i]) && !unconvertible) {
+            unconvertible = &args[i];
+        }
+        if (args[i].name == "__user_context") {
+            has_user_context = true;
         }
     }
-    dest << "    static const char* kwlist[] = {";
+    dest << "// " << f.name << "\n";
+    dest << "static const char* const _f_" << basename << "_kwlist[] = {";
     for (size_t i = 0; i < args.size(); i++) {
         dest << "\"" << arg_names[i] << "\", ";
     }
-    dest << "NULL};\n";
-    for (size_t i = 0; i < args.size(); i++) {
-        dest << "    " << print_type(&args[i]).second << " py_" << arg_names[i] << ";\n";
+    dest << "NULL};\n\n";
+
+    /* The arguments are converted and the pipeline is called by a
+     * function that takes an array of Python objects, which is shared
+     * by all calling conventions below. */
+    dest << "static PyObject* _f_" << basename << "_call(PyObject* const* py_args) {\n";
+    if (unconvertible) {
+        /* Some arguments can't be converted to Python yet. In those
+         * cases, just add a dummy function that always throws an
+         * Exception. */
+        // TODO: Add support for handles and vectors.
+        dest << "    PyErr_Format(PyExc_NotImplementedError, "
+             << "\"Can't convert argument " << unconvertible->name << " from Python\");\n";
+        dest << "    return NULL;\n";
+        dest << "}\n\n";
+    } else {
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i].is_buffer()) {
+                dest << "    halide_buffer_t buffer_" << arg_names[i] << ";\n";
+                dest << "    halide_dimension_t dimensions_" << arg_names[i]
+                     << "[" << (int)args[i].dimensions << "];\n";
+                dest << "    Py_buffer view_" << arg_names[i] << ";\n";
+            } else {
+                dest << "    " << print_type(&args[i]).second << " py_" << arg_names[i] << ";\n";
+            }
+        }
+        dest << "    int result;\n";
+        dest << "    PyObject* ret = NULL;\n";
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i].is_buffer()) {
+                dest << "    view_" << arg_names[i] << ".obj = NULL;\n";
+            }
+        }
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i].is_buffer()) {
+                convert_buffer(arg_names[i], (int)i, &args[i]);
+            } else if (args[i].type.is_handle()) {
+                dest << "    py_" << arg_names[i] << " = py_args[" << i << "];\n";
+            } else {
+                dest << "    if (!PyArg_Parse(py_args[" << i << "], \""
+                     << print_type(&args[i]).first << "\", &py_" << arg_names[i] << ")) {\n";
+                dest << "        goto done;\n";
+                dest << "    }\n";
+            }
+        }
+        if (!has_user_context) {
+            /* The pipeline doesn't touch any Python objects, so other
+             * Python threads can run while it does. */
+            dest << "    Py_BEGIN_ALLOW_THREADS\n";
+        }
+        dest << "    result = " << f.name << "(";
+        for (size_t i = 0; i < args.size(); i++) {
+            if (i > 0) {
+                dest << ", ";
+            }
+            if (args[i].is_buffer()) {
+                dest << "&buffer_" << arg_names[i];
+            } else {
+                dest << "py_" << arg_names[i];
+            }
+        }
+        dest << ");\n";
+        if (!has_user_context) {
+            dest << "    Py_END_ALLOW_THREADS\n";
+        }
+        dest << R"INLINE_CODE(    if (result != 0) {
+        /* In the optimal case, we'd be generating an exception declared
+         * in python_bindings/src, but since we're self-contained,
+         * we don't have access to that API. */
+        PyErr_Format(PyExc_ValueError, "Halide error %d", result);
+        goto done;
     }
-    dest << "    if (!PyArg_ParseTupleAndKeywords(args, kwargs, \"";
-    for (size_t i = 0; i < args.size(); i++) {
-        dest << print_type(&args[i]).first;
+    Py_INCREF(Py_True);
+    ret = Py_True;
+done:
+)INLINE_CODE";
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i].is_buffer()) {
+                dest << "    PyBuffer_Release(&view_" << arg_names[i] << ");\n";
+            }
+        }
+        dest << "    return ret;\n";
+        dest << "}\n\n";
     }
-    dest << "\", (char**)kwlist";
+
+    // The entry point, using the fastest calling convention available.
+    dest << "#if HALIDE_PYTHON_FASTCALL\n";
+    dest << "static PyObject* _f_" << basename
+         << "(PyObject* module, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames) {\n";
+    dest << "    PyObject* py_args[" << num_args + 1 << "];\n";
+    dest << "    if (_parse_fastcall_args(args, nargs, kwnames, _f_" << basename << "_kwlist, "
+         << num_args << ", py_args, \"" << basename << "\") < 0) {\n";
+    dest << "        return NULL;\n";
+    dest << "    }\n";
+    dest << "    return _f_" << basename << "_call(py_args);\n";
+    dest << "}\n";
+    dest << "#else\n";
+    dest << "static PyObject* _f_" << basename << "(PyObject* module, PyObject* args, PyObject* kwargs) {\n";
+    dest << "    PyObject* py_args[" << num_args + 1 << "];\n";
+    dest << "    if (!PyArg_ParseTupleAndKeywords(args, kwargs, \"" << string(args.size(), 'O')
+         << "\", (char**)_f_" << basename << "_kwlist";
     for (size_t i = 0; i < args.size(); i++) {
-        dest << ", ";
-        dest << "&py_" << arg_names[i];
+        dest << ", &py_args[" << i << "]";
     }
     dest << ")) {\n";
     dest << "        return NULL;\n";
     dest << "    }\n";
-    for (size_t i = 0; i < args.size(); i++) {
-        if (args[i].is_buffer()) {
-            convert_buffer(arg_names[i], &args[i]);
-        } else {
-            // Python already converted this.
-        }
+    dest << "    return _f_" << basename << "_call(py_args);\n";
+    dest << "}\n";
+    dest << "#endif\n\n";
+
+    /* The batched entry point calls the pipeline once per element of a
+     * sequence of argument tuples, saving the overhead of a Python call
+     * for each. */
+    dest << "static PyObject* _f_" << basename << "_batch(PyObject* module, PyObject* batch) {\n";
+    dest << "    Py_ssize_t i, n;\n";
+    dest << "    PyObject* seq = PySequence_Fast(batch, \"" << basename
+         << "_batch() expects a sequence of argument tuples\");\n";
+    dest << R"INLINE_CODE(    if (!seq) {
+        return NULL;
     }
-    dest << "    int result = " << f.name << "(";
-    for (size_t i = 0; i < args.size(); i++) {
-        if (i > 0) {
-            dest << ", ";
+    n = PySequence_Fast_GET_SIZE(seq);
+    for (i = 0; i < n; i++) {
+        PyObject* ret;
+        PyObject* item = PySequence_Fast(PySequence_Fast_GET_ITEM(seq, i),
+                                         "Each element of a batch must be a sequence of arguments");
+        if (!item) {
+            Py_DECREF(seq);
+            return NULL;
         }
-        if (args[i].is_buffer()) {
-            dest << "&buffer_" << arg_names[i];
-        } else {
-            dest << "py_" << arg_names[i];
+)INLINE_CODE";
+    dest << "        if (PySequence_Fast_GET_SIZE(item) != " << num_args << ") {\n";
+    dest << "            PyErr_Format(PyExc_TypeError, \"" << basename << "() takes " << num_args
+         << " arguments (%d given)\", (int)PySequence_Fast_GET_SIZE(item));\n";
+    dest << "            Py_DECREF(item);\n";
+    dest << "            Py_DECREF(seq);\n";
+    dest << "            return NULL;\n";
+    dest << "        }\n";
+    dest << "        ret = _f_" << basename << "_call(PySequence_Fast_ITEMS(item));\n";
+    dest << R"INLINE_CODE(        Py_DECREF(item);
+        if (!ret) {
+            Py_DECREF(seq);
+            return NULL;
         }
+        Py_DECREF(ret);
     }
-    dest << ");";
-    dest << R"INLINE_CODE(
-    if (result != 0) {
-        /* In the optimal case, we'd be generating an exception declared
-         * in python_bindings/src, but since we're self-contained,
-         * we don't have access to that API. */
-        PyErr_Format(PyExc_ValueError, "Halide error %d", result);
-        return NULL;
-    }
+    Py_DECREF(seq);
     Py_INCREF(Py_True);
     return Py_True;
+}
+
 )INLINE_CODE";
-    dest << "}\n";
 }
 
 }
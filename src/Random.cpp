@@ -10,78 +10,103 @@ using std::vector;
 
 namespace {
 
-// Some randomly-generated integers.
-#define C0 576942909
-#define C1 1121052041
-#define C2 1040796640
-
-// Permute a 32-bit unsigned integer using a fixed psuedorandom
-// permutation.
-Expr rng32(Expr x) {
-    internal_assert(x.type() == UInt(32));
-
-    // A polynomial P with coefficients C0 .. CN induces a permutation
-    // modulo 2^d iff:
-    // 1) P(0) != P(1) modulo 2
-    // 2) sum(i * Ci) is odd
-
-    // (See http://en.wikipedia.org/wiki/Permutation_polynomial#Rings_Z.2FpkZ)
-
-    // For a quadratic, this is only satisfied by:
-    // C0 anything
-    // C1 odd
-    // C2 even
-
-    // The coefficients defined above were chosen to satisfy this
-    // property.
-
-    // It's pretty random, but note that the quadratic term disappears
-    // if inputs are the multiples of 2^16, and so you get a linear
-    // sequence.  However, *that* linear sequence probably varies in
-    // the low bits, so if you run in through the permutation again,
-    // you should break it up. All actual use of this runs it through
-    // multiple times in order to combine several inputs, so it should
-    // be ok. The other flaw is it's a permutation, so you get no
-    // collisions. Birthday paradox be damned.
-
-    // However, it's exceedingly cheap to compute, as it only uses
-    // vectorizable int32 muls and adds, and the resulting numbers:
-    // - Have the correct moments for a uniform distribution
-    // - Have no serial correlations in any of the bits
-    // - Have a completely flat power spectrum
-    // - Have no visible patterns
-
-    // So I declare this good enough for image processing.
-
-    // If it's just a const (which it often is), save the simplifier some work:
-    if (const uint64_t *i = as_const_uint(x)) {
-        return make_const(UInt(32), ((C2 * (*i)) + C1) * (*i) + C0);
+// random_int is the Threefry-2x32 counter-based generator of Salmon
+// et al., "Parallel Random Numbers: As Easy as 1, 2, 3" (SC 2011). It
+// only uses 32-bit adds, rotates, and xors, so it vectorizes cleanly
+// everywhere and runs at full rate on GPUs. 13 rounds is the fewest
+// that passes all of TestU01's BigCrush.
+const int threefry_rounds = 13;
+
+// Builds the generator as a sequence of lets, as each round uses both
+// words of the previous one, and folds constants as it goes, as many
+// of the inputs (e.g. the tag) are constants.
+class Threefry {
+    vector<std::pair<string, Expr>> lets;
+
+    Expr bind(const Expr &e) {
+        if (is_const(e)) {
+            return e;
+        }
+        string name = unique_name('R');
+        lets.emplace_back(name, e);
+        return Variable::make(UInt(32), name);
     }
 
-    return (((C2 * x) + C1) * x) + C0;
-}
-}
+    Expr add(const Expr &a, const Expr &b) {
+        const uint64_t *ia = as_const_uint(a);
+        const uint64_t *ib = as_const_uint(b);
+        if (ia && ib) {
+            return make_const(UInt(32), (uint32_t)(*ia + *ib));
+        }
+        return bind(a + b);
+    }
+
+    Expr xor_(const Expr &a, const Expr &b) {
+        const uint64_t *ia = as_const_uint(a);
+        const uint64_t *ib = as_const_uint(b);
+        if (ia && ib) {
+            return make_const(UInt(32), (uint32_t)(*ia ^ *ib));
+        }
+        return bind(a ^ b);
+    }
+
+    Expr rotate_left(const Expr &a, int r) {
+        if (const uint64_t *ia = as_const_uint(a)) {
+            uint32_t x = (uint32_t)*ia;
+            return make_const(UInt(32), (uint32_t)((x << r) | (x >> (32 - r))));
+        }
+        return bind((a << r) | (a >> (32 - r)));
+    }
+
+public:
+    // Encrypt the counter (c0, c1) with the key (k0, k1).
+    std::pair<Expr, Expr> block(const Expr &c0, const Expr &c1, const Expr &k0, const Expr &k1) {
+        static const int rotations[8] = {13, 15, 26, 6, 17, 29, 16, 24};
+        Expr ks[3] = {k0, k1, xor_(xor_(k0, k1), make_const(UInt(32), 0x1BD11BDA))};
+        Expr x0 = add(c0, k0), x1 = add(c1, k1);
+        for (int r = 0; r < threefry_rounds; r++) {
+            x0 = add(x0, x1);
+            x1 = rotate_left(x1, rotations[r % 8]);
+            x1 = xor_(x1, x0);
+            if (r % 4 == 3) {
+                // Inject the key every four rounds.
+                int s = (r + 1) / 4;
+                x0 = add(x0, ks[s % 3]);
+                x1 = add(x1, add(ks[(s + 1) % 3], make_const(UInt(32), s)));
+            }
+        }
+        return {x0, x1};
+    }
+
+    // Wrap the lets made so far around an expression.
+    Expr wrap(Expr e) {
+        for (size_t i = lets.size(); i > 0; i--) {
+            e = Let::make(lets[i - 1].first, lets[i - 1].second, e);
+        }
+        return e;
+    }
+};
+}  // namespace
 
 Expr random_int(const vector<Expr> &e) {
     internal_assert(e.size());
-    internal_assert(e[0].type() == Int(32) || e[0].type() == UInt(32));
-    // Permute the first term
-    Expr result = rng32(cast(UInt(32), e[0]));
-    for (size_t i = 1; i < e.size(); i++) {
+    // The inputs are the counter, taken two at a time. The key for
+    // each block is the output of the last one. The first key depends
+    // on the number of inputs, so that appending zeros changes the
+    // result.
+    Threefry threefry;
+    std::pair<Expr, Expr> key = {make_const(UInt(32), 0), make_const(UInt(32), (uint64_t)e.size())};
+    for (size_t i = 0; i < e.size(); i += 2) {
         internal_assert(e[i].type() == Int(32) || e[i].type() == UInt(32));
-        // Add in the next term and permute again
-        string name = unique_name('R');
-        // If it's a const, save the simplifier some work
-        const uint64_t *ir = as_const_uint(result);
-        const uint64_t *ie = as_const_uint(e[i]);
-        if (ir && ie) {
-            result = rng32(make_const(UInt(32), (*ir) + (*ie)));
-        } else {
-            result = Let::make(name, result + cast<uint32_t>(e[i]),
-                               rng32(Variable::make(UInt(32), name)));
+        Expr c0 = cast(UInt(32), e[i]);
+        Expr c1 = make_const(UInt(32), 0);
+        if (i + 1 < e.size()) {
+            internal_assert(e[i + 1].type() == Int(32) || e[i + 1].type() == UInt(32));
+            c1 = cast(UInt(32), e[i + 1]);
         }
+        key = threefry.block(c0, c1, key.first, key.second);
     }
-    return result;
+    return threefry.wrap(key.first);
 }
 
 Expr random_float(const vector<Expr> &e) {
@@ -0,0 +1,340 @@
+#include "RebaseLargeBufferIndices.h"
+#include "Bounds.h"
+#include "CodeGen_GPU_Dev.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Util.h"
+
+#include <limits>
+#include <map>
+#include <set>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Base pointers are moved by a multiple of this many elements, so
+// that they stay as aligned as the pointers they are derived from.
+const int64_t rebase_granularity = 256;
+
+class ContainsLoop : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        result = true;
+    }
+
+public:
+    bool result = false;
+};
+
+// Check if an Expr can be evaluated outside a loop: it must not load
+// from memory, call anything, or use variables bound inside the loop.
+class IsInvariant : public IRVisitor {
+    using IRVisitor::visit;
+
+    const Scope<> &inner_vars;
+
+    void visit(const Variable *op) override {
+        if (inner_vars.contains(op->name)) {
+            result = false;
+        }
+    }
+
+    void visit(const Load *op) override {
+        result = false;
+    }
+
+    void visit(const Call *op) override {
+        result = false;
+    }
+
+public:
+    bool result = true;
+    IsInvariant(const Scope<> &s) : inner_vars(s) {}
+};
+
+// Check if the low 32 bits of a 64-bit index can be computed with
+// 32-bit arithmetic. This is true of sums and products of narrower
+// values and of variables bound outside the loop, because truncation
+// commutes with addition, subtraction, and multiplication.
+bool can_narrow(const Expr &e, const Scope<> &inner_vars) {
+    if (e.as<IntImm>()) {
+        return true;
+    } else if (const Variable *v = e.as<Variable>()) {
+        return !inner_vars.contains(v->name);
+    } else if (const Add *add = e.as<Add>()) {
+        return can_narrow(add->a, inner_vars) && can_narrow(add->b, inner_vars);
+    } else if (const Sub *sub = e.as<Sub>()) {
+        return can_narrow(sub->a, inner_vars) && can_narrow(sub->b, inner_vars);
+    } else if (const Mul *mul = e.as<Mul>()) {
+        return can_narrow(mul->a, inner_vars) && can_narrow(mul->b, inner_vars);
+    } else if (const Cast *cast = e.as<Cast>()) {
+        Type t = cast->value.type();
+        return (t.is_int() || t.is_uint()) && t.bits() <= 32;
+    } else if (const Broadcast *broadcast = e.as<Broadcast>()) {
+        return can_narrow(broadcast->value, inner_vars);
+    } else if (const Ramp *ramp = e.as<Ramp>()) {
+        return can_narrow(ramp->base, inner_vars) && can_narrow(ramp->stride, inner_vars);
+    }
+    return false;
+}
+
+// Find the range of indices each buffer is accessed at within the
+// body of a loop, for the buffers that can be rebased.
+class FindAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    Scope<Interval> bounds;
+    Scope<> inner_vars;
+
+    void visit(const Let *op) override {
+        op->value.accept(this);
+        excluded.insert(op->name);
+        Interval i = bounds_of_expr_in_scope(op->value, bounds);
+        ScopedBinding<Interval> bind_bounds(bounds, op->name, i);
+        ScopedBinding<> bind_var(inner_vars, op->name);
+        op->body.accept(this);
+    }
+
+    void visit(const LetStmt *op) override {
+        op->value.accept(this);
+        excluded.insert(op->name);
+        Interval i = bounds_of_expr_in_scope(op->value, bounds);
+        ScopedBinding<Interval> bind_bounds(bounds, op->name, i);
+        ScopedBinding<> bind_var(inner_vars, op->name);
+        op->body.accept(this);
+    }
+
+    void visit(const Allocate *op) override {
+        excluded.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Variable *op) override {
+        // The host pointer is used for something other than loads and
+        // stores, e.g. passed to an extern call.
+        if (op->type.is_handle()) {
+            excluded.insert(op->name);
+        }
+    }
+
+    void visit(const Load *op) override {
+        access(op->name, op->index, op->type);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) override {
+        access(op->name, op->index, op->value.type());
+        IRVisitor::visit(op);
+    }
+
+    void access(const string &name, const Expr &index, Type t) {
+        if (excluded.count(name)) {
+            return;
+        }
+        if (index.type().element_of() != Int(64) || !can_narrow(index, inner_vars)) {
+            excluded.insert(name);
+            return;
+        }
+        Interval i = bounds_of_expr_in_scope(index, bounds);
+        IsInvariant check(inner_vars);
+        if (i.is_bounded()) {
+            i.min.accept(&check);
+            i.max.accept(&check);
+        }
+        if (!i.is_bounded() || !check.result) {
+            excluded.insert(name);
+            return;
+        }
+        auto it = accesses.find(name);
+        if (it == accesses.end()) {
+            accesses.emplace(name, Access{i, t.bytes(), index.type().is_vector()});
+        } else if (it->second.bytes != t.bytes()) {
+            excluded.insert(name);
+        } else {
+            it->second.range.include(i);
+            it->second.vector = it->second.vector || index.type().is_vector();
+        }
+    }
+
+public:
+    struct Access {
+        Interval range;
+        int bytes;
+        bool vector;
+    };
+    map<string, Access> accesses;
+    set<string> excluded;
+
+    FindAccesses(const string &loop_var, const Expr &min, const Expr &extent) {
+        bounds.push(loop_var, Interval(min, min + extent - 1));
+        inner_vars.push(loop_var);
+    }
+};
+
+// Rewrite the indices of the accesses to some buffers as 32-bit
+// offsets from a new base.
+class RebaseAccesses : public IRMutator {
+    using IRMutator::visit;
+
+    // Compute the low 32 bits of an index, which must satisfy can_narrow.
+    Expr narrow(const Expr &e) {
+        Type t = UInt(32, e.type().lanes());
+        if (const IntImm *imm = e.as<IntImm>()) {
+            return make_const(t, (uint64_t)(uint32_t)imm->value);
+        } else if (e.as<Variable>()) {
+            return Cast::make(t, e);
+        } else if (const Add *add = e.as<Add>()) {
+            return Add::make(narrow(add->a), narrow(add->b));
+        } else if (const Sub *sub = e.as<Sub>()) {
+            return Sub::make(narrow(sub->a), narrow(sub->b));
+        } else if (const Mul *mul = e.as<Mul>()) {
+            return Mul::make(narrow(mul->a), narrow(mul->b));
+        } else if (const Cast *cast = e.as<Cast>()) {
+            return Cast::make(t, mutate(cast->value));
+        } else if (const Broadcast *broadcast = e.as<Broadcast>()) {
+            return Broadcast::make(narrow(broadcast->value), broadcast->lanes);
+        } else if (const Ramp *ramp = e.as<Ramp>()) {
+            return Ramp::make(narrow(ramp->base), narrow(ramp->stride), ramp->lanes);
+        }
+        internal_error << "Can't narrow " << e << "\n";
+        return Expr();
+    }
+
+    // The offset of an index from a base. The result is known to fit
+    // in 31 bits, so the wrapping unsigned arithmetic is exact. Keep
+    // ramps and broadcasts at the top, so that dense and strided
+    // accesses are still recognized as such.
+    Expr rebase(const Expr &index, const Expr &base) {
+        if (const Ramp *ramp = index.as<Ramp>()) {
+            const IntImm *stride = ramp->stride.as<IntImm>();
+            return Ramp::make(rebase(ramp->base, base),
+                              stride ? make_const(Int(32), stride->value) : Cast::make(Int(32), narrow(ramp->stride)),
+                              ramp->lanes);
+        } else if (const Broadcast *broadcast = index.as<Broadcast>()) {
+            return Broadcast::make(rebase(broadcast->value, base), broadcast->lanes);
+        }
+        int lanes = index.type().lanes();
+        Expr b = lanes == 1 ? base : Broadcast::make(base, lanes);
+        return Cast::make(Int(32, lanes), narrow(index) - b);
+    }
+
+    ModulusRemainder rebase(const ModulusRemainder &alignment) {
+        int64_t m = gcd(alignment.modulus, rebase_granularity);
+        return ModulusRemainder(m, mod_imp(alignment.remainder, m));
+    }
+
+    Expr visit(const Load *op) override {
+        auto it = bases.find(op->name);
+        if (it == bases.end()) {
+            return IRMutator::visit(op);
+        }
+        return Load::make(op->type, op->name, rebase(op->index, it->second),
+                          op->image, op->param, mutate(op->predicate),
+                          rebase(op->alignment));
+    }
+
+    Stmt visit(const Store *op) override {
+        auto it = bases.find(op->name);
+        if (it == bases.end()) {
+            return IRMutator::visit(op);
+        }
+        return Store::make(op->name, mutate(op->value), rebase(op->index, it->second),
+                           op->param, mutate(op->predicate), rebase(op->alignment));
+    }
+
+public:
+    // The low 32 bits of the new base index of each buffer.
+    map<string, Expr> bases;
+};
+
+class RebaseLargeBufferIndices : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+            (op->device_api != DeviceAPI::None &&
+             op->device_api != DeviceAPI::Host)) {
+            return op;
+        }
+
+        Stmt body = mutate(op->body);
+        Stmt loop = op;
+        if (!body.same_as(op->body)) {
+            loop = For::make(op->name, op->min, op->extent,
+                             op->for_type, op->device_api, body);
+        }
+
+        ContainsLoop inner;
+        body.accept(&inner);
+        if (inner.result) {
+            return loop;
+        }
+
+        // Only vector address computations get cheaper with narrower
+        // indices, so leave loops without vector accesses alone rather
+        // than duplicating them.
+        FindAccesses finder(op->name, op->min, op->extent);
+        body.accept(&finder);
+        vector<pair<string, FindAccesses::Access>> candidates;
+        bool any_vector = false;
+        for (const auto &p : finder.accesses) {
+            if (!finder.excluded.count(p.first)) {
+                candidates.push_back(p);
+                any_vector = any_vector || p.second.vector;
+            }
+        }
+        if (!any_vector) {
+            return loop;
+        }
+
+        // Pick a base for each buffer at the start of its accessed
+        // range, and check that every range fits in 31 bits.
+        RebaseAccesses rebaser;
+        Expr fits = const_true();
+        vector<pair<string, Expr>> bases;
+        Expr granularity = make_const(Int(64), rebase_granularity);
+        for (const auto &c : candidates) {
+            string base_name = unique_name(c.first + ".rebase");
+            Expr base = Variable::make(Int(64), base_name);
+            bases.emplace_back(base_name, (c.second.range.min / granularity) * granularity);
+            fits = fits && (c.second.range.max - base <= make_const(Int(64), std::numeric_limits<int32_t>::max()));
+            rebaser.bases[c.first] = cast(UInt(32), base);
+        }
+
+        // In the fast version of the loop, shadow each host pointer
+        // with one that points at the base.
+        Stmt fast = rebaser.mutate(loop);
+        for (size_t i = 0; i < candidates.size(); i++) {
+            const string &name = candidates[i].first;
+            Expr base = Variable::make(Int(64), bases[i].first);
+            Expr offset = cast(UInt(64), base) * candidates[i].second.bytes;
+            Expr ptr = reinterpret(Handle(), reinterpret(UInt(64), Variable::make(Handle(), name)) + offset);
+            fast = LetStmt::make(name, ptr, fast);
+        }
+
+        Stmt result = IfThenElse::make(fits, fast, loop);
+        for (auto it = bases.rbegin(); it != bases.rend(); it++) {
+            result = LetStmt::make(it->first, it->second, result);
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+Stmt rebase_large_buffer_indices(Stmt s) {
+    return RebaseLargeBufferIndices().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
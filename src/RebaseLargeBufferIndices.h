@@ -0,0 +1,30 @@
+#ifndef HALIDE_REBASE_LARGE_BUFFER_INDICES_H
+#define HALIDE_REBASE_LARGE_BUFFER_INDICES_H
+
+/** \file
+ * Defines a lowering pass that lets pipelines compiled with
+ * Target::LargeBuffers use 32-bit offsets in their innermost loops.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** With Target::LargeBuffers, buffer indices are 64-bit, which halves
+ * the number of lanes per vector register of gathers and other vector
+ * address computations. For each innermost loop that accesses memory
+ * with vector indices, this pass finds the range of indices each
+ * buffer is accessed at within the loop. Before the loop, it computes
+ * a 64-bit base pointer per buffer at the start of that range, and if
+ * every range fits in 31 bits, runs a version of the loop that indexes
+ * from those base pointers with 32-bit offsets. The offsets are
+ * computed with wrapping 32-bit arithmetic, which gives the exact
+ * result because the true offset is known to be small. Otherwise the
+ * original loop runs. Loops on GPUs are left alone. */
+Stmt rebase_large_buffer_indices(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -0,0 +1,206 @@
+#include "RedundantLoads.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Util.h"
+
+#include <map>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Find the loads in a statement that could be done before it: ones
+// that aren't inside a lazily-evaluated intrinsic, and that don't
+// depend on variables bound inside the statement.
+class FindHoistableLoads : public IRVisitor {
+    using IRVisitor::visit;
+
+    Scope<> inner_vars;
+
+    void visit(const Let *op) override {
+        op->value.accept(this);
+        ScopedBinding<> bind(inner_vars, op->name);
+        op->body.accept(this);
+    }
+
+    void visit(const Call *op) override {
+        if (op->is_intrinsic(Call::if_then_else)) {
+            op->args[0].accept(this);
+            return;
+        }
+        if (!op->is_pure()) {
+            has_side_effects = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Load *op) override {
+        IRVisitor::visit(op);
+        if (!expr_uses_vars(op, inner_vars)) {
+            loads.push_back(op);
+        }
+    }
+
+public:
+    vector<Expr> loads;
+    bool has_side_effects = false;
+};
+
+class ReplaceLoads : public IRMutator {
+    using IRMutator::visit;
+
+    const map<Expr, Expr, IRDeepCompare> &replacements;
+
+    Expr visit(const Load *op) override {
+        auto it = replacements.find(op);
+        if (it != replacements.end()) {
+            return it->second;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    ReplaceLoads(const map<Expr, Expr, IRDeepCompare> &r) : replacements(r) {}
+};
+
+void flatten_blocks(const Stmt &s, vector<Stmt> &result) {
+    if (const Block *b = s.as<Block>()) {
+        flatten_blocks(b->first, result);
+        flatten_blocks(b->rest, result);
+    } else {
+        result.push_back(s);
+    }
+}
+
+class EliminateRedundantLoads : public IRMutator {
+    using IRMutator::visit;
+
+    // The buffers allocated within the Stmt. Anything else is an
+    // input or output, and may alias other inputs and outputs.
+    Scope<> allocations;
+
+    Stmt visit(const Allocate *op) override {
+        ScopedBinding<> bind(allocations, op->name);
+        return IRMutator::visit(op);
+    }
+
+    // A load that has been seen in a run of stores.
+    struct Candidate {
+        Expr load;
+        // The first and last stores in the run that use it.
+        size_t first, last;
+    };
+
+    // Reuse loads across a run of consecutive stores.
+    Stmt reuse_loads(const vector<Stmt> &stores) {
+        vector<Candidate> candidates;
+        // The index in candidates of each load that could still be
+        // reused by the next store.
+        map<Expr, size_t, IRDeepCompare> live;
+
+        for (size_t i = 0; i < stores.size(); i++) {
+            const Store *store = stores[i].as<Store>();
+            FindHoistableLoads finder;
+            stores[i].accept(&finder);
+            if (finder.has_side_effects) {
+                live.clear();
+                continue;
+            }
+            for (const Expr &load : finder.loads) {
+                auto it = live.find(load);
+                if (it != live.end()) {
+                    candidates[it->second].last = i;
+                } else {
+                    live[load] = candidates.size();
+                    candidates.push_back({load, i, i});
+                }
+            }
+            // Values loaded from a buffer this store may write to
+            // can't be reused by later stores.
+            bool may_alias = !allocations.contains(store->name);
+            for (auto it = live.begin(); it != live.end();) {
+                const Load *load = it->first.as<Load>();
+                if (load->name == store->name ||
+                    (may_alias && !allocations.contains(load->name))) {
+                    it = live.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        // For each store, the loads to replace, and for each store,
+        // the lets to begin before it.
+        vector<map<Expr, Expr, IRDeepCompare>> replacements(stores.size());
+        vector<vector<std::pair<string, Expr>>> lets(stores.size());
+        for (const Candidate &c : candidates) {
+            if (c.first == c.last) {
+                continue;
+            }
+            string name = unique_name('t');
+            Expr var = Variable::make(c.load.type(), name);
+            for (size_t i = c.first; i <= c.last; i++) {
+                replacements[i][c.load] = var;
+            }
+            lets[c.first].push_back({name, c.load});
+        }
+
+        // Rebuild the run from the end, so that each let covers the
+        // rest of the run from its first use.
+        Stmt result;
+        for (size_t i = stores.size(); i > 0; i--) {
+            Stmt s = stores[i - 1];
+            if (!replacements[i - 1].empty()) {
+                s = ReplaceLoads(replacements[i - 1]).mutate(s);
+            }
+            result = result.defined() ? Block::make(s, result) : s;
+            for (auto it = lets[i - 1].rbegin(); it != lets[i - 1].rend(); ++it) {
+                result = LetStmt::make(it->first, it->second, result);
+            }
+        }
+        return result;
+    }
+
+    Stmt visit(const Block *op) override {
+        vector<Stmt> stmts;
+        flatten_blocks(op, stmts);
+        for (Stmt &s : stmts) {
+            s = mutate(s);
+        }
+
+        vector<Stmt> result, run;
+        for (size_t i = 0; i <= stmts.size(); i++) {
+            if (i < stmts.size() && stmts[i].as<Store>()) {
+                run.push_back(stmts[i]);
+                continue;
+            }
+            if (run.size() > 1) {
+                result.push_back(reuse_loads(run));
+            } else if (!run.empty()) {
+                result.push_back(run[0]);
+            }
+            run.clear();
+            if (i < stmts.size()) {
+                result.push_back(stmts[i]);
+            }
+        }
+        return Block::make(result);
+    }
+};
+
+}  // namespace
+
+Stmt eliminate_redundant_loads(Stmt s) {
+    return EliminateRedundantLoads().mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,24 @@
+#ifndef HALIDE_REDUNDANT_LOADS_H
+#define HALIDE_REDUNDANT_LOADS_H
+
+/** \file
+ * Defines a lowering pass that reuses loads across statements.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find loads that are repeated across a sequence of stores (e.g. the
+ * values of a Tuple, Funcs fused with compute_with, or unrolled
+ * iterations), and load them once into a LetStmt before the first
+ * use. A load is only reused if nothing between the two uses may
+ * store to its buffer. Buffers not allocated within the Stmt are
+ * assumed to possibly alias each other. */
+Stmt eliminate_redundant_loads(Stmt s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
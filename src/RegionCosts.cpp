@@ -219,6 +219,7 @@ class ExprCost : public IRVisitor {
     void visit(const Load *) override { internal_assert(false); }
     void visit(const Ramp *) override { internal_assert(false); }
     void visit(const Broadcast *) override { internal_assert(false); }
+    void visit(const VectorReduce *) override { internal_assert(false); }
     void visit(const LetStmt *) override { internal_assert(false); }
     void visit(const AssertStmt *) override { internal_assert(false); }
     void visit(const ProducerConsumer *) override { internal_assert(false); }
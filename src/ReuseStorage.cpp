@@ -0,0 +1,286 @@
+#include "ReuseStorage.h"
+#include "FindCalls.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+
+#include <set>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Count the calls to a Func in a definition, and check whether they
+// are all at the definition's own pure coordinates.
+class CallsTo : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) override {
+        IRVisitor::visit(op);
+        if (op->call_type != Call::Halide || op->name != func) {
+            return;
+        }
+        count++;
+        bool same = (op->args.size() == pure_args.size());
+        for (size_t i = 0; same && i < pure_args.size(); i++) {
+            const Variable *v = op->args[i].as<Variable>();
+            same = v && v->name == pure_args[i];
+        }
+        elementwise = elementwise && same;
+    }
+
+public:
+    const string &func;
+    const vector<string> &pure_args;
+    int count = 0;
+    bool elementwise = true;
+
+    CallsTo(const string &func, const vector<string> &pure_args)
+        : func(func), pure_args(pure_args) {
+    }
+};
+
+// Schedules that would make a point of the Func be computed more than
+// once, or stored somewhere other than a single realization at its
+// compute level.
+bool has_simple_storage(const Function &f) {
+    const FuncSchedule &s = f.schedule();
+    if (f.has_extern_definition() ||
+        f.outputs() != 1 ||
+        s.memoized() ||
+        s.async() ||
+        !(s.store_level() == s.compute_level()) ||
+        !s.hoist_storage_level().is_inlined() ||
+        !f.debug_file().empty() ||
+        f.is_tracing_loads() ||
+        f.is_tracing_stores() ||
+        f.is_tracing_realizations()) {
+        return false;
+    }
+    for (const StorageDim &d : s.storage_dims()) {
+        if (d.fold_factor.defined()) {
+            return false;
+        }
+    }
+    vector<const Definition *> defs = {&f.definition()};
+    for (const Definition &u : f.updates()) {
+        defs.push_back(&u);
+    }
+    for (const Definition *d : defs) {
+        if (!d->schedule().fuse_level().level.is_inlined() ||
+            !d->schedule().fused_pairs().empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Are the splits of a definition and all of its specializations ones
+// that compute each point once?
+bool splits_compute_once(const Definition &d) {
+    for (const Split &s : d.schedule().splits()) {
+        if (s.is_split() &&
+            (s.tail == TailStrategy::ShiftInwards ||
+             s.tail == TailStrategy::Auto)) {
+            return false;
+        }
+    }
+    for (const Specialization &s : d.specializations()) {
+        if (!splits_compute_once(s.definition)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Can consumer c be stored in place of producer p?
+bool can_store_in_place(const Function &c, const Function &p,
+                        const map<string, set<string>> &callers) {
+    if (!has_simple_storage(c) ||
+        !has_simple_storage(p) ||
+        c.dimensions() != p.dimensions() ||
+        c.output_types()[0] != p.output_types()[0] ||
+        c.schedule().memory_type() != p.schedule().memory_type() ||
+        !c.schedule().bounds().empty()) {
+        return false;
+    }
+
+    // Nothing but c may read p, or its values would be clobbered.
+    auto it = callers.find(p.name());
+    if (it == callers.end() || it->second.size() != 1 || !it->second.count(c.name())) {
+        return false;
+    }
+
+    // Each point of c must read p only at the same point, and only
+    // once: a split that shifts inwards recomputes some points, which
+    // would then read the value of c already written there.
+    CallsTo pure_calls(p.name(), c.args());
+    c.definition().accept(&pure_calls);
+    if (pure_calls.count == 0 || !pure_calls.elementwise) {
+        return false;
+    }
+    if (!splits_compute_once(c.definition())) {
+        return false;
+    }
+    for (const Definition &u : c.updates()) {
+        CallsTo update_calls(p.name(), c.args());
+        u.accept(&update_calls);
+        if (update_calls.count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class ReuseStorage : public IRMutator {
+    using IRMutator::visit;
+
+    const map<string, Function> &env;
+
+    // The producer in place of which each consumer may be stored.
+    const map<string, string> &in_place_of;
+
+    // The realization each rewritten Func is stored in.
+    map<string, string> storage;
+
+    // The realizations enclosing the current point without an
+    // intervening loop or branch.
+    set<string> open;
+
+    string storage_of(const string &name) const {
+        auto it = storage.find(name);
+        return it == storage.end() ? name : it->second;
+    }
+
+    Stmt visit(const Realize *op) override {
+        auto it = in_place_of.find(op->name);
+        if (it != in_place_of.end() && is_one(op->condition)) {
+            string target = storage_of(it->second);
+            if (open.count(target)) {
+                debug(3) << "Storing " << op->name << " in place of " << target << "\n";
+                storage[op->name] = target;
+                return mutate(op->body);
+            }
+        }
+        open.insert(op->name);
+        Stmt stmt = IRMutator::visit(op);
+        open.erase(op->name);
+        return stmt;
+    }
+
+    template<typename T>
+    Stmt visit_new_level(const T *op) {
+        set<string> old_open;
+        old_open.swap(open);
+        Stmt stmt = IRMutator::visit(op);
+        open.swap(old_open);
+        return stmt;
+    }
+
+    Stmt visit(const For *op) override {
+        return visit_new_level(op);
+    }
+
+    Stmt visit(const IfThenElse *op) override {
+        return visit_new_level(op);
+    }
+
+    Stmt visit(const Fork *op) override {
+        return visit_new_level(op);
+    }
+
+    Stmt visit(const Acquire *op) override {
+        return visit_new_level(op);
+    }
+
+    Stmt visit(const Provide *op) override {
+        auto it = storage.find(op->name);
+        if (it == storage.end()) {
+            return IRMutator::visit(op);
+        }
+        vector<Expr> values, args;
+        for (const Expr &v : op->values) {
+            values.push_back(mutate(v));
+        }
+        for (const Expr &a : op->args) {
+            args.push_back(mutate(a));
+        }
+        return Provide::make(it->second, values, args);
+    }
+
+    Expr visit(const Call *op) override {
+        if (op->call_type != Call::Halide) {
+            return IRMutator::visit(op);
+        }
+        auto it = storage.find(op->name);
+        if (it == storage.end()) {
+            return IRMutator::visit(op);
+        }
+        vector<Expr> args;
+        for (const Expr &a : op->args) {
+            args.push_back(mutate(a));
+        }
+        return Call::make(env.at(it->second), args, op->value_index);
+    }
+
+public:
+    ReuseStorage(const map<string, Function> &env, const map<string, string> &in_place_of)
+        : env(env), in_place_of(in_place_of) {
+    }
+};
+
+}  // namespace
+
+Stmt reuse_producer_storage(const Stmt &s,
+                            const map<string, Function> &env,
+                            const vector<Function> &outputs) {
+    set<string> output_names;
+    for (const Function &f : outputs) {
+        output_names.insert(f.name());
+    }
+
+    map<string, set<string>> callers;
+    set<string> extern_inputs;
+    for (const auto &p : env) {
+        for (const auto &callee : find_direct_calls(p.second)) {
+            callers[callee.first].insert(p.first);
+            if (p.second.has_extern_definition()) {
+                extern_inputs.insert(callee.first);
+            }
+        }
+    }
+
+    map<string, string> in_place_of;
+    for (const auto &p : env) {
+        const Function &c = p.second;
+        if (output_names.count(c.name()) || extern_inputs.count(c.name())) {
+            continue;
+        }
+        for (const auto &callee : find_direct_calls(c)) {
+            const Function &producer = callee.second;
+            if (!env.count(producer.name()) ||
+                output_names.count(producer.name()) ||
+                extern_inputs.count(producer.name())) {
+                continue;
+            }
+            if (can_store_in_place(c, producer, callers)) {
+                in_place_of[c.name()] = producer.name();
+                break;
+            }
+        }
+    }
+
+    if (in_place_of.empty()) {
+        return s;
+    }
+    return ReuseStorage(env, in_place_of).mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
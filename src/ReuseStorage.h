@@ -0,0 +1,35 @@
+#ifndef HALIDE_REUSE_STORAGE_H
+#define HALIDE_REUSE_STORAGE_H
+
+/** \file
+ * Defines the lowering pass that lets an elementwise consumer write
+ * its values in place over the storage of a producer that is dead
+ * afterwards.
+ */
+
+#include <map>
+#include <vector>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+class Function;
+
+/** Find Funcs whose pure definition reads a single producer only at
+ * its own coordinates, where that producer has the same type and
+ * dimensionality, is used by nothing else, and is realized once at
+ * the same loop level just outside the consumer. Rewrite the consumer
+ * to be stored in the producer's realization instead of its own, so
+ * that each point overwrites the value of the producer it was computed
+ * from. Must be run before allocation bounds inference, which then
+ * sizes the shared realization to cover both Funcs. */
+Stmt reuse_producer_storage(const Stmt &s,
+                            const std::map<std::string, Function> &env,
+                            const std::vector<Function> &outputs);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -207,17 +207,19 @@ typedef std::map<FunctionPtr, FunctionPtr> DeepCopyMap;
 struct FuncScheduleContents {
     mutable RefCount ref_count;
 
-    LoopLevel store_level, compute_level;
+    LoopLevel store_level, compute_level, hoist_storage_level;
     std::vector<StorageDim> storage_dims;
     std::vector<Bound> bounds;
     std::vector<Bound> estimates;
     std::map<std::string, Internal::FunctionPtr> wrappers;
     MemoryType memory_type;
-    bool memoized, async;
+    bool memoized, async, carry_loads, interleave_tuple;
 
     FuncScheduleContents() :
         store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()),
-        memory_type(MemoryType::Auto), memoized(false), async(false) {};
+        hoist_storage_level(LoopLevel::inlined()),
+        memory_type(MemoryType::Auto), memoized(false), async(false), carry_loads(false),
+        interleave_tuple(false) {};
 
     // Pass an IRMutator through to all Exprs referenced in the FuncScheduleContents
     void mutate(IRMutator *mutator) {
@@ -276,9 +278,12 @@ struct StageScheduleContents {
     std::vector<FusedPair> fused_pairs;
     bool touched;
     bool allow_race_conditions;
+    bool atomic;
+    bool override_atomic_associativity_test;
 
     StageScheduleContents() : fuse_level(FuseLoopLevel()), touched(false),
-                              allow_race_conditions(false) {};
+                              allow_race_conditions(false), atomic(false),
+                              override_atomic_associativity_test(false) {};
 
     // Pass an IRMutator through to all Exprs referenced in the StageScheduleContents
     void mutate(IRMutator *mutator) {
@@ -323,12 +328,15 @@ FuncSchedule FuncSchedule::deep_copy(
     FuncSchedule copy;
     copy.contents->store_level = contents->store_level;
     copy.contents->compute_level = contents->compute_level;
+    copy.contents->hoist_storage_level = contents->hoist_storage_level;
     copy.contents->storage_dims = contents->storage_dims;
     copy.contents->bounds = contents->bounds;
     copy.contents->estimates = contents->estimates;
     copy.contents->memory_type = contents->memory_type;
     copy.contents->memoized = contents->memoized;
     copy.contents->async = contents->async;
+    copy.contents->carry_loads = contents->carry_loads;
+    copy.contents->interleave_tuple = contents->interleave_tuple;
 
     // Deep-copy wrapper functions.
     for (const auto &iter : contents->wrappers) {
@@ -364,6 +372,22 @@ bool FuncSchedule::async() const {
     return contents->async;
 }
 
+bool &FuncSchedule::carry_loads() {
+    return contents->carry_loads;
+}
+
+bool FuncSchedule::carry_loads() const {
+    return contents->carry_loads;
+}
+
+bool &FuncSchedule::interleave_tuple() {
+    return contents->interleave_tuple;
+}
+
+bool FuncSchedule::interleave_tuple() const {
+    return contents->interleave_tuple;
+}
+
 std::vector<StorageDim> &FuncSchedule::storage_dims() {
     return contents->storage_dims;
 }
@@ -425,6 +449,14 @@ const LoopLevel &FuncSchedule::compute_level() const {
     return contents->compute_level;
 }
 
+LoopLevel &FuncSchedule::hoist_storage_level() {
+    return contents->hoist_storage_level;
+}
+
+const LoopLevel &FuncSchedule::hoist_storage_level() const {
+    return contents->hoist_storage_level;
+}
+
 void FuncSchedule::accept(IRVisitor *visitor) const {
     for (const Bound &b : bounds()) {
         if (b.min.defined()) {
@@ -476,6 +508,8 @@ StageSchedule StageSchedule::get_copy() const {
     copy.contents->fused_pairs = contents->fused_pairs;
     copy.contents->touched = contents->touched;
     copy.contents->allow_race_conditions = contents->allow_race_conditions;
+    copy.contents->atomic = contents->atomic;
+    copy.contents->override_atomic_associativity_test = contents->override_atomic_associativity_test;
     return copy;
 }
 
@@ -543,6 +577,22 @@ bool StageSchedule::allow_race_conditions() const {
     return contents->allow_race_conditions;
 }
 
+bool &StageSchedule::atomic() {
+    return contents->atomic;
+}
+
+bool StageSchedule::atomic() const {
+    return contents->atomic;
+}
+
+bool &StageSchedule::override_atomic_associativity_test() {
+    return contents->override_atomic_associativity_test;
+}
+
+bool StageSchedule::override_atomic_associativity_test() const {
+    return contents->override_atomic_associativity_test;
+}
+
 void StageSchedule::accept(IRVisitor *visitor) const {
     for (const ReductionVariable &r : rvars()) {
         if (r.min.defined()) {
@@ -309,8 +309,16 @@ struct Bound {
 struct StorageDim {
     std::string var;
     Expr alignment;
+    /** Extra elements added to the extent after aligning it. Set by
+     * Func::align_storage. */
+    Expr padding;
     Expr fold_factor;
     bool fold_forward;
+    /** If true, the folded dimension is addressed by rotating a base
+     * index once per iteration of the loop it is folded over, instead
+     * of taking the coordinate modulo the fold factor on every
+     * access. Set by Func::ring_buffer. */
+    bool ring_buffer;
 };
 
 /** This represents two stages with fused loop nests from outermost to a specific
@@ -359,6 +367,10 @@ struct PrefetchDirective {
     PrefetchBoundStrategy strategy;
     // If it's a prefetch load from an image parameter, this points to that.
     Parameter param;
+    // If the offset is undefined, it is chosen during lowering so that
+    // the prefetch is issued roughly this many operations ahead of
+    // the access.
+    int memory_latency;
 };
 
 struct FuncScheduleContents;
@@ -398,6 +410,17 @@ public:
     bool &async();
     bool async() const;
 
+    /** Should loads in this Function's production be carried across
+     * loop iterations. See Func::carry_loads. */
+    bool &carry_loads();
+    bool carry_loads() const;
+
+    /** Should the elements of this Function's Tuple be stored
+     * interleaved in one allocation. See
+     * Func::store_tuple_interleaved. */
+    bool &interleave_tuple();
+    bool interleave_tuple() const;
+
     /** The list and order of dimensions used to store this
      * function. The first dimension in the vector corresponds to the
      * innermost dimension for storage (i.e. which dimension is
@@ -452,6 +475,15 @@ public:
     LoopLevel &compute_level();
     // @}
 
+    /** At what site should the allocations of this function be pooled
+     * so that they survive across iterations of the loops between this
+     * site and the store_level? Inlined (the default) means the
+     * allocation is not hoisted. See \ref Func::hoist_storage */
+    // @{
+    const LoopLevel &hoist_storage_level() const;
+    LoopLevel &hoist_storage_level();
+    // @}
+
     /** Pass an IRVisitor through to all Exprs referenced in the
      * Schedule. */
     void accept(IRVisitor *) const;
@@ -543,6 +575,20 @@ public:
     bool &allow_race_conditions();
     // @}
 
+    /** Should the stores of this stage be performed atomically? See
+     * \ref Stage::atomic */
+    // @{
+    bool atomic() const;
+    bool &atomic();
+    // @}
+
+    /** Was the associativity check skipped when this stage was marked
+     * atomic? */
+    // @{
+    bool override_atomic_associativity_test() const;
+    bool &override_atomic_associativity_test();
+    // @}
+
     /** Pass an IRVisitor through to all Exprs referenced in the
      * Schedule. */
     void accept(IRVisitor *) const;
@@ -12,6 +12,7 @@
 #include "IROperator.h"
 #include "IRPrinter.h"
 #include "Inline.h"
+#include "InjectHostDevBufferCopies.h"
 #include "Qualify.h"
 #include "Simplify.h"
 #include "Solve.h"
@@ -349,6 +350,9 @@ Stmt build_provide_loop_nest(const map<string, Function> &env,
 
     // Make the (multi-dimensional multi-valued) store node.
     Stmt body = Provide::make(func.name(), values, site);
+    if (def.schedule().atomic()) {
+        body = Atomic::make(func.name(), body);
+    }
 
     // Default schedule/values if there is no specialization
     Stmt stmt = build_loop_nest(body, prefix, start_fuse, func, def, is_update);
@@ -652,6 +656,22 @@ Stmt build_extern_produce(const map<string, Function> &env, Function f, const Ta
         check = Block::make(Evaluate::make(cleanup), check);
     }
 
+    DeviceAPI device_api = f.extern_function_device_api();
+    if (f.schedule().async() &&
+        device_api != DeviceAPI::Host &&
+        device_api != DeviceAPI::None &&
+        device_api != DeviceAPI::Default_GPU) {
+        // An extern stage on a device may return with its work still
+        // queued on the stream. Other stages on this thread will queue
+        // behind it, but the consumers of an async producer run on
+        // another thread, so wait for the work to finish before they
+        // are released. This has to happen before any crops of the
+        // outputs are retired. The outputs come last in the argument
+        // list.
+        Stmt sync = call_extern_and_assert("halide_device_sync", {extern_call_args.back()});
+        check = Block::make(IfThenElse::make(EQ::make(result, 0), sync), check);
+    }
+
     check = LetStmt::make(result_name, e, check);
 
     if (annotate.defined()) {
@@ -1120,8 +1140,8 @@ private:
 
     // Compute the shift factor required to align iteration of
     // a function stage with its fused parent loop nest.
-    static void compute_shift_factor(const Function &f, const string &prefix, const Definition &def,
-                                     map<string, Expr> &bounds, map<string, Expr> &shifts) {
+    void compute_shift_factor(const Function &f, const string &prefix, const Definition &def,
+                              map<string, Expr> &bounds, map<string, Expr> &shifts) {
         if (!def.defined()) {
             return;
         }
@@ -1143,13 +1163,28 @@ private:
             internal_assert(iter != dims.end());
             start_fuse = (int)(iter - dims.begin());
         }
+
+        // The fused loops are matched up from the outermost one in,
+        // and may not have the same names in the parent, e.g. when
+        // an RVar of this stage was renamed to match a Var of the
+        // parent.
+        const auto &parent_iter = env.find(fuse_level.func());
+        internal_assert(parent_iter != env.end());
+        const Function &parent = parent_iter->second;
+        const vector<Dim> &parent_dims = (fuse_level.stage_index() == 0) ?
+            parent.definition().schedule().dims() :
+            parent.update(fuse_level.stage_index() - 1).schedule().dims();
+
         for (int i = start_fuse; i < (int) dims.size() - 1; ++i) {
             const string &var = dims[i].var;
+            int parent_idx = (int)(parent_dims.size() - (dims.size() - i));
+            internal_assert(parent_idx >= 0);
+            const string &parent_var = parent_dims[parent_idx].var;
             Expr shift_val;
 
             auto iter = align_strategy.begin();
             for (; iter != align_strategy.end(); ++iter) {
-                if (var_name_match(var, iter->first)) {
+                if (var_name_match(var, iter->first) || var_name_match(parent_var, iter->first)) {
                     break;
                 }
             }
@@ -1167,11 +1202,11 @@ private:
             internal_assert((it_min != bounds.end()) && (it_max != bounds.end()));
 
             if (iter->second == LoopAlignStrategy::AlignStart) {
-                const auto &parent_min = bounds.find(parent_prefix + var + ".loop_min");
+                const auto &parent_min = bounds.find(parent_prefix + parent_var + ".loop_min");
                 internal_assert(parent_min != bounds.end());
                 shift_val = parent_min->second - it_min->second;
             } else {
-                const auto &parent_max = bounds.find(parent_prefix + var + ".loop_max");
+                const auto &parent_max = bounds.find(parent_prefix + parent_var + ".loop_max");
                 internal_assert(parent_max != bounds.end());
                 shift_val = parent_max->second - it_max->second;
             }
@@ -1965,13 +2000,18 @@ void validate_fused_group_schedule_helper(const string &fn,
             << "Invalid compute_with: # of fused dims of " << p.func_1 << ".s"
             << p.stage_1 << " and " << p.func_2 << ".s" << p.stage_2 << " do not match.\n";
 
+        // The fused dims must match, but a pure Var may be fused with
+        // an RVar, e.g. to fuse a stage with an update definition over
+        // a reduction domain. Each stage still iterates over its own
+        // fused dims in its own order, so this is safe as long as the
+        // stages don't depend on each other, which is checked
+        // elsewhere.
         for (int i = 0; i < n_fused; ++i) {
             const Dim &d1 = dims_1[start_fuse_1 + i];
             const Dim &d2 = dims_2[start_fuse_2 + i];
             bool equal = var_name_match(d1.var, d2.var) &&
                          (d1.for_type == d2.for_type) &&
-                         (d1.device_api == d2.device_api) &&
-                         (d1.dim_type == d2.dim_type);
+                         (d1.device_api == d2.device_api);
             if (!equal) {
                 user_error << "Invalid compute_with: dims " << i << " of " << p.func_1 << ".s"
                            << p.stage_1 << "(" << dims_1[start_fuse_1 + i].var << ") and " << p.func_2
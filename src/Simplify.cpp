@@ -2,9 +2,15 @@
 #include "Simplify_Internal.h"
 
 #include "CSE.h"
+#include "IREquality.h"
 #include "IRMutator.h"
 #include "Substitute.h"
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 namespace Halide {
 namespace Internal {
 
@@ -274,10 +280,150 @@ Simplify::ScopedFact::~ScopedFact() {
     }
 }
 
+namespace {
+
+// Simplifying an Expr is a pure function of the Expr itself and the
+// constant bounds and alignment the simplifier is told about, so the
+// results can be shared between calls. Bounds inference in particular
+// simplifies the same expressions many times over. The cache holds at
+// most HL_SIMPLIFY_CACHE_SIZE entries, and is disabled if that isn't
+// set.
+class SimplifyCache {
+public:
+    struct Key {
+        Expr e;
+        bool remove_dead_lets;
+        // The constant bounds and alignment of each variable, as
+        // (name, min_defined, min, max_defined, max, modulus, remainder).
+        vector<std::tuple<string, bool, int64_t, bool, int64_t, int64_t, int64_t>> context;
+    };
+
+private:
+    struct KeyCompare {
+        bool operator()(const Key &a, const Key &b) const {
+            // Do the cheap comparisons first.
+            if (a.remove_dead_lets != b.remove_dead_lets) {
+                return a.remove_dead_lets < b.remove_dead_lets;
+            }
+            if (a.context != b.context) {
+                return a.context < b.context;
+            }
+            return IRDeepCompare()(a.e, b.e);
+        }
+    };
+
+    struct Entry {
+        Expr result;
+        // Whether simplification returned the original Expr. If so we
+        // return the caller's Expr, so that checks of same_as still
+        // work as expected.
+        bool unchanged;
+    };
+
+    std::mutex mutex;
+    std::map<Key, Entry, KeyCompare> entries;
+    size_t max_entries;
+
+public:
+    SimplifyCache() {
+        string size = get_env_variable("HL_SIMPLIFY_CACHE_SIZE");
+        max_entries = size.empty() ? 0 : std::max(0, std::atoi(size.c_str()));
+    }
+
+    bool enabled() const {
+        return max_entries > 0;
+    }
+
+    bool lookup(const Key &k, Expr *result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(k);
+        if (it == entries.end()) {
+            return false;
+        }
+        *result = it->second.unchanged ? k.e : it->second.result;
+        return true;
+    }
+
+    void insert(const Key &k, const Expr &result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.size() >= max_entries) {
+            // Lossy, but cheap and simple. Most reuse is between
+            // simplifications that happen close together.
+            entries.clear();
+        }
+        entries[k] = {result, result.same_as(k.e)};
+    }
+};
+
+SimplifyCache &simplify_cache() {
+    static SimplifyCache cache;
+    return cache;
+}
+
+// Exprs that refer to Functions, Parameters, Buffers or reduction
+// domains can be deep-equal to each other while referring to
+// different objects (e.g. after lowering deep-copies the pipeline), so
+// we don't cache them.
+class RefersToObjects : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) override {
+        result |= (op->param.defined() ||
+                   op->image.defined() ||
+                   op->reduction_domain.defined());
+    }
+
+    void visit(const Load *op) override {
+        result |= (op->param.defined() || op->image.defined());
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        result |= (op->func.defined() ||
+                   op->param.defined() ||
+                   op->image.defined());
+        IRGraphVisitor::visit(op);
+    }
+
+public:
+    bool result = false;
+};
+
+}  // namespace
+
 Expr simplify(Expr e, bool remove_dead_lets,
               const Scope<Interval> &bounds,
               const Scope<ModulusRemainder> &alignment) {
-    return Simplify(remove_dead_lets, &bounds, &alignment).mutate(e, nullptr);
+    Simplify simplifier(remove_dead_lets, &bounds, &alignment);
+
+    SimplifyCache &cache = simplify_cache();
+    if (!cache.enabled() || !e.defined()) {
+        return simplifier.mutate(e, nullptr);
+    }
+
+    RefersToObjects refers;
+    e.accept(&refers);
+    if (refers.result) {
+        return simplifier.mutate(e, nullptr);
+    }
+
+    SimplifyCache::Key key{e, remove_dead_lets, {}};
+    const auto &info = simplifier.bounds_and_alignment_info;
+    for (auto iter = info.cbegin(); iter != info.cend(); ++iter) {
+        const Simplify::ExprInfo &b = iter.value();
+        key.context.emplace_back(iter.name(), b.min_defined, b.min, b.max_defined, b.max,
+                                 b.alignment.modulus, b.alignment.remainder);
+    }
+    // Scopes iterate in no particular order, so sort the context to
+    // make equal contexts compare equal.
+    std::sort(key.context.begin(), key.context.end());
+
+    Expr result;
+    if (!cache.lookup(key, &result)) {
+        result = simplifier.mutate(e, nullptr);
+        cache.insert(key, result);
+    }
+    return result;
 }
 
 Stmt simplify(Stmt s, bool remove_dead_lets,
@@ -43,6 +43,85 @@ Expr Simplify::visit(const Broadcast *op, ExprInfo *bounds) {
     }
 }
 
+Expr Simplify::visit(const VectorReduce *op, ExprInfo *bounds) {
+    Expr value = mutate(op->value, bounds);
+
+    const int lanes = op->type.lanes();
+    const int factor = op->value.type().lanes() / lanes;
+    if (factor == 1) {
+        return value;
+    }
+
+    if (bounds && op->type.is_int()) {
+        switch (op->op) {
+        case VectorReduce::Add:
+            // Alignment of a sum is the alignment of the element
+            // times the number of elements.
+            bounds->alignment = bounds->alignment * factor;
+            if (bounds->min_defined &&
+                !mul_would_overflow(op->type.bits(), bounds->min, factor)) {
+                bounds->min *= factor;
+            } else {
+                bounds->min_defined = false;
+            }
+            if (bounds->max_defined &&
+                !mul_would_overflow(op->type.bits(), bounds->max, factor)) {
+                bounds->max *= factor;
+            } else {
+                bounds->max_defined = false;
+            }
+            break;
+        case VectorReduce::Mul:
+            // Don't try to infer anything about bounds. Leave the
+            // alignment unchanged even though we could theoretically
+            // upgrade it.
+            bounds->min_defined = false;
+            bounds->max_defined = false;
+            break;
+        case VectorReduce::Min:
+        case VectorReduce::Max:
+            // The bounds of the result are the bounds of the lanes.
+            break;
+        case VectorReduce::And:
+        case VectorReduce::Or:
+            // For integer types this is a bitwise operator. Don't try
+            // to infer anything for now.
+            bounds->min_defined = false;
+            bounds->max_defined = false;
+            bounds->alignment = ModulusRemainder{};
+            break;
+        }
+    } else if (bounds) {
+        bounds->min_defined = bounds->max_defined = false;
+        bounds->alignment = ModulusRemainder{};
+    }
+
+    // A horizontal reduction of a broadcast is a narrower broadcast,
+    // scaled by the reduction factor in the case of addition.
+    const Broadcast *b = value.as<Broadcast>();
+    if (b && b->value.type().is_scalar()) {
+        switch (op->op) {
+        case VectorReduce::Add: {
+            Expr v = mutate(b->value * make_const(b->value.type(), factor), nullptr);
+            return lanes == 1 ? v : Broadcast::make(v, lanes);
+        }
+        case VectorReduce::Mul:
+            break;
+        case VectorReduce::Min:
+        case VectorReduce::Max:
+        case VectorReduce::And:
+        case VectorReduce::Or:
+            return lanes == 1 ? b->value : Broadcast::make(b->value, lanes);
+        }
+    }
+
+    if (value.same_as(op->value)) {
+        return op;
+    } else {
+        return VectorReduce::make(op->op, value, lanes);
+    }
+}
+
 Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
     if (bounds_and_alignment_info.contains(op->name)) {
         const ExprInfo &b = bounds_and_alignment_info.get(op->name);
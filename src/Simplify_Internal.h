@@ -289,6 +289,7 @@ public:
     Expr visit(const Load *op, ExprInfo *bounds);
     Expr visit(const Call *op, ExprInfo *bounds);
     Expr visit(const Shuffle *op, ExprInfo *bounds);
+    Expr visit(const VectorReduce *op, ExprInfo *bounds);
     Expr visit(const Let *op, ExprInfo *bounds);
     Stmt visit(const LetStmt *op);
     Stmt visit(const AssertStmt *op);
@@ -304,6 +305,7 @@ public:
     Stmt visit(const Free *op);
     Stmt visit(const Acquire *op);
     Stmt visit(const Fork *op);
+    Stmt visit(const Atomic *op);
 };
 
 }
@@ -486,6 +486,17 @@ Stmt Simplify::visit(const Acquire *op) {
     }
 }
 
+Stmt Simplify::visit(const Atomic *op) {
+    Stmt body = mutate(op->body);
+    if (is_no_op(body)) {
+        return body;
+    } else if (body.same_as(op->body)) {
+        return op;
+    } else {
+        return Atomic::make(op->producer_name, std::move(body));
+    }
+}
+
 Stmt Simplify::visit(const Fork *op) {
     Stmt first = mutate(op->first);
     Stmt rest = mutate(op->rest);
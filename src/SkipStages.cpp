@@ -1,4 +1,5 @@
 #include "SkipStages.h"
+#include "Bounds.h"
 #include "CSE.h"
 #include "Debug.h"
 #include "ExprUsesVar.h"
@@ -8,6 +9,7 @@
 #include "IRPrinter.h"
 #include "Scope.h"
 #include "Simplify.h"
+#include "Solve.h"
 #include "Substitute.h"
 
 #include <iterator>
@@ -39,6 +41,78 @@ bool extern_call_uses_buffer(const Call *op, const std::string &func) {
     return false;
 }
 
+// Replace the arguments of calls that don't vary over the domain with
+// their single value, so that the calls can be moved outside of it.
+class FixCallArgsOverDomain : public IRMutator {
+    using IRMutator::visit;
+
+    Scope<Interval> domain;
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        Expr body;
+        if (expr_uses_vars(value, domain)) {
+            ScopedBinding<Interval> bind(domain, op->name, bounds_of_expr_in_scope(value, domain));
+            body = mutate(op->body);
+        } else {
+            body = mutate(op->body);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return Let::make(op->name, value, body);
+    }
+
+    Expr visit(const Call *op) override {
+        Expr expr = IRMutator::visit(op);
+        op = expr.as<Call>();
+        if (!op || (op->call_type != Call::Halide && op->call_type != Call::Image)) {
+            return expr;
+        }
+        vector<Expr> args;
+        bool changed = false;
+        for (const Expr &arg : op->args) {
+            if (!expr_uses_vars(arg, domain)) {
+                args.push_back(arg);
+                continue;
+            }
+            Interval b = bounds_of_expr_in_scope(arg, domain);
+            if (b.is_bounded()) {
+                Expr min = simplify(b.min), max = simplify(b.max);
+                if (equal(min, max) || can_prove(min == max)) {
+                    args.push_back(min);
+                    changed = true;
+                    continue;
+                }
+            }
+            args.push_back(arg);
+        }
+        if (!changed) {
+            return expr;
+        }
+        return Call::make(op->type, op->name, args, op->call_type,
+                          op->func, op->value_index, op->image, op->param);
+    }
+
+public:
+    FixCallArgsOverDomain(const string &var, const Interval &interval) {
+        domain.push(var, interval);
+    }
+};
+
+// Take a condition that depends on a loop variable, and return a
+// condition that doesn't, and is true if the original is true for any
+// value of the loop variable in the given interval.
+Expr or_condition_over_loop(Expr c, const string &var, const Interval &interval) {
+    c = simplify(FixCallArgsOverDomain(var, interval).mutate(c));
+    if (!expr_uses_var(c, var)) {
+        return c;
+    }
+    Scope<Interval> domain;
+    domain.push(var, interval);
+    return simplify(!and_condition_over_domain(simplify(!c), domain));
+}
+
 }  // namespace
 
 class PredicateFinder : public IRVisitor {
@@ -47,6 +121,7 @@ public:
     PredicateFinder(const string &b, bool s) : predicate(const_false()),
                                                buffer(b),
                                                varies(false),
+                                               varies_with_data(false),
                                                treat_selects_as_guards(s),
                                                in_produce(false) {}
 
@@ -54,24 +129,33 @@ private:
 
     using IRVisitor::visit;
     string buffer;
-    bool varies;
+    // Whether the expression being visited varies within the
+    // Realize. If it only varies with loop variables (and not with
+    // values computed or allocated inside the Realize), conditions
+    // that use it are kept, and made independent of each loop
+    // variable at its loop. This lets a Realize inside a tile loop
+    // skip the tiles in which its Func is not used.
+    bool varies, varies_with_data;
     bool treat_selects_as_guards;
     bool in_produce;
-    Scope<> varying;
+    Scope<> varying, varying_with_data;
     Scope<> in_pipeline;
     Scope<> local_buffers;
 
 
     void visit(const Variable *op) override {
-        bool this_varies = varying.contains(op->name);
-
-        varies |= this_varies;
+        varies |= varying.contains(op->name);
+        varies_with_data |= varying_with_data.contains(op->name);
     }
 
     void visit(const For *op) override {
+        bool old_varies_with_data = varies_with_data;
+        varies_with_data = false;
         op->min.accept(this);
         bool min_varies = varies;
         op->extent.accept(this);
+        bool bounds_vary_with_data = varies_with_data;
+        varies_with_data |= old_varies_with_data;
         bool should_pop = false;
         if (!is_one(op->extent) || min_varies) {
             should_pop = true;
@@ -80,7 +164,13 @@ private:
         op->body.accept(this);
         if (should_pop) {
             varying.pop(op->name);
-            //internal_assert(!expr_uses_var(predicate, op->name));
+            if (expr_uses_var(predicate, op->name)) {
+                Interval loop_interval = Interval::everything();
+                if (!bounds_vary_with_data) {
+                    loop_interval = Interval(op->min, op->min + op->extent - 1);
+                }
+                predicate = or_condition_over_loop(predicate, op->name, loop_interval);
+            }
         } else if (expr_uses_var(predicate, op->name)) {
             predicate = Let::make(op->name, op->min, predicate);
         }
@@ -89,17 +179,27 @@ private:
     template<typename T>
     void visit_let(const std::string &name, Expr value, T body) {
         bool old_varies = varies;
+        bool old_varies_with_data = varies_with_data;
         varies = false;
+        varies_with_data = false;
         value.accept(this);
         bool value_varies = varies;
+        bool value_varies_with_data = varies_with_data;
         varies |= old_varies;
+        varies_with_data |= old_varies_with_data;
         if (value_varies) {
             varying.push(name);
         }
+        if (value_varies_with_data) {
+            varying_with_data.push(name);
+        }
         body.accept(this);
         if (value_varies) {
             varying.pop(name);
         }
+        if (value_varies_with_data) {
+            varying_with_data.pop(name);
+        }
         if (expr_uses_var(predicate, name)) {
             predicate = Let::make(name, value, predicate);
         }
@@ -189,18 +289,21 @@ private:
         Expr false_predicate = predicate;
 
         bool old_varies = varies;
+        bool old_varies_with_data = varies_with_data;
         predicate = const_false();
         varies = false;
+        varies_with_data = false;
         condition.accept(this);
 
         predicate = make_or(predicate, old_predicate);
-        if (varies) {
+        if (varies_with_data) {
             predicate = make_or(predicate, make_or(true_predicate, false_predicate));
         } else {
             predicate = make_or(predicate, make_select(condition, true_predicate, false_predicate));
         }
 
         varies = varies || old_varies;
+        varies_with_data = varies_with_data || old_varies_with_data;
     }
 
     void visit(const Select *op) override {
@@ -217,6 +320,7 @@ private:
 
     void visit(const Call *op) override {
         varies |= in_pipeline.contains(op->name);
+        varies_with_data |= in_pipeline.contains(op->name);
 
         IRVisitor::visit(op);
 
@@ -244,7 +348,9 @@ private:
         // allocation.
         ScopedBinding<>
             bind_host_ptr(varying, op->name),
-            bind_buffer(varying, op->name + ".buffer");
+            bind_buffer(varying, op->name + ".buffer"),
+            bind_host_ptr_data(varying_with_data, op->name),
+            bind_buffer_data(varying_with_data, op->name + ".buffer");
         IRVisitor::visit(op);
     }
 };
@@ -0,0 +1,40 @@
+#include "SparseTiles.h"
+#include "IROperator.h"
+
+namespace Halide {
+
+SparseTiles sparse_tiles(const Func &dense, const Func &background,
+                         const Func &tiles, Expr num_tiles,
+                         int tile_width, int tile_height) {
+    user_assert(dense.defined() && background.defined() && tiles.defined())
+        << "sparse_tiles called with an undefined Func\n";
+    user_assert(dense.dimensions() >= 2)
+        << "sparse_tiles requires a Func with at least two dimensions, but "
+        << dense.name() << " has " << dense.dimensions() << "\n";
+    user_assert(background.dimensions() == dense.dimensions())
+        << "The background " << background.name() << " of sparse_tiles has "
+        << background.dimensions() << " dimensions instead of " << dense.dimensions() << "\n";
+    user_assert(background.output_types() == dense.output_types())
+        << "The background " << background.name() << " of sparse_tiles has different types from "
+        << dense.name() << "\n";
+    user_assert(tiles.dimensions() == 2)
+        << "The list of tiles " << tiles.name() << " passed to sparse_tiles must have two dimensions\n";
+    user_assert(tile_width > 0 && tile_height > 0)
+        << "sparse_tiles called with tile size " << tile_width << "x" << tile_height << "\n";
+
+    std::vector<Var> args = dense.args();
+    Func result(dense.name() + "_sparse");
+    result(args) = background(args);
+
+    RDom r(0, tile_width, 0, tile_height, 0, num_tiles, dense.name() + "_tiles");
+    std::vector<Expr> coords = {
+        cast<int>(tiles(0, r.z)) * tile_width + r.x,
+        cast<int>(tiles(1, r.z)) * tile_height + r.y,
+    };
+    coords.insert(coords.end(), args.begin() + 2, args.end());
+    result(coords) = dense(coords);
+
+    return {result, r.x, r.y, r.z};
+}
+
+}  // namespace Halide
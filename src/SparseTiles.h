@@ -0,0 +1,70 @@
+#ifndef HALIDE_SPARSE_TILES_H
+#define HALIDE_SPARSE_TILES_H
+
+/** \file
+ * Support for computing a Func only over a list of active tiles.
+ */
+
+#include "Func.h"
+#include "Lambda.h"
+#include "RDom.h"
+
+namespace Halide {
+
+/** A Func that is only computed over a list of tiles, as returned by
+ * \ref sparse_tiles. */
+struct SparseTiles {
+    /** The Func. Outside of the listed tiles it takes the values of
+     * the background. */
+    Func func;
+
+    /** The RVars of the update definition of func that iterate over
+     * the listed tiles: the coordinates within a tile, and the index
+     * into the list of tiles. */
+    // @{
+    RVar x, y, tile;
+    // @}
+};
+
+/** Make a Func that has the values of 'dense' within a list of
+ * tile_width x tile_height tiles of its first two dimensions, and the
+ * values of 'background' everywhere else. The tiles are listed by
+ * 'tiles': the i'th tile has its top-left corner at
+ * (tiles(0, i) * tile_width, tiles(1, i) * tile_height), for i in [0,
+ * num_tiles). The list of tiles is usually a compacted list of the
+ * tiles in which a mask is set, computed by an earlier stage or
+ * passed in as an input.
+ *
+ * The tiles are computed by an update definition that loops over the
+ * list. Producers of 'dense' computed at the tile loop are computed
+ * only over the region each tile needs, so no work is done for tiles
+ * that aren't listed. For example:
+ *
+ \code
+ ImageParam active(Int(32), 2);
+ Param<int> num_active;
+ SparseTiles s = sparse_tiles(inpaint, input_f, active, num_active, 32, 32);
+ s.func.update().vectorize(s.x, 8);
+ expensive.compute_at(s.func, s.tile).vectorize(x, 8);
+ \endcode
+ *
+ * If the listed tiles are known to be distinct, the tile loop can
+ * also be parallelized, with
+ * s.func.update().allow_race_conditions().parallel(s.tile).
+ */
+// @{
+SparseTiles sparse_tiles(const Func &dense, const Func &background,
+                         const Func &tiles, Expr num_tiles,
+                         int tile_width, int tile_height);
+
+template<typename T>
+HALIDE_NO_USER_CODE_INLINE SparseTiles sparse_tiles(const Func &dense, const Func &background,
+                                                    const T &tiles, Expr num_tiles,
+                                                    int tile_width, int tile_height) {
+    return sparse_tiles(dense, background, lambda(_, tiles(_)), num_tiles, tile_width, tile_height);
+}
+// @}
+
+}  // namespace Halide
+
+#endif
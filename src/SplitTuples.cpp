@@ -56,9 +56,39 @@ class SplitTuples : public IRMutator {
 
     map<string, set<int>> func_value_indices;
 
+    // The Funcs realized within the current scope whose tuple
+    // elements are stored interleaved.
+    set<string> interleaved;
+
+    bool is_interleaved(const string &name) const {
+        return realizations.contains(name) && interleaved.count(name);
+    }
+
+    // The coordinates of a tuple element in an interleaved
+    // allocation. The element index is the innermost dimension.
+    static vector<Expr> interleaved_args(int value_index, const vector<Expr> &args) {
+        vector<Expr> result = {value_index};
+        result.insert(result.end(), args.begin(), args.end());
+        return result;
+    }
+
+    static Region interleaved_bounds(int outputs, const Region &bounds) {
+        Region result = {Range(0, outputs)};
+        result.insert(result.end(), bounds.begin(), bounds.end());
+        return result;
+    }
+
     Stmt visit(const Realize *op) override {
         ScopedBinding<int> bind(realizations, op->name, 0);
-        if (op->types.size() > 1) {
+        auto it = env.find(op->name);
+        if (op->types.size() > 1 && it != env.end() &&
+            interleaves_tuple(it->second, env)) {
+            interleaved.insert(op->name);
+            Stmt body = mutate(op->body);
+            return Realize::make(op->name, {op->types[0]}, op->memory_type,
+                                 interleaved_bounds(op->types.size(), op->bounds),
+                                 op->condition, body);
+        } else if (op->types.size() > 1) {
             // Make a nested set of realize nodes for each tuple element
             Stmt body = mutate(op->body);
             for (int i = (int)op->types.size() - 1; i >= 0; i--) {
@@ -83,7 +113,14 @@ class SplitTuples : public IRMutator {
     }
 
     Stmt visit(const Prefetch *op) override {
-        if (!op->prefetch.param.defined() && (op->types.size() > 1)) {
+        if (!op->prefetch.param.defined() && (op->types.size() > 1) &&
+            is_interleaved(op->name)) {
+            // All the elements are in one allocation.
+            Stmt body = mutate(op->body);
+            return Prefetch::make(op->name, {op->types[0]},
+                                  interleaved_bounds(op->types.size(), op->bounds),
+                                  op->prefetch, op->condition, body);
+        } else if (!op->prefetch.param.defined() && (op->types.size() > 1)) {
             Stmt body = mutate(op->body);
             // Split the prefetch from a multi-dimensional halide tuple to
             // prefetches of each tuple element. Keep only prefetches of
@@ -107,13 +144,15 @@ class SplitTuples : public IRMutator {
             internal_assert(it != env.end());
             Function f = it->second;
             string name = op->name;
-            if (f.outputs() > 1) {
-                name += "." + std::to_string(op->value_index);
-            }
             vector<Expr> args;
             for (Expr e : op->args) {
                 args.push_back(mutate(e));
             }
+            if (f.outputs() > 1 && is_interleaved(op->name)) {
+                args = interleaved_args(op->value_index, args);
+            } else if (f.outputs() > 1) {
+                name += "." + std::to_string(op->value_index);
+            }
             // It's safe to hook up the pointer to the function
             // unconditionally. This expr never gets held by a
             // Function, so there can't be a cycle. We do this even
@@ -165,6 +204,7 @@ class SplitTuples : public IRMutator {
         vector<Stmt> provides;
         vector<pair<string, Expr>> lets;
 
+        const bool interleave = is_interleaved(op->name);
         for (size_t i = 0; i < op->values.size(); i++) {
             string name = op->name + "." + std::to_string(i);
             string var_name = name + ".value";
@@ -173,7 +213,14 @@ class SplitTuples : public IRMutator {
                 lets.push_back({ var_name, val });
                 val = Variable::make(val.type(), var_name);
             }
-            provides.push_back(Provide::make(name, {val}, args));
+            if (interleave) {
+                // The stores to the elements are adjacent in memory,
+                // so once vectorized, rewrite_interleavings turns
+                // them into one dense store.
+                provides.push_back(Provide::make(op->name, {val}, interleaved_args(i, args)));
+            } else {
+                provides.push_back(Provide::make(name, {val}, args));
+            }
         }
 
         Stmt result = Block::make(provides);
@@ -197,6 +244,32 @@ public:
 
 }  // namespace
 
+bool interleaves_tuple(const Function &f, const map<string, Function> &env) {
+    if (!f.schedule().interleave_tuple() ||
+        f.outputs() < 2 ||
+        f.has_extern_definition() ||
+        f.schedule().memoized()) {
+        return false;
+    }
+    for (const Type &t : f.output_types()) {
+        if (t != f.output_types()[0]) {
+            return false;
+        }
+    }
+    // Extern stages are passed one buffer per tuple element.
+    for (const auto &p : env) {
+        if (!p.second.has_extern_definition()) {
+            continue;
+        }
+        for (const ExternFuncArgument &arg : p.second.extern_arguments()) {
+            if (arg.is_func() && Function(arg.func).name() == f.name()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 Stmt split_tuples(Stmt s, const map<string, Function> &env) {
     return SplitTuples(env).mutate(s);
 }
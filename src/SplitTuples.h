@@ -18,6 +18,14 @@ namespace Internal {
 
 Stmt split_tuples(Stmt s, const std::map<std::string, Function> &env);
 
+/** Check if a Tuple-valued Function's realizations are stored as a
+ * single allocation with the tuple elements interleaved, because it
+ * was scheduled with Func::store_tuple_interleaved and nothing
+ * prevents it. The tuple element is then the innermost dimension of
+ * the allocation, which is named after the Function itself rather
+ * than after each element. Pipeline outputs are never interleaved. */
+bool interleaves_tuple(const Function &f, const std::map<std::string, Function> &env);
+
 }  // namespace Internal
 }  // namespace Halide
 
@@ -2,7 +2,10 @@
 #include "IRVisitor.h"
 #include "IROperator.h"
 #include "Scope.h"
+#include "Util.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iterator>
 #include <iostream>
 #include <fstream>
@@ -34,6 +37,83 @@ private:
 
     int unique_id() { return ++id_count; }
 
+    // The profile of the function being printed, if any, and the
+    // largest values in it, which the heat colors are relative to.
+    const std::map<string, std::map<string, ProfiledFunc>> *profiles = nullptr;
+    const std::map<string, ProfiledFunc> *profile = nullptr;
+    double max_time = 0, max_threads = 0;
+    uint64_t max_memory = 0;
+
+    // Find the profile of the Func that a realization, allocation or
+    // loop belongs to. Allocations of Tuple-valued Funcs have a suffix
+    // of the index of the value, and loops are named <func>.s<stage>.<var>.
+    const ProfiledFunc *find_profile(const string &name, bool is_loop = false) {
+        if (!profile) {
+            return nullptr;
+        }
+        const ProfiledFunc *result = nullptr;
+        size_t longest = 0;
+        for (const auto &f : *profile) {
+            const string &func = f.first;
+            bool match;
+            if (is_loop) {
+                // With profile_by_stage, update stages are reported
+                // as <func>.update(i), and own the loops of stage i + 1.
+                size_t update = func.rfind(".update(");
+                if (update != string::npos && ends_with(func, ")")) {
+                    int stage = std::atoi(func.c_str() + update + 8) + 1;
+                    match = starts_with(name, func.substr(0, update) + ".s" + std::to_string(stage) + ".");
+                } else {
+                    match = starts_with(name, func + ".s");
+                }
+            } else {
+                match = (name == func) ||
+                    (starts_with(name, func + ".") &&
+                     name.find_first_not_of("0123456789", func.size() + 1) == string::npos);
+            }
+            if (match && func.size() >= longest) {
+                result = &f.second;
+                longest = func.size();
+            }
+        }
+        return result;
+    }
+
+    // A label with a background color from yellow to red, by the
+    // fraction 'heat' of the hottest value of its kind.
+    string profile_label(const string &body, double heat) {
+        heat = std::min(std::max(heat, 0.0), 1.0);
+        std::stringstream s;
+        s << "<span class='Profile' style='background-color: hsl("
+          << (int)(60 * (1 - heat)) << ", 100%, " << (int)(90 - 40 * heat) << "%);'>"
+          << body << "</span>";
+        return s.str();
+    }
+
+    string time_label(const ProfiledFunc &p) {
+        std::stringstream s;
+        s << p.time_ms << "ms (" << p.percent << "%)";
+        if (p.threads > 0) {
+            s << " threads: " << p.threads;
+        }
+        return profile_label(s.str(), max_time > 0 ? p.time_ms / max_time : 0);
+    }
+
+    string threads_label(const ProfiledFunc &p) {
+        std::stringstream s;
+        s << "threads: " << p.threads;
+        return profile_label(s.str(), max_threads > 0 ? p.threads / max_threads : 0);
+    }
+
+    string memory_label(const ProfiledFunc &p) {
+        std::stringstream s;
+        s << "peak: " << p.memory_peak << " bytes, num: " << p.num_allocs << ", avg: " << p.memory_avg;
+        if (p.stack_peak > 0) {
+            s << ", stack: " << p.stack_peak;
+        }
+        return profile_label(s.str(), max_memory > 0 ? (double)p.memory_peak / max_memory : 0);
+    }
+
     // All spans and divs will have an id of the form "x-y", where x
     // is shared among all spans/divs in the same context, and y is unique.
     std::vector<int> context_stack;
@@ -334,6 +414,9 @@ private:
         stream << var(op->name);
         stream << close_expand_button() << " {";
         stream << close_span();;
+        if (const ProfiledFunc *p = op->is_producer ? find_profile(op->name) : nullptr) {
+            stream << time_label(*p);
+        }
         stream << open_div(op->is_producer ? "ProduceBody Indent" : "ConsumeBody Indent", produce_id);
         print(op->body);
         stream << close_div();
@@ -372,6 +455,13 @@ private:
         stream << matched(")");
         stream << close_expand_button();
         stream << " " << matched("{");
+        if (const ProfiledFunc *p = find_profile(op->name, true)) {
+            if (op->for_type == ForType::Parallel && p->threads > 0) {
+                stream << threads_label(*p);
+            } else {
+                stream << profile_label("", max_time > 0 ? p->time_ms / max_time : 0);
+            }
+        }
         stream << open_div("ForBody Indent", id);
         print(op->body);
         stream << close_div();
@@ -464,6 +554,11 @@ private:
             stream << keyword("custom_delete") << "{ " << op->free_function << "(); ";
             stream << matched("}");
         }
+        if (const ProfiledFunc *p = find_profile(op->name)) {
+            if (p->memory_peak > 0 || p->stack_peak > 0) {
+                stream << memory_label(*p);
+            }
+        }
 
         stream << open_div("AllocateBody");
         print(op->body);
@@ -527,6 +622,21 @@ private:
         stream << close_div();
     }
 
+    void visit(const Atomic *op) override {
+        stream << open_div("Atomic");
+        int id = unique_id();
+        stream << open_expand_button(id);
+        stream << keyword("atomic") << matched("(");
+        stream << var(op->producer_name);
+        stream << matched(")") << " " << matched("{");
+        stream << close_expand_button();
+        stream << open_div("AtomicBody Indent", id);
+        print(op->body);
+        stream << close_div();
+        stream << matched("}");
+        stream << close_div();
+    }
+
     // To avoid generating ridiculously deep DOMs, we flatten blocks here.
     void visit_block_stmt(Stmt stmt) {
         if (const Block *b = stmt.as<Block>()) {
@@ -653,7 +763,35 @@ private:
         stream << close_span();
     }
 
+    void visit(const VectorReduce *op) override {
+        stream << open_span("VectorReduce");
+        stream << open_span("Type") << op->type << close_span();
+        std::ostringstream op_name;
+        op_name << op->op;
+        stream << symbol("vector_reduce") << "(" << symbol(op_name.str()) << ", ";
+        print(op->value);
+        stream << ")";
+        stream << close_span();
+    }
+
 public:
+    void set_profile(const std::map<string, ProfiledFunc> *p) {
+        profile = p;
+        max_time = max_threads = 0;
+        max_memory = 0;
+        if (profile) {
+            for (const auto &f : *profile) {
+                max_time = std::max(max_time, f.second.time_ms);
+                max_threads = std::max(max_threads, f.second.threads);
+                max_memory = std::max(max_memory, f.second.memory_peak);
+            }
+        }
+    }
+
+    void set_profiles(const std::map<string, std::map<string, ProfiledFunc>> *p) {
+        profiles = p;
+    }
+
     void print(Expr ir) {
         ir.accept(this);
     }
@@ -664,6 +802,10 @@ public:
 
     void print(const LoweredFunc &op) {
         scope.push(op.name, unique_id());
+        if (profiles) {
+            auto iter = profiles->find(op.name);
+            set_profile(iter == profiles->end() ? nullptr : &iter->second);
+        }
         stream << open_div("Function");
 
         int id = unique_id();
@@ -767,6 +909,7 @@ span.IntImm { color: #099; }\n \
 span.FloatImm { color: #099; }\n \
 b.Highlight { font-weight: bold; background-color: #DDD; }\n \
 span.Highlight { font-weight: bold; background-color: #FF0; }\n \
+span.Profile { display: inline-block; min-width: 8px; min-height: 8px; margin-left: 10px; padding: 0px 4px; border-radius: 3px; font-style: italic; }\n \
 ";
 
 const std::string StmtToHtml::js = "\n \
@@ -797,5 +940,76 @@ void print_to_html(string filename, const Module &m) {
     sth.print(m);
 }
 
+std::map<string, std::map<string, ProfiledFunc>> parse_profiler_report(const string &report) {
+    std::map<string, std::map<string, ProfiledFunc>> result;
+    std::map<string, ProfiledFunc> *pipeline = nullptr;
+    std::istringstream lines(report);
+    string line;
+    while (std::getline(lines, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] != ' ') {
+            // Each pipeline starts with a line holding just its name.
+            pipeline = &result[line];
+            continue;
+        }
+        // Funcs are listed as "  name: 1.23ms (12%) threads: 3.4 ...",
+        // and the totals of the pipeline are indented by one space.
+        size_t colon = line.find(": ", 2);
+        if (!pipeline || line.size() < 3 || line[1] != ' ' || line[2] == ' ' ||
+            colon == string::npos) {
+            continue;
+        }
+        ProfiledFunc &f = (*pipeline)[line.substr(2, colon - 2)];
+        std::istringstream fields(line.substr(colon + 2));
+        string field;
+        if (fields >> field) {
+            f.time_ms = std::atof(field.c_str());
+        }
+        if (fields >> field && field.size() > 2) {
+            f.percent = std::atoi(field.c_str() + 1);
+        }
+        while (fields >> field) {
+            string value;
+            if (field.back() != ':' || !(fields >> value)) {
+                continue;
+            }
+            if (field == "threads:") {
+                f.threads = std::atof(value.c_str());
+            } else if (field == "peak:") {
+                f.memory_peak = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (field == "num:") {
+                f.num_allocs = std::atoi(value.c_str());
+            } else if (field == "avg:") {
+                f.memory_avg = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (field == "stack:") {
+                f.stack_peak = std::strtoull(value.c_str(), nullptr, 10);
+            }
+        }
+    }
+    return result;
+}
+
+void print_to_html(string filename, Stmt s, const string &profiler_report) {
+    std::map<string, std::map<string, ProfiledFunc>> profiles = parse_profiler_report(profiler_report);
+    // A Stmt isn't labelled with the name of its pipeline, so use the
+    // stats of every pipeline in the report.
+    std::map<string, ProfiledFunc> profile;
+    for (const auto &p : profiles) {
+        profile.insert(p.second.begin(), p.second.end());
+    }
+    StmtToHtml sth(filename);
+    sth.set_profile(&profile);
+    sth.print(s);
+}
+
+void print_to_html(string filename, const Module &m, const string &profiler_report) {
+    std::map<string, std::map<string, ProfiledFunc>> profiles = parse_profiler_report(profiler_report);
+    StmtToHtml sth(filename);
+    sth.set_profiles(&profiles);
+    sth.print(m);
+}
+
 }
 }
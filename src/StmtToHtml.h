@@ -5,6 +5,8 @@
  * Defines a function to dump an HTML-formatted stmt to a file.
  */
 
+#include <map>
+
 #include "Module.h"
 
 namespace Halide {
@@ -18,6 +20,39 @@ void print_to_html(std::string filename, Stmt s);
 /** Dump an HTML-formatted print of a Module to filename. */
 void print_to_html(std::string filename, const Module &m);
 
+/** The statistics reported for one Func by halide_profiler_report. */
+struct ProfiledFunc {
+    /** Time taken per run, in milliseconds. */
+    double time_ms = 0;
+    /** Share of the pipeline's total time, as a percentage. */
+    int percent = 0;
+    /** Average number of threads active while computing it. Zero if
+     * the pipeline ran serially. */
+    double threads = 0;
+    uint64_t memory_peak = 0, memory_avg = 0, stack_peak = 0;
+    int num_allocs = 0;
+};
+
+/** Parse the text printed by halide_profiler_report. Returns the
+ * stats of each Func, keyed by the name of the pipeline and then by
+ * the name of the Func. */
+std::map<std::string, std::map<std::string, ProfiledFunc>>
+parse_profiler_report(const std::string &report);
+
+/** Dump an HTML-formatted print of a Stmt to filename, annotated
+ * with the output of halide_profiler_report. Produce nodes and loops
+ * are colored by the time taken by their Func, parallel loops are
+ * labelled with the average number of threads used, and allocations
+ * with their peak memory usage. Profiler output only has a
+ * granularity of a Func, so every loop of a Func gets the same
+ * color. */
+void print_to_html(std::string filename, Stmt s, const std::string &profiler_report);
+
+/** Dump an HTML-formatted print of a Module to filename, annotating
+ * each function with the profile of the pipeline of the same name in
+ * the output of halide_profiler_report. */
+void print_to_html(std::string filename, const Module &m, const std::string &profiler_report);
+
 }  // namespace Internal
 }  // namespace Halide
 
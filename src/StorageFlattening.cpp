@@ -6,6 +6,7 @@
 #include "IROperator.h"
 #include "Parameter.h"
 #include "Scope.h"
+#include "SplitTuples.h"
 
 #include <sstream>
 
@@ -38,6 +39,13 @@ private:
     Scope<> realizations, shader_scope_realizations;
     bool in_shader = false;
 
+    // The number of dimensions added to the front of a Function's
+    // storage for the tuple element: one if its elements are stored
+    // interleaved, and zero otherwise.
+    static int interleaved_dimension(const pair<Function, int> &entry) {
+        return entry.second < 0 ? 1 : 0;
+    }
+
     Expr make_shape_var(string name, string field, size_t dim,
                         const Buffer<> &buf, const Parameter &param) {
         ReductionDomain rdom;
@@ -137,19 +145,31 @@ private:
             Function f = iter->second.first;
             const vector<StorageDim> &storage_dims = f.schedule().storage_dims();
             const vector<string> &args = f.args();
+            // An interleaved tuple has the tuple element as an extra
+            // innermost dimension.
+            const int offset = interleaved_dimension(iter->second);
+            if (offset) {
+                storage_permutation.push_back(0);
+                allocation_extents[0] = extents[0];
+            }
             for (size_t i = 0; i < storage_dims.size(); i++) {
-                for (size_t j = 0; j < args.size(); j++) {
-                    if (args[j] == storage_dims[i].var) {
-                        storage_permutation.push_back((int)j);
+                for (size_t k = 0; k < args.size(); k++) {
+                    if (args[k] == storage_dims[i].var) {
+                        const int j = (int)k + offset;
+                        storage_permutation.push_back(j);
                         Expr alignment = storage_dims[i].alignment;
                         if (alignment.defined()) {
                             allocation_extents[j] = ((extents[j] + alignment - 1)/alignment)*alignment;
                         } else {
                             allocation_extents[j] = extents[j];
                         }
+                        Expr padding = storage_dims[i].padding;
+                        if (padding.defined()) {
+                            allocation_extents[j] += padding;
+                        }
                     }
                 }
-                internal_assert(storage_permutation.size() == i+1);
+                internal_assert(storage_permutation.size() == i + 1 + offset);
             }
         }
 
@@ -326,13 +346,17 @@ private:
                 Function f = iter->second.first;
                 const vector<StorageDim> &storage_dims = f.schedule().storage_dims();
                 const vector<string> &args = f.args();
+                const int offset = interleaved_dimension(iter->second);
+                if (offset) {
+                    storage_permutation.push_back(0);
+                }
                 for (size_t i = 0; i < storage_dims.size(); i++) {
                     for (size_t j = 0; j < args.size(); j++) {
                         if (args[j] == storage_dims[i].var) {
-                            storage_permutation.push_back((int)j);
+                            storage_permutation.push_back((int)j + offset);
                         }
                     }
-                    internal_assert(storage_permutation.size() == i+1);
+                    internal_assert(storage_permutation.size() == i + 1 + offset);
                 }
             }
             internal_assert(storage_permutation.size() == op->bounds.size());
@@ -429,12 +453,18 @@ Stmt storage_flattening(Stmt s,
     // Make an environment that makes it easier to figure out which
     // Function corresponds to a tuple component. foo.0, foo.1, foo.2,
     // all point to the function foo.
+    // Internal Functions with interleaved tuple elements use a single
+    // allocation named after the Function, which maps to an index of
+    // -1.
     map<string, pair<Function, int>> tuple_env;
     for (auto p : env) {
         if (p.second.outputs() > 1) {
             for (int i = 0; i < p.second.outputs(); i++) {
                 tuple_env[p.first + "." + std::to_string(i)] = {p.second, i};
             }
+            if (interleaves_tuple(p.second, env)) {
+                tuple_env[p.first] = {p.second, -1};
+            }
         } else {
             tuple_env[p.first] = {p.second, 0};
         }
@@ -25,7 +25,9 @@ using std::map;
 using std::string;
 using std::vector;
 
-// Count the number of producers of a particular func.
+// Count the number of producers of a particular func. A Func stored in
+// place of this one (see reuse_producer_storage) also counts, as its
+// provides outside of any producer for this func.
 class CountProducers : public IRVisitor {
     const std::string &name;
 
@@ -37,6 +39,13 @@ class CountProducers : public IRVisitor {
         }
     }
 
+    void visit(const Provide *op) override {
+        if (op->name == name) {
+            count++;
+        }
+        IRVisitor::visit(op);
+    }
+
     using IRVisitor::visit;
 
 public:
@@ -51,6 +60,29 @@ int count_producers(Stmt in, const std::string &name) {
     return counter.count;
 }
 
+// Collect the names of all the variables defined inside a statement.
+class CollectDefinedVars : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const LetStmt *op) override {
+        vars.push(op->name);
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const Let *op) override {
+        vars.push(op->name);
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const For *op) override {
+        vars.push(op->name);
+        IRGraphVisitor::visit(op);
+    }
+
+public:
+    Scope<> vars;
+};
+
 // Fold the storage of a function in a particular dimension by a particular factor
 class FoldStorageOfFunction : public IRMutator {
     string func;
@@ -58,6 +90,24 @@ class FoldStorageOfFunction : public IRMutator {
     Expr factor;
     string dynamic_footprint;
 
+    // If defined, address the folded dimension as a ring buffer. Every
+    // access in the loop body is known to lie in [ring_min, ring_min +
+    // factor), and ring_base is ring_min % factor, computed once per
+    // loop iteration. This lets us wrap coordinates with a compare and
+    // subtract instead of a modulus.
+    Expr ring_min, ring_base;
+
+    Expr fold(const Expr &e) {
+        if (is_one(factor)) {
+            return 0;
+        } else if (ring_base.defined()) {
+            Expr idx = ring_base + (e - ring_min);
+            return select(idx >= factor, idx - factor, idx);
+        } else {
+            return e % factor;
+        }
+    }
+
     using IRMutator::visit;
 
     Expr visit(const Call *op) override {
@@ -67,7 +117,7 @@ class FoldStorageOfFunction : public IRMutator {
         if (op->name == func && op->call_type == Call::Halide) {
             vector<Expr> args = op->args;
             internal_assert(dim < (int)args.size());
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             expr = Call::make(op->type, op->name, args, op->call_type,
                               op->func, op->value_index, op->image, op->param);
         } else if (op->name == Call::buffer_crop) {
@@ -141,7 +191,7 @@ class FoldStorageOfFunction : public IRMutator {
         internal_assert(op);
         if (op->name == func) {
             vector<Expr> args = op->args;
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             stmt = Provide::make(op->name, op->values, args);
         }
         return stmt;
@@ -149,8 +199,8 @@ class FoldStorageOfFunction : public IRMutator {
 
 
 public:
-    FoldStorageOfFunction(string f, int d, Expr e, string p) :
-        func(f), dim(d), factor(e), dynamic_footprint(p) {}
+    FoldStorageOfFunction(string f, int d, Expr e, string p, Expr ring_min = Expr(), Expr ring_base = Expr()) :
+        func(f), dim(d), factor(e), dynamic_footprint(p), ring_min(ring_min), ring_base(ring_base) {}
 };
 
 // Inject dynamic folding checks against a tracked live range.
@@ -435,6 +485,16 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
         Box required = box_required(body, func.name());
         Box box = box_union(provided, required);
 
+        // If each iteration of the loop produces everything it uses,
+        // nothing is communicated from one iteration to the next
+        // (e.g. by sliding window), so it doesn't matter which
+        // direction the footprint moves in, and any number of
+        // dimensions can be folded over this loop, as long as the
+        // footprint of one iteration fits. An async producer can run
+        // ahead of its consumer, so this doesn't apply to it.
+        const bool independent_iterations = (box_contains(provided, required) &&
+                                             !func.schedule().async());
+
         Expr loop_var = Variable::make(Int(32), op->name);
         Expr loop_min = Variable::make(Int(32), op->name + ".loop_min");
         Expr loop_max = Variable::make(Int(32), op->name + ".loop_max");
@@ -540,6 +600,15 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             // Uncomment to pretend that static analysis always fails (for testing)
             // can_fold_forwards = can_fold_backwards = false;
 
+            if (!explicit_only && independent_iterations &&
+                !can_fold_forwards && !can_fold_backwards &&
+                (expr_uses_var(min, op->name) || expr_uses_var(max, op->name))) {
+                // E.g. a footprint that moves along x and then jumps
+                // back at the start of each row, over a loop over
+                // tiles of both x and y that have been fused together.
+                can_fold_forwards = true;
+            }
+
             if (!can_fold_forwards && !can_fold_backwards) {
                 if (explicit_factor.defined()) {
                     // If we didn't find a monotonic dimension, and we
@@ -657,7 +726,45 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                 } else {
                     head = dynamic_footprint;
                 }
-                body = FoldStorageOfFunction(func.name(), (int)i - 1, factor, head).mutate(body);
+
+                // Ring buffer addressing needs the min of the
+                // footprint at the top of each loop iteration, so it
+                // must not depend on anything computed inside
+                // it. It also relies on the footprint of each
+                // iteration fitting in the fold, which we only know
+                // if we could analyze it statically.
+                bool ring_buffer = false;
+                if (storage_dim.ring_buffer) {
+                    CollectDefinedVars defined;
+                    body.accept(&defined);
+                    ring_buffer = (dynamic_footprint.empty() &&
+                                   is_pure(min) &&
+                                   !expr_uses_vars(min, defined.vars));
+                    if (!ring_buffer) {
+                        debug(3) << "Not addressing " << func.name() << " as a ring buffer because the min of its footprint "
+                                 << "isn't known at the top of the loop over " << op->name << ": " << min << "\n";
+                    }
+                }
+
+                if (ring_buffer) {
+                    if (explicit_factor.defined() && func.schedule().async()) {
+                        // The check on the extent above was skipped
+                        // because the semaphores track the footprint,
+                        // but the ring buffer addressing needs it.
+                        Expr error = Call::make(Int(32), "halide_error_fold_factor_too_small",
+                                                {func.name(), storage_dim.var, explicit_factor, op->name, extent},
+                                                Call::Extern);
+                        body = Block::make(AssertStmt::make(extent <= explicit_factor, error), body);
+                    }
+                    string ring_name = func.name() + ".ring." + std::to_string(i - 1) + unique_name('_');
+                    Expr ring_min = Variable::make(Int(32), ring_name + ".min");
+                    Expr ring_base = Variable::make(Int(32), ring_name + ".base");
+                    body = FoldStorageOfFunction(func.name(), (int)i - 1, factor, head, ring_min, ring_base).mutate(body);
+                    body = LetStmt::make(ring_name + ".base", ring_min % factor, body);
+                    body = LetStmt::make(ring_name + ".min", min, body);
+                } else {
+                    body = FoldStorageOfFunction(func.name(), (int)i - 1, factor, head).mutate(body);
+                }
             }
 
             // If the producer is async, it can run ahead by
@@ -756,6 +863,13 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                 // for further folding opportunities
                 // recursively.
             } else if (!body.same_as(op->body)) {
+                if (independent_iterations) {
+                    // The overlap is recomputed by each iteration, so
+                    // keep looking for other dimensions to fold over
+                    // this loop.
+                    dynamic_footprint.clear();
+                    continue;
+                }
                 stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
                 break;
             } else {
@@ -15,6 +15,16 @@
 // This uses elf.h and must be included after "LLVM_Headers.h", which
 // uses llvm/support/Elf.h.
 #include <sys/auxv.h>
+// Older C libraries don't define the POWER9 and POWER10 bits.
+#ifndef PPC_FEATURE2_ARCH_3_00
+#define PPC_FEATURE2_ARCH_3_00 0x00800000
+#endif
+#ifndef PPC_FEATURE2_ARCH_3_1
+#define PPC_FEATURE2_ARCH_3_1 0x00040000
+#endif
+#ifndef PPC_FEATURE2_MMA
+#define PPC_FEATURE2_MMA 0x00020000
+#endif
 #endif
 
 #ifdef  _MSC_VER
@@ -92,6 +102,9 @@ Target calculate_host_target() {
     bool have_altivec = (hwcap & PPC_FEATURE_HAS_ALTIVEC) != 0;
     bool have_vsx     = (hwcap & PPC_FEATURE_HAS_VSX) != 0;
     bool arch_2_07    = (hwcap2 & PPC_FEATURE2_ARCH_2_07) != 0;
+    bool arch_3_00    = (hwcap2 & PPC_FEATURE2_ARCH_3_00) != 0;
+    bool arch_3_1     = (hwcap2 & PPC_FEATURE2_ARCH_3_1) != 0 &&
+                        (hwcap2 & PPC_FEATURE2_MMA) != 0;
 
     user_assert(have_altivec)
         << "The POWERPC backend assumes at least AltiVec support. This machine does not appear to have AltiVec.\n";
@@ -99,6 +112,8 @@ Target calculate_host_target() {
     std::vector<Target::Feature> initial_features;
     if (have_vsx)     initial_features.push_back(Target::VSX);
     if (arch_2_07)    initial_features.push_back(Target::POWER_ARCH_2_07);
+    if (arch_3_00)    initial_features.push_back(Target::POWER_ARCH_3_00);
+    if (arch_3_1)     initial_features.push_back(Target::POWER_ARCH_3_1);
 #else
     Target::Arch arch = Target::X86;
 
@@ -143,6 +158,9 @@ Target calculate_host_target() {
         const uint32_t avx512_knl = avx512 | avx512pf | avx512er;
         const uint32_t avx512_skylake = avx512 | avx512vl | avx512bw | avx512dq;
         const uint32_t avx512_cannonlake = avx512_skylake | avx512ifma; // Assume ifma => vbmi
+        const uint32_t avx512vnni = 1U << 11;  // In ecx
+        const uint32_t avx512bf16 = 1U << 5;   // In eax, with cpuid(eax=7, ecx=1)
+        const uint32_t amx = (1U << 22) | (1U << 24) | (1U << 25);  // AMX-BF16, AMX-TILE, AMX-INT8 in edx
         if ((info2[1] & avx2) == avx2) {
             initial_features.push_back(Target::AVX2);
         }
@@ -157,6 +175,23 @@ Target calculate_host_target() {
             if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
                 initial_features.push_back(Target::AVX512_Cannonlake);
             }
+            if ((info2[1] & avx512_skylake) == avx512_skylake &&
+                (info2[2] & avx512vnni) == avx512vnni) {
+                initial_features.push_back(Target::AVX512_VNNI);
+                int info3[4];
+                cpuid(info3, 7, 1);
+                if ((info3[0] & avx512bf16) == avx512bf16) {
+                    initial_features.push_back(Target::AVX512_BF16);
+#if LLVM_VERSION >= 130
+                    // The AMX instructions can only be generated with
+                    // LLVM 13 or later.
+                    if ((info2[1] & avx512_cannonlake) == avx512_cannonlake &&
+                        (info2[3] & amx) == amx) {
+                        initial_features.push_back(Target::AVX512_SapphireRapids);
+                    }
+#endif
+                }
+            }
         }
     }
 #ifdef _WIN32
@@ -192,6 +227,12 @@ int get_cuda_capability_lower_bound(const Target &t) {
     if (t.has_feature(Target::CUDACapability61)) {
         return 61;
     }
+    if (t.has_feature(Target::CUDACapability70)) {
+        return 70;
+    }
+    if (t.has_feature(Target::CUDACapability80)) {
+        return 80;
+    }
     return 20;
 }
 
@@ -201,6 +242,8 @@ bool is_using_hexagon(const Target &t) {
            || t.has_feature(Target::HVX_v62)
            || t.has_feature(Target::HVX_v65)
            || t.has_feature(Target::HVX_v66)
+           || t.has_feature(Target::HVX_v68)
+           || t.has_feature(Target::HVX_v69)
            || t.has_feature(Target::HexagonDma)
            || t.has_feature(Target::HVX_shared_object)
            || t.arch == Target::Hexagon;
@@ -219,6 +262,12 @@ int get_hvx_lower_bound(const Target &t) {
     if (t.has_feature(Target::HVX_v66)) {
         return 66;
     }
+    if (t.has_feature(Target::HVX_v68)) {
+        return 68;
+    }
+    if (t.has_feature(Target::HVX_v69)) {
+        return 69;
+    }
     return 60;
 }
 
@@ -252,8 +301,12 @@ Target::Feature calculate_host_cuda_capability(Target t) {
         return Target::CUDACapability35;
     } else if (ver < 61) {
         return Target::CUDACapability50;
-    } else {
+    } else if (ver < 70) {
         return Target::CUDACapability61;
+    } else if (ver < 80) {
+        return Target::CUDACapability70;
+    } else {
+        return Target::CUDACapability80;
     }
 }
 
@@ -309,6 +362,7 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"debug", Target::Debug},
     {"no_asserts", Target::NoAsserts},
     {"no_bounds_query", Target::NoBoundsQuery},
+    {"trusted_entry", Target::TrustedEntry},
     {"sse41", Target::SSE41},
     {"avx", Target::AVX},
     {"avx2", Target::AVX2},
@@ -325,6 +379,8 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"cuda_capability_35", Target::CUDACapability35},
     {"cuda_capability_50", Target::CUDACapability50},
     {"cuda_capability_61", Target::CUDACapability61},
+    {"cuda_capability_70", Target::CUDACapability70},
+    {"cuda_capability_80", Target::CUDACapability80},
     {"opencl", Target::OpenCL},
     {"cl_doubles", Target::CLDoubles},
     {"cl_half", Target::CLHalf},
@@ -343,6 +399,9 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"hvx_v62", Target::HVX_v62},
     {"hvx_v65", Target::HVX_v65},
     {"hvx_v66", Target::HVX_v66},
+    {"hvx_v68", Target::HVX_v68},
+    {"hvx_v69", Target::HVX_v69},
+    {"hvx_auto_vtcm", Target::HVX_AutoVTCM},
     {"hvx_shared_object", Target::HVX_shared_object},
     {"fuzz_float_stores", Target::FuzzFloatStores},
     {"soft_float_abi", Target::SoftFloatABI},
@@ -366,6 +425,29 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"disable_llvm_loop_unroll", Target::DisableLLVMLoopUnroll},
     {"wasm_simd128", Target::WasmSimd128},
     {"wasm_signext", Target::WasmSignExt},
+    {"arena_alloc", Target::ArenaAlloc},
+    {"cuda_cubin", Target::CUDACubin},
+    {"avx512_vnni", Target::AVX512_VNNI},
+    {"avx512_bf16", Target::AVX512_BF16},
+    {"arm_dot_prod", Target::ARMDotProd},
+    {"arm_fp16", Target::ARMFp16},
+    {"sve", Target::SVE},
+    {"sve2", Target::SVE2},
+    {"rvv", Target::RVV},
+    {"wasm_threads", Target::WasmThreads},
+    {"metal_lib", Target::MetalLib},
+    {"auto_async", Target::AutoAsync},
+    {"profile_by_stage", Target::ProfileByStage},
+    {"profile_branches", Target::ProfileBranches},
+    {"vulkan", Target::Vulkan},
+    {"webgpu", Target::WebGPU},
+    {"power_arch_3_00", Target::POWER_ARCH_3_00},
+    {"power_arch_3_1", Target::POWER_ARCH_3_1},
+    {"avx512_sapphirerapids", Target::AVX512_SapphireRapids},
+    {"check_aliasing", Target::CheckAliasing},
+    {"cache_bounds_checks", Target::CacheBoundsChecks},
+    {"share_allocations", Target::ShareAllocations},
+    {"reuse_producer_storage", Target::ReuseProducerStorage},
     // NOTE: When adding features to this map, be sure to update
     // PyEnums.cpp and halide.cmake as well.
 };
@@ -477,7 +559,9 @@ bool merge_string(Target &t, const std::string &target) {
         !t.has_feature(Target::CUDACapability32) &&
         !t.has_feature(Target::CUDACapability35) &&
         !t.has_feature(Target::CUDACapability50) &&
-        !t.has_feature(Target::CUDACapability61)) {
+        !t.has_feature(Target::CUDACapability61) &&
+        !t.has_feature(Target::CUDACapability70) &&
+        !t.has_feature(Target::CUDACapability80)) {
         // Detect host cuda capability
         t.set_feature(get_host_cuda_capability(t));
     }
@@ -643,6 +727,16 @@ bool Target::supported() const {
 #if !defined(WITH_D3D12)
     bad |= has_feature(Target::D3D12Compute);
 #endif
+#if !defined(WITH_VULKAN)
+    bad |= has_feature(Target::Vulkan);
+#endif
+#if !defined(WITH_WEBGPU)
+    bad |= has_feature(Target::WebGPU);
+#endif
+#if LLVM_VERSION < 130
+    // The AMX tile instructions need LLVM 13 or later.
+    bad |= has_feature(Target::AVX512_SapphireRapids);
+#endif
 #if defined(WITH_WEBASSEMBLY) && LLVM_VERSION < 90
     // LLVM8 supports wasm, but there are fixes and improvements
     // in trunk that may not be in 8 (or that we haven't tested with),
@@ -701,7 +795,8 @@ Target Target::without_feature(Feature f) const {
 }
 
 bool Target::has_gpu_feature() const {
-    return has_feature(CUDA) || has_feature(OpenCL) || has_feature(Metal) || has_feature(D3D12Compute);
+    return has_feature(CUDA) || has_feature(OpenCL) || has_feature(Metal) || has_feature(D3D12Compute) ||
+           has_feature(Vulkan) || has_feature(WebGPU);
 }
 
 bool Target::supports_type(const Type &t) const {
@@ -711,9 +806,10 @@ bool Target::supports_type(const Type &t) const {
                    !has_feature(OpenGL) &&
                    !has_feature(OpenGLCompute) &&
                    !has_feature(D3D12Compute) &&
+                   !has_feature(WebGPU) &&
                    (!has_feature(Target::OpenCL) || has_feature(Target::CLDoubles));
         } else {
-            return !has_feature(Metal) && !has_feature(D3D12Compute);
+            return !has_feature(Metal) && !has_feature(D3D12Compute) && !has_feature(WebGPU);
         }
     }
     return true;
@@ -742,6 +838,9 @@ bool Target::supports_type(const Type &t, DeviceAPI device) const {
         // Shader Model 5.x can optionally support double-precision; 64-bit int
         // types are not supported.
         return t.bits() < 64;
+    } else if (device == DeviceAPI::WebGPU) {
+        // WGSL has no 64-bit types.
+        return t.bits() < 64;
     }
 
     return true;
@@ -767,6 +866,8 @@ Target::Feature target_feature_for_device_api(DeviceAPI api) {
     case DeviceAPI::Metal:         return Target::Metal;
     case DeviceAPI::Hexagon:       return Target::HVX_128;
     case DeviceAPI::D3D12Compute:  return Target::D3D12Compute;
+    case DeviceAPI::Vulkan:        return Target::Vulkan;
+    case DeviceAPI::WebGPU:        return Target::WebGPU;
     default:                       return Target::FeatureEnd;
     }
 }
@@ -795,13 +896,19 @@ int Target::natural_vector_size(const Halide::Type &t) const {
         }
     } else if (arch == Target::X86) {
         if (is_integer && (has_feature(Halide::Target::AVX512_Skylake) ||
-                           has_feature(Halide::Target::AVX512_Cannonlake))) {
-            // AVX512BW exists on Skylake and Cannonlake
+                           has_feature(Halide::Target::AVX512_Cannonlake) ||
+                           has_feature(Halide::Target::AVX512_VNNI) ||
+                           has_feature(Halide::Target::AVX512_BF16) ||
+                           has_feature(Halide::Target::AVX512_SapphireRapids))) {
+            // AVX512BW exists on Skylake and later
             return 64 / data_size;
         } else if (t.is_float() && (has_feature(Halide::Target::AVX512) ||
                                     has_feature(Halide::Target::AVX512_KNL) ||
                                     has_feature(Halide::Target::AVX512_Skylake) ||
-                                    has_feature(Halide::Target::AVX512_Cannonlake))) {
+                                    has_feature(Halide::Target::AVX512_Cannonlake) ||
+                                    has_feature(Halide::Target::AVX512_VNNI) ||
+                                    has_feature(Halide::Target::AVX512_BF16) ||
+                                    has_feature(Halide::Target::AVX512_SapphireRapids))) {
             // AVX512F is on all AVX512 architectures
             return 64 / data_size;
         } else if (has_feature(Halide::Target::AVX2)) {
@@ -838,18 +945,19 @@ bool Target::get_runtime_compatible_target(const Target& other, Target &result)
     // (a) must be included if either target has the feature (union)
     // (b) must be included if both targets have the feature (intersection)
     // (c) must match across both targets; it is an error if one target has the feature and the other doesn't
-    const std::array<Feature, 15> union_features = {{
+    const std::array<Feature, 19> union_features = {{
             // These are true union features.
-            CUDA, OpenCL, OpenGL, OpenGLCompute, Metal, D3D12Compute, NoNEON,
+            CUDA, OpenCL, OpenGL, OpenGLCompute, Metal, D3D12Compute, Vulkan, WebGPU, NoNEON,
 
             // These features are actually intersection-y, but because targets only record the _highest_,
             // we have to put their union in the result and then take a lower bound.
             CUDACapability30, CUDACapability32, CUDACapability35, CUDACapability50, CUDACapability61,
-            HVX_v62, HVX_v65, HVX_v66
+            HVX_v62, HVX_v65, HVX_v66, HVX_v68, HVX_v69
     }};
 
-    const std::array<Feature, 12> intersection_features = {{
-            SSE41, AVX, AVX2, FMA, FMA4, F16C, ARMv7s,VSX, AVX512, AVX512_KNL, AVX512_Skylake, AVX512_Cannonlake
+    const std::array<Feature, 20> intersection_features = {{
+            SSE41, AVX, AVX2, FMA, FMA4, F16C, ARMv7s,VSX, AVX512, AVX512_KNL, AVX512_Skylake, AVX512_Cannonlake,
+            AVX512_VNNI, AVX512_BF16, AVX512_SapphireRapids, ARMDotProd, ARMFp16, SVE, SVE2, RVV
     }};
 
     const std::array<Feature, 10> matching_features = {{
@@ -918,6 +1026,8 @@ bool Target::get_runtime_compatible_target(const Target& other, Target &result)
     if (hvx_version < 62) output.features.reset(HVX_v62);
     if (hvx_version < 65) output.features.reset(HVX_v65);
     if (hvx_version < 66) output.features.reset(HVX_v66);
+    if (hvx_version < 68) output.features.reset(HVX_v68);
+    if (hvx_version < 69) output.features.reset(HVX_v69);
 
     result = output;
     return true;
@@ -77,6 +77,8 @@ struct Target {
         CUDACapability35 = halide_target_feature_cuda_capability35,
         CUDACapability50 = halide_target_feature_cuda_capability50,
         CUDACapability61 = halide_target_feature_cuda_capability61,
+        CUDACapability70 = halide_target_feature_cuda_capability70,
+        CUDACapability80 = halide_target_feature_cuda_capability80,
         OpenCL = halide_target_feature_opencl,
         CLDoubles = halide_target_feature_cl_doubles,
         CLHalf = halide_target_feature_cl_half,
@@ -96,6 +98,10 @@ struct Target {
         HVX_v62 = halide_target_feature_hvx_v62,
         HVX_v65 = halide_target_feature_hvx_v65,
         HVX_v66 = halide_target_feature_hvx_v66,
+        HVX_v68 = halide_target_feature_hvx_v68,
+        HVX_v69 = halide_target_feature_hvx_v69,
+        HVX_AutoVTCM = halide_target_feature_hvx_auto_vtcm,
+        TrustedEntry = halide_target_feature_trusted_entry,
         HVX_shared_object = halide_target_feature_hvx_use_shared_object,
         FuzzFloatStores = halide_target_feature_fuzz_float_stores,
         SoftFloatABI = halide_target_feature_soft_float_abi,
@@ -118,6 +124,29 @@ struct Target {
         DisableLLVMLoopUnroll = halide_target_feature_disable_llvm_loop_unroll,
         WasmSimd128 = halide_target_feature_wasm_simd128,
         WasmSignExt = halide_target_feature_wasm_signext,
+        ArenaAlloc = halide_target_feature_arena_alloc,
+        CUDACubin = halide_target_feature_cuda_cubin,
+        AVX512_VNNI = halide_target_feature_avx512_vnni,
+        AVX512_BF16 = halide_target_feature_avx512_bf16,
+        ARMDotProd = halide_target_feature_arm_dot_prod,
+        ARMFp16 = halide_target_feature_arm_fp16,
+        SVE = halide_target_feature_sve,
+        SVE2 = halide_target_feature_sve2,
+        RVV = halide_target_feature_rvv,
+        WasmThreads = halide_target_feature_wasm_threads,
+        MetalLib = halide_target_feature_metal_lib,
+        AutoAsync = halide_target_feature_auto_async,
+        ProfileByStage = halide_target_feature_profile_by_stage,
+        ProfileBranches = halide_target_feature_profile_branches,
+        Vulkan = halide_target_feature_vulkan,
+        WebGPU = halide_target_feature_webgpu,
+        POWER_ARCH_3_00 = halide_target_feature_power_arch_3_00,
+        POWER_ARCH_3_1 = halide_target_feature_power_arch_3_1,
+        AVX512_SapphireRapids = halide_target_feature_avx512_sapphirerapids,
+        CheckAliasing = halide_target_feature_check_aliasing,
+        CacheBoundsChecks = halide_target_feature_cache_bounds_checks,
+        ShareAllocations = halide_target_feature_share_allocations,
+        ReuseProducerStorage = halide_target_feature_reuse_producer_storage,
         FeatureEnd = halide_target_feature_end
     };
     Target() : os(OSUnknown), arch(ArchUnknown), bits(0) {}
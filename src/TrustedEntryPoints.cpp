@@ -0,0 +1,88 @@
+#include "TrustedEntryPoints.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// Remove everything that checks the arguments, and the handling of
+// bounds queries. This is what a target with NoAsserts and
+// NoBoundsQuery would compile, but derived from the already-lowered
+// body so that the pipeline doesn't have to be lowered again.
+class StripChecks : public IRMutator {
+    using IRMutator::visit;
+
+    // Code generation drops asserts under NoAsserts, but keeps any
+    // lets they depend on (which may have side effects), so just
+    // remove the asserts without simplifying.
+    Stmt visit(const AssertStmt *op) override {
+        return Evaluate::make(0);
+    }
+
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::buffer_is_bounds_query)) {
+            return const_false();
+        }
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const IfThenElse *op) override {
+        Expr condition = mutate(op->condition);
+        Stmt then_case = mutate(op->then_case);
+        Stmt else_case = mutate(op->else_case);
+        if (!condition.same_as(op->condition)) {
+            // The condition referred to a bounds query. Only these
+            // conditions are simplified, to pick the branch taken
+            // when the call isn't a bounds query.
+            condition = simplify(condition);
+            if (is_one(condition)) {
+                return then_case;
+            } else if (is_zero(condition)) {
+                return else_case.defined() ? else_case : Evaluate::make(0);
+            }
+        }
+        if (condition.same_as(op->condition) &&
+            then_case.same_as(op->then_case) &&
+            else_case.same_as(op->else_case)) {
+            return op;
+        }
+        return IfThenElse::make(condition, then_case, else_case);
+    }
+};
+
+// Remove all of the computation, leaving only the checks and the
+// handling of bounds queries.
+class StripProducers : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->is_producer) {
+            return Evaluate::make(0);
+        }
+        return IRMutator::visit(op);
+    }
+};
+
+}  // namespace
+
+void add_trusted_entry_points(Module module, const LoweredFunc &fn) {
+    if (!module.target().has_feature(Target::TrustedEntry)) {
+        return;
+    }
+
+    Stmt trusted_body = StripChecks().mutate(fn.body);
+    debug(2) << "Added trusted entry point for " << fn.name << ":\n" << trusted_body << "\n\n";
+    module.append(LoweredFunc(fn.name + "_trusted", fn.args, trusted_body,
+                              LinkageType::External, fn.name_mangling));
+
+    Stmt validate_body = StripProducers().mutate(fn.body);
+    debug(2) << "Added validation for " << fn.name << ":\n" << validate_body << "\n\n";
+    module.append(LoweredFunc(fn.name + "_validate", fn.args, validate_body,
+                              LinkageType::External, fn.name_mangling));
+}
+
+}  // namespace Internal
+}  // namespace Halide
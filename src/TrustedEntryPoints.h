@@ -0,0 +1,33 @@
+#ifndef HALIDE_TRUSTED_ENTRY_POINTS_H
+#define HALIDE_TRUSTED_ENTRY_POINTS_H
+
+#include "Module.h"
+
+/** \file
+ *
+ * Defines a pass over a Module that adds entry points which separate
+ * the validation of a pipeline's arguments from running it. */
+
+namespace Halide {
+namespace Internal {
+
+/** If the module's target has Target::TrustedEntry, add two
+ * LoweredFuncs derived from fn, with the same arguments:
+ *
+ * - fn.name + "_trusted", which skips all assertions (including the
+ *   buffer and parameter checks) and never answers bounds queries. It
+ *   must only be called with arguments that fn.name + "_validate"
+ *   accepts, or that are known to be equivalent.
+ *
+ * - fn.name + "_validate", which makes the checks and answers the
+ *   bounds queries that fn would, but computes nothing.
+ *
+ * Code generation also adds fn.name + "_trusted_argv" and
+ * fn.name + "_trusted_batch", which calls the former over an array of
+ * argument sets. */
+void add_trusted_entry_points(Module m, const LoweredFunc &fn);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -31,6 +31,9 @@ Halide::Expr Type::max() const {
         return Internal::IntImm::make(*this, max_int(bits()));
     } else if (is_uint()) {
         return Internal::UIntImm::make(*this, max_uint(bits()));
+    } else if (is_bfloat()) {
+        internal_assert(bits() == 16) << "Unknown bfloat type: " << (*this) << "\n";
+        return Internal::FloatImm::make(*this, std::numeric_limits<float>::infinity());
     } else {
         internal_assert(is_float());
         if (bits() == 16) {
@@ -55,6 +58,9 @@ Halide::Expr Type::min() const {
         return Internal::IntImm::make(*this, min_int(bits()));
     } else if (is_uint()) {
         return Internal::UIntImm::make(*this, 0);
+    } else if (is_bfloat()) {
+        internal_assert(bits() == 16) << "Unknown bfloat type: " << (*this) << "\n";
+        return Internal::FloatImm::make(*this, -std::numeric_limits<float>::infinity());
     } else {
         internal_assert(is_float());
         if (bits() == 16) {
@@ -106,8 +112,10 @@ bool Type::can_represent(Type other) const {
                 (other.is_uint() && other.bits() < bits()));
     } else if (is_uint()) {
         return other.is_uint() && other.bits() <= bits();
+    } else if (is_bfloat()) {
+        return (other.is_bfloat() && other.bits() <= bits());
     } else if (is_float()) {
-        return ((other.is_float() && other.bits() <= bits()) ||
+        return ((other.is_float() && !other.is_bfloat() && other.bits() <= bits()) ||
                 (bits() == 64 && other.bits() <= 32) ||
                 (bits() == 32 && other.bits() <= 16));
     } else {
@@ -123,6 +131,9 @@ bool Type::can_represent(int64_t x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (int64_t)(float)(bfloat16_t)(float)x == x;
+            }
             return (int64_t)(float)(float16_t)(float)x == x;
         case 32:
             return (int64_t)(float)x == x;
@@ -144,6 +155,9 @@ bool Type::can_represent(uint64_t x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (uint64_t)(float)(bfloat16_t)(float)x == x;
+            }
             return (uint64_t)(float)(float16_t)(float)x == x;
         case 32:
             return (uint64_t)(float)x == x;
@@ -167,6 +181,9 @@ bool Type::can_represent(double x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (double)(bfloat16_t)x == x;
+            }
             return (double)(float16_t)x == x;
         case 32:
             return (double)(float)x == x;
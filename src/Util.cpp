@@ -2,6 +2,7 @@
 #include "Debug.h"
 #include "Error.h"
 #include "Introspection.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <fstream>
@@ -97,6 +98,14 @@ string running_program_name() {
     #endif
 }
 
+int get_num_compile_threads() {
+    string threads = get_env_variable("HL_NUM_COMPILE_THREADS");
+    if (threads.empty()) {
+        return 1;
+    }
+    return std::max(1, std::atoi(threads.c_str()));
+}
+
 namespace {
 // We use 64K of memory to store unique counters for the purpose of
 // making names unique. Using less memory increases the likelihood of
@@ -114,6 +114,12 @@ std::string get_env_variable(char const *env_var_name);
  * If program name cannot be retrieved, function returns an empty string. */
 std::string running_program_name();
 
+/** The number of threads to use for the parts of compilation that can
+ * be done in parallel, as set by the HL_NUM_COMPILE_THREADS
+ * environment variable. Defaults to one, in which case compilation is
+ * single-threaded and deterministic. */
+int get_num_compile_threads();
+
 /** Generate a unique name starting with the given prefix. It's unique
  * relative to all other strings returned by unique_name in this
  * process.
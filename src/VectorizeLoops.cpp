@@ -1,5 +1,6 @@
 #include <algorithm>
 
+#include "Associativity.h"
 #include "CSE.h"
 #include "CodeGen_GPU_Dev.h"
 #include "Deinterleave.h"
@@ -263,11 +264,28 @@ class PredicateLoadStore : public IRMutator {
                 << "We are inside a hexagon loop, but the target doesn't have hexagon's features\n";
             return true;
         } else if (target.arch == Target::X86) {
-            // Should only attempt to predicate store/load if the lane size is
-            // no less than 4
-            // TODO: disabling for now due to trunk LLVM breakage.
+            // Masked loads and stores without AVX-512 are still disabled
+            // due to LLVM breakage.
             // See: https://github.com/halide/Halide/issues/3534
-            // return (bit_size == 32) && (lanes >= 4);
+            //
+            // With AVX-512 they use the mask registers: 32 and 64-bit
+            // elements need only AVX-512F, 8 and 16-bit elements need
+            // AVX-512BW. Should only attempt to predicate store/load if
+            // the lane size is no less than 4.
+            if (lanes < 4) {
+                return false;
+            }
+            const bool avx512bw = target.features_any_of({Target::AVX512_Skylake,
+                                                          Target::AVX512_Cannonlake,
+                                                          Target::AVX512_VNNI,
+                                                          Target::AVX512_BF16});
+            const bool avx512f = avx512bw || target.features_any_of({Target::AVX512,
+                                                                     Target::AVX512_KNL});
+            if (bit_size == 32 || bit_size == 64) {
+                return avx512f;
+            } else if (bit_size == 8 || bit_size == 16) {
+                return avx512bw;
+            }
             return false;
         }
         // For other architecture, do not predicate vector load/store
@@ -360,6 +378,29 @@ public:
     }
 };
 
+// Replace loads of one location of a buffer with calls to a Func of
+// the same name, so that the associativity prover can recognize an
+// update of that location.
+class LoadsToSelfReferences : public IRMutator {
+    using IRMutator::visit;
+
+    const string &name;
+    const Expr &index;
+
+    Expr visit(const Load *op) override {
+        if (op->name == name && equal(op->index, index) && is_one(op->predicate)) {
+            self_load = op;
+            return Call::make(op->type, op->name, {op->index}, Call::Halide);
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    LoadsToSelfReferences(const string &n, const Expr &i) : name(n), index(i) {}
+
+    Expr self_load;
+};
+
 // Substitutes a vector for a scalar var in a Stmt. Used on the
 // body of every vectorized loop.
 class VectorSubs : public IRMutator {
@@ -384,6 +425,10 @@ class VectorSubs : public IRMutator {
     // version of them if we scalarize inner code.
     vector<pair<string, Expr>> containing_lets;
 
+    // The condition of the innermost containing if statement with a
+    // vector condition, if any.
+    Expr vector_condition;
+
     // Widen an expression to the given number of lanes.
     Expr widen(Expr e, int lanes) {
         if (e.type().lanes() == lanes) {
@@ -700,11 +745,100 @@ class VectorSubs : public IRMutator {
         }
     }
 
+    // A store to a location that doesn't vary with the vectorized
+    // var, of a value that does, may be a commutative and associative
+    // update of that location by each lane. If so, combine the lanes
+    // with a horizontal reduction and do a single scalar
+    // update. Returns an undefined Stmt if the store is not such an
+    // update.
+    Stmt vectorize_reduction(const Store *op, Expr index, Expr predicate) {
+        LoadsToSelfReferences to_self_refs(op->name, op->index);
+        Expr value = to_self_refs.mutate(op->value);
+        if (!to_self_refs.self_load.defined()) {
+            return Stmt();
+        }
+
+        AssociativeOp assoc = prove_associativity(op->name, {op->index}, {value});
+        if (!assoc.associative() || !assoc.commutative() || assoc.size() != 1 ||
+            !assoc.xs[0].expr.defined() || !assoc.ys[0].expr.defined()) {
+            return Stmt();
+        }
+
+        // The pattern must be a single binary op of the self-reference
+        // and the rest of the update.
+        Expr pattern = assoc.pattern.ops[0];
+        VectorReduce::Operator reduce_op;
+        Expr a, b;
+        if (const Add *add = pattern.as<Add>()) {
+            reduce_op = VectorReduce::Add;
+            a = add->a;
+            b = add->b;
+        } else if (const Mul *mul = pattern.as<Mul>()) {
+            reduce_op = VectorReduce::Mul;
+            a = mul->a;
+            b = mul->b;
+        } else if (const Min *min = pattern.as<Min>()) {
+            reduce_op = VectorReduce::Min;
+            a = min->a;
+            b = min->b;
+        } else if (const Max *max = pattern.as<Max>()) {
+            reduce_op = VectorReduce::Max;
+            a = max->a;
+            b = max->b;
+        } else if (const And *and_op = pattern.as<And>()) {
+            reduce_op = VectorReduce::And;
+            a = and_op->a;
+            b = and_op->b;
+        } else if (const Or *or_op = pattern.as<Or>()) {
+            reduce_op = VectorReduce::Or;
+            a = or_op->a;
+            b = or_op->b;
+        } else {
+            return Stmt();
+        }
+        const Variable *var_a = a.as<Variable>();
+        const Variable *var_b = b.as<Variable>();
+        if (!var_a || !var_b ||
+            !((var_a->name == assoc.xs[0].var && var_b->name == assoc.ys[0].var) ||
+              (var_a->name == assoc.ys[0].var && var_b->name == assoc.xs[0].var))) {
+            return Stmt();
+        }
+
+        Expr y = mutate(assoc.ys[0].expr);
+        const int lanes = y.type().lanes();
+        if (lanes == 1) {
+            return Stmt();
+        }
+
+        // Lanes that a vector condition turns off contribute the
+        // identity.
+        if (vector_condition.defined()) {
+            internal_assert(vector_condition.type().lanes() == lanes);
+            y = Select::make(vector_condition, y, Broadcast::make(assoc.pattern.identities[0], lanes));
+        }
+
+        const Load *self = to_self_refs.self_load.as<Load>();
+        Expr x = Load::make(self->type, self->name, index, self->image,
+                            self->param, const_true(), self->alignment);
+        Expr new_value = substitute(assoc.xs[0].var, x,
+                                    substitute(assoc.ys[0].var, VectorReduce::make(reduce_op, y, 1), pattern));
+        return Store::make(op->name, new_value, index, op->param, predicate, op->alignment);
+    }
+
     Stmt visit(const Store *op) override {
         Expr predicate = mutate(op->predicate);
-        Expr value = mutate(op->value);
         Expr index = mutate(op->index);
 
+        if (predicate.type().is_scalar() && index.type().is_scalar() &&
+            !op->value.type().is_vector()) {
+            Stmt s = vectorize_reduction(op, index, predicate);
+            if (s.defined()) {
+                return s;
+            }
+        }
+
+        Expr value = mutate(op->value);
+
         if (predicate.same_as(op->predicate) && value.same_as(op->value) && index.same_as(op->index)) {
             return op;
         } else {
@@ -725,8 +859,18 @@ class VectorSubs : public IRMutator {
                  << "Old: " << op->condition << "\n"
                  << "New: " << cond << "\n";
 
-        Stmt then_case = mutate(op->then_case);
-        Stmt else_case = mutate(op->else_case);
+        Expr old_vector_condition = vector_condition;
+        Stmt then_case, else_case;
+        if (lanes > 1) {
+            vector_condition = old_vector_condition.defined() ? (old_vector_condition && cond) : cond;
+            then_case = mutate(op->then_case);
+            vector_condition = old_vector_condition.defined() ? (old_vector_condition && !cond) : !cond;
+            else_case = mutate(op->else_case);
+            vector_condition = old_vector_condition;
+        } else {
+            then_case = mutate(op->then_case);
+            else_case = mutate(op->else_case);
+        }
 
         if (lanes > 1) {
             // We have an if statement with a vector condition,
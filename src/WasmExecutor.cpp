@@ -8,6 +8,7 @@
 #include "LLVM_Output.h"
 #include "LLVM_Runtime_Linker.h"
 #include "Target.h"
+#include "Util.h"
 
 #include <cmath>
 #include <mutex>
@@ -1266,6 +1267,16 @@ WasmModuleContents::WasmModuleContents(
             // "--wasm-interpret-all",
             // "--trace-wasm-memory",
         };
+        // Extra flags for V8 may be passed in HL_WASM_V8_FLAGS,
+        // separated by spaces. e.g. "--no-liftoff" skips the
+        // baseline compiler, so that all code runs in its optimized
+        // form from the first call, which is what you want when
+        // benchmarking.
+        for (const auto &f : split_string(get_env_variable("HL_WASM_V8_FLAGS"), " ")) {
+            if (!f.empty()) {
+                flags.push_back(f);
+            }
+        }
         for (const auto &f : flags) {
             V8::SetFlagsFromString(f.c_str(), f.size());
         }
@@ -164,6 +164,12 @@ public:
         return alloc != nullptr;
     }
 
+    /** The number of Buffers sharing the host memory this Buffer owns,
+     * including this one, or zero if it doesn't own any. */
+    int host_memory_ref_count() const {
+        return owns_host_memory() ? alloc->ref_count.load() : 0;
+    }
+
 private:
     /** Increment the reference count of any owned allocation */
     void incref() const {
@@ -1225,6 +1231,26 @@ public:
             src.crop(i, min_coord, max_coord - min_coord + 1);
         }
 
+        // If the innermost dimension (after flattening) is dense in
+        // both buffers, which is the case for crops of dense buffers
+        // and copies between buffers with the same layout, copy whole
+        // rows at a time.
+        const size_t elem_size = type().bytes();
+        if (dimensions() == 0) {
+            memcpy(dst.data(), src.data(), elem_size);
+            set_host_dirty();
+            return;
+        }
+        Buffer<>::for_each_value_task_dim<2> *t =
+            (Buffer<>::for_each_value_task_dim<2> *)HALIDE_ALLOCA((dimensions() + 1) * sizeof(Buffer<>::for_each_value_task_dim<2>));
+        const halide_buffer_t *buffers[] = {&dst.buf, &src.buf};
+        if (Buffer<>::for_each_value_prep(t, buffers)) {
+            Buffer<>::copy_rows_helper(dimensions() - 1, t, elem_size,
+                                       (uint8_t *)dst.data(), (const uint8_t *)src.data());
+            set_host_dirty();
+            return;
+        }
+
         // If T is void, we need to do runtime dispatch to an
         // appropriately-typed lambda. We're copying, so we only care
         // about the element size.
@@ -1925,6 +1951,22 @@ public:
 
     Buffer<T, D> &fill(not_void_T val) {
         set_host_dirty();
+        // If every byte of the value is the same (e.g. zero), we can
+        // memset dense rows.
+        const uint8_t *bytes = (const uint8_t *)&val;
+        bool uniform_bytes = true;
+        for (size_t i = 1; i < sizeof(val); i++) {
+            uniform_bytes &= bytes[i] == bytes[0];
+        }
+        if (uniform_bytes && dimensions() > 0) {
+            Buffer<>::for_each_value_task_dim<1> *t =
+                (Buffer<>::for_each_value_task_dim<1> *)HALIDE_ALLOCA((dimensions() + 1) * sizeof(Buffer<>::for_each_value_task_dim<1>));
+            const halide_buffer_t *buffers[] = {&buf};
+            if (Buffer<>::for_each_value_prep(t, buffers)) {
+                Buffer<>::fill_rows_helper(dimensions() - 1, t, sizeof(val), (uint8_t *)data(), bytes[0]);
+                return *this;
+            }
+        }
         for_each_value([=](T &v) {v = val;});
         return *this;
     }
@@ -2040,6 +2082,36 @@ private:
         return innermost_strides_are_one;
     }
 
+    // Copy or fill the rows of buffers prepared by
+    // for_each_value_prep, for which the innermost strides are
+    // all one, a whole row at a time.
+    HALIDE_NEVER_INLINE
+    static void copy_rows_helper(int d, const for_each_value_task_dim<2> *t, size_t elem_size,
+                                 uint8_t *dst, const uint8_t *src) {
+        if (d == 0) {
+            memcpy(dst, src, t[0].extent * elem_size);
+        } else {
+            for (int i = t[d].extent; i != 0; i--) {
+                copy_rows_helper(d - 1, t, elem_size, dst, src);
+                dst += (int64_t)t[d].stride[0] * elem_size;
+                src += (int64_t)t[d].stride[1] * elem_size;
+            }
+        }
+    }
+
+    HALIDE_NEVER_INLINE
+    static void fill_rows_helper(int d, const for_each_value_task_dim<1> *t, size_t elem_size,
+                                 uint8_t *dst, uint8_t val) {
+        if (d == 0) {
+            memset(dst, val, t[0].extent * elem_size);
+        } else {
+            for (int i = t[d].extent; i != 0; i--) {
+                fill_rows_helper(d - 1, t, elem_size, dst, val);
+                dst += (int64_t)t[d].stride[0] * elem_size;
+            }
+        }
+    }
+
     template<typename Fn, typename ...Args, int N = sizeof...(Args) + 1>
     void for_each_value_impl(Fn &&f, Args&&... other_buffers) const {
         Buffer<>::for_each_value_task_dim<N> *t =
@@ -305,6 +305,45 @@ extern void halide_join_thread(struct halide_thread *);
  */
 extern int halide_set_num_threads(int n);
 
+/** Give the pipeline invocations made with the given user_context a
+ * priority and a thread budget in Halide's thread pool. Idle threads
+ * always pick up work of a higher priority first. At most max_threads
+ * threads, including the one that called the pipeline, work on the
+ * parallel loops of those invocations at once; zero means no
+ * limit. Tasks that need more threads to make progress (e.g. async()
+ * producers and their consumers) are not limited. Running work is not
+ * preempted, so a higher priority pipeline waits for the iterations
+ * already claimed by lower priority ones. Setting a priority and
+ * max_threads of zero returns the user context to the default. Returns
+ * zero on success, or an error code if too many user contexts have
+ * been given a priority or budget.
+ *
+ * (As with halide_set_num_threads, this is only respected by the
+ * default implementations of the thread pool functions.)
+ */
+extern int halide_set_thread_pool_priority(void *user_context, int priority, int max_threads);
+
+/** Make Halide's thread pool elastic, so that the number of worker
+ * threads follows the load instead of staying at the most ever
+ * created. When work is enqueued, the pool spawns workers for it, up
+ * to the number of threads passed to halide_set_num_threads, or the
+ * cgroup cpu quota of the process (on Linux and Android) if that is
+ * lower. The quota is read again at most once a second, so changes
+ * to it at runtime are followed. Workers beyond what the load needed
+ * over the last ms milliseconds, or beyond the quota or the number of
+ * threads, retire between tasks, without a call to
+ * halide_shutdown_thread_pool. Load is only measured when work is
+ * enqueued, so an idle pool keeps its workers asleep until the next
+ * pipeline runs. A negative ms turns this off, which is the default,
+ * and zero uses the value of the environment variable
+ * HL_THREAD_POOL_IDLE_TIMEOUT_MS, if any. Returns the previous
+ * timeout, or zero if the pool wasn't elastic.
+ *
+ * (As with halide_set_num_threads, this is only respected by the
+ * default implementations of the thread pool functions.)
+ */
+extern int halide_set_thread_pool_idle_timeout(int ms);
+
 /** Halide calls these functions to allocate and free memory. To
  * replace in AOT code, use the halide_set_custom_malloc and
  * halide_set_custom_free, or (on platforms that support weak
@@ -333,6 +372,17 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** On Linux and Windows, halide_default_malloc serves allocations of
+ * at least this many bytes directly from the OS in large pages (2MB
+ * on x86), which take fewer TLB entries than the same memory in
+ * regular pages. On Linux it uses reserved huge pages if there are
+ * any, and otherwise asks for transparent huge pages; on Windows it
+ * needs the SeLockMemoryPrivilege. If large pages aren't available it
+ * uses malloc. The default is HL_LARGE_PAGE_THRESHOLD_MB megabytes, or
+ * 8MB if that isn't set. Zero disables large pages. Returns the
+ * previous threshold. */
+extern int64_t halide_set_large_page_threshold(int64_t bytes);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -379,8 +429,9 @@ typedef enum halide_type_code_t
 {
     halide_type_int = 0,   //!< signed integers
     halide_type_uint = 1,  //!< unsigned integers
-    halide_type_float = 2, //!< floating point numbers
-    halide_type_handle = 3 //!< opaque pointer type (void *)
+    halide_type_float = 2, //!< IEEE floating point numbers
+    halide_type_handle = 3, //!< opaque pointer type (void *)
+    halide_type_bfloat = 4 //!< floating point numbers in the bfloat format
 } halide_type_code_t;
 
 // Note that while __attribute__ can go before or after the declaration,
@@ -637,6 +688,35 @@ struct halide_trace_packet_t {
 
 
 
+/** Binary traces can instead be written in a more compact format, by
+ * setting the environment variable HL_TRACE_FORMAT to "compact". A
+ * compact trace is a sequence of records, each of which starts with
+ * one of the bytes below. All integers are LEB128 varints, and signed
+ * integers are zig-zag encoded first.
+ *
+ * - halide_trace_compact_header is followed by the bytes "HT2". It
+ *   starts the trace written by each process, and resets the string
+ *   table.
+ * - halide_trace_compact_string defines an entry in the string table:
+ *   id, length, then the characters, with no terminating null.
+ * - halide_trace_compact_event is a trace event: id, parent_id,
+ *   event, type code, type bits, type lanes, value_index, the string
+ *   id of the func, the string id of the trace tag (zero if there is
+ *   none), the number of coordinates, and the number of bytes of
+ *   value. Then each coordinate as the (signed) difference from the
+ *   previous one, where the first is relative to zero. Then the raw
+ *   bytes of the value, if any.
+ *
+ * Func names and trace tags are written once each, instead of in every
+ * packet, and the coordinates of vector events are mostly small
+ * deltas, so these traces are usually several times smaller. The
+ * tools in util/ that read traces accept either format. */
+enum halide_trace_compact_record_t {
+    halide_trace_compact_header = 0x7f,
+    halide_trace_compact_string = 1,
+    halide_trace_compact_event = 2
+};
+
 /** Set the file descriptor that Halide should write binary trace
  * events to. If called with 0 as the argument, Halide outputs trace
  * information to stdout in a human-readable format. If never called,
@@ -658,6 +738,14 @@ extern int halide_get_trace_file(void *user_context);
  * (flushing the trace). Returns zero on success. */
 extern int halide_shutdown_trace();
 
+/** Only pass on one in every N load and store events to the trace
+ * handler, to make tracing loads and stores tolerably cheap on large
+ * inputs. Other events are unaffected. If never called, Halide checks
+ * for an environment variable called HL_TRACE_SAMPLE_RATE, and
+ * otherwise passes on every event. Sampling is not exact when events
+ * are emitted from many threads at once. */
+extern void halide_set_trace_sample_rate(int n);
+
 /** All Halide GPU or device backend implementations provide an
  * interface to be used with halide_device_malloc, etc. This is
  * accessed via the functions below.
@@ -730,6 +818,24 @@ extern int halide_copy_to_host(void *user_context, struct halide_buffer_t *buf);
 extern int halide_copy_to_device(void *user_context, struct halide_buffer_t *buf,
                                  const struct halide_device_interface_t *device_interface);
 
+/** Versions of halide_copy_to_host and halide_copy_to_device that
+ * only need the elements at the given range of offsets from the host
+ * pointer (as used by the indices of loads and stores in generated
+ * code) to be current on the destination. Only the slices of the
+ * buffer's outermost dimension that contain the range are
+ * copied. The dirty bits are left set, because the rest of the buffer
+ * is still not current on the destination. These fall back to copying
+ * the whole buffer if the device interface can't copy part of it.
+ * These are called by generated code when it can tell a producer or
+ * consumer only touches part of a buffer. */
+// @{
+extern int halide_copy_to_host_region(void *user_context, struct halide_buffer_t *buf,
+                                      int min, int extent);
+extern int halide_copy_to_device_region(void *user_context, struct halide_buffer_t *buf,
+                                        const struct halide_device_interface_t *device_interface,
+                                        int min, int extent);
+// @}
+
 /** Copy data from one buffer to another. The buffers may have
  * different shapes and sizes, but the destination buffer's shape must
  * be contained within the source buffer's shape. That is, for each
@@ -797,6 +903,32 @@ extern int halide_device_malloc(void *user_context, struct halide_buffer_t *buf,
 /** Free device memory. */
 extern int halide_device_free(void *user_context, struct halide_buffer_t *buf);
 
+/** Control whether device allocations are cached for reuse. When
+ * enabled, device memory released by halide_device_free is kept in a
+ * cache shared by all device backends, keyed on the device interface
+ * and the allocation size, and handed back out by later calls to
+ * halide_device_malloc of exactly the same size on the same device
+ * interface instead of calling the driver allocator. This avoids
+ * paying for e.g. cuMemAlloc/cuMemFree on every realization of a
+ * pipeline with GPU intermediates. Currently supported by the CUDA,
+ * OpenCL and Metal backends. Disabling reuse frees all cached
+ * allocations. Off by default. */
+// @{
+extern int halide_reuse_device_allocations(void *user_context, bool);
+extern bool halide_can_reuse_device_allocations(void *user_context);
+// @}
+
+/** Set the maximum number of bytes of device memory the allocation
+ * cache may hold. When exceeded, the least recently freed allocations
+ * are freed. Zero (the default) means no limit. */
+extern void halide_set_device_allocation_cache_limit(int64_t size);
+
+/** Free all cached device allocations for the given device interface,
+ * or for all device interfaces if it is NULL. Cached allocations for a
+ * device interface are also freed by halide_device_release. */
+extern int halide_device_allocation_cache_flush(void *user_context,
+                                                const struct halide_device_interface_t *device_interface);
+
 /** Wrap or detach a native device handle, setting the device field
  * and device_interface field as appropriate for the given GPU
  * API. The meaning of the opaque handle is specific to the device
@@ -832,17 +964,91 @@ extern void halide_set_gpu_device(int n);
  * setting. Implement this yourself to use a different gpu device per
  * user_context. The default implementation returns the value set by
  * halide_set_gpu_device, or the environment variable
- * HL_GPU_DEVICE. */
+ * HL_GPU_DEVICE. The CUDA runtime keeps a separate context for each
+ * device returned, and enables peer access between them where
+ * supported, so device buffers produced on one GPU can be passed to
+ * pipelines running on another. */
 extern int halide_get_gpu_device(void *user_context);
 
-/** Set the soft maximum amount of memory, in bytes, that the LRU
+/** Set the soft maximum amount of memory, in bytes, that the
  *  cache will use to memoize Func results.  This is not a strict
  *  maximum in that concurrency and simultaneous use of memoized
  *  reults larger than the cache size can both cause it to
- *  temporariliy be larger than the size specified here.
+ *  temporariliy be larger than the size specified here. When the
+ *  cache is full, the results that took the least time to compute
+ *  per byte, among those not recently used, are evicted first.
  */
 extern void halide_memoization_cache_set_size(int64_t size);
 
+/** Set a soft maximum amount of memory, in bytes, that memoized
+ *  results from the pipeline with the given name may use, so that
+ *  one heavily-used pipeline cannot evict the cached results of all
+ *  the others. When the budget is exceeded, entries from this
+ *  pipeline are evicted first. Results still count
+ *  towards the overall limit set by halide_memoization_cache_set_size.
+ *  A size of zero removes the limit. Returns zero on success, or -1
+ *  if too many pipelines have budgets.
+ */
+extern int halide_memoization_cache_set_pipeline_budget(void *user_context, const char *pipeline_name, int64_t size);
+
+/** Back the memoization cache with a file of the given size, mapped
+ *  into memory and shared by every process on the host that uses the
+ *  same path, so that memoized results outlive the process. Results
+ *  missing from the in-memory cache are looked up in the file, and
+ *  new results are added to it until it is full. Entries are never
+ *  evicted from the file; delete it to reset it. Lookups from any
+ *  number of processes and threads run concurrently; additions are
+ *  serialized by a lock on the file. Only supported on Linux,
+ *  Android and OS X. Returns zero on success, or -1 if the store is
+ *  already set, or the file could not be mapped, or was created with
+ *  a different size.
+ */
+extern int halide_memoization_cache_set_persistent_store(void *user_context, const char *path, int64_t size);
+
+/** Counters describing the use of the memoization cache since it
+ *  was created or the counters were last reset. */
+struct halide_memoization_cache_stats_t {
+    /** The number of lookups that found the result in memory. */
+    uint64_t hits;
+    /** The number of lookups that found the result in the persistent
+     *  store, after missing in memory. */
+    uint64_t persistent_hits;
+    /** The number of lookups that found no result, after which the
+     *  result was computed. */
+    uint64_t misses;
+    /** The number of results evicted to keep the cache within its
+     *  limits, and their total size in bytes. */
+    uint64_t evictions;
+    uint64_t evicted_bytes;
+    /** The number of results currently in memory, and their total
+     *  size in bytes. */
+    int64_t entries;
+    int64_t size;
+};
+
+/** Get the counters of the memoization cache. This can be used to
+ *  choose the size passed to halide_memoization_cache_set_size: a
+ *  high rate of evictions relative to misses means results are
+ *  evicted before they are reused. */
+extern void halide_memoization_cache_get_stats(void *user_context, struct halide_memoization_cache_stats_t *stats);
+
+/** Reset the hit, miss and eviction counters of the memoization
+ *  cache to zero. */
+extern void halide_memoization_cache_reset_stats(void *user_context);
+
+/** The type of a function called with the key of each result evicted
+ *  from the memoization cache, its size, and the time taken to
+ *  compute it. It is called with a lock on part of the cache held,
+ *  so it must not use the memoization cache itself. */
+typedef void (*halide_memoization_cache_eviction_handler_t)(void *user_context, const uint8_t *cache_key, int32_t size,
+                                                                int64_t size_in_bytes, int64_t compute_time_ns);
+
+/** Set the function called when a result is evicted from the
+ *  memoization cache, or NULL to call nothing. Returns the previous
+ *  handler. */
+extern halide_memoization_cache_eviction_handler_t
+halide_memoization_cache_set_eviction_handler(halide_memoization_cache_eviction_handler_t handler);
+
 /** Given a cache key for a memoized result, currently constructed
  *  from the Func name and top-level Func name plus the arguments of
  *  the computation, determine if the result is in the cache and
@@ -905,6 +1111,39 @@ extern void halide_memoization_cache_release(void *user_context, void *host);
  */
 extern void halide_memoization_cache_cleanup();
 
+/** Create, use, and destroy a pool of reusable memory blocks. Used by
+ * Func::hoist_storage: the pool is created at the hoist_storage level,
+ * and each allocation inside it acquires a block of at least the
+ * requested size and releases it when done. Released blocks are kept
+ * for reuse until the pool is destroyed. The pool is thread-safe, and
+ * blocks come from halide_malloc with its usual alignment. Acquiring a
+ * block returns NULL if the pool is NULL (because creating it failed)
+ * or a new block could not be allocated. Destroying
+ * the pool frees all released blocks; it must not be called while any
+ * block is still in use. */
+// @{
+extern void *halide_memory_pool_create(void *user_context);
+extern void *halide_memory_pool_acquire(void *user_context, void *pool, uint64_t size);
+extern void halide_memory_pool_release(void *user_context, void *ptr);
+extern void halide_memory_pool_destroy(void *user_context, void *pool);
+// @}
+
+/** Create, use, and destroy the arena used for allocations that happen
+ * once per pipeline invocation when compiling with
+ * Target::ArenaAlloc. Allocations are carved out of large chunks
+ * obtained from halide_malloc, halide_arena_free does nothing, and all
+ * of the memory is released when the arena is destroyed at the end of
+ * the pipeline. The largest chunk is kept for reuse by the next arena
+ * created, until halide_arena_cleanup is called or the runtime is
+ * unloaded. */
+// @{
+extern void *halide_arena_create(void *user_context);
+extern void *halide_arena_alloc(void *user_context, void *arena, uint64_t size);
+extern void halide_arena_free(void *user_context, void *ptr);
+extern void halide_arena_destroy(void *user_context, void *arena);
+extern void halide_arena_cleanup();
+// @}
+
 /** Annotate that a given range of memory has been initialized;
  * only used when Target::MSAN is enabled.
  *
@@ -1271,6 +1510,35 @@ typedef enum halide_target_feature_t {
     halide_target_feature_disable_llvm_loop_unroll,  ///< Disable loop unrolling in LLVM. (Ignored for non-LLVM targets.)
     halide_target_feature_wasm_simd128,  ///< Enable +simd128 instructions for WebAssembly codegen.
     halide_target_feature_wasm_signext,  ///< Enable +sign-ext instructions for WebAssembly codegen.
+    halide_target_feature_arena_alloc,  ///< Carve heap allocations out of a per-invocation arena and per-pipeline memory pool instead of calling halide_malloc for each.
+    halide_target_feature_cuda_cubin,  ///< Compile CUDA kernels ahead of time to a cubin for the target compute capability, using ptxas from the CUDA SDK.
+    halide_target_feature_avx512_vnni,  ///< Enable the AVX512-VNNI integer dot product instructions (Cascade Lake and later). Implies avx512_skylake.
+    halide_target_feature_avx512_bf16,  ///< Enable the AVX512-BF16 instructions (Cooper Lake and later). Implies avx512_vnni.
+    halide_target_feature_arm_dot_prod,  ///< Enable the ARMv8.2 sdot/udot dot product instructions.
+    halide_target_feature_arm_fp16,  ///< Enable ARMv8.2 half-precision floating point vector arithmetic.
+    halide_target_feature_sve,  ///< Enable the ARM Scalable Vector Extension.
+    halide_target_feature_sve2,  ///< Enable the ARM Scalable Vector Extension version 2. Implies sve.
+    halide_target_feature_rvv,  ///< Enable the RISC-V vector extension.
+    halide_target_feature_wasm_threads,  ///< Enable shared memory and atomics for WebAssembly codegen, and use a pthreads-based thread pool (e.g. Emscripten's, on Web Workers).
+    halide_target_feature_metal_lib,  ///< Compile Metal kernels ahead of time to a metallib, using the Metal compiler from Xcode.
+    halide_target_feature_cuda_capability70,  ///< Enable CUDA compute capability 7.0 (Volta)
+    halide_target_feature_cuda_capability80,  ///< Enable CUDA compute capability 8.0 (Ampere)
+    halide_target_feature_hvx_auto_vtcm,  ///< Place small intermediates computed inside loops in VTCM automatically. Requires hvx_v65.
+    halide_target_feature_hvx_v68,  ///< Enable Hexagon v68 architecture, including the HVX IEEE and qfloat floating point instructions.
+    halide_target_feature_hvx_v69,  ///< Enable Hexagon v69 architecture.
+    halide_target_feature_trusted_entry,  ///< Also emit entry points that skip argument checks and bounds queries, a function that only does those, and a batched entry point.
+    halide_target_feature_auto_async,  ///< Run compute_root Funcs concurrently with the independent Funcs that follow them in the realization order, as if they were scheduled async().
+    halide_target_feature_profile_by_stage,  ///< With profile, report the time taken by each update stage of a Func separately.
+    halide_target_feature_profile_branches,  ///< Count how often each branch is taken and each loop runs, for use as a profile by later compiles. See halide_branch_profile_dump().
+    halide_target_feature_vulkan,  ///< Enable the Vulkan runtime, and compile GPU kernels to SPIR-V.
+    halide_target_feature_webgpu,  ///< Enable the WebGPU runtime, and compile GPU kernels to WGSL.
+    halide_target_feature_power_arch_3_00,  ///< Use POWER ISA 3.0 (POWER9) new instructions. Only relevant on POWERPC.
+    halide_target_feature_power_arch_3_1,  ///< Use POWER ISA 3.1 (POWER10) new instructions, including the Matrix-Multiply Assist (MMA) facility. Only relevant on POWERPC.
+    halide_target_feature_avx512_sapphirerapids,  ///< Enable the AMX tile instructions (Sapphire Rapids and later). Implies avx512_bf16 and avx512_cannonlake. Requires LLVM 13 or later.
+    halide_target_feature_check_aliasing,  ///< Check at runtime whether the output buffers overlap the other buffer arguments, and use a version of the pipeline that doesn't assume they are distinct if they do.
+    halide_target_feature_cache_bounds_checks,  ///< Skip the checks on the buffer arguments' shapes and the scalar parameters when they are the same as in the last call that passed them.
+    halide_target_feature_share_allocations,  ///< Let heap allocations with disjoint lifetimes at the same loop level share blocks from a per-pipeline memory pool.
+    halide_target_feature_reuse_producer_storage,  ///< Store an elementwise consumer in place of a producer that only it reads.
 
     halide_target_feature_end ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
@@ -1289,6 +1557,12 @@ typedef enum halide_target_feature_t {
  *
  * The default implementation simply calls halide_default_can_use_target_features.
  *
+ * Multitarget wrappers call this while the library containing them is
+ * being loaded (i.e. during static initialization), so a replacement
+ * implementation must not depend on state that is set up later; state
+ * that changes after load should be handled by installing a function
+ * with halide_set_custom_can_use_target_features instead.
+ *
  * Note that `features` points to an array of `count` uint64_t; this array must contain enough
  * bits to represent all the currently known features. Any excess bits must be set to zero.
  */
@@ -1298,6 +1572,15 @@ typedef int (*halide_can_use_target_features_t)(int count, const uint64_t *featu
 extern halide_can_use_target_features_t halide_set_custom_can_use_target_features(halide_can_use_target_features_t);
 // @}
 
+/** Register the cached function pointer of a multitarget wrapper. The
+ * wrapper selects its sub-target when the library is loaded, by calling
+ * halide_can_use_target_features; calling
+ * halide_set_custom_can_use_target_features clears every registered
+ * pointer, so that the selection is made again on the next call. Returns
+ * 0 if the pointer could not be registered, in which case the wrapper
+ * must not select its sub-target before it is first called. */
+extern int halide_register_dispatch_cache(void **cache);
+
 /**
  * This is the default implementation of halide_can_use_target_features; it is provided
  * for convenience of user code that may wish to extend halide_can_use_target_features
@@ -1657,6 +1940,17 @@ void halide_register_argv_and_metadata(
  * the -profile target flag, which runs a sampling profiler thread
  * alongside the pipeline. */
 
+/** The hardware performance counters recorded by the sampling
+ * profiler when the environment variable HL_PROFILER_PERF_COUNTERS is
+ * set. Currently only supported on x86 linux. */
+enum halide_perf_counter_t {
+    halide_perf_cycles = 0,
+    halide_perf_instructions,
+    halide_perf_llc_misses,
+    halide_perf_branch_misses,
+    halide_perf_num_counters
+};
+
 /** Per-Func state tracked by the sampling profiler. */
 struct halide_profiler_func_stats {
     /** Total time taken evaluating this Func (in nanoseconds). */
@@ -1677,6 +1971,11 @@ struct halide_profiler_func_stats {
     /** The average number of thread pool worker threads active while computing this Func. */
     uint64_t active_threads_numerator, active_threads_denominator;
 
+    /** The hardware performance counter totals of the threads running
+     * this Func, indexed by halide_perf_counter_t. All zero unless
+     * hardware performance counters are enabled and available. */
+    uint64_t perf_counters[halide_perf_num_counters];
+
     /** The name of this Func. A global constant string. */
     const char *name;
 
@@ -1729,8 +2028,38 @@ struct halide_profiler_pipeline_stats {
     int num_allocs;
 };
 
+/** The time spent on a GPU by one kernel, or by copies in one
+ * direction between the host and a GPU, as timed by the device API
+ * while the sampling profiler is running. These exist in a linked
+ * list. */
+struct halide_profiler_device_stats {
+    /** Total time taken on the device (in nanoseconds). */
+    uint64_t time;
+
+    /** The name of the kernel, or of the kind of copy. Owned by the
+     * profiler, as kernels may outlive the modules that launched
+     * them. */
+    const char *name;
+
+    /** The next device_stats pointer. */
+    struct halide_profiler_device_stats *next;
+
+    /** The number of kernel launches or copies timed. */
+    int count;
+
+    /** Whether this is a copy, rather than a kernel. */
+    int is_copy;
+};
+
 /** The global state of the profiler. */
 
+/** The maximum number of concurrently-running parallel tasks the
+ * profiler can distinguish between. Time spent in any further tasks is
+ * not recorded. */
+enum {
+    halide_profiler_max_threads = 256
+};
+
 struct halide_profiler_state {
     /** Guards access to the fields below. If not locked, the sampling
      * profiler thread is free to modify things below (including
@@ -1761,6 +2090,19 @@ struct halide_profiler_state {
 
     /** Sampling thread reference to be joined at shutdown. */
     struct halide_thread *sampling_thread;
+
+    /** The id of the Func being run by each thread currently
+     * executing a parallel task, or halide_profiler_slot_free. Each
+     * task claims a slot when it starts and releases it when it
+     * finishes. The profiler thread samples all of these along with
+     * current_func, so that time spent in Funcs running concurrently
+     * is billed to each of them. */
+    int thread_current_func[halide_profiler_max_threads];
+
+    /** A linked list of the time taken by each GPU kernel and kind
+     * of copy. Device time is not billed to the Funcs of the
+     * pipelines above, which only track time on the host. */
+    struct halide_profiler_device_stats *device_stats;
 };
 
 /** Profiler func ids with special meanings. */
@@ -1770,7 +2112,10 @@ enum {
     /// Set current_func to this value to tell the profiling thread to
     /// halt. It will start up again next time you run a pipeline with
     /// profiling enabled.
-    halide_profiler_please_stop = -2
+    halide_profiler_please_stop = -2,
+    /// Entries of thread_current_func take on this value when not
+    /// claimed by any thread.
+    halide_profiler_slot_free = -3
 };
 
 /** Get a pointer to the global profiler state for programmatic
@@ -1800,6 +2145,38 @@ void halide_profiler_shutdown();
  * reset. Also happens at process exit. */
 extern void halide_profiler_report(void *user_context);
 
+/** Add time taken on a device by a kernel or copy to the profiler's
+ * device stats. Called by the GPU runtimes, which time launches and
+ * copies with the device API when the sampling profiler is running. */
+extern void halide_profiler_record_device_time(void *user_context, const char *name,
+                                               int is_copy, uint64_t time);
+
+/** Get the counters for the branches and loops of a function built
+ * with Target::ProfileBranches, creating them on first use. There are
+ * two counters for each of the num_sites sites. Called by instrumented
+ * code on entry. */
+extern uint64_t *halide_branch_profile_register(void *user_context, const char *name, int num_sites);
+
+/** Write out the branch and loop counts gathered since the last reset,
+ * to the file named by the environment variable HL_BRANCH_PROFILE, or
+ * with halide_print if it is not set. Compiling a pipeline without
+ * Target::ProfileBranches while HL_BRANCH_PROFILE names this file
+ * attaches the counts to the generated code. Also happens at process
+ * exit. */
+extern int halide_branch_profile_dump(void *user_context);
+
+/** Reset all branch and loop counts to zero. */
+extern void halide_branch_profile_reset();
+
+/** Used by pipelines built with Target::CacheBoundsChecks. The lookup
+ * returns 1 if the size values in key are the same as the last ones
+ * stored in cache, and 0 otherwise; the store remembers them. The
+ * cache is memory owned by the pipeline. */
+// @{
+extern int halide_bounds_check_cache_lookup(void *user_context, void *cache, const int64_t *key, int size);
+extern int halide_bounds_check_cache_store(void *user_context, void *cache, const int64_t *key, int size);
+// @}
+
 /// \name "Float16" functions
 /// These functions operate of bits (``uint16_t``) representing a half
 /// precision floating point number (IEEE-754 2008 binary16).
@@ -1815,6 +2192,15 @@ extern double halide_float16_bits_to_double(uint16_t);
 
 // TODO: Conversion functions to half
 
+/** Read bits representing a bfloat16 floating point number (the top
+ * half of an IEEE single precision float) and return the float that
+ * represents the same value */
+extern float halide_bfloat16_bits_to_float(uint16_t);
+
+/** Read bits representing a bfloat16 floating point number and return
+ *  the double that represents the same value */
+extern double halide_bfloat16_bits_to_double(uint16_t);
+
 //@}
 
 #ifdef __cplusplus
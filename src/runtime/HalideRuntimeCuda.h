@@ -59,6 +59,46 @@ extern int halide_cuda_detach_device_ptr(void *user_context, struct halide_buffe
  */
 extern uintptr_t halide_cuda_get_device_ptr(void *user_context, struct halide_buffer_t *buf);
 
+/** Get the CUcontext and CUstream that Halide queues its kernels and
+ * copies on for this user_context on the calling thread. Extern
+ * stages defined with DeviceAPI::CUDA can receive the user_context
+ * (via user_context_value()) and queue their own work on this stream
+ * instead of synchronizing with the device; Halide's later work on
+ * the stream is ordered after it. */
+extern int halide_cuda_get_current_stream(void *user_context, void **context, void **stream);
+
+/** An opaque handle to a recorded sequence of kernel launches and
+ * device copies. */
+struct halide_cuda_graph_t;
+
+/** Record the device work of the Halide pipeline calls made between
+ * this and halide_cuda_end_graph_capture into a CUDA graph, which can
+ * then be replayed with far less launch overhead than calling the
+ * pipelines again. Kernels and copies are enqueued but not run while
+ * capturing. A replay repeats exactly the recorded work, with the same
+ * device pointers and scalar arguments, so the buffers used must stay
+ * alive and in place until the graph is released; in particular,
+ * halide_reuse_device_allocations should be enabled so that the
+ * pipeline's intermediate allocations aren't freed at the end of each
+ * call. Host buffers copied to or from during capture should be
+ * allocated with page-locked memory. Requires a CUDA 11.4 or later
+ * driver. Only one capture may be in progress at a time, and Halide
+ * CUDA calls from other threads are captured too, so other threads
+ * should not run CUDA pipelines while capturing. */
+extern int halide_cuda_begin_graph_capture(void *user_context);
+
+/** Finish the capture started by halide_cuda_begin_graph_capture, and
+ * instantiate the resulting graph. The graph is run once before this
+ * returns, to produce the results of the pipeline calls that were
+ * captured. */
+extern int halide_cuda_end_graph_capture(void *user_context, struct halide_cuda_graph_t **graph);
+
+/** Replay a captured graph, and wait for it to complete. */
+extern int halide_cuda_graph_launch(void *user_context, struct halide_cuda_graph_t *graph);
+
+/** Release a captured graph. */
+extern int halide_cuda_graph_release(void *user_context, struct halide_cuda_graph_t *graph);
+
 #ifdef __cplusplus
 } // End extern "C"
 #endif
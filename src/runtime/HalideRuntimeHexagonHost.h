@@ -57,6 +57,23 @@ extern int halide_hexagon_power_hvx_off(void *user_context);
 extern void halide_hexagon_power_hvx_off_as_destructor(void *user_context, void * /* obj */);
 // @}
 
+/** Queue the Hexagon pipelines called between these two calls,
+ * and run them all with a single remote call in
+ * halide_hexagon_end_batch, instead of one per pipeline. Calls to
+ * a pipeline return as soon as it is queued, so its outputs are
+ * not valid until halide_hexagon_end_batch returns, and the
+ * buffers it is called with must stay alive until then; errors are
+ * also only reported by halide_hexagon_end_batch. Because the
+ * pipelines' host-side code runs at queueing time, this is only
+ * suitable for pipelines whose work is entirely offloaded to
+ * Hexagon. Pipelines called from other threads while a batch is
+ * active are queued too. If the remote runtime doesn't support
+ * batching, pipelines run as they are called. */
+// @{
+extern int halide_hexagon_begin_batch(void *user_context);
+extern int halide_hexagon_end_batch(void *user_context);
+// @}
+
 /** Power modes for Hexagon. */
 typedef enum halide_hexagon_power_mode_t {
     halide_hexagon_power_low          = 0,
@@ -81,6 +81,27 @@ extern int halide_opencl_wrap_cl_mem(void *user_context, struct halide_buffer_t
  */
 extern int halide_opencl_detach_cl_mem(void *user_context, struct halide_buffer_t *buf);
 
+/** Import an Android AHardwareBuffer (passed as an AHardwareBuffer *) as
+ * the device memory of a halide_buffer_t, without copying it, e.g. to
+ * run a pipeline directly on camera frames. This requires the
+ * cl_arm_import_memory extension. The AHardwareBuffer must be a blob or
+ * YUV buffer whose memory is laid out as the halide_buffer_t describes;
+ * planes after the first can be reached with halide_device_crop. The
+ * dev field of the halide_buffer_t must be NULL when this routine is
+ * called. The device and host dirty bits are left unmodified.
+ *
+ * EGLImages can't be imported this way, because OpenCL imports them as
+ * images rather than buffers. To use an EGLImage in an OpenGL pipeline,
+ * bind it to a texture with glEGLImageTargetTexture2DOES and use
+ * halide_opengl_wrap_texture. */
+extern int halide_opencl_wrap_ahardwarebuffer(void *user_context, struct halide_buffer_t *buf, void *hardware_buffer);
+
+/** Disconnect a halide_buffer_t from an AHardwareBuffer previously
+ * imported with halide_opencl_wrap_ahardwarebuffer, and release the
+ * cl_mem made by the import. The AHardwareBuffer is not freed. The dev
+ * field of the halide_buffer_t will be NULL on return. */
+extern int halide_opencl_detach_ahardwarebuffer(void *user_context, struct halide_buffer_t *buf);
+
 /** Return the underlying cl_mem for a halide_buffer_t. This buffer must be
  *  valid on an OpenCL device, or not have any associated device
  *  memory. If there is no device memory (dev field is NULL), this
@@ -0,0 +1,111 @@
+#ifndef HALIDE_HALIDERUNTIMEVULKAN_H
+#define HALIDE_HALIDERUNTIMEVULKAN_H
+
+#include "HalideRuntime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+ *  Routines specific to the Halide Vulkan runtime.
+ */
+
+#define HALIDE_RUNTIME_VULKAN
+
+extern const struct halide_device_interface_t *halide_vulkan_device_interface();
+
+/** These are forward declared here to allow clients to override the
+ *  Halide Vulkan runtime. Do not call them. */
+// @{
+extern int halide_vulkan_initialize_kernels(void *user_context, void **state_ptr,
+                                            const char *src, int size);
+
+extern int halide_vulkan_run(void *user_context,
+                             void *state_ptr,
+                             const char *entry_name,
+                             int blocksX, int blocksY, int blocksZ,
+                             int threadsX, int threadsY, int threadsZ,
+                             int shared_mem_bytes,
+                             struct halide_type_t arg_types[],
+                             void *args[],
+                             int8_t arg_is_buffer[],
+                             int num_attributes,
+                             float *vertex_buffer,
+                             int num_coords_dim0,
+                             int num_coords_dim1);
+// @}
+
+/** Set the underlying VkBuffer for a halide_buffer_t. The buffer must
+ * have been created with VK_BUFFER_USAGE_STORAGE_BUFFER_BIT and both
+ * transfer usage bits, on the device returned by
+ * halide_vulkan_acquire_context, and must be large enough to cover the
+ * extent of the halide_buffer_t. The dev field of the halide_buffer_t
+ * must be NULL when this routine is called. The device and host dirty
+ * bits are left unmodified. */
+extern int halide_vulkan_wrap_vk_buffer(void *user_context, struct halide_buffer_t *buf, uint64_t vk_buffer);
+
+/** Disconnect a halide_buffer_t from the VkBuffer it was previously
+ * wrapped around. Waits for any work using the buffer to complete, but
+ * does not destroy the VkBuffer. The dev field of the halide_buffer_t
+ * will be NULL on return. */
+extern int halide_vulkan_detach_vk_buffer(void *user_context, struct halide_buffer_t *buf);
+
+/** Return the underlying VkBuffer for a halide_buffer_t, or 0 if there
+ * is no device memory. */
+extern uint64_t halide_vulkan_get_vk_buffer(void *user_context, struct halide_buffer_t *buf);
+
+/** Returns the offset associated with the Vulkan memory allocation via device_crop or device_slice. */
+extern uint64_t halide_vulkan_get_crop_offset(void *user_context, struct halide_buffer_t *buf);
+
+struct halide_vulkan_instance;
+struct halide_vulkan_physical_device;
+struct halide_vulkan_device;
+
+/** This prototype is exported as applications will typically need to
+ * replace it to get Halide filters to execute on the same device used
+ * for other purposes. The types are VkInstance, VkPhysicalDevice and
+ * VkDevice. queue_family_index is the family Halide takes its queues
+ * from, and queue_count the number of queues of that family created
+ * with the device that Halide may submit to. Halide does not take
+ * ownership of these objects. They must remain valid until all of the
+ * following are true:
+ * - A balancing halide_vulkan_release_context has occurred for each
+ *     halide_vulkan_acquire_context which returned the context
+ * - All Halide filters using the context information have completed
+ * - All halide_buffer_t objects on the device have had
+ *     halide_device_free called or have been detached via
+ *     halide_vulkan_detach_vk_buffer.
+ * - halide_device_release has been called on the interface returned from
+ *     halide_vulkan_device_interface(). (This releases the pipelines,
+ *     command pools and fences Halide made on the device.)
+ */
+extern int halide_vulkan_acquire_context(void *user_context,
+                                         struct halide_vulkan_instance **instance_ret,
+                                         struct halide_vulkan_physical_device **physical_device_ret,
+                                         struct halide_vulkan_device **device_ret,
+                                         uint32_t *queue_family_index_ret,
+                                         uint32_t *queue_count_ret,
+                                         bool create);
+
+/** This call balances each successful halide_vulkan_acquire_context call.
+ * If halide_vulkan_acquire_context is replaced, this routine must be replaced
+ * as well.
+ */
+extern int halide_vulkan_release_context(void *user_context);
+
+/** Halide calls this to choose which of the context's queues the work
+ * for a user_context is submitted to. Work on different queues can
+ * run concurrently, so pipelines running on different threads should
+ * use different queues. The default implementation hashes the
+ * user_context, so that pipelines called with distinct user_contexts
+ * spread over the queues, and calls with the same (e.g. NULL)
+ * user_context share one queue. The result is taken modulo the number
+ * of queues. */
+extern int halide_vulkan_get_queue_index(void *user_context);
+
+#ifdef __cplusplus
+} // End extern "C"
+#endif
+
+#endif // HALIDE_HALIDERUNTIMEVULKAN_H
@@ -0,0 +1,100 @@
+#ifndef HALIDE_HALIDERUNTIMEWEBGPU_H
+#define HALIDE_HALIDERUNTIMEWEBGPU_H
+
+#include "HalideRuntime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \file
+ *  Routines specific to the Halide WebGPU runtime.
+ */
+
+#define HALIDE_RUNTIME_WEBGPU
+
+extern const struct halide_device_interface_t *halide_webgpu_device_interface();
+
+/** These are forward declared here to allow clients to override the
+ *  Halide WebGPU runtime. Do not call them. */
+// @{
+extern int halide_webgpu_initialize_kernels(void *user_context, void **state_ptr,
+                                            const char *src, int size);
+
+extern int halide_webgpu_run(void *user_context,
+                             void *state_ptr,
+                             const char *entry_name,
+                             int blocksX, int blocksY, int blocksZ,
+                             int threadsX, int threadsY, int threadsZ,
+                             int shared_mem_bytes,
+                             struct halide_type_t arg_types[],
+                             void *args[],
+                             int8_t arg_is_buffer[],
+                             int num_attributes,
+                             float *vertex_buffer,
+                             int num_coords_dim0,
+                             int num_coords_dim1);
+// @}
+
+/** Set the underlying WGPUBuffer for a halide_buffer_t. The buffer must
+ * have been created with the Storage, CopySrc and CopyDst usages, on
+ * the device returned by halide_webgpu_acquire_context, and must be
+ * large enough to cover the extent of the halide_buffer_t, rounded up
+ * to a multiple of 4 bytes. The dev field of the halide_buffer_t must
+ * be NULL when this routine is called. The device and host dirty bits
+ * are left unmodified. */
+extern int halide_webgpu_wrap_native(void *user_context, struct halide_buffer_t *buf, uint64_t mem);
+
+/** Disconnect a halide_buffer_t from the WGPUBuffer it was previously
+ * wrapped around. Does not release the WGPUBuffer. The dev field of the
+ * halide_buffer_t will be NULL on return. */
+extern int halide_webgpu_detach_native(void *user_context, struct halide_buffer_t *buf);
+
+/** Return the underlying WGPUBuffer for a halide_buffer_t, or 0 if
+ * there is no device memory. */
+extern uint64_t halide_webgpu_get_native_buffer(void *user_context, struct halide_buffer_t *buf);
+
+/** Returns the offset associated with the WebGPU buffer via device_crop or device_slice. */
+extern uint64_t halide_webgpu_get_crop_offset(void *user_context, struct halide_buffer_t *buf);
+
+struct halide_webgpu_instance;
+struct halide_webgpu_device;
+
+/** This prototype is exported as applications will typically need to
+ * replace it to get Halide filters to execute on the same device used
+ * for other purposes, e.g. rendering. The types are WGPUInstance and
+ * WGPUDevice. The instance may be NULL in the browser, where the
+ * device's events are processed by the JavaScript event loop; a native
+ * application that passes a NULL instance must process the device's
+ * events from another thread. Halide does not take ownership of these
+ * objects. They must remain valid until all of the following are true:
+ * - A balancing halide_webgpu_release_context has occurred for each
+ *     halide_webgpu_acquire_context which returned the context
+ * - All Halide filters using the context information have completed
+ * - All halide_buffer_t objects on the device have had
+ *     halide_device_free called or have been detached via
+ *     halide_webgpu_detach_native.
+ * - halide_device_release has been called on the interface returned from
+ *     halide_webgpu_device_interface(). (This releases the pipelines and
+ *     buffers Halide made on the device.)
+ *
+ * The default implementation in the browser uses the device
+ * JavaScript placed in Module.preinitializedWebGPUDevice, as returned
+ * by emscripten_webgpu_get_device().
+ */
+extern int halide_webgpu_acquire_context(void *user_context,
+                                         struct halide_webgpu_instance **instance_ret,
+                                         struct halide_webgpu_device **device_ret,
+                                         bool create);
+
+/** This call balances each successful halide_webgpu_acquire_context call.
+ * If halide_webgpu_acquire_context is replaced, this routine must be replaced
+ * as well.
+ */
+extern int halide_webgpu_release_context(void *user_context);
+
+#ifdef __cplusplus
+} // End extern "C"
+#endif
+
+#endif // HALIDE_HALIDERUNTIMEWEBGPU_H
@@ -0,0 +1,46 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+// The last set of buffer shapes and scalar parameters that passed the
+// argument checks of a pipeline built with Target::CacheBoundsChecks.
+// The compiler gives each pipeline a zero-initialized block of memory
+// of this layout, with room for the number of key values it uses.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+struct bounds_check_cache {
+    halide_mutex mutex;
+    int64_t valid;
+    int64_t key[1];
+};
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_bounds_check_cache_lookup(void *user_context, void *cache, const int64_t *key, int size) {
+    bounds_check_cache *c = (bounds_check_cache *)cache;
+    ScopedMutexLock lock(&c->mutex);
+    if (!c->valid) {
+        return 0;
+    }
+    for (int i = 0; i < size; i++) {
+        if (c->key[i] != key[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+WEAK int halide_bounds_check_cache_store(void *user_context, void *cache, const int64_t *key, int size) {
+    bounds_check_cache *c = (bounds_check_cache *)cache;
+    ScopedMutexLock lock(&c->mutex);
+    memcpy(c->key, key, size * sizeof(int64_t));
+    c->valid = 1;
+    return 0;
+}
+
+}
@@ -0,0 +1,123 @@
+#include "HalideRuntime.h"
+#include "printer.h"
+#include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+// Counters for Target::ProfileBranches. Each instrumented function
+// registers itself on entry, and gets a pair of counters for each of
+// its sites: for a branch, the number of times it was and wasn't taken;
+// for a loop, the number of times it was entered and the total number
+// of iterations. The counts are written out in a form that the
+// compiler reads back from HL_BRANCH_PROFILE when the pipeline is next
+// compiled without the feature.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+struct branch_profile_func {
+    branch_profile_func *next;
+    char *name;
+    int num_sites;
+    uint64_t *counters;
+};
+
+WEAK branch_profile_func *branch_profile_funcs = NULL;
+WEAK halide_mutex branch_profile_mutex;
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK uint64_t *halide_branch_profile_register(void *user_context, const char *name, int num_sites) {
+    ScopedMutexLock lock(&branch_profile_mutex);
+
+    for (branch_profile_func *f = branch_profile_funcs; f; f = f->next) {
+        if (f->num_sites == num_sites && strcmp(f->name, name) == 0) {
+            return f->counters;
+        }
+    }
+
+    // The name and counters outlive the code that registers them,
+    // which may be unloaded before the counts are written out.
+    size_t name_size = strlen(name) + 1;
+    size_t counters_size = 2 * (size_t)num_sites * sizeof(uint64_t);
+    branch_profile_func *f = (branch_profile_func *)malloc(sizeof(branch_profile_func));
+    char *name_copy = (char *)malloc(name_size);
+    uint64_t *counters = (uint64_t *)malloc(counters_size);
+    halide_assert(user_context, f && name_copy && counters);
+    memcpy(name_copy, name, name_size);
+    memset(counters, 0, counters_size);
+
+    f->name = name_copy;
+    f->num_sites = num_sites;
+    f->counters = counters;
+    f->next = branch_profile_funcs;
+    branch_profile_funcs = f;
+    return counters;
+}
+
+WEAK int halide_branch_profile_dump(void *user_context) {
+    ScopedMutexLock lock(&branch_profile_mutex);
+
+    const char *path = getenv("HL_BRANCH_PROFILE");
+    void *file = NULL;
+    if (path) {
+        file = fopen(path, "w");
+        if (!file) {
+            error(user_context) << "Could not open branch profile " << path << " for writing\n";
+            return halide_error_code_generic_error;
+        }
+    }
+
+    stringstream line(user_context);
+    for (branch_profile_func *f = branch_profile_funcs; f; f = f->next) {
+        for (int i = 0; i < f->num_sites; i++) {
+            line.clear();
+            line << f->name << " " << i << " "
+                 << f->counters[2 * i] << " " << f->counters[2 * i + 1] << "\n";
+            if (file) {
+                fwrite(line.str(), line.size(), 1, file);
+            } else {
+                halide_print(user_context, line.str());
+            }
+        }
+    }
+
+    if (file) {
+        fclose(file);
+    }
+    return 0;
+}
+
+WEAK void halide_branch_profile_reset() {
+    ScopedMutexLock lock(&branch_profile_mutex);
+    for (branch_profile_func *f = branch_profile_funcs; f; f = f->next) {
+        memset(f->counters, 0, 2 * (size_t)f->num_sites * sizeof(uint64_t));
+    }
+}
+
+namespace {
+
+__attribute__((destructor))
+WEAK void halide_branch_profile_shutdown() {
+    if (!branch_profile_funcs) {
+        return;
+    }
+    halide_branch_profile_dump(NULL);
+
+    ScopedMutexLock lock(&branch_profile_mutex);
+    branch_profile_func *f = branch_profile_funcs;
+    while (f) {
+        branch_profile_func *next = f->next;
+        free(f->name);
+        free(f->counters);
+        free(f);
+        f = next;
+    }
+    branch_profile_funcs = NULL;
+}
+
+}  // namespace
+
+}
@@ -65,6 +65,8 @@ WEAK bool buffer_has_shape(const halide_buffer_t *buf, const halide_dimension_t
     return true;
 }
 
+struct CacheBudget;
+
 struct CacheEntry {
     CacheEntry *next;
     CacheEntry *more_recent;
@@ -80,6 +82,15 @@ struct CacheEntry {
     halide_dimension_t *computed_bounds;
     // The actual stored data.
     halide_buffer_t *buf;
+    // The per-pipeline budget this entry is charged to, if any.
+    CacheBudget *budget;
+    // The time taken to compute the data, and the total size of its
+    // buffers.
+    int64_t compute_time_ns;
+    int64_t size_in_bytes;
+    // The GreedyDual-Size priority, the lowest of which is evicted
+    // first. See prune_shard.
+    double priority;
 
     bool init(const uint8_t *cache_key, size_t cache_key_size,
               uint32_t key_hash,
@@ -93,13 +104,16 @@ struct CacheEntry {
 struct CacheBlockHeader {
     CacheEntry *entry;
     uint32_t hash;
+    // When the lookup that allocated the block missed, to time the
+    // computation of its contents.
+    int64_t miss_time_ns;
 };
 
 // Each host block has extra space to store a header just before the
 // contents. This block must respect the same alignment as
 // halide_malloc, because it offsets the return value from
-// halide_malloc. The header holds the cache key hash and pointer to
-// the hash entry.
+// halide_malloc. The header holds the cache key hash, pointer to the
+// hash entry, and the time of the miss.
 WEAK __attribute((always_inline)) size_t header_bytes() {
     size_t s = sizeof(CacheBlockHeader);
     size_t mask = halide_malloc_alignment() - 1;
@@ -121,6 +135,10 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
     in_use_count = 0;
     tuple_count = tuples;
     dimensions = computed_bounds_buf->dimensions;
+    budget = NULL;
+    compute_time_ns = 0;
+    size_in_bytes = 0;
+    priority = 0;
 
     // Allocate all the necessary space (or die)
     size_t storage_bytes = 0;
@@ -165,6 +183,7 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
         for (int j = 0; j < dimensions; j++) {
             buf[i].dim[j] = tuple_buffers[i]->dim[j];
         }
+        size_in_bytes += buf[i].size_in_bytes();
     }
     return true;
 }
@@ -177,42 +196,432 @@ WEAK void CacheEntry::destroy() {
     halide_free(NULL, metadata_storage);
 }
 
-WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size)  {
-    uint32_t h = 5381;
+// FNV-1a, followed by the murmur3 finalizer so that the high bits
+// (which select the shard) depend on all of the key.
+WEAK uint32_t cache_hash(const uint8_t *key, size_t key_size) {
+    uint32_t h = 2166136261u;
     for (size_t i = 0; i < key_size; i++) {
-        h = (h << 5) + h + key[i];
+        h ^= key[i];
+        h *= 16777619u;
     }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
     return h;
 }
 
-WEAK halide_mutex memoization_lock = { { 0 } };
+// The cache is split into shards, each with its own lock, hash table
+// and LRU list, so that concurrent lookups of different keys rarely
+// contend. The size limit is global, and is enforced by pruning the
+// shards one at a time, so the eviction order is only approximately
+// LRU across shards.
+const size_t kCacheShards = 16;
+const size_t kShardHashTableSize = 64;
+
+struct CacheShard {
+    halide_mutex lock;
+    CacheEntry *entries[kShardHashTableSize];
+    CacheEntry *most_recently_used;
+    CacheEntry *least_recently_used;
+    // The priority of the last entry evicted from this shard, which
+    // ages the priorities of the entries that remain.
+    double inflation;
+};
 
-const size_t kHashTableSize = 256;
+WEAK CacheShard cache_shards[kCacheShards];
 
-WEAK CacheEntry *cache_entries[kHashTableSize];
+WEAK __attribute((always_inline)) uint32_t shard_index(uint32_t hash) {
+    return hash >> 28;
+}
 
-WEAK CacheEntry *most_recently_used = NULL;
-WEAK CacheEntry *least_recently_used = NULL;
+WEAK __attribute((always_inline)) uint32_t bucket_index(uint32_t hash) {
+    return hash % kShardHashTableSize;
+}
 
 const uint64_t kDefaultCacheSize = 1 << 20;
 WEAK int64_t max_cache_size = kDefaultCacheSize;
+// Only accessed atomically.
 WEAK int64_t current_cache_size = 0;
 
+// A soft limit on the memory used by entries from one pipeline, so
+// that a hot pipeline can't evict everything else. Pipelines are
+// identified by the top-level name at the start of the cache key.
+struct CacheBudget {
+    uint32_t name_hash;
+    size_t name_size;
+    // Zero means no limit.
+    int64_t max_size;
+    // Only accessed atomically.
+    int64_t current_size;
+};
+
+const size_t kMaxCacheBudgets = 64;
+
+// Budgets are never removed once added, because cache entries point
+// to them. Setting a budget of zero removes the limit.
+WEAK CacheBudget cache_budgets[kMaxCacheBudgets];
+WEAK int num_cache_budgets = 0;
+WEAK halide_mutex cache_budgets_lock = { { 0 } };
+
+WEAK __attribute((always_inline)) int64_t atomic_add_size(int64_t *size, int64_t delta) {
+    return __atomic_add_fetch(size, delta, __ATOMIC_SEQ_CST);
+}
+
+WEAK __attribute((always_inline)) int64_t atomic_load_size(int64_t *size) {
+    return __atomic_load_n(size, __ATOMIC_SEQ_CST);
+}
+
+// Counters for halide_memoization_cache_get_stats. Only accessed
+// atomically.
+WEAK uint64_t cache_hits = 0;
+WEAK uint64_t cache_persistent_hits = 0;
+WEAK uint64_t cache_misses = 0;
+WEAK uint64_t cache_evictions = 0;
+WEAK uint64_t cache_evicted_bytes = 0;
+WEAK int64_t cache_entries = 0;
+
+WEAK __attribute((always_inline)) void atomic_count(uint64_t *counter, uint64_t delta) {
+    __atomic_add_fetch(counter, delta, __ATOMIC_RELAXED);
+}
+
+WEAK halide_memoization_cache_eviction_handler_t cache_eviction_handler = NULL;
+
+// The clock used to time the computation of memoized results. Some
+// clocks must be started before they can be read.
+WEAK int64_t cache_time_ns(void *user_context) {
+    halide_start_clock(user_context);
+    return halide_current_time_ns(user_context);
+}
+
+WEAK bool over_limit(CacheBudget *budget) {
+    if (budget) {
+        return budget->max_size > 0 &&
+            atomic_load_size(&budget->current_size) > budget->max_size;
+    } else {
+        return atomic_load_size(&current_cache_size) > max_cache_size;
+    }
+}
+
+// Must be called with cache_budgets_lock held.
+WEAK CacheBudget *find_budget(uint32_t name_hash, size_t name_size) {
+    for (int i = 0; i < num_cache_budgets; i++) {
+        if (cache_budgets[i].name_hash == name_hash &&
+            cache_budgets[i].name_size == name_size) {
+            return &cache_budgets[i];
+        }
+    }
+    return NULL;
+}
+
+// Cache keys start with a pointer to a string of the form
+// "<length>:<top-level name><length>:<function name>", in the space
+// of a Handle.
+const size_t kKeyNameBytes = 8;
+
+WEAK const char *key_name(const uint8_t *cache_key, size_t key_size) {
+    if (key_size < kKeyNameBytes) {
+        return NULL;
+    }
+    const char *name;
+    memcpy(&name, cache_key, sizeof(name));
+    return name;
+}
+
+// Find the budget for the pipeline that a cache key belongs to, which
+// is identified by the top-level name.
+WEAK CacheBudget *budget_for_key(const uint8_t *cache_key, size_t key_size) {
+    if (num_cache_budgets == 0) {
+        return NULL;
+    }
+    const char *name = key_name(cache_key, key_size);
+    if (name == NULL) {
+        return NULL;
+    }
+    size_t name_size = 0, i = 0;
+    while (name[i] >= '0' && name[i] <= '9') {
+        name_size = name_size * 10 + (name[i] - '0');
+        i++;
+    }
+    if (i == 0 || name[i] != ':' || name_size > strlen(name + i + 1)) {
+        return NULL;
+    }
+    uint32_t name_hash = cache_hash((const uint8_t *)name + i + 1, name_size);
+    ScopedMutexLock lock(&cache_budgets_lock);
+    return find_budget(name_hash, name_size);
+}
+
+// An optional second level of the cache, in a file mapped into every
+// process that uses the same path, so that memoized results survive
+// restarts and are shared between the processes on a host. Entries
+// are keyed on the contents of the cache key, with the name pointer
+// at its start replaced by the name itself, so each process
+// compiling the same pipeline produces the same keys. (The key also
+// includes a per-process count of the pipelines lowered with
+// memoization, so JIT-compiled pipelines only share entries with
+// processes that compile the same pipelines in the same order.)
+//
+// Entries are only ever added, once per key: the store fills up, and
+// is reset by deleting the file. Lookups take no lock. Adding an entry
+// takes the lock on the file, writes the entry, and then publishes it
+// by writing the hash of its slot last.
+struct PersistentStoreHeader {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t num_slots;
+    // The bytes of the data region in use. Only changed with the file
+    // lock held.
+    uint64_t data_used;
+};
+
+struct PersistentSlot {
+    // Zero while the slot is empty. Accessed atomically.
+    uint64_t hash;
+    uint64_t offset;
+};
+
+// Each entry in the data region is this, then the key, the computed
+// bounds, and the type, shape, and contents of each tuple buffer,
+// each padded to a multiple of 8 bytes.
+struct PersistentRecord {
+    uint32_t key_size;
+    int32_t dimensions;
+    int32_t tuple_count;
+    uint32_t padding;
+};
+
+const uint64_t kPersistentStoreMagic = 0x3130656863614348ULL;  // "HCache01"
+const uint64_t kPersistentBytesPerSlot = 16 * 1024;
+
+struct PersistentStore {
+    uint8_t *base;
+    size_t size;
+    int fd;
+};
+
+// base is accessed atomically. The lock serializes setting up and
+// tearing down the store.
+WEAK PersistentStore persistent_store = { NULL, 0, -1 };
+WEAK halide_mutex persistent_store_lock = { { 0 } };
+
+WEAK __attribute((always_inline)) uint64_t align_to_8(uint64_t x) {
+    return (x + 7) & ~(uint64_t)7;
+}
+
+WEAK __attribute((always_inline)) uint64_t persistent_data_start(uint64_t num_slots) {
+    return align_to_8(sizeof(PersistentStoreHeader) + num_slots * sizeof(PersistentSlot));
+}
+
+// The key of a cache entry in the persistent store, in two pieces.
+struct PersistentKey {
+    const char *name;
+    size_t name_size;
+    const uint8_t *rest;
+    size_t rest_size;
+    uint64_t hash;
+
+    bool init(const uint8_t *cache_key, size_t key_size) {
+        name = key_name(cache_key, key_size);
+        if (name == NULL) {
+            return false;
+        }
+        name_size = strlen(name);
+        rest = cache_key + kKeyNameBytes;
+        rest_size = key_size - kKeyNameBytes;
+
+        // 64-bit FNV-1a, as keys from many processes share the table.
+        hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < name_size; i++) {
+            hash = (hash ^ (uint8_t)name[i]) * 1099511628211ULL;
+        }
+        for (size_t i = 0; i < rest_size; i++) {
+            hash = (hash ^ rest[i]) * 1099511628211ULL;
+        }
+        if (hash == 0) {
+            hash = 1;
+        }
+        return true;
+    }
+
+    bool matches(const uint8_t *record) const {
+        const PersistentRecord *r = (const PersistentRecord *)record;
+        const uint8_t *key = record + sizeof(PersistentRecord);
+        return r->key_size == name_size + rest_size &&
+            memcmp(key, name, name_size) == 0 &&
+            memcmp(key + name_size, rest, rest_size) == 0;
+    }
+};
+
+// The size of the record for an entry, or zero if the entry can't be
+// saved, because its host data is stale or not laid out in order.
+WEAK uint64_t persistent_record_size(const PersistentKey &key, int32_t dimensions,
+                                     int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    uint64_t size = sizeof(PersistentRecord) + align_to_8(key.name_size + key.rest_size);
+    size += sizeof(halide_dimension_t) * dimensions;
+    for (int32_t i = 0; i < tuple_count; i++) {
+        const halide_buffer_t *buf = tuple_buffers[i];
+        if (buf->host == NULL || buf->device_dirty()) {
+            return 0;
+        }
+        for (int j = 0; j < buf->dimensions; j++) {
+            if (buf->dim[j].stride < 0) {
+                return 0;
+            }
+        }
+        size += align_to_8(sizeof(halide_type_t)) + sizeof(halide_dimension_t) * dimensions;
+        size += align_to_8(buf->size_in_bytes());
+    }
+    return size;
+}
+
+// Fill in the tuple buffers from the persistent store, if it has an
+// entry with the same key and shapes.
+WEAK bool persistent_lookup(const uint8_t *cache_key, int32_t size, const halide_buffer_t *computed_bounds,
+                            int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    uint8_t *base = __atomic_load_n(&persistent_store.base, __ATOMIC_ACQUIRE);
+    PersistentKey key;
+    if (base == NULL || !key.init(cache_key, size)) {
+        return false;
+    }
+
+    const PersistentStoreHeader *header = (const PersistentStoreHeader *)base;
+    PersistentSlot *slots = (PersistentSlot *)(base + sizeof(PersistentStoreHeader));
+    const uint8_t *record = NULL;
+    for (uint64_t i = 0; i < header->num_slots; i++) {
+        PersistentSlot &slot = slots[(key.hash + i) % header->num_slots];
+        uint64_t slot_hash = __atomic_load_n(&slot.hash, __ATOMIC_ACQUIRE);
+        if (slot_hash == 0) {
+            return false;
+        }
+        if (slot_hash == key.hash && key.matches(base + slot.offset)) {
+            record = base + slot.offset;
+            break;
+        }
+    }
+    if (record == NULL) {
+        return false;
+    }
+
+    const PersistentRecord *r = (const PersistentRecord *)record;
+    int32_t dimensions = computed_bounds->dimensions;
+    if (r->dimensions != dimensions || r->tuple_count != tuple_count) {
+        return false;
+    }
+    const uint8_t *ptr = record + sizeof(PersistentRecord) + align_to_8(r->key_size);
+    if (!buffer_has_shape(computed_bounds, (const halide_dimension_t *)ptr)) {
+        return false;
+    }
+    ptr += sizeof(halide_dimension_t) * dimensions;
+
+    // Check all of the tuple buffers before copying any of them.
+    const uint8_t *tuples = ptr;
+    for (int32_t i = 0; i < tuple_count; i++) {
+        const halide_buffer_t *buf = tuple_buffers[i];
+        if (memcmp(ptr, &buf->type, sizeof(halide_type_t)) != 0) {
+            return false;
+        }
+        ptr += align_to_8(sizeof(halide_type_t));
+        if (!buffer_has_shape(buf, (const halide_dimension_t *)ptr)) {
+            return false;
+        }
+        ptr += sizeof(halide_dimension_t) * dimensions + align_to_8(buf->size_in_bytes());
+    }
+    ptr = tuples;
+    for (int32_t i = 0; i < tuple_count; i++) {
+        halide_buffer_t *buf = tuple_buffers[i];
+        ptr += align_to_8(sizeof(halide_type_t)) + sizeof(halide_dimension_t) * dimensions;
+        memcpy(buf->host, ptr, buf->size_in_bytes());
+        ptr += align_to_8(buf->size_in_bytes());
+    }
+    return true;
+}
+
+// Add an entry to the persistent store, unless it already has one
+// with the same key, or is full.
+WEAK void persistent_add(const uint8_t *cache_key, int32_t size, const halide_buffer_t *computed_bounds,
+                         int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    uint8_t *base = __atomic_load_n(&persistent_store.base, __ATOMIC_ACQUIRE);
+    PersistentKey key;
+    if (base == NULL || !key.init(cache_key, size)) {
+        return;
+    }
+    int32_t dimensions = computed_bounds->dimensions;
+    uint64_t record_size = persistent_record_size(key, dimensions, tuple_count, tuple_buffers);
+    if (record_size == 0) {
+        return;
+    }
+
+    PersistentStoreHeader *header = (PersistentStoreHeader *)base;
+    PersistentSlot *slots = (PersistentSlot *)(base + sizeof(PersistentStoreHeader));
+    halide_shared_file_lock(persistent_store.fd);
+
+    // Other writers are locked out, so the first empty slot along the
+    // probe sequence stays empty until it is published below.
+    PersistentSlot *slot = NULL;
+    for (uint64_t i = 0; i < header->num_slots; i++) {
+        PersistentSlot &s = slots[(key.hash + i) % header->num_slots];
+        uint64_t slot_hash = __atomic_load_n(&s.hash, __ATOMIC_ACQUIRE);
+        if (slot_hash == 0) {
+            slot = &s;
+            break;
+        }
+        if (slot_hash == key.hash && key.matches(base + s.offset)) {
+            break;
+        }
+    }
+    uint64_t data_start = persistent_data_start(header->num_slots);
+    if (slot == NULL || header->data_used + record_size > header->capacity - data_start) {
+        halide_shared_file_unlock(persistent_store.fd);
+        return;
+    }
+
+    uint64_t offset = data_start + header->data_used;
+    uint8_t *ptr = base + offset;
+    PersistentRecord *r = (PersistentRecord *)ptr;
+    r->key_size = key.name_size + key.rest_size;
+    r->dimensions = dimensions;
+    r->tuple_count = tuple_count;
+    r->padding = 0;
+    ptr += sizeof(PersistentRecord);
+    memcpy(ptr, key.name, key.name_size);
+    memcpy(ptr + key.name_size, key.rest, key.rest_size);
+    ptr += align_to_8(r->key_size);
+    memcpy(ptr, computed_bounds->dim, sizeof(halide_dimension_t) * dimensions);
+    ptr += sizeof(halide_dimension_t) * dimensions;
+    for (int32_t i = 0; i < tuple_count; i++) {
+        const halide_buffer_t *buf = tuple_buffers[i];
+        memcpy(ptr, &buf->type, sizeof(halide_type_t));
+        ptr += align_to_8(sizeof(halide_type_t));
+        memcpy(ptr, buf->dim, sizeof(halide_dimension_t) * dimensions);
+        ptr += sizeof(halide_dimension_t) * dimensions;
+        memcpy(ptr, buf->host, buf->size_in_bytes());
+        ptr += align_to_8(buf->size_in_bytes());
+    }
+    header->data_used += record_size;
+
+    slot->offset = offset;
+    __atomic_store_n(&slot->hash, key.hash, __ATOMIC_RELEASE);
+
+    halide_shared_file_unlock(persistent_store.fd);
+}
+
 #if CACHE_DEBUGGING
-WEAK void validate_cache() {
-    print(NULL) << "validating cache, "
-                << "current size " << current_cache_size
+// Must be called with the shard lock held.
+WEAK void validate_shard(CacheShard &shard) {
+    print(NULL) << "validating cache shard " << (int)(&shard - cache_shards) << ", "
+                << "current size " << atomic_load_size(&current_cache_size)
                 << " of maximum " << max_cache_size << "\n";
     int entries_in_hash_table = 0;
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
+    for (size_t i = 0; i < kShardHashTableSize; i++) {
+        CacheEntry *entry = shard.entries[i];
         while (entry != NULL) {
             entries_in_hash_table++;
-            if (entry->more_recent == NULL && entry != most_recently_used) {
+            if (entry->more_recent == NULL && entry != shard.most_recently_used) {
                 halide_print(NULL, "cache invalid case 1\n");
                 __builtin_trap();
             }
-            if (entry->less_recent == NULL && entry != least_recently_used) {
+            if (entry->less_recent == NULL && entry != shard.least_recently_used) {
                 halide_print(NULL, "cache invalid case 2\n");
                 __builtin_trap();
             }
@@ -220,13 +629,13 @@ WEAK void validate_cache() {
         }
     }
     int entries_from_mru = 0;
-    CacheEntry *mru_chain = most_recently_used;
+    CacheEntry *mru_chain = shard.most_recently_used;
     while (mru_chain != NULL) {
         entries_from_mru++;
         mru_chain = mru_chain->less_recent;
     }
     int entries_from_lru = 0;
-    CacheEntry *lru_chain = least_recently_used;
+    CacheEntry *lru_chain = shard.least_recently_used;
     while (lru_chain != NULL) {
         entries_from_lru++;
         lru_chain = lru_chain->more_recent;
@@ -242,92 +651,132 @@ WEAK void validate_cache() {
         halide_print(NULL, "cache invalid case 4\n");
         __builtin_trap();
     }
-    if (current_cache_size < 0) {
+    if (atomic_load_size(&current_cache_size) < 0) {
         halide_print(NULL, "cache size is negative\n");
         __builtin_trap();
     }
 }
 #endif
 
-WEAK void prune_cache() {
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-    CacheEntry *prune_candidate = least_recently_used;
-    while (current_cache_size > max_cache_size &&
-           prune_candidate != NULL) {
-        CacheEntry *more_recent = prune_candidate->more_recent;
-
-        if (prune_candidate->in_use_count == 0) {
-            uint32_t h = prune_candidate->hash;
-            uint32_t index = h % kHashTableSize;
-
-            // Remove from hash table
-            CacheEntry *prev_hash_entry = cache_entries[index];
-            if (prev_hash_entry == prune_candidate) {
-                cache_entries[index] = prune_candidate->next;
-            } else {
-                while (prev_hash_entry != NULL && prev_hash_entry->next != prune_candidate) {
-                    prev_hash_entry = prev_hash_entry->next;
-                }
-                halide_assert(NULL, prev_hash_entry != NULL);
-                prev_hash_entry->next = prune_candidate->next;
-            }
+// Remove an entry from a shard's hash table and LRU list, and free
+// it. Must be called with the shard lock held.
+WEAK void evict_entry(CacheShard &shard, CacheEntry *entry) {
+    uint32_t index = bucket_index(entry->hash);
 
-            // Remove from less recent chain.
-            if (least_recently_used == prune_candidate) {
-                least_recently_used = more_recent;
-            }
-            if (more_recent != NULL) {
-                more_recent->less_recent = prune_candidate->less_recent;
-            }
+    // Remove from hash table
+    CacheEntry *prev_hash_entry = shard.entries[index];
+    if (prev_hash_entry == entry) {
+        shard.entries[index] = entry->next;
+    } else {
+        while (prev_hash_entry != NULL && prev_hash_entry->next != entry) {
+            prev_hash_entry = prev_hash_entry->next;
+        }
+        halide_assert(NULL, prev_hash_entry != NULL);
+        prev_hash_entry->next = entry->next;
+    }
 
-            // Remove from more recent chain.
-            if (most_recently_used == prune_candidate) {
-                most_recently_used = prune_candidate->less_recent;
-            }
-            if (prune_candidate->less_recent != NULL) {
-                prune_candidate->less_recent = more_recent;
-            }
+    // Remove from less recent chain.
+    if (shard.least_recently_used == entry) {
+        shard.least_recently_used = entry->more_recent;
+    }
+    if (entry->more_recent != NULL) {
+        entry->more_recent->less_recent = entry->less_recent;
+    }
 
-            // Decrease cache used amount.
-            for (uint32_t i = 0; i < prune_candidate->tuple_count; i++) {
-                current_cache_size -= prune_candidate->buf[i].size_in_bytes();
-            }
+    // Remove from more recent chain.
+    if (shard.most_recently_used == entry) {
+        shard.most_recently_used = entry->less_recent;
+    }
+    if (entry->less_recent != NULL) {
+        entry->less_recent->more_recent = entry->more_recent;
+    }
 
-            // Deallocate the entry.
-            prune_candidate->destroy();
-            halide_free(NULL, prune_candidate);
-        }
+    // Decrease cache used amount.
+    int64_t entry_size = entry->size_in_bytes;
+    atomic_add_size(&current_cache_size, -entry_size);
+    if (entry->budget) {
+        atomic_add_size(&entry->budget->current_size, -entry_size);
+    }
+    atomic_add_size(&cache_entries, -1);
+    atomic_count(&cache_evictions, 1);
+    atomic_count(&cache_evicted_bytes, entry_size);
+
+    halide_memoization_cache_eviction_handler_t handler =
+        __atomic_load_n(&cache_eviction_handler, __ATOMIC_ACQUIRE);
+    if (handler) {
+        handler(NULL, entry->key, (int32_t)entry->key_size, entry_size, entry->compute_time_ns);
+    }
 
-        prune_candidate = more_recent;
+    // Deallocate the entry.
+    entry->destroy();
+    halide_free(NULL, entry);
+}
+
+// Entries are evicted in GreedyDual-Size order: each entry's
+// priority is set to the shard's inflation plus its compute time per
+// byte when it is added or used, the entry with the lowest priority
+// is evicted first, and its priority becomes the new inflation. So
+// results that are cheap to recompute for the memory they use are
+// evicted first, but an expensive result that goes unused is
+// eventually evicted too, as the inflation overtakes it. Entries with
+// equal costs are evicted in LRU order.
+WEAK void update_priority(CacheShard &shard, CacheEntry *entry) {
+    double bytes = entry->size_in_bytes > 0 ? (double)entry->size_in_bytes : 1.0;
+    entry->priority = shard.inflation + (double)entry->compute_time_ns / bytes;
+}
+
+// Evict unused entries from one shard, lowest priority first, until
+// the cache as a whole (or the given budget, if not NULL) is within
+// its limit. Must be called with the shard lock held.
+WEAK void prune_shard(CacheShard &shard, CacheBudget *budget) {
+#if CACHE_DEBUGGING
+    validate_shard(shard);
+#endif
+    while (over_limit(budget)) {
+        // Find the unused entry with the lowest priority, preferring
+        // the least recently used on ties.
+        CacheEntry *victim = NULL;
+        for (CacheEntry *candidate = shard.least_recently_used;
+             candidate != NULL; candidate = candidate->more_recent) {
+            if (candidate->in_use_count == 0 &&
+                (budget == NULL || candidate->budget == budget) &&
+                (victim == NULL || candidate->priority < victim->priority)) {
+                victim = candidate;
+            }
+        }
+        if (victim == NULL) {
+            break;
+        }
+        if (victim->priority > shard.inflation) {
+            shard.inflation = victim->priority;
+        }
+        evict_entry(shard, victim);
     }
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_shard(shard);
 #endif
 }
 
-}}} // namespace Halide::Runtime::Internal
-
-extern "C" {
-
-WEAK void halide_memoization_cache_set_size(int64_t size) {
-    if (size == 0) {
-        size = kDefaultCacheSize;
+// Prune shards one at a time, starting with the given one, until the
+// cache (or the given budget) is within its limit. Must be called
+// with no shard locks held.
+WEAK void prune_cache(uint32_t first_shard, CacheBudget *budget) {
+    for (size_t i = 0; i < kCacheShards && over_limit(budget); i++) {
+        CacheShard &shard = cache_shards[(first_shard + i) % kCacheShards];
+        ScopedMutexLock lock(&shard.lock);
+        prune_shard(shard, budget);
     }
-
-    ScopedMutexLock lock(&memoization_lock);
-
-    max_cache_size = size;
-    prune_cache();
 }
 
-WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
-                                         halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
-    uint32_t h = djb_hash(cache_key, size);
-    uint32_t index = h % kHashTableSize;
+// Look up an entry in the in-memory cache. On a miss, this allocates
+// the tuple buffers for the caller to compute into.
+WEAK int memory_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
+                             halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    uint32_t h = cache_hash(cache_key, size);
+    CacheShard &shard = cache_shards[shard_index(h)];
+    uint32_t index = bucket_index(h);
 
-    ScopedMutexLock lock(&memoization_lock);
+    ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
     debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
@@ -342,7 +791,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
     }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
+    CacheEntry *entry = shard.entries[index];
     while (entry != NULL) {
         if (entry->hash == h && entry->key_size == (size_t)size &&
             keys_equal(entry->key, cache_key, size) &&
@@ -356,23 +805,23 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
             }
 
             if (all_bounds_equal) {
-                if (entry != most_recently_used) {
+                if (entry != shard.most_recently_used) {
                     halide_assert(user_context, entry->more_recent != NULL);
                     if (entry->less_recent != NULL) {
                         entry->less_recent->more_recent = entry->more_recent;
                     } else {
-                        halide_assert(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
+                        halide_assert(user_context, shard.least_recently_used == entry);
+                        shard.least_recently_used = entry->more_recent;
                     }
                     halide_assert(user_context, entry->more_recent != NULL);
                     entry->more_recent->less_recent = entry->less_recent;
 
                     entry->more_recent = NULL;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != NULL) {
-                        most_recently_used->more_recent = entry;
+                    entry->less_recent = shard.most_recently_used;
+                    if (shard.most_recently_used != NULL) {
+                        shard.most_recently_used->more_recent = entry;
                     }
-                    most_recently_used = entry;
+                    shard.most_recently_used = entry;
                 }
 
                 for (int32_t i = 0; i < tuple_count; i++) {
@@ -381,6 +830,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
                 }
 
                 entry->in_use_count += tuple_count;
+                update_priority(shard, entry);
 
                 return 0;
             }
@@ -388,6 +838,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         entry = entry->next;
     }
 
+    int64_t miss_time_ns = cache_time_ns(user_context);
     for (int32_t i = 0; i < tuple_count; i++) {
         halide_buffer_t *buf = tuple_buffers[i];
 
@@ -403,121 +854,268 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         CacheBlockHeader *header = get_pointer_to_header(buf->host);
         header->hash = h;
         header->entry = NULL;
+        header->miss_time_ns = miss_time_ns;
     }
 
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_shard(shard);
 #endif
 
     return 1;
 }
 
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK void halide_memoization_cache_set_size(int64_t size) {
+    if (size == 0) {
+        size = kDefaultCacheSize;
+    }
+
+    max_cache_size = size;
+    prune_cache(0, NULL);
+}
+
+WEAK int halide_memoization_cache_set_pipeline_budget(void *user_context, const char *pipeline_name, int64_t size) {
+    size_t name_size = strlen(pipeline_name);
+    uint32_t name_hash = cache_hash((const uint8_t *)pipeline_name, name_size);
+    CacheBudget *budget = NULL;
+    {
+        ScopedMutexLock lock(&cache_budgets_lock);
+        budget = find_budget(name_hash, name_size);
+        if (budget == NULL) {
+            if (size == 0) {
+                // Nothing to remove.
+                return 0;
+            }
+            if (num_cache_budgets == (int)kMaxCacheBudgets) {
+                error(user_context) << "halide_memoization_cache_set_pipeline_budget: too many pipeline budgets.\n";
+                return -1;
+            }
+            budget = &cache_budgets[num_cache_budgets];
+            budget->name_hash = name_hash;
+            budget->name_size = name_size;
+            budget->current_size = 0;
+            // Publish the budget only once it is initialized, as
+            // budget_for_key checks the count without the lock.
+            __atomic_store_n(&num_cache_budgets, num_cache_budgets + 1, __ATOMIC_SEQ_CST);
+        }
+        budget->max_size = size;
+    }
+    prune_cache(0, budget);
+    return 0;
+}
+
+WEAK int halide_memoization_cache_set_persistent_store(void *user_context, const char *path, int64_t size) {
+    ScopedMutexLock lock(&persistent_store_lock);
+    if (persistent_store.base != NULL) {
+        error(user_context) << "halide_memoization_cache_set_persistent_store: the persistent store is already set.\n";
+        return -1;
+    }
+    uint64_t num_slots = size / kPersistentBytesPerSlot;
+    if (num_slots == 0) {
+        error(user_context) << "halide_memoization_cache_set_persistent_store: " << size << " bytes is too small.\n";
+        return -1;
+    }
+
+    int fd = -1;
+    uint8_t *base = (uint8_t *)halide_shared_file_map(user_context, path, size, &fd);
+    if (base == NULL) {
+        error(user_context) << "halide_memoization_cache_set_persistent_store: could not map " << path << ".\n";
+        return -1;
+    }
+
+    // Set up the header if this is a new file.
+    PersistentStoreHeader *header = (PersistentStoreHeader *)base;
+    halide_shared_file_lock(fd);
+    if (header->magic == 0) {
+        header->capacity = size;
+        header->num_slots = num_slots;
+        header->data_used = 0;
+        __atomic_store_n(&header->magic, kPersistentStoreMagic, __ATOMIC_RELEASE);
+    }
+    bool compatible = header->magic == kPersistentStoreMagic && header->capacity == (uint64_t)size;
+    halide_shared_file_unlock(fd);
+    if (!compatible) {
+        error(user_context) << "halide_memoization_cache_set_persistent_store: " << path
+                            << " is not a memoization cache of " << size << " bytes.\n";
+        halide_shared_file_unmap(base, size, fd);
+        return -1;
+    }
+
+    persistent_store.size = size;
+    persistent_store.fd = fd;
+    __atomic_store_n(&persistent_store.base, base, __ATOMIC_RELEASE);
+    return 0;
+}
+
+WEAK void halide_memoization_cache_get_stats(void *user_context, halide_memoization_cache_stats_t *stats) {
+    stats->hits = __atomic_load_n(&cache_hits, __ATOMIC_RELAXED);
+    stats->persistent_hits = __atomic_load_n(&cache_persistent_hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&cache_misses, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&cache_evictions, __ATOMIC_RELAXED);
+    stats->evicted_bytes = __atomic_load_n(&cache_evicted_bytes, __ATOMIC_RELAXED);
+    stats->entries = atomic_load_size(&cache_entries);
+    stats->size = atomic_load_size(&current_cache_size);
+}
+
+WEAK void halide_memoization_cache_reset_stats(void *user_context) {
+    __atomic_store_n(&cache_hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_persistent_hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_evictions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_evicted_bytes, 0, __ATOMIC_RELAXED);
+}
+
+WEAK halide_memoization_cache_eviction_handler_t
+halide_memoization_cache_set_eviction_handler(halide_memoization_cache_eviction_handler_t handler) {
+    return __atomic_exchange_n(&cache_eviction_handler, handler, __ATOMIC_ACQ_REL);
+}
+
+WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
+                                         halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    int result = memory_cache_lookup(user_context, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+    if (result == 1 &&
+        persistent_lookup(cache_key, size, computed_bounds, tuple_count, tuple_buffers)) {
+        // The persistent store filled in the buffers. Adding them to
+        // the in-memory cache marks them as in use by the caller, as
+        // for a hit. The time it took is the cost of reloading them.
+        atomic_count(&cache_persistent_hits, 1);
+        halide_memoization_cache_store(user_context, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+        return 0;
+    }
+    if (result == 0) {
+        atomic_count(&cache_hits, 1);
+    } else if (result == 1) {
+        atomic_count(&cache_misses, 1);
+    }
+    return result;
+}
+
 WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
                                         halide_buffer_t *computed_bounds,
                                         int32_t tuple_count, halide_buffer_t **tuple_buffers) {
     debug(user_context) << "halide_memoization_cache_store\n";
 
-    uint32_t h = get_pointer_to_header(tuple_buffers[0]->host)->hash;
+    CacheBlockHeader *first_header = get_pointer_to_header(tuple_buffers[0]->host);
+    uint32_t h = first_header->hash;
+    int64_t compute_time_ns = cache_time_ns(user_context) - first_header->miss_time_ns;
+
+    uint32_t first_shard = shard_index(h);
+    CacheShard &shard = cache_shards[first_shard];
+    uint32_t index = bucket_index(h);
 
-    uint32_t index = h % kHashTableSize;
+    CacheBudget *budget = budget_for_key(cache_key, size);
 
-    ScopedMutexLock lock(&memoization_lock);
+    {
+        ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
-    debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
+        debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
 
-    debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
+        debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
 
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            debug_print_buffer(user_context, "Allocation bounds", *buf);
+        {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                debug_print_buffer(user_context, "Allocation bounds", *buf);
+            }
         }
-    }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != NULL) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            bool all_bounds_equal = true;
-            bool no_host_pointers_equal = true;
-            {
-                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-                    if (entry->buf[i].host == buf->host) {
-                        no_host_pointers_equal = false;
+        CacheEntry *entry = shard.entries[index];
+        while (entry != NULL) {
+            if (entry->hash == h && entry->key_size == (size_t)size &&
+                keys_equal(entry->key, cache_key, size) &&
+                buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+                entry->tuple_count == (uint32_t)tuple_count) {
+
+                bool all_bounds_equal = true;
+                bool no_host_pointers_equal = true;
+                {
+                    for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                        halide_buffer_t *buf = tuple_buffers[i];
+                        all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
+                        if (entry->buf[i].host == buf->host) {
+                            no_host_pointers_equal = false;
+                        }
                     }
                 }
-            }
-            if (all_bounds_equal) {
-                halide_assert(user_context, no_host_pointers_equal);
-                // This entry is still in use by the caller. Mark it as having no cache entry
-                // so halide_memoization_cache_release can free the buffer.
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    get_pointer_to_header(tuple_buffers[i]->host)->entry = NULL;
+                if (all_bounds_equal) {
+                    halide_assert(user_context, no_host_pointers_equal);
+                    // This entry is still in use by the caller. Mark it as having no cache entry
+                    // so halide_memoization_cache_release can free the buffer.
+                    for (int32_t i = 0; i < tuple_count; i++) {
+                        get_pointer_to_header(tuple_buffers[i]->host)->entry = NULL;
 
+                    }
+                    return 0;
                 }
-                return 0;
             }
+            entry = entry->next;
         }
-        entry = entry->next;
-    }
 
-    uint64_t added_size = 0;
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            added_size += buf->size_in_bytes();
+        CacheEntry *new_entry = (CacheEntry *)halide_malloc(NULL, sizeof(CacheEntry));
+        bool inited = false;
+        if (new_entry) {
+            inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
         }
-    }
-    current_cache_size += added_size;
-    prune_cache();
+        if (!inited) {
+            // This entry is still in use by the caller. Mark it as having no cache entry
+            // so halide_memoization_cache_release can free the buffer.
+            for (int32_t i = 0; i < tuple_count; i++) {
+                get_pointer_to_header(tuple_buffers[i]->host)->entry = NULL;
+            }
 
-    CacheEntry *new_entry = (CacheEntry *)halide_malloc(NULL, sizeof(CacheEntry));
-    bool inited = false;
-    if (new_entry) {
-        inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
-    }
-    if (!inited) {
-        current_cache_size -= added_size;
+            if (new_entry) {
+                halide_free(user_context, new_entry);
+            }
+            return 0;
+        }
 
-        // This entry is still in use by the caller. Mark it as having no cache entry
-        // so halide_memoization_cache_release can free the buffer.
-        for (int32_t i = 0; i < tuple_count; i++) {
-            get_pointer_to_header(tuple_buffers[i]->host)->entry = NULL;
+        new_entry->budget = budget;
+        new_entry->compute_time_ns = compute_time_ns > 0 ? compute_time_ns : 0;
+        update_priority(shard, new_entry);
+        int64_t added_size = new_entry->size_in_bytes;
+        atomic_add_size(&current_cache_size, added_size);
+        if (budget) {
+            atomic_add_size(&budget->current_size, added_size);
         }
+        atomic_add_size(&cache_entries, 1);
 
-        if (new_entry) {
-            halide_free(user_context, new_entry);
+        new_entry->next = shard.entries[index];
+        new_entry->less_recent = shard.most_recently_used;
+        if (shard.most_recently_used != NULL) {
+            shard.most_recently_used->more_recent = new_entry;
         }
-        return 0;
-    }
+        shard.most_recently_used = new_entry;
+        if (shard.least_recently_used == NULL) {
+            shard.least_recently_used = new_entry;
+        }
+        shard.entries[index] = new_entry;
 
-    new_entry->next = cache_entries[index];
-    new_entry->less_recent = most_recently_used;
-    if (most_recently_used != NULL) {
-        most_recently_used->more_recent = new_entry;
-    }
-    most_recently_used = new_entry;
-    if (least_recently_used == NULL) {
-        least_recently_used = new_entry;
+        // The new entry is in use by the caller, so the pruning below
+        // can't evict it.
+        new_entry->in_use_count = tuple_count;
+
+        for (int32_t i = 0; i < tuple_count; i++) {
+            get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+        }
+
+#if CACHE_DEBUGGING
+        validate_shard(shard);
+#endif
     }
-    cache_entries[index] = new_entry;
 
-    new_entry->in_use_count = tuple_count;
+    persistent_add(cache_key, size, computed_bounds, tuple_count, tuple_buffers);
 
-    for (int32_t i = 0; i < tuple_count; i++) {
-        get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+    // Make room, first within this pipeline's budget, then globally.
+    if (budget) {
+        prune_cache(first_shard, budget);
     }
+    prune_cache(first_shard, NULL);
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 
     return 0;
@@ -531,12 +1129,13 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     if (entry == NULL) {
         halide_free(user_context, header);
     } else {
-        ScopedMutexLock lock(&memoization_lock);
+        CacheShard &shard = cache_shards[shard_index(entry->hash)];
+        ScopedMutexLock lock(&shard.lock);
 
         halide_assert(user_context, entry->in_use_count > 0);
         entry->in_use_count--;
 #if CACHE_DEBUGGING
-        validate_cache();
+        validate_shard(shard);
 #endif
     }
 
@@ -545,19 +1144,34 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
 
 WEAK void halide_memoization_cache_cleanup() {
     debug(NULL) << "halide_memoization_cache_cleanup\n";
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
-        cache_entries[i] = NULL;
-        while (entry != NULL) {
-            CacheEntry *next = entry->next;
-            entry->destroy();
-            halide_free(NULL, entry);
-            entry = next;
+    for (size_t s = 0; s < kCacheShards; s++) {
+        CacheShard &shard = cache_shards[s];
+        for (size_t i = 0; i < kShardHashTableSize; i++) {
+            CacheEntry *entry = shard.entries[i];
+            shard.entries[i] = NULL;
+            while (entry != NULL) {
+                CacheEntry *next = entry->next;
+                entry->destroy();
+                halide_free(NULL, entry);
+                entry = next;
+            }
         }
+        shard.most_recently_used = NULL;
+        shard.least_recently_used = NULL;
+        shard.inflation = 0;
     }
     current_cache_size = 0;
-    most_recently_used = NULL;
-    least_recently_used = NULL;
+    cache_entries = 0;
+    for (int i = 0; i < num_cache_budgets; i++) {
+        cache_budgets[i].current_size = 0;
+    }
+    {
+        ScopedMutexLock lock(&persistent_store_lock);
+        if (persistent_store.base != NULL) {
+            halide_shared_file_unmap(persistent_store.base, persistent_store.size, persistent_store.fd);
+            persistent_store.base = NULL;
+        }
+    }
 }
 
 namespace {
@@ -1,9 +1,18 @@
 #include "HalideRuntime.h"
 #include "cpu_features.h"
 #include "printer.h"
+#include "scoped_mutex_lock.h"
 
 namespace Halide { namespace Runtime { namespace Internal {
 WEAK halide_can_use_target_features_t custom_can_use_target_features = halide_default_can_use_target_features;
+
+// The cached function pointers of multitarget wrappers, which are
+// resolved when the library is loaded and must be re-resolved if the
+// way target features are checked changes.
+const int max_dispatch_caches = 64;
+WEAK void **dispatch_caches[max_dispatch_caches];
+WEAK int dispatch_cache_count = 0;
+WEAK halide_mutex dispatch_caches_mutex;
 }}}
 
 extern "C" {
@@ -11,9 +20,24 @@ extern "C" {
 WEAK halide_can_use_target_features_t halide_set_custom_can_use_target_features(halide_can_use_target_features_t fn) {
     halide_can_use_target_features_t result = custom_can_use_target_features;
     custom_can_use_target_features = fn;
+    // Any dispatch already done used the old function; clear the
+    // caches so that the next call to each wrapper re-resolves.
+    ScopedMutexLock lock(&dispatch_caches_mutex);
+    for (int i = 0; i < dispatch_cache_count; i++) {
+        *dispatch_caches[i] = NULL;
+    }
     return result;
 }
 
+WEAK int halide_register_dispatch_cache(void **cache) {
+    ScopedMutexLock lock(&dispatch_caches_mutex);
+    if (dispatch_cache_count == max_dispatch_caches) {
+        return 0;
+    }
+    dispatch_caches[dispatch_cache_count++] = cache;
+    return 1;
+}
+
 WEAK int halide_can_use_target_features(int count, const uint64_t *features) {
     return (*custom_can_use_target_features)(count, features);
 }
@@ -25,6 +25,15 @@ namespace Halide { namespace Runtime { namespace Internal { namespace Cuda {
 WEAK void *lib_cuda = NULL;
 volatile int WEAK lib_cuda_lock = 0;
 
+// Whether halide_cuda_get_stream should return the per-thread default
+// stream. -1 means HL_CUDA_PER_THREAD_STREAMS hasn't been read yet.
+WEAK int per_thread_streams = -1;
+
+// The stream work is being captured on, between
+// halide_cuda_begin_graph_capture and halide_cuda_end_graph_capture,
+// or NULL if no capture is in progress.
+WEAK CUstream capture_stream = NULL;
+
 extern "C" WEAK void *halide_cuda_get_symbol(void *user_context, const char *name) {
     // Only try to load the library if we can't already get the symbol
     // from the library. Even if the library is NULL, the symbols may
@@ -92,13 +101,60 @@ WEAK void ensure_libcuda_init(void *user_context) {
 extern WEAK halide_device_interface_t cuda_device_interface;
 
 WEAK const char *get_error_name(CUresult error);
-WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx);
+WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx, int device);
 
-// A cuda context defined in this module with weak linkage
+// A cuda context defined in this module with weak linkage, used when
+// halide_get_gpu_device returns -1 (pick the best device).
 CUcontext WEAK context = 0;
-// This spinlock protexts the above context variable.
+
+// Contexts for explicitly selected devices. halide_get_gpu_device
+// takes the user_context, so overriding it lets different calls to
+// the same pipeline (e.g. from different threads) run on different
+// GPUs, each with its own context and loaded kernels.
+const int max_cuda_devices = 16;
+CUcontext WEAK device_contexts[max_cuda_devices];
+
+// This spinlock protexts the above context variables.
 volatile int WEAK context_lock = 0;
 
+WEAK CUcontext *context_for_device(int device) {
+    if (device >= 0 && device < max_cuda_devices) {
+        return &device_contexts[device];
+    }
+    return &context;
+}
+
+// Let a newly created context access memory on the GPUs of all
+// existing contexts and vice versa, so that a buffer allocated on one
+// device can be used by a pipeline running on another. Kernels then
+// read it directly over the peer link, and device-to-device copies
+// work across GPUs. Failure is not an error: the devices may simply
+// not support peer access.
+WEAK void enable_peer_access(void *user_context, CUcontext new_ctx) {
+    if (cuCtxEnablePeerAccess == NULL) {
+        return;
+    }
+    for (int i = -1; i < max_cuda_devices; i++) {
+        CUcontext other = *context_for_device(i);
+        if (other == NULL || other == new_ctx) {
+            continue;
+        }
+        CUcontext old;
+        if (cuCtxPushCurrent(new_ctx) == CUDA_SUCCESS) {
+            CUresult err = cuCtxEnablePeerAccess(other, 0);
+            debug(user_context) << "    cuCtxEnablePeerAccess " << new_ctx << " -> " << other
+                                << ": " << get_error_name(err) << "\n";
+            cuCtxPopCurrent(&old);
+        }
+        if (cuCtxPushCurrent(other) == CUDA_SUCCESS) {
+            CUresult err = cuCtxEnablePeerAccess(new_ctx, 0);
+            debug(user_context) << "    cuCtxEnablePeerAccess " << other << " -> " << new_ctx
+                                << ": " << get_error_name(err) << "\n";
+            cuCtxPopCurrent(&old);
+        }
+    }
+}
+
 }}}} // namespace Halide::Runtime::Internal::Cuda
 
 using namespace Halide::Runtime::Internal;
@@ -123,12 +179,15 @@ WEAK int halide_cuda_acquire_context(void *user_context, CUcontext *ctx, bool cr
     // If the context has not been initialized, initialize it now.
     halide_assert(user_context, &context != NULL);
 
+    int device = halide_get_gpu_device(user_context);
+    CUcontext *slot = context_for_device(device);
+
     // Note that this null-check of the context is *not* locked with
     // respect to device_release, so we may get a non-null context
     // that's in the process of being destroyed. Things will go badly
     // in general if you call device_release while other Halide code
     // is running though.
-    CUcontext local_val = context;
+    CUcontext local_val = *slot;
     if (local_val == NULL) {
         if (!create) {
             *ctx = NULL;
@@ -137,20 +196,21 @@ WEAK int halide_cuda_acquire_context(void *user_context, CUcontext *ctx, bool cr
 
         {
             ScopedSpinLock spinlock(&context_lock);
-            local_val = context;
+            local_val = *slot;
             if (local_val == NULL) {
-                CUresult error = create_cuda_context(user_context, &local_val);
+                CUresult error = create_cuda_context(user_context, &local_val, device);
                 if (error != CUDA_SUCCESS) {
                     return error;
                 }
+                enable_peer_access(user_context, local_val);
             }
             // Normally in double-checked locking you need a release
             // fence here that synchronizes with an acquire fence
             // above to ensure context is fully constructed before
             // assigning to the global, but there's no way that
-            // create_cuda_context can access the "context" global, so
+            // create_cuda_context can access the context globals, so
             // we should be OK just storing to it here.
-            context = local_val;
+            *slot = local_val;
         }  // spinlock
     }
 
@@ -167,11 +227,31 @@ WEAK int halide_cuda_release_context(void *user_context) {
 // for the context (NULL stream). The context is passed in for convenience, but
 // any sort of scoping must be handled by that of the
 // halide_cuda_acquire_context/halide_cuda_release_context pair, not this call.
+//
+// If HL_CUDA_PER_THREAD_STREAMS is set to 1, each thread gets its own
+// stream instead. Work from different threads (e.g. async() producers
+// and their consumers) can then overlap on the device, so buffer
+// copies for one stage can run while kernels for another are
+// executing. Within a thread, each kernel launch and buffer copy
+// completes before returning, because the other threads don't know
+// which stream they would need to wait on.
+//
+// While a graph capture is in progress (see
+// halide_cuda_begin_graph_capture), all work goes to the capturing
+// stream instead.
 WEAK int halide_cuda_get_stream(void *user_context, CUcontext ctx, CUstream *stream) {
+    if (Halide::Runtime::Internal::Cuda::capture_stream) {
+        *stream = Halide::Runtime::Internal::Cuda::capture_stream;
+        return 0;
+    }
     // There are two default streams we could use. stream 0 is fully
     // synchronous. stream 2 gives a separate non-blocking stream per
     // thread.
-    *stream = 0;
+    if (Halide::Runtime::Internal::Cuda::per_thread_streams < 0) {
+        const char *env = getenv("HL_CUDA_PER_THREAD_STREAMS");
+        Halide::Runtime::Internal::Cuda::per_thread_streams = (env && env[0] == '1') ? 1 : 0;
+    }
+    *stream = Halide::Runtime::Internal::Cuda::per_thread_streams ? CU_STREAM_PER_THREAD : 0;
     return 0;
 }
 
@@ -179,6 +259,19 @@ WEAK int halide_cuda_get_stream(void *user_context, CUcontext ctx, CUstream *str
 
 namespace Halide { namespace Runtime { namespace Internal { namespace Cuda {
 
+}}}} // namespace Halide::Runtime::Internal::Cuda
+
+// A captured and instantiated sequence of Halide CUDA work. Declared
+// opaquely in HalideRuntimeCuda.h.
+struct halide_cuda_graph_t {
+    CUgraph graph;
+    CUgraphExec exec;
+    // The stream the graph was captured on, which it is replayed on.
+    CUstream stream;
+};
+
+namespace Halide { namespace Runtime { namespace Internal { namespace Cuda {
+
 // Helper object to acquire and release the cuda context.
 class Context {
     void *user_context;
@@ -257,7 +350,108 @@ WEAK module_state *find_module_for_context(const registered_filters *filters, CU
     return NULL;
 }
 
-WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx) {
+// While the sampling profiler is running, kernel launches and copies
+// are bracketed by events, so that the time they take on the device
+// can be reported alongside the time spent on the host. Reading the
+// elapsed time of an event that hasn't happened yet would stall, so
+// pending events are kept in a list and resolved once they complete.
+struct timed_event {
+    CUcontext context;
+    CUevent start, end;
+    const char *name;
+    int is_copy;
+    timed_event *next;
+};
+WEAK timed_event *timed_events = NULL;
+// This spinlock protects the above timed_events.
+volatile int WEAK timed_events_lock = 0;
+
+WEAK bool timing_enabled() {
+    return (cuEventCreate != NULL &&
+            halide_profiler_get_state()->sampling_thread != NULL);
+}
+
+// Record an event marking the start of some work on the stream, or
+// return NULL if the work should not be timed. Events can't be
+// recorded into a stream being captured into a graph, and would
+// time the capture rather than the launch anyway.
+WEAK CUevent begin_timing(CUstream stream) {
+    if (!timing_enabled() || capture_stream) {
+        return NULL;
+    }
+    CUevent start = NULL;
+    if (cuEventCreate(&start, 0) != CUDA_SUCCESS) {
+        return NULL;
+    }
+    if (cuEventRecord(start, stream) != CUDA_SUCCESS) {
+        cuEventDestroy_v2(start);
+        return NULL;
+    }
+    return start;
+}
+
+// Record an event marking the end of the work begun with start, and
+// queue the pair to be resolved. Name must be a constant string.
+WEAK void end_timing(CUcontext ctx, CUstream stream, CUevent start,
+                     const char *name, int is_copy) {
+    if (!start) {
+        return;
+    }
+    CUevent end = NULL;
+    timed_event *e = (timed_event *)malloc(sizeof(timed_event));
+    if (!e ||
+        cuEventCreate(&end, 0) != CUDA_SUCCESS ||
+        cuEventRecord(end, stream) != CUDA_SUCCESS) {
+        if (end) cuEventDestroy_v2(end);
+        cuEventDestroy_v2(start);
+        free(e);
+        return;
+    }
+    e->context = ctx;
+    e->start = start;
+    e->end = end;
+    e->name = name;
+    e->is_copy = is_copy;
+
+    ScopedSpinLock spinlock(&timed_events_lock);
+    e->next = timed_events;
+    timed_events = e;
+}
+
+// Hand the times of completed events on the given context to the
+// profiler. If wait is true, wait for all of them to complete. The
+// context must be current.
+WEAK void report_timed_events(void *user_context, CUcontext ctx, bool wait) {
+    ScopedSpinLock spinlock(&timed_events_lock);
+    timed_event **prev_ptr = &timed_events;
+    timed_event *e = timed_events;
+    while (e) {
+        if (e->context != ctx) {
+            prev_ptr = &e->next;
+            e = e->next;
+            continue;
+        }
+        CUresult err = wait ? cuEventSynchronize(e->end) : cuEventQuery(e->end);
+        if (err == CUDA_ERROR_NOT_READY) {
+            prev_ptr = &e->next;
+            e = e->next;
+            continue;
+        }
+        float ms = 0;
+        if (err == CUDA_SUCCESS &&
+            cuEventElapsedTime(&ms, e->start, e->end) == CUDA_SUCCESS) {
+            halide_profiler_record_device_time(user_context, e->name, e->is_copy,
+                                               (uint64_t)(ms * 1000000.0f));
+        }
+        cuEventDestroy_v2(e->start);
+        cuEventDestroy_v2(e->end);
+        *prev_ptr = e->next;
+        free(e);
+        e = *prev_ptr;
+    }
+}
+
+WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx, int device) {
     // Initialize CUDA
     ensure_libcuda_init(user_context);
     if (!cuInit) {
@@ -286,7 +480,6 @@ WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx) {
         return CUDA_ERROR_NO_DEVICE;
     }
 
-    int device = halide_get_gpu_device(user_context);
     if (device == -1 && deviceCount == 1) {
         device = 0;
     } else if (device == -1) {
@@ -406,7 +599,7 @@ WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx) {
 
     // Create context
     debug(user_context) <<  "    cuCtxCreate " << dev << " -> ";
-    err = cuCtxCreate(ctx, 0, dev);
+    err = cuCtxCreate(ctx, CU_CTX_MAP_HOST, dev);
     if (err != CUDA_SUCCESS) {
         debug(user_context) << get_error_name(err) << "\n";
         error(user_context) << "CUDA: cuCtxCreate failed: "
@@ -464,6 +657,259 @@ WEAK bool validate_device_pointer(void *user_context, halide_buffer_t* buf, size
 #endif
 }
 
+// Frees a device allocation that was held in the device allocation
+// cache, in the context it was allocated in. That may not be the
+// context of the current device, so don't acquire it here.
+WEAK int free_cached_allocation(void *user_context, void *context, uint64_t device) {
+    CUresult err = cuCtxPushCurrent((CUcontext)context);
+    if (err != CUDA_SUCCESS) {
+        return err;
+    }
+    debug(user_context) << "    cuMemFree " << (void *)device << "\n";
+    err = cuMemFree((CUdeviceptr)device);
+    CUcontext old;
+    cuCtxPopCurrent(&old);
+    return err;
+}
+
+// The context a device allocation was made in. With peer access, a
+// buffer may be freed while another device's context is current.
+WEAK CUcontext allocation_context(CUdeviceptr dev_ptr, CUcontext current) {
+    CUcontext ctx = NULL;
+    if (cuPointerGetAttribute(&ctx, CU_POINTER_ATTRIBUTE_CONTEXT, dev_ptr) != CUDA_SUCCESS || ctx == NULL) {
+        return current;
+    }
+    return ctx;
+}
+
+// A persistent cache of compiled kernels. If HL_CUDA_KERNEL_CACHE_DIR
+// is set, PTX is compiled to a cubin once with the driver's JIT
+// linker, and the cubin is written to that directory. Later loads of
+// the same PTX on the same kind of device, in this or any other
+// process, load the cubin directly and skip the driver's JIT
+// compilation. The cache is keyed on the PTX source, the compute
+// capability of the device, the version of the driver, and the
+// register limit.
+WEAK uint64_t kernel_cache_key(const char *src, int size, CUdevice dev, unsigned int max_regs) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < size; i++) {
+        h = (h ^ (uint8_t)src[i]) * 1099511628211ULL;
+    }
+    int major = 0, minor = 0, driver_version = 0;
+    cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, dev);
+    cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, dev);
+    if (cuDriverGetVersion) {
+        cuDriverGetVersion(&driver_version);
+    }
+    uint64_t extra[] = {(uint64_t)major, (uint64_t)minor, (uint64_t)driver_version, max_regs};
+    for (int i = 0; i < 4; i++) {
+        h = (h ^ extra[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+WEAK CUresult load_cached_kernel(void *user_context, CUmodule *module, const char *path) {
+    void *f = fopen(path, "rb");
+    if (!f) {
+        return CUDA_ERROR_FILE_NOT_FOUND;
+    }
+    CUresult err = CUDA_ERROR_FILE_NOT_FOUND;
+    // 2 is SEEK_END and 0 is SEEK_SET everywhere we run.
+    long size = (fseek(f, 0, 2) == 0) ? ftell(f) : -1;
+    if (size > 0 && fseek(f, 0, 0) == 0) {
+        void *cubin = malloc(size);
+        if (cubin && fread(cubin, 1, size, f) == (size_t)size) {
+            err = cuModuleLoadData(module, cubin);
+        }
+        free(cubin);
+    }
+    fclose(f);
+    debug(user_context) << "    loading cached kernel " << path << ": " << (err == CUDA_SUCCESS ? "hit" : "miss") << "\n";
+    return err;
+}
+
+WEAK CUresult compile_and_cache_kernel(void *user_context, CUmodule *module, const char *src, int size,
+                                       unsigned int num_options, CUjit_option *options, void **option_values,
+                                       const char *path) {
+    CUlinkState state;
+    CUresult err = cuLinkCreate(num_options, options, option_values, &state);
+    if (err != CUDA_SUCCESS) {
+        return err;
+    }
+    err = cuLinkAddData(state, CU_JIT_INPUT_PTX, (void *)src, size, "halide_kernels", 0, NULL, NULL);
+    void *cubin = NULL;
+    size_t cubin_size = 0;
+    if (err == CUDA_SUCCESS) {
+        err = cuLinkComplete(state, &cubin, &cubin_size);
+    }
+    if (err == CUDA_SUCCESS) {
+        err = cuModuleLoadData(module, cubin);
+    }
+    if (err == CUDA_SUCCESS) {
+        // Failing to write the cache is not an error.
+        void *f = fopen(path, "wb");
+        if (f) {
+            bool ok = fwrite(cubin, 1, cubin_size, f) == cubin_size;
+            fclose(f);
+            if (!ok) {
+                remove(path);
+            }
+            debug(user_context) << "    wrote cached kernel " << path << "\n";
+        }
+    }
+    // The cubin is owned by the link state.
+    cuLinkDestroy(state);
+    return err;
+}
+
+WEAK CUresult load_kernels(void *user_context, CUmodule *module, const char *src, int size,
+                           unsigned int max_regs_per_thread) {
+    CUjit_option options[] = { CU_JIT_MAX_REGISTERS };
+    void *option_values[] = { (void*)(uintptr_t) max_regs_per_thread };
+
+    const char *dir = getenv("HL_CUDA_KERNEL_CACHE_DIR");
+    // Kernels compiled ahead of time to a cubin are already native code.
+    bool is_ptx = !(size >= 4 && memcmp(src, "\x7f" "ELF", 4) == 0);
+    CUdevice dev;
+    if (dir && dir[0] && is_ptx &&
+        cuLinkCreate && cuLinkAddData && cuLinkComplete && cuLinkDestroy &&
+        cuCtxGetDevice(&dev) == CUDA_SUCCESS) {
+        char path[1024];
+        char *dst = path, *end = path + sizeof(path) - 1;
+        dst = halide_string_to_string(dst, end, dir);
+        dst = halide_string_to_string(dst, end, "/halide_cuda_");
+        dst = halide_uint64_to_string(dst, end, kernel_cache_key(src, size, dev, max_regs_per_thread), 1);
+        dst = halide_string_to_string(dst, end, ".cubin");
+        if (dst < end) {
+            if (load_cached_kernel(user_context, module, path) == CUDA_SUCCESS) {
+                return CUDA_SUCCESS;
+            }
+            if (compile_and_cache_kernel(user_context, module, src, size, 1, options, option_values, path) == CUDA_SUCCESS) {
+                return CUDA_SUCCESS;
+            }
+        }
+        // Fall back to loading the PTX directly.
+    }
+
+    return cuModuleLoadDataEx(module, src, 1, options, option_values);
+}
+
+// If HL_CUDA_KERNEL_REPORT is set to 1, print the resources used by
+// each kernel in a newly loaded module: registers and local memory
+// (spills) per thread, static shared memory, and the theoretical
+// occupancy at the largest block size the kernel can be launched
+// with. When the block size is known at compile time, the kernel is
+// annotated with it and that is the block size reported. Halide's
+// shared memory is allocated dynamically at launch, so it isn't
+// accounted for in the occupancy.
+WEAK void report_kernel_resources(void *user_context, CUmodule module, const char *src, int size) {
+    if (!cuFuncGetAttribute) {
+        return;
+    }
+    CUdevice dev;
+    if (cuCtxGetDevice(&dev) != CUDA_SUCCESS) {
+        return;
+    }
+    int threads_per_sm = 0;
+    cuDeviceGetAttribute(&threads_per_sm, CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, dev);
+
+    // Kernels compiled ahead of time to a cubin don't carry their
+    // names in the clear, so only PTX can be reported on.
+    const char *entry = ".entry ";
+    const int entry_len = 7;
+    for (int i = 0; i + entry_len < size; i++) {
+        if (memcmp(src + i, entry, entry_len) != 0) {
+            continue;
+        }
+        i += entry_len;
+        char name[256];
+        int len = 0;
+        while (i < size && len < (int)sizeof(name) - 1 &&
+               src[i] != '(' && src[i] != ' ' && src[i] != '\n') {
+            name[len++] = src[i++];
+        }
+        name[len] = 0;
+
+        CUfunction f;
+        if (cuModuleGetFunction(&f, module, name) != CUDA_SUCCESS) {
+            continue;
+        }
+        int regs = 0, local_bytes = 0, shared_bytes = 0, max_threads = 0;
+        cuFuncGetAttribute(&regs, CU_FUNC_ATTRIBUTE_NUM_REGS, f);
+        cuFuncGetAttribute(&local_bytes, CU_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES, f);
+        cuFuncGetAttribute(&shared_bytes, CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES, f);
+        cuFuncGetAttribute(&max_threads, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, f);
+
+        print(user_context) << "CUDA: kernel " << name
+                            << ": " << regs << " registers, "
+                            << local_bytes << " bytes local (spill) memory, "
+                            << shared_bytes << " bytes static shared memory\n";
+        int blocks = 0;
+        if (cuOccupancyMaxActiveBlocksPerMultiprocessor && threads_per_sm > 0 &&
+            cuOccupancyMaxActiveBlocksPerMultiprocessor(&blocks, f, max_threads, 0) == CUDA_SUCCESS) {
+            print(user_context) << "CUDA: kernel " << name
+                                << ": at " << max_threads << " threads per block, "
+                                << blocks << " blocks per SM, occupancy "
+                                << (100 * blocks * max_threads) / threads_per_sm << "%\n";
+        }
+    }
+}
+
+// Free everything tied to a context: cached device allocations,
+// timed events, and loaded modules. The context itself is left alive.
+WEAK void release_context_resources(void *user_context, CUcontext ctx) {
+    // It's possible that this is being called from the destructor of
+    // a static variable, in which case the driver may already be
+    // shutting down.
+    CUresult err = cuCtxPushCurrent(ctx);
+    if (err != CUDA_SUCCESS) {
+        err = cuCtxSynchronize();
+    }
+    halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
+
+    // Free any allocations held for reuse while the context is still
+    // alive.
+    halide_device_allocation_cache_flush_context(user_context, &cuda_device_interface, ctx);
+
+    // Events can't outlive their context.
+    if (timed_events) {
+        report_timed_events(user_context, ctx, err == CUDA_SUCCESS);
+    }
+
+    {
+        ScopedSpinLock spinlock(&filters_list_lock);
+
+        // Unload the modules attached to this context. Note that the list
+        // nodes themselves are not freed, only the module objects are
+        // released. Subsequent calls to halide_init_kernels might re-create
+        // the program object using the same list node to store the module
+        // object.
+        registered_filters *filters = filters_list;
+        while (filters) {
+            module_state **prev_ptr = &filters->modules;
+            module_state *loaded_module = filters->modules;
+            while (loaded_module != NULL) {
+                if (loaded_module->context == ctx) {
+                    debug(user_context) << "    cuModuleUnload " << loaded_module->module << "\n";
+                    err = cuModuleUnload(loaded_module->module);
+                    halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
+                    *prev_ptr = loaded_module->next;
+                    free(loaded_module);
+                    loaded_module = *prev_ptr;
+                } else {
+                    loaded_module = loaded_module->next;
+                    prev_ptr = &loaded_module->next;
+                }
+            }
+            filters = filters->next;
+        }
+    }  // spinlock
+
+    CUcontext old_ctx;
+    cuCtxPopCurrent(&old_ctx);
+}
+
 }}}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -505,7 +951,6 @@ WEAK int halide_cuda_initialize_kernels(void *user_context, void **state_ptr, co
             loaded_module = (module_state *)malloc(sizeof(module_state));
             debug(user_context) <<  "    cuModuleLoadData " << (void *)ptx_src << ", " << size << " -> ";
 
-            CUjit_option options[] = { CU_JIT_MAX_REGISTERS };
             unsigned int max_regs_per_thread = 64;
 
             // A hack to enable control over max register count for
@@ -515,8 +960,7 @@ WEAK int halide_cuda_initialize_kernels(void *user_context, void **state_ptr, co
             if (regs) {
                 max_regs_per_thread = atoi(regs);
             }
-            void *optionValues[] = { (void*)(uintptr_t) max_regs_per_thread };
-            CUresult err = cuModuleLoadDataEx(&loaded_module->module, ptx_src, 1, options, optionValues);
+            CUresult err = load_kernels(user_context, &loaded_module->module, ptx_src, size, max_regs_per_thread);
 
             if (err != CUDA_SUCCESS) {
                 free(loaded_module);
@@ -526,6 +970,10 @@ WEAK int halide_cuda_initialize_kernels(void *user_context, void **state_ptr, co
             } else {
                 debug(user_context) << (void *)(loaded_module->module) << "\n";
             }
+            const char *report = getenv("HL_CUDA_KERNEL_REPORT");
+            if (report && report[0] == '1') {
+                report_kernel_resources(user_context, loaded_module->module, ptx_src, size);
+            }
             loaded_module->context = ctx.context;
             loaded_module->next = (*filters)->modules;
             (*filters)->modules = loaded_module;
@@ -562,8 +1010,29 @@ WEAK int halide_cuda_device_free(void *user_context, halide_buffer_t* buf) {
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
 
+    if ((void *)dev_ptr == buf->host) {
+        // The device allocation is the buffer's mapped host
+        // allocation (see halide_cuda_device_and_host_malloc), which
+        // is freed along with the host allocation.
+        debug(user_context) << "    releasing mapped host allocation " << (void *)dev_ptr << "\n";
+        buf->device_interface->impl->release_module();
+        buf->device_interface = NULL;
+        buf->device = 0;
+        return 0;
+    }
+
     halide_assert(user_context, validate_device_pointer(user_context, buf));
 
+    if (halide_device_allocation_cache_put(user_context, &cuda_device_interface,
+                                           allocation_context(dev_ptr, ctx.context),
+                                           buf->size_in_bytes(), buf->device, free_cached_allocation)) {
+        debug(user_context) << "    caching allocation " << (void *)(dev_ptr) << " for reuse\n";
+        buf->device_interface->impl->release_module();
+        buf->device_interface = NULL;
+        buf->device = 0;
+        return 0;
+    }
+
     debug(user_context) <<  "    cuMemFree " << (void *)(dev_ptr) << "\n";
     CUresult err = cuMemFree(dev_ptr);
     // If cuMemFree fails, it isn't likely to succeed later, so just drop
@@ -600,62 +1069,38 @@ WEAK int halide_cuda_device_release(void *user_context) {
         return err;
     }
 
+    // Release the acquired context, which may not be one of ours, and
+    // then any other contexts we created for other devices.
     if (ctx) {
-        // It's possible that this is being called from the destructor of
-        // a static variable, in which case the driver may already be
-        // shutting down.
-        err = cuCtxPushCurrent(ctx);
-        if (err != CUDA_SUCCESS) {
-            err = cuCtxSynchronize();
+        release_context_resources(user_context, ctx);
+    }
+    for (int i = -1; i < max_cuda_devices; i++) {
+        CUcontext other = *context_for_device(i);
+        if (other != NULL && other != ctx) {
+            release_context_resources(user_context, other);
         }
-        halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
-
-        {
-            ScopedSpinLock spinlock(&filters_list_lock);
-
-            // Unload the modules attached to this context. Note that the list
-            // nodes themselves are not freed, only the module objects are
-            // released. Subsequent calls to halide_init_kernels might re-create
-            // the program object using the same list node to store the module
-            // object.
-            registered_filters *filters = filters_list;
-            while (filters) {
-                module_state **prev_ptr = &filters->modules;
-                module_state *loaded_module = filters->modules;
-                while (loaded_module != NULL) {
-                    if (loaded_module->context == ctx) {
-                        debug(user_context) << "    cuModuleUnload " << loaded_module->module << "\n";
-                        err = cuModuleUnload(loaded_module->module);
-                        halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
-                        *prev_ptr = loaded_module->next;
-                        free(loaded_module);
-                        loaded_module = *prev_ptr;
-                    } else {
-                        loaded_module = loaded_module->next;
-                        prev_ptr = &loaded_module->next;
-                    }
-                }
-                filters = filters->next;
-            }
-        }  // spinlock
-
-        CUcontext old_ctx;
-        cuCtxPopCurrent(&old_ctx);
-
-        // Only destroy the context if we own it
+    }
 
-        {
-            ScopedSpinLock spinlock(&context_lock);
+    // Only destroy the contexts we own
+    {
+        ScopedSpinLock spinlock(&context_lock);
 
-            if (ctx == context) {
-                debug(user_context) << "    cuCtxDestroy " << context << "\n";
-                err = cuProfilerStop();
-                err = cuCtxDestroy(context);
-                halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
-                context = NULL;
+        bool stopped_profiler = false;
+        for (int i = -1; i < max_cuda_devices; i++) {
+            CUcontext *slot = context_for_device(i);
+            if (*slot == NULL) {
+                continue;
             }
-        }  // spinlock
-    }
+            if (!stopped_profiler) {
+                cuProfilerStop();
+                stopped_profiler = true;
+            }
+            debug(user_context) << "    cuCtxDestroy " << *slot << "\n";
+            err = cuCtxDestroy(*slot);
+            halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
+            *slot = NULL;
+        }
+    }  // spinlock
 
     halide_cuda_release_context(user_context);
 
@@ -691,16 +1136,21 @@ WEAK int halide_cuda_device_malloc(void *user_context, halide_buffer_t *buf) {
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
 
-    CUdeviceptr p;
-    debug(user_context) << "    cuMemAlloc " << (uint64_t)size << " -> ";
-    CUresult err = cuMemAlloc(&p, size);
-    if (err != CUDA_SUCCESS) {
-        debug(user_context) << get_error_name(err) << "\n";
-        error(user_context) << "CUDA: cuMemAlloc failed: "
-                            << get_error_name(err);
-        return err;
+    CUdeviceptr p = (CUdeviceptr)halide_device_allocation_cache_get(user_context, &cuda_device_interface,
+                                                                    ctx.context, size);
+    if (p) {
+        debug(user_context) << "    reusing cached allocation " << (void *)p << "\n";
     } else {
-        debug(user_context) << (void *)p << "\n";
+        debug(user_context) << "    cuMemAlloc " << (uint64_t)size << " -> ";
+        CUresult err = cuMemAlloc(&p, size);
+        if (err != CUDA_SUCCESS) {
+            debug(user_context) << get_error_name(err) << "\n";
+            error(user_context) << "CUDA: cuMemAlloc failed: "
+                                << get_error_name(err);
+            return err;
+        } else {
+            debug(user_context) << (void *)p << "\n";
+        }
     }
     halide_assert(user_context, p);
     buf->device = p;
@@ -717,25 +1167,47 @@ WEAK int halide_cuda_device_malloc(void *user_context, halide_buffer_t *buf) {
 
 namespace {
 WEAK int cuda_do_multidimensional_copy(void *user_context, const device_copy &c,
-                                       uint64_t src, uint64_t dst, int d, bool from_host, bool to_host) {
+                                       uint64_t src, uint64_t dst, int d, bool from_host, bool to_host,
+                                       CUstream stream) {
     if (d > MAX_COPY_DIMS) {
         error(user_context) << "Buffer has too many dimensions to copy to/from GPU\n";
         return -1;
     } else if (d == 0) {
         CUresult err = CUDA_SUCCESS;
-        const char *copy_name;
+        const char *copy_name = "memcpy";
         debug(user_context) << "    from " << (from_host ? "host" : "device")
                             << " to " << (to_host ? "host" : "device") << ", "
                             << (void *)src << " -> " << (void *)dst << ", " << c.chunk_size << " bytes\n";
         if (!from_host && to_host) {
-            debug(user_context) << "cuMemcpyDtoH(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
-            err = cuMemcpyDtoH((void *)dst, (CUdeviceptr)src, c.chunk_size);
+            if (stream) {
+                debug(user_context) << "cuMemcpyDtoHAsync(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size << ", " << stream << ")\n";
+                copy_name = "cuMemcpyDtoHAsync";
+                err = cuMemcpyDtoHAsync((void *)dst, (CUdeviceptr)src, c.chunk_size, stream);
+            } else {
+                debug(user_context) << "cuMemcpyDtoH(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
+                copy_name = "cuMemcpyDtoH";
+                err = cuMemcpyDtoH((void *)dst, (CUdeviceptr)src, c.chunk_size);
+            }
         } else if (from_host && !to_host) {
-            debug(user_context) << "cuMemcpyHtoD(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
-            err = cuMemcpyHtoD((CUdeviceptr)dst, (void *)src, c.chunk_size);
+            if (stream) {
+                debug(user_context) << "cuMemcpyHtoDAsync(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size << ", " << stream << ")\n";
+                copy_name = "cuMemcpyHtoDAsync";
+                err = cuMemcpyHtoDAsync((CUdeviceptr)dst, (void *)src, c.chunk_size, stream);
+            } else {
+                debug(user_context) << "cuMemcpyHtoD(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
+                copy_name = "cuMemcpyHtoD";
+                err = cuMemcpyHtoD((CUdeviceptr)dst, (void *)src, c.chunk_size);
+            }
         } else if (!from_host && !to_host) {
-            debug(user_context) << "cuMemcpyDtoD(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
-            err = cuMemcpyDtoD((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size);
+            if (stream) {
+                debug(user_context) << "cuMemcpyDtoDAsync(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size << ", " << stream << ")\n";
+                copy_name = "cuMemcpyDtoDAsync";
+                err = cuMemcpyDtoDAsync((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size, stream);
+            } else {
+                debug(user_context) << "cuMemcpyDtoD(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
+                copy_name = "cuMemcpyDtoD";
+                err = cuMemcpyDtoD((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size);
+            }
         } else if (dst != src) {
             debug(user_context) << "memcpy(" << (void *)dst << ", " << (void *)src << ", " << c.chunk_size <<")\n";
             // Could reach here if a user called directly into the
@@ -750,7 +1222,7 @@ WEAK int cuda_do_multidimensional_copy(void *user_context, const device_copy &c,
     } else {
         ssize_t src_off = 0, dst_off = 0;
         for (int i = 0; i < (int)c.extent[d-1]; i++) {
-            int err = cuda_do_multidimensional_copy(user_context, c, src + src_off, dst + dst_off, d - 1, from_host, to_host);
+            int err = cuda_do_multidimensional_copy(user_context, c, src + src_off, dst + dst_off, d - 1, from_host, to_host, stream);
             dst_off += c.dst_stride_bytes[d-1];
             src_off += c.src_stride_bytes[d-1];
             if (err) {
@@ -807,7 +1279,48 @@ WEAK int halide_cuda_buffer_copy(void *user_context, struct halide_buffer_t *src
         }
         #endif
 
-        err = cuda_do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst, dst->dimensions, from_host, to_host);
+        // Copies are issued on the same stream as kernel launches, so
+        // they are ordered with respect to them. The copy must
+        // still be complete before returning: the host memory may be
+        // reused, and other threads may be waiting on the result.
+        CUstream stream = NULL;
+        if (cuStreamSynchronize != NULL) {
+            int result = halide_cuda_get_stream(user_context, ctx.context, &stream);
+            if (result != 0) {
+                error(user_context) << "CUDA: In halide_cuda_buffer_copy, halide_cuda_get_stream returned " << result << "\n";
+            }
+        }
+
+        // If the device allocation is the mapped host allocation,
+        // there is nothing to copy, but a copy to the host must still
+        // wait for the kernels writing it.
+        bool aliased = (src == dst && from_host != to_host &&
+                        src->host != NULL && (uint64_t)src->host == src->device);
+        if (!aliased) {
+            CUevent start = begin_timing(stream);
+            err = cuda_do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst, dst->dimensions, from_host, to_host, stream);
+            if (err == 0) {
+                end_timing(ctx.context, stream, start,
+                           to_host ? "copy to host" : (from_host ? "copy to device" : "copy on device"), 1);
+            } else if (start) {
+                cuEventDestroy_v2(start);
+            }
+        }
+
+        // Nothing runs while a graph is being captured, so there is
+        // nothing to wait for.
+        if (err == 0 && stream && stream != capture_stream) {
+            CUresult sync_err = cuStreamSynchronize(stream);
+            if (sync_err != CUDA_SUCCESS) {
+                error(user_context) << "CUDA: cuStreamSynchronize failed: "
+                                    << get_error_name(sync_err);
+                err = (int)sync_err;
+            }
+        }
+
+        if (timed_events) {
+            report_timed_events(user_context, ctx.context, false);
+        }
 
         #ifdef DEBUG_RUNTIME
         uint64_t t_after = halide_current_time_ns(user_context);
@@ -885,7 +1398,11 @@ WEAK int halide_cuda_device_sync(void *user_context, struct halide_buffer_t *) {
     #endif
 
     CUresult err;
-    if (cuStreamSynchronize != NULL) {
+    if (capture_stream) {
+        // Synchronizing a capturing stream is an error, and there is
+        // no work in flight to wait for anyway.
+        err = CUDA_SUCCESS;
+    } else if (cuStreamSynchronize != NULL) {
         CUstream stream;
         int result = halide_cuda_get_stream(user_context, ctx.context, &stream);
         if (result != 0) {
@@ -901,6 +1418,10 @@ WEAK int halide_cuda_device_sync(void *user_context, struct halide_buffer_t *) {
         return err;
     }
 
+    if (timed_events) {
+        report_timed_events(user_context, ctx.context, false);
+    }
+
     #ifdef DEBUG_RUNTIME
     uint64_t t_after = halide_current_time_ns(user_context);
     debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
@@ -992,6 +1513,14 @@ WEAK int halide_cuda_run(void *user_context,
         }
     }
 
+    // Resolve the times of any earlier launches that have finished,
+    // so that the list of pending events stays short.
+    if (timed_events) {
+        report_timed_events(user_context, ctx.context, false);
+    }
+
+    halide_timeline_event(user_context, entry_name, "gpu", 'i');
+    CUevent start = begin_timing(stream);
     err = cuLaunchKernel(f,
                          blocksX,  blocksY,  blocksZ,
                          threadsX, threadsY, threadsZ,
@@ -1002,30 +1531,305 @@ WEAK int halide_cuda_run(void *user_context,
     free(dev_handles);
     free(translated_args);
     if (err != CUDA_SUCCESS) {
+        if (start) {
+            cuEventDestroy_v2(start);
+        }
         error(user_context) << "CUDA: cuLaunchKernel failed: "
                             << get_error_name(err);
         return err;
     }
+    end_timing(ctx.context, stream, start, entry_name, 0);
+
+    if (stream == CU_STREAM_PER_THREAD) {
+        // Other threads can't wait on this thread's stream, so the
+        // kernel must be done before anything it produces is used.
+        err = cuStreamSynchronize(stream);
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuStreamSynchronize failed: "
+                                << get_error_name(err);
+            return err;
+        }
+    }
 
     #ifdef DEBUG_RUNTIME
-    err = cuCtxSynchronize();
+    if (!capture_stream) {
+        err = cuCtxSynchronize();
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuCtxSynchronize failed: "
+                                << get_error_name(err);
+            return err;
+        }
+    }
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+    return 0;
+}
+
+WEAK int halide_cuda_begin_graph_capture(void *user_context) {
+    debug(user_context)
+        << "CUDA: halide_cuda_begin_graph_capture (user_context: " << user_context << ")\n";
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    if (cuStreamBeginCapture_v2 == NULL || cuGraphInstantiateWithFlags == NULL) {
+        error(user_context) << "CUDA: graph capture requires a CUDA 11.4 or later driver\n";
+        return CUDA_ERROR_NOT_SUPPORTED;
+    }
+    if (capture_stream) {
+        error(user_context) << "CUDA: halide_cuda_begin_graph_capture called while a capture is already in progress\n";
+        return CUDA_ERROR_NOT_PERMITTED;
+    }
+
+    // The legacy default stream can't be captured, so use a fresh
+    // stream that doesn't synchronize with it.
+    CUstream stream;
+    CUresult err = cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING);
     if (err != CUDA_SUCCESS) {
-        error(user_context) << "CUDA: cuCtxSynchronize failed: "
+        error(user_context) << "CUDA: cuStreamCreate failed: "
                             << get_error_name(err);
         return err;
     }
+
+    // Relaxed mode, because a pipeline may still allocate device
+    // memory on first use, which the other modes forbid.
+    err = cuStreamBeginCapture_v2(stream, CU_STREAM_CAPTURE_MODE_RELAXED);
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuStreamBeginCapture failed: "
+                            << get_error_name(err);
+        cuStreamDestroy_v2(stream);
+        return err;
+    }
+
+    capture_stream = stream;
+    return 0;
+}
+
+WEAK int halide_cuda_end_graph_capture(void *user_context, struct halide_cuda_graph_t **graph) {
+    debug(user_context)
+        << "CUDA: halide_cuda_end_graph_capture (user_context: " << user_context << ")\n";
+
+    halide_assert(user_context, graph != NULL);
+    *graph = NULL;
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    CUstream stream = capture_stream;
+    if (!stream) {
+        error(user_context) << "CUDA: halide_cuda_end_graph_capture called without a capture in progress\n";
+        return CUDA_ERROR_NOT_PERMITTED;
+    }
+    capture_stream = NULL;
+
+    CUgraph g = NULL;
+    CUgraphExec exec = NULL;
+    CUresult err = cuStreamEndCapture(stream, &g);
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuStreamEndCapture failed: "
+                            << get_error_name(err);
+    }
+    if (err == CUDA_SUCCESS) {
+        err = cuGraphInstantiateWithFlags(&exec, g, 0);
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuGraphInstantiateWithFlags failed: "
+                                << get_error_name(err);
+        }
+    }
+    // Nothing the captured calls enqueued has actually run yet, so
+    // launch the graph once to produce their results.
+    if (err == CUDA_SUCCESS) {
+        err = cuGraphLaunch(exec, stream);
+        if (err == CUDA_SUCCESS) {
+            err = cuStreamSynchronize(stream);
+        }
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuGraphLaunch failed: "
+                                << get_error_name(err);
+        }
+    }
+
+    halide_cuda_graph_t *result = NULL;
+    if (err == CUDA_SUCCESS) {
+        result = (halide_cuda_graph_t *)malloc(sizeof(halide_cuda_graph_t));
+        if (result == NULL) {
+            error(user_context) << "CUDA: Out of memory allocating graph\n";
+            err = CUDA_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (err != CUDA_SUCCESS) {
+        if (exec) {
+            cuGraphExecDestroy(exec);
+        }
+        if (g) {
+            cuGraphDestroy(g);
+        }
+        cuStreamDestroy_v2(stream);
+        return err;
+    }
+
+    result->graph = g;
+    result->exec = exec;
+    result->stream = stream;
+    *graph = result;
+    return 0;
+}
+
+WEAK int halide_cuda_graph_launch(void *user_context, struct halide_cuda_graph_t *graph) {
+    debug(user_context)
+        << "CUDA: halide_cuda_graph_launch (user_context: " << user_context
+        << ", graph: " << graph << ")\n";
+
+    halide_assert(user_context, graph != NULL);
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    CUresult err = cuGraphLaunch(graph->exec, graph->stream);
+    if (err == CUDA_SUCCESS) {
+        err = cuStreamSynchronize(graph->stream);
+    }
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuGraphLaunch failed: "
+                            << get_error_name(err);
+        return err;
+    }
+
+    #ifdef DEBUG_RUNTIME
     uint64_t t_after = halide_current_time_ns(user_context);
     debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
     #endif
+
+    return 0;
+}
+
+WEAK int halide_cuda_graph_release(void *user_context, struct halide_cuda_graph_t *graph) {
+    debug(user_context)
+        << "CUDA: halide_cuda_graph_release (user_context: " << user_context
+        << ", graph: " << graph << ")\n";
+
+    if (graph == NULL) {
+        return 0;
+    }
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    cuGraphExecDestroy(graph->exec);
+    cuGraphDestroy(graph->graph);
+    cuStreamDestroy_v2(graph->stream);
+    free(graph);
     return 0;
 }
 
 WEAK int halide_cuda_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf) {
-    return halide_default_device_and_host_malloc(user_context, buf, &cuda_device_interface);
+    debug(user_context)
+        << "CUDA: halide_cuda_device_and_host_malloc (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    if (buf->device) {
+        return halide_default_device_and_host_malloc(user_context, buf, &cuda_device_interface);
+    }
+
+    size_t size = buf->size_in_bytes();
+    halide_assert(user_context, size != 0);
+    for (int i = 0; i < buf->dimensions; i++) {
+        halide_assert(user_context, buf->dim[i].stride >= 0);
+    }
+
+    {
+        Context ctx(user_context);
+        if (ctx.error != CUDA_SUCCESS) {
+            return ctx.error;
+        }
+
+        // Page-locked host memory is copied to and from the device by
+        // DMA, without staging it through a driver buffer. An
+        // integrated device shares physical memory with the host, so
+        // there it is also mapped into the device's address space and
+        // used as the device allocation.
+        CUdevice dev;
+        int integrated = 0, can_map = 0;
+        if (cuCtxGetDevice(&dev) == CUDA_SUCCESS) {
+            cuDeviceGetAttribute(&integrated, CU_DEVICE_ATTRIBUTE_INTEGRATED, dev);
+            cuDeviceGetAttribute(&can_map, CU_DEVICE_ATTRIBUTE_CAN_MAP_HOST_MEMORY, dev);
+        }
+        bool map = integrated && can_map;
+
+        void *host = NULL;
+        debug(user_context) << "    cuMemHostAlloc " << (uint64_t)size << (map ? " (mapped)" : "") << " -> ";
+        CUresult err = cuMemHostAlloc(&host, size, CU_MEMHOSTALLOC_PORTABLE | (map ? CU_MEMHOSTALLOC_DEVICEMAP : 0));
+        if (err != CUDA_SUCCESS) {
+            // Fall back to pageable host memory.
+            debug(user_context) << get_error_name(err) << "\n";
+            return halide_default_device_and_host_malloc(user_context, buf, &cuda_device_interface);
+        }
+        debug(user_context) << host << "\n";
+        buf->host = (uint8_t *)host;
+
+        // Only use the mapping if it has the same address as the host
+        // allocation, which is always the case with unified
+        // addressing. halide_cuda_device_free and
+        // halide_cuda_buffer_copy rely on this to recognize it.
+        CUdeviceptr p = 0;
+        if (map &&
+            cuMemHostGetDevicePointer(&p, host, 0) == CUDA_SUCCESS &&
+            p == (CUdeviceptr)host) {
+            debug(user_context) << "    using mapped host allocation as device allocation\n";
+            buf->device = p;
+            buf->device_interface = &cuda_device_interface;
+            buf->device_interface->impl->use_module();
+            return 0;
+        }
+    }
+
+    int result = halide_cuda_device_malloc(user_context, buf);
+    if (result != 0) {
+        Context ctx(user_context);
+        cuMemFreeHost(buf->host);
+        buf->host = NULL;
+    }
+    return result;
 }
 
 WEAK int halide_cuda_device_and_host_free(void *user_context, struct halide_buffer_t *buf) {
-    return halide_default_device_and_host_free(user_context, buf, &cuda_device_interface);
+    debug(user_context)
+        << "CUDA: halide_cuda_device_and_host_free (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    int result = halide_device_free(user_context, buf);
+    if (buf->host) {
+        // The host allocation is page-locked unless
+        // halide_cuda_device_and_host_malloc fell back to
+        // halide_malloc.
+        Context ctx(user_context);
+        unsigned int flags;
+        if (ctx.error == CUDA_SUCCESS &&
+            cuMemHostGetFlags(&flags, buf->host) == CUDA_SUCCESS) {
+            debug(user_context) << "    cuMemFreeHost " << (void *)buf->host << "\n";
+            cuMemFreeHost(buf->host);
+        } else {
+            halide_free(user_context, buf->host);
+        }
+        buf->host = NULL;
+    }
+    buf->set_host_dirty(false);
+    buf->set_device_dirty(false);
+    return result;
 }
 
 WEAK int halide_cuda_wrap_device_ptr(void *user_context, struct halide_buffer_t *buf, uint64_t device_ptr) {
@@ -1066,6 +1870,23 @@ WEAK uintptr_t halide_cuda_get_device_ptr(void *user_context, struct halide_buff
     return (uintptr_t)buf->device;
 }
 
+WEAK int halide_cuda_get_current_stream(void *user_context, void **context, void **stream) {
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    CUstream s;
+    int result = halide_cuda_get_stream(user_context, ctx.context, &s);
+    if (result != 0) {
+        error(user_context) << "CUDA: In halide_cuda_get_current_stream, halide_cuda_get_stream returned " << result << "\n";
+        return result;
+    }
+    *context = (void *)ctx.context;
+    *stream = (void *)s;
+    return 0;
+}
+
 WEAK const halide_device_interface_t *halide_cuda_device_interface() {
     return &cuda_device_interface;
 }
@@ -385,6 +385,7 @@ static PFN_D3D12_CREATE_DEVICE              D3D12CreateDevice           = NULL;
 static PFN_D3D12_GET_DEBUG_INTERFACE        D3D12GetDebugInterface      = NULL;
 static PFN_D3D12_SERIALIZE_ROOT_SIGNATURE   D3D12SerializeRootSignature = NULL;
 static PFN_D3DCOMPILE                       D3DCompile                  = NULL;
+static PFN_D3DCREATEBLOB                    D3DCreateBlob               = NULL;
 static PFN_CREATEDXGIFACORY1                CreateDXGIFactory1          = NULL;
 
 #if defined(__cplusplus) && !defined(_MSC_VER)
@@ -507,6 +508,8 @@ struct d3d12_library {
 struct d3d12_function {
     ID3DBlob *shaderBlob;
     ID3D12RootSignature *rootSignature;
+    // created on first use, and then reused by every dispatch of the function
+    d3d12_compute_pipeline_state *pipelineState;
 };
 
 enum ResourceBindingSlots {
@@ -653,14 +656,6 @@ void release_d3d12_object<d3d12_library>(d3d12_library *library) {
     d3d12_free(library);
 }
 
-template<>
-void release_d3d12_object<d3d12_function>(d3d12_function *function) {
-    TRACELOG;
-    Release_ID3D12Object(function->shaderBlob);
-    Release_ID3D12Object(function->rootSignature);
-    d3d12_free(function);
-}
-
 template<>
 void release_d3d12_object<d3d12_profiler>(d3d12_profiler *profiler) {
     TRACELOG;
@@ -676,6 +671,15 @@ void release_d3d12_object<d3d12_compute_pipeline_state>(d3d12_compute_pipeline_s
     Release_ID3D12Object(p);
 }
 
+template<>
+void release_d3d12_object<d3d12_function>(d3d12_function *function) {
+    TRACELOG;
+    release_object(function->pipelineState);
+    Release_ID3D12Object(function->shaderBlob);
+    Release_ID3D12Object(function->rootSignature);
+    d3d12_free(function);
+}
+
 extern WEAK halide_device_interface_t d3d12compute_device_interface;
 
 static d3d12_buffer *peel_buffer(struct halide_buffer_t *hbuffer) {
@@ -770,6 +774,7 @@ static void D3D12LoadDependencies(void *user_context) {
     D3D12GetDebugInterface      = LibrarySymbol::get(user_context, lib_d3d12,           "D3D12GetDebugInterface");
     D3D12SerializeRootSignature = LibrarySymbol::get(user_context, lib_d3d12,           "D3D12SerializeRootSignature");
     D3DCompile                  = LibrarySymbol::get(user_context, lib_D3DCompiler_47,  "D3DCompile");
+    D3DCreateBlob               = LibrarySymbol::get(user_context, lib_D3DCompiler_47,  "D3DCreateBlob");
     CreateDXGIFactory1          = LibrarySymbol::get(user_context, lib_dxgi,            "CreateDXGIFactory1");
 
     // Windows x64 follows the LLP64 integer type convention:
@@ -1597,6 +1602,66 @@ static void dump_shader(const char *source, ID3DBlob *compiler_msgs = NULL) {
     dump(user_context) << TRACEINDENT << ">>> HLSL shader source dump <<<\n" << source << "\n";
 }
 
+// A persistent cache of compiled shaders. If HL_D3D12_SHADER_CACHE_DIR is
+// set, the bytecode D3DCompile() produces for each specialization of a
+// kernel is written to that directory, and later runs, in this or any other
+// process, load it from there instead of compiling the HLSL again. The
+// cache is keyed on the source, the specialization (entry point, thread
+// counts and groupshared size), the shader model and the compile flags.
+static uint64_t shader_cache_key(const char *source, int source_size, const char *specialization,
+                                 const char *target, UINT flags) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < source_size; i++) {
+        h = (h ^ (uint8_t)source[i]) * 1099511628211ULL;
+    }
+    for (const char *c = specialization; *c; c++) {
+        h = (h ^ (uint8_t)*c) * 1099511628211ULL;
+    }
+    for (const char *c = target; *c; c++) {
+        h = (h ^ (uint8_t)*c) * 1099511628211ULL;
+    }
+    h = (h ^ flags) * 1099511628211ULL;
+    return h;
+}
+
+static ID3DBlob *load_cached_shader(const char *path) {
+    TRACELOG;
+    void *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    ID3DBlob *blob = NULL;
+    // 2 is SEEK_END and 0 is SEEK_SET everywhere we run.
+    long size = (fseek(f, 0, 2) == 0) ? ftell(f) : -1;
+    if (size > 0 && fseek(f, 0, 0) == 0 && D3DCreateBlob &&
+        SUCCEEDED(D3DCreateBlob(size, &blob)) && (blob != NULL)) {
+        if (fread(blob->GetBufferPointer(), 1, size, f) != (size_t)size) {
+            Release_ID3D12Object(blob);
+            blob = NULL;
+        }
+    }
+    fclose(f);
+    TRACEPRINT("loading cached shader " << path << ": " << (blob ? "hit" : "miss") << "\n");
+    return blob;
+}
+
+static void save_cached_shader(const char *path, ID3DBlob *blob) {
+    TRACELOG;
+    // Failing to write the cache is not an error.
+    void *f = fopen(path, "wb");
+    if (!f) {
+        return;
+    }
+    size_t size = blob->GetBufferSize();
+    bool ok = fwrite(blob->GetBufferPointer(), 1, size, f) == size;
+    fclose(f);
+    if (!ok) {
+        remove(path);
+    }
+    TRACEPRINT("wrote cached shader " << path << "\n");
+}
+
 static d3d12_function *new_function_with_name(d3d12_device *device, d3d12_library *library, const char *name, size_t name_len,
                                               int shared_mem_bytes, int threadsX, int threadsY, int threadsZ) {
     TRACELOG;
@@ -1650,7 +1715,30 @@ static d3d12_function *new_function_with_name(d3d12_device *device, d3d12_librar
 
     //dump_shader(source);
 
-    HRESULT result = D3DCompile(source, source_size, shaderName, pDefines, includeHandler, entryPoint, target, flags1, flags2, &shaderBlob, &errorMsgs);
+    char path[1024];
+    path[0] = '\0';
+    const char *dir = getenv("HL_D3D12_SHADER_CACHE_DIR");
+    if (dir && dir[0]) {
+        char *dst = path, *end = path + sizeof(path) - 1;
+        dst = halide_string_to_string(dst, end, dir);
+        dst = halide_string_to_string(dst, end, "/halide_d3d12_");
+        dst = halide_uint64_to_string(dst, end, shader_cache_key(source, source_size, key.str(), target, flags1), 1);
+        dst = halide_string_to_string(dst, end, ".cso");
+        if (dst >= end) {
+            path[0] = '\0';
+        }
+    }
+    if (path[0]) {
+        shaderBlob = load_cached_shader(path);
+    }
+
+    HRESULT result = S_OK;
+    if (shaderBlob == NULL) {
+        result = D3DCompile(source, source_size, shaderName, pDefines, includeHandler, entryPoint, target, flags1, flags2, &shaderBlob, &errorMsgs);
+        if (SUCCEEDED(result) && (shaderBlob != NULL) && path[0]) {
+            save_cached_shader(path, shaderBlob);
+        }
+    }
 
     if (FAILED(result) || (shaderBlob == NULL)) {
         TRACEPRINT("Unable to compile D3D12 compute shader (HRESULT=" << (void*)(int64_t)result << ", ShaderBlob=" << shaderBlob << " entry=" << entryPoint << ").\n");
@@ -1671,6 +1759,7 @@ static d3d12_function *new_function_with_name(d3d12_device *device, d3d12_librar
     function = malloct<d3d12_function>();
     function->shaderBlob = shaderBlob;
     function->rootSignature = rootSignature;
+    function->pipelineState = NULL;
     rootSignature->AddRef();
 
     // cache the compiled function for future use:
@@ -2631,10 +2720,14 @@ WEAK int halide_d3d12compute_run(void *user_context,
 
     // prepare buffer resource binding:
     d3d12_binder *binder = new_descriptor_binder(device);
-    d3d12_compute_pipeline_state *pipeline_state = new_compute_pipeline_state_with_function(d3d12_context.device, function);
+    // compute pipeline states are expensive to create, so each function keeps
+    // the one it creates on first use for every later dispatch:
+    if (function->pipelineState == NULL) {
+        function->pipelineState = new_compute_pipeline_state_with_function(d3d12_context.device, function);
+    }
+    d3d12_compute_pipeline_state *pipeline_state = function->pipelineState;
     if (pipeline_state == 0) {
         d3d12_halt("D3D12Compute: Could not allocate pipeline state.");
-        release_object(function);
         return halide_error_code_device_run_failed;
     }
     set_compute_pipeline_state(cmdList, pipeline_state, function, binder);
@@ -2773,7 +2866,6 @@ WEAK int halide_d3d12compute_run(void *user_context,
     release_object(cmdList);
     release_object(command_allocator);
     release_object(&args_buffer);
-    release_object(pipeline_state);
     release_object(binder);
 
     #ifdef DEBUG_RUNTIME
@@ -166,6 +166,54 @@ WEAK device_copy make_device_to_host_copy(const halide_buffer_t *buf) {
     return make_buffer_copy(buf, false, buf, true);
 }
 
+// Make dst a crop of src's host memory covering the slices of src's
+// outermost dimension that contain the elements at offsets [min, min +
+// extent) from src's host pointer. dst has no device
+// allocation. Returns false if src's layout is not one we can crop
+// this way, in which case the caller should copy all of src.
+WEAK bool crop_to_element_range(const halide_buffer_t *src, int64_t min, int64_t extent,
+                                halide_buffer_t *dst, halide_dimension_t *dst_shape) {
+    if (src->dimensions < 1 || src->dimensions > MAX_COPY_DIMS || extent <= 0) {
+        return false;
+    }
+    int outer = 0;
+    for (int i = 0; i < src->dimensions; i++) {
+        // TODO: deal with negative strides.
+        if (src->dim[i].stride < 0) {
+            return false;
+        }
+        if (src->dim[i].stride > src->dim[outer].stride) {
+            outer = i;
+        }
+    }
+    const int64_t stride = src->dim[outer].stride;
+    if (stride == 0) {
+        return false;
+    }
+    int64_t lo = min / stride;
+    int64_t hi = (min + extent - 1) / stride;
+    lo = lo < 0 ? 0 : lo;
+    hi = hi >= src->dim[outer].extent ? src->dim[outer].extent - 1 : hi;
+    if (lo > hi) {
+        return false;
+    }
+
+    *dst = *src;
+    dst->dim = dst_shape;
+    for (int i = 0; i < src->dimensions; i++) {
+        dst->dim[i] = src->dim[i];
+    }
+    dst->dim[outer].min = src->dim[outer].min + (int32_t)lo;
+    dst->dim[outer].extent = (int32_t)(hi - lo + 1);
+    if (dst->host) {
+        dst->host += lo * stride * src->type.bytes();
+    }
+    dst->device = 0;
+    dst->device_interface = NULL;
+    dst->flags = 0;
+    return true;
+}
+
 // Caller is expected to verify that src->dimensions == dst->dimensions
 inline __attribute__((always_inline))
 int64_t calc_device_crop_byte_offset(const struct halide_buffer_t *src, struct halide_buffer_t *dst) {
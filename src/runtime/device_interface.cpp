@@ -52,6 +52,73 @@ WEAK int copy_to_host_already_locked(void *user_context, struct halide_buffer_t
     return result;
 }
 
+// A cache of device allocations that have been freed, so that they
+// can be handed back out by a later allocation of the same size on
+// the same device interface and context instead of going back to the
+// driver. It
+// is shared by all device backends; a backend opts in by calling
+// halide_device_allocation_cache_get from its device_malloc and
+// halide_device_allocation_cache_put from its device_free.
+struct cached_device_allocation {
+    cached_device_allocation *next;
+    const halide_device_interface_t *interface;
+    void *context;
+    size_t size;
+    uint64_t device;
+    // Releases the allocation for real. May be called without the
+    // backend's context held.
+    halide_device_allocation_free_t free_fn;
+};
+
+WEAK halide_mutex device_allocation_cache_mutex;
+// Most recently freed first.
+WEAK cached_device_allocation *device_allocation_cache = NULL;
+WEAK bool reuse_device_allocations = false;
+WEAK int64_t device_allocation_cache_size = 0;
+// Zero means no limit.
+WEAK int64_t device_allocation_cache_limit = 0;
+
+// Really free a list of allocations removed from the cache. Must be
+// called without the cache lock held, as the free functions may take
+// backend locks.
+WEAK int free_cached_device_allocations(void *user_context, cached_device_allocation *list) {
+    int result = 0;
+    while (list) {
+        cached_device_allocation *next = list->next;
+        debug(user_context) << "Freeing cached device allocation " << (void *)list->device
+                            << " of size " << (uint64_t)list->size << "\n";
+        int err = list->free_fn(user_context, list->context, list->device);
+        if (err != 0) {
+            result = err;
+        }
+        free(list);
+        list = next;
+    }
+    return result;
+}
+
+// Remove all cached allocations for the given interface and context
+// (or for all interfaces or contexts if they are NULL) and return them
+// as a list. Must be called with the cache lock held.
+WEAK cached_device_allocation *take_cached_device_allocations(const halide_device_interface_t *interface,
+                                                              void *context = NULL) {
+    cached_device_allocation *taken = NULL;
+    cached_device_allocation **prev = &device_allocation_cache;
+    while (*prev) {
+        cached_device_allocation *entry = *prev;
+        if ((interface == NULL || entry->interface == interface) &&
+            (context == NULL || entry->context == context)) {
+            *prev = entry->next;
+            device_allocation_cache_size -= entry->size;
+            entry->next = taken;
+            taken = entry;
+        } else {
+            prev = &entry->next;
+        }
+    }
+    return taken;
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 namespace {
@@ -180,6 +247,107 @@ WEAK int halide_copy_to_device(void *user_context,
     return copy_to_device_already_locked(user_context, buf, device_interface);
 }
 
+WEAK int halide_copy_to_host_region(void *user_context, struct halide_buffer_t *buf,
+                                    int min, int extent) {
+    ScopedMutexLock lock(&device_copy_mutex);
+
+    int result = debug_log_and_validate_buf(user_context, buf, "halide_copy_to_host_region");
+    if (result != 0) {
+        return result;
+    }
+
+    if (!buf->device_dirty()) {
+        return 0;
+    }
+
+    halide_buffer_t crop;
+    halide_dimension_t crop_shape[MAX_COPY_DIMS];
+    if (buf->host_dirty() ||
+        buf->host == NULL ||
+        buf->device_interface == NULL ||
+        !crop_to_element_range(buf, min, extent, &crop, crop_shape)) {
+        return copy_to_host_already_locked(user_context, buf);
+    }
+
+    debug(user_context) << "halide_copy_to_host_region " << buf
+                        << " elements [" << min << ", " << min + extent << ")\n";
+    result = buf->device_interface->impl->buffer_copy(user_context, buf, NULL, &crop);
+    if (result == halide_error_code_incompatible_device_interface) {
+        // This device interface can't copy part of a buffer.
+        return copy_to_host_already_locked(user_context, buf);
+    } else if (result != 0) {
+        debug(user_context) << "halide_copy_to_host_region " << buf << " device buffer_copy returned an error\n";
+        return halide_error_code_copy_to_host_failed;
+    }
+
+    // The rest of the host allocation is still stale, so buf stays
+    // device dirty.
+    halide_msan_annotate_buffer_is_initialized(user_context, &crop);
+    return 0;
+}
+
+WEAK int halide_copy_to_device_region(void *user_context, struct halide_buffer_t *buf,
+                                      const halide_device_interface_t *device_interface,
+                                      int min, int extent) {
+    ScopedMutexLock lock(&device_copy_mutex);
+
+    int result = debug_log_and_validate_buf(user_context, buf, "halide_copy_to_device_region");
+    if (result != 0) {
+        return result;
+    }
+
+    if (device_interface == NULL) {
+        device_interface = buf->device_interface;
+    }
+
+    if (!buf->host_dirty() ||
+        buf->device_dirty() ||
+        device_interface == NULL ||
+        (buf->device && buf->device_interface != device_interface)) {
+        // Nothing to copy, or an error halide_copy_to_device will
+        // report.
+        return copy_to_device_already_locked(user_context, buf, device_interface);
+    }
+
+    if (buf->device == 0) {
+        result = halide_device_malloc(user_context, buf, device_interface);
+        if (result != 0) {
+            debug(user_context) << "halide_copy_to_device_region " << buf
+                                << " call to halide_device_malloc failed\n";
+            return result;
+        }
+    }
+
+    halide_buffer_t crop;
+    halide_dimension_t crop_shape[MAX_COPY_DIMS];
+    if (!crop_to_element_range(buf, min, extent, &crop, crop_shape)) {
+        return copy_to_device_already_locked(user_context, buf, device_interface);
+    }
+
+    // Crop the device allocation to the same region, and copy the
+    // host crop into it.
+    result = device_interface->impl->device_crop(user_context, buf, &crop);
+    if (result != 0) {
+        // This device interface can't crop buffers.
+        return copy_to_device_already_locked(user_context, buf, device_interface);
+    }
+    crop.set_host_dirty(true);
+
+    debug(user_context) << "halide_copy_to_device_region " << buf
+                        << " elements [" << min << ", " << min + extent << ")\n";
+    result = device_interface->impl->copy_to_device(user_context, &crop);
+    device_interface->impl->device_release_crop(user_context, &crop);
+    if (result != 0) {
+        debug(user_context) << "halide_copy_to_device_region " << buf
+                            << " device copy_to_device returned an error\n";
+        return halide_error_code_copy_to_device_failed;
+    }
+
+    // The rest of the device allocation is still stale, so buf stays
+    // host dirty.
+    return 0;
+}
+
 /** Wait for current GPU operations to complete. Calling this explicitly
  * should rarely be necessary, except maybe for profiling. */
 WEAK int halide_device_sync(void *user_context, struct halide_buffer_t *buf) {
@@ -711,4 +879,126 @@ WEAK int halide_device_release_crop(void *user_context,
     return 0;
 }
 
+WEAK int halide_reuse_device_allocations(void *user_context, bool flag) {
+    cached_device_allocation *to_free = NULL;
+    {
+        ScopedMutexLock lock(&device_allocation_cache_mutex);
+        reuse_device_allocations = flag;
+        if (!flag) {
+            to_free = take_cached_device_allocations(NULL);
+        }
+    }
+    return free_cached_device_allocations(user_context, to_free);
+}
+
+WEAK bool halide_can_reuse_device_allocations(void *user_context) {
+    return reuse_device_allocations;
+}
+
+WEAK void halide_set_device_allocation_cache_limit(int64_t size) {
+    cached_device_allocation *to_free = NULL;
+    {
+        ScopedMutexLock lock(&device_allocation_cache_mutex);
+        device_allocation_cache_limit = size;
+        if (size > 0 && device_allocation_cache_size > size) {
+            // Just flush everything. Shrinking the limit is rare.
+            to_free = take_cached_device_allocations(NULL);
+        }
+    }
+    free_cached_device_allocations(NULL, to_free);
+}
+
+WEAK int halide_device_allocation_cache_flush(void *user_context,
+                                              const struct halide_device_interface_t *device_interface) {
+    cached_device_allocation *to_free = NULL;
+    {
+        ScopedMutexLock lock(&device_allocation_cache_mutex);
+        to_free = take_cached_device_allocations(device_interface);
+    }
+    return free_cached_device_allocations(user_context, to_free);
+}
+
+WEAK int halide_device_allocation_cache_flush_context(void *user_context,
+                                                      const struct halide_device_interface_t *device_interface,
+                                                      void *context) {
+    cached_device_allocation *to_free = NULL;
+    {
+        ScopedMutexLock lock(&device_allocation_cache_mutex);
+        to_free = take_cached_device_allocations(device_interface, context);
+    }
+    return free_cached_device_allocations(user_context, to_free);
+}
+
+WEAK uint64_t halide_device_allocation_cache_get(void *user_context,
+                                                 const struct halide_device_interface_t *device_interface,
+                                                 void *context, size_t size) {
+    if (!reuse_device_allocations) {
+        return 0;
+    }
+    ScopedMutexLock lock(&device_allocation_cache_mutex);
+    cached_device_allocation **prev = &device_allocation_cache;
+    while (*prev) {
+        cached_device_allocation *entry = *prev;
+        if (entry->interface == device_interface && entry->context == context && entry->size == size) {
+            *prev = entry->next;
+            device_allocation_cache_size -= entry->size;
+            uint64_t device = entry->device;
+            free(entry);
+            debug(user_context) << "Reusing cached device allocation " << (void *)device
+                                << " of size " << (uint64_t)size << "\n";
+            return device;
+        }
+        prev = &entry->next;
+    }
+    return 0;
+}
+
+WEAK bool halide_device_allocation_cache_put(void *user_context,
+                                             const struct halide_device_interface_t *device_interface,
+                                             void *context, size_t size, uint64_t device,
+                                             halide_device_allocation_free_t free_fn) {
+    if (!reuse_device_allocations) {
+        return false;
+    }
+    cached_device_allocation *entry = (cached_device_allocation *)malloc(sizeof(cached_device_allocation));
+    if (entry == NULL) {
+        return false;
+    }
+    entry->interface = device_interface;
+    entry->context = context;
+    entry->size = size;
+    entry->device = device;
+    entry->free_fn = free_fn;
+
+    cached_device_allocation *to_free = NULL;
+    {
+        ScopedMutexLock lock(&device_allocation_cache_mutex);
+        if (device_allocation_cache_limit > 0 && (int64_t)size > device_allocation_cache_limit) {
+            free(entry);
+            return false;
+        }
+        entry->next = device_allocation_cache;
+        device_allocation_cache = entry;
+        device_allocation_cache_size += size;
+
+        // Evict the least recently freed allocations until we're
+        // back under the limit. They're at the end of the list.
+        if (device_allocation_cache_limit > 0) {
+            while (device_allocation_cache_size > device_allocation_cache_limit) {
+                cached_device_allocation **last = &device_allocation_cache;
+                while ((*last)->next) {
+                    last = &(*last)->next;
+                }
+                cached_device_allocation *victim = *last;
+                *last = NULL;
+                device_allocation_cache_size -= victim->size;
+                victim->next = to_free;
+                to_free = victim;
+            }
+        }
+    }
+    free_cached_device_allocations(user_context, to_free);
+    return true;
+}
+
 } // extern "C" linkage
@@ -46,6 +46,31 @@ extern WEAK int halide_default_device_crop(void *user_context, const struct hali
 extern WEAK int halide_default_device_slice(void *user_context, const struct halide_buffer_t *src,
                                             int slice_dim, int slice_pos, struct halide_buffer_t *dst);
 extern WEAK int halide_default_device_release_crop(void *user_context, struct halide_buffer_t *buf);
+// Used by device backends to share the device allocation cache (see
+// halide_reuse_device_allocations). If a backend's device_free hands
+// an allocation to halide_device_allocation_cache_put and it returns
+// true, the backend should drop its reference without freeing it; the
+// cache will call free_fn later if the allocation is evicted or
+// flushed. halide_device_allocation_cache_get returns a previously
+// cached device field value of exactly the given size for the given
+// interface and context, or zero. The context is whatever the backend
+// uses to tell apart allocations that can't be used in place of each
+// other (e.g. a CUcontext per device), or NULL if it has only one, and
+// it is passed back to free_fn. Backends must flush their entries in
+// device_release, either all at once or one context at a time with
+// halide_device_allocation_cache_flush_context.
+typedef int (*halide_device_allocation_free_t)(void *user_context, void *context, uint64_t device);
+extern WEAK uint64_t halide_device_allocation_cache_get(void *user_context,
+                                                        const struct halide_device_interface_t *device_interface,
+                                                        void *context, size_t size);
+extern WEAK bool halide_device_allocation_cache_put(void *user_context,
+                                                    const struct halide_device_interface_t *device_interface,
+                                                    void *context, size_t size, uint64_t device,
+                                                    halide_device_allocation_free_t free_fn);
+extern WEAK int halide_device_allocation_cache_flush_context(void *user_context,
+                                                             const struct halide_device_interface_t *device_interface,
+                                                             void *context);
+
 extern WEAK int halide_default_device_wrap_native(void *user_context, struct halide_buffer_t *buf, uint64_t handle);
 extern WEAK int halide_default_device_detach_native(void *user_context, struct halide_buffer_t *buf);
 
@@ -0,0 +1,19 @@
+#include "runtime_internal.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Hardware performance counters aren't supported on this platform.
+
+WEAK int halide_perf_counters_thread_id() {
+    return 0;
+}
+
+WEAK int halide_perf_counters_open() {
+    return -1;
+}
+
+WEAK bool halide_perf_counters_read(int group, uint64_t *values) {
+    return false;
+}
+
+}}}
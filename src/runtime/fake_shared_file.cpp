@@ -0,0 +1,20 @@
+#include "runtime_internal.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Files shared between processes aren't supported on this platform.
+
+WEAK void *halide_shared_file_map(void *user_context, const char *path, size_t size, int *fd) {
+    return NULL;
+}
+
+WEAK void halide_shared_file_unmap(void *mapping, size_t size, int fd) {
+}
+
+WEAK void halide_shared_file_lock(int fd) {
+}
+
+WEAK void halide_shared_file_unlock(int fd) {
+}
+
+}}}
@@ -0,0 +1,15 @@
+#include "runtime_internal.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK bool halide_thread_set_affinity(int cpu) {
+    // Pinning threads isn't supported on this platform.
+    return false;
+}
+
+WEAK int halide_host_cpu_quota() {
+    // Cpu quotas aren't supported on this platform.
+    return 0;
+}
+
+}}}
@@ -50,6 +50,7 @@ WEAK bool halide_default_semaphore_try_acquire(halide_semaphore_t *s, int n) {
 
 namespace Halide { namespace Runtime { namespace Internal {
 
+WEAK halide_timeline_event_fn halide_timeline_event_hook = NULL;
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_loop_task_t custom_do_loop_task = halide_default_do_loop_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
@@ -58,6 +59,11 @@ WEAK halide_semaphore_init_t custom_semaphore_init = halide_default_semaphore_in
 WEAK halide_semaphore_try_acquire_t custom_semaphore_try_acquire = halide_default_semaphore_try_acquire;
 WEAK halide_semaphore_release_t custom_semaphore_release = halide_default_semaphore_release;
 
+WEAK uint64_t halide_current_thread_id() {
+    // There is only ever one thread.
+    return 0;
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -88,6 +94,16 @@ WEAK int halide_set_num_threads(int n) {
     return 1;
 }
 
+WEAK int halide_set_thread_pool_priority(void *user_context, int priority, int max_threads) {
+    // Everything runs on the calling thread anyway.
+    return 0;
+}
+
+WEAK int halide_set_thread_pool_idle_timeout(int ms) {
+    // There are no worker threads to retire.
+    return 0;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
@@ -72,4 +72,19 @@ WEAK double halide_float16_bits_to_double(uint16_t bits) {
     return (double) valueAsFloat;
 }
 
+WEAK float halide_bfloat16_bits_to_float(uint16_t bits) {
+    // bfloat16 is the top half of a float, so no rounding or
+    // re-encoding is required.
+    union {
+        uint32_t asUInt;
+        float asFloat;
+    } result;
+    result.asUInt = ((uint32_t) bits) << 16;
+    return result.asFloat;
+}
+
+WEAK double halide_bfloat16_bits_to_double(uint16_t bits) {
+    return (double) halide_bfloat16_bits_to_float(bits);
+}
+
 }
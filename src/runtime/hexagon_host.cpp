@@ -29,6 +29,9 @@ typedef int (*remote_get_symbol_fn)(halide_hexagon_handle_t, const char*, int, h
 typedef int (*remote_run_fn)(halide_hexagon_handle_t, int,
                              const remote_buffer*, int, const remote_buffer*, int,
                              remote_buffer*, int);
+typedef int (*remote_run_batch_fn)(const uint64_t*, int,
+                                   const remote_buffer*, int, remote_buffer*, int,
+                                   const uint64_t*, int);
 typedef int (*remote_release_library_fn)(halide_hexagon_handle_t);
 typedef int (*remote_poll_log_fn)(char *, int, int *);
 typedef void (*remote_poll_profiler_state_fn)(int *, int *);
@@ -45,6 +48,7 @@ typedef void (*host_free_fn)(void *);
 WEAK remote_load_library_fn remote_load_library = NULL;
 WEAK remote_get_symbol_fn remote_get_symbol = NULL;
 WEAK remote_run_fn remote_run = NULL;
+WEAK remote_run_batch_fn remote_run_batch = NULL;
 WEAK remote_release_library_fn remote_release_library = NULL;
 WEAK remote_poll_log_fn remote_poll_log = NULL;
 WEAK remote_poll_profiler_state_fn remote_poll_profiler_state = NULL;
@@ -155,6 +159,9 @@ WEAK int init_hexagon_runtime(void *user_context) {
     get_symbol(user_context, host_lib, "halide_hexagon_remote_set_performance_mode", remote_set_performance_mode, /* required */ false);
     get_symbol(user_context, host_lib, "halide_hexagon_remote_set_thread_priority", remote_set_thread_priority, /* required */ false);
 
+    // If this is unavailable, halide_hexagon_begin_batch does nothing, and pipelines run immediately.
+    get_symbol(user_context, host_lib, "halide_hexagon_remote_run_batch", remote_run_batch, /* required */ false);
+
     host_malloc_init();
 
     return 0;
@@ -334,6 +341,88 @@ WEAK int map_arguments(void *user_context, int arg_count,
     return mapped_count;
 }
 
+// The pipeline invocations queued between halide_hexagon_begin_batch
+// and halide_hexagon_end_batch, in the form halide_hexagon_remote_run_batch
+// expects them.
+struct hexagon_batch {
+    bool active;
+    // Five entries per call: module, function, and the number of
+    // input buffers, output buffers and scalars.
+    uint64_t *calls;
+    int call_count, call_capacity;
+    remote_buffer *input_buffers;
+    int input_count, input_capacity;
+    remote_buffer *output_buffers;
+    int output_count, output_capacity;
+    // Scalars are copied by value, because the arguments passed to
+    // halide_hexagon_run don't outlive the call.
+    uint64_t *scalars;
+    int scalar_count, scalar_capacity;
+};
+WEAK hexagon_batch batch = { false, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0 };
+WEAK halide_mutex batch_lock = { { 0 } };
+
+WEAK bool batch_append(void **array, int &count, int &capacity,
+                       const void *elems, int n, size_t elem_size) {
+    if (count + n > capacity) {
+        int new_capacity = capacity * 2;
+        if (new_capacity < count + n) {
+            new_capacity = count + n;
+        }
+        if (new_capacity < 16) {
+            new_capacity = 16;
+        }
+        void *new_array = malloc(new_capacity * elem_size);
+        if (!new_array) {
+            return false;
+        }
+        if (*array) {
+            memcpy(new_array, *array, count * elem_size);
+            free(*array);
+        }
+        *array = new_array;
+        capacity = new_capacity;
+    }
+    memcpy((uint8_t *)*array + count * elem_size, elems, n * elem_size);
+    count += n;
+    return true;
+}
+
+WEAK int enqueue_batched_run(void *user_context, halide_hexagon_handle_t module, halide_hexagon_handle_t function,
+                             const remote_buffer *input_buffers, int input_buffer_count,
+                             const remote_buffer *output_buffers, int output_buffer_count,
+                             const remote_buffer *input_scalars, int input_scalar_count) {
+    uint64_t *scalars = (uint64_t *)__builtin_alloca(input_scalar_count * sizeof(uint64_t));
+    for (int i = 0; i < input_scalar_count; i++) {
+        if (input_scalars[i].dataLen > (int)sizeof(uint64_t)) {
+            error(user_context) << "Hexagon: Scalar argument " << i << " is larger than "
+                                << (int)sizeof(uint64_t) << " bytes\n";
+            return -1;
+        }
+        scalars[i] = 0;
+        memcpy(&scalars[i], input_scalars[i].data, input_scalars[i].dataLen);
+    }
+    uint64_t call[] = {
+        (uint64_t)module,
+        (uint64_t)function,
+        (uint64_t)input_buffer_count,
+        (uint64_t)output_buffer_count,
+        (uint64_t)input_scalar_count,
+    };
+    if (!batch_append((void **)&batch.calls, batch.call_count, batch.call_capacity,
+                      call, 5, sizeof(uint64_t)) ||
+        !batch_append((void **)&batch.input_buffers, batch.input_count, batch.input_capacity,
+                      input_buffers, input_buffer_count, sizeof(remote_buffer)) ||
+        !batch_append((void **)&batch.output_buffers, batch.output_count, batch.output_capacity,
+                      output_buffers, output_buffer_count, sizeof(remote_buffer)) ||
+        !batch_append((void **)&batch.scalars, batch.scalar_count, batch.scalar_capacity,
+                      scalars, input_scalar_count, sizeof(uint64_t))) {
+        error(user_context) << "Hexagon: Out of memory queueing pipeline run\n";
+        return -1;
+    }
+    return 0;
+}
+
 }  // namespace
 
 WEAK int halide_hexagon_run(void *user_context,
@@ -394,6 +483,17 @@ WEAK int halide_hexagon_run(void *user_context,
                                            input_scalars);
     if (input_scalar_count < 0) return input_scalar_count;
 
+    {
+        ScopedMutexLock lock(&batch_lock);
+        if (batch.active) {
+            debug(user_context) << "    queueing for halide_hexagon_remote_run_batch\n";
+            return enqueue_batched_run(user_context, module, *function,
+                                       input_buffers, input_buffer_count,
+                                       output_buffers, output_buffer_count,
+                                       input_scalars, input_scalar_count);
+        }
+    }
+
     #ifdef DEBUG_RUNTIME
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
@@ -432,6 +532,70 @@ WEAK int halide_hexagon_run(void *user_context,
     return result != 0 ? -1 : 0;
 }
 
+WEAK int halide_hexagon_begin_batch(void *user_context) {
+    debug(user_context) << "Hexagon: halide_hexagon_begin_batch (user_context: " << user_context << ")\n";
+    int result = init_hexagon_runtime(user_context);
+    if (result != 0) return result;
+
+    if (!remote_run_batch) {
+        // Older remote runtimes can't run batches; just run each
+        // pipeline as it is called.
+        debug(user_context) << "    halide_hexagon_remote_run_batch not available, not batching\n";
+        return 0;
+    }
+
+    ScopedMutexLock lock(&batch_lock);
+    if (batch.active) {
+        error(user_context) << "Hexagon: halide_hexagon_begin_batch called while a batch is already active\n";
+        return -1;
+    }
+    batch.active = true;
+    return 0;
+}
+
+WEAK int halide_hexagon_end_batch(void *user_context) {
+    debug(user_context) << "Hexagon: halide_hexagon_end_batch (user_context: " << user_context << ")\n";
+
+    ScopedMutexLock lock(&batch_lock);
+    if (!batch.active) {
+        return 0;
+    }
+    batch.active = false;
+    if (batch.call_count == 0) {
+        return 0;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    debug(user_context) << "    halide_hexagon_remote_run_batch (" << batch.call_count / 5 << " pipelines) -> ";
+    int result = remote_run_batch(batch.calls, batch.call_count,
+                                  batch.input_buffers, batch.input_count,
+                                  batch.output_buffers, batch.output_count,
+                                  batch.scalars, batch.scalar_count);
+    poll_log(user_context);
+    debug(user_context) << "        " << result << "\n";
+
+    // Keep the storage for the next batch.
+    batch.call_count = 0;
+    batch.input_count = 0;
+    batch.output_count = 0;
+    batch.scalar_count = 0;
+
+    if (result != 0) {
+        error(user_context) << "Hexagon pipeline failed.\n";
+        return result;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
 WEAK int halide_hexagon_device_release(void *user_context) {
     debug(user_context)
         << "Hexagon: halide_hexagon_device_release (user_context: " <<  user_context << ")\n";
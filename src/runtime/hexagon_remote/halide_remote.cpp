@@ -440,6 +440,55 @@ int halide_hexagon_remote_run_v2(handle_t module_ptr, handle_t function,
     return result;
 }
 
+int halide_hexagon_remote_run_batch(const scalar_t *calls, int callsLen,
+                                    const buffer *input_buffersPtrs, int input_buffersLen,
+                                    buffer *output_buffersPtrs, int output_buffersLen,
+                                    const scalar_t *scalars, int scalarsLen) {
+    const int fields_per_call = 5;
+    if (callsLen % fields_per_call != 0) {
+        log_printf("halide_hexagon_remote_run_batch: malformed call list\n");
+        return -1;
+    }
+
+    // Keep HVX powered on across the whole batch, rather than
+    // powering it off and on again between pipelines.
+    int result = halide_hexagon_remote_power_hvx_on();
+    if (result != 0) {
+        return result;
+    }
+
+    for (int i = 0; i < callsLen && result == 0; i += fields_per_call) {
+        handle_t module_ptr = (handle_t)calls[i];
+        handle_t function = (handle_t)calls[i + 1];
+        int input_count = (int)calls[i + 2];
+        int output_count = (int)calls[i + 3];
+        int scalar_count = (int)calls[i + 4];
+        if (input_count > input_buffersLen ||
+            output_count > output_buffersLen ||
+            scalar_count > scalarsLen) {
+            log_printf("halide_hexagon_remote_run_batch: call %d has too many arguments\n", i / fields_per_call);
+            result = -1;
+            break;
+        }
+
+        result = halide_hexagon_remote_run_v2(module_ptr, function,
+                                              input_buffersPtrs, input_count,
+                                              output_buffersPtrs, output_count,
+                                              scalars, scalar_count);
+
+        input_buffersPtrs += input_count;
+        input_buffersLen -= input_count;
+        output_buffersPtrs += output_count;
+        output_buffersLen -= output_count;
+        scalars += scalar_count;
+        scalarsLen -= scalar_count;
+    }
+
+    halide_hexagon_remote_power_hvx_off();
+
+    return result;
+}
+
 int halide_hexagon_remote_release_library(handle_t module_ptr) {
     if (use_dlopenbuf()) {
         dlclose(reinterpret_cast<void*>(module_ptr));
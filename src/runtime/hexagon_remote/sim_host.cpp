@@ -433,6 +433,57 @@ int halide_hexagon_remote_run(handle_t module_ptr, handle_t function,
     return ret;
 }
 
+DLLEXPORT
+int halide_hexagon_remote_run_batch(const uint64_t *calls, int callsLen,
+                                    const host_buffer *input_buffersPtrs, int input_buffersLen,
+                                    host_buffer *output_buffersPtrs, int output_buffersLen,
+                                    const uint64_t *scalars, int scalarsLen) {
+    // There is no RPC overhead to save on the simulator, so just run
+    // the pipelines one at a time, in order.
+    const int fields_per_call = 5;
+    if (callsLen % fields_per_call != 0) {
+        printf("halide_hexagon_remote_run_batch: malformed call list\n");
+        return -1;
+    }
+
+    for (int i = 0; i < callsLen; i += fields_per_call) {
+        handle_t module_ptr = static_cast<handle_t>(calls[i]);
+        handle_t function = static_cast<handle_t>(calls[i + 1]);
+        int input_count = static_cast<int>(calls[i + 2]);
+        int output_count = static_cast<int>(calls[i + 3]);
+        int scalar_count = static_cast<int>(calls[i + 4]);
+        if (input_count > input_buffersLen ||
+            output_count > output_buffersLen ||
+            scalar_count > scalarsLen) {
+            printf("halide_hexagon_remote_run_batch: call %d has too many arguments\n", i / fields_per_call);
+            return -1;
+        }
+
+        // The scalars are passed by value, but run expects pointers
+        // to them.
+        std::vector<host_buffer> input_scalars(scalar_count);
+        for (int j = 0; j < scalar_count; j++) {
+            input_scalars[j].data = (unsigned char *)&scalars[j];
+            input_scalars[j].dataLen = sizeof(uint64_t);
+        }
+
+        int ret = halide_hexagon_remote_run(module_ptr, function,
+                                            input_buffersPtrs, input_count,
+                                            output_buffersPtrs, output_count,
+                                            input_scalars.data(), scalar_count);
+        if (ret != 0) return ret;
+
+        input_buffersPtrs += input_count;
+        input_buffersLen -= input_count;
+        output_buffersPtrs += output_count;
+        output_buffersLen -= output_count;
+        scalars += scalar_count;
+        scalarsLen -= scalar_count;
+    }
+
+    return 0;
+}
+
 DLLEXPORT
 int halide_hexagon_remote_release_library(handle_t module_ptr) {
     std::lock_guard<std::mutex> guard(mutex);
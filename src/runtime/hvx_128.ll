@@ -473,3 +473,143 @@ define weak_odr void @halide.hexagon.scatter.release(i8* %ptr) nounwind uwtable
   call void asm sideeffect "vmem($0 + #0):scatter_release\0A; v1 = vmem($0 + #0)\0A", "=*m,*m,~{v1}"(i8* %ptr, i8* %ptr)
   ret void
 }
+
+; v68 IEEE floating point arithmetic. The intrinsics operate on
+; integer vectors, so these wrappers take and return float
+; vectors. Widening operations produce their results deinterleaved
+; (even lanes in the low vector, odd lanes in the high vector), like
+; the integer widening operations; the wrappers reinterleave them so
+; the results are in order.
+declare <32 x i32> @llvm.hexagon.V6.vadd.sf.sf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vsub.sf.sf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vmpy.sf.sf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vfmax.sf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vfmin.sf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vadd.hf.hf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vsub.hf.hf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vmpy.hf.hf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vfmax.hf.128B(<32 x i32>, <32 x i32>)
+declare <32 x i32> @llvm.hexagon.V6.vfmin.hf.128B(<32 x i32>, <32 x i32>)
+
+define weak_odr <32 x float> @halide.hexagon.add.vsf.vsf(<32 x float> %a, <32 x float> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <32 x float> %a to <32 x i32>
+  %b_32 = bitcast <32 x float> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vadd.sf.sf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <32 x float>
+  ret <32 x float> %r
+}
+
+define weak_odr <32 x float> @halide.hexagon.sub.vsf.vsf(<32 x float> %a, <32 x float> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <32 x float> %a to <32 x i32>
+  %b_32 = bitcast <32 x float> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vsub.sf.sf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <32 x float>
+  ret <32 x float> %r
+}
+
+define weak_odr <32 x float> @halide.hexagon.mul.vsf.vsf(<32 x float> %a, <32 x float> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <32 x float> %a to <32 x i32>
+  %b_32 = bitcast <32 x float> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vmpy.sf.sf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <32 x float>
+  ret <32 x float> %r
+}
+
+define weak_odr <32 x float> @halide.hexagon.max.vsf.vsf(<32 x float> %a, <32 x float> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <32 x float> %a to <32 x i32>
+  %b_32 = bitcast <32 x float> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vfmax.sf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <32 x float>
+  ret <32 x float> %r
+}
+
+define weak_odr <32 x float> @halide.hexagon.min.vsf.vsf(<32 x float> %a, <32 x float> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <32 x float> %a to <32 x i32>
+  %b_32 = bitcast <32 x float> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vfmin.sf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <32 x float>
+  ret <32 x float> %r
+}
+
+define weak_odr <64 x half> @halide.hexagon.add.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vadd.hf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <64 x half>
+  ret <64 x half> %r
+}
+
+define weak_odr <64 x half> @halide.hexagon.sub.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vsub.hf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <64 x half>
+  ret <64 x half> %r
+}
+
+define weak_odr <64 x half> @halide.hexagon.mul.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vmpy.hf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <64 x half>
+  ret <64 x half> %r
+}
+
+define weak_odr <64 x half> @halide.hexagon.max.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vfmax.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <64 x half>
+  ret <64 x half> %r
+}
+
+define weak_odr <64 x half> @halide.hexagon.min.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_32 = call <32 x i32> @llvm.hexagon.V6.vfmin.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r = bitcast <32 x i32> %r_32 to <64 x half>
+  ret <64 x half> %r
+}
+
+declare <64 x i32> @llvm.hexagon.V6.vmpy.sf.hf.128B(<32 x i32>, <32 x i32>)
+declare <64 x i32> @llvm.hexagon.V6.vmpy.sf.hf.acc.128B(<64 x i32>, <32 x i32>, <32 x i32>)
+declare <64 x i32> @llvm.hexagon.V6.vadd.sf.hf.128B(<32 x i32>, <32 x i32>)
+declare <64 x i32> @llvm.hexagon.V6.vsub.sf.hf.128B(<32 x i32>, <32 x i32>)
+
+define weak_odr <64 x float> @halide.hexagon.mpy.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_d = call <64 x i32> @llvm.hexagon.V6.vmpy.sf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r_32 = call <64 x i32> @halide.hexagon.interleave.vw(<64 x i32> %r_d)
+  %r = bitcast <64 x i32> %r_32 to <64 x float>
+  ret <64 x float> %r
+}
+
+define weak_odr <64 x float> @halide.hexagon.add_mpy.vsf.vhf.vhf(<64 x float> %acc, <64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %acc_32 = bitcast <64 x float> %acc to <64 x i32>
+  %acc_d = call <64 x i32> @halide.hexagon.deinterleave.vw(<64 x i32> %acc_32)
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_d = call <64 x i32> @llvm.hexagon.V6.vmpy.sf.hf.acc.128B(<64 x i32> %acc_d, <32 x i32> %a_32, <32 x i32> %b_32)
+  %r_32 = call <64 x i32> @halide.hexagon.interleave.vw(<64 x i32> %r_d)
+  %r = bitcast <64 x i32> %r_32 to <64 x float>
+  ret <64 x float> %r
+}
+
+define weak_odr <64 x float> @halide.hexagon.add_vsf.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_d = call <64 x i32> @llvm.hexagon.V6.vadd.sf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r_32 = call <64 x i32> @halide.hexagon.interleave.vw(<64 x i32> %r_d)
+  %r = bitcast <64 x i32> %r_32 to <64 x float>
+  ret <64 x float> %r
+}
+
+define weak_odr <64 x float> @halide.hexagon.sub_vsf.vhf.vhf(<64 x half> %a, <64 x half> %b) nounwind uwtable readnone alwaysinline {
+  %a_32 = bitcast <64 x half> %a to <32 x i32>
+  %b_32 = bitcast <64 x half> %b to <32 x i32>
+  %r_d = call <64 x i32> @llvm.hexagon.V6.vsub.sf.hf.128B(<32 x i32> %a_32, <32 x i32> %b_32)
+  %r_32 = call <64 x i32> @halide.hexagon.interleave.vw(<64 x i32> %r_d)
+  %r = bitcast <64 x i32> %r_32 to <64 x float>
+  ret <64 x float> %r
+}
@@ -0,0 +1,62 @@
+#include "runtime_internal.h"
+
+extern "C" {
+
+extern void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+extern int munmap(void *addr, size_t length);
+extern int madvise(void *addr, size_t length, int advice);
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define MAP_PRIVATE 0x02
+#define MAP_ANONYMOUS 0x20
+#define MAP_HUGETLB 0x40000
+#define MADV_HUGEPAGE 14
+#define MAP_FAILED ((void *)-1)
+
+WEAK size_t large_page_size() {
+    return 2 * 1024 * 1024;
+}
+
+// Large allocations first try the reserved huge pages of hugetlbfs, and
+// then ask for transparent huge pages for a mapping aligned to them.
+WEAK void *large_page_map(size_t size) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        return p;
+    }
+
+    // Map an extra page, and trim the mapping down to one aligned to
+    // the large page size, so that all of it can be backed by them.
+    const size_t page = large_page_size();
+    uint8_t *base = (uint8_t *)mmap(NULL, size + page, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((void *)base == MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t *aligned = (uint8_t *)(((size_t)base + page - 1) & ~(page - 1));
+    if (aligned > base) {
+        munmap(base, aligned - base);
+    }
+    if (aligned + size < base + size + page) {
+        munmap(aligned + size, (base + size + page) - (aligned + size));
+    }
+    // Transparent huge pages may be disabled, or only enabled on
+    // request; either way the mapping still works with small pages.
+    madvise(aligned, size, MADV_HUGEPAGE);
+    return aligned;
+}
+
+WEAK void large_page_unmap(void *base, size_t size) {
+    munmap(base, size);
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+#define HALIDE_LARGE_PAGES 1
+#include "posix_allocator.cpp"
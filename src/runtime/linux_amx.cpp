@@ -0,0 +1,30 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+// Linux (5.16 and later) disables the AMX tile data state by default,
+// and a process must request it with arch_prctl before its first tile
+// instruction, or that instruction faults. The permission is
+// per-process, so we only need to ask once.
+
+#define SYS_ARCH_PRCTL 158
+#define ARCH_REQ_XCOMP_PERM 0x1023
+#define XFEATURE_XTILEDATA 18
+
+extern int syscall(int num, ...);
+
+WEAK bool halide_x86_amx_permission_granted = false;
+
+WEAK int halide_x86_amx_request_permission(void *user_context) {
+    if (!halide_x86_amx_permission_granted) {
+        if (syscall(SYS_ARCH_PRCTL, ARCH_REQ_XCOMP_PERM, XFEATURE_XTILEDATA) != 0) {
+            halide_error(user_context, "The kernel refused to enable the AMX tile registers for this process\n");
+            return halide_error_code_generic_error;
+        }
+        halide_x86_amx_permission_granted = true;
+    }
+    return 0;
+}
+
+}
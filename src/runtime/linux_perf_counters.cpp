@@ -0,0 +1,99 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" int syscall(int num, ...);
+extern "C" ssize_t read(int fd, void *buf, size_t bytes);
+
+// The syscall numbers for perf_event_open and gettid vary across
+// platforms. This module is only used on x86 linux:
+// -- x64 is 298 and 186
+// -- i386 is 336 and 224
+#ifdef BITS_64
+#define SYS_PERF_EVENT_OPEN 298
+#define SYS_GETTID 186
+#endif
+
+#ifdef BITS_32
+#define SYS_PERF_EVENT_OPEN 336
+#define SYS_GETTID 224
+#endif
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The first 64 bytes of the kernel's struct perf_event_attr
+// (PERF_ATTR_SIZE_VER0), which is all we need.
+struct perf_event_attr {
+    uint32_t type;
+    uint32_t size;
+    uint64_t config;
+    uint64_t sample_period;
+    uint64_t sample_type;
+    uint64_t read_format;
+    uint64_t flags;
+    uint32_t wakeup_events;
+    uint32_t bp_type;
+    uint64_t config1;
+};
+
+enum {
+    perf_type_hardware = 0,
+    perf_format_group = 1 << 3,
+    perf_flag_exclude_kernel = 1 << 5,
+    perf_flag_exclude_hv = 1 << 6,
+};
+
+WEAK int halide_perf_counters_thread_id() {
+    return syscall(SYS_GETTID);
+}
+
+WEAK int halide_perf_counters_open() {
+    // The generic hardware events, in the order of halide_perf_counter_t.
+    const uint64_t configs[halide_perf_num_counters] = {
+        0,  // PERF_COUNT_HW_CPU_CYCLES
+        1,  // PERF_COUNT_HW_INSTRUCTIONS
+        3,  // PERF_COUNT_HW_CACHE_MISSES
+        5,  // PERF_COUNT_HW_BRANCH_MISSES
+    };
+    int group = -1;
+    for (int i = 0; i < halide_perf_num_counters; i++) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = perf_type_hardware;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.read_format = perf_format_group;
+        // Only count user-space events, which is permitted at the
+        // default perf_event_paranoid level.
+        attr.flags = perf_flag_exclude_kernel | perf_flag_exclude_hv;
+        // A pid of zero and a cpu of -1 means the calling thread, on
+        // whatever cpu it runs.
+        int fd = syscall(SYS_PERF_EVENT_OPEN, &attr, 0, -1, group, 0);
+        if (fd < 0) {
+            if (group >= 0) {
+                // Closing the leader closes its whole group.
+                close(group);
+            }
+            return -1;
+        }
+        if (group < 0) {
+            group = fd;
+        }
+    }
+    return group;
+}
+
+WEAK bool halide_perf_counters_read(int group, uint64_t *values) {
+    // With PERF_FORMAT_GROUP, a read returns the number of counters
+    // followed by their values.
+    uint64_t buf[halide_perf_num_counters + 1];
+    if (read(group, buf, sizeof(buf)) != (ssize_t)sizeof(buf) ||
+        buf[0] != halide_perf_num_counters) {
+        return false;
+    }
+    for (int i = 0; i < halide_perf_num_counters; i++) {
+        values[i] = buf[i + 1];
+    }
+    return true;
+}
+
+}}}
@@ -0,0 +1,61 @@
+#include "runtime_internal.h"
+
+extern "C" int sched_setaffinity(int pid, size_t cpusetsize, const void *mask);
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK bool halide_thread_set_affinity(int cpu) {
+    // A cpu_set_t is a 1024-bit mask in glibc and bionic.
+    uint64_t mask[1024 / 64];
+    if (cpu < 0 || cpu >= 1024) {
+        return false;
+    }
+    memset(mask, 0, sizeof(mask));
+    mask[cpu / 64] = (uint64_t)1 << (cpu % 64);
+    // A pid of zero means the calling thread.
+    return sched_setaffinity(0, sizeof(mask), mask) == 0;
+}
+
+// Read up to size - 1 bytes of a small file into a null-terminated
+// buffer. Returns false if it can't be read.
+WEAK bool read_small_file(const char *filename, char *buf, size_t size) {
+    void *f = fopen(filename, "r");
+    if (!f) {
+        return false;
+    }
+    size_t n = fread(buf, 1, size - 1, f);
+    fclose(f);
+    buf[n] = 0;
+    return n > 0;
+}
+
+WEAK int cpus_for_quota(int64_t quota, int64_t period) {
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return (int)((quota + period - 1) / period);
+}
+
+WEAK int halide_host_cpu_quota() {
+    // This reads the cgroup the process sees at the root of the
+    // cgroup filesystem, which inside a container is the container's
+    // own. First try cgroup v2, where cpu.max holds "<quota> <period>"
+    // or "max <period>".
+    char buf[64];
+    if (read_small_file("/sys/fs/cgroup/cpu.max", buf, sizeof(buf))) {
+        if (strncmp(buf, "max", 3) == 0) {
+            return 0;
+        }
+        const char *period = strchr(buf, ' ');
+        return period ? cpus_for_quota(atoi(buf), atoi(period + 1)) : 0;
+    }
+    // Then cgroup v1, where a quota of -1 means there is no limit.
+    char period[64];
+    if (read_small_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", buf, sizeof(buf)) &&
+        read_small_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us", period, sizeof(period))) {
+        return cpus_for_quota(atoi(buf), atoi(period));
+    }
+    return 0;
+}
+
+}}}
@@ -0,0 +1,257 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+// A memory pool used by Func::hoist_storage. The pool is created
+// outside of some loops, and each iteration of those loops acquires a
+// block from it and releases it at the end of the iteration. Blocks are
+// recycled rather than freed, so the pool holds at most one block per
+// concurrently-running iteration, and each block is as large as the
+// largest request made of it.
+//
+// This file also contains the arena used by Target::ArenaAlloc for
+// allocations that happen once per pipeline invocation. They are
+// carved out of large chunks and released in bulk when the pipeline
+// finishes. The largest chunk is kept for the next invocation.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+struct memory_pool;
+
+struct memory_pool_block {
+    memory_pool_block *next;
+    memory_pool *pool;
+    size_t size;
+};
+
+struct memory_pool {
+    halide_mutex mutex;
+    memory_pool_block *free_blocks;
+};
+
+// The header lives immediately before the memory handed out by
+// acquire. Round it up so that the payload keeps the alignment
+// halide_malloc gives the block.
+WEAK __attribute__((always_inline)) size_t memory_pool_header_size() {
+    size_t alignment = (size_t)halide_malloc_alignment();
+    return (sizeof(memory_pool_block) + alignment - 1) & ~(alignment - 1);
+}
+
+WEAK __attribute__((always_inline)) void *memory_pool_payload(memory_pool_block *block) {
+    return (void *)((uint8_t *)block + memory_pool_header_size());
+}
+
+struct arena_chunk {
+    arena_chunk *next;
+    size_t size, used;
+};
+
+struct arena {
+    halide_mutex mutex;
+    arena_chunk *chunks;
+};
+
+// The smallest chunk worth asking halide_malloc for.
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+
+// A chunk kept from the last pipeline invocation to finish.
+WEAK arena_chunk *arena_spare_chunk = NULL;
+WEAK halide_mutex arena_spare_chunk_mutex;
+
+WEAK __attribute__((always_inline)) size_t arena_round_up(size_t size) {
+    size_t alignment = (size_t)halide_malloc_alignment();
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+WEAK __attribute__((always_inline)) void *arena_chunk_payload(arena_chunk *chunk) {
+    return (void *)((uint8_t *)chunk + arena_round_up(sizeof(arena_chunk)));
+}
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK void *halide_memory_pool_create(void *user_context) {
+    memory_pool *pool = (memory_pool *)halide_malloc(user_context, sizeof(memory_pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    memset(&pool->mutex, 0, sizeof(pool->mutex));
+    pool->free_blocks = NULL;
+    return pool;
+}
+
+WEAK void *halide_memory_pool_acquire(void *user_context, void *p, uint64_t size) {
+    memory_pool *pool = (memory_pool *)p;
+    if (pool == NULL || size == 0) {
+        return NULL;
+    }
+
+    memory_pool_block *block = NULL;
+    {
+        ScopedMutexLock lock(&pool->mutex);
+        // Prefer a free block that is already large enough. Failing
+        // that, take any free block and grow it.
+        memory_pool_block **prev = &pool->free_blocks;
+        for (memory_pool_block *b = pool->free_blocks; b; b = b->next) {
+            if (b->size >= size) {
+                *prev = b->next;
+                block = b;
+                break;
+            }
+            prev = &b->next;
+        }
+        if (block == NULL && pool->free_blocks != NULL) {
+            block = pool->free_blocks;
+            pool->free_blocks = block->next;
+        }
+    }
+
+    if (block != NULL && block->size < size) {
+        halide_free(user_context, block);
+        block = NULL;
+    }
+
+    if (block == NULL) {
+        block = (memory_pool_block *)halide_malloc(user_context, memory_pool_header_size() + size);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->pool = pool;
+        block->size = size;
+    }
+    block->next = NULL;
+    return memory_pool_payload(block);
+}
+
+WEAK void halide_memory_pool_release(void *user_context, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    memory_pool_block *block = (memory_pool_block *)((uint8_t *)ptr - memory_pool_header_size());
+    memory_pool *pool = block->pool;
+    ScopedMutexLock lock(&pool->mutex);
+    block->next = pool->free_blocks;
+    pool->free_blocks = block;
+}
+
+WEAK void halide_memory_pool_destroy(void *user_context, void *p) {
+    memory_pool *pool = (memory_pool *)p;
+    if (pool == NULL) {
+        return;
+    }
+    memory_pool_block *block = pool->free_blocks;
+    while (block) {
+        memory_pool_block *next = block->next;
+        halide_free(user_context, block);
+        block = next;
+    }
+    halide_free(user_context, pool);
+}
+
+WEAK void *halide_arena_create(void *user_context) {
+    arena *a = (arena *)halide_malloc(user_context, sizeof(arena));
+    if (a == NULL) {
+        return NULL;
+    }
+    memset(&a->mutex, 0, sizeof(a->mutex));
+    ScopedMutexLock lock(&arena_spare_chunk_mutex);
+    a->chunks = arena_spare_chunk;
+    arena_spare_chunk = NULL;
+    return a;
+}
+
+WEAK void *halide_arena_alloc(void *user_context, void *p, uint64_t size) {
+    arena *a = (arena *)p;
+    if (a == NULL || size == 0) {
+        return NULL;
+    }
+    size = arena_round_up(size);
+
+    ScopedMutexLock lock(&a->mutex);
+    arena_chunk *chunk = a->chunks;
+    if (chunk == NULL || chunk->used + size > chunk->size) {
+        // Grow geometrically, so that a pipeline with many
+        // allocations only makes a few calls to halide_malloc.
+        size_t chunk_size = ARENA_MIN_CHUNK_SIZE;
+        if (chunk != NULL && chunk->size * 2 > chunk_size) {
+            chunk_size = chunk->size * 2;
+        }
+        if (size > chunk_size) {
+            chunk_size = size;
+        }
+        chunk = (arena_chunk *)halide_malloc(user_context, arena_round_up(sizeof(arena_chunk)) + chunk_size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = a->chunks;
+        a->chunks = chunk;
+    }
+    void *result = (uint8_t *)arena_chunk_payload(chunk) + chunk->used;
+    chunk->used += size;
+    return result;
+}
+
+WEAK void halide_arena_free(void *user_context, void *ptr) {
+    // Memory in the arena is released all at once by halide_arena_destroy.
+}
+
+WEAK void halide_arena_destroy(void *user_context, void *p) {
+    arena *a = (arena *)p;
+    if (a == NULL) {
+        return;
+    }
+    // Keep the largest chunk around for the next invocation.
+    arena_chunk *largest = NULL;
+    arena_chunk *chunk = a->chunks;
+    while (chunk) {
+        arena_chunk *next = chunk->next;
+        if (largest == NULL || chunk->size > largest->size) {
+            if (largest) {
+                halide_free(user_context, largest);
+            }
+            largest = chunk;
+        } else {
+            halide_free(user_context, chunk);
+        }
+        chunk = next;
+    }
+    halide_free(user_context, a);
+
+    if (largest) {
+        largest->next = NULL;
+        largest->used = 0;
+        ScopedMutexLock lock(&arena_spare_chunk_mutex);
+        if (arena_spare_chunk == NULL || arena_spare_chunk->size < largest->size) {
+            arena_chunk *t = arena_spare_chunk;
+            arena_spare_chunk = largest;
+            largest = t;
+        }
+    }
+    if (largest) {
+        halide_free(user_context, largest);
+    }
+}
+
+WEAK void halide_arena_cleanup() {
+    ScopedMutexLock lock(&arena_spare_chunk_mutex);
+    if (arena_spare_chunk) {
+        halide_free(NULL, arena_spare_chunk);
+        arena_spare_chunk = NULL;
+    }
+}
+
+namespace {
+
+__attribute__((destructor))
+WEAK void halide_arena_cleanup_on_unload() {
+    halide_arena_cleanup();
+}
+
+}
+
+}
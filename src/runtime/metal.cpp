@@ -11,6 +11,8 @@
 extern "C" {
 extern objc_id MTLCreateSystemDefaultDevice();
 extern struct ObjectiveCClass _NSConcreteGlobalBlock;
+void *dispatch_data_create(const void *buffer, size_t size, void *queue, void *destructor);
+void dispatch_release(void *object);
 }
 
 namespace Halide { namespace Runtime { namespace Internal { namespace Metal {
@@ -157,6 +159,25 @@ WEAK mtl_library *new_library_with_source(mtl_device *device, const char *source
     return result;
 }
 
+WEAK mtl_library *new_library_with_data(mtl_device *device, const char *data, size_t data_len) {
+    objc_id error_return;
+    // A NULL destructor makes dispatch copy the data.
+    void *dispatch_data = dispatch_data_create(data, data_len, NULL, NULL);
+
+    typedef mtl_library *(*new_library_with_data_method)(objc_id device, objc_sel sel, void *data, objc_id *error_return);
+    new_library_with_data_method method = (new_library_with_data_method)&objc_msgSend;
+    mtl_library *result = (*method)(device, sel_getUid("newLibraryWithData:error:"),
+                                    dispatch_data, &error_return);
+
+    dispatch_release(dispatch_data);
+
+    if (result == NULL) {
+        ns_log_object(error_return);
+    }
+
+    return result;
+}
+
 WEAK mtl_function *new_function_with_name(mtl_library *library, const char *name, size_t name_len) {
     objc_id name_str = wrap_string_as_ns_string(name, name_len);
     typedef mtl_function *(*new_function_with_name_method)(objc_id library, objc_sel sel, objc_id name);
@@ -373,6 +394,15 @@ WEAK command_buffer_completed_handler_block_literal command_buffer_completed_han
     &command_buffer_completed_handler_descriptor
 };
 
+// Frees a device allocation that was held in the device allocation
+// cache.
+WEAK int free_cached_allocation(void *user_context, void *context, uint64_t device) {
+    device_handle *handle = (device_handle *)device;
+    release_ns_object(handle->buf);
+    free(handle);
+    return 0;
+}
+
 }}}} // namespace Halide::Runtime::Internal::Metal
 
 using namespace Halide::Runtime::Internal::Metal;
@@ -408,6 +438,15 @@ WEAK int halide_metal_device_malloc(void *user_context, halide_buffer_t* buf) {
         return metal_context.error;
     }
 
+    uint64_t cached = halide_device_allocation_cache_get(user_context, &metal_device_interface, NULL, size);
+    if (cached) {
+        debug(user_context) << "    reusing cached device buffer " << (void *)cached << "\n";
+        buf->device = cached;
+        buf->device_interface = &metal_device_interface;
+        buf->device_interface->impl->use_module();
+        return 0;
+    }
+
     device_handle *handle = (device_handle *)malloc(sizeof(device_handle));
     if (handle == NULL) {
         return halide_error_code_out_of_memory;
@@ -449,8 +488,11 @@ WEAK int halide_metal_device_free(void *user_context, halide_buffer_t* buf) {
     device_handle *handle = (device_handle *)buf->device;
     halide_assert(user_context, (((device_handle *)buf->device)->offset == 0) && "halide_metal_device_free on buffer obtained from halide_device_crop");
 
-    release_ns_object(handle->buf);
-    free(handle);
+    if (!halide_device_allocation_cache_put(user_context, &metal_device_interface, NULL, buf->size_in_bytes(),
+                                            buf->device, free_cached_allocation)) {
+        release_ns_object(handle->buf);
+        free(handle);
+    }
     buf->device = 0;
     buf->device_interface->impl->release_module();
     buf->device_interface = NULL;
@@ -490,11 +532,22 @@ WEAK int halide_metal_initialize_kernels(void *user_context, void **state_ptr, c
         uint64_t t_before_compile = halide_current_time_ns(user_context);
         #endif
 
-        debug(user_context) << "Metal - Allocating: new_library_with_source " << (*state)->library << "\n";
-        (*state)->library = new_library_with_source(metal_context.device, source, source_size);
-        if ((*state)->library == 0) {
-            error(user_context) << "Metal: new_library_with_source failed.\n";
-            return -1;
+        // Kernels compiled ahead of time with the metal_lib target
+        // feature are a metallib rather than source.
+        if (source_size >= 4 && memcmp(source, "MTLB", 4) == 0) {
+            debug(user_context) << "Metal - Allocating: new_library_with_data " << (*state)->library << "\n";
+            (*state)->library = new_library_with_data(metal_context.device, source, source_size);
+            if ((*state)->library == 0) {
+                error(user_context) << "Metal: new_library_with_data failed.\n";
+                return -1;
+            }
+        } else {
+            debug(user_context) << "Metal - Allocating: new_library_with_source " << (*state)->library << "\n";
+            (*state)->library = new_library_with_source(metal_context.device, source, source_size);
+            if ((*state)->library == 0) {
+                error(user_context) << "Metal: new_library_with_source failed.\n";
+                return -1;
+            }
         }
 
         #ifdef DEBUG_RUNTIME
@@ -563,6 +616,9 @@ WEAK int halide_metal_device_release(void *user_context) {
     if (device) {
         halide_metal_device_sync_internal(queue, NULL);
 
+        // Free any allocations held for reuse before the device goes away.
+        halide_device_allocation_cache_flush(user_context, &metal_device_interface);
+
         // Unload the modules attached to this device. Note that the list
         // nodes themselves are not freed, only the program objects are
         // released. Subsequent calls to halide_init_kernels might re-create
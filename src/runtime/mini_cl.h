@@ -578,6 +578,12 @@ typedef struct _cl_buffer_region {
 #define CL_PROFILING_COMMAND_START                  0x1282
 #define CL_PROFILING_COMMAND_END                    0x1283
 
+/* cl_arm_import_memory extension */
+typedef intptr_t            cl_import_properties_arm;
+#define CL_IMPORT_TYPE_ARM                          0x40B2
+#define CL_IMPORT_TYPE_ANDROID_HARDWARE_BUFFER_ARM  0x41E2
+#define CL_IMPORT_MEMORY_WHOLE_ALLOCATION_ARM       ((size_t)-1)
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,20 @@ typedef struct CUfunc_st *CUfunction;                     /**< CUDA function */
 typedef struct CUstream_st *CUstream;                     /**< CUDA stream */
 typedef struct CUevent_st *CUevent;                       /**< CUDA event */
 typedef struct CUarray_st* CUarray;
+typedef struct CUlinkState_st *CUlinkState;             /**< CUDA JIT linker state */
+
+/** The per-thread default stream. Work on it from different threads can run concurrently. */
+#define CU_STREAM_PER_THREAD ((CUstream)0x2)
+#define CU_STREAM_NON_BLOCKING 0x1
+
+typedef struct CUgraph_st *CUgraph;                       /**< CUDA graph */
+typedef struct CUgraphExec_st *CUgraphExec;               /**< CUDA executable graph */
+
+typedef enum CUstreamCaptureMode_enum {
+    CU_STREAM_CAPTURE_MODE_GLOBAL       = 0,
+    CU_STREAM_CAPTURE_MODE_THREAD_LOCAL = 1,
+    CU_STREAM_CAPTURE_MODE_RELAXED      = 2
+} CUstreamCaptureMode;
 
 typedef enum CUjit_option_enum {
     CU_JIT_MAX_REGISTERS = 0,
@@ -37,6 +51,14 @@ typedef enum CUjit_option_enum {
     CU_JIT_FALLBACK_STRATEGY = 10
 } CUjit_option;
 
+typedef enum CUjitInputType_enum {
+    CU_JIT_INPUT_CUBIN = 0,
+    CU_JIT_INPUT_PTX = 1,
+    CU_JIT_INPUT_FATBINARY = 2,
+    CU_JIT_INPUT_OBJECT = 3,
+    CU_JIT_INPUT_LIBRARY = 4,
+} CUjitInputType;
+
 typedef enum {
     CUDA_SUCCESS                              = 0,
     CUDA_ERROR_INVALID_VALUE                  = 1,
@@ -189,6 +211,16 @@ typedef enum {
     CU_DEVICE_ATTRIBUTE_MAX
 } CUdevice_attribute;
 
+typedef enum {
+    CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK = 0,  /**< Maximum number of threads per block the function can be launched with */
+    CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES = 1,      /**< Statically-allocated shared memory in bytes */
+    CU_FUNC_ATTRIBUTE_CONST_SIZE_BYTES = 2,       /**< User-allocated constant memory in bytes */
+    CU_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES = 3,       /**< Local memory used by each thread in bytes */
+    CU_FUNC_ATTRIBUTE_NUM_REGS = 4,               /**< Number of registers used by each thread */
+    CU_FUNC_ATTRIBUTE_PTX_VERSION = 5,            /**< PTX virtual architecture version */
+    CU_FUNC_ATTRIBUTE_BINARY_VERSION = 6          /**< Binary architecture version */
+} CUfunction_attribute;
+
 typedef enum CUmemorytype_enum {
     CU_MEMORYTYPE_HOST = 0x01,
     CU_MEMORYTYPE_DEVICE = 0x02,
@@ -228,6 +260,11 @@ typedef struct CUDA_MEMCPY3D_st {
 
 #define CU_POINTER_ATTRIBUTE_CONTEXT 1
 
+#define CU_CTX_MAP_HOST 0x08
+
+#define CU_MEMHOSTALLOC_PORTABLE 0x01
+#define CU_MEMHOSTALLOC_DEVICEMAP 0x02
+
 }}}}
 
 #endif
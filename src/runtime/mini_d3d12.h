@@ -7073,6 +7073,10 @@ typedef HRESULT(WINAPI* PFN_D3DCOMPILE)(
            _Out_ ID3DBlob** ppCode,
            _Always_(_Outptr_opt_result_maybenull_) ID3DBlob** ppErrorMsgs);
 
+typedef HRESULT(WINAPI* PFN_D3DCREATEBLOB)(
+           _In_ SIZE_T Size,
+           _Out_ ID3DBlob** ppBlob);
+
 #define D3DCOMPILE_DEBUG                                (1 << 0)
 #define D3DCOMPILE_SKIP_VALIDATION                      (1 << 1)
 #define D3DCOMPILE_SKIP_OPTIMIZATION                    (1 << 2)
@@ -0,0 +1,217 @@
+#ifndef HALIDE_MINI_WEBGPU_H
+#define HALIDE_MINI_WEBGPU_H
+
+// The subset of webgpu.h (the C API shared by Dawn, wgpu-native and
+// Emscripten's WebGPU bindings) used by the Halide runtime.
+
+#define WGPU_WHOLE_SIZE (0xffffffffffffffffULL)
+
+typedef uint32_t WGPUBool;
+typedef uint32_t WGPUFlags;
+
+typedef struct WGPUAdapterImpl *WGPUAdapter;
+typedef struct WGPUBindGroupImpl *WGPUBindGroup;
+typedef struct WGPUBindGroupLayoutImpl *WGPUBindGroupLayout;
+typedef struct WGPUBufferImpl *WGPUBuffer;
+typedef struct WGPUCommandBufferImpl *WGPUCommandBuffer;
+typedef struct WGPUCommandEncoderImpl *WGPUCommandEncoder;
+typedef struct WGPUComputePassEncoderImpl *WGPUComputePassEncoder;
+typedef struct WGPUComputePipelineImpl *WGPUComputePipeline;
+typedef struct WGPUDeviceImpl *WGPUDevice;
+typedef struct WGPUInstanceImpl *WGPUInstance;
+typedef struct WGPUPipelineLayoutImpl *WGPUPipelineLayout;
+typedef struct WGPUQueueImpl *WGPUQueue;
+typedef struct WGPUSamplerImpl *WGPUSampler;
+typedef struct WGPUShaderModuleImpl *WGPUShaderModule;
+typedef struct WGPUTextureViewImpl *WGPUTextureView;
+
+typedef enum WGPUSType {
+    WGPUSType_Invalid = 0x00000000,
+    WGPUSType_ShaderModuleWGSLDescriptor = 0x00000006,
+    WGPUSType_Force32 = 0x7FFFFFFF
+} WGPUSType;
+
+typedef enum WGPUBufferUsage {
+    WGPUBufferUsage_None = 0x00000000,
+    WGPUBufferUsage_MapRead = 0x00000001,
+    WGPUBufferUsage_MapWrite = 0x00000002,
+    WGPUBufferUsage_CopySrc = 0x00000004,
+    WGPUBufferUsage_CopyDst = 0x00000008,
+    WGPUBufferUsage_Uniform = 0x00000040,
+    WGPUBufferUsage_Storage = 0x00000080,
+    WGPUBufferUsage_Force32 = 0x7FFFFFFF
+} WGPUBufferUsage;
+typedef WGPUFlags WGPUBufferUsageFlags;
+
+typedef enum WGPUMapMode {
+    WGPUMapMode_None = 0x00000000,
+    WGPUMapMode_Read = 0x00000001,
+    WGPUMapMode_Write = 0x00000002,
+    WGPUMapMode_Force32 = 0x7FFFFFFF
+} WGPUMapMode;
+typedef WGPUFlags WGPUMapModeFlags;
+
+typedef enum WGPUShaderStage {
+    WGPUShaderStage_None = 0x00000000,
+    WGPUShaderStage_Compute = 0x00000004,
+    WGPUShaderStage_Force32 = 0x7FFFFFFF
+} WGPUShaderStage;
+typedef WGPUFlags WGPUShaderStageFlags;
+
+typedef enum WGPUBufferBindingType {
+    WGPUBufferBindingType_Undefined = 0x00000000,
+    WGPUBufferBindingType_Uniform = 0x00000001,
+    WGPUBufferBindingType_Storage = 0x00000002,
+    WGPUBufferBindingType_ReadOnlyStorage = 0x00000003,
+    WGPUBufferBindingType_Force32 = 0x7FFFFFFF
+} WGPUBufferBindingType;
+
+typedef enum WGPUErrorFilter {
+    WGPUErrorFilter_Validation = 0x00000000,
+    WGPUErrorFilter_OutOfMemory = 0x00000001,
+    WGPUErrorFilter_Internal = 0x00000002,
+    WGPUErrorFilter_Force32 = 0x7FFFFFFF
+} WGPUErrorFilter;
+
+typedef enum WGPUErrorType {
+    WGPUErrorType_NoError = 0x00000000,
+    WGPUErrorType_Force32 = 0x7FFFFFFF
+} WGPUErrorType;
+
+typedef enum WGPUBufferMapAsyncStatus {
+    WGPUBufferMapAsyncStatus_Success = 0x00000000,
+    WGPUBufferMapAsyncStatus_Force32 = 0x7FFFFFFF
+} WGPUBufferMapAsyncStatus;
+
+typedef enum WGPUQueueWorkDoneStatus {
+    WGPUQueueWorkDoneStatus_Success = 0x00000000,
+    WGPUQueueWorkDoneStatus_Force32 = 0x7FFFFFFF
+} WGPUQueueWorkDoneStatus;
+
+typedef enum WGPURequestAdapterStatus {
+    WGPURequestAdapterStatus_Success = 0x00000000,
+    WGPURequestAdapterStatus_Force32 = 0x7FFFFFFF
+} WGPURequestAdapterStatus;
+
+typedef enum WGPURequestDeviceStatus {
+    WGPURequestDeviceStatus_Success = 0x00000000,
+    WGPURequestDeviceStatus_Force32 = 0x7FFFFFFF
+} WGPURequestDeviceStatus;
+
+typedef struct WGPUChainedStruct {
+    const struct WGPUChainedStruct *next;
+    WGPUSType sType;
+} WGPUChainedStruct;
+
+typedef struct WGPUBufferDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    WGPUBufferUsageFlags usage;
+    uint64_t size;
+    WGPUBool mappedAtCreation;
+} WGPUBufferDescriptor;
+
+typedef struct WGPUShaderModuleWGSLDescriptor {
+    WGPUChainedStruct chain;
+    const char *code;
+} WGPUShaderModuleWGSLDescriptor;
+
+typedef struct WGPUShaderModuleDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    size_t hintCount;
+    const void *hints;
+} WGPUShaderModuleDescriptor;
+
+typedef struct WGPUBufferBindingLayout {
+    const WGPUChainedStruct *nextInChain;
+    WGPUBufferBindingType type;
+    WGPUBool hasDynamicOffset;
+    uint64_t minBindingSize;
+} WGPUBufferBindingLayout;
+
+typedef struct WGPUSamplerBindingLayout {
+    const WGPUChainedStruct *nextInChain;
+    uint32_t type;
+} WGPUSamplerBindingLayout;
+
+typedef struct WGPUTextureBindingLayout {
+    const WGPUChainedStruct *nextInChain;
+    uint32_t sampleType;
+    uint32_t viewDimension;
+    WGPUBool multisampled;
+} WGPUTextureBindingLayout;
+
+typedef struct WGPUStorageTextureBindingLayout {
+    const WGPUChainedStruct *nextInChain;
+    uint32_t access;
+    uint32_t format;
+    uint32_t viewDimension;
+} WGPUStorageTextureBindingLayout;
+
+typedef struct WGPUBindGroupLayoutEntry {
+    const WGPUChainedStruct *nextInChain;
+    uint32_t binding;
+    WGPUShaderStageFlags visibility;
+    WGPUBufferBindingLayout buffer;
+    WGPUSamplerBindingLayout sampler;
+    WGPUTextureBindingLayout texture;
+    WGPUStorageTextureBindingLayout storageTexture;
+} WGPUBindGroupLayoutEntry;
+
+typedef struct WGPUBindGroupLayoutDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    size_t entryCount;
+    const WGPUBindGroupLayoutEntry *entries;
+} WGPUBindGroupLayoutDescriptor;
+
+typedef struct WGPUPipelineLayoutDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    size_t bindGroupLayoutCount;
+    const WGPUBindGroupLayout *bindGroupLayouts;
+} WGPUPipelineLayoutDescriptor;
+
+typedef struct WGPUProgrammableStageDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    WGPUShaderModule module;
+    const char *entryPoint;
+    size_t constantCount;
+    const void *constants;
+} WGPUProgrammableStageDescriptor;
+
+typedef struct WGPUComputePipelineDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    WGPUPipelineLayout layout;
+    WGPUProgrammableStageDescriptor compute;
+} WGPUComputePipelineDescriptor;
+
+typedef struct WGPUBindGroupEntry {
+    const WGPUChainedStruct *nextInChain;
+    uint32_t binding;
+    WGPUBuffer buffer;
+    uint64_t offset;
+    uint64_t size;
+    WGPUSampler sampler;
+    WGPUTextureView textureView;
+} WGPUBindGroupEntry;
+
+typedef struct WGPUBindGroupDescriptor {
+    const WGPUChainedStruct *nextInChain;
+    const char *label;
+    WGPUBindGroupLayout layout;
+    size_t entryCount;
+    const WGPUBindGroupEntry *entries;
+} WGPUBindGroupDescriptor;
+
+typedef void (*WGPUBufferMapCallback)(WGPUBufferMapAsyncStatus status, void *userdata);
+typedef void (*WGPUErrorCallback)(WGPUErrorType type, const char *message, void *userdata);
+typedef void (*WGPUQueueWorkDoneCallback)(WGPUQueueWorkDoneStatus status, void *userdata);
+typedef void (*WGPURequestAdapterCallback)(WGPURequestAdapterStatus status, WGPUAdapter adapter,
+                                           const char *message, void *userdata);
+typedef void (*WGPURequestDeviceCallback)(WGPURequestDeviceStatus status, WGPUDevice device,
+                                          const char *message, void *userdata);
+
+#endif  // HALIDE_MINI_WEBGPU_H
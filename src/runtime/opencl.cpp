@@ -70,6 +70,33 @@ extern WEAK halide_device_interface_t opencl_device_interface;
 WEAK const char *get_opencl_error_name(cl_int err);
 WEAK int create_opencl_context(void *user_context, cl_context *ctx, cl_command_queue *q);
 
+// The cl_arm_import_memory extension, used to import memory allocated
+// elsewhere (e.g. an Android AHardwareBuffer) as a cl_mem without a
+// copy. Extension functions aren't exported by the OpenCL library, so we
+// look it up via clGetExtensionFunctionAddressForPlatform, which is
+// OpenCL 1.2 and so not in cl_functions.h.
+typedef cl_mem (CL_API_CALL *clImportMemoryARM_t)(cl_context context, cl_mem_flags flags,
+                                                  const cl_import_properties_arm *properties,
+                                                  void *memory, size_t size, cl_int *errcode_ret);
+typedef void *(CL_API_CALL *clGetExtensionFunctionAddressForPlatform_t)(cl_platform_id platform,
+                                                                        const char *funcname);
+
+// Returns NULL if the platform of the context does not support the extension.
+WEAK clImportMemoryARM_t get_import_memory_arm(void *user_context, cl_context ctx) {
+    clGetExtensionFunctionAddressForPlatform_t get_extension_function =
+        (clGetExtensionFunctionAddressForPlatform_t)halide_opencl_get_symbol(user_context, "clGetExtensionFunctionAddressForPlatform");
+    if (get_extension_function == NULL) {
+        return NULL;
+    }
+    cl_device_id dev;
+    cl_platform_id platform;
+    if (clGetContextInfo(ctx, CL_CONTEXT_DEVICES, sizeof(dev), &dev, NULL) != CL_SUCCESS ||
+        clGetDeviceInfo(dev, CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL) != CL_SUCCESS) {
+        return NULL;
+    }
+    return (clImportMemoryARM_t)get_extension_function(platform, "clImportMemoryARM");
+}
+
 // An OpenCL context/queue/synchronization lock defined in
 // this module with weak linkage
 cl_context WEAK context = 0;
@@ -469,6 +496,45 @@ WEAK int create_opencl_context(void *user_context, cl_context *ctx, cl_command_q
     return err;
 }
 
+// Frees a device allocation that was held in the device allocation
+// cache. This may be called with the context already held, and
+// clReleaseMemObject doesn't need it, so don't acquire it here.
+WEAK int free_cached_allocation(void *user_context, void *context, uint64_t device) {
+    device_handle *dev_handle = (device_handle *)device;
+    debug(user_context) << "    clReleaseMemObject " << (void *)dev_handle->mem << "\n";
+    cl_int result = clReleaseMemObject(dev_handle->mem);
+    free(dev_handle);
+    return result;
+}
+
+// Returns the host memory backing a buffer's device allocation, or
+// NULL if the allocation is not backed by host memory. The device
+// allocation of a buffer allocated with
+// halide_opencl_device_and_host_malloc on a device with unified
+// memory is the buffer's host allocation, in which case copies
+// between the two are only synchronization.
+WEAK uint8_t *get_host_backing(halide_buffer_t *buf) {
+    device_handle *dev_handle = (device_handle *)buf->device;
+    void *host_ptr = NULL;
+    if (clGetMemObjectInfo(dev_handle->mem, CL_MEM_HOST_PTR, sizeof(host_ptr), &host_ptr, NULL) != CL_SUCCESS ||
+        host_ptr == NULL) {
+        return NULL;
+    }
+    return (uint8_t *)host_ptr + dev_handle->offset;
+}
+
+// Whether the device the context was created for shares memory with
+// the host.
+WEAK bool has_unified_memory(cl_context ctx) {
+    cl_device_id dev;
+    cl_bool unified = CL_FALSE;
+    if (clGetContextInfo(ctx, CL_CONTEXT_DEVICES, sizeof(dev), &dev, NULL) != CL_SUCCESS ||
+        clGetDeviceInfo(dev, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(unified), &unified, NULL) != CL_SUCCESS) {
+        return false;
+    }
+    return unified == CL_TRUE;
+}
+
 }}}} // namespace Halide::Runtime::Internal::OpenCL
 
 extern "C" {
@@ -498,6 +564,19 @@ WEAK int halide_opencl_device_free(void *user_context, halide_buffer_t* buf) {
     #endif
 
     halide_assert(user_context, validate_device_pointer(user_context, buf));
+
+    // Allocations backed by host memory can't be reused once the host
+    // memory is freed.
+    if (!get_host_backing(buf) &&
+        halide_device_allocation_cache_put(user_context, &opencl_device_interface, NULL, buf->size_in_bytes(),
+                                           buf->device, free_cached_allocation)) {
+        debug(user_context) << "    caching cl_mem " << (void *)dev_ptr << " for reuse\n";
+        buf->device = 0;
+        buf->device_interface->impl->release_module();
+        buf->device_interface = NULL;
+        return 0;
+    }
+
     debug(user_context) << "    clReleaseMemObject " << (void *)dev_ptr << "\n";
     cl_int result = clReleaseMemObject((cl_mem)dev_ptr);
     // If clReleaseMemObject fails, it is unlikely to succeed in a later call, so
@@ -520,6 +599,95 @@ WEAK int halide_opencl_device_free(void *user_context, halide_buffer_t* buf) {
     return 0;
 }
 
+// A persistent cache of compiled programs. If HL_OCL_BINARY_CACHE_DIR
+// is set, the binary of each program built from source is written to
+// that directory, and later loads of the same source on the same
+// device and driver, in this or any other process, create the program
+// from the binary instead. This skips the front end of the driver's
+// compiler, which can take seconds for large programs. The cache is
+// keyed on the source, the build options, and the name and version of
+// the device and its driver.
+WEAK uint64_t program_cache_key(const char *src, int size, const char *options, cl_device_id dev) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < size; i++) {
+        h = (h ^ (uint8_t)src[i]) * 1099511628211ULL;
+    }
+    for (const char *c = options; *c; c++) {
+        h = (h ^ (uint8_t)*c) * 1099511628211ULL;
+    }
+    const cl_device_info infos[] = { CL_DEVICE_NAME, CL_DEVICE_VERSION, CL_DRIVER_VERSION };
+    for (int i = 0; i < 3; i++) {
+        char buf[256];
+        if (clGetDeviceInfo(dev, infos[i], sizeof(buf), buf, NULL) != CL_SUCCESS) {
+            buf[0] = 0;
+        }
+        buf[sizeof(buf) - 1] = 0;
+        // Include the terminator, so that adjacent strings can't alias.
+        for (const char *c = buf; ; c++) {
+            h = (h ^ (uint8_t)*c) * 1099511628211ULL;
+            if (!*c) break;
+        }
+    }
+    return h;
+}
+
+WEAK cl_program load_cached_program(void *user_context, cl_context context, cl_device_id dev,
+                                    const char *options, const char *path) {
+    void *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    cl_program program = NULL;
+    // 2 is SEEK_END and 0 is SEEK_SET everywhere we run.
+    long size = (fseek(f, 0, 2) == 0) ? ftell(f) : -1;
+    if (size > 0 && fseek(f, 0, 0) == 0) {
+        unsigned char *binary = (unsigned char *)malloc(size);
+        if (binary && fread(binary, 1, size, f) == (size_t)size) {
+            const unsigned char *binaries[] = { binary };
+            size_t lengths[] = { (size_t)size };
+            cl_int binary_status = CL_SUCCESS, err = CL_SUCCESS;
+            program = clCreateProgramWithBinary(context, 1, &dev, lengths, binaries, &binary_status, &err);
+            if (err != CL_SUCCESS || binary_status != CL_SUCCESS) {
+                program = NULL;
+            } else if (clBuildProgram(program, 1, &dev, options, NULL, NULL) != CL_SUCCESS) {
+                // A stale or corrupt binary. Fall back to the source.
+                clReleaseProgram(program);
+                program = NULL;
+            }
+        }
+        free(binary);
+    }
+    fclose(f);
+    debug(user_context) << "    loading cached program " << path << ": " << (program ? "hit" : "miss") << "\n";
+    return program;
+}
+
+WEAK void save_program_binary(void *user_context, cl_program program, const char *path) {
+    // Failing to write the cache is not an error.
+    size_t size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL) != CL_SUCCESS ||
+        size == 0) {
+        return;
+    }
+    unsigned char *binary = (unsigned char *)malloc(size);
+    if (!binary) {
+        return;
+    }
+    unsigned char *binaries[] = { binary };
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, NULL) == CL_SUCCESS) {
+        void *f = fopen(path, "wb");
+        if (f) {
+            bool ok = fwrite(binary, 1, size, f) == size;
+            fclose(f);
+            if (!ok) {
+                remove(path);
+            }
+            debug(user_context) << "    wrote cached program " << path << "\n";
+        }
+    }
+    free(binary);
+}
 
 WEAK int halide_opencl_initialize_kernels(void *user_context, void **state_ptr, const char* src, int size) {
     debug(user_context)
@@ -587,6 +755,32 @@ WEAK int halide_opencl_initialize_kernels(void *user_context, void **state_ptr,
         options << "-D MAX_CONSTANT_BUFFER_SIZE=" << max_constant_buffer_size
                 << " -D MAX_CONSTANT_ARGS=" << max_constant_args;
 
+        char path[1024];
+        path[0] = 0;
+        const char *dir = getenv("HL_OCL_BINARY_CACHE_DIR");
+        if (dir && dir[0]) {
+            char *dst = path, *end = path + sizeof(path) - 1;
+            dst = halide_string_to_string(dst, end, dir);
+            dst = halide_string_to_string(dst, end, "/halide_opencl_");
+            dst = halide_uint64_to_string(dst, end, program_cache_key(src, size, options.str(), dev), 1);
+            dst = halide_string_to_string(dst, end, ".bin");
+            if (dst >= end) {
+                path[0] = 0;
+            }
+        }
+
+        if (path[0]) {
+            cl_program program = load_cached_program(user_context, ctx.context, dev, options.str(), path);
+            if (program) {
+                (*state)->program = program;
+                #ifdef DEBUG_RUNTIME
+                uint64_t t_after = halide_current_time_ns(user_context);
+                debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+                #endif
+                return 0;
+            }
+        }
+
         const char * sources[] = { src };
         debug(user_context) << "    clCreateProgramWithSource -> ";
         cl_program program = clCreateProgramWithSource(ctx.context, 1, &sources[0], NULL, &err );
@@ -623,6 +817,10 @@ WEAK int halide_opencl_initialize_kernels(void *user_context, void **state_ptr,
 
             return err;
         }
+
+        if (path[0]) {
+            save_program_binary(user_context, program, path);
+        }
     }
 
     #ifdef DEBUG_RUNTIME
@@ -663,6 +861,9 @@ WEAK int halide_opencl_device_release(void *user_context) {
     debug(user_context)
         << "CL: halide_opencl_device_release (user_context: " << user_context << ")\n";
 
+    // Free any allocations held for reuse.
+    halide_device_allocation_cache_flush(user_context, &opencl_device_interface);
+
     // The ClContext object does not allow the context storage to be modified,
     // so we use halide_acquire_context directly.
     int err;
@@ -740,6 +941,15 @@ WEAK int halide_opencl_device_malloc(void *user_context, halide_buffer_t* buf) {
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
 
+    uint64_t cached = halide_device_allocation_cache_get(user_context, &opencl_device_interface, NULL, size);
+    if (cached) {
+        debug(user_context) << "    reusing cached device buffer " << (void *)cached << "\n";
+        buf->device = cached;
+        buf->device_interface = &opencl_device_interface;
+        buf->device_interface->impl->use_module();
+        return CL_SUCCESS;
+    }
+
     device_handle *dev_handle = (device_handle *)malloc(sizeof(device_handle));
     if (dev_handle == NULL) {
         return CL_OUT_OF_HOST_MEMORY;
@@ -832,6 +1042,35 @@ WEAK int opencl_do_multidimensional_copy(void *user_context, ClContext &ctx,
     }
     return 0;
 }
+
+// Makes a buffer's host memory and its device allocation backed by
+// that memory consistent in one direction, without copying, by
+// mapping and unmapping the device allocation.
+WEAK int opencl_sync_host_backed(void *user_context, ClContext &ctx,
+                                 halide_buffer_t *buf, bool to_host) {
+    device_handle *dev_handle = (device_handle *)buf->device;
+    // When copying to the device, the host memory holds the contents
+    // and the device's view of them is about to be replaced.
+    cl_map_flags flags = to_host ? CL_MAP_READ : CL_MAP_WRITE_INVALIDATE_REGION;
+    debug(user_context) << "    clEnqueueMapBuffer " << (void *)dev_handle->mem
+                        << " offset " << dev_handle->offset
+                        << " (" << (to_host ? "to host" : "to device") << ")\n";
+    cl_int err = CL_SUCCESS;
+    void *mapped = clEnqueueMapBuffer(ctx.cmd_queue, dev_handle->mem, CL_TRUE, flags,
+                                      dev_handle->offset, buf->size_in_bytes(),
+                                      0, NULL, NULL, &err);
+    if (err != CL_SUCCESS) {
+        error(user_context) << "CL: clEnqueueMapBuffer failed: " << get_opencl_error_name(err);
+        return (int)err;
+    }
+    halide_assert(user_context, mapped == buf->host);
+    err = clEnqueueUnmapMemObject(ctx.cmd_queue, dev_handle->mem, mapped, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        error(user_context) << "CL: clEnqueueUnmapMemObject failed: " << get_opencl_error_name(err);
+        return (int)err;
+    }
+    return 0;
+}
 }
 
 WEAK int halide_opencl_buffer_copy(void *user_context, struct halide_buffer_t *src,
@@ -879,7 +1118,13 @@ WEAK int halide_opencl_buffer_copy(void *user_context, struct halide_buffer_t *s
         }
         #endif
 
-        err = opencl_do_multidimensional_copy(user_context, ctx, c, c.src_begin, 0, dst->dimensions, from_host, to_host);
+        if (src == dst && from_host != to_host && src->host != NULL &&
+            src->device_interface == &opencl_device_interface &&
+            get_host_backing(src) == src->host) {
+            err = opencl_sync_host_backed(user_context, ctx, src, to_host);
+        } else {
+            err = opencl_do_multidimensional_copy(user_context, ctx, c, c.src_begin, 0, dst->dimensions, from_host, to_host);
+        }
 
         // The reads/writes above are all non-blocking, so empty the command
         // queue before we proceed so that other host code won't write
@@ -1035,6 +1280,7 @@ WEAK int halide_opencl_run(void *user_context,
         << "    clEnqueueNDRangeKernel "
         << blocksX << "x" << blocksY << "x" << blocksZ << ", "
         << threadsX << "x" << threadsY << "x" << threadsZ << " -> ";
+    halide_timeline_event(user_context, entry_name, "gpu", 'i');
     err = clEnqueueNDRangeKernel(ctx.cmd_queue, f,
                                  // NDRange
                                  3, NULL, global_dim, local_dim,
@@ -1072,7 +1318,74 @@ WEAK int halide_opencl_run(void *user_context,
 }
 
 WEAK int halide_opencl_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf) {
-    return halide_default_device_and_host_malloc(user_context, buf, &opencl_device_interface);
+    debug(user_context)
+        << "CL: halide_opencl_device_and_host_malloc (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    bool unified = false;
+    {
+        ClContext ctx(user_context);
+        if (ctx.error != CL_SUCCESS) {
+            return ctx.error;
+        }
+        unified = has_unified_memory(ctx.context);
+    }
+    if (!unified || buf->device) {
+        return halide_default_device_and_host_malloc(user_context, buf, &opencl_device_interface);
+    }
+
+    // The device shares memory with the host, so back the device
+    // allocation with the host allocation rather than keeping two
+    // copies of the buffer in the same memory.
+    size_t size = buf->size_in_bytes();
+    halide_assert(user_context, size != 0);
+    for (int i = 0; i < buf->dimensions; i++) {
+        halide_assert(user_context, buf->dim[i].stride >= 0);
+    }
+
+    buf->host = (uint8_t *)halide_malloc(user_context, size);
+    if (buf->host == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+
+    device_handle *dev_handle = (device_handle *)malloc(sizeof(device_handle));
+    if (dev_handle == NULL) {
+        halide_free(user_context, buf->host);
+        buf->host = NULL;
+        return CL_OUT_OF_HOST_MEMORY;
+    }
+
+    cl_int err;
+    cl_mem dev_ptr;
+    {
+        ClContext ctx(user_context);
+        if (ctx.error != CL_SUCCESS) {
+            free(dev_handle);
+            halide_free(user_context, buf->host);
+            buf->host = NULL;
+            return ctx.error;
+        }
+        debug(user_context) << "    clCreateBuffer (CL_MEM_USE_HOST_PTR " << (void *)buf->host
+                            << ") -> " << (int)size << " ";
+        dev_ptr = clCreateBuffer(ctx.context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, size, buf->host, &err);
+    }
+    if (err != CL_SUCCESS || dev_ptr == 0) {
+        debug(user_context) << get_opencl_error_name(err) << "\n";
+        error(user_context) << "CL: clCreateBuffer failed: "
+                            << get_opencl_error_name(err);
+        free(dev_handle);
+        halide_free(user_context, buf->host);
+        buf->host = NULL;
+        return err;
+    }
+    debug(user_context) << (void *)dev_ptr << " device_handle: " << dev_handle << "\n";
+
+    dev_handle->mem = dev_ptr;
+    dev_handle->offset = 0;
+    buf->device = (uint64_t)dev_handle;
+    buf->device_interface = &opencl_device_interface;
+    buf->device_interface->impl->use_module();
+    return 0;
 }
 
 WEAK int halide_opencl_device_and_host_free(void *user_context, struct halide_buffer_t *buf) {
@@ -1117,6 +1430,64 @@ WEAK int halide_opencl_detach_cl_mem(void *user_context, halide_buffer_t *buf) {
     return 0;
 }
 
+WEAK int halide_opencl_wrap_ahardwarebuffer(void *user_context, struct halide_buffer_t *buf, void *hardware_buffer) {
+    halide_assert(user_context, buf->device == 0);
+    if (buf->device != 0) {
+        return -2;
+    }
+
+    ClContext ctx(user_context);
+    if (ctx.error != CL_SUCCESS) {
+        return ctx.error;
+    }
+
+    clImportMemoryARM_t import_memory = get_import_memory_arm(user_context, ctx.context);
+    if (import_memory == NULL) {
+        error(user_context) << "CL: Importing an AHardwareBuffer requires the cl_arm_import_memory extension.\n";
+        return halide_error_code_device_wrap_native_failed;
+    }
+
+    const cl_import_properties_arm properties[] = {
+        CL_IMPORT_TYPE_ARM, CL_IMPORT_TYPE_ANDROID_HARDWARE_BUFFER_ARM, 0
+    };
+    cl_int err = CL_SUCCESS;
+    debug(user_context) << "    clImportMemoryARM " << hardware_buffer << " -> ";
+    cl_mem mem = import_memory(ctx.context, CL_MEM_READ_WRITE, properties, hardware_buffer,
+                               CL_IMPORT_MEMORY_WHOLE_ALLOCATION_ARM, &err);
+    if (err != CL_SUCCESS || mem == NULL) {
+        debug(user_context) << get_opencl_error_name(err) << "\n";
+        error(user_context) << "CL: clImportMemoryARM failed: " << get_opencl_error_name(err) << "\n";
+        return halide_error_code_device_wrap_native_failed;
+    }
+    debug(user_context) << (void *)mem << "\n";
+
+    int result = halide_opencl_wrap_cl_mem(user_context, buf, (uint64_t)mem);
+    if (result != 0) {
+        clReleaseMemObject(mem);
+    }
+    return result;
+}
+
+WEAK int halide_opencl_detach_ahardwarebuffer(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == NULL) {
+        return 0;
+    }
+    cl_mem mem = (cl_mem)halide_opencl_get_cl_mem(user_context, buf);
+    int result = halide_opencl_detach_cl_mem(user_context, buf);
+    if (result != 0) {
+        return result;
+    }
+    // The import made a new reference to the memory, which we release
+    // here. The AHardwareBuffer itself is not freed.
+    debug(user_context) << "    clReleaseMemObject " << (void *)mem << "\n";
+    cl_int err = clReleaseMemObject(mem);
+    if (err != CL_SUCCESS) {
+        error(user_context) << "CL: clReleaseMemObject failed: " << get_opencl_error_name(err) << "\n";
+        return halide_error_code_device_detach_native_failed;
+    }
+    return 0;
+}
+
 WEAK uintptr_t halide_opencl_get_cl_mem(void *user_context, halide_buffer_t *buf) {
     if (buf->device == NULL) {
         return 0;
@@ -1199,6 +1570,16 @@ WEAK int halide_opencl_device_release_crop(void *user_context,
     #endif
 
     halide_assert(user_context, validate_device_pointer(user_context, buf));
+
+    if (halide_device_allocation_cache_put(user_context, &opencl_device_interface, NULL, buf->size_in_bytes(),
+                                           buf->device, free_cached_allocation)) {
+        debug(user_context) << "    caching cl_mem " << (void *)dev_ptr << " for reuse\n";
+        buf->device = 0;
+        buf->device_interface->impl->release_module();
+        buf->device_interface = NULL;
+        return 0;
+    }
+
     debug(user_context) << "    clReleaseMemObject " << (void *)dev_ptr << "\n";
     // Sub-buffers are released with clReleaseMemObject
     cl_int result = clReleaseMemObject((cl_mem)dev_ptr);
@@ -3,26 +3,97 @@
 
 #include "printer.h"
 
+// An OS-specific allocator may include this file with
+// HALIDE_LARGE_PAGES defined, and with definitions of
+//
+//   size_t large_page_size();
+//   void *large_page_map(size_t size);
+//   void large_page_unmap(void *base, size_t size);
+//
+// Then allocations at least as large as the large page threshold are
+// mapped directly, in a multiple of the large page size and aligned to
+// it, so that they can be backed by large pages and take fewer TLB
+// entries. If the mapping fails, they fall back to malloc.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The size in bytes above which allocations use large pages, or zero
+// if they never do. Negative until read from the environment.
+WEAK int64_t large_page_threshold = -1;
+
+WEAK int64_t get_large_page_threshold() {
+#ifdef HALIDE_LARGE_PAGES
+    if (large_page_threshold < 0) {
+        // Read the threshold, in megabytes, from the environment.
+        const char *threshold_str = getenv("HL_LARGE_PAGE_THRESHOLD_MB");
+        large_page_threshold = (int64_t)(threshold_str ? atoi(threshold_str) : 8) * 1024 * 1024;
+        if (large_page_threshold < 0) {
+            large_page_threshold = 0;
+        }
+    }
+    return large_page_threshold;
+#else
+    return 0;
+#endif
+}
+
+}}} // namespace Halide::Runtime::Internal
+
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
 
+WEAK int64_t halide_set_large_page_threshold(int64_t bytes) {
+    int64_t result = get_large_page_threshold();
+    large_page_threshold = bytes < 0 ? 0 : bytes;
+    return result;
+}
+
+// Both kinds of allocation store the pointer to free immediately before
+// the pointer returned, and the size of the mapping (or zero for
+// malloc) before that.
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
-    // Allocate enough space for aligning the pointer we return.
     const size_t alignment = halide_malloc_alignment();
-    void *orig = malloc(x + alignment);
+
+#ifdef HALIDE_LARGE_PAGES
+    int64_t threshold = get_large_page_threshold();
+    if (threshold > 0 && x >= (uint64_t)threshold) {
+        // Leave room for the header before the allocation, and for
+        // reads beyond its end.
+        const size_t page = large_page_size();
+        size_t size = (x + 2 * alignment + page - 1) & ~(page - 1);
+        void *base = large_page_map(size);
+        if (base) {
+            void *ptr = (void *)((uint8_t *)base + alignment);
+            ((void **)ptr)[-1] = base;
+            ((size_t *)ptr)[-2] = size;
+            return ptr;
+        }
+    }
+#endif
+
+    // Allocate enough space for aligning the pointer we return.
+    void *orig = malloc(x + alignment + 2 * sizeof(void *));
     if (orig == NULL) {
         // Will result in a failed assertion and a call to halide_error
         return NULL;
     }
     // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void*) - 1) & ~(alignment - 1));
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void *) - 1) & ~(alignment - 1));
     ((void **)ptr)[-1] = orig;
+    ((size_t *)ptr)[-2] = 0;
     return ptr;
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
+#ifdef HALIDE_LARGE_PAGES
+    size_t size = ((size_t *)ptr)[-2];
+    if (size) {
+        large_page_unmap(((void **)ptr)[-1], size);
+        return;
+    }
+#endif
     free(((void**)ptr)[-1]);
 }
 
@@ -0,0 +1,71 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "printer.h"
+
+// The values of these are the same on linux, android and OS X.
+#define PROT_READ 1
+#define PROT_WRITE 2
+#define MAP_SHARED 1
+#define MAP_FAILED ((void *)-1)
+#define LOCK_EX 2
+#define LOCK_UN 8
+#define SEEK_END 2
+
+extern "C" void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+extern "C" int ftruncate(int fd, long length);
+extern "C" int munmap(void *addr, size_t length);
+extern "C" int flock(int fd, int operation);
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK void *halide_shared_file_map(void *user_context, const char *path, size_t size, int *fd) {
+    // Open the file for reading and writing without truncating it,
+    // creating it if it doesn't exist.
+    void *file = fopen(path, "r+b");
+    if (!file) {
+        file = fopen(path, "a+b");
+        if (file) {
+            fclose(file);
+            file = fopen(path, "r+b");
+        }
+    }
+    if (!file) {
+        error(user_context) << "Could not open " << path << "\n";
+        return NULL;
+    }
+    *fd = fileno(file);
+
+    // Grow the file to the requested size. The new bytes are zero.
+    flock(*fd, LOCK_EX);
+    bool ok = fseek(file, 0, SEEK_END) == 0;
+    long current_size = ok ? ftell(file) : -1;
+    if (current_size >= 0 && (size_t)current_size < size) {
+        ok = ftruncate(*fd, (long)size) == 0;
+    }
+    flock(*fd, LOCK_UN);
+
+    void *mapping = ok ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0) : MAP_FAILED;
+    if (mapping == MAP_FAILED) {
+        error(user_context) << "Could not map " << path << "\n";
+        fclose(file);
+        return NULL;
+    }
+    // The file stays open for the lifetime of the process, as its
+    // descriptor is also the lock.
+    return mapping;
+}
+
+WEAK void halide_shared_file_unmap(void *mapping, size_t size, int fd) {
+    munmap(mapping, size);
+    close(fd);
+}
+
+WEAK void halide_shared_file_lock(int fd) {
+    flock(fd, LOCK_EX);
+}
+
+WEAK void halide_shared_file_unlock(int fd) {
+    flock(fd, LOCK_UN);
+}
+
+}}}
@@ -36,6 +36,8 @@ extern int pthread_key_create(pthread_key_t *key, void (*destructor)(void*));
 extern int pthread_setspecific(pthread_key_t key, const void *value);
 extern void *pthread_getspecific(pthread_key_t key);
 
+extern pthread_t pthread_self();
+
 } // extern "C"
 
 namespace Halide { namespace Runtime { namespace Internal {
@@ -51,6 +53,10 @@ WEAK void *spawn_thread_helper(void *arg) {
     return NULL;
 }
 
+WEAK uint64_t halide_current_thread_id() {
+    return (uint64_t)pthread_self();
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -24,3 +24,56 @@ define weak_odr <4 x float> @fast_inverse_sqrt_f32x4(<4 x float> %x) readnone al
   %approx = tail call <4 x float> @llvm.ppc.altivec.vrsqrtefp(<4 x float> %x) #2
   ret <4 x float> %approx
 }
+
+; Saturating narrowing packs. The pack instructions number lanes
+; big-endian, so on a little-endian target the high half of the input
+; is the first operand. These are only used on 64-bit (little-endian)
+; targets.
+declare <16 x i8> @llvm.ppc.altivec.vpkshss(<8 x i16>, <8 x i16>) nounwind readnone
+declare <16 x i8> @llvm.ppc.altivec.vpkshus(<8 x i16>, <8 x i16>) nounwind readnone
+declare <16 x i8> @llvm.ppc.altivec.vpkuhus(<8 x i16>, <8 x i16>) nounwind readnone
+declare <8 x i16> @llvm.ppc.altivec.vpkswss(<4 x i32>, <4 x i32>) nounwind readnone
+declare <8 x i16> @llvm.ppc.altivec.vpkswus(<4 x i32>, <4 x i32>) nounwind readnone
+declare <8 x i16> @llvm.ppc.altivec.vpkuwus(<4 x i32>, <4 x i32>) nounwind readnone
+
+define weak_odr <16 x i8> @vpkshssx16(<16 x i16> %arg) nounwind alwaysinline {
+  %lo = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 0, i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7>
+  %hi = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 8, i32 9, i32 10, i32 11, i32 12, i32 13, i32 14, i32 15>
+  %r = tail call <16 x i8> @llvm.ppc.altivec.vpkshss(<8 x i16> %hi, <8 x i16> %lo)
+  ret <16 x i8> %r
+}
+
+define weak_odr <16 x i8> @vpkshusx16(<16 x i16> %arg) nounwind alwaysinline {
+  %lo = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 0, i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7>
+  %hi = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 8, i32 9, i32 10, i32 11, i32 12, i32 13, i32 14, i32 15>
+  %r = tail call <16 x i8> @llvm.ppc.altivec.vpkshus(<8 x i16> %hi, <8 x i16> %lo)
+  ret <16 x i8> %r
+}
+
+define weak_odr <16 x i8> @vpkuhusx16(<16 x i16> %arg) nounwind alwaysinline {
+  %lo = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 0, i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7>
+  %hi = shufflevector <16 x i16> %arg, <16 x i16> undef, <8 x i32> <i32 8, i32 9, i32 10, i32 11, i32 12, i32 13, i32 14, i32 15>
+  %r = tail call <16 x i8> @llvm.ppc.altivec.vpkuhus(<8 x i16> %hi, <8 x i16> %lo)
+  ret <16 x i8> %r
+}
+
+define weak_odr <8 x i16> @vpkswssx8(<8 x i32> %arg) nounwind alwaysinline {
+  %lo = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %hi = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 4, i32 5, i32 6, i32 7>
+  %r = tail call <8 x i16> @llvm.ppc.altivec.vpkswss(<4 x i32> %hi, <4 x i32> %lo)
+  ret <8 x i16> %r
+}
+
+define weak_odr <8 x i16> @vpkswusx8(<8 x i32> %arg) nounwind alwaysinline {
+  %lo = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %hi = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 4, i32 5, i32 6, i32 7>
+  %r = tail call <8 x i16> @llvm.ppc.altivec.vpkswus(<4 x i32> %hi, <4 x i32> %lo)
+  ret <8 x i16> %r
+}
+
+define weak_odr <8 x i16> @vpkuwusx8(<8 x i32> %arg) nounwind alwaysinline {
+  %lo = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %hi = shufflevector <8 x i32> %arg, <8 x i32> undef, <4 x i32> <i32 4, i32 5, i32 6, i32 7>
+  %r = tail call <8 x i16> @llvm.ppc.altivec.vpkuwus(<4 x i32> %hi, <4 x i32> %lo)
+  ret <8 x i16> %r
+}
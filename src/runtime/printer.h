@@ -94,6 +94,12 @@ public:
         return *this;
     }
 
+    Printer & write_bfloat16_from_bits(const uint16_t arg) {
+        double value = halide_bfloat16_bits_to_double(arg);
+        dst = halide_double_to_string(dst, end, value, 1);
+        return *this;
+    }
+
     Printer &operator<<(const halide_type_t &t) {
         dst = halide_type_to_string(dst, end, &t);
         return *this;
@@ -60,13 +60,19 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
         p->funcs[i].stack_peak = 0;
         p->funcs[i].active_threads_numerator = 0;
         p->funcs[i].active_threads_denominator = 0;
+        for (int j = 0; j < halide_perf_num_counters; j++) {
+            p->funcs[i].perf_counters[j] = 0;
+        }
     }
     s->first_free_id += num_funcs;
     s->pipelines = p;
     return p;
 }
 
-WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads) {
+// Find the stats for a func, and the pipeline it belongs to. Returns
+// NULL if there is no such func.
+WEAK halide_profiler_func_stats *find_func_stats(halide_profiler_state *s, int func_id,
+                                                 halide_profiler_pipeline_stats **pipeline) {
     halide_profiler_pipeline_stats *p_prev = NULL;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
          p = (halide_profiler_pipeline_stats *)(p->next)) {
@@ -77,19 +83,155 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int ac
                 p->next = s->pipelines;
                 s->pipelines = p;
             }
-            halide_profiler_func_stats *f = p->funcs + func_id - p->first_func_id;
-            f->time += time;
-            f->active_threads_numerator += active_threads;
-            f->active_threads_denominator += 1;
-            p->time += time;
-            p->samples++;
-            p->active_threads_numerator += active_threads;
-            p->active_threads_denominator += 1;
-            return;
+            *pipeline = p;
+            return p->funcs + func_id - p->first_func_id;
         }
         p_prev = p;
     }
-    // Someone must have called reset_state while a kernel was running. Do nothing.
+    return NULL;
+}
+
+// Bill some time to a func. func_threads is the number of threads
+// that were running it. If pipeline_threads is non-negative, this is
+// the first func billed for this sample, and pipeline_threads is the
+// total number of threads doing work.
+WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time,
+                    int func_threads, int pipeline_threads) {
+    halide_profiler_pipeline_stats *p = NULL;
+    halide_profiler_func_stats *f = find_func_stats(s, func_id, &p);
+    if (!f) {
+        // Someone must have called reset_state while a kernel was running. Do nothing.
+        return;
+    }
+    f->time += time;
+    f->active_threads_numerator += func_threads;
+    f->active_threads_denominator += 1;
+    p->time += time;
+    if (pipeline_threads >= 0) {
+        p->samples++;
+        p->active_threads_numerator += pipeline_threads;
+        p->active_threads_denominator += 1;
+    }
+}
+
+// Where tasks write their current func when all the slots are taken.
+WEAK int overflow_slot;
+
+// Divide an interval of time between all the funcs currently running
+// on some thread, in proportion to the number of threads running each.
+WEAK void bill_sample(halide_profiler_state *s, int main_func, uint64_t time, int active_threads) {
+    int funcs[halide_profiler_max_threads + 1];
+    int counts[halide_profiler_max_threads + 1];
+    int num_funcs = 0, busy = 0;
+    for (int i = -1; i < halide_profiler_max_threads; i++) {
+        int f = (i < 0) ? main_func : s->thread_current_func[i];
+        if (f < 0) {
+            continue;
+        }
+        busy++;
+        int j = 0;
+        while (j < num_funcs && funcs[j] != f) {
+            j++;
+        }
+        if (j == num_funcs) {
+            funcs[num_funcs] = f;
+            counts[num_funcs] = 0;
+            num_funcs++;
+        }
+        counts[j]++;
+    }
+    for (int j = 0; j < num_funcs; j++) {
+        bill_func(s, funcs[j], (time * counts[j]) / busy, counts[j],
+                  j == 0 ? active_threads : -1);
+    }
+}
+
+// Hardware performance counters, if enabled, are tracked per thread
+// rather than per slot, because that's how the kernel counts them. Each
+// thread records which slot it is currently running a Func in, and the
+// profiler thread bills the counts accumulated by each thread since the
+// last sample to that Func.
+struct perf_thread {
+    int tid;
+    // The group of counters opened by this thread, or -1.
+    int group;
+    // The slot this thread is currently recording its Func in, or NULL
+    // if it's not running Halide code.
+    int *volatile slot;
+    // The counter values at the last sample. Only touched by the
+    // profiler thread once ready is set.
+    uint64_t last[halide_perf_num_counters];
+    volatile bool ready;
+};
+
+WEAK perf_thread perf_threads[halide_profiler_max_threads];
+WEAK int num_perf_threads = 0;
+
+// The slot held by each thread before it acquired each entry of
+// thread_current_func, so that it can be restored on release when
+// tasks are nested.
+WEAK int *perf_prev_slot[halide_profiler_max_threads];
+
+// -1 indicates uninitialized
+WEAK int perf_counters_enabled = -1;
+
+// Find or create the perf_thread for the calling thread. Returns NULL if
+// there are too many threads, or if counters are unavailable.
+WEAK perf_thread *perf_current_thread() {
+    int tid = halide_perf_counters_thread_id();
+    int n = min(num_perf_threads, (int)halide_profiler_max_threads);
+    for (int i = 0; i < n; i++) {
+        perf_thread *t = perf_threads + i;
+        if (t->ready && t->tid == tid) {
+            return t->group >= 0 ? t : NULL;
+        }
+    }
+    int i = __sync_fetch_and_add(&num_perf_threads, 1);
+    if (i >= halide_profiler_max_threads) {
+        return NULL;
+    }
+    perf_thread *t = perf_threads + i;
+    t->tid = tid;
+    t->slot = NULL;
+    t->group = halide_perf_counters_open();
+    if (t->group >= 0 && !halide_perf_counters_read(t->group, t->last)) {
+        close(t->group);
+        t->group = -1;
+    }
+    if (t->group < 0) {
+        // Probably not permitted (see perf_event_paranoid), or not
+        // supported. Don't try again for any thread.
+        perf_counters_enabled = 0;
+    }
+    __sync_synchronize();
+    t->ready = true;
+    return t->group >= 0 ? t : NULL;
+}
+
+// Bill the counts accumulated by each thread since the last sample to
+// the Func it is running.
+WEAK void bill_perf_counters(halide_profiler_state *s) {
+    int n = min(num_perf_threads, (int)halide_profiler_max_threads);
+    for (int i = 0; i < n; i++) {
+        perf_thread *t = perf_threads + i;
+        if (!t->ready || t->group < 0) {
+            continue;
+        }
+        uint64_t values[halide_perf_num_counters];
+        if (!halide_perf_counters_read(t->group, values)) {
+            continue;
+        }
+        int *slot = t->slot;
+        int func = slot ? *slot : halide_profiler_outside_of_halide;
+        halide_profiler_pipeline_stats *p = NULL;
+        halide_profiler_func_stats *f = func >= 0 ? find_func_stats(s, func, &p) : NULL;
+        for (int j = 0; j < halide_perf_num_counters; j++) {
+            if (f) {
+                f->perf_counters[j] += values[j] - t->last[j];
+            }
+            t->last[j] = values[j];
+        }
+    }
 }
 
 WEAK void sampling_profiler_thread(void *) {
@@ -104,7 +246,8 @@ WEAK void sampling_profiler_thread(void *) {
         uint64_t t = t1;
         while (1) {
             int func, active_threads;
-            if (s->get_remote_profiler_state) {
+            bool remote = s->get_remote_profiler_state != NULL;
+            if (remote) {
                 // Execution has disappeared into remote code running
                 // on an accelerator (e.g. Hexagon DSP)
                 s->get_remote_profiler_state(&func, &active_threads);
@@ -115,10 +258,19 @@ WEAK void sampling_profiler_thread(void *) {
             uint64_t t_now = halide_current_time_ns(NULL);
             if (func == halide_profiler_please_stop) {
                 break;
-            } else if (func >= 0) {
+            } else if (remote) {
+                if (func >= 0) {
+                    // Assume all time since I was last awake is due to
+                    // the currently running func.
+                    bill_func(s, func, t_now - t, active_threads, active_threads);
+                }
+            } else {
                 // Assume all time since I was last awake is due to
-                // the currently running func.
-                bill_func(s, func, t_now - t, active_threads);
+                // the funcs currently running on each thread.
+                bill_sample(s, func, t_now - t, active_threads);
+                if (perf_counters_enabled > 0) {
+                    bill_perf_counters(s);
+                }
             }
             t = t_now;
 
@@ -149,6 +301,23 @@ void sync_compare_max_and_swap(T *ptr, T val) {
     }
 }
 
+// Print the instructions per cycle and the misses per thousand
+// instructions for some hardware performance counter totals.
+template<typename StreamT>
+void print_perf_counters(StreamT &sstr, const uint64_t *counters) {
+    float cycles = counters[halide_perf_cycles];
+    float kinstrs = counters[halide_perf_instructions] / 1000.0f;
+    sstr << " ipc: " << counters[halide_perf_instructions] / cycles;
+    // We don't need 6 sig. figs.
+    sstr.erase(4);
+    if (kinstrs > 0) {
+        sstr << " llc mpki: " << counters[halide_perf_llc_misses] / kinstrs;
+        sstr.erase(4);
+        sstr << " br mpki: " << counters[halide_perf_branch_misses] / kinstrs;
+        sstr.erase(4);
+    }
+}
+
 }
 
 extern "C" {
@@ -178,7 +347,15 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
 
     ScopedMutexLock lock(&s->lock);
 
+    if (perf_counters_enabled < 0) {
+        const char *perf_str = getenv("HL_PROFILER_PERF_COUNTERS");
+        perf_counters_enabled = (perf_str && atoi(perf_str) > 0) ? 1 : 0;
+    }
+
     if (!s->sampling_thread) {
+        for (int i = 0; i < halide_profiler_max_threads; i++) {
+            s->thread_current_func[i] = halide_profiler_slot_free;
+        }
         halide_start_clock(user_context);
         s->sampling_thread = halide_spawn_thread(sampling_profiler_thread, NULL);
     }
@@ -191,9 +368,50 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
     }
     p->runs++;
 
+    if (perf_counters_enabled > 0) {
+        perf_thread *t = perf_current_thread();
+        if (t) {
+            t->slot = &s->current_func;
+        }
+    }
+
     return p->first_func_id;
 }
 
+// Claim a slot in which a thread starting a parallel task can record
+// which func it's running, and record the given func in it.
+WEAK int *halide_profiler_acquire_slot(void *state, int func) {
+    halide_profiler_state *s = (halide_profiler_state *)state;
+    for (int i = 0; i < halide_profiler_max_threads; i++) {
+        if (__sync_bool_compare_and_swap(&s->thread_current_func[i], halide_profiler_slot_free, func)) {
+            if (perf_counters_enabled > 0) {
+                perf_thread *t = perf_current_thread();
+                if (t) {
+                    perf_prev_slot[i] = t->slot;
+                    t->slot = &s->thread_current_func[i];
+                }
+            }
+            return &s->thread_current_func[i];
+        }
+    }
+    // There are more tasks running than we can track. The time spent
+    // in this one goes unrecorded.
+    return &overflow_slot;
+}
+
+WEAK void halide_profiler_release_slot(void *state, int *slot) {
+    if (slot != &overflow_slot) {
+        if (perf_counters_enabled > 0) {
+            halide_profiler_state *s = (halide_profiler_state *)state;
+            perf_thread *t = perf_current_thread();
+            if (t) {
+                t->slot = perf_prev_slot[slot - s->thread_current_func];
+            }
+        }
+        __sync_lock_test_and_set(slot, (int)halide_profiler_slot_free);
+    }
+}
+
 WEAK void halide_profiler_stack_peak_update(void *user_context,
                                             void *pipeline_state,
                                             uint64_t *f_values) {
@@ -280,6 +498,50 @@ WEAK void halide_profiler_memory_free(void *user_context,
     __sync_sub_and_fetch(&f_stats->memory_current, decr);
 }
 
+// Print the time taken by each GPU kernel and kind of copy.
+WEAK void halide_profiler_report_device_unlocked(void *user_context, halide_profiler_state *s) {
+    char line_buf[1024];
+    Printer<StringStreamPrinter, sizeof(line_buf)> sstr(user_context, line_buf);
+
+    for (int copies = 0; copies < 2; copies++) {
+        bool any = false;
+        for (halide_profiler_device_stats *d = s->device_stats; d; d = d->next) {
+            any = any || (d->is_copy == copies);
+        }
+        if (!any) continue;
+
+        sstr.clear();
+        sstr << (copies ? "device copies\n" : "device kernels\n");
+        halide_print(user_context, sstr.str());
+
+        for (halide_profiler_device_stats *d = s->device_stats; d; d = d->next) {
+            if (d->is_copy != copies) continue;
+            size_t cursor = 0;
+            sstr.clear();
+            sstr << "  " << d->name << ": ";
+            cursor += 25;
+            while (sstr.size() < cursor) sstr << " ";
+
+            float t = d->time / 1000000.0f;
+            sstr << t;
+            // We don't need 6 sig. figs.
+            sstr.erase(3);
+            sstr << "ms";
+            cursor += 10;
+            while (sstr.size() < cursor) sstr << " ";
+
+            sstr << (copies ? "copies: " : "launches: ") << d->count;
+            cursor += 18;
+            while (sstr.size() < cursor) sstr << " ";
+
+            sstr << "avg: " << t / d->count;
+            sstr.erase(3);
+            sstr << "ms\n";
+            halide_print(user_context, sstr.str());
+        }
+    }
+}
+
 WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_state *s) {
 
     char line_buf[1024];
@@ -306,6 +568,17 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
         }
         sstr << " heap allocations: " << p->num_allocs
              << "  peak heap usage: " << p->memory_peak << " bytes\n";
+        uint64_t p_counters[halide_perf_num_counters] = {0};
+        for (int i = 0; i < p->num_funcs; i++) {
+            for (int j = 0; j < halide_perf_num_counters; j++) {
+                p_counters[j] += p->funcs[i].perf_counters[j];
+            }
+        }
+        if (p_counters[halide_perf_cycles]) {
+            sstr << " hardware counters:";
+            print_perf_counters(sstr, p_counters);
+            sstr << "\n";
+        }
         halide_print(user_context, sstr.str());
 
         bool print_f_states = p->time || p->memory_total;
@@ -374,12 +647,17 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 if (fs->stack_peak > 0) {
                     sstr << " stack: " << fs->stack_peak;
                 }
+                if (fs->perf_counters[halide_perf_cycles]) {
+                    print_perf_counters(sstr, fs->perf_counters);
+                }
                 sstr << "\n";
 
                 halide_print(user_context, sstr.str());
             }
         }
     }
+
+    halide_profiler_report_device_unlocked(user_context, s);
 }
 
 WEAK void halide_profiler_report(void *user_context) {
@@ -388,6 +666,33 @@ WEAK void halide_profiler_report(void *user_context) {
     halide_profiler_report_unlocked(user_context, s);
 }
 
+WEAK void halide_profiler_record_device_time(void *user_context, const char *name,
+                                             int is_copy, uint64_t time) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+
+    // Kernels with the same name are merged, whichever module
+    // launched them.
+    halide_profiler_device_stats *d = s->device_stats;
+    while (d && (d->is_copy != is_copy || strcmp(d->name, name) != 0)) {
+        d = d->next;
+    }
+    if (!d) {
+        size_t len = strlen(name) + 1;
+        d = (halide_profiler_device_stats *)malloc(sizeof(halide_profiler_device_stats) + len);
+        if (!d) return;
+        memcpy(d + 1, name, len);
+        d->time = 0;
+        d->name = (const char *)(d + 1);
+        d->count = 0;
+        d->is_copy = is_copy;
+        d->next = s->device_stats;
+        s->device_stats = d;
+    }
+    d->time += time;
+    d->count++;
+}
+
 
 WEAK void halide_profiler_reset_unlocked(halide_profiler_state *s) {
     while (s->pipelines) {
@@ -396,6 +701,11 @@ WEAK void halide_profiler_reset_unlocked(halide_profiler_state *s) {
         free(p->funcs);
         free(p);
     }
+    while (s->device_stats) {
+        halide_profiler_device_stats *d = s->device_stats;
+        s->device_stats = d->next;
+        free(d);
+    }
     s->first_free_id = 0;
 }
 
@@ -453,6 +763,12 @@ WEAK void halide_windows_profiler_shutdown() {
 }
 
 WEAK void halide_profiler_pipeline_end(void *user_context, void *state) {
+    if (perf_counters_enabled > 0) {
+        perf_thread *t = perf_current_thread();
+        if (t) {
+            t->slot = NULL;
+        }
+    }
     ((halide_profiler_state *)state)->current_func = halide_profiler_outside_of_halide;
 }
 
@@ -0,0 +1,26 @@
+; Warp-level matrix multiply-accumulate on tensor cores (sm_70 and
+; later). Each of these computes C += A * B for a 16x16x16 tile, with
+; all three matrices row-major in memory and each stride given in
+; elements. They must be called by all 32 threads of a warp with the
+; same arguments, and the tiles must be 32-byte aligned. The return
+; value is always zero, so that they can be used as Halide Exprs. They
+; use inline PTX rather than the llvm.nvvm.wmma intrinsics, whose names
+; and signatures vary across LLVM versions.
+
+; A and B are float16, C is float32.
+define weak_odr i32 @halide_ptx_wmma_m16n16k16_f16_f32(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc) nounwind alwaysinline {
+       call void asm sideeffect "{\0A\09.reg .b32 %wa<8>, %wb<8>, %wc<8>;\0A\09wmma.load.a.sync.aligned.row.m16n16k16.f16 {%wa0,%wa1,%wa2,%wa3,%wa4,%wa5,%wa6,%wa7}, [$0], $1;\0A\09wmma.load.b.sync.aligned.row.m16n16k16.f16 {%wb0,%wb1,%wb2,%wb3,%wb4,%wb5,%wb6,%wb7}, [$2], $3;\0A\09wmma.load.c.sync.aligned.row.m16n16k16.f32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, [$4], $5;\0A\09wmma.mma.sync.aligned.row.row.m16n16k16.f32.f32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, {%wa0,%wa1,%wa2,%wa3,%wa4,%wa5,%wa6,%wa7}, {%wb0,%wb1,%wb2,%wb3,%wb4,%wb5,%wb6,%wb7}, {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7};\0A\09wmma.store.d.sync.aligned.row.m16n16k16.f32 [$4], {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, $5;\0A}", "l,r,l,r,l,r,~{memory}"(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc)
+       ret i32 0
+}
+
+; A and B are int8, C is int32. Requires sm_72 or later.
+define weak_odr i32 @halide_ptx_wmma_m16n16k16_s8_s32(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc) nounwind alwaysinline {
+       call void asm sideeffect "{\0A\09.reg .b32 %wa<2>, %wb<2>, %wc<8>;\0A\09wmma.load.a.sync.aligned.row.m16n16k16.s8 {%wa0,%wa1}, [$0], $1;\0A\09wmma.load.b.sync.aligned.row.m16n16k16.s8 {%wb0,%wb1}, [$2], $3;\0A\09wmma.load.c.sync.aligned.row.m16n16k16.s32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, [$4], $5;\0A\09wmma.mma.sync.aligned.row.row.m16n16k16.s32.s8.s8.s32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, {%wa0,%wa1}, {%wb0,%wb1}, {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7};\0A\09wmma.store.d.sync.aligned.row.m16n16k16.s32 [$4], {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, $5;\0A}", "l,r,l,r,l,r,~{memory}"(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc)
+       ret i32 0
+}
+
+; A and B are uint8, C is int32. Requires sm_72 or later.
+define weak_odr i32 @halide_ptx_wmma_m16n16k16_u8_s32(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc) nounwind alwaysinline {
+       call void asm sideeffect "{\0A\09.reg .b32 %wa<2>, %wb<2>, %wc<8>;\0A\09wmma.load.a.sync.aligned.row.m16n16k16.u8 {%wa0,%wa1}, [$0], $1;\0A\09wmma.load.b.sync.aligned.row.m16n16k16.u8 {%wb0,%wb1}, [$2], $3;\0A\09wmma.load.c.sync.aligned.row.m16n16k16.s32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, [$4], $5;\0A\09wmma.mma.sync.aligned.row.row.m16n16k16.s32.u8.u8.s32 {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, {%wa0,%wa1}, {%wb0,%wb1}, {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7};\0A\09wmma.store.d.sync.aligned.row.m16n16k16.s32 [$4], {%wc0,%wc1,%wc2,%wc3,%wc4,%wc5,%wc6,%wc7}, $5;\0A}", "l,r,l,r,l,r,~{memory}"(i8* %a, i32 %lda, i8* %b, i32 %ldb, i8* %c, i32 %ldc)
+       ret i32 0
+}
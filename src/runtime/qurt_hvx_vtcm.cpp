@@ -2,17 +2,148 @@
 #include "HalideRuntimeQurt.h"
 #include "mini_qurt.h"
 #include "mini_qurt_vtcm.h"
+#include "scoped_mutex_lock.h"
 
 using namespace Halide::Runtime::Internal::Qurt;
 
+namespace Halide { namespace Runtime { namespace Internal { namespace Qurt {
+
+// Requesting and releasing VTCM from the driver is expensive, and
+// allocations stored in VTCM are often inside loops. So the first
+// allocation reserves a pool, which is then sub-allocated and held
+// until the pipeline library is unloaded. Allocations that don't fit
+// in the pool (or made when the pool couldn't be reserved) go
+// directly to the driver, as before.
+const int vtcm_pool_size = 256 * 1024;
+// Sub-allocations are rounded up to a multiple of an HVX vector.
+const int vtcm_alignment = 128;
+const int max_vtcm_blocks = 64;
+
+// The pool is divided into contiguous blocks, kept in address order.
+struct vtcm_block {
+    int offset;
+    int size;
+    bool used;
+};
+
+WEAK uint8_t *vtcm_pool = NULL;
+// Set if reserving the pool failed, so we don't keep retrying.
+WEAK bool vtcm_pool_failed = false;
+WEAK vtcm_block vtcm_blocks[max_vtcm_blocks];
+WEAK int vtcm_block_count = 0;
+WEAK halide_mutex vtcm_pool_mutex;
+
+WEAK void *vtcm_pool_alloc(int size) {
+    size = (size + vtcm_alignment - 1) & ~(vtcm_alignment - 1);
+
+    if (!vtcm_pool && !vtcm_pool_failed) {
+        vtcm_pool = (uint8_t *)HAP_request_VTCM(vtcm_pool_size, 1);
+        if (vtcm_pool) {
+            vtcm_blocks[0].offset = 0;
+            vtcm_blocks[0].size = vtcm_pool_size;
+            vtcm_blocks[0].used = false;
+            vtcm_block_count = 1;
+        } else {
+            vtcm_pool_failed = true;
+        }
+    }
+    if (!vtcm_pool) {
+        return NULL;
+    }
+
+    for (int i = 0; i < vtcm_block_count; i++) {
+        vtcm_block &b = vtcm_blocks[i];
+        if (b.used || b.size < size) {
+            continue;
+        }
+        if (b.size > size && vtcm_block_count < max_vtcm_blocks) {
+            // Split off the remainder as a new free block.
+            for (int j = vtcm_block_count; j > i + 1; j--) {
+                vtcm_blocks[j] = vtcm_blocks[j - 1];
+            }
+            vtcm_blocks[i + 1].offset = b.offset + size;
+            vtcm_blocks[i + 1].size = b.size - size;
+            vtcm_blocks[i + 1].used = false;
+            vtcm_block_count++;
+            b.size = size;
+        }
+        b.used = true;
+        return vtcm_pool + b.offset;
+    }
+    return NULL;
+}
+
+// Returns false if addr is not in the pool.
+WEAK bool vtcm_pool_free(void *addr) {
+    if (!vtcm_pool ||
+        (uint8_t *)addr < vtcm_pool ||
+        (uint8_t *)addr >= vtcm_pool + vtcm_pool_size) {
+        return false;
+    }
+    int offset = (int)((uint8_t *)addr - vtcm_pool);
+    for (int i = 0; i < vtcm_block_count; i++) {
+        if (vtcm_blocks[i].offset != offset) {
+            continue;
+        }
+        vtcm_blocks[i].used = false;
+        // Coalesce with the following and preceding blocks if they are free.
+        if (i + 1 < vtcm_block_count && !vtcm_blocks[i + 1].used) {
+            vtcm_blocks[i].size += vtcm_blocks[i + 1].size;
+            for (int j = i + 1; j < vtcm_block_count - 1; j++) {
+                vtcm_blocks[j] = vtcm_blocks[j + 1];
+            }
+            vtcm_block_count--;
+        }
+        if (i > 0 && !vtcm_blocks[i - 1].used) {
+            vtcm_blocks[i - 1].size += vtcm_blocks[i].size;
+            for (int j = i; j < vtcm_block_count - 1; j++) {
+                vtcm_blocks[j] = vtcm_blocks[j + 1];
+            }
+            vtcm_block_count--;
+        }
+        break;
+    }
+    return true;
+}
+
+}}}}  // namespace Halide::Runtime::Internal::Qurt
+
 extern "C" {
 
 WEAK void* halide_vtcm_malloc(void *user_context, int size) {
+    {
+        ScopedMutexLock lock(&vtcm_pool_mutex);
+        void *addr = vtcm_pool_alloc(size);
+        if (addr) {
+            return addr;
+        }
+    }
     return HAP_request_VTCM(size, 1);
 }
 
 WEAK void halide_vtcm_free(void *user_context, void *addr) {
+    {
+        ScopedMutexLock lock(&vtcm_pool_mutex);
+        if (vtcm_pool_free(addr)) {
+            return;
+        }
+    }
     HAP_release_VTCM(addr);
 }
 
+namespace {
+
+__attribute__((destructor))
+WEAK void halide_vtcm_pool_cleanup() {
+    ScopedMutexLock lock(&vtcm_pool_mutex);
+    if (vtcm_pool) {
+        HAP_release_VTCM(vtcm_pool);
+        vtcm_pool = NULL;
+        vtcm_block_count = 0;
+    }
+    vtcm_pool_failed = false;
+}
+
+}
+
 }
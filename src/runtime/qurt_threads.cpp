@@ -77,6 +77,10 @@ WEAK void halide_join_thread(struct halide_thread *thread_arg) {
 
 namespace Halide { namespace Runtime { namespace Internal {
 
+WEAK uint64_t halide_current_thread_id() {
+    return qurt_thread_get_id();
+}
+
 namespace Synchronization {
 
 struct thread_parker {
@@ -4,7 +4,8 @@
 namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK CpuFeatures halide_get_cpu_features() {
-    // For now, no version specific features, though RISCV promises to have many.
+    // The vector extension is only discoverable from machine mode
+    // (misa) or through OS-specific hwcaps, so rvv is left unknown.
     return CpuFeatures();
 }
 
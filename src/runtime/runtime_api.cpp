@@ -7,6 +7,8 @@
 #include "HalideRuntimeHexagonHost.h"
 #include "HalideRuntimeD3D12Compute.h"
 #include "HalideRuntimeQurt.h"
+#include "HalideRuntimeVulkan.h"
+#include "HalideRuntimeWebGPU.h"
 #include "cpu_features.h"
 
 // This runtime module will contain extern declarations of the Halide
@@ -17,25 +19,46 @@
 // cat src/runtime/runtime_internal.h src/runtime/HalideRuntime*.h | grep "^[^ ][^(]*halide_[^ ]*(" | grep -v '#define' | sed "s/[^(]*halide/halide/" | sed "s/(.*//" | sed "s/^h/    \(void *)\&h/" | sed "s/$/,/" | sort | uniq
 
 extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
+    (void *)&halide_arena_alloc,
+    (void *)&halide_arena_cleanup,
+    (void *)&halide_arena_create,
+    (void *)&halide_arena_destroy,
+    (void *)&halide_arena_free,
+    (void *)&halide_bfloat16_bits_to_double,
+    (void *)&halide_bfloat16_bits_to_float,
+    (void *)&halide_bounds_check_cache_lookup,
+    (void *)&halide_bounds_check_cache_store,
+    (void *)&halide_branch_profile_dump,
+    (void *)&halide_branch_profile_register,
+    (void *)&halide_branch_profile_reset,
     (void *)&halide_buffer_copy,
     (void *)&halide_buffer_to_string,
+    (void *)&halide_can_reuse_device_allocations,
     (void *)&halide_can_use_target_features,
     (void *)&halide_cond_broadcast,
     (void *)&halide_cond_signal,
     (void *)&halide_cond_wait,
     (void *)&halide_copy_to_device,
     (void *)&halide_copy_to_device_legacy,
+    (void *)&halide_copy_to_device_region,
     (void *)&halide_copy_to_host,
     (void *)&halide_copy_to_host_legacy,
+    (void *)&halide_copy_to_host_region,
+    (void *)&halide_cuda_begin_graph_capture,
     (void *)&halide_cuda_detach_device_ptr,
     (void *)&halide_cuda_device_interface,
+    (void *)&halide_cuda_end_graph_capture,
+    (void *)&halide_cuda_get_current_stream,
     (void *)&halide_cuda_get_device_ptr,
+    (void *)&halide_cuda_graph_launch,
+    (void *)&halide_cuda_graph_release,
     (void *)&halide_cuda_initialize_kernels,
     (void *)&halide_cuda_run,
     (void *)&halide_cuda_wrap_device_ptr,
     (void *)&halide_current_time_ns,
     (void *)&halide_debug_to_file,
     (void *)&halide_default_can_use_target_features,
+    (void *)&halide_device_allocation_cache_flush,
     (void *)&halide_device_and_host_free,
     (void *)&halide_device_and_host_free_as_destructor,
     (void *)&halide_device_and_host_malloc,
@@ -92,9 +115,11 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_get_library_symbol,
     (void *)&halide_get_symbol,
     (void *)&halide_get_trace_file,
+    (void *)&halide_hexagon_begin_batch,
     (void *)&halide_hexagon_detach_device_handle,
     (void *)&halide_hexagon_device_interface,
     (void *)&halide_hexagon_device_release,
+    (void *)&halide_hexagon_end_batch,
     (void *)&halide_hexagon_get_device_handle,
     (void *)&halide_hexagon_get_device_size,
     (void *)&halide_hexagon_initialize_kernels,
@@ -114,8 +139,13 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_memoization_cache_cleanup,
     (void *)&halide_memoization_cache_lookup,
     (void *)&halide_memoization_cache_release,
+    (void *)&halide_memoization_cache_set_pipeline_budget,
     (void *)&halide_memoization_cache_set_size,
     (void *)&halide_memoization_cache_store,
+    (void *)&halide_memory_pool_acquire,
+    (void *)&halide_memory_pool_create,
+    (void *)&halide_memory_pool_destroy,
+    (void *)&halide_memory_pool_release,
     (void *)&halide_metal_acquire_context,
     (void *)&halide_metal_detach_buffer,
     (void *)&halide_metal_device_interface,
@@ -130,6 +160,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_msan_annotate_memory_is_initialized,
     (void *)&halide_mutex_lock,
     (void *)&halide_mutex_unlock,
+    (void *)&halide_opencl_detach_ahardwarebuffer,
     (void *)&halide_opencl_detach_cl_mem,
     (void *)&halide_opencl_device_interface,
     (void *)&halide_opencl_get_cl_mem,
@@ -140,6 +171,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_opencl_run,
     (void *)&halide_opencl_set_device_type,
     (void *)&halide_opencl_set_platform_name,
+    (void *)&halide_opencl_wrap_ahardwarebuffer,
     (void *)&halide_opencl_wrap_cl_mem,
     (void *)&halide_opengl_context_lost,
     (void *)&halide_opengl_create_context,
@@ -156,18 +188,22 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_openglcompute_run,
     (void *)&halide_pointer_to_string,
     (void *)&halide_print,
+    (void *)&halide_profiler_acquire_slot,
     (void *)&halide_profiler_get_pipeline_state,
     (void *)&halide_profiler_get_state,
     (void *)&halide_profiler_memory_allocate,
     (void *)&halide_profiler_memory_free,
     (void *)&halide_profiler_pipeline_start,
+    (void *)&halide_profiler_release_slot,
     (void *)&halide_profiler_report,
     (void *)&halide_profiler_reset,
     (void *)&halide_profiler_stack_peak_update,
     (void *)&halide_qurt_hvx_lock,
     (void *)&halide_qurt_hvx_unlock,
     (void *)&halide_qurt_hvx_unlock_as_destructor,
+    (void *)&halide_register_dispatch_cache,
     (void *)&halide_release_jit_module,
+    (void *)&halide_reuse_device_allocations,
     (void *)&halide_semaphore_init,
     (void *)&halide_semaphore_release,
     (void *)&halide_semaphore_try_acquire,
@@ -182,10 +218,15 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_set_custom_malloc,
     (void *)&halide_set_custom_print,
     (void *)&halide_set_custom_trace,
+    (void *)&halide_set_device_allocation_cache_limit,
     (void *)&halide_set_error_handler,
     (void *)&halide_set_gpu_device,
+    (void *)&halide_set_large_page_threshold,
     (void *)&halide_set_num_threads,
+    (void *)&halide_set_thread_pool_idle_timeout,
+    (void *)&halide_set_thread_pool_priority,
     (void *)&halide_set_trace_file,
+    (void *)&halide_set_trace_sample_rate,
     (void *)&halide_shutdown_thread_pool,
     (void *)&halide_shutdown_trace,
     (void *)&halide_sleep_ms,
@@ -202,4 +243,23 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_d3d12compute_initialize_kernels,
     (void *)&halide_d3d12compute_release_context,
     (void *)&halide_d3d12compute_run,
+    (void *)&halide_vulkan_acquire_context,
+    (void *)&halide_vulkan_detach_vk_buffer,
+    (void *)&halide_vulkan_device_interface,
+    (void *)&halide_vulkan_get_crop_offset,
+    (void *)&halide_vulkan_get_queue_index,
+    (void *)&halide_vulkan_get_vk_buffer,
+    (void *)&halide_vulkan_initialize_kernels,
+    (void *)&halide_vulkan_release_context,
+    (void *)&halide_vulkan_run,
+    (void *)&halide_vulkan_wrap_vk_buffer,
+    (void *)&halide_webgpu_acquire_context,
+    (void *)&halide_webgpu_detach_native,
+    (void *)&halide_webgpu_device_interface,
+    (void *)&halide_webgpu_get_crop_offset,
+    (void *)&halide_webgpu_get_native_buffer,
+    (void *)&halide_webgpu_initialize_kernels,
+    (void *)&halide_webgpu_release_context,
+    (void *)&halide_webgpu_run,
+    (void *)&halide_webgpu_wrap_native,
 };
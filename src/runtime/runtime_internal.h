@@ -78,6 +78,9 @@ int fileno(void *);
 int fclose(void *);
 int close(int);
 size_t fwrite(const void *, size_t, size_t, void *);
+size_t fread(void *, size_t, size_t, void *);
+int fseek(void *, long, int);
+long ftell(void *);
 ssize_t write(int fd, const void *buf, size_t bytes);
 int remove(const char *pathname);
 int ioctl(int fd, unsigned long request, ...);
@@ -128,6 +131,8 @@ WEAK void halide_profiler_memory_free(void *user_context,
                                       void *pipeline_state,
                                       int func_id,
                                       uint64_t decr);
+WEAK int *halide_profiler_acquire_slot(void *state, int func);
+WEAK void halide_profiler_release_slot(void *state, int *slot);
 WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const char *pipeline_name,
                                         int num_funcs,
@@ -197,6 +202,53 @@ extern WEAK __attribute__((always_inline)) void halide_abort();
 
 void halide_thread_yield();
 
+// Pin the calling thread to the given cpu. Returns false if this is
+// not supported on the current platform.
+bool halide_thread_set_affinity(int cpu);
+
+// The number of cpus the process may use according to its cgroup cpu
+// quota, rounded up, or zero if there is no quota or it can't be read.
+int halide_host_cpu_quota();
+
+// An identifier for the calling thread, unique among running threads.
+uint64_t halide_current_thread_id();
+
+// Add an event on the calling thread to the timeline written when
+// HL_TRACE_FORMAT=chrome. phase is a Chrome trace event phase: 'B' or
+// 'E' to begin or end a duration, or 'i' for an instant. The hook is
+// set by the tracing module while a timeline is being written, and is
+// otherwise NULL. It lives in the thread pool, so that it exists even
+// on platforms that don't include the tracing module.
+typedef void (*halide_timeline_event_fn)(void *user_context, const char *name, const char *cat, char phase);
+extern halide_timeline_event_fn halide_timeline_event_hook;
+
+__attribute__((always_inline)) inline void halide_timeline_event(void *user_context, const char *name,
+                                                                 const char *cat, char phase) {
+    if (halide_timeline_event_hook) {
+        halide_timeline_event_hook(user_context, name, cat, phase);
+    }
+}
+
+// Hardware performance counters for the sampling profiler. Get an id
+// for the calling thread, and open a group of counters for it with one
+// per halide_perf_counter_t, returning -1 if this isn't
+// supported. Reading a group writes the current value of each counter
+// to values. Any thread may read a group.
+int halide_perf_counters_thread_id();
+int halide_perf_counters_open();
+bool halide_perf_counters_read(int group, uint64_t *values);
+
+// Map a file into memory, shared with every other process that maps
+// it. The file is created if it doesn't exist, and grown to at least
+// size bytes, which are zero when new. Returns NULL if this isn't
+// supported. The descriptor written to fd locks the file against
+// other processes, for serializing writers. Unmapping also closes the
+// descriptor.
+void *halide_shared_file_map(void *user_context, const char *path, size_t size, int *fd);
+void halide_shared_file_unmap(void *mapping, size_t size, int fd);
+void halide_shared_file_lock(int fd);
+void halide_shared_file_unlock(int fd);
+
 }}}
 
 /** A macro that calls halide_print if the supplied condition is
@@ -126,7 +126,8 @@ __attribute__((always_inline)) uintptr_t atomic_or_fetch_relaxed(uintptr_t *addr
     return __sync_or_and_fetch(addr, val);
 }
 
-__attribute__((always_inline)) void atomic_store_relaxed(uintptr_t *addr, uintptr_t *val) {
+template <typename T>
+__attribute__((always_inline)) void atomic_store_relaxed(T *addr, T *val) {
     *addr = *val;
 }
 
@@ -140,6 +141,10 @@ __attribute__((always_inline)) void atomic_thread_fence_acquire() {
      __sync_synchronize();
 }
 
+__attribute__((always_inline)) void atomic_thread_fence_sequentially_consistent() {
+     __sync_synchronize();
+}
+
 #else
 
 __attribute__((always_inline))  uintptr_t atomic_and_fetch_release(uintptr_t *addr, uintptr_t val) {
@@ -190,7 +195,8 @@ __attribute__((always_inline)) uintptr_t atomic_or_fetch_relaxed(uintptr_t *addr
     return __atomic_or_fetch(addr, val, __ATOMIC_RELAXED);
 }
 
-__attribute__((always_inline)) void atomic_store_relaxed(uintptr_t *addr, uintptr_t *val) {
+template <typename T>
+__attribute__((always_inline)) void atomic_store_relaxed(T *addr, T *val) {
     __atomic_store(addr, val, __ATOMIC_RELAXED);
 }
 
@@ -203,6 +209,10 @@ __attribute__((always_inline)) void atomic_thread_fence_acquire() {
     __atomic_thread_fence(__ATOMIC_ACQUIRE);
 }
 
+__attribute__((always_inline)) void atomic_thread_fence_sequentially_consistent() {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
 #endif
 
 }
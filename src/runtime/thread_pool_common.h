@@ -21,6 +21,32 @@ int gettid() {
 
 namespace Halide { namespace Runtime { namespace Internal {
 
+// A contiguous range of loop iterations owned by one participant in a
+// work-stealing job. The begin and end of the range are packed into a
+// single 64-bit word so that the owner can pop from the front and
+// thieves can split off the back half with a single compare-and-swap.
+struct work_slot {
+    uint64_t range;
+    // The NUMA node this range is intended for, or zero if NUMA mode
+    // is off. Written before the job is enqueued.
+    int node;
+    // Whether a worker has claimed this slot. Protected by the work
+    // queue mutex.
+    bool claimed;
+    // Pad to a cache line so that participants don't false-share.
+    char padding[64 - sizeof(uint64_t) - sizeof(int) - sizeof(bool)];
+};
+
+struct halide_semaphore_impl_t {
+    int value;
+    // Nonzero if a job has failed to acquire the semaphore since it
+    // was last released, so the next release must wake the thread
+    // pool. Only set and cleared with the work queue lock held.
+    int waiters;
+};
+
+WEAK bool semaphore_try_acquire_or_request_wakeup(halide_semaphore_t *s, int n);
+
 struct work {
     halide_parallel_task_t task;
 
@@ -32,6 +58,10 @@ struct work {
     work *siblings;
     int sibling_count;
     work *parent_job;
+
+    // The priority given to user_context with
+    // halide_set_thread_pool_priority when the job was enqueued.
+    int priority;
     int threads_reserved;
   
     void *user_context;
@@ -41,10 +71,22 @@ struct work {
     // which condition variable is the owner sleeping on. NULL if it isn't sleeping.
     bool owner_is_sleeping;
 
+    // If non-NULL, this job runs in work-stealing mode. The
+    // iterations were divided among num_slots ranges up front, and
+    // each participating worker claims one slot under the lock and
+    // then runs iterations from it without touching the lock again,
+    // stealing from the other slots when its own slot runs dry.
+    work_slot *slots;
+    int num_slots;
+    int slots_claimed;
+    // The first nonzero exit status seen by any participant. Only
+    // accessed atomically.
+    int steal_exit_status;
+
     bool make_runnable() {
         for (; next_semaphore < task.num_semaphores; next_semaphore++) {
-            if (!halide_default_semaphore_try_acquire(task.semaphores[next_semaphore].semaphore,
-                                                      task.semaphores[next_semaphore].count)) {
+            if (!semaphore_try_acquire_or_request_wakeup(task.semaphores[next_semaphore].semaphore,
+                                                         task.semaphores[next_semaphore].count)) {
                 // Note that we don't release the semaphores already
                 // acquired. We never have two consumers contending
                 // over the same semaphore, so it's not helpful to do
@@ -64,6 +106,127 @@ struct work {
 
 #define MAX_THREADS 256
 
+// The maximum number of user contexts that can be given a priority
+// and thread budget at once.
+#define MAX_THREAD_POOL_CLASSES 16
+
+// The priority and thread budget of the pipeline invocations made
+// with a given user_context.
+struct thread_pool_class {
+    void *user_context;
+    int priority;
+    // The most threads that may work on the jobs of this class at
+    // once, including the thread that called the pipeline, or zero
+    // for no limit.
+    int max_threads;
+    // The number of worker threads currently working on the jobs of
+    // this class on behalf of some other thread.
+    int active_workers;
+};
+
+// The maximum number of ranges a work-stealing job is split into.
+#define MAX_WORK_SLOTS 64
+
+WEAK uint64_t pack_range(int begin, int end) {
+    return ((uint64_t)(uint32_t)begin << 32) | (uint64_t)(uint32_t)end;
+}
+
+WEAK int range_begin(uint64_t r) {
+    return (int)(uint32_t)(r >> 32);
+}
+
+WEAK int range_end(uint64_t r) {
+    return (int)(uint32_t)(r & 0xffffffff);
+}
+
+// Take the first iteration from a slot. Only the owner of a slot pops
+// from it, but thieves may concurrently shrink it from the back.
+WEAK bool slot_pop_front(work_slot *slot, int *idx) {
+    uint64_t old_range, new_range;
+    Synchronization::atomic_load_acquire(&slot->range, &old_range);
+    do {
+        int begin = range_begin(old_range), end = range_end(old_range);
+        if (begin >= end) {
+            return false;
+        }
+        *idx = begin;
+        new_range = pack_range(begin + 1, end);
+    } while (!Synchronization::atomic_cas_weak_relacq_relaxed(&slot->range, &old_range, &new_range));
+    return true;
+}
+
+// Try to move work from some other slot into this (empty) slot. Takes
+// the back half of the fullest-looking victim, preferring victims on
+// the thief's own NUMA node. Returns false if all other slots appear
+// to be empty.
+WEAK bool slot_steal(work *job, int thief) {
+    while (true) {
+        int victim = -1, best = 0;
+        uint64_t victim_range = 0;
+        for (int i = 1; i <= job->num_slots; i++) {
+            // Start scanning at the slot after our own so that thieves
+            // spread out over the victims.
+            int v = (thief + i) % job->num_slots;
+            if (v == thief) continue;
+            if (victim >= 0 &&
+                job->slots[victim].node == job->slots[thief].node &&
+                job->slots[v].node != job->slots[thief].node) {
+                // We already have a victim on our own node.
+                continue;
+            }
+            uint64_t r;
+            Synchronization::atomic_load_acquire(&job->slots[v].range, &r);
+            int remaining = range_end(r) - range_begin(r);
+            bool local = job->slots[v].node == job->slots[thief].node;
+            bool victim_local = victim >= 0 && job->slots[victim].node == job->slots[thief].node;
+            if (remaining > 0 && ((local && !victim_local) || remaining > best)) {
+                best = remaining;
+                victim = v;
+                victim_range = r;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+        int begin = range_begin(victim_range), end = range_end(victim_range);
+        int split = end - (end - begin + 1) / 2;
+        uint64_t new_range = pack_range(begin, split);
+        if (Synchronization::atomic_cas_weak_relacq_relaxed(&job->slots[victim].range, &victim_range, &new_range)) {
+            uint64_t stolen = pack_range(split, end);
+            Synchronization::atomic_store_release(&job->slots[thief].range, &stolen);
+            return true;
+        }
+        // Lost a race with the owner or another thief. Rescan.
+    }
+}
+
+// Run iterations of a work-stealing job until every slot is
+// empty. Called without the work queue lock held.
+WEAK int run_work_stealing_job(work *job, int slot) {
+    int idx;
+    int result = 0;
+    do {
+        while (slot_pop_front(&job->slots[slot], &idx)) {
+            int exit_status;
+            Synchronization::atomic_load_relaxed(&job->steal_exit_status, &exit_status);
+            if (exit_status != 0) {
+                return exit_status;
+            }
+            if (job->task_fn) {
+                result = halide_do_task(job->user_context, job->task_fn, idx, job->task.closure);
+            } else {
+                result = halide_do_loop_task(job->user_context, job->task.fn, idx, 1, job->task.closure, job);
+            }
+            if (result != 0) {
+                int expected = 0;
+                Synchronization::atomic_cas_weak_relacq_relaxed(&job->steal_exit_status, &expected, &result);
+                return result;
+            }
+        }
+    } while (slot_steal(job, slot));
+    return 0;
+}
+
 WEAK int clamp_num_threads(int threads) {
     if (threads > MAX_THREADS) {
         threads = MAX_THREADS;
@@ -96,6 +259,17 @@ struct work_queue_t {
     // The desired number threads doing work (HL_NUM_THREADS).
     int desired_threads_working;
 
+    // The user contexts that have been given a priority or thread
+    // budget. These persist across thread pool shutdowns.
+    thread_pool_class classes[MAX_THREAD_POOL_CLASSES];
+    int num_classes;
+
+    // How long in milliseconds the elastic thread pool keeps workers
+    // that the load no longer needs (HL_THREAD_POOL_IDLE_TIMEOUT_MS),
+    // or -1 if the pool isn't elastic, or 0 to read it from the
+    // environment when the pool is initialized.
+    int idle_timeout_ms;
+
     // All fields after this must be zero in the initial state. See assert_zeroed
     // Field serves both to mark the offset in struct and as layout padding.
     int zero_marker;
@@ -103,7 +277,9 @@ struct work_queue_t {
     // Singly linked list for job stack
     work *jobs;
 
-    // The number threads created
+    // The number threads created. In an elastic pool, this is the
+    // number of workers that haven't retired, which are always the
+    // first ones in threads.
     int threads_created;
 
     // Workers sleep on one of two condition variables, to make it
@@ -126,10 +302,48 @@ struct work_queue_t {
     // Keep track of threads so they can be joined at shutdown
     halide_thread *threads[MAX_THREADS];
 
+    // The workers that have retired from an elastic pool, which are
+    // joined the next time more workers are spawned, or at shutdown.
+    halide_thread *retired_threads[MAX_THREADS];
+    int threads_retired;
+
+    // The state of an elastic pool. The number of workers the load
+    // needs, the number working on jobs now, and the most that have
+    // been working at once since window_start_ns. The cpu quota of
+    // the process is the number of cpus it may use, or zero if there
+    // is no limit, and was last read at quota_checked_ns.
+    int worker_limit;
+    int workers_working, peak_workers_working;
+    int64_t window_start_ns;
+    int cpu_quota;
+    int64_t quota_checked_ns;
+
     // Global flags indicating the threadpool should shut down, and
     // whether the thread pool has been initialized.
     bool shutdown, initialized;
 
+    // Whether simple parallel loops should be run with per-worker
+    // ranges and work stealing instead of claiming one iteration at a
+    // time under the lock (HL_THREAD_POOL_WORK_STEALING).
+    bool work_stealing;
+
+    // Whether the ranges of simple parallel loops are handed to the
+    // workers by index (HL_THREAD_POOL_AFFINITY), so that consecutive
+    // loops with the same extent give the same range to the same
+    // worker, and a consumer finds the rows it reads in the cache of
+    // the core that produced them. Implies work stealing.
+    bool affinity;
+
+    // The number of NUMA nodes the host cpus are split into
+    // (HL_NUMA_NODES). If greater than one, worker threads are pinned
+    // to cpus, and the ranges of simple parallel loops are divided
+    // among the nodes in order, so that a given part of the iteration
+    // space consistently runs on the same node.
+    int numa_nodes;
+
+    // The number of cpus on the host, used to place pinned workers.
+    int cpu_count;
+
     // The number of threads that are currently commited to possibly block
     // via outstanding jobs queued or being actively worked on. Used to limit
     // the number of iterations of parallel for loops that are invoked so as
@@ -142,7 +356,7 @@ struct work_queue_t {
 
     // Used to check initial state is correct.
     void assert_zeroed() const {
-        // Assert that all fields except the mutex and desired hreads count are zeroed.
+        // Assert that all fields except the mutex, desired threads count, classes and idle timeout are zeroed.
         const char *bytes = ((const char *)&this->zero_marker);
         const char *limit = ((const char *)this) + sizeof(work_queue_t);
         while (bytes < limit && *bytes == 0) {
@@ -154,7 +368,7 @@ struct work_queue_t {
     // Return the work queue to initial state. Must be called while locked
     // and queue will remain locked.
     void reset() {
-        // Ensure all fields except the mutex and desired hreads count are zeroed.
+        // Ensure all fields except the mutex, desired threads count, classes and idle timeout are zeroed.
         char *bytes = ((char *)&this->zero_marker);
         char *limit = ((char *)this) + sizeof(work_queue_t);
         memset(bytes, 0, limit - bytes);
@@ -192,11 +406,197 @@ WEAK void dump_job_state() {
 
 WEAK void worker_thread(void *);
 
-WEAK void worker_thread_already_locked(work *owned_job) {
+// Try to acquire a semaphore for a job. If it can't be acquired, ask
+// whoever next releases it to wake the thread pool. Must be called
+// with the work queue lock held, which is also held when the request
+// is cleared.
+WEAK bool semaphore_try_acquire_or_request_wakeup(halide_semaphore_t *s, int n) {
+    if (halide_default_semaphore_try_acquire(s, n)) {
+        return true;
+    }
+    halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
+    int one = 1;
+    Synchronization::atomic_store_relaxed(&sem->waiters, &one);
+    // Check again, in case the semaphore was released before the
+    // releaser could see the request. This pairs with the fence in
+    // halide_default_semaphore_release.
+    Synchronization::atomic_thread_fence_sequentially_consistent();
+    return halide_default_semaphore_try_acquire(s, n);
+}
+
+// The NUMA node of the cpu a given worker thread is pinned to. Nodes
+// are assumed to own contiguous ranges of cpu ids. Threads that are
+// not part of the pool (e.g. the one calling into the pipeline) are
+// treated as being on the first node.
+WEAK int numa_node_of_cpu(int cpu) {
+    if (work_queue.numa_nodes <= 1) {
+        return 0;
+    }
+    return (int)(((int64_t)cpu * work_queue.numa_nodes) / work_queue.cpu_count);
+}
+
+WEAK int cpu_of_worker(int thread_index) {
+    // Leave cpu zero for the thread that is calling into the pipeline.
+    return (thread_index + 1) % work_queue.cpu_count;
+}
+
+// Find the thread pool class for a user context, or NULL.
+WEAK thread_pool_class *find_thread_pool_class_already_locked(void *user_context) {
+    for (int i = 0; i < work_queue.num_classes; i++) {
+        if (work_queue.classes[i].user_context == user_context) {
+            return &work_queue.classes[i];
+        }
+    }
+    return NULL;
+}
+
+// Push a job onto the job stack, above the jobs of the same or lower
+// priority. Workers prefer jobs near the top of the stack, so this
+// serves higher priority jobs first.
+WEAK void push_job_already_locked(work *job) {
+    work **prev_ptr = &work_queue.jobs;
+    while (*prev_ptr && (*prev_ptr)->priority > job->priority) {
+        prev_ptr = &((*prev_ptr)->next_job);
+    }
+    job->next_job = *prev_ptr;
+    *prev_ptr = job;
+}
+
+// The thread pool class whose thread budget a thread working on a job
+// uses up, if any. A thread that owns a job with the same user context
+// is already working on that pipeline invocation, so it doesn't use
+// any more of it.
+WEAK thread_pool_class *budget_for_job_already_locked(const work *job, const work *owned_job) {
+    if (work_queue.num_classes == 0 ||
+        (owned_job && owned_job->user_context == job->user_context)) {
+        return NULL;
+    }
+    return find_thread_pool_class_already_locked(job->user_context);
+}
+
+// Pick the slot of a work-stealing job for a thread to claim, or return
+// -1 if it shouldn't join the job. Worker threads are numbered from one
+// in the order they were created, and the thread that owns the job
+// counts as worker zero.
+WEAK int choose_slot_already_locked(const work *job, const work *owned_job, int numa_node, int worker_index) {
+    int slot = -1;
+    if (work_queue.affinity) {
+        // Each slot belongs to one worker. Only the owner takes
+        // someone else's unclaimed slot; the other workers leave them
+        // for their own workers, or to be stolen from.
+        int own = worker_index % job->num_slots;
+        if (!job->slots[own].claimed) {
+            return own;
+        } else if (job != owned_job) {
+            return -1;
+        }
+    }
+    for (int i = 0; i < job->num_slots; i++) {
+        if (!job->slots[i].claimed &&
+            (slot < 0 || job->slots[i].node == numa_node)) {
+            slot = i;
+            if (job->slots[i].node == numa_node) {
+                break;
+            }
+        }
+    }
+    return slot;
+}
+
+WEAK bool elastic_already_locked() {
+    return work_queue.idle_timeout_ms > 0;
+}
+
+// The most worker threads an elastic pool may keep: one less than the
+// desired number of threads, or than the cpu quota if that is lower,
+// because the thread that calls the pipeline also works.
+WEAK int elastic_max_workers_already_locked() {
+    int threads = work_queue.desired_threads_working;
+    if (work_queue.cpu_quota > 0 && work_queue.cpu_quota < threads) {
+        threads = work_queue.cpu_quota;
+    }
+    return threads - 1;
+}
+
+// Wake all the sleeping workers, so that any surplus ones retire.
+WEAK void wake_surplus_workers_already_locked() {
+    halide_cond_broadcast(&work_queue.wake_a_team);
+    halide_cond_broadcast(&work_queue.wake_b_team);
+}
+
+// Resize an elastic pool before enqueuing top-level work that could
+// use workers_wanted workers, counting the ones already working. The
+// pool grows right away to fit the work, up to the cpu quota and the
+// desired number of threads. Once per idle timeout, it shrinks to the
+// most workers that were working at once since the last time, and
+// the surplus workers retire.
+WEAK void resize_elastic_pool_already_locked(int workers_wanted) {
+    int64_t now = halide_current_time_ns(NULL);
+    // The quota can change while the process runs, e.g. when a
+    // container is resized, so read it again once a second.
+    if (work_queue.quota_checked_ns == 0 || now - work_queue.quota_checked_ns > 1000000000) {
+        work_queue.cpu_quota = halide_host_cpu_quota();
+        work_queue.quota_checked_ns = now;
+    }
+    if (now - work_queue.window_start_ns > (int64_t)work_queue.idle_timeout_ms * 1000000) {
+        work_queue.worker_limit = work_queue.peak_workers_working;
+        work_queue.peak_workers_working = work_queue.workers_working;
+        work_queue.window_start_ns = now;
+    }
+    if (work_queue.worker_limit < workers_wanted) {
+        work_queue.worker_limit = workers_wanted;
+    }
+    int max_workers = elastic_max_workers_already_locked();
+    if (work_queue.worker_limit > max_workers) {
+        work_queue.worker_limit = max_workers;
+    }
+    if (work_queue.threads_created > work_queue.worker_limit) {
+        wake_surplus_workers_already_locked();
+    }
+}
+
+// Whether a worker should leave an elastic pool that has more workers
+// than it needs. Workers retire from the end of threads, one at a
+// time, and only while no job is counting on the threads it reserved
+// to make progress.
+WEAK bool worker_should_retire_already_locked(int worker_index) {
+    if (!elastic_already_locked() ||
+        worker_index != work_queue.threads_created ||
+        work_queue.threads_reserved != 0) {
+        return false;
+    }
+    int limit = elastic_max_workers_already_locked();
+    if (work_queue.worker_limit < limit) {
+        limit = work_queue.worker_limit;
+    }
+    return worker_index > limit;
+}
+
+// Join the workers that have retired. They released the lock before
+// returning, so this doesn't wait for long.
+WEAK void join_retired_threads_already_locked() {
+    for (int i = 0; i < work_queue.threads_retired; i++) {
+        halide_join_thread(work_queue.retired_threads[i]);
+    }
+    work_queue.threads_retired = 0;
+}
+
+WEAK void worker_thread_already_locked(work *owned_job, int numa_node = 0, int worker_index = 0) {
     while (owned_job ? owned_job->running() : !work_queue.shutdown) {
         work *job = work_queue.jobs;
         work **prev_ptr = &work_queue.jobs;
 
+        if (!owned_job && worker_should_retire_already_locked(worker_index)) {
+            work_queue.threads_created--;
+            work_queue.retired_threads[work_queue.threads_retired++] =
+                work_queue.threads[work_queue.threads_created];
+            work_queue.a_team_size--;
+            log_message("Worker " << worker_index << " retiring");
+            // The worker before this one may be surplus too.
+            wake_surplus_workers_already_locked();
+            return;
+        }
+
         if (owned_job) {
             if (owned_job->exit_status != 0) {
                 if (owned_job->active_workers == 0) {
@@ -256,8 +656,24 @@ WEAK void worker_thread_already_locked(work *owned_job) {
             if (!can_add_worker) {
                 log_message("Cannot add worker to job " << job->task.name);
             }              
-              
-            if (enough_threads && can_use_this_thread_stack && can_add_worker) {
+            // Jobs that don't need extra threads to make progress can
+            // always be finished by their owner, so they are the ones
+            // thread budgets apply to.
+            bool within_budget = true;
+            if (job->task.min_threads == 0) {
+                const thread_pool_class *c = budget_for_job_already_locked(job, owned_job);
+                within_budget = !c || c->max_threads <= 0 || c->active_workers < c->max_threads - 1;
+            }
+            if (!within_budget) {
+                log_message("Thread budget exhausted for job " << job->task.name);
+            }
+            bool has_slot = !job->slots ||
+                choose_slot_already_locked(job, owned_job, numa_node, worker_index) >= 0;
+            if (!has_slot) {
+                log_message("No slot for this thread in job " << job->task.name);
+            }
+
+            if (enough_threads && can_use_this_thread_stack && can_add_worker && within_budget && has_slot) {
                 if (job->make_runnable()) {
                     break;
                 } else {
@@ -273,7 +689,11 @@ WEAK void worker_thread_already_locked(work *owned_job) {
             if (owned_job) {
                 work_queue.owners_sleeping++;
                 owned_job->owner_is_sleeping = true;
+                // The owner is blocked waiting for other threads to
+                // finish its job, or for semaphores to be released.
+                halide_timeline_event(owned_job->user_context, owned_job->task.name, "wait", 'B');
                 halide_cond_wait(&work_queue.wake_owners, &work_queue.mutex);
+                halide_timeline_event(owned_job->user_context, owned_job->task.name, "wait", 'E');
                 owned_job->owner_is_sleeping = false;
                 work_queue.owners_sleeping--;
             } else {
@@ -293,6 +713,65 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
         log_message("Working on job " << job->task.name);
 
+        thread_pool_class *budget = budget_for_job_already_locked(job, owned_job);
+        if (budget) {
+            budget->active_workers++;
+        }
+        if (!owned_job) {
+            work_queue.workers_working++;
+            if (work_queue.workers_working > work_queue.peak_workers_working) {
+                work_queue.peak_workers_working = work_queue.workers_working;
+            }
+        }
+
+        if (job->slots) {
+            // Claim a slot. Once the last slot is claimed, no more
+            // workers can usefully join, so take the job off the
+            // stack. The remaining participants steal from each
+            // other until it's done.
+            int slot = choose_slot_already_locked(job, owned_job, numa_node, worker_index);
+            job->slots[slot].claimed = true;
+            job->slots_claimed++;
+            if (job->slots_claimed == job->num_slots) {
+                *prev_ptr = job->next_job;
+                job->task.extent = 0;
+            }
+            job->active_workers++;
+            halide_mutex_unlock(&work_queue.mutex);
+            halide_timeline_event(job->user_context, job->task.name, "task", 'B');
+            int result = run_work_stealing_job(job, slot);
+            halide_timeline_event(job->user_context, job->task.name, "task", 'E');
+            halide_mutex_lock(&work_queue.mutex);
+            if (result != 0) {
+                log_message("Saw thread pool saw error from task: " << result);
+                if (job->exit_status == 0) {
+                    job->exit_status = result;
+                }
+            }
+            if (job->task.extent != 0) {
+                // We found nothing left to steal, so the remaining
+                // iterations (if any) are all in the hands of other
+                // participants. Stop new workers from joining.
+                job->task.extent = 0;
+                work **p = &work_queue.jobs;
+                while (*p != job) {
+                    p = &((*p)->next_job);
+                }
+                *p = job->next_job;
+            }
+            job->active_workers--;
+            if (budget) {
+                budget->active_workers--;
+            }
+            if (!owned_job) {
+                work_queue.workers_working--;
+            }
+            if (job->active_workers == 0 && job->owner_is_sleeping) {
+                halide_cond_broadcast(&work_queue.wake_owners);
+            }
+            continue;
+        }
+
         // Increment the active_worker count so that other threads
         // are aware that this job is still in progress even
         // though there are no outstanding tasks for it.
@@ -314,6 +793,7 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
             // Release the lock and do the task.
             halide_mutex_unlock(&work_queue.mutex);
+            halide_timeline_event(job->user_context, job->task.name, "task", 'B');
             int total_iters = 0;
             int iters = 1;
             while (result == 0) {
@@ -331,6 +811,7 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                 total_iters += iters;
                 iters = 0;
             }
+            halide_timeline_event(job->user_context, job->task.name, "task", 'E');
             halide_mutex_lock(&work_queue.mutex);
 
             job->task.min += total_iters;
@@ -340,8 +821,7 @@ WEAK void worker_thread_already_locked(work *owned_job) {
             if (result != 0) {
                 job->task.extent = 0; // Force job to be finished.
             } else if (job->task.extent > 0) {
-                job->next_job = work_queue.jobs;
-                work_queue.jobs = job;
+                push_job_already_locked(job);
             }
         } else {
             // Claim a task from it.
@@ -357,6 +837,7 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
             // Release the lock and do the task.
             halide_mutex_unlock(&work_queue.mutex);
+            halide_timeline_event(myjob.user_context, myjob.task.name, "task", 'B');
             if (myjob.task_fn) {
                 result = halide_do_task(myjob.user_context, myjob.task_fn,
                                         myjob.task.min, myjob.task.closure);
@@ -365,6 +846,7 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                                              myjob.task.min, 1,
                                              myjob.task.closure, job);
             }
+            halide_timeline_event(myjob.user_context, myjob.task.name, "task", 'E');
             halide_mutex_lock(&work_queue.mutex);
         }
 
@@ -398,6 +880,12 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
         // We are no longer active on this job
         job->active_workers--;
+        if (budget) {
+            budget->active_workers--;
+        }
+        if (!owned_job) {
+            work_queue.workers_working--;
+        }
 
         log_message("Done working on job " << job->task.name);
 
@@ -409,13 +897,28 @@ WEAK void worker_thread_already_locked(work *owned_job) {
     }
 }
 
+// The entry point for worker threads. The argument is the index of the
+// thread in the pool.
 WEAK void worker_thread(void *arg) {
     halide_mutex_lock(&work_queue.mutex);
-    worker_thread_already_locked((work *)arg);
+    worker_thread_already_locked(NULL, 0, (int)(intptr_t)arg + 1);
     halide_mutex_unlock(&work_queue.mutex);
 }
 
-WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
+// The entry point for worker threads in NUMA mode. The argument is the
+// index of the thread in the pool.
+WEAK void pinned_worker_thread(void *arg) {
+    int cpu = cpu_of_worker((int)(intptr_t)arg);
+    int node = 0;
+    if (halide_thread_set_affinity(cpu)) {
+        node = numa_node_of_cpu(cpu);
+    }
+    halide_mutex_lock(&work_queue.mutex);
+    worker_thread_already_locked(NULL, node, (int)(intptr_t)arg + 1);
+    halide_mutex_unlock(&work_queue.mutex);
+}
+
+WEAK void initialize_work_queue_already_locked() {
     if (!work_queue.initialized) {
         work_queue.assert_zeroed();
 
@@ -426,8 +929,39 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             work_queue.desired_threads_working = default_desired_num_threads();
         }
         work_queue.desired_threads_working = clamp_num_threads(work_queue.desired_threads_working);
+        if (!work_queue.idle_timeout_ms) {
+            char *timeout_str = getenv("HL_THREAD_POOL_IDLE_TIMEOUT_MS");
+            work_queue.idle_timeout_ms = timeout_str && atoi(timeout_str) > 0 ? atoi(timeout_str) : -1;
+        }
+        char *stealing_str = getenv("HL_THREAD_POOL_WORK_STEALING");
+        work_queue.work_stealing = stealing_str && atoi(stealing_str) != 0;
+        char *affinity_str = getenv("HL_THREAD_POOL_AFFINITY");
+        work_queue.affinity = affinity_str && atoi(affinity_str) != 0;
+        // Affinity and NUMA placement turn on work stealing, unless
+        // it was explicitly turned off.
+        bool stealing_unset = stealing_str == NULL;
+        if (work_queue.affinity && stealing_unset) {
+            work_queue.work_stealing = true;
+        }
+        char *numa_str = getenv("HL_NUMA_NODES");
+        if (numa_str && atoi(numa_str) > 1) {
+            work_queue.cpu_count = halide_host_cpu_count();
+            work_queue.numa_nodes = atoi(numa_str);
+            if (work_queue.numa_nodes > work_queue.cpu_count) {
+                work_queue.numa_nodes = work_queue.cpu_count;
+            }
+            // Placing loop ranges by node relies on the ranges being
+            // fixed up front.
+            if (stealing_unset) {
+                work_queue.work_stealing = work_queue.numa_nodes > 1;
+            }
+        }
         work_queue.initialized = true;
     }
+}
+
+WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
+    initialize_work_queue_already_locked();
 
     // Gather some information about the work.
 
@@ -478,15 +1012,30 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             min_threads += 1;
         }
     
+        // An elastic pool only keeps as many workers as the load needs.
+        int workers_wanted = work_queue.desired_threads_working - 1;
+        if (elastic_already_locked()) {
+            resize_elastic_pool_already_locked(work_queue.workers_working + workers_to_wake);
+            workers_wanted = work_queue.worker_limit;
+            join_retired_threads_already_locked();
+        }
+
         // Spawn more threads if necessary.
         while (work_queue.threads_created < MAX_THREADS &&
-               ((work_queue.threads_created < work_queue.desired_threads_working - 1) ||
+               ((work_queue.threads_created < workers_wanted) ||
                 (work_queue.threads_created + 1) - work_queue.threads_reserved < min_threads)) {
             // We might need to make some new threads, if work_queue.desired_threads_working has
             // increased, or if there aren't enough threads to complete this new task.
             work_queue.a_team_size++;
-            work_queue.threads[work_queue.threads_created++] =
-                halide_spawn_thread(worker_thread, NULL);
+            if (work_queue.numa_nodes > 1) {
+                work_queue.threads[work_queue.threads_created] =
+                    halide_spawn_thread(pinned_worker_thread, (void *)(intptr_t)work_queue.threads_created);
+                work_queue.threads_created++;
+            } else {
+                work_queue.threads[work_queue.threads_created] =
+                    halide_spawn_thread(worker_thread, (void *)(intptr_t)work_queue.threads_created);
+                work_queue.threads_created++;
+            }
         }
         log_message("enqueue_work_already_locked top level job " << jobs[0].task.name << " with min_threads " << min_threads << " work_queue.threads_created " << work_queue.threads_created << " work_queue.threads_reserved " << work_queue.threads_reserved);
         if (job_has_acquires || job_may_block) {
@@ -503,13 +1052,12 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
 
     // Push the jobs onto the stack.
     for (int i = num_jobs - 1; i >= 0; i--) {
-        // We could bubble it downwards based on some heuristics, but
-        // it's not strictly necessary to do so.
-        jobs[i].next_job = work_queue.jobs;
+        const thread_pool_class *c = find_thread_pool_class_already_locked(jobs[i].user_context);
+        jobs[i].priority = c ? c->priority : 0;
         jobs[i].siblings = &jobs[0];
         jobs[i].sibling_count = num_jobs;
         jobs[i].threads_reserved = 0;
-        work_queue.jobs = jobs + i;
+        push_job_already_locked(jobs + i);
     }
 
     bool nested_parallelism =
@@ -543,6 +1091,7 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
     }
 }
 
+WEAK halide_timeline_event_fn halide_timeline_event_hook = NULL;
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_loop_task_t custom_do_loop_task = halide_default_do_loop_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
@@ -600,7 +1149,35 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     job.siblings = &job; // guarantees no other job points to the same siblings.
     job.sibling_count = 0;
     job.parent_job = NULL;
+    job.slots = NULL;
+    job.num_slots = 0;
+    job.slots_claimed = 0;
+    job.steal_exit_status = 0;
+
+    int max_slots = size < MAX_WORK_SLOTS ? size : MAX_WORK_SLOTS;
+    work_slot *slots = (work_slot *)__builtin_alloca(sizeof(work_slot) * max_slots);
+
     halide_mutex_lock(&work_queue.mutex);
+    initialize_work_queue_already_locked();
+    if (work_queue.work_stealing && size > 1) {
+        // Split the iterations evenly over one slot per thread.
+        int num_slots = work_queue.desired_threads_working;
+        if (num_slots > max_slots) {
+            num_slots = max_slots;
+        }
+        for (int i = 0; i < num_slots; i++) {
+            int begin = min + (int)(((int64_t)size * i) / num_slots);
+            int end = min + (int)(((int64_t)size * (i + 1)) / num_slots);
+            slots[i].range = pack_range(begin, end);
+            // In NUMA mode, consecutive slots go to the same node, so
+            // that (e.g.) a producer and consumer parallelized over
+            // the same rows touch them from the same node.
+            slots[i].node = work_queue.numa_nodes > 1 ? (int)(((int64_t)i * work_queue.numa_nodes) / num_slots) : 0;
+            slots[i].claimed = false;
+        }
+        job.slots = slots;
+        job.num_slots = num_slots;
+    }
     enqueue_work_already_locked(1, &job, NULL);
     worker_thread_already_locked(&job);
     halide_mutex_unlock(&work_queue.mutex);
@@ -626,6 +1203,10 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
         jobs[i].next_semaphore = 0;
         jobs[i].owner_is_sleeping = false;
         jobs[i].parent_job = (work *)task_parent;
+        jobs[i].slots = NULL;
+        jobs[i].num_slots = 0;
+        jobs[i].slots_claimed = 0;
+        jobs[i].steal_exit_status = 0;
     }
 
     if (num_tasks == 0) {
@@ -660,10 +1241,70 @@ WEAK int halide_set_num_threads(int n) {
     }
     int old = work_queue.desired_threads_working;
     work_queue.desired_threads_working = clamp_num_threads(n);
+    if (elastic_already_locked() && work_queue.desired_threads_working < old) {
+        // Retire the workers beyond the new number of threads now,
+        // rather than once they have been idle for the timeout.
+        wake_surplus_workers_already_locked();
+    }
     halide_mutex_unlock(&work_queue.mutex);
     return old;
 }
 
+WEAK int halide_set_thread_pool_idle_timeout(int ms) {
+    halide_mutex_lock(&work_queue.mutex);
+    int old = work_queue.idle_timeout_ms > 0 ? work_queue.idle_timeout_ms : 0;
+    if (ms == 0) {
+        char *timeout_str = getenv("HL_THREAD_POOL_IDLE_TIMEOUT_MS");
+        ms = timeout_str ? atoi(timeout_str) : 0;
+    }
+    work_queue.idle_timeout_ms = ms > 0 ? ms : -1;
+    if (work_queue.initialized && elastic_already_locked()) {
+        // Start a new window with the workers the pool already has.
+        work_queue.worker_limit = work_queue.threads_created;
+        work_queue.peak_workers_working = work_queue.workers_working;
+        work_queue.window_start_ns = halide_current_time_ns(NULL);
+        wake_surplus_workers_already_locked();
+    }
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
+WEAK int halide_set_thread_pool_priority(void *user_context, int priority, int max_threads) {
+    if (max_threads < 0) {
+        halide_error(user_context, "halide_set_thread_pool_priority: max_threads must be >= 0.");
+        return halide_error_code_generic_error;
+    }
+    halide_mutex_lock(&work_queue.mutex);
+    int result = 0;
+    thread_pool_class *c = find_thread_pool_class_already_locked(user_context);
+    if (!c && (priority != 0 || max_threads != 0)) {
+        // Reuse the entry of a user context that was set back to the
+        // default, once no workers are counted against it.
+        for (int i = 0; i < work_queue.num_classes && !c; i++) {
+            thread_pool_class &old = work_queue.classes[i];
+            if (old.priority == 0 && old.max_threads == 0 && old.active_workers == 0) {
+                c = &old;
+            }
+        }
+        if (!c && work_queue.num_classes < MAX_THREAD_POOL_CLASSES) {
+            c = &work_queue.classes[work_queue.num_classes++];
+            c->active_workers = 0;
+        }
+        if (c) {
+            c->user_context = user_context;
+        } else {
+            halide_error(user_context, "halide_set_thread_pool_priority: too many user contexts have a priority or thread budget.");
+            result = halide_error_code_generic_error;
+        }
+    }
+    if (c) {
+        c->priority = priority;
+        c->max_threads = max_threads;
+    }
+    halide_mutex_unlock(&work_queue.mutex);
+    return result;
+}
+
 WEAK void halide_shutdown_thread_pool() {
     if (work_queue.initialized) {
         // Wake everyone up and tell them the party's over and it's time
@@ -680,18 +1321,19 @@ WEAK void halide_shutdown_thread_pool() {
         for (int i = 0; i < work_queue.threads_created; i++) {
             halide_join_thread(work_queue.threads[i]);
         }
+        for (int i = 0; i < work_queue.threads_retired; i++) {
+            halide_join_thread(work_queue.retired_threads[i]);
+        }
 
         // Tidy up
         work_queue.reset();
     }
 }
 
-struct halide_semaphore_impl_t {
-    int value;
-};
-
 WEAK int halide_default_semaphore_init(halide_semaphore_t *s, int n) {
     halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
+    int zero = 0;
+    Halide::Runtime::Internal::Synchronization::atomic_store_relaxed(&sem->waiters, &zero);
     Halide::Runtime::Internal::Synchronization::atomic_store_release(&sem->value, &n);
     return n;
 }
@@ -699,12 +1341,29 @@ WEAK int halide_default_semaphore_init(halide_semaphore_t *s, int n) {
 WEAK int halide_default_semaphore_release(halide_semaphore_t *s, int n) {
     halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
     int old_val = Halide::Runtime::Internal::Synchronization::atomic_fetch_add_acquire_release(&sem->value, n);
-    // TODO(abadams|zvookin): Is this correct if an acquire can be for say count of 2 and the releases are 1 each?
-    if (old_val == 0 && n != 0) { // Don't wake if nothing released.
+    if (n == 0) { // Don't wake if nothing released.
+        return old_val;
+    }
+    // Only wake the thread pool if a job has failed to acquire this
+    // semaphore. Producers usually get ahead of their consumers, so
+    // most releases don't touch the thread pool's lock at all. This
+    // pairs with the fence in
+    // semaphore_try_acquire_or_request_wakeup: either we see its
+    // request, or it sees the count we just released.
+    Halide::Runtime::Internal::Synchronization::atomic_thread_fence_sequentially_consistent();
+    int waiters;
+    Halide::Runtime::Internal::Synchronization::atomic_load_relaxed(&sem->waiters, &waiters);
+    if (waiters) {
         // We may have just made a job runnable
         halide_mutex_lock(&work_queue.mutex);
-        halide_cond_broadcast(&work_queue.wake_a_team);
-        halide_cond_broadcast(&work_queue.wake_owners);
+        int zero = 0;
+        Halide::Runtime::Internal::Synchronization::atomic_store_relaxed(&sem->waiters, &zero);
+        if (work_queue.workers_sleeping) {
+            halide_cond_broadcast(&work_queue.wake_a_team);
+        }
+        if (work_queue.owners_sleeping) {
+            halide_cond_broadcast(&work_queue.wake_owners);
+        }
         halide_mutex_unlock(&work_queue.mutex);
     }
     return old_val + n;
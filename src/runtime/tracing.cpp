@@ -151,6 +151,257 @@ WEAK int halide_trace_file_lock = 0;
 WEAK bool halide_trace_file_initialized = false;
 WEAK void *halide_trace_file_internally_opened = NULL;
 
+// State for writing traces in the compact format (see
+// halide_trace_compact_record_t in HalideRuntime.h).
+WEAK bool halide_trace_compact = false;
+
+struct InternedString {
+    uint32_t hash;
+    uint32_t id;
+    char *str;
+};
+
+const static int interned_strings_size = 4096;
+WEAK InternedString *halide_trace_interned_strings = NULL;
+WEAK int halide_trace_interned_strings_lock = 0;
+WEAK uint32_t halide_trace_next_string_id = 1;
+WEAK bool halide_trace_compact_header_written = false;
+
+__attribute__((always_inline)) uint32_t varint_size(uint64_t x) {
+    uint32_t n = 1;
+    while (x >= 128) {
+        x >>= 7;
+        n++;
+    }
+    return n;
+}
+
+__attribute__((always_inline)) uint8_t *write_varint(uint8_t *dst, uint64_t x) {
+    while (x >= 128) {
+        *dst++ = (uint8_t)(x | 128);
+        x >>= 7;
+    }
+    *dst++ = (uint8_t)x;
+    return dst;
+}
+
+__attribute__((always_inline)) uint64_t zigzag(int64_t x) {
+    return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63);
+}
+
+// Write a record defining a string table entry.
+WEAK void write_compact_string(void *user_context, int fd, uint32_t id, const char *str, uint32_t len) {
+    uint32_t size = 1 + varint_size(id) + varint_size(len) + len;
+    uint8_t *dst = (uint8_t *)halide_trace_buffer->acquire_packet(user_context, fd, size);
+    uint8_t *p = dst;
+    *p++ = halide_trace_compact_string;
+    p = write_varint(p, id);
+    p = write_varint(p, len);
+    memcpy(p, str, len);
+    halide_trace_buffer->release_packet((halide_trace_packet_t *)dst);
+}
+
+// Get the string table id for a string, writing a record defining it if
+// it hasn't been seen before. Must be called by a thread that doesn't
+// currently hold a packet in the trace buffer, because it may need to
+// acquire one itself.
+WEAK uint32_t intern_string(void *user_context, int fd, const char *str) {
+    if (!str || !*str) {
+        return 0;
+    }
+
+    ScopedSpinLock lock(&halide_trace_interned_strings_lock);
+
+    if (!halide_trace_compact_header_written) {
+        uint8_t *dst = (uint8_t *)halide_trace_buffer->acquire_packet(user_context, fd, 4);
+        dst[0] = halide_trace_compact_header;
+        dst[1] = 'H';
+        dst[2] = 'T';
+        dst[3] = '2';
+        halide_trace_buffer->release_packet((halide_trace_packet_t *)dst);
+        halide_trace_compact_header_written = true;
+    }
+
+    uint32_t len = strlen(str);
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+    }
+
+    if (!halide_trace_interned_strings) {
+        size_t bytes = interned_strings_size * sizeof(InternedString);
+        halide_trace_interned_strings = (InternedString *)malloc(bytes);
+        halide_assert(user_context, halide_trace_interned_strings);
+        memset(halide_trace_interned_strings, 0, bytes);
+    }
+
+    for (int i = 0; i < interned_strings_size; i++) {
+        InternedString &e = halide_trace_interned_strings[(hash + i) & (interned_strings_size - 1)];
+        if (!e.str) {
+            char *copy = (char *)malloc(len + 1);
+            halide_assert(user_context, copy);
+            memcpy(copy, str, len + 1);
+            e.hash = hash;
+            e.id = halide_trace_next_string_id++;
+            e.str = copy;
+            write_compact_string(user_context, fd, e.id, str, len);
+            return e.id;
+        } else if (e.hash == hash && strcmp(e.str, str) == 0) {
+            return e.id;
+        }
+    }
+
+    // The table is full. Define the string again under a fresh id.
+    uint32_t id = halide_trace_next_string_id++;
+    write_compact_string(user_context, fd, id, str, len);
+    return id;
+}
+
+WEAK void write_compact_event(void *user_context, int fd, int32_t id, const halide_trace_event_t *e) {
+    uint32_t func_id = intern_string(user_context, fd, e->func);
+    uint32_t tag_id = intern_string(user_context, fd, e->trace_tag);
+
+    uint32_t value_bytes = e->value ? (uint32_t)(e->type.lanes * e->type.bytes()) : 0;
+    int dimensions = e->coordinates ? e->dimensions : 0;
+
+    uint32_t size = 1 +
+        varint_size((uint32_t)id) +
+        varint_size(zigzag(e->parent_id)) +
+        varint_size(e->event) +
+        varint_size(e->type.code) +
+        varint_size(e->type.bits) +
+        varint_size(e->type.lanes) +
+        varint_size(zigzag(e->value_index)) +
+        varint_size(func_id) +
+        varint_size(tag_id) +
+        varint_size(dimensions) +
+        varint_size(value_bytes) +
+        value_bytes;
+    int32_t prev = 0;
+    for (int i = 0; i < dimensions; i++) {
+        size += varint_size(zigzag((int64_t)e->coordinates[i] - prev));
+        prev = e->coordinates[i];
+    }
+
+    uint8_t *dst = (uint8_t *)halide_trace_buffer->acquire_packet(user_context, fd, size);
+    uint8_t *p = dst;
+    *p++ = halide_trace_compact_event;
+    p = write_varint(p, (uint32_t)id);
+    p = write_varint(p, zigzag(e->parent_id));
+    p = write_varint(p, e->event);
+    p = write_varint(p, e->type.code);
+    p = write_varint(p, e->type.bits);
+    p = write_varint(p, e->type.lanes);
+    p = write_varint(p, zigzag(e->value_index));
+    p = write_varint(p, func_id);
+    p = write_varint(p, tag_id);
+    p = write_varint(p, dimensions);
+    p = write_varint(p, value_bytes);
+    prev = 0;
+    for (int i = 0; i < dimensions; i++) {
+        p = write_varint(p, zigzag((int64_t)e->coordinates[i] - prev));
+        prev = e->coordinates[i];
+    }
+    if (value_bytes) {
+        memcpy(p, e->value, value_bytes);
+    }
+    halide_trace_buffer->release_packet((halide_trace_packet_t *)dst);
+}
+
+// State for writing traces as a timeline in the Chrome trace event
+// format, which can be loaded into chrome://tracing or Perfetto. We use
+// the JSON array format, in which the closing bracket is optional, so
+// the file is valid however the process exits.
+WEAK bool halide_trace_chrome = false;
+
+// Write a single event. Events with a non-negative id are async events,
+// which may begin and end on different threads. Others are duration or
+// instant events on the calling thread.
+WEAK void write_chrome_event(void *user_context, int fd, const char *name, const char *cat,
+                             char phase, int32_t id) {
+    // Escape the name for use as a JSON string. Func names won't need
+    // it, but trace tags might.
+    char escaped[256];
+    char *e = escaped;
+    for (const char *src = name; src && *src && e < escaped + sizeof(escaped) - 3; src++) {
+        if (*src == '"' || *src == '\\') {
+            *e++ = '\\';
+        }
+        *e++ = ((uint8_t)*src < 32) ? ' ' : *src;
+    }
+    *e = 0;
+
+    char buf[512];
+    Printer<StringStreamPrinter, sizeof(buf)> ss(user_context, buf);
+    uint64_t t = halide_current_time_ns(user_context);
+    ss << "{\"name\":\"" << escaped << "\",\"cat\":\"" << cat
+       << "\",\"ph\":\"";
+    char ph[2] = {phase, 0};
+    ss << ph << "\",";
+    if (id >= 0) {
+        ss << "\"id\":" << id << ",";
+    } else if (phase == 'i') {
+        // Instant events are scoped to their thread.
+        ss << "\"s\":\"t\",";
+    }
+    // Timestamps are in microseconds.
+    ss << "\"ts\":" << t / 1000 << ".";
+    uint64_t frac = t % 1000;
+    if (frac < 100) ss << "0";
+    if (frac < 10) ss << "0";
+    ss << frac << ",\"pid\":0,\"tid\":" << halide_current_thread_id() << "},\n";
+    ss.msan_annotate_is_initialized();
+
+    uint32_t size = (uint32_t)ss.size();
+    uint8_t *dst = (uint8_t *)halide_trace_buffer->acquire_packet(user_context, fd, size);
+    memcpy(dst, buf, size);
+    halide_trace_buffer->release_packet((halide_trace_packet_t *)dst);
+}
+
+// Turn a trace event into timeline events. Realizations, and the
+// production and consumption of each realization, become async events
+// keyed on the realization's id. Loads and stores are too fine-grained
+// to be useful on a timeline, and are dropped.
+WEAK void write_chrome_trace_event(void *user_context, int fd, int32_t id, const halide_trace_event_t *e) {
+    switch (e->event) {
+    case halide_trace_begin_pipeline:
+        write_chrome_event(user_context, fd, e->func, "pipeline", 'b', id);
+        break;
+    case halide_trace_end_pipeline:
+        write_chrome_event(user_context, fd, e->func, "pipeline", 'e', e->parent_id);
+        break;
+    case halide_trace_begin_realization:
+        write_chrome_event(user_context, fd, e->func, "realization", 'b', id);
+        break;
+    case halide_trace_end_realization:
+        write_chrome_event(user_context, fd, e->func, "realization", 'e', e->parent_id);
+        break;
+    case halide_trace_produce:
+        write_chrome_event(user_context, fd, e->func, "produce", 'b', e->parent_id);
+        break;
+    case halide_trace_consume:
+        write_chrome_event(user_context, fd, e->func, "produce", 'e', e->parent_id);
+        write_chrome_event(user_context, fd, e->func, "consume", 'b', e->parent_id);
+        break;
+    case halide_trace_end_consume:
+        write_chrome_event(user_context, fd, e->func, "consume", 'e', e->parent_id);
+        break;
+    case halide_trace_tag:
+        write_chrome_event(user_context, fd, e->trace_tag, "tag", 'i', -1);
+        break;
+    default:
+        break;
+    }
+}
+
+// Installed as halide_timeline_event_hook while writing a timeline.
+WEAK void chrome_timeline_event(void *user_context, const char *name, const char *cat, char phase) {
+    if (halide_trace_chrome && halide_trace_file > 0) {
+        write_chrome_event(user_context, halide_trace_file, name, cat, phase, -1);
+    }
+}
+
 }}}
 
 extern "C" {
@@ -162,7 +413,19 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
 
     // If we're dumping to a file, use a binary format
     int fd = halide_get_trace_file(user_context);
-    if (fd > 0) {
+    if (fd > 0 && halide_trace_chrome) {
+        write_chrome_trace_event(user_context, fd, my_id, e);
+
+        if (e->event == halide_trace_end_pipeline) {
+            halide_trace_buffer->flush(user_context, fd);
+        }
+    } else if (fd > 0 && halide_trace_compact) {
+        write_compact_event(user_context, fd, my_id, e);
+
+        if (e->event == halide_trace_end_pipeline) {
+            halide_trace_buffer->flush(user_context, fd);
+        }
+    } else if (fd > 0) {
         // Compute the total packet size
         uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
         uint32_t header_bytes = (uint32_t)sizeof(halide_trace_packet_t);
@@ -291,6 +554,9 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
                     }
                 } else if (e->type.code == 3) {
                     ss << ((void **)(e->value))[i];
+                } else if (e->type.code == 4) {
+                    halide_assert(user_context, print_bits == 16 && "Tracing a bad type");
+                    ss.write_bfloat16_from_bits(((uint16_t *)(e->value))[i]);
                 }
             }
             if (e->type.lanes > 1) {
@@ -320,6 +586,10 @@ namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK trace_fn halide_custom_trace = halide_default_trace;
 
+// -1 indicates uninitialized
+WEAK int halide_trace_sample_rate = -1;
+WEAK uint32_t halide_trace_sample_count = 0;
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -345,10 +615,22 @@ WEAK int halide_get_trace_file(void *user_context) {
             halide_assert(user_context, file && "Failed to open trace file\n");
             halide_set_trace_file(fileno(file));
             halide_trace_file_internally_opened = file;
+            const char *trace_format = getenv("HL_TRACE_FORMAT");
+            halide_trace_compact = trace_format && strcmp(trace_format, "compact") == 0;
             if (!halide_trace_buffer) {
                 halide_trace_buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
                 halide_trace_buffer->init();
             }
+            if (trace_format && strcmp(trace_format, "chrome") == 0) {
+                halide_start_clock(user_context);
+                uint8_t *dst = (uint8_t *)halide_trace_buffer->acquire_packet(user_context, halide_trace_file, 2);
+                dst[0] = '[';
+                dst[1] = '\n';
+                halide_trace_buffer->release_packet((halide_trace_packet_t *)dst);
+                __sync_synchronize();
+                halide_trace_chrome = true;
+                halide_timeline_event_hook = chrome_timeline_event;
+            }
         } else {
             halide_set_trace_file(0);
         }
@@ -356,19 +638,54 @@ WEAK int halide_get_trace_file(void *user_context) {
     return halide_trace_file;
 }
 
+WEAK void halide_set_trace_sample_rate(int n) {
+    halide_trace_sample_rate = n;
+}
+
 WEAK int32_t halide_trace(void *user_context, const halide_trace_event_t *e) {
+    if (e->event == halide_trace_load || e->event == halide_trace_store) {
+        int rate = halide_trace_sample_rate;
+        if (rate < 0) {
+            const char *rate_str = getenv("HL_TRACE_SAMPLE_RATE");
+            rate = rate_str ? atoi(rate_str) : 1;
+            halide_trace_sample_rate = rate;
+        }
+        if (rate > 1) {
+            // This counter is deliberately not atomic: contention on it
+            // would cost more than the occasional lost increment.
+            uint32_t count = halide_trace_sample_count++;
+            if (count % (uint32_t)rate) {
+                return 0;
+            }
+        }
+    }
     return (*halide_custom_trace)(user_context, e);
 }
 
 WEAK int halide_shutdown_trace() {
     if (halide_trace_file_internally_opened) {
+        if (halide_trace_buffer) {
+            halide_trace_buffer->flush(NULL, halide_trace_file);
+        }
+        halide_timeline_event_hook = NULL;
+        halide_trace_chrome = false;
         int ret = fclose(halide_trace_file_internally_opened);
         halide_trace_file = 0;
         halide_trace_file_initialized = false;
         halide_trace_file_internally_opened = NULL;
         if (halide_trace_buffer) {
             free(halide_trace_buffer);
+            halide_trace_buffer = NULL;
+        }
+        if (halide_trace_interned_strings) {
+            for (int i = 0; i < interned_strings_size; i++) {
+                free(halide_trace_interned_strings[i].str);
+            }
+            free(halide_trace_interned_strings);
+            halide_trace_interned_strings = NULL;
         }
+        halide_trace_next_string_id = 1;
+        halide_trace_compact_header_written = false;
         return ret;
     } else {
         return 0;
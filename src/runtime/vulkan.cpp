@@ -0,0 +1,2026 @@
+#include "HalideRuntimeVulkan.h"
+#include "scoped_spin_lock.h"
+#include "device_buffer_utils.h"
+#include "device_interface.h"
+#include "printer.h"
+
+#include "mini_vulkan.h"
+
+#define INLINE inline __attribute__((always_inline))
+
+namespace Halide { namespace Runtime { namespace Internal { namespace Vulkan {
+
+#define VK_FN(ret, fn, args) WEAK ret (VKAPI_CALL *fn) args;
+#include "vulkan_functions.h"
+#undef VK_FN
+
+// The default implementation of halide_vulkan_get_symbol attempts to load
+// the Vulkan loader shared library/DLL, and then get the symbol from it.
+WEAK void *lib_vulkan = NULL;
+
+extern "C" WEAK void *halide_vulkan_get_symbol(void *user_context, const char *name) {
+    // Only try to load the library if the library isn't already
+    // loaded, or we can't load the symbol from the process already.
+    void *symbol = halide_get_library_symbol(lib_vulkan, name);
+    if (symbol) {
+        return symbol;
+    }
+
+    const char *lib_names[] = {
+#ifdef WINDOWS
+        "vulkan-1.dll",
+#else
+        "libvulkan.so.1",
+        "libvulkan.so",
+#endif
+    };
+    for (size_t i = 0; i < sizeof(lib_names)/sizeof(lib_names[0]); i++) {
+        lib_vulkan = halide_load_library(lib_names[i]);
+        if (lib_vulkan) {
+            debug(user_context) << "    Loaded Vulkan loader library: " << lib_names[i] << "\n";
+            break;
+        }
+    }
+
+    return halide_get_library_symbol(lib_vulkan, name);
+}
+
+template <typename T>
+INLINE T get_vk_symbol(void *user_context, const char *name) {
+    T s = (T)halide_vulkan_get_symbol(user_context, name);
+    if (!s) {
+        error(user_context) << "Vulkan API not found: " << name << "\n";
+    }
+    return s;
+}
+
+// Load the Vulkan loader, and get the function pointers for the Vulkan
+// API from it. All of them are exported by the loader of any Vulkan 1.1
+// implementation, including Android's.
+WEAK int load_libvulkan(void *user_context) {
+    debug(user_context) << "    load_libvulkan (user_context: " << user_context << ")\n";
+    halide_assert(user_context, vkCreateInstance == NULL);
+
+    #define VK_FN(ret, fn, args)                                                \
+        fn = get_vk_symbol<ret (VKAPI_CALL *)args>(user_context, #fn);          \
+        if (!fn) {                                                              \
+            /* Try again on the next call. */                                   \
+            vkCreateInstance = NULL;                                            \
+            return halide_error_code_generic_error;                             \
+        }
+    #include "vulkan_functions.h"
+    #undef VK_FN
+    return 0;
+}
+
+extern WEAK halide_device_interface_t vulkan_device_interface;
+
+WEAK const char *get_vulkan_error_name(VkResult err);
+WEAK int create_vulkan_context(void *user_context);
+
+// The Vulkan context made by the default implementation of
+// halide_vulkan_acquire_context, and its lock.
+WEAK VkInstance instance = NULL;
+WEAK VkPhysicalDevice physical_device = NULL;
+WEAK VkDevice device = NULL;
+WEAK uint32_t queue_family_index = 0;
+WEAK uint32_t queue_count = 0;
+volatile int WEAK thread_lock = 0;
+
+// The most queues Halide submits to.
+const int max_queues = 8;
+// The queues the default context asks for, unless HL_VK_MAX_QUEUES
+// says otherwise.
+const int default_queues = 4;
+// The number of command buffers each queue can have in flight.
+const int ring_size = 4;
+// While the GPU is busy, up to this many commands are recorded into a
+// command buffer before it is submitted.
+const int max_batched_commands = 32;
+// The number of descriptor sets cached per kernel.
+const int descriptor_cache_size = 16;
+// The size of the push constant block every implementation supports.
+const int max_push_constant_bytes = 128;
+
+}}}} // namespace Halide::Runtime::Internal::Vulkan
+
+using namespace Halide::Runtime::Internal::Vulkan;
+
+extern "C" {
+
+// The default implementation of halide_vulkan_acquire_context uses the
+// global handles above, and serializes access with a spin lock.
+// Overriding implementations of acquire/release must implement the
+// following behavior:
+// - halide_vulkan_acquire_context should always store a valid context
+//   in its output arguments, or return an error code.
+// - A call to halide_vulkan_acquire_context is followed by a matching call to
+//   halide_vulkan_release_context. halide_vulkan_acquire_context should block while a
+//   previous call (if any) has not yet been released via halide_vulkan_release_context.
+WEAK int halide_vulkan_acquire_context(void *user_context,
+                                       halide_vulkan_instance **instance_ret,
+                                       halide_vulkan_physical_device **physical_device_ret,
+                                       halide_vulkan_device **device_ret,
+                                       uint32_t *queue_family_index_ret,
+                                       uint32_t *queue_count_ret,
+                                       bool create = true) {
+    halide_assert(user_context, instance_ret != NULL);
+    halide_assert(user_context, physical_device_ret != NULL);
+    halide_assert(user_context, device_ret != NULL);
+    halide_assert(user_context, queue_family_index_ret != NULL);
+    halide_assert(user_context, queue_count_ret != NULL);
+
+    while (__sync_lock_test_and_set(&thread_lock, 1)) { }
+
+    // If the context has not been initialized, initialize it now.
+    if (!device && create) {
+        int error = create_vulkan_context(user_context);
+        if (error != 0) {
+            __sync_lock_release(&thread_lock);
+            return error;
+        }
+    }
+
+    *instance_ret = (halide_vulkan_instance *)instance;
+    *physical_device_ret = (halide_vulkan_physical_device *)physical_device;
+    *device_ret = (halide_vulkan_device *)device;
+    *queue_family_index_ret = queue_family_index;
+    *queue_count_ret = queue_count;
+    return 0;
+}
+
+WEAK int halide_vulkan_release_context(void *user_context) {
+    __sync_lock_release(&thread_lock);
+    return 0;
+}
+
+WEAK int halide_vulkan_get_queue_index(void *user_context) {
+    // Fibonacci hashing spreads user_contexts that are nearby in memory
+    // (e.g. on the stacks of different threads) over the queues.
+    uint64_t h = (uint64_t)(uintptr_t)user_context * 11400714819323198485ULL;
+    return (int)(h >> 40);
+}
+
+} // extern "C"
+
+namespace Halide { namespace Runtime { namespace Internal { namespace Vulkan {
+
+// Each queue records commands into a ring of command buffers. A
+// command buffer is submitted once it holds max_batched_commands
+// commands, when the GPU would otherwise be idle, or when the host
+// needs the results. Every batch has a serial number, so that work can
+// wait for a particular batch to complete.
+struct queue_state {
+    VkQueue queue;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffers[ring_size];
+    VkFence fences[ring_size];
+    // The serial number of the batch in each slot, or 0 if it is free.
+    uint64_t serials[ring_size];
+    // The serial number of the next batch. Batches are numbered from 1.
+    uint64_t next_serial;
+    // Every batch up to this one has completed.
+    uint64_t completed_serial;
+    // The slot being recorded into, or -1.
+    int recording;
+    int recorded_commands;
+};
+
+// What Halide keeps for the device of the context.
+struct device_state {
+    VkDevice device;
+    VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    uint32_t queue_count;
+    queue_state queues[max_queues];
+    VkPipelineCache pipeline_cache;
+    bool pipeline_cache_dirty;
+};
+WEAK device_state *dev_state = NULL;
+
+// A VkBuffer and the memory bound to it. Crops of a buffer share its
+// allocation.
+struct vk_allocation {
+    VkBuffer buffer;
+    // VK_NULL_HANDLE for buffers wrapped with halide_vulkan_wrap_vk_buffer.
+    VkDeviceMemory memory;
+    // The host address of the memory, or NULL if the host can't map it.
+    uint8_t *mapped;
+    uint64_t size;
+    // Unique for the life of the process, so that descriptor sets can
+    // be cached on it.
+    uint64_t id;
+    int refcount;
+    // The last batch of commands that used the allocation.
+    int last_queue;
+    uint64_t last_serial;
+};
+WEAK uint64_t next_allocation_id = 1;
+
+// The device field of a halide_buffer_t. The offset of a crop is passed
+// to kernels in their push constants, so crops don't need descriptors
+// with aligned offsets.
+struct device_handle {
+    // Important: order these to avoid any padding between fields;
+    // some Win32 compiler optimizer configurations can inconsistently
+    // insert padding otherwise.
+    uint64_t offset;
+    vk_allocation *alloc;
+};
+
+struct descriptor_cache_entry {
+    VkDescriptorSet set;
+    // The ids of the allocations bound, or all zero if unused.
+    uint64_t *allocation_ids;
+    uint64_t last_used;
+    // The last batch of commands that used the set. A descriptor set
+    // can't be updated while a pending command buffer uses it.
+    int queue;
+    uint64_t serial;
+};
+
+// The pipeline for a kernel, which is created the first time the
+// kernel runs, and its descriptor sets. Rebinding the buffers of a
+// descriptor set for every dispatch is a significant part of the cost
+// of a launch on mobile drivers, so each kernel keeps the sets for the
+// most recently used combinations of buffers.
+struct kernel_state {
+    char *name;
+    int num_buffers;
+    uint32_t push_constant_size;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+    VkDescriptorPool descriptor_pool;
+    descriptor_cache_entry descriptor_cache[descriptor_cache_size];
+    uint64_t tick;
+    kernel_state *next;
+};
+
+// Structure to hold the state of a module attached to the context.
+// Also used as a linked-list to keep track of all the different
+// modules that are attached to a context in order to release them all
+// when then context is released.
+struct module_state {
+    VkShaderModule shader;
+    kernel_state *kernels;
+    module_state *next;
+};
+WEAK module_state *state_list = NULL;
+
+WEAK int init_device_state(void *user_context, VkPhysicalDevice phys, VkDevice dev,
+                           uint32_t family, uint32_t count);
+
+// Helper object to acquire and release the Vulkan context.
+class VkContext {
+    void *user_context;
+    bool acquired;
+
+public:
+    VkDevice device;
+    device_state *state;
+    int error;
+
+    // Constructor sets 'error' if any occurs.
+    INLINE VkContext(void *user_context) : user_context(user_context),
+                                           acquired(false),
+                                           device(NULL),
+                                           state(NULL),
+                                           error(0) {
+        if (vkCreateInstance == NULL) {
+            error = load_libvulkan(user_context);
+            if (error != 0) {
+                return;
+            }
+        }
+
+#ifdef DEBUG_RUNTIME
+        halide_start_clock(user_context);
+#endif
+
+        halide_vulkan_instance *inst;
+        halide_vulkan_physical_device *phys;
+        halide_vulkan_device *dev;
+        uint32_t family, count;
+        error = halide_vulkan_acquire_context(user_context, &inst, &phys, &dev, &family, &count, true);
+        if (error != 0) {
+            return;
+        }
+        acquired = true;
+        device = (VkDevice)dev;
+        halide_assert(user_context, device != NULL && count > 0);
+
+        if (dev_state == NULL) {
+            error = init_device_state(user_context, (VkPhysicalDevice)phys, device, family, count);
+        } else if (dev_state->device != device) {
+            Halide::Runtime::Internal::error(user_context) << "Vulkan: the context changed to a different device; "
+                                << "call halide_device_release first.\n";
+            error = halide_error_code_generic_error;
+        }
+        state = dev_state;
+    }
+
+    INLINE ~VkContext() {
+        if (acquired) {
+            halide_vulkan_release_context(user_context);
+        }
+    }
+
+    INLINE int queue_index() const {
+        return (int)((unsigned)halide_vulkan_get_queue_index(user_context) % state->queue_count);
+    }
+};
+
+// Returns the index of a memory type allowed by type_bits that has the
+// required properties, preferring ones that also have the preferred
+// properties, or -1.
+WEAK int find_memory_type(const device_state *ds, uint32_t type_bits,
+                          VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) {
+    for (int pass = 0; pass < 2; pass++) {
+        VkMemoryPropertyFlags wanted = required | (pass == 0 ? preferred : 0);
+        for (uint32_t i = 0; i < ds->memory_properties.memoryTypeCount; i++) {
+            if ((type_bits & (1u << i)) &&
+                (ds->memory_properties.memoryTypes[i].propertyFlags & wanted) == wanted) {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+// Returns the file the pipeline cache is kept in, or false if
+// HL_VK_PIPELINE_CACHE_DIR is not set.
+WEAK bool pipeline_cache_path(const device_state *ds, char *path, size_t size) {
+    const char *dir = getenv("HL_VK_PIPELINE_CACHE_DIR");
+    if (!dir || !dir[0]) {
+        return false;
+    }
+    // The driver rejects cache data from another device or driver
+    // version; keying the file on them keeps the caches of different
+    // devices from overwriting each other. FNV-1a.
+    uint32_t ids[] = { ds->properties.vendorID, ds->properties.deviceID, ds->properties.driverVersion };
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(ids); i++) {
+        h = (h ^ ((const uint8_t *)ids)[i]) * 1099511628211ULL;
+    }
+    for (int i = 0; i < VK_UUID_SIZE; i++) {
+        h = (h ^ ds->properties.pipelineCacheUUID[i]) * 1099511628211ULL;
+    }
+    char *dst = path, *end = path + size - 1;
+    dst = halide_string_to_string(dst, end, dir);
+    dst = halide_string_to_string(dst, end, "/halide_vulkan_");
+    dst = halide_uint64_to_string(dst, end, h, 1);
+    dst = halide_string_to_string(dst, end, ".bin");
+    return dst < end;
+}
+
+// Creates the pipeline cache, from the data saved by an earlier run if
+// there is any.
+WEAK VkResult create_pipeline_cache(void *user_context, device_state *ds) {
+    char path[1024];
+    void *data = NULL;
+    long size = 0;
+    if (pipeline_cache_path(ds, path, sizeof(path))) {
+        void *f = fopen(path, "rb");
+        if (f) {
+            // 2 is SEEK_END and 0 is SEEK_SET everywhere we run.
+            size = (fseek(f, 0, 2) == 0) ? ftell(f) : -1;
+            if (size > 0 && fseek(f, 0, 0) == 0) {
+                data = malloc(size);
+                if (data && fread(data, 1, size, f) != (size_t)size) {
+                    free(data);
+                    data = NULL;
+                }
+            }
+            fclose(f);
+            debug(user_context) << "    loading pipeline cache " << path << ": " << (data ? "hit" : "miss") << "\n";
+        }
+    }
+    VkPipelineCacheCreateInfo info = {
+        VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, NULL, 0,
+        data ? (size_t)size : 0, data
+    };
+    VkResult result = vkCreatePipelineCache(ds->device, &info, NULL, &ds->pipeline_cache);
+    if (result != VK_SUCCESS && data) {
+        // Stale or corrupt data. Start over.
+        info.initialDataSize = 0;
+        info.pInitialData = NULL;
+        result = vkCreatePipelineCache(ds->device, &info, NULL, &ds->pipeline_cache);
+    }
+    free(data);
+    ds->pipeline_cache_dirty = false;
+    return result;
+}
+
+WEAK void save_pipeline_cache(void *user_context, device_state *ds) {
+    // Failing to write the cache is not an error.
+    char path[1024];
+    if (!ds->pipeline_cache_dirty || !pipeline_cache_path(ds, path, sizeof(path))) {
+        return;
+    }
+    size_t size = 0;
+    if (vkGetPipelineCacheData(ds->device, ds->pipeline_cache, &size, NULL) != VK_SUCCESS || size == 0) {
+        return;
+    }
+    void *data = malloc(size);
+    if (!data) {
+        return;
+    }
+    if (vkGetPipelineCacheData(ds->device, ds->pipeline_cache, &size, data) == VK_SUCCESS) {
+        void *f = fopen(path, "wb");
+        if (f) {
+            bool ok = fwrite(data, 1, size, f) == size;
+            fclose(f);
+            if (!ok) {
+                remove(path);
+            }
+            debug(user_context) << "    wrote pipeline cache " << path << "\n";
+        }
+    }
+    free(data);
+    ds->pipeline_cache_dirty = false;
+}
+
+// Frees everything in a device_state. The device must be idle.
+WEAK void destroy_device_state(void *user_context, device_state *ds) {
+    for (uint32_t i = 0; i < ds->queue_count; i++) {
+        queue_state *q = &ds->queues[i];
+        for (int j = 0; j < ring_size; j++) {
+            if (q->fences[j]) {
+                vkDestroyFence(ds->device, q->fences[j], NULL);
+            }
+        }
+        if (q->command_pool) {
+            // This frees the command buffers too.
+            vkDestroyCommandPool(ds->device, q->command_pool, NULL);
+        }
+    }
+    if (ds->pipeline_cache) {
+        save_pipeline_cache(user_context, ds);
+        vkDestroyPipelineCache(ds->device, ds->pipeline_cache, NULL);
+    }
+    free(ds);
+}
+
+WEAK int init_device_state(void *user_context, VkPhysicalDevice phys, VkDevice dev,
+                           uint32_t family, uint32_t count) {
+    device_state *ds = (device_state *)malloc(sizeof(device_state));
+    if (ds == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    memset(ds, 0, sizeof(device_state));
+    ds->device = dev;
+    vkGetPhysicalDeviceProperties(phys, &ds->properties);
+    vkGetPhysicalDeviceMemoryProperties(phys, &ds->memory_properties);
+    ds->queue_count = count < (uint32_t)max_queues ? count : (uint32_t)max_queues;
+
+    debug(user_context) << "    Vulkan device: " << ds->properties.deviceName
+                        << ", using " << ds->queue_count << " queues\n";
+
+    // Kernels are SPIR-V 1.3, which needs Vulkan 1.1.
+    if (ds->properties.apiVersion < VK_API_VERSION_1_1) {
+        error(user_context) << "Vulkan: device " << ds->properties.deviceName
+                            << " does not support Vulkan 1.1\n";
+        free(ds);
+        return halide_error_code_generic_error;
+    }
+
+    VkResult result = VK_SUCCESS;
+    for (uint32_t i = 0; i < ds->queue_count && result == VK_SUCCESS; i++) {
+        queue_state *q = &ds->queues[i];
+        q->next_serial = 1;
+        q->recording = -1;
+        vkGetDeviceQueue(dev, family, i, &q->queue);
+
+        VkCommandPoolCreateInfo pool_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, NULL,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, family
+        };
+        result = vkCreateCommandPool(dev, &pool_info, NULL, &q->command_pool);
+        if (result != VK_SUCCESS) {
+            break;
+        }
+        VkCommandBufferAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, NULL,
+            q->command_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, ring_size
+        };
+        result = vkAllocateCommandBuffers(dev, &alloc_info, q->command_buffers);
+        for (int j = 0; j < ring_size && result == VK_SUCCESS; j++) {
+            VkFenceCreateInfo fence_info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, NULL, 0 };
+            result = vkCreateFence(dev, &fence_info, NULL, &q->fences[j]);
+        }
+    }
+    if (result == VK_SUCCESS) {
+        result = create_pipeline_cache(user_context, ds);
+    }
+    if (result != VK_SUCCESS) {
+        error(user_context) << "Vulkan: initializing the device failed: "
+                            << get_vulkan_error_name(result) << "\n";
+        destroy_device_state(user_context, ds);
+        return result;
+    }
+    dev_state = ds;
+    return 0;
+}
+
+// Makes everything written before a point in a command buffer visible
+// to the given stages after it.
+WEAK void memory_barrier(VkCommandBuffer cb, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access) {
+    VkMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_MEMORY_WRITE_BIT, dst_access
+    };
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dst_stages, 0,
+                         1, &barrier, 0, NULL, 0, NULL);
+}
+
+// Waits for the batch in a slot to complete, and frees the slot.
+WEAK int wait_for_slot(void *user_context, VkDevice dev, queue_state *q, int slot) {
+    if (q->serials[slot] == 0) {
+        return 0;
+    }
+    VkResult result = vkWaitForFences(dev, 1, &q->fences[slot], VK_TRUE, ~0ULL);
+    if (result != VK_SUCCESS) {
+        error(user_context) << "Vulkan: vkWaitForFences failed: " << get_vulkan_error_name(result) << "\n";
+        return result;
+    }
+    vkResetFences(dev, 1, &q->fences[slot]);
+    if (q->serials[slot] > q->completed_serial) {
+        q->completed_serial = q->serials[slot];
+    }
+    q->serials[slot] = 0;
+    return 0;
+}
+
+WEAK int submit_commands(void *user_context, queue_state *q) {
+    if (q->recording < 0) {
+        return 0;
+    }
+    int slot = q->recording;
+    q->recording = -1;
+    VkCommandBuffer cb = q->command_buffers[slot];
+    // Make the results visible to the host once the fence signals.
+    memory_barrier(cb, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    VkResult result = vkEndCommandBuffer(cb);
+    if (result == VK_SUCCESS) {
+        VkSubmitInfo submit = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO, NULL, 0, NULL, NULL, 1, &cb, 0, NULL
+        };
+        result = vkQueueSubmit(q->queue, 1, &submit, q->fences[slot]);
+    }
+    if (result != VK_SUCCESS) {
+        // The fence will never signal.
+        q->serials[slot] = 0;
+        error(user_context) << "Vulkan: submitting commands failed: " << get_vulkan_error_name(result) << "\n";
+        return result;
+    }
+    return 0;
+}
+
+// Waits for every batch on a queue up to and including serial.
+WEAK int wait_for_serial(void *user_context, VkDevice dev, queue_state *q, uint64_t serial) {
+    if (serial <= q->completed_serial) {
+        return 0;
+    }
+    if (q->recording >= 0 && q->serials[q->recording] <= serial) {
+        int err = submit_commands(user_context, q);
+        if (err != 0) {
+            return err;
+        }
+    }
+    for (int i = 0; i < ring_size; i++) {
+        if (q->serials[i] != 0 && q->serials[i] <= serial) {
+            int err = wait_for_slot(user_context, dev, q, i);
+            if (err != 0) {
+                return err;
+            }
+        }
+    }
+    // Every batch begins with a barrier on all earlier commands, so the
+    // batches complete in order.
+    if (serial > q->completed_serial) {
+        q->completed_serial = serial;
+    }
+    return 0;
+}
+
+WEAK int wait_for_queue(void *user_context, VkDevice dev, queue_state *q) {
+    return wait_for_serial(user_context, dev, q, q->next_serial - 1);
+}
+
+WEAK bool queue_busy(VkDevice dev, queue_state *q) {
+    for (int i = 0; i < ring_size; i++) {
+        if (i != q->recording && q->serials[i] > q->completed_serial &&
+            vkWaitForFences(dev, 1, &q->fences[i], VK_TRUE, 0) == VK_TIMEOUT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the command buffer to record a command into, ordered after
+// everything before it on the queue.
+WEAK int begin_command(void *user_context, VkDevice dev, queue_state *q, VkCommandBuffer *cb) {
+    if (q->recording < 0) {
+        int slot = (int)(q->next_serial % ring_size);
+        int err = wait_for_slot(user_context, dev, q, slot);
+        if (err != 0) {
+            return err;
+        }
+        VkCommandBufferBeginInfo begin = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, NULL
+        };
+        VkResult result = vkBeginCommandBuffer(q->command_buffers[slot], &begin);
+        if (result != VK_SUCCESS) {
+            error(user_context) << "Vulkan: vkBeginCommandBuffer failed: " << get_vulkan_error_name(result) << "\n";
+            return result;
+        }
+        q->recording = slot;
+        q->serials[slot] = q->next_serial++;
+        q->recorded_commands = 0;
+    }
+    *cb = q->command_buffers[q->recording];
+    memory_barrier(*cb, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                   VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+    q->recorded_commands++;
+    return 0;
+}
+
+WEAK int end_command(void *user_context, VkDevice dev, queue_state *q) {
+    // Batching amortizes the cost of a submission, but only pays off
+    // while the GPU has other work to do.
+    if (q->recorded_commands >= max_batched_commands || !queue_busy(dev, q)) {
+        return submit_commands(user_context, q);
+    }
+    return 0;
+}
+
+// Records that the command being recorded on a queue uses an
+// allocation. Work on different queues is unordered, so the host waits
+// for an earlier use on another queue to complete first.
+WEAK int use_allocation(void *user_context, VkContext &ctx, vk_allocation *alloc, int queue) {
+    if (alloc->last_serial != 0 && alloc->last_queue != queue) {
+        int err = wait_for_serial(user_context, ctx.device, &ctx.state->queues[alloc->last_queue], alloc->last_serial);
+        if (err != 0) {
+            return err;
+        }
+    }
+    queue_state *q = &ctx.state->queues[queue];
+    halide_assert(user_context, q->recording >= 0);
+    alloc->last_queue = queue;
+    alloc->last_serial = q->serials[q->recording];
+    return 0;
+}
+
+// Waits until the GPU is done with an allocation, so that the host can
+// access it.
+WEAK int wait_for_allocation(void *user_context, VkDevice dev, vk_allocation *alloc) {
+    if (alloc->last_serial == 0) {
+        return 0;
+    }
+    int err = wait_for_serial(user_context, dev, &dev_state->queues[alloc->last_queue], alloc->last_serial);
+    if (err == 0) {
+        alloc->last_serial = 0;
+    }
+    return err;
+}
+
+WEAK int create_allocation(void *user_context, VkContext &ctx, uint64_t size, bool staging, vk_allocation **result) {
+    VkBufferCreateInfo buffer_info = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, NULL, 0, size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE, 0, NULL
+    };
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkResult err = vkCreateBuffer(ctx.device, &buffer_info, NULL, &buffer);
+    if (err != VK_SUCCESS) {
+        error(user_context) << "Vulkan: vkCreateBuffer failed: " << get_vulkan_error_name(err) << "\n";
+        return err;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(ctx.device, buffer, &requirements);
+    const uint32_t host_coherent = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    int type;
+    if (staging) {
+        type = find_memory_type(ctx.state, requirements.memoryTypeBits, host_coherent, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    } else {
+        // Prefer device memory that the host can map too, which is all
+        // memory on most mobile GPUs. Copies to and from it are then
+        // plain memcpys, with no staging buffers or transfer commands.
+        type = find_memory_type(ctx.state, requirements.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | host_coherent,
+                                VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        if (type < 0) {
+            type = find_memory_type(ctx.state, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+        }
+        if (type < 0) {
+            type = find_memory_type(ctx.state, requirements.memoryTypeBits, 0, 0);
+        }
+    }
+    if (type < 0) {
+        error(user_context) << "Vulkan: no suitable memory type for a buffer\n";
+        vkDestroyBuffer(ctx.device, buffer, NULL);
+        return halide_error_code_device_malloc_failed;
+    }
+
+    VkMemoryAllocateInfo alloc_info = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, requirements.size, (uint32_t)type
+    };
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    err = vkAllocateMemory(ctx.device, &alloc_info, NULL, &memory);
+    if (err == VK_SUCCESS) {
+        err = vkBindBufferMemory(ctx.device, buffer, memory, 0);
+    }
+    void *mapped = NULL;
+    if (err == VK_SUCCESS &&
+        (ctx.state->memory_properties.memoryTypes[type].propertyFlags & host_coherent) == host_coherent) {
+        // Keep the memory mapped for the life of the allocation.
+        err = vkMapMemory(ctx.device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+    }
+    vk_allocation *alloc = NULL;
+    if (err == VK_SUCCESS) {
+        alloc = (vk_allocation *)malloc(sizeof(vk_allocation));
+        if (alloc == NULL) {
+            err = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+    if (err != VK_SUCCESS) {
+        error(user_context) << "Vulkan: allocating " << size << " bytes of memory failed: "
+                            << get_vulkan_error_name(err) << "\n";
+        vkDestroyBuffer(ctx.device, buffer, NULL);
+        if (memory) {
+            vkFreeMemory(ctx.device, memory, NULL);
+        }
+        return err;
+    }
+
+    alloc->buffer = buffer;
+    alloc->memory = memory;
+    alloc->mapped = (uint8_t *)mapped;
+    alloc->size = size;
+    alloc->id = next_allocation_id++;
+    alloc->refcount = 1;
+    alloc->last_queue = 0;
+    alloc->last_serial = 0;
+    debug(user_context) << "    allocated VkBuffer " << (void *)alloc->buffer << " of " << size
+                        << " bytes in memory type " << type << (mapped ? " (host visible)" : "") << "\n";
+    *result = alloc;
+    return 0;
+}
+
+WEAK void destroy_allocation(void *user_context, VkDevice dev, vk_allocation *alloc) {
+    // The GPU may still be using the buffer.
+    wait_for_allocation(user_context, dev, alloc);
+    if (alloc->memory) {
+        debug(user_context) << "    vkDestroyBuffer " << (void *)alloc->buffer << "\n";
+        if (alloc->mapped) {
+            vkUnmapMemory(dev, alloc->memory);
+        }
+        vkDestroyBuffer(dev, alloc->buffer, NULL);
+        vkFreeMemory(dev, alloc->memory, NULL);
+    }
+    free(alloc);
+}
+
+// Drops a device_handle's reference to its allocation.
+WEAK void release_handle(void *user_context, VkDevice dev, device_handle *handle) {
+    if (--handle->alloc->refcount == 0) {
+        destroy_allocation(user_context, dev, handle->alloc);
+    }
+    free(handle);
+}
+
+// Frees a device allocation that was held in the device allocation
+// cache. This may be called with the context already held, so don't
+// acquire it here.
+WEAK int free_cached_allocation(void *user_context, void *context, uint64_t device) {
+    halide_assert(user_context, dev_state != NULL);
+    release_handle(user_context, dev_state->device, (device_handle *)device);
+    return 0;
+}
+
+WEAK void release_kernels(void *user_context, VkDevice dev, module_state *mod) {
+    kernel_state *k = mod->kernels;
+    while (k) {
+        kernel_state *next = k->next;
+        if (k->pipeline) {
+            vkDestroyPipeline(dev, k->pipeline, NULL);
+        }
+        if (k->pipeline_layout) {
+            vkDestroyPipelineLayout(dev, k->pipeline_layout, NULL);
+        }
+        if (k->set_layout) {
+            vkDestroyDescriptorSetLayout(dev, k->set_layout, NULL);
+        }
+        if (k->descriptor_pool) {
+            // This frees the descriptor sets too.
+            vkDestroyDescriptorPool(dev, k->descriptor_pool, NULL);
+        }
+        for (int i = 0; i < descriptor_cache_size; i++) {
+            free(k->descriptor_cache[i].allocation_ids);
+        }
+        free(k->name);
+        free(k);
+        k = next;
+    }
+    mod->kernels = NULL;
+}
+
+// The size of the push constants of a kernel, laid out as
+// CodeGen_Vulkan_Dev does.
+WEAK uint32_t push_constant_size(halide_type_t arg_types[], int8_t arg_is_buffer[]) {
+    uint32_t size = 0;
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (arg_is_buffer[i]) {
+            size += 4;
+        }
+    }
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (!arg_is_buffer[i]) {
+            uint32_t bytes = arg_types[i].bits > 32 ? 8 : 4;
+            size = (size + bytes - 1) / bytes * bytes + bytes;
+        }
+    }
+    return size;
+}
+
+// Finds the kernel of a module with the given name, creating its
+// pipeline if this is its first run.
+WEAK int get_kernel(void *user_context, VkContext &ctx, module_state *mod, const char *entry_name,
+                    halide_type_t arg_types[], int8_t arg_is_buffer[], kernel_state **result) {
+    for (kernel_state *k = mod->kernels; k; k = k->next) {
+        if (strcmp(k->name, entry_name) == 0) {
+            *result = k;
+            return 0;
+        }
+    }
+
+    kernel_state *k = (kernel_state *)malloc(sizeof(kernel_state));
+    if (k == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    memset(k, 0, sizeof(kernel_state));
+    size_t name_size = strlen(entry_name) + 1;
+    k->name = (char *)malloc(name_size);
+    if (k->name == NULL) {
+        free(k);
+        return halide_error_code_out_of_memory;
+    }
+    memcpy(k->name, entry_name, name_size);
+    // Link the kernel in now, so that device_release frees it even if
+    // creating its pipeline fails below.
+    k->next = mod->kernels;
+    mod->kernels = k;
+
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (arg_is_buffer[i]) {
+            k->num_buffers++;
+        }
+    }
+    k->push_constant_size = push_constant_size(arg_types, arg_is_buffer);
+    halide_assert(user_context, k->push_constant_size <= (uint32_t)max_push_constant_bytes);
+
+#ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+#endif
+
+    VkResult err = VK_SUCCESS;
+    if (k->num_buffers > 0) {
+        VkDescriptorSetLayoutBinding *bindings =
+            (VkDescriptorSetLayoutBinding *)malloc(k->num_buffers * sizeof(VkDescriptorSetLayoutBinding));
+        if (bindings == NULL) {
+            return halide_error_code_out_of_memory;
+        }
+        for (int i = 0; i < k->num_buffers; i++) {
+            VkDescriptorSetLayoutBinding b = {
+                (uint32_t)i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, NULL
+            };
+            bindings[i] = b;
+        }
+        VkDescriptorSetLayoutCreateInfo layout_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, NULL, 0, (uint32_t)k->num_buffers, bindings
+        };
+        err = vkCreateDescriptorSetLayout(ctx.device, &layout_info, NULL, &k->set_layout);
+        free(bindings);
+    }
+
+    if (err == VK_SUCCESS) {
+        VkPushConstantRange range = { VK_SHADER_STAGE_COMPUTE_BIT, 0, k->push_constant_size };
+        VkPipelineLayoutCreateInfo layout_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, NULL, 0,
+            k->num_buffers > 0 ? 1u : 0u, &k->set_layout,
+            k->push_constant_size > 0 ? 1u : 0u, &range
+        };
+        err = vkCreatePipelineLayout(ctx.device, &layout_info, NULL, &k->pipeline_layout);
+    }
+
+    if (err == VK_SUCCESS) {
+        VkComputePipelineCreateInfo pipeline_info = {
+            VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO, NULL, 0,
+            {
+                VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, NULL, 0,
+                VK_SHADER_STAGE_COMPUTE_BIT, mod->shader, entry_name, NULL
+            },
+            k->pipeline_layout, VK_NULL_HANDLE, -1
+        };
+        debug(user_context) << "    vkCreateComputePipelines " << entry_name << "\n";
+        err = vkCreateComputePipelines(ctx.device, ctx.state->pipeline_cache, 1, &pipeline_info, NULL, &k->pipeline);
+        ctx.state->pipeline_cache_dirty = true;
+    }
+
+    if (err == VK_SUCCESS && k->num_buffers > 0) {
+        VkDescriptorPoolSize pool_size = {
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t)(k->num_buffers * descriptor_cache_size)
+        };
+        VkDescriptorPoolCreateInfo pool_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, NULL, 0, descriptor_cache_size, 1, &pool_size
+        };
+        err = vkCreateDescriptorPool(ctx.device, &pool_info, NULL, &k->descriptor_pool);
+        VkDescriptorSetLayout layouts[descriptor_cache_size];
+        VkDescriptorSet sets[descriptor_cache_size];
+        for (int i = 0; i < descriptor_cache_size; i++) {
+            layouts[i] = k->set_layout;
+        }
+        if (err == VK_SUCCESS) {
+            VkDescriptorSetAllocateInfo alloc_info = {
+                VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, NULL,
+                k->descriptor_pool, descriptor_cache_size, layouts
+            };
+            err = vkAllocateDescriptorSets(ctx.device, &alloc_info, sets);
+        }
+        for (int i = 0; i < descriptor_cache_size && err == VK_SUCCESS; i++) {
+            descriptor_cache_entry *e = &k->descriptor_cache[i];
+            e->set = sets[i];
+            e->allocation_ids = (uint64_t *)malloc(k->num_buffers * sizeof(uint64_t));
+            if (e->allocation_ids == NULL) {
+                return halide_error_code_out_of_memory;
+            }
+            memset(e->allocation_ids, 0, k->num_buffers * sizeof(uint64_t));
+        }
+    }
+
+    if (err != VK_SUCCESS) {
+        error(user_context) << "Vulkan: creating the pipeline for " << entry_name << " failed: "
+                            << get_vulkan_error_name(err) << "\n";
+        // Leave the kernel without a pipeline, so that the next run
+        // tries again.
+        if (k->pipeline) {
+            vkDestroyPipeline(ctx.device, k->pipeline, NULL);
+        }
+        k->pipeline = VK_NULL_HANDLE;
+        mod->kernels = k->next;
+        k->next = NULL;
+        module_state tmp = { VK_NULL_HANDLE, k, NULL };
+        release_kernels(user_context, ctx.device, &tmp);
+        return err;
+    }
+
+#ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time to create pipeline: " << (t_after - t_before) / 1.0e6 << " ms\n";
+#endif
+
+    *result = k;
+    return 0;
+}
+
+// Returns a descriptor set binding the buffer arguments of a kernel.
+WEAK int get_descriptor_set(void *user_context, VkContext &ctx, kernel_state *k,
+                            void *args[], int8_t arg_is_buffer[], descriptor_cache_entry **result) {
+    k->tick++;
+    descriptor_cache_entry *lru = &k->descriptor_cache[0];
+    for (int i = 0; i < descriptor_cache_size; i++) {
+        descriptor_cache_entry *e = &k->descriptor_cache[i];
+        bool match = true;
+        for (int a = 0, b = 0; match && args[a] != NULL; a++) {
+            if (arg_is_buffer[a]) {
+                const device_handle *h = (const device_handle *)((halide_buffer_t *)args[a])->device;
+                match = (e->allocation_ids[b++] == h->alloc->id);
+            }
+        }
+        if (match) {
+            e->last_used = k->tick;
+            *result = e;
+            return 0;
+        }
+        if (e->last_used < lru->last_used) {
+            lru = e;
+        }
+    }
+
+    // Rebind the least recently used set.
+    if (lru->serial != 0) {
+        int err = wait_for_serial(user_context, ctx.device, &ctx.state->queues[lru->queue], lru->serial);
+        if (err != 0) {
+            return err;
+        }
+    }
+    VkDescriptorBufferInfo *infos =
+        (VkDescriptorBufferInfo *)malloc(k->num_buffers * sizeof(VkDescriptorBufferInfo));
+    VkWriteDescriptorSet *writes =
+        (VkWriteDescriptorSet *)malloc(k->num_buffers * sizeof(VkWriteDescriptorSet));
+    if (infos == NULL || writes == NULL) {
+        free(infos);
+        free(writes);
+        return halide_error_code_out_of_memory;
+    }
+    for (int a = 0, b = 0; args[a] != NULL; a++) {
+        if (!arg_is_buffer[a]) {
+            continue;
+        }
+        const device_handle *h = (const device_handle *)((halide_buffer_t *)args[a])->device;
+        VkDescriptorBufferInfo info = { h->alloc->buffer, 0, VK_WHOLE_SIZE };
+        infos[b] = info;
+        VkWriteDescriptorSet write = {
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, lru->set, (uint32_t)b, 0, 1,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &infos[b], NULL
+        };
+        writes[b] = write;
+        lru->allocation_ids[b] = h->alloc->id;
+        b++;
+    }
+    vkUpdateDescriptorSets(ctx.device, k->num_buffers, writes, 0, NULL);
+    free(infos);
+    free(writes);
+    lru->last_used = k->tick;
+    lru->serial = 0;
+    *result = lru;
+    return 0;
+}
+
+}}}} // namespace Halide::Runtime::Internal::Vulkan
+
+extern "C" {
+
+WEAK int halide_vulkan_device_free(void *user_context, halide_buffer_t *buf) {
+    // halide_vulkan_device_free, at present, can be exposed to clients and they
+    // should be allowed to call halide_vulkan_device_free on any halide_buffer_t
+    // including ones that have never been used with a GPU.
+    if (buf->device == 0) {
+        return 0;
+    }
+
+    device_handle *handle = (device_handle *)buf->device;
+    halide_assert(user_context, handle->offset == 0 && "halide_vulkan_device_free on buffer obtained from halide_device_crop");
+
+    debug(user_context)
+        << "Vulkan: halide_vulkan_device_free (user_context: " << user_context
+        << ", buf: " << buf << ") VkBuffer: " << (void *)handle->alloc->buffer << "\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    // Wrapped buffers and buffers still referenced by crops can't be
+    // reused for something else.
+    if (handle->alloc->memory && handle->alloc->refcount == 1 &&
+        halide_device_allocation_cache_put(user_context, &vulkan_device_interface, NULL, buf->size_in_bytes(),
+                                           buf->device, free_cached_allocation)) {
+        debug(user_context) << "    caching VkBuffer " << (void *)handle->alloc->buffer << " for reuse\n";
+    } else {
+        release_handle(user_context, ctx.device, handle);
+    }
+    buf->device = 0;
+    buf->device_interface->impl->release_module();
+    buf->device_interface = NULL;
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
+WEAK int halide_vulkan_initialize_kernels(void *user_context, void **state_ptr, const char *src, int size) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_initialize_kernels (user_context: " << user_context
+        << ", state_ptr: " << state_ptr
+        << ", program: " << (void *)src
+        << ", size: " << size << "\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    // Create the state object if necessary. This only happens once, regardless
+    // of how many times halide_initialize_kernels/halide_release is called.
+    // halide_release traverses this list and releases the shader modules, but
+    // it does not modify the list nodes created/inserted here.
+    module_state **state = (module_state **)state_ptr;
+    if (!(*state)) {
+        *state = (module_state *)malloc(sizeof(module_state));
+        if (!(*state)) {
+            return halide_error_code_out_of_memory;
+        }
+        (*state)->shader = VK_NULL_HANDLE;
+        (*state)->kernels = NULL;
+        (*state)->next = state_list;
+        state_list = *state;
+    }
+
+    if (!(*state)->shader && size > 0) {
+        // SPIR-V must be 4-byte aligned, which the kernel source in the
+        // binary is not guaranteed to be.
+        uint32_t *code = (uint32_t *)malloc(size);
+        if (code == NULL) {
+            return halide_error_code_out_of_memory;
+        }
+        memcpy(code, src, size);
+        VkShaderModuleCreateInfo info = {
+            VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, NULL, 0, (size_t)size, code
+        };
+        VkResult err = vkCreateShaderModule(ctx.device, &info, NULL, &(*state)->shader);
+        free(code);
+        if (err != VK_SUCCESS) {
+            error(user_context) << "Vulkan: vkCreateShaderModule failed: " << get_vulkan_error_name(err) << "\n";
+            return err;
+        }
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
+// Used to generate correct timings when tracing
+WEAK int halide_vulkan_device_sync(void *user_context, halide_buffer_t *buf) {
+    debug(user_context) << "Vulkan: halide_vulkan_device_sync (user_context: " << user_context << ")\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    int err = 0;
+    if (buf && buf->device && buf->device_interface == &vulkan_device_interface) {
+        // Only wait for the work that uses the buffer, not for
+        // pipelines on other queues.
+        err = wait_for_allocation(user_context, ctx.device, ((device_handle *)buf->device)->alloc);
+    } else {
+        for (uint32_t i = 0; i < ctx.state->queue_count && err == 0; i++) {
+            err = wait_for_queue(user_context, ctx.device, &ctx.state->queues[i]);
+        }
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return err;
+}
+
+WEAK int halide_vulkan_device_release(void *user_context) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_device_release (user_context: " << user_context << ")\n";
+
+    if (vkCreateInstance == NULL) {
+        // The loader was never loaded, so there is nothing to release.
+        return 0;
+    }
+
+    // The VkContext object would create a context, so we use
+    // halide_vulkan_acquire_context directly.
+    halide_vulkan_instance *inst;
+    halide_vulkan_physical_device *phys;
+    halide_vulkan_device *dev;
+    uint32_t family, count;
+    int err = halide_vulkan_acquire_context(user_context, &inst, &phys, &dev, &family, &count, false);
+    if (err != 0) {
+        return err;
+    }
+
+    if (dev && dev_state && dev_state->device == (VkDevice)dev) {
+        for (uint32_t i = 0; i < dev_state->queue_count; i++) {
+            wait_for_queue(user_context, dev_state->device, &dev_state->queues[i]);
+        }
+
+        // Free any allocations held for reuse.
+        halide_device_allocation_cache_flush(user_context, &vulkan_device_interface);
+
+        // Release the pipelines and shader modules of the modules. Note
+        // that the list nodes themselves are not freed, so that later
+        // calls to halide_vulkan_initialize_kernels can reuse them.
+        module_state *state = state_list;
+        while (state) {
+            release_kernels(user_context, dev_state->device, state);
+            if (state->shader) {
+                debug(user_context) << "    vkDestroyShaderModule " << (void *)state->shader << "\n";
+                vkDestroyShaderModule(dev_state->device, state->shader, NULL);
+                state->shader = VK_NULL_HANDLE;
+            }
+            state = state->next;
+        }
+
+        destroy_device_state(user_context, dev_state);
+        dev_state = NULL;
+
+        // Release the context itself, if we created it.
+        if ((VkDevice)dev == device) {
+            debug(user_context) << "    vkDestroyDevice " << (void *)device << "\n";
+            vkDestroyDevice(device, NULL);
+            device = NULL;
+            vkDestroyInstance(instance, NULL);
+            instance = NULL;
+            physical_device = NULL;
+        }
+    } else {
+        halide_device_allocation_cache_flush(user_context, &vulkan_device_interface);
+    }
+
+    halide_vulkan_release_context(user_context);
+
+    return 0;
+}
+
+WEAK int halide_vulkan_device_malloc(void *user_context, halide_buffer_t *buf) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_device_malloc (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    size_t size = buf->size_in_bytes();
+    halide_assert(user_context, size != 0);
+    if (buf->device) {
+        return 0;
+    }
+
+    for (int i = 0; i < buf->dimensions; i++) {
+        halide_assert(user_context, buf->dim[i].stride >= 0);
+    }
+
+    debug(user_context) << "    allocating " << *buf << "\n";
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    uint64_t cached = halide_device_allocation_cache_get(user_context, &vulkan_device_interface, NULL, size);
+    if (cached) {
+        debug(user_context) << "    reusing cached device buffer " << (void *)cached << "\n";
+        buf->device = cached;
+        buf->device_interface = &vulkan_device_interface;
+        buf->device_interface->impl->use_module();
+        return 0;
+    }
+
+    device_handle *handle = (device_handle *)malloc(sizeof(device_handle));
+    if (handle == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    int err = create_allocation(user_context, ctx, size, false, &handle->alloc);
+    if (err != 0) {
+        free(handle);
+        return err;
+    }
+    handle->offset = 0;
+    buf->device = (uint64_t)handle;
+    buf->device_interface = &vulkan_device_interface;
+    buf->device_interface->impl->use_module();
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
+namespace {
+
+// Appends a region to regions for every contiguous chunk of a copy.
+WEAK void collect_copy_regions(const device_copy &c, int d, uint64_t src_off, uint64_t dst_off,
+                               VkBufferCopy *regions, uint32_t *count) {
+    if (d == 0) {
+        VkBufferCopy region = { src_off, dst_off, c.chunk_size };
+        regions[(*count)++] = region;
+    } else {
+        for (uint64_t i = 0; i < c.extent[d - 1]; i++) {
+            collect_copy_regions(c, d - 1, src_off, dst_off, regions, count);
+            src_off += c.src_stride_bytes[d - 1];
+            dst_off += c.dst_stride_bytes[d - 1];
+        }
+    }
+}
+
+// Records a copy of the chunks of c from one allocation to another.
+WEAK int vulkan_copy_on_device(void *user_context, VkContext &ctx, const device_copy &c,
+                               vk_allocation *src, uint64_t src_begin,
+                               vk_allocation *dst, uint64_t dst_begin) {
+    uint64_t count = 1;
+    for (int i = 0; i < MAX_COPY_DIMS; i++) {
+        count *= c.extent[i];
+    }
+    VkBufferCopy *regions = (VkBufferCopy *)malloc(count * sizeof(VkBufferCopy));
+    if (regions == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    uint32_t n = 0;
+    collect_copy_regions(c, MAX_COPY_DIMS, src_begin, dst_begin, regions, &n);
+    debug(user_context) << "    vkCmdCopyBuffer " << (void *)src->buffer << " -> " << (void *)dst->buffer
+                        << ", " << n << " regions of " << c.chunk_size << " bytes\n";
+
+    int queue = ctx.queue_index();
+    queue_state *q = &ctx.state->queues[queue];
+    VkCommandBuffer cb;
+    int err = begin_command(user_context, ctx.device, q, &cb);
+    if (err == 0) {
+        err = use_allocation(user_context, ctx, src, queue);
+    }
+    if (err == 0) {
+        err = use_allocation(user_context, ctx, dst, queue);
+    }
+    if (err == 0) {
+        vkCmdCopyBuffer(cb, src->buffer, dst->buffer, n, regions);
+        err = end_command(user_context, ctx.device, q);
+    }
+    free(regions);
+    return err;
+}
+
+}  // namespace
+
+WEAK int halide_vulkan_buffer_copy(void *user_context, struct halide_buffer_t *src,
+                                   const struct halide_device_interface_t *dst_device_interface,
+                                   struct halide_buffer_t *dst) {
+    // We only handle copies to vulkan or to host
+    halide_assert(user_context, dst_device_interface == NULL ||
+                  dst_device_interface == &vulkan_device_interface);
+
+    if ((src->device_dirty() || src->host == NULL) &&
+        src->device_interface != &vulkan_device_interface) {
+        halide_assert(user_context, dst_device_interface == &vulkan_device_interface);
+        // This is handled at the higher level.
+        return halide_error_code_incompatible_device_interface;
+    }
+
+    bool from_host = (src->device_interface != &vulkan_device_interface) ||
+                     (src->device == 0) ||
+                     (src->host_dirty() && src->host != NULL);
+    bool to_host = !dst_device_interface;
+
+    halide_assert(user_context, from_host || src->device);
+    halide_assert(user_context, to_host || dst->device);
+
+    device_copy c = make_buffer_copy(src, from_host, dst, to_host);
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    debug(user_context)
+        << "Vulkan: halide_vulkan_buffer_copy (user_context: " << user_context
+        << ", src: " << src << ", dst: " << dst << ")\n";
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    int err = 0;
+    if (!from_host && !to_host) {
+        device_handle *s = (device_handle *)c.src;
+        device_handle *d = (device_handle *)c.dst;
+        err = vulkan_copy_on_device(user_context, ctx, c, s->alloc, s->offset + c.src_begin, d->alloc, d->offset);
+    } else if (from_host && !to_host) {
+        device_handle *d = (device_handle *)c.dst;
+        if (d->alloc->mapped) {
+            err = wait_for_allocation(user_context, ctx.device, d->alloc);
+            if (err == 0) {
+                c.dst = (uint64_t)(d->alloc->mapped + d->offset);
+                copy_memory(c, user_context);
+            }
+        } else {
+            // Write the chunks into a staging buffer at the offsets they
+            // have in dst, and copy them into place on the device.
+            vk_allocation *staging = NULL;
+            err = create_allocation(user_context, ctx, dst->size_in_bytes(), true, &staging);
+            if (err == 0) {
+                device_copy to_staging = c;
+                to_staging.dst = (uint64_t)staging->mapped;
+                copy_memory(to_staging, user_context);
+                device_copy from_staging = c;
+                for (int i = 0; i < MAX_COPY_DIMS; i++) {
+                    from_staging.src_stride_bytes[i] = c.dst_stride_bytes[i];
+                }
+                err = vulkan_copy_on_device(user_context, ctx, from_staging, staging, 0, d->alloc, d->offset);
+                destroy_allocation(user_context, ctx.device, staging);
+            }
+        }
+    } else if (!from_host && to_host) {
+        device_handle *s = (device_handle *)c.src;
+        if (s->alloc->mapped) {
+            err = wait_for_allocation(user_context, ctx.device, s->alloc);
+            if (err == 0) {
+                c.src = (uint64_t)(s->alloc->mapped + s->offset);
+                copy_memory(c, user_context);
+            }
+        } else {
+            // Copy everything src spans into a staging buffer, and copy
+            // the chunks out of it on the host.
+            vk_allocation *staging = NULL;
+            uint64_t size = src->size_in_bytes();
+            err = create_allocation(user_context, ctx, size, true, &staging);
+            if (err == 0) {
+                device_copy whole = {0};
+                for (int i = 0; i < MAX_COPY_DIMS; i++) {
+                    whole.extent[i] = 1;
+                }
+                whole.chunk_size = size;
+                err = vulkan_copy_on_device(user_context, ctx, whole, s->alloc, s->offset, staging, 0);
+                if (err == 0) {
+                    err = wait_for_allocation(user_context, ctx.device, staging);
+                }
+                if (err == 0) {
+                    c.src = (uint64_t)staging->mapped;
+                    copy_memory(c, user_context);
+                }
+                destroy_allocation(user_context, ctx.device, staging);
+            }
+        }
+    } else {
+        copy_memory(c, user_context);
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return err;
+}
+
+WEAK int halide_vulkan_copy_to_device(void *user_context, halide_buffer_t *buf) {
+    return halide_vulkan_buffer_copy(user_context, buf, &vulkan_device_interface, buf);
+}
+
+WEAK int halide_vulkan_copy_to_host(void *user_context, halide_buffer_t *buf) {
+    return halide_vulkan_buffer_copy(user_context, buf, NULL, buf);
+}
+
+WEAK int halide_vulkan_run(void *user_context,
+                           void *state_ptr,
+                           const char *entry_name,
+                           int blocksX, int blocksY, int blocksZ,
+                           int threadsX, int threadsY, int threadsZ,
+                           int shared_mem_bytes,
+                           halide_type_t arg_types[],
+                           void *args[],
+                           int8_t arg_is_buffer[],
+                           int num_attributes,
+                           float *vertex_buffer,
+                           int num_coords_dim0,
+                           int num_coords_dim1) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_run (user_context: " << user_context << ", "
+        << "entry: " << entry_name << ", "
+        << "blocks: " << blocksX << "x" << blocksY << "x" << blocksZ << ", "
+        << "threads: " << threadsX << "x" << threadsY << "x" << threadsZ << ", "
+        << "shmem: " << shared_mem_bytes << "\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    halide_assert(user_context, state_ptr);
+    module_state *mod = (module_state *)state_ptr;
+    halide_assert(user_context, mod->shader);
+
+    kernel_state *k = NULL;
+    int err = get_kernel(user_context, ctx, mod, entry_name, arg_types, arg_is_buffer, &k);
+    if (err != 0) {
+        return err;
+    }
+
+    // Pack the push constants, as laid out by CodeGen_Vulkan_Dev: the
+    // element offset of each buffer, then the scalars.
+    uint8_t push_constants[max_push_constant_bytes];
+    memset(push_constants, 0, sizeof(push_constants));
+    uint32_t offset = 0;
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (arg_is_buffer[i]) {
+            const device_handle *h = (const device_handle *)((halide_buffer_t *)args[i])->device;
+            uint64_t element_bytes = (arg_types[i].bits + 7) / 8;
+            halide_assert(user_context, h->offset % element_bytes == 0);
+            uint32_t element_offset = (uint32_t)(h->offset / element_bytes);
+            memcpy(push_constants + offset, &element_offset, 4);
+            offset += 4;
+        }
+    }
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (!arg_is_buffer[i]) {
+            uint32_t bytes = arg_types[i].bits > 32 ? 8 : 4;
+            offset = (offset + bytes - 1) / bytes * bytes;
+            // Narrow scalars are zero-extended into their slot.
+            memcpy(push_constants + offset, args[i], (arg_types[i].bits + 7) / 8);
+            offset += bytes;
+        }
+    }
+    halide_assert(user_context, offset == k->push_constant_size);
+
+    // Get the descriptor set before starting the command, because
+    // rebinding a set may have to wait for the queue.
+    descriptor_cache_entry *descriptors = NULL;
+    if (k->num_buffers > 0) {
+        err = get_descriptor_set(user_context, ctx, k, args, arg_is_buffer, &descriptors);
+        if (err != 0) {
+            return err;
+        }
+    }
+
+    int queue = ctx.queue_index();
+    queue_state *q = &ctx.state->queues[queue];
+    VkCommandBuffer cb;
+    err = begin_command(user_context, ctx.device, q, &cb);
+    if (err != 0) {
+        return err;
+    }
+    for (int i = 0; arg_types[i].bits != 0 && err == 0; i++) {
+        if (arg_is_buffer[i]) {
+            err = use_allocation(user_context, ctx, ((device_handle *)((halide_buffer_t *)args[i])->device)->alloc, queue);
+        }
+    }
+    if (err != 0) {
+        return err;
+    }
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, k->pipeline);
+    if (descriptors) {
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, k->pipeline_layout, 0, 1, &descriptors->set, 0, NULL);
+        descriptors->queue = queue;
+        descriptors->serial = q->serials[q->recording];
+    }
+    if (k->push_constant_size > 0) {
+        vkCmdPushConstants(cb, k->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, k->push_constant_size, push_constants);
+    }
+    halide_timeline_event(user_context, entry_name, "gpu", 'i');
+    vkCmdDispatch(cb, blocksX, blocksY, blocksZ);
+
+    err = end_command(user_context, ctx.device, q);
+    if (err != 0) {
+        return err;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    err = wait_for_queue(user_context, ctx.device, q);
+    if (err != 0) {
+        return err;
+    }
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+    return 0;
+}
+
+WEAK int halide_vulkan_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_device_and_host_malloc (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    int result = halide_vulkan_device_malloc(user_context, buf);
+    if (result != 0) {
+        return result;
+    }
+    device_handle *handle = (device_handle *)buf->device;
+    if (handle->alloc->mapped) {
+        // The host can use the device memory directly, and copies
+        // between the two only wait for the GPU.
+        buf->host = handle->alloc->mapped + handle->offset;
+        return 0;
+    }
+    buf->host = (uint8_t *)halide_malloc(user_context, buf->size_in_bytes());
+    if (buf->host == NULL) {
+        halide_vulkan_device_free(user_context, buf);
+        return halide_error_code_out_of_memory;
+    }
+    return 0;
+}
+
+WEAK int halide_vulkan_device_and_host_free(void *user_context, struct halide_buffer_t *buf) {
+    if (buf->device && buf->device_interface == &vulkan_device_interface) {
+        device_handle *handle = (device_handle *)buf->device;
+        if (handle->alloc->mapped && buf->host == handle->alloc->mapped + handle->offset) {
+            buf->host = NULL;
+        }
+    }
+    int result = halide_vulkan_device_free(user_context, buf);
+    if (buf->host) {
+        halide_free(user_context, buf->host);
+        buf->host = NULL;
+    }
+    buf->set_host_dirty(false);
+    buf->set_device_dirty(false);
+    return result;
+}
+
+WEAK int halide_vulkan_wrap_vk_buffer(void *user_context, struct halide_buffer_t *buf, uint64_t vk_buffer) {
+    halide_assert(user_context, buf->device == 0);
+    if (buf->device != 0) {
+        return -2;
+    }
+    device_handle *handle = (device_handle *)malloc(sizeof(device_handle));
+    vk_allocation *alloc = (vk_allocation *)malloc(sizeof(vk_allocation));
+    if (handle == NULL || alloc == NULL) {
+        free(handle);
+        free(alloc);
+        return halide_error_code_out_of_memory;
+    }
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        free(handle);
+        free(alloc);
+        return ctx.error;
+    }
+    alloc->buffer = (VkBuffer)vk_buffer;
+    alloc->memory = VK_NULL_HANDLE;
+    alloc->mapped = NULL;
+    alloc->size = buf->size_in_bytes();
+    alloc->id = next_allocation_id++;
+    alloc->refcount = 1;
+    alloc->last_queue = 0;
+    alloc->last_serial = 0;
+    handle->offset = 0;
+    handle->alloc = alloc;
+    buf->device = (uint64_t)handle;
+    buf->device_interface = &vulkan_device_interface;
+    buf->device_interface->impl->use_module();
+    return 0;
+}
+
+WEAK int halide_vulkan_detach_vk_buffer(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &vulkan_device_interface);
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+    release_handle(user_context, ctx.device, (device_handle *)buf->device);
+    buf->device = 0;
+    buf->device_interface->impl->release_module();
+    buf->device_interface = NULL;
+    return 0;
+}
+
+WEAK uint64_t halide_vulkan_get_vk_buffer(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &vulkan_device_interface);
+    return ((device_handle *)buf->device)->alloc->buffer;
+}
+
+WEAK uint64_t halide_vulkan_get_crop_offset(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &vulkan_device_interface);
+    return ((device_handle *)buf->device)->offset;
+}
+
+namespace {
+
+WEAK int vulkan_device_crop_from_offset(void *user_context,
+                                        const struct halide_buffer_t *src,
+                                        int64_t offset,
+                                        struct halide_buffer_t *dst) {
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    device_handle *new_handle = (device_handle *)malloc(sizeof(device_handle));
+    if (new_handle == NULL) {
+        error(user_context) << "Vulkan: malloc failed making device handle for crop.\n";
+        return halide_error_code_out_of_memory;
+    }
+
+    const device_handle *src_handle = (const device_handle *)src->device;
+    new_handle->alloc = src_handle->alloc;
+    new_handle->alloc->refcount++;
+    new_handle->offset = src_handle->offset + offset;
+    dst->device = (uint64_t)new_handle;
+    dst->device_interface = src->device_interface;
+    return 0;
+}
+
+}  // namespace
+
+WEAK int halide_vulkan_device_crop(void *user_context,
+                                   const struct halide_buffer_t *src,
+                                   struct halide_buffer_t *dst) {
+    const int64_t offset = calc_device_crop_byte_offset(src, dst);
+    return vulkan_device_crop_from_offset(user_context, src, offset, dst);
+}
+
+WEAK int halide_vulkan_device_slice(void *user_context,
+                                    const struct halide_buffer_t *src,
+                                    int slice_dim,
+                                    int slice_pos,
+                                    struct halide_buffer_t *dst) {
+    const int64_t offset = calc_device_slice_byte_offset(src, slice_dim, slice_pos);
+    return vulkan_device_crop_from_offset(user_context, src, offset, dst);
+}
+
+WEAK int halide_vulkan_device_release_crop(void *user_context,
+                                           struct halide_buffer_t *buf) {
+    debug(user_context)
+        << "Vulkan: halide_vulkan_device_release_crop (user_context: " << user_context
+        << ", buf: " << buf << ") offset: " << ((device_handle *)buf->device)->offset << "\n";
+
+    VkContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+    release_handle(user_context, ctx.device, (device_handle *)buf->device);
+    return 0;
+}
+
+WEAK const struct halide_device_interface_t *halide_vulkan_device_interface() {
+    return &vulkan_device_interface;
+}
+
+namespace {
+__attribute__((destructor))
+WEAK void halide_vulkan_cleanup() {
+    halide_vulkan_device_release(NULL);
+}
+}
+
+} // extern "C" linkage
+
+namespace Halide { namespace Runtime { namespace Internal { namespace Vulkan {
+
+// Returns the index of a queue family of a device that supports
+// compute, preferring families without graphics, which on many GPUs
+// run concurrently with rendering, or -1.
+WEAK int find_compute_queue_family(VkPhysicalDevice dev, uint32_t *queue_count_ret) {
+    VkQueueFamilyProperties families[16];
+    uint32_t count = 16;
+    vkGetPhysicalDeviceQueueFamilyProperties(dev, &count, families);
+    int result = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!(families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) || families[i].queueCount == 0) {
+            continue;
+        }
+        if (result < 0 || !(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            result = (int)i;
+            *queue_count_ret = families[i].queueCount;
+            if (!(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+WEAK bool has_extension(const VkExtensionProperties *extensions, uint32_t count, const char *name) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(extensions[i].extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Initializes the context used by the default implementation
+// of halide_vulkan_acquire_context.
+WEAK int create_vulkan_context(void *user_context) {
+    debug(user_context) << "    create_vulkan_context (user_context: " << user_context << ")\n";
+
+    VkApplicationInfo app_info = {
+        VK_STRUCTURE_TYPE_APPLICATION_INFO, NULL, "Halide", 0, "Halide", 0, VK_API_VERSION_1_1
+    };
+    VkInstanceCreateInfo instance_info = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, NULL, 0, &app_info, 0, NULL, 0, NULL
+    };
+    VkResult err = vkCreateInstance(&instance_info, NULL, &instance);
+    if (err != VK_SUCCESS) {
+        error(user_context) << "Vulkan: vkCreateInstance failed: " << get_vulkan_error_name(err) << "\n";
+        instance = NULL;
+        return err;
+    }
+
+    VkPhysicalDevice devices[16];
+    uint32_t device_count = 16;
+    err = vkEnumeratePhysicalDevices(instance, &device_count, devices);
+    if (err != VK_SUCCESS && err != VK_INCOMPLETE) {
+        device_count = 0;
+    }
+
+    // Prefer discrete GPUs, then integrated GPUs, then anything else
+    // that supports Vulkan 1.1 and compute.
+    int best = -1, best_score = 0, family = -1;
+    uint32_t family_queue_count = 0;
+    for (uint32_t i = 0; i < device_count; i++) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(devices[i], &properties);
+        uint32_t n = 0;
+        int f = find_compute_queue_family(devices[i], &n);
+        if (properties.apiVersion < VK_API_VERSION_1_1 || f < 0) {
+            continue;
+        }
+        int score = (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) ? 3 :
+                    (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) ? 2 : 1;
+        if (score > best_score) {
+            best = (int)i;
+            best_score = score;
+            family = f;
+            family_queue_count = n;
+        }
+    }
+    if (best < 0) {
+        error(user_context) << "Vulkan: no device supports Vulkan 1.1 compute\n";
+        vkDestroyInstance(instance, NULL);
+        instance = NULL;
+        return halide_error_code_generic_error;
+    }
+    VkPhysicalDevice phys = devices[best];
+
+    uint32_t queues = default_queues;
+    const char *max_queues_str = getenv("HL_VK_MAX_QUEUES");
+    if (max_queues_str && atoi(max_queues_str) > 0) {
+        queues = (uint32_t)atoi(max_queues_str);
+    }
+    if (queues > (uint32_t)max_queues) {
+        queues = max_queues;
+    }
+    if (queues > family_queue_count) {
+        queues = family_queue_count;
+    }
+
+    // Enable the optional features the kernels may need that the device
+    // supports: 8 and 16-bit types, in buffers and in arithmetic, and
+    // 64-bit types.
+    VkExtensionProperties *extensions = NULL;
+    uint32_t extension_count = 0;
+    if (vkEnumerateDeviceExtensionProperties(phys, NULL, &extension_count, NULL) == VK_SUCCESS &&
+        extension_count > 0) {
+        extensions = (VkExtensionProperties *)malloc(extension_count * sizeof(VkExtensionProperties));
+        if (extensions == NULL ||
+            vkEnumerateDeviceExtensionProperties(phys, NULL, &extension_count, extensions) != VK_SUCCESS) {
+            extension_count = 0;
+        }
+    }
+    const char *enabled_extensions[2];
+    uint32_t enabled_extension_count = 0;
+
+    VkPhysicalDeviceShaderFloat16Int8FeaturesKHR float16_int8 = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES_KHR, NULL, VK_FALSE, VK_FALSE
+    };
+    VkPhysicalDevice8BitStorageFeaturesKHR storage_8bit = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_8BIT_STORAGE_FEATURES_KHR, NULL, VK_FALSE, VK_FALSE, VK_FALSE
+    };
+    VkPhysicalDevice16BitStorageFeatures storage_16bit = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES, NULL, VK_FALSE, VK_FALSE, VK_FALSE, VK_FALSE
+    };
+    VkPhysicalDeviceFeatures2 features;
+    memset(&features, 0, sizeof(features));
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &storage_16bit;
+    void **tail = &storage_16bit.pNext;
+    if (has_extension(extensions, extension_count, "VK_KHR_8bit_storage")) {
+        enabled_extensions[enabled_extension_count++] = "VK_KHR_8bit_storage";
+        *tail = &storage_8bit;
+        tail = &storage_8bit.pNext;
+    }
+    if (has_extension(extensions, extension_count, "VK_KHR_shader_float16_int8")) {
+        enabled_extensions[enabled_extension_count++] = "VK_KHR_shader_float16_int8";
+        *tail = &float16_int8;
+        tail = &float16_int8.pNext;
+    }
+    vkGetPhysicalDeviceFeatures2(phys, &features);
+
+    // Enable only what's needed; features like robustBufferAccess cost
+    // performance.
+    VkPhysicalDeviceFeatures supported = features.features;
+    memset(&features.features, 0, sizeof(features.features));
+    features.features.shaderFloat64 = supported.shaderFloat64;
+    features.features.shaderInt64 = supported.shaderInt64;
+    features.features.shaderInt16 = supported.shaderInt16;
+    storage_16bit.uniformAndStorageBuffer16BitAccess = VK_FALSE;
+    storage_16bit.storagePushConstant16 = VK_FALSE;
+    storage_16bit.storageInputOutput16 = VK_FALSE;
+    storage_8bit.uniformAndStorageBuffer8BitAccess = VK_FALSE;
+    storage_8bit.storagePushConstant8 = VK_FALSE;
+
+    float priorities[max_queues];
+    for (int i = 0; i < max_queues; i++) {
+        priorities[i] = 1.0f;
+    }
+    VkDeviceQueueCreateInfo queue_info = {
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, NULL, 0, (uint32_t)family, queues, priorities
+    };
+    VkDeviceCreateInfo device_info = {
+        VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, &features, 0, 1, &queue_info,
+        0, NULL, enabled_extension_count, enabled_extensions, NULL
+    };
+    err = vkCreateDevice(phys, &device_info, NULL, &device);
+    free(extensions);
+    if (err != VK_SUCCESS) {
+        error(user_context) << "Vulkan: vkCreateDevice failed: " << get_vulkan_error_name(err) << "\n";
+        device = NULL;
+        vkDestroyInstance(instance, NULL);
+        instance = NULL;
+        return err;
+    }
+
+    physical_device = phys;
+    queue_family_index = (uint32_t)family;
+    queue_count = queues;
+    return 0;
+}
+
+WEAK const char *get_vulkan_error_name(VkResult err) {
+    switch (err) {
+    case VK_SUCCESS: return "VK_SUCCESS";
+    case VK_NOT_READY: return "VK_NOT_READY";
+    case VK_TIMEOUT: return "VK_TIMEOUT";
+    case VK_EVENT_SET: return "VK_EVENT_SET";
+    case VK_EVENT_RESET: return "VK_EVENT_RESET";
+    case VK_INCOMPLETE: return "VK_INCOMPLETE";
+    case VK_ERROR_OUT_OF_HOST_MEMORY: return "VK_ERROR_OUT_OF_HOST_MEMORY";
+    case VK_ERROR_OUT_OF_DEVICE_MEMORY: return "VK_ERROR_OUT_OF_DEVICE_MEMORY";
+    case VK_ERROR_INITIALIZATION_FAILED: return "VK_ERROR_INITIALIZATION_FAILED";
+    case VK_ERROR_DEVICE_LOST: return "VK_ERROR_DEVICE_LOST";
+    case VK_ERROR_MEMORY_MAP_FAILED: return "VK_ERROR_MEMORY_MAP_FAILED";
+    case VK_ERROR_LAYER_NOT_PRESENT: return "VK_ERROR_LAYER_NOT_PRESENT";
+    case VK_ERROR_EXTENSION_NOT_PRESENT: return "VK_ERROR_EXTENSION_NOT_PRESENT";
+    case VK_ERROR_FEATURE_NOT_PRESENT: return "VK_ERROR_FEATURE_NOT_PRESENT";
+    case VK_ERROR_INCOMPATIBLE_DRIVER: return "VK_ERROR_INCOMPATIBLE_DRIVER";
+    case VK_ERROR_TOO_MANY_OBJECTS: return "VK_ERROR_TOO_MANY_OBJECTS";
+    case VK_ERROR_FORMAT_NOT_SUPPORTED: return "VK_ERROR_FORMAT_NOT_SUPPORTED";
+    case VK_ERROR_FRAGMENTED_POOL: return "VK_ERROR_FRAGMENTED_POOL";
+    case VK_ERROR_OUT_OF_POOL_MEMORY: return "VK_ERROR_OUT_OF_POOL_MEMORY";
+    default: return "<Unknown error>";
+    }
+}
+
+WEAK halide_device_interface_impl_t vulkan_device_interface_impl = {
+    halide_use_jit_module,
+    halide_release_jit_module,
+    halide_vulkan_device_malloc,
+    halide_vulkan_device_free,
+    halide_vulkan_device_sync,
+    halide_vulkan_device_release,
+    halide_vulkan_copy_to_host,
+    halide_vulkan_copy_to_device,
+    halide_vulkan_device_and_host_malloc,
+    halide_vulkan_device_and_host_free,
+    halide_vulkan_buffer_copy,
+    halide_vulkan_device_crop,
+    halide_vulkan_device_slice,
+    halide_vulkan_device_release_crop,
+    halide_vulkan_wrap_vk_buffer,
+    halide_vulkan_detach_vk_buffer,
+};
+
+WEAK halide_device_interface_t vulkan_device_interface = {
+    halide_device_malloc,
+    halide_device_free,
+    halide_device_sync,
+    halide_device_release,
+    halide_copy_to_host,
+    halide_copy_to_device,
+    halide_device_and_host_malloc,
+    halide_device_and_host_free,
+    halide_buffer_copy,
+    halide_device_crop,
+    halide_device_slice,
+    halide_device_release_crop,
+    halide_device_wrap_native,
+    halide_device_detach_native,
+    NULL,
+    &vulkan_device_interface_impl
+};
+
+}}}} // namespace Halide::Runtime::Internal::Vulkan
@@ -0,0 +1,75 @@
+// Note that this header intentionally does not use include
+// guards. The intended usage of this file is to define the meaning of
+// the VK_FN macro, and then include this file, sometimes repeatedly
+// within the same compilation unit.
+
+#ifndef VK_FN
+#define VK_FN(ret, fn, args)
+#endif
+
+/* Instance and physical device API */
+VK_FN(VkResult, vkCreateInstance, (const VkInstanceCreateInfo *, const VkAllocationCallbacks *, VkInstance *));
+VK_FN(void, vkDestroyInstance, (VkInstance, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkEnumeratePhysicalDevices, (VkInstance, uint32_t *, VkPhysicalDevice *));
+VK_FN(void, vkGetPhysicalDeviceProperties, (VkPhysicalDevice, VkPhysicalDeviceProperties *));
+VK_FN(void, vkGetPhysicalDeviceFeatures, (VkPhysicalDevice, VkPhysicalDeviceFeatures *));
+VK_FN(void, vkGetPhysicalDeviceFeatures2, (VkPhysicalDevice, VkPhysicalDeviceFeatures2 *));
+VK_FN(void, vkGetPhysicalDeviceQueueFamilyProperties, (VkPhysicalDevice, uint32_t *, VkQueueFamilyProperties *));
+VK_FN(void, vkGetPhysicalDeviceMemoryProperties, (VkPhysicalDevice, VkPhysicalDeviceMemoryProperties *));
+VK_FN(VkResult, vkEnumerateDeviceExtensionProperties, (VkPhysicalDevice, const char *, uint32_t *, VkExtensionProperties *));
+
+/* Device and queue API */
+VK_FN(VkResult, vkCreateDevice, (VkPhysicalDevice, const VkDeviceCreateInfo *, const VkAllocationCallbacks *, VkDevice *));
+VK_FN(void, vkDestroyDevice, (VkDevice, const VkAllocationCallbacks *));
+VK_FN(void, vkGetDeviceQueue, (VkDevice, uint32_t, uint32_t, VkQueue *));
+VK_FN(VkResult, vkDeviceWaitIdle, (VkDevice));
+VK_FN(VkResult, vkQueueSubmit, (VkQueue, uint32_t, const VkSubmitInfo *, VkFence));
+
+/* Memory API */
+VK_FN(VkResult, vkCreateBuffer, (VkDevice, const VkBufferCreateInfo *, const VkAllocationCallbacks *, VkBuffer *));
+VK_FN(void, vkDestroyBuffer, (VkDevice, VkBuffer, const VkAllocationCallbacks *));
+VK_FN(void, vkGetBufferMemoryRequirements, (VkDevice, VkBuffer, VkMemoryRequirements *));
+VK_FN(VkResult, vkAllocateMemory, (VkDevice, const VkMemoryAllocateInfo *, const VkAllocationCallbacks *, VkDeviceMemory *));
+VK_FN(void, vkFreeMemory, (VkDevice, VkDeviceMemory, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkBindBufferMemory, (VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize));
+VK_FN(VkResult, vkMapMemory, (VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void **));
+VK_FN(void, vkUnmapMemory, (VkDevice, VkDeviceMemory));
+
+/* Shader and pipeline API */
+VK_FN(VkResult, vkCreateShaderModule, (VkDevice, const VkShaderModuleCreateInfo *, const VkAllocationCallbacks *, VkShaderModule *));
+VK_FN(void, vkDestroyShaderModule, (VkDevice, VkShaderModule, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkCreatePipelineCache, (VkDevice, const VkPipelineCacheCreateInfo *, const VkAllocationCallbacks *, VkPipelineCache *));
+VK_FN(void, vkDestroyPipelineCache, (VkDevice, VkPipelineCache, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkGetPipelineCacheData, (VkDevice, VkPipelineCache, size_t *, void *));
+VK_FN(VkResult, vkCreateComputePipelines, (VkDevice, VkPipelineCache, uint32_t, const VkComputePipelineCreateInfo *, const VkAllocationCallbacks *, VkPipeline *));
+VK_FN(void, vkDestroyPipeline, (VkDevice, VkPipeline, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkCreatePipelineLayout, (VkDevice, const VkPipelineLayoutCreateInfo *, const VkAllocationCallbacks *, VkPipelineLayout *));
+VK_FN(void, vkDestroyPipelineLayout, (VkDevice, VkPipelineLayout, const VkAllocationCallbacks *));
+
+/* Descriptor API */
+VK_FN(VkResult, vkCreateDescriptorSetLayout, (VkDevice, const VkDescriptorSetLayoutCreateInfo *, const VkAllocationCallbacks *, VkDescriptorSetLayout *));
+VK_FN(void, vkDestroyDescriptorSetLayout, (VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkCreateDescriptorPool, (VkDevice, const VkDescriptorPoolCreateInfo *, const VkAllocationCallbacks *, VkDescriptorPool *));
+VK_FN(void, vkDestroyDescriptorPool, (VkDevice, VkDescriptorPool, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkAllocateDescriptorSets, (VkDevice, const VkDescriptorSetAllocateInfo *, VkDescriptorSet *));
+VK_FN(void, vkUpdateDescriptorSets, (VkDevice, uint32_t, const VkWriteDescriptorSet *, uint32_t, const void *));
+
+/* Command buffer API */
+VK_FN(VkResult, vkCreateCommandPool, (VkDevice, const VkCommandPoolCreateInfo *, const VkAllocationCallbacks *, VkCommandPool *));
+VK_FN(void, vkDestroyCommandPool, (VkDevice, VkCommandPool, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkAllocateCommandBuffers, (VkDevice, const VkCommandBufferAllocateInfo *, VkCommandBuffer *));
+VK_FN(VkResult, vkResetCommandBuffer, (VkCommandBuffer, VkCommandBufferResetFlags));
+VK_FN(VkResult, vkBeginCommandBuffer, (VkCommandBuffer, const VkCommandBufferBeginInfo *));
+VK_FN(VkResult, vkEndCommandBuffer, (VkCommandBuffer));
+VK_FN(void, vkCmdBindPipeline, (VkCommandBuffer, VkPipelineBindPoint, VkPipeline));
+VK_FN(void, vkCmdBindDescriptorSets, (VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t, const VkDescriptorSet *, uint32_t, const uint32_t *));
+VK_FN(void, vkCmdPushConstants, (VkCommandBuffer, VkPipelineLayout, VkShaderStageFlags, uint32_t, uint32_t, const void *));
+VK_FN(void, vkCmdDispatch, (VkCommandBuffer, uint32_t, uint32_t, uint32_t));
+VK_FN(void, vkCmdCopyBuffer, (VkCommandBuffer, VkBuffer, VkBuffer, uint32_t, const VkBufferCopy *));
+VK_FN(void, vkCmdPipelineBarrier, (VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const void *, uint32_t, const void *));
+
+/* Synchronization API */
+VK_FN(VkResult, vkCreateFence, (VkDevice, const VkFenceCreateInfo *, const VkAllocationCallbacks *, VkFence *));
+VK_FN(void, vkDestroyFence, (VkDevice, VkFence, const VkAllocationCallbacks *));
+VK_FN(VkResult, vkWaitForFences, (VkDevice, uint32_t, const VkFence *, VkBool32, uint64_t));
+VK_FN(VkResult, vkResetFences, (VkDevice, uint32_t, const VkFence *));
@@ -0,0 +1,1353 @@
+#include "HalideRuntimeWebGPU.h"
+#include "scoped_spin_lock.h"
+#include "device_buffer_utils.h"
+#include "device_interface.h"
+#include "printer.h"
+
+#include "mini_webgpu.h"
+
+#define INLINE inline __attribute__((always_inline))
+
+#ifdef WEBGPU_EMSCRIPTEN
+// In the browser, Emscripten implements the WebGPU C API over the
+// JavaScript API, and the functions are linked in directly.
+extern "C" {
+#define WGPU_FN(ret, fn, args) ret fn args;
+#include "webgpu_functions.h"
+#undef WGPU_FN
+WGPUDevice emscripten_webgpu_get_device();
+void emscripten_sleep(unsigned int ms);
+}
+#endif
+
+namespace Halide { namespace Runtime { namespace Internal { namespace WebGPU {
+
+WEAK bool lib_webgpu_loaded = false;
+
+#ifndef WEBGPU_EMSCRIPTEN
+#define WGPU_FN(ret, fn, args) WEAK ret (*fn) args;
+#include "webgpu_functions.h"
+#undef WGPU_FN
+
+// The default implementation of halide_webgpu_get_symbol attempts to load
+// a native WebGPU implementation (Dawn or wgpu-native), and then get the
+// symbol from it.
+WEAK void *lib_webgpu = NULL;
+
+extern "C" WEAK void *halide_webgpu_get_symbol(void *user_context, const char *name) {
+    // Only try to load the library if the library isn't already
+    // loaded, or we can't load the symbol from the process already.
+    void *symbol = halide_get_library_symbol(lib_webgpu, name);
+    if (symbol) {
+        return symbol;
+    }
+
+    const char *lib_names[] = {
+#ifdef WINDOWS
+        "webgpu_dawn.dll",
+        "wgpu_native.dll",
+#else
+        "libwebgpu_dawn.so",
+        "libwgpu_native.so",
+        "libwebgpu_dawn.dylib",
+        "libwgpu_native.dylib",
+#endif
+    };
+    for (size_t i = 0; i < sizeof(lib_names)/sizeof(lib_names[0]); i++) {
+        lib_webgpu = halide_load_library(lib_names[i]);
+        if (lib_webgpu) {
+            debug(user_context) << "    Loaded WebGPU library: " << lib_names[i] << "\n";
+            break;
+        }
+    }
+
+    return halide_get_library_symbol(lib_webgpu, name);
+}
+
+template <typename T>
+INLINE T get_wgpu_symbol(void *user_context, const char *name) {
+    T s = (T)halide_webgpu_get_symbol(user_context, name);
+    if (!s) {
+        error(user_context) << "WebGPU API not found: " << name << "\n";
+    }
+    return s;
+}
+
+WEAK int load_libwebgpu(void *user_context) {
+    debug(user_context) << "    load_libwebgpu (user_context: " << user_context << ")\n";
+
+    #define WGPU_FN(ret, fn, args)                                              \
+        fn = get_wgpu_symbol<ret (*)args>(user_context, #fn);                  \
+        if (!fn) {                                                              \
+            return halide_error_code_generic_error;                             \
+        }
+    #include "webgpu_functions.h"
+    #undef WGPU_FN
+    lib_webgpu_loaded = true;
+    return 0;
+}
+#else
+WEAK int load_libwebgpu(void *user_context) {
+    lib_webgpu_loaded = true;
+    return 0;
+}
+#endif
+
+extern WEAK halide_device_interface_t webgpu_device_interface;
+
+WEAK int create_webgpu_context(void *user_context);
+
+// The WebGPU context made by the default implementation of
+// halide_webgpu_acquire_context, and its lock.
+WEAK WGPUInstance instance = NULL;
+WEAK WGPUAdapter adapter = NULL;
+WEAK WGPUDevice device = NULL;
+volatile int WEAK thread_lock = 0;
+
+// The size of the ring buffer the arguments of kernels are passed in.
+const uint32_t uniform_ring_size = 64 * 1024;
+// The alignment of the arguments of each dispatch within the ring,
+// which is the minUniformBufferOffsetAlignment all devices support.
+const uint32_t uniform_alignment = 256;
+// Commands are recorded into one command buffer, which is submitted
+// once it holds this many, or when the host needs the results.
+const int max_batched_commands = 32;
+
+}}}} // namespace Halide::Runtime::Internal::WebGPU
+
+using namespace Halide::Runtime::Internal::WebGPU;
+
+extern "C" {
+
+// The default implementation of halide_webgpu_acquire_context uses the
+// global handles above, and serializes access with a spin lock.
+// Overriding implementations of acquire/release must implement the
+// following behavior:
+// - halide_webgpu_acquire_context should always store a valid device
+//   in its output arguments, or return an error code.
+// - A call to halide_webgpu_acquire_context is followed by a matching call to
+//   halide_webgpu_release_context. halide_webgpu_acquire_context should block while a
+//   previous call (if any) has not yet been released via halide_webgpu_release_context.
+WEAK int halide_webgpu_acquire_context(void *user_context,
+                                       halide_webgpu_instance **instance_ret,
+                                       halide_webgpu_device **device_ret,
+                                       bool create = true) {
+    halide_assert(user_context, instance_ret != NULL);
+    halide_assert(user_context, device_ret != NULL);
+
+    while (__sync_lock_test_and_set(&thread_lock, 1)) { }
+
+    // If the context has not been initialized, initialize it now.
+    if (!device && create) {
+        int error = create_webgpu_context(user_context);
+        if (error != 0) {
+            __sync_lock_release(&thread_lock);
+            return error;
+        }
+    }
+
+    *instance_ret = (halide_webgpu_instance *)instance;
+    *device_ret = (halide_webgpu_device *)device;
+    return 0;
+}
+
+WEAK int halide_webgpu_release_context(void *user_context) {
+    __sync_lock_release(&thread_lock);
+    return 0;
+}
+
+} // extern "C"
+
+namespace Halide { namespace Runtime { namespace Internal { namespace WebGPU {
+
+// The state Halide keeps for the device it runs on.
+struct device_state {
+    WGPUInstance instance;
+    WGPUDevice device;
+    WGPUQueue queue;
+    // The encoder commands are recorded into until they are submitted,
+    // or NULL, and the number of commands recorded into it.
+    WGPUCommandEncoder encoder;
+    int pending_commands;
+    // The ring buffer of kernel arguments, and the offset in it the
+    // arguments of the next dispatch go to.
+    WGPUBuffer uniforms;
+    uint32_t uniform_offset;
+    // The buffer copies to the host go through. It is kept for reuse,
+    // and grows to the largest copy seen.
+    WGPUBuffer readback;
+    uint64_t readback_size;
+};
+WEAK device_state *dev_state = NULL;
+
+// A device buffer, shared by a buffer and its crops. Buffers wrapped
+// with halide_webgpu_wrap_native are not owned by Halide.
+struct wgpu_allocation {
+    WGPUBuffer buffer;
+    uint64_t size;
+    int refcount;
+    bool owned;
+};
+
+// What the device field of a halide_buffer_t points to.
+struct device_handle {
+    wgpu_allocation *alloc;
+    uint64_t offset;
+};
+
+// The pipeline for a kernel, which is created the first time the
+// kernel runs.
+struct kernel_state {
+    char *name;
+    int num_buffers;
+    uint32_t uniform_size;
+    WGPUBindGroupLayout bind_group_layout;
+    WGPUComputePipeline pipeline;
+    kernel_state *next;
+};
+
+// Structure to hold the state of a module attached to the context.
+// Also used as a linked-list to keep track of all the different
+// modules that are attached to a context in order to release them all
+// when then context is released.
+struct module_state {
+    WGPUShaderModule shader;
+    kernel_state *kernels;
+    module_state *next;
+};
+WEAK module_state *state_list = NULL;
+
+WEAK int init_device_state(void *user_context, WGPUInstance inst, WGPUDevice dev);
+
+// Helper object to acquire and release the WebGPU context.
+class WgpuContext {
+    void *user_context;
+    bool acquired;
+
+public:
+    WGPUDevice device;
+    device_state *state;
+    int error;
+
+    // Constructor sets 'error' if any occurs.
+    INLINE WgpuContext(void *user_context) : user_context(user_context),
+                                             acquired(false),
+                                             device(NULL),
+                                             state(NULL),
+                                             error(0) {
+        if (!lib_webgpu_loaded) {
+            error = load_libwebgpu(user_context);
+            if (error != 0) {
+                return;
+            }
+        }
+
+#ifdef DEBUG_RUNTIME
+        halide_start_clock(user_context);
+#endif
+
+        halide_webgpu_instance *inst;
+        halide_webgpu_device *dev;
+        error = halide_webgpu_acquire_context(user_context, &inst, &dev, true);
+        if (error != 0) {
+            return;
+        }
+        acquired = true;
+        device = (WGPUDevice)dev;
+        halide_assert(user_context, device != NULL);
+
+        if (dev_state == NULL) {
+            error = init_device_state(user_context, (WGPUInstance)inst, device);
+        } else if (dev_state->device != device) {
+            Halide::Runtime::Internal::error(user_context) << "WebGPU: the context changed to a different device; "
+                                << "call halide_device_release first.\n";
+            error = halide_error_code_generic_error;
+        }
+        state = dev_state;
+    }
+
+    INLINE ~WgpuContext() {
+        if (acquired) {
+            halide_webgpu_release_context(user_context);
+        }
+    }
+};
+
+// Processes the device's events until *done is set by a callback.
+WEAK void wait_for_callback(device_state *ds, volatile int *done) {
+    while (!*done) {
+#ifdef WEBGPU_EMSCRIPTEN
+        // Callbacks run from the browser's event loop, which needs
+        // -sASYNCIFY to be entered from here.
+        emscripten_sleep(1);
+#else
+        if (ds->instance) {
+            wgpuInstanceProcessEvents(ds->instance);
+        } else {
+            // The application processes events on another thread.
+            halide_thread_yield();
+        }
+#endif
+    }
+}
+
+struct callback_result {
+    volatile int done;
+    int status;
+};
+
+WEAK void on_work_done(WGPUQueueWorkDoneStatus status, void *userdata) {
+    callback_result *r = (callback_result *)userdata;
+    r->status = status;
+    r->done = 1;
+}
+
+WEAK void on_buffer_mapped(WGPUBufferMapAsyncStatus status, void *userdata) {
+    callback_result *r = (callback_result *)userdata;
+    r->status = status;
+    r->done = 1;
+}
+
+struct error_scope_result {
+    volatile int done;
+    WGPUErrorType type;
+    void *user_context;
+};
+
+WEAK void on_error_scope_popped(WGPUErrorType type, const char *message, void *userdata) {
+    error_scope_result *r = (error_scope_result *)userdata;
+    r->type = type;
+    if (type != WGPUErrorType_NoError) {
+        error(r->user_context) << "WebGPU: " << (message ? message : "unknown error") << "\n";
+    }
+    r->done = 1;
+}
+
+// Pops the error scope pushed before creating objects on the device,
+// and returns an error if creating them failed.
+WEAK int pop_error_scope(void *user_context, device_state *ds) {
+    error_scope_result r = {0, WGPUErrorType_NoError, user_context};
+    wgpuDevicePopErrorScope(ds->device, on_error_scope_popped, &r);
+    wait_for_callback(ds, &r.done);
+    return r.type == WGPUErrorType_NoError ? 0 : halide_error_code_generic_error;
+}
+
+WEAK WGPUBuffer create_buffer(WGPUDevice dev, uint64_t size, WGPUBufferUsageFlags usage) {
+    WGPUBufferDescriptor desc = {NULL, NULL, usage, size, 0};
+    return wgpuDeviceCreateBuffer(dev, &desc);
+}
+
+WEAK int init_device_state(void *user_context, WGPUInstance inst, WGPUDevice dev) {
+    device_state *ds = (device_state *)malloc(sizeof(device_state));
+    if (ds == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    memset(ds, 0, sizeof(device_state));
+    ds->instance = inst;
+    ds->device = dev;
+    ds->queue = wgpuDeviceGetQueue(dev);
+    ds->uniforms = create_buffer(dev, uniform_ring_size,
+                                 WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst);
+    if (ds->queue == NULL || ds->uniforms == NULL) {
+        error(user_context) << "WebGPU: failed to initialize the device state\n";
+        if (ds->queue) {
+            wgpuQueueRelease(ds->queue);
+        }
+        free(ds);
+        return halide_error_code_generic_error;
+    }
+    dev_state = ds;
+    return 0;
+}
+
+// Submits the commands recorded so far.
+WEAK void flush_commands(device_state *ds) {
+    if (ds->encoder == NULL) {
+        return;
+    }
+    WGPUCommandBuffer commands = wgpuCommandEncoderFinish(ds->encoder, NULL);
+    wgpuCommandEncoderRelease(ds->encoder);
+    ds->encoder = NULL;
+    ds->pending_commands = 0;
+    wgpuQueueSubmit(ds->queue, 1, &commands);
+    wgpuCommandBufferRelease(commands);
+}
+
+// Returns the encoder to record the next command into.
+WEAK WGPUCommandEncoder begin_command(device_state *ds) {
+    if (ds->encoder == NULL) {
+        ds->encoder = wgpuDeviceCreateCommandEncoder(ds->device, NULL);
+    }
+    return ds->encoder;
+}
+
+WEAK void end_command(device_state *ds) {
+    if (++ds->pending_commands >= max_batched_commands) {
+        flush_commands(ds);
+    }
+}
+
+// Waits for all the submitted and recorded work to complete.
+WEAK int wait_for_queue(void *user_context, device_state *ds) {
+    flush_commands(ds);
+    callback_result r = {0, 0};
+    wgpuQueueOnSubmittedWorkDone(ds->queue, on_work_done, &r);
+    wait_for_callback(ds, &r.done);
+    if (r.status != WGPUQueueWorkDoneStatus_Success) {
+        error(user_context) << "WebGPU: waiting for the queue failed with status " << r.status << "\n";
+        return halide_error_code_generic_error;
+    }
+    return 0;
+}
+
+WEAK void destroy_device_state(device_state *ds) {
+    if (ds->encoder) {
+        wgpuCommandEncoderRelease(ds->encoder);
+    }
+    if (ds->readback) {
+        wgpuBufferDestroy(ds->readback);
+        wgpuBufferRelease(ds->readback);
+    }
+    wgpuBufferDestroy(ds->uniforms);
+    wgpuBufferRelease(ds->uniforms);
+    wgpuQueueRelease(ds->queue);
+    free(ds);
+}
+
+WEAK void release_allocation(wgpu_allocation *alloc) {
+    if (--alloc->refcount > 0) {
+        return;
+    }
+    if (alloc->owned) {
+        wgpuBufferDestroy(alloc->buffer);
+        wgpuBufferRelease(alloc->buffer);
+    }
+    free(alloc);
+}
+
+// Called by the allocation cache to release device buffers it holds.
+WEAK int free_cached_allocation(void *user_context, void *context, uint64_t dev) {
+    device_handle *handle = (device_handle *)dev;
+    release_allocation(handle->alloc);
+    free(handle);
+    return 0;
+}
+
+WEAK void release_kernels(module_state *mod) {
+    kernel_state *k = mod->kernels;
+    while (k) {
+        kernel_state *next = k->next;
+        if (k->pipeline) {
+            wgpuComputePipelineRelease(k->pipeline);
+        }
+        if (k->bind_group_layout) {
+            wgpuBindGroupLayoutRelease(k->bind_group_layout);
+        }
+        free(k->name);
+        free(k);
+        k = next;
+    }
+    mod->kernels = NULL;
+}
+
+// Reads size bytes at offset in a device buffer into dst. The offset
+// and size must be multiples of 4.
+WEAK int read_from_device(void *user_context, device_state *ds, WGPUBuffer buffer,
+                          uint64_t offset, uint64_t size, void *dst) {
+    if (ds->readback_size < size) {
+        if (ds->readback) {
+            wgpuBufferDestroy(ds->readback);
+            wgpuBufferRelease(ds->readback);
+        }
+        ds->readback = create_buffer(ds->device, size, WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst);
+        ds->readback_size = ds->readback ? size : 0;
+        if (ds->readback == NULL) {
+            error(user_context) << "WebGPU: failed to create a readback buffer of " << size << " bytes\n";
+            return halide_error_code_device_buffer_copy_failed;
+        }
+    }
+
+    WGPUCommandEncoder encoder = begin_command(ds);
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, buffer, offset, ds->readback, 0, size);
+    flush_commands(ds);
+
+    callback_result r = {0, 0};
+    wgpuBufferMapAsync(ds->readback, WGPUMapMode_Read, 0, (size_t)size, on_buffer_mapped, &r);
+    wait_for_callback(ds, &r.done);
+    if (r.status != WGPUBufferMapAsyncStatus_Success) {
+        error(user_context) << "WebGPU: mapping the readback buffer failed with status " << r.status << "\n";
+        return halide_error_code_device_buffer_copy_failed;
+    }
+    const void *mapped = wgpuBufferGetConstMappedRange(ds->readback, 0, (size_t)size);
+    memcpy(dst, mapped, size);
+    wgpuBufferUnmap(ds->readback);
+    return 0;
+}
+
+// Returns the number of bytes from the first to the last byte a copy
+// touches on one side.
+WEAK uint64_t copy_span(const device_copy &c, const uint64_t *stride_bytes) {
+    uint64_t span = c.chunk_size;
+    for (int i = 0; i < MAX_COPY_DIMS; i++) {
+        span += (c.extent[i] - 1) * stride_bytes[i];
+    }
+    return span;
+}
+
+WEAK bool is_single_chunk(const device_copy &c) {
+    for (int i = 0; i < MAX_COPY_DIMS; i++) {
+        if (c.extent[i] != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies host memory into a device buffer, as described by c, with
+// c.dst the byte offset in the buffer.
+WEAK int write_to_device(void *user_context, device_state *ds, const device_copy &c, WGPUBuffer buffer) {
+    // Queue writes happen before any commands recorded but not yet
+    // submitted, so submit those first.
+    flush_commands(ds);
+
+    const uint8_t *src = (const uint8_t *)c.src + c.src_begin;
+    if (is_single_chunk(c) && c.dst % 4 == 0 && c.chunk_size % 4 == 0) {
+        wgpuQueueWriteBuffer(ds->queue, buffer, c.dst, src, (size_t)c.chunk_size);
+        return 0;
+    }
+
+    // Writes must cover whole words, and the gaps between chunks must
+    // keep their contents, so read the words the copy touches back,
+    // patch them, and write them again.
+    uint64_t begin = c.dst & ~(uint64_t)3;
+    uint64_t end = (c.dst + copy_span(c, c.dst_stride_bytes) + 3) & ~(uint64_t)3;
+    uint8_t *staging = (uint8_t *)malloc(end - begin);
+    if (staging == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    int err = 0;
+    if (!is_single_chunk(c) || begin != c.dst || end != c.dst + c.chunk_size) {
+        err = read_from_device(user_context, ds, buffer, begin, end - begin, staging);
+    }
+    if (err == 0) {
+        device_copy patch = c;
+        patch.dst = (uint64_t)(staging + (c.dst - begin));
+        copy_memory(patch, user_context);
+        wgpuQueueWriteBuffer(ds->queue, buffer, begin, staging, (size_t)(end - begin));
+    }
+    free(staging);
+    return err;
+}
+
+WEAK int get_kernel(void *user_context, WgpuContext &ctx, module_state *mod, const char *entry_name,
+                    halide_type_t arg_types[], int8_t arg_is_buffer[], kernel_state **result) {
+    for (kernel_state *k = mod->kernels; k; k = k->next) {
+        if (strcmp(k->name, entry_name) == 0) {
+            *result = k;
+            return 0;
+        }
+    }
+
+    kernel_state *k = (kernel_state *)malloc(sizeof(kernel_state));
+    if (k == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    memset(k, 0, sizeof(kernel_state));
+    size_t name_size = strlen(entry_name) + 1;
+    k->name = (char *)malloc(name_size);
+    if (k->name == NULL) {
+        free(k);
+        return halide_error_code_out_of_memory;
+    }
+    memcpy(k->name, entry_name, name_size);
+    // Link the kernel in now, so that device_release frees it even if
+    // creating its pipeline fails below.
+    k->next = mod->kernels;
+    mod->kernels = k;
+
+    // The arguments block, as laid out by CodeGen_WebGPU_Dev: the
+    // element offset of each buffer, then the scalars, 4 bytes each.
+    int num_args = 0;
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (arg_is_buffer[i]) {
+            k->num_buffers++;
+        }
+        num_args++;
+    }
+    k->uniform_size = (uint32_t)num_args * 4;
+
+    // The buffers are bound in argument order, followed by the
+    // arguments block.
+    int num_entries = k->num_buffers + (k->uniform_size > 0 ? 1 : 0);
+    WGPUBindGroupLayoutEntry *entries =
+        (WGPUBindGroupLayoutEntry *)malloc((num_entries + 1) * sizeof(WGPUBindGroupLayoutEntry));
+    if (entries == NULL) {
+        return halide_error_code_out_of_memory;
+    }
+    memset(entries, 0, (num_entries + 1) * sizeof(WGPUBindGroupLayoutEntry));
+    for (int i = 0; i < num_entries; i++) {
+        entries[i].binding = i;
+        entries[i].visibility = WGPUShaderStage_Compute;
+        entries[i].buffer.type = i < k->num_buffers ? WGPUBufferBindingType_Storage : WGPUBufferBindingType_Uniform;
+    }
+
+    wgpuDevicePushErrorScope(ctx.device, WGPUErrorFilter_Validation);
+    WGPUBindGroupLayoutDescriptor layout_desc = {NULL, NULL, (size_t)num_entries, entries};
+    k->bind_group_layout = wgpuDeviceCreateBindGroupLayout(ctx.device, &layout_desc);
+    free(entries);
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {NULL, NULL, 1, &k->bind_group_layout};
+    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(ctx.device, &pipeline_layout_desc);
+    WGPUComputePipelineDescriptor pipeline_desc = {
+        NULL, entry_name, pipeline_layout, {NULL, mod->shader, entry_name, 0, NULL}
+    };
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+    k->pipeline = wgpuDeviceCreateComputePipeline(ctx.device, &pipeline_desc);
+    wgpuPipelineLayoutRelease(pipeline_layout);
+    int err = pop_error_scope(user_context, ctx.state);
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Created pipeline for " << entry_name << " in "
+                        << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+    if (err != 0) {
+        error(user_context) << "WebGPU: failed to create the pipeline for " << entry_name << "\n";
+        return err;
+    }
+
+    *result = k;
+    return 0;
+}
+
+}}}} // namespace Halide::Runtime::Internal::WebGPU
+
+extern "C" {
+
+WEAK int halide_webgpu_device_free(void *user_context, halide_buffer_t *buf) {
+    // halide_webgpu_device_free, at present, can be exposed to clients and they
+    // should be allowed to call halide_webgpu_device_free on any halide_buffer_t
+    // including ones that have never been used with a GPU.
+    if (buf->device == 0) {
+        return 0;
+    }
+
+    device_handle *handle = (device_handle *)buf->device;
+    halide_assert(user_context, handle->offset == 0 && "halide_webgpu_device_free on buffer obtained from halide_device_crop");
+
+    debug(user_context)
+        << "WebGPU: halide_webgpu_device_free (user_context: " << user_context
+        << ", buf: " << buf << ") WGPUBuffer: " << (void *)handle->alloc->buffer << "\n";
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    // Wrapped buffers and buffers still referenced by crops can't be
+    // reused for something else. Commands using a buffer keep it alive
+    // until they complete, so nothing needs to wait here.
+    if (handle->alloc->owned && handle->alloc->refcount == 1 &&
+        halide_device_allocation_cache_put(user_context, &webgpu_device_interface, NULL, buf->size_in_bytes(),
+                                           buf->device, free_cached_allocation)) {
+        debug(user_context) << "    caching WGPUBuffer " << (void *)handle->alloc->buffer << " for reuse\n";
+    } else {
+        release_allocation(handle->alloc);
+        free(handle);
+    }
+    buf->device = 0;
+    buf->device_interface->impl->release_module();
+    buf->device_interface = NULL;
+
+    return 0;
+}
+
+WEAK int halide_webgpu_initialize_kernels(void *user_context, void **state_ptr, const char *src, int size) {
+    debug(user_context)
+        << "WebGPU: halide_webgpu_initialize_kernels (user_context: " << user_context
+        << ", state_ptr: " << state_ptr
+        << ", program: " << (void *)src
+        << ", size: " << size << "\n";
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    // Create the state object if necessary. This only happens once, regardless
+    // of how many times halide_initialize_kernels/halide_release is called.
+    // halide_release traverses this list and releases the shader modules, but
+    // it does not modify the list nodes created/inserted here.
+    module_state **state = (module_state **)state_ptr;
+    if (!(*state)) {
+        *state = (module_state *)malloc(sizeof(module_state));
+        if (!(*state)) {
+            return halide_error_code_out_of_memory;
+        }
+        (*state)->shader = NULL;
+        (*state)->kernels = NULL;
+        (*state)->next = state_list;
+        state_list = *state;
+    }
+
+    if (!(*state)->shader && size > 0) {
+        // The WGSL source is NUL-terminated by CodeGen_WebGPU_Dev.
+        WGPUShaderModuleWGSLDescriptor wgsl = {{NULL, WGPUSType_ShaderModuleWGSLDescriptor}, src};
+        WGPUShaderModuleDescriptor desc = {&wgsl.chain, NULL, 0, NULL};
+        wgpuDevicePushErrorScope(ctx.device, WGPUErrorFilter_Validation);
+        (*state)->shader = wgpuDeviceCreateShaderModule(ctx.device, &desc);
+        int err = pop_error_scope(user_context, ctx.state);
+        if (err != 0) {
+            error(user_context) << "WebGPU: failed to compile the WGSL module\n";
+            if ((*state)->shader) {
+                wgpuShaderModuleRelease((*state)->shader);
+                (*state)->shader = NULL;
+            }
+            return err;
+        }
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
+// Used to generate correct timings when tracing
+WEAK int halide_webgpu_device_sync(void *user_context, halide_buffer_t *) {
+    debug(user_context) << "WebGPU: halide_webgpu_device_sync (user_context: " << user_context << ")\n";
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    int err = wait_for_queue(user_context, ctx.state);
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return err;
+}
+
+WEAK int halide_webgpu_device_release(void *user_context) {
+    debug(user_context)
+        << "WebGPU: halide_webgpu_device_release (user_context: " << user_context << ")\n";
+
+    if (!lib_webgpu_loaded) {
+        // The library was never loaded, so there is nothing to release.
+        return 0;
+    }
+
+    // The WgpuContext object would create a context, so we use
+    // halide_webgpu_acquire_context directly.
+    halide_webgpu_instance *inst;
+    halide_webgpu_device *dev;
+    int err = halide_webgpu_acquire_context(user_context, &inst, &dev, false);
+    if (err != 0) {
+        return err;
+    }
+
+    if (dev && dev_state && dev_state->device == (WGPUDevice)dev) {
+        wait_for_queue(user_context, dev_state);
+
+        // Free any allocations held for reuse.
+        halide_device_allocation_cache_flush(user_context, &webgpu_device_interface);
+
+        // Release the pipelines and shader modules of the modules. Note
+        // that the list nodes themselves are not freed, so that later
+        // calls to halide_webgpu_initialize_kernels can reuse them.
+        module_state *state = state_list;
+        while (state) {
+            release_kernels(state);
+            if (state->shader) {
+                wgpuShaderModuleRelease(state->shader);
+                state->shader = NULL;
+            }
+            state = state->next;
+        }
+
+        destroy_device_state(dev_state);
+        dev_state = NULL;
+
+#ifndef WEBGPU_EMSCRIPTEN
+        // Release the context itself, if we created it.
+        if ((WGPUDevice)dev == device) {
+            debug(user_context) << "    wgpuDeviceRelease " << (void *)device << "\n";
+            wgpuDeviceRelease(device);
+            device = NULL;
+            wgpuAdapterRelease(adapter);
+            adapter = NULL;
+            wgpuInstanceRelease(instance);
+            instance = NULL;
+        }
+#else
+        // The device belongs to JavaScript.
+        device = NULL;
+#endif
+    } else {
+        halide_device_allocation_cache_flush(user_context, &webgpu_device_interface);
+    }
+
+    halide_webgpu_release_context(user_context);
+
+    return 0;
+}
+
+WEAK int halide_webgpu_device_malloc(void *user_context, halide_buffer_t *buf) {
+    debug(user_context)
+        << "WebGPU: halide_webgpu_device_malloc (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    size_t size = buf->size_in_bytes();
+    halide_assert(user_context, size != 0);
+    if (buf->device) {
+        return 0;
+    }
+
+    for (int i = 0; i < buf->dimensions; i++) {
+        halide_assert(user_context, buf->dim[i].stride >= 0);
+    }
+
+    debug(user_context) << "    allocating " << *buf << "\n";
+
+    uint64_t cached = halide_device_allocation_cache_get(user_context, &webgpu_device_interface, NULL, size);
+    if (cached) {
+        debug(user_context) << "    reusing cached device buffer " << (void *)cached << "\n";
+        buf->device = cached;
+        buf->device_interface = &webgpu_device_interface;
+        buf->device_interface->impl->use_module();
+        return 0;
+    }
+
+    device_handle *handle = (device_handle *)malloc(sizeof(device_handle));
+    wgpu_allocation *alloc = (wgpu_allocation *)malloc(sizeof(wgpu_allocation));
+    if (handle == NULL || alloc == NULL) {
+        free(handle);
+        free(alloc);
+        return halide_error_code_out_of_memory;
+    }
+    // Buffer sizes must be a multiple of 4, and kernels access 8 and
+    // 16-bit elements through the words that contain them.
+    uint64_t rounded_size = (size + 3) & ~(uint64_t)3;
+    alloc->buffer = create_buffer(ctx.device, rounded_size,
+                                  WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst);
+    if (alloc->buffer == NULL) {
+        error(user_context) << "WebGPU: failed to allocate a buffer of " << rounded_size << " bytes\n";
+        free(handle);
+        free(alloc);
+        return halide_error_code_device_malloc_failed;
+    }
+    alloc->size = rounded_size;
+    alloc->refcount = 1;
+    alloc->owned = true;
+    handle->alloc = alloc;
+    handle->offset = 0;
+    buf->device = (uint64_t)handle;
+    buf->device_interface = &webgpu_device_interface;
+    buf->device_interface->impl->use_module();
+
+    debug(user_context) << "    allocated WGPUBuffer " << (void *)alloc->buffer << "\n";
+    return 0;
+}
+
+WEAK int halide_webgpu_buffer_copy(void *user_context, struct halide_buffer_t *src,
+                                   const struct halide_device_interface_t *dst_device_interface,
+                                   struct halide_buffer_t *dst) {
+    // We only handle copies to webgpu or to host
+    halide_assert(user_context, dst_device_interface == NULL ||
+                  dst_device_interface == &webgpu_device_interface);
+
+    if ((src->device_dirty() || src->host == NULL) &&
+        src->device_interface != &webgpu_device_interface) {
+        halide_assert(user_context, dst_device_interface == &webgpu_device_interface);
+        // This is handled at the higher level.
+        return halide_error_code_incompatible_device_interface;
+    }
+
+    bool from_host = (src->device_interface != &webgpu_device_interface) ||
+                     (src->device == 0) ||
+                     (src->host_dirty() && src->host != NULL);
+    bool to_host = !dst_device_interface;
+
+    halide_assert(user_context, from_host || src->device);
+    halide_assert(user_context, to_host || dst->device);
+
+    device_copy c = make_buffer_copy(src, from_host, dst, to_host);
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    debug(user_context)
+        << "WebGPU: halide_webgpu_buffer_copy (user_context: " << user_context
+        << ", src: " << src << ", dst: " << dst << ")\n";
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    int err = 0;
+    if (!from_host && !to_host && is_single_chunk(c) &&
+        (((device_handle *)c.src)->offset + c.src_begin) % 4 == 0 &&
+        ((device_handle *)c.dst)->offset % 4 == 0 && c.chunk_size % 4 == 0) {
+        // Copies between buffers on the device stay on the device.
+        device_handle *s = (device_handle *)c.src;
+        device_handle *d = (device_handle *)c.dst;
+        WGPUCommandEncoder encoder = begin_command(ctx.state);
+        wgpuCommandEncoderCopyBufferToBuffer(encoder, s->alloc->buffer, s->offset + c.src_begin,
+                                             d->alloc->buffer, d->offset, c.chunk_size);
+        end_command(ctx.state);
+    } else if (!from_host) {
+        // Read the words the copy touches from the source, and do the
+        // rest of the copy from that.
+        device_handle *s = (device_handle *)c.src;
+        uint64_t first = s->offset + c.src_begin;
+        uint64_t begin = first & ~(uint64_t)3;
+        uint64_t end = (first + copy_span(c, c.src_stride_bytes) + 3) & ~(uint64_t)3;
+        uint8_t *staging = (uint8_t *)malloc(end - begin);
+        if (staging == NULL) {
+            return halide_error_code_out_of_memory;
+        }
+        err = read_from_device(user_context, ctx.state, s->alloc->buffer, begin, end - begin, staging);
+        if (err == 0) {
+            c.src = (uint64_t)staging;
+            c.src_begin = first - begin;
+            if (to_host) {
+                copy_memory(c, user_context);
+            } else {
+                device_handle *d = (device_handle *)c.dst;
+                c.dst = d->offset;
+                err = write_to_device(user_context, ctx.state, c, d->alloc->buffer);
+            }
+        }
+        free(staging);
+    } else if (!to_host) {
+        device_handle *d = (device_handle *)c.dst;
+        c.dst = d->offset;
+        err = write_to_device(user_context, ctx.state, c, d->alloc->buffer);
+    } else {
+        copy_memory(c, user_context);
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return err;
+}
+
+WEAK int halide_webgpu_copy_to_device(void *user_context, halide_buffer_t *buf) {
+    return halide_webgpu_buffer_copy(user_context, buf, &webgpu_device_interface, buf);
+}
+
+WEAK int halide_webgpu_copy_to_host(void *user_context, halide_buffer_t *buf) {
+    return halide_webgpu_buffer_copy(user_context, buf, NULL, buf);
+}
+
+WEAK int halide_webgpu_run(void *user_context,
+                           void *state_ptr,
+                           const char *entry_name,
+                           int blocksX, int blocksY, int blocksZ,
+                           int threadsX, int threadsY, int threadsZ,
+                           int shared_mem_bytes,
+                           halide_type_t arg_types[],
+                           void *args[],
+                           int8_t arg_is_buffer[],
+                           int num_attributes,
+                           float *vertex_buffer,
+                           int num_coords_dim0,
+                           int num_coords_dim1) {
+    debug(user_context)
+        << "WebGPU: halide_webgpu_run (user_context: " << user_context << ", "
+        << "entry: " << entry_name << ", "
+        << "blocks: " << blocksX << "x" << blocksY << "x" << blocksZ << ", "
+        << "threads: " << threadsX << "x" << threadsY << "x" << threadsZ << ", "
+        << "shmem: " << shared_mem_bytes << "\n";
+
+    WgpuContext ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    halide_assert(user_context, state_ptr);
+    module_state *mod = (module_state *)state_ptr;
+    halide_assert(user_context, mod->shader);
+
+    kernel_state *k = NULL;
+    int err = get_kernel(user_context, ctx, mod, entry_name, arg_types, arg_is_buffer, &k);
+    if (err != 0) {
+        return err;
+    }
+    device_state *ds = ctx.state;
+
+    // Pack the arguments block, as laid out by CodeGen_WebGPU_Dev: the
+    // element offset of each buffer, then the scalars, widened to 32
+    // bits the way the kernel expects to find them.
+    uint32_t uniform_offset = 0;
+    if (k->uniform_size > 0) {
+        uint8_t *uniforms = (uint8_t *)__builtin_alloca(k->uniform_size);
+        uint32_t offset = 0;
+        for (int i = 0; arg_types[i].bits != 0; i++) {
+            if (arg_is_buffer[i]) {
+                const device_handle *h = (const device_handle *)((halide_buffer_t *)args[i])->device;
+                uint64_t element_bytes = (arg_types[i].bits + 7) / 8;
+                halide_assert(user_context, h->offset % element_bytes == 0);
+                int32_t element_offset = (int32_t)(h->offset / element_bytes);
+                memcpy(uniforms + offset, &element_offset, 4);
+                offset += 4;
+            }
+        }
+        for (int i = 0; arg_types[i].bits != 0; i++) {
+            if (!arg_is_buffer[i]) {
+                halide_type_t t = arg_types[i];
+                uint32_t value = 0;
+                if (t.bits == 1) {
+                    value = *(const uint8_t *)args[i] ? 1 : 0;
+                } else if (t.bits == 8) {
+                    value = t.code == halide_type_int ? (uint32_t)(int32_t)*(const int8_t *)args[i] : *(const uint8_t *)args[i];
+                } else if (t.bits == 16) {
+                    value = t.code == halide_type_int ? (uint32_t)(int32_t)*(const int16_t *)args[i] : *(const uint16_t *)args[i];
+                } else {
+                    halide_assert(user_context, t.bits == 32);
+                    memcpy(&value, args[i], 4);
+                }
+                memcpy(uniforms + offset, &value, 4);
+                offset += 4;
+            }
+        }
+        halide_assert(user_context, offset == k->uniform_size);
+
+        // Take the next slice of the ring. The writes of earlier slices
+        // are ordered before the dispatches that read them, so once the
+        // ring wraps, submitting those dispatches before overwriting
+        // their slices is enough.
+        uint32_t slice = (k->uniform_size + uniform_alignment - 1) & ~(uniform_alignment - 1);
+        if (ds->uniform_offset + slice > uniform_ring_size) {
+            flush_commands(ds);
+            ds->uniform_offset = 0;
+        }
+        uniform_offset = ds->uniform_offset;
+        ds->uniform_offset += slice;
+        wgpuQueueWriteBuffer(ds->queue, ds->uniforms, uniform_offset, uniforms, k->uniform_size);
+    }
+
+    int num_entries = k->num_buffers + (k->uniform_size > 0 ? 1 : 0);
+    WGPUBindGroupEntry *entries = (WGPUBindGroupEntry *)__builtin_alloca((num_entries + 1) * sizeof(WGPUBindGroupEntry));
+    memset(entries, 0, (num_entries + 1) * sizeof(WGPUBindGroupEntry));
+    int binding = 0;
+    for (int i = 0; arg_types[i].bits != 0; i++) {
+        if (arg_is_buffer[i]) {
+            // The whole buffer is bound; the kernel adds the offset of
+            // the crop itself.
+            const wgpu_allocation *alloc = ((const device_handle *)((halide_buffer_t *)args[i])->device)->alloc;
+            entries[binding].binding = binding;
+            entries[binding].buffer = alloc->buffer;
+            entries[binding].offset = 0;
+            entries[binding].size = alloc->size;
+            binding++;
+        }
+    }
+    if (k->uniform_size > 0) {
+        entries[binding].binding = binding;
+        entries[binding].buffer = ds->uniforms;
+        entries[binding].offset = uniform_offset;
+        entries[binding].size = (k->uniform_size + 15) & ~15;
+    }
+    WGPUBindGroupDescriptor bind_group_desc = {NULL, NULL, k->bind_group_layout, (size_t)num_entries, entries};
+    WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(ctx.device, &bind_group_desc);
+
+    WGPUCommandEncoder encoder = begin_command(ds);
+    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, NULL);
+    wgpuComputePassEncoderSetPipeline(pass, k->pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, NULL);
+    halide_timeline_event(user_context, entry_name, "gpu", 'i');
+    wgpuComputePassEncoderDispatchWorkgroups(pass, blocksX, blocksY, blocksZ);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    // The command buffer holds a reference to the bind group.
+    wgpuBindGroupRelease(bind_group);
+    end_command(ds);
+
+    #ifdef DEBUG_RUNTIME
+    err = wait_for_queue(user_context, ds);
+    if (err != 0) {
+        return err;
+    }
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+    return 0;
+}
+
+WEAK int halide_webgpu_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf) {
+    return halide_default_device_and_host_malloc(user_context, buf, &webgpu_device_interface);
+}
+
+WEAK int halide_webgpu_device_and_host_free(void *user_context, struct halide_buffer_t *buf) {
+    return halide_default_device_and_host_free(user_context, buf, &webgpu_device_interface);
+}
+
+WEAK int halide_webgpu_wrap_native(void *user_context, struct halide_buffer_t *buf, uint64_t mem) {
+    halide_assert(user_context, buf->device == 0);
+    if (buf->device != 0) {
+        return -2;
+    }
+    device_handle *handle = (device_handle *)malloc(sizeof(device_handle));
+    wgpu_allocation *alloc = (wgpu_allocation *)malloc(sizeof(wgpu_allocation));
+    if (handle == NULL || alloc == NULL) {
+        free(handle);
+        free(alloc);
+        return halide_error_code_out_of_memory;
+    }
+    alloc->buffer = (WGPUBuffer)mem;
+    alloc->size = (buf->size_in_bytes() + 3) & ~(uint64_t)3;
+    alloc->refcount = 1;
+    alloc->owned = false;
+    handle->alloc = alloc;
+    handle->offset = 0;
+    buf->device = (uint64_t)handle;
+    buf->device_interface = &webgpu_device_interface;
+    buf->device_interface->impl->use_module();
+    return 0;
+}
+
+WEAK int halide_webgpu_detach_native(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &webgpu_device_interface);
+    device_handle *handle = (device_handle *)buf->device;
+    release_allocation(handle->alloc);
+    free(handle);
+    buf->device = 0;
+    buf->device_interface->impl->release_module();
+    buf->device_interface = NULL;
+    return 0;
+}
+
+WEAK uint64_t halide_webgpu_get_native_buffer(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &webgpu_device_interface);
+    return (uint64_t)((device_handle *)buf->device)->alloc->buffer;
+}
+
+WEAK uint64_t halide_webgpu_get_crop_offset(void *user_context, halide_buffer_t *buf) {
+    if (buf->device == 0) {
+        return 0;
+    }
+    halide_assert(user_context, buf->device_interface == &webgpu_device_interface);
+    return ((device_handle *)buf->device)->offset;
+}
+
+namespace {
+
+WEAK int webgpu_device_crop_from_offset(void *user_context,
+                                        const struct halide_buffer_t *src,
+                                        int64_t offset,
+                                        struct halide_buffer_t *dst) {
+    device_handle *new_handle = (device_handle *)malloc(sizeof(device_handle));
+    if (new_handle == NULL) {
+        error(user_context) << "WebGPU: malloc failed making device handle for crop.\n";
+        return halide_error_code_out_of_memory;
+    }
+
+    const device_handle *src_handle = (const device_handle *)src->device;
+    new_handle->alloc = src_handle->alloc;
+    new_handle->alloc->refcount++;
+    new_handle->offset = src_handle->offset + offset;
+    dst->device = (uint64_t)new_handle;
+    dst->device_interface = src->device_interface;
+    return 0;
+}
+
+}  // namespace
+
+WEAK int halide_webgpu_device_crop(void *user_context,
+                                   const struct halide_buffer_t *src,
+                                   struct halide_buffer_t *dst) {
+    const int64_t offset = calc_device_crop_byte_offset(src, dst);
+    return webgpu_device_crop_from_offset(user_context, src, offset, dst);
+}
+
+WEAK int halide_webgpu_device_slice(void *user_context,
+                                    const struct halide_buffer_t *src,
+                                    int slice_dim,
+                                    int slice_pos,
+                                    struct halide_buffer_t *dst) {
+    const int64_t offset = calc_device_slice_byte_offset(src, slice_dim, slice_pos);
+    return webgpu_device_crop_from_offset(user_context, src, offset, dst);
+}
+
+WEAK int halide_webgpu_device_release_crop(void *user_context,
+                                           struct halide_buffer_t *buf) {
+    debug(user_context)
+        << "WebGPU: halide_webgpu_device_release_crop (user_context: " << user_context
+        << ", buf: " << buf << ") offset: " << ((device_handle *)buf->device)->offset << "\n";
+
+    device_handle *handle = (device_handle *)buf->device;
+    release_allocation(handle->alloc);
+    free(handle);
+    return 0;
+}
+
+WEAK const struct halide_device_interface_t *halide_webgpu_device_interface() {
+    return &webgpu_device_interface;
+}
+
+namespace {
+__attribute__((destructor))
+WEAK void halide_webgpu_cleanup() {
+    halide_webgpu_device_release(NULL);
+}
+}
+
+} // extern "C" linkage
+
+namespace Halide { namespace Runtime { namespace Internal { namespace WebGPU {
+
+#ifdef WEBGPU_EMSCRIPTEN
+
+// Initializes the context used by the default implementation of
+// halide_webgpu_acquire_context from the device JavaScript made.
+WEAK int create_webgpu_context(void *user_context) {
+    debug(user_context) << "    create_webgpu_context (user_context: " << user_context << ")\n";
+
+    device = emscripten_webgpu_get_device();
+    if (device == NULL) {
+        error(user_context) << "WebGPU: no device. Set Module.preinitializedWebGPUDevice "
+                            << "to a GPUDevice before running the pipeline.\n";
+        return halide_error_code_generic_error;
+    }
+    return 0;
+}
+
+#else
+
+struct request_result {
+    volatile int done;
+    int status;
+    void *handle;
+};
+
+WEAK void on_adapter(WGPURequestAdapterStatus status, WGPUAdapter a, const char *message, void *userdata) {
+    request_result *r = (request_result *)userdata;
+    r->status = status;
+    r->handle = a;
+    r->done = 1;
+}
+
+WEAK void on_device(WGPURequestDeviceStatus status, WGPUDevice d, const char *message, void *userdata) {
+    request_result *r = (request_result *)userdata;
+    r->status = status;
+    r->handle = d;
+    r->done = 1;
+}
+
+// Initializes the context used by the default implementation
+// of halide_webgpu_acquire_context.
+WEAK int create_webgpu_context(void *user_context) {
+    debug(user_context) << "    create_webgpu_context (user_context: " << user_context << ")\n";
+
+    instance = wgpuCreateInstance(NULL);
+    if (instance == NULL) {
+        error(user_context) << "WebGPU: wgpuCreateInstance failed\n";
+        return halide_error_code_generic_error;
+    }
+
+    request_result r = {0, 0, NULL};
+    wgpuInstanceRequestAdapter(instance, NULL, on_adapter, &r);
+    while (!r.done) {
+        wgpuInstanceProcessEvents(instance);
+    }
+    if (r.status != WGPURequestAdapterStatus_Success || r.handle == NULL) {
+        error(user_context) << "WebGPU: no adapter available\n";
+        wgpuInstanceRelease(instance);
+        instance = NULL;
+        return halide_error_code_generic_error;
+    }
+    adapter = (WGPUAdapter)r.handle;
+
+    request_result d = {0, 0, NULL};
+    wgpuAdapterRequestDevice(adapter, NULL, on_device, &d);
+    while (!d.done) {
+        wgpuInstanceProcessEvents(instance);
+    }
+    if (d.status != WGPURequestDeviceStatus_Success || d.handle == NULL) {
+        error(user_context) << "WebGPU: failed to create a device\n";
+        wgpuAdapterRelease(adapter);
+        adapter = NULL;
+        wgpuInstanceRelease(instance);
+        instance = NULL;
+        return halide_error_code_generic_error;
+    }
+    device = (WGPUDevice)d.handle;
+    return 0;
+}
+
+#endif
+
+WEAK halide_device_interface_impl_t webgpu_device_interface_impl = {
+    halide_use_jit_module,
+    halide_release_jit_module,
+    halide_webgpu_device_malloc,
+    halide_webgpu_device_free,
+    halide_webgpu_device_sync,
+    halide_webgpu_device_release,
+    halide_webgpu_copy_to_host,
+    halide_webgpu_copy_to_device,
+    halide_webgpu_device_and_host_malloc,
+    halide_webgpu_device_and_host_free,
+    halide_webgpu_buffer_copy,
+    halide_webgpu_device_crop,
+    halide_webgpu_device_slice,
+    halide_webgpu_device_release_crop,
+    halide_webgpu_wrap_native,
+    halide_webgpu_detach_native,
+};
+
+WEAK halide_device_interface_t webgpu_device_interface = {
+    halide_device_malloc,
+    halide_device_free,
+    halide_device_sync,
+    halide_device_release,
+    halide_copy_to_host,
+    halide_copy_to_device,
+    halide_device_and_host_malloc,
+    halide_device_and_host_free,
+    halide_buffer_copy,
+    halide_device_crop,
+    halide_device_slice,
+    halide_device_release_crop,
+    halide_device_wrap_native,
+    halide_device_detach_native,
+    NULL,
+    &webgpu_device_interface_impl
+};
+
+}}}} // namespace Halide::Runtime::Internal::WebGPU
@@ -0,0 +1,2 @@
+#define WEBGPU_EMSCRIPTEN
+#include "webgpu.cpp"
@@ -0,0 +1,62 @@
+// Note that this header intentionally does not use include
+// guards. The intended usage of this file is to define the meaning of
+// the WGPU_FN macro, and then include this file, sometimes repeatedly
+// within the same compilation unit.
+
+#ifndef WGPU_FN
+#define WGPU_FN(ret, fn, args)
+#endif
+
+#ifndef WEBGPU_EMSCRIPTEN
+/* Instance and adapter API. In the browser, the device is created by
+ * JavaScript instead. */
+WGPU_FN(WGPUInstance, wgpuCreateInstance, (const void *));
+WGPU_FN(void, wgpuInstanceRequestAdapter, (WGPUInstance, const void *, WGPURequestAdapterCallback, void *));
+WGPU_FN(void, wgpuInstanceProcessEvents, (WGPUInstance));
+WGPU_FN(void, wgpuInstanceRelease, (WGPUInstance));
+WGPU_FN(void, wgpuAdapterRequestDevice, (WGPUAdapter, const void *, WGPURequestDeviceCallback, void *));
+WGPU_FN(void, wgpuAdapterRelease, (WGPUAdapter));
+WGPU_FN(void, wgpuDeviceRelease, (WGPUDevice));
+#endif
+
+/* Device and queue API */
+WGPU_FN(WGPUQueue, wgpuDeviceGetQueue, (WGPUDevice));
+WGPU_FN(void, wgpuQueueRelease, (WGPUQueue));
+WGPU_FN(void, wgpuDevicePushErrorScope, (WGPUDevice, WGPUErrorFilter));
+WGPU_FN(void, wgpuDevicePopErrorScope, (WGPUDevice, WGPUErrorCallback, void *));
+WGPU_FN(void, wgpuQueueSubmit, (WGPUQueue, size_t, const WGPUCommandBuffer *));
+WGPU_FN(void, wgpuQueueWriteBuffer, (WGPUQueue, WGPUBuffer, uint64_t, const void *, size_t));
+WGPU_FN(void, wgpuQueueOnSubmittedWorkDone, (WGPUQueue, WGPUQueueWorkDoneCallback, void *));
+
+/* Buffer API */
+WGPU_FN(WGPUBuffer, wgpuDeviceCreateBuffer, (WGPUDevice, const WGPUBufferDescriptor *));
+WGPU_FN(void, wgpuBufferDestroy, (WGPUBuffer));
+WGPU_FN(void, wgpuBufferRelease, (WGPUBuffer));
+WGPU_FN(void, wgpuBufferMapAsync, (WGPUBuffer, WGPUMapModeFlags, size_t, size_t, WGPUBufferMapCallback, void *));
+WGPU_FN(const void *, wgpuBufferGetConstMappedRange, (WGPUBuffer, size_t, size_t));
+WGPU_FN(void, wgpuBufferUnmap, (WGPUBuffer));
+
+/* Shader and pipeline API */
+WGPU_FN(WGPUShaderModule, wgpuDeviceCreateShaderModule, (WGPUDevice, const WGPUShaderModuleDescriptor *));
+WGPU_FN(void, wgpuShaderModuleRelease, (WGPUShaderModule));
+WGPU_FN(WGPUBindGroupLayout, wgpuDeviceCreateBindGroupLayout, (WGPUDevice, const WGPUBindGroupLayoutDescriptor *));
+WGPU_FN(void, wgpuBindGroupLayoutRelease, (WGPUBindGroupLayout));
+WGPU_FN(WGPUPipelineLayout, wgpuDeviceCreatePipelineLayout, (WGPUDevice, const WGPUPipelineLayoutDescriptor *));
+WGPU_FN(void, wgpuPipelineLayoutRelease, (WGPUPipelineLayout));
+WGPU_FN(WGPUComputePipeline, wgpuDeviceCreateComputePipeline, (WGPUDevice, const WGPUComputePipelineDescriptor *));
+WGPU_FN(void, wgpuComputePipelineRelease, (WGPUComputePipeline));
+WGPU_FN(WGPUBindGroup, wgpuDeviceCreateBindGroup, (WGPUDevice, const WGPUBindGroupDescriptor *));
+WGPU_FN(void, wgpuBindGroupRelease, (WGPUBindGroup));
+
+/* Command API */
+WGPU_FN(WGPUCommandEncoder, wgpuDeviceCreateCommandEncoder, (WGPUDevice, const void *));
+WGPU_FN(void, wgpuCommandEncoderCopyBufferToBuffer, (WGPUCommandEncoder, WGPUBuffer, uint64_t, WGPUBuffer, uint64_t, uint64_t));
+WGPU_FN(WGPUComputePassEncoder, wgpuCommandEncoderBeginComputePass, (WGPUCommandEncoder, const void *));
+WGPU_FN(WGPUCommandBuffer, wgpuCommandEncoderFinish, (WGPUCommandEncoder, const void *));
+WGPU_FN(void, wgpuCommandEncoderRelease, (WGPUCommandEncoder));
+WGPU_FN(void, wgpuCommandBufferRelease, (WGPUCommandBuffer));
+WGPU_FN(void, wgpuComputePassEncoderSetPipeline, (WGPUComputePassEncoder, WGPUComputePipeline));
+WGPU_FN(void, wgpuComputePassEncoderSetBindGroup, (WGPUComputePassEncoder, uint32_t, WGPUBindGroup, size_t, const uint32_t *));
+WGPU_FN(void, wgpuComputePassEncoderDispatchWorkgroups, (WGPUComputePassEncoder, uint32_t, uint32_t, uint32_t));
+WGPU_FN(void, wgpuComputePassEncoderEnd, (WGPUComputePassEncoder));
+WGPU_FN(void, wgpuComputePassEncoderRelease, (WGPUComputePassEncoder));
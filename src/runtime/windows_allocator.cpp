@@ -0,0 +1,47 @@
+#include "runtime_internal.h"
+
+extern "C" {
+
+#ifdef BITS_64
+#define WIN32API
+#else
+#define WIN32API __stdcall
+#endif
+
+WIN32API void *VirtualAlloc(void *lpAddress, size_t dwSize, unsigned long flAllocationType, unsigned long flProtect);
+WIN32API int VirtualFree(void *lpAddress, size_t dwSize, unsigned long dwFreeType);
+WIN32API size_t GetLargePageMinimum();
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+#define MEM_COMMIT 0x00001000
+#define MEM_RESERVE 0x00002000
+#define MEM_RELEASE 0x00008000
+#define MEM_LARGE_PAGES 0x20000000
+#define PAGE_READWRITE 0x04
+
+WEAK size_t large_page_size() {
+    size_t page = GetLargePageMinimum();
+    return page ? page : 2 * 1024 * 1024;
+}
+
+// Large pages need the SeLockMemoryPrivilege to have been granted to the
+// user and enabled in the process. Without it the allocation fails, and
+// falls back to malloc.
+WEAK void *large_page_map(size_t size) {
+    if (GetLargePageMinimum() == 0) {
+        return NULL;
+    }
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+WEAK void large_page_unmap(void *base, size_t size) {
+    VirtualFree(base, 0, MEM_RELEASE);
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+#define HALIDE_LARGE_PAGES 1
+#include "posix_allocator.cpp"
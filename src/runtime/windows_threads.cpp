@@ -28,6 +28,7 @@ extern WIN32API void DeleteCriticalSection(CriticalSection *);
 extern WIN32API void EnterCriticalSection(CriticalSection *);
 extern WIN32API void LeaveCriticalSection(CriticalSection *);
 extern WIN32API int32_t WaitForSingleObject(Thread, int32_t timeout);
+extern WIN32API uint32_t GetCurrentThreadId();
 
 } // extern "C"
 
@@ -44,6 +45,10 @@ WEAK void *spawn_thread_helper(void *arg) {
     return NULL;
 }
 
+WEAK uint64_t halide_current_thread_id() {
+    return GetCurrentThreadId();
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -0,0 +1,2 @@
+#define WINDOWS
+#include "vulkan.cpp"
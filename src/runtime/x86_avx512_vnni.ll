@@ -0,0 +1,41 @@
+; The AVX512-VNNI dot product instructions. Each i32 lane of the
+; result is the accumulator plus the dot product of the four u8 x i8
+; (dpbusd) or two i16 x i16 (dpwssd) pairs packed into the
+; corresponding i32 lanes of the other two arguments.
+
+declare <16 x i32> @llvm.x86.avx512.vpdpbusd.512(<16 x i32>, <16 x i32>, <16 x i32>)
+declare <8 x i32> @llvm.x86.avx512.vpdpbusd.256(<8 x i32>, <8 x i32>, <8 x i32>)
+declare <4 x i32> @llvm.x86.avx512.vpdpbusd.128(<4 x i32>, <4 x i32>, <4 x i32>)
+declare <16 x i32> @llvm.x86.avx512.vpdpwssd.512(<16 x i32>, <16 x i32>, <16 x i32>)
+declare <8 x i32> @llvm.x86.avx512.vpdpwssd.256(<8 x i32>, <8 x i32>, <8 x i32>)
+declare <4 x i32> @llvm.x86.avx512.vpdpwssd.128(<4 x i32>, <4 x i32>, <4 x i32>)
+
+define weak_odr <16 x i32> @dpbusdx16(<16 x i32> %acc, <16 x i32> %a, <16 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <16 x i32> @llvm.x86.avx512.vpdpbusd.512(<16 x i32> %acc, <16 x i32> %a, <16 x i32> %b)
+  ret <16 x i32> %1
+}
+
+define weak_odr <8 x i32> @dpbusdx8(<8 x i32> %acc, <8 x i32> %a, <8 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <8 x i32> @llvm.x86.avx512.vpdpbusd.256(<8 x i32> %acc, <8 x i32> %a, <8 x i32> %b)
+  ret <8 x i32> %1
+}
+
+define weak_odr <4 x i32> @dpbusdx4(<4 x i32> %acc, <4 x i32> %a, <4 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <4 x i32> @llvm.x86.avx512.vpdpbusd.128(<4 x i32> %acc, <4 x i32> %a, <4 x i32> %b)
+  ret <4 x i32> %1
+}
+
+define weak_odr <16 x i32> @dpwssdx16(<16 x i32> %acc, <16 x i32> %a, <16 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <16 x i32> @llvm.x86.avx512.vpdpwssd.512(<16 x i32> %acc, <16 x i32> %a, <16 x i32> %b)
+  ret <16 x i32> %1
+}
+
+define weak_odr <8 x i32> @dpwssdx8(<8 x i32> %acc, <8 x i32> %a, <8 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <8 x i32> @llvm.x86.avx512.vpdpwssd.256(<8 x i32> %acc, <8 x i32> %a, <8 x i32> %b)
+  ret <8 x i32> %1
+}
+
+define weak_odr <4 x i32> @dpwssdx4(<4 x i32> %acc, <4 x i32> %a, <4 x i32> %b) nounwind alwaysinline {
+  %1 = tail call <4 x i32> @llvm.x86.avx512.vpdpwssd.128(<4 x i32> %acc, <4 x i32> %a, <4 x i32> %b)
+  ret <4 x i32> %1
+}
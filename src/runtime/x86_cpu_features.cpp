@@ -5,8 +5,9 @@ namespace Halide { namespace Runtime { namespace Internal {
 
 extern "C" void x86_cpuid_halide(int32_t *);
 
-static inline void cpuid(int32_t fn_id, int32_t *info) {
+static inline void cpuid(int32_t fn_id, int32_t *info, int32_t sub_fn_id = 0) {
     info[0] = fn_id;
+    info[2] = sub_fn_id;
     x86_cpuid_halide(info);
 }
 
@@ -21,6 +22,9 @@ WEAK CpuFeatures halide_get_cpu_features() {
     features.set_known(halide_target_feature_avx512_knl);
     features.set_known(halide_target_feature_avx512_skylake);
     features.set_known(halide_target_feature_avx512_cannonlake);
+    features.set_known(halide_target_feature_avx512_vnni);
+    features.set_known(halide_target_feature_avx512_bf16);
+    features.set_known(halide_target_feature_avx512_sapphirerapids);
 
     int32_t info[4];
     cpuid(1, info);
@@ -60,6 +64,9 @@ WEAK CpuFeatures halide_get_cpu_features() {
         const uint32_t avx512_knl = avx512 | avx512pf | avx512er;
         const uint32_t avx512_skylake = avx512 | avx512vl | avx512bw | avx512dq;
         const uint32_t avx512_cannonlake = avx512_skylake | avx512ifma; // Assume ifma => vbmi
+        const uint32_t avx512vnni = 1U << 11;  // In ecx
+        const uint32_t avx512bf16 = 1U << 5;   // In eax, with cpuid(eax=7, ecx=1)
+        const uint32_t amx = (1U << 22) | (1U << 24) | (1U << 25);  // AMX-BF16, AMX-TILE, AMX-INT8 in edx
         if ((info2[1] & avx2) == avx2) {
             features.set_available(halide_target_feature_avx2);
         }
@@ -74,6 +81,19 @@ WEAK CpuFeatures halide_get_cpu_features() {
             if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
                 features.set_available(halide_target_feature_avx512_cannonlake);
             }
+            if ((info2[1] & avx512_skylake) == avx512_skylake &&
+                (info2[2] & avx512vnni) == avx512vnni) {
+                features.set_available(halide_target_feature_avx512_vnni);
+                int info3[4];
+                cpuid(7, info3, 1);
+                if ((info3[0] & avx512bf16) == avx512bf16) {
+                    features.set_available(halide_target_feature_avx512_bf16);
+                    if ((info2[1] & avx512_cannonlake) == avx512_cannonlake &&
+                        (info2[3] & amx) == amx) {
+                        features.set_available(halide_target_feature_avx512_sapphirerapids);
+                    }
+                }
+            }
         }
     }
     return features;
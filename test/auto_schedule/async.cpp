@@ -0,0 +1,50 @@
+#include "Halide.h"
+#include <math.h>
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+    Buffer<float> input = lambda(x, y, sin(x) + cos(y) + 1.0f).realize(260, 260);
+
+    // Two independent stencils feeding one consumer. The output is small
+    // relative to the parallelism below, so the autoscheduler should run
+    // the producers of each tile as asynchronous tasks.
+    Func a("a"), b("b"), c("c");
+    a(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3.0f;
+    b(x, y) = (input(x, y) + input(x, y + 1) + input(x, y + 2)) / 3.0f;
+    c(x, y) = a(x, y) + a(x, y + 2) + b(x, y) + b(x + 2, y);
+
+    c.estimate(x, 0, 256).estimate(y, 0, 256);
+
+    Target target = get_jit_target_from_environment();
+    Pipeline p(c);
+
+    MachineParams params(64, 16 * 1024 * 1024, 40);
+    std::string schedule = p.auto_schedule(target, params);
+    std::cout << schedule << "\n";
+
+    if (schedule.find(".async()") == std::string::npos) {
+        printf("The producers were not made async\n");
+        return -1;
+    }
+
+    Buffer<float> out = p.realize(256, 256);
+
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            auto fa = [&](int x, int y) { return (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3.0f; };
+            auto fb = [&](int x, int y) { return (input(x, y) + input(x, y + 1) + input(x, y + 2)) / 3.0f; };
+            float correct = fa(x, y) + fa(x, y + 2) + fb(x, y) + fb(x + 2, y);
+            if (fabs(out(x, y) - correct) > 1e-4f) {
+                printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    const int W = 512, H = 512;
+    ImageParam in(Float(32), 2);
+
+    // burn does a lot of arithmetic per value it loads, and copy does
+    // none, so they should land on opposite sides of the roofline.
+    Func burn("burn"), copy("copy");
+    Expr e = in(x, y);
+    for (int i = 0; i < 128; i++) {
+        e = e * e + 0.5f;
+    }
+    burn(x, y) = e;
+    copy(x, y) = burn(y, x);
+
+    burn.compute_root();
+
+    in.dim(0).set_bounds_estimate(0, W);
+    in.dim(1).set_bounds_estimate(0, H);
+    copy.estimate(x, 0, W).estimate(y, 0, H);
+
+    Pipeline p(copy);
+    std::string report = p.roofline_report(MachineParams(16, 8 * 1024 * 1024, 40));
+    printf("%s", report.c_str());
+
+    auto bound_of = [&](const std::string &stage) -> std::string {
+        size_t line = report.find("\n" + stage + " ");
+        if (line == std::string::npos) {
+            return "";
+        }
+        size_t end = report.find('\n', line + 1);
+        std::string row = report.substr(line + 1, end - line - 1);
+        size_t word = row.find_last_of(' ');
+        return row.substr(word + 1);
+    };
+
+    if (bound_of("burn") != "compute") {
+        printf("burn should have been compute-bound\n");
+        return -1;
+    }
+
+    if (bound_of("copy") != "memory") {
+        printf("copy should have been memory-bound\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
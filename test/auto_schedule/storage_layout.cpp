@@ -0,0 +1,55 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), c("c");
+
+    const int W = 256, H = 128, C = 16;
+    Buffer<float> in(W + 8, H);
+    in.for_each_element([&](int x, int y) { in(x, y) = (float)((x * 3 + y * 7) % 13); });
+
+    // f is defined with x innermost, but its only consumer walks over
+    // c innermost, so it should be stored with c innermost too.
+    RDom r(0, 8, "r");
+    Func f("f"), g("g");
+    f(x, y, c) = 0.0f;
+    f(x, y, c) += in(x + r, y) * (c + 1);
+    g(c, x, y) = f(x, y, c) * 2.0f;
+
+    g.estimate(c, 0, C).estimate(x, 0, W).estimate(y, 0, H);
+
+    Target target = get_jit_target_from_environment();
+    Pipeline p(g);
+
+    std::string schedule = p.auto_schedule(target);
+
+    // Inspect the schedule
+    g.print_loop_nest();
+
+    if (schedule.find("reorder_storage(c, x, y)") == std::string::npos) {
+        printf("f was not stored with c innermost:\n%s\n", schedule.c_str());
+        return -1;
+    }
+
+    // Run the schedule
+    Buffer<float> out = p.realize(C, W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            for (int c = 0; c < C; c++) {
+                float correct = 0.0f;
+                for (int i = 0; i < 8; i++) {
+                    correct += in(x + i, y) * (c + 1);
+                }
+                correct *= 2.0f;
+                if (out(c, x, y) != correct) {
+                    printf("out(%d, %d, %d) = %f instead of %f\n", c, x, y, out(c, x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
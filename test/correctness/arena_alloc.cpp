@@ -0,0 +1,100 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+std::atomic<int> mallocs;
+std::atomic<int> frees;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    void *orig = malloc(x + 64);
+    void *ptr = (void *)((((size_t)orig + 64) >> 6) << 6);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    frees++;
+    free(((void **)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+
+#ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    return 0;
+#else
+    setenv("HL_NUM_THREADS", "4", 1);
+
+    const int stages = 10;
+    Var x, y;
+
+    std::vector<Func> chain(stages);
+    chain[0](x, y) = x + y;
+    for (int i = 1; i < stages; i++) {
+        chain[i](x, y) = chain[i - 1](x, y) + chain[i - 1](x + 1, y);
+        chain[i - 1].compute_root();
+    }
+
+    // One more Func computed per row inside a parallel loop.
+    Func inner, out;
+    inner(x, y) = chain.back()(x, y) * 2;
+    out(x, y) = inner(x, y) + inner(x + 1, y);
+    inner.compute_at(out, y);
+    out.parallel(y);
+    chain.back().compute_root();
+
+    out.set_custom_allocator(my_malloc, my_free);
+    Target t = get_jit_target_from_environment().with_feature(Target::ArenaAlloc);
+    out.compile_jit(t);
+
+    for (int iter = 0; iter < 3; iter++) {
+        mallocs = 0;
+        frees = 0;
+
+        // Let the size vary, so that the allocations aren't constant size.
+        Buffer<int> result(200 + iter, 100);
+        out.realize(result, t);
+
+        // Without the arena, each of the root Funcs would make a call to
+        // halide_malloc, and each row of the parallel loop would make
+        // another. With it, the root Funcs share a few large chunks, and
+        // the rows share a pool with at most one block per thread.
+        if (mallocs > 16) {
+            printf("Too many calls to malloc: %d\n", (int)mallocs);
+            return -1;
+        }
+
+        // Everything but the chunk kept for the next run is freed.
+        if (frees < mallocs - 1) {
+            printf("%d calls to malloc but only %d calls to free\n", (int)mallocs, (int)frees);
+            return -1;
+        }
+
+        for (int yy = 0; yy < result.height(); yy++) {
+            for (int xx = 0; xx < result.width(); xx++) {
+                // chain[i](x, y) = sum_k C(i, k) * (x + k + y)
+                int c = 0, binomial = 1;
+                for (int k = 0; k < stages; k++) {
+                    c += binomial * (xx + k + yy) * 2;
+                    c += binomial * (xx + 1 + k + yy) * 2;
+                    binomial = binomial * (stages - 1 - k) / (k + 1);
+                }
+                if (result(xx, yy) != c) {
+                    printf("result(%d, %d) = %d instead of %d\n", xx, yy, result(xx, yy), c);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
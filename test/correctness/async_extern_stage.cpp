@@ -0,0 +1,60 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+// Fills its output with x + 2 * y.
+extern "C" DLLEXPORT int make_ramp(halide_buffer_t *out) {
+    if (out->is_bounds_query()) {
+        return 0;
+    }
+    assert(out->host && out->type == halide_type_of<int32_t>());
+    for (int y = 0; y < out->dim[1].extent; y++) {
+        for (int x = 0; x < out->dim[0].extent; x++) {
+            int32_t *dst = (int32_t *)out->host + x * out->dim[0].stride + y * out->dim[1].stride;
+            *dst = (x + out->dim[0].min) + 2 * (y + out->dim[1].min);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Var x, y, yo, yi;
+
+    for (int i = 0; i < 2; i++) {
+        Func producer("producer"), consumer("consumer");
+        producer.define_extern("make_ramp", {}, Int(32), {x, y});
+        consumer(x, y) = producer(x, y) + producer(x + 1, y);
+
+        if (i == 0) {
+            // The whole producer runs on another thread while the
+            // consumer waits for it.
+            producer.compute_root().async();
+        } else {
+            // One strip of the producer at a time, running ahead of
+            // the consumer.
+            consumer.split(y, yo, yi, 8);
+            producer.compute_at(consumer, yo).store_root().async();
+        }
+
+        Buffer<int32_t> out = consumer.realize(64, 64);
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = 2 * x + 1 + 4 * y;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+template<typename T>
+int check(const Buffer<T> &result, const Buffer<T> &correct, const char *name) {
+    for (int x = 0; x < correct.width(); x++) {
+        if (result(x) != correct(x)) {
+            printf("%s: result(%d) = %f instead of %f\n", name, x,
+                   (double)result(x), (double)correct(x));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const int img_size = 10000;
+    const int hist_size = 7;
+
+    Buffer<int> input(img_size);
+    for (int i = 0; i < img_size; i++) {
+        input(i) = (i * 17 + 3) % 101;
+    }
+
+    Var x;
+    RDom r(0, img_size);
+
+    // A histogram, parallelized and vectorized over the RDom. Lowers
+    // to native atomic adds.
+    {
+        Buffer<int> correct(hist_size);
+        correct.fill(0);
+        for (int i = 0; i < img_size; i++) {
+            correct(input(i) % hist_size)++;
+        }
+
+        Func hist;
+        hist(x) = 0;
+        hist(input(r) % hist_size) += 1;
+
+        RVar ro, ri;
+        hist.update().atomic().split(r, ro, ri, 16).parallel(ro).vectorize(ri, 8);
+
+        Buffer<int> result = hist.realize(hist_size);
+        if (check(result, correct, "hist") != 0) {
+            return -1;
+        }
+    }
+
+    // Min and max reductions.
+    {
+        Buffer<int> correct_min(hist_size), correct_max(hist_size);
+        correct_min.fill(1000);
+        correct_max.fill(-1000);
+        for (int i = 0; i < img_size; i++) {
+            int b = i % hist_size;
+            correct_min(b) = std::min(correct_min(b), input(i) - 50);
+            correct_max(b) = std::max(correct_max(b), input(i) - 50);
+        }
+
+        Func lo, hi;
+        lo(x) = 1000;
+        lo(r % hist_size) = min(lo(r % hist_size), input(r) - 50);
+        hi(x) = -1000;
+        hi(r % hist_size) = max(hi(r % hist_size), input(r) - 50);
+        lo.update().atomic().parallel(r);
+        hi.update().atomic().parallel(r);
+
+        Buffer<int> result_min = lo.realize(hist_size);
+        Buffer<int> result_max = hi.realize(hist_size);
+        if (check(result_min, correct_min, "min") != 0 ||
+            check(result_max, correct_max, "max") != 0) {
+            return -1;
+        }
+    }
+
+    // A product has no native atomic instruction, so it uses a
+    // compare-and-swap loop.
+    {
+        Buffer<uint32_t> correct(hist_size);
+        correct.fill(1);
+        for (int i = 0; i < img_size; i++) {
+            correct(i % hist_size) *= (uint32_t)(input(i) | 1);
+        }
+
+        Func prod;
+        prod(x) = cast<uint32_t>(1);
+        prod(r % hist_size) *= cast<uint32_t>(input(r) | 1);
+        prod.update().atomic().parallel(r);
+
+        Buffer<uint32_t> result = prod.realize(hist_size);
+        if (check(result, correct, "prod") != 0) {
+            return -1;
+        }
+    }
+
+    // A floating point sum. The summands are small integers so the
+    // result is exact regardless of the order of the additions.
+    {
+        Buffer<float> correct(hist_size);
+        correct.fill(0.0f);
+        for (int i = 0; i < img_size; i++) {
+            correct(i % hist_size) += (float)input(i);
+        }
+
+        Func sum;
+        sum(x) = 0.0f;
+        sum(r % hist_size) += cast<float>(input(r));
+        sum.update().atomic().parallel(r);
+
+        Buffer<float> result = sum.realize(hist_size);
+        if (check(result, correct, "float sum") != 0) {
+            return -1;
+        }
+    }
+
+    Target t = get_jit_target_from_environment();
+    if (t.has_gpu_feature()) {
+        Buffer<int> correct(hist_size);
+        correct.fill(0);
+        for (int i = 0; i < img_size; i++) {
+            correct(input(i) % hist_size)++;
+        }
+
+        Func hist;
+        hist(x) = 0;
+        hist(input(r) % hist_size) += 1;
+
+        RVar ro, ri;
+        hist.update().atomic().gpu_tile(r, ro, ri, 64);
+
+        Buffer<int> result = hist.realize(hist_size);
+        if (check(result, correct, "gpu hist") != 0) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
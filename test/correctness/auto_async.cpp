@@ -0,0 +1,83 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Count the Fork nodes in the lowered code, without changing it.
+class CountForks : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const Fork *op) override {
+        count++;
+        return IRMutator::visit(op);
+    }
+
+public:
+    int count = 0;
+};
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment().with_feature(Target::AutoAsync);
+
+    // Three independent branches that merge.
+    Func a, b, c, out;
+    Var x, y;
+    a(x, y) = x + y;
+    b(x, y) = x * 2 - y;
+    c(x, y) = x * y;
+    out(x, y) = a(x, y) + b(x, y) + c(x, y);
+
+    a.compute_root();
+    b.compute_root();
+    c.compute_root();
+
+    CountForks *counter = new CountForks;
+    out.add_custom_lowering_pass(counter);
+    Buffer<int> result = out.realize(64, 64, t);
+
+    for (int y = 0; y < result.height(); y++) {
+        for (int x = 0; x < result.width(); x++) {
+            int correct = (x + y) + (x * 2 - y) + x * y;
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // a and b are each followed by a branch that doesn't consume
+    // them, so they run concurrently with it. c is followed by its
+    // consumer, so there is nothing for it to overlap with.
+    if (counter->count != 2) {
+        printf("Expected 2 forks, got %d\n", counter->count);
+        return -1;
+    }
+
+    // A chain of compute_root Funcs has nothing to run concurrently.
+    {
+        Func f, g, h;
+        f(x) = x;
+        g(x) = f(x) + 1;
+        h(x) = g(x) * 2;
+        f.compute_root();
+        g.compute_root();
+
+        CountForks *counter = new CountForks;
+        h.add_custom_lowering_pass(counter);
+        Buffer<int> r = h.realize(16, t);
+        for (int x = 0; x < 16; x++) {
+            if (r(x) != (x + 1) * 2) {
+                printf("r(%d) = %d instead of %d\n", x, r(x), (x + 1) * 2);
+                return -1;
+            }
+        }
+        if (counter->count != 0) {
+            printf("Expected no forks for a chain, got %d\n", counter->count);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
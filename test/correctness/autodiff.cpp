@@ -1245,6 +1245,93 @@ void test_select_guard() {
     check(__LINE__, d_input_buf(1), -2.f + 0.5f - 0.5f + 1.f);
 }
 
+void test_checkpoints() {
+    Var x("x");
+    const int W = 16;
+    Buffer<float> input(W + 10);
+    for (int i = 0; i < input.width(); i++) {
+        input(i) = float(i) / W;
+    }
+    // A chain of nine stencils.
+    std::vector<Func> chain;
+    Func prev = lambda(x, input(x));
+    for (int i = 0; i < 9; i++) {
+        Func f("chain_" + std::to_string(i));
+        f(x) = sin(prev(x)) + prev(x + 1) * 0.5f;
+        chain.push_back(f);
+        prev = f;
+    }
+    Func loss("loss");
+    RDom r(0, W);
+    loss() += prev(r.x) * prev(r.x);
+    Derivative d = propagate_adjoints(loss);
+
+    // With everything inlined.
+    Buffer<float> inlined = d(input).realize(W + 9);
+
+    std::vector<Func> stored = schedule_checkpoints(loss);
+    // The lambda wrapping the input is one of the ten Funcs that can
+    // be recomputed.
+    _halide_user_assert(stored.size() == 3) << "Stored " << stored.size() << " Funcs\n";
+    for (const Func &f : stored) {
+        _halide_user_assert(f.function().schedule().compute_level().is_root())
+            << f.name() << " should be computed at root\n";
+    }
+    _halide_user_assert(chain[0].function().schedule().compute_level().is_inlined());
+    Buffer<float> checkpointed = d(input).realize(W + 9);
+    for (int i = 0; i < W + 9; i++) {
+        check(__LINE__, checkpointed(i), inlined(i), 1e-4f);
+    }
+
+    // Storing every Func gives the same result.
+    schedule_checkpoints(loss, chain);
+    Buffer<float> all_stored = d(input).realize(W + 9);
+    for (int i = 0; i < W + 9; i++) {
+        check(__LINE__, all_stored(i), inlined(i), 1e-4f);
+    }
+}
+
+void test_parallel_scatter() {
+    Var x("x");
+    const int W = 256, N = 16;
+    Buffer<float> input(N);
+    Buffer<int> index(W);
+    for (int i = 0; i < N; i++) {
+        input(i) = float(i);
+    }
+    for (int i = 0; i < W; i++) {
+        index(i) = (i * i) % N;
+    }
+    // A gather in the forward pass becomes a scatter in the adjoint.
+    Func gather("gather");
+    gather(x) = input(clamp(index(x), 0, N - 1));
+    Func loss("loss");
+    RDom r(0, W);
+    loss() += gather(r.x) * (r.x + 1.f);
+    Derivative d = propagate_adjoints(loss);
+
+    parallelize_scatters(d);
+    bool found_atomic = false;
+    for (const auto &it : d.adjoints) {
+        Function f = it.second.function();
+        for (const Definition &def : f.updates()) {
+            found_atomic |= def.schedule().atomic();
+        }
+    }
+    _halide_user_assert(found_atomic) << "Expected an atomic scatter in the adjoints\n";
+
+    Buffer<float> d_input = d(input).realize(N);
+    for (int i = 0; i < N; i++) {
+        float correct = 0.f;
+        for (int j = 0; j < W; j++) {
+            if (index(j) == i) {
+                correct += j + 1.f;
+            }
+        }
+        check(__LINE__, d_input(i), correct);
+    }
+}
+
 int main(int argc, char **argv) {
     test_scalar<float>();
     test_scalar<double>();
@@ -1280,6 +1367,8 @@ int main(int argc, char **argv) {
     test_rdom_predicate();
     test_reverse_scan();
     test_select_guard();
+    test_checkpoints();
+    test_parallel_scatter();
     printf("[autodiff] Success!\n");
     return 0;
 }
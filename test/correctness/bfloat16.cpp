@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <cmath>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Conversions in the frontend type round to nearest, ties to even.
+    if (bfloat16_t(1.0f).to_bits() != 0x3f80 ||
+        bfloat16_t(1.00390625f).to_bits() != 0x3f80 ||  // Tie, rounds down to even
+        bfloat16_t(1.01171875f).to_bits() != 0x3f82 ||  // Tie, rounds up to even
+        bfloat16_t(-2.0).to_bits() != 0xc000 ||
+        bfloat16_t(3.4e38f).to_bits() != 0x7f80 ||
+        !bfloat16_t(NAN).is_nan() ||
+        !bfloat16_t::make_infinity(false).is_negative()) {
+        printf("Incorrect bfloat16_t conversion\n");
+        return -1;
+    }
+
+    const int size = 1000;
+    Buffer<float> in_f32(size);
+    Buffer<bfloat16_t> in_bf16(size);
+    for (int i = 0; i < size; i++) {
+        // Use values that need rounding, and span a large range.
+        in_f32(i) = (i - size / 2) * 1.2345678f * std::pow(1.1f, (float)(i % 50));
+        in_bf16(i) = bfloat16_t(in_f32(i) * 0.5f);
+    }
+    in_f32(0) = NAN;
+    in_bf16(1) = bfloat16_t::make_nan();
+
+    Var x;
+    Func narrow, arith, widen;
+    narrow(x) = cast<bfloat16_t>(in_f32(x));
+    arith(x) = abs(in_bf16(x) * in_bf16(x) - in_bf16(x) / bfloat16_t(3.0f)) + bfloat16_t(1.0f);
+    widen(x) = cast<float>(in_bf16(x)) * 2.0f;
+
+    Target t = get_jit_target_from_environment();
+    if (t.has_gpu_feature()) {
+        Var xo, xi;
+        narrow.gpu_tile(x, xo, xi, 64);
+        arith.gpu_tile(x, xo, xi, 64);
+        widen.gpu_tile(x, xo, xi, 64);
+    } else {
+        narrow.vectorize(x, 16);
+        arith.vectorize(x, 16);
+        widen.vectorize(x, 16);
+    }
+
+    Buffer<bfloat16_t> narrow_out = narrow.realize(size);
+    Buffer<bfloat16_t> arith_out = arith.realize(size);
+    Buffer<float> widen_out = widen.realize(size);
+
+    for (int i = 0; i < size; i++) {
+        bfloat16_t correct = bfloat16_t(in_f32(i));
+        if (narrow_out(i).to_bits() != correct.to_bits() &&
+            !(narrow_out(i).is_nan() && correct.is_nan())) {
+            printf("narrow(%d) = %x instead of %x\n", i, narrow_out(i).to_bits(), correct.to_bits());
+            return -1;
+        }
+
+        bfloat16_t a = in_bf16(i);
+        bfloat16_t d = bfloat16_t((float)a / 3.0f);
+        bfloat16_t diff = a * a - d;
+        correct = bfloat16_t(std::abs((float)diff)) + bfloat16_t(1.0f);
+        if (arith_out(i).to_bits() != correct.to_bits() &&
+            !(arith_out(i).is_nan() && correct.is_nan())) {
+            printf("arith(%d) = %f instead of %f\n", i, (float)arith_out(i), (float)correct);
+            return -1;
+        }
+
+        float correct_f32 = (float)in_bf16(i) * 2.0f;
+        if (widen_out(i) != correct_f32 && !(std::isnan(widen_out(i)) && std::isnan(correct_f32))) {
+            printf("widen(%d) = %f instead of %f\n", i, widen_out(i), correct_f32);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -220,6 +220,12 @@ bool test_all(int vector_width, Target t) {
             repeat_edge(input),
             test_min, test_extent, test_min, test_extent,
             vector_width, t);
+        // Materialized into a padded buffer.
+        success &= check_repeat_edge(
+            input,
+            padded(repeat_edge(input_f, 0, W, 0, H)),
+            test_min, test_extent, test_min, test_extent,
+            vector_width, t);
     }
 
     // constant_exterior:
@@ -258,6 +264,12 @@ bool test_all(int vector_width, Target t) {
             constant_exterior(input, exterior),
             test_min, test_extent, test_min, test_extent,
             vector_width, t);
+        // Materialized into a padded buffer.
+        success &= check_constant_exterior(
+            input, exterior,
+            padded(constant_exterior(input_f, exterior, 0, W, 0, H)),
+            test_min, test_extent, test_min, test_extent,
+            vector_width, t);
     }
 
     // repeat_image:
@@ -381,6 +393,12 @@ int main(int argc, char **argv) {
         target.has_feature(Target::D3D12Compute)) {
         // https://github.com/halide/Halide/issues/2148
         vector_width_max = 4;
+    } else if (target.has_feature(Target::Vulkan)) {
+        // SPIR-V vectors have at most four lanes.
+        vector_width_max = 4;
+    } else if (target.has_feature(Target::WebGPU)) {
+        // WebGPU kernels are scalar.
+        vector_width_max = 1;
     }
     for (int vector_width = 1; vector_width <= vector_width_max; vector_width *= 2) {
         std::cout << "Testing vector_width: " << vector_width << "\n";
@@ -0,0 +1,77 @@
+#include "Halide.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (t.arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT does not support profile_branches.\n");
+        return 0;
+    }
+
+#ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    return 0;
+#else
+    std::string profile = Internal::get_test_tmp_dir() + "branch_profile.txt";
+    Internal::ensure_no_file_exists(profile);
+    setenv("HL_BRANCH_PROFILE", profile.c_str(), 1);
+
+    // A reduction that only adds every fourth value, so its loop runs
+    // 100 times and its branch is taken a quarter of the time.
+    Param<int> n;
+    RDom r(0, n);
+    r.where(r % 4 == 0);
+    Func g("g");
+    g() = 0;
+    g() += r;
+
+    n.set(100);
+    Buffer<int> result = g.realize(t.with_feature(Target::ProfileBranches));
+    if (result() != 1200) {
+        printf("result() = %d instead of 1200\n", result());
+        return -1;
+    }
+
+    bool found_loop = false, found_branch = false;
+    std::ifstream file(profile);
+    std::string func;
+    int site;
+    uint64_t a, b;
+    while (file >> func >> site >> a >> b) {
+        if (func != "g") {
+            continue;
+        }
+        found_loop = found_loop || (a == 1 && b == 100);
+        found_branch = found_branch || (a == 25 && b == 75);
+    }
+    if (!found_loop || !found_branch) {
+        printf("Branch profile %s is missing the counts of the reduction\n", profile.c_str());
+        return -1;
+    }
+
+    // Compiling without the feature should now attach those counts to
+    // the branch. Turn off LLVM's vectorization of the loop, which
+    // would replace the branch.
+    std::string ll_file = Internal::get_test_tmp_dir() + "branch_profile.ll";
+    Internal::ensure_no_file_exists(ll_file);
+    g.compile_to_llvm_assembly(ll_file, {n}, "g",
+                               t.with_feature(Target::NoRuntime).with_feature(Target::DisableLLVMLoopVectorize));
+    std::ifstream ll(ll_file);
+    std::stringstream code;
+    code << ll.rdbuf();
+    if (code.str().find("!\"branch_weights\", i32 25, i32 75}") == std::string::npos &&
+        code.str().find("!\"branch_weights\", i32 75, i32 25}") == std::string::npos) {
+        printf("The branch weights from the profile were not used\n");
+        return -1;
+    }
+
+    unsetenv("HL_BRANCH_PROFILE");
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,82 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    ImageParam in(Int(32), 2, "in");
+    Param<int> offset("offset");
+    Var x("x"), y("y");
+
+    Func f("f");
+    f(x, y) = in(x + offset, y) * 2;
+    in.dim(0).set_min(0);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::CacheBoundsChecks);
+    f.compile_jit(t);
+    f.set_error_handler(my_error_handler);
+
+    Buffer<int> input(40, 20), small_input(30, 20);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y * 100; });
+    small_input.fill(0);
+
+    // Calls that are expected to succeed, with the same shapes each time
+    // except for the last, which changes a scalar parameter.
+    for (int i = 0; i < 3; i++) {
+        int off = i == 2 ? 8 : 4;
+        in.set(input);
+        offset.set(off);
+        error_occurred = false;
+        Buffer<int> out(32, 20);
+        f.realize(out);
+        if (error_occurred) {
+            printf("Error incorrectly raised on call %d\n", i);
+            return -1;
+        }
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = input(x + off, y) * 2;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Changing only the scalar parameter must run the checks again.
+    offset.set(16);
+    error_occurred = false;
+    f.realize(32, 20);
+    if (!error_occurred) {
+        printf("Error incorrectly not raised for a new offset\n");
+        return -1;
+    }
+
+    // As must changing the shape of an input.
+    in.set(small_input);
+    offset.set(4);
+    error_occurred = false;
+    f.realize(32, 20);
+    if (!error_occurred) {
+        printf("Error incorrectly not raised for a smaller input\n");
+        return -1;
+    }
+
+    // A failed check doesn't replace the last shapes that passed.
+    in.set(input);
+    error_occurred = false;
+    f.realize(32, 20);
+    if (error_occurred) {
+        printf("Error incorrectly raised after a failed call\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Counts the stack allocations made to hold carried values.
+class CountCarriedValues : public IRMutator {
+public:
+    int count = 0;
+
+    using IRMutator::mutate;
+
+    Stmt mutate(const Stmt &s) override {
+        class Counter : public IRVisitor {
+            using IRVisitor::visit;
+            void visit(const Allocate *op) override {
+                if (op->memory_type == MemoryType::Stack) {
+                    (*count)++;
+                }
+                IRVisitor::visit(op);
+            }
+        public:
+            int *count;
+        } counter;
+        counter.count = &count;
+        s.accept(&counter);
+        return s;
+    }
+};
+
+int test(bool vertical, bool carry) {
+    const int W = 256, H = 64;
+    Buffer<float> input(W + 2, H + 2);
+    input.set_min(-1, -1);
+    input.for_each_element([&](int x, int y) { input(x, y) = (float)((x * 17 + y * 31) % 101); });
+
+    Var x("x"), y("y"), xo("xo"), xi("xi");
+    Func f("f");
+    if (vertical) {
+        f(x, y) = input(x, y - 1) + input(x, y) * 2 + input(x, y + 1);
+        // Vectorize x, and walk down the columns of vectors, so that
+        // rows loaded on one iteration are reused on the next.
+        f.split(x, xo, xi, 8).reorder(xi, y, xo).vectorize(xi);
+    } else {
+        f(x, y) = input(x - 1, y) + input(x, y) * 2 + input(x + 1, y);
+        f.vectorize(x, 8);
+    }
+    if (carry) {
+        f.carry_loads();
+    }
+
+    CountCarriedValues *counter = new CountCarriedValues;
+    f.add_custom_lowering_pass(counter);
+    Buffer<float> out = f.realize(W, H);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            float correct = (vertical ?
+                             input(x, y - 1) + input(x, y) * 2 + input(x, y + 1) :
+                             input(x - 1, y) + input(x, y) * 2 + input(x + 1, y));
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %f instead of %f (vertical = %d, carry = %d)\n",
+                       x, y, out(x, y), correct, vertical, carry);
+                return -1;
+            }
+        }
+    }
+
+    Target target = get_jit_target_from_environment();
+    if (vertical && target.arch != Target::Hexagon && (counter->count > 0) != carry) {
+        printf("Expected %s values to be carried, but found %d carried values\n",
+               carry ? "some" : "no", counter->count);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    for (bool vertical : {true, false}) {
+        for (bool carry : {false, true}) {
+            if (test(vertical, carry) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1173,6 +1173,63 @@ int nested_compute_with_test() {
     return 0;
 }
 
+int rvar_fuse_test() {
+    const int W = 30, H = 40;
+    Buffer<int> in(W, H);
+    in.for_each_element([&](int x, int y) { in(x, y) = (x * 7 + y * 13) % 19; });
+
+    Buffer<int> f_im(W, H), g_im(W, H), h_im(W, H - 5);
+    Buffer<int> f_im_ref(W, H), g_im_ref(W, H), h_im_ref(W, H - 5);
+
+    for (int fused = 0; fused < 2; fused++) {
+        Var x("x"), y("y");
+        RVar ry("y");
+        RDom r(1, H - 1);
+        Func f("f"), g("g"), h("h");
+
+        f(x, y) = in(x, y) + 1;
+        f(x, y) += x;
+        // A scan down the columns, over a reduction domain that
+        // doesn't cover the whole of f.
+        g(x, y) = in(x, y);
+        g(x, r) = g(x, r - 1) + in(x, r);
+        h(x, y) = in(x, y + 2) * 2;
+
+        if (fused) {
+            // Share the pass over the rows of the input between all
+            // three Funcs. The RVar of the scan is renamed to line
+            // up with the y of the others.
+            g.update().rename(r, ry);
+            g.compute_with(f, y);
+            h.compute_with(f, y);
+            g.update().compute_with(f.update(), y);
+            Pipeline({f, g, h}).realize({f_im, g_im, h_im});
+        } else {
+            Pipeline({f, g, h}).realize({f_im_ref, g_im_ref, h_im_ref});
+        }
+    }
+
+    auto f_func = [f_im_ref](int x, int y) {
+        return f_im_ref(x, y);
+    };
+    if (check_image(f_im, f_func)) {
+        return -1;
+    }
+    auto g_func = [g_im_ref](int x, int y) {
+        return g_im_ref(x, y);
+    };
+    if (check_image(g_im, g_func)) {
+        return -1;
+    }
+    auto h_func = [h_im_ref](int x, int y) {
+        return h_im_ref(x, y);
+    };
+    if (check_image(h_im, h_func)) {
+        return -1;
+    }
+    return 0;
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -1256,6 +1313,11 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    printf("Running rvar fuse test\n");
+    if (rvar_fuse_test() != 0) {
+        return -1;
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <memory>
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the outermost GPU block loop, which is what gets compiled into
+// a kernel.
+class FindKernel : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (!kernel.defined() && CodeGen_GPU_Dev::is_gpu_var(op->name)) {
+            kernel = op;
+            return;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    Stmt kernel;
+};
+
+int main(int argc, char **argv) {
+    Target t = get_host_target().with_feature(Target::CUDA).with_feature(Target::CUDACapability80);
+    if (!t.supported()) {
+        printf("CUDA is not enabled in this build of Halide, skipping test\n");
+        return 0;
+    }
+
+    // Stage the input in shared memory, and read it back from other
+    // threads.
+    ImageParam in(Float(32), 1, "in");
+    Func staged("staged"), out("out");
+    Var x("x"), xo("xo"), xi("xi");
+    staged(x) = in(x);
+    out(x) = staged(x) + staged(x + 1);
+    out.gpu_tile(x, xo, xi, 64);
+    staged.compute_at(out, xo).gpu_threads(x);
+
+    // Only the PTX is inspected, so this doesn't need a GPU.
+    Module m = out.compile_to_module({in}, "cuda_cp_async", t);
+    FindKernel finder;
+    for (const LoweredFunc &fn : m.functions()) {
+        fn.body.accept(&finder);
+    }
+    const For *loop = finder.kernel.as<For>();
+    if (!loop || loop->device_api != DeviceAPI::CUDA) {
+        printf("No CUDA kernel was found in the lowered code\n");
+        return -1;
+    }
+
+    // The GPU host drives the PTX backend through this interface.
+    std::unique_ptr<CodeGen_GPU_Dev> codegen(new CodeGen_PTX_Dev(t));
+    codegen->init_module();
+    HostClosure closure(loop->body, loop->name);
+    codegen->add_kernel(loop, "cuda_cp_async_kernel", closure.arguments());
+    std::vector<char> buf = codegen->compile_to_src();
+    std::string ptx(buf.begin(), buf.end());
+
+    if (ptx.find(".target sm_80") == std::string::npos) {
+        printf("PTX does not target sm_80:\n%s\n", ptx.c_str());
+        return -1;
+    }
+
+    // The copy into shared memory is asynchronous, and waited for
+    // before the barrier that makes it visible to the other threads.
+    size_t copy = ptx.find("cp.async.ca.shared.global");
+    size_t wait = ptx.find("cp.async.wait_all");
+    size_t barrier = ptx.find("bar.sync");
+    if (copy == std::string::npos || wait == std::string::npos || barrier == std::string::npos ||
+        !(copy < wait && wait < barrier)) {
+        printf("Expected cp.async, then cp.async.wait_all, then a barrier in:\n%s\n", ptx.c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
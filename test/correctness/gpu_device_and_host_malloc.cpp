@@ -0,0 +1,60 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target t(get_jit_target_from_environment());
+    if (!t.has_gpu_feature()) {
+        printf("Not running test because no gpu target enabled\n");
+        return 0;
+    }
+
+    const halide_device_interface_t *interface =
+        get_device_interface_for_device_api(DeviceAPI::Default_GPU, t);
+
+    // Buffers whose host and device allocations are made together. On
+    // some devices these share memory, so copies between them only
+    // synchronize.
+    const int W = 64, H = 64;
+    Buffer<int> in(nullptr, W, H), out(nullptr, W, H);
+    if (in.device_and_host_malloc(interface) != 0 ||
+        out.device_and_host_malloc(interface) != 0) {
+        printf("device_and_host_malloc failed\n");
+        return -1;
+    }
+
+    ImageParam p(Int(32), 2);
+    Func f;
+    Var x, y, xi, yi;
+    f(x, y) = p(x, y) * 2 + 1;
+    f.gpu_tile(x, y, xi, yi, 8, 8);
+    f.compile_jit(t);
+    p.set(in);
+
+    // Run it twice, changing the input on the host in between, to
+    // check that the host and device stay consistent in both
+    // directions.
+    for (int i = 0; i < 2; i++) {
+        in.for_each_element([&](int x, int y) { in(x, y) = x + y * W + i; });
+        in.set_host_dirty();
+        f.realize(out);
+        out.copy_to_host();
+
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                int correct = (x + y * W + i) * 2 + 1;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    in.device_and_host_free(interface);
+    out.device_and_host_free(interface);
+
+    printf("Success!\n");
+    return 0;
+}
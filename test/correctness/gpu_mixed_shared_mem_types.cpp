@@ -37,7 +37,8 @@ int main(int argc, char **argv) {
 
     Type result_type;
     if (t.has_feature(Target::Metal) ||
-        t.has_feature(Target::D3D12Compute)) {
+        t.has_feature(Target::D3D12Compute) ||
+        t.has_feature(Target::WebGPU)) {
         result_type = UInt(32);
     } else {
         result_type = UInt(64);
@@ -49,9 +50,10 @@ int main(int argc, char **argv) {
         int off = 0;
         if ((types[i].is_int() || types[i].is_uint())) {
             // Metal does not support 64-bit integers.
-            // neither does D3D12 under SM 5.1.
+            // neither does D3D12 under SM 5.1, or WebGPU.
             if ((t.supports_device_api(DeviceAPI::Metal) ||
-                 t.supports_device_api(DeviceAPI::D3D12Compute)) &&
+                 t.supports_device_api(DeviceAPI::D3D12Compute) ||
+                 t.supports_device_api(DeviceAPI::WebGPU)) &&
                 types[i].bits() >= 64) {
                 ++skipped_types;
                 continue;
@@ -76,7 +78,8 @@ int main(int argc, char **argv) {
 
     int result;
     if (t.has_feature(Target::Metal) ||
-        t.has_feature(Target::D3D12Compute)) {
+        t.has_feature(Target::D3D12Compute) ||
+        t.has_feature(Target::WebGPU)) {
         result = check_result<uint32_t>(output, n_types - skipped_types, offset);
     } else {
         result = check_result<uint64_t>(output, n_types, offset);
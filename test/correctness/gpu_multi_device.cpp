@@ -5,7 +5,7 @@ using namespace Halide;
 
 struct MultiDevicePipeline {
     Var x, y, c, xi, yi;
-    Func stage[5];
+    Func stage[8];
     size_t current_stage;
 
     MultiDevicePipeline(Func input) {
@@ -45,6 +45,18 @@ struct MultiDevicePipeline {
                 .gpu_tile(x, y, xi, yi, 8, 8, TailStrategy::Auto, DeviceAPI::OpenGLCompute);
             current_stage++;
         }
+        if (jit_target.has_feature(Target::Vulkan)) {
+            stage[current_stage](x, y, c) = stage[current_stage - 1](x, y, c) + 69;
+            stage[current_stage].compute_root().reorder(c, x, y)
+                .gpu_tile(x, y, xi, yi, 8, 8, TailStrategy::Auto, DeviceAPI::Vulkan);
+            current_stage++;
+        }
+        if (jit_target.has_feature(Target::WebGPU)) {
+            stage[current_stage](x, y, c) = stage[current_stage - 1](x, y, c) + 69;
+            stage[current_stage].compute_root().reorder(c, x, y)
+                .gpu_tile(x, y, xi, yi, 8, 8, TailStrategy::Auto, DeviceAPI::WebGPU);
+            current_stage++;
+        }
     }
 
     void run(Buffer<float> &result) {
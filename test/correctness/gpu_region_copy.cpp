@@ -0,0 +1,58 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (!target.has_gpu_feature()) {
+        printf("No GPU feature enabled in target. Skipping test\n");
+        return 0;
+    }
+
+    const int W = 256, H = 256;
+    const int crop_x = 100, crop_y = 200, crop_size = 16;
+
+    // A device-resident input whose host copy is stale.
+    Buffer<int> input(W, H);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y * W; });
+    input.set_host_dirty();
+    input.copy_to_device(target);
+    input.fill(-1);
+    input.set_host_dirty(false);
+    input.set_device_dirty();
+
+    // A host pipeline that reads a small crop of it.
+    ImageParam in(Int(32), 2);
+    Var x, y;
+    Func f;
+    f(x, y) = in(x + crop_x, y + crop_y) * 2;
+
+    in.set(input);
+    Buffer<int> result = f.realize(crop_size, crop_size, target);
+
+    for (int y = 0; y < crop_size; y++) {
+        for (int x = 0; x < crop_size; x++) {
+            int correct = ((x + crop_x) + (y + crop_y) * W) * 2;
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Only the rows of the input the pipeline read should have been
+    // copied back, so the input is still device dirty, and the rows
+    // before the crop are still stale on the host.
+    if (!input.device_dirty()) {
+        printf("Expected the input to still be device dirty\n");
+        return -1;
+    }
+    if (input(0, 0) != -1) {
+        printf("Expected the first row of the input not to be copied to the host\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (!t.has_gpu_feature()) {
+        printf("This is a GPU-specific test\n");
+        return 0;
+    }
+
+    const int W = 256, H = 128;
+    Buffer<float> input(H, W);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y * 1000.0f; });
+
+    // Transpose through shared memory.
+    {
+        ImageParam in(Float(32), 2);
+        Var x, y, xo, yo, xi, yi;
+        Func g;
+        g(x, y) = in(y, x);
+        g.gpu_tile(x, y, xo, yo, xi, yi, 32, 8);
+        in.stage_in_gpu_shared(g, xo);
+
+        in.set(input);
+        Buffer<float> out = g.realize(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (out(x, y) != input(y, x)) {
+                    printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), input(y, x));
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A stencil whose footprint is larger than the thread block, with
+    // a Func producer of a narrower type.
+    {
+        Var x, y, xo, yo, xi, yi;
+        Func f, g;
+        f(x, y) = cast<uint8_t>(x + y * 3);
+        g(x, y) = (cast<int>(f(x - 1, y - 1)) + f(x + 1, y) + f(x, y + 1) + f(x + 2, y + 2));
+        f.compute_root().gpu_tile(x, y, xo, yo, xi, yi, 16, 16);
+        g.gpu_tile(x, y, xo, yo, xi, yi, 16, 16);
+        f.stage_in_gpu_shared(g, xo);
+
+        Buffer<int> out = g.realize(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                auto fv = [](int x, int y) { return (int)(uint8_t)(x + y * 3); };
+                int correct = fv(x - 1, y - 1) + fv(x + 1, y) + fv(x, y + 1) + fv(x + 2, y + 2);
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
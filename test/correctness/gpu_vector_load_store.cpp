@@ -0,0 +1,72 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+// Check that dense vector loads and stores in GPU kernels are correct,
+// both when their alignment can be proven (and they become wide vector
+// accesses) and when it can't.
+template<typename T>
+int test(int lanes, int offset) {
+    Target t = get_jit_target_from_environment();
+
+    const int W = 256, H = 8;
+    Buffer<T> input(W + 16, H);
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            input(x, y) = (T)(x * 3 + y * 7);
+        }
+    }
+
+    ImageParam in(type_of<T>(), 2);
+    Var x, y, xo, xi;
+    Func f;
+    f(x, y) = in(x + offset, y) * 2 + in(x, y);
+    f.bound(x, 0, W)
+        .split(x, xo, xi, lanes, TailStrategy::RoundUp)
+        .gpu_blocks(y)
+        .gpu_threads(xo)
+        .vectorize(xi);
+
+    // Without this, nothing is known about the alignment of the input.
+    in.dim(0).set_min(0);
+    in.dim(1).set_stride(W + 16);
+
+    in.set(input);
+    Buffer<T> out = f.realize(W, H, t);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            T correct = (T)(input(x + offset, y) * 2 + input(x, y));
+            if (out(x, y) != correct) {
+                printf("lanes = %d, offset = %d: out(%d, %d) = %f instead of %f\n",
+                       lanes, offset, x, y, (double)out(x, y), (double)correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (!t.has_gpu_feature()) {
+        printf("This is a GPU-specific test\n");
+        return 0;
+    }
+
+    for (int lanes : {2, 4, 8, 16}) {
+        for (int offset : {0, 1, 4, 8}) {
+            if (test<float>(lanes, offset) != 0 ||
+                test<uint8_t>(lanes, offset) != 0 ||
+                test<int16_t>(lanes, offset) != 0) {
+                return -1;
+            }
+            if (t.supports_type(Float(64)) && test<double>(lanes, offset) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
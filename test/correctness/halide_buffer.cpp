@@ -399,6 +399,46 @@ int main(int argc, char **argv) {
         assert(b.dim(3).stride() == b2.dim(3).stride());
     }
 
+    {
+        // Check the fast paths for copy_from and fill. Copies between
+        // crops of dense buffers copy whole rows, copies between
+        // interleaved and planar buffers do not.
+        constexpr int W = 37, H = 19, C = 3;
+        Buffer<uint16_t> planar(W, H, C);
+        planar.fill([](int x, int y, int c) { return x + y * 64 + c * 4096; });
+        auto interleaved = Buffer<uint16_t>::make_interleaved(W, H, C);
+        interleaved.fill(0);
+        assert(interleaved.all_equal(0));
+        interleaved.copy_from(planar);
+        check_equal(interleaved, planar);
+
+        Buffer<uint16_t> planar2(W, H, C);
+        planar2.fill(0xabab);
+        assert(planar2.all_equal(0xabab));
+        planar2.copy_from(interleaved);
+        check_equal(planar2, planar);
+
+        Buffer<uint16_t> crop(W - 4, H - 2, C);
+        crop.set_min(2, 1);
+        crop.fill(7);
+        assert(crop.all_equal(7));
+        crop.copy_from(planar);
+        check_equal(crop, planar.cropped({{2, W - 4}, {1, H - 2}, {0, C}}));
+
+        // Filling a crop should not touch the rest of the buffer.
+        planar2.cropped(0, 1, W - 2).fill(0);
+        planar2.for_each_element([&](int x, int y, int c) {
+            uint16_t correct = (x == 0 || x == W - 1) ? planar(x, y, c) : 0;
+            assert(planar2(x, y, c) == correct);
+        });
+
+        // Zero-dimensional buffers
+        Buffer<float> s0 = Buffer<float>::make_scalar(), s1 = Buffer<float>::make_scalar();
+        s0() = 3.0f;
+        s1.copy_from(s0);
+        assert(s1() == 3.0f);
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,50 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+// Check that a Func offloaded to Hexagon can be computed async(), so
+// the CPU computes other Funcs while waiting for the DSP.
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (!target.features_any_of({Target::HVX_64, Target::HVX_128})) {
+        printf("Not running on HVX. Skipping test.\n");
+        return 0;
+    }
+    const int vector_size = target.has_feature(Target::HVX_128) ? 128 : 64;
+
+    const int W = 1024, H = 64;
+
+    for (int i = 0; i < 2; i++) {
+        Var x, y;
+        Func dsp, cpu, out;
+        dsp(x, y) = cast<uint8_t>(x + y);
+        cpu(x, y) = cast<uint8_t>(x * 2 - y);
+        out(x, y) = dsp(x, y) + cpu(x, y);
+
+        if (i == 0) {
+            // A whole stage on the DSP, an independent stage on the CPU.
+            dsp.compute_root().async().hexagon().vectorize(x, vector_size);
+            cpu.compute_root().vectorize(x, 16);
+        } else {
+            // Double-buffer rows of the DSP stage, each of which is a
+            // separate offload.
+            dsp.store_root().compute_at(out, y).fold_storage(y, 2).async()
+                .hexagon().vectorize(x, vector_size);
+            cpu.compute_at(out, y).vectorize(x, 16);
+        }
+
+        Buffer<uint8_t> result = out.realize(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                uint8_t correct = (uint8_t)(x + y) + (uint8_t)(x * 2 - y);
+                if (result(x, y) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the allocation of a Func and the async producers in the lowered
+// code.
+class FindPrefetch : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) override {
+        if (op->name == name) {
+            allocations++;
+            memory_type = op->memory_type;
+            extents = op->extents;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Fork *op) override {
+        forks++;
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::string name;
+    int allocations = 0, forks = 0;
+    MemoryType memory_type = MemoryType::Auto;
+    std::vector<Expr> extents;
+
+    FindPrefetch(const std::string &name) : name(name) {}
+};
+
+int main(int argc, char **argv) {
+    ImageParam input(UInt(8), 2, "input");
+    Func input_copy("input_copy"), output("output");
+    Var x("x"), y("y"), tx("tx"), ty("ty");
+
+    input_copy(x, y) = input(x, y);
+    output(x, y) = input_copy(x, y) * 2;
+    output.tile(x, y, tx, ty, x, y, 128, 32);
+    input_copy.hexagon_dma_prefetch(output, tx, ty, x, 128);
+
+    // Only the lowered code is inspected, so this doesn't need a
+    // Hexagon device or the DMA runtime.
+    Target t = get_host_target();
+    Module m = output.compile_to_module({input}, "hexagon_dma_prefetch", t);
+    FindPrefetch finder(input_copy.name());
+    for (const LoweredFunc &f : m.functions()) {
+        f.body.accept(&finder);
+    }
+
+    if (finder.allocations != 1) {
+        printf("Expected one allocation of %s, got %d\n", input_copy.name().c_str(), finder.allocations);
+        return -1;
+    }
+
+    if (finder.memory_type != MemoryType::LockedCache) {
+        printf("%s is not allocated in locked cache\n", input_copy.name().c_str());
+        return -1;
+    }
+
+    // The copy is stored at each row of tiles and folded over x, so it
+    // holds two tiles.
+    const int64_t *fold = finder.extents.empty() ? nullptr : as_const_int(finder.extents[0]);
+    if (!fold || *fold != 2 * 128) {
+        printf("Unexpected extents of %s:", input_copy.name().c_str());
+        for (const Expr &e : finder.extents) {
+            std::cout << " " << e;
+        }
+        printf("\n");
+        return -1;
+    }
+
+    // The copy of each tile runs in a separate thread.
+    if (finder.forks == 0) {
+        printf("The copy of %s is not async\n", input_copy.name().c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
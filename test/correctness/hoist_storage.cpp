@@ -0,0 +1,135 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+std::atomic<int> mallocs;
+std::atomic<int> frees;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    void *orig = malloc(x + 64);
+    void *ptr = (void *)((((size_t)orig + 64) >> 6) << 6);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    frees++;
+    free(((void **)ptr)[-1]);
+}
+
+int run(Func f, int rows, int expected_max_mallocs) {
+    mallocs = 0;
+    frees = 0;
+    f.set_custom_allocator(my_malloc, my_free);
+
+    // A large non-constant width keeps the intermediate on the heap.
+    Buffer<int> out(1000, rows);
+    f.realize(out);
+
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            int correct = 2 * x * y;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    if (mallocs != frees) {
+        printf("%d calls to malloc but %d calls to free\n", (int)mallocs, (int)frees);
+        return -1;
+    }
+
+    if (mallocs > expected_max_mallocs) {
+        printf("Expected at most %d calls to malloc, got %d\n", expected_max_mallocs, (int)mallocs);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+
+#ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    return 0;
+#else
+    // Bound the number of iterations that can run at once. The
+    // calling thread works alongside the thread pool.
+    const int rows = 256;
+    const int threads = 4;
+    setenv("HL_NUM_THREADS", "4", 1);
+    const int max_concurrency = threads + 1;
+
+    Var x, y;
+
+    {
+        // Without hoist_storage, every row allocates.
+        Func g, f;
+        g(x, y) = x * y;
+        f(x, y) = g(x - 1, y) + g(x + 1, y);
+        g.compute_at(f, y);
+        f.parallel(y);
+
+        if (run(f, rows, rows) != 0) {
+            return -1;
+        }
+        if (mallocs != rows) {
+            printf("Expected %d calls to malloc without hoist_storage, got %d\n", rows, (int)mallocs);
+            return -1;
+        }
+    }
+
+    {
+        // Hoisting to the root gives one block per worker, plus
+        // the pool itself.
+        Func g, f;
+        g(x, y) = x * y;
+        f(x, y) = g(x - 1, y) + g(x + 1, y);
+        g.compute_at(f, y).hoist_storage_root();
+        f.parallel(y);
+
+        if (run(f, rows, max_concurrency + 1) != 0) {
+            return -1;
+        }
+    }
+
+    {
+        // Hoisting to an outer parallel loop gives one pool and one
+        // block per iteration of that loop.
+        Func g, f;
+        Var yo, yi;
+        g(x, y) = x * y;
+        f(x, y) = g(x - 1, y) + g(x + 1, y);
+        f.split(y, yo, yi, 32).parallel(yo);
+        g.compute_at(f, yi).hoist_storage(f, yo);
+
+        if (run(f, rows, 2 * (rows / 32)) != 0) {
+            return -1;
+        }
+    }
+
+    {
+        // Tuple-valued Funcs get one pool shared by all their buffers.
+        Func g, f;
+        g(x, y) = Tuple(x * y, x * y * 3);
+        f(x, y) = g(x - 1, y)[0] + g(x + 1, y)[1] / 3;
+        g.compute_at(f, y).hoist_storage_root();
+        f.parallel(y);
+
+        if (run(f, rows, 2 * max_concurrency + 1) != 0) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
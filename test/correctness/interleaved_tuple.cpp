@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Record the names of the allocations in the lowered code, without
+// changing it.
+class FindAllocations : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const Allocate *op) override {
+        names.insert(op->name);
+        return IRMutator::visit(op);
+    }
+
+public:
+    std::set<std::string> names;
+};
+
+int main(int argc, char **argv) {
+    // Complex multiplication of a tuple-valued Func, whose consumer
+    // reads both elements at once.
+    Func z("z"), out("out");
+    Var x("x"), y("y");
+    z(x, y) = Tuple(cast<float>(x + y), cast<float>(x - y));
+    Expr re = z(x, y)[0], im = z(x, y)[1];
+    out(x, y) = re * re - im * im + 2 * re * im;
+
+    z.compute_at(out, y).vectorize(x, 8).store_tuple_interleaved();
+    out.vectorize(x, 8);
+
+    FindAllocations *finder = new FindAllocations;
+    out.add_custom_lowering_pass(finder);
+    Buffer<float> result = out.realize(64, 16);
+
+    for (int y = 0; y < result.height(); y++) {
+        for (int x = 0; x < result.width(); x++) {
+            float r = x + y, i = x - y;
+            float correct = r * r - i * i + 2 * r * i;
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %f instead of %f\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    if (!finder->names.count("z") || finder->names.count("z.0") || finder->names.count("z.1")) {
+        printf("Expected a single allocation for z\n");
+        return -1;
+    }
+
+    // Tuples of mixed types can't be interleaved, so this has no
+    // effect.
+    {
+        Func g("g"), h("h");
+        g(x) = Tuple(x, cast<float>(x) / 2);
+        h(x) = cast<float>(g(x)[0]) + g(x)[1];
+        g.compute_root().store_tuple_interleaved();
+
+        FindAllocations *finder = new FindAllocations;
+        h.add_custom_lowering_pass(finder);
+        Buffer<float> r = h.realize(32);
+        for (int x = 0; x < 32; x++) {
+            float correct = x + x / 2.0f;
+            if (r(x) != correct) {
+                printf("r(%d) = %f instead of %f\n", x, r(x), correct);
+                return -1;
+            }
+        }
+        if (!finder->names.count("g.0") || !finder->names.count("g.1")) {
+            printf("Expected one allocation per element of g\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "Halide.h"
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+using namespace Halide;
+
+int check(const Buffer<int> &out, const Buffer<int> &in, int offset) {
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            int correct = in(x, y) * 2 + offset;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Func f;
+    Var x, y;
+    Param<int> offset;
+    ImageParam input(Int(32), 2);
+
+    f(x, y) = input(x, y) * 2 + offset;
+    f.vectorize(x, 8, TailStrategy::GuardWithIf);
+
+    Buffer<int> in(64, 64);
+    in.for_each_element([&](int x, int y) { in(x, y) = x + y * 64; });
+    input.set(in);
+
+    Pipeline p(f);
+    p.set_auto_specialize(4);
+
+    // Call with the same shapes and values long enough for the
+    // specialization to be compiled in the background and used.
+    offset.set(3);
+    for (int i = 0; i < 50; i++) {
+        Buffer<int> out(32, 32);
+        p.realize(out);
+        if (check(out, in, 3)) {
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    // Other values must still get the generic code.
+    offset.set(5);
+    Buffer<int> out(48, 16);
+    p.realize(out);
+    if (check(out, in, 5)) {
+        return -1;
+    }
+
+    Buffer<int> transposed = in.transposed(0, 1);
+    input.set(transposed);
+    Buffer<int> out2(16, 16);
+    p.realize(out2);
+    if (check(out2, transposed, 5)) {
+        return -1;
+    }
+
+    // And the specialized values once more.
+    input.set(in);
+    offset.set(3);
+    Buffer<int> out3(32, 32);
+    p.realize(out3);
+    if (check(out3, in, 3)) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+using namespace Halide;
+
+int trace_events = 0;
+
+int my_trace(void *user_context, const halide_trace_event_t *e) {
+    trace_events++;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = x * 3 + y;
+
+    Pipeline p(f);
+    p.set_custom_trace(my_trace);
+
+    auto check = [&](const Buffer<int> &out) {
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                if (out(x, y) != x * 3 + y) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x * 3 + y);
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    if (!check(p.realize(64, 64))) return -1;
+    if (trace_events != 0) {
+        printf("The initial code traced %d events\n", trace_events);
+        return -1;
+    }
+
+    // Reschedule, and compile the replacement in the background. Calls
+    // to realize run the old code until it's ready.
+    f.vectorize(x, 4).parallel(y).trace_realizations();
+    p.compile_jit_in_background();
+    while (p.jit_replacement_pending()) {
+        if (!check(p.realize(64, 64))) return -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The replacement traces its realizations.
+    trace_events = 0;
+    if (!check(p.realize(64, 64))) return -1;
+    if (trace_events == 0) {
+        printf("The replacement was not switched to\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
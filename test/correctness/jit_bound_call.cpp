@@ -0,0 +1,55 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f;
+    Var x, y;
+    Param<int> offset;
+    ImageParam input(Int(32), 2);
+
+    f(x, y) = input(x, y) * 2 + offset;
+
+    Buffer<int> in(16, 16);
+    in.for_each_element([&](int x, int y) { in(x, y) = x + y * 16; });
+    input.set(in);
+
+    Buffer<int> out(16, 16);
+    Pipeline p(f);
+    JITBoundCall call = p.bind(out);
+
+    for (int i = 0; i < 5; i++) {
+        // Scalar params are bound by reference, so changes are seen
+        // by the next call.
+        offset.set(i);
+        call.run();
+
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = (x + y * 16) * 2 + i;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // The input buffer is bound by address, so mutating it in place is
+    // visible too.
+    in.fill(1);
+    offset.set(3);
+    call.run();
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            if (out(x, y) != 5) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), 5);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "Halide.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+using namespace Halide;
+
+int run_pipeline() {
+    Func f("jit_disk_cache_f");
+    Var x("x"), y("y");
+    f(x, y) = x * 3 + y;
+    f.vectorize(x, 8);
+
+    Buffer<int> im = f.realize(32, 16);
+    for (int y = 0; y < im.height(); y++) {
+        for (int x = 0; x < im.width(); x++) {
+            if (im(x, y) != x * 3 + y) {
+                printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), x * 3 + y);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+// The names of the objects in the cache directory.
+std::vector<std::string> cache_entries(const std::string &dir) {
+    std::vector<std::string> entries;
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return entries;
+    }
+    while (dirent *e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name.size() > 2 && name.substr(name.size() - 2) == ".o") {
+            entries.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+#endif
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    std::string dir = Internal::get_test_tmp_dir() + "jit_disk_cache";
+    setenv("HL_JIT_CACHE_DIR", dir.c_str(), 1);
+
+    // The cache is meant to be shared across processes, so each compile
+    // happens in a child process running the same code.
+    if (argc > 1 && std::string(argv[1]) == "child") {
+        return run_pipeline();
+    }
+    std::string child = std::string(argv[0]) + " child";
+
+    for (const std::string &e : cache_entries(dir)) {
+        remove(e.c_str());
+    }
+
+    // The first compile populates the cache.
+    if (system(child.c_str()) != 0) {
+        return -1;
+    }
+    std::vector<std::string> written = cache_entries(dir);
+    if (written.empty()) {
+        printf("No objects were written to %s\n", dir.c_str());
+        return -1;
+    }
+
+    // Backdate the entries, so that any that get written again can be
+    // told apart.
+    const time_t old_time = 1000000000;
+    for (const std::string &e : written) {
+        struct utimbuf times = {old_time, old_time};
+        if (utime(e.c_str(), &times) != 0) {
+            printf("Could not set the modification time of %s\n", e.c_str());
+            return -1;
+        }
+    }
+
+    // The second compile is served from the cache, so it writes
+    // nothing.
+    if (system(child.c_str()) != 0) {
+        return -1;
+    }
+    if (cache_entries(dir) != written) {
+        printf("The second compile added objects to %s\n", dir.c_str());
+        return -1;
+    }
+    for (const std::string &e : written) {
+        struct stat s;
+        if (stat(e.c_str(), &s) != 0 || s.st_mtime != old_time) {
+            printf("The second compile missed the cache for %s\n", e.c_str());
+            return -1;
+        }
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment().with_feature(Target::LargeBuffers);
+
+    // A vectorized gather from a table, indexed by another input, so
+    // that the innermost loop computes vectors of 64-bit indices.
+    ImageParam table(Int(32), 2, "table");
+    ImageParam idx(UInt(8), 2, "idx");
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = table(table.dim(0).min() + idx(x, y) % 128, y % 4) * 2 + idx(x, y);
+    f.vectorize(x, 8);
+
+    Buffer<int> table_buf(256, 4);
+    table_buf.for_each_element([&](int x, int y) { table_buf(x, y) = x * 3 + y * 1000; });
+    Buffer<uint8_t> idx_buf(100, 20);
+    idx_buf.for_each_element([&](int x, int y) { idx_buf(x, y) = (uint8_t)(x * 17 + y * 31); });
+    idx.set(idx_buf);
+
+    // Also use a crop of the table that doesn't start at zero.
+    for (Buffer<int> tbl : {table_buf, table_buf.cropped(0, 100, 128)}) {
+        table.set(tbl);
+        Buffer<int> out = f.realize(96, 20, t);
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int i = idx_buf(x, y);
+                int correct = tbl(tbl.dim(0).min() + i % 128, y % 4) * 2 + i;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
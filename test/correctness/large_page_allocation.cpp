@@ -0,0 +1,35 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // The intermediate is 16MB, above the default threshold for
+    // serving allocations from large pages, and the smaller one is
+    // below it, so the pipeline mixes both kinds of allocation.
+    const int W = 4096, H = 1024;
+    Var x("x"), y("y");
+    Func big("big"), small("small"), out("out");
+    big(x, y) = x * 3 + y;
+    small(x, y) = x - y;
+    out(x, y) = big(x, y) + big(W - 1 - x, y) + small(x % 16, y % 16);
+
+    big.compute_root().parallel(y).vectorize(x, 8);
+    small.compute_root();
+
+    for (int i = 0; i < 3; i++) {
+        Buffer<int> result = out.realize(W, H);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int correct = (xx * 3 + yy) + ((W - 1 - xx) * 3 + yy) + (xx % 16 - yy % 16);
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
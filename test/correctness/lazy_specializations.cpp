@@ -0,0 +1,77 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Counts the number of times the pipeline is lowered.
+int lowerings = 0;
+
+class CountLowerings : public Internal::IRMutator {
+public:
+    using Internal::IRMutator::mutate;
+    Internal::Stmt mutate(const Internal::Stmt &s) override {
+        lowerings++;
+        return s;
+    }
+};
+
+int main(int argc, char **argv) {
+    Func f("f");
+    Var x("x"), y("y");
+    Param<int> mode("mode");
+    ImageParam input(Int(32), 2, "input");
+
+    f(x, y) = input(x, y) * 2 + mode;
+    f.specialize(mode == 1).vectorize(x, 4);
+    f.specialize(mode == 2).parallel(y);
+    f.specialize(input.width() >= 128).vectorize(x, 8);
+
+    Pipeline p(f);
+    p.add_custom_lowering_pass(new CountLowerings);
+    p.set_lazy_specializations(true);
+
+    Buffer<int> small(64, 16), large(128, 16);
+    for (Buffer<int> b : {small, large}) {
+        b.for_each_element([&](int x, int y) { b(x, y) = x + y * 1000; });
+    }
+
+    // The number of lowerings expected after each call.
+    struct Call {
+        int mode;
+        Buffer<int> in;
+        int lowerings;
+    } calls[] = {
+        {0, small, 1},  // The default code.
+        {0, small, 1},
+        {1, small, 2},  // Compiles the first specialization.
+        {1, small, 2},
+        {0, small, 2},
+        {2, small, 3},  // Compiles the second specialization.
+        {0, large, 4},  // Compiles the third specialization.
+        {1, large, 5},  // The first and third conditions hold.
+        {1, small, 5},
+        {0, large, 5},
+    };
+
+    for (const Call &c : calls) {
+        mode.set(c.mode);
+        input.set(c.in);
+        Buffer<int> out = p.realize(c.in.width(), c.in.height());
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = c.in(x, y) * 2 + c.mode;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+        if (lowerings != c.lowerings) {
+            printf("Lowered %d times instead of %d\n", lowerings, c.lowerings);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
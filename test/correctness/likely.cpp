@@ -125,6 +125,28 @@ int main(int argc, char **argv) {
         count_partitions(h, 5);
     }
 
+    // If the body of an outer loop is large, the top and bottom of
+    // the image share a single copy of the unsimplified code, so that
+    // code size doesn't grow as quickly with the number of
+    // dimensions. A large 2D stencil with a boundary condition then
+    // has 4 code paths.
+    {
+        Var y;
+        Func g;
+        g(x, y) = x + y;
+        g.compute_root();
+        Func clamped = BoundaryConditions::mirror_image(g, 0, 10, 0, 10);
+        Func h;
+        Expr e = 0;
+        for (int dy = -3; dy <= 3; dy++) {
+            for (int dx = -3; dx <= 3; dx++) {
+                e += clamped(x + dx, y + dy) * (dx + dy + 7);
+            }
+        }
+        h(x, y) = e;
+        count_partitions(h, 4);
+    }
+
     // If you split and also have a boundary condition, or have
     // multiple boundary conditions at play (e.g. because you're
     // blurring an inlined Func that uses a boundary condition), then
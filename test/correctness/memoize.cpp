@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "test/common/halide_test_dirs.h"
+
 using namespace Halide;
 
 #ifdef _WIN32
@@ -97,6 +99,11 @@ int main(int argc, char **argv) {
         assert(result2(0) == 42);
 
         assert(call_count == 1);
+
+        halide_memoization_cache_stats_t stats = Internal::JITSharedRuntime::memoization_cache_get_stats();
+        assert(stats.misses == 1);
+        assert(stats.hits == 1);
+        assert(stats.entries == 1);
     }
 
     {
@@ -397,6 +404,66 @@ int main(int argc, char **argv) {
         Internal::JITSharedRuntime::memoization_cache_set_size(0);
     }
 
+    {
+        // Test that a per-pipeline budget stops one pipeline from
+        // evicting the cached results of another.
+        Param<float> hot_val, cold_val;
+
+        Func hot_calls, cold_calls;
+        hot_calls.define_extern("count_calls_with_arg", {cast<uint8_t>(hot_val)}, UInt(8), 2);
+        cold_calls.define_extern("count_calls_with_arg", {cast<uint8_t>(cold_val)}, UInt(8), 2);
+        hot_calls.compute_root().memoize();
+        cold_calls.compute_root().memoize();
+
+        Var x, y;
+        Func hot("hot_pipeline"), cold("cold_pipeline");
+        hot(x, y) = hot_calls(x, y);
+        cold(x, y) = cold_calls(x, y);
+
+        Internal::JITSharedRuntime::memoization_cache_set_size(1000000);
+        Internal::JITSharedRuntime::memoization_cache_set_pipeline_budget("hot_pipeline", 100000);
+
+        cold_val.set(17.0f);
+        Buffer<uint8_t> cold1 = cold.realize(128, 128);
+
+        // Enough distinct results to overflow the whole cache many times over.
+        for (int v = 0; v < 200; v++) {
+            hot_val.set((float)v);
+            Buffer<uint8_t> hot_out = hot.realize(128, 128);
+            assert(hot_out(0, 0) == (uint8_t)v);
+        }
+
+        call_count_with_arg = 0;
+        Buffer<uint8_t> cold2 = cold.realize(128, 128);
+        assert(cold2(0, 0) == 17);
+        if (call_count_with_arg != 0) {
+            printf("Pipeline with a budget evicted another pipeline's cached result.\n");
+            return -1;
+        }
+
+        // The budget only has room for a few of the results. Walk back
+        // from the most recent one, which the last store could not
+        // evict, and count the results still cached.
+        int cached = 0;
+        for (int v = 199; v >= 0; v--) {
+            call_count_with_arg = 0;
+            hot_val.set((float)v);
+            Buffer<uint8_t> hot_out = hot.realize(128, 128);
+            assert(hot_out(0, 0) == (uint8_t)v);
+            if (call_count_with_arg == 0) {
+                cached++;
+            }
+        }
+        if (cached < 1 || cached * 128 * 128 > 100000) {
+            printf("%d results of the pipeline with a budget were cached.\n", cached);
+            return -1;
+        }
+
+        Internal::JITSharedRuntime::memoization_cache_set_pipeline_budget("hot_pipeline", 0);
+        // Return cache size to default.
+        Internal::JITSharedRuntime::memoization_cache_set_size(0);
+    }
+
     {
         // Test flushing entire cache with a single element larger than the cache
         Param<float> val;
@@ -616,6 +683,53 @@ int main(int argc, char **argv) {
 
     }
 
+    {
+        // Results found in the persistent store should be used
+        // without recomputing them after they are evicted from
+        // memory. This comes last, as the store can't be removed.
+        std::string store = Internal::get_test_tmp_dir() + "memoize_persistent_store.bin";
+        Internal::ensure_no_file_exists(store);
+        bool ok = Internal::JITSharedRuntime::memoization_cache_set_persistent_store(store, 1 << 20);
+        assert(ok);
+
+        call_count_with_arg = 0;
+        Param<uint8_t> val;
+        Func count_calls;
+        count_calls.define_extern("count_calls_with_arg", {val}, UInt(8), 2);
+
+        Func f;
+        Var x, y;
+        f(x, y) = count_calls(x, y);
+        count_calls.compute_root().memoize();
+
+        val.set(17);
+        Buffer<uint8_t> out1 = f.realize(64, 64);
+        assert(call_count_with_arg == 1);
+
+        // Evict everything from the in-memory cache.
+        Internal::JITSharedRuntime::memoization_cache_reset_stats();
+        Internal::JITSharedRuntime::memoization_cache_set_size(1);
+        Internal::JITSharedRuntime::memoization_cache_set_size(0);
+        halide_memoization_cache_stats_t stats = Internal::JITSharedRuntime::memoization_cache_get_stats();
+        assert(stats.evictions > 0);
+
+        Buffer<uint8_t> out2 = f.realize(64, 64);
+        for (int32_t i = 0; i < 64; i++) {
+            for (int32_t j = 0; j < 64; j++) {
+                assert(out1(i, j) == 17);
+                assert(out2(i, j) == 17);
+            }
+        }
+        assert(call_count_with_arg == 1);
+        stats = Internal::JITSharedRuntime::memoization_cache_get_stats();
+        assert(stats.persistent_hits == 1);
+
+        val.set(18);
+        Buffer<uint8_t> out3 = f.realize(64, 64);
+        assert(out3(0, 0) == 18);
+        assert(call_count_with_arg == 2);
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -554,10 +554,13 @@ int main(int argc, char **argv) {
     // Test multiplication
     std::vector<int> mul_vector_widths = { 1 };
     if (target.has_feature(Target::Metal) ||
-        target.has_feature(Target::D3D12Compute)) {
+        target.has_feature(Target::D3D12Compute) ||
+        target.has_feature(Target::Vulkan)) {
         for (int i = 2; i <= 4; i *= 2) {
             mul_vector_widths.push_back(i);
         }
+    } else if (target.has_feature(Target::WebGPU)) {
+        // WebGPU kernels are scalar.
     } else if (target.has_feature(Target::HVX_64)) {
         mul_vector_widths.push_back(64);
     } else if (target.has_feature(Target::HVX_128)) {
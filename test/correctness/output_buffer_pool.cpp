@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Param<int> k("k");
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = x + y * k;
+
+    Pipeline p(f);
+    p.set_output_buffer_pool_size(2);
+
+    auto check = [&](const Buffer<int> &out, int k_value) {
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                if (out(x, y) != x + y * k_value) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x + y * k_value);
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    const void *first_host = nullptr;
+    {
+        k.set(1);
+        Buffer<int> out = p.realize(64, 64);
+        if (!check(out, 1)) return -1;
+        first_host = out.data();
+    }
+
+    // The first output has been released, so it should be reused.
+    k.set(2);
+    Buffer<int> second = p.realize(64, 64);
+    if (!check(second, 2)) return -1;
+    if (second.data() != first_host) {
+        printf("A released output was not reused\n");
+        return -1;
+    }
+
+    // The second output is still held, so this one must be new.
+    k.set(3);
+    Buffer<int> third = p.realize(64, 64);
+    if (!check(third, 3) || !check(second, 2)) return -1;
+    if (third.data() == second.data()) {
+        printf("An output still in use was reused\n");
+        return -1;
+    }
+
+    // A crop keeps the memory in use too.
+    Buffer<int> crop = second.cropped(0, 8, 8);
+    second = Buffer<int>();
+    k.set(4);
+    Buffer<int> fourth = p.realize(64, 64);
+    if (!check(fourth, 4)) return -1;
+    if (fourth.data() == crop.data()) {
+        printf("An output still referred to by a crop was reused\n");
+        return -1;
+    }
+
+    // Outputs of a different size are never shared.
+    third = Buffer<int>();
+    Buffer<int> other = p.realize(32, 64);
+    if (!check(other, 4)) return -1;
+
+    printf("Success!\n");
+    return 0;
+}
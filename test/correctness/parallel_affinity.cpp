@@ -0,0 +1,107 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    // The thread pool reads this when it first starts up, so it must
+    // be set before anything is realized.
+    setenv("HL_THREAD_POOL_AFFINITY", "1", 1);
+
+    Var x, y, z;
+
+    // A chain of compute_root stages parallelized over the same rows,
+    // so each row of a consumer is handed to the worker that produced
+    // it, and one over a different extent.
+    {
+        Func f, g, h, out;
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) * 2 + f(x, y + 1);
+        h(x, y) = g(x, y) - 1;
+        out(x, y) = h(x, y) + h(x, y + 1);
+        f.compute_root().parallel(y);
+        g.compute_root().parallel(y);
+        h.compute_root().parallel(y);
+        out.parallel(y);
+
+        Buffer<int> im = out.realize(64, 1000);
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                auto g_ref = [&](int y) { return (x + y) * 2 + (x + y + 1); };
+                int correct = (g_ref(y) - 1) + (g_ref(y + 1) - 1);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Uneven work per iteration, so that workers must steal from each
+    // other's ranges.
+    {
+        Func f;
+        f(x, y) = x * y;
+        RDom r(0, 20);
+        Func g;
+        g(x, y) = 0;
+        g(x, y) += select(y % 7 == 0, f(x + r, y), 1);
+        g.parallel(y);
+
+        Buffer<int> im = g.realize(16, 1000);
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = 0;
+                for (int i = 0; i < 20; i++) {
+                    correct += (y % 7 == 0) ? (x + i) * y : 1;
+                }
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Nested parallelism, where the owners of the inner loops are
+    // themselves workers.
+    {
+        Func f;
+        f(x, y, z) = x * y + z * 3 + 1;
+        f.parallel(x).parallel(y).parallel(z);
+
+        Buffer<int> im = f.realize(64, 64, 64);
+        for (int z = 0; z < 64; z++) {
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < 64; x++) {
+                    if (im(x, y, z) != x * y + z * 3 + 1) {
+                        printf("im(%d, %d, %d) = %d\n", x, y, z, im(x, y, z));
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Parallel loops with fewer iterations than there are workers.
+    for (int extent = 1; extent < 100; extent += 13) {
+        Func f;
+        f(x) = x * 2;
+        f.parallel(x);
+        Buffer<int> im = f.realize(extent);
+        for (int x = 0; x < extent; x++) {
+            if (im(x) != x * 2) {
+                printf("im(%d) = %d\n", x, im(x));
+                return -1;
+            }
+        }
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+const int rows = 256;
+
+// The cpu each row of the pipeline below ran on, or -1 if unknown.
+int row_cpu[rows];
+
+extern "C" DLLEXPORT int record_cpu(int y) {
+    // Enough work per row that all of the workers get involved.
+    float f = 3.0f;
+    for (int i = 0; i < (1 << 10); i++) {
+        f = sqrtf(sinf(cosf(f)));
+    }
+#ifdef __linux__
+    row_cpu[y] = sched_getcpu();
+#else
+    row_cpu[y] = -1;
+#endif
+    return f < 0 ? 0 : y;
+}
+HalideExtern_1(int, record_cpu, int);
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    // The thread pool reads this when it first starts up, so it must
+    // be set before anything is realized.
+    setenv("HL_NUMA_NODES", "2", 1);
+
+    // Node assignment can only be checked if the workers can be
+    // pinned to every cpu, and there are enough cpus for each node to
+    // have workers of its own.
+    bool check_nodes = false;
+    int cpus = 0;
+    #ifdef __linux__
+    cpu_set_t allowed;
+    cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus >= 4 &&
+        sched_getaffinity(0, sizeof(allowed), &allowed) == 0 &&
+        CPU_COUNT(&allowed) == cpus &&
+        getenv("HL_NUM_THREADS") == nullptr &&
+        getenv("HL_THREAD_POOL_WORK_STEALING") == nullptr) {
+        // The pool leaves cpu zero for the thread calling into the
+        // pipeline, and treats that thread as being on the first
+        // node, so pin it there too.
+        cpu_set_t first;
+        CPU_ZERO(&first);
+        CPU_SET(0, &first);
+        check_nodes = sched_setaffinity(0, sizeof(first), &first) == 0;
+    }
+    #endif
+
+    Var x, y;
+
+    // A producer and a consumer parallelized over the same rows.
+    Func f, g;
+    f(x, y) = record_cpu(y) + x;
+    g(x, y) = f(x, y) * 2;
+    f.compute_root().parallel(y);
+    g.parallel(y);
+
+    // The first run spawns the pinned workers.
+    for (int run = 0; run < 2; run++) {
+        Buffer<int> im = g.realize(16, rows);
+        for (int yy = 0; yy < rows; yy++) {
+            for (int xx = 0; xx < 16; xx++) {
+                if (im(xx, yy) != (xx + yy) * 2) {
+                    printf("im(%d, %d) = %d instead of %d\n", xx, yy, im(xx, yy), (xx + yy) * 2);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    if (check_nodes) {
+        // The rows are split into one range per worker, and the first
+        // half of the ranges go to the first node. The node of a cpu is
+        // its position in the cpus, split evenly in order of cpu id.
+        // Workers only run ranges of the other node once they run out
+        // of their own, so most rows should run on their own node.
+        int local = 0;
+        for (int yy = 0; yy < rows; yy++) {
+            int node_of_row = (yy * 2) / rows;
+            int node_of_cpu = (row_cpu[yy] * 2) / cpus;
+            if (row_cpu[yy] < 0 || row_cpu[yy] >= cpus) {
+                printf("Row %d ran on unknown cpu %d\n", yy, row_cpu[yy]);
+                return -1;
+            }
+            if (node_of_row == node_of_cpu) {
+                local++;
+            }
+        }
+        if (local * 2 <= rows) {
+            printf("Only %d of %d rows ran on their own node\n", local, rows);
+            return -1;
+        }
+    } else {
+        printf("Not checking NUMA node assignment on this host\n");
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <tuple>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), ri("ri"), rb("rb");
+
+    Buffer<int> in(40, 1000);
+    in.for_each_element([&](int x, int y) {
+        in(x, y) = (x * 17 + y * 31) % 23 - 11;
+    });
+
+    // A cumulative sum down the columns of an image, computed in
+    // blocks that don't divide the extent.
+    {
+        Func f("f");
+        RDom r(1, 999);
+        f(x, y) = in(x, y);
+        f(x, r) = f(x, r - 1) + in(x, r);
+
+        Func blocks, totals;
+        std::tie(blocks, totals) = f.update().parallel_scan(r, 64, ri, rb);
+        blocks.vectorize(x, 8);
+        blocks.update().vectorize(x, 8);
+        f.update().parallel(r).vectorize(x, 8);
+
+        Buffer<int> out = f.realize(40, 1000);
+        for (int x = 0; x < 40; x++) {
+            int correct = 0;
+            for (int y = 0; y < 1000; y++) {
+                correct += in(x, y);
+                if (out(x, y) != correct) {
+                    printf("sum: out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A running max along a row, where the scan starts partway along
+    // and the blocks are a single element.
+    {
+        Func g("g");
+        RDom r(10, 27);
+        g(x) = x;
+        g(r) = max(g(r - 1), in(r, 5) * 3);
+        g.update().parallel_scan(r, 1, ri, rb);
+        g.update().vectorize(r, 4);
+
+        Buffer<int> out = g.realize(37);
+        int correct = 9;
+        for (int x = 0; x < 37; x++) {
+            if (x >= 10) {
+                correct = std::max(correct, in(x, 5) * 3);
+            }
+            int expected = x < 10 ? x : correct;
+            if (out(x) != expected) {
+                printf("max: out(%d) = %d instead of %d\n", x, out(x), expected);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
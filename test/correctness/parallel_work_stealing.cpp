@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    // The thread pool reads this when it first starts up, so it must
+    // be set before anything is realized.
+    setenv("HL_THREAD_POOL_WORK_STEALING", "1", 1);
+
+    Var x, y, z;
+
+    // A simple parallel loop with uneven work per iteration, so that
+    // workers run out of iterations at different times and must steal.
+    {
+        Func f;
+        f(x, y) = x * y;
+        RDom r(0, 20);
+        Func g;
+        g(x, y) = 0;
+        g(x, y) += select(y % 7 == 0, f(x + r, y), 1);
+        g.parallel(y);
+
+        Buffer<int> im = g.realize(16, 1000);
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = 0;
+                for (int i = 0; i < 20; i++) {
+                    correct += (y % 7 == 0) ? (x + i) * y : 1;
+                }
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Nested parallelism.
+    {
+        Func f;
+        f(x, y, z) = x * y + z * 3 + 1;
+        f.parallel(x).parallel(y).parallel(z);
+
+        Buffer<int> im = f.realize(64, 64, 64);
+        for (int z = 0; z < 64; z++) {
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < 64; x++) {
+                    if (im(x, y, z) != x * y + z * 3 + 1) {
+                        printf("im(%d, %d, %d) = %d\n", x, y, z, im(x, y, z));
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Parallel loops with small and odd extents.
+    for (int extent = 1; extent < 100; extent += 13) {
+        Func f;
+        f(x) = x * 2;
+        f.parallel(x);
+        Buffer<int> im = f.realize(extent);
+        for (int x = 0; x < extent; x++) {
+            if (im(x) != x * 2) {
+                printf("im(%d) = %d\n", x, im(x));
+                return -1;
+            }
+        }
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
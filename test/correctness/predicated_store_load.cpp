@@ -47,9 +47,12 @@ class CheckPredicatedStoreLoad : public IRMutator {
 public:
     CheckPredicatedStoreLoad(const Target &target, int store, int load) :
         expected_store_count(store), expected_load_count(load) {
-        // TODO: disabling for now due to trunk LLVM breakage.
+        // Only AVX-512 targets predicate vector loads and stores on x86,
+        // due to LLVM breakage on the others.
         // See: https://github.com/halide/Halide/issues/3534
-        if (target.arch == Target::X86) {
+        if (target.arch == Target::X86 &&
+            !target.features_any_of({Target::AVX512, Target::AVX512_KNL,
+                                     Target::AVX512_Skylake, Target::AVX512_Cannonlake})) {
             expected_store_count = 0;
             expected_load_count = 0;
         }
@@ -159,6 +159,52 @@ int test4(const Target &t) {
     return 0;
 }
 
+vector<vector<Expr>> collect_prefetches(const Func &f, Expr offset, int memory_latency) {
+    Func h("h");
+    Var x("x");
+    h(x) = f(x) * 2;
+    if (offset.defined()) {
+        h.prefetch(f, x, offset);
+    } else {
+        MachineParams params = MachineParams::generic();
+        params.memory_latency = memory_latency;
+        h.prefetch(f, x, params);
+    }
+
+    Module m = h.compile_to_module({});
+    CollectPrefetches collect;
+    m.functions()[0].body.accept(&collect);
+    return collect.prefetches;
+}
+
+int test5(const Target &t) {
+    Func f("f");
+    Var x("x");
+
+    f(x) = x;
+    f.compute_root();
+
+    // A memory latency shorter than one iteration prefetches the next
+    // iteration.
+    vector<vector<Expr>> expected = collect_prefetches(f, 1, 0);
+    vector<vector<Expr>> result = collect_prefetches(f, Expr(), 1);
+    if (!check(expected, result)) {
+        return -1;
+    }
+
+    // A long memory latency prefetches further ahead.
+    result = collect_prefetches(f, Expr(), 10000);
+    if (result.size() != 1 || expected.size() != 1) {
+        std::cout << "Expected one prefetch\n";
+        return -1;
+    }
+    if (equal(result[0][1], expected[0][1])) {
+        std::cout << "Expected prefetch of f further ahead than " << expected[0][1] << "\n";
+        return -1;
+    }
+    return 0;
+}
+
 }  // anonymous namespace
 
 int main(int argc, char **argv) {
@@ -180,6 +226,10 @@ int main(int argc, char **argv) {
     if (test4(t) != 0) {
         return -1;
     }
+    printf("Running prefetch test5\n");
+    if (test5(t) != 0) {
+        return -1;
+    }
 
     printf("Success!\n");
     return 0;
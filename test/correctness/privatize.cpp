@@ -0,0 +1,65 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), z("z"), u("u");
+
+    Buffer<uint8_t> in(123, 1001);
+    in.for_each_element([&](int x, int y) {
+        in(x, y) = (x * 17 + y * 31 + x * y) % 256;
+    });
+
+    // A histogram, with a number of copies that doesn't divide the
+    // number of rows.
+    {
+        Func hist("hist");
+        RDom r(0, in.width(), 0, in.height());
+        hist(x) = 0;
+        hist(in(r.x, r.y)) += 1;
+        hist.update().privatize(r.y, u, 7, 8);
+
+        Buffer<int> out = hist.realize(256);
+        int correct[256] = {0};
+        in.for_each_value([&](uint8_t v) { correct[v]++; });
+        for (int i = 0; i < 256; i++) {
+            if (out(i) != correct[i]) {
+                printf("hist(%d) = %d instead of %d\n", i, out(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    // Splatting into a coarse three-dimensional grid, as in the
+    // bilateral grid, without vectorization.
+    {
+        Func grid("grid");
+        RDom r(0, in.width(), 0, in.height());
+        Expr v = cast<int>(in(r.x, r.y));
+        grid(x, y, z) = 0;
+        grid(r.x / 8, r.y / 8, v / 32) += v;
+        grid.update().privatize(r.y, u, 16);
+
+        Buffer<int> out = grid.realize(16, 126, 8);
+        Buffer<int> correct(16, 126, 8);
+        correct.fill(0);
+        in.for_each_element([&](int x, int y) {
+            correct(x / 8, y / 8, in(x, y) / 32) += in(x, y);
+        });
+        for (int z = 0; z < 8; z++) {
+            for (int y = 0; y < 126; y++) {
+                for (int x = 0; x < 16; x++) {
+                    if (out(x, y, z) != correct(x, y, z)) {
+                        printf("grid(%d, %d, %d) = %d instead of %d\n",
+                               x, y, z, out(x, y, z), correct(x, y, z));
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
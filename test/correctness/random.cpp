@@ -141,6 +141,25 @@ int main(int argc, char **argv) {
 
     }
 
+    // The generator is counter-based, so the value at each site
+    // shouldn't depend on the schedule.
+    {
+        Func f;
+        f(x, y) = random_int();
+        Buffer<int> scalar = f.realize(256, 256);
+        f.vectorize(x, 8).parallel(y);
+        Buffer<int> vector = f.realize(256, 256);
+        for (int y = 0; y < 256; y++) {
+            for (int x = 0; x < 256; x++) {
+                if (scalar(x, y) != vector(x, y)) {
+                    printf("Vectorized random_int at (%d, %d) was %d instead of %d\n",
+                           x, y, vector(x, y), scalar(x, y));
+                    return -1;
+                }
+            }
+        }
+    }
+
     // Check independence and dependence.
     {
         // Make two random variables
@@ -0,0 +1,43 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f;
+    Var x, y;
+    Param<int> offset;
+    f(x, y) = x + y * 256 + offset;
+    f.parallel(y);
+
+    Pipeline p(f);
+
+    // Start a few realizations at once, each into its own buffer.
+    const int n = 4;
+    std::vector<Buffer<int>> outs;
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < n; i++) {
+        outs.emplace_back(256, 256);
+    }
+    offset.set(3);
+    for (int i = 0; i < n; i++) {
+        done.push_back(p.realize_async(outs[i]));
+    }
+
+    for (int i = 0; i < n; i++) {
+        done[i].get();
+        for (int y = 0; y < outs[i].height(); y++) {
+            for (int x = 0; x < outs[i].width(); x++) {
+                int correct = x + y * 256 + 3;
+                if (outs[i](x, y) != correct) {
+                    printf("outs[%d](%d, %d) = %d instead of %d\n",
+                           i, x, y, outs[i](x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
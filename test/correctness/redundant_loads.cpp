@@ -0,0 +1,72 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Count the loads from a buffer, and the stores to another.
+class CountLoadsAndStores : public IRMutator {
+    using IRMutator::visit;
+
+    std::string load_name, store_name;
+
+    Expr visit(const Load *op) override {
+        if (op->name == load_name) {
+            loads++;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const Store *op) override {
+        if (op->name == store_name) {
+            stores++;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    int loads = 0, stores = 0;
+    CountLoadsAndStores(const std::string &l, const std::string &s)
+        : load_name(l), store_name(s) {}
+};
+
+int main(int argc, char **argv) {
+    const int W = 64;
+    Buffer<int> input(W + 2, "input");
+    for (int x = 0; x < input.width(); x++) {
+        input(x) = x * 17 + 3;
+    }
+
+    // Both values of a Tuple load the same neighbourhood of the
+    // input. The second value should reuse the loads done by the
+    // first.
+    Var x("x");
+    Func h("h"), out("out");
+    h(x) = Tuple(input(x) + input(x + 2), input(x) * input(x + 2));
+    out(x) = h(x)[0] + h(x)[1];
+
+    h.compute_root().vectorize(x, 8);
+    out.bound(x, 0, W);
+
+    CountLoadsAndStores *counter = new CountLoadsAndStores("input", "h.0");
+    out.add_custom_lowering_pass(counter);
+    Buffer<int> result = out.realize(W);
+
+    if (counter->stores == 0 || counter->loads != 2 * counter->stores) {
+        printf("Expected two loads of the input per store to h, instead of %d loads for %d stores\n",
+               counter->loads, counter->stores);
+        return -1;
+    }
+
+    for (int x = 0; x < W; x++) {
+        int a = input(x), b = input(x + 2);
+        int correct = (a + b) + (a * b);
+        if (result(x) != correct) {
+            printf("result(%d) = %d instead of %d\n", x, result(x), correct);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
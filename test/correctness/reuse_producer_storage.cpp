@@ -0,0 +1,141 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+const int W = 300, H = 200;
+
+int big_mallocs = 0;
+
+void *my_malloc(void *user_context, size_t x) {
+    if (x >= W * H * sizeof(int)) {
+        big_mallocs++;
+    }
+    void *orig = malloc(x + 64);
+    void *ptr = (void *)((((size_t)orig + 64) >> 6) << 6);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    free(((void **)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+
+    Var x("x"), y("y");
+    Target target = get_jit_target_from_environment().with_feature(Target::ReuseProducerStorage);
+
+    // A pointwise chain of root Funcs, each read only by the next at
+    // the same coordinates. g and h should both be written in place
+    // over f, so there is a single large allocation. This is opt-in,
+    // so without the feature each Func gets its own.
+    for (int reuse = 0; reuse < 2; reuse++) {
+        Func f("f"), g("g"), h("h"), out("out");
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) * 2;
+        h(x, y) = g(x, y) + 1;
+        out(x, y) = h(x, y) + h(x + 1, y);
+
+        f.compute_root();
+        g.compute_root().vectorize(x, 8, TailStrategy::GuardWithIf);
+        h.compute_root().parallel(y);
+
+        out.set_custom_allocator(my_malloc, my_free);
+        big_mallocs = 0;
+        Buffer<int> result = out.realize(W, H, reuse ? target : get_jit_target_from_environment());
+
+        int expected = reuse ? 1 : 3;
+        if (big_mallocs != expected) {
+            printf("%d large allocations instead of %d\n", big_mallocs, expected);
+            return -1;
+        }
+
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int correct = ((xx + yy) * 2 + 1) + ((xx + 1 + yy) * 2 + 1);
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Consumers that can't overwrite their producer: g reads a
+    // neighbouring point, and h recomputes the last few points of each
+    // row because of a split that shifts inwards. With allocation
+    // sharing, h can still reuse the memory of f once f is dead, so
+    // there are two large allocations rather than one or three.
+    {
+        Func f("f"), g("g"), h("h"), out("out");
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) + f(x + 1, y);
+        h(x, y) = g(x, y) * 3;
+        out(x, y) = h(x, y) - 1;
+
+        f.compute_root();
+        g.compute_root();
+        h.compute_root().vectorize(x, 16, TailStrategy::ShiftInwards);
+
+        out.set_custom_allocator(my_malloc, my_free);
+        big_mallocs = 0;
+        Buffer<int> result = out.realize(W + 3, H, target.with_feature(Target::ShareAllocations));
+
+        if (big_mallocs != 2) {
+            printf("%d large allocations instead of 2\n", big_mallocs);
+            return -1;
+        }
+
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W + 3; xx++) {
+                int correct = ((xx + yy) + (xx + 1 + yy)) * 3 - 1;
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // The same goes for a split in a specialization, whichever way the
+    // specialization goes.
+    for (int vectorized = 0; vectorized < 2; vectorized++) {
+        Func f("f"), h("h"), out("out");
+        Param<bool> p;
+        f(x, y) = x + y;
+        h(x, y) = f(x, y) * 3;
+        out(x, y) = h(x, y) - 1;
+
+        f.compute_root();
+        h.compute_root();
+        h.specialize(p).vectorize(x, 16, TailStrategy::ShiftInwards);
+
+        p.set(vectorized != 0);
+        out.set_custom_allocator(my_malloc, my_free);
+        big_mallocs = 0;
+        Buffer<int> result = out.realize(W + 3, H, target);
+
+        if (big_mallocs != 2) {
+            printf("%d large allocations instead of 2\n", big_mallocs);
+            return -1;
+        }
+
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W + 3; xx++) {
+                int correct = (xx + yy) * 3 - 1;
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
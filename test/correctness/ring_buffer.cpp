@@ -0,0 +1,114 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Check that no store to or load from g computes a modulus.
+class CheckForMod : public IRMutator {
+    using IRMutator::visit;
+
+    bool in_index = false;
+
+    Expr visit(const Mod *op) override {
+        if (in_index) {
+            found = true;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Expr visit(const Load *op) override {
+        if (op->name == "g") {
+            in_index = true;
+            mutate(op->index);
+            in_index = false;
+        }
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const Store *op) override {
+        if (op->name == "g") {
+            in_index = true;
+            mutate(op->index);
+            in_index = false;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    bool found = false;
+};
+
+int run_test(bool async, bool use_ring_buffer) {
+    Func g("g"), f("f");
+    Var x, y;
+
+    g(x, y) = x * 3 + y;
+    f(x, y) = g(x, y - 1) + g(x, y) * 2 + g(x, y + 1);
+
+    // A fold factor of 3 isn't a power of two, so fold_storage would
+    // have to take every coordinate modulo 3.
+    g.compute_at(f, y).store_root();
+    if (use_ring_buffer) {
+        g.ring_buffer(y, 3);
+    } else {
+        g.fold_storage(y, 3);
+    }
+    if (async) {
+        g.async();
+    }
+
+    CheckForMod checker;
+    f.add_custom_lowering_pass(&checker, []() {});
+
+    Buffer<int> out = f.realize(32, 32);
+
+    if (use_ring_buffer && !async && checker.found) {
+        printf("Found a modulus in the addressing of g\n");
+        return -1;
+    }
+
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            int correct = 4 * (x * 3 + y);
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d (async = %d)\n",
+                       x, y, out(x, y), correct, async);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    for (bool async : {false, true}) {
+        for (bool use_ring_buffer : {false, true}) {
+            if (run_test(async, use_ring_buffer) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    // Folding backwards.
+    {
+        Func g("g"), f("f");
+        Var x, y;
+        g(x, y) = x - y;
+        f(x, y) = g(x, 31 - y) + g(x, 32 - y);
+        g.compute_at(f, y).store_root().ring_buffer(y, 2, false);
+        Buffer<int> out = f.realize(16, 32);
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = 2 * x - (31 - y) - (32 - y);
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
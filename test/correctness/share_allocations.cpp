@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+const int W = 100000;
+
+std::atomic<int> big_mallocs;
+
+void *my_malloc(void *user_context, size_t x) {
+    if (x >= W * sizeof(int)) {
+        big_mallocs++;
+    }
+    void *orig = malloc(x + 64);
+    void *ptr = (void *)((((size_t)orig + 64) >> 6) << 6);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    free(((void **)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+
+    // A chain of root Funcs, each of which is only used by the
+    // next. Only two of them are ever alive at once, so they should
+    // take turns in two blocks of memory rather than each getting
+    // their own.
+    const int stages = 8;
+    Var x;
+    std::vector<Func> chain(stages);
+    chain[0](x) = x;
+    for (int i = 1; i < stages; i++) {
+        chain[i](x) = chain[i - 1](x) + chain[i - 1](x + 1);
+        chain[i - 1].compute_root();
+    }
+
+    chain.back().set_custom_allocator(my_malloc, my_free);
+
+    // Sharing is opt-in, so without the feature each of the root Funcs
+    // gets its own block.
+    for (int share = 0; share < 2; share++) {
+        Target t = get_jit_target_from_environment();
+        int expected = stages - 1;
+        if (share) {
+            t = t.with_feature(Target::ShareAllocations);
+            expected = 2;
+        }
+
+        big_mallocs = 0;
+        Buffer<int> result = chain.back().realize(W, t);
+
+        if (big_mallocs != expected) {
+            printf("%d large calls to malloc instead of %d\n", (int)big_mallocs, expected);
+            return -1;
+        }
+
+        for (int xx = 0; xx < W; xx++) {
+            // chain[i](x) = sum_k C(i, k) * (x + k)
+            int correct = 0, binomial = 1;
+            for (int k = 0; k < stages; k++) {
+                correct += binomial * (xx + k);
+                binomial = binomial * (stages - 1 - k) / (k + 1);
+            }
+            if (result(xx) != correct) {
+                printf("result(%d) = %d instead of %d\n", xx, result(xx), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -48,6 +48,7 @@ size_t num_threads = Halide::Internal::ThreadPool<void>::num_processors_online()
 struct Test {
     bool use_avx2{false};
     bool use_avx512{false};
+    bool use_avx512_vnni{false};
     bool use_avx{false};
     bool use_power_arch_2_07{false};
     bool use_sse41{false};
@@ -89,6 +90,9 @@ struct Test {
         if (target.has_feature(Target::AVX512) && !use_avx512) {
             std::cerr << "Warning: This test is only configured for the skylake variant of avx512. Expect failures\n";
         }
+        use_avx512_vnni = (target.has_feature(Target::AVX512_VNNI) ||
+                           target.has_feature(Target::AVX512_BF16));
+        use_avx512 = use_avx512 || use_avx512_vnni;
         use_avx2 = use_avx512 || (target.has_feature(Target::AVX512) || target.has_feature(Target::AVX2));
         use_avx = use_avx2 || target.has_feature(Target::AVX);
         use_sse41 = use_avx || target.has_feature(Target::SSE41);
@@ -148,7 +152,8 @@ struct Test {
         // A bunch of feature flags also need to match between the
         // compiled code and the host in order to run the code.
         for (Target::Feature f : {Target::SSE41, Target::AVX,
-                    Target::AVX2, Target::AVX512,
+                    Target::AVX2, Target::AVX512, Target::AVX512_VNNI,
+                    Target::ARMDotProd, Target::ARMFp16,
                     Target::FMA, Target::FMA4, Target::F16C,
                     Target::VSX, Target::POWER_ARCH_2_07,
                     Target::ARMv7s, Target::NoNEON, Target::MinGW,
@@ -692,6 +697,26 @@ struct Test {
             check("vpmaxsq", 8, max(i64_1, i64_2));
             check("vpminsq", 8, min(i64_1, i64_2));
         }
+        if (use_avx512_vnni) {
+            Expr u8_4 = in_u8(x+48), i8_4 = in_i8(x+48);
+            for (int w : {4, 8, 16}) {
+                const char *suffix = w == 16 ? "*zmm" : w == 8 ? "*ymm" : "*xmm";
+                check(std::string("vpdpbusd") + suffix, w,
+                      i32_1 + i32(u8_1) * i32(i8_1) + i32(u8_2) * i32(i8_2) +
+                      i32(u8_3) * i32(i8_3) + i32(u8_4) * i32(i8_4));
+                check(std::string("vpdpbusd") + suffix, w,
+                      i32_1 + i32(u8_1) * 3 + i32(u8_2) * -5 + i32(u8_3) * 7);
+                check(std::string("vpdpwssd") + suffix, w,
+                      i32_1 + i32(i16_1) * i32(i16_2) + i32(i16_3) * i32(i16_1));
+            }
+        }
+        if (target.has_feature(Target::F16C)) {
+            // float16 math is done in float32, with vector conversions.
+            Expr f16_1 = cast(Float(16), f32_1), f16_2 = cast(Float(16), f32_2);
+            check("vcvtps2ph*ymm", 8, f16_1);
+            check("vcvtph2ps*ymm", 8, f32(f16_1) * 2.0f);
+            check("vaddps*ymm", 8, f16_1 + f16_2);
+        }
     }
 
     void check_neon_all() {
@@ -1471,6 +1496,29 @@ struct Test {
         // Interleave or deinterleave two vectors. Given that we use
         // interleaving loads and stores, it's hard to hit this op with
         // halide.
+
+        // ARMv8.2 extensions
+        if (target.has_feature(Target::ARMDotProd)) {
+            Expr u8_4 = in_u8(x+48), i8_4 = in_i8(x+48);
+            for (int w = 1; w <= 4; w++) {
+                // UDOT/SDOT  -  Dot Product
+                check("udot", 2*w, u32_1 + u32(u8_1) * u32(u8_2) + u32(u8_2) * u32(u8_3) +
+                      u32(u8_3) * u32(u8_4) + u32(u8_4) * u32(u8_1));
+                check("udot", 2*w, i32_1 + i32(u8_1) * 3 + i32(u8_2) * 5 + i32(u8_3) * 7);
+                check("sdot", 2*w, i32_1 + i32(i8_1) * i32(i8_2) + i32(i8_2) * i32(i8_3) +
+                      i32(i8_3) * i32(i8_4) + i32(i8_4) * i32(i8_1));
+            }
+        }
+        if (target.has_feature(Target::ARMFp16)) {
+            Expr f16_1 = cast(Float(16), f32_1), f16_2 = cast(Float(16), f32_2);
+            for (int w = 1; w <= 2; w++) {
+                const char *suffix = w == 1 ? ".4h" : ".8h";
+                check(string("fadd*") + suffix, 4*w, f16_1 + f16_2);
+                check(string("fsub*") + suffix, 4*w, f16_1 - f16_2);
+                check(string("fmul*") + suffix, 4*w, f16_1 * f16_2);
+                check(string("fmax*") + suffix, 4*w, max(f16_1, f16_2));
+            }
+        }
     }
 
     void check_hvx_all() {
@@ -1495,7 +1543,11 @@ struct Test {
         }
 
         int isa_version;
-        if (target.has_feature(Halide::Target::HVX_v66)) {
+        if (target.has_feature(Halide::Target::HVX_v69)) {
+            isa_version = 69;
+        } else if (target.has_feature(Halide::Target::HVX_v68)) {
+            isa_version = 68;
+        } else if (target.has_feature(Halide::Target::HVX_v66)) {
             isa_version = 66;
         } else if (target.has_feature(Halide::Target::HVX_v65)) {
             isa_version = 65;
@@ -2051,6 +2103,27 @@ check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*
         check("vnormamt(v*.h)", hvx_width/2, max(count_leading_zeros(i16_1), count_leading_zeros(~i16_1)));
         check("vnormamt(v*.w)", hvx_width/4, max(count_leading_zeros(i32_1), count_leading_zeros(~i32_1)));
         check("vpopcount(v*.h)", hvx_width/2, popcount(u16_1));
+
+        if (isa_version >= 68) {
+            Expr f16_1 = cast(Float(16), f32_1), f16_2 = cast(Float(16), f32_2);
+
+            check("v*.sf = vadd(v*.sf,v*.sf)", hvx_width/4, f32_1 + f32_2);
+            check("v*.sf = vsub(v*.sf,v*.sf)", hvx_width/4, f32_1 - f32_2);
+            check("v*.sf = vmpy(v*.sf,v*.sf)", hvx_width/4, f32_1 * f32_2);
+            check("v*.sf = vfmax(v*.sf,v*.sf)", hvx_width/4, max(f32_1, f32_2));
+            check("v*.sf = vfmin(v*.sf,v*.sf)", hvx_width/4, min(f32_1, f32_2));
+
+            check("v*.hf = vadd(v*.hf,v*.hf)", hvx_width/2, f16_1 + f16_2);
+            check("v*.hf = vsub(v*.hf,v*.hf)", hvx_width/2, f16_1 - f16_2);
+            check("v*.hf = vmpy(v*.hf,v*.hf)", hvx_width/2, f16_1 * f16_2);
+            check("v*.hf = vfmax(v*.hf,v*.hf)", hvx_width/2, max(f16_1, f16_2));
+            check("v*.hf = vfmin(v*.hf,v*.hf)", hvx_width/2, min(f16_1, f16_2));
+
+            check("v*:*.sf = vmpy(v*.hf,v*.hf)", hvx_width/2, f32(f16_1) * f32(f16_2));
+            check("v*:*.sf += vmpy(v*.hf,v*.hf)", hvx_width/2, f32_3 + f32(f16_1) * f32(f16_2));
+            check("v*:*.sf = vadd(v*.hf,v*.hf)", hvx_width/2, f32(f16_1) + f32(f16_2));
+            check("v*:*.sf = vsub(v*.hf,v*.hf)", hvx_width/2, f32(f16_1) - f32(f16_2));
+        }
     }
 
     void check_altivec_all() {
@@ -2123,6 +2196,41 @@ check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*
             check("vminfp", 4*w, min(f32_1, f32_2));
         }
 
+        Expr u8_4 = in_u8(x+48), i8_4 = in_i8(x+48);
+        for (int w = 1; w <= 4; w++) {
+            // Vector Integer Multiply Even/Odd Instructions
+            check("vmulesb", 16*w, i16(i8_1) * i16(i8_2));
+            check("vmulosb", 16*w, i16(i8_1) * i16(i8_2));
+            check("vmuleub", 16*w, u16(u8_1) * u16(u8_2));
+            check("vmuloub", 16*w, u16(u8_1) * u16(u8_2));
+            check("vmulesh", 8*w, i32(i16_1) * i32(i16_2));
+            check("vmulosh", 8*w, i32(i16_1) * i32(i16_2));
+            check("vmuleuh", 8*w, u32(u16_1) * u32(u16_2));
+            check("vmulouh", 8*w, u32(u16_1) * u32(u16_2));
+
+            // Vector Integer Multiply-Sum Instructions
+            check("vmsumubm", 4*w, u32_1 + u32(u8_1) * u32(u8_2) + u32(u8_2) * u32(u8_3) +
+                  u32(u8_3) * u32(u8_4) + u32(u8_4) * u32(u8_1));
+            check("vmsumubm", 4*w, i32_1 + i32(u8_1) * 3 + i32(u8_2) * 5 + i32(u8_3) * 7);
+            check("vmsummbm", 4*w, i32_1 + i32(i8_1) * i32(u8_2) + i32(i8_2) * i32(u8_3) +
+                  i32(i8_3) * i32(u8_4) + i32(i8_4) * i32(u8_1));
+            check("vmsumshm", 4*w, i32_1 + i32(i16_1) * i32(i16_2) + i32(i16_2) * i32(i16_3));
+            check("vmsumuhm", 4*w, u32_1 + u32(u16_1) * u32(u16_2) + u32(u16_2) * u32(u16_3));
+        }
+
+        // The saturating packs are only used on little-endian (64-bit) targets.
+        if (target.bits == 64) {
+            for (int w = 1; w <= 4; w++) {
+                // Vector Pack Saturate Instructions
+                check("vpkshss", 16*w, i8_sat(i16_1));
+                check("vpkshus", 16*w, u8_sat(i16_1));
+                check("vpkuhus", 16*w, u8_sat(u16_1));
+                check("vpkswss", 8*w, i16_sat(i32_1));
+                check("vpkswus", 8*w, u16_sat(i32_1));
+                check("vpkuwus", 8*w, u16_sat(u32_1));
+            }
+        }
+
         // Check these if target supports VSX.
         if (use_vsx) {
             for (int w = 1; w <= 4; w++) {
@@ -0,0 +1,85 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+int check(const Expr &a, const Expr &b) {
+    if (!equal(a, b)) {
+        std::cerr << "Simplified to " << a << " instead of " << b << "\n";
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    setenv("HL_SIMPLIFY_CACHE_SIZE", "4", 1);
+
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+
+    for (int i = 0; i < 3; i++) {
+        // Build a fresh copy each time, so that hits come from deep
+        // equality rather than pointer identity.
+        Expr e1 = (x + 3) - (x + 1) + y * 0;
+        if (check(simplify(e1), 2) != 0) {
+            return -1;
+        }
+
+        // An Expr that doesn't simplify must come back unchanged.
+        Expr e2 = x + y;
+        if (!simplify(e2).same_as(e2)) {
+            std::cerr << "simplify(x + y) should have returned its input\n";
+            return -1;
+        }
+
+        // The same Expr simplifies differently with different bounds.
+        Expr e3 = min(x, 10);
+        Scope<Interval> bounds;
+        if (check(simplify(e3, true, bounds), e3) != 0) {
+            return -1;
+        }
+        bounds.push("x", Interval(0, 5));
+        if (check(simplify(e3, true, bounds), x) != 0) {
+            return -1;
+        }
+        bounds.pop("x");
+        bounds.push("x", Interval(20, 30));
+        if (check(simplify(e3, true, bounds), 10) != 0) {
+            return -1;
+        }
+    }
+
+    // Overflow the cache's capacity a few times.
+    for (int i = 0; i < 20; i++) {
+        if (check(simplify(x + i - x), i) != 0) {
+            return -1;
+        }
+    }
+
+    // Make sure a real pipeline still compiles and runs correctly.
+    Func f;
+    Var u, v;
+    f(u, v) = u + v;
+    Func g;
+    g(u, v) = f(u - 1, v) + f(u + 1, v);
+    f.compute_at(g, v);
+    Buffer<int> im = g.realize(16, 16);
+    for (int v = 0; v < im.height(); v++) {
+        for (int u = 0; u < im.width(); u++) {
+            int correct = 2 * (u + v);
+            if (im(u, v) != correct) {
+                printf("im(%d, %d) = %d instead of %d\n", u, v, im(u, v), correct);
+                return -1;
+            }
+        }
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
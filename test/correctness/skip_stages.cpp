@@ -211,6 +211,37 @@ int main(int argc, char **argv) {
         check_counts(11);
     }
 
+    {
+        // A condition that varies within a tile of the consumer. The
+        // producer computed per tile should only be computed in the
+        // tiles where some iteration uses it.
+        Param<int> threshold;
+        Func f1, f2;
+        f1(x) = call_counter(x, 0);
+        f2(x) = select(x < threshold, f1(x), 0);
+
+        Var xo, xi;
+        f2.split(x, xo, xi, 5);
+        f1.compute_at(f2, xo);
+
+        f2.compile_jit();
+
+        reset_counts();
+        threshold.set(3);
+        f2.realize(20);
+        check_counts(5);
+
+        reset_counts();
+        threshold.set(12);
+        f2.realize(20);
+        check_counts(15);
+
+        reset_counts();
+        threshold.set(0);
+        f2.realize(20);
+        check_counts(0);
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,72 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+std::atomic<int> mallocs;
+std::atomic<int> frees;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    void *orig = malloc(x + 64);
+    void *ptr = (void *)((((size_t)orig + 64) >> 6) << 6);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    frees++;
+    free(((void **)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("Skipping test for WebAssembly as the wasm JIT cannot support set_custom_allocator().\n");
+        return 0;
+    }
+
+    // The size of g depends on the width of the output, so it isn't
+    // known at compile time.
+    Func g, f;
+    Var x, y;
+    g(x, y) = x * y;
+    f(x, y) = g(x - 1, y) + g(x + 1, y);
+    g.compute_at(f, y);
+    f.parallel(y);
+    f.set_custom_allocator(my_malloc, my_free);
+
+    const int rows = 64;
+    for (int width : {50, 1000}) {
+        mallocs = 0;
+        frees = 0;
+        Buffer<int> out(width, rows);
+        f.realize(out);
+
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = 2 * x * y;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // Small rows of g should use scratch space on the stack,
+        // and large ones should use the heap.
+        int expected_mallocs = width < 100 ? 0 : rows;
+        if (mallocs != expected_mallocs) {
+            printf("Expected %d calls to malloc for width %d, got %d\n",
+                   expected_mallocs, width, (int)mallocs);
+            return -1;
+        }
+        if (mallocs != frees) {
+            printf("%d calls to malloc but %d calls to free\n", (int)mallocs, (int)frees);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
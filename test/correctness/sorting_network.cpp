@@ -0,0 +1,64 @@
+#include "Halide.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), k("k");
+
+    const int width = 64, max_n = 49;
+    Buffer<int16_t> in(width, max_n);
+    in.for_each_element([&](int x, int y) {
+        // Lots of ties, and negative values.
+        in(x, y) = (int16_t)((x * 37 + y * 101 + x * y * 7) % 61 - 30);
+    });
+
+    for (int n : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 16, 17, 25, 49}) {
+        std::vector<Expr> values;
+        for (int i = 0; i < n; i++) {
+            values.push_back(in(x, i));
+        }
+
+        // Every output of the sort, and every possible selection.
+        std::vector<Expr> s = sorted(values);
+        Expr sort_result = s[0], select_result = kth_smallest(values, 0);
+        for (int i = 1; i < n; i++) {
+            sort_result = select(k == i, s[i], sort_result);
+            select_result = select(k == i, kth_smallest(values, i), select_result);
+        }
+        Func f("f");
+        f(x, k) = Tuple(sort_result, select_result, median(values));
+        f.vectorize(x, 16);
+
+        Realization r = f.realize(width, n);
+        Buffer<int16_t> sort_out = r[0], select_out = r[1], median_out = r[2];
+        for (int x = 0; x < width; x++) {
+            std::vector<int16_t> correct;
+            for (int i = 0; i < n; i++) {
+                correct.push_back(in(x, i));
+            }
+            std::sort(correct.begin(), correct.end());
+            for (int i = 0; i < n; i++) {
+                if (sort_out(x, i) != correct[i]) {
+                    printf("n = %d: sorted(%d, %d) = %d instead of %d\n",
+                           n, x, i, sort_out(x, i), correct[i]);
+                    return -1;
+                }
+                if (select_out(x, i) != correct[i]) {
+                    printf("n = %d: kth_smallest(%d, %d) = %d instead of %d\n",
+                           n, x, i, select_out(x, i), correct[i]);
+                    return -1;
+                }
+            }
+            if (median_out(x, 0) != correct[n / 2]) {
+                printf("n = %d: median(%d) = %d instead of %d\n",
+                       n, x, median_out(x, 0), correct[n / 2]);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
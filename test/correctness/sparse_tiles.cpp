@@ -0,0 +1,67 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+extern "C" DLLEXPORT int count_calls(int x) {
+    call_count++;
+    return x;
+}
+HalideExtern_1(int, count_calls, int);
+
+int main(int argc, char **argv) {
+    const int W = 64, H = 64, T = 16;
+
+    // The list of active tiles.
+    const int active[][2] = {{0, 0}, {1, 1}, {3, 2}};
+    const int num_active = 3;
+    Buffer<int> tiles(2, num_active);
+    for (int i = 0; i < num_active; i++) {
+        tiles(0, i) = active[i][0];
+        tiles(1, i) = active[i][1];
+    }
+
+    Var x, y;
+    Func expensive, dense, background;
+    expensive(x, y) = count_calls(x + y * W);
+    dense(x, y) = expensive(x, y) * 2 + expensive(x + 1, y);
+    background(x, y) = -1;
+
+    SparseTiles s = sparse_tiles(dense, background, tiles, num_active, T, T);
+    s.func.update().vectorize(s.x, 8);
+    expensive.compute_at(s.func, s.tile);
+
+    Buffer<int> result = s.func.realize(W, H);
+
+    // The expensive stage is only computed for the active tiles (and
+    // the one column past each that they need).
+    const int expected_calls = num_active * (T + 1) * T;
+    if (call_count != expected_calls) {
+        printf("expensive was called %d times instead of %d\n", call_count, expected_calls);
+        return -1;
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            bool is_active = false;
+            for (int i = 0; i < num_active; i++) {
+                is_active |= (x / T == active[i][0] && y / T == active[i][1]);
+            }
+            int correct = is_active ? (x + y * W) * 2 + (x + 1 + y * W) : -1;
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
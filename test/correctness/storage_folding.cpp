@@ -443,6 +443,40 @@ int main(int argc, char **argv) {
             });
     }
 
+    {
+        // Fold two dimensions over a single loop over fused
+        // tiles. The footprint jumps back at the start of each row
+        // of tiles, but each tile computes all of f that it uses, so
+        // both x and y are folded down to the footprint of one tile.
+        Func f, g;
+        Var xo, yo, xi, yi, t;
+        f(x, y) = x + y;
+        g(x, y) = f(x - 1, y - 1) + f(x + 1, y + 1);
+        g.tile(x, y, xo, yo, xi, yi, 16, 16).fuse(xo, yo, t);
+        f.store_root().compute_at(g, t);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        custom_malloc_size = 0;
+        Buffer<int> im = g.realize(128, 128);
+
+        size_t expected_size = 32*32*sizeof(int) + sizeof(int);
+        if (custom_malloc_size == 0 || custom_malloc_size != expected_size) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)expected_size);
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = 2 * (x + y);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
     // Now we check some error cases.
 
     {
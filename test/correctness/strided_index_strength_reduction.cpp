@@ -0,0 +1,50 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Walk several inputs down their columns, so that the innermost
+    // loop steps each of them by a stride only known at runtime.
+    const int num_inputs = 6;
+    std::vector<ImageParam> inputs;
+    std::vector<Buffer<int>> buffers;
+    Var x("x"), y("y");
+    Expr e = 0;
+    for (int i = 0; i < num_inputs; i++) {
+        inputs.emplace_back(Int(32), 2, "in" + std::to_string(i));
+        e += inputs.back()(x, y + i) * (i + 1);
+
+        // Give each input a different row stride.
+        Buffer<int> b(40 + i * 3, 64 + num_inputs + 5);
+        b.for_each_element([&](int x, int y) { b(x, y) = x * 7 + y * 13 + i; });
+        buffers.push_back(b.cropped(0, 0, 32));
+        inputs.back().set(buffers.back());
+    }
+
+    Func f("f");
+    f(x, y) = e;
+    f.reorder(y, x);
+
+    for (int min_y : {0, 5}) {
+        Buffer<int> out(32, 64);
+        out.set_min(0, min_y);
+        f.realize(out);
+
+        for (int x = 0; x < out.width(); x++) {
+            for (int y = min_y; y < min_y + out.height(); y++) {
+                int correct = 0;
+                for (int i = 0; i < num_inputs; i++) {
+                    correct += buffers[i](x, y + i) * (i + 1);
+                }
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x");
+
+    {
+        // A lookup table with an update definition can't be bounded by
+        // bounds inference, so promise the range of its values.
+        Func lut("lut");
+        RDom r(0, 256);
+        lut(x) = 0;
+        lut(r) = (r * 37) % 16;
+        lut.compute_root();
+        lut.value_bounds(0, 15);
+
+        ImageParam in(Int(32), 1, "in");
+        Func out("out");
+        out(x) = in(lut(x % 256));
+
+        Buffer<int> input(16);
+        input.for_each_element([&](int x) { input(x) = x * 3; });
+        in.set(input);
+
+        Buffer<int> result = out.realize(512);
+        for (int x = 0; x < result.width(); x++) {
+            int correct = (((x % 256) * 37) % 16) * 3;
+            if (result(x) != correct) {
+                printf("result(%d) = %d instead of %d\n", x, result(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // The condition of a select bounds the index in each branch.
+        ImageParam in(Int(32), 1, "in");
+        Func out("out");
+        out(x) = in(select(x < 5, x * 2, 9)) + in(select(x >= 4, 0, x * 3));
+
+        out.infer_input_bounds(32);
+        Buffer<int> input = in.get();
+        if (input.dim(0).min() != 0 || input.dim(0).extent() != 10) {
+            printf("Inferred input region [%d, %d] instead of [0, 9]\n",
+                   input.dim(0).min(), input.dim(0).max());
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
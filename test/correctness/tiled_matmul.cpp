@@ -0,0 +1,92 @@
+#include "Halide.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+using namespace Halide::ConciseCasts;
+
+int main(int argc, char **argv) {
+    Target amx_target("x86-64-linux-avx512_skylake-avx512_cannonlake-avx512_vnni-avx512_bf16-avx512_sapphirerapids");
+    if (!amx_target.supported()) {
+        printf("This build of Halide does not support AMX. Skipping test.\n");
+        return 0;
+    }
+
+    const int rows = 32, cols = 32, k = 256;
+
+    // The right-hand side is in the layout the AMX instructions
+    // expect: b(i, x, ko) is element (4 * ko + i, x) of the matrix.
+    Buffer<int8_t> a(k, rows);
+    Buffer<int8_t> b(4, cols, k / 4);
+    for (int y = 0; y < rows; y++) {
+        for (int i = 0; i < k; i++) {
+            a(i, y) = (int8_t)(rand() % 256 - 128);
+        }
+    }
+    for (int ko = 0; ko < k / 4; ko++) {
+        for (int x = 0; x < cols; x++) {
+            for (int i = 0; i < 4; i++) {
+                b(i, x, ko) = (int8_t)(rand() % 256 - 128);
+            }
+        }
+    }
+
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    RDom r(0, k);
+    RVar ro("ro"), ri("ri");
+
+    Func mm("mm"), out("out");
+    mm(x, y) = 0;
+    mm(x, y) += i32(a(r, y)) * i32(b(r % 4, x, r / 4));
+    out(x, y) = mm(x, y);
+
+    // Accumulate 16x16 tiles of the output, 64 bytes of k at a time.
+    out.tile(x, y, xi, yi, 16, 16);
+    mm.compute_at(out, x)
+        .store_in(MemoryType::AMXTile);
+    mm.update()
+        .split(r, ro, ri, 64)
+        .reorder(ri, x, y, ro);
+
+    // Check that the accumulator was put in a tile register, whether
+    // or not this machine can run it.
+    std::string asm_file = Internal::get_test_tmp_dir() + "tiled_matmul.s";
+    Internal::ensure_no_file_exists(asm_file);
+    out.compile_to_assembly(asm_file, {}, "tiled_matmul", amx_target);
+    std::ifstream asm_stream(asm_file);
+    std::stringstream assembly;
+    assembly << asm_stream.rdbuf();
+    for (const char *op : {"tileloadd", "tdpbssd", "tilestored"}) {
+        if (assembly.str().find(op) == std::string::npos) {
+            printf("No %s instruction in %s\n", op, asm_file.c_str());
+            return -1;
+        }
+    }
+
+    Target target = get_jit_target_from_environment();
+    if (!target.has_feature(Target::AVX512_SapphireRapids)) {
+        printf("No AMX support in target. Skipping the run.\n");
+        printf("Success!\n");
+        return 0;
+    }
+
+    Buffer<int32_t> result = out.realize(cols, rows, target);
+
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            int32_t correct = 0;
+            for (int i = 0; i < k; i++) {
+                correct += (int32_t)a(i, y) * (int32_t)b(i % 4, x, i / 4);
+            }
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
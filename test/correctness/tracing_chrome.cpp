@@ -0,0 +1,65 @@
+#include "Halide.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test/common/halide_test_dirs.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    std::string trace_file = Internal::get_test_tmp_dir() + "tracing_chrome.json";
+    Internal::ensure_no_file_exists(trace_file);
+    setenv("HL_TRACE_FILE", trace_file.c_str(), 1);
+    setenv("HL_TRACE_FORMAT", "chrome", 1);
+
+    Func f("f"), g("g");
+    Var x, y;
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2;
+    f.compute_at(g, y).trace_realizations();
+    g.parallel(y).trace_realizations();
+
+    Buffer<int> out = g.realize(64, 64);
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            if (out(x, y) != 2 * (x + y)) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), 2 * (x + y));
+                return -1;
+            }
+        }
+    }
+
+    // The trace is flushed at the end of each pipeline.
+    std::ifstream in(trace_file);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    std::string s = contents.str();
+
+    if (s.empty() || s[0] != '[') {
+        printf("Trace file doesn't look like a Chrome trace:\n%s\n", s.c_str());
+        return -1;
+    }
+
+    const char *expected[] = {
+        "\"name\":\"f\",\"cat\":\"produce\",\"ph\":\"b\"",
+        "\"name\":\"f\",\"cat\":\"consume\",\"ph\":\"e\"",
+        "\"name\":\"g\",\"cat\":\"realization\",\"ph\":\"b\"",
+        "\"cat\":\"pipeline\",\"ph\":\"e\"",
+        "\"cat\":\"task\",\"ph\":\"B\"",
+    };
+    for (const char *e : expected) {
+        if (s.find(e) == std::string::npos) {
+            printf("Didn't find %s in the trace file\n", e);
+            return -1;
+        }
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
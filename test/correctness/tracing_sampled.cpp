@@ -0,0 +1,57 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+int stores = 0, realizations = 0;
+
+int my_trace(void *user_context, const halide_trace_event_t *e) {
+    if (e->event == halide_trace_store) {
+        stores++;
+    } else if (e->event == halide_trace_begin_realization) {
+        realizations++;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    setenv("HL_TRACE_SAMPLE_RATE", "10", 1);
+
+    Func f("f"), g("g");
+    Var x;
+    f(x) = x;
+    g(x) = f(x) + 1;
+    f.compute_root().trace_stores().trace_realizations();
+    g.trace_stores();
+    g.set_custom_trace(&my_trace);
+
+    Buffer<int> out = g.realize(1000);
+    for (int i = 0; i < out.width(); i++) {
+        if (out(i) != i + 1) {
+            printf("out(%d) = %d instead of %d\n", i, out(i), i + 1);
+            return -1;
+        }
+    }
+
+    // There are 2000 stores in total. Roughly one in ten should have
+    // been reported; the counter is shared, so the exact number
+    // depends on where it started.
+    if (stores < 199 || stores > 201) {
+        printf("Saw %d store events instead of 200\n", stores);
+        return -1;
+    }
+
+    // Other events are never dropped.
+    if (realizations != 1) {
+        printf("Saw %d begin realization events instead of 1\n", realizations);
+        return -1;
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
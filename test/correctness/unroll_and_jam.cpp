@@ -0,0 +1,115 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Counts the loops nested inside a loop over a given variable.
+class CountInnerLoops : public IRMutator {
+public:
+    std::string loop;
+    int inner_loops = 0;
+
+    CountInnerLoops(const std::string &loop) : loop(loop) {}
+
+    using IRMutator::mutate;
+
+    Stmt mutate(const Stmt &s) override {
+        class Counter : public IRVisitor {
+            using IRVisitor::visit;
+            void visit(const For *op) override {
+                if (inside) {
+                    parent->inner_loops++;
+                    IRVisitor::visit(op);
+                } else if (ends_with(op->name, "." + parent->loop)) {
+                    inside = true;
+                    IRVisitor::visit(op);
+                    inside = false;
+                } else {
+                    IRVisitor::visit(op);
+                }
+            }
+        public:
+            CountInnerLoops *parent;
+            bool inside = false;
+        } counter;
+        counter.parent = this;
+        s.accept(&counter);
+        return s;
+    }
+};
+
+int main(int argc, char **argv) {
+    const int N = 64, K = 50;
+    Buffer<float> a(K, N), b(N, K);
+    a.for_each_element([&](int x, int y) { a(x, y) = (float)((x * 7 + y * 3) % 11); });
+    b.for_each_element([&](int x, int y) { b(x, y) = (float)((x * 5 + y * 13) % 17); });
+
+    // A matrix multiply, with the iterations over y jammed into the
+    // loop over the reduction.
+    {
+        Var x("x"), y("y"), xo("xo"), xi("xi");
+        Func c("c");
+        RDom r(0, K, "r");
+        c(x, y) = 0.0f;
+        c(x, y) += a(r, y) * b(x, r);
+        c.update()
+            .split(x, xo, xi, 8)
+            .reorder(xi, r, xo, y)
+            .vectorize(xi)
+            .unroll_and_jam(y, 4);
+
+        CountInnerLoops *counter = new CountInnerLoops("r$x");
+        c.add_custom_lowering_pass(counter);
+        Buffer<float> out = c.realize(N, N);
+
+        for (int y = 0; y < N; y++) {
+            for (int x = 0; x < N; x++) {
+                float correct = 0.0f;
+                for (int k = 0; k < K; k++) {
+                    correct += a(k, y) * b(x, k);
+                }
+                if (out(x, y) != correct) {
+                    printf("c(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // The four rows are all updated directly in the body of the
+        // loop over r.
+        if (counter->inner_loops != 0) {
+            printf("Loop over r has %d inner loops instead of none\n",
+                   counter->inner_loops);
+            return -1;
+        }
+    }
+
+    // Unroll-and-jam of an RVar with a tail, on a stage without any
+    // vectorization.
+    {
+        Var x("x");
+        Func f("f");
+        RDom r(0, 10, 0, 7);
+        f(x) = 0;
+        f(x) += cast<int>(a(r.x, r.y)) * (x + 1);
+        f.update().reorder(x, r.x, r.y).unroll_and_jam(r.y, 3, TailStrategy::GuardWithIf);
+
+        Buffer<int> out = f.realize(5);
+        for (int x = 0; x < 5; x++) {
+            int correct = 0;
+            for (int ry = 0; ry < 7; ry++) {
+                for (int rx = 0; rx < 10; rx++) {
+                    correct += (int)a(rx, ry) * (x + 1);
+                }
+            }
+            if (out(x) != correct) {
+                printf("f(%d) = %d instead of %d\n", x, out(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Count the horizontal reductions in the lowered code, without
+// changing it.
+class CountVectorReduces : public IRMutator {
+    using IRMutator::visit;
+
+    Expr visit(const VectorReduce *op) override {
+        count++;
+        return IRMutator::visit(op);
+    }
+
+public:
+    int count = 0;
+};
+
+template<typename T>
+int check(const Buffer<T> &result, const Buffer<T> &correct, const char *name) {
+    for (int x = 0; x < correct.width(); x++) {
+        if (result(x) != correct(x)) {
+            printf("%s: result(%d) = %f instead of %f\n", name, x,
+                   (double)result(x), (double)correct(x));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const int size = 1024;
+    const int out_size = 16;
+
+    Buffer<uint8_t> a(size * out_size), b(size * out_size);
+    for (int i = 0; i < size * out_size; i++) {
+        a(i) = (uint8_t)((i * 17 + 3) % 251);
+        b(i) = (uint8_t)((i * 31 + 7) % 253);
+    }
+
+    Var x;
+    RDom r(0, size);
+    Expr idx = x * size + r;
+
+    // A sum of absolute differences, vectorized over the RDom. On x86
+    // this becomes psadbw.
+    {
+        Buffer<uint32_t> correct(out_size);
+        for (int i = 0; i < out_size; i++) {
+            correct(i) = 0;
+            for (int j = 0; j < size; j++) {
+                int d = (int)a(i * size + j) - (int)b(i * size + j);
+                correct(i) += d < 0 ? -d : d;
+            }
+        }
+
+        Func sad;
+        sad(x) = cast<uint32_t>(0);
+        sad(x) += cast<uint32_t>(absd(a(idx), b(idx)));
+
+        RVar ro, ri;
+        sad.update().split(r, ro, ri, 32).atomic().vectorize(ri);
+
+        CountVectorReduces *counter = new CountVectorReduces;
+        sad.add_custom_lowering_pass(counter);
+        Buffer<uint32_t> result = sad.realize(out_size);
+        if (check(result, correct, "sad")) {
+            return -1;
+        }
+        if (counter->count == 0) {
+            printf("sad: no horizontal reduction in the lowered code\n");
+            return -1;
+        }
+    }
+
+    // A max, which reduces with a different operator.
+    {
+        Buffer<uint8_t> correct(out_size);
+        for (int i = 0; i < out_size; i++) {
+            correct(i) = 0;
+            for (int j = 0; j < size; j++) {
+                correct(i) = std::max(correct(i), a(i * size + j));
+            }
+        }
+
+        Func m;
+        m(x) = cast<uint8_t>(0);
+        m(x) = max(m(x), a(idx));
+
+        RVar ro, ri;
+        m.update().split(r, ro, ri, 16).atomic().vectorize(ri);
+
+        Buffer<uint8_t> result = m.realize(out_size);
+        if (check(result, correct, "max")) {
+            return -1;
+        }
+    }
+
+    // A sum over some of the lanes. The other lanes contribute the
+    // identity.
+    {
+        Buffer<int> correct(out_size);
+        for (int i = 0; i < out_size; i++) {
+            correct(i) = 0;
+            for (int j = 0; j < size; j++) {
+                if (a(i * size + j) > b(i * size + j)) {
+                    correct(i) += a(i * size + j);
+                }
+            }
+        }
+
+        RDom rp(0, size);
+        Expr idx_p = x * size + rp;
+        rp.where(a(idx_p) > b(idx_p));
+
+        Func s;
+        s(x) = 0;
+        s(x) += cast<int>(a(idx_p));
+
+        RVar ro, ri;
+        s.update().split(rp, ro, ri, 8).atomic().vectorize(ri);
+
+        Buffer<int> result = s.realize(out_size);
+        if (check(result, correct, "predicated sum")) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
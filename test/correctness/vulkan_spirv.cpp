@@ -0,0 +1,128 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the outermost GPU block loop, which is what gets compiled into
+// a kernel.
+class FindKernel : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (!kernel.defined() && CodeGen_GPU_Dev::is_gpu_var(op->name)) {
+            kernel = op;
+            return;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    Stmt kernel;
+};
+
+// Read the null-terminated string literal starting at the given word.
+std::string literal_string(const std::vector<uint32_t> &words, size_t start, size_t end) {
+    std::string result;
+    for (size_t i = start; i < end; i++) {
+        for (int b = 0; b < 4; b++) {
+            char c = (char)((words[i] >> (8 * b)) & 0xff);
+            if (c == 0) {
+                return result;
+            }
+            result += c;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    Target t = get_host_target().with_feature(Target::Vulkan);
+    if (!t.supported()) {
+        printf("Vulkan is not enabled in this build of Halide, skipping test\n");
+        return 0;
+    }
+
+    Func f("f");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    f(x, y) = x * 2 + y;
+    f.gpu_tile(x, y, xi, yi, 8, 4);
+
+    // Only the device code is inspected, so this doesn't need a Vulkan
+    // driver.
+    Module m = f.compile_to_module({}, "vulkan_spirv", t);
+    FindKernel finder;
+    for (const LoweredFunc &fn : m.functions()) {
+        fn.body.accept(&finder);
+    }
+    const For *loop = finder.kernel.as<For>();
+    if (!loop || loop->device_api != DeviceAPI::Vulkan) {
+        printf("No Vulkan kernel was found in the lowered code\n");
+        return -1;
+    }
+
+    CodeGen_Vulkan_Dev codegen(t);
+    codegen.init_module();
+    HostClosure closure(loop->body, loop->name);
+    codegen.add_kernel(loop, "vulkan_spirv_kernel", closure.arguments());
+    std::string entry_name = codegen.get_current_kernel_name();
+    std::vector<char> src = codegen.compile_to_src();
+
+    if (src.size() < 5 * sizeof(uint32_t) || src.size() % sizeof(uint32_t) != 0) {
+        printf("SPIR-V module of %d bytes is not a whole number of words\n", (int)src.size());
+        return -1;
+    }
+    std::vector<uint32_t> words(src.size() / sizeof(uint32_t));
+    memcpy(words.data(), src.data(), src.size());
+
+    if (words[0] != 0x07230203) {
+        printf("Bad SPIR-V magic number 0x%08x\n", words[0]);
+        return -1;
+    }
+
+    // Walk the instructions after the header, looking for the entry
+    // point and its workgroup size.
+    const uint32_t OpEntryPoint = 15, OpExecutionMode = 16;
+    const uint32_t ExecutionModelGLCompute = 5, ExecutionModeLocalSize = 17;
+    int entry_points = 0;
+    uint32_t entry_fn = 0;
+    uint32_t local_size[3] = {0, 0, 0};
+    for (size_t i = 5; i < words.size();) {
+        uint32_t word_count = words[i] >> 16;
+        uint32_t opcode = words[i] & 0xffff;
+        if (word_count == 0 || i + word_count > words.size()) {
+            printf("Malformed SPIR-V instruction at word %d\n", (int)i);
+            return -1;
+        }
+        if (opcode == OpEntryPoint && word_count >= 4) {
+            std::string name = literal_string(words, i + 3, i + word_count);
+            if (words[i + 1] != ExecutionModelGLCompute || name != entry_name) {
+                printf("Unexpected entry point %s with execution model %d\n", name.c_str(), words[i + 1]);
+                return -1;
+            }
+            entry_fn = words[i + 2];
+            entry_points++;
+        } else if (opcode == OpExecutionMode && word_count == 6 &&
+                   words[i + 1] == entry_fn && words[i + 2] == ExecutionModeLocalSize) {
+            for (int d = 0; d < 3; d++) {
+                local_size[d] = words[i + 3 + d];
+            }
+        }
+        i += word_count;
+    }
+
+    if (entry_points != 1) {
+        printf("%d entry points instead of 1\n", entry_points);
+        return -1;
+    }
+
+    if (local_size[0] != 8 || local_size[1] != 4 || local_size[2] != 1) {
+        printf("Workgroup size is %d x %d x %d instead of 8 x 4 x 1\n",
+               local_size[0], local_size[1], local_size[2]);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "Halide.h"
+#include <set>
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the outermost GPU block loop, which is what gets compiled into
+// a kernel.
+class FindKernel : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (!kernel.defined() && CodeGen_GPU_Dev::is_gpu_var(op->name)) {
+            kernel = op;
+            return;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    Stmt kernel;
+};
+
+// The binding of a module-scope variable declared with the given
+// suffix, or -1 if there isn't exactly one.
+int binding_of(const std::string &src, const std::string &decl) {
+    size_t pos = src.find(decl);
+    if (pos == std::string::npos || src.find(decl, pos + 1) != std::string::npos) {
+        return -1;
+    }
+    size_t line = src.rfind('\n', pos);
+    line = (line == std::string::npos) ? 0 : line + 1;
+    const std::string prefix = "@group(0) @binding(";
+    if (src.compare(line, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    return atoi(src.c_str() + line + prefix.size());
+}
+
+// Check that every index into the given array ends with the given
+// shift, i.e. addresses the u32 word holding a packed element.
+bool all_indices_shifted(const std::string &src, const std::string &array, const std::string &shift) {
+    int count = 0;
+    for (size_t pos = src.find(array + "["); pos != std::string::npos; pos = src.find(array + "[", pos + 1)) {
+        size_t end = src.find(']', pos);
+        std::string index = src.substr(pos, end - pos);
+        if (index.size() < shift.size() || index.compare(index.size() - shift.size(), shift.size(), shift) != 0) {
+            printf("Unpacked access %s]\n", index.c_str());
+            return false;
+        }
+        count++;
+    }
+    return count > 0;
+}
+
+int main(int argc, char **argv) {
+    Target t = get_host_target().with_feature(Target::WebGPU);
+    if (!t.supported()) {
+        printf("WebGPU is not enabled in this build of Halide, skipping test\n");
+        return 0;
+    }
+
+    // One 8-bit and one 32-bit input, and a 16-bit output, so that
+    // both packed and unpacked buffers are bound.
+    ImageParam a(UInt(8), 1, "a"), b(Float(32), 1, "b");
+    Func out("out");
+    Var x("x"), xi("xi");
+    out(x) = cast<uint16_t>(a(x)) + cast<uint16_t>(b(x));
+    out.gpu_tile(x, xi, 16);
+
+    // Only the device code is inspected, so this doesn't need a WebGPU
+    // implementation.
+    Module m = out.compile_to_module({a, b}, "webgpu_wgsl", t);
+    FindKernel finder;
+    for (const LoweredFunc &fn : m.functions()) {
+        fn.body.accept(&finder);
+    }
+    const For *loop = finder.kernel.as<For>();
+    if (!loop || loop->device_api != DeviceAPI::WebGPU) {
+        printf("No WebGPU kernel was found in the lowered code\n");
+        return -1;
+    }
+
+    CodeGen_WebGPU_Dev codegen(t);
+    codegen.init_module();
+    HostClosure closure(loop->body, loop->name);
+    codegen.add_kernel(loop, "webgpu_wgsl_kernel", closure.arguments());
+    std::vector<char> buf = codegen.compile_to_src();
+    std::string src(buf.data());
+    const std::string k = codegen.get_current_kernel_name();
+
+    // The entry point, with the workgroup size of the tile.
+    if (src.find("@compute @workgroup_size(16, 1, 1)\nfn " + k + "(") == std::string::npos) {
+        printf("No entry point %s with workgroup size 16 in:\n%s\n", k.c_str(), src.c_str());
+        return -1;
+    }
+
+    // Each buffer gets its own binding, followed by the uniform block
+    // of scalar arguments. 8 and 16-bit buffers are bound as arrays of
+    // u32, which are atomic if the kernel writes to them.
+    std::set<int> bindings;
+    for (const std::string &decl : {k + "_a : array<u32>;",
+                                    k + "_b : array<f32>;",
+                                    k + "_out : array<atomic<u32>>;"}) {
+        int binding = binding_of(src, " var<storage, read_write> " + decl);
+        if (binding < 0) {
+            printf("No binding declared for %s in:\n%s\n", decl.c_str(), src.c_str());
+            return -1;
+        }
+        bindings.insert(binding);
+    }
+    if (bindings != std::set<int>{0, 1, 2} ||
+        binding_of(src, " var<uniform> " + k + "_args : ") != 3) {
+        printf("Unexpected bindings in:\n%s\n", src.c_str());
+        return -1;
+    }
+
+    // Packed elements are accessed through the word that holds them,
+    // and stores to them only update their own bits.
+    if (!all_indices_shifted(src, k + "_a", " >> 2u") ||
+        !all_indices_shifted(src, k + "_out", " >> 1u") ||
+        src.find("atomicAnd(&" + k + "_out[") == std::string::npos ||
+        src.find("atomicOr(&" + k + "_out[") == std::string::npos) {
+        printf("8 and 16-bit buffers are not packed correctly in:\n%s\n", src.c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+
+    Func f;
+    Var x;
+
+    f(x) = 0;
+
+    RDom r(0, 100);
+    f(r % 10) = f(r % 10) * 2 - r;
+
+    // This update isn't associative, so atomic() should refuse it.
+    f.update().atomic().parallel(r);
+
+    // We shouldn't reach here, because there should have been a compile error.
+    printf("There should have been an error\n");
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+#include "halide_malloc_trace.h"
+
+#include <stdio.h>
+#include <string>
+
+#include "allocation_trace.h"
+
+using namespace Halide::Runtime;
+using namespace Halide::Tools;
+
+int main(int argc, char **argv) {
+    Buffer<float> input(65, 32), output(64, 32);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y; });
+
+    const char *filename = "allocation_trace.trace";
+    halide_enable_malloc_trace_capture(filename);
+    for (int i = 0; i < 2; i++) {
+        if (allocation_trace(input, output) != 0) {
+            printf("Pipeline failed\n");
+            return -1;
+        }
+    }
+    if (!halide_disable_malloc_trace_capture()) {
+        printf("Could not write %s\n", filename);
+        return -1;
+    }
+
+    output.for_each_element([&](int x, int y) {
+        if (output(x, y) != (x + y) * 2 + (x + 1 + y) * 2) {
+            printf("output(%d, %d) = %f\n", x, y, output(x, y));
+            exit(-1);
+        }
+    });
+
+    MallocTrace trace;
+    if (!trace.read(filename)) {
+        printf("Could not read %s\n", filename);
+        return -1;
+    }
+    remove(filename);
+
+    // Each call allocates tmp once, and frees it again.
+    int tmp_mallocs = 0, mallocs = 0, frees = 0;
+    uint64_t last_timestamp = 0;
+    for (const MallocTraceRecord &r : trace.records) {
+        if (r.timestamp_ns < last_timestamp) {
+            printf("Records are out of order\n");
+            return -1;
+        }
+        last_timestamp = r.timestamp_ns;
+        if (r.event == malloc_trace_malloc) {
+            mallocs++;
+            if (trace.func_name(r) == std::string("tmp")) {
+                tmp_mallocs++;
+                if (r.size < 65 * 32 * sizeof(float) || r.alignment_log2 < 7) {
+                    printf("Unexpected size %d or alignment %d for tmp\n", (int)r.size, 1 << r.alignment_log2);
+                    return -1;
+                }
+            }
+        } else {
+            frees++;
+        }
+    }
+    if (tmp_mallocs != 2 || mallocs != frees) {
+        printf("Saw %d allocations of tmp, %d mallocs and %d frees\n", tmp_mallocs, mallocs, frees);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "Halide.h"
+
+namespace {
+
+class AllocationTrace : public Halide::Generator<AllocationTrace> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        Var x, y;
+        Func tmp("tmp");
+        tmp(x, y) = input(x, y) * 2;
+        output(x, y) = tmp(x, y) + tmp(x + 1, y);
+
+        // Trace the realizations of tmp, so that its allocation is
+        // labelled with its name.
+        tmp.compute_root().trace_realizations();
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(AllocationTrace, allocation_trace)
@@ -3,6 +3,7 @@
 #include "HalideRuntime.h"
 #include "HalideBuffer.h"
 #include <assert.h>
+#include <future>
 #if defined(TEST_OPENCL)
 #include "HalideRuntimeOpenCL.h"
 #elif defined(TEST_CUDA)
@@ -55,6 +56,13 @@ int main(int argc, char **argv) {
 
     Buffer<int> output(W, H);
 
+    // Load the kernels on another thread, as a server would at startup.
+    std::future<int> prewarmed = std::async(std::launch::async, gpu_only_prewarm, nullptr);
+    if (prewarmed.get() != 0) {
+        printf("Prewarming failed\n");
+        return -1;
+    }
+
     // Create halide_buffer_ts without host pointers.
     halide_buffer_t input_no_host = *((halide_buffer_t *)input);
     input_no_host.host = nullptr;
@@ -81,8 +89,37 @@ int main(int argc, char **argv) {
         }
     }
 
+    // With allocation reuse enabled, freeing the output's device
+    // allocation should make it available to the next run.
+    halide_reuse_device_allocations(nullptr, true);
+    uint64_t first_device = output_no_host.device;
+    halide_device_free(nullptr, &output_no_host);
+    output_no_host.host = (uint8_t *)1;
+    gpu_only(&input_no_host, &output_no_host);
+    if (output_no_host.device != first_device) {
+        printf("Device allocation was not reused\n");
+        return -1;
+    }
+    output_no_host.host = (uint8_t *)output.data();
+    halide_copy_to_host(nullptr, &output_no_host);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (input(x, y) * 2 != output(x, y)) {
+                printf("Error after reuse at %d, %d: %d != %d\n", x, y, input(x, y), output(x, y));
+                return -1;
+            }
+        }
+    }
+    halide_device_free(nullptr, &output_no_host);
+    halide_reuse_device_allocations(nullptr, false);
+
     printf("Success!\n");
 #else
+    // Without kernels there is nothing to prewarm.
+    if (gpu_only_prewarm(nullptr) != 0) {
+        printf("Prewarming failed\n");
+        return -1;
+    }
     printf("No GPU target enabled, skipping...\n");
 #endif
     return 0;
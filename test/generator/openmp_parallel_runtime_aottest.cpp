@@ -0,0 +1,38 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+#include "halide_openmp_parallel_runtime.h"
+
+#include <stdio.h>
+
+#include "openmp_parallel_runtime.h"
+
+using namespace Halide::Runtime;
+
+int main(int argc, char **argv) {
+    Halide::Tools::use_openmp_parallel_runtime();
+
+    Buffer<int> out(64, 64, 8);
+    for (int i = 0; i < 10; i++) {
+        int ret = openmp_parallel_runtime(out);
+        if (ret) {
+            printf("Non zero exit code: %d\n", ret);
+            return -1;
+        }
+    }
+
+    for (int z = 0; z < out.channels(); z++) {
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = 4 * (x + y + z);
+                if (out(x, y, z) != correct) {
+                    printf("out(%d, %d, %d) = %d instead of %d\n",
+                           x, y, z, out(x, y, z), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
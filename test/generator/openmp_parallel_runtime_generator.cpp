@@ -0,0 +1,27 @@
+#include "Halide.h"
+
+namespace {
+
+class OpenMPParallelRuntime : public Halide::Generator<OpenMPParallelRuntime> {
+public:
+    Output<Buffer<int>> output{"output", 3};
+
+    void generate() {
+        // Parallel loops with async producers and consumers nested
+        // inside them, so that both halide_do_par_for and
+        // halide_do_parallel_tasks get used.
+        Var x, y, z;
+        Func producer, consumer;
+        producer(x, y, z) = x + y + z;
+        consumer(x, y, z) = producer(x - 1, y, z) + producer(x + 1, y, z);
+        output(x, y, z) = consumer(x, y - 1, z) + consumer(x, y + 1, z);
+
+        consumer.compute_at(output, y).async();
+        producer.compute_at(consumer, y).async();
+        output.parallel(z).parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(OpenMPParallelRuntime, openmp_parallel_runtime)
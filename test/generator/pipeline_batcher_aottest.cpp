@@ -0,0 +1,64 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+#include "halide_pipeline_batcher.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "pipeline_batcher.h"
+
+using namespace Halide::Runtime;
+
+std::atomic<int> batches{0};
+
+int main(int argc, char **argv) {
+    const int max_batch = 8;
+    Halide::Tools::PipelineBatcher<float, float> batcher(
+        [](Buffer<float> &in, Buffer<float> &out) {
+            batches++;
+            return pipeline_batcher(in, out);
+        },
+        max_batch, std::chrono::milliseconds(50));
+
+    // Many threads each run the pipeline on their own small input at
+    // once. A few use a different size, which can't share a batch
+    // with the others.
+    const int num_requests = 32;
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_requests; t++) {
+        threads.emplace_back([&, t]() {
+            const int size = (t % 8 == 0) ? 7 : 16;
+            Buffer<float> in(size, size), out(size, size);
+            in.for_each_element([&](int x, int y) { in(x, y) = x + y + t; });
+            if (batcher.run(in, out) != 0) {
+                errors++;
+                return;
+            }
+            out.for_each_element([&](int x, int y) {
+                if (out(x, y) != (x + y + t) * 2 + 1) {
+                    errors++;
+                }
+            });
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (errors) {
+        printf("%d errors\n", errors.load());
+        return -1;
+    }
+
+    if (batches >= num_requests) {
+        printf("Expected requests to be batched, but got %d batches for %d requests\n",
+               batches.load(), num_requests);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
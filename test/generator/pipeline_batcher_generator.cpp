@@ -0,0 +1,20 @@
+#include "Halide.h"
+
+namespace {
+
+class PipelineBatcher : public Halide::Generator<PipelineBatcher> {
+public:
+    // A batch of small images, with the batch index outermost.
+    Input<Buffer<float>> input{"input", 3};
+    Output<Buffer<float>> output{"output", 3};
+
+    void generate() {
+        Var x, y, n;
+        output(x, y, n) = input(x, y, n) * 2 + 1;
+        output.parallel(n);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(PipelineBatcher, pipeline_batcher)
@@ -0,0 +1,44 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+
+#include <stdio.h>
+
+#include "specialize_on.h"
+
+using namespace Halide::Runtime;
+
+int main(int argc, char **argv) {
+    Buffer<int32_t> input(17, 5);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y * 17; });
+
+    // Both the specialized and the generic values must give the same
+    // results.
+    for (int scale : {1, 2, 3, 4, -7}) {
+        for (bool flip : {false, true}) {
+            Buffer<int32_t> output(17, 5);
+            if (specialize_on(input, scale, flip, output) != 0) {
+                printf("specialize_on failed\n");
+                return -1;
+            }
+            for (int y = 0; y < output.height(); y++) {
+                for (int x = 0; x < output.width(); x++) {
+                    int correct = input(x, y) * scale;
+                    if (flip) {
+                        correct = -correct;
+                    }
+                    if (y == 0) {
+                        correct += 1;
+                    }
+                    if (output(x, y) != correct) {
+                        printf("scale=%d flip=%d: output(%d, %d) = %d instead of %d\n",
+                               scale, (int)flip, x, y, output(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "Halide.h"
+
+namespace {
+
+class SpecializeOn : public Halide::Generator<SpecializeOn> {
+public:
+    Input<Buffer<int32_t>> input{"input", 2};
+    Input<int32_t> scale{"scale", 1};
+    Input<bool> flip{"flip", false};
+
+    Output<Buffer<int32_t>> output{"output", 2};
+
+    void generate() {
+        Func scaled("scaled");
+        scaled(x, y) = input(x, y) * scale;
+
+        output(x, y) = select(flip, -scaled(x, y), scaled(x, y));
+        output(x, 0) += 1;
+
+        scale.specialize_on({1, 2, 4});
+        flip.specialize_on({false});
+    }
+
+    void schedule() {
+        output.vectorize(x, natural_vector_size<int32_t>(), TailStrategy::GuardWithIf);
+    }
+
+    Var x, y;
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(SpecializeOn, specialize_on)
@@ -0,0 +1,109 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+#include "thread_pool_elastic.h"
+
+using namespace Halide::Runtime;
+
+std::atomic<bool> stop{false};
+
+// The number of threads in the process, or -1 if it can't be counted.
+int count_threads() {
+#ifdef __linux__
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir) {
+        return -1;
+    }
+    int count = 0;
+    while (dirent *e = readdir(dir)) {
+        if (e->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+#else
+    return -1;
+#endif
+}
+
+int run(Buffer<float> &out) {
+    int ret = thread_pool_elastic(out);
+    if (ret) {
+        printf("Non zero exit code: %d\n", ret);
+        return -1;
+    }
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            float correct = sqrtf(sqrtf((float)(x * y)));
+            if (fabsf(out(x, y) - correct) > 1e-5f) {
+                printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+void mess_with_pool(void *) {
+    while (!stop) {
+        halide_set_num_threads((rand() % 8) + 1);
+        halide_set_thread_pool_idle_timeout((rand() % 3) + 1);
+    }
+}
+
+int main(int argc, char **argv) {
+    const int initial_threads = count_threads();
+    Buffer<float> out(64, 64);
+
+    halide_set_thread_pool_idle_timeout(10);
+    halide_set_num_threads(8);
+    for (int i = 0; i < 10; i++) {
+        if (run(out)) return -1;
+    }
+
+    // With fewer threads, the surplus workers retire without a
+    // shutdown of the thread pool.
+    halide_set_num_threads(2);
+    if (run(out)) return -1;
+    if (initial_threads > 0) {
+        int threads = count_threads();
+        for (int i = 0; i < 200 && threads > initial_threads + 1; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            threads = count_threads();
+        }
+        if (threads > initial_threads + 1) {
+            printf("%d threads are running instead of at most %d\n", threads, initial_threads + 1);
+            return -1;
+        }
+    }
+
+    // Resize the pool at random while running a job with lots of
+    // nested parallelism, to hunt for deadlocks.
+    halide_thread *t = halide_spawn_thread(&mess_with_pool, NULL);
+    for (int i = 0; i < 500; i++) {
+        if (run(out)) return -1;
+    }
+    stop = true;
+    halide_join_thread(t);
+
+    // The pool still works once it's no longer elastic.
+    halide_set_thread_pool_idle_timeout(-1);
+    halide_set_num_threads(4);
+    if (run(out)) return -1;
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,20 @@
+#include "Halide.h"
+
+namespace {
+
+class ThreadPoolElastic : public Halide::Generator<ThreadPoolElastic> {
+public:
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        // A job with lots of nested parallelism
+        Var x, y;
+
+        output(x, y) = sqrt(sqrt(x*y));
+        output.parallel(x).parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ThreadPoolElastic, thread_pool_elastic)
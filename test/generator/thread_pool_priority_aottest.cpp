@@ -0,0 +1,85 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "thread_pool_priority.h"
+
+using namespace Halide::Runtime;
+
+static void * const high_priority = (void *)(intptr_t)0xf00dd00d;
+static void * const low_priority = (void *)(intptr_t)0xdeadbeef;
+
+struct Task {
+    void *user_context;
+    int ret;
+};
+
+int check(const Buffer<float> &out) {
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            float correct = sqrtf(sqrtf((float)(x * y)));
+            if (fabsf(out(x, y) - correct) > 1e-5f) {
+                printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+void run(void *arg) {
+    Task *task = (Task *)arg;
+    Buffer<float> out(64, 64);
+    for (int i = 0; i < 100 && task->ret == 0; i++) {
+        task->ret = thread_pool_priority(task->user_context, out);
+        if (task->ret == 0) {
+            task->ret = check(out);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    halide_set_num_threads(4);
+
+    if (halide_set_thread_pool_priority(high_priority, 10, 0) != 0 ||
+        halide_set_thread_pool_priority(low_priority, -10, 2) != 0) {
+        printf("halide_set_thread_pool_priority failed\n");
+        return -1;
+    }
+
+    // A negative budget is an error.
+    if (halide_set_thread_pool_priority(low_priority, 0, -1) == 0) {
+        printf("Expected a negative max_threads to be rejected\n");
+        return -1;
+    }
+
+    // Run pipelines in both classes at once. The intent is to hunt
+    // for deadlocks and for jobs that never get run.
+    Task high = {high_priority, 0}, low = {low_priority, 0};
+    halide_thread *t = halide_spawn_thread(&run, &low);
+    run(&high);
+    halide_join_thread(t);
+
+    if (high.ret != 0 || low.ret != 0) {
+        printf("Non zero exit code: %d %d\n", high.ret, low.ret);
+        return -1;
+    }
+
+    // Resetting both classes returns them to the default.
+    if (halide_set_thread_pool_priority(high_priority, 0, 0) != 0 ||
+        halide_set_thread_pool_priority(low_priority, 0, 0) != 0) {
+        printf("halide_set_thread_pool_priority failed\n");
+        return -1;
+    }
+    run(&low);
+    if (low.ret != 0) {
+        printf("Non zero exit code: %d\n", low.ret);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <stdio.h>
+#include <vector>
+
+#include "trusted_entry.h"
+
+using namespace Halide::Runtime;
+
+const int kSize = 16;
+
+bool verify(const Buffer<uint8_t> &input, int offset, const Buffer<uint8_t> &output) {
+    for (int y = 0; y < kSize; y++) {
+        for (int x = 0; x < kSize; x++) {
+            uint8_t expected = (uint8_t)(input(x, y) + offset);
+            if (output(x, y) != expected) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void my_error_handler(void *user_context, const char *message) {
+    printf("Saw: (%s)\n", message);
+}
+
+int main(int argc, char **argv) {
+    halide_set_error_handler(my_error_handler);
+
+    Buffer<uint8_t> input(kSize, kSize);
+    input.for_each_element([&](int x, int y) { input(x, y) = (uint8_t)(x * 3 + y); });
+
+    // The validation entry point accepts good arguments, and computes
+    // nothing.
+    Buffer<uint8_t> output(kSize, kSize);
+    output.fill(0);
+    if (trusted_entry_validate(input, 1, output) != 0) {
+        printf("trusted_entry_validate rejected valid arguments\n");
+        return -1;
+    }
+    for (int y = 0; y < kSize; y++) {
+        for (int x = 0; x < kSize; x++) {
+            if (output(x, y) != 0) {
+                printf("trusted_entry_validate wrote to the output\n");
+                return -1;
+            }
+        }
+    }
+
+    // It rejects an input that is too small...
+    Buffer<uint8_t> small_input(kSize / 2, kSize);
+    if (trusted_entry_validate(small_input, 1, output) == 0) {
+        printf("trusted_entry_validate accepted an input that is too small\n");
+        return -1;
+    }
+
+    // ...and answers bounds queries.
+    Buffer<uint8_t> query(nullptr, 0, 0);
+    if (trusted_entry_validate(query, 1, output) != 0) {
+        printf("trusted_entry_validate failed a bounds query\n");
+        return -1;
+    }
+    if (query.width() != kSize || query.height() != kSize) {
+        printf("Bounds query gave %d x %d instead of %d x %d\n",
+               query.width(), query.height(), kSize, kSize);
+        return -1;
+    }
+
+    // The trusted entry point computes the same thing as the checked one.
+    if (trusted_entry_trusted(input, 2, output) != 0 || !verify(input, 2, output)) {
+        printf("trusted_entry_trusted failed\n");
+        return -1;
+    }
+
+    // As does the batched one, over many argument sets.
+    const int batch = 64;
+    std::vector<Buffer<uint8_t>> outputs;
+    std::vector<int> offsets(batch);
+    std::vector<void *> args(batch * 3);
+    std::vector<void **> arg_sets(batch);
+    for (int i = 0; i < batch; i++) {
+        outputs.emplace_back(kSize, kSize);
+        offsets[i] = i;
+    }
+    for (int i = 0; i < batch; i++) {
+        args[i * 3 + 0] = (halide_buffer_t *)input;
+        args[i * 3 + 1] = &offsets[i];
+        args[i * 3 + 2] = (halide_buffer_t *)outputs[i];
+        arg_sets[i] = &args[i * 3];
+    }
+    if (trusted_entry_trusted_batch(batch, arg_sets.data()) != 0) {
+        printf("trusted_entry_trusted_batch failed\n");
+        return -1;
+    }
+    for (int i = 0; i < batch; i++) {
+        if (!verify(input, offsets[i], outputs[i])) {
+            printf("trusted_entry_trusted_batch computed the wrong result for argument set %d\n", i);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "halide_benchmark.h"
+#include <Halide.h>
+
+// Time how long the compiler itself takes to lower and compile some
+// representative pipelines, so that changes to compile time can be
+// tracked. Run with HL_COMPILE_PROFILE=<file> to also get a
+// breakdown of the time spent in each lowering pass and in LLVM, and
+// the size of the IR after each pass.
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+namespace {
+
+Var x("x"), y("y"), xi("xi"), yi("yi");
+
+// Many inputs summed together, as in lots_of_inputs.
+Pipeline make_lots_of_inputs() {
+    std::vector<ImageParam> inputs;
+    Expr e = 0.0f;
+    for (int i = 0; i < 64; i++) {
+        inputs.emplace_back(Float(32), 2);
+        e += inputs.back()(x, y);
+    }
+    Func f("lots_of_inputs");
+    f(x, y) = e;
+    f.vectorize(x, 8).parallel(y);
+    return f;
+}
+
+// A separable blur with a boundary condition, scheduled like the apps.
+Pipeline make_blur() {
+    ImageParam input(UInt(16), 2, "input");
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    Func blur_x("blur_x"), blur_y("blur_y");
+    blur_x(x, y) = (clamped(x - 1, y) + clamped(x, y) + clamped(x + 1, y)) / 3;
+    blur_y(x, y) = (blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1)) / 3;
+    blur_y.tile(x, y, xi, yi, 256, 32).vectorize(xi, 8).parallel(y);
+    blur_x.compute_at(blur_y, x).vectorize(x, 8);
+    return blur_y;
+}
+
+// A deep chain of 3x3 stencils, each computed per tile of the output.
+Pipeline make_stencil_chain() {
+    ImageParam input(Float(32), 2, "input");
+    std::vector<Func> stages;
+    stages.push_back(BoundaryConditions::repeat_edge(input));
+    for (int i = 0; i < 32; i++) {
+        Func prev = stages.back();
+        Func f("stage_" + std::to_string(i));
+        Expr e = 0.0f;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                e += prev(x + dx, y + dy);
+            }
+        }
+        f(x, y) = e / 9;
+        stages.push_back(f);
+    }
+    Func out = stages.back();
+    out.tile(x, y, xi, yi, 128, 64).vectorize(xi, 8).parallel(y);
+    for (size_t i = 1; i + 1 < stages.size(); i++) {
+        stages[i].compute_at(out, x).vectorize(x, 8);
+    }
+    return out;
+}
+
+// Specialize in every branch of a tree of boolean params, giving 2^depth
+// copies of the loop nest.
+void specialize_tree(Stage s, const std::vector<Param<bool>> &params, size_t depth) {
+    if (depth == params.size()) {
+        return;
+    }
+    specialize_tree(s.specialize(params[depth]), params, depth + 1);
+    specialize_tree(s, params, depth + 1);
+}
+
+Pipeline make_specialize_tree() {
+    ImageParam input(Float(32), 2, "input");
+    std::vector<Param<bool>> params;
+    Expr e = input(x, y);
+    for (int i = 0; i < 7; i++) {
+        params.emplace_back("p" + std::to_string(i));
+        e = select(params.back(), e * 2 + 1, e - 3);
+    }
+    Func f("specialize_tree");
+    f(x, y) = e;
+    f.vectorize(x, 8).parallel(y);
+    specialize_tree(f, params, 0);
+    return f;
+}
+
+// Counts distinct IR nodes, treating the IR as a DAG.
+class CountIRNodes : public Internal::IRGraphVisitor {
+    std::set<const Internal::IRNode *> seen;
+
+    using Internal::IRGraphVisitor::visit;
+
+    void include(const Expr &e) override {
+        if (seen.insert(e.get()).second) {
+            e.accept(this);
+        }
+    }
+
+    void include(const Internal::Stmt &s) override {
+        if (seen.insert(s.get()).second) {
+            s.accept(this);
+        }
+    }
+
+public:
+    size_t count(const Internal::Stmt &s) {
+        include(s);
+        return seen.size();
+    }
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const Target target = get_jit_target_from_environment();
+
+    struct Case {
+        const char *name;
+        Pipeline (*make)();
+    };
+    const Case cases[] = {
+        {"lots_of_inputs", make_lots_of_inputs},
+        {"blur", make_blur},
+        {"stencil_chain", make_stencil_chain},
+        {"specialize_tree", make_specialize_tree},
+    };
+
+    printf("%-20s %12s %12s %12s %12s\n", "pipeline", "lower (ms)", "object (ms)", "jit (ms)", "IR nodes");
+    for (const Case &c : cases) {
+        // Use a fresh pipeline for each measurement, so that nothing is
+        // cached between them.
+        std::vector<Module> modules;
+        double t_lower = benchmark(1, 1, [&]() {
+            Pipeline p = c.make();
+            modules.push_back(p.compile_to_module(p.infer_arguments(), c.name, target));
+        });
+        size_t ir_nodes = 0;
+        CountIRNodes counter;
+        for (const auto &f : modules.back().functions()) {
+            ir_nodes = counter.count(f.body);
+        }
+
+        Internal::TemporaryFile object(c.name, ".o");
+        double t_object = benchmark(1, 1, [&]() {
+            Pipeline p = c.make();
+            p.compile_to_object(object.pathname(), p.infer_arguments(), c.name, target);
+        });
+
+        double t_jit = benchmark(1, 1, [&]() {
+            Pipeline p = c.make();
+            p.compile_jit(target);
+        });
+
+        printf("%-20s %12.1f %12.1f %12.1f %12zu\n", c.name,
+               t_lower * 1e3, t_object * 1e3, t_jit * 1e3, ir_nodes);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "Halide.h"
 #include <cstdio>
 #include <cstdint>
+#include <limits>
 #include <random>
 #include "halide_benchmark.h"
 
@@ -104,6 +105,93 @@ bool test(int w, bool div) {
 
 }
 
+// Division by a value that is not a constant, but doesn't vary within
+// the loop, like a Param.
+template<typename T>
+bool test_param(int w, bool div) {
+    Func f, g;
+    Var x, y;
+    Param<T> divisor;
+
+    size_t bits = sizeof(T)*8;
+    bool is_signed = (T)(-1) < (T)(0);
+
+    printf("%sInt(%2d, %2d)    ",
+           is_signed ? " " : "U",
+           (int)bits, w);
+
+    const int h = 16;
+    Buffer<T> input(w * 256, h);
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            uint32_t bits = (uint32_t) rng();
+            input(x, y) = (T)bits;
+        }
+    }
+
+    // The reference version loads the divisor from memory, so it
+    // uses the hardware division.
+    Buffer<T> divisors(input.width());
+
+    if (div) {
+        f(x, y) = input(x, y) / divisor;
+        g(x, y) = input(x, y) / divisors(x);
+    } else {
+        f(x, y) = input(x, y) % divisor;
+        g(x, y) = input(x, y) % divisors(x);
+    }
+
+    if (w > 1) {
+        f.vectorize(x, w);
+        g.vectorize(x, w);
+    }
+
+    f.compile_jit();
+    g.compile_jit();
+
+    std::vector<T> values = {1, 2, 3, 7, 10, 100, 127};
+    values.push_back(std::numeric_limits<T>::max());
+    if (bits > 8) {
+        values.push_back(1000);
+    }
+    if (is_signed) {
+        values.push_back((T)(-3));
+        values.push_back((T)(-100));
+        values.push_back(std::numeric_limits<T>::min());
+    } else {
+        values.push_back((T)(std::numeric_limits<T>::max() / 2 + 1));
+    }
+
+    Buffer<T> fast(input.width(), h), correct(input.width(), h);
+    double t_fast = 0, t_correct = 0;
+    for (T d : values) {
+        divisor.set(d);
+        divisors.fill(d);
+
+        t_correct += benchmark([&]() { g.realize(correct); });
+        t_fast += benchmark([&]() { f.realize(fast); });
+
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < input.width(); x++) {
+                if (fast(x, y) != correct(x, y)) {
+                    printf("fast(%d, %d) = %lld instead of %lld (%lld %s %lld)\n",
+                           x, y,
+                           (long long int)fast(x, y),
+                           (long long int)correct(x, y),
+                           (long long int)input(x, y),
+                           div ? "/" : "%",
+                           (long long int)d);
+                    return false;
+                }
+            }
+        }
+    }
+
+    printf("%6.3f\n", t_correct / t_fast);
+
+    return true;
+}
+
 int main(int argc, char **argv) {
     int seed = argc > 1 ? atoi(argv[1]) : time(nullptr);
     rng.seed(seed);
@@ -129,6 +217,25 @@ int main(int argc, char **argv) {
         success = success && test<uint8_t>(32, i == 0);
     }
 
+    for (int i = 0; i < 2; i++) {
+        const char *name = (i == 0 ? "divisor" : "modulus");
+        printf("type            invariant-%s speed-up\n", name);
+        // Scalar
+        success = success && test_param<int32_t>(1, i == 0);
+        success = success && test_param<int16_t>(1, i == 0);
+        success = success && test_param<int8_t>(1, i == 0);
+        success = success && test_param<uint32_t>(1, i == 0);
+        success = success && test_param<uint16_t>(1, i == 0);
+        success = success && test_param<uint8_t>(1, i == 0);
+        // Vector
+        success = success && test_param<int32_t>(8, i == 0);
+        success = success && test_param<int16_t>(16, i == 0);
+        success = success && test_param<int8_t>(32, i == 0);
+        success = success && test_param<uint32_t>(8, i == 0);
+        success = success && test_param<uint16_t>(16, i == 0);
+        success = success && test_param<uint8_t>(32, i == 0);
+    }
+
     if (success) {
         printf("Success!\n");
         return 0;
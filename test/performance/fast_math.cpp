@@ -0,0 +1,121 @@
+#include "Halide.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "halide_benchmark.h"
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// The distance between two floats in units in the last place.
+double ulps(float a, float b) {
+    int32_t ia, ib;
+    memcpy(&ia, &a, 4);
+    memcpy(&ib, &b, 4);
+    if (ia < 0) ia = INT32_MIN - ia;
+    if (ib < 0) ib = INT32_MIN - ib;
+    return (double)(ia > ib ? (uint32_t)ia - (uint32_t)ib : (uint32_t)ib - (uint32_t)ia);
+}
+
+double ulps(double a, double b) {
+    int64_t ia, ib;
+    memcpy(&ia, &a, 8);
+    memcpy(&ib, &b, 8);
+    if (ia < 0) ia = INT64_MIN - ia;
+    if (ib < 0) ib = INT64_MIN - ib;
+    return (double)(ia > ib ? (uint64_t)ia - (uint64_t)ib : (uint64_t)ib - (uint64_t)ia);
+}
+
+// Check the accuracy of a fast function against the C library, and
+// compare its speed with Halide's own version. Returns false on
+// failure.
+template<typename T>
+bool test(const char *name, std::function<Expr(Expr, int)> fast, std::function<Expr(Expr)> slow,
+          std::function<double(double)> ref, double lo, double hi, int max_ulp_error) {
+    const int N = 1024 * 1024;
+    Var x;
+    Expr in = cast<T>(lo + (hi - lo) * (cast<double>(x) / N));
+
+    Func f, g;
+    f(x) = fast(in, max_ulp_error);
+    g(x) = slow(in);
+    const int vec = 32 / sizeof(T);
+    f.vectorize(x, vec);
+    g.vectorize(x, vec);
+    f.compile_jit();
+    g.compile_jit();
+
+    Buffer<T> fast_result(N), slow_result(N);
+    f.realize(fast_result);
+    g.realize(slow_result);
+
+    double worst = 0;
+    for (int i = 0; i < N; i++) {
+        T arg = (T)(lo + (hi - lo) * ((double)i / N));
+        T correct = (T)ref(arg);
+        worst = std::max(worst, ulps(fast_result(i), correct));
+    }
+
+    double t_fast = benchmark([&]() { f.realize(fast_result); });
+    double t_slow = benchmark([&]() { g.realize(slow_result); });
+
+    printf("%s<%s>(max_ulp_error = %d): %f ns per element "
+           "(without fast_: %f ns), worst error %.0f ulps\n",
+           name, sizeof(T) == 4 ? "float" : "double", max_ulp_error,
+           1e9 * t_fast / N, 1e9 * t_slow / N, worst);
+
+    // Allow a little slack for rounding of the reference and for
+    // fused multiply-adds.
+    int bound = max_ulp_error == 0 ? (sizeof(T) == 4 ? 600 : 70) : max_ulp_error;
+    if (worst > bound + 2) {
+        printf("Error for %s too large\n", name);
+        return false;
+    }
+
+    if (max_ulp_error == 0 && t_slow < t_fast) {
+        printf("%s is slower than the version without fast_\n", name);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool test_all(int max_ulp_error) {
+    Expr (*halide_sin)(Expr) = Halide::sin;
+    Expr (*halide_cos)(Expr) = Halide::cos;
+    Expr (*halide_atan)(Expr) = Halide::atan;
+    Expr (*halide_tanh)(Expr) = Halide::tanh;
+    double (*c_sin)(double) = std::sin;
+    double (*c_cos)(double) = std::cos;
+    double (*c_atan)(double) = std::atan;
+    double (*c_tanh)(double) = std::tanh;
+
+    // atan2 along the line x = 3 - y, which crosses three quadrants.
+    auto fast_atan2_line = [](Expr y, int max_ulp_error) {
+        return fast_atan2(y, 3 - y, max_ulp_error);
+    };
+    auto halide_atan2_line = [](Expr y) {
+        return atan2(y, 3 - y);
+    };
+    auto c_atan2_line = [](double y) {
+        return std::atan2(y, (double)(T)(3 - y));
+    };
+
+    return (test<T>("fast_sin", fast_sin, halide_sin, c_sin, -100, 100, max_ulp_error) &&
+            test<T>("fast_cos", fast_cos, halide_cos, c_cos, -100, 100, max_ulp_error) &&
+            test<T>("fast_atan", fast_atan, halide_atan, c_atan, -20, 20, max_ulp_error) &&
+            test<T>("fast_atan2", fast_atan2_line, halide_atan2_line, c_atan2_line, -20, 20, max_ulp_error) &&
+            test<T>("fast_tanh", fast_tanh, halide_tanh, c_tanh, -10, 10, max_ulp_error));
+}
+
+int main(int argc, char **argv) {
+    for (int max_ulp_error : {0, 16, 6}) {
+        if (!test_all<float>(max_ulp_error) ||
+            !test_all<double>(max_ulp_error)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
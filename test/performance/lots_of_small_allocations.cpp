@@ -6,10 +6,10 @@ using namespace Halide;
 int main(int argc, char **argv) {
     Param<int> p;
 
-    const char *names[3] = {"heap", "pseudostack", "stack"};
+    const char *names[4] = {"heap", "pseudostack", "stack", "hoisted heap"};
 
-    double t[3];
-    for (int i = 0; i < 3; i++) {
+    double t[4];
+    for (int i = 0; i < 4; i++) {
         Var x("x");
 
         Func in;
@@ -27,21 +27,26 @@ int main(int argc, char **argv) {
 
         Var xo, xi;
         chain.back().split(x, xo, xi, p, TailStrategy::RoundUp);
+        Var xoo;
         for (size_t j = 0; j < chain.size() - 1; j++) {
             chain[j].compute_at(chain.back(), xo);
-            if (i != 0) {
+            if (i == 1 || i == 2) {
                 chain[j].store_in(MemoryType::Stack);
             }
             if (i == 2) {
                 chain[j].bound_extent(x, p);
             }
+            if (i == 3) {
+                // Keep the heap allocations alive across the serial
+                // loop inside each parallel task.
+                chain[j].hoist_storage(chain.back(), xoo);
+            }
             // Vectorize. Otherwise llvm autovectorizes the stack version, confusing the results
             chain[j].vectorize(x, 8, TailStrategy::RoundUp);
         }
         // One of the problems with frequent heap allocations is that
         // they can serialize in the allocator, so we should
         // parallelize things too.
-        Var xoo;
         if (i == 2) {
             chain.back().specialize(p == 200).split(xo, xoo, xo, 100, TailStrategy::RoundUp).parallel(xoo);
             chain.back().specialize_fail("Expected p == 200");
@@ -66,5 +71,10 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    if (t[0] < t[3]) {
+        printf("Heap allocation was faster than hoisted heap allocation!\n");
+        return -1;
+    }
+
     return 0;
 }
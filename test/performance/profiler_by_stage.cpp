@@ -0,0 +1,58 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int expensive_percentage = -1, cheap_percentage = -1;
+void my_print(void *, const char *msg) {
+    float ms;
+    int percentage;
+    if (sscanf(msg, " f.update(0): %fms (%d", &ms, &percentage) == 2) {
+        expensive_percentage = percentage;
+    }
+    if (sscanf(msg, " f.update(1): %fms (%d", &ms, &percentage) == 2) {
+        cheap_percentage = percentage;
+    }
+}
+
+Expr burn(Expr e, int iters) {
+    for (int i = 0; i < iters; i++) {
+        e = sin(e);
+    }
+    return e;
+}
+
+int main(int argc, char **argv) {
+    // A Func with two update stages, one of which is much more
+    // expensive than the other. With profile_by_stage, the profiler
+    // should report them separately.
+    Func f("f");
+    Var x, y;
+    f(x, y) = cast<float>(x + y);
+    f(x, y) += burn(f(x, y), 300);
+    f(x, y) += burn(f(x, y), 50);
+
+    f.update(0).parallel(y);
+
+    f.set_custom_print(&my_print);
+
+    Target t = get_jit_target_from_environment()
+        .with_feature(Target::Profile)
+        .with_feature(Target::ProfileByStage);
+    f.realize(1000, 100, t);
+
+    printf("f.update(0): %d%% f.update(1): %d%%\n", expensive_percentage, cheap_percentage);
+
+    if (expensive_percentage < 0 || cheap_percentage < 0) {
+        printf("Didn't find both update stages in the profiler output\n");
+        return -1;
+    }
+
+    if (expensive_percentage <= cheap_percentage) {
+        printf("The expensive update should have been billed more time than the cheap one\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+float kernel_ms = -1, copy_ms = -1;
+int kernel_launches = 0;
+void my_print(void *, const char *msg) {
+    float ms;
+    int count;
+    if (sscanf(msg, " kernel_f_%*[^:]: %fms launches: %d", &ms, &count) == 2) {
+        kernel_ms = ms;
+        kernel_launches = count;
+    }
+    if (sscanf(msg, " copy to host: %fms", &ms) == 1) {
+        copy_ms = ms;
+    }
+}
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment();
+    if (!t.has_feature(Target::CUDA)) {
+        printf("Not running with CUDA. Skipping test.\n");
+        return 0;
+    }
+
+    // A kernel whose output is consumed on the host, so that it is
+    // copied back within the pipeline. With the profiler on, the
+    // kernel and the copy should be timed on the device.
+    Func f("f"), g("g");
+    Var x("x"), y("y"), xo, yo, xi, yi;
+    Expr e = cast<float>(x + y);
+    for (int i = 0; i < 100; i++) {
+        e = sin(e);
+    }
+    f(x, y) = e;
+    g(x, y) = f(x, y) * 2.0f;
+
+    f.compute_root().gpu_tile(x, y, xo, yo, xi, yi, 16, 16);
+
+    g.set_custom_print(&my_print);
+    g.realize(1024, 1024, t.with_feature(Target::Profile));
+
+    printf("kernel: %fms (%d launches), copy to host: %fms\n",
+           kernel_ms, kernel_launches, copy_ms);
+
+    if (kernel_ms < 0 || kernel_launches != 1) {
+        printf("The kernel was not timed once\n");
+        return -1;
+    }
+
+    if (copy_ms < 0) {
+        printf("The copy to host was not timed\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int expensive_percentage = -1, cheap_percentage = -1;
+void my_print(void *, const char *msg) {
+    float ms;
+    int percentage;
+    if (sscanf(msg, " expensive: %fms (%d", &ms, &percentage) == 2) {
+        expensive_percentage = percentage;
+    }
+    if (sscanf(msg, " cheap: %fms (%d", &ms, &percentage) == 2) {
+        cheap_percentage = percentage;
+    }
+}
+
+Expr burn(Expr e, int iters) {
+    for (int i = 0; i < iters; i++) {
+        e = sin(e);
+    }
+    return e;
+}
+
+int main(int argc, char **argv) {
+    // Two Funcs computed concurrently on different threads, one of
+    // which is much more expensive than the other. The profiler
+    // should bill time to the one that's actually running on each
+    // thread, rather than to whichever Func last started.
+    Func expensive("expensive"), cheap("cheap"), out("out");
+    Var x, y;
+    expensive(x, y) = burn(cast<float>(x + y), 300);
+    cheap(x, y) = burn(cast<float>(x - y), 50);
+    out(x, y) = expensive(x, y) + cheap(x, y);
+
+    expensive.compute_root().async().parallel(y);
+    cheap.compute_root().async().parallel(y);
+
+    out.set_custom_print(&my_print);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::Profile);
+    out.realize(1000, 100, t);
+
+    printf("expensive: %d%% cheap: %d%%\n", expensive_percentage, cheap_percentage);
+
+    if (expensive_percentage < 0 || cheap_percentage < 0) {
+        printf("Didn't find both Funcs in the profiler output\n");
+        return -1;
+    }
+
+    if (expensive_percentage <= cheap_percentage) {
+        printf("The expensive Func should have been billed more time than the cheap one\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
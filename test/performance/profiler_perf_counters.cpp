@@ -0,0 +1,88 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Halide;
+
+float compute_ipc = -1, memory_ipc = -1;
+float compute_mpki = -1, memory_mpki = -1;
+void my_print(void *, const char *msg) {
+    float *ipc = NULL, *mpki = NULL;
+    if (strstr(msg, " compute_bound: ")) {
+        ipc = &compute_ipc;
+        mpki = &compute_mpki;
+    } else if (strstr(msg, " memory_bound: ")) {
+        ipc = &memory_ipc;
+        mpki = &memory_mpki;
+    } else {
+        return;
+    }
+    const char *ipc_str = strstr(msg, " ipc: ");
+    const char *mpki_str = strstr(msg, " llc mpki: ");
+    if (ipc_str) {
+        sscanf(ipc_str, " ipc: %f", ipc);
+    }
+    if (mpki_str) {
+        sscanf(mpki_str, " llc mpki: %f", mpki);
+    }
+}
+
+int main(int argc, char **argv) {
+    #ifdef _WIN32
+    printf("Test skipped on windows due to use of setenv\n");
+    #else
+    setenv("HL_PROFILER_PERF_COUNTERS", "1", 1);
+
+    // One Func that does a lot of arithmetic on values in registers,
+    // and one that does little more than random reads from a buffer
+    // much larger than the last level cache.
+    const int size = 64 * 1024 * 1024;
+    Buffer<int> table(size);
+    table.fill(7);
+
+    Func compute_bound("compute_bound"), memory_bound("memory_bound"), out("out");
+    Var x;
+    Expr e = cast<float>(x);
+    for (int i = 0; i < 200; i++) {
+        e = e * 1.0001f + 0.5f;
+    }
+    compute_bound(x) = e;
+    memory_bound(x) = table(((x * 1103515245 + 12345) & 0x7fffffff) % size);
+    out(x) = compute_bound(x) + memory_bound(x);
+
+    compute_bound.compute_root();
+    memory_bound.compute_root();
+
+    out.set_custom_print(&my_print);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::Profile);
+    out.realize(10 * 1024 * 1024, t);
+
+    if (compute_ipc < 0 && memory_ipc < 0) {
+        // Either this isn't x86 linux, or the kernel won't let us read
+        // the hardware counters (e.g. in a VM, or because of
+        // perf_event_paranoid).
+        printf("Hardware performance counters unavailable. Skipping test.\n");
+        printf("Success!\n");
+        return 0;
+    }
+
+    printf("compute_bound: ipc %f llc mpki %f\n"
+           "memory_bound: ipc %f llc mpki %f\n",
+           compute_ipc, compute_mpki, memory_ipc, memory_mpki);
+
+    if (compute_ipc <= 0 || memory_ipc <= 0) {
+        printf("Didn't find counters for both Funcs in the profiler output\n");
+        return -1;
+    }
+
+    if (memory_mpki <= compute_mpki) {
+        printf("The memory-bound Func should have more cache misses per instruction\n");
+        return -1;
+    }
+    #endif
+
+    printf("Success!\n");
+    return 0;
+}
@@ -129,6 +129,22 @@ int main(int argc, char **argv) {
         std::cout << "One argument Pipeline realize reusing Realization/Target/ParamMap time " << t * 1e6 << "us.\n";
     }
 
+    {
+        Func f;
+        Param<int> in;
+
+        f() = in + 42;
+
+        in.set(0);
+
+        Pipeline p(f);
+        auto buf = Buffer<int32_t>::make_scalar();
+        JITBoundCall call = p.bind(buf);
+
+        double t = benchmark([&]() { call.run(); });
+        std::cout << "One argument Pipeline bound call time " << t * 1e6 << "us.\n";
+    }
+
     for (int i = 10; i < 100; i += 10) {
         Func f;
         std::vector<Param<int>> params(i);
@@ -145,6 +161,10 @@ int main(int argc, char **argv) {
         auto buf = Buffer<int32_t>::make_scalar();
         double t = benchmark([&]() { f.realize(buf); });
         std::cout << std::to_string(i) << "-argument Func realize to Buffer time " << t * 1e6 << "us.\n";
+
+        JITBoundCall call = Pipeline(f).bind(buf);
+        t = benchmark([&]() { call.run(); });
+        std::cout << std::to_string(i) << "-argument Pipeline bound call time " << t * 1e6 << "us.\n";
     }
 
     std::cout << "Success!\n";
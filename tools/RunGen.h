@@ -4,7 +4,9 @@
 #include "halide_image_io.h"
 
 #include <cstdio>
+#include <atomic>
 #include <cstdlib>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -13,6 +15,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace Halide {
@@ -24,6 +27,8 @@ using ::Halide::Runtime::Buffer;
 // provide a typedef for it (and doesn't use a vector for it in any event).
 using Shape = std::vector<halide_dimension_t>;
 
+using SteadyTimePoint = decltype(Halide::Tools::benchmark_now());
+
 // Standard stream output for halide_type_t
 inline std::ostream &operator<<(std::ostream &stream, const halide_type_t &type) {
     if (type.code == halide_type_uint && type.bits == 1) {
@@ -1160,11 +1165,19 @@ public:
         }
     }
 
+    // If num_threads is nonzero, the Halide thread pool is set to that
+    // many threads for the duration of the benchmark.
     void run_for_benchmark(double benchmark_min_time,
                            uint64_t benchmark_min_iters,
-                           uint64_t benchmark_max_iters) {
+                           uint64_t benchmark_max_iters,
+                           int num_threads = 0) {
         std::vector<void*> filter_argv = build_filter_argv();
 
+        int old_num_threads = 0;
+        if (num_threads > 0) {
+            old_num_threads = halide_set_num_threads(num_threads);
+        }
+
         const auto benchmark_inner = [this, &filter_argv]() {
             // Ignore result since our halide_error() should catch everything.
             (void) halide_argv_call(&filter_argv[0]);
@@ -1180,6 +1193,22 @@ public:
         config.max_time = benchmark_min_time * 4;
         config.min_iters = benchmark_min_iters;
         config.max_iters = benchmark_max_iters;
+
+        if (benchmark_distribution || benchmark_cold_cache || json_output) {
+            run_for_benchmark_stats(benchmark_inner, config, num_threads);
+        } else {
+            run_for_benchmark_best(benchmark_inner, config, num_threads);
+        }
+
+        if (num_threads > 0) {
+            halide_set_num_threads(old_num_threads);
+        }
+    }
+
+    // Report the best sample, as chosen by the adaptive benchmark().
+    void run_for_benchmark_best(const std::function<void()> &benchmark_inner,
+                                const Halide::Tools::BenchmarkConfig &config,
+                                int num_threads) {
         auto result = Halide::Tools::benchmark(benchmark_inner, config);
 
         if (!parsable_output) {
@@ -1195,6 +1224,196 @@ public:
                   << md->name << "  TIMING_ACCURACY          " << result.accuracy << "\n"
                   << md->name << "  THROUGHPUT_MPIX_PER_SEC  " << (megapixels_out() / result.wall_time) << "\n"
                   << md->name << "  HALIDE_TARGET            " << md->target << "\n";
+            if (num_threads > 0) {
+                out() << md->name << "  NUM_THREADS              " << num_threads << "\n";
+            }
+        }
+    }
+
+    // Report the distribution of times over all samples.
+    void run_for_benchmark_stats(const std::function<void()> &benchmark_inner,
+                                 const Halide::Tools::BenchmarkConfig &config,
+                                 int num_threads) {
+        std::function<void()> before_sample;
+        if (benchmark_cold_cache) {
+            before_sample = [this]() { flush_caches(); };
+        }
+        auto stats = Halide::Tools::benchmark_stats(benchmark_inner, config, before_sample);
+        const char *cache = benchmark_cold_cache ? "cold" : "warm";
+
+        if (json_output) {
+            // One self-contained JSON object per line.
+            std::ostringstream o;
+            o << std::setprecision(6)
+              << "{\"name\": \"" << md->name << "\""
+              << ", \"target\": \"" << md->target << "\""
+              << ", \"num_threads\": " << num_threads
+              << ", \"cache\": \"" << cache << "\""
+              << ", \"samples\": " << stats.samples
+              << ", \"iterations_per_sample\": " << stats.iterations_per_sample
+              << ", \"min_msec\": " << stats.min * 1000
+              << ", \"median_msec\": " << stats.median * 1000
+              << ", \"p90_msec\": " << stats.p90 * 1000
+              << ", \"p99_msec\": " << stats.p99 * 1000
+              << ", \"mean_msec\": " << stats.mean * 1000
+              << ", \"stddev_msec\": " << stats.stddev * 1000
+              << ", \"median_throughput_mpix_per_sec\": " << (megapixels_out() / stats.median)
+              << "}\n";
+            out() << o.str();
+        } else if (!parsable_output) {
+            out() << "Benchmark for " << md->name << " (" << cache << " cache"
+                  << (num_threads > 0 ? ", " + std::to_string(num_threads) + " threads" : std::string())
+                  << ") over " << stats.samples << " samples of "
+                  << stats.iterations_per_sample << " iterations:\n"
+                  << "  min " << stats.min << " median " << stats.median
+                  << " p90 " << stats.p90 << " p99 " << stats.p99 << " sec/iter\n"
+                  << "  mean " << stats.mean << " stddev " << stats.stddev << " sec/iter\n"
+                  << "Median output throughput is " << (megapixels_out() / stats.median) << " mpix/sec.\n";
+        } else {
+            out() << md->name << "  MIN_TIME_MSEC_PER_ITER     " << stats.min * 1000.f << "\n"
+                  << md->name << "  MEDIAN_TIME_MSEC_PER_ITER  " << stats.median * 1000.f << "\n"
+                  << md->name << "  P90_TIME_MSEC_PER_ITER     " << stats.p90 * 1000.f << "\n"
+                  << md->name << "  P99_TIME_MSEC_PER_ITER     " << stats.p99 * 1000.f << "\n"
+                  << md->name << "  MEAN_TIME_MSEC_PER_ITER    " << stats.mean * 1000.f << "\n"
+                  << md->name << "  STDDEV_TIME_MSEC_PER_ITER  " << stats.stddev * 1000.f << "\n"
+                  << md->name << "  SAMPLES                    " << stats.samples << "\n"
+                  << md->name << "  ITERATIONS_PER_SAMPLE      " << stats.iterations_per_sample << "\n"
+                  << md->name << "  CACHE                      " << cache << "\n"
+                  << md->name << "  THROUGHPUT_MPIX_PER_SEC    " << (megapixels_out() / stats.median) << "\n"
+                  << md->name << "  HALIDE_TARGET              " << md->target << "\n";
+            if (num_threads > 0) {
+                out() << md->name << "  NUM_THREADS                " << num_threads << "\n";
+            }
+        }
+    }
+
+    // Evict the filter's inputs and outputs from the CPU caches, by
+    // touching a buffer larger than any last-level cache we expect.
+    void flush_caches() {
+        constexpr size_t kFlushBytes = 128 * 1024 * 1024;
+        constexpr size_t kCacheLineBytes = 64;
+        if (cache_flush_buffer.empty()) {
+            cache_flush_buffer.resize(kFlushBytes);
+        }
+        volatile uint8_t *p = cache_flush_buffer.data();
+        for (size_t i = 0; i < kFlushBytes; i += kCacheLineBytes) {
+            p[i] = p[i] + 1;
+        }
+    }
+
+    // Call the filter from 'concurrency' host threads at once, each
+    // making 'batch' calls on its own copies of the input and output
+    // buffers, as a server handling concurrent requests would. All
+    // threads share the Halide thread pool. Reports the aggregate
+    // throughput, and the distribution of per-call latency.
+    void run_for_concurrency(int concurrency, int batch) {
+        struct Caller {
+            std::vector<Buffer<>> buffers;
+            std::vector<void *> filter_argv;
+            std::vector<double> latencies;
+            SteadyTimePoint start, end;
+        };
+        std::vector<Caller> callers(concurrency);
+        for (auto &c : callers) {
+            c.filter_argv = build_filter_argv();
+            c.buffers.resize(args.size());
+            for (auto &arg_pair : args) {
+                auto &arg = arg_pair.second;
+                if (arg.metadata->kind != halide_argument_kind_input_scalar) {
+                    c.buffers[arg.index] = arg.buffer_value.copy();
+                    c.filter_argv[arg.index] = c.buffers[arg.index].raw_buffer();
+                }
+            }
+            c.latencies.reserve(batch);
+        }
+
+        info() << "Running filter from " << concurrency << " threads, " << batch << " calls each...";
+
+        const auto call = [this](Caller &c) {
+            // Ignore result since our halide_error() should catch everything.
+            (void)halide_argv_call(&c.filter_argv[0]);
+            for (auto &arg_pair : args) {
+                auto &arg = arg_pair.second;
+                if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+                    c.buffers[arg.index].device_sync();
+                }
+            }
+        };
+
+        // Each thread makes one untimed call to warm up, then waits for
+        // all the others to do so before starting.
+        std::atomic<int> ready(0);
+        const auto caller_main = [&](Caller &c) {
+            call(c);
+            ready++;
+            while (ready < concurrency) {
+                std::this_thread::yield();
+            }
+            c.start = Halide::Tools::benchmark_now();
+            for (int i = 0; i < batch; i++) {
+                auto t0 = Halide::Tools::benchmark_now();
+                call(c);
+                auto t1 = Halide::Tools::benchmark_now();
+                c.latencies.push_back(Halide::Tools::benchmark_duration_seconds(t0, t1));
+            }
+            c.end = Halide::Tools::benchmark_now();
+        };
+        std::vector<std::thread> threads;
+        for (int i = 1; i < concurrency; i++) {
+            threads.emplace_back(caller_main, std::ref(callers[i]));
+        }
+        caller_main(callers[0]);
+        for (auto &t : threads) {
+            t.join();
+        }
+
+        std::vector<double> latencies;
+        auto start = callers[0].start, end = callers[0].end;
+        for (const auto &c : callers) {
+            latencies.insert(latencies.end(), c.latencies.begin(), c.latencies.end());
+            start = std::min(start, c.start);
+            end = std::max(end, c.end);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const double wall_time = Halide::Tools::benchmark_duration_seconds(start, end);
+        const double calls_per_sec = latencies.size() / wall_time;
+        const double median = Halide::Tools::benchmark_percentile(latencies, 0.5);
+        const double p90 = Halide::Tools::benchmark_percentile(latencies, 0.9);
+        const double p99 = Halide::Tools::benchmark_percentile(latencies, 0.99);
+
+        if (json_output) {
+            std::ostringstream o;
+            o << std::setprecision(6)
+              << "{\"name\": \"" << md->name << "\""
+              << ", \"target\": \"" << md->target << "\""
+              << ", \"concurrency\": " << concurrency
+              << ", \"batch\": " << batch
+              << ", \"calls_per_sec\": " << calls_per_sec
+              << ", \"throughput_mpix_per_sec\": " << (megapixels_out() * calls_per_sec)
+              << ", \"min_latency_msec\": " << latencies.front() * 1000
+              << ", \"median_latency_msec\": " << median * 1000
+              << ", \"p90_latency_msec\": " << p90 * 1000
+              << ", \"p99_latency_msec\": " << p99 * 1000
+              << ", \"max_latency_msec\": " << latencies.back() * 1000
+              << "}\n";
+            out() << o.str();
+        } else if (!parsable_output) {
+            out() << "Throughput for " << md->name << " with " << concurrency << " concurrent callers making "
+                  << batch << " calls each is " << calls_per_sec << " calls/sec ("
+                  << (megapixels_out() * calls_per_sec) << " mpix/sec).\n"
+                  << "Per-call latency: min " << latencies.front() << " median " << median
+                  << " p90 " << p90 << " p99 " << p99 << " max " << latencies.back() << " sec.\n";
+        } else {
+            out() << md->name << "  CONCURRENCY                " << concurrency << "\n"
+                  << md->name << "  BATCH                      " << batch << "\n"
+                  << md->name << "  CALLS_PER_SEC              " << calls_per_sec << "\n"
+                  << md->name << "  THROUGHPUT_MPIX_PER_SEC    " << (megapixels_out() * calls_per_sec) << "\n"
+                  << md->name << "  MIN_LATENCY_MSEC           " << latencies.front() * 1000.f << "\n"
+                  << md->name << "  MEDIAN_LATENCY_MSEC        " << median * 1000.f << "\n"
+                  << md->name << "  P90_LATENCY_MSEC           " << p90 * 1000.f << "\n"
+                  << md->name << "  P99_LATENCY_MSEC           " << p99 * 1000.f << "\n"
+                  << md->name << "  MAX_LATENCY_MSEC           " << latencies.back() * 1000.f << "\n"
+                  << md->name << "  HALIDE_TARGET              " << md->target << "\n";
         }
     }
 
@@ -1274,6 +1493,18 @@ public:
         this->parsable_output = parsable_output;
     }
 
+    void set_json_output(bool json_output = true) {
+        this->json_output = json_output;
+    }
+
+    void set_benchmark_distribution(bool benchmark_distribution = true) {
+        this->benchmark_distribution = benchmark_distribution;
+    }
+
+    void set_benchmark_cold_cache(bool benchmark_cold_cache = true) {
+        this->benchmark_cold_cache = benchmark_cold_cache;
+    }
+
 private:
     std::map<std::string, Shape> bounds_query_input_shapes() const {
         assert(!output_shapes.empty());
@@ -1332,6 +1563,10 @@ private:
     std::map<std::string, ArgData> args;
     std::map<std::string, Shape> output_shapes;
     bool parsable_output = false;
+    bool json_output = false;
+    bool benchmark_distribution = false;
+    bool benchmark_cold_cache = false;
+    std::vector<uint8_t> cache_flush_buffer;
 };
 
 }  // namespace RunGen
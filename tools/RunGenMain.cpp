@@ -147,6 +147,33 @@ Flags:
         Override the default maximum number of benchmarking iterations; ignored
         if --benchmarks is not also specified.
 
+    --benchmark_distribution:
+        Instead of reporting only the fastest sample, time at least 10
+        samples and report the min, median, 90th and 99th percentile, mean,
+        and standard deviation of the time per iteration; ignored if
+        --benchmarks is not also specified.
+
+    --benchmark_cold_cache:
+        Flush the CPU caches before each benchmark sample (outside of the
+        timed region), and run a single iteration per sample, to measure
+        performance when inputs are not already in cache. Implies
+        --benchmark_distribution.
+
+    --benchmark_threads=N1,N2,...:
+        Run the benchmark once for each of the given Halide thread pool
+        sizes, rather than once with the default number of threads.
+
+    --concurrency=N [default = 1]:
+        Measure throughput by calling the filter from N host threads at
+        once, each with its own copies of the input and output buffers,
+        sharing the Halide thread pool. Reports the aggregate calls/sec and
+        the distribution of per-call latency.
+
+    --batch=N [default = 10]:
+        The number of calls each thread makes when measuring throughput
+        (after one untimed warm-up call). Specifying either --batch or
+        --concurrency enables throughput measurement.
+
     --track_memory:
         Override Halide memory allocator to track high-water mark of memory
         allocation during run; note that this may slow down execution, so
@@ -165,6 +192,11 @@ Flags:
         Final output is emitted in an easy-to-parse output (one value per line),
         rather than easy-for-humans.
 
+    --json_output:
+        Benchmark results are emitted as one JSON object per line (per
+        benchmark run), for consumption by other tools. Implies
+        --benchmark_distribution.
+
 Known Issues:
 
     * Filters running on GPU (vs CPU) have not been tested.
@@ -372,6 +404,10 @@ int main(int argc, char **argv) {
     double benchmark_min_time = BenchmarkConfig().min_time;
     uint64_t benchmark_min_iters = BenchmarkConfig().min_iters;
     uint64_t benchmark_max_iters = BenchmarkConfig().max_iters;
+    std::vector<int> benchmark_threads;
+    bool throughput = false;
+    int concurrency = 1;
+    int batch = 10;
     std::string default_input_buffers;
     std::string default_input_scalars;
     for (int i = 1; i < argc; ++i) {
@@ -413,6 +449,15 @@ int main(int argc, char **argv) {
                     fail() << "Invalid value for flag: " << flag_name;
                 }
                 r.set_parsable_output(parsable_output);
+            } else if (flag_name == "json_output") {
+                if (flag_value.empty()) {
+                    flag_value = "true";
+                }
+                bool json_output;
+                if (!parse_scalar(flag_value, &json_output)) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                r.set_json_output(json_output);
             } else if (flag_name == "describe") {
                 if (flag_value.empty()) {
                     flag_value = "true";
@@ -444,6 +489,43 @@ int main(int argc, char **argv) {
                 if (!parse_scalar(flag_value, &benchmark_max_iters)) {
                     fail() << "Invalid value for flag: " << flag_name;
                 }
+            } else if (flag_name == "benchmark_distribution") {
+                if (flag_value.empty()) {
+                    flag_value = "true";
+                }
+                bool benchmark_distribution;
+                if (!parse_scalar(flag_value, &benchmark_distribution)) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                r.set_benchmark_distribution(benchmark_distribution);
+            } else if (flag_name == "benchmark_cold_cache") {
+                if (flag_value.empty()) {
+                    flag_value = "true";
+                }
+                bool benchmark_cold_cache;
+                if (!parse_scalar(flag_value, &benchmark_cold_cache)) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                r.set_benchmark_cold_cache(benchmark_cold_cache);
+            } else if (flag_name == "benchmark_threads") {
+                benchmark_threads.clear();
+                for (const auto &s : split_string(flag_value, ",")) {
+                    int n;
+                    if (!parse_scalar(s, &n) || n <= 0) {
+                        fail() << "Invalid value for flag: " << flag_name;
+                    }
+                    benchmark_threads.push_back(n);
+                }
+            } else if (flag_name == "concurrency") {
+                if (!parse_scalar(flag_value, &concurrency) || concurrency <= 0) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                throughput = true;
+            } else if (flag_name == "batch") {
+                if (!parse_scalar(flag_value, &batch) || batch <= 0) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                throughput = true;
             } else if (flag_name == "default_input_buffers") {
                 default_input_buffers = flag_value;
                 if (default_input_buffers.empty()) {
@@ -477,7 +559,7 @@ int main(int argc, char **argv) {
     }
 
     // It's OK to omit output arguments when we are benchmarking or tracking memory.
-    bool ok_to_omit_outputs = (benchmark || track_memory);
+    bool ok_to_omit_outputs = (benchmark || track_memory || throughput);
 
     if (benchmark && track_memory) {
         warn() << "Using --track_memory with --benchmarks will produce inaccurate benchmark results.";
@@ -504,8 +586,17 @@ int main(int argc, char **argv) {
     }
 
     if (benchmark) {
-        r.run_for_benchmark(benchmark_min_time, benchmark_min_iters, benchmark_max_iters);
-    } else {
+        if (benchmark_threads.empty()) {
+            r.run_for_benchmark(benchmark_min_time, benchmark_min_iters, benchmark_max_iters);
+        }
+        for (int num_threads : benchmark_threads) {
+            r.run_for_benchmark(benchmark_min_time, benchmark_min_iters, benchmark_max_iters, num_threads);
+        }
+    }
+    if (throughput) {
+        r.run_for_concurrency(concurrency, batch);
+    }
+    if (!benchmark) {
         r.run_for_output();
     }
 
@@ -4,8 +4,10 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <functional>
 #include <limits>
+#include <vector>
 
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
@@ -210,6 +212,100 @@ inline BenchmarkResult benchmark(std::function<void()> op, const BenchmarkConfig
     return result;
 }
 
+// Nearest-rank percentile (p in [0, 1]) of a sorted, non-empty vector.
+inline double benchmark_percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+struct BenchmarkStats {
+    // Statistics of the elapsed wall-clock time per iteration
+    // (seconds), over all samples.
+    double min, median, p90, p99, mean, stddev;
+
+    // Number of samples measured.
+    uint64_t samples;
+
+    // Number of iterations per sample.
+    uint64_t iterations_per_sample;
+};
+
+// Benchmark the operation 'op', reporting the distribution of the
+// time per iteration across samples rather than just the best one,
+// so that run-to-run variation and tail latency are visible. Samples
+// are taken until config.min_time has elapsed (and at least 10 have
+// been taken), stopping early at config.max_time or config.max_iters.
+// config.accuracy is ignored.
+//
+// If before_sample is given, it is called before each sample, outside
+// of the timed region (e.g. to flush caches). In that case each sample
+// is a single iteration. Otherwise, each sample runs enough iterations
+// (but at least config.min_iters) to be long enough to time reliably.
+//
+// The same caveats about GPU code as for benchmark() above apply.
+inline BenchmarkStats benchmark_stats(std::function<void()> op, const BenchmarkConfig &config = {},
+                                      std::function<void()> before_sample = nullptr) {
+    constexpr uint64_t kMinSamples = 10;
+    // The shortest sample we trust the clock to time accurately.
+    constexpr double kMinSampleTime = 1e-4;
+
+    const double min_time = std::max(10 * 1e-6, config.min_time);
+    const double max_time = std::max(config.min_time, config.max_time);
+    const uint64_t max_iters = std::min(
+            std::max(config.min_iters, config.max_iters), kBenchmarkMaxIterations);
+
+    // Run once to warm up, and to estimate how many iterations a
+    // sample needs.
+    if (before_sample) {
+        before_sample();
+    }
+    const double first = benchmark(1, 1, op);
+    uint64_t iters_per_sample = 1;
+    if (!before_sample) {
+        iters_per_sample = std::max(std::max((uint64_t)1, config.min_iters),
+                                    (uint64_t)(kMinSampleTime / std::max(first, 1e-9) + 0.5));
+        iters_per_sample = std::min(iters_per_sample, max_iters);
+    }
+
+    std::vector<double> times;
+    double total_time = 0;
+    uint64_t iterations = 0;
+    while ((times.size() < kMinSamples || total_time < min_time) &&
+           total_time < max_time &&
+           iterations + iters_per_sample <= max_iters) {
+        if (before_sample) {
+            before_sample();
+        }
+        const double t = benchmark(1, iters_per_sample, op);
+        times.push_back(t);
+        total_time += t * iters_per_sample;
+        iterations += iters_per_sample;
+    }
+    if (times.empty()) {
+        times.push_back(first);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    BenchmarkStats stats;
+    stats.samples = times.size();
+    stats.iterations_per_sample = iters_per_sample;
+    stats.min = times.front();
+    stats.median = benchmark_percentile(times, 0.5);
+    stats.p90 = benchmark_percentile(times, 0.9);
+    stats.p99 = benchmark_percentile(times, 0.99);
+    double sum = 0, sum_sq = 0;
+    for (double t : times) {
+        sum += t;
+    }
+    stats.mean = sum / times.size();
+    for (double t : times) {
+        sum_sq += (t - stats.mean) * (t - stats.mean);
+    }
+    stats.stddev = times.size() > 1 ? std::sqrt(sum_sq / (times.size() - 1)) : 0.0;
+    return stats;
+}
+
 }   // namespace Tools
 }   // mamespace Halide
 
@@ -5,14 +5,18 @@
 #define HALIDE_IMAGE_IO_H
 
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cctype>
 
@@ -24,6 +28,13 @@
 #include "jpeglib.h"
 #endif
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "HalideRuntime.h"  // for halide_type_t
 
 namespace Halide {
@@ -53,6 +64,81 @@ struct FormatInfo {
     }
 };
 
+// A file mapped into memory by map_image(). Images returned by
+// map_image() may point directly into the mapping, so they must not
+// be used after it is closed or destroyed. The mapping is private:
+// writes to the image are not written back to the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&other) {
+        if (this != &other) {
+            close();
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Map the whole file. Returns false if it could not be mapped
+    // (which is always the case on Windows).
+    bool open(const std::string &filename) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        data_ = (uint8_t *)p;
+        size_ = (size_t)st.st_size;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    bool is_open() const { return data_ != nullptr; }
+    uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
 namespace Internal {
 
 // Must be constexpr to allow use in case clauses.
@@ -330,6 +416,35 @@ struct FileOpener {
     FILE * const f;
 };
 
+// Reads from memory with the same interface as FileOpener, so the
+// same code can parse headers out of files and memory mappings.
+struct MemoryReader {
+    MemoryReader(const uint8_t *data, size_t size) : data(data), size(size), offset(0) {}
+
+    bool read_bytes(void *dst, size_t count) {
+        if (count > size - offset) {
+            return false;
+        }
+        memcpy(dst, data + offset, count);
+        offset += count;
+        return true;
+    }
+
+    template<typename T, size_t N>
+    bool read_array(T (&dst)[N]) {
+        return read_bytes(&dst[0], sizeof(T) * N);
+    }
+
+    template<typename T>
+    bool read_vector(std::vector<T> *v) {
+        return read_bytes(v->data(), v->size() * sizeof(T));
+    }
+
+    const uint8_t * const data;
+    const size_t size;
+    size_t offset;
+};
+
 // Read a row of ElemTypes from a byte buffer and copy them into a specific image row.
 // Multibyte elements are assumed to be big-endian.
 template<typename ElemType, typename ImageType>
@@ -714,13 +829,28 @@ bool load_jpg(const std::string &filename, ImageType *im) {
 
     auto copy_to_image = Internal::read_big_endian_row<uint8_t, ImageType>;
 
-    std::vector<uint8_t> row(width * channels);
+    // Decode as many rows per call as the decoder prefers to produce at
+    // once (e.g. a whole MCU row when upsampling chroma). This avoids the
+    // decoder having to buffer rows internally, and libjpeg-turbo in
+    // particular takes faster paths for it.
+    const int rows_per_call = std::max(1, (int)cinfo.rec_outbuf_height);
+    const int row_bytes = width * channels;
+    std::vector<uint8_t> rows(row_bytes * rows_per_call);
+    std::vector<uint8_t *> row_ptrs(rows_per_call);
+    for (int i = 0; i < rows_per_call; i++) {
+        row_ptrs[i] = rows.data() + i * row_bytes;
+    }
     const int ymin = im->dim(1).min();
     const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        uint8_t *src = row.data();
-        jpeg_read_scanlines(&cinfo, &src, 1);
-        copy_to_image(row.data(), y, im);
+    for (int y = ymin; y <= ymax;) {
+        const int n = jpeg_read_scanlines(&cinfo, row_ptrs.data(), std::min(rows_per_call, ymax - y + 1));
+        if (!check(n > 0, "Could not read JPEG scanlines")) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        for (int i = 0; i < n; i++, y++) {
+            copy_to_image(row_ptrs[i], y, im);
+        }
     }
 
     jpeg_finish_decompress(&cinfo);
@@ -790,7 +920,8 @@ bool save_jpg(ImageType &im, const std::string &filename) {
 
 #endif  // not HALIDE_NO_JPEG
 
-constexpr int kNumTmpCodes = 10;
+// Code 10 (bfloat16) is a Halide extension; ImageStack doesn't know it.
+constexpr int kNumTmpCodes = 11;
 
 inline const halide_type_t *tmp_code_to_halide_type() {
     static const halide_type_t tmp_code_to_halide_type_[kNumTmpCodes] = {
@@ -803,7 +934,8 @@ inline const halide_type_t *tmp_code_to_halide_type() {
       { halide_type_uint, 32 },
       { halide_type_int, 32 },
       { halide_type_uint, 64 },
-      { halide_type_int, 64 }
+      { halide_type_int, 64 },
+      { halide_type_bfloat, 16 }
     };
     return tmp_code_to_halide_type_;
 }
@@ -831,6 +963,25 @@ bool buffer_is_compact_planar(ImageType &im) {
     return true;
 }
 
+// Reads a .tmp header from a FileOpener or MemoryReader, leaving it
+// positioned at the start of the payload.
+template<typename Reader, CheckFunc check = CheckReturn>
+bool read_tmp_header(Reader &f, halide_type_t *type, std::vector<int> *extents) {
+    int32_t header[5];
+    if (!check(f.read_array(header), "Count not read .tmp header")) {
+        return false;
+    }
+
+    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
+               header[4] >= 0 && header[4] < kNumTmpCodes, "Bad header on .tmp file")) {
+        return false;
+    }
+
+    *type = tmp_code_to_halide_type()[header[4]];
+    *extents = { header[0], header[1], header[2], header[3] };
+    return true;
+}
+
 // ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
 template<typename ImageType, CheckFunc check = CheckReturn>
 bool load_tmp(const std::string &filename, ImageType *im) {
@@ -841,18 +992,11 @@ bool load_tmp(const std::string &filename, ImageType *im) {
         return false;
     }
 
-    int32_t header[5];
-    if (!check(f.read_array(header), "Count not read .tmp header")) {
-        return false;
-    }
-
-    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
-               header[4] >= 0 && header[4] < kNumTmpCodes, "Bad header on .tmp file")) {
+    halide_type_t im_type;
+    std::vector<int> im_dimensions;
+    if (!read_tmp_header<FileOpener, check>(f, &im_type, &im_dimensions)) {
         return false;
     }
-
-    const halide_type_t im_type = tmp_code_to_halide_type()[header[4]];
-    std::vector<int> im_dimensions = { header[0], header[1], header[2], header[3] };
     *im = ImageType(im_type, im_dimensions);
 
     // This should never fail unless the default Buffer<> constructor behavior changes.
@@ -881,6 +1025,7 @@ inline const std::set<FormatInfo> &query_tmp() {
       { halide_type_t(halide_type_int, 32), 4 },
       { halide_type_t(halide_type_uint, 64), 4 },
       { halide_type_t(halide_type_int, 64), 4 },
+      { halide_type_t(halide_type_bfloat, 16), 4 },
     };
     return info;
 }
@@ -979,15 +1124,10 @@ enum MatlabClassCode {
     mxUINT64_CLASS = 15
 };
 
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool load_mat(const std::string &filename, ImageType *im) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    FileOpener f(filename, "rb");
-    if (!check(f.f != nullptr, "File could not be opened for reading")) {
-        return false;
-    }
-
+// Reads a .mat header from a FileOpener or MemoryReader, leaving it
+// positioned at the start of the payload.
+template<typename Reader, CheckFunc check = CheckReturn>
+bool read_mat_header(Reader &f, halide_type_t *type, std::vector<int> *extents) {
     uint8_t header[128];
     if (!check(f.read_array(header), "Could not read .mat header\n")) {
         return false;
@@ -1020,8 +1160,8 @@ bool load_mat(const std::string &filename, ImageType *im) {
         return false;
     }
     int dims = shape_header[1]/4;
-    std::vector<int> extents(dims);
-    if (!check(f.read_vector(&extents), "Could not read .mat header\n")) {
+    extents->resize(dims);
+    if (!check(f.read_vector(extents), "Could not read .mat header\n")) {
         return false;
     }
     if (dims & 1) {
@@ -1055,38 +1195,56 @@ bool load_mat(const std::string &filename, ImageType *im) {
     if (!check(f.read_array(payload_header), "Could not read .mat header\n")) {
         return false;
     }
-    halide_type_t type;
     switch (payload_header[0]) {
     case miINT8:
-        type = halide_type_of<int8_t>();
+        *type = halide_type_of<int8_t>();
         break;
     case miINT16:
-        type = halide_type_of<int16_t>();
+        *type = halide_type_of<int16_t>();
         break;
     case miINT32:
-        type = halide_type_of<int32_t>();
+        *type = halide_type_of<int32_t>();
         break;
     case miINT64:
-        type = halide_type_of<int64_t>();
+        *type = halide_type_of<int64_t>();
         break;
     case miUINT8:
-        type = halide_type_of<uint8_t>();
+        *type = halide_type_of<uint8_t>();
         break;
     case miUINT16:
-        type = halide_type_of<uint16_t>();
+        *type = halide_type_of<uint16_t>();
         break;
     case miUINT32:
-        type = halide_type_of<uint32_t>();
+        *type = halide_type_of<uint32_t>();
         break;
     case miUINT64:
-        type = halide_type_of<uint64_t>();
+        *type = halide_type_of<uint64_t>();
         break;
     case miSINGLE:
-        type = halide_type_of<float>();
+        *type = halide_type_of<float>();
         break;
     case miDOUBLE:
-        type = halide_type_of<double>();
+        *type = halide_type_of<double>();
         break;
+    default:
+        return check(false, "Could not parse this .mat file: unsupported payload type\n");
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mat(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    halide_type_t type;
+    std::vector<int> extents;
+    if (!read_mat_header<FileOpener, check>(f, &type, &extents)) {
+        return false;
     }
 
     *im = ImageType(type, extents);
@@ -1192,6 +1350,7 @@ bool save_mat(ImageType &im, const std::string &filename) {
             check(false, "unreachable");
         };
         break;
+    case halide_type_bfloat:
     case halide_type_handle:
         check(false, "unreachable");
     }
@@ -1312,6 +1471,321 @@ bool save_mat(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// ".npy" is the numpy array format documented here:
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+// Only little-endian integer and floating point arrays are supported.
+// Arrays in C order are stored with their axes reversed, so the last
+// numpy axis is the innermost Halide dimension.
+
+inline bool npy_descr_to_halide_type(const std::string &descr, halide_type_t *type) {
+    if (descr.size() < 3) {
+        return false;
+    }
+    const char order = descr[0];
+    const char kind = descr[1];
+    const int bytes = atoi(descr.c_str() + 2);
+    if (bytes != 1 && bytes != 2 && bytes != 4 && bytes != 8) {
+        return false;
+    }
+    // '|' means byte order is irrelevant, '=' means native order.
+    if (order != '<' && order != '|' && order != '=' && !(order == '>' && bytes == 1)) {
+        return false;
+    }
+    switch (kind) {
+    case 'i':
+        *type = halide_type_t(halide_type_int, bytes * 8);
+        return true;
+    case 'u':
+        *type = halide_type_t(halide_type_uint, bytes * 8);
+        return true;
+    case 'f':
+        if (bytes != 4 && bytes != 8) {
+            return false;
+        }
+        *type = halide_type_t(halide_type_float, bytes * 8);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Find the value for key in the python dict literal that makes up a
+// .npy header. Returns the position just past the ':', or npos.
+inline size_t find_npy_header_value(const std::string &header, const std::string &key) {
+    size_t pos = header.find("'" + key + "'");
+    if (pos == std::string::npos) {
+        return pos;
+    }
+    pos = header.find(':', pos);
+    if (pos == std::string::npos) {
+        return pos;
+    }
+    pos++;
+    while (pos < header.size() && header[pos] == ' ') {
+        pos++;
+    }
+    return pos;
+}
+
+// Reads a .npy header from a FileOpener or MemoryReader, leaving it
+// positioned at the start of the payload.
+template<typename Reader, CheckFunc check = CheckReturn>
+bool read_npy_header(Reader &f, halide_type_t *type, std::vector<int> *extents) {
+    uint8_t magic[8];
+    if (!check(f.read_array(magic), "Could not read .npy header\n")) {
+        return false;
+    }
+    if (!check(memcmp(magic, "\x93NUMPY", 6) == 0, "Bad magic on .npy file\n")) {
+        return false;
+    }
+    const int major_version = magic[6];
+    if (!check(major_version >= 1 && major_version <= 3, "Unsupported .npy version\n")) {
+        return false;
+    }
+
+    uint32_t header_len = 0;
+    if (major_version == 1) {
+        uint8_t len[2];
+        if (!check(f.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8);
+    } else {
+        uint8_t len[4];
+        if (!check(f.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t)len[3] << 24);
+    }
+    if (!check(header_len < (1 << 20), "Bad header length on .npy file\n")) {
+        return false;
+    }
+    std::vector<char> header_chars(header_len);
+    if (!check(f.read_vector(&header_chars), "Could not read .npy header\n")) {
+        return false;
+    }
+    const std::string header(header_chars.begin(), header_chars.end());
+
+    size_t pos = find_npy_header_value(header, "descr");
+    if (!check(pos < header.size() && (header[pos] == '\'' || header[pos] == '"'),
+               "Could not parse this .npy file: bad descr\n")) {
+        return false;
+    }
+    size_t end = header.find(header[pos], pos + 1);
+    if (!check(end != std::string::npos, "Could not parse this .npy file: bad descr\n")) {
+        return false;
+    }
+    const std::string descr = header.substr(pos + 1, end - pos - 1);
+    if (!check(npy_descr_to_halide_type(descr, type), "Unsupported type in .npy file\n")) {
+        return false;
+    }
+
+    pos = find_npy_header_value(header, "fortran_order");
+    if (!check(pos != std::string::npos, "Could not parse this .npy file: bad fortran_order\n")) {
+        return false;
+    }
+    const bool fortran_order = header.compare(pos, 4, "True") == 0;
+
+    pos = find_npy_header_value(header, "shape");
+    if (!check(pos < header.size() && header[pos] == '(', "Could not parse this .npy file: bad shape\n")) {
+        return false;
+    }
+    end = header.find(')', pos);
+    if (!check(end != std::string::npos, "Could not parse this .npy file: bad shape\n")) {
+        return false;
+    }
+    extents->clear();
+    const char *p = header.c_str() + pos + 1;
+    const char *shape_end = header.c_str() + end;
+    while (p < shape_end) {
+        char *next = nullptr;
+        long extent = strtol(p, &next, 10);
+        if (next == p) {
+            // Skip separators.
+            p++;
+            continue;
+        }
+        if (!check(extent >= 0 && extent <= 0x7fffffff, "Bad extent in .npy file\n")) {
+            return false;
+        }
+        extents->push_back((int)extent);
+        p = next;
+    }
+    if (!fortran_order) {
+        std::reverse(extents->begin(), extents->end());
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_npy(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    halide_type_t type;
+    std::vector<int> extents;
+    if (!read_npy_header<FileOpener, check>(f, &type, &extents)) {
+        return false;
+    }
+
+    *im = ImageType(type, extents);
+
+    // This should never fail unless the default Buffer<> constructor behavior changes.
+    if (!check(buffer_is_compact_planar(*im), "load_npy() requires compact planar images")) {
+        return false;
+    }
+
+    if (!check(f.read_bytes(im->begin(), im->size_in_bytes()), "Could not read .npy payload")) {
+        return false;
+    }
+
+    im->set_host_dirty();
+    return true;
+}
+
+inline const std::set<FormatInfo> &query_npy() {
+    // Numpy arrays may have any number of dimensions. As for .mat, our
+    // support arbitrarily stops at 16.
+    static std::set<FormatInfo> info = []() {
+        std::set<FormatInfo> s;
+        for (int i = 0; i < 16; i++) {
+            s.insert({ halide_type_t(halide_type_float, 32), i });
+            s.insert({ halide_type_t(halide_type_float, 64), i });
+            s.insert({ halide_type_t(halide_type_uint, 8), i });
+            s.insert({ halide_type_t(halide_type_int, 8), i });
+            s.insert({ halide_type_t(halide_type_uint, 16), i });
+            s.insert({ halide_type_t(halide_type_int, 16), i });
+            s.insert({ halide_type_t(halide_type_uint, 32), i });
+            s.insert({ halide_type_t(halide_type_int, 32), i });
+            s.insert({ halide_type_t(halide_type_uint, 64), i });
+            s.insert({ halide_type_t(halide_type_int, 64), i });
+        }
+        return s;
+    }();
+    return info;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_npy(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    const halide_type_t im_type = im.type();
+    const char kind = im_type.code == halide_type_float ? 'f' :
+                      im_type.code == halide_type_int ? 'i' : 'u';
+    // Note that this assumes the host is little-endian.
+    std::string header = "{'descr': '<";
+    header += kind;
+    header += std::to_string(im_type.bytes());
+    header += "', 'fortran_order': False, 'shape': (";
+    for (int i = im.dimensions() - 1; i >= 0; i--) {
+        header += std::to_string(im.dim(i).extent());
+        if (i > 0 || im.dimensions() == 1) {
+            header += ",";
+        }
+        if (i > 0) {
+            header += " ";
+        }
+    }
+    header += "), }";
+    // The header is padded with spaces and terminated with a newline so
+    // that the payload is 64-byte aligned.
+    const size_t preamble_size = 10;
+    while ((preamble_size + header.size() + 1) % 64 != 0) {
+        header += ' ';
+    }
+    header += '\n';
+    if (!check(header.size() < 65536, "Too many dimensions for .npy file")) {
+        return false;
+    }
+
+    const uint8_t preamble[preamble_size] = {
+        0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+        (uint8_t)(header.size() & 0xff), (uint8_t)(header.size() >> 8)
+    };
+
+    FileOpener f(filename, "wb");
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
+    }
+    if (!check(f.write_array(preamble) && f.write_bytes(header.data(), header.size()),
+               "Could not write .npy header")) {
+        return false;
+    }
+
+    if (!write_planar_payload<ImageType, check>(im, f)) {
+        return false;
+    }
+
+    return true;
+}
+
+// Wrap the payload of a mapped file, which starts at the given offset,
+// in an image. If the payload isn't suitably aligned for its type, it
+// is copied into a new allocation instead and the mapping is closed.
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool map_planar_payload(MappedFile *mapping, size_t offset, halide_type_t type,
+                        const std::vector<int> &extents, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    size_t size_in_bytes = type.bytes();
+    for (int e : extents) {
+        size_in_bytes *= e;
+    }
+    if (!check(offset <= mapping->size() && size_in_bytes <= mapping->size() - offset,
+               "File is too small for the image it describes")) {
+        return false;
+    }
+
+    uint8_t *payload = mapping->data() + offset;
+    if (((uintptr_t)payload % type.bytes()) == 0) {
+        *im = ImageType(type, payload, extents);
+    } else {
+        *im = ImageType(type, extents);
+        memcpy(im->data(), payload, size_in_bytes);
+        mapping->close();
+    }
+
+    // This should never fail unless the Buffer<> constructor behavior changes.
+    return check(buffer_is_compact_planar(*im), "map_image() requires compact planar images");
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool map_image(const std::string &filename, ImageType *im, MappedFile *mapping) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    const std::string ext = get_lowercase_extension(filename);
+    if (!check(ext == "tmp" || ext == "mat" || ext == "npy",
+               "map_image() only supports .tmp, .mat and .npy files")) {
+        return false;
+    }
+    if (!check(mapping->open(filename), "File could not be mapped for reading")) {
+        return false;
+    }
+
+    MemoryReader reader(mapping->data(), mapping->size());
+    halide_type_t type;
+    std::vector<int> extents;
+    bool success;
+    if (ext == "tmp") {
+        success = read_tmp_header<MemoryReader, check>(reader, &type, &extents);
+    } else if (ext == "mat") {
+        success = read_mat_header<MemoryReader, check>(reader, &type, &extents);
+    } else {
+        success = read_npy_header<MemoryReader, check>(reader, &type, &extents);
+    }
+    if (!success || !map_planar_payload<ImageType, check>(mapping, reader.offset, type, extents, im)) {
+        mapping->close();
+        return false;
+    }
+    return true;
+}
+
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool load_tiff(const std::string &filename, ImageType *im) {
     static_assert(!ImageType::has_static_halide_type, "");
@@ -1579,6 +2053,355 @@ bool save_tiff(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// Decodes an image a row at a time, for the formats that are stored
+// in row order. Rows are interleaved, with multibyte elements in
+// big-endian order, as read_big_endian_row() expects.
+struct RowDecoder {
+    int width = 0, height = 0, channels = 0, bit_depth = 0;
+
+    virtual ~RowDecoder() = default;
+    virtual bool read_row(uint8_t *row) = 0;
+};
+
+// The inverse of RowDecoder.
+struct RowEncoder {
+    virtual ~RowEncoder() = default;
+    virtual bool write_row(const uint8_t *row) = 0;
+    virtual bool finish() = 0;
+};
+
+#ifndef HALIDE_NO_PNG
+
+template<CheckFunc check>
+struct PngRowDecoder : public RowDecoder {
+    FileOpener f;
+    png_structp png_ptr = nullptr;
+    png_infop info_ptr = nullptr;
+
+    PngRowDecoder(const std::string &filename) : f(filename, "rb") {}
+
+    ~PngRowDecoder() override {
+        if (png_ptr != nullptr) {
+            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        }
+    }
+
+    bool open() {
+        if (!check(f.f != nullptr, "File could not be opened for reading")) {
+            return false;
+        }
+        png_byte header[8];
+        if (!check(f.read_array(header), "File ended before end of header")) {
+            return false;
+        }
+        if (!check(!png_sig_cmp(header, 0, 8), "File is not recognized as a PNG file")) {
+            return false;
+        }
+        png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        if (!check(png_ptr != nullptr, "png_create_read_struct failed")) {
+            return false;
+        }
+        info_ptr = png_create_info_struct(png_ptr);
+        if (!check(info_ptr != nullptr, "png_create_info_struct failed")) {
+            return false;
+        }
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error loading PNG")) {
+            return false;
+        }
+        png_init_io(png_ptr, f.f);
+        png_set_sig_bytes(png_ptr, 8);
+        png_read_info(png_ptr, info_ptr);
+
+        width = png_get_image_width(png_ptr, info_ptr);
+        height = png_get_image_height(png_ptr, info_ptr);
+        channels = png_get_channels(png_ptr, info_ptr);
+        bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+        if (!check(png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE,
+                   "Interlaced PNG files can't be read a row at a time")) {
+            return false;
+        }
+
+        png_read_update_info(png_ptr, info_ptr);
+        return true;
+    }
+
+    bool read_row(uint8_t *row) override {
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error loading PNG")) {
+            return false;
+        }
+        png_read_row(png_ptr, row, nullptr);
+        return true;
+    }
+};
+
+template<CheckFunc check>
+struct PngRowEncoder : public RowEncoder {
+    FileOpener f;
+    png_structp png_ptr = nullptr;
+    png_infop info_ptr = nullptr;
+
+    PngRowEncoder(const std::string &filename) : f(filename, "wb") {}
+
+    ~PngRowEncoder() override {
+        if (png_ptr != nullptr) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+        }
+    }
+
+    bool open(int width, int height, int channels, int bit_depth) {
+        if (!check(channels >= 1 && channels <= 4,
+                   "Can't write PNG files that have other than 1, 2, 3, or 4 channels")) {
+            return false;
+        }
+        const png_byte color_types[4] = {
+            PNG_COLOR_TYPE_GRAY,
+            PNG_COLOR_TYPE_GRAY_ALPHA,
+            PNG_COLOR_TYPE_RGB,
+            PNG_COLOR_TYPE_RGB_ALPHA
+        };
+        if (!check(f.f != nullptr, "[write_png_file] File could not be opened for writing")) {
+            return false;
+        }
+        png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        if (!check(png_ptr != nullptr, "[write_png_file] png_create_write_struct failed")) {
+            return false;
+        }
+        info_ptr = png_create_info_struct(png_ptr);
+        if (!check(info_ptr != nullptr, "[write_png_file] png_create_info_struct failed")) {
+            return false;
+        }
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error saving PNG")) {
+            return false;
+        }
+        png_init_io(png_ptr, f.f);
+        png_set_IHDR(png_ptr, info_ptr, width, height,
+                     bit_depth, color_types[channels - 1], PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+        png_write_info(png_ptr, info_ptr);
+        return true;
+    }
+
+    bool write_row(const uint8_t *row) override {
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error saving PNG")) {
+            return false;
+        }
+        png_write_row(png_ptr, (png_bytep)row);
+        return true;
+    }
+
+    bool finish() override {
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error saving PNG")) {
+            return false;
+        }
+        png_write_end(png_ptr, NULL);
+        return true;
+    }
+};
+
+#endif  // not HALIDE_NO_PNG
+
+template<CheckFunc check>
+struct PnmRowDecoder : public RowDecoder {
+    FileOpener f;
+
+    PnmRowDecoder(const std::string &filename) : f(filename, "rb") {}
+
+    bool open(int pnm_channels) {
+        channels = pnm_channels;
+        const char *hdr_fmt = channels == 3 ? "P6" : "P5";
+        return read_pnm_header<check>(f, hdr_fmt, &width, &height, &bit_depth);
+    }
+
+    bool read_row(uint8_t *row) override {
+        return check(f.read_bytes(row, width * channels * (bit_depth / 8)), "Could not read data");
+    }
+};
+
+template<CheckFunc check>
+struct PnmRowEncoder : public RowEncoder {
+    FileOpener f;
+    size_t row_bytes = 0;
+
+    PnmRowEncoder(const std::string &filename) : f(filename, "wb") {}
+
+    bool open(int width, int height, int channels, int bit_depth) {
+        if (!check(f.f != nullptr, "File could not be opened for writing")) {
+            return false;
+        }
+        const char *hdr_fmt = channels == 3 ? "P6" : "P5";
+        fprintf(f.f, "%s\n%d %d\n%d\n", hdr_fmt, width, height, (1<<bit_depth)-1);
+        row_bytes = width * channels * (bit_depth / 8);
+        return true;
+    }
+
+    bool write_row(const uint8_t *row) override {
+        return check(f.write_bytes(row, row_bytes), "Could not write data");
+    }
+
+    bool finish() override {
+        return true;
+    }
+};
+
+#ifndef HALIDE_NO_JPEG
+
+template<CheckFunc check>
+struct JpgRowDecoder : public RowDecoder {
+    FileOpener f;
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    bool created = false;
+
+    JpgRowDecoder(const std::string &filename) : f(filename, "rb") {}
+
+    ~JpgRowDecoder() override {
+        if (created) {
+            jpeg_destroy_decompress(&cinfo);
+        }
+    }
+
+    bool open() {
+        if (!check(f.f != nullptr, "File could not be opened for reading")) {
+            return false;
+        }
+        cinfo.err = jpeg_std_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+        created = true;
+        jpeg_stdio_src(&cinfo, f.f);
+        jpeg_read_header(&cinfo, TRUE);
+        jpeg_start_decompress(&cinfo);
+        width = cinfo.output_width;
+        height = cinfo.output_height;
+        channels = cinfo.output_components;
+        bit_depth = 8;
+        return true;
+    }
+
+    bool read_row(uint8_t *row) override {
+        return check(jpeg_read_scanlines(&cinfo, &row, 1) == 1, "Could not read JPEG scanline");
+    }
+};
+
+template<CheckFunc check>
+struct JpgRowEncoder : public RowEncoder {
+    FileOpener f;
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    bool created = false;
+
+    JpgRowEncoder(const std::string &filename) : f(filename, "wb") {}
+
+    ~JpgRowEncoder() override {
+        if (created) {
+            jpeg_destroy_compress(&cinfo);
+        }
+    }
+
+    bool open(int width, int height, int channels, int bit_depth) {
+        if (!check(bit_depth == 8, "Can only write 8-bit JPEG files")) {
+            return false;
+        }
+        if (!check(channels == 1 || channels == 3, "Can only write JPEG files with 1 or 3 channels")) {
+            return false;
+        }
+        if (!check(f.f != nullptr, "File could not be opened for writing")) {
+            return false;
+        }
+        constexpr int quality = 99;
+        cinfo.err = jpeg_std_error(&jerr);
+        jpeg_create_compress(&cinfo);
+        created = true;
+        jpeg_stdio_dest(&cinfo, f.f);
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = channels;
+        cinfo.in_color_space = (channels == 3) ? JCS_RGB : JCS_GRAYSCALE;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+        return true;
+    }
+
+    bool write_row(const uint8_t *row) override {
+        JSAMPROW r = (JSAMPROW)row;
+        return check(jpeg_write_scanlines(&cinfo, &r, 1) == 1, "Could not write JPEG scanline");
+    }
+
+    bool finish() override {
+        jpeg_finish_compress(&cinfo);
+        return true;
+    }
+};
+
+#endif  // not HALIDE_NO_JPEG
+
+template<CheckFunc check>
+std::unique_ptr<RowDecoder> open_row_decoder(const std::string &filename) {
+    const std::string ext = get_lowercase_extension(filename);
+    if (ext == "pgm" || ext == "ppm") {
+        std::unique_ptr<PnmRowDecoder<check>> d(new PnmRowDecoder<check>(filename));
+        if (d->open(ext == "ppm" ? 3 : 1)) {
+            return std::move(d);
+        }
+        return nullptr;
+    }
+#ifndef HALIDE_NO_PNG
+    if (ext == "png") {
+        std::unique_ptr<PngRowDecoder<check>> d(new PngRowDecoder<check>(filename));
+        if (d->open()) {
+            return std::move(d);
+        }
+        return nullptr;
+    }
+#endif
+#ifndef HALIDE_NO_JPEG
+    if (ext == "jpg" || ext == "jpeg") {
+        std::unique_ptr<JpgRowDecoder<check>> d(new JpgRowDecoder<check>(filename));
+        if (d->open()) {
+            return std::move(d);
+        }
+        return nullptr;
+    }
+#endif
+    check(false, ("unsupported file extension \"" + ext + "\" for reading a strip at a time\n").c_str());
+    return nullptr;
+}
+
+template<CheckFunc check>
+std::unique_ptr<RowEncoder> open_row_encoder(const std::string &filename, int width, int height, int channels, int bit_depth) {
+    const std::string ext = get_lowercase_extension(filename);
+    if (ext == "pgm" || ext == "ppm") {
+        if (!check(channels == (ext == "ppm" ? 3 : 1), "Wrong number of channels")) {
+            return nullptr;
+        }
+        std::unique_ptr<PnmRowEncoder<check>> e(new PnmRowEncoder<check>(filename));
+        if (e->open(width, height, channels, bit_depth)) {
+            return std::move(e);
+        }
+        return nullptr;
+    }
+#ifndef HALIDE_NO_PNG
+    if (ext == "png") {
+        std::unique_ptr<PngRowEncoder<check>> e(new PngRowEncoder<check>(filename));
+        if (e->open(width, height, channels, bit_depth)) {
+            return std::move(e);
+        }
+        return nullptr;
+    }
+#endif
+#ifndef HALIDE_NO_JPEG
+    if (ext == "jpg" || ext == "jpeg") {
+        std::unique_ptr<JpgRowEncoder<check>> e(new JpgRowEncoder<check>(filename));
+        if (e->open(width, height, channels, bit_depth)) {
+            return std::move(e);
+        }
+        return nullptr;
+    }
+#endif
+    check(false, ("unsupported file extension \"" + ext + "\" for writing a strip at a time\n").c_str());
+    return nullptr;
+}
+
 // Given something like ImageType<Foo>, produce typedef ImageType<Bar>
 template<typename ImageType, typename ElemType>
 struct ImageTypeWithElemType {
@@ -1617,6 +2440,7 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
         {"ppm", {load_ppm<ImageType, check>, save_ppm<ConstImageType, check>, query_ppm}},
         {"tmp", {load_tmp<ImageType, check>, save_tmp<ConstImageType, check>, query_tmp}},
         {"mat", {load_mat<ImageType, check>, save_mat<ConstImageType, check>, query_mat}},
+        {"npy", {load_npy<ImageType, check>, save_npy<ConstImageType, check>, query_npy}},
         {"tiff", {load_tiff<ImageType, check>, save_tiff<ConstImageType, check>, query_tiff}},
     };
     std::string ext = Internal::get_lowercase_extension(filename);
@@ -1634,6 +2458,35 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
     return check(false, err.c_str());
 }
 
+// Call f(i) for each i in [0, n), using up to num_threads threads
+// (or one per core if num_threads is zero). Returns false if any call
+// returns false.
+inline bool parallel_for_each_index(int n, int num_threads, const std::function<bool(int)> &f) {
+    if (num_threads <= 0) {
+        num_threads = (int)std::thread::hardware_concurrency();
+    }
+    num_threads = std::max(1, std::min(num_threads, n));
+
+    std::atomic<int> next(0);
+    std::atomic<bool> success(true);
+    auto worker = [&]() {
+        for (int i = next++; i < n; i = next++) {
+            if (!f(i)) {
+                success = false;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) {
+        t.join();
+    }
+    return success;
+}
+
 template<typename ImageType>
 FormatInfo best_save_format(const ImageType &im, const std::set<FormatInfo> &info) {
     // A bit ad hoc, but will do for now:
@@ -1866,6 +2719,208 @@ bool load(const std::string &filename, ImageType *im) {
     return true;
 }
 
+// Map a .tmp, .mat or .npy file into memory, and make the image refer
+// to its payload directly rather than reading it into a new
+// allocation. This makes loading large files much cheaper when only
+// part of the image is used. The mapping must outlive the image (and
+// any images sharing its storage). Writes to the image are not written
+// back to the file. If the payload is misaligned for its type, it is
+// copied instead and the mapping is closed. As for load(), if the
+// output Image has a static type that doesn't match the file, fail.
+// Returns false upon failure.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool map_image(const std::string &filename, ImageType *im, MappedFile *mapping) {
+    using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+    DynamicImageType im_d;
+    if (!Internal::map_image<DynamicImageType, check>(filename, &im_d, mapping)) {
+        return false;
+    }
+    if (ImageType::has_static_halide_type) {
+        const halide_type_t expected_type = ImageType::static_halide_type();
+        if (!check(im_d.type() == expected_type, "Image loaded did not match the expected type")) {
+            mapping->close();
+            return false;
+        }
+    }
+    *im = im_d.template as<typename ImageType::ElemType>();
+    im->set_host_dirty();
+    return true;
+}
+
+// Reads an image a strip of rows at a time, so that images too large
+// to hold in memory can be processed in pieces, e.g. by realizing a
+// pipeline over one strip of output rows at a time. Only the rows
+// being read are decoded and held in memory. Supports the formats
+// that are stored in row order: png (non-interlaced), jpg, pgm and ppm.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+class ImageStripReader {
+public:
+    // Open the file and read its header. Returns false upon failure.
+    bool open(const std::string &filename) {
+        decoder = Internal::open_row_decoder<check>(filename);
+        if (!decoder) {
+            return false;
+        }
+        if (ImageType::has_static_halide_type) {
+            const halide_type_t expected_type = ImageType::static_halide_type();
+            if (!check(type() == expected_type, "Image loaded did not match the expected type")) {
+                decoder.reset();
+                return false;
+            }
+        }
+        row.resize(width() * channels() * (decoder->bit_depth / 8));
+        cur_row = 0;
+        return true;
+    }
+
+    int width() const { return decoder->width; }
+    int height() const { return decoder->height; }
+    int channels() const { return decoder->channels; }
+    halide_type_t type() const { return halide_type_t(halide_type_uint, decoder->bit_depth); }
+
+    // The first row that the next call to read_rows() will decode.
+    int next_row() const { return cur_row; }
+
+    // Decode up to the given number of rows into *strip, which is
+    // reallocated if it doesn't already have the right shape, and
+    // whose min y coordinate is set to the first row read. The strip
+    // has the same dimensions load() would produce for the whole
+    // image. Returns false upon failure, or if all rows have already
+    // been read.
+    bool read_rows(int rows, ImageType *strip) {
+        if (!check(decoder != nullptr, "ImageStripReader is not open")) {
+            return false;
+        }
+        rows = std::min(rows, height() - cur_row);
+        if (!check(rows > 0, "No more rows to read")) {
+            return false;
+        }
+
+        std::vector<int> extents = { width(), rows };
+        if (channels() != 1) {
+            extents.push_back(channels());
+        }
+        bool reuse = strip->data() != nullptr &&
+                     strip->type() == type() &&
+                     strip->dimensions() == (int)extents.size();
+        for (int i = 0; reuse && i < (int)extents.size(); i++) {
+            reuse = strip->dim(i).extent() == extents[i];
+        }
+        if (!reuse) {
+            *strip = ImageType(type(), extents);
+        }
+        strip->set_min(0, cur_row);
+
+        auto strip_d = strip->template as<void>();
+        for (int i = 0; i < rows; i++) {
+            if (!decoder->read_row(row.data())) {
+                return false;
+            }
+            if (decoder->bit_depth == 8) {
+                Internal::read_big_endian_row<uint8_t>(row.data(), cur_row, &strip_d);
+            } else {
+                Internal::read_big_endian_row<uint16_t>(row.data(), cur_row, &strip_d);
+            }
+            cur_row++;
+        }
+        strip->set_host_dirty();
+        return true;
+    }
+
+private:
+    std::unique_ptr<Internal::RowDecoder> decoder;
+    std::vector<uint8_t> row;
+    int cur_row = 0;
+};
+
+// Writes an image a strip of rows at a time. The counterpart to
+// ImageStripReader, supporting the same formats.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+class ImageStripWriter {
+public:
+    ~ImageStripWriter() {
+        close();
+    }
+
+    // Create the file and write its header. The type must be uint8
+    // or uint16 (uint8 only for jpg). Returns false upon failure.
+    bool open(const std::string &filename, halide_type_t type, int width, int height, int channels) {
+        if (!check(type.code == halide_type_uint && (type.bits == 8 || type.bits == 16) && type.lanes == 1,
+                   "Can only write uint8 or uint16 images a strip at a time")) {
+            return false;
+        }
+        close();
+        encoder = Internal::open_row_encoder<check>(filename, width, height, channels, type.bits);
+        if (!encoder) {
+            return false;
+        }
+        im_type = type;
+        im_width = width;
+        im_height = height;
+        im_channels = channels;
+        row.resize(width * channels * type.bytes());
+        cur_row = 0;
+        return true;
+    }
+
+    // The first row that the next call to write_rows() must start at.
+    int next_row() const { return cur_row; }
+
+    // Encode the rows of the strip, which must have the type and
+    // channels given to open(), span the full width of the image
+    // starting at x = 0, and start at next_row(). Returns false upon
+    // failure.
+    bool write_rows(ImageType &strip) {
+        if (!check(encoder != nullptr, "ImageStripWriter is not open")) {
+            return false;
+        }
+        if (!check(strip.type() == im_type &&
+                   strip.dim(0).min() == 0 && strip.dim(0).extent() == im_width &&
+                   (strip.dimensions() > 2 ? strip.dim(2).extent() : 1) == im_channels,
+                   "Strip does not match the shape of the image being written")) {
+            return false;
+        }
+        if (!check(strip.dim(1).min() == cur_row && strip.dim(1).max() < im_height,
+                   "Strips must be written in order")) {
+            return false;
+        }
+        strip.copy_to_host();
+
+        auto strip_d = strip.template as<const void>();
+        const int ymax = strip.dim(1).max();
+        for (int y = cur_row; y <= ymax; y++) {
+            if (im_type.bits == 8) {
+                Internal::write_big_endian_row<uint8_t>(strip_d, y, row.data());
+            } else {
+                Internal::write_big_endian_row<uint16_t>(strip_d, y, row.data());
+            }
+            if (!encoder->write_row(row.data())) {
+                return false;
+            }
+        }
+        cur_row = ymax + 1;
+        return true;
+    }
+
+    // Finish writing the file. Fails if not all rows were written.
+    // Called by the destructor if necessary.
+    bool close() {
+        if (!encoder) {
+            return true;
+        }
+        bool success = check(cur_row == im_height, "Not all rows of the image were written") &&
+                       encoder->finish();
+        encoder.reset();
+        return success;
+    }
+
+private:
+    std::unique_ptr<Internal::RowEncoder> encoder;
+    std::vector<uint8_t> row;
+    halide_type_t im_type;
+    int im_width = 0, im_height = 0, im_channels = 0, cur_row = 0;
+};
+
 // Save the Image in the format associated with the filename's extension.
 // If the format can't represent the Image without losing data, fail.
 // Returns false upon failure.
@@ -1886,6 +2941,33 @@ bool save(ImageType &im, const std::string &filename) {
     return imageio.save(im_d, filename);
 }
 
+// Load a batch of images concurrently, using up to num_threads threads
+// (or one per core if num_threads is zero). Each file is loaded as if
+// by load(), so all the same formats are supported. On return, images
+// has one entry per filename. Returns false if any image fails to
+// load; the others are still loaded.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_images(const std::vector<std::string> &filenames, std::vector<ImageType> *images, int num_threads = 0) {
+    images->clear();
+    images->resize(filenames.size());
+    return Internal::parallel_for_each_index((int)filenames.size(), num_threads, [&](int i) {
+        return load<ImageType, check>(filenames[i], &(*images)[i]);
+    });
+}
+
+// Save a batch of images concurrently, as if by save(). images and
+// filenames must be the same size. Returns false if any image fails to
+// save; the others are still saved.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool save_images(std::vector<ImageType> &images, const std::vector<std::string> &filenames, int num_threads = 0) {
+    if (!check(images.size() == filenames.size(), "save_images() needs one filename per image")) {
+        return false;
+    }
+    return Internal::parallel_for_each_index((int)filenames.size(), num_threads, [&](int i) {
+        return save<ImageType, check>(images[i], filenames[i]);
+    });
+}
+
 // Return a set of FormatInfo structs that contain the legal type-and-dimensions
 // that can be saved in this format. Most applications won't ever need to use
 // this call. Returns false upon failure.
@@ -15,12 +15,33 @@
 //   halide_free   => [0x9e390, 0x9e3ff], # size:112, align:16
 //   halide_free   => [0xa2820, 0xa287f], # size:96, align:32
 //
+// Alternatively, the allocations can be captured to a binary trace file
+// (see halide_malloc_trace_format.h) by calling:
+//
+//   halide_enable_malloc_trace_capture("allocations.trace");
+//   ... run the pipeline ...
+//   halide_disable_malloc_trace_capture();
+//
+// which records the size, alignment, thread, and time of each call.
+// The trace is kept in memory, and written when capture is disabled.
+// Allocations are labelled with the name of the Func they are for if
+// its realizations are traced (Func::trace_realizations), because the
+// allocation of a Func comes just before the start of its realization
+// on the same thread. Capturing replaces the trace handler.
+// util/HalideMallocReplay replays a trace against several allocators.
+//
 //---------------------------------------------------------------------------
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <iostream>
 
+#include "halide_malloc_trace_format.h"
+
 namespace Halide {
 namespace Tools {
 
@@ -47,7 +68,7 @@ static inline void print_meminfoalign(intptr_t val) {
     }
 }
 
-void *halide_malloc_trace(void *user_context, size_t x) {
+static inline void *malloc_trace_allocate(size_t x) {
     // Halide requires halide_malloc to allocate memory that can be
     // read 8 bytes before the start to store the original pointer.
     // Additionally, we also need to align it to the natural vector
@@ -60,6 +81,15 @@ void *halide_malloc_trace(void *user_context, size_t x) {
     // Round up to next multiple of 128.
     void *ptr = (void *)((((size_t)orig + 128) >> 7) << 7);
     ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void *halide_malloc_trace(void *user_context, size_t x) {
+    void *ptr = malloc_trace_allocate(x);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    void *orig = ((void **)ptr)[-1];
 
     void *headend = (orig == ptr) ? orig : (char *)ptr - 1;
     std::cout << "halide_malloc => [0x" << std::hex
@@ -96,6 +126,139 @@ void halide_enable_malloc_trace(void) {
     halide_set_custom_free(halide_free_trace);
 }
 
+struct MallocTraceCapture {
+    std::mutex mutex;
+    std::string filename;
+    std::chrono::steady_clock::time_point start;
+    MallocTrace trace;
+    std::map<std::string, uint32_t> func_ids;
+    // The id and size of each live allocation, by address.
+    std::map<void *, std::pair<uint64_t, uint64_t>> live;
+    // The index of the last malloc on each thread, if it has not been
+    // labelled with a Func name yet.
+    std::map<uint32_t, size_t> unlabelled;
+    uint64_t next_id = 0;
+    std::atomic<uint32_t> next_thread{0};
+
+    halide_malloc_t old_malloc = nullptr;
+    halide_free_t old_free = nullptr;
+    halide_trace_t old_trace = nullptr;
+    bool enabled = false;
+};
+
+static inline MallocTraceCapture &malloc_trace_capture() {
+    static MallocTraceCapture capture;
+    return capture;
+}
+
+static inline uint32_t malloc_trace_thread() {
+    static thread_local uint32_t thread = malloc_trace_capture().next_thread++;
+    return thread;
+}
+
+static inline void malloc_trace_record(MallocTraceEvent event, void *ptr, size_t size) {
+    MallocTraceCapture &c = malloc_trace_capture();
+    MallocTraceRecord r;
+    memset(&r, 0, sizeof(r));
+    r.thread = malloc_trace_thread();
+    r.event = event;
+    r.alignment_log2 = 20;
+    while (r.alignment_log2 > 0 && ((uintptr_t)ptr & (((uintptr_t)1 << r.alignment_log2) - 1)) != 0) {
+        r.alignment_log2--;
+    }
+
+    std::lock_guard<std::mutex> lock(c.mutex);
+    r.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - c.start).count();
+    if (event == malloc_trace_malloc) {
+        r.id = c.next_id++;
+        r.size = size;
+        c.live[ptr] = {r.id, r.size};
+        c.unlabelled[r.thread] = c.trace.records.size();
+    } else {
+        auto it = c.live.find(ptr);
+        if (it == c.live.end()) {
+            // Allocated before capture started.
+            return;
+        }
+        r.id = it->second.first;
+        r.size = it->second.second;
+        c.live.erase(it);
+    }
+    c.trace.records.push_back(r);
+}
+
+void *halide_malloc_trace_capture(void *user_context, size_t x) {
+    void *ptr = malloc_trace_allocate(x);
+    if (ptr != NULL) {
+        malloc_trace_record(malloc_trace_malloc, ptr, x);
+    }
+    return ptr;
+}
+
+void halide_free_trace_capture(void *user_context, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    malloc_trace_record(malloc_trace_free, ptr, 0);
+    free(((void**)ptr)[-1]);
+}
+
+int halide_trace_capture_func_names(void *user_context, const halide_trace_event_t *e) {
+    if (e->event != halide_trace_begin_realization) {
+        return 0;
+    }
+    MallocTraceCapture &c = malloc_trace_capture();
+    uint32_t thread = malloc_trace_thread();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    auto it = c.unlabelled.find(thread);
+    if (it == c.unlabelled.end()) {
+        return 0;
+    }
+    auto id = c.func_ids.find(e->func);
+    if (id == c.func_ids.end()) {
+        c.trace.func_names.push_back(e->func);
+        id = c.func_ids.emplace(e->func, (uint32_t)c.trace.func_names.size()).first;
+    }
+    c.trace.records[it->second].func = id->second;
+    c.unlabelled.erase(it);
+    return 0;
+}
+
+void halide_enable_malloc_trace_capture(const char *filename) {
+    MallocTraceCapture &c = malloc_trace_capture();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.filename = filename;
+    c.start = std::chrono::steady_clock::now();
+    c.trace = MallocTrace();
+    c.func_ids.clear();
+    c.live.clear();
+    c.unlabelled.clear();
+    c.next_id = 0;
+    if (!c.enabled) {
+        c.old_malloc = halide_set_custom_malloc(halide_malloc_trace_capture);
+        c.old_free = halide_set_custom_free(halide_free_trace_capture);
+        c.old_trace = halide_set_custom_trace(halide_trace_capture_func_names);
+        c.enabled = true;
+    }
+}
+
+// Stop capturing, restore the previous handlers, and write the
+// trace. Returns false if the trace could not be written. Memory
+// allocated while capturing has the same layout as that of the default
+// halide_malloc, so the default halide_free can free it afterwards.
+bool halide_disable_malloc_trace_capture(void) {
+    MallocTraceCapture &c = malloc_trace_capture();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.enabled) {
+        return false;
+    }
+    halide_set_custom_malloc(c.old_malloc);
+    halide_set_custom_free(c.old_free);
+    halide_set_custom_trace(c.old_trace);
+    c.enabled = false;
+    return c.trace.write(c.filename.c_str());
+}
+
 } // namespace Tools
 } // namespace Halide
 
@@ -0,0 +1,115 @@
+#ifndef HALIDE_MALLOC_TRACE_FORMAT_H
+#define HALIDE_MALLOC_TRACE_FORMAT_H
+
+//---------------------------------------------------------------------------
+// The binary allocation trace written by the capture mode of
+// halide_malloc_trace.h, and read by util/HalideMallocReplay.cpp. A
+// trace file contains, in the byte order of the machine that wrote it:
+//
+//   char magic[8];               // "HLMTRC01"
+//   uint32_t num_func_names;
+//   num_func_names times:
+//     uint32_t length;
+//     char name[length];         // not null-terminated
+//   uint64_t num_records;
+//   MallocTraceRecord records[num_records];
+//
+// Records are in the order the calls happened in.
+//---------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Halide {
+namespace Tools {
+
+enum MallocTraceEvent : uint8_t {
+    malloc_trace_malloc = 0,
+    malloc_trace_free = 1,
+};
+
+struct MallocTraceRecord {
+    // Nanoseconds since the capture started.
+    uint64_t timestamp_ns;
+    // Identifies the allocation. A malloc and its free have the same id.
+    uint64_t id;
+    // The size requested by the malloc.
+    uint64_t size;
+    // A small number identifying the calling thread, in the order
+    // threads were first seen.
+    uint32_t thread;
+    // One plus the index of the name of the Func being allocated in
+    // the table of names, or zero if it is unknown.
+    uint32_t func;
+    uint8_t event;
+    // The log2 of the largest power of two the address is a multiple
+    // of, up to 1M.
+    uint8_t alignment_log2;
+    uint8_t padding[6];
+};
+
+static_assert(sizeof(MallocTraceRecord) == 40, "MallocTraceRecord should not need padding");
+
+struct MallocTrace {
+    std::vector<std::string> func_names;
+    std::vector<MallocTraceRecord> records;
+
+    bool write(const char *filename) const {
+        FILE *f = fopen(filename, "wb");
+        if (!f) {
+            return false;
+        }
+        bool ok = fwrite("HLMTRC01", 1, 8, f) == 8;
+        uint32_t num_names = (uint32_t)func_names.size();
+        ok = ok && fwrite(&num_names, sizeof(num_names), 1, f) == 1;
+        for (const std::string &name : func_names) {
+            uint32_t length = (uint32_t)name.size();
+            ok = ok && fwrite(&length, sizeof(length), 1, f) == 1;
+            ok = ok && fwrite(name.data(), 1, length, f) == length;
+        }
+        uint64_t num_records = records.size();
+        ok = ok && fwrite(&num_records, sizeof(num_records), 1, f) == 1;
+        ok = ok && fwrite(records.data(), sizeof(MallocTraceRecord), records.size(), f) == records.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    bool read(const char *filename) {
+        func_names.clear();
+        records.clear();
+        FILE *f = fopen(filename, "rb");
+        if (!f) {
+            return false;
+        }
+        char magic[8];
+        bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, "HLMTRC01", 8) == 0;
+        uint32_t num_names = 0;
+        ok = ok && fread(&num_names, sizeof(num_names), 1, f) == 1;
+        for (uint32_t i = 0; ok && i < num_names; i++) {
+            uint32_t length = 0;
+            ok = fread(&length, sizeof(length), 1, f) == 1;
+            std::string name(ok ? length : 0, ' ');
+            ok = ok && fread(&name[0], 1, length, f) == length;
+            func_names.push_back(name);
+        }
+        uint64_t num_records = 0;
+        ok = ok && fread(&num_records, sizeof(num_records), 1, f) == 1;
+        if (ok) {
+            records.resize(num_records);
+            ok = fread(records.data(), sizeof(MallocTraceRecord), num_records, f) == num_records;
+        }
+        fclose(f);
+        return ok;
+    }
+
+    const char *func_name(const MallocTraceRecord &r) const {
+        return r.func == 0 || r.func > func_names.size() ? "<unknown>" : func_names[r.func - 1].c_str();
+    }
+};
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_MALLOC_TRACE_FORMAT_H
@@ -0,0 +1,80 @@
+#ifndef HALIDE_OPENMP_PARALLEL_RUNTIME_H
+#define HALIDE_OPENMP_PARALLEL_RUNTIME_H
+
+//---------------------------------------------------------------------------
+// Runs Halide's parallel loops and async() tasks on OpenMP threads
+// instead of Halide's own thread pool, so that an application that
+// already uses OpenMP doesn't end up with two pools competing for the
+// same cores. Compile with -fopenmp (or your compiler's equivalent)
+// and call
+//
+//   Halide::Tools::use_openmp_parallel_runtime();
+//
+// once before running any pipelines. The number of threads is
+// controlled the usual OpenMP ways (OMP_NUM_THREADS,
+// omp_set_num_threads); halide_set_num_threads has no effect. As with
+// any OpenMP code, parallel loops nested inside other parallel work
+// only run in parallel if nested parallelism is enabled.
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <thread>
+
+#include <omp.h>
+
+#include "halide_parallel_runtime_common.h"
+
+namespace Halide {
+namespace Tools {
+
+inline int openmp_do_par_for(void *user_context, halide_task_t task,
+                             int min, int size, uint8_t *closure) {
+    return ParallelRuntime::do_par_for(
+        user_context, task, min, size, closure,
+        [](int min, int size, const std::function<void(int)> &body) {
+#pragma omp parallel for schedule(dynamic, 1) if (size > 1)
+            for (int i = min; i < min + size; i++) {
+                body(i);
+            }
+        });
+}
+
+inline int openmp_do_parallel_tasks(void *user_context, int num_tasks,
+                                    halide_parallel_task_t *tasks, void *task_parent) {
+    ParallelRuntime::ParallelTaskSet set(user_context, num_tasks, tasks);
+    const int threads = std::min(omp_get_max_threads(), set.max_concurrency());
+
+    // The calling thread is thread zero of the team. The others keep
+    // looking for ready work until everything has been claimed. They
+    // can wait for it because OpenMP threads in a parallel region
+    // don't pick up unrelated work, so a waiting thread can't be
+    // holding up an iteration of this set further down its stack.
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        if (omp_get_thread_num() == 0) {
+            set.run_until_finished([]() {});
+        } else {
+            while (!set.all_claimed()) {
+                if (!set.run_one()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+    return set.exit_status();
+}
+
+inline void use_openmp_parallel_runtime() {
+    halide_set_custom_parallel_runtime(openmp_do_par_for,
+                                       ParallelRuntime::do_task,
+                                       ParallelRuntime::do_loop_task,
+                                       openmp_do_parallel_tasks,
+                                       ParallelRuntime::semaphore_init,
+                                       ParallelRuntime::semaphore_try_acquire,
+                                       ParallelRuntime::semaphore_release);
+}
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_OPENMP_PARALLEL_RUNTIME_H
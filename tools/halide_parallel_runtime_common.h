@@ -0,0 +1,224 @@
+#ifndef HALIDE_PARALLEL_RUNTIME_COMMON_H
+#define HALIDE_PARALLEL_RUNTIME_COMMON_H
+
+//---------------------------------------------------------------------------
+// Pieces shared by halide_tbb_parallel_runtime.h and
+// halide_openmp_parallel_runtime.h, which implement Halide's parallel
+// runtime (see halide_set_custom_parallel_runtime) on top of another
+// task system. This file isn't useful on its own.
+//
+// The subtle part is halide_do_parallel_tasks, which is how async()
+// producers and their consumers run. Each call gets a
+// ParallelTaskSet. An iteration of a task is only claimed once all of
+// its semaphores have been acquired, so a claimed iteration never
+// waits on another one in the same set, and the thread that called
+// halide_do_parallel_tasks can always finish the whole set by itself
+// if no other threads help. Other threads only add concurrency. This
+// means the adapters don't need to reserve min_threads threads per
+// task the way Halide's own thread pool does.
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "HalideRuntime.h"
+
+namespace Halide {
+namespace Tools {
+namespace ParallelRuntime {
+
+inline std::atomic<int> *semaphore_value(halide_semaphore_t *s) {
+    static_assert(sizeof(std::atomic<int>) <= sizeof(halide_semaphore_t),
+                  "halide_semaphore_t is too small to hold the semaphore");
+    return reinterpret_cast<std::atomic<int> *>(s);
+}
+
+inline int semaphore_init(halide_semaphore_t *s, int n) {
+    new (s) std::atomic<int>(n);
+    return n;
+}
+
+// Returns the old value, like halide_default_semaphore_release.
+inline int semaphore_release(halide_semaphore_t *s, int n) {
+    return semaphore_value(s)->fetch_add(n, std::memory_order_acq_rel);
+}
+
+inline bool semaphore_try_acquire(halide_semaphore_t *s, int n) {
+    if (n == 0) {
+        return true;
+    }
+    std::atomic<int> *value = semaphore_value(s);
+    int expected = value->load(std::memory_order_acquire);
+    while (expected >= n) {
+        if (value->compare_exchange_weak(expected, expected - n,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int do_task(void *user_context, halide_task_t f, int idx, uint8_t *closure) {
+    return f(user_context, idx, closure);
+}
+
+inline int do_loop_task(void *user_context, halide_loop_task_t f, int min, int extent,
+                        uint8_t *closure, void *task_parent) {
+    return f(user_context, min, extent, closure, task_parent);
+}
+
+// Runs a parallel for loop by calling run_range(min, size, body),
+// which must call body(i) once for each i in [min, min + size). Once
+// an iteration fails, the remaining ones return without doing
+// anything.
+using RunRange = std::function<void(int, int, const std::function<void(int)> &)>;
+
+inline int do_par_for(void *user_context, halide_task_t task, int min, int size,
+                      uint8_t *closure, const RunRange &run_range) {
+    std::atomic<int> result(0);
+    run_range(min, size, [&](int i) {
+        if (result.load(std::memory_order_relaxed) != 0) {
+            return;
+        }
+        int r = task(user_context, i, closure);
+        if (r != 0) {
+            int expected = 0;
+            result.compare_exchange_strong(expected, r);
+        }
+    });
+    return result;
+}
+
+// The state of one call to halide_do_parallel_tasks.
+class ParallelTaskSet {
+    void *user_context;
+    halide_parallel_task_t *tasks;
+    int num_tasks;
+
+    std::mutex mutex;
+    // The next unclaimed iteration of each task.
+    std::vector<int> next;
+    // Whether a serial task has an iteration running.
+    std::vector<bool> running;
+    int unclaimed = 0, in_flight = 0, result = 0;
+    int concurrency = 0;
+
+    bool acquire_semaphores(const halide_parallel_task_t &task) {
+        for (int i = 0; i < task.num_semaphores; i++) {
+            if (!semaphore_try_acquire(task.semaphores[i].semaphore,
+                                       task.semaphores[i].count)) {
+                // Give back the ones we got.
+                for (int j = 0; j < i; j++) {
+                    semaphore_release(task.semaphores[j].semaphore,
+                                      task.semaphores[j].count);
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    ParallelTaskSet(void *user_context, int num_tasks, halide_parallel_task_t *tasks)
+        : user_context(user_context), tasks(tasks), num_tasks(num_tasks),
+          next(num_tasks), running(num_tasks, false) {
+        for (int i = 0; i < num_tasks; i++) {
+            next[i] = tasks[i].min;
+            unclaimed += tasks[i].extent;
+            concurrency += tasks[i].serial ? 1 : tasks[i].extent;
+        }
+    }
+
+    // The most iterations that could ever run at once.
+    int max_concurrency() const {
+        return concurrency;
+    }
+
+    // Claim an iteration that is ready to go and run it. Returns
+    // false if nothing was ready.
+    bool run_one() {
+        int t = -1, min = 0, extent = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (result != 0) {
+                return false;
+            }
+            for (int i = 0; i < num_tasks; i++) {
+                const halide_parallel_task_t &task = tasks[i];
+                if (next[i] == task.min + task.extent ||
+                    (task.serial && running[i]) ||
+                    !acquire_semaphores(task)) {
+                    continue;
+                }
+                t = i;
+                min = next[i];
+                // Without semaphores there's nothing to reacquire
+                // between the iterations of a serial task, so run
+                // the rest of it in one call.
+                extent = (task.serial && task.num_semaphores == 0) ? task.min + task.extent - min : 1;
+                next[i] += extent;
+                running[i] = task.serial;
+                unclaimed -= extent;
+                in_flight++;
+                break;
+            }
+        }
+        if (t < 0) {
+            return false;
+        }
+
+        int r = tasks[t].fn(user_context, min, extent, tasks[t].closure, nullptr);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running[t] = false;
+        in_flight--;
+        if (r != 0 && result == 0) {
+            result = r;
+        }
+        return true;
+    }
+
+    // Whether every iteration has been claimed, or a failure means no
+    // more will be.
+    bool all_claimed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return unclaimed == 0 || result != 0;
+    }
+
+    // Whether the set is complete and no iterations are still running.
+    bool finished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (unclaimed == 0 || result != 0) && in_flight == 0;
+    }
+
+    int exit_status() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return result;
+    }
+
+    // The loop run by the thread that called
+    // halide_do_parallel_tasks. Returns once the set is finished.
+    // on_progress is called after each iteration this thread runs,
+    // which is when more work may have become ready.
+    template<typename OnProgress>
+    void run_until_finished(OnProgress on_progress) {
+        while (!finished()) {
+            if (run_one()) {
+                on_progress();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+}  // namespace ParallelRuntime
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_PARALLEL_RUNTIME_COMMON_H
@@ -0,0 +1,177 @@
+#ifndef HALIDE_PIPELINE_BATCHER_H
+#define HALIDE_PIPELINE_BATCHER_H
+
+//---------------------------------------------------------------------------
+// PipelineBatcher coalesces concurrent calls to a pipeline on small,
+// independent inputs into one call over a batch. Compile a version of
+// the pipeline whose input and output have one more dimension than a
+// single request, with the batch index as the outermost dimension,
+// and usually with the parallel loop over it. Then, from any number of
+// threads:
+//
+//   Halide::Tools::PipelineBatcher<float, float> batcher(
+//       [](Halide::Runtime::Buffer<float> &in, Halide::Runtime::Buffer<float> &out) {
+//           return my_batched_pipeline(in, out);
+//       },
+//       16, std::chrono::microseconds(200));
+//   ...
+//   int result = batcher.run(input, output);
+//
+// The first request in a batch waits until the batch has max_batch
+// requests or the window has passed, whichever is sooner, then runs
+// the batch on its own thread while the others wait for it. Requests
+// are only batched with requests of the same shape. Inputs and
+// outputs must be on the host; they are copied into and out of the
+// batch. Every request in a batch gets the batch's return value.
+//---------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "HalideBuffer.h"
+
+namespace Halide {
+namespace Tools {
+
+template<typename InT, typename OutT>
+class PipelineBatcher {
+public:
+    using BatchedPipeline = std::function<int(Halide::Runtime::Buffer<InT> &,
+                                              Halide::Runtime::Buffer<OutT> &)>;
+
+    PipelineBatcher(BatchedPipeline pipeline, int max_batch, std::chrono::microseconds window)
+        : pipeline(std::move(pipeline)), max_batch(max_batch), window(window) {
+        assert(max_batch > 0);
+    }
+
+    // Run the pipeline on one request. Blocks until its batch is done.
+    int run(const Halide::Runtime::Buffer<InT> &in, Halide::Runtime::Buffer<OutT> &out) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::shared_ptr<Batch> batch;
+        for (const auto &b : open) {
+            if ((int)b->requests.size() < max_batch &&
+                same_shape(*b->requests[0].in, in) &&
+                same_shape(*b->requests[0].out, out)) {
+                batch = b;
+                break;
+            }
+        }
+
+        if (batch) {
+            batch->requests.push_back({&in, &out});
+            if ((int)batch->requests.size() == max_batch) {
+                batch->full.notify_one();
+            }
+            batch->done_cond.wait(lock, [&] { return batch->done; });
+            return batch->result;
+        }
+
+        // Start a new batch, and run it once it fills or the
+        // window closes.
+        batch = std::make_shared<Batch>();
+        batch->requests.push_back({&in, &out});
+        open.push_back(batch);
+        batch->full.wait_for(lock, window, [&] {
+            return (int)batch->requests.size() == max_batch;
+        });
+        for (size_t i = 0; i < open.size(); i++) {
+            if (open[i] == batch) {
+                open.erase(open.begin() + i);
+                break;
+            }
+        }
+        lock.unlock();
+
+        int result = run_batch(batch->requests);
+
+        lock.lock();
+        batch->result = result;
+        batch->done = true;
+        batch->done_cond.notify_all();
+        return result;
+    }
+
+private:
+    struct Request {
+        const Halide::Runtime::Buffer<InT> *in;
+        Halide::Runtime::Buffer<OutT> *out;
+    };
+
+    struct Batch {
+        std::vector<Request> requests;
+        std::condition_variable full, done_cond;
+        bool done = false;
+        int result = 0;
+    };
+
+    BatchedPipeline pipeline;
+    const int max_batch;
+    const std::chrono::microseconds window;
+
+    std::mutex mutex;
+    // Batches that are still accepting requests.
+    std::vector<std::shared_ptr<Batch>> open;
+
+    template<typename A, typename B>
+    static bool same_shape(const Halide::Runtime::Buffer<A> &a, const Halide::Runtime::Buffer<B> &b) {
+        if (a.dimensions() != b.dimensions()) {
+            return false;
+        }
+        for (int i = 0; i < a.dimensions(); i++) {
+            if (a.dim(i).min() != b.dim(i).min() ||
+                a.dim(i).extent() != b.dim(i).extent()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A buffer shaped like b with an outermost dimension of size n.
+    template<typename T>
+    static Halide::Runtime::Buffer<T> make_batched(const Halide::Runtime::Buffer<T> &b, int n) {
+        std::vector<int> sizes, mins;
+        for (int i = 0; i < b.dimensions(); i++) {
+            sizes.push_back(b.dim(i).extent());
+            mins.push_back(b.dim(i).min());
+        }
+        sizes.push_back(n);
+        mins.push_back(0);
+        Halide::Runtime::Buffer<T> batched(sizes);
+        batched.set_min(mins);
+        return batched;
+    }
+
+    int run_batch(const std::vector<Request> &requests) {
+        const int n = (int)requests.size();
+        Halide::Runtime::Buffer<InT> in = make_batched(*requests[0].in, n);
+        Halide::Runtime::Buffer<OutT> out = make_batched(*requests[0].out, n);
+        for (int i = 0; i < n; i++) {
+            in.sliced(in.dimensions() - 1, i).copy_from(*requests[i].in);
+        }
+
+        int result = pipeline(in, out);
+        if (result != 0) {
+            return result;
+        }
+        result = out.copy_to_host();
+        if (result != 0) {
+            return result;
+        }
+
+        for (int i = 0; i < n; i++) {
+            requests[i].out->copy_from(out.sliced(out.dimensions() - 1, i));
+        }
+        return 0;
+    }
+};
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_PIPELINE_BATCHER_H
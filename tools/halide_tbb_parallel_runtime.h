@@ -0,0 +1,88 @@
+#ifndef HALIDE_TBB_PARALLEL_RUNTIME_H
+#define HALIDE_TBB_PARALLEL_RUNTIME_H
+
+//---------------------------------------------------------------------------
+// Runs Halide's parallel loops and async() tasks on Intel TBB instead
+// of Halide's own thread pool, so that an application that already
+// uses TBB doesn't end up with two pools competing for the same
+// cores. Call
+//
+//   Halide::Tools::use_tbb_parallel_runtime();
+//
+// once before running any pipelines. Work is done in whichever task
+// arena the pipeline is called from, so use tbb::task_arena to limit
+// or isolate it. halide_set_num_threads has no effect.
+//---------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+#include "halide_parallel_runtime_common.h"
+
+namespace Halide {
+namespace Tools {
+
+inline int tbb_do_par_for(void *user_context, halide_task_t task,
+                          int min, int size, uint8_t *closure) {
+    return ParallelRuntime::do_par_for(
+        user_context, task, min, size, closure,
+        [](int min, int size, const std::function<void(int)> &body) {
+            tbb::parallel_for(tbb::blocked_range<int>(min, min + size),
+                              [&](const tbb::blocked_range<int> &r) {
+                                  for (int i = r.begin(); i < r.end(); i++) {
+                                      body(i);
+                                  }
+                              });
+        });
+}
+
+inline int tbb_do_parallel_tasks(void *user_context, int num_tasks,
+                                 halide_parallel_task_t *tasks, void *task_parent) {
+    ParallelRuntime::ParallelTaskSet set(user_context, num_tasks, tasks);
+    const int max_helpers =
+        std::min(tbb::this_task_arena::max_concurrency(), set.max_concurrency()) - 1;
+
+    // Helpers run whatever is ready and then return, rather than
+    // waiting for more work to become ready. A helper can be picked
+    // up by a thread that is waiting inside an iteration of this
+    // set, and waiting there could block the iteration it needs. The
+    // calling thread starts new helpers whenever it makes progress.
+    tbb::task_group group;
+    std::atomic<int> helpers(0);
+    auto help = [&]() {
+        while (set.run_one()) {
+        }
+        helpers--;
+    };
+    auto add_helper = [&]() {
+        if (!set.all_claimed() && helpers.load() < max_helpers) {
+            helpers++;
+            group.run(help);
+        }
+    };
+
+    add_helper();
+    set.run_until_finished(add_helper);
+    group.wait();
+    return set.exit_status();
+}
+
+inline void use_tbb_parallel_runtime() {
+    halide_set_custom_parallel_runtime(tbb_do_par_for,
+                                       ParallelRuntime::do_task,
+                                       ParallelRuntime::do_loop_task,
+                                       tbb_do_parallel_tasks,
+                                       ParallelRuntime::semaphore_init,
+                                       ParallelRuntime::semaphore_try_acquire,
+                                       ParallelRuntime::semaphore_release);
+}
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_TBB_PARALLEL_RUNTIME_H
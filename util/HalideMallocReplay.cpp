@@ -0,0 +1,351 @@
+#include "halide_malloc_trace_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** \file
+ *
+ * A tool which replays a binary allocation trace, as captured by
+ * halide_enable_malloc_trace_capture in tools/halide_malloc_trace.h,
+ * against several allocators, and reports the time each takes and the
+ * memory each holds. This makes it possible to choose and tune an
+ * allocator for a pipeline without rerunning the pipeline.
+ *
+ * The calls are replayed on one thread in the order they were
+ * captured in. The allocators are:
+ *
+ *   malloc:     malloc and free, with the 128-byte alignment that the
+ *               default halide_malloc provides.
+ *   arena:      allocations are carved out of large chunks, which are
+ *               reused from the start once nothing is live. This is
+ *               the strategy of Target::ArenaAlloc.
+ *   size_class: sizes are rounded up to one of four classes per power
+ *               of two, and freed blocks are kept on a free list per
+ *               class, as in jemalloc-style allocators.
+ *   pool:       freed blocks are kept, and reused for any request they
+ *               are large enough for, or grown to fit if none is. This
+ *               is the strategy of the pool used by Func::hoist_storage.
+ */
+
+using namespace Halide::Tools;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const size_t alignment = 128;
+
+size_t round_up(size_t x, size_t m) {
+    return (x + m - 1) / m * m;
+}
+
+// The interface of the allocators under test. Each one tracks the
+// bytes it holds from the system.
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+    virtual void *allocate(size_t size) = 0;
+    virtual void release(void *ptr, size_t size) = 0;
+    size_t held = 0, peak_held = 0;
+
+protected:
+    void *system_alloc(size_t size) {
+        held += size;
+        peak_held = std::max(peak_held, held);
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, alignment, std::max(size, alignment)) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        return ptr;
+    }
+
+    void system_free(void *ptr, size_t size) {
+        held -= size;
+        free(ptr);
+    }
+};
+
+class MallocAllocator : public Allocator {
+public:
+    void *allocate(size_t size) override {
+        return system_alloc(size);
+    }
+    void release(void *ptr, size_t size) override {
+        system_free(ptr, size);
+    }
+};
+
+class ArenaAllocator : public Allocator {
+    struct Chunk {
+        uint8_t *base;
+        size_t size, used;
+    };
+    vector<Chunk> chunks;
+    size_t current = 0;
+    int live = 0;
+
+public:
+    ~ArenaAllocator() override {
+        for (Chunk &c : chunks) {
+            system_free(c.base, c.size);
+        }
+    }
+
+    void *allocate(size_t size) override {
+        size = round_up(size, alignment);
+        while (current < chunks.size() && chunks[current].used + size > chunks[current].size) {
+            current++;
+        }
+        if (current == chunks.size()) {
+            size_t chunk_size = std::max(size, (size_t)1 << 20);
+            chunks.push_back({(uint8_t *)system_alloc(chunk_size), chunk_size, 0});
+        }
+        Chunk &c = chunks[current];
+        void *ptr = c.base + c.used;
+        c.used += size;
+        live++;
+        return ptr;
+    }
+
+    void release(void *ptr, size_t size) override {
+        if (--live == 0) {
+            for (Chunk &c : chunks) {
+                c.used = 0;
+            }
+            current = 0;
+        }
+    }
+};
+
+class SizeClassAllocator : public Allocator {
+    std::map<size_t, vector<void *>> free_lists;
+    vector<std::pair<void *, size_t>> blocks;
+
+    static size_t size_class(size_t size) {
+        size = std::max(size, (size_t)64);
+        size_t p = 64;
+        while (p * 2 < size) {
+            p *= 2;
+        }
+        // Four classes between p and 2p.
+        return round_up(size, std::max(p / 4, (size_t)16));
+    }
+
+public:
+    ~SizeClassAllocator() override {
+        for (auto &b : blocks) {
+            system_free(b.first, b.second);
+        }
+    }
+
+    void *allocate(size_t size) override {
+        size_t c = size_class(size);
+        vector<void *> &list = free_lists[c];
+        if (!list.empty()) {
+            void *ptr = list.back();
+            list.pop_back();
+            return ptr;
+        }
+        void *ptr = system_alloc(c);
+        blocks.emplace_back(ptr, c);
+        return ptr;
+    }
+
+    void release(void *ptr, size_t size) override {
+        free_lists[size_class(size)].push_back(ptr);
+    }
+};
+
+class PoolAllocator : public Allocator {
+    // The free blocks and their sizes, and the sizes of the blocks in use.
+    vector<std::pair<void *, size_t>> free_blocks;
+    std::unordered_map<void *, size_t> in_use;
+
+public:
+    ~PoolAllocator() override {
+        for (auto &b : free_blocks) {
+            system_free(b.first, b.second);
+        }
+        for (auto &b : in_use) {
+            system_free(b.first, b.second);
+        }
+    }
+
+    void *allocate(size_t size) override {
+        for (size_t i = 0; i < free_blocks.size(); i++) {
+            if (free_blocks[i].second >= size) {
+                auto b = free_blocks[i];
+                free_blocks.erase(free_blocks.begin() + i);
+                in_use[b.first] = b.second;
+                return b.first;
+            }
+        }
+        if (!free_blocks.empty()) {
+            // Grow a free block to fit.
+            auto b = free_blocks.front();
+            free_blocks.erase(free_blocks.begin());
+            system_free(b.first, b.second);
+        }
+        void *ptr = system_alloc(size);
+        in_use[ptr] = size;
+        return ptr;
+    }
+
+    void release(void *ptr, size_t size) override {
+        auto it = in_use.find(ptr);
+        free_blocks.emplace_back(it->first, it->second);
+        in_use.erase(it);
+    }
+};
+
+std::unique_ptr<Allocator> make_allocator(const string &name) {
+    if (name == "malloc") {
+        return std::unique_ptr<Allocator>(new MallocAllocator);
+    } else if (name == "arena") {
+        return std::unique_ptr<Allocator>(new ArenaAllocator);
+    } else if (name == "size_class") {
+        return std::unique_ptr<Allocator>(new SizeClassAllocator);
+    } else if (name == "pool") {
+        return std::unique_ptr<Allocator>(new PoolAllocator);
+    }
+    return nullptr;
+}
+
+struct ReplayResult {
+    double ns_per_call;
+    size_t peak_held;
+};
+
+// Replay the trace the given number of times with a fresh allocator,
+// optionally writing to each page of each allocation, as the pipeline
+// would.
+ReplayResult replay(const MallocTrace &trace, const string &allocator_name, int iterations, bool touch) {
+    std::unique_ptr<Allocator> allocator = make_allocator(allocator_name);
+    std::unordered_map<uint64_t, void *> live;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const MallocTraceRecord &r : trace.records) {
+            if (r.event == malloc_trace_malloc) {
+                uint8_t *ptr = (uint8_t *)allocator->allocate(r.size);
+                if (touch) {
+                    for (uint64_t j = 0; j < r.size; j += 4096) {
+                        ptr[j] = 0;
+                    }
+                }
+                live[r.id] = ptr;
+            } else {
+                auto it = live.find(r.id);
+                if (it != live.end()) {
+                    allocator->release(it->second, r.size);
+                    live.erase(it);
+                }
+            }
+        }
+        // Free anything the trace never freed, so that iterations
+        // don't accumulate memory.
+        for (const MallocTraceRecord &r : trace.records) {
+            auto it = live.find(r.id);
+            if (r.event == malloc_trace_malloc && it != live.end()) {
+                allocator->release(it->second, r.size);
+                live.erase(it);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return {ns / std::max<size_t>(1, trace.records.size() * iterations), allocator->peak_held};
+}
+
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [-n iterations] [-touch] trace_file [allocator ...]\n"
+            "Replays an allocation trace against the given allocators, or all of them:\n"
+            "  malloc arena size_class pool\n"
+            "-touch writes to every page of each allocation.\n",
+            name);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    int iterations = 100;
+    bool touch = false;
+    const char *filename = nullptr;
+    vector<string> allocators;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-touch")) {
+            touch = true;
+        } else if (!filename) {
+            filename = argv[i];
+        } else if (make_allocator(argv[i])) {
+            allocators.push_back(argv[i]);
+        } else {
+            fprintf(stderr, "Unknown allocator: %s\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!filename) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (allocators.empty()) {
+        allocators = {"malloc", "arena", "size_class", "pool"};
+    }
+
+    MallocTrace trace;
+    if (!trace.read(filename)) {
+        fprintf(stderr, "Could not read allocation trace %s\n", filename);
+        return 1;
+    }
+
+    // Summarize the allocations of each Func.
+    struct FuncSummary {
+        uint64_t count = 0, bytes = 0, max_size = 0;
+    };
+    std::map<string, FuncSummary> funcs;
+    uint64_t live_bytes = 0, peak_live_bytes = 0;
+    std::map<uint32_t, bool> threads;
+    for (const MallocTraceRecord &r : trace.records) {
+        threads[r.thread] = true;
+        if (r.event == malloc_trace_malloc) {
+            FuncSummary &s = funcs[trace.func_name(r)];
+            s.count++;
+            s.bytes += r.size;
+            s.max_size = std::max(s.max_size, r.size);
+            live_bytes += r.size;
+            peak_live_bytes = std::max(peak_live_bytes, live_bytes);
+        } else {
+            live_bytes -= r.size;
+        }
+    }
+    printf("%zu calls on %zu threads, peak live bytes: %llu\n\n",
+           trace.records.size(), threads.size(), (unsigned long long)peak_live_bytes);
+    printf("%-32s %10s %14s %14s\n", "Func", "mallocs", "total bytes", "max bytes");
+    for (const auto &f : funcs) {
+        printf("%-32s %10llu %14llu %14llu\n", f.first.c_str(),
+               (unsigned long long)f.second.count,
+               (unsigned long long)f.second.bytes,
+               (unsigned long long)f.second.max_size);
+    }
+
+    printf("\n%-12s %14s %16s\n", "allocator", "ns per call", "peak bytes held");
+    for (const string &a : allocators) {
+        ReplayResult r = replay(trace, a, iterations, touch);
+        printf("%-12s %14.1f %16llu\n", a.c_str(), r.ns_per_call, (unsigned long long)r.peak_held);
+    }
+    return 0;
+}
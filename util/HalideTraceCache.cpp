@@ -0,0 +1,504 @@
+#include "HalideTraceUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/** \file
+ *
+ * A tool which reads a binary Halide trace containing loads and stores,
+ * and reports the memory behavior of each traced Func: its footprint,
+ * the distribution of reuse distances of its accesses, and its hit
+ * rates in a simulated two-level cache.
+ *
+ * Traces only record coordinates, so addresses are reconstructed by
+ * assuming each realization of a Func is a dense buffer covering the
+ * bounds given by its begin-realization event, with the innermost
+ * dimension stored contiguously. Accesses to Funcs with no
+ * realization in the trace (inputs and outputs) are assumed to fall in
+ * a dense buffer covering every coordinate accessed. A Func that is
+ * realized repeatedly (e.g. because it is computed at some loop level
+ * of a consumer) reuses the same memory each time, as it typically does
+ * with the default allocator.
+ */
+
+using namespace Halide;
+using namespace Internal;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+struct CacheOpts {
+    int line_bytes = 64;
+    int64_t l1_bytes = 32 * 1024;
+    int l1_ways = 8;
+    int64_t l2_bytes = 256 * 1024;
+    int l2_ways = 8;
+};
+
+// A set-associative cache with LRU replacement.
+class Cache {
+    int64_t sets;
+    int ways;
+    // For each set, the lines it holds, most recently used first.
+    vector<vector<uint64_t>> contents;
+
+public:
+    Cache(int64_t bytes, int ways, int line_bytes)
+        : sets(std::max<int64_t>(1, bytes / line_bytes / ways)), ways(ways), contents(sets) {
+    }
+
+    // Returns true if the access hits. The line is now the most
+    // recently used in its set.
+    bool access(uint64_t line) {
+        vector<uint64_t> &set = contents[line % sets];
+        auto it = std::find(set.begin(), set.end(), line);
+        bool hit = it != set.end();
+        if (hit) {
+            set.erase(it);
+        } else if ((int)set.size() == ways) {
+            set.pop_back();
+        }
+        set.insert(set.begin(), line);
+        return hit;
+    }
+};
+
+// Computes LRU stack distances, i.e. the number of distinct lines
+// accessed since the previous access to the same line. A Fenwick tree
+// over access times holds a one at the time of the most recent access
+// to each line, so the distance is a prefix sum.
+class ReuseDistance {
+    vector<int> tree;
+    std::unordered_map<uint64_t, int64_t> last_access;
+    int64_t now = 0;
+
+    void add(int64_t t, int delta) {
+        for (t++; t <= (int64_t)tree.size(); t += t & -t) {
+            tree[t - 1] += delta;
+        }
+    }
+
+    int64_t prefix_sum(int64_t t) const {
+        int64_t result = 0;
+        for (t++; t > 0; t -= t & -t) {
+            result += tree[t - 1];
+        }
+        return result;
+    }
+
+public:
+    ReuseDistance(int64_t total_accesses)
+        : tree(total_accesses) {
+    }
+
+    // Returns the reuse distance of an access to the given line, or -1
+    // if the line has not been accessed before.
+    int64_t access(uint64_t line) {
+        int64_t distance = -1;
+        auto it = last_access.find(line);
+        if (it != last_access.end()) {
+            distance = prefix_sum(now - 1) - prefix_sum(it->second);
+            add(it->second, -1);
+            it->second = now;
+        } else {
+            last_access[line] = now;
+        }
+        add(now, 1);
+        now++;
+        return distance;
+    }
+};
+
+// Reuse distances are bucketed by powers of two: bucket 0 counts
+// first touches, and bucket b > 0 counts distances in [2^(b-1) - 1, 2^b - 1).
+const int num_distance_buckets = 40;
+
+int distance_bucket(int64_t distance) {
+    int b = 0;
+    for (int64_t d = distance + 1; d > 0; d >>= 1) {
+        b++;
+    }
+    return std::min(b, num_distance_buckets - 1);
+}
+
+// A dense region of memory assigned to a Func.
+struct Region {
+    uint64_t base = 0;
+    int64_t capacity = 0;
+    vector<int> min, extent;
+
+    int64_t elements() const {
+        int64_t n = 1;
+        for (int e : extent) {
+            n *= e;
+        }
+        return n;
+    }
+};
+
+struct FuncInfo {
+    int elem_bytes = 0;
+
+    // Bounds of accesses made outside of any realization.
+    vector<int> unrealized_min, unrealized_max;
+
+    // The memory used by realizations of this Func, and the
+    // realizations currently in progress, innermost last.
+    Region storage;
+    vector<Region> realizations;
+    Region unrealized;
+
+    // Stats
+    int64_t loads = 0, stores = 0;
+    int64_t l1_hits = 0, l2_hits = 0;
+    int64_t num_realizations = 0;
+    int64_t peak_realization_bytes = 0;
+    std::unordered_set<uint64_t> lines_touched;
+    vector<int64_t> distance_histogram = vector<int64_t>(num_distance_buckets);
+
+    int64_t accesses() const {
+        return loads + stores;
+    }
+};
+
+class Simulator {
+    CacheOpts opts;
+    map<string, FuncInfo> funcs;
+    uint64_t next_base = 0;
+    int64_t total_accesses = 0;
+
+    uint64_t allocate(int64_t bytes) {
+        const uint64_t base = next_base;
+        next_base += (bytes + 4095) & ~(int64_t)4095;
+        return base;
+    }
+
+    int real_dims(const Packet &p) const {
+        return p.dimensions / p.type.lanes;
+    }
+
+    int coord(const Packet &p, int dim, int lane) const {
+        return p.coordinates()[p.type.lanes * dim + lane];
+    }
+
+    // The region accessed by a load or store of the given Func.
+    const Region &region_for(FuncInfo &fi) {
+        if (!fi.realizations.empty()) {
+            return fi.realizations.back();
+        }
+        if (fi.unrealized.extent.empty() && !fi.unrealized_min.empty()) {
+            for (size_t i = 0; i < fi.unrealized_min.size(); i++) {
+                fi.unrealized.min.push_back(fi.unrealized_min[i]);
+                fi.unrealized.extent.push_back(fi.unrealized_max[i] - fi.unrealized_min[i] + 1);
+            }
+            fi.unrealized.capacity = fi.unrealized.elements();
+            fi.unrealized.base = allocate(fi.unrealized.capacity * fi.elem_bytes);
+        }
+        return fi.unrealized;
+    }
+
+public:
+    Simulator(const CacheOpts &opts)
+        : opts(opts) {
+    }
+
+    // First pass: find the element size of each Func, the bounds of
+    // accesses made outside of realizations, and the number of
+    // accesses.
+    void preprocess(const Packet &p) {
+        if (p.event == halide_trace_begin_realization) {
+            funcs[p.func()].realizations.emplace_back();
+        } else if (p.event == halide_trace_end_realization) {
+            FuncInfo &fi = funcs[p.func()];
+            if (!fi.realizations.empty()) {
+                fi.realizations.pop_back();
+            }
+        } else if (p.event == halide_trace_load || p.event == halide_trace_store) {
+            FuncInfo &fi = funcs[p.func()];
+            fi.elem_bytes = std::max(fi.elem_bytes, (int)p.type.bytes());
+            total_accesses += p.type.lanes;
+            if (!fi.realizations.empty()) {
+                return;
+            }
+            const int dims = real_dims(p);
+            if (fi.unrealized_min.empty()) {
+                fi.unrealized_min.resize(dims, INT32_MAX);
+                fi.unrealized_max.resize(dims, INT32_MIN);
+            } else if ((int)fi.unrealized_min.size() != dims) {
+                fprintf(stderr, "Error: packet dimensionality doesn't match previous packets of same Func. Aborting.\n");
+                exit(-1);
+            }
+            for (int lane = 0; lane < p.type.lanes; lane++) {
+                for (int i = 0; i < dims; i++) {
+                    fi.unrealized_min[i] = std::min(fi.unrealized_min[i], coord(p, i, lane));
+                    fi.unrealized_max[i] = std::max(fi.unrealized_max[i], coord(p, i, lane));
+                }
+            }
+        }
+    }
+
+    // Second pass: assign addresses to each access and simulate them.
+    void simulate(FILE *file_desc) {
+        for (auto &it : funcs) {
+            it.second.realizations.clear();
+        }
+
+        ReuseDistance reuse(total_accesses);
+        Cache l1(opts.l1_bytes, opts.l1_ways, opts.line_bytes);
+        Cache l2(opts.l2_bytes, opts.l2_ways, opts.line_bytes);
+
+        int packet_count = 0;
+        for (;;) {
+            Packet p;
+            if (!p.read_from_filedesc(file_desc)) {
+                printf("[INFO] Finished pass 2 after %d packets.\n", packet_count);
+                break;
+            }
+            packet_count++;
+            if ((packet_count % 1000000) == 0) {
+                printf("[INFO] Pass 2: Read %d packets so far.\n", packet_count);
+            }
+
+            if (p.event == halide_trace_begin_realization) {
+                FuncInfo &fi = funcs[p.func()];
+                Region r;
+                for (int i = 0; i + 1 < p.dimensions; i += 2) {
+                    r.min.push_back(p.coordinates()[i]);
+                    r.extent.push_back(p.coordinates()[i + 1]);
+                }
+                const int64_t elems = r.elements();
+                if (fi.realizations.empty()) {
+                    // Reuse the Func's storage from any previous
+                    // realization, if it is large enough.
+                    if (fi.storage.capacity < elems) {
+                        fi.storage.capacity = elems;
+                        fi.storage.base = allocate(elems * fi.elem_bytes);
+                    }
+                    r.base = fi.storage.base;
+                    r.capacity = fi.storage.capacity;
+                } else {
+                    // Nested realization of the same Func.
+                    r.capacity = elems;
+                    r.base = allocate(elems * fi.elem_bytes);
+                }
+                fi.num_realizations++;
+                fi.peak_realization_bytes = std::max(fi.peak_realization_bytes, elems * fi.elem_bytes);
+                fi.realizations.push_back(r);
+            } else if (p.event == halide_trace_end_realization) {
+                FuncInfo &fi = funcs[p.func()];
+                if (!fi.realizations.empty()) {
+                    fi.realizations.pop_back();
+                }
+            } else if (p.event == halide_trace_load || p.event == halide_trace_store) {
+                FuncInfo &fi = funcs[p.func()];
+                const Region &r = region_for(fi);
+                const int dims = std::min(real_dims(p), (int)r.extent.size());
+                for (int lane = 0; lane < p.type.lanes; lane++) {
+                    int64_t offset = 0, stride = 1;
+                    for (int i = 0; i < dims; i++) {
+                        offset += (int64_t)(coord(p, i, lane) - r.min[i]) * stride;
+                        stride *= r.extent[i];
+                    }
+                    const uint64_t addr = r.base + offset * fi.elem_bytes;
+                    const uint64_t line = addr / opts.line_bytes;
+
+                    if (p.event == halide_trace_load) {
+                        fi.loads++;
+                    } else {
+                        fi.stores++;
+                    }
+                    fi.lines_touched.insert(line);
+                    fi.distance_histogram[distance_bucket(reuse.access(line))]++;
+                    if (l1.access(line)) {
+                        fi.l1_hits++;
+                        // Keep L2 inclusive of L1, as its LRU state
+                        // would be if L1 hits were also L2 hits.
+                        l2.access(line);
+                    } else if (l2.access(line)) {
+                        fi.l2_hits++;
+                    }
+                }
+            }
+        }
+    }
+
+    void report() const {
+        const int64_t l1_lines = opts.l1_bytes / opts.line_bytes;
+        const int64_t l2_lines = opts.l2_bytes / opts.line_bytes;
+
+        printf("\nCache model:\n");
+        printf("  Line size: %d bytes\n", opts.line_bytes);
+        printf("  L1: %lld bytes, %d-way\n", (long long)opts.l1_bytes, opts.l1_ways);
+        printf("  L2: %lld bytes, %d-way\n", (long long)opts.l2_bytes, opts.l2_ways);
+
+        vector<int64_t> total_histogram(num_distance_buckets);
+        int64_t total = 0, total_l1_hits = 0, total_l2_hits = 0;
+
+        printf("\nTrace stats:\n");
+        printf("  Funcs:\n");
+        for (const auto &pair : funcs) {
+            const FuncInfo &fi = pair.second;
+            if (!fi.accesses()) {
+                continue;
+            }
+            printf("    %s:\n", pair.first.c_str());
+            printf("      Loads: %lld\n", (long long)fi.loads);
+            printf("      Stores: %lld\n", (long long)fi.stores);
+            printf("      Realizations: %lld\n", (long long)fi.num_realizations);
+            if (fi.num_realizations) {
+                printf("      Peak realization size: %lld bytes\n", (long long)fi.peak_realization_bytes);
+            }
+            printf("      Footprint: %lld lines (%lld bytes)\n",
+                   (long long)fi.lines_touched.size(),
+                   (long long)fi.lines_touched.size() * opts.line_bytes);
+
+            // The fraction of accesses that would hit in a fully
+            // associative LRU cache of the size of each level.
+            int64_t within_l1 = 0, within_l2 = 0;
+            for (int b = 1; b < num_distance_buckets; b++) {
+                const int64_t max_distance = ((int64_t)1 << b) - 2;
+                if (max_distance < l1_lines) {
+                    within_l1 += fi.distance_histogram[b];
+                }
+                if (max_distance < l2_lines) {
+                    within_l2 += fi.distance_histogram[b];
+                }
+            }
+            const double n = (double)fi.accesses();
+            printf("      First touches: %.2f%%\n", 100.0 * fi.distance_histogram[0] / n);
+            printf("      Reuse distance fits in L1: %.2f%%, L2: %.2f%%\n",
+                   100.0 * within_l1 / n, 100.0 * within_l2 / n);
+            printf("      L1 hit rate: %.2f%%\n", 100.0 * fi.l1_hits / n);
+            printf("      L2 hit rate: %.2f%%\n", 100.0 * (fi.l1_hits + fi.l2_hits) / n);
+
+            for (int b = 0; b < num_distance_buckets; b++) {
+                total_histogram[b] += fi.distance_histogram[b];
+            }
+            total += fi.accesses();
+            total_l1_hits += fi.l1_hits;
+            total_l2_hits += fi.l2_hits;
+        }
+
+        if (!total) {
+            printf("\nNo loads or stores found. Trace with Func::trace_loads(),\n"
+                   "Func::trace_stores(), or the trace_loads and trace_stores\n"
+                   "target features.\n");
+            return;
+        }
+
+        printf("\n  All Funcs:\n");
+        printf("    Accesses: %lld\n", (long long)total);
+        printf("    L1 hit rate: %.2f%%\n", 100.0 * total_l1_hits / total);
+        printf("    L2 hit rate: %.2f%%\n", 100.0 * (total_l1_hits + total_l2_hits) / total);
+        printf("    Reuse distance histogram (in lines):\n");
+        printf("      first touch: %lld\n", (long long)total_histogram[0]);
+        int64_t cumulative = total_histogram[0];
+        for (int b = 1; b < num_distance_buckets; b++) {
+            if (!total_histogram[b]) {
+                continue;
+            }
+            cumulative += total_histogram[b];
+            printf("      < %lld: %lld (cumulative %.2f%%)\n",
+                   ((long long)1 << b) - 1, (long long)total_histogram[b],
+                   100.0 * cumulative / total);
+        }
+        printf("Done.\n");
+    }
+};
+
+void usage(char * const *argv) {
+    const string usage =
+        "Usage: " + string(argv[0]) + " -i trace_file [options]\n"
+        "\n"
+        "This tool reads a binary trace produced by Halide, and reports the\n"
+        "footprint, reuse distances, and simulated cache hit rates of the\n"
+        "loads and stores of each Func. To generate a suitable binary trace,\n"
+        "use Func::trace_loads() and Func::trace_stores(), or the target\n"
+        "features trace_loads, trace_stores and trace_realizations, and run\n"
+        "with HL_TRACE_FILE=<filename>.\n"
+        "\n"
+        "Options:\n"
+        "  --line bytes: The cache line size. Defaults to 64.\n"
+        "  --l1 bytes ways: The size and associativity of the L1 cache.\n"
+        "      Defaults to 32768 8.\n"
+        "  --l2 bytes ways: The size and associativity of the L2 cache.\n"
+        "      Defaults to 262144 8.\n";
+    fprintf(stderr, "%s\n", usage.c_str());
+    exit(1);
+}
+
+}  // namespace
+
+int main(int argc, char * const *argv) {
+    char *buf_filename = nullptr;
+    CacheOpts opts;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) {
+            buf_filename = argv[++i];
+        } else if (arg == "--line" && i + 1 < argc) {
+            opts.line_bytes = atoi(argv[++i]);
+        } else if (arg == "--l1" && i + 2 < argc) {
+            opts.l1_bytes = atoll(argv[++i]);
+            opts.l1_ways = atoi(argv[++i]);
+        } else if (arg == "--l2" && i + 2 < argc) {
+            opts.l2_bytes = atoll(argv[++i]);
+            opts.l2_ways = atoi(argv[++i]);
+        } else {
+            usage(argv);
+        }
+    }
+
+    if (buf_filename == nullptr ||
+        opts.line_bytes <= 0 ||
+        opts.l1_bytes <= 0 || opts.l1_ways <= 0 ||
+        opts.l2_bytes <= 0 || opts.l2_ways <= 0) {
+        usage(argv);
+    }
+
+    FILE *file_desc = fopen(buf_filename, "r");
+    if (file_desc == nullptr) {
+        fprintf(stderr, "Error opening file: %s. Exiting.\n", buf_filename);
+        exit(1);
+    }
+
+    Simulator sim(opts);
+
+    printf("[INFO] First pass...\n");
+    int packet_count = 0;
+    for (;;) {
+        Packet p;
+        if (!p.read_from_filedesc(file_desc)) {
+            printf("[INFO] Finished pass 1 after %d packets.\n", packet_count);
+            break;
+        }
+        packet_count++;
+        if ((packet_count % 1000000) == 0) {
+            printf("[INFO] Pass 1: Read %d packets so far.\n", packet_count);
+        }
+        sim.preprocess(p);
+    }
+
+    fseek(file_desc, 0, SEEK_SET);
+    if (ferror(file_desc)) {
+        fprintf(stderr, "Error: couldn't seek back to beginning of trace file. Aborting.\n");
+        exit(-1);
+    }
+
+    printf("[INFO] Second pass...\n");
+    sim.simulate(file_desc);
+    fclose(file_desc);
+
+    sim.report();
+    return 0;
+}
@@ -4,16 +4,83 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <map>
+#include <string>
+
 namespace Halide {
 namespace Internal {
 
+namespace {
+
+// What we know about each trace stream being read.
+struct StreamState {
+    bool compact = false;
+    std::map<uint32_t, std::string> strings;
+};
+
+std::map<FILE *, StreamState> stream_states;
+
+bool read_varint(FILE *fdesc, uint64_t *result) {
+    uint64_t x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(fdesc);
+        if (c == EOF) {
+            return false;
+        }
+        x |= (uint64_t)(c & 127) << shift;
+        if (!(c & 128)) {
+            *result = x;
+            return true;
+        }
+    }
+    fprintf(stderr, "Bad varint in trace stream\n");
+    exit(-1);
+    return false;
+}
+
+int64_t unzigzag(uint64_t x) {
+    return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+}
+
+}  // namespace
+
 bool Packet::read_from_stdin() {
     return read_from_filedesc(stdin);
 }
 
 bool Packet::read_from_filedesc(FILE *fdesc){
+    if (ftell(fdesc) == 0) {
+        // A new stream (or a FILE * reused for a different one).
+        stream_states.erase(fdesc);
+    }
+    StreamState &state = stream_states[fdesc];
+
+    while (state.compact) {
+        int kind = fgetc(fdesc);
+        if (kind == EOF) {
+            return false;
+        }
+        if (kind == halide_trace_compact_event) {
+            return read_compact(kind, fdesc);
+        } else if (!read_compact(kind, fdesc)) {
+            return false;
+        }
+    }
+
+    // Read the size field first, to check it isn't actually the
+    // header of a compact trace.
     size_t header_size = sizeof(halide_trace_packet_t);
-    if (!Packet::read(this, header_size, fdesc)) {
+    if (!Packet::read(this, 4, fdesc)) {
+        return false;
+    }
+    const uint8_t *first_bytes = (const uint8_t *)this;
+    if (first_bytes[0] == halide_trace_compact_header &&
+        first_bytes[1] == 'H' && first_bytes[2] == 'T' && first_bytes[3] == '2') {
+        state.compact = true;
+        return read_from_filedesc(fdesc);
+    }
+    if (!Packet::read((uint8_t *)this + 4, header_size - 4, fdesc)) {
+        fprintf(stderr, "Unexpected EOF mid-packet");
         return false;
     }
     size_t payload_size = size - header_size;
@@ -29,6 +96,86 @@ bool Packet::read_from_filedesc(FILE *fdesc){
     return true;
 }
 
+bool Packet::read_compact(int kind, FILE *fdesc) {
+    StreamState &state = stream_states[fdesc];
+    if (kind == halide_trace_compact_header) {
+        char magic[3];
+        if (!Packet::read(magic, 3, fdesc) || memcmp(magic, "HT2", 3) != 0) {
+            fprintf(stderr, "Bad header in compact trace stream\n");
+            exit(-1);
+        }
+        // Each new trace has its own string table.
+        state.strings.clear();
+        return true;
+    } else if (kind == halide_trace_compact_string) {
+        uint64_t id, len;
+        if (!read_varint(fdesc, &id) || !read_varint(fdesc, &len)) {
+            fprintf(stderr, "Unexpected EOF mid-packet");
+            return false;
+        }
+        std::string str(len, ' ');
+        if (!Packet::read(&str[0], len, fdesc)) {
+            fprintf(stderr, "Unexpected EOF mid-packet");
+            return false;
+        }
+        state.strings[(uint32_t)id] = str;
+        return true;
+    } else if (kind != halide_trace_compact_event) {
+        fprintf(stderr, "Unknown record type %d in compact trace stream\n", kind);
+        exit(-1);
+    }
+
+    uint64_t fields[11];
+    for (int i = 0; i < 11; i++) {
+        if (!read_varint(fdesc, &fields[i])) {
+            fprintf(stderr, "Unexpected EOF mid-packet");
+            return false;
+        }
+    }
+    this->id = (int32_t)fields[0];
+    parent_id = (int32_t)unzigzag(fields[1]);
+    event = (halide_trace_event_code_t)fields[2];
+    type.code = (halide_type_code_t)fields[3];
+    type.bits = (uint8_t)fields[4];
+    type.lanes = (uint16_t)fields[5];
+    value_index = (int32_t)unzigzag(fields[6]);
+    const std::string &func_name = state.strings[(uint32_t)fields[7]];
+    const std::string &tag = state.strings[(uint32_t)fields[8]];
+    dimensions = (int32_t)fields[9];
+    size_t value_bytes = (size_t)fields[10];
+    if (value_bytes && value_bytes != (size_t)(type.lanes * type.bytes())) {
+        fprintf(stderr, "Bad value size in compact trace stream\n");
+        exit(-1);
+    }
+    size_t payload_size = dimensions * sizeof(int32_t) + type.lanes * type.bytes() +
+        func_name.size() + 1 + tag.size() + 1;
+    if (payload_size > sizeof(payload)) {
+        fprintf(stderr, "Payload larger than %d bytes in trace stream (%d)\n", (int)sizeof(payload), (int)payload_size);
+        abort();
+        return false;
+    }
+    size = (uint32_t)((sizeof(halide_trace_packet_t) + payload_size + 3) & ~3);
+
+    int32_t prev = 0;
+    for (int i = 0; i < dimensions; i++) {
+        uint64_t delta;
+        if (!read_varint(fdesc, &delta)) {
+            fprintf(stderr, "Unexpected EOF mid-packet");
+            return false;
+        }
+        prev = (int32_t)(prev + unzigzag(delta));
+        coordinates()[i] = prev;
+    }
+    memset(value(), 0, type.lanes * type.bytes());
+    if (value_bytes && !Packet::read(value(), value_bytes, fdesc)) {
+        fprintf(stderr, "Unexpected EOF mid-packet");
+        return false;
+    }
+    memcpy(func(), func_name.c_str(), func_name.size() + 1);
+    memcpy(trace_tag(), tag.c_str(), tag.size() + 1);
+    return true;
+}
+
 bool Packet::read(void *d, size_t size, FILE *fdesc) {
     uint8_t *dst = (uint8_t *)d;
     if (!size) return true;
@@ -87,11 +87,15 @@ struct Packet : public halide_trace_packet_t {
     bool read_from_stdin();
 
     // Grab a packet from a particular fctl file descriptor. Returns false when end is reached.
+    // Traces in the compact format are expanded back into regular packets.
     bool read_from_filedesc(FILE *fdesc);
 
 private:
     // Do a blocking read of some number of bytes from a unistd file descriptor.
     bool read(void *d, size_t size, FILE *fdesc);
+
+    // Read the rest of a record in the compact format, given its first byte.
+    bool read_compact(int kind, FILE *fdesc);
 };
 
 }
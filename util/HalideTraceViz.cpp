@@ -8,6 +8,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -37,6 +38,20 @@ namespace {
 
 bool verbose = false;
 
+// Options that only affect how (and how often) frames are rendered, not
+// what they look like, so they aren't part of GlobalConfig and can't be
+// set via trace tags.
+struct RenderOptions {
+    // Only write every Nth frame to the output.
+    int frame_skip = 1;
+    // Write nothing but the final frame of the trace.
+    bool final_frame_only = false;
+    // Number of threads used for per-pixel work. 0 means one per core.
+    int threads = 0;
+};
+
+RenderOptions render_options;
+
 // Log informational output to stderr, but only in verbose mode
 struct info {
     std::ostringstream msg;
@@ -320,6 +335,17 @@ parameters should be set zero or one times:
  --hold frames: How many frames to output after the end of the
     trace. Defaults to 250.
 
+ --frame_skip n: Only output every nth frame. The skipped frames are
+    still accumulated, so highlights decay the same way they would
+    otherwise. Defaults to 1.
+
+ --final_frame_only: Only output a single frame, showing the state at
+    the end of the trace. Implies --hold 0. Useful for quickly checking
+    a visualization of a long-running pipeline.
+
+ --threads n: How many threads to use when compositing frames. Defaults
+    to one per core.
+
 The following parameters can be set once per Func. With the exception
 of label, they continue to take effect for all subsequently defined
 Funcs.
@@ -769,6 +795,14 @@ void process_args(int argc, char **argv, VizState *state) {
         } else if (next == "--hold") {
             expect(i + 1 < argc, i);
             globals.hold_frames = parse_int(argv[++i]);
+        } else if (next == "--frame_skip") {
+            expect(i + 1 < argc, i);
+            render_options.frame_skip = std::max(1, parse_int(argv[++i]));
+        } else if (next == "--final_frame_only") {
+            render_options.final_frame_only = true;
+        } else if (next == "--threads") {
+            expect(i + 1 < argc, i);
+            render_options.threads = std::max(0, parse_int(argv[++i]));
         } else if (next == "--uninit") {
             expect(i + 3 < argc, i);
             int r = parse_int(argv[++i]);
@@ -804,8 +838,31 @@ void process_args(int argc, char **argv, VizState *state) {
 // it, and text labels. These layers get composited.
 struct Surface {
     const Point frame_size;
+    const int num_threads;
     std::vector<uint32_t> image, anim, anim_decay, text_buf, blend;
 
+    // Call f(begin, end) on disjoint ranges of whole rows that
+    // together cover the frame, using up to num_threads threads.
+    template<typename Fn>
+    void parallel_for_pixels(Fn f) {
+        const size_t n = frame_elems();
+        const int tasks = std::max(1, std::min(num_threads, frame_size.y));
+        if (tasks == 1) {
+            f((size_t)0, n);
+            return;
+        }
+        const size_t rows_per_task = (frame_size.y + tasks - 1) / tasks;
+        const size_t elems_per_task = rows_per_task * frame_size.x;
+        std::vector<std::thread> workers;
+        for (size_t begin = elems_per_task; begin < n; begin += elems_per_task) {
+            workers.emplace_back(f, begin, std::min(n, begin + elems_per_task));
+        }
+        f((size_t)0, std::min(n, elems_per_task));
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+
     // Composite a single pixel of 'over' over a single pixel of 'under', writing the result into dst.
     // Note that under or over might be dst.
     static void composite_one(const uint32_t *under, const uint32_t *over, uint32_t *dst) {
@@ -828,10 +885,10 @@ struct Surface {
         }
     }
 
-    void do_decay(int decay_factor, uint32_t *dst) {
+    static void do_decay(int decay_factor, uint32_t *dst, uint32_t *dst_end) {
         if (decay_factor != 1) {
             const uint32_t inv_d1 = (1 << 24) / std::max(1, decay_factor);
-            for (uint32_t *dst_end = dst + frame_elems(); dst < dst_end; ++dst) {
+            for (; dst < dst_end; ++dst) {
                 uint32_t color = *dst;
                 uint32_t rgb = color & 0x00ffffff;
                 uint32_t alpha = (color >> 24);
@@ -912,8 +969,9 @@ struct Surface {
 
 
 public:
-    Surface(const Point &fs)
+    Surface(const Point &fs, int threads)
         : frame_size(fs),
+          num_threads(threads > 0 ? threads : std::max(1, (int)std::thread::hardware_concurrency())),
           image(frame_elems()),
           anim(frame_elems()),
           anim_decay(frame_elems()),
@@ -977,34 +1035,42 @@ public:
         do_fill_realization(image.data(), color, fi, p);
     }
 
-    void composite() {
-        // Composite text over anim over image
-        uint32_t *anim_decay_px  = anim_decay.data();
-        uint32_t *anim_px  = anim.data();
-        uint32_t *image_px = image.data();
-        uint32_t *text_px  = text_buf.data();
-        uint32_t *blend_px = blend.data();
-        for (size_t i = 0; i < image.size(); i++) {
-            // anim over anim_decay -> anim_decay
-            composite_one(anim_decay_px, anim_px, anim_decay_px);
-            // anim_decay over image -> blend
-            composite_one(image_px, anim_decay_px, blend_px);
-            // text over blend -> blend
-            composite_one(blend_px, text_px, blend_px);
-            anim_decay_px++;
-            anim_px++;
-            image_px++;
-            text_px++;
-            blend_px++;
-        }
+    // Composite text over anim over image. If to_blend is false, only
+    // accumulate anim into anim_decay; this is all a frame that won't
+    // be output needs.
+    void composite(bool to_blend = true) {
+        parallel_for_pixels([this, to_blend](size_t begin, size_t end) {
+            uint32_t *anim_decay_px  = anim_decay.data() + begin;
+            uint32_t *anim_px  = anim.data() + begin;
+            uint32_t *image_px = image.data() + begin;
+            uint32_t *text_px  = text_buf.data() + begin;
+            uint32_t *blend_px = blend.data() + begin;
+            for (size_t i = begin; i < end; i++) {
+                // anim over anim_decay -> anim_decay
+                composite_one(anim_decay_px, anim_px, anim_decay_px);
+                if (to_blend) {
+                    // anim_decay over image -> blend
+                    composite_one(image_px, anim_decay_px, blend_px);
+                    // text over blend -> blend
+                    composite_one(blend_px, text_px, blend_px);
+                }
+                anim_decay_px++;
+                anim_px++;
+                image_px++;
+                text_px++;
+                blend_px++;
+            }
+        });
     }
 
     void decay_animations(int decay_factor_after_compute, int decay_factor_during_compute) {
-        // Decay the anim_decay
-        do_decay(decay_factor_after_compute, anim_decay.data());
+        parallel_for_pixels([=](size_t begin, size_t end) {
+            // Decay the anim_decay
+            do_decay(decay_factor_after_compute, anim_decay.data() + begin, anim_decay.data() + end);
 
-        // Also decay the anim
-        do_decay(decay_factor_during_compute, anim.data());
+            // Also decay the anim
+            do_decay(decay_factor_during_compute, anim.data() + begin, anim.data() + end);
+        });
     }
 
     void clear_animations() {
@@ -1049,7 +1115,7 @@ int run(bool ignore_trace_tags, FlagProcessor flag_processor) {
         flag_processor(&state);
 
         // allocate the surface after all tags and flags are processed
-        surface = std::unique_ptr<Surface>(new Surface(state.globals.frame_size));
+        surface = std::unique_ptr<Surface>(new Surface(state.globals.frame_size, render_options.threads));
 
         if (state.globals.auto_layout_grid.x < 0 || state.globals.auto_layout_grid.y < 0) {
             int cells_needed = 0;
@@ -1091,9 +1157,20 @@ int run(bool ignore_trace_tags, FlagProcessor flag_processor) {
     std::list<std::pair<Label, int>> labels_being_drawn;
     size_t end_counter = 0;
     size_t packet_clock = 0;
+    size_t frame_counter = 0;
+    const auto write_frame = [&]() -> void {
+        const int64_t frame_bytes = surface->frame_elems() * sizeof(uint32_t);
+        int64_t bytes_written = write(STDOUT_FILENO, surface->frame_data(), frame_bytes);
+        if (bytes_written < frame_bytes) {
+            fail() << "Could not write frame to stdout.";
+        }
+    };
     for (;;) {
         // Hold for some number of frames once the trace has finished.
         if (end_counter) {
+            if (render_options.final_frame_only) {
+                break;
+            }
             halide_clock += state.globals.timestep;
             if (end_counter >= (size_t) state.globals.hold_frames) {
                 break;
@@ -1103,8 +1180,6 @@ int run(bool ignore_trace_tags, FlagProcessor flag_processor) {
         if (halide_clock > video_clock) {
             assert(is_state_finalized);
 
-            const int64_t frame_bytes = surface->frame_elems() * sizeof(uint32_t);
-
             while (halide_clock > video_clock) {
                 // Always render text last, since it's on top of everything
                 // and there's no need to re-render for every packet.
@@ -1125,14 +1200,16 @@ int run(bool ignore_trace_tags, FlagProcessor flag_processor) {
                     }
                 }
 
-                // Composite text over anim over image
-                surface->composite();
-
-                // Dump the frame
-                int64_t bytes_written = write(STDOUT_FILENO, surface->frame_data(), frame_bytes);
-                if (bytes_written < frame_bytes) {
-                    fail() << "Could not write frame to stdout.";
+                // Composite text over anim over image, and dump the
+                // frame. Frames we aren't going to output still need
+                // their animations accumulated.
+                const bool output_frame = !render_options.final_frame_only &&
+                                          (frame_counter % render_options.frame_skip) == 0;
+                surface->composite(output_frame);
+                if (output_frame) {
+                    write_frame();
                 }
+                frame_counter++;
 
                 video_clock += state.globals.timestep;
 
@@ -1353,6 +1430,11 @@ int run(bool ignore_trace_tags, FlagProcessor flag_processor) {
         }
     }
 
+    if (render_options.final_frame_only && surface) {
+        surface->composite();
+        write_frame();
+    }
+
     if (verbose) {
         info() << "Total number of Funcs: " << state.funcs.size();
 